@@ -47,12 +47,20 @@ from moveit_msgs.msg import (
     MotionPlanRequest,
 )
 from sensor_msgs.msg import JointState
+from collections import namedtuple
 import rospy
 import tf
 from moveit_ros_planning_interface import _moveit_move_group_interface
 from .exception import MoveItCommanderException
 import moveit_commander.conversions as conversions
 
+TrajectoryArrays = namedtuple(
+    "TrajectoryArrays",
+    ["joint_names", "times", "positions", "velocities", "accelerations"],
+)
+TrajectoryArrays.__doc__ = """A joint trajectory as numpy arrays with one row per waypoint.
+velocities and accelerations are empty arrays if the trajectory does not specify them for all waypoints."""
+
 
 class MoveGroupCommander(object):
     """
@@ -639,6 +647,29 @@ class MoveGroupCommander(object):
             error_code,
         )
 
+    def plan_arrays(self, joints=None, single_precision=False):
+        """Like plan(), but return the trajectory as TrajectoryArrays of numpy arrays instead of a RobotTrajectory
+        message, which is much faster to unpack for long trajectories. Multi-DOF joints are not included.
+        Return a tuple (success flag : boolean, trajectory : TrajectoryArrays, planning time : float,
+        error code : MoveitErrorCodes). With single_precision, the arrays use float32."""
+        if type(joints) is str:
+            self.set_joint_value_target(self.get_remembered_joint_values()[joints])
+        elif type(joints) is Pose:
+            self.set_pose_target(joints)
+        elif joints is not None:
+            self.set_joint_value_target(joints)
+
+        (error_code_msg, arrays, planning_time) = self._g.plan_arrays(single_precision)
+
+        error_code = MoveItErrorCodes()
+        error_code.deserialize(error_code_msg)
+        return (
+            error_code.val == MoveItErrorCodes.SUCCESS,
+            TrajectoryArrays(*arrays),
+            planning_time,
+            error_code,
+        )
+
     def construct_motion_plan_request(self):
         """Returns a MotionPlanRequest filled with the current goals of the move_group_interface"""
         mpr = MotionPlanRequest()
@@ -680,6 +711,25 @@ class MoveGroupCommander(object):
         path.deserialize(ser_path)
         return (path, fraction)
 
+    def compute_cartesian_path_arrays(
+        self,
+        waypoints,
+        eef_step,
+        jump_threshold,
+        avoid_collisions=True,
+        single_precision=False,
+    ):
+        """Like compute_cartesian_path(), but return the path as TrajectoryArrays of numpy arrays.
+        The return value is a tuple: the TrajectoryArrays and the fraction of the path that was followed."""
+        (arrays, fraction) = self._g.compute_cartesian_path_arrays(
+            [conversions.pose_to_list(p) for p in waypoints],
+            eef_step,
+            jump_threshold,
+            avoid_collisions,
+            single_precision,
+        )
+        return (TrajectoryArrays(*arrays), fraction)
+
     def execute(self, plan_msg, wait=True):
         """Execute a previously planned path"""
         if wait:
@@ -687,6 +737,17 @@ class MoveGroupCommander(object):
         else:
             return self._g.async_execute(conversions.msg_to_string(plan_msg))
 
+    def execute_arrays(self, trajectory, wait=True):
+        """Execute a trajectory given as TrajectoryArrays, as returned by plan_arrays()"""
+        return self._g.execute_arrays(
+            list(trajectory.joint_names),
+            trajectory.times,
+            trajectory.positions,
+            trajectory.velocities,
+            trajectory.accelerations,
+            wait,
+        )
+
     def attach_object(self, object_name, link_name="", touch_links=[]):
         """Given the name of an object existing in the planning scene, attach it to a link. The link used is specified by the second argument. If left unspecified, the end-effector link is used, if one is known. If there is no end-effector link, the first link in the group is used. If no link is identified, failure is reported. True is returned if an attach request was succesfully sent to the move_group node. This does not verify that the attach request also was successfuly applied by move_group."""
         return self._g.attach_object(object_name, link_name, touch_links)
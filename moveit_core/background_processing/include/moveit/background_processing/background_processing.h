@@ -36,8 +36,11 @@
 
 #pragma once
 
+#include <atomic>
+#include <cstdint>
 #include <deque>
 #include <string>
+#include <vector>
 #include <boost/thread.hpp>
 #include <boost/function.hpp>
 #include <boost/noncopyable.hpp>
@@ -52,7 +55,17 @@ namespace tools
 {
 /** \brief This class provides simple API for executing background
     jobs. A queue of jobs is created and the specified jobs are
-    executed in order, one at a time. */
+    executed by a pool of background threads (one by default).
+
+    Jobs can be given a key: jobs with the same key never run at the same
+    time, and adding a job supersedes the jobs of its key that are still
+    queued (they are removed) or running (they are asked to cancel). Jobs
+    added without a key are never superseded and run one at a time, in
+    order, as with a single thread. Among the jobs that may start, the one
+    with the highest priority runs first; jobs of equal priority run in the
+    order they were added.
+
+    Cancellation is cooperative: a running job polls isCancelled(). */
 class BackgroundProcessing : private boost::noncopyable
 {
 public:
@@ -74,19 +87,30 @@ public:
   /** \brief The signature for job callbacks */
   typedef boost::function<void()> JobCallback;
 
-  /** \brief Constructor. The background thread is activated automatically. */
-  BackgroundProcessing();
+  /** \brief Constructor. The \e threads background threads are activated automatically. */
+  BackgroundProcessing(unsigned int threads = 1);
 
-  /** \brief Finishes currently executing job, clears the remaining queue. */
+  /** \brief Finishes currently executing jobs, clears the remaining queue. */
   ~BackgroundProcessing();
 
   /** \brief Add a job to the queue of jobs to execute. A name is also specifies for the job */
   void addJob(const JobCallback& job, const std::string& name);
 
-  /** \brief Get the size of the queue of jobs (includes currently processed job). */
+  /** \brief Add a job with a \e priority (higher runs first) and a \e key. If \e key is not empty,
+      queued jobs with the same key are removed and running ones are asked to cancel. */
+  void addJob(const JobCallback& job, const std::string& name, int priority, const std::string& key = "");
+
+  /** \brief Remove the queued jobs with \e key and ask the running ones to cancel */
+  void cancel(const std::string& key);
+
+  /** \brief Called from within a job: true if the job was asked to cancel, because it was superseded or the queue
+      was cleared. Always false outside of jobs. */
+  static bool isCancelled();
+
+  /** \brief Get the size of the queue of jobs (includes currently processed jobs). */
   std::size_t getJobCount() const;
 
-  /** \brief Clear the queue of jobs */
+  /** \brief Clear the queue of jobs and ask the running jobs to cancel */
   void clear();
 
   /** \brief Set the callback to be triggered when events in JobEvent take place */
@@ -96,19 +120,37 @@ public:
   void clearJobUpdateEvent();
 
 private:
-  std::unique_ptr<boost::thread> processing_thread_;
+  struct Job
+  {
+    JobCallback callback;
+    std::string name;
+    std::string key;
+    int priority;
+    std::uint64_t sequence;
+    std::shared_ptr<std::atomic<bool>> cancelled;
+  };
+
+  std::vector<std::unique_ptr<boost::thread>> processing_threads_;
   bool run_processing_thread_;
 
   mutable boost::mutex action_lock_;
   boost::condition_variable new_action_condition_;
-  std::deque<JobCallback> actions_;
-  std::deque<std::string> action_names_;
+  /** \brief Queued jobs, by decreasing priority, then in the order they were added */
+  std::deque<Job> actions_;
+  std::uint64_t next_sequence_;
 
-  JobUpdateCallback queue_change_event_;
+  /** \brief Jobs being executed */
+  std::vector<Job> running_;
 
-  bool processing_;
+  JobUpdateCallback queue_change_event_;
 
   void processingThread();
+
+  /** \brief Take the first job of the queue whose key is not running. Requires action_lock_. */
+  bool takeNextJob(Job& job);
+
+  /** \brief Remove the queued jobs with \e key into \e removed and cancel the running ones. Requires action_lock_. */
+  void cancelLocked(const std::string& key, std::vector<std::string>& removed);
 };
 }  // namespace tools
 }  // namespace moveit
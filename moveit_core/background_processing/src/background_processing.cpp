@@ -36,24 +36,50 @@
 
 #include <moveit/background_processing/background_processing.h>
 #include <ros/console.h>
+#include <algorithm>
 
 namespace moveit
 {
 namespace tools
 {
-BackgroundProcessing::BackgroundProcessing()
+namespace
 {
-  // spin a thread that will process user events
+// the cancellation flag of the job executed by the current thread
+thread_local const std::atomic<bool>* current_job_cancelled = nullptr;
+}  // namespace
+
+BackgroundProcessing::BackgroundProcessing(unsigned int threads)
+{
+  // spin the threads that will process user events
   run_processing_thread_ = true;
-  processing_ = false;
-  processing_thread_ = std::make_unique<boost::thread>([this] { processingThread(); });
+  next_sequence_ = 0;
+  for (unsigned int i = 0; i < std::max(threads, 1u); ++i)
+    processing_threads_.push_back(std::make_unique<boost::thread>([this] { processingThread(); }));
 }
 
 BackgroundProcessing::~BackgroundProcessing()
 {
-  run_processing_thread_ = false;
+  {
+    boost::mutex::scoped_lock _(action_lock_);
+    run_processing_thread_ = false;
+  }
   new_action_condition_.notify_all();
-  processing_thread_->join();
+  for (std::unique_ptr<boost::thread>& thread : processing_threads_)
+    thread->join();
+}
+
+bool BackgroundProcessing::takeNextJob(Job& job)
+{
+  for (std::deque<Job>::iterator it = actions_.begin(); it != actions_.end(); ++it)
+  {
+    const std::string& key = it->key;
+    if (std::any_of(running_.begin(), running_.end(), [&key](const Job& running) { return running.key == key; }))
+      continue;
+    job = std::move(*it);
+    actions_.erase(it);
+    return true;
+  }
+  return false;
 }
 
 void BackgroundProcessing::processingThread()
@@ -62,69 +88,134 @@ void BackgroundProcessing::processingThread()
 
   while (run_processing_thread_)
   {
-    while (actions_.empty() && run_processing_thread_)
+    Job job;
+    if (!takeNextJob(job))
+    {
       new_action_condition_.wait(ulock);
+      continue;
+    }
+    running_.push_back(job);
 
-    while (!actions_.empty())
+    // make sure we are unlocked while we process the event
+    ulock.unlock();
+    current_job_cancelled = job.cancelled.get();
+    try
     {
-      JobCallback fn = actions_.front();
-      std::string action_name = action_names_.front();
-      actions_.pop_front();
-      action_names_.pop_front();
-      processing_ = true;
-
-      // make sure we are unlocked while we process the event
-      action_lock_.unlock();
-      try
-      {
-        ROS_DEBUG_NAMED("background_processing", "Begin executing '%s'", action_name.c_str());
-        fn();
-        ROS_DEBUG_NAMED("background_processing", "Done executing '%s'", action_name.c_str());
-      }
-      catch (std::exception& ex)
-      {
-        ROS_ERROR_NAMED("background_processing", "Exception caught while processing action '%s': %s",
-                        action_name.c_str(), ex.what());
-      }
-      processing_ = false;
-      if (queue_change_event_)
-        queue_change_event_(COMPLETE, action_name);
-      action_lock_.lock();
+      ROS_DEBUG_NAMED("background_processing", "Begin executing '%s'", job.name.c_str());
+      job.callback();
+      ROS_DEBUG_NAMED("background_processing", "Done executing '%s'", job.name.c_str());
     }
+    catch (std::exception& ex)
+    {
+      ROS_ERROR_NAMED("background_processing", "Exception caught while processing action '%s': %s",
+                      job.name.c_str(), ex.what());
+    }
+    current_job_cancelled = nullptr;
+    ulock.lock();
+
+    running_.erase(std::find_if(running_.begin(), running_.end(),
+                                [&job](const Job& running) { return running.sequence == job.sequence; }));
+    // jobs that were held back by this one may run now
+    new_action_condition_.notify_all();
+    JobUpdateCallback queue_change_event = queue_change_event_;
+    ulock.unlock();
+    if (queue_change_event)
+      queue_change_event(COMPLETE, job.name);
+    ulock.lock();
   }
 }
 
 void BackgroundProcessing::addJob(const boost::function<void()>& job, const std::string& name)
 {
+  addJob(job, name, 0);
+}
+
+void BackgroundProcessing::addJob(const JobCallback& job, const std::string& name, int priority,
+                                  const std::string& key)
+{
+  std::vector<std::string> removed;
+  JobUpdateCallback queue_change_event;
   {
     boost::mutex::scoped_lock _(action_lock_);
-    actions_.push_back(job);
-    action_names_.push_back(name);
+    if (!key.empty())
+      cancelLocked(key, removed);
+
+    Job entry;
+    entry.callback = job;
+    entry.name = name;
+    entry.key = key;
+    entry.priority = priority;
+    entry.sequence = next_sequence_++;
+    entry.cancelled = std::make_shared<std::atomic<bool>>(false);
+    // after all jobs of higher or equal priority
+    actions_.insert(std::find_if(actions_.begin(), actions_.end(),
+                                 [priority](const Job& queued) { return queued.priority < priority; }),
+                    std::move(entry));
     new_action_condition_.notify_all();
+    queue_change_event = queue_change_event_;
+  }
+  if (queue_change_event)
+  {
+    for (const std::string& it : removed)
+      queue_change_event(REMOVE, it);
+    queue_change_event(ADD, name);
   }
-  if (queue_change_event_)
-    queue_change_event_(ADD, name);
 }
 
-void BackgroundProcessing::clear()
+void BackgroundProcessing::cancelLocked(const std::string& key, std::vector<std::string>& removed)
+{
+  for (std::deque<Job>::iterator it = actions_.begin(); it != actions_.end();)
+    if (it->key == key)
+    {
+      removed.push_back(it->name);
+      it = actions_.erase(it);
+    }
+    else
+      ++it;
+  for (Job& running : running_)
+    if (running.key == key)
+      *running.cancelled = true;
+}
+
+void BackgroundProcessing::cancel(const std::string& key)
 {
-  bool update = false;
-  std::deque<std::string> removed;
+  std::vector<std::string> removed;
+  JobUpdateCallback queue_change_event;
   {
     boost::mutex::scoped_lock _(action_lock_);
-    update = !actions_.empty();
-    actions_.clear();
-    action_names_.swap(removed);
+    cancelLocked(key, removed);
+    queue_change_event = queue_change_event_;
   }
-  if (update && queue_change_event_)
+  if (queue_change_event)
     for (const std::string& it : removed)
-      queue_change_event_(REMOVE, it);
+      queue_change_event(REMOVE, it);
+}
+
+bool BackgroundProcessing::isCancelled()
+{
+  return current_job_cancelled && *current_job_cancelled;
+}
+
+void BackgroundProcessing::clear()
+{
+  std::deque<Job> removed;
+  JobUpdateCallback queue_change_event;
+  {
+    boost::mutex::scoped_lock _(action_lock_);
+    actions_.swap(removed);
+    for (Job& running : running_)
+      *running.cancelled = true;
+    queue_change_event = queue_change_event_;
+  }
+  if (queue_change_event)
+    for (const Job& it : removed)
+      queue_change_event(REMOVE, it.name);
 }
 
 std::size_t BackgroundProcessing::getJobCount() const
 {
   boost::mutex::scoped_lock _(action_lock_);
-  return actions_.size() + (processing_ ? 1 : 0);
+  return actions_.size() + running_.size();
 }
 
 void BackgroundProcessing::setJobUpdateEvent(const JobUpdateCallback& event)
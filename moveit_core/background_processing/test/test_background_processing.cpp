@@ -0,0 +1,145 @@
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2026, PickNik LLC.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of PickNik LLC nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *********************************************************************/
+
+#include <moveit/background_processing/background_processing.h>
+#include <gtest/gtest.h>
+#include <chrono>
+#include <future>
+#include <mutex>
+#include <thread>
+
+using moveit::tools::BackgroundProcessing;
+
+namespace
+{
+void waitUntilIdle(const BackgroundProcessing& processing)
+{
+  while (processing.getJobCount() > 0)
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+}
+}  // namespace
+
+TEST(BackgroundProcessing, PrioritiesAndOrder)
+{
+  BackgroundProcessing processing;
+  std::promise<void> gate;
+  std::shared_future<void> opened = gate.get_future().share();
+  std::mutex order_lock;
+  std::vector<std::string> order;
+  auto record = [&](const std::string& name) {
+    return [&, name] {
+      std::lock_guard<std::mutex> _(order_lock);
+      order.push_back(name);
+    };
+  };
+
+  // hold the only thread while the queue fills up
+  processing.addJob([opened] { opened.wait(); }, "gate");
+  processing.addJob(record("low 1"), "low 1", 0);
+  processing.addJob(record("high"), "high", 5);
+  processing.addJob(record("low 2"), "low 2", 0);
+  EXPECT_EQ(processing.getJobCount(), 4u);
+  gate.set_value();
+  waitUntilIdle(processing);
+
+  EXPECT_EQ(order, (std::vector<std::string>{ "high", "low 1", "low 2" }));
+}
+
+TEST(BackgroundProcessing, SupersededJobsAreCoalesced)
+{
+  BackgroundProcessing processing;
+  std::promise<void> gate;
+  std::shared_future<void> opened = gate.get_future().share();
+  std::atomic<int> runs(0), last(0);
+
+  processing.addJob([opened] { opened.wait(); }, "gate");
+  for (int i = 1; i <= 5; ++i)
+    processing.addJob(
+        [&, i] {
+          ++runs;
+          last = i;
+        },
+        "update", 0, "update");
+  EXPECT_EQ(processing.getJobCount(), 2u);
+  gate.set_value();
+  waitUntilIdle(processing);
+
+  EXPECT_EQ(runs, 1);
+  EXPECT_EQ(last, 5);
+}
+
+TEST(BackgroundProcessing, CooperativeCancellation)
+{
+  BackgroundProcessing processing;
+  std::promise<void> started;
+  std::atomic<bool> cancelled(false);
+  processing.addJob(
+      [&] {
+        started.set_value();
+        while (!BackgroundProcessing::isCancelled())
+          std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        cancelled = true;
+      },
+      "long job", 0, "long");
+  started.get_future().wait();
+  EXPECT_FALSE(BackgroundProcessing::isCancelled());
+  processing.cancel("long");
+  waitUntilIdle(processing);
+  EXPECT_TRUE(cancelled);
+}
+
+TEST(BackgroundProcessing, KeyedJobsRunNextToSlowJobs)
+{
+  BackgroundProcessing processing(2);
+  std::promise<void> gate;
+  std::shared_future<void> opened = gate.get_future().share();
+  std::promise<void> keyed_done;
+  std::atomic<bool> unkeyed_ran(false);
+
+  // unkeyed jobs run one at a time, but a keyed job can use the second thread
+  processing.addJob([opened] { opened.wait(); }, "slow");
+  processing.addJob([&] { unkeyed_ran = true; }, "after slow");
+  processing.addJob([&] { keyed_done.set_value(); }, "keyed", 0, "keyed");
+  EXPECT_EQ(keyed_done.get_future().wait_for(std::chrono::seconds(5)), std::future_status::ready);
+  EXPECT_FALSE(unkeyed_ran);
+  gate.set_value();
+  waitUntilIdle(processing);
+  EXPECT_TRUE(unkeyed_ran);
+}
+
+int main(int argc, char** argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,89 @@
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2026, PickNik LLC.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of PickNik LLC nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *********************************************************************/
+
+#pragma once
+
+#include <Eigen/Geometry>
+#include <vector>
+
+namespace collision_detection
+{
+/** \brief Static bounding volume hierarchy over a set of axis-aligned boxes.
+ *
+ * The tree is built top-down by splitting the boxes at the median of the longest axis of their centers, and
+ * answers overlap queries in logarithmic time for well distributed boxes. It does not support incremental
+ * updates: it is meant to be rebuilt when the boxes change, which for a few thousand entries takes well below
+ * a millisecond. All boxes must be bounded. */
+class AABBTree
+{
+public:
+  /** \brief Build the tree over \e boxes. Query results are indices into this vector. */
+  void build(const std::vector<Eigen::AlignedBox3d>& boxes);
+
+  /** \brief Remove all boxes */
+  void clear();
+
+  /** \brief The number of boxes in the tree */
+  std::size_t size() const
+  {
+    return boxes_.size();
+  }
+
+  bool empty() const
+  {
+    return boxes_.empty();
+  }
+
+  /** \brief Append the indices of all boxes that intersect \e box to \e indices, in no particular order */
+  void query(const Eigen::AlignedBox3d& box, std::vector<std::size_t>& indices) const;
+
+private:
+  struct Node
+  {
+    Eigen::AlignedBox3d box;
+    /** \brief Indices of the children in nodes_; zero for leaves, since the root is nobody's child */
+    std::size_t left;
+    std::size_t right;
+    /** \brief Range of leaf entries in indices_ */
+    std::size_t first;
+    std::size_t count;
+  };
+
+  std::size_t buildNode(std::size_t first, std::size_t count, const std::vector<Eigen::Vector3d>& centers);
+
+  std::vector<Eigen::AlignedBox3d> boxes_;
+  std::vector<std::size_t> indices_;
+  std::vector<Node> nodes_;
+};
+}  // namespace collision_detection
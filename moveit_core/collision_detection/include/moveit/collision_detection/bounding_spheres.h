@@ -0,0 +1,60 @@
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2026, PickNik LLC.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of PickNik LLC nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *********************************************************************/
+
+#pragma once
+
+#include <moveit/robot_model/link_model.h>
+#include <Eigen/Geometry>
+#include <vector>
+
+namespace collision_detection
+{
+/** \brief Get the bounding spheres of collision shape \e shape_index of \e link, in the frame of that shape, after
+    the link scaling \e scale and padding \e padding are applied the same way collision geometry is scaled and padded.
+    Without scaling and padding these are the spheres precomputed by moveit::core::LinkModel. */
+void getLinkShapeBoundingSpheres(const moveit::core::LinkModel* link, std::size_t shape_index, double scale,
+                                 double padding, std::vector<moveit::core::BoundingSphere>& spheres);
+
+/** \brief Conservative pre-filter for narrowphase checks: return false only if no sphere of \e spheres1 posed at
+    \e pose1 comes closer than \e margin to a sphere of \e spheres2 posed at \e pose2, in which case the shapes they
+    enclose cannot be in collision either. Empty sphere sets stand for unbounded shapes and always pass. */
+bool boundingSpheresOverlap(const std::vector<moveit::core::BoundingSphere>& spheres1, const Eigen::Isometry3d& pose1,
+                            const std::vector<moveit::core::BoundingSphere>& spheres2, const Eigen::Isometry3d& pose2,
+                            double margin = 0.0);
+
+/** \brief Same as above, for spheres tested against the world-frame axis-aligned box \e box, e.g. the broadphase
+    bounding box of an object that has no bounding spheres */
+bool boundingSpheresOverlap(const std::vector<moveit::core::BoundingSphere>& spheres, const Eigen::Isometry3d& pose,
+                            const Eigen::AlignedBox3d& box, double margin = 0.0);
+}  // namespace collision_detection
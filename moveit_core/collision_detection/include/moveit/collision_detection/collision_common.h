@@ -190,6 +190,9 @@ struct CollisionRequest
     , max_contacts(1)
     , max_contacts_per_pair(1)
     , max_cost_sources(1)
+    , bounding_sphere_filter(false)
+    , octomap_lod(false)
+    , octomap_resolution(0.0)
     , verbose(false)
   {
   }
@@ -219,6 +222,22 @@ struct CollisionRequest
   /** \brief When costs are computed, this value defines how many of the top cost sources should be returned */
   std::size_t max_cost_sources;
 
+  /** \brief If true, pairs of robot link shapes (and link shapes vs. the bounding box of other objects) whose bounding
+   *  spheres do not overlap are rejected before the exact narrowphase check, see
+   *  moveit::core::LinkModel::getShapeBoundingSpheres(). The filter is conservative and does not change the result;
+   *  it pays off in scenes where many broadphase candidates are far apart. */
+  bool bounding_sphere_filter;
+
+  /** \brief If true, bodies are first checked against an 8 times coarser version of octomaps, in which a node is
+   *  occupied if any part of it is, and only refined where that coarse check finds a collision. The check is
+   *  conservative and does not change the result. It is skipped when costs are computed. Only supported by FCL. */
+  bool octomap_lod;
+
+  /** \brief If larger than the leaf size of an octomap, check collisions with the octomap at this resolution instead,
+   *  treating a node as occupied if any part of it is. This is conservative and may report collisions in free space
+   *  near occupied cells. Only supported by FCL. */
+  double octomap_resolution;
+
   /** \brief Function call that decides whether collision detection should stop. */
   boost::function<bool(const CollisionResult&)> is_done;
 
@@ -251,6 +270,7 @@ struct DistanceRequest
     , distance_threshold(std::numeric_limits<double>::max())
     , verbose(false)
     , compute_gradient(false)
+    , threads(1)
   {
   }
 
@@ -287,7 +307,8 @@ struct DistanceRequest
   const AllowedCollisionMatrix* acm;
 
   /// Only calculate distances for objects within this threshold to each other.
-  /// If set, this can significantly reduce the number of queries.
+  /// If set, this can significantly reduce the number of queries, since pairs whose bounding boxes are farther apart
+  /// are skipped by the broadphase.
   double distance_threshold;
 
   /// Log debug information
@@ -296,6 +317,10 @@ struct DistanceRequest
   /// Indicate if gradient should be calculated between each object.
   /// This is the normalized vector connecting the closest points on the two objects.
   bool compute_gradient;
+
+  /// Number of threads the robot-world distance queries are distributed over (the calling thread is one of them).
+  /// Only supported by some collision detectors.
+  unsigned int threads;
 };
 
 /** \brief Generic representation of the distance information for a pair of objects */
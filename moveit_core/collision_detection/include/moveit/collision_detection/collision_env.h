@@ -37,6 +37,7 @@
 #pragma once
 
 #include <moveit/collision_detection/collision_matrix.h>
+#include <moveit/collision_detection/convex_decomposition.h>
 #include <moveit/macros/class_forward.h>
 #include <moveit/robot_state/robot_state.h>
 #include <moveit_msgs/LinkPadding.h>
@@ -156,6 +157,40 @@ public:
                                    const moveit::core::RobotState& state1,
                                    const moveit::core::RobotState& state2) const = 0;
 
+  /** \brief Binary check for self collision. Only a yes / no answer is computed (no contacts, costs or distances),
+   *  which lets implementations skip all bookkeeping of contacts.
+   *  @param state The kinematic state for which checks are being made
+   *  @param acm The allowed collision matrix
+   *  @param group_name The group to check collisions for (if empty, the complete robot)
+   *  @return True if the robot is in self collision */
+  virtual bool isSelfColliding(const moveit::core::RobotState& state, const AllowedCollisionMatrix& acm,
+                               const std::string& group_name = "") const;
+
+  /** \brief Binary check for collisions of the robot with the world. Only a yes / no answer is computed (no
+   *  contacts, costs or distances), which lets implementations skip all bookkeeping of contacts.
+   *  @param state The kinematic state for which checks are being made
+   *  @param acm The allowed collision matrix
+   *  @param group_name The group to check collisions for (if empty, the complete robot)
+   *  @return True if the robot is in collision with the world */
+  virtual bool isRobotColliding(const moveit::core::RobotState& state, const AllowedCollisionMatrix& acm,
+                                const std::string& group_name = "") const;
+
+  /** \brief Binary self collision checks of many states, e.g. the waypoints of a dense trajectory.
+   *  Each state is checked with isSelfColliding(), which stops at the first collision of that state.
+   *  @param states The states to check; their collision body transforms have to be up to date
+   *  @param acm The allowed collision matrix
+   *  @param colliding Set to one flag per state, true if the state is in self collision
+   *  @param group_name The group to check collisions for (if empty, the complete robot)
+   *  @param threads Number of threads the states are distributed over (the calling thread is one of them) */
+  virtual void isSelfColliding(const std::vector<const moveit::core::RobotState*>& states,
+                               const AllowedCollisionMatrix& acm, std::vector<bool>& colliding,
+                               const std::string& group_name = "", unsigned int threads = 1) const;
+
+  /** \brief Binary checks of many states for collisions with the world, see isSelfColliding() for the parameters */
+  virtual void isRobotColliding(const std::vector<const moveit::core::RobotState*>& states,
+                                const AllowedCollisionMatrix& acm, std::vector<bool>& colliding,
+                                const std::string& group_name = "", unsigned int threads = 1) const;
+
   /** \brief The distance to self-collision given the robot is at state \e state.
       @param req A DistanceRequest object that encapsulates the distance request
       @param res A DistanceResult object that encapsulates the distance result
@@ -195,6 +230,19 @@ public:
   virtual void distanceRobot(const DistanceRequest& req, DistanceResult& res,
                              const moveit::core::RobotState& state) const = 0;
 
+  /** \brief Self distance queries of many states, e.g. the waypoints of a trajectory optimized by a local planner.
+   *  Each state is queried with distanceSelf() and the same request.
+   *  @param req The distance request shared by all states
+   *  @param states The states to query; their collision body transforms have to be up to date
+   *  @param results Set to one distance result per state
+   *  @param threads Number of threads the states are distributed over (the calling thread is one of them) */
+  virtual void distanceSelf(const DistanceRequest& req, const std::vector<const moveit::core::RobotState*>& states,
+                            std::vector<DistanceResult>& results, unsigned int threads = 1) const;
+
+  /** \brief Distance queries of many states to the world, see distanceSelf() for the parameters */
+  virtual void distanceRobot(const DistanceRequest& req, const std::vector<const moveit::core::RobotState*>& states,
+                             std::vector<DistanceResult>& results, unsigned int threads = 1) const;
+
   /** \brief Compute the shortest distance between a robot and the world
    *  @param robot The robot to check distance for
    *  @param state The state for the robot to check distances from
@@ -302,6 +350,29 @@ public:
   /** @brief Get the link scaling as a vector of messages*/
   void getScale(std::vector<moveit_msgs::LinkScale>& scale) const;
 
+  /** @brief Check meshes of world objects as the union of their convex parts, see computeConvexDecomposition().
+   *  This is conservative and lets the collision libraries use convex-convex tests with penetration depths instead
+   *  of triangle-level checks. Decompositions are computed once per distinct mesh and parameters. Changing this
+   *  setting updates all world objects. */
+  void setConvexDecomposition(bool enabled,
+                              const ConvexDecompositionParameters& parameters = ConvexDecompositionParameters());
+
+  bool getConvexDecomposition() const
+  {
+    return convex_decomposition_;
+  }
+
+  const ConvexDecompositionParameters& getConvexDecompositionParameters() const
+  {
+    return convex_decomposition_parameters_;
+  }
+
+  /** @brief Compute the data the collision checker caches for \e shapes before they are added to the world, e.g.
+   *  convex decompositions or bounding volume hierarchies of meshes, so that adding them only copies cached data.
+   *  This may be called concurrently from several threads. The default implementation computes the convex
+   *  decompositions of meshes if they are enabled. */
+  virtual void prepareWorldShapes(const std::vector<shapes::ShapeConstPtr>& shapes) const;
+
 protected:
   /** @brief When the scale or padding is changed for a set of links by any of the functions in this class,
      updatedPaddingOrScaling() function is called.
@@ -311,6 +382,16 @@ protected:
       @param links the names of the links whose padding or scaling were updated */
   virtual void updatedPaddingOrScaling(const std::vector<std::string>& links);
 
+  /** @brief Called by setConvexDecomposition(). The default implementation does nothing; collision checkers that
+      support convex decompositions rebuild their world objects. */
+  virtual void updatedConvexDecomposition();
+
+  /** @brief Get the shapes that world object \e obj is checked with and their global poses: the shapes of the object,
+      with meshes replaced by their convex parts if convex decomposition is enabled. \e convex tells which shapes are
+      such parts. */
+  void getWorldObjectCollisionShapes(const World::Object& obj, std::vector<shapes::ShapeConstPtr>& shapes,
+                                     EigenSTL::vector_Isometry3d& poses, std::vector<bool>& convex) const;
+
   /** @brief The kinematic model corresponding to this collision model*/
   moveit::core::RobotModelConstPtr robot_model_;
 
@@ -320,6 +401,11 @@ protected:
   /** @brief The internally maintained map (from link names to scaling)*/
   std::map<std::string, double> link_scale_;
 
+  /** @brief Whether world meshes are checked as their convex decomposition */
+  bool convex_decomposition_ = false;
+
+  ConvexDecompositionParameters convex_decomposition_parameters_;
+
 private:
   WorldPtr world_;             // The world always valid, never nullptr.
   WorldConstPtr world_const_;  // always same as world_
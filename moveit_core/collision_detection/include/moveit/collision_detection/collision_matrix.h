@@ -40,10 +40,13 @@
 #include <moveit/macros/class_forward.h>
 #include <moveit_msgs/AllowedCollisionMatrix.h>
 #include <boost/function.hpp>
+#include <algorithm>
+#include <cstdint>
 #include <iostream>
 #include <vector>
 #include <string>
 #include <map>
+#include <unordered_map>
 
 namespace collision_detection
 {
@@ -76,7 +79,12 @@ MOVEIT_CLASS_FORWARD(AllowedCollisionMatrix);  // Defines AllowedCollisionMatrix
 /** @class AllowedCollisionMatrix
  *  @brief Definition of a structure for the allowed collision matrix. All elements in the collision world are referred
  * to by their names.
- *   This class represents which collisions are allowed to happen and which are not. */
+ *   This class represents which collisions are allowed to happen and which are not.
+ *
+ *   Besides the name-keyed entries, every known name is assigned an index and the resolved type of each pair of
+ *   indices (explicit entry, else the combined defaults) is kept in a dense matrix of 2-bit codes. The matrix is
+ *   updated incrementally whenever entries or defaults change, so getAllowedCollision() costs two hash lookups (or
+ *   none, using the index overload) instead of several nested map lookups. */
 class AllowedCollisionMatrix
 {
 public:
@@ -241,6 +249,31 @@ public:
   bool getAllowedCollision(const std::string& name1, const std::string& name2,
                            AllowedCollision::Type& allowed_collision) const;
 
+  /** @brief Get the index of \e name in the dense representation, or -1 if the matrix has neither entries nor a
+   *  default for \e name. Indices stay valid until clear() is called. */
+  int getEntryIndex(const std::string& name) const
+  {
+    auto it = name_indices_.find(name);
+    return it == name_indices_.end() ? -1 : static_cast<int>(it->second);
+  }
+
+  /** @brief Same as getAllowedCollision() for names, for elements identified by getEntryIndex(). An index of -1
+   *  stands for an element that is unknown to the matrix. This is a constant time lookup. */
+  bool getAllowedCollision(int index1, int index2, AllowedCollision::Type& allowed_collision) const
+  {
+    unsigned int code;
+    if (index1 >= 0 && index2 >= 0)
+      code = getCode(index1, index2);
+    else if (index1 >= 0 || index2 >= 0)
+      code = default_codes_[std::max(index1, index2)];
+    else
+      return false;
+    if (code == NO_ENTRY)
+      return false;
+    allowed_collision = static_cast<AllowedCollision::Type>(code - 1);
+    return true;
+  }
+
   /** @brief Print the allowed collision matrix */
   void print(std::ostream& out) const;
 
@@ -248,10 +281,42 @@ private:
   bool getDefaultEntry(const std::string& name1, const std::string& name2,
                        AllowedCollision::Type& allowed_collision) const;
 
+  /** @brief Code of a pair without entry and defaults; otherwise the code is the AllowedCollision::Type + 1 */
+  static constexpr unsigned int NO_ENTRY = 0;
+  static constexpr std::size_t CODES_PER_WORD = 32;
+
+  unsigned int getCode(std::size_t index1, std::size_t index2) const
+  {
+    const std::size_t cell = index1 * stride_ + index2;
+    return (dense_[cell / CODES_PER_WORD] >> (2 * (cell % CODES_PER_WORD))) & 3u;
+  }
+
+  void setCode(std::size_t index1, std::size_t index2, unsigned int code);
+
+  /** @brief Index of \e name, adding it (and its row of the dense matrix) if it is new */
+  std::size_t addName(const std::string& name);
+
+  /** @brief Recompute the dense code of a pair from the name-keyed entries */
+  void updateCode(std::size_t index1, std::size_t index2);
+
+  /** @brief Recompute the default code and the row of the dense matrix of \e name, if it is known */
+  void updateName(const std::string& name);
+
   std::map<std::string, std::map<std::string, AllowedCollision::Type> > entries_;
   std::map<std::string, std::map<std::string, DecideContactFn> > allowed_contacts_;
 
   std::map<std::string, AllowedCollision::Type> default_entries_;
   std::map<std::string, DecideContactFn> default_allowed_contacts_;
+
+  /** @brief The names that have an index, and the reverse mapping */
+  std::vector<std::string> names_;
+  std::unordered_map<std::string, std::size_t> name_indices_;
+
+  /** @brief Resolved code of the default entry of each index */
+  std::vector<std::uint8_t> default_codes_;
+
+  /** @brief Row-major matrix of 2-bit codes with \e stride_ columns (the capacity, doubled when exceeded) */
+  std::vector<std::uint64_t> dense_;
+  std::size_t stride_ = 0;
 };
 }  // namespace collision_detection
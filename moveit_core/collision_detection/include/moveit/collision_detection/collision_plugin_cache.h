@@ -55,6 +55,16 @@ public:
    */
   bool activate(const std::string& name, const planning_scene::PlanningScenePtr& scene, bool exclusive);
 
+  /**
+   * @brief Add the collision detector of a specific collision plugin to the given planning scene instance, without
+   * making it the active one. It is kept up to date with the scene's world, so it can be queried through
+   * PlanningScene::getCollisionEnv(name) or activated at no cost.
+   * @param name The plugin name.
+   * @param scene The planning scene instance.
+   * @return success / failure
+   */
+  bool add(const std::string& name, const planning_scene::PlanningScenePtr& scene);
+
 private:
   MOVEIT_CLASS_FORWARD(CollisionPluginCacheImpl);
   CollisionPluginCacheImplPtr cache_;
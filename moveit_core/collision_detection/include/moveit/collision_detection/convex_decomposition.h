@@ -0,0 +1,78 @@
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2026, PickNik LLC.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of PickNik LLC nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *********************************************************************/
+
+#pragma once
+
+#include <geometric_shapes/shapes.h>
+#include <eigen_stl_containers/eigen_stl_vector_container.h>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace collision_detection
+{
+/** \brief Parameters of computeConvexDecomposition() */
+struct ConvexDecompositionParameters
+{
+  /** \brief A part is not split further once its convex hull exceeds its volume by at most this fraction of the
+      hull volume */
+  double max_concavity = 0.05;
+
+  /** \brief Maximum number of convex parts of a mesh */
+  unsigned int max_parts = 32;
+
+  /** \brief Name under which decompositions with these parameters are cached */
+  std::string getCacheName() const;
+};
+
+/** \brief Compute the convex hull of \e points as a closed triangle mesh with outward facing triangles.
+    Returns false if the points do not span a volume. */
+bool computeConvexHull(const EigenSTL::vector_Vector3d& points, EigenSTL::vector_Vector3d& vertices,
+                       std::vector<unsigned int>& triangles);
+
+/** \brief Approximate \e mesh by the union of convex meshes.
+ *
+ * The mesh is split recursively by axis-aligned planes, cutting triangles and closing the cut, and each part is
+ * replaced by its convex hull. The part whose hull adds the most volume is split first, at the plane that minimizes
+ * the volume of the two new hulls, until all parts are within \e params.max_concavity or \e params.max_parts is
+ * reached. The union of the parts contains the volume enclosed by the mesh. Meshes that do not enclose a volume
+ * are replaced by their convex hull. An empty vector is returned if the mesh has no convex hull. */
+std::vector<shapes::ShapeConstPtr> computeConvexDecomposition(const shapes::Mesh& mesh,
+                                                              const ConvexDecompositionParameters& params);
+
+/** \brief Get the convex decomposition of the mesh \e shape, computing it only once per distinct mesh.
+    Decompositions are kept in GeometryCache::getGlobal() and persisted if it has a persistent directory. */
+std::shared_ptr<const std::vector<shapes::ShapeConstPtr>>
+getConvexDecomposition(const shapes::ShapeConstPtr& shape, const ConvexDecompositionParameters& params);
+}  // namespace collision_detection
@@ -0,0 +1,145 @@
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2026, PickNik LLC.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of PickNik LLC nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *********************************************************************/
+
+#pragma once
+
+#include <geometric_shapes/shapes.h>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace collision_detection
+{
+/** \brief Process-wide cache of mesh geometry, keyed by the content of the meshes.
+ *
+ * intern() maps meshes with identical vertices and triangles to a single shared instance, so scenes that contain
+ * many copies of the same part, or that receive the same mesh repeatedly, hold it only once. Collision checkers
+ * attach the data structures they derive from a mesh (bounding volume hierarchies, convex hulls, ...) with
+ * getDerived(), so each of them is built once per distinct mesh rather than once per object. Derived data lives as
+ * long as some instance of its mesh is alive.
+ *
+ * Derived data that can be stored as a byte string may additionally be persisted in a directory, see
+ * setPersistentDirectory(), so that it survives restarts and is shared between processes. Persisted data can be
+ * mapped read-only with mapPersistent(), in which case processes on the same host share a single copy of it in
+ * memory. The global cache persists to the directory named by the environment variable MOVEIT_GEOMETRY_CACHE_DIR,
+ * if set, so co-located processes attach to the same store without further configuration. */
+class GeometryCache
+{
+public:
+  /** \brief Read-only view of persisted data. It stays valid as long as the view exists. */
+  struct PersistentView
+  {
+    const char* data = nullptr;
+    std::size_t size = 0;
+  };
+  using PersistentViewConstPtr = std::shared_ptr<const PersistentView>;
+
+  /** \brief The cache shared by World and all collision environments of this process */
+  static GeometryCache& getGlobal();
+
+  /** \brief Hash of the vertices and triangles of \e mesh. Different seeds give independent hashes. */
+  static std::uint64_t computeMeshHash(const shapes::Mesh& mesh, std::uint64_t seed = 14695981039346656037ULL);
+
+  /** \brief Return the cached instance of a mesh with the same content as \e shape, registering \e shape if there
+      is none. Shapes other than meshes are returned unchanged. */
+  shapes::ShapeConstPtr intern(const shapes::ShapeConstPtr& shape);
+
+  /** \brief Get the data of kind \e name derived from the mesh content of \e shape, calling \e create to compute it
+      if it is not cached yet. \e create may run concurrently for the same data in different threads; the first
+      result stored is returned to all of them. \e name must identify the type T. Data derived from shapes other
+      than meshes is not cached. */
+  template <typename T>
+  std::shared_ptr<const T> getDerived(const shapes::ShapeConstPtr& shape, const std::string& name,
+                                      const std::function<std::shared_ptr<const T>()>& create)
+  {
+    return std::static_pointer_cast<const T>(
+        getDerivedImpl(shape, name, [&create]() -> std::shared_ptr<const void> { return create(); }));
+  }
+
+  /** \brief Store persistent derived data in \e directory, which must exist. An empty directory, the default,
+      disables persistence. */
+  void setPersistentDirectory(const std::string& directory);
+
+  const std::string& getPersistentDirectory() const
+  {
+    return directory_;
+  }
+
+  /** \brief Read the persisted data of kind \e name for \e mesh. \e name is part of the file name. Returns false if persistence is disabled or
+      there is no valid file. */
+  bool loadPersistent(const shapes::Mesh& mesh, const std::string& name, std::string& data) const;
+
+  /** \brief Map the persisted data of kind \e name for \e mesh read-only into memory. The pages are backed by the
+      cache file and shared with all processes mapping it. Returns nullptr if persistence is disabled or there is
+      no valid file. */
+  PersistentViewConstPtr mapPersistent(const shapes::Mesh& mesh, const std::string& name) const;
+
+  /** \brief Persist \e data of kind \e name for \e mesh. Returns false if persistence is disabled or the file could
+      not be written. */
+  bool storePersistent(const shapes::Mesh& mesh, const std::string& name, const std::string& data) const;
+
+  /** \brief Number of distinct meshes currently cached */
+  std::size_t size() const;
+
+  /** \brief Drop all cached meshes and derived data. Meshes returned earlier stay valid. */
+  void clear();
+
+private:
+  struct Entry
+  {
+    std::weak_ptr<const shapes::Mesh> mesh;
+    std::map<std::string, std::shared_ptr<const void>> derived;
+  };
+
+  /** \brief Find the entry of the mesh content of \e mesh; the lock must be held */
+  Entry* findEntry(const shapes::Mesh& mesh, std::uint64_t hash);
+
+  /** \brief Remove entries whose meshes expired; the lock must be held */
+  void removeExpired();
+
+  std::shared_ptr<const void> getDerivedImpl(const shapes::ShapeConstPtr& shape, const std::string& name,
+                                             const std::function<std::shared_ptr<const void>()>& create);
+
+  std::string getPersistentFilename(const shapes::Mesh& mesh, const std::string& name) const;
+
+  mutable std::mutex lock_;
+  std::multimap<std::uint64_t, Entry> entries_;
+  std::size_t inserts_since_cleanup_ = 0;
+  std::string directory_;
+};
+}  // namespace collision_detection
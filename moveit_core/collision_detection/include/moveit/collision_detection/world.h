@@ -40,7 +40,11 @@
 
 #include <string>
 #include <vector>
+#include <iterator>
 #include <map>
+#include <memory>
+#include <mutex>
+#include <set>
 #include <boost/function.hpp>
 #include <Eigen/Geometry>
 #include <eigen_stl_containers/eigen_stl_vector_container.h>
@@ -123,28 +127,105 @@ public:
   /** \brief Get a particular object */
   ObjectConstPtr getObject(const std::string& object_id) const;
 
-  /** iterator over the objects in the world. */
-  using const_iterator = std::map<std::string, ObjectPtr>::const_iterator;
-  /** iterator pointing to first change */
+  using ObjectMap = std::map<std::string, ObjectPtr>;
+
+  /** iterator over the objects in the world, in order of their ids.
+   * The objects are stored as a map shared between copies of the world and
+   * a map of the objects changed since, and the iterator merges both. */
+  class const_iterator
+  {
+  public:
+    using iterator_category = std::forward_iterator_tag;
+    using value_type = ObjectMap::value_type;
+    using difference_type = std::ptrdiff_t;
+    using pointer = const value_type*;
+    using reference = const value_type&;
+
+    const_iterator() = default;
+
+    reference operator*() const
+    {
+      return fromChanged() ? *changed_ : *shared_;
+    }
+    pointer operator->() const
+    {
+      return &**this;
+    }
+    const_iterator& operator++()
+    {
+      advance();
+      skipRemoved();
+      return *this;
+    }
+    const_iterator operator++(int)
+    {
+      const_iterator it = *this;
+      ++*this;
+      return it;
+    }
+    bool operator==(const const_iterator& other) const
+    {
+      return shared_ == other.shared_ && changed_ == other.changed_;
+    }
+    bool operator!=(const const_iterator& other) const
+    {
+      return !(*this == other);
+    }
+
+  private:
+    const_iterator(ObjectMap::const_iterator shared, ObjectMap::const_iterator shared_end,
+                   ObjectMap::const_iterator changed, ObjectMap::const_iterator changed_end)
+      : shared_(shared), shared_end_(shared_end), changed_(changed), changed_end_(changed_end)
+    {
+      skipRemoved();
+    }
+
+    /* changed objects shadow shared objects with the same id */
+    bool fromChanged() const
+    {
+      return shared_ == shared_end_ || (changed_ != changed_end_ && changed_->first <= shared_->first);
+    }
+    void advance()
+    {
+      if (fromChanged())
+      {
+        if (shared_ != shared_end_ && shared_->first == changed_->first)
+          ++shared_;
+        ++changed_;
+      }
+      else
+        ++shared_;
+    }
+    /* removed objects are recorded as changed objects without value */
+    void skipRemoved()
+    {
+      while (changed_ != changed_end_ && !changed_->second && fromChanged())
+        advance();
+    }
+
+    ObjectMap::const_iterator shared_, shared_end_, changed_, changed_end_;
+    friend class World;
+  };
+
+  /** iterator pointing to first object */
   const_iterator begin() const
   {
-    return objects_.begin();
+    return const_iterator(shared_objects_->begin(), shared_objects_->end(), changed_objects_.begin(),
+                          changed_objects_.end());
   }
-  /** iterator pointing to end of changes */
+  /** iterator pointing to end of objects */
   const_iterator end() const
   {
-    return objects_.end();
+    return const_iterator(shared_objects_->end(), shared_objects_->end(), changed_objects_.end(),
+                          changed_objects_.end());
   }
-  /** number of changes stored */
+  /** number of objects */
   std::size_t size() const
   {
-    return objects_.size();
-  }
-  /** find changes for a named object */
-  const_iterator find(const std::string& object_id) const
-  {
-    return objects_.find(object_id);
+    return object_count_;
   }
+  /** find a named object */
+  const_iterator find(const std::string& object_id) const;
 
   /** \brief Check if a particular object exists in the collision world*/
   bool hasObject(const std::string& object_id) const;
@@ -178,7 +259,8 @@ public:
 
   /** \brief Add a pose and shapes to an object in the map.
    * This function makes repeated calls to addToObjectInternal() to add the
-   * shapes one by one.*/
+   * shapes one by one. Meshes are replaced by the instance with the same content
+   * in GeometryCache::getGlobal(), so the object may hold a different pointer than the one passed in.*/
   void addToObject(const std::string& object_id, const Eigen::Isometry3d& pose,
                    const std::vector<shapes::ShapeConstPtr>& shapes, const EigenSTL::vector_Isometry3d& shape_poses);
 
@@ -218,6 +300,11 @@ public:
   bool moveShapeInObject(const std::string& object_id, const shapes::ShapeConstPtr& shape,
                          const Eigen::Isometry3d& shape_pose);
 
+  /** \brief Replace the shape at \e shape_index of an object by a new version of it, e.g. an updated octree, which
+   * may also be the same pointer if the shape was modified in place. Observers are notified with UPDATE_SHAPE and may
+   * update their data structures incrementally. Returns true on success. */
+  bool updateShapeInObject(const std::string& object_id, std::size_t shape_index, const shapes::ShapeConstPtr& shape);
+
   /** \brief Move the object pose (thus moving all shapes and subframes in the object)
    * according to the given transform specified in world frame.
    * The transform is relative to and changes the object pose. It does not replace it.
@@ -249,6 +336,69 @@ public:
    * the memory is freed. */
   void clearObjects();
 
+  /**********************************************************************/
+  /* Bulk Changes                                                       */
+  /**********************************************************************/
+
+  /** \brief Start a bulk change.
+   * Until the matching endBulkChange(), observers are not notified. The
+   * changes are collected per object instead, and endBulkChange() notifies
+   * each changed object once with the combined action, as a WorldDiff would
+   * record it. Objects that were created and destroyed within the bulk
+   * change are not reported at all. Bulk changes may be nested; only the
+   * outermost one notifies. */
+  void beginBulkChange();
+
+  /** \brief End a bulk change started with beginBulkChange() */
+  void endBulkChange();
+
+  /** \brief Check if a bulk change is in progress */
+  bool inBulkChange() const
+  {
+    return bulk_change_depth_ > 0;
+  }
+
+  /** \brief Scoped bulk change: calls beginBulkChange() on construction and endBulkChange() on destruction */
+  class BulkChange
+  {
+  public:
+    explicit BulkChange(World& world) : world_(world)
+    {
+      world_.beginBulkChange();
+    }
+    ~BulkChange()
+    {
+      world_.endBulkChange();
+    }
+    BulkChange(const BulkChange&) = delete;
+    BulkChange& operator=(const BulkChange&) = delete;
+
+  private:
+    World& world_;
+  };
+
+  /**********************************************************************/
+  /* Spatial Queries                                                    */
+  /**********************************************************************/
+
+  /** \brief Get the axis-aligned bounding box of an object in the world frame.
+   * Objects containing a plane are unbounded. Returns an empty box if the
+   * object does not exist. */
+  Eigen::AlignedBox3d getObjectAABB(const std::string& object_id) const;
+
+  /** \brief Get the ids of the objects whose bounding boxes intersect \e box, in
+   * no particular order.
+   * The lookup uses an AABB tree over all objects that is kept up to date
+   * lazily, so queries are cheap as long as few objects changed since the
+   * previous one. Concurrent queries are safe. */
+  std::vector<std::string> getObjectIdsInBox(const Eigen::AlignedBox3d& box) const;
+
+  /** \brief Get the ids of the objects whose bounding boxes intersect the
+   * world-frame bounding box of a box with the given \e extents at \e pose
+   * (e.g. the bounding box of a link), padded by \e distance. */
+  std::vector<std::string> getObjectIdsNearBox(const Eigen::Isometry3d& pose, const Eigen::Vector3d& extents,
+                                               double distance) const;
+
   enum ActionBits
   {
     UNINITIALIZED = 0,
@@ -257,6 +407,7 @@ public:
     MOVE_SHAPE = 4,    /** one or more shapes in object were moved */
     ADD_SHAPE = 8,     /** shape(s) were added to object */
     REMOVE_SHAPE = 16, /** shape(s) were removed from object */
+    UPDATE_SHAPE = 32, /** shape(s) in object were replaced by a new version of the same geometry */
   };
 
   /** \brief Represents an action that occurred on an object in the world.
@@ -315,9 +466,15 @@ public:
   void notifyObserverAllObjects(const ObserverHandle observer_handle, Action action) const;
 
 private:
-  /** notify all observers of a change */
+  /** notify all observers of a change, or record it if a bulk change is in progress */
   void notify(const ObjectConstPtr& /*obj*/, Action /*action*/);
 
+  /** notify all observers of a change */
+  void notifyObservers(const ObjectConstPtr& obj, Action action);
+
+  /** Bring the spatial index up to date with the objects. Call with spatial_index_lock_ held. */
+  void updateSpatialIndex() const;
+
   /** send notification of change to all objects. */
   void notifyAll(Action action);
 
@@ -326,6 +483,25 @@ private:
    * clone is made so that it can be safely modified later on. */
   void ensureUnique(ObjectPtr& obj);
 
+  /** \brief Get the entry of an object in changed_objects_ for modification,
+   * sharing the object with shared_objects_ until ensureUnique() is called.
+   * The entry is null if the object does not exist; assigning an object to it
+   * creates the object. Call objectCreated() afterwards if it did. */
+  ObjectPtr& getObjectForWrite(const std::string& object_id);
+
+  /** \brief Account for the creation of an object through getObjectForWrite() */
+  void objectCreated()
+  {
+    ++object_count_;
+  }
+
+  /** \brief Remove an existing object from the map */
+  void eraseObject(const std::string& object_id);
+
+  /** \brief Merge the changed objects into a new shared map once there are
+   * enough of them to make lookups and copies noticeably slower */
+  void compactObjects();
+
   /* Add a shape with no checking */
   virtual void addToObjectInternal(const ObjectPtr& obj, const shapes::ShapeConstPtr& shape,
                                    const Eigen::Isometry3d& shape_pose);
@@ -333,8 +509,40 @@ private:
   /** \brief Updates the global shape and subframe poses. */
   void updateGlobalPosesInternal(ObjectPtr& obj, bool update_shape_poses = true, bool update_subframe_poses = true);
 
-  /** The objects maintained in the world */
-  std::map<std::string, ObjectPtr> objects_;
+  /** The objects maintained in the world, as a map that is shared with copies of
+   * this world and never modified, and the objects changed since. Removed objects
+   * are kept as null entries in changed_objects_ if they exist in shared_objects_.
+   * Copying the world thus only copies the changed objects. */
+  std::shared_ptr<const ObjectMap> shared_objects_;
+  ObjectMap changed_objects_;
+  std::size_t object_count_ = 0;
+
+  /** A change to an object recorded during a bulk change */
+  struct BulkChangeEntry
+  {
+    /** Whether observers knew the object before the bulk change */
+    bool known = false;
+    /** The object as observers knew it, if it was destroyed during the bulk change */
+    ObjectConstPtr destroyed;
+    /** The combined action since the object was created or last destroyed */
+    int action = 0;
+  };
+
+  /** Nesting depth of bulk changes */
+  unsigned int bulk_change_depth_ = 0;
+
+  /** The changes recorded during the current bulk change */
+  std::map<std::string, BulkChangeEntry> bulk_changes_;
+
+  /** Protects the lazily updated spatial index, so that const queries can run concurrently */
+  mutable std::mutex spatial_index_lock_;
+
+  /** The spatial index, shared with copies of this world until either is changed */
+  struct SpatialIndex;
+  mutable std::shared_ptr<const SpatialIndex> spatial_index_;
+
+  /** Objects whose bounding boxes changed since the spatial index was updated */
+  mutable std::set<std::string> changed_aabbs_;
 
   /** Wrapper for a callback function to call when something changes in the world */
   class Observer
@@ -0,0 +1,125 @@
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2026, PickNik LLC.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of PickNik LLC nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *********************************************************************/
+
+#include <moveit/collision_detection/aabb_tree.h>
+#include <algorithm>
+
+namespace collision_detection
+{
+namespace
+{
+// boxes per leaf; below this, testing all of them is cheaper than descending further
+constexpr std::size_t LEAF_SIZE = 4;
+}  // namespace
+
+void AABBTree::build(const std::vector<Eigen::AlignedBox3d>& boxes)
+{
+  clear();
+  if (boxes.empty())
+    return;
+
+  boxes_ = boxes;
+  indices_.resize(boxes_.size());
+  std::vector<Eigen::Vector3d> centers(boxes_.size());
+  for (std::size_t i = 0; i < boxes_.size(); ++i)
+  {
+    indices_[i] = i;
+    centers[i] = boxes_[i].center();
+  }
+  nodes_.reserve(2 * (boxes_.size() / LEAF_SIZE) + 1);
+  buildNode(0, boxes_.size(), centers);
+}
+
+void AABBTree::clear()
+{
+  boxes_.clear();
+  indices_.clear();
+  nodes_.clear();
+}
+
+std::size_t AABBTree::buildNode(std::size_t first, std::size_t count, const std::vector<Eigen::Vector3d>& centers)
+{
+  const std::size_t index = nodes_.size();
+  nodes_.emplace_back();
+  Eigen::AlignedBox3d box, center_box;
+  for (std::size_t i = first; i < first + count; ++i)
+  {
+    box.extend(boxes_[indices_[i]]);
+    center_box.extend(centers[indices_[i]]);
+  }
+  nodes_[index].box = box;
+  nodes_[index].first = first;
+  nodes_[index].count = count;
+  nodes_[index].left = nodes_[index].right = 0;
+  if (count <= LEAF_SIZE)
+    return index;
+
+  int axis;
+  center_box.sizes().maxCoeff(&axis);
+  const auto begin = indices_.begin() + first;
+  std::nth_element(begin, begin + count / 2, begin + count,
+                   [&centers, axis](std::size_t a, std::size_t b) { return centers[a][axis] < centers[b][axis]; });
+
+  // nodes_ may reallocate during the recursion, so no reference to the node is held across it
+  const std::size_t left = buildNode(first, count / 2, centers);
+  const std::size_t right = buildNode(first + count / 2, count - count / 2, centers);
+  nodes_[index].left = left;
+  nodes_[index].right = right;
+  return index;
+}
+
+void AABBTree::query(const Eigen::AlignedBox3d& box, std::vector<std::size_t>& indices) const
+{
+  if (nodes_.empty() || !nodes_.front().box.intersects(box))
+    return;
+
+  std::vector<std::size_t> stack(1, 0);
+  while (!stack.empty())
+  {
+    const Node& node = nodes_[stack.back()];
+    stack.pop_back();
+    if (node.left == 0)
+    {
+      for (std::size_t i = node.first; i < node.first + node.count; ++i)
+        if (boxes_[indices_[i]].intersects(box))
+          indices.push_back(indices_[i]);
+      continue;
+    }
+    if (nodes_[node.left].box.intersects(box))
+      stack.push_back(node.left);
+    if (nodes_[node.right].box.intersects(box))
+      stack.push_back(node.right);
+  }
+}
+}  // namespace collision_detection
@@ -0,0 +1,95 @@
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2026, PickNik LLC.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of PickNik LLC nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *********************************************************************/
+
+#include <moveit/collision_detection/bounding_spheres.h>
+#include <geometric_shapes/shapes.h>
+#include <cmath>
+#include <limits>
+#include <memory>
+
+namespace collision_detection
+{
+void getLinkShapeBoundingSpheres(const moveit::core::LinkModel* link, std::size_t shape_index, double scale,
+                                 double padding, std::vector<moveit::core::BoundingSphere>& spheres)
+{
+  if (std::fabs(scale - 1.0) <= std::numeric_limits<double>::epsilon() &&
+      std::fabs(padding) <= std::numeric_limits<double>::epsilon())
+  {
+    spheres = link->getShapeBoundingSpheres()[shape_index];
+    return;
+  }
+
+  // meshes are scaled about their vertex centroid, so the spheres are recomputed from the scaled shape
+  std::unique_ptr<shapes::Shape> scaled_shape(link->getShapes()[shape_index]->clone());
+  scaled_shape->scaleAndPadd(scale, padding);
+  moveit::core::computeBoundingSpheres(*scaled_shape, spheres);
+}
+
+bool boundingSpheresOverlap(const std::vector<moveit::core::BoundingSphere>& spheres1, const Eigen::Isometry3d& pose1,
+                            const std::vector<moveit::core::BoundingSphere>& spheres2, const Eigen::Isometry3d& pose2,
+                            double margin)
+{
+  if (spheres1.empty() || spheres2.empty())
+    return true;
+
+  // express the spheres of the second shape in the frame of the first one, to pose only one set
+  const Eigen::Isometry3d relative = pose1.inverse() * pose2;
+  for (const moveit::core::BoundingSphere& sphere2 : spheres2)
+  {
+    const Eigen::Vector3d center2 = relative * sphere2.center;
+    for (const moveit::core::BoundingSphere& sphere1 : spheres1)
+    {
+      const double reach = sphere1.radius + sphere2.radius + margin;
+      if ((center2 - sphere1.center).squaredNorm() <= reach * reach)
+        return true;
+    }
+  }
+  return false;
+}
+
+bool boundingSpheresOverlap(const std::vector<moveit::core::BoundingSphere>& spheres, const Eigen::Isometry3d& pose,
+                            const Eigen::AlignedBox3d& box, double margin)
+{
+  if (spheres.empty())
+    return true;
+
+  for (const moveit::core::BoundingSphere& sphere : spheres)
+  {
+    const double reach = sphere.radius + margin;
+    if (box.squaredExteriorDistance(pose * sphere.center) <= reach * reach)
+      return true;
+  }
+  return false;
+}
+}  // namespace collision_detection
@@ -35,7 +35,45 @@
 /* Author: Ioan Sucan, Jens Petit */
 
 #include <moveit/collision_detection/collision_env.h>
+#include <algorithm>
 #include <limits>
+#include <memory>
+#include <thread>
+
+namespace
+{
+/** \brief Call \e fn(i) for every index i < \e count, distributing contiguous chunks over \e threads threads */
+template <typename Fn>
+void forEachIndex(std::size_t count, unsigned int threads, const Fn& fn)
+{
+  const std::size_t chunks = std::max<std::size_t>(1, std::min<std::size_t>(threads, count));
+  const std::size_t chunk_size = (count + chunks - 1) / chunks;
+  auto run = [&](std::size_t begin) {
+    for (std::size_t i = begin, end = std::min(begin + chunk_size, count); i < end; ++i)
+      fn(i);
+  };
+
+  std::vector<std::thread> workers;
+  workers.reserve(chunks - 1);
+  for (std::size_t chunk = 1; chunk < chunks; ++chunk)
+    workers.emplace_back(run, chunk * chunk_size);
+  run(0);
+  for (std::thread& worker : workers)
+    worker.join();
+}
+
+/** \brief Evaluate \e check for every state, distributing contiguous chunks of states over \e threads threads */
+template <typename CheckFn>
+void checkStates(const std::vector<const moveit::core::RobotState*>& states, std::vector<bool>& colliding,
+                 unsigned int threads, const CheckFn& check)
+{
+  const std::size_t count = states.size();
+  // std::vector<bool> cannot be written concurrently
+  std::unique_ptr<bool[]> flags(new bool[count]);
+  forEachIndex(count, threads, [&](std::size_t i) { flags[i] = check(*states[i]); });
+  colliding.assign(flags.get(), flags.get() + count);
+}
+}  // namespace
 
 static inline bool validateScale(double scale)
 {
@@ -107,6 +145,8 @@ CollisionEnv::CollisionEnv(const CollisionEnv& other, const WorldPtr& world)
 {
   link_padding_ = other.link_padding_;
   link_scale_ = other.link_scale_;
+  convex_decomposition_ = other.convex_decomposition_;
+  convex_decomposition_parameters_ = other.convex_decomposition_parameters_;
 }
 void CollisionEnv::setPadding(double padding)
 {
@@ -279,6 +319,53 @@ void CollisionEnv::updatedPaddingOrScaling(const std::vector<std::string>& /*lin
 {
 }
 
+void CollisionEnv::setConvexDecomposition(bool enabled, const ConvexDecompositionParameters& parameters)
+{
+  convex_decomposition_ = enabled;
+  convex_decomposition_parameters_ = parameters;
+  updatedConvexDecomposition();
+}
+
+void CollisionEnv::updatedConvexDecomposition()
+{
+}
+
+void CollisionEnv::prepareWorldShapes(const std::vector<shapes::ShapeConstPtr>& shapes) const
+{
+  if (!convex_decomposition_)
+    return;
+  for (const shapes::ShapeConstPtr& shape : shapes)
+    if (shape && shape->type == shapes::MESH)
+      getConvexDecomposition(shape, convex_decomposition_parameters_);
+}
+
+void CollisionEnv::getWorldObjectCollisionShapes(const World::Object& obj, std::vector<shapes::ShapeConstPtr>& shapes,
+                                                 EigenSTL::vector_Isometry3d& poses, std::vector<bool>& convex) const
+{
+  shapes.clear();
+  poses.clear();
+  convex.clear();
+  for (std::size_t i = 0; i < obj.shapes_.size(); ++i)
+  {
+    if (convex_decomposition_ && obj.shapes_[i]->type == shapes::MESH)
+    {
+      std::shared_ptr<const std::vector<shapes::ShapeConstPtr>> parts =
+          getConvexDecomposition(obj.shapes_[i], convex_decomposition_parameters_);
+      // meshes without a decomposition are checked as they are
+      if (!parts->empty())
+      {
+        shapes.insert(shapes.end(), parts->begin(), parts->end());
+        poses.insert(poses.end(), parts->size(), obj.global_shape_poses_[i]);
+        convex.insert(convex.end(), parts->size(), true);
+        continue;
+      }
+    }
+    shapes.push_back(obj.shapes_[i]);
+    poses.push_back(obj.global_shape_poses_[i]);
+    convex.push_back(false);
+  }
+}
+
 void CollisionEnv::setWorld(const WorldPtr& world)
 {
   world_ = world;
@@ -304,4 +391,56 @@ void CollisionEnv::checkCollision(const CollisionRequest& req, CollisionResult&
     checkRobotCollision(req, res, state, acm);
 }
 
+bool CollisionEnv::isSelfColliding(const moveit::core::RobotState& state, const AllowedCollisionMatrix& acm,
+                                   const std::string& group_name) const
+{
+  CollisionRequest req;
+  req.group_name = group_name;
+  CollisionResult res;
+  checkSelfCollision(req, res, state, acm);
+  return res.collision;
+}
+
+bool CollisionEnv::isRobotColliding(const moveit::core::RobotState& state, const AllowedCollisionMatrix& acm,
+                                    const std::string& group_name) const
+{
+  CollisionRequest req;
+  req.group_name = group_name;
+  CollisionResult res;
+  checkRobotCollision(req, res, state, acm);
+  return res.collision;
+}
+
+void CollisionEnv::isSelfColliding(const std::vector<const moveit::core::RobotState*>& states,
+                                   const AllowedCollisionMatrix& acm, std::vector<bool>& colliding,
+                                   const std::string& group_name, unsigned int threads) const
+{
+  checkStates(states, colliding, threads, [&](const moveit::core::RobotState& state) {
+    return isSelfColliding(state, acm, group_name);
+  });
+}
+
+void CollisionEnv::isRobotColliding(const std::vector<const moveit::core::RobotState*>& states,
+                                    const AllowedCollisionMatrix& acm, std::vector<bool>& colliding,
+                                    const std::string& group_name, unsigned int threads) const
+{
+  checkStates(states, colliding, threads, [&](const moveit::core::RobotState& state) {
+    return isRobotColliding(state, acm, group_name);
+  });
+}
+
+void CollisionEnv::distanceSelf(const DistanceRequest& req, const std::vector<const moveit::core::RobotState*>& states,
+                                std::vector<DistanceResult>& results, unsigned int threads) const
+{
+  results.assign(states.size(), DistanceResult());
+  forEachIndex(states.size(), threads, [&](std::size_t i) { distanceSelf(req, results[i], *states[i]); });
+}
+
+void CollisionEnv::distanceRobot(const DistanceRequest& req, const std::vector<const moveit::core::RobotState*>& states,
+                                 std::vector<DistanceResult>& results, unsigned int threads) const
+{
+  results.assign(states.size(), DistanceResult());
+  forEachIndex(states.size(), threads, [&](std::size_t i) { distanceRobot(req, results[i], *states[i]); });
+}
+
 }  // end of namespace collision_detection
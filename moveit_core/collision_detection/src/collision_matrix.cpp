@@ -157,12 +157,14 @@ void AllowedCollisionMatrix::setEntry(const std::string& name1, const std::strin
     if (jt != it->second.end())
       it->second.erase(jt);
   }
+  updateCode(addName(name1), addName(name2));
 }
 
 void AllowedCollisionMatrix::setEntry(const std::string& name1, const std::string& name2, const DecideContactFn& fn)
 {
   entries_[name1][name2] = entries_[name2][name1] = AllowedCollision::CONDITIONAL;
   allowed_contacts_[name1][name2] = allowed_contacts_[name2][name1] = fn;
+  updateCode(addName(name1), addName(name2));
 }
 
 void AllowedCollisionMatrix::removeEntry(const std::string& name)
@@ -173,6 +175,7 @@ void AllowedCollisionMatrix::removeEntry(const std::string& name)
     entry.second.erase(name);
   for (auto& allowed_contact : allowed_contacts_)
     allowed_contact.second.erase(name);
+  updateName(name);
 }
 
 void AllowedCollisionMatrix::removeEntry(const std::string& name1, const std::string& name2)
@@ -206,6 +209,11 @@ void AllowedCollisionMatrix::removeEntry(const std::string& name1, const std::st
     if (jt != it->second.end())
       it->second.erase(jt);
   }
+
+  const int index1 = getEntryIndex(name1);
+  const int index2 = getEntryIndex(name2);
+  if (index1 >= 0 && index2 >= 0)
+    updateCode(index1, index2);
 }
 
 void AllowedCollisionMatrix::setEntry(const std::string& name, const std::vector<std::string>& other_names, bool allowed)
@@ -239,6 +247,9 @@ void AllowedCollisionMatrix::setEntry(bool allowed)
   for (auto& entry : entries_)
     for (auto& it2 : entry.second)
       it2.second = v;
+  for (std::size_t i = 0; i < names_.size(); ++i)
+    for (std::size_t j = i; j < names_.size(); ++j)
+      updateCode(i, j);
 }
 
 void AllowedCollisionMatrix::setDefaultEntry(const std::string& name, bool allowed)
@@ -246,12 +257,16 @@ void AllowedCollisionMatrix::setDefaultEntry(const std::string& name, bool allow
   const AllowedCollision::Type v = allowed ? AllowedCollision::ALWAYS : AllowedCollision::NEVER;
   default_entries_[name] = v;
   default_allowed_contacts_.erase(name);
+  addName(name);
+  updateName(name);
 }
 
 void AllowedCollisionMatrix::setDefaultEntry(const std::string& name, const DecideContactFn& fn)
 {
   default_entries_[name] = AllowedCollision::CONDITIONAL;
   default_allowed_contacts_[name] = fn;
+  addName(name);
+  updateName(name);
 }
 
 bool AllowedCollisionMatrix::getDefaultEntry(const std::string& name, AllowedCollision::Type& allowed_collision) const
@@ -325,7 +340,66 @@ bool AllowedCollisionMatrix::getDefaultEntry(const std::string& name1, const std
 bool AllowedCollisionMatrix::getAllowedCollision(const std::string& name1, const std::string& name2,
                                                  AllowedCollision::Type& allowed_collision) const
 {
-  return getEntry(name1, name2, allowed_collision) || getDefaultEntry(name1, name2, allowed_collision);
+  return getAllowedCollision(getEntryIndex(name1), getEntryIndex(name2), allowed_collision);
+}
+
+void AllowedCollisionMatrix::setCode(std::size_t index1, std::size_t index2, unsigned int code)
+{
+  const std::size_t cell = index1 * stride_ + index2;
+  const std::size_t shift = 2 * (cell % CODES_PER_WORD);
+  std::uint64_t& word = dense_[cell / CODES_PER_WORD];
+  word = (word & ~(std::uint64_t(3) << shift)) | (std::uint64_t(code) << shift);
+}
+
+std::size_t AllowedCollisionMatrix::addName(const std::string& name)
+{
+  auto it = name_indices_.find(name);
+  if (it != name_indices_.end())
+    return it->second;
+
+  const std::size_t index = names_.size();
+  if (index >= stride_)
+  {
+    // double the capacity and move the existing codes to their new cells
+    const std::size_t old_stride = stride_;
+    std::vector<std::uint64_t> old_dense;
+    old_dense.swap(dense_);
+    stride_ = std::max<std::size_t>(16, 2 * stride_);
+    dense_.assign((stride_ * stride_ + CODES_PER_WORD - 1) / CODES_PER_WORD, 0);
+    for (std::size_t i = 0; i < index; ++i)
+      for (std::size_t j = 0; j < index; ++j)
+      {
+        const std::size_t cell = i * old_stride + j;
+        setCode(i, j, (old_dense[cell / CODES_PER_WORD] >> (2 * (cell % CODES_PER_WORD))) & 3u);
+      }
+  }
+  names_.push_back(name);
+  name_indices_[name] = index;
+  default_codes_.push_back(NO_ENTRY);
+  updateName(name);
+  return index;
+}
+
+void AllowedCollisionMatrix::updateCode(std::size_t index1, std::size_t index2)
+{
+  AllowedCollision::Type type;
+  const unsigned int code = getEntry(names_[index1], names_[index2], type) ||
+                                    getDefaultEntry(names_[index1], names_[index2], type) ?
+                                static_cast<unsigned int>(type) + 1 :
+                                NO_ENTRY;
+  setCode(index1, index2, code);
+  setCode(index2, index1, code);
+}
+
+void AllowedCollisionMatrix::updateName(const std::string& name)
+{
+  const int index = getEntryIndex(name);
+  if (index < 0)
+    return;
+  AllowedCollision::Type type;
+  default_codes_[index] = getDefaultEntry(name, type) ? static_cast<unsigned int>(type) + 1 : NO_ENTRY;
+  for (std::size_t j = 0; j < names_.size(); ++j)
+    updateCode(index, j);
 }
 
 void AllowedCollisionMatrix::clear()
@@ -334,6 +408,11 @@ void AllowedCollisionMatrix::clear()
   allowed_contacts_.clear();
   default_entries_.clear();
   default_allowed_contacts_.clear();
+  names_.clear();
+  name_indices_.clear();
+  default_codes_.clear();
+  dense_.clear();
+  stride_ = 0;
 }
 
 void AllowedCollisionMatrix::getAllEntryNames(std::vector<std::string>& names) const
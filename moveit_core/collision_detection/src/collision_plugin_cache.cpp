@@ -90,6 +90,15 @@ public:
     return false;
   }
 
+  bool add(const std::string& name, const planning_scene::PlanningScenePtr& scene)
+  {
+    // plugins can only activate their detector, so restore the active one afterwards
+    const std::string active = scene->getActiveCollisionDetectorName();
+    if (!activate(name, scene, false))
+      return false;
+    return scene->setActiveCollisionDetector(active);
+  }
+
 private:
   std::shared_ptr<pluginlib::ClassLoader<CollisionPlugin>> cache_;
   std::map<std::string, CollisionPluginPtr> plugins_;
@@ -108,4 +117,9 @@ bool CollisionPluginCache::activate(const std::string& name, const planning_scen
   return cache_->activate(name, scene, exclusive);
 }
 
+bool CollisionPluginCache::add(const std::string& name, const planning_scene::PlanningScenePtr& scene)
+{
+  return cache_->add(name, scene);
+}
+
 }  // namespace collision_detection
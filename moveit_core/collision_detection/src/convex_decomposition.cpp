@@ -0,0 +1,517 @@
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2026, PickNik LLC.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of PickNik LLC nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *********************************************************************/
+
+#include <moveit/collision_detection/convex_decomposition.h>
+#include <moveit/collision_detection/geometry_cache.h>
+#include <ros/console.h>
+#include <Eigen/Geometry>
+#include <algorithm>
+#include <cstring>
+#include <iomanip>
+#include <limits>
+#include <set>
+#include <sstream>
+#include <utility>
+
+namespace collision_detection
+{
+namespace
+{
+struct HullFace
+{
+  unsigned int v[3];
+  Eigen::Vector3d normal;
+  double offset;
+  bool alive;
+  /** \brief Points that are outside of this face and not assigned to another one */
+  std::vector<unsigned int> outside;
+};
+
+HullFace makeHullFace(const EigenSTL::vector_Vector3d& points, unsigned int a, unsigned int b, unsigned int c)
+{
+  HullFace face;
+  face.v[0] = a;
+  face.v[1] = b;
+  face.v[2] = c;
+  face.normal = (points[b] - points[a]).cross(points[c] - points[a]);
+  const double norm = face.normal.norm();
+  if (norm > 0.0)
+    face.normal /= norm;
+  face.offset = face.normal.dot(points[a]);
+  face.alive = true;
+  return face;
+}
+
+/** \brief A closed triangle soup, three vertices per triangle, and its convex hull */
+struct Part
+{
+  EigenSTL::vector_Vector3d triangles;
+  EigenSTL::vector_Vector3d hull_vertices;
+  std::vector<unsigned int> hull_triangles;
+  double volume;
+  double hull_volume;
+
+  double excess() const
+  {
+    return hull_volume - volume;
+  }
+};
+
+/** \brief Signed volume enclosed by a closed triangle soup */
+double computeVolume(const EigenSTL::vector_Vector3d& triangles)
+{
+  double volume = 0.0;
+  for (std::size_t i = 0; i + 2 < triangles.size(); i += 3)
+    volume += triangles[i].dot(triangles[i + 1].cross(triangles[i + 2]));
+  return volume / 6.0;
+}
+
+/** \brief Compute the hull of the part and its volume; returns false if the part does not span a volume */
+bool computePartHull(Part& part, double sign)
+{
+  // neighboring triangles share their vertices
+  EigenSTL::vector_Vector3d points = part.triangles;
+  auto less = [](const Eigen::Vector3d& a, const Eigen::Vector3d& b) {
+    return std::lexicographical_compare(a.data(), a.data() + 3, b.data(), b.data() + 3);
+  };
+  std::sort(points.begin(), points.end(), less);
+  points.erase(std::unique(points.begin(), points.end()), points.end());
+  if (!computeConvexHull(points, part.hull_vertices, part.hull_triangles))
+    return false;
+  EigenSTL::vector_Vector3d hull;
+  hull.reserve(part.hull_triangles.size());
+  for (unsigned int index : part.hull_triangles)
+    hull.push_back(part.hull_vertices[index]);
+  part.hull_volume = computeVolume(hull);
+  // the parts of a closed mesh are closed, so their volume is exact up to rounding
+  part.volume = std::min(std::max(sign * computeVolume(part.triangles), 0.0), part.hull_volume);
+  return true;
+}
+
+/** \brief Append the part of triangle \e t on one side of the plane normal * x = offset to \e out, and the cut
+    edges of the triangle, oriented like the cap that closes the cut, to \e cuts */
+void clipTriangle(const Eigen::Vector3d* t, const Eigen::Vector3d& normal, double offset, bool positive,
+                  EigenSTL::vector_Vector3d& out, EigenSTL::vector_Vector3d& cuts)
+{
+  double s[3];
+  bool inside[3];
+  for (int i = 0; i < 3; ++i)
+  {
+    s[i] = normal.dot(t[i]) - offset;
+    inside[i] = positive ? s[i] > 0.0 : s[i] <= 0.0;
+  }
+
+  Eigen::Vector3d polygon[4];
+  int count = 0;
+  Eigen::Vector3d entry, exit;
+  bool cut = false;
+  for (int i = 0; i < 3; ++i)
+  {
+    const int j = (i + 1) % 3;
+    if (inside[i])
+      polygon[count++] = t[i];
+    if (inside[i] != inside[j])
+    {
+      const Eigen::Vector3d p = t[i] + (t[j] - t[i]) * (s[i] / (s[i] - s[j]));
+      polygon[count++] = p;
+      if (inside[i])
+        exit = p;
+      else
+        entry = p;
+      cut = true;
+    }
+  }
+
+  for (int i = 1; i + 1 < count; ++i)
+  {
+    out.push_back(polygon[0]);
+    out.push_back(polygon[i]);
+    out.push_back(polygon[i + 1]);
+  }
+  // the piece has the edge exit -> entry, the cap traverses it the other way
+  if (cut && count > 0)
+  {
+    cuts.push_back(entry);
+    cuts.push_back(exit);
+  }
+}
+
+/** \brief The part of the closed soup \e triangles on one side of a plane, closed by a cap in the plane */
+EigenSTL::vector_Vector3d splitPart(const EigenSTL::vector_Vector3d& triangles, const Eigen::Vector3d& normal,
+                                    double offset, bool positive)
+{
+  EigenSTL::vector_Vector3d out, cuts;
+  for (std::size_t i = 0; i + 2 < triangles.size(); i += 3)
+    clipTriangle(&triangles[i], normal, offset, positive, out, cuts);
+  if (cuts.empty())
+    return out;
+
+  // a fan around any point of the plane closes each loop of cut edges, also for non-convex cuts
+  Eigen::Vector3d center = Eigen::Vector3d::Zero();
+  for (const Eigen::Vector3d& p : cuts)
+    center += p;
+  center /= cuts.size();
+  center -= normal * (normal.dot(center) - offset);
+  for (std::size_t i = 0; i < cuts.size(); i += 2)
+  {
+    out.push_back(cuts[i]);
+    out.push_back(cuts[i + 1]);
+    out.push_back(center);
+  }
+  return out;
+}
+
+/** \brief Split \e part at the best of five axis-aligned planes; returns false if no plane gives two parts */
+bool splitBest(const Part& part, double sign, Part& best_first, Part& best_second)
+{
+  Eigen::AlignedBox3d box;
+  for (const Eigen::Vector3d& v : part.triangles)
+    box.extend(v);
+  const double min_extent = 1e-6 * box.sizes().maxCoeff();
+
+  int longest;
+  box.sizes().maxCoeff(&longest);
+
+  double best = std::numeric_limits<double>::infinity();
+  for (int axis = 0; axis < 3; ++axis)
+  {
+    if (box.sizes()[axis] <= min_extent)
+      continue;
+    // the midplanes of all axes, and off-center planes along the longest one
+    for (double fraction : { 0.5, 0.25, 0.75 })
+    {
+      if (fraction != 0.5 && axis != longest)
+        continue;
+      Part first, second;
+      const Eigen::Vector3d normal = Eigen::Vector3d::Unit(axis);
+      const double offset = box.min()[axis] + fraction * box.sizes()[axis];
+      first.triangles = splitPart(part.triangles, normal, offset, true);
+      second.triangles = splitPart(part.triangles, normal, offset, false);
+      if (!computePartHull(first, sign) || !computePartHull(second, sign))
+        continue;
+      const double cost = first.hull_volume + second.hull_volume;
+      if (cost < best)
+      {
+        best = cost;
+        best_first = std::move(first);
+        best_second = std::move(second);
+      }
+    }
+  }
+  return best < std::numeric_limits<double>::infinity();
+}
+
+shapes::ShapeConstPtr makeMesh(const EigenSTL::vector_Vector3d& vertices, const std::vector<unsigned int>& triangles)
+{
+  auto mesh = std::make_shared<shapes::Mesh>(vertices.size(), triangles.size() / 3);
+  for (std::size_t i = 0; i < vertices.size(); ++i)
+    for (int j = 0; j < 3; ++j)
+      mesh->vertices[3 * i + j] = vertices[i][j];
+  std::copy(triangles.begin(), triangles.end(), mesh->triangles);
+  return mesh;
+}
+
+/** \brief Flatten the convex meshes of a decomposition for GeometryCache::storePersistent() */
+std::string serializeDecomposition(const std::vector<shapes::ShapeConstPtr>& parts)
+{
+  std::string data;
+  auto append = [&data](const void* bytes, std::size_t size) {
+    data.append(static_cast<const char*>(bytes), size);
+  };
+  const std::uint32_t count = parts.size();
+  append(&count, sizeof(count));
+  for (const shapes::ShapeConstPtr& part : parts)
+  {
+    const shapes::Mesh& mesh = static_cast<const shapes::Mesh&>(*part);
+    const std::uint32_t sizes[2] = { mesh.vertex_count, mesh.triangle_count };
+    append(sizes, sizeof(sizes));
+    append(mesh.vertices, 3 * sizeof(double) * mesh.vertex_count);
+    append(mesh.triangles, 3 * sizeof(unsigned int) * mesh.triangle_count);
+  }
+  return data;
+}
+
+bool deserializeDecomposition(const std::string& data, std::vector<shapes::ShapeConstPtr>& parts)
+{
+  std::size_t position = 0;
+  auto read = [&data, &position](void* bytes, std::size_t size) {
+    if (position + size > data.size())
+      return false;
+    std::memcpy(bytes, data.data() + position, size);
+    position += size;
+    return true;
+  };
+  std::uint32_t count;
+  if (!read(&count, sizeof(count)))
+    return false;
+  parts.clear();
+  for (std::uint32_t i = 0; i < count; ++i)
+  {
+    std::uint32_t sizes[2];
+    if (!read(sizes, sizeof(sizes)) ||
+        position + 3 * (sizeof(double) * sizes[0] + sizeof(unsigned int) * sizes[1]) > data.size())
+      return false;
+    auto mesh = std::make_shared<shapes::Mesh>(sizes[0], sizes[1]);
+    read(mesh->vertices, 3 * sizeof(double) * sizes[0]);
+    read(mesh->triangles, 3 * sizeof(unsigned int) * sizes[1]);
+    parts.push_back(mesh);
+  }
+  return position == data.size();
+}
+}  // namespace
+
+std::string ConvexDecompositionParameters::getCacheName() const
+{
+  std::stringstream name;
+  name << "convex_decomposition_" << std::setprecision(6) << max_concavity << "_" << max_parts;
+  return name.str();
+}
+
+bool computeConvexHull(const EigenSTL::vector_Vector3d& points, EigenSTL::vector_Vector3d& vertices,
+                       std::vector<unsigned int>& triangles)
+{
+  vertices.clear();
+  triangles.clear();
+  if (points.size() < 4)
+    return false;
+
+  Eigen::AlignedBox3d box;
+  for (const Eigen::Vector3d& p : points)
+    box.extend(p);
+  const double eps = 1e-9 * std::max(box.sizes().maxCoeff(), box.min().cwiseAbs().maxCoeff());
+
+  // initial tetrahedron of extreme points
+  unsigned int simplex[4] = { 0, 0, 0, 0 };
+  for (unsigned int i = 1; i < points.size(); ++i)
+    if (points[i].x() < points[simplex[0]].x())
+      simplex[0] = i;
+  double best = 0.0;
+  for (unsigned int i = 0; i < points.size(); ++i)
+    if ((points[i] - points[simplex[0]]).norm() > best)
+    {
+      best = (points[i] - points[simplex[0]]).norm();
+      simplex[1] = i;
+    }
+  if (best <= eps)
+    return false;
+  const Eigen::Vector3d axis = (points[simplex[1]] - points[simplex[0]]).normalized();
+  best = 0.0;
+  for (unsigned int i = 0; i < points.size(); ++i)
+  {
+    const double distance = (points[i] - points[simplex[0]]).cross(axis).norm();
+    if (distance > best)
+    {
+      best = distance;
+      simplex[2] = i;
+    }
+  }
+  if (best <= eps)
+    return false;
+  const Eigen::Vector3d normal =
+      (points[simplex[1]] - points[simplex[0]]).cross(points[simplex[2]] - points[simplex[0]]).normalized();
+  best = 0.0;
+  for (unsigned int i = 0; i < points.size(); ++i)
+  {
+    const double distance = std::abs(normal.dot(points[i] - points[simplex[0]]));
+    if (distance > best)
+    {
+      best = distance;
+      simplex[3] = i;
+    }
+  }
+  if (best <= eps)
+    return false;
+
+  const Eigen::Vector3d inside =
+      (points[simplex[0]] + points[simplex[1]] + points[simplex[2]] + points[simplex[3]]) / 4.0;
+  std::vector<HullFace> faces;
+  const unsigned int initial[4][3] = { { 0, 1, 2 }, { 0, 3, 1 }, { 0, 2, 3 }, { 1, 3, 2 } };
+  for (const auto& f : initial)
+  {
+    HullFace face = makeHullFace(points, simplex[f[0]], simplex[f[1]], simplex[f[2]]);
+    if (face.normal.dot(inside) > face.offset)
+      face = makeHullFace(points, simplex[f[0]], simplex[f[2]], simplex[f[1]]);
+    faces.push_back(face);
+  }
+
+  // every point outside the hull is kept in the list of one face it sees
+  for (unsigned int i = 0; i < points.size(); ++i)
+    for (HullFace& face : faces)
+      if (face.normal.dot(points[i]) - face.offset > eps)
+      {
+        face.outside.push_back(i);
+        break;
+      }
+
+  // add the farthest point seen by a face, replacing all faces it sees by a cone to their horizon
+  std::set<std::pair<unsigned int, unsigned int>> edges;
+  std::vector<unsigned int> orphans;
+  std::vector<std::size_t> alive = { 0, 1, 2, 3 };
+  for (std::size_t f = 0; f < faces.size(); ++f)
+    while (faces[f].alive && !faces[f].outside.empty())
+    {
+      unsigned int apex = faces[f].outside.front();
+      for (unsigned int i : faces[f].outside)
+        if (faces[f].normal.dot(points[i]) > faces[f].normal.dot(points[apex]))
+          apex = i;
+
+      edges.clear();
+      orphans.clear();
+      for (std::size_t g : alive)
+      {
+        HullFace& face = faces[g];
+        if (face.normal.dot(points[apex]) - face.offset > eps)
+        {
+          face.alive = false;
+          for (int k = 0; k < 3; ++k)
+            edges.insert(std::make_pair(face.v[k], face.v[(k + 1) % 3]));
+          orphans.insert(orphans.end(), face.outside.begin(), face.outside.end());
+          face.outside.clear();
+        }
+      }
+      alive.erase(std::remove_if(alive.begin(), alive.end(), [&faces](std::size_t g) { return !faces[g].alive; }),
+                  alive.end());
+
+      const std::size_t first_new = faces.size();
+      for (const std::pair<unsigned int, unsigned int>& edge : edges)
+        if (edges.find(std::make_pair(edge.second, edge.first)) == edges.end())
+        {
+          alive.push_back(faces.size());
+          faces.push_back(makeHullFace(points, edge.first, edge.second, apex));
+        }
+
+      // points outside the new hull see one of the new faces
+      for (unsigned int i : orphans)
+        if (i != apex)
+          for (std::size_t g = first_new; g < faces.size(); ++g)
+            if (faces[g].normal.dot(points[i]) - faces[g].offset > eps)
+            {
+              faces[g].outside.push_back(i);
+              break;
+            }
+    }
+
+  std::vector<int> index(points.size(), -1);
+  for (const HullFace& face : faces)
+    if (face.alive)
+      for (unsigned int v : face.v)
+      {
+        if (index[v] < 0)
+        {
+          index[v] = vertices.size();
+          vertices.push_back(points[v]);
+        }
+        triangles.push_back(index[v]);
+      }
+  return true;
+}
+
+std::vector<shapes::ShapeConstPtr> computeConvexDecomposition(const shapes::Mesh& mesh,
+                                                              const ConvexDecompositionParameters& params)
+{
+  Part whole;
+  whole.triangles.reserve(3 * mesh.triangle_count);
+  for (unsigned int i = 0; i < 3 * mesh.triangle_count; ++i)
+  {
+    const unsigned int v = mesh.triangles[i];
+    whole.triangles.push_back(Eigen::Vector3d(mesh.vertices[3 * v], mesh.vertices[3 * v + 1], mesh.vertices[3 * v + 2]));
+  }
+  // the orientation of the triangles of the mesh decides the sign of its volume
+  const double sign = computeVolume(whole.triangles) < 0.0 ? -1.0 : 1.0;
+
+  std::vector<Part> parts;
+  if (!computePartHull(whole, sign))
+  {
+    ROS_WARN_NAMED("collision_detection", "Unable to compute the convex hull of a mesh with %u vertices",
+                   mesh.vertex_count);
+    return std::vector<shapes::ShapeConstPtr>();
+  }
+
+  // open meshes do not enclose a volume to compare with, their hull is the closest convex approximation
+  const bool closed = whole.volume > 1e-6 * whole.hull_volume;
+  parts.push_back(std::move(whole));
+  std::vector<bool> done(1, !closed);
+  while (parts.size() < params.max_parts)
+  {
+    // split the part whose hull adds the most volume
+    std::size_t worst = parts.size();
+    for (std::size_t i = 0; i < parts.size(); ++i)
+      if (!done[i] && parts[i].excess() > params.max_concavity * parts[i].hull_volume &&
+          (worst == parts.size() || parts[i].excess() > parts[worst].excess()))
+        worst = i;
+    if (worst == parts.size())
+      break;
+
+    Part first, second;
+    if (!splitBest(parts[worst], sign, first, second))
+    {
+      done[worst] = true;
+      continue;
+    }
+    parts[worst] = std::move(first);
+    parts.push_back(std::move(second));
+    done.push_back(false);
+  }
+
+  std::vector<shapes::ShapeConstPtr> result;
+  result.reserve(parts.size());
+  for (const Part& part : parts)
+    result.push_back(makeMesh(part.hull_vertices, part.hull_triangles));
+  return result;
+}
+
+std::shared_ptr<const std::vector<shapes::ShapeConstPtr>>
+getConvexDecomposition(const shapes::ShapeConstPtr& shape, const ConvexDecompositionParameters& params)
+{
+  if (!shape || shape->type != shapes::MESH)
+    return std::make_shared<const std::vector<shapes::ShapeConstPtr>>();
+
+  GeometryCache& cache = GeometryCache::getGlobal();
+  const std::string name = params.getCacheName();
+  return cache.getDerived<std::vector<shapes::ShapeConstPtr>>(shape, name, [&]() {
+    const shapes::Mesh& mesh = static_cast<const shapes::Mesh&>(*shape);
+    auto parts = std::make_shared<std::vector<shapes::ShapeConstPtr>>();
+    std::string data;
+    if (cache.loadPersistent(mesh, name, data) && deserializeDecomposition(data, *parts))
+      return std::shared_ptr<const std::vector<shapes::ShapeConstPtr>>(parts);
+
+    *parts = computeConvexDecomposition(mesh, params);
+    ROS_DEBUG_NAMED("collision_detection", "Decomposed a mesh with %u triangles into %zu convex parts",
+                    mesh.triangle_count, parts->size());
+    if (!cache.getPersistentDirectory().empty())
+      cache.storePersistent(mesh, name, serializeDecomposition(*parts));
+    return std::shared_ptr<const std::vector<shapes::ShapeConstPtr>>(parts);
+  });
+}
+}  // namespace collision_detection
@@ -0,0 +1,314 @@
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2026, PickNik LLC.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of PickNik LLC nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *********************************************************************/
+
+#include <moveit/collision_detection/geometry_cache.h>
+#include <ros/console.h>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <sstream>
+#include <thread>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace collision_detection
+{
+namespace
+{
+/** \brief Header of the files written by GeometryCache::storePersistent() */
+struct PersistentFileHeader
+{
+  char magic[8];
+  std::uint32_t version;
+  std::uint32_t vertex_count;
+  std::uint32_t triangle_count;
+  std::uint32_t reserved;
+  /** \brief Mesh hash with a second seed, guards against collisions of the hash in the file name */
+  std::uint64_t check;
+  std::uint64_t size;
+};
+
+const char PERSISTENT_FILE_MAGIC[8] = { 'M', 'V', 'T', 'G', 'E', 'O', 'M', '\0' };
+const std::uint32_t PERSISTENT_FILE_VERSION = 1;
+const std::uint64_t CHECK_SEED = 0x9e3779b97f4a7c15ULL;
+
+// cached meshes are checked for expiry every this many insertions
+const std::size_t CLEANUP_INTERVAL = 64;
+
+void hashBytes(std::uint64_t& hash, const void* data, std::size_t size)
+{
+  const unsigned char* bytes = static_cast<const unsigned char*>(data);
+  for (std::size_t i = 0; i < size; ++i)
+    hash = (hash ^ bytes[i]) * 1099511628211ULL;
+}
+
+/** \brief A read-only mapping of a whole persistent file, viewed from behind its header */
+struct MappedFile : GeometryCache::PersistentView
+{
+  ~MappedFile()
+  {
+    if (base != MAP_FAILED)
+      munmap(base, length);
+  }
+
+  void* base = MAP_FAILED;
+  std::size_t length = 0;
+};
+
+bool sameContent(const shapes::Mesh& a, const shapes::Mesh& b)
+{
+  return a.vertex_count == b.vertex_count && a.triangle_count == b.triangle_count &&
+         (a.vertex_count == 0 || std::memcmp(a.vertices, b.vertices, 3 * sizeof(double) * a.vertex_count) == 0) &&
+         (a.triangle_count == 0 ||
+          std::memcmp(a.triangles, b.triangles, 3 * sizeof(unsigned int) * a.triangle_count) == 0);
+}
+}  // namespace
+
+GeometryCache& GeometryCache::getGlobal()
+{
+  static GeometryCache& cache = []() -> GeometryCache& {
+    static GeometryCache instance;
+    const char* directory = std::getenv("MOVEIT_GEOMETRY_CACHE_DIR");
+    if (directory && *directory)
+      instance.setPersistentDirectory(directory);
+    return instance;
+  }();
+  return cache;
+}
+
+std::uint64_t GeometryCache::computeMeshHash(const shapes::Mesh& mesh, std::uint64_t seed)
+{
+  std::uint64_t hash = seed;
+  hashBytes(hash, &mesh.vertex_count, sizeof(mesh.vertex_count));
+  hashBytes(hash, &mesh.triangle_count, sizeof(mesh.triangle_count));
+  if (mesh.vertex_count > 0)
+    hashBytes(hash, mesh.vertices, 3 * sizeof(double) * mesh.vertex_count);
+  if (mesh.triangle_count > 0)
+    hashBytes(hash, mesh.triangles, 3 * sizeof(unsigned int) * mesh.triangle_count);
+  return hash;
+}
+
+GeometryCache::Entry* GeometryCache::findEntry(const shapes::Mesh& mesh, std::uint64_t hash)
+{
+  auto range = entries_.equal_range(hash);
+  for (auto it = range.first; it != range.second; ++it)
+  {
+    std::shared_ptr<const shapes::Mesh> cached = it->second.mesh.lock();
+    if (cached && (cached.get() == &mesh || sameContent(*cached, mesh)))
+      return &it->second;
+  }
+  return nullptr;
+}
+
+void GeometryCache::removeExpired()
+{
+  for (auto it = entries_.begin(); it != entries_.end();)
+    it = it->second.mesh.expired() ? entries_.erase(it) : std::next(it);
+  inserts_since_cleanup_ = 0;
+}
+
+shapes::ShapeConstPtr GeometryCache::intern(const shapes::ShapeConstPtr& shape)
+{
+  if (!shape || shape->type != shapes::MESH)
+    return shape;
+
+  auto mesh = std::static_pointer_cast<const shapes::Mesh>(shape);
+  const std::uint64_t hash = computeMeshHash(*mesh);
+  std::lock_guard<std::mutex> lock(lock_);
+  if (Entry* entry = findEntry(*mesh, hash))
+  {
+    std::shared_ptr<const shapes::Mesh> cached = entry->mesh.lock();
+    if (cached)
+      return cached;
+  }
+
+  if (++inserts_since_cleanup_ >= CLEANUP_INTERVAL)
+    removeExpired();
+  Entry entry;
+  entry.mesh = mesh;
+  entries_.emplace(hash, entry);
+  return shape;
+}
+
+std::shared_ptr<const void> GeometryCache::getDerivedImpl(const shapes::ShapeConstPtr& shape, const std::string& name,
+                                                          const std::function<std::shared_ptr<const void>()>& create)
+{
+  if (!shape || shape->type != shapes::MESH)
+    return create();
+
+  // make sure the content is registered, so the data can be attached to it
+  const shapes::ShapeConstPtr interned = intern(shape);
+  const shapes::Mesh& mesh = static_cast<const shapes::Mesh&>(*interned);
+  const std::uint64_t hash = computeMeshHash(mesh);
+  {
+    std::lock_guard<std::mutex> lock(lock_);
+    Entry* entry = findEntry(mesh, hash);
+    if (entry)
+    {
+      auto it = entry->derived.find(name);
+      if (it != entry->derived.end())
+        return it->second;
+    }
+  }
+
+  // derived data is expensive to compute, so this happens outside the lock
+  std::shared_ptr<const void> data = create();
+  if (!data)
+    return data;
+
+  std::lock_guard<std::mutex> lock(lock_);
+  Entry* entry = findEntry(mesh, hash);
+  if (!entry)
+  {
+    // the cache was cleared in between
+    Entry new_entry;
+    new_entry.mesh = std::static_pointer_cast<const shapes::Mesh>(interned);
+    entry = &entries_.emplace(hash, new_entry)->second;
+  }
+  return entry->derived.emplace(name, data).first->second;
+}
+
+void GeometryCache::setPersistentDirectory(const std::string& directory)
+{
+  std::lock_guard<std::mutex> lock(lock_);
+  directory_ = directory;
+}
+
+std::string GeometryCache::getPersistentFilename(const shapes::Mesh& mesh, const std::string& name) const
+{
+  std::lock_guard<std::mutex> lock(lock_);
+  if (directory_.empty())
+    return std::string();
+  std::stringstream filename;
+  filename << directory_ << "/" << name << "_" << std::hex << computeMeshHash(mesh) << ".bgc";
+  return filename.str();
+}
+
+GeometryCache::PersistentViewConstPtr GeometryCache::mapPersistent(const shapes::Mesh& mesh,
+                                                                   const std::string& name) const
+{
+  const std::string filename = getPersistentFilename(mesh, name);
+  if (filename.empty())
+    return nullptr;
+  const int fd = open(filename.c_str(), O_RDONLY | O_CLOEXEC);
+  if (fd < 0)
+    return nullptr;
+
+  auto file = std::make_shared<MappedFile>();
+  struct stat st;
+  if (fstat(fd, &st) == 0 && static_cast<std::size_t>(st.st_size) >= sizeof(PersistentFileHeader))
+  {
+    file->length = st.st_size;
+    file->base = mmap(nullptr, file->length, PROT_READ, MAP_SHARED, fd, 0);
+  }
+  close(fd);
+  if (file->base == MAP_FAILED)
+    return nullptr;
+
+  PersistentFileHeader header;
+  std::memcpy(&header, file->base, sizeof(header));
+  if (std::memcmp(header.magic, PERSISTENT_FILE_MAGIC, sizeof(header.magic)) != 0 ||
+      header.version != PERSISTENT_FILE_VERSION || header.vertex_count != mesh.vertex_count ||
+      header.triangle_count != mesh.triangle_count || header.check != computeMeshHash(mesh, CHECK_SEED) ||
+      header.size != file->length - sizeof(header))
+  {
+    ROS_DEBUG_NAMED("collision_detection", "Geometry cache file '%s' does not match the mesh", filename.c_str());
+    return nullptr;
+  }
+  file->data = static_cast<const char*>(file->base) + sizeof(header);
+  file->size = header.size;
+  return file;
+}
+
+bool GeometryCache::loadPersistent(const shapes::Mesh& mesh, const std::string& name, std::string& data) const
+{
+  PersistentViewConstPtr view = mapPersistent(mesh, name);
+  if (!view)
+    return false;
+  data.assign(view->data, view->size);
+  return true;
+}
+
+bool GeometryCache::storePersistent(const shapes::Mesh& mesh, const std::string& name, const std::string& data) const
+{
+  const std::string filename = getPersistentFilename(mesh, name);
+  if (filename.empty())
+    return false;
+
+  PersistentFileHeader header;
+  std::memset(&header, 0, sizeof(header));
+  std::memcpy(header.magic, PERSISTENT_FILE_MAGIC, sizeof(header.magic));
+  header.version = PERSISTENT_FILE_VERSION;
+  header.vertex_count = mesh.vertex_count;
+  header.triangle_count = mesh.triangle_count;
+  header.check = computeMeshHash(mesh, CHECK_SEED);
+  header.size = data.size();
+
+  // write to a temporary file first so concurrent readers never see a partial file
+  std::stringstream temp_file;
+  temp_file << filename << ".tmp" << std::this_thread::get_id();
+  {
+    std::ofstream os(temp_file.str(), std::ios::out | std::ios::binary | std::ios::trunc);
+    os.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    os.write(data.data(), data.size());
+    os.close();
+    if (!os.fail() && std::rename(temp_file.str().c_str(), filename.c_str()) == 0)
+      return true;
+  }
+  ROS_WARN_NAMED("collision_detection", "Unable to write geometry cache file %s", filename.c_str());
+  std::remove(temp_file.str().c_str());
+  return false;
+}
+
+std::size_t GeometryCache::size() const
+{
+  std::lock_guard<std::mutex> lock(lock_);
+  std::size_t count = 0;
+  for (const auto& entry : entries_)
+    if (!entry.second.mesh.expired())
+      ++count;
+  return count;
+}
+
+void GeometryCache::clear()
+{
+  std::lock_guard<std::mutex> lock(lock_);
+  entries_.clear();
+  inserts_since_cleanup_ = 0;
+}
+}  // namespace collision_detection
@@ -35,19 +35,82 @@
 /* Author: Acorn Pooley, Ioan Sucan */
 
 #include <moveit/collision_detection/world.h>
+#include <moveit/collision_detection/aabb_tree.h>
+#include <moveit/collision_detection/geometry_cache.h>
+#include <moveit/robot_model/aabb.h>
 #include <geometric_shapes/check_isometry.h>
+#include <geometric_shapes/shape_operations.h>
 #include <boost/algorithm/string/predicate.hpp>
+#include <octomap/octomap.h>
 #include <ros/console.h>
+#include <limits>
 
 namespace collision_detection
 {
-World::World()
+namespace
+{
+// changed objects are merged into the shared map when there are more than this plus a fraction of the shared ones
+constexpr std::size_t MAX_CHANGED_OBJECTS = 16;
+
+void extendWithShape(const shapes::Shape& shape, const Eigen::Isometry3d& pose, moveit::core::AABB& aabb)
+{
+  switch (shape.type)
+  {
+    case shapes::PLANE:
+      aabb.extend(Eigen::Vector3d::Constant(-std::numeric_limits<double>::infinity()));
+      aabb.extend(Eigen::Vector3d::Constant(std::numeric_limits<double>::infinity()));
+      break;
+    case shapes::MESH:
+    {
+      const shapes::Mesh& mesh = static_cast<const shapes::Mesh&>(shape);
+      for (unsigned int i = 0; i < mesh.vertex_count; ++i)
+        aabb.extend(pose * Eigen::Map<const Eigen::Vector3d>(&mesh.vertices[3 * i]));
+      break;
+    }
+    case shapes::OCTREE:
+    {
+      const shapes::OcTree& octree = static_cast<const shapes::OcTree&>(shape);
+      if (!octree.octree || octree.octree->size() == 0)
+        break;
+      Eigen::Vector3d min, max;
+      octree.octree->getMetricMin(min.x(), min.y(), min.z());
+      octree.octree->getMetricMax(max.x(), max.y(), max.z());
+      aabb.extendWithTransformedBox(pose * Eigen::Translation3d(0.5 * (min + max)), max - min);
+      break;
+    }
+    default:
+      aabb.extendWithTransformedBox(pose, shapes::computeShapeExtents(&shape));
+      break;
+  }
+}
+}  // namespace
+
+struct World::SpatialIndex
+{
+  /** Cached world-frame bounding boxes of the objects */
+  std::map<std::string, Eigen::AlignedBox3d> object_aabbs;
+
+  /** The AABB tree over the bounded objects, indexing into tree_ids */
+  AABBTree tree;
+  std::vector<std::string> tree_ids;
+
+  /** Objects with unbounded shapes (planes), which intersect every query */
+  std::vector<std::string> unbounded_ids;
+};
+
+World::World() : shared_objects_(std::make_shared<const ObjectMap>())
 {
 }
 
 World::World(const World& other)
+  : shared_objects_(other.shared_objects_)
+  , changed_objects_(other.changed_objects_)
+  , object_count_(other.object_count_)
 {
-  objects_ = other.objects_;
+  // the index is still valid for the shared objects
+  std::lock_guard<std::mutex> lock(other.spatial_index_lock_);
+  spatial_index_ = other.spatial_index_;
+  changed_aabbs_ = other.changed_aabbs_;
 }
 
 World::~World()
@@ -59,7 +122,8 @@ World::~World()
 inline void World::addToObjectInternal(const ObjectPtr& obj, const shapes::ShapeConstPtr& shape,
                                        const Eigen::Isometry3d& shape_pose)
 {
-  obj->shapes_.push_back(shape);
+  // identical meshes share one instance, and the collision data structures derived from it
+  obj->shapes_.push_back(GeometryCache::getGlobal().intern(shape));
   ASSERT_ISOMETRY(shape_pose)  // unsanitized input, could contain a non-isometry
   obj->shape_poses_.push_back(shape_pose);
   obj->global_shape_poses_.push_back(obj->pose_ * shape_pose);
@@ -81,10 +145,11 @@ void World::addToObject(const std::string& object_id, const Eigen::Isometry3d& p
 
   int action = ADD_SHAPE;
 
-  ObjectPtr& obj = objects_[object_id];
+  ObjectPtr& obj = getObjectForWrite(object_id);
   if (!obj)
   {
     obj = std::make_shared<Object>(object_id);
+    objectCreated();
     action |= CREATE;
     obj->pose_ = pose;
   }
@@ -100,40 +165,82 @@ void World::addToObject(const std::string& object_id, const Eigen::Isometry3d& p
 std::vector<std::string> World::getObjectIds() const
 {
   std::vector<std::string> ids;
-  for (const auto& object : objects_)
+  ids.reserve(size());
+  for (const auto& object : *this)
     ids.push_back(object.first);
   return ids;
 }
 
 World::ObjectConstPtr World::getObject(const std::string& object_id) const
 {
-  auto it = objects_.find(object_id);
-  if (it == objects_.end())
+  auto it = find(object_id);
+  if (it == end())
     return ObjectConstPtr();
   else
     return it->second;
 }
 
+World::const_iterator World::find(const std::string& object_id) const
+{
+  const_iterator it(shared_objects_->lower_bound(object_id), shared_objects_->end(),
+                    changed_objects_.lower_bound(object_id), changed_objects_.end());
+  return (it != end() && it->first == object_id) ? it : end();
+}
+
 void World::ensureUnique(ObjectPtr& obj)
 {
   if (obj && !obj.unique())
     obj = std::make_shared<Object>(*obj);
 }
 
+World::ObjectPtr& World::getObjectForWrite(const std::string& object_id)
+{
+  compactObjects();
+  auto inserted = changed_objects_.insert(std::make_pair(object_id, ObjectPtr()));
+  if (inserted.second)
+  {
+    auto it = shared_objects_->find(object_id);
+    if (it != shared_objects_->end())
+      inserted.first->second = it->second;
+  }
+  return inserted.first->second;
+}
+
+void World::eraseObject(const std::string& object_id)
+{
+  if (shared_objects_->find(object_id) != shared_objects_->end())
+    changed_objects_[object_id].reset();
+  else
+    changed_objects_.erase(object_id);
+  --object_count_;
+}
+
+void World::compactObjects()
+{
+  if (changed_objects_.size() <= MAX_CHANGED_OBJECTS + shared_objects_->size() / 8)
+    return;
+
+  auto objects = std::make_shared<ObjectMap>();
+  for (const std::pair<const std::string, ObjectPtr>& object : *this)
+    objects->emplace_hint(objects->end(), object);
+  shared_objects_ = objects;
+  changed_objects_.clear();
+}
+
 bool World::hasObject(const std::string& object_id) const
 {
-  return objects_.find(object_id) != objects_.end();
+  return find(object_id) != end();
 }
 
 bool World::knowsTransform(const std::string& name) const
 {
   // Check object names first
-  std::map<std::string, ObjectPtr>::const_iterator it = objects_.find(name);
-  if (it != objects_.end())
+  const_iterator it = find(name);
+  if (it != end())
     return true;
   else  // Then objects' subframes
   {
-    for (const std::pair<const std::string, ObjectPtr>& object : objects_)
+    for (const std::pair<const std::string, ObjectPtr>& object : *this)
     {
       // if "object name/" matches start of object_id, we found the matching object
       if (boost::starts_with(name, object.first) && name[object.first.length()] == '/')
@@ -160,14 +267,14 @@ const Eigen::Isometry3d& World::getTransform(const std::string& name, bool& fram
   // assume found
   frame_found = true;
 
-  std::map<std::string, ObjectPtr>::const_iterator it = objects_.find(name);
-  if (it != objects_.end())
+  const_iterator it = find(name);
+  if (it != end())
   {
     return it->second->pose_;
   }
   else  // Search within subframes
   {
-    for (const std::pair<const std::string, ObjectPtr>& object : objects_)
+    for (const std::pair<const std::string, ObjectPtr>& object : *this)
     {
       // if "object name/" matches start of object_id, we found the matching object
       if (boost::starts_with(name, object.first) && name[object.first.length()] == '/')
@@ -189,8 +296,8 @@ const Eigen::Isometry3d& World::getTransform(const std::string& name, bool& fram
 
 const Eigen::Isometry3d& World::getGlobalShapeTransform(const std::string& object_id, int shape_index) const
 {
-  auto it = objects_.find(object_id);
-  if (it != objects_.end())
+  auto it = find(object_id);
+  if (it != end())
   {
     return it->second->global_shape_poses_[shape_index];
   }
@@ -204,8 +311,8 @@ const Eigen::Isometry3d& World::getGlobalShapeTransform(const std::string& objec
 
 const EigenSTL::vector_Isometry3d& World::getGlobalShapeTransforms(const std::string& object_id) const
 {
-  auto it = objects_.find(object_id);
-  if (it != objects_.end())
+  auto it = find(object_id);
+  if (it != end())
   {
     return it->second->global_shape_poses_;
   }
@@ -220,29 +327,46 @@ const EigenSTL::vector_Isometry3d& World::getGlobalShapeTransforms(const std::st
 bool World::moveShapeInObject(const std::string& object_id, const shapes::ShapeConstPtr& shape,
                               const Eigen::Isometry3d& shape_pose)
 {
-  auto it = objects_.find(object_id);
-  if (it != objects_.end())
+  auto it = find(object_id);
+  if (it != end())
   {
+    // the object holds the cached instance of meshes
+    const shapes::ShapeConstPtr interned = GeometryCache::getGlobal().intern(shape);
     unsigned int n = it->second->shapes_.size();
     for (unsigned int i = 0; i < n; ++i)
-      if (it->second->shapes_[i] == shape)
+      if (it->second->shapes_[i] == shape || it->second->shapes_[i] == interned)
       {
-        ensureUnique(it->second);
+        ObjectPtr& obj = getObjectForWrite(object_id);
+        ensureUnique(obj);
         ASSERT_ISOMETRY(shape_pose)  // unsanitized input, could contain a non-isometry
-        it->second->shape_poses_[i] = shape_pose;
-        it->second->global_shape_poses_[i] = it->second->pose_ * shape_pose;
+        obj->shape_poses_[i] = shape_pose;
+        obj->global_shape_poses_[i] = obj->pose_ * shape_pose;
 
-        notify(it->second, MOVE_SHAPE);
+        notify(obj, MOVE_SHAPE);
         return true;
       }
   }
   return false;
 }
 
+bool World::updateShapeInObject(const std::string& object_id, std::size_t shape_index,
+                                const shapes::ShapeConstPtr& shape)
+{
+  auto it = find(object_id);
+  if (it == end() || shape_index >= it->second->shapes_.size())
+    return false;
+
+  ObjectPtr& obj = getObjectForWrite(object_id);
+  ensureUnique(obj);
+  obj->shapes_[shape_index] = GeometryCache::getGlobal().intern(shape);
+  notify(obj, UPDATE_SHAPE);
+  return true;
+}
+
 bool World::moveObject(const std::string& object_id, const Eigen::Isometry3d& transform)
 {
-  auto it = objects_.find(object_id);
-  if (it == objects_.end())
+  auto it = find(object_id);
+  if (it == end())
     return false;
   if (transform.isApprox(Eigen::Isometry3d::Identity()))
     return true;  // object already at correct location
@@ -254,11 +378,12 @@ bool World::moveObject(const std::string& object_id, const Eigen::Isometry3d& tr
 bool World::setObjectPose(const std::string& object_id, const Eigen::Isometry3d& pose)
 {
   ASSERT_ISOMETRY(pose);  // unsanitized input, could contain a non-isometry
-  ObjectPtr& obj = objects_[object_id];
+  ObjectPtr& obj = getObjectForWrite(object_id);
   int action;
   if (!obj)
   {
     obj = std::make_shared<Object>(object_id);
+    objectCreated();
     action = CREATE;
   }
   else
@@ -275,26 +400,29 @@ bool World::setObjectPose(const std::string& object_id, const Eigen::Isometry3d&
 
 bool World::removeShapeFromObject(const std::string& object_id, const shapes::ShapeConstPtr& shape)
 {
-  auto it = objects_.find(object_id);
-  if (it != objects_.end())
+  auto it = find(object_id);
+  if (it != end())
   {
+    // the object holds the cached instance of meshes
+    const shapes::ShapeConstPtr interned = GeometryCache::getGlobal().intern(shape);
     unsigned int n = it->second->shapes_.size();
     for (unsigned int i = 0; i < n; ++i)
-      if (it->second->shapes_[i] == shape)
+      if (it->second->shapes_[i] == shape || it->second->shapes_[i] == interned)
       {
-        ensureUnique(it->second);
-        it->second->shapes_.erase(it->second->shapes_.begin() + i);
-        it->second->shape_poses_.erase(it->second->shape_poses_.begin() + i);
-        it->second->global_shape_poses_.erase(it->second->global_shape_poses_.begin() + i);
+        ObjectPtr& obj = getObjectForWrite(object_id);
+        ensureUnique(obj);
+        obj->shapes_.erase(obj->shapes_.begin() + i);
+        obj->shape_poses_.erase(obj->shape_poses_.begin() + i);
+        obj->global_shape_poses_.erase(obj->global_shape_poses_.begin() + i);
 
-        if (it->second->shapes_.empty())
+        if (obj->shapes_.empty())
         {
-          notify(it->second, DESTROY);
-          objects_.erase(it);
+          notify(obj, DESTROY);
+          eraseObject(object_id);
         }
         else
         {
-          notify(it->second, REMOVE_SHAPE);
+          notify(obj, REMOVE_SHAPE);
         }
         return true;
       }
@@ -304,11 +432,11 @@ bool World::removeShapeFromObject(const std::string& object_id, const shapes::Sh
 
 bool World::removeObject(const std::string& object_id)
 {
-  auto it = objects_.find(object_id);
-  if (it != objects_.end())
+  auto it = find(object_id);
+  if (it != end())
   {
     notify(it->second, DESTROY);
-    objects_.erase(it);
+    eraseObject(object_id);
     return true;
   }
   return false;
@@ -317,13 +445,14 @@ bool World::removeObject(const std::string& object_id)
 void World::clearObjects()
 {
   notifyAll(DESTROY);
-  objects_.clear();
+  shared_objects_ = std::make_shared<const ObjectMap>();
+  changed_objects_.clear();
+  object_count_ = 0;
 }
 
 bool World::setSubframesOfObject(const std::string& object_id, const moveit::core::FixedTransformsMap& subframe_poses)
 {
-  auto obj_pair = objects_.find(object_id);
-  if (obj_pair == objects_.end())
+  if (find(object_id) == end())
   {
     return false;
   }
@@ -331,9 +460,11 @@ bool World::setSubframesOfObject(const std::string& object_id, const moveit::cor
   {
     ASSERT_ISOMETRY(t.second)  // unsanitized input, could contain a non-isometry
   }
-  obj_pair->second->subframe_poses_ = subframe_poses;
-  obj_pair->second->global_subframe_poses_ = subframe_poses;
-  updateGlobalPosesInternal(obj_pair->second, false, true);
+  ObjectPtr& obj = getObjectForWrite(object_id);
+  ensureUnique(obj);
+  obj->subframe_poses_ = subframe_poses;
+  obj->global_subframe_poses_ = subframe_poses;
+  updateGlobalPosesInternal(obj, false, true);
   return true;
 }
 
@@ -376,18 +507,149 @@ void World::removeObserver(ObserverHandle observer_handle)
   }
 }
 
+void World::beginBulkChange()
+{
+  ++bulk_change_depth_;
+}
+
+void World::endBulkChange()
+{
+  if (bulk_change_depth_ == 0)
+  {
+    ROS_ERROR_NAMED("collision_detection", "endBulkChange() called without matching beginBulkChange()");
+    return;
+  }
+  if (--bulk_change_depth_ > 0)
+    return;
+
+  std::map<std::string, BulkChangeEntry> changes;
+  changes.swap(bulk_changes_);
+  for (const std::pair<const std::string, BulkChangeEntry>& change : changes)
+  {
+    if (change.second.destroyed)
+      notifyObservers(change.second.destroyed, DESTROY);
+    auto it = find(change.first);
+    if (it != end())
+      notifyObservers(it->second, Action(change.second.action));
+  }
+}
+
 void World::notifyAll(Action action)
 {
-  for (std::map<std::string, ObjectPtr>::const_iterator it = objects_.begin(); it != objects_.end(); ++it)
+  for (const_iterator it = begin(); it != end(); ++it)
     notify(it->second, action);
 }
 
 void World::notify(const ObjectConstPtr& obj, Action action)
+{
+  {
+    std::lock_guard<std::mutex> lock(spatial_index_lock_);
+    changed_aabbs_.insert(obj->id_);
+  }
+
+  if (bulk_change_depth_ == 0)
+  {
+    notifyObservers(obj, action);
+    return;
+  }
+
+  auto inserted = bulk_changes_.insert(std::make_pair(obj->id_, BulkChangeEntry()));
+  BulkChangeEntry& change = inserted.first->second;
+  if (inserted.second)
+    change.known = !(action & CREATE);
+  if (action == DESTROY)
+  {
+    // observers only need to hear about the first version of the object they knew
+    if (change.known && !change.destroyed)
+      change.destroyed = obj;
+    change.action = 0;
+  }
+  else
+    change.action |= action;
+}
+
+void World::notifyObservers(const ObjectConstPtr& obj, Action action)
 {
   for (Observer* observer : observers_)
     observer->callback_(obj, action);
 }
 
+Eigen::AlignedBox3d World::getObjectAABB(const std::string& object_id) const
+{
+  auto it = find(object_id);
+  if (it == end())
+    return Eigen::AlignedBox3d();
+
+  moveit::core::AABB aabb;
+  for (std::size_t i = 0; i < it->second->shapes_.size(); ++i)
+    extendWithShape(*it->second->shapes_[i], it->second->global_shape_poses_[i], aabb);
+  return aabb;
+}
+
+void World::updateSpatialIndex() const
+{
+  if (spatial_index_ && changed_aabbs_.empty())
+    return;
+
+  // build a new index, as the current one may be shared with copies of this world
+  auto index = std::make_shared<SpatialIndex>();
+  if (spatial_index_)
+    index->object_aabbs = spatial_index_->object_aabbs;
+  for (const std::string& id : changed_aabbs_)
+  {
+    if (find(id) == end())
+      index->object_aabbs.erase(id);
+    else
+      index->object_aabbs[id] = getObjectAABB(id);
+  }
+  changed_aabbs_.clear();
+
+  std::vector<Eigen::AlignedBox3d> boxes;
+  boxes.reserve(index->object_aabbs.size());
+  for (const std::pair<const std::string, Eigen::AlignedBox3d>& aabb : index->object_aabbs)
+  {
+    if (aabb.second.isEmpty())
+      continue;
+    if (!aabb.second.min().allFinite() || !aabb.second.max().allFinite())
+      index->unbounded_ids.push_back(aabb.first);
+    else
+    {
+      index->tree_ids.push_back(aabb.first);
+      boxes.push_back(aabb.second);
+    }
+  }
+  index->tree.build(boxes);
+  spatial_index_ = index;
+}
+
+std::vector<std::string> World::getObjectIdsInBox(const Eigen::AlignedBox3d& box) const
+{
+  std::shared_ptr<const SpatialIndex> index;
+  {
+    std::lock_guard<std::mutex> lock(spatial_index_lock_);
+    updateSpatialIndex();
+    index = spatial_index_;
+  }
+
+  std::vector<std::size_t> indices;
+  index->tree.query(box, indices);
+  std::vector<std::string> ids = index->unbounded_ids;
+  ids.reserve(ids.size() + indices.size());
+  for (std::size_t i : indices)
+    ids.push_back(index->tree_ids[i]);
+  return ids;
+}
+
+std::vector<std::string> World::getObjectIdsNearBox(const Eigen::Isometry3d& pose, const Eigen::Vector3d& extents,
+                                                    double distance) const
+{
+  moveit::core::AABB aabb;
+  aabb.extendWithTransformedBox(pose, extents);
+  aabb.min().array() -= distance;
+  aabb.max().array() += distance;
+  return getObjectIdsInBox(aabb);
+}
+
 void World::notifyObserverAllObjects(const ObserverHandle observer_handle, Action action) const
 {
   for (auto observer : observers_)
@@ -395,7 +657,7 @@ void World::notifyObserverAllObjects(const ObserverHandle observer_handle, Actio
     if (observer == observer_handle.observer_)
     {
       // call the callback for each object
-      for (const auto& object : objects_)
+      for (const auto& object : *this)
         observer->callback_(object.second, action);
       break;
     }
@@ -0,0 +1,144 @@
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2026, PickNik LLC.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of PickNik LLC nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *********************************************************************/
+
+#include <gtest/gtest.h>
+#include <moveit/collision_detection/collision_matrix.h>
+
+using collision_detection::AllowedCollision::ALWAYS;
+using collision_detection::AllowedCollision::CONDITIONAL;
+using collision_detection::AllowedCollision::NEVER;
+
+namespace
+{
+// the type as resolved from the name-keyed entries, bypassing the dense matrix
+bool referenceType(const collision_detection::AllowedCollisionMatrix& acm, const std::string& name1,
+                   const std::string& name2, collision_detection::AllowedCollision::Type& type)
+{
+  if (acm.getEntry(name1, name2, type))
+    return true;
+  collision_detection::AllowedCollision::Type t1, t2;
+  const bool found1 = acm.getDefaultEntry(name1, t1);
+  const bool found2 = acm.getDefaultEntry(name2, t2);
+  if (found1 && found2)
+    type = (t1 == NEVER || t2 == NEVER) ? NEVER : (t1 == CONDITIONAL || t2 == CONDITIONAL) ? CONDITIONAL : ALWAYS;
+  else if (found1 || found2)
+    type = found1 ? t1 : t2;
+  return found1 || found2;
+}
+
+void expectConsistent(const collision_detection::AllowedCollisionMatrix& acm, const std::vector<std::string>& names)
+{
+  for (const std::string& name1 : names)
+    for (const std::string& name2 : names)
+    {
+      collision_detection::AllowedCollision::Type expected = NEVER, actual = NEVER, indexed = NEVER;
+      const bool found = referenceType(acm, name1, name2, expected);
+      ASSERT_EQ(acm.getAllowedCollision(name1, name2, actual), found) << name1 << " " << name2;
+      ASSERT_EQ(acm.getAllowedCollision(acm.getEntryIndex(name1), acm.getEntryIndex(name2), indexed), found);
+      if (found)
+      {
+        EXPECT_EQ(actual, expected) << name1 << " " << name2;
+        EXPECT_EQ(indexed, expected) << name1 << " " << name2;
+      }
+    }
+}
+}  // namespace
+
+TEST(AllowedCollisionMatrix, DenseLookupMatchesEntries)
+{
+  std::vector<std::string> names;
+  for (int i = 0; i < 40; ++i)
+    names.push_back("link" + std::to_string(i));
+
+  collision_detection::AllowedCollisionMatrix acm(std::vector<std::string>(names.begin(), names.begin() + 10));
+  names.push_back("unknown");
+  expectConsistent(acm, names);
+
+  // grow beyond the initial capacity
+  for (std::size_t i = 0; i + 1 < 40; i += 3)
+    acm.setEntry(names[i], names[i + 1], true);
+  acm.setDefaultEntry("link5", true);
+  acm.setDefaultEntry("link30", true);
+  acm.setDefaultEntry("link31", false);
+  const collision_detection::DecideContactFn allow = [](collision_detection::Contact& /*unused*/) { return true; };
+  acm.setDefaultEntry("link32", allow);
+  acm.setEntry("link7", "link33", allow);
+  expectConsistent(acm, names);
+
+  acm.removeEntry("link0", "link1");
+  acm.removeEntry("link5");
+  acm.setDefaultEntry("link30", false);
+  expectConsistent(acm, names);
+
+  acm.setEntry(true);
+  expectConsistent(acm, names);
+
+  collision_detection::AllowedCollisionMatrix copy(acm);
+  copy.setEntry("link2", "link3", false);
+  expectConsistent(copy, names);
+  expectConsistent(acm, names);
+
+  acm.clear();
+  EXPECT_EQ(acm.getEntryIndex("link2"), -1);
+  expectConsistent(acm, names);
+}
+
+TEST(AllowedCollisionMatrix, IndexLookup)
+{
+  collision_detection::AllowedCollisionMatrix acm;
+  acm.setEntry("a", "b", true);
+  acm.setDefaultEntry("c", true);
+  const int a = acm.getEntryIndex("a");
+  const int b = acm.getEntryIndex("b");
+  const int c = acm.getEntryIndex("c");
+  ASSERT_GE(a, 0);
+  ASSERT_GE(b, 0);
+  ASSERT_GE(c, 0);
+  EXPECT_EQ(acm.getEntryIndex("d"), -1);
+
+  collision_detection::AllowedCollision::Type type;
+  ASSERT_TRUE(acm.getAllowedCollision(a, b, type));
+  EXPECT_EQ(type, ALWAYS);
+  EXPECT_FALSE(acm.getAllowedCollision(a, -1, type));
+  // unknown elements take the default of the other one
+  ASSERT_TRUE(acm.getAllowedCollision(-1, c, type));
+  EXPECT_EQ(type, ALWAYS);
+  EXPECT_FALSE(acm.getAllowedCollision(-1, -1, type));
+}
+
+int main(int argc, char** argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
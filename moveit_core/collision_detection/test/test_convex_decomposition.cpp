@@ -0,0 +1,172 @@
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2026, PickNik LLC.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of PickNik LLC nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *********************************************************************/
+
+#include <moveit/collision_detection/convex_decomposition.h>
+#include <gtest/gtest.h>
+
+namespace
+{
+/** \brief Prism of height 1 over the polygon \e outline, which must be star-shaped with respect to its first
+    vertex and counter-clockwise */
+std::shared_ptr<shapes::Mesh> makePrism(const std::vector<Eigen::Vector2d>& outline)
+{
+  const unsigned int n = outline.size();
+  auto mesh = std::make_shared<shapes::Mesh>(2 * n, 4 * n - 4);
+  for (unsigned int i = 0; i < n; ++i)
+    for (unsigned int z = 0; z < 2; ++z)
+    {
+      mesh->vertices[3 * (2 * i + z)] = outline[i].x();
+      mesh->vertices[3 * (2 * i + z) + 1] = outline[i].y();
+      mesh->vertices[3 * (2 * i + z) + 2] = z;
+    }
+  unsigned int* t = mesh->triangles;
+  auto add = [&t](unsigned int a, unsigned int b, unsigned int c) {
+    *t++ = a;
+    *t++ = b;
+    *t++ = c;
+  };
+  for (unsigned int i = 1; i + 1 < n; ++i)
+  {
+    add(0, 2 * (i + 1), 2 * i);
+    add(1, 2 * i + 1, 2 * (i + 1) + 1);
+  }
+  for (unsigned int i = 0; i < n; ++i)
+  {
+    const unsigned int j = (i + 1) % n;
+    add(2 * i, 2 * j, 2 * j + 1);
+    add(2 * i, 2 * j + 1, 2 * i + 1);
+  }
+  return mesh;
+}
+
+bool insideConvexMesh(const shapes::Mesh& mesh, const Eigen::Vector3d& point)
+{
+  for (unsigned int i = 0; i < mesh.triangle_count; ++i)
+  {
+    Eigen::Vector3d v[3];
+    for (int j = 0; j < 3; ++j)
+      v[j] = Eigen::Vector3d(mesh.vertices + 3 * mesh.triangles[3 * i + j]);
+    if ((v[1] - v[0]).cross(v[2] - v[0]).dot(point - v[0]) > 1e-9)
+      return false;
+  }
+  return true;
+}
+
+double convexMeshVolume(const shapes::Mesh& mesh)
+{
+  double volume = 0.0;
+  for (unsigned int i = 0; i < mesh.triangle_count; ++i)
+  {
+    Eigen::Vector3d v[3];
+    for (int j = 0; j < 3; ++j)
+      v[j] = Eigen::Vector3d(mesh.vertices + 3 * mesh.triangles[3 * i + j]);
+    volume += v[0].dot(v[1].cross(v[2])) / 6.0;
+  }
+  return volume;
+}
+}  // namespace
+
+TEST(ConvexDecomposition, ConvexHull)
+{
+  EigenSTL::vector_Vector3d points;
+  for (int i = 0; i < 8; ++i)
+    points.push_back(Eigen::Vector3d(i & 1, (i >> 1) & 1, (i >> 2) & 1));
+  for (int i = 0; i < 50; ++i)
+    points.push_back(Eigen::Vector3d::Random().cwiseAbs());
+
+  EigenSTL::vector_Vector3d vertices;
+  std::vector<unsigned int> triangles;
+  ASSERT_TRUE(collision_detection::computeConvexHull(points, vertices, triangles));
+  EXPECT_EQ(vertices.size(), 8u);
+
+  // closed and outward facing: the volume is that of the unit cube and all points are inside
+  double volume = 0.0;
+  for (std::size_t i = 0; i < triangles.size(); i += 3)
+  {
+    const Eigen::Vector3d& a = vertices[triangles[i]];
+    const Eigen::Vector3d normal = (vertices[triangles[i + 1]] - a).cross(vertices[triangles[i + 2]] - a);
+    volume += a.dot(normal) / 6.0;
+    for (const Eigen::Vector3d& p : points)
+      EXPECT_LE(normal.dot(p - a), 1e-9);
+  }
+  EXPECT_NEAR(volume, 1.0, 1e-9);
+
+  // flat point sets have no hull
+  for (Eigen::Vector3d& p : points)
+    p.z() = 0.0;
+  EXPECT_FALSE(collision_detection::computeConvexHull(points, vertices, triangles));
+}
+
+TEST(ConvexDecomposition, ConvexMeshIsKept)
+{
+  auto square = makePrism({ { 0, 0 }, { 1, 0 }, { 1, 1 }, { 0, 1 } });
+  std::vector<shapes::ShapeConstPtr> parts =
+      collision_detection::computeConvexDecomposition(*square, collision_detection::ConvexDecompositionParameters());
+  ASSERT_EQ(parts.size(), 1u);
+  EXPECT_NEAR(convexMeshVolume(static_cast<const shapes::Mesh&>(*parts[0])), 1.0, 1e-9);
+}
+
+TEST(ConvexDecomposition, ConcaveMesh)
+{
+  // L-shaped prism of volume 3, star-shaped with respect to the reflex vertex
+  auto l_shape = makePrism({ { 1, 1 }, { 1, 2 }, { 0, 2 }, { 0, 0 }, { 2, 0 }, { 2, 1 } });
+  collision_detection::ConvexDecompositionParameters params;
+  params.max_concavity = 0.01;
+  std::vector<shapes::ShapeConstPtr> parts = collision_detection::computeConvexDecomposition(*l_shape, params);
+  ASSERT_GE(parts.size(), 2u);
+  EXPECT_LE(parts.size(), params.max_parts);
+
+  // the parts cover the mesh and add little volume, unlike the convex hull of volume 3.5
+  double volume = 0.0;
+  for (const shapes::ShapeConstPtr& part : parts)
+    volume += convexMeshVolume(static_cast<const shapes::Mesh&>(*part));
+  EXPECT_LT(volume, 3.1);
+  for (double x = 0.05; x < 2.0; x += 0.1)
+    for (double y = 0.05; y < 2.0; y += 0.1)
+    {
+      if (x > 1.0 && y > 1.0)
+        continue;
+      const Eigen::Vector3d point(x, y, 0.5);
+      bool covered = false;
+      for (const shapes::ShapeConstPtr& part : parts)
+        covered = covered || insideConvexMesh(static_cast<const shapes::Mesh&>(*part), point);
+      EXPECT_TRUE(covered) << point.transpose();
+    }
+}
+
+int main(int argc, char** argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
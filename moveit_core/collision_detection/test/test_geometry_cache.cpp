@@ -0,0 +1,147 @@
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2026, PickNik LLC.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of PickNik LLC nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *********************************************************************/
+
+#include <moveit/collision_detection/geometry_cache.h>
+#include <moveit/collision_detection/world.h>
+#include <boost/filesystem.hpp>
+#include <gtest/gtest.h>
+
+namespace
+{
+shapes::ShapeConstPtr makeTetrahedron(double size)
+{
+  auto mesh = std::make_shared<shapes::Mesh>(4, 4);
+  const double vertices[12] = { 0, 0, 0, size, 0, 0, 0, size, 0, 0, 0, size };
+  const unsigned int triangles[12] = { 0, 2, 1, 0, 1, 3, 0, 3, 2, 1, 2, 3 };
+  std::copy(vertices, vertices + 12, mesh->vertices);
+  std::copy(triangles, triangles + 12, mesh->triangles);
+  return mesh;
+}
+}  // namespace
+
+TEST(GeometryCache, InternIdenticalMeshes)
+{
+  collision_detection::GeometryCache cache;
+  shapes::ShapeConstPtr a = makeTetrahedron(1.0);
+  shapes::ShapeConstPtr b = makeTetrahedron(1.0);
+  shapes::ShapeConstPtr c = makeTetrahedron(2.0);
+
+  EXPECT_EQ(cache.intern(a), a);
+  EXPECT_EQ(cache.intern(b), a);
+  EXPECT_EQ(cache.intern(c), c);
+  EXPECT_EQ(cache.size(), 2u);
+
+  // other shapes are not cached
+  shapes::ShapeConstPtr box = std::make_shared<shapes::Box>(1, 1, 1);
+  EXPECT_EQ(cache.intern(box), box);
+  EXPECT_EQ(cache.size(), 2u);
+
+  // entries go away with their meshes
+  a.reset();
+  EXPECT_EQ(cache.size(), 1u);
+  EXPECT_EQ(cache.intern(b), b);
+}
+
+TEST(GeometryCache, DerivedData)
+{
+  collision_detection::GeometryCache cache;
+  shapes::ShapeConstPtr a = makeTetrahedron(1.0);
+  shapes::ShapeConstPtr b = makeTetrahedron(1.0);
+
+  int calls = 0;
+  auto create = [&calls]() {
+    ++calls;
+    return std::make_shared<const int>(calls);
+  };
+  std::shared_ptr<const int> first = cache.getDerived<int>(a, "test", create);
+  std::shared_ptr<const int> second = cache.getDerived<int>(b, "test", create);
+  EXPECT_EQ(first, second);
+  EXPECT_EQ(calls, 1);
+
+  cache.getDerived<int>(a, "other", create);
+  EXPECT_EQ(calls, 2);
+  cache.getDerived<int>(makeTetrahedron(2.0), "test", create);
+  EXPECT_EQ(calls, 3);
+}
+
+TEST(GeometryCache, Persistence)
+{
+  const boost::filesystem::path directory =
+      boost::filesystem::temp_directory_path() / boost::filesystem::unique_path("geometry_cache_%%%%%%%%");
+  ASSERT_TRUE(boost::filesystem::create_directories(directory));
+
+  collision_detection::GeometryCache cache;
+  shapes::ShapeConstPtr mesh = makeTetrahedron(1.0);
+  const shapes::Mesh& m = static_cast<const shapes::Mesh&>(*mesh);
+  std::string data;
+  EXPECT_FALSE(cache.storePersistent(m, "test", "disabled"));
+
+  cache.setPersistentDirectory(directory.string());
+  EXPECT_FALSE(cache.loadPersistent(m, "test", data));
+  EXPECT_TRUE(cache.storePersistent(m, "test", std::string("a\0b", 3)));
+
+  collision_detection::GeometryCache other;
+  other.setPersistentDirectory(directory.string());
+  ASSERT_TRUE(other.loadPersistent(*static_cast<const shapes::Mesh*>(makeTetrahedron(1.0).get()), "test", data));
+  EXPECT_EQ(data, std::string("a\0b", 3));
+  EXPECT_FALSE(other.loadPersistent(*static_cast<const shapes::Mesh*>(makeTetrahedron(2.0).get()), "test", data));
+
+  collision_detection::GeometryCache::PersistentViewConstPtr view = other.mapPersistent(m, "test");
+  ASSERT_TRUE(view);
+  EXPECT_EQ(std::string(view->data, view->size), std::string("a\0b", 3));
+  EXPECT_FALSE(other.mapPersistent(m, "missing"));
+
+  boost::filesystem::remove_all(directory);
+}
+
+TEST(GeometryCache, SharedByWorld)
+{
+  collision_detection::World world;
+  shapes::ShapeConstPtr a = makeTetrahedron(1.0);
+  shapes::ShapeConstPtr b = makeTetrahedron(1.0);
+  world.addToObject("a", a, Eigen::Isometry3d::Identity());
+  world.addToObject("b", b, Eigen::Isometry3d::Identity());
+  EXPECT_EQ(world.getObject("a")->shapes_[0], world.getObject("b")->shapes_[0]);
+
+  // shapes can still be addressed by the pointer they were added with
+  EXPECT_TRUE(world.moveShapeInObject("b", b, Eigen::Isometry3d(Eigen::Translation3d(1, 0, 0))));
+  EXPECT_TRUE(world.removeShapeFromObject("b", b));
+  EXPECT_FALSE(world.hasObject("b"));
+}
+
+int main(int argc, char** argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
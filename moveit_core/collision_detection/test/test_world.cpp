@@ -37,6 +37,7 @@
 #include <gtest/gtest.h>
 #include <moveit/collision_detection/world.h>
 #include <geometric_shapes/shapes.h>
+#include <algorithm>
 #include <functional>
 
 using namespace collision_detection;
@@ -372,6 +373,42 @@ TEST(World, TrackChanges)
   EXPECT_EQ(4, ta3.cnt_);
 }
 
+TEST(World, UpdateShape)
+{
+  World world;
+
+  TestAction ta;
+  World::ObserverHandle observer_ta =
+      world.addObserver([&ta](const World::ObjectConstPtr& object, World::Action action) {
+        return TrackChangesNotify(ta, object, action);
+      });
+
+  shapes::ShapePtr ball(new shapes::Sphere(1.0));
+  shapes::ShapePtr ball2(new shapes::Sphere(2.0));
+  const Eigen::Isometry3d pose(Eigen::Translation3d(0, 0, 1));
+  world.addToObject("obj1", ball, pose);
+  ta.reset();
+
+  EXPECT_FALSE(world.updateShapeInObject("xyz", 0, ball2));
+  EXPECT_FALSE(world.updateShapeInObject("obj1", 1, ball2));
+  EXPECT_EQ(1, ta.cnt_);
+
+  // the shape is replaced in place, keeping its pose
+  EXPECT_TRUE(world.updateShapeInObject("obj1", 0, ball2));
+  EXPECT_EQ(2, ta.cnt_);
+  EXPECT_EQ(World::UPDATE_SHAPE, ta.action_);
+  ASSERT_EQ(1u, world.getObject("obj1")->shapes_.size());
+  EXPECT_EQ(ball2, world.getObject("obj1")->shapes_[0]);
+  EXPECT_TRUE(world.getObject("obj1")->shape_poses_[0].isApprox(pose));
+
+  // a shape modified in place is announced with the same pointer
+  EXPECT_TRUE(world.updateShapeInObject("obj1", 0, ball2));
+  EXPECT_EQ(3, ta.cnt_);
+  EXPECT_EQ(World::UPDATE_SHAPE, ta.action_);
+
+  world.removeObserver(observer_ta);
+}
+
 TEST(World, ObjectPoseAndSubframes)
 {
   World world;
@@ -458,6 +495,135 @@ TEST(World, ObjectPoseAndSubframes)
   EXPECT_EQ(1.0, pose(2, 3));  // z
 }
 
+TEST(World, BulkChange)
+{
+  World world;
+  shapes::ShapePtr ball(new shapes::Sphere(1.0));
+  shapes::ShapePtr box(new shapes::Box(1, 2, 3));
+  world.addToObject("kept", ball, Eigen::Isometry3d::Identity());
+  world.addToObject("removed", ball, Eigen::Isometry3d::Identity());
+  world.addToObject("replaced", ball, Eigen::Isometry3d::Identity());
+
+  std::vector<std::pair<std::string, int>> notifications;
+  world.addObserver([&notifications](const World::ObjectConstPtr& object, World::Action action) {
+    notifications.emplace_back(object->id_, action);
+  });
+
+  {
+    World::BulkChange bulk(world);
+    for (int i = 0; i < 10; ++i)
+      world.addToObject("part" + std::to_string(i), box, Eigen::Isometry3d::Identity());
+    world.moveObject("kept", Eigen::Isometry3d(Eigen::Translation3d(1, 0, 0)));
+    world.addToObject("kept", box, Eigen::Isometry3d::Identity());
+    world.moveObject("part3", Eigen::Isometry3d(Eigen::Translation3d(1, 0, 0)));
+    world.removeObject("removed");
+    world.removeObject("replaced");
+    world.addToObject("replaced", box, Eigen::Isometry3d::Identity());
+    world.addToObject("transient", box, Eigen::Isometry3d::Identity());
+    world.removeObject("transient");
+    EXPECT_TRUE(world.inBulkChange());
+    EXPECT_TRUE(notifications.empty());
+  }
+  EXPECT_FALSE(world.inBulkChange());
+
+  std::map<std::string, std::vector<int>> actions;
+  for (const auto& notification : notifications)
+    actions[notification.first].push_back(notification.second);
+  EXPECT_EQ(actions.size(), 13u);
+  for (int i = 0; i < 10; ++i)
+  {
+    const std::vector<int>& part = actions["part" + std::to_string(i)];
+    ASSERT_EQ(part.size(), 1u);
+    EXPECT_EQ(part[0] & (World::CREATE | World::ADD_SHAPE), World::CREATE | World::ADD_SHAPE);
+  }
+  EXPECT_EQ(actions["kept"], std::vector<int>({ World::MOVE_SHAPE | World::ADD_SHAPE }));
+  EXPECT_EQ(actions["removed"], std::vector<int>({ World::DESTROY }));
+  EXPECT_EQ(actions["replaced"], std::vector<int>({ World::DESTROY, World::CREATE | World::ADD_SHAPE }));
+  EXPECT_EQ(actions.count("transient"), 0u);
+}
+
+TEST(World, SpatialIndex)
+{
+  World world;
+  shapes::ShapePtr box(new shapes::Box(0.2, 0.2, 0.2));
+  for (int i = 0; i < 100; ++i)
+    world.addToObject("box" + std::to_string(i), Eigen::Isometry3d(Eigen::Translation3d(i, 0, 0)), box,
+                      Eigen::Isometry3d::Identity());
+  world.addToObject("floor", shapes::ShapePtr(new shapes::Plane(0, 0, 1, 0)), Eigen::Isometry3d::Identity());
+
+  Eigen::AlignedBox3d aabb = world.getObjectAABB("box5");
+  EXPECT_TRUE(aabb.min().isApprox(Eigen::Vector3d(4.9, -0.1, -0.1)));
+  EXPECT_TRUE(aabb.max().isApprox(Eigen::Vector3d(5.1, 0.1, 0.1)));
+
+  std::vector<std::string> ids = world.getObjectIdsInBox(Eigen::AlignedBox3d(Eigen::Vector3d(9.5, -1, -1),
+                                                                             Eigen::Vector3d(12.05, 1, 1)));
+  std::sort(ids.begin(), ids.end());
+  EXPECT_EQ(ids, std::vector<std::string>({ "box10", "box11", "box12", "floor" }));
+
+  // the index follows changes to the objects
+  world.moveObject("box50", Eigen::Isometry3d(Eigen::Translation3d(0, 0, 10)));
+  world.removeObject("floor");
+  ids = world.getObjectIdsNearBox(Eigen::Isometry3d(Eigen::Translation3d(50, 0, 10)), Eigen::Vector3d::Zero(), 0.5);
+  EXPECT_EQ(ids, std::vector<std::string>({ "box50" }));
+
+  // copies share the index
+  World copy(world);
+  EXPECT_EQ(copy.getObjectIdsNearBox(Eigen::Isometry3d(Eigen::Translation3d(50, 0, 10)), Eigen::Vector3d::Zero(), 0.5),
+            ids);
+  EXPECT_TRUE(copy.getObjectIdsNearBox(Eigen::Isometry3d(Eigen::Translation3d(50, 0, 0)), Eigen::Vector3d::Zero(), 0.5)
+                  .empty());
+}
+
+TEST(World, CopyOnWrite)
+{
+  World parent;
+  shapes::ShapePtr box(new shapes::Box(1, 1, 1));
+  for (int i = 0; i < 200; ++i)
+    parent.addToObject("box" + std::to_string(i), box, Eigen::Isometry3d(Eigen::Translation3d(i, 0, 0)));
+
+  World child(parent);
+  EXPECT_EQ(child.size(), 200u);
+  child.moveObject("box3", Eigen::Isometry3d(Eigen::Translation3d(0, 0, 1)));
+  child.removeObject("box7");
+  child.addToObject("extra", box, Eigen::Isometry3d::Identity());
+  moveit::core::FixedTransformsMap subframes;
+  subframes["tip"] = Eigen::Isometry3d(Eigen::Translation3d(0, 0, 0.5));
+  child.setSubframesOfObject("box9", subframes);
+
+  // untouched objects are shared, changed objects are copied
+  EXPECT_EQ(child.getObject("box4"), parent.getObject("box4"));
+  EXPECT_NE(child.getObject("box3"), parent.getObject("box3"));
+  EXPECT_NE(child.getObject("box9"), parent.getObject("box9"));
+  EXPECT_EQ(parent.getTransform("box3").translation().z(), 0.0);
+  EXPECT_EQ(child.getTransform("box3").translation().z(), 1.0);
+  EXPECT_TRUE(parent.hasObject("box7"));
+  EXPECT_FALSE(child.hasObject("box7"));
+  EXPECT_FALSE(parent.hasObject("extra"));
+  EXPECT_FALSE(parent.knowsTransform("box9/tip"));
+  EXPECT_TRUE(child.knowsTransform("box9/tip"));
+  EXPECT_EQ(parent.size(), 200u);
+  EXPECT_EQ(child.size(), 200u);
+
+  // iteration merges shared and changed objects in order of their ids
+  std::vector<std::string> ids = child.getObjectIds();
+  EXPECT_EQ(ids.size(), child.size());
+  EXPECT_TRUE(std::is_sorted(ids.begin(), ids.end()));
+  EXPECT_EQ(std::count(ids.begin(), ids.end(), "box7"), 0);
+  EXPECT_EQ(std::count(ids.begin(), ids.end(), "extra"), 1);
+
+  // enough changes to merge the changed objects into a new shared map
+  for (int i = 0; i < 100; ++i)
+    child.removeObject("box" + std::to_string(i));
+  child.addToObject("box7", box, Eigen::Isometry3d::Identity());
+  EXPECT_EQ(child.size(), 102u);
+  EXPECT_EQ(child.getObjectIds().size(), 102u);
+  EXPECT_TRUE(child.hasObject("box7"));
+  EXPECT_FALSE(child.hasObject("box8"));
+  EXPECT_EQ(child.getObject("box150"), parent.getObject("box150"));
+  EXPECT_EQ(parent.size(), 200u);
+  EXPECT_EQ(parent.getObjectIds().size(), 200u);
+}
+
 int main(int argc, char** argv)
 {
   testing::InitGoogleTest(&argc, argv);
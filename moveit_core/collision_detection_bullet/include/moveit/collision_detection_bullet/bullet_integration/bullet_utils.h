@@ -41,9 +41,14 @@
 #include <moveit/collision_detection_bullet/bullet_integration/basic_types.h>
 #include <moveit/collision_detection_bullet/bullet_integration/contact_checker_common.h>
 #include <moveit/collision_detection/collision_common.h>
+#include <moveit/collision_detection/bounding_spheres.h>
 #include <moveit/macros/declare_ptr.h>
 #include <moveit/macros/class_forward.h>
 
+#include <octomap/octomap.h>
+#include <map>
+#include <unordered_map>
+
 namespace collision_detection_bullet
 {
 #define METERS
@@ -56,6 +61,7 @@ const btScalar BULLET_DEFAULT_CONTACT_DISTANCE = 0.00f;  // All pairs closer tha
 const bool BULLET_COMPOUND_USE_DYNAMIC_AABB = true;
 
 MOVEIT_CLASS_FORWARD(CollisionObjectWrapper);
+MOVEIT_CLASS_FORWARD(OctreeCompoundShape);
 
 /** \brief Allowed = true */
 inline bool acmCheck(const std::string& body_1, const std::string& body_2,
@@ -107,6 +113,18 @@ inline Eigen::Vector3d convertBtToEigen(const btVector3& v)
   return Eigen::Vector3d(static_cast<double>(v.x()), static_cast<double>(v.y()), static_cast<double>(v.z()));
 }
 
+/** \brief Converts bullet transform to eigen transform */
+inline Eigen::Isometry3d convertBtToEigen(const btTransform& t)
+{
+  Eigen::Isometry3d i = Eigen::Isometry3d::Identity();
+  const btMatrix3x3& basis = t.getBasis();
+  for (int r = 0; r < 3; ++r)
+    for (int c = 0; c < 3; ++c)
+      i.linear()(r, c) = static_cast<double>(basis[r][c]);
+  i.translation() = convertBtToEigen(t.getOrigin());
+  return i;
+}
+
 /** \brief Converts eigen quaternion to bullet quaternion */
 inline btQuaternion convertEigenToBt(const Eigen::Quaterniond& q)
 {
@@ -134,6 +152,48 @@ inline btTransform convertEigenToBt(const Eigen::Isometry3d& t)
   return btTransform(mat, translation);
 }
 
+/** @brief Compound shape of the occupied voxels of an octree, which can be updated incrementally.
+ *
+ *  All voxels of the same size share one child shape, and the voxel of each child is indexed, so a new version of the
+ *  octree only adds the children of newly occupied voxels and removes those of voxels that are no longer occupied. */
+class OctreeCompoundShape
+{
+public:
+  /** \brief Fill \e compound with the voxels of \e octree. The compound is not owned by this class. */
+  OctreeCompoundShape(const octomap::OcTree& octree, btCompoundShape* compound,
+                      const CollisionObjectType& collision_object_type);
+
+  btCompoundShape* getCompound() const
+  {
+    return compound_;
+  }
+
+  /** \brief Apply the occupied voxels of a new version of the octree to the compound */
+  void update(const octomap::OcTree& octree);
+
+private:
+  /** \brief Add the children of newly occupied voxels and mark those of the voxels that are still occupied */
+  void addOccupiedVoxels(const octomap::OcTree& octree);
+
+  /** \brief The shared child shape of all voxels at \e depth, which have edges of length \e size */
+  btCollisionShape* getVoxelShape(unsigned int depth, double size);
+
+  btCompoundShape* compound_;
+  CollisionObjectType collision_object_type_;
+
+  /** \brief Child shapes by voxel depth */
+  std::map<unsigned int, std::unique_ptr<btCollisionShape>> voxel_shapes_;
+
+  /** \brief Child index of each voxel, identified by its key and depth */
+  std::unordered_map<std::uint64_t, int> voxel_children_;
+
+  /** \brief Voxel of each child index */
+  std::vector<std::uint64_t> child_voxels_;
+
+  /** \brief Whether a child is still occupied in the octree being applied */
+  std::vector<bool> child_occupied_;
+};
+
 /** @brief Tesseract bullet collision object.
  *
  *  A wrapper around bullet's collision object which contains specific information related to bullet. One of the main
@@ -174,6 +234,13 @@ public:
   /** \brief The robot links the collision objects is allowed to touch */
   std::set<std::string> m_touch_links;
 
+  /** \brief Spheres enclosing all shapes, relative to the world transform of the object. Empty if they were not
+   *  computed or a shape is unbounded. */
+  std::vector<moveit::core::BoundingSphere> m_bounding_spheres;
+
+  /** \brief Compute m_bounding_spheres from the shapes of the object */
+  void computeBoundingSpheres();
+
   /** @brief Get the collision object name */
   const std::string& getName() const
   {
@@ -223,10 +290,33 @@ public:
     clone_cow->m_enabled = m_enabled;
     clone_cow->setBroadphaseHandle(nullptr);
     clone_cow->m_touch_links = m_touch_links;
+    clone_cow->m_bounding_spheres = m_bounding_spheres;
     clone_cow->setContactProcessingThreshold(this->getContactProcessingThreshold());
+    clone_cow->m_octree = m_octree;
     return clone_cow;
   }
 
+  /** @brief The incrementally updatable compound shape if the object consists of a single octree, shared with clones
+   *  of this object */
+  const OctreeCompoundShapePtr& getOctreeShape() const
+  {
+    return m_octree;
+  }
+
+  /** @brief Set the compound shape of an octree while constructing the shapes of the object */
+  void setOctreeShape(const OctreeCompoundShapePtr& octree)
+  {
+    // only a single octree can be updated, previous ones of the object just need to stay alive
+    if (m_octree)
+      manage(m_octree);
+    m_octree = octree;
+  }
+
+  /** @brief Replace the octree of an object that consists of a single octree by a new version. The compound shape is
+   *  only updated if \e update_shape is true, as it is shared with the clones of this object.
+   *  @return False if the object does not consist of a single octree */
+  bool replaceOctree(const shapes::ShapeConstPtr& shape, bool update_shape);
+
   /** \brief Manage memory of a raw pointer shape */
   template <class T>
   void manage(T* t)
@@ -265,6 +355,9 @@ protected:
 
   /** @brief Manages the collision shape pointer so they get destroyed */
   std::vector<std::shared_ptr<void>> m_data;
+
+  /** @brief Set if the object consists of a single octree */
+  OctreeCompoundShapePtr m_octree;
 };
 
 /** @brief Casted collision shape used for checking if an object is collision free between two discrete poses
@@ -596,10 +689,33 @@ struct BroadphaseContactResultCallback
     else
     {
       return !collisions_.done && (self_ ? isOnlyKinematic(cow0, cow1) : !isOnlyKinematic(cow0, cow1)) &&
-             !acmCheck(cow0->getName(), cow1->getName(), acm_);
+             !acmCheck(cow0->getName(), cow1->getName(), acm_) &&
+             (!collisions_.req.bounding_sphere_filter || boundingSpheresMayCollide(cow0, cow1));
     }
   }
 
+  /** \brief Conservative check of the bounding spheres of two robot links, or of the spheres of a robot link against
+   *  the AABB of an object without spheres. Returns false if the objects cannot be closer than the contact distance. */
+  bool boundingSpheresMayCollide(const CollisionObjectWrapper* cow0, const CollisionObjectWrapper* cow1) const
+  {
+    if (cow0->m_bounding_spheres.empty())
+      std::swap(cow0, cow1);
+    if (cow0->m_bounding_spheres.empty())
+      return true;
+
+    const Eigen::Isometry3d pose0 = convertBtToEigen(cow0->getWorldTransform());
+    if (!cow1->m_bounding_spheres.empty())
+      return collision_detection::boundingSpheresOverlap(cow0->m_bounding_spheres, pose0, cow1->m_bounding_spheres,
+                                                         convertBtToEigen(cow1->getWorldTransform()),
+                                                         contact_distance_);
+
+    btVector3 aabb_min, aabb_max;
+    cow1->getAABB(aabb_min, aabb_max);
+    return collision_detection::boundingSpheresOverlap(
+        cow0->m_bounding_spheres, pose0, Eigen::AlignedBox3d(convertBtToEigen(aabb_min), convertBtToEigen(aabb_max)),
+        contact_distance_);
+  }
+
   /** \brief This callback is used after btManifoldResult processed a collision result. */
   btScalar addSingleResult(btManifoldPoint& cp, const btCollisionObjectWrapper* colObj0Wrap, int /*partId0*/,
                            int index0, const btCollisionObjectWrapper* colObj1Wrap, int /*partId1*/, int index1)
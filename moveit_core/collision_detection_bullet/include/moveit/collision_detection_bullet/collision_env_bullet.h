@@ -95,6 +95,9 @@ protected:
    */
   void updatedPaddingOrScaling(const std::vector<std::string>& links) override;
 
+  /** \brief Rebuilds the collision objects of all world objects */
+  void updatedConvexDecomposition() override;
+
   /** \brief All of the attached objects in the robot state are wrapped into bullet collision objects */
   void addAttachedOjects(const moveit::core::RobotState& state,
                          std::vector<collision_detection_bullet::CollisionObjectWrapperPtr>& cows) const;
@@ -127,7 +130,14 @@ protected:
   mutable std::mutex collision_env_mutex_;
 
   /** \brief Adds a world object to the collision managers */
-  void addToManager(const World::Object* obj);
+  void addToManager(const World::ObjectConstPtr& obj);
+
+  /** \brief Adds clones of the collision objects of \e other that are still valid for this environment.
+   *
+   *  The clones share the bullet collision shapes with \e other, so the shapes of the robot links and of all world
+   *  objects that did not change (e.g. in a diff of a planning scene) are not constructed again. World objects that
+   *  were changed or added are constructed from scratch. */
+  void cloneCollisionObjects(const CollisionEnvBullet& other);
 
   /** \brief Updates a managed collision object with its world representation.
    *
@@ -136,9 +146,19 @@ protected:
    *                      3) the object is in the manager then delete and add the modified */
   void updateManagedObject(const std::string& id);
 
+  /** \brief Apply a new version of the octree of \e obj to the voxels of its collision object incrementally
+   *  \return False if \e obj is not an octree managed by this environment alone, which needs to be rebuilt instead */
+  bool updateManagedOctree(const World::ObjectConstPtr& obj);
+
   /** \brief The active links where active refers to the group which can collide with everything */
   std::vector<std::string> active_;
 
+  /** \brief The world objects the collision objects in the managers were constructed from.
+   *
+   *  Holding on to the objects makes World copy them on modification, so comparing pointers tells whether a
+   *  collision object still represents the object in the world. */
+  std::map<std::string, World::ObjectConstPtr> world_object_sources_;
+
 private:
   /** \brief Callback function executed for each change to the world environment */
   void notifyObjectChange(const ObjectConstPtr& obj, World::Action action);
@@ -38,6 +38,9 @@
 #include <BulletCollision/CollisionShapes/btShapeHull.h>
 #include <BulletCollision/Gimpact/btGImpactShape.h>
 #include <geometric_shapes/shapes.h>
+#include <geometric_shapes/shape_operations.h>
+#include <moveit/collision_detection/geometry_cache.h>
+#include <cstring>
 #include <memory>
 #include <octomap/octomap.h>
 #include <ros/console.h>
@@ -81,8 +84,49 @@ btCollisionShape* createShapePrimitive(const shapes::Cone* geom, const Collision
   return (new btConeShapeZ(r, l));
 }
 
-btCollisionShape* createShapePrimitive(const shapes::Mesh* geom, const CollisionObjectType& collision_object_type,
-                                       CollisionObjectWrapper* cow)
+namespace
+{
+using HullVertices = AlignedVector<Eigen::Vector3d>;
+
+const char CONVEX_HULL_CACHE_NAME[] = "bullet_convex_hull";
+
+/** \brief Compute the vertices of the convex hull of \e mesh, or load them from the persistent geometry cache */
+std::shared_ptr<const HullVertices> computeConvexHullVertices(const shapes::Mesh* mesh)
+{
+  collision_detection::GeometryCache& cache = collision_detection::GeometryCache::getGlobal();
+  auto vertices = std::make_shared<HullVertices>();
+  collision_detection::GeometryCache::PersistentViewConstPtr view = cache.mapPersistent(*mesh, CONVEX_HULL_CACHE_NAME);
+  if (view && view->size % (3 * sizeof(double)) == 0)
+  {
+    vertices->resize(view->size / (3 * sizeof(double)));
+    for (std::size_t i = 0; i < vertices->size(); ++i)
+      std::memcpy((*vertices)[i].data(), view->data + i * 3 * sizeof(double), 3 * sizeof(double));
+    return vertices;
+  }
+
+  HullVertices input;
+  std::vector<int> faces;
+  input.reserve(mesh->vertex_count);
+  for (unsigned int i = 0; i < mesh->vertex_count; ++i)
+    input.push_back(Eigen::Vector3d(mesh->vertices[3 * i], mesh->vertices[3 * i + 1], mesh->vertices[3 * i + 2]));
+
+  if (collision_detection_bullet::createConvexHull(*vertices, faces, input) < 0)
+    return nullptr;
+
+  if (!cache.getPersistentDirectory().empty())
+  {
+    std::string data;
+    data.resize(vertices->size() * 3 * sizeof(double));
+    for (std::size_t i = 0; i < vertices->size(); ++i)
+      std::memcpy(&data[i * 3 * sizeof(double)], (*vertices)[i].data(), 3 * sizeof(double));
+    cache.storePersistent(*mesh, CONVEX_HULL_CACHE_NAME, data);
+  }
+  return vertices;
+}
+}  // namespace
+
+btCollisionShape* createShapePrimitive(const shapes::ShapeConstPtr& shape, const shapes::Mesh* geom,
+                                       const CollisionObjectType& collision_object_type, CollisionObjectWrapper* cow)
 {
   assert(collision_object_type == CollisionObjectType::USE_SHAPE_TYPE ||
          collision_object_type == CollisionObjectType::CONVEX_HULL ||
@@ -95,20 +139,15 @@ btCollisionShape* createShapePrimitive(const shapes::Mesh* geom, const Collision
     {
       case CollisionObjectType::CONVEX_HULL:
       {
-        // Create a convex hull shape to approximate Trimesh
-        collision_detection_bullet::AlignedVector<Eigen::Vector3d> input;
-        collision_detection_bullet::AlignedVector<Eigen::Vector3d> vertices;
-        std::vector<int> faces;
-
-        input.reserve(geom->vertex_count);
-        for (unsigned int i = 0; i < geom->vertex_count; ++i)
-          input.push_back(Eigen::Vector3d(geom->vertices[3 * i], geom->vertices[3 * i + 1], geom->vertices[3 * i + 2]));
-
-        if (collision_detection_bullet::createConvexHull(vertices, faces, input) < 0)
+        // Create a convex hull shape to approximate Trimesh; the hull is computed once per distinct mesh
+        std::shared_ptr<const HullVertices> vertices =
+            collision_detection::GeometryCache::getGlobal().getDerived<HullVertices>(
+                shape, CONVEX_HULL_CACHE_NAME, [geom]() { return computeConvexHullVertices(geom); });
+        if (!vertices)
           return nullptr;
 
         btConvexHullShape* subshape = new btConvexHullShape();
-        for (const Eigen::Vector3d& v : vertices)
+        for (const Eigen::Vector3d& v : *vertices)
           subshape->addPoint(
               btVector3(static_cast<btScalar>(v[0]), static_cast<btScalar>(v[1]), static_cast<btScalar>(v[2])));
 
@@ -158,6 +197,94 @@ btCollisionShape* createShapePrimitive(const shapes::Mesh* geom, const Collision
   return nullptr;
 }
 
+namespace
+{
+// identifies a voxel by the key of its corner and its depth
+std::uint64_t voxelId(const octomap::OcTree::leaf_iterator& it)
+{
+  const octomap::OcTreeKey key = it.getIndexKey();
+  return (static_cast<std::uint64_t>(key[0]) << 40) | (static_cast<std::uint64_t>(key[1]) << 24) |
+         (static_cast<std::uint64_t>(key[2]) << 8) | it.getDepth();
+}
+}  // namespace
+
+OctreeCompoundShape::OctreeCompoundShape(const octomap::OcTree& octree, btCompoundShape* compound,
+                                         const CollisionObjectType& collision_object_type)
+  : compound_(compound), collision_object_type_(collision_object_type)
+{
+  addOccupiedVoxels(octree);
+}
+
+void OctreeCompoundShape::update(const octomap::OcTree& octree)
+{
+  child_occupied_.assign(child_voxels_.size(), false);
+  addOccupiedVoxels(octree);
+
+  // removing a child moves the last one into its place; going backwards, the moved child is always one to keep,
+  // including the children added above
+  bool removed = false;
+  for (int i = static_cast<int>(child_occupied_.size()) - 1; i >= 0; --i)
+  {
+    if (child_occupied_[i])
+      continue;
+    voxel_children_.erase(child_voxels_[i]);
+    compound_->removeChildShapeByIndex(i);
+    if (i != static_cast<int>(child_voxels_.size()) - 1)
+    {
+      child_voxels_[i] = child_voxels_.back();
+      voxel_children_[child_voxels_[i]] = i;
+    }
+    child_voxels_.pop_back();
+    removed = true;
+  }
+  child_occupied_.clear();
+  if (removed)
+    compound_->recalculateLocalAabb();
+}
+
+void OctreeCompoundShape::addOccupiedVoxels(const octomap::OcTree& octree)
+{
+  const double occupancy_threshold = octree.getOccupancyThres();
+  for (auto it = octree.begin_leafs(), end = octree.end_leafs(); it != end; ++it)
+  {
+    if (it->getOccupancy() < occupancy_threshold)
+      continue;
+
+    const std::uint64_t id = voxelId(it);
+    auto child = voxel_children_.find(id);
+    if (child != voxel_children_.end())
+    {
+      child_occupied_[child->second] = true;
+      continue;
+    }
+
+    btTransform geom_trans;
+    geom_trans.setIdentity();
+    geom_trans.setOrigin(btVector3(static_cast<btScalar>(it.getX()), static_cast<btScalar>(it.getY()),
+                                   static_cast<btScalar>(it.getZ())));
+    compound_->addChildShape(geom_trans, getVoxelShape(it.getDepth(), it.getSize()));
+    voxel_children_[id] = static_cast<int>(child_voxels_.size());
+    child_voxels_.push_back(id);
+  }
+}
+
+btCollisionShape* OctreeCompoundShape::getVoxelShape(unsigned int depth, double size)
+{
+  std::unique_ptr<btCollisionShape>& shape = voxel_shapes_[depth];
+  if (!shape)
+  {
+    if (collision_object_type_ == CollisionObjectType::MULTI_SPHERE)
+      shape = std::make_unique<btSphereShape>(static_cast<btScalar>(std::sqrt(2 * ((size / 2) * (size / 2)))));
+    else
+    {
+      btScalar l = static_cast<btScalar>(size / 2);
+      shape = std::make_unique<btBoxShape>(btVector3(l, l, l));
+    }
+    shape->setMargin(BULLET_MARGIN);
+  }
+  return shape.get();
+}
+
 btCollisionShape* createShapePrimitive(const shapes::OcTree* geom, const CollisionObjectType& collision_object_type,
                                        CollisionObjectWrapper* cow)
 {
@@ -166,57 +293,16 @@ btCollisionShape* createShapePrimitive(const shapes::OcTree* geom, const Collisi
          collision_object_type == CollisionObjectType::SDF ||
          collision_object_type == CollisionObjectType::MULTI_SPHERE);
 
-  btCompoundShape* subshape =
-      new btCompoundShape(BULLET_COMPOUND_USE_DYNAMIC_AABB, static_cast<int>(geom->octree->size()));
-  double occupancy_threshold = geom->octree->getOccupancyThres();
-
   // convert the mesh to the assigned collision object type
   switch (collision_object_type)
   {
     case CollisionObjectType::USE_SHAPE_TYPE:
-    {
-      for (auto it = geom->octree->begin(static_cast<unsigned char>(geom->octree->getTreeDepth())),
-                end = geom->octree->end();
-           it != end; ++it)
-      {
-        if (it->getOccupancy() >= occupancy_threshold)
-        {
-          double size = it.getSize();
-          btTransform geom_trans;
-          geom_trans.setIdentity();
-          geom_trans.setOrigin(btVector3(static_cast<btScalar>(it.getX()), static_cast<btScalar>(it.getY()),
-                                         static_cast<btScalar>(it.getZ())));
-          btScalar l = static_cast<btScalar>(size / 2);
-          btBoxShape* childshape = new btBoxShape(btVector3(l, l, l));
-          childshape->setMargin(BULLET_MARGIN);
-          cow->manage(childshape);
-
-          subshape->addChildShape(geom_trans, childshape);
-        }
-      }
-      return subshape;
-    }
     case CollisionObjectType::MULTI_SPHERE:
     {
-      for (auto it = geom->octree->begin(static_cast<unsigned char>(geom->octree->getTreeDepth())),
-                end = geom->octree->end();
-           it != end; ++it)
-      {
-        if (it->getOccupancy() >= occupancy_threshold)
-        {
-          double size = it.getSize();
-          btTransform geom_trans;
-          geom_trans.setIdentity();
-          geom_trans.setOrigin(btVector3(static_cast<btScalar>(it.getX()), static_cast<btScalar>(it.getY()),
-                                         static_cast<btScalar>(it.getZ())));
-          btSphereShape* childshape =
-              new btSphereShape(static_cast<btScalar>(std::sqrt(2 * ((size / 2) * (size / 2)))));
-          childshape->setMargin(BULLET_MARGIN);
-          cow->manage(childshape);
-
-          subshape->addChildShape(geom_trans, childshape);
-        }
-      }
+      btCompoundShape* subshape =
+          new btCompoundShape(BULLET_COMPOUND_USE_DYNAMIC_AABB, static_cast<int>(geom->octree->size()));
+      // the voxel shapes live as long as any clone of the object
+      cow->setOctreeShape(std::make_shared<OctreeCompoundShape>(*geom->octree, subshape, collision_object_type));
       return subshape;
     }
     default:
@@ -251,7 +337,7 @@ btCollisionShape* createShapePrimitive(const shapes::ShapeConstPtr& geom,
     }
     case shapes::MESH:
     {
-      return createShapePrimitive(static_cast<const shapes::Mesh*>(geom.get()), collision_object_type, cow);
+      return createShapePrimitive(geom, static_cast<const shapes::Mesh*>(geom.get()), collision_object_type, cow);
     }
     case shapes::OCTREE:
     {
@@ -331,6 +417,46 @@ CollisionObjectWrapper::CollisionObjectWrapper(const std::string& name, const co
   }
 }
 
+bool CollisionObjectWrapper::replaceOctree(const shapes::ShapeConstPtr& shape, bool update_shape)
+{
+  if (!m_octree || m_shapes.size() != 1 || shape->type != shapes::OCTREE ||
+      getCollisionShape() != m_octree->getCompound())
+    return false;
+
+  m_shapes[0] = shape;
+  if (update_shape)
+    m_octree->update(*static_cast<const shapes::OcTree&>(*shape).octree);
+  return true;
+}
+
+void CollisionObjectWrapper::computeBoundingSpheres()
+{
+  m_bounding_spheres.clear();
+  // shapes are placed relative to the pose of the first one, see the constructor
+  const Eigen::Isometry3d inv_world = m_shape_poses[0].inverse();
+  std::vector<moveit::core::BoundingSphere> shape_spheres;
+  for (std::size_t j = 0; j < m_shapes.size(); ++j)
+  {
+    if (m_collision_object_types[j] == CollisionObjectType::CONVEX_HULL)
+    {
+      // the hull of a mesh is not covered by the spheres of its slabs, only by a sphere around all vertices
+      shape_spheres.resize(1);
+      shapes::computeShapeBoundingSphere(m_shapes[j].get(), shape_spheres[0].center, shape_spheres[0].radius);
+    }
+    else
+      moveit::core::computeBoundingSpheres(*m_shapes[j], shape_spheres);
+
+    if (shape_spheres.empty())
+    {
+      m_bounding_spheres.clear();
+      return;
+    }
+    const Eigen::Isometry3d local = inv_world * m_shape_poses[j];
+    for (const moveit::core::BoundingSphere& sphere : shape_spheres)
+      m_bounding_spheres.push_back(moveit::core::BoundingSphere{ local * sphere.center, sphere.radius });
+  }
+}
+
 CollisionObjectWrapper::CollisionObjectWrapper(const std::string& name, const collision_detection::BodyType& type_id,
                                                const std::vector<shapes::ShapeConstPtr>& shapes,
                                                const AlignedVector<Eigen::Isometry3d>& shape_poses,
@@ -38,6 +38,7 @@
 #include <moveit/collision_detection_bullet/collision_detector_allocator_bullet.h>
 #include <moveit/collision_detection_bullet/bullet_integration/ros_bullet_utils.h>
 #include <moveit/collision_detection_bullet/bullet_integration/contact_checker_common.h>
+#include <moveit/profiler/trace.h>
 #include <functional>
 #include <bullet/btBulletCollisionCommon.h>
 
@@ -86,13 +87,7 @@ CollisionEnvBullet::CollisionEnvBullet(const CollisionEnvBullet& other, const Wo
   observer_handle_ = getWorld()->addObserver(
       [this](const World::ObjectConstPtr& object, World::Action action) { notifyObjectChange(object, action); });
 
-  for (const std::pair<const std::string, urdf::LinkSharedPtr>& link : other.robot_model_->getURDF()->links_)
-  {
-    addLinkAsCollisionObject(link.second);
-  }
-
-  // get notifications any objects already in the new world
-  getWorld()->notifyObserverAllObjects(observer_handle_, World::CREATE);
+  cloneCollisionObjects(other);
 }
 
 CollisionEnvBullet::~CollisionEnvBullet()
@@ -117,6 +112,7 @@ void CollisionEnvBullet::checkSelfCollisionHelper(const CollisionRequest& req, C
                                                   const moveit::core::RobotState& state,
                                                   const AllowedCollisionMatrix* acm) const
 {
+  MOVEIT_TRACE_ZONE("CollisionEnvBullet::checkSelfCollision");
   std::lock_guard<std::mutex> guard(collision_env_mutex_);
 
   std::vector<collision_detection_bullet::CollisionObjectWrapperPtr> cows;
@@ -180,6 +176,7 @@ void CollisionEnvBullet::checkRobotCollisionHelper(const CollisionRequest& req,
                                                    const moveit::core::RobotState& state,
                                                    const AllowedCollisionMatrix* acm) const
 {
+  MOVEIT_TRACE_ZONE("CollisionEnvBullet::checkRobotCollision");
   std::lock_guard<std::mutex> guard(collision_env_mutex_);
 
   if (req.distance)
@@ -250,11 +247,48 @@ void CollisionEnvBullet::distanceRobot(const DistanceRequest& /*req*/, DistanceR
   ROS_INFO_NAMED(LOGNAME, "distanceRobot is not implemented for Bullet.");
 }
 
-void CollisionEnvBullet::addToManager(const World::Object* obj)
+void CollisionEnvBullet::cloneCollisionObjects(const CollisionEnvBullet& other)
+{
+  std::lock_guard<std::mutex> other_guard(other.collision_env_mutex_);
+  std::lock_guard<std::mutex> guard(collision_env_mutex_);
+
+  for (const std::pair<const std::string, collision_detection_bullet::CollisionObjectWrapperPtr>& entry :
+       other.manager_->getCollisionObjects())
+    if (entry.second->getTypeID() == collision_detection::BodyType::ROBOT_LINK)
+    {
+      collision_detection_bullet::CollisionObjectWrapperPtr cow = entry.second->clone();
+      manager_->addCollisionObject(cow);
+      manager_CCD_->addCollisionObject(cow->clone());
+    }
+  active_ = other.active_;
+
+  for (const std::pair<const std::string, World::ObjectPtr>& object : *getWorld())
+  {
+    const auto source = other.world_object_sources_.find(object.first);
+    if (source != other.world_object_sources_.end() && source->second == object.second &&
+        other.manager_->hasCollisionObject(object.first))
+    {
+      collision_detection_bullet::CollisionObjectWrapperPtr cow =
+          other.manager_->getCollisionObjects().at(object.first)->clone();
+      manager_->addCollisionObject(cow);
+      manager_CCD_->addCollisionObject(cow->clone());
+      world_object_sources_[object.first] = object.second;
+    }
+    else
+      addToManager(object.second);
+  }
+}
+
+void CollisionEnvBullet::addToManager(const World::ObjectConstPtr& obj)
 {
   std::vector<collision_detection_bullet::CollisionObjectType> collision_object_types;
 
-  for (const shapes::ShapeConstPtr& shape : obj->shapes_)
+  // meshes of a convex decomposition are replaced by their parts
+  std::vector<shapes::ShapeConstPtr> shapes;
+  EigenSTL::vector_Isometry3d poses;
+  std::vector<bool> convex;
+  getWorldObjectCollisionShapes(*obj, shapes, poses, convex);
+  for (const shapes::ShapeConstPtr& shape : shapes)
   {
     if (shape->type == shapes::MESH)
       collision_object_types.push_back(collision_detection_bullet::CollisionObjectType::CONVEX_HULL);
@@ -263,11 +297,11 @@ void CollisionEnvBullet::addToManager(const World::Object* obj)
   }
 
   auto cow = std::make_shared<collision_detection_bullet::CollisionObjectWrapper>(
-      obj->id_, collision_detection::BodyType::WORLD_OBJECT, obj->shapes_, obj->global_shape_poses_,
-      collision_object_types, false);
+      obj->id_, collision_detection::BodyType::WORLD_OBJECT, shapes, poses, collision_object_types, false);
 
   manager_->addCollisionObject(cow);
   manager_CCD_->addCollisionObject(cow->clone());
+  world_object_sources_[obj->id_] = obj;
 }
 
 void CollisionEnvBullet::updateManagedObject(const std::string& id)
@@ -279,11 +313,11 @@ void CollisionEnvBullet::updateManagedObject(const std::string& id)
     {
       manager_->removeCollisionObject(id);
       manager_CCD_->removeCollisionObject(id);
-      addToManager(it->second.get());
+      addToManager(it->second);
     }
     else
     {
-      addToManager(it->second.get());
+      addToManager(it->second);
     }
   }
   else
@@ -293,6 +327,7 @@ void CollisionEnvBullet::updateManagedObject(const std::string& id)
       manager_->removeCollisionObject(id);
       manager_CCD_->removeCollisionObject(id);
     }
+    world_object_sources_.erase(id);
   }
 }
 
@@ -321,13 +356,40 @@ void CollisionEnvBullet::notifyObjectChange(const ObjectConstPtr& obj, World::Ac
   {
     manager_->removeCollisionObject(obj->id_);
     manager_CCD_->removeCollisionObject(obj->id_);
+    world_object_sources_.erase(obj->id_);
   }
-  else
+  else if (action != World::UPDATE_SHAPE || !updateManagedOctree(obj))
   {
     updateManagedObject(obj->id_);
   }
 }
 
+bool CollisionEnvBullet::updateManagedOctree(const World::ObjectConstPtr& obj)
+{
+  if (obj->shapes_.size() != 1 || !manager_->hasCollisionObject(obj->id_) ||
+      !manager_CCD_->hasCollisionObject(obj->id_))
+    return false;
+
+  const collision_detection_bullet::CollisionObjectWrapperPtr& cow = manager_->getCollisionObjects().at(obj->id_);
+  const collision_detection_bullet::CollisionObjectWrapperPtr& cow_ccd =
+      manager_CCD_->getCollisionObjects().at(obj->id_);
+  // the compound shape is shared by the objects in both managers; any further user is a clone of this environment,
+  // which needs to keep the previous version of the octree
+  const collision_detection_bullet::OctreeCompoundShapePtr& octree = cow->getOctreeShape();
+  if (!octree || cow_ccd->getOctreeShape() != octree || octree.use_count() != 2)
+    return false;
+
+  if (!cow->replaceOctree(obj->shapes_[0], true))
+    return false;
+  cow_ccd->replaceOctree(obj->shapes_[0], false);
+
+  // the bounds of the object changed with its voxels
+  manager_->setCollisionObjectsTransform(obj->id_, obj->global_shape_poses_[0]);
+  manager_CCD_->setCollisionObjectsTransform(obj->id_, obj->global_shape_poses_[0]);
+  world_object_sources_[obj->id_] = obj;
+  return true;
+}
+
 void CollisionEnvBullet::addAttachedOjects(const moveit::core::RobotState& state,
                                            std::vector<collision_detection_bullet::CollisionObjectWrapperPtr>& cows) const
 {
@@ -371,6 +433,13 @@ void CollisionEnvBullet::updatedPaddingOrScaling(const std::vector<std::string>&
   }
 }
 
+void CollisionEnvBullet::updatedConvexDecomposition()
+{
+  std::lock_guard<std::mutex> guard(collision_env_mutex_);
+  for (const auto& object : *getWorld())
+    updateManagedObject(object.first);
+}
+
 void CollisionEnvBullet::updateTransformsFromState(
     const moveit::core::RobotState& state, const collision_detection_bullet::BulletDiscreteBVHManagerPtr& manager) const
 {
@@ -433,6 +502,7 @@ void CollisionEnvBullet::addLinkAsCollisionObject(const urdf::LinkSharedPtr& lin
     {
       collision_detection_bullet::CollisionObjectWrapperPtr cow(new collision_detection_bullet::CollisionObjectWrapper(
           link->name, collision_detection::BodyType::ROBOT_LINK, shapes, shape_poses, collision_object_types, true));
+      cow->computeBoundingSpheres();
       manager_->addCollisionObject(cow);
       manager_CCD_->addCollisionObject(cow->clone());
       active_.push_back(cow->getName());
@@ -321,6 +321,51 @@ TEST_F(BulletCollisionDetectionTester, ContinuousCollisionWorld)
   res.clear();
 }
 
+/** \brief A copy of the environment reuses the collision objects of unchanged world objects and is independent of
+ *  the original afterwards. */
+TEST_F(BulletCollisionDetectionTester, CopyEnvironment)
+{
+  collision_detection::CollisionRequest req;
+  collision_detection::CollisionResult res;
+
+  Eigen::Isometry3d near_pose{ Eigen::Isometry3d::Identity() };
+  near_pose.translation().z() = 0.3;
+  Eigen::Isometry3d far_pose{ Eigen::Isometry3d::Identity() };
+  far_pose.translation().x() = 5.0;
+  cenv_->getWorld()->addToObject("box", std::make_shared<shapes::Box>(0.1, 0.1, 0.1), near_pose);
+  cenv_->getWorld()->addToObject("far_box", std::make_shared<shapes::Box>(0.1, 0.1, 0.1), far_pose);
+
+  auto world = std::make_shared<collision_detection::World>(*cenv_->getWorld());
+  collision_detection::CollisionEnvBullet copy(dynamic_cast<const collision_detection::CollisionEnvBullet&>(*cenv_),
+                                               world);
+
+  copy.checkSelfCollision(req, res, *robot_state_, *acm_);
+  EXPECT_FALSE(res.collision);
+  res.clear();
+  copy.checkRobotCollision(req, res, *robot_state_, *acm_);
+  EXPECT_TRUE(res.collision);
+  res.clear();
+
+  // moving the object in the copy does not affect the original
+  world->moveShapeInObject("box", world->getObject("box")->shapes_[0], far_pose);
+  copy.checkRobotCollision(req, res, *robot_state_, *acm_);
+  EXPECT_FALSE(res.collision);
+  res.clear();
+  cenv_->checkRobotCollision(req, res, *robot_state_, *acm_);
+  EXPECT_TRUE(res.collision);
+  res.clear();
+
+  // and vice versa
+  cenv_->getWorld()->moveShapeInObject("far_box", cenv_->getWorld()->getObject("far_box")->shapes_[0], near_pose);
+  cenv_->getWorld()->removeObject("box");
+  cenv_->checkRobotCollision(req, res, *robot_state_, *acm_);
+  EXPECT_TRUE(res.collision);
+  res.clear();
+  copy.checkRobotCollision(req, res, *robot_state_, *acm_);
+  EXPECT_FALSE(res.collision);
+  res.clear();
+}
+
 TEST(ContinuousCollisionUnit, BulletCastBVHCollisionBoxBoxUnit)
 {
   collision_detection::CollisionResult result;
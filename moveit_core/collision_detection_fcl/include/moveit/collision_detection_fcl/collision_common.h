@@ -38,6 +38,7 @@
 
 #include <moveit/collision_detection/world.h>
 #include <moveit/collision_detection/collision_env.h>
+#include <moveit/collision_detection/bounding_spheres.h>
 #include <moveit/macros/class_forward.h>
 #include <moveit/collision_detection_fcl/fcl_compat.h>
 #include <geometric_shapes/check_isometry.h>
@@ -140,12 +141,25 @@ struct CollisionGeometryData
 /** \brief Data structure which is passed to the collision callback function of the collision manager. */
 struct CollisionData
 {
-  CollisionData() : req_(nullptr), active_components_only_(nullptr), res_(nullptr), acm_(nullptr), done_(false)
+  CollisionData()
+    : req_(nullptr)
+    , active_components_only_(nullptr)
+    , res_(nullptr)
+    , acm_(nullptr)
+    , fcl_result_(nullptr)
+    , link_bounding_spheres_(nullptr)
+    , done_(false)
   {
   }
 
   CollisionData(const CollisionRequest* req, CollisionResult* res, const AllowedCollisionMatrix* acm)
-    : req_(req), active_components_only_(nullptr), res_(res), acm_(acm), done_(false)
+    : req_(req)
+    , active_components_only_(nullptr)
+    , res_(res)
+    , acm_(acm)
+    , fcl_result_(nullptr)
+    , link_bounding_spheres_(nullptr)
+    , done_(false)
   {
   }
 
@@ -171,6 +185,13 @@ struct CollisionData
   /** \brief The user-specified collision matrix (may be NULL). */
   const AllowedCollisionMatrix* acm_;
 
+  /** \brief Storage reused for the results of the narrowphase checks (may be NULL, then a local result is used). */
+  fcl::CollisionResultd* fcl_result_;
+
+  /** \brief Padded bounding spheres of the robot link shapes, indexed like the collision body transforms of a
+   *  RobotState. Used to reject pairs if \e req_ asks for the bounding sphere filter (may be NULL). */
+  const std::vector<std::vector<moveit::core::BoundingSphere>>* link_bounding_spheres_;
+
   /** \brief Flag indicating whether collision checking is complete. */
   bool done_;
 };
@@ -178,7 +199,8 @@ struct CollisionData
 /** \brief Data structure which is passed to the distance callback function of the collision manager. */
 struct DistanceData
 {
-  DistanceData(const DistanceRequest* req, DistanceResult* res) : req(req), res(res), done(false)
+  DistanceData(const DistanceRequest* req, DistanceResult* res)
+    : req(req), res(res), done(false), closest_geometry{ nullptr, nullptr }
   {
   }
   ~DistanceData()
@@ -193,6 +215,9 @@ struct DistanceData
 
   /** \brief Indicates if distance query is finished. */
   bool done;
+
+  /** \brief The geometries of the pair that determined \e res->minimum_distance */
+  const fcl::CollisionGeometryd* closest_geometry[2];
 };
 
 MOVEIT_STRUCT_FORWARD(FCLGeometry);
@@ -299,6 +324,15 @@ FCLGeometryConstPtr createCollisionGeometry(const shapes::ShapeConstPtr& shape,
  *  A world object always consists only of a single shape, therefore we don't need the \e shape_index. */
 FCLGeometryConstPtr createCollisionGeometry(const shapes::ShapeConstPtr& shape, const World::Object* obj);
 
+/** \brief Build the cached data createCollisionGeometry() needs for \e shape ahead of time, i.e. the bounding volume
+ *  hierarchy of meshes. This is thread-safe. */
+void prepareCollisionGeometry(const shapes::ShapeConstPtr& shape);
+
+/** \brief Create new FCLGeometry object out of a convex mesh of a world object, e.g. a part of a convex
+ *  decomposition. With FCL 0.6 and later the mesh becomes an fcl::Convex, which is checked with GJK and yields
+ *  penetration depths; older versions treat it like any other mesh. */
+FCLGeometryConstPtr createConvexCollisionGeometry(const shapes::ShapeConstPtr& shape, const World::Object* obj);
+
 /** \brief Create new scaled and / or padded FCLGeometry object out of robot link model. */
 FCLGeometryConstPtr createCollisionGeometry(const shapes::ShapeConstPtr& shape, double scale, double padding,
                                             const moveit::core::LinkModel* link, int shape_index);
@@ -314,6 +348,9 @@ FCLGeometryConstPtr createCollisionGeometry(const shapes::ShapeConstPtr& shape,
 /** \brief Increases the counter of the caches which can trigger the cleaning of expired entries from them. */
 void cleanCollisionGeometryCache();
 
+/** \brief Drop the coarse versions of an octree geometry, after its octree was modified in place. */
+void clearCoarseOcTreeCache(const fcl::CollisionGeometryd* geometry);
+
 /** \brief Transforms an Eigen Isometry3d to FCL coordinate transformation */
 inline void transform2fcl(const Eigen::Isometry3d& b, fcl::Transform3d& f)
 {
@@ -45,10 +45,65 @@
 #include <fcl/broadphase/broadphase.h>
 #endif
 
+#include <list>
 #include <memory>
+#include <utility>
+#include <vector>
 
 namespace collision_detection
 {
+/** \brief Scratch storage that CollisionEnvFCL reuses across queries.
+ *
+ *  The context keeps the robot broadphases (see CollisionEnvFCL::getRobotBroadPhase()), the FCL result storage of
+ *  the narrowphase checks and the request and result of binary queries. Beyond the first query, checks of states
+ *  with the same attached bodies as the previous query therefore do not allocate. A context must only be used by
+ *  one thread at a time. The queries that take no context use getThreadLocal(). */
+struct CollisionQueryContext
+{
+  /** \brief Collision objects and broadphase of the robot for one robot geometry */
+  struct RobotBroadPhase
+  {
+    std::size_t geometry_id;
+
+    /** \brief The first link_object_count objects belong to links, the remaining ones to attached bodies */
+    FCLManager manager;
+    std::size_t link_object_count;
+
+    /** \brief Whether the link resp. attached body objects are registered to the manager */
+    bool links_registered;
+    bool attached_registered;
+
+    /** \brief The attached bodies the attached body objects were built for, with their shapes. Holding the shapes
+     *  keeps their addresses from being reused, so a state with the same bodies and shapes can keep the objects and
+     *  only update their transforms. */
+    std::vector<std::pair<const moveit::core::AttachedBody*, std::vector<shapes::ShapeConstPtr>>> attached_bodies;
+
+    /** \brief For each attached body object, the index of its body in attached_bodies and of its shape */
+    std::vector<std::pair<std::size_t, std::size_t>> attached_object_shapes;
+  };
+
+  /** \brief The context of the calling thread */
+  static CollisionQueryContext& getThreadLocal();
+
+  /** \brief Robot broadphases of the last few robot geometries, most recently used first */
+  std::list<RobotBroadPhase> robot_broadphases;
+
+  /** \brief Reused by the collision callback for the narrowphase checks */
+  fcl::CollisionResultd fcl_result;
+
+  /** \brief Request and result of the binary queries, e.g. CollisionEnvFCL::isSelfColliding() */
+  CollisionRequest binary_request;
+  CollisionResult binary_result;
+
+  /** \brief Geometries of the closest pair found by the last GLOBAL self resp. robot-world distance query.
+   *
+   *  The next query of the same kind computes the distance of this pair first. For small motions between queries
+   *  it is usually still the closest one, so the broadphase can skip most other pairs right away. The pointers are
+   *  only compared, never dereferenced. */
+  const fcl::CollisionGeometryd* closest_self_pair[2] = { nullptr, nullptr };
+  const fcl::CollisionGeometryd* closest_robot_pair[2] = { nullptr, nullptr };
+};
+
 /** \brief FCL implementation of the CollisionEnv */
 class CollisionEnvFCL : public CollisionEnv
 {
@@ -88,8 +143,31 @@ public:
   void distanceRobot(const DistanceRequest& req, DistanceResult& res,
                      const moveit::core::RobotState& state) const override;
 
+  /** \brief Binary self collision check of \e state with a reusable \e context.
+   *
+   *  No contacts, costs or distances are computed and \e acm is taken into account. */
+  bool isSelfColliding(const moveit::core::RobotState& state, const AllowedCollisionMatrix& acm,
+                       const std::string& group_name, CollisionQueryContext& context) const;
+
+  /** \brief Binary check of \e state for collisions with the world with a reusable \e context.
+   *
+   *  No contacts, costs or distances are computed and \e acm is taken into account. */
+  bool isRobotColliding(const moveit::core::RobotState& state, const AllowedCollisionMatrix& acm,
+                        const std::string& group_name, CollisionQueryContext& context) const;
+
+  using CollisionEnv::isSelfColliding;
+  using CollisionEnv::isRobotColliding;
+
+  bool isSelfColliding(const moveit::core::RobotState& state, const AllowedCollisionMatrix& acm,
+                       const std::string& group_name = "") const override;
+
+  bool isRobotColliding(const moveit::core::RobotState& state, const AllowedCollisionMatrix& acm,
+                        const std::string& group_name = "") const override;
+
   void setWorld(const WorldPtr& world) override;
 
+  void prepareWorldShapes(const std::vector<shapes::ShapeConstPtr>& shapes) const override;
+
 protected:
   /** \brief Updates the FCL collision geometry and objects saved in the CollisionRobotFCL members to reflect a new
    *   padding or scaling of the robot links.
@@ -100,13 +178,37 @@ protected:
    *   \param links The names of the links which have been updated in the robot model */
   void updatedPaddingOrScaling(const std::vector<std::string>& links) override;
 
+  /** \brief Rebuilds the FCL objects of all world objects */
+  void updatedConvexDecomposition() override;
+
   /** \brief Bundles the different checkSelfCollision functions into a single function */
   void checkSelfCollisionHelper(const CollisionRequest& req, CollisionResult& res,
-                                const moveit::core::RobotState& state, const AllowedCollisionMatrix* acm) const;
+                                const moveit::core::RobotState& state, const AllowedCollisionMatrix* acm,
+                                CollisionQueryContext& context) const;
 
   /** \brief Bundles the different checkRobotCollision functions into a single function */
   void checkRobotCollisionHelper(const CollisionRequest& req, CollisionResult& res,
-                                 const moveit::core::RobotState& state, const AllowedCollisionMatrix* acm) const;
+                                 const moveit::core::RobotState& state, const AllowedCollisionMatrix* acm,
+                                 CollisionQueryContext& context) const;
+
+  /** \brief Continuous check of the motion from \e state1 to \e state2 for collisions with the world.
+   *
+   *   Uses conservative advancement in joint space: the clearance to the world at the current configuration, divided
+   *   by an upper bound on how far any point of the robot moves over the whole segment (see getMotionBound()), gives
+   *   a fraction of the segment that is certainly collision free. The configuration is then advanced by that fraction
+   *   until the end of the segment is reached or the clearance drops below a small tolerance. Only the first
+   *   configuration that is found in contact is checked for contacts as requested by \e req. */
+  void checkRobotCollisionHelperCCD(const CollisionRequest& req, CollisionResult& res,
+                                    const moveit::core::RobotState& state1, const moveit::core::RobotState& state2,
+                                    const AllowedCollisionMatrix* acm) const;
+
+  /** \brief Upper bound on the distance any point of the (padded) robot geometry and its attached bodies travels when
+   *   moving along the joint space interpolation from \e state1 to \e state2.
+   *
+   *   The bound sums the motion of all ancestor joints of each link, weighted by the largest possible distance of the
+   *   link geometry from the joint. It is infinite if it depends on unbounded prismatic, planar or floating joints
+   *   between a moving joint and a link. */
+  double getMotionBound(const moveit::core::RobotState& state1, const moveit::core::RobotState& state2) const;
 
   /** \brief Construct an FCL collision object from MoveIt's World::Object. */
   void constructFCLObjectWorld(const World::Object* obj, FCLObject& fcl_obj) const;
@@ -130,6 +232,24 @@ protected:
    *   state and specifying a broadphase collision manager of FCL where the constructed object is registered to. */
   void allocSelfCollisionBroadPhase(const moveit::core::RobotState& state, FCLManager& manager) const;
 
+  /** \brief Get the robot broadphase of \e context, updated to the link transforms and attached bodies of \e state.
+   *
+   *   The context keeps the FCL collision objects of the robot links and their broadphase across queries, so they are
+   *   created only once and afterwards just receive new transforms. The broadphase is refit in place instead of being
+   *   rebuilt. Objects for the attached bodies of \e state are recreated on every call.
+   *
+   *   \param state The robot state to update the objects to
+   *   \param update_manager If false, only the collision objects are updated, not the broadphase structure.
+   *   \param context The context that owns the broadphase
+   *   \return The manager, valid until the next call with the same context */
+  FCLManager& getRobotBroadPhase(const moveit::core::RobotState& state, bool update_manager,
+                                 CollisionQueryContext& context) const;
+
+  /** \brief Find the collision object of \e geometry among the robot objects \e robot or, if \e world is true,
+   *   among the world objects. Returns nullptr if there is none. */
+  fcl::CollisionObjectd* findCollisionObject(const fcl::CollisionGeometryd* geometry, const FCLObject& robot,
+                                             bool world) const;
+
   /** \brief Converts all shapes which make up an atttached body into a vector of FCLGeometryConstPtr.
    *
    *   When they are converted, they can be added to the FCL representation of the robot for collision checking.
@@ -145,6 +265,15 @@ protected:
   /** \brief Vector of shared pointers to the FCL collision objects which make up the robot */
   std::vector<FCLCollisionObjectConstPtr> robot_fcl_objs_;
 
+  /** \brief Padded and scaled bounding spheres of the robot link shapes, indexed like robot_fcl_objs_ */
+  std::vector<std::vector<moveit::core::BoundingSphere>> robot_bounding_spheres_;
+
+  /** \brief Identifies robot_fcl_objs_ in the robot broadphases of the query contexts, see getRobotBroadPhase().
+   *
+   *   Copies of an environment share the id, so they also share the broadphases. It changes whenever the robot
+   *   geometry changes. */
+  std::size_t robot_geometry_id_;
+
   /// FCL collision manager which handles the collision checking process
   std::unique_ptr<fcl::BroadPhaseCollisionManagerd> manager_;
 
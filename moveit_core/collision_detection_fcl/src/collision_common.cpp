@@ -37,10 +37,12 @@
 #include <moveit/collision_detection_fcl/collision_common.h>
 #include <geometric_shapes/shapes.h>
 #include <moveit/collision_detection_fcl/fcl_compat.h>
+#include <moveit/collision_detection/geometry_cache.h>
 
 #if (MOVEIT_FCL_VERSION >= FCL_VERSION_CHECK(0, 6, 0))
 #include <fcl/geometry/bvh/BVH_model.h>
 #include <fcl/geometry/octree/octree.h>
+#include <fcl/geometry/shape/convex.h>
 #else
 #include <fcl/BVH/BVH_model.h>
 #include <fcl/shape/geometric_shapes.h>
@@ -48,11 +50,219 @@
 #endif
 
 #include <boost/thread/mutex.hpp>
+#include <boost/thread/shared_mutex.hpp>
+#include <octomap/octomap.h>
+#include <algorithm>
+#include <cmath>
+#include <map>
 #include <memory>
 #include <type_traits>
+#include <typeinfo>
 
 namespace collision_detection
 {
+namespace
+{
+Eigen::Isometry3d fcl2transform(const fcl::Transform3d& f)
+{
+  Eigen::Isometry3d b;
+#if (MOVEIT_FCL_VERSION >= FCL_VERSION_CHECK(0, 6, 0))
+  b = f;
+#else
+  const fcl::Vec3f& t = f.getTranslation();
+  const fcl::Matrix3f& r = f.getRotation();
+  b.translation() = Eigen::Vector3d(t[0], t[1], t[2]);
+  for (int i = 0; i < 3; ++i)
+    for (int j = 0; j < 3; ++j)
+      b.linear()(i, j) = r(i, j);
+#endif
+  return b;
+}
+
+// bounding spheres of a robot link geometry, nullptr for other bodies
+const std::vector<moveit::core::BoundingSphere>* linkBoundingSpheres(const CollisionData* cdata,
+                                                                     const CollisionGeometryData* cd)
+{
+  if (cd->type != BodyTypes::ROBOT_LINK)
+    return nullptr;
+  const std::size_t index = cd->ptr.link->getFirstCollisionBodyTransformIndex() + cd->shape_index;
+  return index < cdata->link_bounding_spheres_->size() ? &(*cdata->link_bounding_spheres_)[index] : nullptr;
+}
+
+// conservative check whether two geometries can collide, based on the bounding spheres of robot links
+bool boundingSpheresMayCollide(const CollisionData* cdata, fcl::CollisionObjectd* o1, const CollisionGeometryData* cd1,
+                               fcl::CollisionObjectd* o2, const CollisionGeometryData* cd2)
+{
+  const std::vector<moveit::core::BoundingSphere>* spheres1 = linkBoundingSpheres(cdata, cd1);
+  const std::vector<moveit::core::BoundingSphere>* spheres2 = linkBoundingSpheres(cdata, cd2);
+  if (spheres1 && spheres2)
+    return boundingSpheresOverlap(*spheres1, fcl2transform(o1->getTransform()), *spheres2,
+                                  fcl2transform(o2->getTransform()));
+  if (!spheres1)
+  {
+    std::swap(spheres1, spheres2);
+    std::swap(o1, o2);
+  }
+  if (!spheres1)
+    return true;
+
+  // the other body has no spheres; test against its (world frame) broadphase box
+  const auto& aabb = o2->getAABB();
+  const Eigen::AlignedBox3d box(Eigen::Vector3d(aabb.min_[0], aabb.min_[1], aabb.min_[2]),
+                                Eigen::Vector3d(aabb.max_[0], aabb.max_[1], aabb.max_[2]));
+  return boundingSpheresOverlap(*spheres1, fcl2transform(o1->getTransform()), box);
+}
+
+// depth of all octomap octrees
+constexpr unsigned int OCTOMAP_TREE_DEPTH = 16;
+
+// number of octree levels the level-of-detail check of octomaps skips, i.e. it checks 8 times coarser nodes
+constexpr unsigned int OCTOMAP_LOD_LEVELS = 3;
+
+// Mark all cells of the coarse octree covered by the occupied nodes of the subtree of \e node, treating nodes at
+// \e depth_left == 0 as leaves. Inner octomap nodes hold the maximum occupancy of their children.
+template <typename BV>
+void addCoarseOcTreeNodes(const fcl::OcTreed& tree, const fcl::OcTreed::OcTreeNode* node, const BV& bv,
+                          unsigned int depth_left, octomap::OcTree& coarse)
+{
+  if (!tree.isNodeOccupied(node))
+    return;
+
+  if (depth_left > 0 && tree.nodeHasChildren(node))
+  {
+    for (unsigned int i = 0; i < 8; ++i)
+      if (tree.nodeChildExists(node, i))
+      {
+        BV child_bv;
+        fcl::computeChildBV(bv, i, child_bv);
+        addCoarseOcTreeNodes(tree, tree.getNodeChild(node, i), child_bv, depth_left - 1, coarse);
+      }
+    return;
+  }
+
+  // leaves above the coarse level span several coarse cells
+  const double resolution = coarse.getResolution();
+  const int cells = std::max(1, static_cast<int>(std::lround(bv.width() / resolution)));
+  const double first = -0.5 * (cells - 1) * resolution;
+  const float occupied = coarse.getClampingThresMaxLog();
+  for (int x = 0; x < cells; ++x)
+    for (int y = 0; y < cells; ++y)
+      for (int z = 0; z < cells; ++z)
+        coarse.setNodeValue(bv.center()[0] + first + x * resolution, bv.center()[1] + first + y * resolution,
+                            bv.center()[2] + first + z * resolution, occupied, true);
+}
+
+// Copy of an FCL octree whose leaves are the nodes \e levels levels below the root, occupied if any part is
+std::shared_ptr<fcl::OcTreed> buildCoarseOcTree(const fcl::OcTreed& tree, unsigned int levels)
+{
+  const auto root_bv = tree.getRootBV();
+  auto coarse = std::make_shared<octomap::OcTree>(root_bv.width() / (1 << levels));
+  if (tree.getRoot())
+    addCoarseOcTreeNodes(tree, tree.getRoot(), root_bv, levels, *coarse);
+  coarse->updateInnerOccupancy();
+  coarse->prune();
+  return std::make_shared<fcl::OcTreed>(std::shared_ptr<const octomap::OcTree>(coarse));
+}
+
+// Coarse versions of octree world objects, shared by all threads and collision environments
+class CoarseOcTreeCache
+{
+public:
+  // Get \e object with an octree geometry whose leaves are \e levels levels below the root. The returned object has
+  // the same pose and user data as \e object.
+  std::shared_ptr<const fcl::CollisionObjectd> get(const fcl::CollisionObjectd* object, unsigned int levels)
+  {
+    const std::shared_ptr<fcl::CollisionGeometryd>& geometry = object->collisionGeometry();
+    const Key key(geometry.get(), levels);
+    std::shared_ptr<fcl::OcTreed> coarse;
+    {
+      boost::shared_lock<boost::shared_mutex> lock(lock_);
+      auto it = entries_.find(key);
+      // the geometry may have been reallocated at the same address, or its user data changed
+      if (it != entries_.end() && it->second.source.lock() == geometry &&
+          it->second.coarse->getUserData() == geometry->getUserData())
+        coarse = it->second.coarse;
+    }
+
+    if (!coarse)
+    {
+      coarse = buildCoarseOcTree(static_cast<const fcl::OcTreed&>(*geometry), levels);
+      coarse->setUserData(geometry->getUserData());
+
+      boost::unique_lock<boost::shared_mutex> lock(lock_);
+      for (auto it = entries_.begin(); it != entries_.end();)
+        it = it->second.source.expired() ? entries_.erase(it) : std::next(it);
+      entries_[key] = Entry{ geometry, coarse };
+    }
+    // poses change more often than octomaps, so only the geometry is cached
+    return std::make_shared<fcl::CollisionObjectd>(coarse, object->getTransform());
+  }
+
+  // Remove the coarse versions of \e geometry
+  void erase(const fcl::CollisionGeometryd* geometry)
+  {
+    boost::unique_lock<boost::shared_mutex> lock(lock_);
+    entries_.erase(entries_.lower_bound(Key(geometry, 0)), entries_.upper_bound(Key(geometry, OCTOMAP_TREE_DEPTH)));
+  }
+
+private:
+  using Key = std::pair<const fcl::CollisionGeometryd*, unsigned int>;
+
+  struct Entry
+  {
+    std::weak_ptr<const fcl::CollisionGeometryd> source;
+    std::shared_ptr<fcl::OcTreed> coarse;
+  };
+
+  boost::shared_mutex lock_;
+  std::map<Key, Entry> entries_;
+};
+
+CoarseOcTreeCache& getCoarseOcTreeCache()
+{
+  static CoarseOcTreeCache cache;
+  return cache;
+}
+
+// Apply the octomap options of the request to \e object, which is checked against \e other: substitute a coarse
+// version of the octree if a minimum resolution is requested, and return false if the level-of-detail check shows
+// that the pair cannot collide. \e storage keeps a substituted object alive.
+bool applyOctomapResolution(const CollisionRequest& req, fcl::CollisionObjectd*& object,
+                            const fcl::CollisionObjectd* other,
+                            std::shared_ptr<const fcl::CollisionObjectd>& storage)
+{
+  if (object->getObjectType() != fcl::OT_OCTREE)
+    return true;
+  const fcl::OcTreed& tree = static_cast<const fcl::OcTreed&>(*object->collisionGeometry());
+  if (!tree.getRoot())
+    return true;
+
+  // levels from the root to nodes of at least the requested size
+  const double leaf_size = tree.getRootBV().width() / (1 << OCTOMAP_TREE_DEPTH);
+  unsigned int levels = OCTOMAP_TREE_DEPTH;
+  if (req.octomap_resolution > leaf_size)
+    levels -= std::min(OCTOMAP_TREE_DEPTH, static_cast<unsigned int>(std::ceil(
+                                               std::log2(req.octomap_resolution / leaf_size) - 1e-9)));
+
+  // costs take unknown space into account, which the coarse octrees do not represent
+  if (req.octomap_lod && !req.cost && levels > OCTOMAP_LOD_LEVELS)
+  {
+    std::shared_ptr<const fcl::CollisionObjectd> lod = getCoarseOcTreeCache().get(object, levels - OCTOMAP_LOD_LEVELS);
+    fcl::CollisionResultd result;
+    if (fcl::collide(lod.get(), other, fcl::CollisionRequestd(), result) == 0)
+      return false;
+  }
+
+  if (levels < OCTOMAP_TREE_DEPTH)
+  {
+    storage = getCoarseOcTreeCache().get(object, levels);
+    // FCL only reads the objects during the checks
+    object = const_cast<fcl::CollisionObjectd*>(storage.get());
+  }
+  return true;
+}
+}  // namespace
+
 bool collisionCallback(fcl::CollisionObjectd* o1, fcl::CollisionObjectd* o2, void* data)
 {
   CollisionData* cdata = reinterpret_cast<CollisionData*>(data);
@@ -149,6 +359,27 @@ bool collisionCallback(fcl::CollisionObjectd* o1, fcl::CollisionObjectd* o2, voi
   if (always_allow_collision)
     return false;
 
+  if (cdata->req_->bounding_sphere_filter && cdata->link_bounding_spheres_ &&
+      !boundingSpheresMayCollide(cdata, o1, cd1, o2, cd2))
+  {
+    if (cdata->req_->verbose)
+      ROS_DEBUG_NAMED("collision_detection.fcl", "Bounding spheres of %s and %s do not overlap", cd1->getID().c_str(),
+                      cd2->getID().c_str());
+    return false;
+  }
+
+  // octomaps may be checked at a coarser resolution, and against an even coarser version first
+  std::shared_ptr<const fcl::CollisionObjectd> coarse_o1, coarse_o2;
+  if ((cdata->req_->octomap_lod || cdata->req_->octomap_resolution > 0.0) &&
+      (!applyOctomapResolution(*cdata->req_, o1, o2, coarse_o1) ||
+       !applyOctomapResolution(*cdata->req_, o2, o1, coarse_o2)))
+  {
+    if (cdata->req_->verbose)
+      ROS_DEBUG_NAMED("collision_detection.fcl", "Coarse octomap check of %s and %s found no collision",
+                      cd1->getID().c_str(), cd2->getID().c_str());
+    return false;
+  }
+
   if (cdata->req_->verbose)
     ROS_DEBUG_NAMED("collision_detection.fcl", "Actually checking collisions between %s and %s", cd1->getID().c_str(),
                     cd2->getID().c_str());
@@ -180,7 +411,9 @@ bool collisionCallback(fcl::CollisionObjectd* o1, fcl::CollisionObjectd* o2, voi
     bool enable_cost = cdata->req_->cost;
     std::size_t num_max_cost_sources = cdata->req_->max_cost_sources;
     bool enable_contact = true;
-    fcl::CollisionResultd col_result;
+    fcl::CollisionResultd local_result;
+    fcl::CollisionResultd& col_result = cdata->fcl_result_ ? *cdata->fcl_result_ : local_result;
+    col_result.clear();
     int num_contacts = fcl::collide(o1, o2,
                                     fcl::CollisionRequestd(std::numeric_limits<size_t>::max(), enable_contact,
                                                            num_max_cost_sources, enable_cost),
@@ -250,7 +483,9 @@ bool collisionCallback(fcl::CollisionObjectd* o1, fcl::CollisionObjectd* o2, voi
       std::size_t num_max_cost_sources = cdata->req_->max_cost_sources;
       bool enable_contact = true;
 
-      fcl::CollisionResultd col_result;
+      fcl::CollisionResultd local_result;
+      fcl::CollisionResultd& col_result = cdata->fcl_result_ ? *cdata->fcl_result_ : local_result;
+      col_result.clear();
       int num_contacts =
           fcl::collide(o1, o2,
                        fcl::CollisionRequestd(want_contact_count, enable_contact, num_max_cost_sources, enable_cost),
@@ -308,7 +543,9 @@ bool collisionCallback(fcl::CollisionObjectd* o1, fcl::CollisionObjectd* o2, voi
       bool enable_cost = cdata->req_->cost;
       std::size_t num_max_cost_sources = cdata->req_->max_cost_sources;
       bool enable_contact = false;
-      fcl::CollisionResultd col_result;
+      fcl::CollisionResultd local_result;
+      fcl::CollisionResultd& col_result = cdata->fcl_result_ ? *cdata->fcl_result_ : local_result;
+      col_result.clear();
       int num_contacts = fcl::collide(
           o1, o2, fcl::CollisionRequestd(1, enable_contact, num_max_cost_sources, enable_cost), col_result);
       if (num_contacts > 0)
@@ -408,10 +645,30 @@ struct FCLShapeCache
   unsigned int clean_count_;
 };
 
-bool distanceCallback(fcl::CollisionObjectd* o1, fcl::CollisionObjectd* o2, void* data, double& /*min_dist*/)
+namespace
+{
+// Largest distance between two objects that can still change the result of the query
+double relevantDistance(const DistanceData* cdata)
+{
+  if (cdata->req->type == DistanceRequestType::GLOBAL)
+    return std::min(cdata->req->distance_threshold, cdata->res->minimum_distance.distance);
+  return cdata->req->distance_threshold;
+}
+
+// Bound for the broadphase. Overlapping bounding boxes are always visited, they may contain deeper penetrations
+double broadphaseDistance(const DistanceData* cdata)
+{
+  return std::max(0.0, relevantDistance(cdata));
+}
+}  // namespace
+
+bool distanceCallback(fcl::CollisionObjectd* o1, fcl::CollisionObjectd* o2, void* data, double& min_dist)
 {
   DistanceData* cdata = reinterpret_cast<DistanceData*>(data);
 
+  // the broadphase skips all pairs whose bounding boxes are farther apart than min_dist
+  min_dist = std::min(min_dist, broadphaseDistance(cdata));
+
   const CollisionGeometryData* cd1 = static_cast<const CollisionGeometryData*>(o1->collisionGeometry()->getUserData());
   const CollisionGeometryData* cd2 = static_cast<const CollisionGeometryData*>(o2->collisionGeometry()->getUserData());
 
@@ -504,7 +761,7 @@ bool distanceCallback(fcl::CollisionObjectd* o1, fcl::CollisionObjectd* o2, void
   // GLOBAL search: for efficiency, distance_threshold starts at the smallest distance between any pairs found so far
   if (cdata->req->type == DistanceRequestType::GLOBAL)
   {
-    dist_threshold = cdata->res->minimum_distance.distance;
+    dist_threshold = relevantDistance(cdata);
   }
   // Check if a distance between this pair has been found yet. Decrease threshold_distance if so, to narrow the search
   else if (it != cdata->res->distances.end())
@@ -623,6 +880,9 @@ bool distanceCallback(fcl::CollisionObjectd* o1, fcl::CollisionObjectd* o2, void
     if (dist_result.distance < cdata->res->minimum_distance.distance)
     {
       cdata->res->minimum_distance = dist_result;
+      cdata->closest_geometry[0] = fcl_result.o1;
+      cdata->closest_geometry[1] = fcl_result.o2;
+      min_dist = std::min(min_dist, broadphaseDistance(cdata));
     }
 
     if (dist_result.distance <= 0)
@@ -686,6 +946,34 @@ FCLShapeCache& GetShapeCache()
   return cache;
 }
 
+/** \brief Get the bounding volume hierarchy of the mesh \e shape, which is built once per distinct mesh and bounding
+ *  volume type and shared through the GeometryCache. */
+template <typename BV>
+std::shared_ptr<const fcl::BVHModel<BV>> getMeshBVH(const shapes::ShapeConstPtr& shape)
+{
+  return GeometryCache::getGlobal().getDerived<fcl::BVHModel<BV>>(
+      shape, std::string("fcl_bvh_") + typeid(BV).name(), [&shape]() {
+        auto g = std::make_shared<fcl::BVHModel<BV>>();
+        const shapes::Mesh* mesh = static_cast<const shapes::Mesh*>(shape.get());
+        if (mesh->vertex_count > 0 && mesh->triangle_count > 0)
+        {
+          std::vector<fcl::Triangle> tri_indices(mesh->triangle_count);
+          for (unsigned int i = 0; i < mesh->triangle_count; ++i)
+            tri_indices[i] =
+                fcl::Triangle(mesh->triangles[3 * i], mesh->triangles[3 * i + 1], mesh->triangles[3 * i + 2]);
+
+          std::vector<fcl::Vector3d> points(mesh->vertex_count);
+          for (unsigned int i = 0; i < mesh->vertex_count; ++i)
+            points[i] = fcl::Vector3d(mesh->vertices[3 * i], mesh->vertices[3 * i + 1], mesh->vertices[3 * i + 2]);
+
+          g->beginModel();
+          g->addSubModel(points, tri_indices);
+          g->endModel();
+        }
+        return std::shared_ptr<const fcl::BVHModel<BV>>(g);
+      });
+}
+
 /** \brief Templated helper function creating new collision geometry out of general object using an arbitrary bounding
  *  volume (BV).
  *
@@ -828,24 +1116,10 @@ FCLGeometryConstPtr createCollisionGeometry(const shapes::ShapeConstPtr& shape,
     break;
     case shapes::MESH:
     {
-      auto g = new fcl::BVHModel<BV>();
-      const shapes::Mesh* mesh = static_cast<const shapes::Mesh*>(shape.get());
-      if (mesh->vertex_count > 0 && mesh->triangle_count > 0)
-      {
-        std::vector<fcl::Triangle> tri_indices(mesh->triangle_count);
-        for (unsigned int i = 0; i < mesh->triangle_count; ++i)
-          tri_indices[i] =
-              fcl::Triangle(mesh->triangles[3 * i], mesh->triangles[3 * i + 1], mesh->triangles[3 * i + 2]);
-
-        std::vector<fcl::Vector3d> points(mesh->vertex_count);
-        for (unsigned int i = 0; i < mesh->vertex_count; ++i)
-          points[i] = fcl::Vector3d(mesh->vertices[3 * i], mesh->vertices[3 * i + 1], mesh->vertices[3 * i + 2]);
-
-        g->beginModel();
-        g->addSubModel(points, tri_indices);
-        g->endModel();
-      }
-      cg_g = g;
+      // the hierarchy is built once per distinct mesh; copying it is much cheaper than building it
+      std::shared_ptr<const fcl::BVHModel<BV>> prototype = getMeshBVH<BV>(shape);
+      // every object gets its own copy, since the geometry carries the collision data of the object
+      cg_g = new fcl::BVHModel<BV>(*prototype);
     }
     break;
     case shapes::OCTREE:
@@ -888,6 +1162,51 @@ FCLGeometryConstPtr createCollisionGeometry(const shapes::ShapeConstPtr& shape,
   return createCollisionGeometry<fcl::OBBRSSd, World::Object>(shape, obj, 0);
 }
 
+void prepareCollisionGeometry(const shapes::ShapeConstPtr& shape)
+{
+  if (shape && shape->type == shapes::MESH)
+    getMeshBVH<fcl::OBBRSSd>(shape);
+}
+
+FCLGeometryConstPtr createConvexCollisionGeometry(const shapes::ShapeConstPtr& shape, const World::Object* obj)
+{
+#if (MOVEIT_FCL_VERSION >= FCL_VERSION_CHECK(0, 6, 0))
+  struct ConvexData
+  {
+    std::shared_ptr<const std::vector<fcl::Vector3d>> vertices;
+    std::shared_ptr<const std::vector<int>> faces;
+    int num_faces;
+  };
+
+  // fcl::Convex shares its vertices and faces, so all objects with the same mesh use the same arrays
+  std::shared_ptr<const ConvexData> data =
+      GeometryCache::getGlobal().getDerived<ConvexData>(shape, "fcl_convex", [&shape]() {
+        const shapes::Mesh* mesh = static_cast<const shapes::Mesh*>(shape.get());
+        auto vertices = std::make_shared<std::vector<fcl::Vector3d>>(mesh->vertex_count);
+        for (unsigned int i = 0; i < mesh->vertex_count; ++i)
+          (*vertices)[i] = fcl::Vector3d(mesh->vertices[3 * i], mesh->vertices[3 * i + 1], mesh->vertices[3 * i + 2]);
+        auto faces = std::make_shared<std::vector<int>>();
+        faces->reserve(4 * mesh->triangle_count);
+        for (unsigned int i = 0; i < mesh->triangle_count; ++i)
+        {
+          faces->push_back(3);
+          faces->insert(faces->end(), mesh->triangles + 3 * i, mesh->triangles + 3 * i + 3);
+        }
+        auto result = std::make_shared<ConvexData>();
+        result->vertices = vertices;
+        result->faces = faces;
+        result->num_faces = mesh->triangle_count;
+        return std::shared_ptr<const ConvexData>(result);
+      });
+
+  auto cg_g = new fcl::Convexd(data->vertices, data->num_faces, data->faces);
+  cg_g->computeLocalAABB();
+  return FCLGeometryConstPtr(new FCLGeometry(cg_g, obj, 0));
+#else
+  return createCollisionGeometry(shape, obj);
+#endif
+}
+
 /** \brief Templated helper function creating new collision geometry out of general object using an arbitrary bounding
  *  volume (BV). This can include padding and scaling. */
 template <typename BV, typename T>
@@ -923,6 +1242,11 @@ FCLGeometryConstPtr createCollisionGeometry(const shapes::ShapeConstPtr& shape,
   return createCollisionGeometry<fcl::OBBRSSd, World::Object>(shape, scale, padding, obj, 0);
 }
 
+void clearCoarseOcTreeCache(const fcl::CollisionGeometryd* geometry)
+{
+  getCoarseOcTreeCache().erase(geometry);
+}
+
 void cleanCollisionGeometryCache()
 {
   FCLShapeCache& cache1 = GetShapeCache<fcl::OBBRSSd, World::Object>();
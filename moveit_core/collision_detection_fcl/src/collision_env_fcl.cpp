@@ -39,16 +39,28 @@
 #include <moveit/collision_detection_fcl/collision_common.h>
 
 #include <moveit/collision_detection_fcl/fcl_compat.h>
+#include <moveit/profiler/trace.h>
 
 #if (MOVEIT_FCL_VERSION >= FCL_VERSION_CHECK(0, 6, 0))
 #include <fcl/broadphase/broadphase_dynamic_AABB_tree.h>
 #endif
 
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <limits>
+#include <thread>
+
 namespace collision_detection
 {
 static const std::string NAME = "FCL";
 constexpr char LOGNAME[] = "collision_detection.fcl";
 
+// below this clearance the continuous check reports a collision
+constexpr double CCD_DISTANCE_TOLERANCE = 1e-4;
+// the continuous check gives up and reports a collision after this many conservative advancement steps
+constexpr unsigned int CCD_MAX_ITERATIONS = 10000;
+
 namespace
 {
 // Check whether this FCL version supports the requested computations
@@ -71,8 +83,30 @@ void checkFCLCapabilities(const DistanceRequest& req)
   (void)(req);  // silent -Wunused-parameter
 #endif
 }
+
+// Largest distance of a point of \e geometry, placed at \e pose, from the origin
+double geometryRadius(const fcl::CollisionGeometryd& geometry, const Eigen::Isometry3d& pose)
+{
+  const Eigen::Vector3d center(geometry.aabb_center[0], geometry.aabb_center[1], geometry.aabb_center[2]);
+  return (pose * center).norm() + geometry.aabb_radius;
+}
+
+std::size_t newRobotGeometryId()
+{
+  static std::atomic<std::size_t> next_id(1);
+  return next_id++;
+}
+
+/** \brief Number of robot geometries a query context keeps a broadphase for */
+constexpr std::size_t ROBOT_BROADPHASE_CACHE_SIZE = 4;
 }  // namespace
 
+CollisionQueryContext& CollisionQueryContext::getThreadLocal()
+{
+  static thread_local CollisionQueryContext context;
+  return context;
+}
+
 CollisionEnvFCL::CollisionEnvFCL(const moveit::core::RobotModelConstPtr& model, double padding, double scale)
   : CollisionEnv(model, padding, scale)
 {
@@ -80,6 +114,7 @@ CollisionEnvFCL::CollisionEnvFCL(const moveit::core::RobotModelConstPtr& model,
   std::size_t index;
   robot_geoms_.resize(robot_model_->getLinkGeometryCount());
   robot_fcl_objs_.resize(robot_model_->getLinkGeometryCount());
+  robot_bounding_spheres_.resize(robot_model_->getLinkGeometryCount());
   // we keep the same order of objects as what RobotState *::getLinkState() returns
   for (auto link : links)
     for (std::size_t j = 0; j < link->getShapes().size(); ++j)
@@ -90,6 +125,8 @@ CollisionEnvFCL::CollisionEnvFCL(const moveit::core::RobotModelConstPtr& model,
       {
         index = link->getFirstCollisionBodyTransformIndex() + j;
         robot_geoms_[index] = link_geometry;
+        getLinkShapeBoundingSpheres(link, j, getLinkScale(link->getName()), getLinkPadding(link->getName()),
+                                    robot_bounding_spheres_[index]);
 
         // Need to store the FCL object so the AABB does not get recreated every time.
         // Every time this object is created, g->computeLocalAABB() is called  which is
@@ -103,6 +140,7 @@ CollisionEnvFCL::CollisionEnvFCL(const moveit::core::RobotModelConstPtr& model,
     }
 
   manager_ = std::make_unique<fcl::DynamicAABBTreeCollisionManagerd>();
+  robot_geometry_id_ = newRobotGeometryId();
 
   // request notifications about changes to new world
   observer_handle_ = getWorld()->addObserver(
@@ -117,6 +155,7 @@ CollisionEnvFCL::CollisionEnvFCL(const moveit::core::RobotModelConstPtr& model,
   std::size_t index;
   robot_geoms_.resize(robot_model_->getLinkGeometryCount());
   robot_fcl_objs_.resize(robot_model_->getLinkGeometryCount());
+  robot_bounding_spheres_.resize(robot_model_->getLinkGeometryCount());
   // we keep the same order of objects as what RobotState *::getLinkState() returns
   for (auto link : links)
     for (std::size_t j = 0; j < link->getShapes().size(); ++j)
@@ -127,6 +166,8 @@ CollisionEnvFCL::CollisionEnvFCL(const moveit::core::RobotModelConstPtr& model,
       {
         index = link->getFirstCollisionBodyTransformIndex() + j;
         robot_geoms_[index] = g;
+        getLinkShapeBoundingSpheres(link, j, getLinkScale(link->getName()), getLinkPadding(link->getName()),
+                                    robot_bounding_spheres_[index]);
 
         // Need to store the FCL object so the AABB does not get recreated every time.
         // Every time this object is created, g->computeLocalAABB() is called  which is
@@ -139,6 +180,7 @@ CollisionEnvFCL::CollisionEnvFCL(const moveit::core::RobotModelConstPtr& model,
     }
 
   manager_ = std::make_unique<fcl::DynamicAABBTreeCollisionManagerd>();
+  robot_geometry_id_ = newRobotGeometryId();
 
   // request notifications about changes to new world
   observer_handle_ = getWorld()->addObserver(
@@ -155,6 +197,8 @@ CollisionEnvFCL::CollisionEnvFCL(const CollisionEnvFCL& other, const WorldPtr& w
 {
   robot_geoms_ = other.robot_geoms_;
   robot_fcl_objs_ = other.robot_fcl_objs_;
+  robot_bounding_spheres_ = other.robot_bounding_spheres_;
+  robot_geometry_id_ = other.robot_geometry_id_;
 
   manager_ = std::make_unique<fcl::DynamicAABBTreeCollisionManagerd>();
 
@@ -185,12 +229,17 @@ void CollisionEnvFCL::getAttachedBodyObjects(const moveit::core::AttachedBody* a
 
 void CollisionEnvFCL::constructFCLObjectWorld(const World::Object* obj, FCLObject& fcl_obj) const
 {
-  for (std::size_t i = 0; i < obj->shapes_.size(); ++i)
+  std::vector<shapes::ShapeConstPtr> shapes;
+  EigenSTL::vector_Isometry3d poses;
+  std::vector<bool> convex;
+  getWorldObjectCollisionShapes(*obj, shapes, poses, convex);
+  for (std::size_t i = 0; i < shapes.size(); ++i)
   {
-    FCLGeometryConstPtr g = createCollisionGeometry(obj->shapes_[i], obj);
+    FCLGeometryConstPtr g =
+        convex[i] ? createConvexCollisionGeometry(shapes[i], obj) : createCollisionGeometry(shapes[i], obj);
     if (g)
     {
-      auto co = new fcl::CollisionObjectd(g->collision_geometry_, transform2fcl(obj->global_shape_poses_[i]));
+      auto co = new fcl::CollisionObjectd(g->collision_geometry_, transform2fcl(poses[i]));
       fcl_obj.collision_objects_.push_back(FCLCollisionObjectPtr(co));
       fcl_obj.collision_geometry_.push_back(g);
     }
@@ -243,26 +292,144 @@ void CollisionEnvFCL::allocSelfCollisionBroadPhase(const moveit::core::RobotStat
   manager.object_.registerTo(manager.manager_.get());
 }
 
+FCLManager& CollisionEnvFCL::getRobotBroadPhase(const moveit::core::RobotState& state, bool update_manager,
+                                                CollisionQueryContext& context) const
+{
+  std::list<CollisionQueryContext::RobotBroadPhase>& broadphases = context.robot_broadphases;
+  auto it = broadphases.begin();
+  while (it != broadphases.end() && it->geometry_id != robot_geometry_id_)
+    ++it;
+
+  if (it != broadphases.end())
+    broadphases.splice(broadphases.begin(), broadphases, it);
+  else
+  {
+    // first query of this context for this robot geometry: copy the link objects
+    broadphases.emplace_front();
+    if (broadphases.size() > ROBOT_BROADPHASE_CACHE_SIZE)
+      broadphases.pop_back();
+
+    CollisionQueryContext::RobotBroadPhase& broadphase = broadphases.front();
+    broadphase.geometry_id = robot_geometry_id_;
+    broadphase.links_registered = false;
+    broadphase.attached_registered = false;
+    broadphase.manager.manager_ = std::make_shared<fcl::DynamicAABBTreeCollisionManagerd>();
+    FCLObject& object = broadphase.manager.object_;
+    for (std::size_t i = 0; i < robot_geoms_.size(); ++i)
+      if (robot_geoms_[i] && robot_geoms_[i]->collision_geometry_)
+      {
+        object.collision_objects_.push_back(std::make_shared<fcl::CollisionObjectd>(*robot_fcl_objs_[i]));
+        // keeps the geometry data referenced by the objects alive
+        object.collision_geometry_.push_back(robot_geoms_[i]);
+      }
+    broadphase.link_object_count = object.collision_objects_.size();
+  }
+
+  CollisionQueryContext::RobotBroadPhase& broadphase = broadphases.front();
+  FCLObject& object = broadphase.manager.object_;
+  fcl::BroadPhaseCollisionManagerd* manager = broadphase.manager.manager_.get();
+
+  // keep the attached body objects of the previous query if the bodies and their shapes did not change
+  std::vector<const moveit::core::AttachedBody*> ab;
+  state.getAttachedBodies(ab);
+  bool same_attached_bodies = ab.size() == broadphase.attached_bodies.size();
+  for (std::size_t i = 0; same_attached_bodies && i < ab.size(); ++i)
+    same_attached_bodies =
+        ab[i] == broadphase.attached_bodies[i].first && ab[i]->getShapes() == broadphase.attached_bodies[i].second;
+
+  if (!same_attached_bodies)
+  {
+    // remove the attached bodies of the previous query
+    if (broadphase.attached_registered)
+      for (std::size_t i = broadphase.link_object_count; i < object.collision_objects_.size(); ++i)
+        manager->unregisterObject(object.collision_objects_[i].get());
+    object.collision_objects_.resize(broadphase.link_object_count);
+    object.collision_geometry_.resize(broadphase.link_object_count);
+    broadphase.attached_registered = false;
+    broadphase.attached_bodies.clear();
+    broadphase.attached_object_shapes.clear();
+
+    // add the attached bodies of this state; their transforms are set below
+    for (std::size_t i = 0; i < ab.size(); ++i)
+    {
+      broadphase.attached_bodies.emplace_back(ab[i], ab[i]->getShapes());
+      std::vector<FCLGeometryConstPtr> objs;
+      getAttachedBodyObjects(ab[i], objs);
+      for (const FCLGeometryConstPtr& obj : objs)
+        if (obj->collision_geometry_)
+        {
+          object.collision_objects_.push_back(std::make_shared<fcl::CollisionObjectd>(obj->collision_geometry_));
+          object.collision_geometry_.push_back(obj);
+          broadphase.attached_object_shapes.emplace_back(i, obj->collision_geometry_data_->shape_index);
+        }
+    }
+  }
+
+  // move the link objects
+  fcl::Transform3d fcl_tf;
+  for (std::size_t i = 0; i < broadphase.link_object_count; ++i)
+  {
+    fcl::CollisionObjectd* collision_object = object.collision_objects_[i].get();
+    const CollisionGeometryData* data =
+        static_cast<const CollisionGeometryData*>(collision_object->collisionGeometry()->getUserData());
+    transform2fcl(state.getCollisionBodyTransform(data->ptr.link, data->shape_index), fcl_tf);
+    collision_object->setTransform(fcl_tf);
+    collision_object->computeAABB();
+  }
+
+  // move the attached body objects
+  for (std::size_t i = 0; i < broadphase.attached_object_shapes.size(); ++i)
+  {
+    const std::pair<std::size_t, std::size_t>& shape = broadphase.attached_object_shapes[i];
+    transform2fcl(ab[shape.first]->getGlobalCollisionBodyTransforms()[shape.second], fcl_tf);
+    fcl::CollisionObjectd* collision_object = object.collision_objects_[broadphase.link_object_count + i].get();
+    collision_object->setTransform(fcl_tf);
+    collision_object->computeAABB();
+  }
+
+  if (update_manager)
+  {
+    if (!broadphase.links_registered)
+    {
+      // build the broadphase once
+      object.registerTo(manager);
+      broadphase.links_registered = true;
+    }
+    else
+    {
+      if (!broadphase.attached_registered)
+        for (std::size_t i = broadphase.link_object_count; i < object.collision_objects_.size(); ++i)
+          manager->registerObject(object.collision_objects_[i].get());
+      // refit the tree to the new AABBs instead of building it again
+      manager->update();
+    }
+    broadphase.attached_registered = true;
+  }
+  return broadphase.manager;
+}
+
 void CollisionEnvFCL::checkSelfCollision(const CollisionRequest& req, CollisionResult& res,
                                          const moveit::core::RobotState& state) const
 {
-  checkSelfCollisionHelper(req, res, state, nullptr);
+  checkSelfCollisionHelper(req, res, state, nullptr, CollisionQueryContext::getThreadLocal());
 }
 
 void CollisionEnvFCL::checkSelfCollision(const CollisionRequest& req, CollisionResult& res,
                                          const moveit::core::RobotState& state, const AllowedCollisionMatrix& acm) const
 {
-  checkSelfCollisionHelper(req, res, state, &acm);
+  checkSelfCollisionHelper(req, res, state, &acm, CollisionQueryContext::getThreadLocal());
 }
 
 void CollisionEnvFCL::checkSelfCollisionHelper(const CollisionRequest& req, CollisionResult& res,
                                                const moveit::core::RobotState& state,
-                                               const AllowedCollisionMatrix* acm) const
+                                               const AllowedCollisionMatrix* acm, CollisionQueryContext& context) const
 {
-  FCLManager manager;
-  allocSelfCollisionBroadPhase(state, manager);
+  MOVEIT_TRACE_ZONE("CollisionEnvFCL::checkSelfCollision");
+  FCLManager& manager = getRobotBroadPhase(state, true, context);
   CollisionData cd(&req, &res, acm);
   cd.enableGroup(getRobotModel());
+  cd.fcl_result_ = &context.fcl_result;
+  cd.link_bounding_spheres_ = &robot_bounding_spheres_;
   manager.manager_->collide(&cd, &collisionCallback);
   if (req.distance)
   {
@@ -280,40 +447,184 @@ void CollisionEnvFCL::checkSelfCollisionHelper(const CollisionRequest& req, Coll
 void CollisionEnvFCL::checkRobotCollision(const CollisionRequest& req, CollisionResult& res,
                                           const moveit::core::RobotState& state) const
 {
-  checkRobotCollisionHelper(req, res, state, nullptr);
+  checkRobotCollisionHelper(req, res, state, nullptr, CollisionQueryContext::getThreadLocal());
 }
 
 void CollisionEnvFCL::checkRobotCollision(const CollisionRequest& req, CollisionResult& res,
                                           const moveit::core::RobotState& state,
                                           const AllowedCollisionMatrix& acm) const
 {
-  checkRobotCollisionHelper(req, res, state, &acm);
+  checkRobotCollisionHelper(req, res, state, &acm, CollisionQueryContext::getThreadLocal());
 }
 
-void CollisionEnvFCL::checkRobotCollision(const CollisionRequest& /*req*/, CollisionResult& /*res*/,
-                                          const moveit::core::RobotState& /*state1*/,
-                                          const moveit::core::RobotState& /*state2*/) const
+void CollisionEnvFCL::checkRobotCollision(const CollisionRequest& req, CollisionResult& res,
+                                          const moveit::core::RobotState& state1,
+                                          const moveit::core::RobotState& state2) const
 {
-  ROS_ERROR_NAMED(LOGNAME, "Continuous collision not implemented");
+  checkRobotCollisionHelperCCD(req, res, state1, state2, nullptr);
 }
 
-void CollisionEnvFCL::checkRobotCollision(const CollisionRequest& /*req*/, CollisionResult& /*res*/,
-                                          const moveit::core::RobotState& /*state1*/,
-                                          const moveit::core::RobotState& /*state2*/,
-                                          const AllowedCollisionMatrix& /*acm*/) const
+void CollisionEnvFCL::checkRobotCollision(const CollisionRequest& req, CollisionResult& res,
+                                          const moveit::core::RobotState& state1,
+                                          const moveit::core::RobotState& state2,
+                                          const AllowedCollisionMatrix& acm) const
 {
-  ROS_ERROR_NAMED(LOGNAME, "Not implemented");
+  checkRobotCollisionHelperCCD(req, res, state1, state2, &acm);
+}
+
+void CollisionEnvFCL::checkRobotCollisionHelperCCD(const CollisionRequest& req, CollisionResult& res,
+                                                   const moveit::core::RobotState& state1,
+                                                   const moveit::core::RobotState& state2,
+                                                   const AllowedCollisionMatrix* acm) const
+{
+  const double bound = getMotionBound(state1, state2);
+  if (!std::isfinite(bound))
+  {
+    ROS_ERROR_NAMED(LOGNAME, "Unable to bound the robot motion between the two states, reporting a collision");
+    res.collision = true;
+    return;
+  }
+
+  DistanceRequest dreq;
+  dreq.group_name = req.group_name;
+  dreq.acm = acm;
+  dreq.enableGroup(getRobotModel());
+
+  moveit::core::RobotState state(state1);
+  double t = 0.0;
+  for (unsigned int i = 0; i < CCD_MAX_ITERATIONS; ++i)
+  {
+    if (i > 0)
+    {
+      state1.interpolate(state2, t, state);
+      state.updateCollisionBodyTransforms();
+    }
+
+    DistanceResult dres;
+    distanceRobot(dreq, dres, state);
+    const double clearance = dres.minimum_distance.distance;
+    if (clearance <= CCD_DISTANCE_TOLERANCE)
+    {
+      if (req.verbose)
+        ROS_INFO_NAMED(LOGNAME, "Continuous collision at fraction %f of the segment", t);
+      checkRobotCollisionHelper(req, res, state, acm, CollisionQueryContext::getThreadLocal());
+      res.collision = true;
+      return;
+    }
+
+    // no point of the robot travels farther than the clearance over the rest of the segment
+    if (bound * (1.0 - t) <= clearance)
+      return;
+    t += clearance / bound;
+  }
+
+  ROS_WARN_NAMED(LOGNAME, "Continuous collision check did not converge within %u steps, reporting a collision",
+                 CCD_MAX_ITERATIONS);
+  res.collision = true;
+}
+
+double CollisionEnvFCL::getMotionBound(const moveit::core::RobotState& state1,
+                                       const moveit::core::RobotState& state2) const
+{
+  // largest distance of the geometry of each link from the link frame
+  std::vector<double> radius(robot_model_->getLinkModelCount(), -1.0);
+  for (const FCLGeometryConstPtr& geom : robot_geoms_)
+    if (geom && geom->collision_geometry_)
+    {
+      const moveit::core::LinkModel* link = geom->collision_geometry_data_->ptr.link;
+      const int shape_index = geom->collision_geometry_data_->shape_index;
+      double& r = radius[link->getLinkIndex()];
+      r = std::max(r, geometryRadius(*geom->collision_geometry_, link->getCollisionOriginTransforms()[shape_index]));
+    }
+
+  std::vector<const moveit::core::AttachedBody*> attached_bodies;
+  state1.getAttachedBodies(attached_bodies);
+  for (const moveit::core::AttachedBody* body : attached_bodies)
+  {
+    std::vector<FCLGeometryConstPtr> geoms;
+    getAttachedBodyObjects(body, geoms);
+    for (const FCLGeometryConstPtr& geom : geoms)
+    {
+      const Eigen::Isometry3d& pose = body->getShapePosesInLinkFrame()[geom->collision_geometry_data_->shape_index];
+      double& r = radius[body->getAttachedLink()->getLinkIndex()];
+      r = std::max(r, geometryRadius(*geom->collision_geometry_, pose));
+    }
+  }
+
+  double bound = 0.0;
+  for (const moveit::core::LinkModel* link : robot_model_->getLinkModels())
+  {
+    if (radius[link->getLinkIndex()] < 0.0)
+      continue;
+
+    // walk towards the root, accumulating the motion of each joint at the largest lever arm it can have
+    double lever = radius[link->getLinkIndex()];
+    double motion = 0.0;
+    for (const moveit::core::LinkModel* l = link; l && l->getParentJointModel(); l = l->getParentLinkModel())
+    {
+      const moveit::core::JointModel* joint = l->getParentJointModel();
+      const double* p1 = state1.getJointPositions(joint);
+      const double* p2 = state2.getJointPositions(joint);
+      double translation = 0.0;
+      double rotation = 0.0;
+      switch (joint->getType())
+      {
+        case moveit::core::JointModel::REVOLUTE:
+          rotation = joint->distance(p1, p2);
+          break;
+        case moveit::core::JointModel::PRISMATIC:
+          translation = joint->distance(p1, p2);
+          break;
+        case moveit::core::JointModel::PLANAR:
+          translation = std::hypot(p2[0] - p1[0], p2[1] - p1[1]);
+          rotation = std::fabs(std::remainder(p2[2] - p1[2], 2.0 * M_PI));
+          break;
+        case moveit::core::JointModel::FLOATING:
+          translation = (Eigen::Vector3d(p2[0], p2[1], p2[2]) - Eigen::Vector3d(p1[0], p1[1], p1[2])).norm();
+          rotation = Eigen::Quaterniond(p1[6], p1[3], p1[4], p1[5])
+                         .normalized()
+                         .angularDistance(Eigen::Quaterniond(p2[6], p2[3], p2[4], p2[5]).normalized());
+          break;
+        default:
+          break;
+      }
+      if (translation > 0.0 || rotation > 0.0)
+      {
+        if (!std::isfinite(lever))
+          return std::numeric_limits<double>::infinity();
+        motion += translation + rotation * lever;
+      }
+
+      // the frame of the next joint up is offset by the joint origin and by how far this joint can translate
+      lever += l->getJointOriginTransform().translation().norm();
+      if (joint->getType() != moveit::core::JointModel::REVOLUTE && joint->getType() != moveit::core::JointModel::FIXED)
+      {
+        double extent = 0.0;
+        for (const moveit::core::VariableBounds& b : joint->getVariableBounds())
+          if (b.position_bounded_)
+            extent += std::max(std::fabs(b.min_position_), std::fabs(b.max_position_));
+          else
+            extent = std::numeric_limits<double>::infinity();
+        lever += extent;
+      }
+    }
+    bound = std::max(bound, motion);
+  }
+  return bound;
 }
 
 void CollisionEnvFCL::checkRobotCollisionHelper(const CollisionRequest& req, CollisionResult& res,
                                                 const moveit::core::RobotState& state,
-                                                const AllowedCollisionMatrix* acm) const
+                                                const AllowedCollisionMatrix* acm,
+                                                CollisionQueryContext& context) const
 {
-  FCLObject fcl_obj;
-  constructFCLObjectRobot(state, fcl_obj);
+  MOVEIT_TRACE_ZONE("CollisionEnvFCL::checkRobotCollision");
+  const FCLObject& fcl_obj = getRobotBroadPhase(state, false, context).object_;
 
   CollisionData cd(&req, &res, acm);
   cd.enableGroup(getRobotModel());
+  cd.fcl_result_ = &context.fcl_result;
+  cd.link_bounding_spheres_ = &robot_bounding_spheres_;
   for (std::size_t i = 0; !cd.done_ && i < fcl_obj.collision_objects_.size(); ++i)
     manager_->collide(fcl_obj.collision_objects_[i].get(), &cd, &collisionCallback);
 
@@ -330,16 +641,60 @@ void CollisionEnvFCL::checkRobotCollisionHelper(const CollisionRequest& req, Col
   }
 }
 
+bool CollisionEnvFCL::isSelfColliding(const moveit::core::RobotState& state, const AllowedCollisionMatrix& acm,
+                                      const std::string& group_name) const
+{
+  return isSelfColliding(state, acm, group_name, CollisionQueryContext::getThreadLocal());
+}
+
+bool CollisionEnvFCL::isSelfColliding(const moveit::core::RobotState& state, const AllowedCollisionMatrix& acm,
+                                      const std::string& group_name, CollisionQueryContext& context) const
+{
+  // the default request only asks for a yes/no answer, so the contact map of the result is never touched
+  context.binary_request.group_name = group_name;
+  context.binary_result.clear();
+  checkSelfCollisionHelper(context.binary_request, context.binary_result, state, &acm, context);
+  return context.binary_result.collision;
+}
+
+bool CollisionEnvFCL::isRobotColliding(const moveit::core::RobotState& state, const AllowedCollisionMatrix& acm,
+                                       const std::string& group_name) const
+{
+  return isRobotColliding(state, acm, group_name, CollisionQueryContext::getThreadLocal());
+}
+
+bool CollisionEnvFCL::isRobotColliding(const moveit::core::RobotState& state, const AllowedCollisionMatrix& acm,
+                                       const std::string& group_name, CollisionQueryContext& context) const
+{
+  context.binary_request.group_name = group_name;
+  context.binary_result.clear();
+  checkRobotCollisionHelper(context.binary_request, context.binary_result, state, &acm, context);
+  return context.binary_result.collision;
+}
+
 void CollisionEnvFCL::distanceSelf(const DistanceRequest& req, DistanceResult& res,
                                    const moveit::core::RobotState& state) const
 {
   checkFCLCapabilities(req);
 
-  FCLManager manager;
-  allocSelfCollisionBroadPhase(state, manager);
+  CollisionQueryContext& context = CollisionQueryContext::getThreadLocal();
+  FCLManager& manager = getRobotBroadPhase(state, true, context);
   DistanceData drd(&req, &res);
 
+  const bool global = req.type == DistanceRequestType::GLOBAL;
+  if (global)
+  {
+    fcl::CollisionObjectd* o1 = findCollisionObject(context.closest_self_pair[0], manager.object_, false);
+    fcl::CollisionObjectd* o2 = findCollisionObject(context.closest_self_pair[1], manager.object_, false);
+    double min_dist = std::numeric_limits<double>::max();
+    if (o1 && o2)
+      distanceCallback(o1, o2, &drd, min_dist);
+  }
+
   manager.manager_->distance(&drd, &distanceCallback);
+
+  if (global)
+    std::copy(drd.closest_geometry, drd.closest_geometry + 2, context.closest_self_pair);
 }
 
 void CollisionEnvFCL::distanceRobot(const DistanceRequest& req, DistanceResult& res,
@@ -347,12 +702,108 @@ void CollisionEnvFCL::distanceRobot(const DistanceRequest& req, DistanceResult&
 {
   checkFCLCapabilities(req);
 
-  FCLObject fcl_obj;
-  constructFCLObjectRobot(state, fcl_obj);
+  CollisionQueryContext& context = CollisionQueryContext::getThreadLocal();
+  const FCLObject& fcl_obj = getRobotBroadPhase(state, false, context).object_;
+  const std::vector<FCLCollisionObjectPtr>& objects = fcl_obj.collision_objects_;
 
   DistanceData drd(&req, &res);
-  for (std::size_t i = 0; !drd.done && i < fcl_obj.collision_objects_.size(); ++i)
-    manager_->distance(fcl_obj.collision_objects_[i].get(), &drd, &distanceCallback);
+  const bool global = req.type == DistanceRequestType::GLOBAL;
+  if (global)
+  {
+    // the cached pair has one robot and one world object, in either order
+    const fcl::CollisionGeometryd* const* pair = context.closest_robot_pair;
+    fcl::CollisionObjectd* robot = findCollisionObject(pair[0], fcl_obj, false);
+    fcl::CollisionObjectd* world = findCollisionObject(pair[1], fcl_obj, true);
+    if (!robot || !world)
+    {
+      robot = findCollisionObject(pair[1], fcl_obj, false);
+      world = findCollisionObject(pair[0], fcl_obj, true);
+    }
+    double min_dist = std::numeric_limits<double>::max();
+    if (robot && world && robot != world)
+      distanceCallback(robot, world, &drd, min_dist);
+  }
+
+  const unsigned int threads = std::max(1u, std::min<unsigned int>(req.threads, objects.size()));
+  if (threads == 1)
+  {
+    for (std::size_t i = 0; !drd.done && i < objects.size(); ++i)
+      manager_->distance(objects[i].get(), &drd, &distanceCallback);
+  }
+  else
+  {
+    // every thread handles every threads-th robot object and collects its own result, starting from the seeded one
+    std::vector<DistanceResult> results(threads);
+    std::vector<DistanceData> data;
+    data.reserve(threads);
+    for (unsigned int t = 0; t < threads; ++t)
+    {
+      results[t].minimum_distance = res.minimum_distance;
+      data.emplace_back(&req, &results[t]);
+      data.back().done = drd.done;
+    }
+    auto work = [&](unsigned int t) {
+      for (std::size_t i = t; !data[t].done && i < objects.size(); i += threads)
+        manager_->distance(objects[i].get(), &data[t], &distanceCallback);
+    };
+    std::vector<std::thread> workers;
+    workers.reserve(threads - 1);
+    for (unsigned int t = 1; t < threads; ++t)
+      workers.emplace_back(work, t);
+    work(0);
+    for (std::thread& worker : workers)
+      worker.join();
+
+    for (unsigned int t = 0; t < threads; ++t)
+    {
+      res.collision |= results[t].collision;
+      if (results[t].minimum_distance.distance < res.minimum_distance.distance)
+      {
+        res.minimum_distance = results[t].minimum_distance;
+        std::copy(data[t].closest_geometry, data[t].closest_geometry + 2, drd.closest_geometry);
+      }
+      for (std::pair<const std::pair<std::string, std::string>, std::vector<DistanceResultsData>>& entry :
+           results[t].distances)
+      {
+        std::vector<DistanceResultsData>& merged = res.distances[entry.first];
+        if (merged.empty())
+          merged.swap(entry.second);
+        else if (req.type == DistanceRequestType::SINGLE)
+        {
+          if (entry.second[0].distance < merged[0].distance)
+            merged[0] = entry.second[0];
+        }
+        else
+        {
+          for (const DistanceResultsData& d : entry.second)
+            if (req.type == DistanceRequestType::ALL || merged.size() < req.max_contacts_per_body)
+              merged.push_back(d);
+        }
+      }
+    }
+  }
+
+  if (global)
+    std::copy(drd.closest_geometry, drd.closest_geometry + 2, context.closest_robot_pair);
+}
+
+fcl::CollisionObjectd* CollisionEnvFCL::findCollisionObject(const fcl::CollisionGeometryd* geometry,
+                                                            const FCLObject& robot, bool world) const
+{
+  if (!geometry)
+    return nullptr;
+  if (!world)
+  {
+    for (const FCLCollisionObjectPtr& object : robot.collision_objects_)
+      if (object->collisionGeometry().get() == geometry)
+        return object.get();
+    return nullptr;
+  }
+  for (const std::pair<const std::string, FCLObject>& object : fcl_objs_)
+    for (const FCLCollisionObjectPtr& o : object.second.collision_objects_)
+      if (o->collisionGeometry().get() == geometry)
+        return o.get();
+  return nullptr;
 }
 
 void CollisionEnvFCL::updateFCLObject(const std::string& id)
@@ -428,6 +879,12 @@ void CollisionEnvFCL::notifyObjectChange(const ObjectConstPtr& obj, World::Actio
   }
   else
   {
+    // FCL octrees read the octomap directly, but coarse versions of a modified octree need to be rebuilt
+    auto it = fcl_objs_.find(obj->id_);
+    if ((action & World::UPDATE_SHAPE) && it != fcl_objs_.end())
+      for (const FCLGeometryConstPtr& geometry : it->second.collision_geometry_)
+        if (geometry->collision_geometry_->getObjectType() == fcl::OT_OCTREE)
+          clearCoarseOcTreeCache(geometry->collision_geometry_.get());
     updateFCLObject(obj->id_);
     if (action & (World::DESTROY | World::REMOVE_SHAPE))
       cleanCollisionGeometryCache();
@@ -450,6 +907,8 @@ void CollisionEnvFCL::updatedPaddingOrScaling(const std::vector<std::string>& li
         {
           index = lmodel->getFirstCollisionBodyTransformIndex() + j;
           robot_geoms_[index] = g;
+          getLinkShapeBoundingSpheres(lmodel, j, getLinkScale(lmodel->getName()), getLinkPadding(lmodel->getName()),
+                                      robot_bounding_spheres_[index]);
           robot_fcl_objs_[index] = FCLCollisionObjectConstPtr(new fcl::CollisionObjectd(g->collision_geometry_));
         }
       }
@@ -457,6 +916,23 @@ void CollisionEnvFCL::updatedPaddingOrScaling(const std::vector<std::string>& li
     else
       ROS_ERROR_NAMED(LOGNAME, "Updating padding or scaling for unknown link: '%s'", link.c_str());
   }
+  // the broadphases of the old geometry must not be reused
+  robot_geometry_id_ = newRobotGeometryId();
+}
+
+void CollisionEnvFCL::updatedConvexDecomposition()
+{
+  for (const auto& object : *getWorld())
+    updateFCLObject(object.first);
+}
+
+void CollisionEnvFCL::prepareWorldShapes(const std::vector<shapes::ShapeConstPtr>& shapes) const
+{
+  CollisionEnv::prepareWorldShapes(shapes);
+  // meshes replaced by their convex parts do not need a hierarchy
+  if (!getConvexDecomposition())
+    for (const shapes::ShapeConstPtr& shape : shapes)
+      prepareCollisionGeometry(shape);
 }
 
 const std::string& CollisionDetectorAllocatorFCL::getName() const
@@ -48,6 +48,7 @@
 
 #include <urdf_parser/urdf_parser.h>
 #include <geometric_shapes/shape_operations.h>
+#include <octomap/octomap.h>
 
 /** \brief Brings the panda robot in user defined home position */
 inline void setToHome(moveit::core::RobotState& panda_state)
@@ -222,6 +223,256 @@ TEST_F(CollisionDetectionEnvTest, PaddingTest)
   ASSERT_FALSE(res.collision);
 }
 
+/** \brief Repeated self collision checks reuse the broadphase of the robot, which has to follow the state. */
+TEST_F(CollisionDetectionEnvTest, RepeatedSelfCollision)
+{
+  moveit::core::RobotState colliding(robot_model_);
+  colliding.setToDefaultValues();
+  colliding.update();
+
+  collision_detection::CollisionRequest req;
+  collision_detection::CollisionResult res;
+  for (int i = 0; i < 3; ++i)
+  {
+    c_env_->checkSelfCollision(req, res, colliding, *acm_);
+    EXPECT_TRUE(res.collision);
+    res.clear();
+    c_env_->checkSelfCollision(req, res, *robot_state_, *acm_);
+    EXPECT_FALSE(res.collision);
+    res.clear();
+  }
+
+  // an attached body is only part of the broadphase for states it is attached to
+  moveit::core::RobotState attached(*robot_state_);
+  shapes::ShapeConstPtr box = std::make_shared<shapes::Box>(0.5, 0.5, 0.5);
+  attached.attachBody("box", Eigen::Isometry3d::Identity(), { box }, { Eigen::Isometry3d::Identity() },
+                      std::set<std::string>{ "panda_hand", "panda_leftfinger", "panda_rightfinger" }, "panda_hand");
+  attached.update();
+  for (int i = 0; i < 2; ++i)
+  {
+    c_env_->checkSelfCollision(req, res, attached, *acm_);
+    EXPECT_TRUE(res.collision);
+    res.clear();
+    c_env_->checkSelfCollision(req, res, *robot_state_, *acm_);
+    EXPECT_FALSE(res.collision);
+    res.clear();
+  }
+
+  // a copy of the environment with different padding must not reuse the broadphase of the original
+  collision_detection::CollisionEnvFCL padded(
+      static_cast<const collision_detection::CollisionEnvFCL&>(*c_env_), c_env_->getWorld());
+  padded.setLinkPadding("panda_link5", 0.5);
+  padded.checkSelfCollision(req, res, *robot_state_, *acm_);
+  EXPECT_TRUE(res.collision);
+  res.clear();
+  c_env_->checkSelfCollision(req, res, *robot_state_, *acm_);
+  EXPECT_FALSE(res.collision);
+}
+
+/** \brief Binary checks with the thread-local and with explicit query contexts. */
+TEST_F(CollisionDetectionEnvTest, BinaryChecks)
+{
+  const auto& env = static_cast<const collision_detection::CollisionEnvFCL&>(*c_env_);
+  moveit::core::RobotState colliding(robot_model_);
+  colliding.setToDefaultValues();
+  colliding.update();
+
+  Eigen::Isometry3d pos = Eigen::Isometry3d::Identity();
+  pos.translation().z() = 0.3;
+  c_env_->getWorld()->addToObject("box", std::make_shared<shapes::Box>(.1, .1, .1), pos);
+
+  collision_detection::CollisionQueryContext context;
+  for (int i = 0; i < 2; ++i)
+  {
+    EXPECT_TRUE(env.isSelfColliding(colliding, *acm_));
+    EXPECT_FALSE(env.isSelfColliding(*robot_state_, *acm_));
+    EXPECT_TRUE(env.isSelfColliding(colliding, *acm_, "", context));
+    EXPECT_FALSE(env.isSelfColliding(*robot_state_, *acm_, "", context));
+    EXPECT_TRUE(env.isRobotColliding(*robot_state_, *acm_));
+    EXPECT_TRUE(env.isRobotColliding(*robot_state_, *acm_, "", context));
+    // the hand does not touch the box
+    EXPECT_FALSE(env.isRobotColliding(*robot_state_, *acm_, "hand", context));
+  }
+  EXPECT_EQ(context.robot_broadphases.size(), 1u);
+
+  // the binary result matches the full check
+  collision_detection::CollisionRequest req;
+  req.contacts = true;
+  collision_detection::CollisionResult res;
+  c_env_->checkSelfCollision(req, res, colliding, *acm_);
+  EXPECT_TRUE(res.collision);
+  EXPECT_FALSE(res.contacts.empty());
+  EXPECT_TRUE(context.binary_result.contacts.empty());
+}
+
+/** \brief The bounding sphere pre-filter never changes the result of a collision check. */
+TEST_F(CollisionDetectionEnvTest, BoundingSphereFilter)
+{
+  Eigen::Isometry3d pos = Eigen::Isometry3d::Identity();
+  pos.translation().x() = 0.4;
+  pos.translation().z() = 0.4;
+  c_env_->getWorld()->addToObject("box", std::make_shared<shapes::Box>(.2, .2, .2), pos);
+  c_env_->setLinkPadding("panda_link4", 0.02);
+
+  collision_detection::CollisionRequest req;
+  req.contacts = true;
+  req.max_contacts = 100;
+  collision_detection::CollisionRequest filtered_req = req;
+  filtered_req.bounding_sphere_filter = true;
+
+  moveit::core::RobotState state(robot_model_);
+  for (int i = 0; i < 50; ++i)
+  {
+    state.setToRandomPositions();
+    state.update();
+
+    collision_detection::CollisionResult res, filtered_res;
+    c_env_->checkSelfCollision(req, res, state, *acm_);
+    c_env_->checkSelfCollision(filtered_req, filtered_res, state, *acm_);
+    EXPECT_EQ(res.collision, filtered_res.collision);
+    EXPECT_EQ(res.contacts.size(), filtered_res.contacts.size());
+
+    res.clear();
+    filtered_res.clear();
+    c_env_->checkRobotCollision(req, res, state, *acm_);
+    c_env_->checkRobotCollision(filtered_req, filtered_res, state, *acm_);
+    EXPECT_EQ(res.collision, filtered_res.collision);
+    EXPECT_EQ(res.contacts.size(), filtered_res.contacts.size());
+  }
+}
+
+/** \brief Level-of-detail octomap checks never change the result, coarser resolutions only add collisions. */
+TEST_F(CollisionDetectionEnvTest, OctomapLevelOfDetail)
+{
+  auto tree = std::make_shared<octomap::OcTree>(0.02);
+  for (double x = 0.3; x < 0.5; x += 0.02)
+    for (double y = -0.2; y < 0.2; y += 0.02)
+      tree->updateNode(x, y, 0.5, true);
+  tree->updateNode(0.0, 0.5, 0.3, true);
+  c_env_->getWorld()->addToObject("map", std::make_shared<shapes::OcTree>(tree), Eigen::Isometry3d::Identity());
+
+  collision_detection::CollisionRequest req;
+  collision_detection::CollisionRequest lod_req;
+  lod_req.octomap_lod = true;
+  collision_detection::CollisionRequest coarse_req;
+  coarse_req.octomap_resolution = 0.08;
+
+  moveit::core::RobotState state(robot_model_);
+  for (int i = 0; i < 50; ++i)
+  {
+    state.setToRandomPositions();
+    state.update();
+
+    collision_detection::CollisionResult res, lod_res, coarse_res;
+    c_env_->checkRobotCollision(req, res, state, *acm_);
+    c_env_->checkRobotCollision(lod_req, lod_res, state, *acm_);
+    c_env_->checkRobotCollision(coarse_req, coarse_res, state, *acm_);
+    EXPECT_EQ(res.collision, lod_res.collision);
+    if (res.collision)
+      EXPECT_TRUE(coarse_res.collision);
+  }
+}
+
+/** \brief Convex decompositions of world meshes are conservative. */
+TEST_F(CollisionDetectionEnvTest, ConvexDecomposition)
+{
+  // L-shaped prism standing next to the robot
+  const double outline[6][2] = { { 0.6, 0.0 }, { 0.6, 0.3 }, { 0.3, 0.3 }, { 0.3, -0.3 }, { 0.9, -0.3 }, { 0.9, 0.0 } };
+  auto mesh = std::make_shared<shapes::Mesh>(12, 20);
+  for (unsigned int i = 0; i < 6; ++i)
+    for (unsigned int z = 0; z < 2; ++z)
+    {
+      mesh->vertices[3 * (2 * i + z)] = outline[i][0];
+      mesh->vertices[3 * (2 * i + z) + 1] = outline[i][1];
+      mesh->vertices[3 * (2 * i + z) + 2] = z;
+    }
+  unsigned int* t = mesh->triangles;
+  for (unsigned int i = 1; i + 1 < 6; ++i)
+  {
+    const unsigned int bottom[3] = { 0, 2 * (i + 1), 2 * i };
+    const unsigned int top[3] = { 1, 2 * i + 1, 2 * (i + 1) + 1 };
+    t = std::copy(top, top + 3, std::copy(bottom, bottom + 3, t));
+  }
+  for (unsigned int i = 0; i < 6; ++i)
+  {
+    const unsigned int j = (i + 1) % 6;
+    const unsigned int side[6] = { 2 * i, 2 * j, 2 * j + 1, 2 * i, 2 * j + 1, 2 * i + 1 };
+    t = std::copy(side, side + 6, t);
+  }
+  c_env_->getWorld()->addToObject("l_shape", mesh, Eigen::Isometry3d::Identity());
+
+  collision_detection::CollisionRequest req;
+  moveit::core::RobotState state(robot_model_);
+  for (int i = 0; i < 50; ++i)
+  {
+    state.setToRandomPositions();
+    state.update();
+
+    collision_detection::CollisionResult res, convex_res;
+    c_env_->setConvexDecomposition(false);
+    c_env_->checkRobotCollision(req, res, state, *acm_);
+    c_env_->setConvexDecomposition(true);
+    c_env_->checkRobotCollision(req, convex_res, state, *acm_);
+    if (res.collision)
+      EXPECT_TRUE(convex_res.collision);
+  }
+}
+
+/** \brief Distance queries reuse the closest pair of the previous query and can be distributed over threads. */
+TEST_F(CollisionDetectionEnvTest, DistanceQueries)
+{
+  for (int i = 0; i < 5; ++i)
+  {
+    Eigen::Isometry3d pose{ Eigen::Isometry3d::Identity() };
+    pose.translation() = Eigen::Vector3d(0.5 + 0.1 * i, -0.4 + 0.2 * i, 0.2 * i);
+    c_env_->getWorld()->addToObject("box" + std::to_string(i), std::make_shared<shapes::Box>(0.05, 0.05, 0.05), pose);
+  }
+
+  collision_detection::DistanceRequest req;
+  req.acm = acm_.get();
+  collision_detection::DistanceResult expected;
+  c_env_->distanceRobot(req, expected, *robot_state_);
+  ASSERT_LT(expected.minimum_distance.distance, std::numeric_limits<double>::max());
+
+  for (unsigned int threads : { 1u, 1u, 3u })
+  {
+    req.threads = threads;
+    collision_detection::DistanceResult res;
+    c_env_->distanceRobot(req, res, *robot_state_);
+    EXPECT_NEAR(res.minimum_distance.distance, expected.minimum_distance.distance, 1e-9);
+    EXPECT_EQ(res.minimum_distance.link_names[0], expected.minimum_distance.link_names[0]);
+    EXPECT_EQ(res.minimum_distance.link_names[1], expected.minimum_distance.link_names[1]);
+  }
+
+  // per pair distances, restricted to pairs closer than the threshold
+  req.type = collision_detection::DistanceRequestType::SINGLE;
+  req.distance_threshold = expected.minimum_distance.distance + 0.1;
+  req.threads = 1;
+  collision_detection::DistanceResult single;
+  c_env_->distanceRobot(req, single, *robot_state_);
+  ASSERT_FALSE(single.distances.empty());
+  for (const auto& pair : single.distances)
+    EXPECT_LT(pair.second[0].distance, req.distance_threshold);
+
+  req.threads = 4;
+  collision_detection::DistanceResult parallel;
+  c_env_->distanceRobot(req, parallel, *robot_state_);
+  ASSERT_EQ(parallel.distances.size(), single.distances.size());
+  for (const auto& pair : single.distances)
+  {
+    ASSERT_EQ(parallel.distances.count(pair.first), 1u);
+    EXPECT_NEAR(parallel.distances.at(pair.first)[0].distance, pair.second[0].distance, 1e-9);
+  }
+
+  // repeated self distance queries start from the previous closest pair
+  collision_detection::DistanceRequest self_req;
+  self_req.acm = acm_.get();
+  collision_detection::DistanceResult self_first, self_second;
+  c_env_->distanceSelf(self_req, self_first, *robot_state_);
+  c_env_->distanceSelf(self_req, self_second, *robot_state_);
+  EXPECT_NEAR(self_first.minimum_distance.distance, self_second.minimum_distance.distance, 1e-9);
+}
+
 /** \brief Continuous self collision checks of the robot.
  *
  *  Functionality not supported yet. */
@@ -266,10 +517,8 @@ TEST_F(CollisionDetectionEnvTest, DISABLED_ContinuousCollisionSelf)
   res.clear();
 }
 
-/** \brief Two similar robot poses are used as start and end pose of a continuous collision check.
- *
- *  Functionality not supported yet. */
-TEST_F(CollisionDetectionEnvTest, DISABLED_ContinuousCollisionWorld)
+/** \brief Two similar robot poses are used as start and end pose of a continuous collision check. */
+TEST_F(CollisionDetectionEnvTest, ContinuousCollisionWorld)
 {
   collision_detection::CollisionRequest req;
   req.contacts = true;
@@ -313,7 +562,23 @@ TEST_F(CollisionDetectionEnvTest, DISABLED_ContinuousCollisionWorld)
 
   c_env_->checkRobotCollision(req, res, state1, state2, *acm_);
   ASSERT_TRUE(res.collision);
-  ASSERT_EQ(res.contact_count, 4u);
+  EXPECT_LE(res.contact_count, req.max_contacts);
+  res.clear();
+
+  // the reversed motion sweeps through the same box
+  c_env_->checkRobotCollision(req, res, state2, state1, *acm_);
+  EXPECT_TRUE(res.collision);
+  res.clear();
+
+  // moving away from the box does not touch it
+  moveit::core::RobotState state3(state1);
+  double joint_1{ 1.5 };
+  state3.setJointPositions("panda_joint1", &joint_1);
+  state3.update();
+  c_env_->checkRobotCollision(req, res, state3, *acm_);
+  ASSERT_FALSE(res.collision);
+  c_env_->checkRobotCollision(req, res, state1, state3, *acm_);
+  EXPECT_FALSE(res.collision);
   res.clear();
 }
 
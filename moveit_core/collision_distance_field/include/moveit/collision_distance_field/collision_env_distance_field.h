@@ -42,6 +42,7 @@
 #include <moveit/collision_detection/collision_env.h>
 #include <moveit/planning_scene/planning_scene.h>
 #include <boost/thread/mutex.hpp>
+#include <unordered_map>
 
 namespace collision_detection
 {
@@ -127,6 +128,29 @@ public:
     return distance_field_cache_entry_;
   }
 
+  /** \brief Store the world distance field in sparse blocks that are only allocated near obstacles, so large
+      workspaces only use memory proportional to the obstacles they contain. Regenerates the world field. */
+  void setSparseWorldDistanceField(bool sparse);
+
+  bool getSparseWorldDistanceField() const
+  {
+    return sparse_world_distance_field_;
+  }
+
+  /** \brief Store the self-collision distance fields of the groups in \e directory and load them from there
+      instead of propagating them again. Files are keyed by a hash of the obstacle points of the field, so changes
+      to the robot model, padding, resolution or the state of the links outside the group produce new files. An
+      empty directory disables the cache. */
+  void setDistanceFieldCacheDirectory(const std::string& directory)
+  {
+    distance_field_cache_directory_ = directory;
+  }
+
+  const std::string& getDistanceFieldCacheDirectory() const
+  {
+    return distance_field_cache_directory_;
+  }
+
   // void getSelfCollisionsGradients(const collision_detection::CollisionRequest
   // &req,
   //                                 collision_detection::CollisionResult &res,
@@ -140,6 +164,8 @@ public:
   {
     std::map<std::string, std::vector<PosedBodyPointDecompositionPtr>> posed_body_point_decompositions_;
     distance_field::DistanceFieldPtr distance_field_;
+    /// Number of world objects occupying each obstacle voxel, keyed by the linear index of the voxel
+    std::unordered_map<long, unsigned int> voxel_object_counts_;
   };
 
   ~CollisionEnvDistanceField() override;
@@ -197,6 +223,18 @@ public:
     ROS_ERROR_NAMED("collision_distance_field", "Not implemented");
   }
 
+  using CollisionEnv::isRobotColliding;
+
+  /** \brief Binary checks of many states for collisions with the world.
+   *
+   *  The sphere decompositions of the group are set up once for the whole batch. Each thread then only poses the
+   *  spheres for its states and looks up one distance field cell per sphere, without computing gradients or contacts.
+   *  States whose joints outside the group or attached bodies differ from the first state fall back to the regular
+   *  checks. */
+  void isRobotColliding(const std::vector<const moveit::core::RobotState*>& states, const AllowedCollisionMatrix& acm,
+                        std::vector<bool>& colliding, const std::string& group_name = "",
+                        unsigned int threads = 1) const override;
+
   void setWorld(const WorldPtr& world) override;
 
   distance_field::DistanceFieldConstPtr getDistanceField() const
@@ -204,6 +242,12 @@ public:
     return distance_field_cache_entry_->distance_field_;
   }
 
+  /** \brief Get the distance field of the world objects, which robot-world checks look up */
+  distance_field::DistanceFieldConstPtr getWorldDistanceField() const
+  {
+    return distance_field_cache_entry_world_->distance_field_;
+  }
+
   collision_detection::GroupStateRepresentationConstPtr getLastGroupStateRepresentation() const
   {
     return last_gsr_;
@@ -212,6 +256,15 @@ public:
   void getCollisionGradients(const CollisionRequest& req, CollisionResult& res, const moveit::core::RobotState& state,
                              const AllowedCollisionMatrix* acm, GroupStateRepresentationPtr& gsr) const;
 
+  /** \brief Compute the proximity gradients of many states, like getCollisionGradients() for each of them.
+   *
+   *  \e gsrs holds one group state representation per state. Missing ones are created one after the other, existing
+   *  ones are reused, so repeated calls for the same number of states (e.g. the waypoints of a trajectory) only pose
+   *  the spheres and look up the gradients. Those lookups are split among \e threads threads. */
+  void getCollisionGradients(const CollisionRequest& req, const std::vector<const moveit::core::RobotState*>& states,
+                             const AllowedCollisionMatrix* acm, std::vector<GroupStateRepresentationPtr>& gsrs,
+                             unsigned int threads = 1) const;
+
   void getAllCollisions(const CollisionRequest& req, CollisionResult& res, const moveit::core::RobotState& state,
                         const AllowedCollisionMatrix* acm, GroupStateRepresentationPtr& gsr) const;
 
@@ -273,6 +326,13 @@ protected:
   void updateDistanceObject(const std::string& id, CollisionEnvDistanceField::DistanceFieldCacheEntryWorldPtr& dfce,
                             EigenSTL::vector_Vector3d& add_points, EigenSTL::vector_Vector3d& subtract_points);
 
+  /** \brief Update the voxel counts of \e dfce for one object whose points changed from \e old_points to
+      \e new_points. Voxels the object keeps, and voxels shared with other objects, are left alone; only voxels that
+      become free are added to \e freed_points and only voxels that become occupied to \e occupied_points. */
+  void updateVoxelObjectCounts(DistanceFieldCacheEntryWorld& dfce, const EigenSTL::vector_Vector3d& old_points,
+                               const EigenSTL::vector_Vector3d& new_points, EigenSTL::vector_Vector3d& freed_points,
+                               EigenSTL::vector_Vector3d& occupied_points) const;
+
   bool getEnvironmentCollisions(const CollisionRequest& req, CollisionResult& res,
                                 const distance_field::DistanceFieldConstPtr& env_distance_field,
                                 GroupStateRepresentationPtr& gsr) const;
@@ -288,6 +348,8 @@ protected:
   double resolution_;
   double collision_tolerance_;
   double max_propogation_distance_;
+  bool sparse_world_distance_field_;
+  std::string distance_field_cache_directory_;
 
   std::vector<BodyDecompositionConstPtr> link_body_decomposition_vector_;
   std::map<std::string, unsigned int> link_body_decomposition_index_map_;
@@ -45,6 +45,8 @@
 
 namespace collision_detection
 {
+static const double DEFAULT_HYBRID_MARGIN = 0.01;
+
 /** \brief This hybrid collision environment combines FCL and a distance field. Both can be used to calculate
  *  collisions. */
 class CollisionEnvHybrid : public collision_detection::CollisionEnvFCL
@@ -134,11 +136,51 @@ public:
                                         const moveit::core::RobotState& state, const AllowedCollisionMatrix& acm,
                                         GroupStateRepresentationPtr& gsr) const;
 
+  /** \brief Check the robot against the world with the distance field as broadphase and FCL as narrowphase.
+   *
+   *  The collision spheres of each link and attached body are looked up in the world distance field first. Only the
+   *  bodies with a sphere closer than its radius plus \e margin (and one cell, for the discretization of the field)
+   *  to an obstacle, or with a sphere outside the field, are then checked exactly with FCL; all others are allowed to
+   *  collide for that query. If no body is close, FCL is not called at all. The result equals the one of
+   *  checkRobotCollision() as long as the sphere decompositions cover the collision geometry up to \e margin.
+   *  Requests for distances always run the full FCL check, as skipped bodies would be missing from the result. */
+  void checkRobotCollisionHybrid(const CollisionRequest& req, CollisionResult& res,
+                                 const moveit::core::RobotState& state, const AllowedCollisionMatrix& acm,
+                                 double margin = DEFAULT_HYBRID_MARGIN) const;
+
+  void checkRobotCollisionHybrid(const CollisionRequest& req, CollisionResult& res,
+                                 const moveit::core::RobotState& state, double margin = DEFAULT_HYBRID_MARGIN) const;
+
+  /** \brief Route checkRobotCollision() and checkCollision() for single states through checkRobotCollisionHybrid()
+   *  with the given \e margin. Disabled by default. */
+  void setUseHybridRobotCollision(bool use_hybrid, double margin = DEFAULT_HYBRID_MARGIN)
+  {
+    use_hybrid_robot_collision_ = use_hybrid;
+    hybrid_margin_ = margin;
+  }
+
+  bool getUseHybridRobotCollision() const
+  {
+    return use_hybrid_robot_collision_;
+  }
+
+  void checkRobotCollision(const CollisionRequest& req, CollisionResult& res,
+                           const moveit::core::RobotState& state) const override;
+
+  void checkRobotCollision(const CollisionRequest& req, CollisionResult& res, const moveit::core::RobotState& state,
+                           const AllowedCollisionMatrix& acm) const override;
+
+  using CollisionEnvFCL::checkRobotCollision;
+
   void setWorld(const WorldPtr& world) override;
 
   void getCollisionGradients(const CollisionRequest& req, CollisionResult& res, const moveit::core::RobotState& state,
                              const AllowedCollisionMatrix* acm, GroupStateRepresentationPtr& gsr) const;
 
+  void getCollisionGradients(const CollisionRequest& req, const std::vector<const moveit::core::RobotState*>& states,
+                             const AllowedCollisionMatrix* acm, std::vector<GroupStateRepresentationPtr>& gsrs,
+                             unsigned int threads = 1) const;
+
   void getAllCollisions(const CollisionRequest& req, CollisionResult& res, const moveit::core::RobotState& state,
                         const AllowedCollisionMatrix* acm, GroupStateRepresentationPtr& gsr) const;
 
@@ -149,5 +191,7 @@ public:
 
 protected:
   CollisionEnvDistanceFieldPtr cenv_distance_;
+  bool use_hybrid_robot_collision_;
+  double hybrid_margin_;
 };
 }  // namespace collision_detection
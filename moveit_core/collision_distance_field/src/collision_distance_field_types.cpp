@@ -143,15 +143,19 @@ bool collision_detection::getCollisionSphereGradients(const distance_field::Dist
 {
   // assumes gradient is properly initialized
 
+  std::vector<double> distances;
+  EigenSTL::vector_Vector3d gradients;
+  std::vector<bool> in_bounds;
+  distance_field->getDistanceGradients(sphere_centers, distances, gradients, in_bounds);
+
   bool in_collision = false;
   for (unsigned int i = 0; i < sphere_list.size(); i++)
   {
-    Eigen::Vector3d p = sphere_centers[i];
-    Eigen::Vector3d grad;
-    bool in_bounds;
-    double dist = distance_field->getDistanceGradient(p.x(), p.y(), p.z(), grad.x(), grad.y(), grad.z(), in_bounds);
-    if (!in_bounds && grad.norm() > EPSILON)
+    const Eigen::Vector3d& grad = gradients[i];
+    double dist = distances[i];
+    if (!in_bounds[i] && grad.norm() > EPSILON)
     {
+      const Eigen::Vector3d& p = sphere_centers[i];
       ROS_DEBUG("Collision sphere point is out of bounds %lf, %lf, %lf", p.x(), p.y(), p.z());
       return true;
     }
@@ -196,25 +200,34 @@ bool collision_detection::getCollisionSphereGradients(const distance_field::Dist
   return in_collision;
 }
 
+namespace
+{
+// Distance of the cell containing \e p, with the same bounds as DistanceField::getDistanceGradient() but without
+// looking up the neighboring cells for the gradient. Returns false if \e p is out of bounds.
+inline bool getCellDistance(const distance_field::DistanceField* distance_field, const Eigen::Vector3d& p,
+                            double& dist)
+{
+  int gx, gy, gz;
+  distance_field->worldToGrid(p.x(), p.y(), p.z(), gx, gy, gz);
+  if (gx < 1 || gy < 1 || gz < 1 || gx >= distance_field->getXNumCells() - 1 ||
+      gy >= distance_field->getYNumCells() - 1 || gz >= distance_field->getZNumCells() - 1)
+    return false;
+  dist = distance_field->getDistance(gx, gy, gz);
+  return true;
+}
+}  // namespace
+
 bool collision_detection::getCollisionSphereCollision(const distance_field::DistanceField* distance_field,
                                                       const std::vector<CollisionSphere>& sphere_list,
                                                       const EigenSTL::vector_Vector3d& sphere_centers,
                                                       double maximum_value, double tolerance)
 {
+  // spheres out of bounds are not in collision: their gradient is zero
   for (unsigned int i = 0; i < sphere_list.size(); i++)
   {
-    Eigen::Vector3d p = sphere_centers[i];
-    Eigen::Vector3d grad;
-    bool in_bounds = true;
-    double dist = distance_field->getDistanceGradient(p.x(), p.y(), p.z(), grad.x(), grad.y(), grad.z(), in_bounds);
-
-    if (!in_bounds && grad.norm() > 0)
-    {
-      ROS_DEBUG("Collision sphere point is out of bounds");
-      return true;
-    }
-
-    if ((maximum_value > dist) && (sphere_list[i].radius_ - dist > tolerance))
+    double dist;
+    if (getCellDistance(distance_field, sphere_centers[i], dist) && (maximum_value > dist) &&
+        (sphere_list[i].radius_ - dist > tolerance))
     {
       return true;
     }
@@ -232,15 +245,9 @@ bool collision_detection::getCollisionSphereCollision(const distance_field::Dist
   colls.clear();
   for (unsigned int i = 0; i < sphere_list.size(); i++)
   {
-    Eigen::Vector3d p = sphere_centers[i];
-    Eigen::Vector3d grad;
-    bool in_bounds = true;
-    double dist = distance_field->getDistanceGradient(p.x(), p.y(), p.z(), grad.x(), grad.y(), grad.z(), in_bounds);
-    if (!in_bounds && (grad.norm() > 0))
-    {
-      ROS_DEBUG("Collision sphere point is out of bounds");
-      return true;
-    }
+    double dist;
+    if (!getCellDistance(distance_field, sphere_centers[i], dist))
+      continue;
     if (maximum_value > dist && (sphere_list[i].radius_ - dist > tolerance))
     {
       if (num_coll == 0)
@@ -42,8 +42,12 @@
 #include <moveit/collision_distance_field/collision_common_distance_field.h>
 #include <moveit/distance_field/propagation_distance_field.h>
 #include <moveit/collision_distance_field/collision_detector_allocator_distance_field.h>
+#include <algorithm>
+#include <cstdio>
 #include <functional>
 #include <memory>
+#include <sstream>
+#include <thread>
 #include <utility>
 
 namespace collision_detection
@@ -52,6 +56,20 @@ namespace
 {
 static const std::string NAME = "DISTANCE_FIELD";
 const double EPSILON = 0.001f;
+
+/** \brief FNV-1a hash of the obstacle points of a self-collision distance field. The points already reflect the
+    robot geometry, padding, resolution and the poses of the links outside the group. */
+std::uint64_t hashDistanceFieldPoints(const EigenSTL::vector_Vector3d& points)
+{
+  std::uint64_t hash = 14695981039346656037ULL;
+  for (const Eigen::Vector3d& point : points)
+  {
+    const unsigned char* bytes = reinterpret_cast<const unsigned char*>(point.data());
+    for (std::size_t i = 0; i < 3 * sizeof(double); ++i)
+      hash = (hash ^ bytes[i]) * 1099511628211ULL;
+  }
+  return hash;
+}
 }  // namespace
 
 CollisionEnvDistanceField::CollisionEnvDistanceField(
@@ -102,6 +120,8 @@ CollisionEnvDistanceField::CollisionEnvDistanceField(const CollisionEnvDistanceF
   resolution_ = other.resolution_;
   collision_tolerance_ = other.collision_tolerance_;
   max_propogation_distance_ = other.max_propogation_distance_;
+  sparse_world_distance_field_ = other.sparse_world_distance_field_;
+  distance_field_cache_directory_ = other.distance_field_cache_directory_;
   link_body_decomposition_vector_ = other.link_body_decomposition_vector_;
   link_body_decomposition_index_map_ = other.link_body_decomposition_index_map_;
   in_group_update_map_ = other.in_group_update_map_;
@@ -131,6 +151,7 @@ void CollisionEnvDistanceField::initialize(
   resolution_ = resolution;
   collision_tolerance_ = collision_tolerance;
   max_propogation_distance_ = max_propogation_distance;
+  sparse_world_distance_field_ = false;
   addLinkBodyDecompositions(resolution_, link_body_decompositions);
   moveit::core::RobotState state(robot_model_);
   planning_scene_ = std::make_shared<planning_scene::PlanningScene>(robot_model_);
@@ -938,9 +959,10 @@ DistanceFieldCacheEntryPtr CollisionEnvDistanceField::generateDistanceFieldCache
               getAttachedBodyPointDecomposition(attached_body, resolution_));
         }
       }
-      dfce->distance_field_ = std::make_shared<distance_field::PropagationDistanceField>(
+      auto distance_field = std::make_shared<distance_field::PropagationDistanceField>(
           size_.x(), size_.y(), size_.z(), resolution_, origin_.x() - 0.5 * size_.x(), origin_.y() - 0.5 * size_.y(),
           origin_.z() - 0.5 * size_.z(), max_propogation_distance_, use_signed_distance_field_);
+      dfce->distance_field_ = distance_field;
 
       // ROS_INFO_STREAM("Creation took " <<
       // (ros::WallTime::now()-before_create).toSec());
@@ -962,8 +984,38 @@ DistanceFieldCacheEntryPtr CollisionEnvDistanceField::generateDistanceFieldCache
         all_points.insert(all_points.end(), collision_points.begin(), collision_points.end());
       }
 
-      dfce->distance_field_->addPointsToField(all_points);
-      ROS_DEBUG_STREAM("CollisionRobot distance field has been initialized with " << all_points.size() << " points.");
+      // reuse a field precomputed for the same obstacle points, if there is one
+      std::string cache_file;
+      const std::uint64_t key = hashDistanceFieldPoints(all_points);
+      if (!distance_field_cache_directory_.empty())
+      {
+        std::stringstream name;
+        name << distance_field_cache_directory_ << "/" << group_name << "_" << std::hex << key << ".bdf";
+        cache_file = name.str();
+      }
+      if (!cache_file.empty() && distance_field->readFromBinaryFile(cache_file, key))
+      {
+        ROS_DEBUG_STREAM("CollisionRobot distance field has been loaded from " << cache_file);
+      }
+      else
+      {
+        distance_field->addPointsToField(all_points);
+        ROS_DEBUG_STREAM("CollisionRobot distance field has been initialized with " << all_points.size()
+                                                                                    << " points.");
+        if (!cache_file.empty())
+        {
+          // write to a temporary file first so concurrent readers never map a partial file
+          std::stringstream temp_file;
+          temp_file << cache_file << ".tmp" << std::this_thread::get_id();
+          if (!distance_field->writeToBinaryFile(temp_file.str(), key) ||
+              std::rename(temp_file.str().c_str(), cache_file.c_str()) != 0)
+          {
+            ROS_WARN_NAMED("collision_distance_field", "Unable to write distance field cache file %s",
+                           cache_file.c_str());
+            std::remove(temp_file.str().c_str());
+          }
+        }
+      }
     }
   }
   return dfce;
@@ -1528,6 +1580,73 @@ void CollisionEnvDistanceField::checkRobotCollision(const CollisionRequest& /*re
   ROS_ERROR_NAMED("collision_detection.distance", "Continuous collision checking not implemented");
 }
 
+void CollisionEnvDistanceField::isRobotColliding(const std::vector<const moveit::core::RobotState*>& states,
+                                                 const AllowedCollisionMatrix& acm, std::vector<bool>& colliding,
+                                                 const std::string& group_name, unsigned int threads) const
+{
+  const std::size_t count = states.size();
+  colliding.assign(count, false);
+  if (count == 0)
+    return;
+
+  GroupStateRepresentationPtr prototype;
+  generateCollisionCheckingStructures(group_name, *states.front(), &acm, prototype, true);
+  const DistanceFieldCacheEntryConstPtr dfce = prototype->dfce_;
+  const distance_field::DistanceField* env_distance_field = distance_field_cache_entry_world_->distance_field_.get();
+
+  std::vector<const moveit::core::LinkModel*> links(dfce->link_names_.size(), nullptr);
+  for (std::size_t i = 0; i < links.size(); ++i)
+    if (dfce->link_has_geometry_[i])
+      links[i] = robot_model_->getLinkModel(dfce->link_names_[i]);
+
+  // 0: free, 1: colliding, 2: not covered by the cache entry
+  std::unique_ptr<char[]> flags(new char[count]);
+  auto check = [&](const moveit::core::RobotState& state, GroupStateRepresentation& gsr) -> char {
+    if (!compareCacheEntryToState(dfce, state))
+      return 2;
+    for (std::size_t i = 0; i < links.size(); ++i)
+      if (links[i])
+      {
+        PosedBodySphereDecomposition& spheres = *gsr.link_body_decompositions_[i];
+        spheres.updatePose(state.getGlobalLinkTransform(links[i]));
+        if (getCollisionSphereCollision(env_distance_field, spheres.getCollisionSpheres(), spheres.getSphereCenters(),
+                                        max_propogation_distance_, collision_tolerance_))
+          return 1;
+      }
+    for (std::size_t i = 0; i < dfce->attached_body_names_.size(); ++i)
+    {
+      const moveit::core::AttachedBody* body = state.getAttachedBody(dfce->attached_body_names_[i]);
+      PosedBodySphereDecompositionVector& spheres = *gsr.attached_body_decompositions_[i];
+      for (std::size_t j = 0; j < body->getShapes().size(); ++j)
+        spheres.updatePose(j, body->getGlobalCollisionBodyTransforms()[j]);
+      if (getCollisionSphereCollision(env_distance_field, spheres.getCollisionSpheres(), spheres.getSphereCenters(),
+                                      max_propogation_distance_, collision_tolerance_))
+        return 1;
+    }
+    return 0;
+  };
+
+  const std::size_t chunks = std::max<std::size_t>(1, std::min<std::size_t>(threads, count));
+  const std::size_t chunk_size = (count + chunks - 1) / chunks;
+  auto run = [&](std::size_t begin) {
+    // the posed spheres are modified by every check, so each thread needs its own copy
+    GroupStateRepresentationPtr gsr;
+    getGroupStateRepresentation(dfce, *states.front(), gsr);
+    for (std::size_t i = begin, end = std::min(begin + chunk_size, count); i < end; ++i)
+      flags[i] = check(*states[i], *gsr);
+  };
+  std::vector<std::thread> workers;
+  workers.reserve(chunks - 1);
+  for (std::size_t chunk = 1; chunk < chunks; ++chunk)
+    workers.emplace_back(run, chunk * chunk_size);
+  run(0);
+  for (std::thread& worker : workers)
+    worker.join();
+
+  for (std::size_t i = 0; i < count; ++i)
+    colliding[i] = flags[i] == 2 ? isRobotColliding(*states[i], acm, group_name) : flags[i] == 1;
+}
+
 void CollisionEnvDistanceField::getCollisionGradients(const CollisionRequest& req, CollisionResult& /*res*/,
                                                       const moveit::core::RobotState& state,
                                                       const AllowedCollisionMatrix* acm,
@@ -1551,6 +1670,45 @@ void CollisionEnvDistanceField::getCollisionGradients(const CollisionRequest& re
   (const_cast<CollisionEnvDistanceField*>(this))->last_gsr_ = gsr;
 }
 
+void CollisionEnvDistanceField::getCollisionGradients(const CollisionRequest& req,
+                                                      const std::vector<const moveit::core::RobotState*>& states,
+                                                      const AllowedCollisionMatrix* acm,
+                                                      std::vector<GroupStateRepresentationPtr>& gsrs,
+                                                      unsigned int threads) const
+{
+  const std::size_t count = states.size();
+  gsrs.resize(count);
+  if (count == 0)
+    return;
+
+  // creating the structures may update the distance field cache entry, so that is not done concurrently
+  for (std::size_t i = 0; i < count; ++i)
+    if (!gsrs[i])
+      generateCollisionCheckingStructures(req.group_name, *states[i], acm, gsrs[i], true);
+
+  const distance_field::DistanceFieldConstPtr env_distance_field = distance_field_cache_entry_world_->distance_field_;
+  const std::size_t chunks = std::max<std::size_t>(1, std::min<std::size_t>(threads, count));
+  const std::size_t chunk_size = (count + chunks - 1) / chunks;
+  auto run = [&](std::size_t begin) {
+    for (std::size_t i = begin, end = std::min(begin + chunk_size, count); i < end; ++i)
+    {
+      updateGroupStateRepresentationState(*states[i], gsrs[i]);
+      getSelfProximityGradients(gsrs[i]);
+      getIntraGroupProximityGradients(gsrs[i]);
+      getEnvironmentProximityGradients(env_distance_field, gsrs[i]);
+    }
+  };
+  std::vector<std::thread> workers;
+  workers.reserve(chunks - 1);
+  for (std::size_t chunk = 1; chunk < chunks; ++chunk)
+    workers.emplace_back(run, chunk * chunk_size);
+  run(0);
+  for (std::thread& worker : workers)
+    worker.join();
+
+  (const_cast<CollisionEnvDistanceField*>(this))->last_gsr_ = gsrs.back();
+}
+
 void CollisionEnvDistanceField::getAllCollisions(const CollisionRequest& req, CollisionResult& res,
                                                  const moveit::core::RobotState& state,
                                                  const AllowedCollisionMatrix* acm,
@@ -1704,6 +1862,8 @@ void CollisionEnvDistanceField::setWorld(const WorldPtr& world)
 
   // clear out objects from old world
   distance_field_cache_entry_world_->distance_field_->reset();
+  distance_field_cache_entry_world_->posed_body_point_decompositions_.clear();
+  distance_field_cache_entry_world_->voxel_object_counts_.clear();
 
   CollisionEnv::setWorld(world);
 
@@ -1723,19 +1883,13 @@ void CollisionEnvDistanceField::notifyObjectChange(const ObjectConstPtr& obj, Wo
   EigenSTL::vector_Vector3d subtract_points;
   updateDistanceObject(obj->id_, distance_field_cache_entry_world_, add_points, subtract_points);
 
-  if (action == World::DESTROY)
-  {
-    distance_field_cache_entry_world_->distance_field_->removePointsFromField(subtract_points);
-  }
-  else if (action & (World::MOVE_SHAPE | World::REMOVE_SHAPE))
-  {
-    distance_field_cache_entry_world_->distance_field_->removePointsFromField(subtract_points);
-    distance_field_cache_entry_world_->distance_field_->addPointsToField(add_points);
-  }
-  else
-  {
-    distance_field_cache_entry_world_->distance_field_->addPointsToField(add_points);
-  }
+  // only the voxels this change frees or newly occupies are touched, so propagation stays local to the object
+  EigenSTL::vector_Vector3d freed_points;
+  EigenSTL::vector_Vector3d occupied_points;
+  updateVoxelObjectCounts(*distance_field_cache_entry_world_, subtract_points, add_points, freed_points,
+                          occupied_points);
+  if (!freed_points.empty() || !occupied_points.empty())
+    distance_field_cache_entry_world_->distance_field_->updatePointsInField(freed_points, occupied_points);
 
   ROS_DEBUG_NAMED("collision_distance_field", "Modifying object %s took %lf s", obj->id_.c_str(),
                   (ros::WallTime::now() - n).toSec());
@@ -1792,21 +1946,74 @@ void CollisionEnvDistanceField::updateDistanceObject(const std::string& id, Dist
   }
 }
 
+void CollisionEnvDistanceField::updateVoxelObjectCounts(DistanceFieldCacheEntryWorld& dfce,
+                                                        const EigenSTL::vector_Vector3d& old_points,
+                                                        const EigenSTL::vector_Vector3d& new_points,
+                                                        EigenSTL::vector_Vector3d& freed_points,
+                                                        EigenSTL::vector_Vector3d& occupied_points) const
+{
+  const distance_field::DistanceField& df = *dfce.distance_field_;
+  // the shapes of one object may overlap, so each voxel is counted once per object
+  const auto collect_voxels = [&df](const EigenSTL::vector_Vector3d& points,
+                                    std::unordered_map<long, const Eigen::Vector3d*>& voxels) {
+    for (const Eigen::Vector3d& point : points)
+    {
+      int x, y, z;
+      if (df.worldToGrid(point.x(), point.y(), point.z(), x, y, z))
+        voxels.emplace((static_cast<long>(x) * df.getYNumCells() + y) * df.getZNumCells() + z, &point);
+    }
+  };
+  std::unordered_map<long, const Eigen::Vector3d*> old_voxels;
+  std::unordered_map<long, const Eigen::Vector3d*> new_voxels;
+  collect_voxels(old_points, old_voxels);
+  collect_voxels(new_points, new_voxels);
+
+  for (const std::pair<const long, const Eigen::Vector3d*>& voxel : old_voxels)
+  {
+    if (new_voxels.erase(voxel.first))
+      continue;
+    std::unordered_map<long, unsigned int>::iterator count = dfce.voxel_object_counts_.find(voxel.first);
+    if (count != dfce.voxel_object_counts_.end() && --count->second == 0)
+    {
+      dfce.voxel_object_counts_.erase(count);
+      freed_points.push_back(*voxel.second);
+    }
+  }
+  for (const std::pair<const long, const Eigen::Vector3d*>& voxel : new_voxels)
+    if (++dfce.voxel_object_counts_[voxel.first] == 1)
+      occupied_points.push_back(*voxel.second);
+}
+
+void CollisionEnvDistanceField::setSparseWorldDistanceField(bool sparse)
+{
+  if (sparse == sparse_world_distance_field_)
+    return;
+  boost::mutex::scoped_lock slock(update_cache_lock_world_);
+  sparse_world_distance_field_ = sparse;
+  distance_field_cache_entry_world_ = generateDistanceFieldCacheEntryWorld();
+}
+
 CollisionEnvDistanceField::DistanceFieldCacheEntryWorldPtr
 CollisionEnvDistanceField::generateDistanceFieldCacheEntryWorld()
 {
   DistanceFieldCacheEntryWorldPtr dfce(new DistanceFieldCacheEntryWorld());
   dfce->distance_field_ = std::make_shared<distance_field::PropagationDistanceField>(
       size_.x(), size_.y(), size_.z(), resolution_, origin_.x() - 0.5 * size_.x(), origin_.y() - 0.5 * size_.y(),
-      origin_.z() - 0.5 * size_.z(), max_propogation_distance_, use_signed_distance_field_);
+      origin_.z() - 0.5 * size_.z(), max_propogation_distance_, use_signed_distance_field_,
+      sparse_world_distance_field_);
 
   EigenSTL::vector_Vector3d add_points;
   EigenSTL::vector_Vector3d subtract_points;
+  EigenSTL::vector_Vector3d freed_points;
+  EigenSTL::vector_Vector3d occupied_points;
   for (const std::pair<const std::string, ObjectPtr>& object : *getWorld())
   {
+    add_points.clear();
+    subtract_points.clear();
     updateDistanceObject(object.first, dfce, add_points, subtract_points);
+    updateVoxelObjectCounts(*dfce, subtract_points, add_points, freed_points, occupied_points);
   }
-  dfce->distance_field_->addPointsToField(add_points);
+  dfce->distance_field_->addPointsToField(occupied_points);
   return dfce;
 }
 
@@ -42,6 +42,25 @@ namespace collision_detection
 namespace
 {
 static const std::string NAME = "HYBRID";
+
+// True if one of the spheres comes closer than its radius plus \e margin to an obstacle of \e distance_field, or
+// lies where the field cannot tell (out of its bounds or beyond its propagation distance).
+bool isNearObstacle(const distance_field::DistanceField& distance_field, const std::vector<CollisionSphere>& spheres,
+                    const EigenSTL::vector_Vector3d& centers, double margin, double max_propagation_distance)
+{
+  for (std::size_t i = 0; i < spheres.size(); ++i)
+  {
+    int gx, gy, gz;
+    distance_field.worldToGrid(centers[i].x(), centers[i].y(), centers[i].z(), gx, gy, gz);
+    if (gx < 1 || gy < 1 || gz < 1 || gx >= distance_field.getXNumCells() - 1 ||
+        gy >= distance_field.getYNumCells() - 1 || gz >= distance_field.getZNumCells() - 1)
+      return true;
+    const double reach = spheres[i].radius_ + margin;
+    if (reach >= max_propagation_distance || distance_field.getDistance(gx, gy, gz) < reach)
+      return true;
+  }
+  return false;
+}
 }  // namespace
 
 CollisionEnvHybrid::CollisionEnvHybrid(
@@ -53,6 +72,8 @@ CollisionEnvHybrid::CollisionEnvHybrid(
   , cenv_distance_(new collision_detection::CollisionEnvDistanceField(
         robot_model, getWorld(), link_body_decompositions, size_x, size_y, size_z, origin, use_signed_distance_field,
         resolution, collision_tolerance, max_propogation_distance, padding, scale))
+  , use_hybrid_robot_collision_(false)
+  , hybrid_margin_(DEFAULT_HYBRID_MARGIN)
 {
 }
 
@@ -65,12 +86,16 @@ CollisionEnvHybrid::CollisionEnvHybrid(
   , cenv_distance_(new collision_detection::CollisionEnvDistanceField(
         robot_model, getWorld(), link_body_decompositions, size_x, size_y, size_z, origin, use_signed_distance_field,
         resolution, collision_tolerance, max_propogation_distance, padding, scale))
+  , use_hybrid_robot_collision_(false)
+  , hybrid_margin_(DEFAULT_HYBRID_MARGIN)
 {
 }
 
 CollisionEnvHybrid::CollisionEnvHybrid(const CollisionEnvHybrid& other, const WorldPtr& world)
   : CollisionEnvFCL(other, world)
   , cenv_distance_(new collision_detection::CollisionEnvDistanceField(*other.getCollisionWorldDistanceField(), world))
+  , use_hybrid_robot_collision_(other.use_hybrid_robot_collision_)
+  , hybrid_margin_(other.hybrid_margin_)
 {
 }
 
@@ -162,6 +187,83 @@ void CollisionEnvHybrid::checkRobotCollisionDistanceField(const CollisionRequest
   cenv_distance_->checkRobotCollision(req, res, state, acm, gsr);
 }
 
+void CollisionEnvHybrid::checkRobotCollisionHybrid(const CollisionRequest& req, CollisionResult& res,
+                                                   const moveit::core::RobotState& state,
+                                                   const AllowedCollisionMatrix& acm, double margin) const
+{
+  // the distance field checks need a group; distances need every body
+  if (req.distance || !getRobotModel()->hasJointModelGroup(req.group_name))
+  {
+    CollisionEnvFCL::checkRobotCollision(req, res, state, acm);
+    return;
+  }
+
+  // broadphase: pose the collision spheres and look them up in the world distance field
+  CollisionRequest sphere_req;
+  sphere_req.group_name = req.group_name;
+  CollisionResult sphere_res;
+  GroupStateRepresentationPtr gsr;
+  cenv_distance_->checkRobotCollision(sphere_req, sphere_res, state, acm, gsr);
+
+  const distance_field::DistanceFieldConstPtr& world_field = cenv_distance_->getWorldDistanceField();
+  const double reach = margin + world_field->getResolution();
+  const double max_distance = world_field->getUninitializedDistance();
+
+  // bodies far from every obstacle are allowed to collide, so the narrowphase skips them
+  AllowedCollisionMatrix narrow_acm(acm);
+  bool any_near = false;
+  const DistanceFieldCacheEntry& dfce = *gsr->dfce_;
+  for (std::size_t i = 0; i < dfce.link_names_.size(); ++i)
+  {
+    if (!dfce.link_has_geometry_[i])
+      continue;
+    const PosedBodySphereDecompositionPtr& decomposition = gsr->link_body_decompositions_[i];
+    if (isNearObstacle(*world_field, decomposition->getCollisionSpheres(), decomposition->getSphereCenters(), reach,
+                       max_distance))
+      any_near = true;
+    else
+      narrow_acm.setDefaultEntry(dfce.link_names_[i], true);
+  }
+  for (std::size_t i = 0; i < dfce.attached_body_names_.size(); ++i)
+  {
+    const PosedBodySphereDecompositionVectorPtr& decomposition = gsr->attached_body_decompositions_[i];
+    if (isNearObstacle(*world_field, decomposition->getCollisionSpheres(), decomposition->getSphereCenters(), reach,
+                       max_distance))
+      any_near = true;
+    else
+      narrow_acm.setDefaultEntry(dfce.attached_body_names_[i], true);
+  }
+
+  // the cache entry holds the links updated by the group, which are exactly the ones FCL checks
+  if (any_near)
+    CollisionEnvFCL::checkRobotCollision(req, res, state, narrow_acm);
+}
+
+void CollisionEnvHybrid::checkRobotCollisionHybrid(const CollisionRequest& req, CollisionResult& res,
+                                                   const moveit::core::RobotState& state, double margin) const
+{
+  checkRobotCollisionHybrid(req, res, state, AllowedCollisionMatrix(), margin);
+}
+
+void CollisionEnvHybrid::checkRobotCollision(const CollisionRequest& req, CollisionResult& res,
+                                             const moveit::core::RobotState& state) const
+{
+  if (use_hybrid_robot_collision_)
+    checkRobotCollisionHybrid(req, res, state, hybrid_margin_);
+  else
+    CollisionEnvFCL::checkRobotCollision(req, res, state);
+}
+
+void CollisionEnvHybrid::checkRobotCollision(const CollisionRequest& req, CollisionResult& res,
+                                             const moveit::core::RobotState& state,
+                                             const AllowedCollisionMatrix& acm) const
+{
+  if (use_hybrid_robot_collision_)
+    checkRobotCollisionHybrid(req, res, state, acm, hybrid_margin_);
+  else
+    CollisionEnvFCL::checkRobotCollision(req, res, state, acm);
+}
+
 void CollisionEnvHybrid::setWorld(const WorldPtr& world)
 {
   if (world == getWorld())
@@ -178,6 +280,14 @@ void CollisionEnvHybrid::getCollisionGradients(const CollisionRequest& req, Coll
   cenv_distance_->getCollisionGradients(req, res, state, acm, gsr);
 }
 
+void CollisionEnvHybrid::getCollisionGradients(const CollisionRequest& req,
+                                               const std::vector<const moveit::core::RobotState*>& states,
+                                               const AllowedCollisionMatrix* acm,
+                                               std::vector<GroupStateRepresentationPtr>& gsrs, unsigned int threads) const
+{
+  cenv_distance_->getCollisionGradients(req, states, acm, gsrs, threads);
+}
+
 void CollisionEnvHybrid::getAllCollisions(const CollisionRequest& req, CollisionResult& res,
                                           const moveit::core::RobotState& state, const AllowedCollisionMatrix* acm,
                                           GroupStateRepresentationPtr& gsr) const
@@ -96,6 +96,45 @@ TEST_F(DistanceFieldCollisionDetectionTester, DefaultNotInCollision)
   ASSERT_FALSE(res.collision);
 }
 
+TEST_F(DistanceFieldCollisionDetectionTester, DistanceFieldCacheDirectory)
+{
+  const boost::filesystem::path directory = boost::filesystem::temp_directory_path() /
+                                            boost::filesystem::unique_path("distance_field_cache_%%%%%%%%");
+  ASSERT_TRUE(boost::filesystem::create_directories(directory));
+
+  moveit::core::RobotState robot_state(robot_model_);
+  robot_state.setToDefaultValues();
+  robot_state.updateStateWithLinkAt("r_gripper_palm_link", Eigen::Isometry3d::Identity());
+  robot_state.updateStateWithLinkAt("l_gripper_palm_link", Eigen::Isometry3d(Eigen::Translation3d(0.01, 0, 0)));
+  acm_->setEntry("r_gripper_palm_link", "l_gripper_palm_link", false);
+
+  collision_detection::CollisionRequest req;
+  req.group_name = "right_arm";
+  for (const std::string& state : { "palms together", "default" })
+  {
+    // the first environment fills the cache, the second one loads from it
+    std::vector<bool> results;
+    for (int i = 0; i < 2; ++i)
+    {
+      std::map<std::string, std::vector<collision_detection::CollisionSphere>> link_body_decompositions;
+      DefaultCEnvType cenv(robot_model_, link_body_decompositions);
+      cenv.setDistanceFieldCacheDirectory(directory.string());
+      collision_detection::CollisionResult res;
+      cenv.checkSelfCollision(req, res, robot_state, *acm_);
+      results.push_back(res.collision);
+    }
+    EXPECT_EQ(results[0], results[1]) << state;
+    robot_state.setToDefaultValues();
+    robot_state.update();
+  }
+
+  std::size_t files = 0;
+  for (boost::filesystem::directory_iterator it(directory); it != boost::filesystem::directory_iterator(); ++it)
+    files += it->path().extension() == ".bdf";
+  EXPECT_GE(files, 1u);
+  boost::filesystem::remove_all(directory);
+}
+
 TEST_F(DistanceFieldCollisionDetectionTester, ChangeTorsoPosition)
 {
   moveit::core::RobotState robot_state(robot_model_);
@@ -262,6 +301,44 @@ TEST_F(DistanceFieldCollisionDetectionTester, ContactPositions)
   ASSERT_FALSE(res3.collision);
 }
 
+TEST_F(DistanceFieldCollisionDetectionTester, OverlappingWorldObjects)
+{
+  collision_detection::CollisionRequest req;
+  req.group_name = "right_arm";
+
+  moveit::core::RobotState robot_state(robot_model_);
+  robot_state.setToDefaultValues();
+  Eigen::Isometry3d pos1 = Eigen::Isometry3d::Identity();
+  pos1.translation().x() = 1.0;
+  robot_state.updateStateWithLinkAt("r_gripper_palm_link", pos1);
+  robot_state.update();
+
+  // two objects that occupy the same voxels
+  cenv_->getWorld()->addToObject("box1", shapes::ShapeConstPtr(new shapes::Box(.25, .25, .25)), pos1);
+  cenv_->getWorld()->addToObject("box2", shapes::ShapeConstPtr(new shapes::Box(.25, .25, .25)), pos1);
+  collision_detection::CollisionResult res;
+  cenv_->checkRobotCollision(req, res, robot_state, *acm_);
+  ASSERT_TRUE(res.collision);
+
+  // moving one object away must keep the voxels the other one still occupies
+  Eigen::Isometry3d far_away = Eigen::Isometry3d::Identity();
+  far_away.translation().y() = 1.2;
+  ASSERT_TRUE(cenv_->getWorld()->setObjectPose("box1", far_away));
+  res = collision_detection::CollisionResult();
+  cenv_->checkRobotCollision(req, res, robot_state, *acm_);
+  EXPECT_TRUE(res.collision);
+
+  cenv_->getWorld()->removeObject("box2");
+  res = collision_detection::CollisionResult();
+  cenv_->checkRobotCollision(req, res, robot_state, *acm_);
+  EXPECT_FALSE(res.collision);
+
+  ASSERT_TRUE(cenv_->getWorld()->setObjectPose("box1", pos1));
+  res = collision_detection::CollisionResult();
+  cenv_->checkRobotCollision(req, res, robot_state, *acm_);
+  EXPECT_TRUE(res.collision);
+}
+
 TEST_F(DistanceFieldCollisionDetectionTester, AttachedBodyTester)
 {
   collision_detection::CollisionRequest req;
@@ -333,6 +410,35 @@ TEST_F(DistanceFieldCollisionDetectionTester, AttachedBodyTester)
   ASSERT_TRUE(res.collision);
 }
 
+TEST_F(DistanceFieldCollisionDetectionTester, BatchRobotCollision)
+{
+  Eigen::Isometry3d pos = Eigen::Isometry3d::Identity();
+  pos.translation().x() = 0.8;
+  pos.translation().y() = -0.2;
+  pos.translation().z() = 0.8;
+  cenv_->getWorld()->addToObject("box", std::make_shared<shapes::Box>(.3, .3, .3), pos);
+
+  constexpr std::size_t BATCH_SIZE = 12;
+  std::vector<moveit::core::RobotState> states(BATCH_SIZE, moveit::core::RobotState(robot_model_));
+  std::vector<const moveit::core::RobotState*> state_ptrs;
+  for (moveit::core::RobotState& state : states)
+  {
+    state.setToDefaultValues();
+    state.setToRandomPositions(robot_model_->getJointModelGroup("right_arm"));
+    state.update();
+    state_ptrs.push_back(&state);
+  }
+
+  for (unsigned int threads : { 1u, 3u })
+  {
+    std::vector<bool> colliding;
+    cenv_->isRobotColliding(state_ptrs, *acm_, colliding, "right_arm", threads);
+    ASSERT_EQ(colliding.size(), BATCH_SIZE);
+    for (std::size_t i = 0; i < BATCH_SIZE; ++i)
+      EXPECT_EQ(colliding[i], cenv_->isRobotColliding(states[i], *acm_, "right_arm")) << "state " << i;
+  }
+}
+
 int main(int argc, char** argv)
 {
   testing::InitGoogleTest(&argc, argv);
@@ -39,11 +39,67 @@
 #include <moveit/constraint_samplers/constraint_sampler.h>
 #include <moveit/macros/class_forward.h>
 #include <random_numbers/random_numbers.h>
+#include <algorithm>
+#include <cstdint>
+#include <limits>
 
 namespace constraint_samplers
 {
 random_numbers::RandomNumberGenerator createSeededRNG(const std::string& seed_param);
 
+/**
+ * \brief A xoshiro256++ generator for drawing many uniform numbers
+ * quickly, e.g. when sampling in batches.
+ *
+ * It is seeded from a random_numbers::RandomNumberGenerator, so seeding
+ * that generator makes the sequence reproducible.
+ */
+class FastRandomGenerator
+{
+public:
+  explicit FastRandomGenerator(random_numbers::RandomNumberGenerator& seed_source)
+  {
+    // expand the seed with splitmix64, as recommended for xoshiro generators
+    uint64_t seed = (static_cast<uint64_t>(seed_source.uniformInteger(0, std::numeric_limits<int>::max())) << 32) ^
+                    static_cast<uint64_t>(seed_source.uniformInteger(0, std::numeric_limits<int>::max()));
+    for (uint64_t& s : state_)
+    {
+      uint64_t z = (seed += 0x9e3779b97f4a7c15ULL);
+      z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+      z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+      s = z ^ (z >> 31);
+    }
+  }
+
+  /** \brief Get the next 64 random bits */
+  uint64_t next()
+  {
+    const uint64_t result = rotl(state_[0] + state_[3], 23) + state_[0];
+    const uint64_t t = state_[1] << 17;
+    state_[2] ^= state_[0];
+    state_[3] ^= state_[1];
+    state_[1] ^= state_[2];
+    state_[0] ^= state_[3];
+    state_[2] ^= t;
+    state_[3] = rotl(state_[3], 45);
+    return result;
+  }
+
+  /** \brief Get a uniform random number in [0, 1) */
+  double uniform01()
+  {
+    return static_cast<double>(next() >> 11) * (1.0 / 9007199254740992.0);  // 53 bits of mantissa
+  }
+
+private:
+  static uint64_t rotl(uint64_t x, int k)
+  {
+    return (x << k) | (x >> (64 - k));
+  }
+
+  uint64_t state_[4];
+};
+
 MOVEIT_CLASS_FORWARD(JointConstraintSampler);  // Defines JointConstraintSamplerPtr, ConstPtr, WeakPtr... etc
 
 /**
@@ -71,6 +127,7 @@ public:
   JointConstraintSampler(const planning_scene::PlanningSceneConstPtr& scene, const std::string& group_name)
     : ConstraintSampler(scene, group_name)
     , random_number_generator_(createSeededRNG("~joint_constraint_sampler_random_seed"))
+    , fast_random_generator_(random_number_generator_)
   {
   }
 
@@ -122,6 +179,20 @@ public:
 
   bool sample(moveit::core::RobotState& state, const moveit::core::RobotState& ks, unsigned int max_attempts) override;
 
+  /**
+   * \brief Samples many sets of values for the group at once.
+   *
+   * Variables of single-DOF joints are drawn for all samples together
+   * from precomputed intervals, which makes this considerably cheaper
+   * than calling sample() repeatedly, e.g. when building roadmaps.
+   *
+   * @param [in] count The number of samples to draw
+   * @param [out] values The samples as columns, with one row per variable of the group
+   *
+   * @return False if the sampler is not configured
+   */
+  bool sampleBatch(std::size_t count, Eigen::MatrixXd& values);
+
   /**
    * \brief Gets the number of constrained joints - joints that have an
    * additional bound beyond the joint limits.
@@ -201,6 +272,13 @@ protected:
                                                              limits */
   std::vector<unsigned int> uindex_; /**< \brief The index of the unbounded joints in the joint state vector */
   std::vector<double> values_;       /**< \brief Values associated with this group to avoid continuously reallocating */
+
+  FastRandomGenerator fast_random_generator_; /**< \brief Generator used to sample from the intervals */
+  std::vector<std::size_t> interval_index_;   /**< \brief Group index of the variables sampled from intervals */
+  Eigen::ArrayXd interval_min_;               /**< \brief Lower end of the interval of each of these variables */
+  Eigen::ArrayXd interval_range_;             /**< \brief Length of the interval of each of these variables */
+  std::vector<const moveit::core::JointModel*> random_joints_; /**< \brief Unbounded joints sampled by their model */
+  std::vector<std::size_t> random_index_; /**< \brief Group index of the first variable of these joints */
 };
 
 /**
@@ -307,7 +385,10 @@ public:
   IKConstraintSampler(const planning_scene::PlanningSceneConstPtr& scene, const std::string& group_name)
     : ConstraintSampler(scene, group_name)
     , random_number_generator_(createSeededRNG("~ik_constraint_sampler_random_seed"))
+    , ik_batch_size_(1)
+    , ik_batch_threads_(1)
   {
+    loadIKBatchParameters();
   }
 
   /**
@@ -383,6 +464,35 @@ public:
     ik_timeout_ = timeout;
   }
 
+  /**
+   * \brief Gets the number of poses sampled and solved together, see \ref setIKBatchSize
+   */
+  unsigned int getIKBatchSize() const
+  {
+    return ik_batch_size_;
+  }
+
+  /**
+   * \brief Sets the number of poses sampled and solved together
+   *
+   * With a batch size larger than 1, \ref sample generates that many
+   * poses at once, solves them with a single call to
+   * kinematics::KinematicsBase::searchPositionIKBatch() and filters the
+   * solutions by the group state validity callback and the constraints
+   * in one pass. The validity callback is then applied to the solutions
+   * instead of inside the solver. Defaults to the parameter
+   * ~ik_constraint_sampler_batch_size, or 1 for the sequential search.
+   *
+   * @param size The number of poses per batch
+   * @param threads The number of threads the solver may distribute a batch over, 0 for all cores. Defaults to the
+   * parameter ~ik_constraint_sampler_batch_threads, or 1.
+   */
+  void setIKBatchSize(unsigned int size, unsigned int threads = 1)
+  {
+    ik_batch_size_ = std::max(size, 1u);
+    ik_batch_threads_ = threads;
+  }
+
   /**
    * \brief Gets the position constraint associated with this sampler.
    *
@@ -513,6 +623,25 @@ protected:
               moveit::core::RobotState& state, bool use_as_seed);
   bool sampleHelper(moveit::core::RobotState& state, const moveit::core::RobotState& reference_state,
                     unsigned int max_attempts);
+
+  /**
+   * \brief Like \ref sampleHelper, but samples and solves \ref getIKBatchSize poses at a time
+   */
+  bool sampleBatchHelper(moveit::core::RobotState& state, const moveit::core::RobotState& reference_state,
+                         unsigned int max_attempts);
+
+  /**
+   * \brief Samples a pose with \ref samplePose and expresses it for the IK solver, i.e. for its tip frame in its
+   * base frame
+   *
+   * @return True if a pose was sampled, otherwise false
+   */
+  bool sampleIKQuery(geometry_msgs::Pose& ik_query, const moveit::core::RobotState& reference_state,
+                     unsigned int max_attempts);
+
+  /** \brief Reads the default batch size and threads from the parameter server */
+  void loadIKBatchParameters();
+
   bool validate(moveit::core::RobotState& state) const;
 
   random_numbers::RandomNumberGenerator random_number_generator_; /**< \brief Random generator used by the sampler */
@@ -525,5 +654,7 @@ protected:
   bool need_eef_to_ik_tip_transform_; /**< \brief True if the tip frame of the inverse kinematic is different than the
                                         frame of the end effector */
   Eigen::Isometry3d eef_to_ik_tip_transform_; /**< \brief Holds the transformation from end effector to IK tip frame */
+  unsigned int ik_batch_size_;    /**< \brief Number of poses sampled and solved together */
+  unsigned int ik_batch_threads_; /**< \brief Number of threads the IK solver may distribute a batch over */
 };
 }  // namespace constraint_samplers
@@ -0,0 +1,171 @@
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2026, PickNik LLC.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of PickNik LLC nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *********************************************************************/
+
+#pragma once
+
+#include <moveit/constraint_samplers/constraint_sampler.h>
+#include <moveit/constraint_samplers/default_constraint_samplers.h>
+#include <moveit/macros/class_forward.h>
+#include <random_numbers/random_numbers.h>
+
+namespace constraint_samplers
+{
+MOVEIT_CLASS_FORWARD(ProjectionConstraintSampler);  // Defines ProjectionConstraintSamplerPtr, ConstPtr, WeakPtr... etc
+
+/**
+ * \brief A sampler that draws unconstrained states for a chain group and
+ * projects them onto the set of states satisfying position, orientation
+ * and joint constraints.
+ *
+ * The projection takes damped least-squares steps with the group
+ * Jacobian until all constraints are satisfied.  Unlike the \ref
+ * IKConstraintSampler, no kinematics solver is needed and any number of
+ * pose constraints on links of the chain can be combined, which makes
+ * the sampler suitable for path constraints.  The projection can also be
+ * applied to states produced by other means (e.g. interpolated states)
+ * through \ref project().
+ */
+class ProjectionConstraintSampler : public ConstraintSampler
+{
+public:
+  /**
+   * \brief Constructor
+   *
+   * @param [in] scene The planning scene used to check the constraint
+   *
+   * @param [in] group_name The group name associated with the
+   * constraint.  Will be invalid if no group name is passed in or the
+   * joint model group cannot be found in the kinematic model
+   */
+  ProjectionConstraintSampler(const planning_scene::PlanningSceneConstPtr& scene, const std::string& group_name)
+    : ConstraintSampler(scene, group_name)
+    , random_number_generator_(createSeededRNG("~projection_constraint_sampler_random_seed"))
+    , max_projection_iterations_(50)
+  {
+  }
+
+  /**
+   * \brief Configures the sampler from a Constraints message.
+   *
+   * For the configuration to be successful, the group must be a chain
+   * and at least one position or orientation constraint must refer to a
+   * link updated by the group.  Joint constraints on variables of the
+   * group are enforced as additional bounds during projection; all other
+   * constraints are ignored.
+   *
+   * @param [in] constr The message containing the constraints
+   *
+   * @return True if the conditions are met, otherwise false
+   */
+  bool configure(const moveit_msgs::Constraints& constr) override;
+
+  /**
+   * \brief Samples random values for the group and projects them onto
+   * the constraints.
+   *
+   * The first attempt starts from the group values in \e
+   * reference_state, later attempts from random values.
+   *
+   * @param [out] state The state into which the values will be placed
+   * @param [in] reference_state Reference state used for the first attempt and for mobile frames
+   * @param [in] max_attempts The number of projections to try
+   *
+   * @return True if a projected state passing the validity callback was found
+   */
+  bool sample(moveit::core::RobotState& state, const moveit::core::RobotState& reference_state,
+              unsigned int max_attempts) override;
+
+  /**
+   * \brief Moves the group values of \e state onto the constraints.
+   *
+   * Only the variables of the group are changed, and the link transforms
+   * of \e state are kept up to date.
+   *
+   * @param [in,out] state The state to project, modified even if the projection fails
+   * @param [in] max_iterations The maximum number of Jacobian steps to take
+   *
+   * @return True if all constraints are satisfied by the projected state
+   */
+  bool project(moveit::core::RobotState& state, unsigned int max_iterations) const;
+
+  /** \brief Project \e state using the configured maximum number of iterations */
+  bool project(moveit::core::RobotState& state) const
+  {
+    return project(state, max_projection_iterations_);
+  }
+
+  /** \brief Get the maximum number of Jacobian steps taken by a projection */
+  unsigned int getMaxProjectionIterations() const
+  {
+    return max_projection_iterations_;
+  }
+
+  /** \brief Set the maximum number of Jacobian steps taken by a projection */
+  void setMaxProjectionIterations(unsigned int iterations)
+  {
+    max_projection_iterations_ = iterations;
+  }
+
+  const std::string& getName() const override
+  {
+    static const std::string SAMPLER_NAME = "ProjectionConstraintSampler";
+    return SAMPLER_NAME;
+  }
+
+protected:
+  void clear() override;
+
+  /** \brief Check whether \e state satisfies all constraints of the sampler */
+  bool decide(const moveit::core::RobotState& state) const;
+
+  /**
+   * \brief Compute the stacked constraint residuals of \e state and their
+   * Jacobian with respect to the group variables.
+   *
+   * Residuals are zero for satisfied constraints and otherwise point from
+   * a target well inside the allowed region to the current value.
+   */
+  bool computeResidual(const moveit::core::RobotState& state, Eigen::VectorXd& residual,
+                       Eigen::MatrixXd& jacobian) const;
+
+  random_numbers::RandomNumberGenerator random_number_generator_; /**< \brief Random generator used by the sampler */
+  std::vector<kinematic_constraints::PositionConstraintPtr> position_constraints_; /**< \brief Position constraints */
+  std::vector<double> position_margins_; /**< \brief Distance to the region centers that projections aim for */
+  std::vector<kinematic_constraints::OrientationConstraintPtr>
+      orientation_constraints_;                                       /**< \brief Orientation constraints */
+  std::vector<kinematic_constraints::JointConstraint> joint_constraints_; /**< \brief Joint constraints */
+  std::vector<std::size_t> joint_constraint_indices_; /**< \brief Group variable index of each joint constraint */
+  unsigned int max_projection_iterations_;            /**< \brief Maximum number of steps per projection */
+};
+}  // namespace constraint_samplers
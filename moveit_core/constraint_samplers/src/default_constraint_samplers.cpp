@@ -156,6 +156,37 @@ bool JointConstraintSampler::configure(const std::vector<kinematic_constraints::
       // Get the first variable name of this joint and find its index position in the planning group
       uindex_.push_back(jmg_->getVariableGroupIndex(vars[0]));
     }
+
+  // revolute and prismatic joints are sampled uniformly within their bounds, so their intervals can be precomputed;
+  // other unbounded joints are sampled by their joint model. Constraint bounds are listed last, so they take
+  // precedence for multi-DOF joints with some constrained variables.
+  std::vector<double> interval_min, interval_range;
+  for (std::size_t i = 0; i < unbounded_.size(); ++i)
+  {
+    const moveit::core::JointModel* joint = unbounded_[i];
+    if (joint->getType() == moveit::core::JointModel::REVOLUTE ||
+        joint->getType() == moveit::core::JointModel::PRISMATIC)
+    {
+      const moveit::core::VariableBounds& joint_bounds = joint->getVariableBounds()[0];
+      interval_index_.push_back(uindex_[i]);
+      interval_min.push_back(joint_bounds.min_position_);
+      interval_range.push_back(joint_bounds.max_position_ - joint_bounds.min_position_);
+    }
+    else
+    {
+      random_joints_.push_back(joint);
+      random_index_.push_back(uindex_[i]);
+    }
+  }
+  for (const JointInfo& bound : bounds_)
+  {
+    interval_index_.push_back(bound.index_);
+    interval_min.push_back(bound.min_bound_);
+    interval_range.push_back(bound.max_bound_ - bound.min_bound_);
+  }
+  interval_min_ = Eigen::Map<Eigen::ArrayXd>(interval_min.data(), interval_min.size());
+  interval_range_ = Eigen::Map<Eigen::ArrayXd>(interval_range.data(), interval_range.size());
+
   values_.resize(jmg_->getVariableCount());
   is_valid_ = true;
   return true;
@@ -171,19 +202,13 @@ bool JointConstraintSampler::sample(moveit::core::RobotState& state,
     return false;
   }
 
-  // sample the unbounded joints first (in case some joint variables are bounded)
-  std::vector<double> v;
-  for (std::size_t i = 0; i < unbounded_.size(); ++i)
-  {
-    v.resize(unbounded_[i]->getVariableCount());
-    unbounded_[i]->getVariableRandomPositions(random_number_generator_, &v[0]);
-    for (std::size_t j = 0; j < v.size(); ++j)
-      values_[uindex_[i] + j] = v[j];
-  }
+  // sample the joints without intervals first (in case some joint variables are bounded)
+  for (std::size_t i = 0; i < random_joints_.size(); ++i)
+    random_joints_[i]->getVariableRandomPositions(random_number_generator_, &values_[random_index_[i]]);
 
-  // enforce the constraints for the constrained components (could be all of them)
-  for (const JointInfo& bound : bounds_)
-    values_[bound.index_] = random_number_generator_.uniformReal(bound.min_bound_, bound.max_bound_);
+  // sample the intervals, which enforce the constraints for the constrained components (could be all of them)
+  for (std::size_t k = 0; k < interval_index_.size(); ++k)
+    values_[interval_index_[k]] = interval_min_[k] + interval_range_[k] * fast_random_generator_.uniform01();
 
   state.setJointGroupPositions(jmg_, values_);
 
@@ -191,6 +216,30 @@ bool JointConstraintSampler::sample(moveit::core::RobotState& state,
   return true;
 }
 
+bool JointConstraintSampler::sampleBatch(std::size_t count, Eigen::MatrixXd& values)
+{
+  if (!is_valid_)
+  {
+    ROS_WARN_NAMED("constraint_samplers", "JointConstraintSampler not configured, won't sample");
+    return false;
+  }
+
+  values.resize(jmg_->getVariableCount(), count);
+  for (std::size_t c = 0; c < count; ++c)
+    for (std::size_t i = 0; i < random_joints_.size(); ++i)
+      random_joints_[i]->getVariableRandomPositions(random_number_generator_, values.col(c).data() + random_index_[i]);
+
+  // draw the uniform numbers for all samples first, then scale them to the intervals in one pass
+  Eigen::ArrayXXd uniform(interval_index_.size(), count);
+  for (Eigen::Index c = 0; c < uniform.cols(); ++c)
+    for (Eigen::Index k = 0; k < uniform.rows(); ++k)
+      uniform(k, c) = fast_random_generator_.uniform01();
+  uniform = (uniform.colwise() * interval_range_).colwise() + interval_min_;
+  for (std::size_t k = 0; k < interval_index_.size(); ++k)
+    values.row(interval_index_[k]) = uniform.row(k).matrix();
+  return true;
+}
+
 void JointConstraintSampler::clear()
 {
   ConstraintSampler::clear();
@@ -198,6 +247,11 @@ void JointConstraintSampler::clear()
   unbounded_.clear();
   uindex_.clear();
   values_.clear();
+  interval_index_.clear();
+  interval_min_.resize(0);
+  interval_range_.resize(0);
+  random_joints_.clear();
+  random_index_.clear();
 }
 
 IKSamplingPose::IKSamplingPose()
@@ -556,12 +610,67 @@ void samplingIkCallbackFnAdapter(moveit::core::RobotState* state, const moveit::
 }
 }  // namespace
 
+void IKConstraintSampler::loadIKBatchParameters()
+{
+  int value;
+  if (ros::param::get("~ik_constraint_sampler_batch_size", value) && value > 0)
+    ik_batch_size_ = value;
+  if (ros::param::get("~ik_constraint_sampler_batch_threads", value) && value >= 0)
+    ik_batch_threads_ = value;
+}
+
 bool IKConstraintSampler::sample(moveit::core::RobotState& state, const moveit::core::RobotState& reference_state,
                                  unsigned int max_attempts)
 {
+  if (ik_batch_size_ > 1)
+    return sampleBatchHelper(state, reference_state, max_attempts);
   return sampleHelper(state, reference_state, max_attempts);
 }
 
+bool IKConstraintSampler::sampleIKQuery(geometry_msgs::Pose& ik_query, const moveit::core::RobotState& reference_state,
+                                        unsigned int max_attempts)
+{
+  // sample a point in the constraint region
+  Eigen::Vector3d point;
+  Eigen::Quaterniond quat;  // quat is normalized by contract
+  if (!samplePose(point, quat, reference_state, max_attempts))
+  {
+    if (verbose_)
+      ROS_INFO_NAMED("constraint_samplers", "IK constraint sampler was unable to produce a pose to run IK for");
+    return false;
+  }
+
+  // we now have the transform we wish to perform IK for, in the planning frame
+  if (transform_ik_)
+  {
+    // we need to convert this transform to the frame expected by the IK solver
+    // both the planning frame and the frame for the IK are assumed to be robot links
+    Eigen::Isometry3d ikq(Eigen::Translation3d(point) * quat);  // valid isometry by construction
+    // getFrameTransform() returns a valid isometry by contract
+    ikq = reference_state.getFrameTransform(ik_frame_).inverse() * ikq;  // valid isometry * valid isometry
+    point = ikq.translation();
+    quat = Eigen::Quaterniond(ikq.linear());  // ikq is isometry, so quat is normalized
+  }
+
+  if (need_eef_to_ik_tip_transform_)
+  {
+    // After sampling the pose needs to be transformed to the ik chain tip
+    Eigen::Isometry3d ikq(Eigen::Translation3d(point) * quat);  // valid isometry by construction
+    ikq = ikq * eef_to_ik_tip_transform_;  // eef_to_ik_tip_transform_ is valid isometry (checked in loadIKSolver())
+    point = ikq.translation();
+    quat = Eigen::Quaterniond(ikq.linear());  // ikq is isometry, so quat is normalized
+  }
+
+  ik_query.position.x = point.x();
+  ik_query.position.y = point.y();
+  ik_query.position.z = point.z();
+  ik_query.orientation.x = quat.x();
+  ik_query.orientation.y = quat.y();
+  ik_query.orientation.z = quat.z();
+  ik_query.orientation.w = quat.w();
+  return true;
+}
+
 bool IKConstraintSampler::sampleHelper(moveit::core::RobotState& state, const moveit::core::RobotState& reference_state,
                                        unsigned int max_attempts)
 {
@@ -581,48 +690,73 @@ bool IKConstraintSampler::sampleHelper(moveit::core::RobotState& state, const mo
 
   for (unsigned int a = 0; a < max_attempts; ++a)
   {
-    // sample a point in the constraint region
-    Eigen::Vector3d point;
-    Eigen::Quaterniond quat;  // quat is normalized by contract
-    if (!samplePose(point, quat, reference_state, max_attempts))
-    {
-      if (verbose_)
-        ROS_INFO_NAMED("constraint_samplers", "IK constraint sampler was unable to produce a pose to run IK for");
+    geometry_msgs::Pose ik_query;
+    if (!sampleIKQuery(ik_query, reference_state, max_attempts))
       return false;
-    }
 
-    // we now have the transform we wish to perform IK for, in the planning frame
-    if (transform_ik_)
-    {
-      // we need to convert this transform to the frame expected by the IK solver
-      // both the planning frame and the frame for the IK are assumed to be robot links
-      Eigen::Isometry3d ikq(Eigen::Translation3d(point) * quat);  // valid isometry by construction
-      // getFrameTransform() returns a valid isometry by contract
-      ikq = reference_state.getFrameTransform(ik_frame_).inverse() * ikq;  // valid isometry * valid isometry
-      point = ikq.translation();
-      quat = Eigen::Quaterniond(ikq.linear());  // ikq is isometry, so quat is normalized
-    }
+    if (callIK(ik_query, adapted_ik_validity_callback, ik_timeout_, state, a == 0))
+      return true;
+  }
+  return false;
+}
 
-    if (need_eef_to_ik_tip_transform_)
+bool IKConstraintSampler::sampleBatchHelper(moveit::core::RobotState& state,
+                                            const moveit::core::RobotState& reference_state, unsigned int max_attempts)
+{
+  if (!is_valid_)
+  {
+    ROS_WARN_NAMED("constraint_samplers", "IKConstraintSampler not configured, won't sample");
+    return false;
+  }
+
+  const std::vector<unsigned int>& ik_joint_bijection = jmg_->getKinematicsSolverJointBijection();
+  const std::size_t dof = ik_joint_bijection.size();
+  std::vector<geometry_msgs::Pose> ik_queries;
+  std::vector<double> seeds;
+  std::vector<double> solutions;
+  std::vector<bool> found;
+  std::vector<double> vals;
+  std::vector<double> solution(dof);
+
+  for (unsigned int a = 0; a < max_attempts;)
+  {
+    // generate the poses and seeds of the whole batch
+    const unsigned int batch_size = std::min(ik_batch_size_, max_attempts - a);
+    ik_queries.resize(batch_size);
+    seeds.resize(batch_size * dof);
+    for (unsigned int b = 0; b < batch_size; ++b, ++a)
     {
-      // After sampling the pose needs to be transformed to the ik chain tip
-      Eigen::Isometry3d ikq(Eigen::Translation3d(point) * quat);  // valid isometry by construction
-      ikq = ikq * eef_to_ik_tip_transform_;  // eef_to_ik_tip_transform_ is valid isometry (checked in loadIKSolver())
-      point = ikq.translation();
-      quat = Eigen::Quaterniond(ikq.linear());  // ikq is isometry, so quat is normalized
+      if (!sampleIKQuery(ik_queries[b], reference_state, max_attempts))
+        return false;
+
+      // as in the sequential search, the first attempt is seeded with the current state
+      if (a == 0)
+        state.copyJointGroupPositions(jmg_, vals);
+      else
+        jmg_->getVariableRandomPositions(random_number_generator_, vals);
+      assert(vals.size() == dof);
+      for (std::size_t i = 0; i < dof; ++i)
+        seeds[b * dof + i] = vals[ik_joint_bijection[i]];
     }
 
-    geometry_msgs::Pose ik_query;
-    ik_query.position.x = point.x();
-    ik_query.position.y = point.y();
-    ik_query.position.z = point.z();
-    ik_query.orientation.x = quat.x();
-    ik_query.orientation.y = quat.y();
-    ik_query.orientation.z = quat.z();
-    ik_query.orientation.w = quat.w();
+    kb_->searchPositionIKBatch(ik_queries, seeds, ik_timeout_, solutions, found, kinematics::KinematicsQueryOptions(),
+                               ik_batch_threads_);
 
-    if (callIK(ik_query, adapted_ik_validity_callback, ik_timeout_, state, a == 0))
-      return true;
+    // filter the solutions by the validity callback and the constraints in one pass
+    for (unsigned int b = 0; b < batch_size; ++b)
+    {
+      if (!found[b])
+        continue;
+      for (std::size_t i = 0; i < dof; ++i)
+        solution[ik_joint_bijection[i]] = solutions[b * dof + i];
+      if (group_state_validity_callback_ && !group_state_validity_callback_(&state, jmg_, solution.data()))
+        continue;
+      state.setJointGroupPositions(jmg_, solution);
+      if (validate(state))
+        return true;
+    }
+    if (verbose_)
+      ROS_INFO_NAMED("constraint_samplers", "No valid IK solution in a batch of %u poses", batch_size);
   }
   return false;
 }
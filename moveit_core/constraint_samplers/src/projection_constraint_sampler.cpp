@@ -0,0 +1,317 @@
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2026, PickNik LLC.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of PickNik LLC nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *********************************************************************/
+
+#include <moveit/constraint_samplers/projection_constraint_sampler.h>
+#include <geometric_shapes/bodies.h>
+#include <Eigen/Geometry>
+#include <algorithm>
+#include <limits>
+
+namespace constraint_samplers
+{
+namespace
+{
+// damping of the least-squares steps, keeps them bounded close to singularities
+constexpr double DAMPING = 1e-4;
+// largest change of the group values (in the variables' units) taken in a single step
+constexpr double MAX_STEP_NORM = 0.5;
+// steps smaller than this are considered as converged to a point that does not satisfy the constraints
+constexpr double MIN_STEP_NORM = 1e-9;
+
+// radius of a ball around the region center that is contained in the region, 0 if it is not known
+double computeInscribedRadius(const bodies::Body& body)
+{
+  const std::vector<double> dimensions = body.getDimensions();
+  switch (body.getType())
+  {
+    case shapes::SPHERE:
+      return dimensions[0];
+    case shapes::BOX:
+      return 0.5 * std::min(dimensions[0], std::min(dimensions[1], dimensions[2]));
+    case shapes::CYLINDER:
+      return std::min(dimensions[0], 0.5 * dimensions[1]);
+    default:
+      return 0.0;
+  }
+}
+}  // namespace
+
+bool ProjectionConstraintSampler::configure(const moveit_msgs::Constraints& constr)
+{
+  clear();
+
+  if (!jmg_)
+  {
+    ROS_ERROR_NAMED("constraint_samplers", "NULL group specified for constraint sampler");
+    return false;
+  }
+
+  if (!jmg_->isChain())
+  {
+    ROS_DEBUG_NAMED("constraint_samplers", "Group '%s' is not a chain, projection is not available",
+                    jmg_->getName().c_str());
+    return false;
+  }
+
+  for (const moveit_msgs::PositionConstraint& position_constraint : constr.position_constraints)
+  {
+    kinematic_constraints::PositionConstraintPtr pc(
+        new kinematic_constraints::PositionConstraint(scene_->getRobotModel()));
+    if (!pc->configure(position_constraint, scene_->getTransforms()) || !pc->enabled() ||
+        !jmg_->isLinkUpdated(pc->getLinkModel()->getName()))
+      continue;
+
+    // aim for half the inscribed radius of the closest region, so projected states are not on the boundary
+    double margin = std::numeric_limits<double>::infinity();
+    for (const bodies::BodyPtr& body : pc->getConstraintRegions())
+      margin = std::min(margin, 0.5 * computeInscribedRadius(*body));
+    position_margins_.push_back(margin);
+    if (pc->mobileReferenceFrame())
+      frame_depends_.push_back(pc->getReferenceFrame());
+    position_constraints_.push_back(pc);
+  }
+
+  for (const moveit_msgs::OrientationConstraint& orientation_constraint : constr.orientation_constraints)
+  {
+    kinematic_constraints::OrientationConstraintPtr oc(
+        new kinematic_constraints::OrientationConstraint(scene_->getRobotModel()));
+    if (!oc->configure(orientation_constraint, scene_->getTransforms()) || !oc->enabled() ||
+        !jmg_->isLinkUpdated(oc->getLinkModel()->getName()))
+      continue;
+    if (oc->mobileReferenceFrame())
+      frame_depends_.push_back(oc->getReferenceFrame());
+    orientation_constraints_.push_back(oc);
+  }
+
+  if (position_constraints_.empty() && orientation_constraints_.empty())
+  {
+    ROS_DEBUG_NAMED("constraint_samplers", "No position or orientation constraints on links of group '%s'",
+                    jmg_->getName().c_str());
+    clear();
+    return false;
+  }
+
+  for (const moveit_msgs::JointConstraint& joint_constraint : constr.joint_constraints)
+  {
+    kinematic_constraints::JointConstraint jc(scene_->getRobotModel());
+    if (!jc.configure(joint_constraint) || !jc.enabled())
+      continue;
+    const std::vector<std::string>& variables = jmg_->getVariableNames();
+    if (std::find(variables.begin(), variables.end(), jc.getJointVariableName()) == variables.end())
+      continue;
+    joint_constraint_indices_.push_back(jmg_->getVariableGroupIndex(jc.getJointVariableName()));
+    joint_constraints_.push_back(jc);
+  }
+
+  ROS_DEBUG_NAMED("constraint_samplers",
+                  "Projection sampler for group '%s' uses %zu position, %zu orientation and %zu joint constraints",
+                  jmg_->getName().c_str(), position_constraints_.size(), orientation_constraints_.size(),
+                  joint_constraints_.size());
+  is_valid_ = true;
+  return true;
+}
+
+bool ProjectionConstraintSampler::sample(moveit::core::RobotState& state,
+                                         const moveit::core::RobotState& reference_state, unsigned int max_attempts)
+{
+  if (!is_valid_)
+  {
+    ROS_WARN_NAMED("constraint_samplers", "ProjectionConstraintSampler not configured, won't sample");
+    return false;
+  }
+
+  if (&state != &reference_state)
+    state = reference_state;
+
+  std::vector<double> values;
+  for (unsigned int a = 0; a < max_attempts; ++a)
+  {
+    if (a > 0)
+      state.setToRandomPositions(jmg_, random_number_generator_);
+    if (!project(state))
+      continue;
+
+    if (group_state_validity_callback_)
+    {
+      state.copyJointGroupPositions(jmg_, values);
+      if (!group_state_validity_callback_(&state, jmg_, values.data()))
+        continue;
+    }
+    return true;
+  }
+  return false;
+}
+
+bool ProjectionConstraintSampler::project(moveit::core::RobotState& state, unsigned int max_iterations) const
+{
+  if (!is_valid_)
+    return false;
+
+  Eigen::VectorXd residual;
+  Eigen::MatrixXd jacobian;
+  Eigen::VectorXd values;
+  state.copyJointGroupPositions(jmg_, values);
+  state.updateLinkTransforms();
+  for (unsigned int i = 0; i < max_iterations; ++i)
+  {
+    if (decide(state))
+      return true;
+    if (!computeResidual(state, residual, jacobian))
+      return false;
+
+    // damped least-squares step towards the targets of the violated constraints
+    const Eigen::MatrixXd jjt =
+        jacobian * jacobian.transpose() + DAMPING * Eigen::MatrixXd::Identity(jacobian.rows(), jacobian.rows());
+    Eigen::VectorXd step = -jacobian.transpose() * jjt.ldlt().solve(residual);
+    const double step_norm = step.norm();
+    if (step_norm < MIN_STEP_NORM)
+      return false;
+    if (step_norm > MAX_STEP_NORM)
+      step *= MAX_STEP_NORM / step_norm;
+    values += step;
+
+    for (std::size_t j = 0; j < joint_constraints_.size(); ++j)
+    {
+      const kinematic_constraints::JointConstraint& jc = joint_constraints_[j];
+      values[joint_constraint_indices_[j]] =
+          std::max(jc.getDesiredJointPosition() - jc.getJointToleranceBelow(),
+                   std::min(jc.getDesiredJointPosition() + jc.getJointToleranceAbove(),
+                            static_cast<double>(values[joint_constraint_indices_[j]])));
+    }
+    state.setJointGroupPositions(jmg_, values);
+    state.enforceBounds(jmg_);
+    state.copyJointGroupPositions(jmg_, values);
+    state.updateLinkTransforms();
+  }
+  return decide(state);
+}
+
+bool ProjectionConstraintSampler::decide(const moveit::core::RobotState& state) const
+{
+  for (const kinematic_constraints::PositionConstraintPtr& pc : position_constraints_)
+    if (!pc->decide(state).satisfied)
+      return false;
+  for (const kinematic_constraints::OrientationConstraintPtr& oc : orientation_constraints_)
+    if (!oc->decide(state).satisfied)
+      return false;
+  for (const kinematic_constraints::JointConstraint& jc : joint_constraints_)
+    if (!jc.decide(state).satisfied)
+      return false;
+  return true;
+}
+
+bool ProjectionConstraintSampler::computeResidual(const moveit::core::RobotState& state, Eigen::VectorXd& residual,
+                                                  Eigen::MatrixXd& jacobian) const
+{
+  const Eigen::Index rows = 3 * (position_constraints_.size() + orientation_constraints_.size());
+  residual = Eigen::VectorXd::Zero(rows);
+  jacobian = Eigen::MatrixXd::Zero(rows, jmg_->getVariableCount());
+
+  // the group Jacobian is expressed in the frame of the parent link of the chain's root joint
+  const moveit::core::LinkModel* root_link = jmg_->getJointModels()[0]->getParentLinkModel();
+  const Eigen::Matrix3d root_rotation =
+      root_link ? state.getGlobalLinkTransform(root_link).linear() : Eigen::Matrix3d::Identity();
+
+  Eigen::MatrixXd link_jacobian;
+  Eigen::Index row = 0;
+  for (std::size_t i = 0; i < position_constraints_.size(); ++i, row += 3)
+  {
+    const kinematic_constraints::PositionConstraint& pc = *position_constraints_[i];
+    if (pc.decide(state).satisfied)
+      continue;
+
+    const Eigen::Isometry3d& link_transform = state.getGlobalLinkTransform(pc.getLinkModel());
+    const Eigen::Vector3d point =
+        pc.hasLinkOffset() ? link_transform * pc.getLinkOffset() : link_transform.translation();
+
+    // head for the closest region center; the region poses are relative to the reference frame if it is mobile
+    Eigen::Vector3d error = Eigen::Vector3d::Zero();
+    double closest = std::numeric_limits<double>::infinity();
+    for (const bodies::BodyPtr& body : pc.getConstraintRegions())
+    {
+      const Eigen::Vector3d center =
+          pc.mobileReferenceFrame() ? state.getFrameTransform(pc.getReferenceFrame()) * body->getPose().translation() :
+                                      body->getPose().translation();
+      const Eigen::Vector3d difference = point - center;
+      if (difference.squaredNorm() < closest)
+      {
+        closest = difference.squaredNorm();
+        error = difference;
+      }
+    }
+    const double distance = error.norm();
+    if (distance <= position_margins_[i])
+      continue;
+    residual.segment<3>(row) = error * (1.0 - position_margins_[i] / distance);
+
+    if (!state.getJacobian(jmg_, pc.getLinkModel(), pc.getLinkOffset(), link_jacobian))
+      return false;
+    jacobian.middleRows<3>(row) = root_rotation * link_jacobian.topRows<3>();
+  }
+
+  for (const kinematic_constraints::OrientationConstraintPtr& oc : orientation_constraints_)
+  {
+    if (!oc->decide(state).satisfied)
+    {
+      Eigen::Matrix3d desired = oc->getDesiredRotationMatrix();
+      if (oc->mobileReferenceFrame())
+        desired = state.getFrameTransform(oc->getReferenceFrame()).linear() * desired;
+
+      // rotation vector of the error in the desired frame, steered into half the tolerance around each axis
+      const Eigen::AngleAxisd error_rotation(desired.transpose() *
+                                             state.getGlobalLinkTransform(oc->getLinkModel()).linear());
+      const Eigen::Vector3d error = error_rotation.angle() * error_rotation.axis();
+      const Eigen::Vector3d bound =
+          0.5 * Eigen::Vector3d(oc->getXAxisTolerance(), oc->getYAxisTolerance(), oc->getZAxisTolerance());
+      residual.segment<3>(row) = error - error.cwiseMax(-bound).cwiseMin(bound);
+
+      if (!state.getJacobian(jmg_, oc->getLinkModel(), Eigen::Vector3d::Zero(), link_jacobian))
+        return false;
+      jacobian.middleRows<3>(row) = desired.transpose() * root_rotation * link_jacobian.bottomRows<3>();
+    }
+    row += 3;
+  }
+  return true;
+}
+
+void ProjectionConstraintSampler::clear()
+{
+  ConstraintSampler::clear();
+  position_constraints_.clear();
+  position_margins_.clear();
+  orientation_constraints_.clear();
+  joint_constraints_.clear();
+  joint_constraint_indices_.clear();
+}
+}  // namespace constraint_samplers
@@ -37,6 +37,7 @@
 #include <moveit/planning_scene/planning_scene.h>
 #include <moveit/kinematic_constraints/kinematic_constraint.h>
 #include <moveit/constraint_samplers/default_constraint_samplers.h>
+#include <moveit/constraint_samplers/projection_constraint_sampler.h>
 #include <moveit/constraint_samplers/union_constraint_sampler.h>
 #include <moveit/constraint_samplers/constraint_sampler_manager.h>
 #include <moveit/constraint_samplers/constraint_sampler_tools.h>
@@ -252,6 +253,43 @@ TEST_F(LoadPlanningModelsPr2, JointConstraintsSamplerSimple)
   }
 }
 
+TEST_F(LoadPlanningModelsPr2, JointConstraintsSamplerBatch)
+{
+  kinematic_constraints::JointConstraint jc(robot_model_);
+  moveit_msgs::JointConstraint jcm;
+  jcm.joint_name = "r_shoulder_pan_joint";
+  jcm.position = 0.42;
+  jcm.tolerance_above = 0.01;
+  jcm.tolerance_below = 0.05;
+  jcm.weight = 1.0;
+  EXPECT_TRUE(jc.configure(jcm));
+  std::vector<kinematic_constraints::JointConstraint> js;
+  js.push_back(jc);
+
+  constraint_samplers::JointConstraintSampler jcs(ps_, "right_arm");
+  Eigen::MatrixXd values;
+  EXPECT_FALSE(jcs.sampleBatch(10, values));
+  EXPECT_TRUE(jcs.configure(js));
+
+  const moveit::core::JointModelGroup* jmg = robot_model_->getJointModelGroup("right_arm");
+  ASSERT_TRUE(jcs.sampleBatch(1000, values));
+  ASSERT_EQ(values.rows(), static_cast<Eigen::Index>(jmg->getVariableCount()));
+  ASSERT_EQ(values.cols(), 1000);
+
+  moveit::core::RobotState ks(robot_model_);
+  ks.setToDefaultValues();
+  for (Eigen::Index c = 0; c < values.cols(); ++c)
+  {
+    ks.setJointGroupPositions(jmg, values.col(c));
+    EXPECT_TRUE(ks.satisfiesBounds(jmg));
+    EXPECT_TRUE(jc.decide(ks).satisfied);
+  }
+  // the samples are spread over the constraint interval
+  const Eigen::Index index = jmg->getVariableGroupIndex("r_shoulder_pan_joint");
+  EXPECT_LT(values.row(index).minCoeff(), 0.38);
+  EXPECT_GT(values.row(index).maxCoeff(), 0.42);
+}
+
 TEST_F(LoadPlanningModelsPr2, IKConstraintsSamplerSimple)
 {
   moveit::core::Transforms& tf = ps_->getTransformsNonConst();
@@ -448,6 +486,18 @@ TEST_F(LoadPlanningModelsPr2, IKConstraintsSamplerValid)
     EXPECT_TRUE(iks3.sample(ks, ks_const, 100));
     EXPECT_TRUE(oc.decide(ks).satisfied);
   }
+
+  // sampling and solving the poses in batches
+  constraint_samplers::IKConstraintSampler iks4(ps_, "left_arm");
+  EXPECT_TRUE(iks4.configure(constraint_samplers::IKSamplingPose(pc, oc)));
+  iks4.setIKBatchSize(8, 2);
+  EXPECT_EQ(iks4.getIKBatchSize(), 8u);
+  for (int t = 0; t < 100; ++t)
+  {
+    EXPECT_TRUE(iks4.sample(ks, ks_const, 100));
+    EXPECT_TRUE(pc.decide(ks).satisfied);
+    EXPECT_TRUE(oc.decide(ks).satisfied);
+  }
 }
 
 TEST_F(LoadPlanningModelsPr2, UnionConstraintSampler)
@@ -1234,6 +1284,73 @@ TEST_F(LoadPlanningModelsPr2, IKConstraintsSamplerSeeded)
   EXPECT_FALSE((root_to_left_tool2 * root_to_left_tool3.inverse()).matrix().isIdentity(1e-7));
 }
 
+TEST_F(LoadPlanningModelsPr2, ProjectionConstraintSampler)
+{
+  moveit::core::RobotState ks(robot_model_);
+  ks.setToDefaultValues();
+  ks.update();
+  moveit::core::RobotState ks_const(robot_model_);
+  ks_const.setToDefaultValues();
+  ks_const.update();
+
+  moveit::core::Transforms& tf = ps_->getTransformsNonConst();
+
+  moveit_msgs::Constraints c;
+  c.position_constraints.resize(1);
+  moveit_msgs::PositionConstraint& pcm = c.position_constraints[0];
+  pcm.link_name = "l_wrist_roll_link";
+  pcm.header.frame_id = robot_model_->getModelFrame();
+  pcm.constraint_region.primitives.resize(1);
+  pcm.constraint_region.primitives[0].type = shape_msgs::SolidPrimitive::SPHERE;
+  pcm.constraint_region.primitives[0].dimensions.resize(1);
+  pcm.constraint_region.primitives[0].dimensions[0] = 0.05;
+  pcm.constraint_region.primitive_poses.resize(1);
+  pcm.constraint_region.primitive_poses[0].position.x = 0.55;
+  pcm.constraint_region.primitive_poses[0].position.y = 0.2;
+  pcm.constraint_region.primitive_poses[0].position.z = 1.25;
+  pcm.constraint_region.primitive_poses[0].orientation.w = 1.0;
+  pcm.weight = 1.0;
+
+  c.orientation_constraints.resize(1);
+  moveit_msgs::OrientationConstraint& ocm = c.orientation_constraints[0];
+  ocm.link_name = "l_wrist_roll_link";
+  ocm.header.frame_id = robot_model_->getModelFrame();
+  ocm.orientation.w = 1.0;
+  ocm.absolute_x_axis_tolerance = 0.2;
+  ocm.absolute_y_axis_tolerance = 0.1;
+  ocm.absolute_z_axis_tolerance = 0.4;
+  ocm.weight = 1.0;
+
+  kinematic_constraints::KinematicConstraintSet kset(robot_model_);
+  EXPECT_TRUE(kset.add(c, tf));
+
+  // the sampler needs a chain and at least one pose constraint
+  constraint_samplers::ProjectionConstraintSampler pcs(ps_, "left_arm");
+  EXPECT_FALSE(pcs.configure(moveit_msgs::Constraints()));
+  constraint_samplers::ProjectionConstraintSampler arms_pcs(ps_, "arms");
+  EXPECT_FALSE(arms_pcs.configure(c));
+  ASSERT_TRUE(pcs.configure(c));
+  EXPECT_EQ(pcs.getName(), "ProjectionConstraintSampler");
+
+  unsigned int succ = 0;
+  for (int t = 0; t < 100; ++t)
+  {
+    if (pcs.sample(ks, ks_const, 10))
+    {
+      EXPECT_TRUE(kset.decide(ks).satisfied);
+      ++succ;
+    }
+  }
+  EXPECT_GT(succ, 90u);
+
+  // states that start off the constraints (e.g. interpolated ones) are moved onto them
+  ks.setToDefaultValues();
+  ks.update();
+  EXPECT_FALSE(kset.decide(ks).satisfied);
+  if (pcs.project(ks))
+    EXPECT_TRUE(kset.decide(ks).satisfied);
+}
+
 int main(int argc, char** argv)
 {
   testing::InitGoogleTest(&argc, argv);
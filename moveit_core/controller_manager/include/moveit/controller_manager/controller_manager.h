@@ -38,6 +38,8 @@
 
 #include <vector>
 #include <string>
+#include <functional>
+#include <mutex>
 #include <moveit_msgs/RobotTrajectory.h>
 #include <moveit/macros/class_forward.h>
 
@@ -98,6 +100,22 @@ private:
   Value status_;
 };
 
+/// Progress of a trajectory execution, as reported by a controller while executing it
+struct ExecutionProgress
+{
+  /// Time along the trajectory of the currently desired point
+  ros::Duration time_from_start;
+
+  /// The joints the errors refer to
+  std::vector<std::string> joint_names;
+
+  /// Position tracking error (desired - actual) of each joint
+  std::vector<double> position_errors;
+};
+
+/// Callback receiving the progress reported by a controller
+using ExecutionProgressCallback = std::function<void(const ExecutionProgress&)>;
+
 MOVEIT_CLASS_FORWARD(MoveItControllerHandle);  // Defines MoveItControllerHandlePtr, ConstPtr, WeakPtr... etc
 
 /** \brief MoveIt sends commands to a controller via a handle that satisfies this interface. */
@@ -142,8 +160,35 @@ public:
   /** \brief Return the execution status of the last trajectory sent to the controller. */
   virtual ExecutionStatus getLastExecutionStatus() = 0;
 
+  /** \brief Set a callback receiving the progress reported by the controller while it executes a trajectory.
+   *
+   * The callback is invoked from the thread that receives controller feedback, as soon as feedback arrives.
+   * Controllers that do not report progress never invoke it. Pass an empty callback to remove it. */
+  void setProgressCallback(const ExecutionProgressCallback& callback)
+  {
+    std::lock_guard<std::mutex> lock(progress_callback_mutex_);
+    progress_callback_ = callback;
+  }
+
 protected:
+  /** \brief Forward \e progress to the progress callback, if any. To be called by implementations on feedback. */
+  void reportProgress(const ExecutionProgress& progress)
+  {
+    ExecutionProgressCallback callback;
+    {
+      std::lock_guard<std::mutex> lock(progress_callback_mutex_);
+      callback = progress_callback_;
+    }
+    // invoked without holding the lock, so that the callback may use this handle
+    if (callback)
+      callback(progress);
+  }
+
   std::string name_;
+
+private:
+  std::mutex progress_callback_mutex_;
+  ExecutionProgressCallback progress_callback_;
 };
 
 MOVEIT_CLASS_FORWARD(MoveItControllerManager);  // Defines MoveItControllerManagerPtr, ConstPtr, WeakPtr... etc
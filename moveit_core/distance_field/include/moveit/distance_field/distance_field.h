@@ -320,6 +320,42 @@ public:
    */
   double getDistanceGradient(double x, double y, double z, double& gradient_x, double& gradient_y, double& gradient_z,
                              bool& in_bounds) const;
+
+  /**
+   * \brief Batched version of \ref getDistanceGradient, giving the
+   * same results for each of the supplied points.
+   *
+   * All cells needed by the batch are looked up in a single pass
+   * through \ref getCellDistances, which derived classes implement
+   * without a virtual call per cell, and the gradients are then
+   * computed in a separate pass over contiguous arrays.
+   *
+   * @param [in] points The world locations to query
+   * @param [out] distances The distance at each point
+   * @param [out] gradients The gradient at each point
+   * @param [out] in_bounds Whether each point is valid for gradient purposes
+   */
+  void getDistanceGradients(const EigenSTL::vector_Vector3d& points, std::vector<double>& distances,
+                            EigenSTL::vector_Vector3d& gradients, std::vector<bool>& in_bounds) const;
+
+  /**
+   * \brief Gets distances and gradients by trilinear interpolation
+   * between the centers of the eight cells surrounding each point.
+   *
+   * Unlike \ref getDistanceGradient, which returns the distance of
+   * the cell containing a point and a central difference gradient, the
+   * result is continuous in the query location and the gradient is the
+   * exact derivative of the interpolated distance.
+   *
+   * @param [in] points The world locations to query
+   * @param [out] distances The interpolated distance at each point, or
+   * \ref getUninitializedDistance if the point is out of bounds
+   * @param [out] gradients The gradient of the interpolated distance, or
+   * zero if the point is out of bounds
+   * @param [out] in_bounds Whether all eight surrounding cells of each point are valid
+   */
+  void getInterpolatedDistanceGradients(const EigenSTL::vector_Vector3d& points, std::vector<double>& distances,
+                                        EigenSTL::vector_Vector3d& gradients, std::vector<bool>& in_bounds) const;
   /**
    * \brief Gets the distance to the closest obstacle at the given
    * integer cell location. The particulars of this function are
@@ -612,6 +648,18 @@ protected:
   void setPoint(int xCell, int yCell, int zCell, double dist, geometry_msgs::Point& point, std_msgs::ColorRGBA& color,
                 double max_distance) const;
 
+  /**
+   * \brief Gets the distances of a set of valid cells, as \ref
+   * getDistance(int, int, int) would.  Used by the batched queries;
+   * derived classes should override it to access their storage
+   * directly.
+   *
+   * @param [in] cells The cells to look up
+   * @param [in] count The number of cells
+   * @param [out] distances Array of \e count distances
+   */
+  virtual void getCellDistances(const Eigen::Vector3i* cells, std::size_t count, double* distances) const;
+
   double size_x_;            /**< \brief X size of the distance field */
   double size_y_;            /**< \brief Y size of the distance field */
   double size_z_;            /**< \brief Z size of the distance field */
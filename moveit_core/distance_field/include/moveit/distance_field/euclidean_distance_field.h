@@ -0,0 +1,183 @@
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2026, PickNik LLC.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of PickNik LLC nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *********************************************************************/
+
+#pragma once
+
+#include <moveit/distance_field/voxel_grid.h>
+#include <moveit/distance_field/distance_field.h>
+#include <vector>
+
+namespace distance_field
+{
+MOVEIT_CLASS_FORWARD(EuclideanDistanceField);  // Defines EuclideanDistanceFieldPtr, ConstPtr, WeakPtr... etc
+
+/**
+ * \brief A DistanceField that computes exact Euclidean distances with
+ * a separable distance transform.
+ *
+ * Unlike the PropagationDistanceField, which incrementally propagates
+ * distance changes through a bucket queue on a single thread, this
+ * field recomputes the whole squared distance transform every time
+ * obstacle cells are added or removed.  The transform runs the 1-D
+ * lower envelope algorithm of Felzenszwalb and Huttenlocher along the
+ * X, Y and Z axes in turn; the grid lines of every pass are
+ * independent and are distributed over a set of worker threads.  The
+ * cost of an update is therefore linear in the number of cells and
+ * independent of the number of changed obstacles, which makes this
+ * field a good fit when a field is regenerated from scratch for each
+ * planning request, while the PropagationDistanceField remains the
+ * better choice for small incremental changes.
+ *
+ * Distances are exact for the discretized obstacle cells and are
+ * capped at the maximum distance in the same way as in the
+ * PropagationDistanceField, so the two implementations can be used
+ * interchangeably.  The stream format of \ref writeToStream and
+ * \ref readFromStream is also shared with the PropagationDistanceField.
+ */
+class EuclideanDistanceField : public DistanceField
+{
+public:
+  /**
+   * \brief Constructor that initializes an empty field.
+   *
+   * @param [in] size_x The X dimension in meters of the volume to represent
+   * @param [in] size_y The Y dimension in meters of the volume to represent
+   * @param [in] size_z The Z dimension in meters of the volume to represent
+   * @param [in] resolution The resolution in meters of the volume
+   * @param [in] origin_x The minimum X point of the volume
+   * @param [in] origin_y The minimum Y point of the volume
+   * @param [in] origin_z The minimum Z point of the volume
+   * @param [in] max_distance Distances larger than this are reported as the maximum distance
+   * @param [in] propagate_negative_distances Whether to also compute the distance
+   * of obstacle cells to the closest free cell
+   * @param [in] threads The number of threads used for the distance
+   * transform; 0 uses one thread per hardware core
+   */
+  EuclideanDistanceField(double size_x, double size_y, double size_z, double resolution, double origin_x,
+                         double origin_y, double origin_z, double max_distance,
+                         bool propagate_negative_distances = false, unsigned int threads = 0);
+
+  /**
+   * \brief Constructor that reads a field saved with \ref writeToStream
+   * (or PropagationDistanceField::writeToStream) and computes its distances.
+   */
+  EuclideanDistanceField(std::istream& stream, double max_distance, bool propagate_negative_distances = false,
+                         unsigned int threads = 0);
+
+  void addPointsToField(const EigenSTL::vector_Vector3d& points) override;
+  void removePointsFromField(const EigenSTL::vector_Vector3d& points) override;
+
+  /**
+   * \brief Remove \e old_points and add \e new_points, recomputing
+   * the distance transform only once.
+   */
+  void updatePointsInField(const EigenSTL::vector_Vector3d& old_points,
+                           const EigenSTL::vector_Vector3d& new_points) override;
+
+  /**
+   * \brief Mark all cells as free.
+   */
+  void reset() override;
+
+  double getDistance(double x, double y, double z) const override;
+  double getDistance(int x, int y, int z) const override;
+
+  bool isCellValid(int x, int y, int z) const override;
+  int getXNumCells() const override;
+  int getYNumCells() const override;
+  int getZNumCells() const override;
+  bool gridToWorld(int x, int y, int z, double& world_x, double& world_y, double& world_z) const override;
+  bool worldToGrid(double world_x, double world_y, double world_z, int& x, int& y, int& z) const override;
+
+  bool writeToStream(std::ostream& stream) const override;
+  bool readFromStream(std::istream& stream) override;
+
+  double getUninitializedDistance() const override
+  {
+    return max_distance_;
+  }
+
+  /**
+   * \brief Squared distance in cells from cell (x, y, z) to the closest
+   * obstacle cell, capped at \ref getMaximumDistanceSquared.  The cell
+   * must be valid.
+   */
+  int getDistanceSquared(int x, int y, int z) const
+  {
+    return distance_grid_->getCell(x, y, z);
+  }
+
+  /**
+   * \brief Squared distance in cells from the obstacle cell (x, y, z)
+   * to the closest free cell, or 0 if negative distances are not
+   * computed or the cell is free.  The cell must be valid.
+   */
+  int getNegativeDistanceSquared(int x, int y, int z) const
+  {
+    return propagate_negative_ ? negative_distance_grid_->getCell(x, y, z) : 0;
+  }
+
+  /**
+   * \brief The squared maximum distance in cells
+   */
+  int getMaximumDistanceSquared() const
+  {
+    return max_distance_sq_;
+  }
+
+private:
+  /** \brief Allocate the grids for the current dimensions and mark all cells as free */
+  void initialize();
+
+  /** \brief Mark the valid cells of \e points as obstacles (\e occupied) or free; returns whether a cell changed */
+  bool setOccupancy(const EigenSTL::vector_Vector3d& points, bool occupied);
+
+  /** \brief Recompute the squared distances of all cells from the obstacle cells */
+  void computeTransform();
+
+  /** \brief Run the 1-D transform along dimension \e dim over all lines of \e grid */
+  void transformDimension(VoxelGrid<int>& grid, Dimension dim) const;
+
+  bool propagate_negative_;
+  unsigned int threads_;
+  double max_distance_;
+  int max_distance_sq_;
+
+  /** \brief Squared distance to the closest obstacle cell; obstacle cells hold 0 */
+  VoxelGrid<int>::Ptr distance_grid_;
+  /** \brief Squared distance of obstacle cells to the closest free cell, if negative distances are computed */
+  VoxelGrid<int>::Ptr negative_distance_grid_;
+  std::vector<double> sqrt_table_;
+};
+}  // namespace distance_field
@@ -38,6 +38,8 @@
 
 #include <moveit/distance_field/voxel_grid.h>
 #include <moveit/distance_field/distance_field.h>
+#include <cstdint>
+#include <string>
 #include <vector>
 #include <Eigen/Core>
 #include <set>
@@ -161,10 +163,15 @@ public:
    * \ref PropagationDistanceField description for more information on
    * the implications of this.
    *
+   * @param [in] sparse_storage Whether to store the voxels in sparse
+   * blocks that are only allocated close to obstacles (see \ref
+   * VoxelGrid).  This keeps the memory use of large, mostly empty
+   * volumes proportional to the obstacle surface.
+   *
    */
   PropagationDistanceField(double size_x, double size_y, double size_z, double resolution, double origin_x,
                            double origin_y, double origin_z, double max_distance,
-                           bool propagate_negative_distances = false);
+                           bool propagate_negative_distances = false, bool sparse_storage = false);
 
   /**
    * \brief Constructor based on an OcTree and bounding box
@@ -187,10 +194,13 @@ public:
    * and all obstacle cells will be assigned zero distance.  See the
    * \ref PropagationDistanceField description for more information on
    * the implications of this.
+   *
+   * @param [in] sparse_storage Whether to store the voxels in sparse
+   * blocks that are only allocated close to obstacles
    */
   PropagationDistanceField(const octomap::OcTree& octree, const octomap::point3d& bbx_min,
                            const octomap::point3d& bbx_max, double max_distance,
-                           bool propagate_negative_distances = false);
+                           bool propagate_negative_distances = false, bool sparse_storage = false);
 
   /**
    * \brief Constructor that takes an istream and reads the contents
@@ -368,6 +378,40 @@ public:
    */
   bool readFromStream(std::istream& stream) override;
 
+  /**
+   * \brief Writes the complete voxel data, including all propagated
+   * distances and closest points, to a binary file.
+   *
+   * Unlike \ref writeToStream, which only stores the obstacle cells
+   * and requires propagation when reading, the file can be loaded back
+   * with \ref readFromBinaryFile by mapping it into memory and copying
+   * the voxels, without any propagation.
+   *
+   * @param [in] filename The file to write
+   * @param [in] key A caller-defined identifier of the obstacles the
+   * field was computed from, e.g. a hash of the obstacle points
+   *
+   * @return True if the file was written successfully; otherwise False.
+   */
+  bool writeToBinaryFile(const std::string& filename, std::uint64_t key) const;
+
+  /**
+   * \brief Replaces the voxel data with that of a file written by
+   * \ref writeToBinaryFile.
+   *
+   * The file is memory mapped and only accepted if it was written with
+   * the same \e key for a field with the same number of cells,
+   * resolution, origin, maximum distance and negative propagation
+   * setting.
+   *
+   * @param [in] filename The file to read
+   * @param [in] key The identifier the file must have been written with
+   *
+   * @return True if the voxel data was replaced; False, leaving the
+   * field unchanged, if the file is missing or does not match.
+   */
+  bool readFromBinaryFile(const std::string& filename, std::uint64_t key);
+
   // passthrough docs to DistanceField
   double getUninitializedDistance() const override
   {
@@ -387,7 +431,7 @@ public:
    */
   const PropDistanceFieldVoxel& getCell(int x, int y, int z) const
   {
-    return voxel_grid_->getCell(x, y, z);
+    return constVoxelGrid().getCell(x, y, z);
   }
 
   /**
@@ -410,19 +454,19 @@ public:
    */
   const PropDistanceFieldVoxel* getNearestCell(int x, int y, int z, double& dist, Eigen::Vector3i& pos) const
   {
-    const PropDistanceFieldVoxel* cell = &voxel_grid_->getCell(x, y, z);
+    const PropDistanceFieldVoxel* cell = &constVoxelGrid().getCell(x, y, z);
     if (cell->distance_square_ > 0)
     {
       dist = sqrt_table_[cell->distance_square_];
       pos = cell->closest_point_;
-      const PropDistanceFieldVoxel* ncell = &voxel_grid_->getCell(pos.x(), pos.y(), pos.z());
+      const PropDistanceFieldVoxel* ncell = &constVoxelGrid().getCell(pos.x(), pos.y(), pos.z());
       return ncell == cell ? nullptr : ncell;
     }
     if (cell->negative_distance_square_ > 0)
     {
       dist = -sqrt_table_[cell->negative_distance_square_];
       pos = cell->closest_negative_point_;
-      const PropDistanceFieldVoxel* ncell = &voxel_grid_->getCell(pos.x(), pos.y(), pos.z());
+      const PropDistanceFieldVoxel* ncell = &constVoxelGrid().getCell(pos.x(), pos.y(), pos.z());
       return ncell == cell ? nullptr : ncell;
     }
     dist = 0.0;
@@ -495,6 +539,12 @@ private:
    */
   virtual double getDistance(const PropDistanceFieldVoxel& object) const;
 
+  /**
+   * \brief Looks up the voxels of a batch of cells directly in the
+   * voxel grid, prefetching cells ahead of the one being read
+   */
+  void getCellDistances(const Eigen::Vector3i* cells, std::size_t count, double* distances) const override;
+
   /**
    * \brief Helper function to get a single number in a 27 connected
    * 3D voxel grid given dx, dy, and dz values.
@@ -539,9 +589,16 @@ private:
   void print(const EigenSTL::vector_Vector3d& points);
 
   bool propagate_negative_; /**< \brief Whether or not to propagate negative distances */
+  bool sparse_storage_;     /**< \brief Whether the voxel grid uses sparse block storage */
 
   VoxelGrid<PropDistanceFieldVoxel>::Ptr voxel_grid_; /**< \brief Actual container for distance data */
 
+  /** \brief Read-only view of the voxel grid; reads through it never allocate blocks of sparse grids */
+  const VoxelGrid<PropDistanceFieldVoxel>& constVoxelGrid() const
+  {
+    return *voxel_grid_;
+  }
+
   /// \brief Structure used to hold propagation frontier
   std::vector<EigenSTL::vector_Vector3i> bucket_queue_; /**< \brief Data member that holds points from which to
                                                               propagate, where each vector holds points that are a
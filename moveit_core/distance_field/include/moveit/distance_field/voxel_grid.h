@@ -39,6 +39,8 @@
 #include <algorithm>
 #include <cmath>
 #include <Eigen/Core>
+#include <memory>
+#include <vector>
 #include <moveit/macros/declare_ptr.h>
 
 namespace distance_field
@@ -87,9 +89,16 @@ public:
    *
    * @param [in] default_object An object that will be returned for any
    * future queries that are not valid
+   *
+   * @param [in] sparse If true, cells are stored in blocks of
+   * BLOCK_SIZE^3 cells that are only allocated once one of their cells
+   * is accessed for writing.  Cells of unallocated blocks read as the
+   * value given to the last \ref reset (or \e default_object).  This
+   * trades a second indirection per access for memory proportional to
+   * the touched volume, which pays off for large, mostly empty grids.
    */
   VoxelGrid(double size_x, double size_y, double size_z, double resolution, double origin_x, double origin_y,
-            double origin_z, T default_object);
+            double origin_z, T default_object, bool sparse = false);
   virtual ~VoxelGrid();
 
   /**
@@ -116,9 +125,11 @@ public:
    * @param [in] origin_x Minimum point along the X axis of the volume
    * @param [in] origin_y Minimum point along the Y axis of the volume
    * @param [in] origin_z Minimum point along the Z axis of the volume
+   *
+   * @param [in] sparse Whether to use sparse block storage, see \ref VoxelGrid
    */
   void resize(double size_x, double size_y, double size_z, double resolution, double origin_x, double origin_y,
-              double origin_z, T default_object);
+              double origin_z, T default_object, bool sparse = false);
 
   /**
    * \brief Operator that gets the value of the given location (x, y,
@@ -151,7 +162,8 @@ public:
    * @param [in] z The Z index of the desired cell
    *
    * @return The data in the indicated cell.  If x,y,z is invalid then
-   * corruption and/or SEGFAULTS will occur.
+   * corruption and/or SEGFAULTS will occur.  For sparse grids the
+   * non-const versions allocate the block of the cell.
    */
   T& getCell(int x, int y, int z);
   T& getCell(const Eigen::Vector3i& pos);
@@ -182,10 +194,25 @@ public:
   /**
    * \brief Sets every cell in the voxel grid to the supplied data
    *
+   * For sparse grids this releases all blocks.
+   *
    * @param [in] initial The template variable to which to set the data
    */
   void reset(const T& initial);
 
+  /**
+   * \brief Whether the grid uses sparse block storage
+   */
+  bool isSparse() const
+  {
+    return sparse_;
+  }
+
+  /**
+   * \brief The number of allocated blocks of a sparse grid, 0 for dense grids
+   */
+  std::size_t getAllocatedBlockCount() const;
+
   /**
    * \brief Gets the size in arbitrary units of the indicated dimension
    *
@@ -285,7 +312,13 @@ public:
    */
   bool isCellValid(Dimension dim, int cell) const;
 
+  /** \brief Number of cells along each edge of a block of a sparse grid */
+  static constexpr int BLOCK_SIZE = 8;
+
 protected:
+  static constexpr int BLOCK_SHIFT = 3;
+  static constexpr int BLOCK_MASK = BLOCK_SIZE - 1;
+
   T* data_;                /**< \brief Storage for the full set of data elements */
   T default_object_;       /**< \brief The default object to return in case of out-of-bounds query */
   T*** data_ptrs_;         /**< \brief 3D array of pointers to the data elements */
@@ -299,6 +332,26 @@ protected:
   int stride1_;            /**< \brief The step to take when stepping between consecutive X members in the 1D array */
   int stride2_; /**< \brief The step to take when stepping between consecutive Y members given an X in the 1D array */
 
+  bool sparse_;                              /**< \brief Whether cells are stored in blocks_ instead of data_ */
+  std::vector<std::unique_ptr<T[]>> blocks_; /**< \brief Blocks of a sparse grid, null until written */
+  T background_;                             /**< \brief The value of the cells of unallocated blocks */
+  int num_blocks_[3];                        /**< \brief The number of blocks in each dimension */
+
+  /**
+   * \brief Gets the index of the block of a cell of a sparse grid, with no validity check.
+   */
+  int blockRef(int x, int y, int z) const;
+
+  /**
+   * \brief Gets the index of a cell within its block, with no validity check.
+   */
+  int blockOffset(int x, int y, int z) const;
+
+  /**
+   * \brief Gets a cell of a sparse grid, allocating its block if needed.
+   */
+  T& getSparseCell(int x, int y, int z);
+
   /**
    * \brief Gets the 1D index into the array, with no validity check.
    *
@@ -340,14 +393,14 @@ protected:
 
 template <typename T>
 VoxelGrid<T>::VoxelGrid(double size_x, double size_y, double size_z, double resolution, double origin_x,
-                        double origin_y, double origin_z, T default_object)
+                        double origin_y, double origin_z, T default_object, bool sparse)
   : data_(nullptr)
 {
-  resize(size_x, size_y, size_z, resolution, origin_x, origin_y, origin_z, default_object);
+  resize(size_x, size_y, size_z, resolution, origin_x, origin_y, origin_z, default_object, sparse);
 }
 
 template <typename T>
-VoxelGrid<T>::VoxelGrid() : data_(NULL)
+VoxelGrid<T>::VoxelGrid() : data_(NULL), sparse_(false)
 {
   for (int i = DIM_X; i <= DIM_Z; ++i)
   {
@@ -355,6 +408,7 @@ VoxelGrid<T>::VoxelGrid() : data_(NULL)
     origin_[i] = 0;
     origin_minus_[i] = 0;
     num_cells_[i] = 0;
+    num_blocks_[i] = 0;
   }
   resolution_ = 1.0;
   oo_resolution_ = 1.0 / resolution_;
@@ -365,10 +419,11 @@ VoxelGrid<T>::VoxelGrid() : data_(NULL)
 
 template <typename T>
 void VoxelGrid<T>::resize(double size_x, double size_y, double size_z, double resolution, double origin_x,
-                          double origin_y, double origin_z, T default_object)
+                          double origin_y, double origin_z, T default_object, bool sparse)
 {
   delete[] data_;
   data_ = nullptr;
+  blocks_.clear();
 
   size_[DIM_X] = size_x;
   size_[DIM_Y] = size_y;
@@ -393,9 +448,19 @@ void VoxelGrid<T>::resize(double size_x, double size_y, double size_z, double re
   stride1_ = num_cells_[DIM_Y] * num_cells_[DIM_Z];
   stride2_ = num_cells_[DIM_Z];
 
+  sparse_ = sparse;
+  background_ = default_object;
+  for (int i = DIM_X; i <= DIM_Z; ++i)
+    num_blocks_[i] = (std::max(num_cells_[i], 0) + BLOCK_MASK) >> BLOCK_SHIFT;
+
   // initialize the data:
   if (num_cells_total_ > 0)
-    data_ = new T[num_cells_total_];
+  {
+    if (sparse_)
+      blocks_.resize(static_cast<std::size_t>(num_blocks_[DIM_X]) * num_blocks_[DIM_Y] * num_blocks_[DIM_Z]);
+    else
+      data_ = new T[num_cells_total_];
+  }
 }
 
 template <typename T>
@@ -475,40 +540,71 @@ inline const T& VoxelGrid<T>::operator()(const Eigen::Vector3d& pos) const
   return this->operator()(pos.x(), pos.y(), pos.z());
 }
 
+template <typename T>
+inline int VoxelGrid<T>::blockRef(int x, int y, int z) const
+{
+  return ((x >> BLOCK_SHIFT) * num_blocks_[DIM_Y] + (y >> BLOCK_SHIFT)) * num_blocks_[DIM_Z] + (z >> BLOCK_SHIFT);
+}
+
+template <typename T>
+inline int VoxelGrid<T>::blockOffset(int x, int y, int z) const
+{
+  return ((((x & BLOCK_MASK) << BLOCK_SHIFT) + (y & BLOCK_MASK)) << BLOCK_SHIFT) | (z & BLOCK_MASK);
+}
+
+template <typename T>
+T& VoxelGrid<T>::getSparseCell(int x, int y, int z)
+{
+  std::unique_ptr<T[]>& block = blocks_[blockRef(x, y, z)];
+  if (!block)
+  {
+    block.reset(new T[BLOCK_SIZE * BLOCK_SIZE * BLOCK_SIZE]);
+    std::fill(block.get(), block.get() + BLOCK_SIZE * BLOCK_SIZE * BLOCK_SIZE, background_);
+  }
+  return block[blockOffset(x, y, z)];
+}
+
 template <typename T>
 inline T& VoxelGrid<T>::getCell(int x, int y, int z)
 {
+  if (sparse_)
+    return getSparseCell(x, y, z);
   return data_[ref(x, y, z)];
 }
 
 template <typename T>
 inline const T& VoxelGrid<T>::getCell(int x, int y, int z) const
 {
+  if (sparse_)
+  {
+    const T* block = blocks_[blockRef(x, y, z)].get();
+    return block ? block[blockOffset(x, y, z)] : background_;
+  }
   return data_[ref(x, y, z)];
 }
 
 template <typename T>
 inline T& VoxelGrid<T>::getCell(const Eigen::Vector3i& pos)
 {
-  return data_[ref(pos.x(), pos.y(), pos.z())];
+  return getCell(pos.x(), pos.y(), pos.z());
 }
 
 template <typename T>
 inline const T& VoxelGrid<T>::getCell(const Eigen::Vector3i& pos) const
 {
-  return data_[ref(pos.x(), pos.y(), pos.z())];
+  return getCell(pos.x(), pos.y(), pos.z());
 }
 
 template <typename T>
 inline void VoxelGrid<T>::setCell(int x, int y, int z, const T& obj)
 {
-  data_[ref(x, y, z)] = obj;
+  getCell(x, y, z) = obj;
 }
 
 template <typename T>
 inline void VoxelGrid<T>::setCell(const Eigen::Vector3i& pos, const T& obj)
 {
-  data_[ref(pos.x(), pos.y(), pos.z())] = obj;
+  getCell(pos.x(), pos.y(), pos.z()) = obj;
 }
 
 template <typename T>
@@ -540,9 +636,23 @@ inline double VoxelGrid<T>::getLocationFromCell(Dimension dim, int cell) const
 template <typename T>
 inline void VoxelGrid<T>::reset(const T& initial)
 {
+  if (sparse_)
+  {
+    for (std::unique_ptr<T[]>& block : blocks_)
+      block.reset();
+    background_ = initial;
+    return;
+  }
   std::fill(data_, data_ + num_cells_total_, initial);
 }
 
+template <typename T>
+std::size_t VoxelGrid<T>::getAllocatedBlockCount() const
+{
+  return std::count_if(blocks_.begin(), blocks_.end(),
+                       [](const std::unique_ptr<T[]>& block) { return block != nullptr; });
+}
+
 template <typename T>
 inline void VoxelGrid<T>::gridToWorld(int x, int y, int z, double& world_x, double& world_y, double& world_z) const
 {
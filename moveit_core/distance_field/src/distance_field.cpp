@@ -85,6 +85,123 @@ double DistanceField::getDistanceGradient(double x, double y, double z, double&
   return getDistance(gx, gy, gz);
 }
 
+void DistanceField::getCellDistances(const Eigen::Vector3i* cells, std::size_t count, double* distances) const
+{
+  for (std::size_t i = 0; i < count; ++i)
+    distances[i] = getDistance(cells[i].x(), cells[i].y(), cells[i].z());
+}
+
+void DistanceField::getDistanceGradients(const EigenSTL::vector_Vector3d& points, std::vector<double>& distances,
+                                         EigenSTL::vector_Vector3d& gradients, std::vector<bool>& in_bounds) const
+{
+  const std::size_t count = points.size();
+  distances.resize(count);
+  gradients.resize(count);
+  in_bounds.assign(count, false);
+
+  // the cell of each point followed by its neighbors along -x, +x, -y, +y, -z, +z
+  std::vector<Eigen::Vector3i> cells;
+  std::vector<std::size_t> valid;
+  cells.reserve(7 * count);
+  valid.reserve(count);
+  for (std::size_t i = 0; i < count; ++i)
+  {
+    int gx, gy, gz;
+    worldToGrid(points[i].x(), points[i].y(), points[i].z(), gx, gy, gz);
+    if (gx < 1 || gy < 1 || gz < 1 || gx >= getXNumCells() - 1 || gy >= getYNumCells() - 1 || gz >= getZNumCells() - 1)
+    {
+      distances[i] = getUninitializedDistance();
+      gradients[i].setZero();
+      continue;
+    }
+    valid.push_back(i);
+    cells.emplace_back(gx, gy, gz);
+    cells.emplace_back(gx - 1, gy, gz);
+    cells.emplace_back(gx + 1, gy, gz);
+    cells.emplace_back(gx, gy - 1, gz);
+    cells.emplace_back(gx, gy + 1, gz);
+    cells.emplace_back(gx, gy, gz - 1);
+    cells.emplace_back(gx, gy, gz + 1);
+  }
+
+  std::vector<double> cell_distances(cells.size());
+  getCellDistances(cells.data(), cells.size(), cell_distances.data());
+
+  for (std::size_t k = 0; k < valid.size(); ++k)
+  {
+    const double* d = &cell_distances[7 * k];
+    const std::size_t i = valid[k];
+    distances[i] = d[0];
+    gradients[i] = Eigen::Vector3d((d[2] - d[1]) * inv_twice_resolution_, (d[4] - d[3]) * inv_twice_resolution_,
+                                   (d[6] - d[5]) * inv_twice_resolution_);
+    in_bounds[i] = true;
+  }
+}
+
+void DistanceField::getInterpolatedDistanceGradients(const EigenSTL::vector_Vector3d& points,
+                                                     std::vector<double>& distances,
+                                                     EigenSTL::vector_Vector3d& gradients,
+                                                     std::vector<bool>& in_bounds) const
+{
+  const std::size_t count = points.size();
+  distances.resize(count);
+  gradients.resize(count);
+  in_bounds.assign(count, false);
+
+  const Eigen::Vector3d origin(origin_x_, origin_y_, origin_z_);
+  const Eigen::Vector3i num_cells(getXNumCells(), getYNumCells(), getZNumCells());
+  const double inv_resolution = 1.0 / resolution_;
+
+  // the eight corners of each point, corner c at offset (c >> 2, (c >> 1) & 1, c & 1) from the lower corner
+  std::vector<Eigen::Vector3i> cells;
+  std::vector<std::size_t> valid;
+  EigenSTL::vector_Vector3d fractions;
+  cells.reserve(8 * count);
+  valid.reserve(count);
+  fractions.reserve(count);
+  for (std::size_t i = 0; i < count; ++i)
+  {
+    const Eigen::Vector3d u = (points[i] - origin) * inv_resolution;
+    const Eigen::Vector3d lower = u.array().floor();
+    const Eigen::Vector3i cell = lower.cast<int>();
+    if ((cell.array() < 0).any() || (cell.array() + 1 >= num_cells.array()).any())
+    {
+      distances[i] = getUninitializedDistance();
+      gradients[i].setZero();
+      continue;
+    }
+    valid.push_back(i);
+    fractions.push_back(u - lower);
+    for (int c = 0; c < 8; ++c)
+      cells.emplace_back(cell.x() + (c >> 2), cell.y() + ((c >> 1) & 1), cell.z() + (c & 1));
+  }
+
+  std::vector<double> cell_distances(cells.size());
+  getCellDistances(cells.data(), cells.size(), cell_distances.data());
+
+  for (std::size_t k = 0; k < valid.size(); ++k)
+  {
+    const double* d = &cell_distances[8 * k];
+    const Eigen::Vector3d& t = fractions[k];
+    // interpolate along z, then y, then x
+    const double c00 = d[0] + t.z() * (d[1] - d[0]);
+    const double c01 = d[2] + t.z() * (d[3] - d[2]);
+    const double c10 = d[4] + t.z() * (d[5] - d[4]);
+    const double c11 = d[6] + t.z() * (d[7] - d[6]);
+    const double c0 = c00 + t.y() * (c01 - c00);
+    const double c1 = c10 + t.y() * (c11 - c10);
+
+    const std::size_t i = valid[k];
+    distances[i] = c0 + t.x() * (c1 - c0);
+    const double dz0 = (1.0 - t.y()) * (d[1] - d[0]) + t.y() * (d[3] - d[2]);
+    const double dz1 = (1.0 - t.y()) * (d[5] - d[4]) + t.y() * (d[7] - d[6]);
+    gradients[i] = Eigen::Vector3d(c1 - c0, (1.0 - t.x()) * (c01 - c00) + t.x() * (c11 - c10),
+                                   (1.0 - t.x()) * dz0 + t.x() * dz1) *
+                   inv_resolution;
+    in_bounds[i] = true;
+  }
+}
+
 void DistanceField::getIsoSurfaceMarkers(double min_distance, double max_distance, const std::string& frame_id,
                                          const ros::Time stamp, visualization_msgs::Marker& inf_marker) const
 {
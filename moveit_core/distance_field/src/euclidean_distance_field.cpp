@@ -0,0 +1,399 @@
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2026, PickNik LLC.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of PickNik LLC nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *********************************************************************/
+
+#include <moveit/distance_field/euclidean_distance_field.h>
+#include <boost/iostreams/filtering_stream.hpp>
+#include <boost/iostreams/filter/zlib.hpp>
+#include <algorithm>
+#include <bitset>
+#include <cmath>
+#include <functional>
+#include <limits>
+#include <thread>
+
+namespace distance_field
+{
+namespace
+{
+/** \brief Marks cells that have no site along the lines transformed so far */
+constexpr int INFINITE_DISTANCE = std::numeric_limits<int>::max();
+
+/** \brief Call \e fn(begin, end) for consecutive ranges of [0, count) on up to \e threads threads */
+void parallelFor(unsigned int threads, int count, const std::function<void(int, int)>& fn)
+{
+  const int chunks = std::min<int>(threads, count);
+  if (chunks <= 1)
+  {
+    fn(0, count);
+    return;
+  }
+  std::vector<std::thread> workers;
+  workers.reserve(chunks - 1);
+  for (int i = 1; i < chunks; ++i)
+    workers.emplace_back(fn, static_cast<int>(static_cast<long>(count) * i / chunks),
+                         static_cast<int>(static_cast<long>(count) * (i + 1) / chunks));
+  fn(0, count / chunks);
+  for (std::thread& worker : workers)
+    worker.join();
+}
+
+/** \brief Per-thread buffers of the 1-D transform */
+struct LineBuffers
+{
+  explicit LineBuffers(int n) : f(n), d(n), v(n), z(n + 1)
+  {
+  }
+
+  std::vector<int> f;
+  std::vector<int> d;
+  std::vector<int> v;
+  std::vector<double> z;
+};
+
+/** \brief Squared distance transform of the sampled function \e b.f of length \e n (Felzenszwalb and Huttenlocher,
+    "Distance Transforms of Sampled Functions").  Only cells with a finite value are sites of the lower envelope;
+    results are capped at \e cap.  Returns false if the line holds no site, in which case \e b.d is not written. */
+bool transformLine(LineBuffers& b, int n, int cap)
+{
+  int k = -1;
+  for (int q = 0; q < n; ++q)
+  {
+    if (b.f[q] == INFINITE_DISTANCE)
+      continue;
+    double s = -std::numeric_limits<double>::infinity();
+    while (k >= 0)
+    {
+      const int p = b.v[k];
+      s = ((b.f[q] + static_cast<double>(q) * q) - (b.f[p] + static_cast<double>(p) * p)) / (2.0 * (q - p));
+      if (s > b.z[k])
+        break;
+      s = -std::numeric_limits<double>::infinity();
+      --k;
+    }
+    ++k;
+    b.v[k] = q;
+    b.z[k] = s;
+  }
+  if (k < 0)
+    return false;
+  b.z[k + 1] = std::numeric_limits<double>::infinity();
+
+  k = 0;
+  for (int q = 0; q < n; ++q)
+  {
+    while (b.z[k + 1] < q)
+      ++k;
+    const long offset = q - b.v[k];
+    b.d[q] = static_cast<int>(std::min<long>(offset * offset + b.f[b.v[k]], cap));
+  }
+  return true;
+}
+}  // namespace
+
+EuclideanDistanceField::EuclideanDistanceField(double size_x, double size_y, double size_z, double resolution,
+                                               double origin_x, double origin_y, double origin_z, double max_distance,
+                                               bool propagate_negative_distances, unsigned int threads)
+  : DistanceField(size_x, size_y, size_z, resolution, origin_x, origin_y, origin_z)
+  , propagate_negative_(propagate_negative_distances)
+  , threads_(threads)
+  , max_distance_(max_distance)
+{
+  initialize();
+}
+
+EuclideanDistanceField::EuclideanDistanceField(std::istream& stream, double max_distance,
+                                               bool propagate_negative_distances, unsigned int threads)
+  : DistanceField(0, 0, 0, 0, 0, 0, 0)
+  , propagate_negative_(propagate_negative_distances)
+  , threads_(threads)
+  , max_distance_(max_distance)
+{
+  readFromStream(stream);
+}
+
+void EuclideanDistanceField::initialize()
+{
+  if (threads_ == 0)
+    threads_ = std::max(1u, std::thread::hardware_concurrency());
+
+  const int max_cells = std::ceil(max_distance_ / resolution_);
+  max_distance_sq_ = max_cells * max_cells;
+  distance_grid_ = std::make_shared<VoxelGrid<int>>(size_x_, size_y_, size_z_, resolution_, origin_x_, origin_y_,
+                                                    origin_z_, max_distance_sq_);
+  if (propagate_negative_)
+    negative_distance_grid_ = std::make_shared<VoxelGrid<int>>(size_x_, size_y_, size_z_, resolution_, origin_x_,
+                                                               origin_y_, origin_z_, 0);
+
+  sqrt_table_.resize(max_distance_sq_ + 1);
+  for (int i = 0; i <= max_distance_sq_; ++i)
+    sqrt_table_[i] = std::sqrt(double(i)) * resolution_;
+
+  reset();
+}
+
+void EuclideanDistanceField::reset()
+{
+  distance_grid_->reset(max_distance_sq_);
+  if (propagate_negative_)
+    negative_distance_grid_->reset(0);
+}
+
+bool EuclideanDistanceField::setOccupancy(const EigenSTL::vector_Vector3d& points, bool occupied)
+{
+  bool changed = false;
+  for (const Eigen::Vector3d& point : points)
+  {
+    int x, y, z;
+    if (!worldToGrid(point.x(), point.y(), point.z(), x, y, z))
+      continue;
+    int& cell = distance_grid_->getCell(x, y, z);
+    if ((cell == 0) != occupied)
+    {
+      // any non-zero value marks a free cell until the transform is recomputed
+      cell = occupied ? 0 : INFINITE_DISTANCE;
+      changed = true;
+    }
+  }
+  return changed;
+}
+
+void EuclideanDistanceField::addPointsToField(const EigenSTL::vector_Vector3d& points)
+{
+  if (setOccupancy(points, true))
+    computeTransform();
+}
+
+void EuclideanDistanceField::removePointsFromField(const EigenSTL::vector_Vector3d& points)
+{
+  if (setOccupancy(points, false))
+    computeTransform();
+}
+
+void EuclideanDistanceField::updatePointsInField(const EigenSTL::vector_Vector3d& old_points,
+                                                 const EigenSTL::vector_Vector3d& new_points)
+{
+  const bool removed = setOccupancy(old_points, false);
+  const bool added = setOccupancy(new_points, true);
+  if (removed || added)
+    computeTransform();
+}
+
+void EuclideanDistanceField::computeTransform()
+{
+  const int num_x = getXNumCells();
+  const int num_y = getYNumCells();
+  const int num_z = getZNumCells();
+
+  // obstacle cells are the sites of the positive transform and free cells those of the negative one
+  parallelFor(threads_, num_x, [&](int begin, int end) {
+    for (int x = begin; x < end; ++x)
+      for (int y = 0; y < num_y; ++y)
+        for (int z = 0; z < num_z; ++z)
+        {
+          int& cell = distance_grid_->getCell(x, y, z);
+          const bool occupied = cell == 0;
+          cell = occupied ? 0 : INFINITE_DISTANCE;
+          if (propagate_negative_)
+            negative_distance_grid_->getCell(x, y, z) = occupied ? INFINITE_DISTANCE : 0;
+        }
+  });
+
+  transformDimension(*distance_grid_, DIM_X);
+  transformDimension(*distance_grid_, DIM_Y);
+  transformDimension(*distance_grid_, DIM_Z);
+  if (propagate_negative_)
+  {
+    transformDimension(*negative_distance_grid_, DIM_X);
+    transformDimension(*negative_distance_grid_, DIM_Y);
+    transformDimension(*negative_distance_grid_, DIM_Z);
+  }
+}
+
+void EuclideanDistanceField::transformDimension(VoxelGrid<int>& grid, Dimension dim) const
+{
+  // the two dimensions indexing the lines along dim
+  const Dimension outer = dim == DIM_X ? DIM_Y : DIM_X;
+  const Dimension inner = dim == DIM_Z ? DIM_Y : DIM_Z;
+  const int n = grid.getNumCells(dim);
+  const int num_inner = grid.getNumCells(inner);
+  const int num_lines = grid.getNumCells(outer) * num_inner;
+  // lines without any site keep their marker until the last pass, which caps them at the maximum distance
+  const bool last = dim == DIM_Z;
+
+  parallelFor(threads_, num_lines, [&](int begin, int end) {
+    LineBuffers buffers(n);
+    int cell[3];
+    for (int line = begin; line < end; ++line)
+    {
+      cell[outer] = line / num_inner;
+      cell[inner] = line % num_inner;
+      for (int q = 0; q < n; ++q)
+      {
+        cell[dim] = q;
+        buffers.f[q] = grid.getCell(cell[DIM_X], cell[DIM_Y], cell[DIM_Z]);
+      }
+      if (!transformLine(buffers, n, max_distance_sq_))
+      {
+        if (!last)
+          continue;
+        std::fill(buffers.d.begin(), buffers.d.end(), max_distance_sq_);
+      }
+      for (int q = 0; q < n; ++q)
+      {
+        cell[dim] = q;
+        grid.getCell(cell[DIM_X], cell[DIM_Y], cell[DIM_Z]) = buffers.d[q];
+      }
+    }
+  });
+}
+
+double EuclideanDistanceField::getDistance(double x, double y, double z) const
+{
+  int cell_x, cell_y, cell_z;
+  if (!worldToGrid(x, y, z, cell_x, cell_y, cell_z))
+    return sqrt_table_[max_distance_sq_];
+  return getDistance(cell_x, cell_y, cell_z);
+}
+
+double EuclideanDistanceField::getDistance(int x, int y, int z) const
+{
+  return sqrt_table_[getDistanceSquared(x, y, z)] - sqrt_table_[getNegativeDistanceSquared(x, y, z)];
+}
+
+bool EuclideanDistanceField::isCellValid(int x, int y, int z) const
+{
+  return distance_grid_->isCellValid(x, y, z);
+}
+
+int EuclideanDistanceField::getXNumCells() const
+{
+  return distance_grid_->getNumCells(DIM_X);
+}
+
+int EuclideanDistanceField::getYNumCells() const
+{
+  return distance_grid_->getNumCells(DIM_Y);
+}
+
+int EuclideanDistanceField::getZNumCells() const
+{
+  return distance_grid_->getNumCells(DIM_Z);
+}
+
+bool EuclideanDistanceField::gridToWorld(int x, int y, int z, double& world_x, double& world_y, double& world_z) const
+{
+  distance_grid_->gridToWorld(x, y, z, world_x, world_y, world_z);
+  return true;
+}
+
+bool EuclideanDistanceField::worldToGrid(double world_x, double world_y, double world_z, int& x, int& y, int& z) const
+{
+  return distance_grid_->worldToGrid(world_x, world_y, world_z, x, y, z);
+}
+
+bool EuclideanDistanceField::writeToStream(std::ostream& os) const
+{
+  os << "resolution: " << resolution_ << std::endl;
+  os << "size_x: " << size_x_ << std::endl;
+  os << "size_y: " << size_y_ << std::endl;
+  os << "size_z: " << size_z_ << std::endl;
+  os << "origin_x: " << origin_x_ << std::endl;
+  os << "origin_y: " << origin_y_ << std::endl;
+  os << "origin_z: " << origin_z_ << std::endl;
+
+  // obstacle cells as zlib compressed bits, eight Z cells per byte
+  boost::iostreams::filtering_ostream out;
+  out.push(boost::iostreams::zlib_compressor());
+  out.push(os);
+
+  for (int x = 0; x < getXNumCells(); ++x)
+    for (int y = 0; y < getYNumCells(); ++y)
+      for (int z = 0; z < getZNumCells(); z += 8)
+      {
+        std::bitset<8> bs(0);
+        const int zv = std::min(8, getZNumCells() - z);
+        for (int zi = 0; zi < zv; ++zi)
+          bs[zi] = distance_grid_->getCell(x, y, z + zi) == 0;
+        const char byte = static_cast<char>(bs.to_ulong());
+        out.write(&byte, sizeof(char));
+      }
+  out.flush();
+  return true;
+}
+
+bool EuclideanDistanceField::readFromStream(std::istream& is)
+{
+  if (!is.good())
+    return false;
+
+  std::string temp;
+  double* const fields[] = { &resolution_, &size_x_, &size_y_, &size_z_, &origin_x_, &origin_y_, &origin_z_ };
+  const char* const names[] = { "resolution:", "size_x:", "size_y:", "size_z:", "origin_x:", "origin_y:", "origin_z:" };
+  for (std::size_t i = 0; i < 7; ++i)
+  {
+    is >> temp;
+    if (temp != names[i])
+      return false;
+    is >> *fields[i];
+  }
+
+  // previous values for propagate_negative_ and max_distance_ will be used
+  initialize();
+
+  // this should be newline
+  char nl;
+  is.get(nl);
+
+  boost::iostreams::filtering_istream in;
+  in.push(boost::iostreams::zlib_decompressor());
+  in.push(is);
+
+  for (int x = 0; x < getXNumCells(); ++x)
+    for (int y = 0; y < getYNumCells(); ++y)
+      for (int z = 0; z < getZNumCells(); z += 8)
+      {
+        char inchar;
+        if (!in.good())
+          return false;
+        in.get(inchar);
+        const std::bitset<8> inbit(static_cast<unsigned char>(inchar));
+        const int zv = std::min(8, getZNumCells() - z);
+        for (int zi = 0; zi < zv; ++zi)
+          if (inbit[zi])
+            distance_grid_->getCell(x, y, z + zi) = 0;
+      }
+  computeTransform();
+  return true;
+}
+}  // namespace distance_field
@@ -40,14 +40,39 @@
 #include <boost/iostreams/filtering_stream.hpp>
 #include <boost/iostreams/copy.hpp>
 #include <boost/iostreams/filter/zlib.hpp>
+#include <boost/iostreams/device/mapped_file.hpp>
+#include <cstring>
+#include <fstream>
 
 namespace distance_field
 {
+namespace
+{
+/** \brief Header of the files written by PropagationDistanceField::writeToBinaryFile() */
+struct BinaryFileHeader
+{
+  char magic[8];
+  std::uint32_t version;
+  std::uint32_t voxel_size;
+  std::uint64_t key;
+  std::int32_t num_cells[3];
+  std::int32_t max_distance_sq;
+  std::uint32_t propagate_negative;
+  std::uint32_t reserved;
+  double resolution;
+  double origin[3];
+};
+
+const char BINARY_FILE_MAGIC[8] = { 'M', 'V', 'T', 'P', 'D', 'F', '\0', '\0' };
+const std::uint32_t BINARY_FILE_VERSION = 1;
+}  // namespace
+
 PropagationDistanceField::PropagationDistanceField(double size_x, double size_y, double size_z, double resolution,
                                                    double origin_x, double origin_y, double origin_z,
-                                                   double max_distance, bool propagate_negative)
+                                                   double max_distance, bool propagate_negative, bool sparse_storage)
   : DistanceField(size_x, size_y, size_z, resolution, origin_x, origin_y, origin_z)
   , propagate_negative_(propagate_negative)
+  , sparse_storage_(sparse_storage)
   , max_distance_(max_distance)
 {
   initialize();
@@ -55,10 +80,11 @@ PropagationDistanceField::PropagationDistanceField(double size_x, double size_y,
 
 PropagationDistanceField::PropagationDistanceField(const octomap::OcTree& octree, const octomap::point3d& bbx_min,
                                                    const octomap::point3d& bbx_max, double max_distance,
-                                                   bool propagate_negative_distances)
+                                                   bool propagate_negative_distances, bool sparse_storage)
   : DistanceField(bbx_max.x() - bbx_min.x(), bbx_max.y() - bbx_min.y(), bbx_max.z() - bbx_min.z(),
                   octree.getResolution(), bbx_min.x(), bbx_min.y(), bbx_min.z())
   , propagate_negative_(propagate_negative_distances)
+  , sparse_storage_(sparse_storage)
   , max_distance_(max_distance)
   , max_distance_sq_(0)  // avoid gcc warning about uninitialized value
 {
@@ -68,7 +94,10 @@ PropagationDistanceField::PropagationDistanceField(const octomap::OcTree& octree
 
 PropagationDistanceField::PropagationDistanceField(std::istream& is, double max_distance,
                                                    bool propagate_negative_distances)
-  : DistanceField(0, 0, 0, 0, 0, 0, 0), propagate_negative_(propagate_negative_distances), max_distance_(max_distance)
+  : DistanceField(0, 0, 0, 0, 0, 0, 0)
+  , propagate_negative_(propagate_negative_distances)
+  , sparse_storage_(false)
+  , max_distance_(max_distance)
 {
   readFromStream(is);
 }
@@ -78,7 +107,8 @@ void PropagationDistanceField::initialize()
   max_distance_sq_ = ceil(max_distance_ / resolution_) * ceil(max_distance_ / resolution_);
   voxel_grid_ =
       std::make_shared<VoxelGrid<PropDistanceFieldVoxel>>(size_x_, size_y_, size_z_, resolution_, origin_x_, origin_y_,
-                                                          origin_z_, PropDistanceFieldVoxel(max_distance_sq_, 0));
+                                                          origin_z_, PropDistanceFieldVoxel(max_distance_sq_, 0),
+                                                          sparse_storage_);
 
   initNeighborhoods();
 
@@ -154,7 +184,7 @@ void PropagationDistanceField::updatePointsInField(const EigenSTL::vector_Vector
   EigenSTL::vector_Vector3i new_not_in_current;
   for (Eigen::Vector3i& voxel_loc : new_not_old)
   {
-    if (voxel_grid_->getCell(voxel_loc.x(), voxel_loc.y(), voxel_loc.z()).distance_square_ != 0)
+    if (constVoxelGrid().getCell(voxel_loc.x(), voxel_loc.y(), voxel_loc.z()).distance_square_ != 0)
     {
       new_not_in_current.push_back(voxel_loc);
     }
@@ -185,7 +215,7 @@ void PropagationDistanceField::addPointsToField(const EigenSTL::vector_Vector3d&
 
     if (valid)
     {
-      if (voxel_grid_->getCell(voxel_loc.x(), voxel_loc.y(), voxel_loc.z()).distance_square_ > 0)
+      if (constVoxelGrid().getCell(voxel_loc.x(), voxel_loc.y(), voxel_loc.z()).distance_square_ > 0)
       {
         voxel_points.push_back(voxel_loc);
       }
@@ -224,7 +254,8 @@ void PropagationDistanceField::addNewObstacleVoxels(const EigenSTL::vector_Vecto
   EigenSTL::vector_Vector3i negative_stack;
   if (propagate_negative_)
   {
-    negative_stack.reserve(getXNumCells() * getYNumCells() * getZNumCells());
+    if (!sparse_storage_)
+      negative_stack.reserve(getXNumCells() * getYNumCells() * getZNumCells());
     negative_bucket_queue_[0].reserve(voxel_points.size());
   }
 
@@ -306,11 +337,13 @@ void PropagationDistanceField::removeObstacleVoxels(const EigenSTL::vector_Vecto
   EigenSTL::vector_Vector3i negative_stack;
   int initial_update_direction = getDirectionNumber(0, 0, 0);
 
-  stack.reserve(getXNumCells() * getYNumCells() * getZNumCells());
+  if (!sparse_storage_)
+    stack.reserve(getXNumCells() * getYNumCells() * getZNumCells());
   bucket_queue_[0].reserve(voxel_points.size());
   if (propagate_negative_)
   {
-    negative_stack.reserve(getXNumCells() * getYNumCells() * getZNumCells());
+    if (!sparse_storage_)
+      negative_stack.reserve(getXNumCells() * getYNumCells() * getZNumCells());
     negative_bucket_queue_[0].reserve(voxel_points.size());
   }
 
@@ -507,6 +540,10 @@ void PropagationDistanceField::propagateNegative()
 void PropagationDistanceField::reset()
 {
   voxel_grid_->reset(PropDistanceFieldVoxel(max_distance_sq_, 0));
+  // free cells without a closest negative point are treated as their own closest point when obstacles are added,
+  // so sparse grids can leave them unset instead of allocating every block
+  if (sparse_storage_)
+    return;
   for (int x = 0; x < getXNumCells(); x++)
   {
     for (int y = 0; y < getYNumCells(); y++)
@@ -599,7 +636,26 @@ double PropagationDistanceField::getDistance(double x, double y, double z) const
 
 double PropagationDistanceField::getDistance(int x, int y, int z) const
 {
-  return getDistance(voxel_grid_->getCell(x, y, z));
+  return getDistance(constVoxelGrid().getCell(x, y, z));
+}
+
+void PropagationDistanceField::getCellDistances(const Eigen::Vector3i* cells, std::size_t count,
+                                                double* distances) const
+{
+  // far enough ahead to hide a cache miss behind the lookups in between
+  const std::size_t PREFETCH_DISTANCE = 8;
+  const VoxelGrid<PropDistanceFieldVoxel>& grid = constVoxelGrid();
+  for (std::size_t i = 0; i < count; ++i)
+  {
+#if defined(__GNUC__)
+    if (i + PREFETCH_DISTANCE < count)
+    {
+      const Eigen::Vector3i& ahead = cells[i + PREFETCH_DISTANCE];
+      __builtin_prefetch(&grid.getCell(ahead.x(), ahead.y(), ahead.z()));
+    }
+#endif
+    distances[i] = getDistance(grid.getCell(cells[i].x(), cells[i].y(), cells[i].z()));
+  }
 }
 
 bool PropagationDistanceField::isCellValid(int x, int y, int z) const
@@ -759,4 +815,81 @@ bool PropagationDistanceField::readFromStream(std::istream& is)
   addNewObstacleVoxels(obs_points);
   return true;
 }
+
+bool PropagationDistanceField::writeToBinaryFile(const std::string& filename, std::uint64_t key) const
+{
+  BinaryFileHeader header;
+  std::memset(&header, 0, sizeof(header));
+  std::memcpy(header.magic, BINARY_FILE_MAGIC, sizeof(header.magic));
+  header.version = BINARY_FILE_VERSION;
+  header.voxel_size = sizeof(PropDistanceFieldVoxel);
+  header.key = key;
+  header.num_cells[DIM_X] = getXNumCells();
+  header.num_cells[DIM_Y] = getYNumCells();
+  header.num_cells[DIM_Z] = getZNumCells();
+  header.max_distance_sq = max_distance_sq_;
+  header.propagate_negative = propagate_negative_;
+  header.resolution = resolution_;
+  header.origin[DIM_X] = origin_x_;
+  header.origin[DIM_Y] = origin_y_;
+  header.origin[DIM_Z] = origin_z_;
+
+  std::ofstream os(filename, std::ios::out | std::ios::binary | std::ios::trunc);
+  if (!os.good())
+    return false;
+  os.write(reinterpret_cast<const char*>(&header), sizeof(header));
+  for (int x = 0; x < getXNumCells(); ++x)
+    for (int y = 0; y < getYNumCells(); ++y)
+      for (int z = 0; z < getZNumCells(); ++z)
+        os.write(reinterpret_cast<const char*>(&getCell(x, y, z)), sizeof(PropDistanceFieldVoxel));
+  os.close();
+  return !os.fail();
+}
+
+bool PropagationDistanceField::readFromBinaryFile(const std::string& filename, std::uint64_t key)
+{
+  boost::iostreams::mapped_file_source file;
+  try
+  {
+    file.open(filename);
+  }
+  catch (std::exception& e)
+  {
+    ROS_DEBUG_NAMED("distance_field", "Unable to map distance field file '%s': %s", filename.c_str(), e.what());
+    return false;
+  }
+
+  const std::size_t num_cells = static_cast<std::size_t>(getXNumCells()) * getYNumCells() * getZNumCells();
+  BinaryFileHeader header;
+  if (file.size() != sizeof(header) + num_cells * sizeof(PropDistanceFieldVoxel))
+    return false;
+  std::memcpy(&header, file.data(), sizeof(header));
+  if (std::memcmp(header.magic, BINARY_FILE_MAGIC, sizeof(header.magic)) != 0 ||
+      header.version != BINARY_FILE_VERSION || header.voxel_size != sizeof(PropDistanceFieldVoxel) ||
+      header.key != key || header.num_cells[DIM_X] != getXNumCells() || header.num_cells[DIM_Y] != getYNumCells() ||
+      header.num_cells[DIM_Z] != getZNumCells() || header.max_distance_sq != max_distance_sq_ ||
+      header.propagate_negative != static_cast<std::uint32_t>(propagate_negative_) ||
+      header.resolution != resolution_ || header.origin[DIM_X] != origin_x_ || header.origin[DIM_Y] != origin_y_ ||
+      header.origin[DIM_Z] != origin_z_)
+  {
+    ROS_DEBUG_NAMED("distance_field", "Distance field file '%s' does not match this field", filename.c_str());
+    return false;
+  }
+
+  // sparse grids only allocate the blocks that differ from the empty field
+  if (sparse_storage_)
+    voxel_grid_->reset(PropDistanceFieldVoxel(max_distance_sq_, 0));
+  const char* data = file.data() + sizeof(header);
+  PropDistanceFieldVoxel voxel;
+  for (int x = 0; x < getXNumCells(); ++x)
+    for (int y = 0; y < getYNumCells(); ++y)
+      for (int z = 0; z < getZNumCells(); ++z, data += sizeof(PropDistanceFieldVoxel))
+      {
+        std::memcpy(&voxel, data, sizeof(PropDistanceFieldVoxel));
+        if (sparse_storage_ && voxel.distance_square_ == max_distance_sq_ && voxel.negative_distance_square_ == 0)
+          continue;
+        voxel_grid_->getCell(x, y, z) = voxel;
+      }
+  return true;
+}
 }  // namespace distance_field
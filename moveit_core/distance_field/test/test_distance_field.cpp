@@ -38,6 +38,7 @@
 
 #include <moveit/distance_field/voxel_grid.h>
 #include <moveit/distance_field/propagation_distance_field.h>
+#include <moveit/distance_field/euclidean_distance_field.h>
 #include <moveit/distance_field/find_internal_points.h>
 #include <geometric_shapes/body_operations.h>
 #include <tf2_eigen/tf2_eigen.h>
@@ -929,6 +930,229 @@ TEST(TestSignedPropagationDistanceField, TestReadWrite)
   EXPECT_FALSE(areDistanceFieldsDistancesEqual(df, df3));
 }
 
+TEST(TestSignedPropagationDistanceField, TestBinaryFile)
+{
+  PropagationDistanceField df(WIDTH, HEIGHT, DEPTH, RESOLUTION, ORIGIN_X, ORIGIN_Y, ORIGIN_Z, MAX_DIST, true);
+  shapes::Box box(0.3, 0.2, 0.2);
+  df.addShapeToField(&box, Eigen::Isometry3d(Eigen::Translation3d(0.5, 0.5, 0.5)));
+  ASSERT_TRUE(df.writeToBinaryFile("test_small.bdf", 42));
+
+  PropagationDistanceField df2(WIDTH, HEIGHT, DEPTH, RESOLUTION, ORIGIN_X, ORIGIN_Y, ORIGIN_Z, MAX_DIST, true);
+  EXPECT_FALSE(df2.readFromBinaryFile("test_small.bdf", 43));
+  EXPECT_FALSE(df2.readFromBinaryFile("does_not_exist.bdf", 42));
+  ASSERT_TRUE(df2.readFromBinaryFile("test_small.bdf", 42));
+  EXPECT_TRUE(areDistanceFieldsDistancesEqual(df, df2));
+
+  PropagationDistanceField sparse(WIDTH, HEIGHT, DEPTH, RESOLUTION, ORIGIN_X, ORIGIN_Y, ORIGIN_Z, MAX_DIST, true, true);
+  ASSERT_TRUE(sparse.readFromBinaryFile("test_small.bdf", 42));
+  EXPECT_TRUE(areDistanceFieldsDistancesEqual(df, sparse));
+
+  // fields with a different layout reject the file
+  PropagationDistanceField unsigned_df(WIDTH, HEIGHT, DEPTH, RESOLUTION, ORIGIN_X, ORIGIN_Y, ORIGIN_Z, MAX_DIST);
+  EXPECT_FALSE(unsigned_df.readFromBinaryFile("test_small.bdf", 42));
+  PropagationDistanceField larger_df(WIDTH, HEIGHT, DEPTH, RESOLUTION, ORIGIN_X, ORIGIN_Y, ORIGIN_Z, 0.5, true);
+  EXPECT_FALSE(larger_df.readFromBinaryFile("test_small.bdf", 42));
+}
+
+TEST(TestSignedPropagationDistanceField, TestSparseStorage)
+{
+  for (bool signed_field : { false, true })
+  {
+    PropagationDistanceField dense(WIDTH, HEIGHT, DEPTH, RESOLUTION, ORIGIN_X, ORIGIN_Y, ORIGIN_Z, MAX_DIST,
+                                   signed_field);
+    PropagationDistanceField sparse(WIDTH, HEIGHT, DEPTH, RESOLUTION, ORIGIN_X, ORIGIN_Y, ORIGIN_Z, MAX_DIST,
+                                    signed_field, true);
+
+    shapes::Box box(0.3, 0.2, 0.2);
+    Eigen::Isometry3d pose = Eigen::Isometry3d::Identity();
+    pose.translation() = Eigen::Vector3d(0.5, 0.5, 0.5);
+    dense.addShapeToField(&box, pose);
+    sparse.addShapeToField(&box, pose);
+    ASSERT_TRUE(areDistanceFieldsDistancesEqual(dense, sparse));
+
+    EigenSTL::vector_Vector3d points;
+    points.push_back(POINT1);
+    points.push_back(POINT3);
+    dense.addPointsToField(points);
+    sparse.addPointsToField(points);
+    pose.translation().x() = 0.6;
+    dense.moveShapeInField(&box, Eigen::Isometry3d(Eigen::Translation3d(0.5, 0.5, 0.5)), pose);
+    sparse.moveShapeInField(&box, Eigen::Isometry3d(Eigen::Translation3d(0.5, 0.5, 0.5)), pose);
+    dense.removePointsFromField(points);
+    sparse.removePointsFromField(points);
+    EXPECT_TRUE(areDistanceFieldsDistancesEqual(dense, sparse));
+  }
+}
+
+TEST(TestSignedPropagationDistanceField, TestBatchedGradients)
+{
+  PropagationDistanceField df(WIDTH, HEIGHT, DEPTH, RESOLUTION, ORIGIN_X, ORIGIN_Y, ORIGIN_Z, MAX_DIST, true);
+  shapes::Box box(0.3, 0.2, 0.2);
+  df.addShapeToField(&box, Eigen::Isometry3d(Eigen::Translation3d(0.5, 0.5, 0.5)));
+
+  // includes points outside of the field and on its boundary cells
+  EigenSTL::vector_Vector3d points;
+  for (double x = -0.2; x < 1.2; x += 0.13)
+    for (double y = -0.2; y < 1.2; y += 0.11)
+      for (double z = -0.2; z < 1.2; z += 0.17)
+        points.push_back(Eigen::Vector3d(x, y, z));
+
+  std::vector<double> distances;
+  EigenSTL::vector_Vector3d gradients;
+  std::vector<bool> in_bounds;
+  df.getDistanceGradients(points, distances, gradients, in_bounds);
+  ASSERT_EQ(distances.size(), points.size());
+  for (std::size_t i = 0; i < points.size(); ++i)
+  {
+    Eigen::Vector3d grad;
+    bool valid;
+    const double dist =
+        df.getDistanceGradient(points[i].x(), points[i].y(), points[i].z(), grad.x(), grad.y(), grad.z(), valid);
+    EXPECT_EQ(valid, in_bounds[i]);
+    EXPECT_EQ(dist, distances[i]);
+    EXPECT_TRUE(grad == gradients[i]);
+  }
+
+  // at cell centers the interpolated distance is the distance of the cell
+  points.clear();
+  for (int x = 0; x < df.getXNumCells() - 1; ++x)
+    for (int y = 0; y < df.getYNumCells() - 1; ++y)
+      for (int z = 0; z < df.getZNumCells() - 1; z += 3)
+      {
+        Eigen::Vector3d point;
+        df.gridToWorld(x, y, z, point.x(), point.y(), point.z());
+        points.push_back(point);
+      }
+  df.getInterpolatedDistanceGradients(points, distances, gradients, in_bounds);
+  for (std::size_t i = 0; i < points.size(); ++i)
+  {
+    int x, y, z;
+    df.worldToGrid(points[i].x(), points[i].y(), points[i].z(), x, y, z);
+    ASSERT_TRUE(in_bounds[i]);
+    EXPECT_NEAR(distances[i], df.getDistance(x, y, z), 1e-9);
+  }
+
+  // between the cell centers the gradient is the derivative of the interpolated distance
+  const double delta = 1e-6;
+  const Eigen::Vector3d point(0.23, 0.47, 0.61);
+  points.assign(1, point);
+  for (int d = 0; d < 3; ++d)
+  {
+    points.push_back(point + Eigen::Vector3d::Unit(d) * delta);
+    points.push_back(point - Eigen::Vector3d::Unit(d) * delta);
+  }
+  df.getInterpolatedDistanceGradients(points, distances, gradients, in_bounds);
+  for (int d = 0; d < 3; ++d)
+    EXPECT_NEAR(gradients[0][d], (distances[1 + 2 * d] - distances[2 + 2 * d]) / (2 * delta), 1e-6);
+
+  points.assign(1, Eigen::Vector3d(WIDTH, 0.5, 0.5));
+  df.getInterpolatedDistanceGradients(points, distances, gradients, in_bounds);
+  EXPECT_FALSE(in_bounds[0]);
+  EXPECT_EQ(distances[0], df.getUninitializedDistance());
+}
+
+// brute force squared distances in cells from every cell to the closest cell with occupied[cell] == target
+void checkEuclideanDistances(const EuclideanDistanceField& df, const std::vector<bool>& occupied)
+{
+  const int num_y = df.getYNumCells();
+  const int num_z = df.getZNumCells();
+  auto index = [&](int x, int y, int z) { return (x * num_y + y) * num_z + z; };
+  auto closest = [&](int x, int y, int z, bool target) {
+    int best = df.getMaximumDistanceSquared();
+    for (int i = 0; i < df.getXNumCells(); ++i)
+      for (int j = 0; j < num_y; ++j)
+        for (int k = 0; k < num_z; ++k)
+          if (occupied[index(i, j, k)] == target)
+            best = std::min(best, dist_sq(i - x, j - y, k - z));
+    return best;
+  };
+  for (int x = 0; x < df.getXNumCells(); ++x)
+    for (int y = 0; y < num_y; ++y)
+      for (int z = 0; z < num_z; ++z)
+      {
+        ASSERT_EQ(df.getDistanceSquared(x, y, z), closest(x, y, z, true)) << x << " " << y << " " << z;
+        const int expected_negative = occupied[index(x, y, z)] ? closest(x, y, z, false) : 0;
+        ASSERT_EQ(df.getNegativeDistanceSquared(x, y, z), expected_negative) << x << " " << y << " " << z;
+      }
+}
+
+TEST(TestEuclideanDistanceField, TestBruteForce)
+{
+  // a cap below the grid diagonal exercises the maximum distance as well
+  for (unsigned int threads : { 1u, 3u })
+  {
+    EuclideanDistanceField df(WIDTH, HEIGHT, 0.6, RESOLUTION, ORIGIN_X, ORIGIN_Y, ORIGIN_Z, 0.5, true, threads);
+    std::vector<bool> occupied(df.getXNumCells() * df.getYNumCells() * df.getZNumCells(), false);
+    checkEuclideanDistances(df, occupied);
+
+    std::srand(7);
+    EigenSTL::vector_Vector3d points;
+    for (int i = 0; i < 12; ++i)
+    {
+      const int x = std::rand() % df.getXNumCells();
+      const int y = std::rand() % df.getYNumCells();
+      const int z = std::rand() % df.getZNumCells();
+      occupied[(x * df.getYNumCells() + y) * df.getZNumCells() + z] = true;
+      points.emplace_back();
+      df.gridToWorld(x, y, z, points.back().x(), points.back().y(), points.back().z());
+    }
+    // a solid block gives obstacle cells a non-trivial negative distance
+    for (int x = 5; x < 9; ++x)
+      for (int y = 2; y < 6; ++y)
+        for (int z = 1; z < 5; ++z)
+        {
+          occupied[(x * df.getYNumCells() + y) * df.getZNumCells() + z] = true;
+          points.emplace_back();
+          df.gridToWorld(x, y, z, points.back().x(), points.back().y(), points.back().z());
+        }
+    df.addPointsToField(points);
+    checkEuclideanDistances(df, occupied);
+
+    EigenSTL::vector_Vector3d removed(points.begin(), points.begin() + 6);
+    for (const Eigen::Vector3d& point : removed)
+    {
+      int x, y, z;
+      ASSERT_TRUE(df.worldToGrid(point.x(), point.y(), point.z(), x, y, z));
+      occupied[(x * df.getYNumCells() + y) * df.getZNumCells() + z] = false;
+    }
+    df.removePointsFromField(removed);
+    checkEuclideanDistances(df, occupied);
+
+    df.reset();
+    std::fill(occupied.begin(), occupied.end(), false);
+    checkEuclideanDistances(df, occupied);
+  }
+}
+
+TEST(TestEuclideanDistanceField, TestMatchesPropagation)
+{
+  PropagationDistanceField pdf(WIDTH, HEIGHT, DEPTH, RESOLUTION, ORIGIN_X, ORIGIN_Y, ORIGIN_Z, MAX_DIST);
+  EuclideanDistanceField edf(WIDTH, HEIGHT, DEPTH, RESOLUTION, ORIGIN_X, ORIGIN_Y, ORIGIN_Z, MAX_DIST);
+  EXPECT_EQ(pdf.getUninitializedDistance(), edf.getUninitializedDistance());
+
+  EigenSTL::vector_Vector3d points;
+  points.push_back(POINT1);
+  points.push_back(POINT2);
+  pdf.addPointsToField(points);
+  edf.addPointsToField(points);
+
+  // propagation is exact close to isolated obstacles
+  for (int x = 0; x < pdf.getXNumCells(); ++x)
+    for (int y = 0; y < pdf.getYNumCells(); ++y)
+      for (int z = 0; z < pdf.getZNumCells(); ++z)
+        EXPECT_NEAR(pdf.getDistance(x, y, z), edf.getDistance(x, y, z), 1e-9) << x << " " << y << " " << z;
+  EXPECT_NEAR(pdf.getDistance(-1.0, 0.0, 0.0), edf.getDistance(-1.0, 0.0, 0.0), 1e-9);
+
+  // the stream format is shared
+  std::stringstream stream;
+  ASSERT_TRUE(pdf.writeToStream(stream));
+  EuclideanDistanceField edf2(stream, MAX_DIST);
+  for (int x = 0; x < edf.getXNumCells(); ++x)
+    for (int y = 0; y < edf.getYNumCells(); ++y)
+      for (int z = 0; z < edf.getZNumCells(); ++z)
+        EXPECT_EQ(edf.getDistanceSquared(x, y, z), edf2.getDistanceSquared(x, y, z));
+}
+
 int main(int argc, char** argv)
 {
   testing::InitGoogleTest(&argc, argv);
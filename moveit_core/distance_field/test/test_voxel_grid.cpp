@@ -95,6 +95,40 @@ TEST(TestVoxelGrid, TestReadWrite)
       }
 }
 
+TEST(TestVoxelGrid, TestSparse)
+{
+  // 20 x 12 x 9 cells: partial blocks along every dimension
+  VoxelGrid<int> vg(0.2, 0.12, 0.09, 0.01, 0, 0, 0, -100, true);
+  ASSERT_TRUE(vg.isSparse());
+  EXPECT_EQ(vg.getNumCells(DIM_X), 20);
+  EXPECT_EQ(vg.getNumCells(DIM_Y), 12);
+  EXPECT_EQ(vg.getNumCells(DIM_Z), 9);
+  EXPECT_EQ(vg.getAllocatedBlockCount(), 0u);
+
+  vg.reset(5);
+  const VoxelGrid<int>& const_vg = vg;
+  EXPECT_EQ(const_vg.getCell(19, 11, 8), 5);
+  EXPECT_EQ(vg.getAllocatedBlockCount(), 0u);  // const reads do not allocate
+
+  vg.setCell(0, 0, 0, 1);
+  vg.getCell(19, 11, 8) = 2;
+  vg.setCell(Eigen::Vector3i(7, 7, 7), 3);
+  EXPECT_EQ(vg.getAllocatedBlockCount(), 2u);
+  EXPECT_EQ(const_vg.getCell(0, 0, 0), 1);
+  EXPECT_EQ(const_vg.getCell(19, 11, 8), 2);
+  EXPECT_EQ(const_vg.getCell(7, 7, 7), 3);
+  EXPECT_EQ(const_vg.getCell(1, 0, 0), 5);
+  EXPECT_EQ(const_vg.getCell(8, 8, 8), 5);
+
+  // world queries behave as for dense grids
+  EXPECT_EQ(vg(0.0, 0.0, 0.0), 1);
+  EXPECT_EQ(vg(-1.0, 0.0, 0.0), -100);
+
+  vg.reset(0);
+  EXPECT_EQ(vg.getAllocatedBlockCount(), 0u);
+  EXPECT_EQ(const_vg.getCell(0, 0, 0), 0);
+}
+
 int main(int argc, char** argv)
 {
   testing::InitGoogleTest(&argc, argv);
@@ -36,10 +36,6 @@
 
 #pragma once
 
-// KDL
-#include <kdl/chain.hpp>
-#include <kdl/chainidsolver_recursive_newton_euler.hpp>
-
 #include <moveit/robot_state/robot_state.h>
 #include <geometry_msgs/Vector3.h>
 #include <geometry_msgs/Wrench.h>
@@ -54,7 +50,8 @@ MOVEIT_CLASS_FORWARD(DynamicsSolver);  // Defines DynamicsSolverPtr, ConstPtr, W
 /**
  * This solver currently computes the required torques given a
  * joint configuration, velocities, accelerations and external wrenches
- * acting on the links of a robot
+ * acting on the links of a robot. Torques are computed with the recursive
+ * Newton-Euler algorithm directly on the joints and the URDF inertias of the chain.
  */
 class DynamicsSolver
 {
@@ -88,6 +85,29 @@ public:
                   const std::vector<double>& joint_accelerations, const std::vector<geometry_msgs::Wrench>& wrenches,
                   std::vector<double>& torques) const;
 
+  /**
+   * @brief Get the torques for a sequence of waypoints, e.g. of a trajectory, without
+   * external wrenches. Each column is one waypoint; rows are in the order of the joints
+   * for this group in the RobotModel.
+   * @param positions The joint positions, with number of rows = number of joints in the group
+   * @param velocities The joint velocities, of the same size as \e positions
+   * @param accelerations The joint accelerations, of the same size as \e positions
+   * @param torques Resized to the size of \e positions and filled with the torques
+   * @return False if any of the input matrices are of the wrong size
+   */
+  bool getTrajectoryTorques(const Eigen::MatrixXd& positions, const Eigen::MatrixXd& velocities,
+                            const Eigen::MatrixXd& accelerations, Eigen::MatrixXd& torques) const;
+
+  /**
+   * @brief Check torques computed by getTrajectoryTorques() against the maximum torques of the group.
+   * Joints without an effort limit are not checked.
+   * @param torques One column of joint torques per waypoint
+   * @param waypoint The first waypoint that exceeds a limit, if any
+   * @param joint_saturated The first joint at \e waypoint that exceeds its limit, if any
+   * @return True if all torques are within the limits
+   */
+  bool withinTorqueLimits(const Eigen::MatrixXd& torques, std::size_t& waypoint, unsigned int& joint_saturated) const;
+
   /**
    * @brief Get the maximum payload for this group (in kg). Payload is
    * the weight that this group can hold when the weight is attached to the origin
@@ -135,8 +155,26 @@ public:
   }
 
 private:
-  std::shared_ptr<KDL::ChainIdSolver_RNE> chain_id_solver_;  // KDL chain inverse dynamics
-  KDL::Chain kdl_chain_;                                     // KDL chain
+  /** \brief A link on the chain from base to tip, with its inertia expressed in the link frame */
+  struct ChainLink
+  {
+    int variable;                        // group variable index of the parent joint; -1 for fixed joints
+    bool prismatic;                      // the parent joint is prismatic rather than revolute
+    Eigen::Matrix3d origin_rotation;     // rotation of the parent joint origin, relative to the parent link
+    Eigen::Vector3d origin_translation;  // translation of the parent joint origin, relative to the parent link
+    Eigen::Vector3d axis;                // joint axis in the link frame
+    double mass;
+    Eigen::Vector3d first_moment;  // mass times center of mass
+    Eigen::Matrix3d inertia;       // rotational inertia about the link origin
+  };
+  struct Workspace;
+
+  /** \brief Recursive Newton-Euler for one waypoint. \e wrenches, if given, act on the chain links. */
+  void computeTorques(const double* positions, const double* velocities, const double* accelerations,
+                      const std::vector<geometry_msgs::Wrench>* wrenches, double* torques, Workspace& ws) const;
+
+  std::vector<ChainLink> chain_;
+  Eigen::Vector3d gravity_vector_;  // in the base frame
 
   moveit::core::RobotModelConstPtr robot_model_;
   const moveit::core::JointModelGroup* joint_model_group_;
@@ -35,11 +35,10 @@
 /* Author: Sachin Chitta */
 
 #include <moveit/dynamics_solver/dynamics_solver.h>
-
-// KDL
-#include <kdl/jntarray.hpp>
-#include <kdl_parser/kdl_parser.hpp>
-#include <kdl/tree.hpp>
+#include <moveit/robot_model/prismatic_joint_model.h>
+#include <moveit/robot_model/revolute_joint_model.h>
+#include <algorithm>
+#include <cmath>
 
 namespace dynamics_solver
 {
@@ -61,6 +60,18 @@ inline geometry_msgs::Vector3 transformVector(const Eigen::Isometry3d& transform
 }
 }  // namespace
 
+/** \brief Per-waypoint quantities of the recursive Newton-Euler passes, allocated once per batch */
+struct DynamicsSolver::Workspace
+{
+  explicit Workspace(std::size_t size) : rotation(size), translation(3, size), force(6, size)
+  {
+  }
+
+  std::vector<Eigen::Matrix3d> rotation;           // of each link relative to its parent link
+  Eigen::Matrix3Xd translation;                    // of each link relative to its parent link
+  Eigen::Matrix<double, 6, Eigen::Dynamic> force;  // force and torque on each link, about its origin
+};
+
 DynamicsSolver::DynamicsSolver(const moveit::core::RobotModelConstPtr& robot_model, const std::string& group_name,
                                const geometry_msgs::Vector3& gravity_vector)
 {
@@ -98,29 +109,101 @@ DynamicsSolver::DynamicsSolver(const moveit::core::RobotModelConstPtr& robot_mod
   tip_name_ = joint_model_group_->getLinkModelNames().back();
   ROS_DEBUG_NAMED("dynamics_solver", "Base name: '%s', Tip name: '%s'", base_name_.c_str(), tip_name_.c_str());
 
-  const urdf::ModelInterfaceSharedPtr urdf_model = robot_model_->getURDF();
-  const srdf::ModelConstSharedPtr srdf_model = robot_model_->getSRDF();
-  KDL::Tree tree;
+  // collect the links from the base to the tip
+  std::vector<const moveit::core::LinkModel*> links;
+  for (const moveit::core::LinkModel* link = robot_model_->getLinkModel(tip_name_);
+       link != joint->getParentLinkModel(); link = link->getParentLinkModel())
+  {
+    if (!link)
+    {
+      ROS_ERROR_NAMED("dynamics_solver", "Could not initialize chain object");
+      joint_model_group_ = nullptr;
+      return;
+    }
+    links.push_back(link);
+  }
+  std::reverse(links.begin(), links.end());
 
-  if (!kdl_parser::treeFromUrdfModel(*urdf_model, tree))
+  const urdf::ModelInterfaceSharedPtr urdf_model = robot_model_->getURDF();
+  num_joints_ = 0;
+  num_segments_ = links.size();
+  chain_.resize(links.size());
+  for (std::size_t i = 0; i < links.size(); ++i)
   {
-    ROS_ERROR_NAMED("dynamics_solver", "Could not initialize tree object");
-    joint_model_group_ = nullptr;
-    return;
+    const moveit::core::JointModel* link_joint = links[i]->getParentJointModel();
+    ChainLink& link = chain_[i];
+    link.variable = -1;
+    link.prismatic = false;
+    link.axis.setZero();
+    switch (link_joint->getType())
+    {
+      case moveit::core::JointModel::REVOLUTE:
+        link.axis = static_cast<const moveit::core::RevoluteJointModel*>(link_joint)->getAxis();
+        link.variable = joint_model_group_->getVariableGroupIndex(link_joint->getName());
+        break;
+      case moveit::core::JointModel::PRISMATIC:
+        link.axis = static_cast<const moveit::core::PrismaticJointModel*>(link_joint)->getAxis();
+        link.variable = joint_model_group_->getVariableGroupIndex(link_joint->getName());
+        link.prismatic = true;
+        break;
+      case moveit::core::JointModel::FIXED:
+        break;
+      default:
+        ROS_ERROR_NAMED("dynamics_solver", "Joint '%s' is neither revolute, prismatic nor fixed",
+                        link_joint->getName().c_str());
+        joint_model_group_ = nullptr;
+        return;
+    }
+    if (link_joint->getType() != moveit::core::JointModel::FIXED)
+    {
+      if (link.variable < 0)
+      {
+        ROS_ERROR_NAMED("dynamics_solver", "Joint '%s' is not part of group '%s'", link_joint->getName().c_str(),
+                        group_name.c_str());
+        joint_model_group_ = nullptr;
+        return;
+      }
+      ++num_joints_;
+    }
+    link.origin_rotation = links[i]->getJointOriginTransform().linear();
+    link.origin_translation = links[i]->getJointOriginTransform().translation();
+
+    // inertia about the link origin, in the link frame
+    link.mass = 0.0;
+    link.first_moment.setZero();
+    link.inertia.setZero();
+    const urdf::LinkConstSharedPtr urdf_link = urdf_model->getLink(links[i]->getName());
+    if (urdf_link && urdf_link->inertial)
+    {
+      const urdf::Inertial& inertial = *urdf_link->inertial;
+      const Eigen::Matrix3d rotation =
+          Eigen::Quaterniond(inertial.origin.rotation.w, inertial.origin.rotation.x, inertial.origin.rotation.y,
+                             inertial.origin.rotation.z)
+              .toRotationMatrix();
+      const Eigen::Vector3d com(inertial.origin.position.x, inertial.origin.position.y, inertial.origin.position.z);
+      Eigen::Matrix3d com_inertia;
+      com_inertia << inertial.ixx, inertial.ixy, inertial.ixz, inertial.ixy, inertial.iyy, inertial.iyz, inertial.ixz,
+          inertial.iyz, inertial.izz;
+      link.mass = inertial.mass;
+      link.first_moment = inertial.mass * com;
+      // parallel axis theorem
+      link.inertia = rotation * com_inertia * rotation.transpose() +
+                     inertial.mass * (com.squaredNorm() * Eigen::Matrix3d::Identity() - com * com.transpose());
+    }
   }
-  if (!tree.getChain(base_name_, tip_name_, kdl_chain_))
+  if (num_joints_ != joint_model_group_->getVariableCount())
   {
-    ROS_ERROR_NAMED("dynamics_solver", "Could not initialize chain object");
+    ROS_ERROR_NAMED("dynamics_solver", "Group '%s' has joints that are not on the chain from '%s' to '%s'",
+                    group_name.c_str(), base_name_.c_str(), tip_name_.c_str());
     joint_model_group_ = nullptr;
     return;
   }
-  num_joints_ = kdl_chain_.getNrOfJoints();
-  num_segments_ = kdl_chain_.getNrOfSegments();
 
   state_ = std::make_shared<moveit::core::RobotState>(robot_model_);
   state_->setToDefaultValues();
 
-  const std::vector<std::string>& joint_model_names = joint_model_group_->getJointModelNames();
+  // in the order of the joint variables; fixed joints have no torque
+  const std::vector<std::string>& joint_model_names = joint_model_group_->getActiveJointModelNames();
   for (const std::string& joint_model_name : joint_model_names)
   {
     const urdf::Joint* ujoint = urdf_model->getJoint(joint_model_name).get();
@@ -130,12 +213,92 @@ DynamicsSolver::DynamicsSolver(const moveit::core::RobotModelConstPtr& robot_mod
       max_torques_.push_back(0.0);
   }
 
-  KDL::Vector gravity(gravity_vector.x, gravity_vector.y,
-                      gravity_vector.z);  // \todo Not sure if KDL expects the negative of this (Sachin)
-  gravity_ = gravity.Norm();
+  gravity_vector_ = Eigen::Vector3d(gravity_vector.x, gravity_vector.y, gravity_vector.z);
+  gravity_ = gravity_vector_.norm();
   ROS_DEBUG_NAMED("dynamics_solver", "Gravity norm set to %f", gravity_);
+}
+
+void DynamicsSolver::computeTorques(const double* positions, const double* velocities, const double* accelerations,
+                                    const std::vector<geometry_msgs::Wrench>* wrenches, double* torques,
+                                    Workspace& ws) const
+{
+  // Motion and force vectors are split into linear and angular parts, expressed in a link frame about its origin.
+  // The base is at rest; gravity is modelled as an upward acceleration of the base.
+  Eigen::Vector3d v = Eigen::Vector3d::Zero(), w = Eigen::Vector3d::Zero();
+  Eigen::Vector3d dv = -gravity_vector_, dw = Eigen::Vector3d::Zero();
 
-  chain_id_solver_ = std::make_shared<KDL::ChainIdSolver_RNE>(kdl_chain_, gravity);
+  // outward pass: velocities and accelerations of the links, and the forces they need
+  for (std::size_t i = 0; i < chain_.size(); ++i)
+  {
+    const ChainLink& link = chain_[i];
+    Eigen::Matrix3d& r = ws.rotation[i];
+    Eigen::Vector3d p = link.origin_translation;
+    if (link.variable >= 0 && !link.prismatic)
+      r = link.origin_rotation * Eigen::AngleAxisd(positions[link.variable], link.axis).toRotationMatrix();
+    else
+    {
+      r = link.origin_rotation;
+      if (link.prismatic)
+        p += link.origin_rotation * link.axis * positions[link.variable];
+    }
+    ws.translation.col(i) = p;
+
+    // motion of the parent link, moved to the origin of this link
+    v = r.transpose() * (v + w.cross(p));
+    w = r.transpose() * w;
+    dv = r.transpose() * (dv + dw.cross(p));
+    dw = r.transpose() * dw;
+
+    // motion of the joint; its axis does not move in the link frame
+    if (link.variable >= 0)
+    {
+      const double qd = velocities[link.variable];
+      const double qdd = accelerations[link.variable];
+      if (link.prismatic)
+      {
+        const Eigen::Vector3d vj = link.axis * qd;
+        v += vj;
+        dv += link.axis * qdd + w.cross(vj);
+      }
+      else
+      {
+        const Eigen::Vector3d wj = link.axis * qd;
+        w += wj;
+        dv += v.cross(wj);
+        dw += link.axis * qdd + w.cross(wj);
+      }
+    }
+
+    // I * a + v x* (I * v) - f_ext
+    const Eigen::Vector3d& h = link.first_moment;
+    const Eigen::Vector3d momentum = link.mass * v - h.cross(w);
+    const Eigen::Vector3d angular_momentum = link.inertia * w + h.cross(v);
+    Eigen::Vector3d force = link.mass * dv - h.cross(dw) + w.cross(momentum);
+    Eigen::Vector3d torque = link.inertia * dw + h.cross(dv) + w.cross(angular_momentum) + v.cross(momentum);
+    if (wrenches)
+    {
+      const geometry_msgs::Wrench& wrench = (*wrenches)[i];
+      force -= Eigen::Vector3d(wrench.force.x, wrench.force.y, wrench.force.z);
+      torque -= Eigen::Vector3d(wrench.torque.x, wrench.torque.y, wrench.torque.z);
+    }
+    ws.force.col(i) << force, torque;
+  }
+
+  // inward pass: project the forces onto the joint axes and accumulate them towards the base
+  for (std::size_t i = chain_.size(); i-- > 0;)
+  {
+    const ChainLink& link = chain_[i];
+    const Eigen::Vector3d force = ws.force.col(i).head<3>();
+    const Eigen::Vector3d torque = ws.force.col(i).tail<3>();
+    if (link.variable >= 0)
+      torques[link.variable] = link.axis.dot(link.prismatic ? force : torque);
+    if (i > 0)
+    {
+      const Eigen::Vector3d parent_force = ws.rotation[i] * force;
+      ws.force.col(i - 1).head<3>() += parent_force;
+      ws.force.col(i - 1).tail<3>() += ws.rotation[i] * torque + ws.translation.col(i).cross(parent_force);
+    }
+  }
 }
 
 bool DynamicsSolver::getTorques(const std::vector<double>& joint_angles, const std::vector<double>& joint_velocities,
@@ -174,37 +337,57 @@ bool DynamicsSolver::getTorques(const std::vector<double>& joint_angles, const s
     return false;
   }
 
-  KDL::JntArray kdl_angles(num_joints_), kdl_velocities(num_joints_), kdl_accelerations(num_joints_),
-      kdl_torques(num_joints_);
-  KDL::Wrenches kdl_wrenches(num_segments_);
+  Workspace ws(chain_.size());
+  computeTorques(joint_angles.data(), joint_velocities.data(), joint_accelerations.data(), &wrenches, torques.data(),
+                 ws);
+  return true;
+}
 
-  for (unsigned int i = 0; i < num_joints_; ++i)
+bool DynamicsSolver::getTrajectoryTorques(const Eigen::MatrixXd& positions, const Eigen::MatrixXd& velocities,
+                                          const Eigen::MatrixXd& accelerations, Eigen::MatrixXd& torques) const
+{
+  if (!joint_model_group_)
   {
-    kdl_angles(i) = joint_angles[i];
-    kdl_velocities(i) = joint_velocities[i];
-    kdl_accelerations(i) = joint_accelerations[i];
+    ROS_DEBUG_NAMED("dynamics_solver", "Did not construct DynamicsSolver object properly. "
+                                       "Check error logs.");
+    return false;
   }
-
-  for (unsigned int i = 0; i < num_segments_; ++i)
+  if (positions.rows() != static_cast<Eigen::Index>(num_joints_))
   {
-    kdl_wrenches[i](0) = wrenches[i].force.x;
-    kdl_wrenches[i](1) = wrenches[i].force.y;
-    kdl_wrenches[i](2) = wrenches[i].force.z;
-
-    kdl_wrenches[i](3) = wrenches[i].torque.x;
-    kdl_wrenches[i](4) = wrenches[i].torque.y;
-    kdl_wrenches[i](5) = wrenches[i].torque.z;
+    ROS_ERROR_NAMED("dynamics_solver", "Joint positions should have %d rows", num_joints_);
+    return false;
   }
-
-  if (chain_id_solver_->CartToJnt(kdl_angles, kdl_velocities, kdl_accelerations, kdl_wrenches, kdl_torques) < 0)
+  if (velocities.rows() != positions.rows() || velocities.cols() != positions.cols())
   {
-    ROS_ERROR_NAMED("dynamics_solver", "Something went wrong computing torques");
+    ROS_ERROR_NAMED("dynamics_solver", "Joint velocities should be of the same size as the positions");
+    return false;
+  }
+  if (accelerations.rows() != positions.rows() || accelerations.cols() != positions.cols())
+  {
+    ROS_ERROR_NAMED("dynamics_solver", "Joint accelerations should be of the same size as the positions");
     return false;
   }
 
-  for (unsigned int i = 0; i < num_joints_; ++i)
-    torques[i] = kdl_torques(i);
+  // columns of column-major matrices are contiguous
+  torques.resize(positions.rows(), positions.cols());
+  Workspace ws(chain_.size());
+  for (Eigen::Index i = 0; i < positions.cols(); ++i)
+    computeTorques(positions.col(i).data(), velocities.col(i).data(), accelerations.col(i).data(), nullptr,
+                   torques.col(i).data(), ws);
+  return true;
+}
 
+bool DynamicsSolver::withinTorqueLimits(const Eigen::MatrixXd& torques, std::size_t& waypoint,
+                                        unsigned int& joint_saturated) const
+{
+  for (Eigen::Index i = 0; i < torques.cols(); ++i)
+    for (unsigned int j = 0; j < max_torques_.size() && j < static_cast<std::size_t>(torques.rows()); ++j)
+      if (max_torques_[j] > 0.0 && std::fabs(torques(j, i)) > max_torques_[j])
+      {
+        waypoint = i;
+        joint_saturated = j;
+        return false;
+      }
   return true;
 }
 
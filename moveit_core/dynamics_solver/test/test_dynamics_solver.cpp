@@ -0,0 +1,161 @@
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2026, PickNik LLC.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of PickNik LLC nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *********************************************************************/
+
+#include <moveit/dynamics_solver/dynamics_solver.h>
+#include <moveit/utils/robot_model_test_utils.h>
+#include <kdl/chainidsolver_recursive_newton_euler.hpp>
+#include <kdl_parser/kdl_parser.hpp>
+#include <gtest/gtest.h>
+#include <random>
+
+namespace
+{
+geometry_msgs::Pose makePose(double x, double y, double z, double qx, double qy, double qz, double qw)
+{
+  geometry_msgs::Pose pose;
+  pose.position.x = x;
+  pose.position.y = y;
+  pose.position.z = z;
+  pose.orientation.x = qx;
+  pose.orientation.y = qy;
+  pose.orientation.z = qz;
+  pose.orientation.w = qw;
+  return pose;
+}
+
+// a chain with revolute joints about different axes, a prismatic joint and a fixed tip
+moveit::core::RobotModelPtr buildArm()
+{
+  moveit::core::RobotModelBuilder builder("arm", "base");
+  builder.addChain("base->a", "revolute", { makePose(0.0, 0.0, 0.3, 0.0, 0.0, 0.0, 1.0) }, urdf::Vector3(0, 0, 1));
+  builder.addChain("a->b", "revolute", { makePose(0.1, 0.0, 0.2, 0.0, 0.0, 0.3826834, 0.9238795) },
+                   urdf::Vector3(0, 1, 0));
+  builder.addChain("b->c", "revolute", { makePose(0.4, 0.05, 0.0, 0.2588190, 0.0, 0.0, 0.9659258) },
+                   urdf::Vector3(1, 0, 0));
+  builder.addChain("c->d", "prismatic", { makePose(0.3, 0.0, 0.0, 0.0, 0.0, 0.0, 1.0) }, urdf::Vector3(1, 0, 0));
+  builder.addChain("d->tip", "fixed", { makePose(0.0, 0.0, 0.1, 0.0, 0.7071068, 0.0, 0.7071068) });
+  builder.addInertial("a", 3.0, makePose(0.0, 0.0, 0.1, 0.0, 0.0, 0.0, 1.0), 0.02, 0.0, 0.0, 0.02, 0.0, 0.01);
+  builder.addInertial("b", 2.0, makePose(0.2, 0.0, 0.0, 0.0, 0.0, 0.3826834, 0.9238795), 0.01, 0.001, 0.0, 0.03,
+                      0.0, 0.03);
+  builder.addInertial("c", 1.5, makePose(0.15, 0.02, -0.01, 0.0, 0.0, 0.0, 1.0), 0.005, 0.0, 0.001, 0.02, 0.0, 0.02);
+  builder.addInertial("d", 0.5, makePose(0.05, 0.0, 0.0, 0.0, 0.0, 0.0, 1.0), 0.001, 0.0, 0.0, 0.002, 0.0, 0.002);
+  builder.addInertial("tip", 0.2, makePose(0.0, 0.01, 0.02, 0.0, 0.0, 0.0, 1.0), 0.0005, 0.0, 0.0, 0.0005, 0.0,
+                      0.0005);
+  builder.addGroupChain("base", "tip", "arm");
+  return builder.build();
+}
+}  // namespace
+
+TEST(DynamicsSolver, MatchesKDL)
+{
+  const moveit::core::RobotModelPtr model = buildArm();
+  ASSERT_TRUE(model);
+  geometry_msgs::Vector3 gravity;
+  gravity.z = -9.81;
+  dynamics_solver::DynamicsSolver solver(model, "arm", gravity);
+  ASSERT_TRUE(solver.getGroup());
+
+  KDL::Tree tree;
+  KDL::Chain chain;
+  ASSERT_TRUE(kdl_parser::treeFromUrdfModel(*model->getURDF(), tree));
+  ASSERT_TRUE(tree.getChain("base", "tip", chain));
+  KDL::ChainIdSolver_RNE kdl_solver(chain, KDL::Vector(gravity.x, gravity.y, gravity.z));
+  const unsigned int joints = chain.getNrOfJoints();
+  const unsigned int segments = chain.getNrOfSegments();
+  ASSERT_EQ(joints, 4u);
+
+  std::mt19937 rng(42);
+  std::uniform_real_distribution<double> uniform(-1.0, 1.0);
+  for (int trial = 0; trial < 20; ++trial)
+  {
+    std::vector<double> q(joints), qd(joints), qdd(joints), torques(joints);
+    KDL::JntArray kdl_q(joints), kdl_qd(joints), kdl_qdd(joints), kdl_torques(joints);
+    for (unsigned int i = 0; i < joints; ++i)
+    {
+      kdl_q(i) = q[i] = uniform(rng);
+      kdl_qd(i) = qd[i] = uniform(rng);
+      kdl_qdd(i) = qdd[i] = uniform(rng);
+    }
+    std::vector<geometry_msgs::Wrench> wrenches(segments);
+    KDL::Wrenches kdl_wrenches(segments);
+    wrenches.back().force.x = uniform(rng);
+    wrenches.back().force.z = uniform(rng);
+    wrenches.back().torque.y = uniform(rng);
+    kdl_wrenches.back() = KDL::Wrench(KDL::Vector(wrenches.back().force.x, 0.0, wrenches.back().force.z),
+                                      KDL::Vector(0.0, wrenches.back().torque.y, 0.0));
+
+    ASSERT_TRUE(solver.getTorques(q, qd, qdd, wrenches, torques));
+    ASSERT_GE(kdl_solver.CartToJnt(kdl_q, kdl_qd, kdl_qdd, kdl_wrenches, kdl_torques), 0);
+    for (unsigned int i = 0; i < joints; ++i)
+      EXPECT_NEAR(torques[i], kdl_torques(i), 1e-9) << "trial " << trial << ", joint " << i;
+  }
+}
+
+TEST(DynamicsSolver, TrajectoryTorques)
+{
+  const moveit::core::RobotModelPtr model = buildArm();
+  geometry_msgs::Vector3 gravity;
+  gravity.z = -9.81;
+  dynamics_solver::DynamicsSolver solver(model, "arm", gravity);
+  ASSERT_TRUE(solver.getGroup());
+
+  const Eigen::MatrixXd positions = Eigen::MatrixXd::Random(4, 10);
+  const Eigen::MatrixXd velocities = Eigen::MatrixXd::Random(4, 10);
+  const Eigen::MatrixXd accelerations = Eigen::MatrixXd::Random(4, 10);
+  Eigen::MatrixXd torques;
+  ASSERT_TRUE(solver.getTrajectoryTorques(positions, velocities, accelerations, torques));
+  ASSERT_EQ(torques.rows(), 4);
+  ASSERT_EQ(torques.cols(), 10);
+
+  const std::vector<geometry_msgs::Wrench> wrenches(5);
+  for (Eigen::Index i = 0; i < positions.cols(); ++i)
+  {
+    const auto column = [i](const Eigen::MatrixXd& m) {
+      return std::vector<double>(m.col(i).data(), m.col(i).data() + m.rows());
+    };
+    std::vector<double> expected(4);
+    ASSERT_TRUE(solver.getTorques(column(positions), column(velocities), column(accelerations), wrenches, expected));
+    for (Eigen::Index j = 0; j < 4; ++j)
+      EXPECT_NEAR(torques(j, i), expected[j], 1e-12);
+  }
+
+  Eigen::MatrixXd wrong_size = Eigen::MatrixXd::Zero(3, 10);
+  EXPECT_FALSE(solver.getTrajectoryTorques(wrong_size, wrong_size, wrong_size, torques));
+}
+
+int main(int argc, char** argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -46,6 +46,7 @@
 #include <moveit_msgs/Constraints.h>
 
 #include <iostream>
+#include <mutex>
 #include <vector>
 
 /** \brief Representation and evaluation of kinematic constraints */
@@ -108,6 +109,38 @@ public:
    */
   virtual ConstraintEvaluationResult decide(const moveit::core::RobotState& state, bool verbose = false) const = 0;
 
+  /**
+   * \brief Decide whether the constraint is satisfied in each of the indicated states. Only
+   * satisfaction is decided, no distances are computed. States already marked as not satisfied
+   * are skipped and states violating the constraint are marked as not satisfied. The default
+   * implementation calls decide() for each state.
+   *
+   * @param [in] states The kinematic states used for evaluation, with up to date link transforms
+   * @param [in,out] satisfied One flag per state
+   */
+  virtual void decideBatch(const std::vector<const moveit::core::RobotState*>& states,
+                           std::vector<bool>& satisfied) const;
+
+  /**
+   * \brief Compute the violation of the constraint in the indicated
+   * state and its Jacobian with respect to the variables of a group.
+   *
+   * The violation is a vector that is zero if the constraint is
+   * satisfied and otherwise points from the closest satisfying value to
+   * the current one, so its squared norm is a smooth penalty for
+   * optimizers. Reference frames are treated as fixed when
+   * differentiating. The default implementation returns false.
+   *
+   * @param [in] state The kinematic state used for evaluation, with up to date link transforms
+   * @param [in] group The group whose variables correspond to the columns of the Jacobian
+   * @param [out] violation The violation of the constraint
+   * @param [out] jacobian The derivative of the violation with respect to the group variables
+   *
+   * @return True if the violation and its Jacobian could be computed
+   */
+  virtual bool computeJacobian(const moveit::core::RobotState& state, const moveit::core::JointModelGroup* group,
+                               Eigen::VectorXd& violation, Eigen::MatrixXd& jacobian) const;
+
   /** \brief This function returns true if this constraint is
       configured and able to decide whether states do meet the
       constraint or not. If this function returns false it means
@@ -246,6 +279,10 @@ public:
   bool equal(const KinematicConstraint& other, double margin) const override;
 
   ConstraintEvaluationResult decide(const moveit::core::RobotState& state, bool verbose = false) const override;
+  void decideBatch(const std::vector<const moveit::core::RobotState*>& states,
+                   std::vector<bool>& satisfied) const override;
+  bool computeJacobian(const moveit::core::RobotState& state, const moveit::core::JointModelGroup* group,
+                       Eigen::VectorXd& violation, Eigen::MatrixXd& jacobian) const override;
   bool enabled() const override;
   void clear() override;
   void print(std::ostream& out = std::cout) const override;
@@ -396,6 +433,10 @@ public:
 
   void clear() override;
   ConstraintEvaluationResult decide(const moveit::core::RobotState& state, bool verbose = false) const override;
+  void decideBatch(const std::vector<const moveit::core::RobotState*>& states,
+                   std::vector<bool>& satisfied) const override;
+  bool computeJacobian(const moveit::core::RobotState& state, const moveit::core::JointModelGroup* group,
+                       Eigen::VectorXd& violation, Eigen::MatrixXd& jacobian) const override;
   bool enabled() const override;
   void print(std::ostream& out = std::cout) const override;
 
@@ -484,6 +525,16 @@ public:
   }
 
 protected:
+  /**
+   * \brief Compute the absolute error of the orientation of the link in \e state about each axis, in the
+   * parameterization of the constraint
+   *
+   * @param [in] state The kinematic state used for evaluation
+   *
+   * @return The absolute x, y and z components of the error
+   */
+  Eigen::Vector3d computeError(const moveit::core::RobotState& state) const;
+
   const moveit::core::LinkModel* link_model_;   /**< \brief The target link model */
   Eigen::Matrix3d desired_rotation_matrix_;     /**< \brief The desired rotation matrix in the tf frame. Guaranteed to
                                                  * be valid rotation matrix. */
@@ -494,6 +545,11 @@ protected:
   int parameterization_type_;                   /**< \brief Parameterization type for orientation tolerance. */
   double absolute_x_axis_tolerance_, absolute_y_axis_tolerance_,
       absolute_z_axis_tolerance_; /**< \brief Storage for the tolerances */
+  Eigen::Quaterniond desired_rotation_quaternion_inv_; /**< \brief The inverse of the desired rotation as quaternion,
+                                                        * precomputed for the rotation vector error */
+  Eigen::Vector3d absolute_tolerances_; /**< \brief The tolerances padded by machine epsilon, as compared against the
+                                         * error */
+  double min_error_trace_; /**< \brief The smallest trace of the error rotation that can satisfy the tolerances */
 };
 
 MOVEIT_CLASS_FORWARD(PositionConstraint);  // Defines PositionConstraintPtr, ConstPtr, WeakPtr... etc
@@ -545,6 +601,20 @@ public:
    */
   bool configure(const moveit_msgs::PositionConstraint& pc, const moveit::core::Transforms& tf);
 
+  /**
+   * \brief Move the constraint regions to the poses in \e pc
+   *
+   * Unlike configure(), the region bodies are kept and only moved, so
+   * \e pc must constrain the same link with regions of the same
+   * shapes as the message this constraint was configured with. The
+   * target offset, the frame and the weight are taken from \e pc.
+   *
+   * @param [in] pc moveit_msgs::PositionConstraint with the new targets
+   *
+   * @return False, leaving the constraint unchanged, if the link or the number of regions differs
+   */
+  bool retarget(const moveit_msgs::PositionConstraint& pc, const moveit::core::Transforms& tf);
+
   /**
    * \brief Check if two constraints are the same.  For position
    * constraints this means that:
@@ -572,6 +642,10 @@ public:
 
   void clear() override;
   ConstraintEvaluationResult decide(const moveit::core::RobotState& state, bool verbose = false) const override;
+  void decideBatch(const std::vector<const moveit::core::RobotState*>& states,
+                   std::vector<bool>& satisfied) const override;
+  bool computeJacobian(const moveit::core::RobotState& state, const moveit::core::JointModelGroup* group,
+                       Eigen::VectorXd& violation, Eigen::MatrixXd& jacobian) const override;
   bool enabled() const override;
   void print(std::ostream& out = std::cout) const override;
 
@@ -648,6 +722,27 @@ public:
   }
 
 protected:
+  /** \brief Node of the bounding volume hierarchy over the constraint regions */
+  struct RegionTreeNode
+  {
+    Eigen::AlignedBox3d bounds; /**< \brief Bounds of all regions below the node */
+    std::size_t begin, end;     /**< \brief Range of the node's regions in region_tree_order_ */
+    std::size_t left, right;    /**< \brief Child nodes, 0 for leaves (the root is never a child) */
+  };
+
+  /** \brief Regions of constraints with fewer regions are searched linearly */
+  static const std::size_t REGION_TREE_MIN_REGIONS = 8;
+  /** \brief Maximum number of regions in a leaf of the region tree */
+  static const std::size_t REGION_TREE_LEAF_SIZE = 4;
+
+  /** \brief Build the hierarchy over the regions of a constraint in a fixed frame with many regions */
+  void buildRegionTree();
+  std::size_t buildRegionTreeNode(const std::vector<Eigen::AlignedBox3d>& bounds, std::size_t begin, std::size_t end);
+
+  /** \brief Get the lowest index of a region containing \e pt (in the model frame) using the region tree, or the
+   *  number of regions if no region contains it */
+  std::size_t findContainingRegion(const Eigen::Vector3d& pt) const;
+
   Eigen::Vector3d offset_;                         /**< \brief The target offset */
   bool has_offset_;                                /**< \brief Whether the offset is substantially different than 0.0 */
   std::vector<bodies::BodyPtr> constraint_region_; /**< \brief The constraint region vector */
@@ -656,6 +751,8 @@ protected:
   bool mobile_frame_;                         /**< \brief Whether or not a mobile frame is employed*/
   std::string constraint_frame_id_;           /**< \brief The constraint frame id */
   const moveit::core::LinkModel* link_model_; /**< \brief The link model constraint subject */
+  std::vector<RegionTreeNode> region_tree_;   /**< \brief Region hierarchy, empty if regions are searched linearly */
+  std::vector<std::size_t> region_tree_order_; /**< \brief Region indices ordered by the leaves of the tree */
 };
 
 MOVEIT_CLASS_FORWARD(VisibilityConstraint);  // Defines VisibilityConstraintPtr, ConstPtr, WeakPtr... etc
@@ -842,6 +939,21 @@ protected:
    */
   bool decideContact(const collision_detection::Contact& contact) const;
 
+  /**
+   * \brief Conservative test whether any robot link may intersect the visibility cone
+   *
+   * The bounding sphere of each link is tested against a circular cone that encloses the visibility cone.
+   * Links the cone is allowed to touch are skipped.
+   *
+   * @param [in] state The state providing the link poses
+   * @param [in] sp The pose of the sensor
+   * @param [in] tp The pose of the target
+   *
+   * @return False if no link can intersect the cone, so no collision check is needed
+   */
+  bool mayIntersectLinks(const moveit::core::RobotState& state, const Eigen::Isometry3d& sp,
+                         const Eigen::Isometry3d& tp) const;
+
   collision_detection::CollisionEnvPtr collision_env_; /**< \brief A copy of the collision robot maintained for
                                                               collision checking the cone against robot links */
   bool mobile_sensor_frame_;      /**< \brief True if the sensor is a non-fixed frame relative to the transform frame */
@@ -856,6 +968,8 @@ protected:
   double target_radius_;             /**< \brief Storage for the target radius */
   double max_view_angle_;            /**< \brief Storage for the max view angle */
   double max_range_angle_;           /**< \brief Storage for the max range angle */
+  shapes::ShapeConstPtr cone_; /**< \brief The visibility cone, built once if sensor and target are fixed relative to
+                                  each other; expressed in the sensor frame */
 };
 
 MOVEIT_CLASS_FORWARD(KinematicConstraintSet);  // Defines KinematicConstraintSetPtr, ConstPtr, WeakPtr... etc
@@ -939,6 +1053,23 @@ public:
    */
   bool add(const std::vector<moveit_msgs::VisibilityConstraint>& vc, const moveit::core::Transforms& tf);
 
+  /**
+   * \brief Replace the stored constraints by the constraints in \e c
+   *
+   * Equivalent to clear() followed by add(), but if \e c has the same
+   * structure as the stored constraints (the same kinds of
+   * constraints, in the order add() stores them, on the same joints
+   * and links, with regions of the same shapes), the member
+   * constraints are re-targeted in place and constraint regions are
+   * neither parsed nor allocated again. This suits replanning loops
+   * whose goals only change in value.
+   *
+   * @param [in] c A message potentially contain vectors of constraints of add types
+   *
+   * @return Whether or not all constraints could be successfully configured, as for add()
+   */
+  bool update(const moveit_msgs::Constraints& c, const moveit::core::Transforms& tf);
+
   /**
    * \brief Determines whether all constraints are satisfied by state,
    * returning a single evaluation result
@@ -973,6 +1104,39 @@ public:
   ConstraintEvaluationResult decide(const moveit::core::RobotState& state,
                                     std::vector<ConstraintEvaluationResult>& results, bool verbose = false) const;
 
+  /**
+   * \brief Determines for each of the states whether all constraints are satisfied.
+   *
+   * Only satisfaction is decided, no distances are computed, so each
+   * constraint only sees the states that satisfied the constraints
+   * evaluated before it. The constraints are evaluated in the order of
+   * their measured cost per rejected state, so cheap and selective
+   * constraints run first.
+   *
+   * @param [in] states The states to test, e.g. the waypoints of a
+   * trajectory, with up to date link transforms
+   *
+   * @param [out] satisfied Whether each state satisfies all constraints
+   */
+  void decideBatch(const std::vector<const moveit::core::RobotState*>& states, std::vector<bool>& satisfied) const;
+
+  /**
+   * \brief Compute the stacked violations of all constraints and their
+   * Jacobian with respect to the variables of a group.
+   *
+   * The rows of the constraints are stacked in the order in which the
+   * constraints were added. See KinematicConstraint::computeJacobian().
+   *
+   * @param [in] state The state to evaluate, with up to date link transforms
+   * @param [in] group The group whose variables correspond to the columns of the Jacobian
+   * @param [out] violation The stacked violations
+   * @param [out] jacobian The stacked Jacobians
+   *
+   * @return True if all constraints support the computation for the group
+   */
+  bool computeJacobian(const moveit::core::RobotState& state, const moveit::core::JointModelGroup* group,
+                       Eigen::VectorXd& violation, Eigen::MatrixXd& jacobian) const;
+
   /**
    * \brief Whether or not another KinematicConstraintSet is equal to
    * this one.
@@ -1064,6 +1228,14 @@ public:
   }
 
 protected:
+  /** \brief Measured cost and rejections of a member constraint during batch evaluation */
+  struct ConstraintStatistics
+  {
+    double seconds = 0.0;     /**< \brief Time spent evaluating the constraint */
+    std::size_t states = 0;   /**< \brief Number of states the constraint was evaluated on */
+    std::size_t rejected = 0; /**< \brief Number of those states that violated the constraint */
+  };
+
   moveit::core::RobotModelConstPtr robot_model_; /**< \brief The kinematic model used for by the Set */
   std::vector<KinematicConstraintPtr>
       kinematic_constraints_; /**<  \brief Shared pointers to all the member constraints */
@@ -1077,5 +1249,9 @@ protected:
   std::vector<moveit_msgs::VisibilityConstraint> visibility_constraints_;   /**<  \brief Messages corresponding to all
                                                                                internal visibility constraints */
   moveit_msgs::Constraints all_constraints_; /**<  \brief Messages corresponding to all internal constraints */
+
+  mutable std::mutex statistics_lock_; /**<  \brief Guards statistics_ */
+  mutable std::vector<ConstraintStatistics> statistics_; /**<  \brief Batch evaluation statistics, one entry per
+                                                            member constraint */
 };
 }  // namespace kinematic_constraints
@@ -42,9 +42,14 @@
 #include <geometric_shapes/check_isometry.h>
 #include <boost/math/constants/constants.hpp>
 #include <tf2_eigen/tf2_eigen.h>
+#include <ros/serialization.h>
+#include <algorithm>
+#include <chrono>
 #include <functional>
 #include <limits>
 #include <memory>
+#include <numeric>
+#include <unordered_map>
 
 namespace kinematic_constraints
 {
@@ -117,6 +122,49 @@ KinematicConstraint::KinematicConstraint(const moveit::core::RobotModelConstPtr&
 
 KinematicConstraint::~KinematicConstraint() = default;
 
+// collect the indices of the states that are not rejected yet
+static void collectUnrejected(const std::vector<bool>& satisfied, std::vector<std::size_t>& indices)
+{
+  indices.clear();
+  for (std::size_t i = 0; i < satisfied.size(); ++i)
+    if (satisfied[i])
+      indices.push_back(i);
+}
+
+void KinematicConstraint::decideBatch(const std::vector<const moveit::core::RobotState*>& states,
+                                      std::vector<bool>& satisfied) const
+{
+  for (std::size_t i = 0; i < states.size(); ++i)
+    if (satisfied[i])
+      satisfied[i] = decide(*states[i]).satisfied;
+}
+
+bool KinematicConstraint::computeJacobian(const moveit::core::RobotState& /*state*/,
+                                          const moveit::core::JointModelGroup* /*group*/,
+                                          Eigen::VectorXd& /*violation*/, Eigen::MatrixXd& /*jacobian*/) const
+{
+  return false;
+}
+
+// Jacobian of a point on a link with respect to the variables of a chain group, expressed in the model frame
+static bool computeLinkJacobian(const moveit::core::RobotState& state, const moveit::core::JointModelGroup* group,
+                                const moveit::core::LinkModel* link, const Eigen::Vector3d& offset,
+                                Eigen::MatrixXd& jacobian)
+{
+  if (!group->isChain() || !group->isLinkUpdated(link->getName()) || !state.getJacobian(group, link, offset, jacobian))
+    return false;
+
+  // RobotState::getJacobian() expresses the Jacobian in the parent link frame of the chain's root joint
+  const moveit::core::LinkModel* root_link = group->getJointModels()[0]->getParentLinkModel();
+  if (root_link)
+  {
+    const Eigen::Matrix3d rotation = state.getGlobalLinkTransform(root_link).linear();
+    jacobian.topRows<3>() = rotation * jacobian.topRows<3>();
+    jacobian.bottomRows<3>() = rotation * jacobian.bottomRows<3>();
+  }
+  return true;
+}
+
 bool JointConstraint::configure(const moveit_msgs::JointConstraint& jc)
 {
   // clearing before we configure to get rid of any old data
@@ -294,6 +342,35 @@ ConstraintEvaluationResult JointConstraint::decide(const moveit::core::RobotStat
   return ConstraintEvaluationResult(result, constraint_weight_ * fabs(dif));
 }
 
+void JointConstraint::decideBatch(const std::vector<const moveit::core::RobotState*>& states,
+                                  std::vector<bool>& satisfied) const
+{
+  if (!joint_model_)
+    return;
+
+  std::vector<std::size_t> indices;
+  collectUnrejected(satisfied, indices);
+  Eigen::ArrayXd dif(indices.size());
+  for (std::size_t k = 0; k < indices.size(); ++k)
+    dif[k] = states[indices[k]]->getVariablePosition(joint_variable_index_);
+
+  // same distance as in decide(), evaluated on all states at once
+  const double pi = boost::math::constants::pi<double>();
+  if (joint_is_continuous_)
+  {
+    dif = dif.unaryExpr(&normalizeAngle) - joint_position_;
+    dif = (dif > pi).select(2.0 * pi - dif, (dif < -pi).select(dif + 2.0 * pi, dif));
+  }
+  else
+    dif -= joint_position_;
+
+  const Eigen::Array<bool, Eigen::Dynamic, 1> result =
+      dif <= (joint_tolerance_above_ + 2.0 * std::numeric_limits<double>::epsilon()) &&
+      dif >= (-joint_tolerance_below_ - 2.0 * std::numeric_limits<double>::epsilon());
+  for (std::size_t k = 0; k < indices.size(); ++k)
+    satisfied[indices[k]] = result[k];
+}
+
 bool JointConstraint::enabled() const
 {
   return joint_model_;
@@ -309,6 +386,27 @@ void JointConstraint::clear()
   joint_position_ = joint_tolerance_below_ = joint_tolerance_above_ = 0.0;
 }
 
+bool JointConstraint::computeJacobian(const moveit::core::RobotState& state, const moveit::core::JointModelGroup* group,
+                                      Eigen::VectorXd& violation, Eigen::MatrixXd& jacobian) const
+{
+  violation = Eigen::VectorXd::Zero(1);
+  jacobian = Eigen::MatrixXd::Zero(1, group->getVariableCount());
+  if (!joint_model_)
+    return true;
+
+  double dif = state.getVariablePosition(joint_variable_index_) - joint_position_;
+  if (joint_is_continuous_)
+    dif = normalizeAngle(dif);
+  violation(0) = dif - std::max(-joint_tolerance_below_, std::min(joint_tolerance_above_, dif));
+
+  // the variable only has a column if it belongs to the group
+  const std::vector<std::string>& variables = group->getVariableNames();
+  const auto it = std::find(variables.begin(), variables.end(), joint_variable_name_);
+  if (violation(0) != 0.0 && it != variables.end())
+    jacobian(0, it - variables.begin()) = 1.0;
+  return true;
+}
+
 void JointConstraint::print(std::ostream& out) const
 {
   if (joint_model_)
@@ -326,6 +424,46 @@ void JointConstraint::print(std::ostream& out) const
     out << "No constraint" << std::endl;
 }
 
+// Bodies of constraint regions are cached by the serialized content of their shape message, so a constraint that
+// is configured again from the same message (e.g. for every request) only clones the cached body at its pose.
+// Clones share the mesh data of the cached body instead of recomputing it.
+template <typename ShapeMsg>
+static bodies::BodyPtr createRegionBody(const ShapeMsg& msg, const Eigen::Isometry3d& pose)
+{
+  static const std::size_t MAX_CACHED_BODIES = 1024;
+  static std::mutex cache_lock;
+  static std::unordered_map<std::string, bodies::BodyConstPtr> cache;
+
+  std::string key(ros::serialization::serializationLength(msg), '\0');
+  ros::serialization::OStream stream(reinterpret_cast<uint8_t*>(&key[0]), key.size());
+  ros::serialization::serialize(stream, msg);
+
+  bodies::BodyConstPtr body;
+  {
+    std::lock_guard<std::mutex> lock(cache_lock);
+    auto it = cache.find(key);
+    if (it != cache.end())
+      body = it->second;
+  }
+
+  if (!body)
+  {
+    std::unique_ptr<shapes::Shape> shape(shapes::constructShapeFromMsg(msg));
+    if (!shape)
+      return bodies::BodyPtr();
+    const bodies::BodyPtr new_body(bodies::createEmptyBodyFromShapeType(shape->type));
+    new_body->setDimensionsDirty(shape.get());
+    new_body->updateInternalData();
+    body = new_body;
+
+    std::lock_guard<std::mutex> lock(cache_lock);
+    if (cache.size() >= MAX_CACHED_BODIES)
+      cache.clear();
+    cache.emplace(std::move(key), body);
+  }
+  return body->cloneAt(pose);
+}
+
 bool PositionConstraint::configure(const moveit_msgs::PositionConstraint& pc, const moveit::core::Transforms& tf)
 {
   // clearing before we configure to get rid of any old data
@@ -364,25 +502,21 @@ bool PositionConstraint::configure(const moveit_msgs::PositionConstraint& pc, co
   // load primitive shapes, first clearing any we already have
   for (std::size_t i = 0; i < pc.constraint_region.primitives.size(); ++i)
   {
-    std::unique_ptr<shapes::Shape> shape(shapes::constructShapeFromMsg(pc.constraint_region.primitives[i]));
-    if (shape)
+    if (pc.constraint_region.primitive_poses.size() <= i)
+    {
+      ROS_WARN_NAMED("kinematic_constraints", "Constraint region message does not contain enough primitive poses");
+      continue;
+    }
+    Eigen::Isometry3d t;
+    tf2::fromMsg(pc.constraint_region.primitive_poses[i], t);
+    ASSERT_ISOMETRY(t)  // unsanitized input, could contain a non-isometry
+    if (!mobile_frame_)
+      tf.transformPose(pc.header.frame_id, t, t);
+
+    const bodies::BodyPtr body = createRegionBody(pc.constraint_region.primitives[i], t);
+    if (body)
     {
-      if (pc.constraint_region.primitive_poses.size() <= i)
-      {
-        ROS_WARN_NAMED("kinematic_constraints", "Constraint region message does not contain enough primitive poses");
-        continue;
-      }
-      Eigen::Isometry3d t;
-      tf2::fromMsg(pc.constraint_region.primitive_poses[i], t);
-      ASSERT_ISOMETRY(t)  // unsanitized input, could contain a non-isometry
       constraint_region_pose_.push_back(t);
-      if (!mobile_frame_)
-        tf.transformPose(pc.header.frame_id, constraint_region_pose_.back(), constraint_region_pose_.back());
-
-      const bodies::BodyPtr body(bodies::createEmptyBodyFromShapeType(shape->type));
-      body->setDimensionsDirty(shape.get());
-      body->setPoseDirty(constraint_region_pose_.back());
-      body->updateInternalData();
       constraint_region_.push_back(body);
     }
     else
@@ -392,24 +526,21 @@ bool PositionConstraint::configure(const moveit_msgs::PositionConstraint& pc, co
   // load meshes
   for (std::size_t i = 0; i < pc.constraint_region.meshes.size(); ++i)
   {
-    std::unique_ptr<shapes::Shape> shape(shapes::constructShapeFromMsg(pc.constraint_region.meshes[i]));
-    if (shape)
+    if (pc.constraint_region.mesh_poses.size() <= i)
+    {
+      ROS_WARN_NAMED("kinematic_constraints", "Constraint region message does not contain enough primitive poses");
+      continue;
+    }
+    Eigen::Isometry3d t;
+    tf2::fromMsg(pc.constraint_region.mesh_poses[i], t);
+    ASSERT_ISOMETRY(t)  // unsanitized input, could contain a non-isometry
+    if (!mobile_frame_)
+      tf.transformPose(pc.header.frame_id, t, t);
+
+    const bodies::BodyPtr body = createRegionBody(pc.constraint_region.meshes[i], t);
+    if (body)
     {
-      if (pc.constraint_region.mesh_poses.size() <= i)
-      {
-        ROS_WARN_NAMED("kinematic_constraints", "Constraint region message does not contain enough primitive poses");
-        continue;
-      }
-      Eigen::Isometry3d t;
-      tf2::fromMsg(pc.constraint_region.mesh_poses[i], t);
-      ASSERT_ISOMETRY(t)  // unsanitized input, could contain a non-isometry
       constraint_region_pose_.push_back(t);
-      if (!mobile_frame_)
-        tf.transformPose(pc.header.frame_id, constraint_region_pose_.back(), constraint_region_pose_.back());
-      const bodies::BodyPtr body(bodies::createEmptyBodyFromShapeType(shape->type));
-      body->setDimensionsDirty(shape.get());
-      body->setPoseDirty(constraint_region_pose_.back());
-      body->updateInternalData();
       constraint_region_.push_back(body);
     }
     else
@@ -417,6 +548,7 @@ bool PositionConstraint::configure(const moveit_msgs::PositionConstraint& pc, co
       ROS_WARN_NAMED("kinematic_constraints", "Could not construct mesh shape %zu", i);
     }
   }
+  buildRegionTree();
 
   if (pc.weight <= std::numeric_limits<double>::epsilon())
   {
@@ -431,6 +563,40 @@ bool PositionConstraint::configure(const moveit_msgs::PositionConstraint& pc, co
   return !constraint_region_.empty();
 }
 
+bool PositionConstraint::retarget(const moveit_msgs::PositionConstraint& pc, const moveit::core::Transforms& tf)
+{
+  if (link_model_ == nullptr || pc.link_name != link_model_->getName() || pc.header.frame_id.empty())
+    return false;
+  const std::vector<shape_msgs::SolidPrimitive>& primitives = pc.constraint_region.primitives;
+  const std::vector<shape_msgs::Mesh>& meshes = pc.constraint_region.meshes;
+  if (pc.constraint_region.primitive_poses.size() < primitives.size() ||
+      pc.constraint_region.mesh_poses.size() < meshes.size() ||
+      constraint_region_.size() != primitives.size() + meshes.size())
+    return false;
+
+  offset_ = Eigen::Vector3d(pc.target_point_offset.x, pc.target_point_offset.y, pc.target_point_offset.z);
+  has_offset_ = offset_.squaredNorm() > std::numeric_limits<double>::epsilon();
+  mobile_frame_ = !tf.isFixedFrame(pc.header.frame_id);
+  constraint_frame_id_ = mobile_frame_ ? pc.header.frame_id : tf.getTargetFrame();
+
+  for (std::size_t i = 0; i < constraint_region_.size(); ++i)
+  {
+    Eigen::Isometry3d t;
+    tf2::fromMsg(i < primitives.size() ? pc.constraint_region.primitive_poses[i] :
+                                         pc.constraint_region.mesh_poses[i - primitives.size()],
+                 t);
+    ASSERT_ISOMETRY(t)  // unsanitized input, could contain a non-isometry
+    if (!mobile_frame_)
+      tf.transformPose(pc.header.frame_id, t, t);
+    constraint_region_[i]->setPose(t);
+    constraint_region_pose_[i] = t;
+  }
+  buildRegionTree();
+
+  constraint_weight_ = pc.weight <= std::numeric_limits<double>::epsilon() ? 1.0 : pc.weight;
+  return true;
+}
+
 bool PositionConstraint::equal(const KinematicConstraint& other, double margin) const
 {
   if (other.getType() != type_)
@@ -510,6 +676,14 @@ ConstraintEvaluationResult PositionConstraint::decide(const moveit::core::RobotS
                                          verbose);
     }
   }
+  else if (!region_tree_.empty() && !verbose)
+  {
+    const std::size_t i = findContainingRegion(pt);
+    const bool result = i < constraint_region_.size();
+    const bodies::BodyPtr& region = result ? constraint_region_[i] : constraint_region_.back();
+    return finishPositionConstraintDecision(pt, region->getPose().translation(), link_model_->getName(),
+                                            constraint_weight_, result, verbose);
+  }
   else
   {
     for (std::size_t i = 0; i < constraint_region_.size(); ++i)
@@ -526,6 +700,150 @@ ConstraintEvaluationResult PositionConstraint::decide(const moveit::core::RobotS
   return ConstraintEvaluationResult(false, 0.0);
 }
 
+void PositionConstraint::decideBatch(const std::vector<const moveit::core::RobotState*>& states,
+                                     std::vector<bool>& satisfied) const
+{
+  if (!link_model_ || constraint_region_.empty())
+    return;
+  if (mobile_frame_)
+  {
+    KinematicConstraint::decideBatch(states, satisfied);
+    return;
+  }
+
+  std::vector<std::size_t> indices;
+  collectUnrejected(satisfied, indices);
+  if (!region_tree_.empty())
+  {
+    for (std::size_t index : indices)
+    {
+      const Eigen::Vector3d pt = states[index]->getGlobalLinkTransform(link_model_) * offset_;
+      satisfied[index] = findContainingRegion(pt) < constraint_region_.size();
+    }
+    return;
+  }
+
+  Eigen::Matrix3Xd points(3, indices.size());
+  for (std::size_t k = 0; k < indices.size(); ++k)
+    points.col(k) = states[indices[k]]->getGlobalLinkTransform(link_model_) * offset_;
+
+  // points outside the bounding spheres of all regions cannot be inside any region,
+  // so the exact (and more expensive) containment test only runs on the remaining ones
+  Eigen::Array<bool, 1, Eigen::Dynamic> near = Eigen::Array<bool, 1, Eigen::Dynamic>::Constant(indices.size(), false);
+  for (const bodies::BodyPtr& region : constraint_region_)
+  {
+    bodies::BoundingSphere sphere;
+    region->computeBoundingSphere(sphere);
+    const double radius = sphere.radius + 1e-9;  // keep points on the boundary for the exact test
+    near = near || ((points.colwise() - sphere.center).colwise().squaredNorm().array() <= radius * radius);
+  }
+
+  for (std::size_t k = 0; k < indices.size(); ++k)
+  {
+    bool result = false;
+    if (near[k])
+    {
+      const Eigen::Vector3d pt = points.col(k);
+      for (std::size_t i = 0; !result && i < constraint_region_.size(); ++i)
+        result = constraint_region_[i]->containsPoint(pt);
+    }
+    satisfied[indices[k]] = result;
+  }
+}
+
+// Violation of a point outside a region (pointing from the closest point of the region to the point) and its
+// derivative with respect to the point. Regions that are not spheres, boxes or cylinders are treated as their center.
+static void computeRegionViolation(const bodies::Body& region, const Eigen::Isometry3d& pose, const Eigen::Vector3d& pt,
+                                   Eigen::Vector3d& violation, Eigen::Matrix3d& derivative)
+{
+  const std::vector<double> dimensions = region.getDimensions();
+  const Eigen::Vector3d local = pose.inverse() * pt;
+  Eigen::Vector3d local_violation = Eigen::Vector3d::Zero();
+  Eigen::Matrix3d local_derivative = Eigen::Matrix3d::Zero();
+
+  switch (region.getType())
+  {
+    case shapes::SPHERE:
+    {
+      const double radius = dimensions[0];
+      const double norm = local.norm();
+      if (norm > radius)
+      {
+        local_violation = (1.0 - radius / norm) * local;
+        local_derivative = (1.0 - radius / norm) * Eigen::Matrix3d::Identity() +
+                           (radius / (norm * norm * norm)) * local * local.transpose();
+      }
+      break;
+    }
+    case shapes::BOX:
+      for (int i = 0; i < 3; ++i)
+      {
+        const double half_size = 0.5 * dimensions[i];
+        local_violation(i) = local(i) - std::max(-half_size, std::min(half_size, local(i)));
+        local_derivative(i, i) = local_violation(i) != 0.0 ? 1.0 : 0.0;
+      }
+      break;
+    case shapes::CYLINDER:
+    {
+      const double radius = dimensions[0];
+      const Eigen::Vector2d planar = local.head<2>();
+      const double norm = planar.norm();
+      if (norm > radius)
+      {
+        local_violation.head<2>() = (1.0 - radius / norm) * planar;
+        local_derivative.topLeftCorner<2, 2>() = (1.0 - radius / norm) * Eigen::Matrix2d::Identity() +
+                                                 (radius / (norm * norm * norm)) * planar * planar.transpose();
+      }
+      const double half_length = 0.5 * dimensions[1];
+      local_violation(2) = local(2) - std::max(-half_length, std::min(half_length, local(2)));
+      local_derivative(2, 2) = local_violation(2) != 0.0 ? 1.0 : 0.0;
+      break;
+    }
+    default:
+      local_violation = local;
+      local_derivative = Eigen::Matrix3d::Identity();
+  }
+  violation = pose.linear() * local_violation;
+  derivative = pose.linear() * local_derivative * pose.linear().transpose();
+}
+
+bool PositionConstraint::computeJacobian(const moveit::core::RobotState& state,
+                                         const moveit::core::JointModelGroup* group, Eigen::VectorXd& violation,
+                                         Eigen::MatrixXd& jacobian) const
+{
+  violation = Eigen::VectorXd::Zero(3);
+  jacobian = Eigen::MatrixXd::Zero(3, group->getVariableCount());
+  if (!enabled() || decide(state).satisfied)
+    return true;
+
+  Eigen::MatrixXd link_jacobian;
+  if (!computeLinkJacobian(state, group, link_model_, offset_, link_jacobian))
+    return false;
+
+  // the constraint is violated by all regions, the closest one determines the violation
+  const Eigen::Vector3d pt = state.getGlobalLinkTransform(link_model_) * offset_;
+  Eigen::Vector3d region_violation;
+  Eigen::Matrix3d region_derivative;
+  Eigen::Matrix3d derivative = Eigen::Matrix3d::Zero();
+  double closest = std::numeric_limits<double>::infinity();
+  for (std::size_t i = 0; i < constraint_region_.size(); ++i)
+  {
+    const Eigen::Isometry3d pose = mobile_frame_ ?
+                                       Eigen::Isometry3d(state.getFrameTransform(constraint_frame_id_) *
+                                                         constraint_region_pose_[i]) :
+                                       constraint_region_pose_[i];
+    computeRegionViolation(*constraint_region_[i], pose, pt, region_violation, region_derivative);
+    if (region_violation.squaredNorm() < closest)
+    {
+      closest = region_violation.squaredNorm();
+      violation = region_violation;
+      derivative = region_derivative;
+    }
+  }
+  jacobian = derivative * link_jacobian.topRows<3>();
+  return true;
+}
+
 void PositionConstraint::print(std::ostream& out) const
 {
   if (enabled())
@@ -534,12 +852,100 @@ void PositionConstraint::print(std::ostream& out) const
     out << "No constraint" << std::endl;
 }
 
+void PositionConstraint::buildRegionTree()
+{
+  region_tree_.clear();
+  region_tree_order_.clear();
+  if (mobile_frame_ || constraint_region_.size() < REGION_TREE_MIN_REGIONS)
+    return;
+
+  std::vector<Eigen::AlignedBox3d> bounds;
+  bounds.reserve(constraint_region_.size());
+  for (const bodies::BodyPtr& region : constraint_region_)
+  {
+    bodies::BoundingSphere sphere;
+    region->computeBoundingSphere(sphere);
+    const Eigen::Vector3d extents = Eigen::Vector3d::Constant(sphere.radius + 1e-9);
+    bounds.emplace_back(sphere.center - extents, sphere.center + extents);
+  }
+  region_tree_order_.resize(constraint_region_.size());
+  std::iota(region_tree_order_.begin(), region_tree_order_.end(), 0);
+  buildRegionTreeNode(bounds, 0, region_tree_order_.size());
+}
+
+std::size_t PositionConstraint::buildRegionTreeNode(const std::vector<Eigen::AlignedBox3d>& bounds, std::size_t begin,
+                                                    std::size_t end)
+{
+  const std::size_t index = region_tree_.size();
+  region_tree_.emplace_back();
+  Eigen::AlignedBox3d node_bounds;
+  Eigen::AlignedBox3d centers;
+  for (std::size_t k = begin; k < end; ++k)
+  {
+    node_bounds.extend(bounds[region_tree_order_[k]]);
+    centers.extend(bounds[region_tree_order_[k]].center());
+  }
+  region_tree_[index].bounds = node_bounds;
+  region_tree_[index].begin = begin;
+  region_tree_[index].end = end;
+  region_tree_[index].left = 0;
+  region_tree_[index].right = 0;
+  if (end - begin <= REGION_TREE_LEAF_SIZE)
+    return index;
+
+  // split at the median of the region centers along the axis in which they are spread the most
+  Eigen::Index axis;
+  centers.sizes().maxCoeff(&axis);
+  const std::size_t middle = begin + (end - begin) / 2;
+  std::nth_element(region_tree_order_.begin() + begin, region_tree_order_.begin() + middle,
+                   region_tree_order_.begin() + end, [&bounds, axis](std::size_t a, std::size_t b) {
+                     return bounds[a].min()[axis] + bounds[a].max()[axis] <
+                            bounds[b].min()[axis] + bounds[b].max()[axis];
+                   });
+  const std::size_t left = buildRegionTreeNode(bounds, begin, middle);
+  const std::size_t right = buildRegionTreeNode(bounds, middle, end);
+  region_tree_[index].left = left;
+  region_tree_[index].right = right;
+  return index;
+}
+
+std::size_t PositionConstraint::findContainingRegion(const Eigen::Vector3d& pt) const
+{
+  // the lowest index of a containing region is reported, as the linear scan in decide() would
+  std::size_t found = constraint_region_.size();
+  std::vector<std::size_t> stack(1, 0);
+  while (!stack.empty())
+  {
+    const RegionTreeNode& node = region_tree_[stack.back()];
+    stack.pop_back();
+    if (!node.bounds.contains(pt))
+      continue;
+    if (node.left == 0)
+    {
+      for (std::size_t k = node.begin; k < node.end; ++k)
+      {
+        const std::size_t i = region_tree_order_[k];
+        if (i < found && constraint_region_[i]->containsPoint(pt))
+          found = i;
+      }
+    }
+    else
+    {
+      stack.push_back(node.left);
+      stack.push_back(node.right);
+    }
+  }
+  return found;
+}
+
 void PositionConstraint::clear()
 {
   offset_ = Eigen::Vector3d(0.0, 0.0, 0.0);
   has_offset_ = false;
   constraint_region_.clear();
   constraint_region_pose_.clear();
+  region_tree_.clear();
+  region_tree_order_.clear();
   mobile_frame_ = false;
   constraint_frame_id_ = "";
   link_model_ = nullptr;
@@ -590,6 +996,7 @@ bool OrientationConstraint::configure(const moveit_msgs::OrientationConstraint&
     desired_rotation_matrix_ = Eigen::Matrix3d(q);
     mobile_frame_ = true;
   }
+  desired_rotation_quaternion_inv_ = Eigen::Quaterniond(desired_rotation_matrix_).conjugate();
   std::stringstream matrix_str;
   matrix_str << desired_rotation_matrix_;
   ROS_DEBUG_NAMED("kinematic_constraints", "The desired rotation matrix for link '%s' in frame %s is:\n%s",
@@ -627,6 +1034,19 @@ bool OrientationConstraint::configure(const moveit_msgs::OrientationConstraint&
   if (absolute_z_axis_tolerance_ < std::numeric_limits<double>::epsilon())
     ROS_WARN_NAMED("kinematic_constraints", "Near-zero value for absolute_z_axis_tolerance");
 
+  absolute_tolerances_ = Eigen::Vector3d(absolute_x_axis_tolerance_, absolute_y_axis_tolerance_,
+                                         absolute_z_axis_tolerance_)
+                             .array() +
+                         std::numeric_limits<double>::epsilon();
+
+  // The rotation angle of the error is at most the sum of the Euler angles, or the norm of the rotation vector, so
+  // states rotated further than all tolerances together allow can be rejected from the trace of the error alone.
+  const double max_angle = (parameterization_type_ == moveit_msgs::OrientationConstraint::ROTATION_VECTOR ?
+                                absolute_tolerances_.norm() :
+                                absolute_tolerances_.sum()) +
+                           1e-9;
+  min_error_trace_ = max_angle < boost::math::constants::pi<double>() ? 1.0 + 2.0 * std::cos(max_angle) : -1.0;
+
   return link_model_ != nullptr;
 }
 
@@ -656,6 +1076,9 @@ void OrientationConstraint::clear()
   desired_rotation_frame_id_ = "";
   mobile_frame_ = false;
   absolute_z_axis_tolerance_ = absolute_y_axis_tolerance_ = absolute_x_axis_tolerance_ = 0.0;
+  desired_rotation_quaternion_inv_ = Eigen::Quaterniond::Identity();
+  absolute_tolerances_ = Eigen::Vector3d::Zero();
+  min_error_trace_ = -1.0;
 }
 
 bool OrientationConstraint::enabled() const
@@ -663,67 +1086,63 @@ bool OrientationConstraint::enabled() const
   return link_model_;
 }
 
-ConstraintEvaluationResult OrientationConstraint::decide(const moveit::core::RobotState& state, bool verbose) const
+Eigen::Vector3d OrientationConstraint::computeError(const moveit::core::RobotState& state) const
 {
-  if (!link_model_)
-    return ConstraintEvaluationResult(true, 0.0);
+  // getGlobalLinkTransform() and getFrameTransform() return valid isometries by contract
+  const auto link_rotation = state.getGlobalLinkTransform(link_model_).linear();
 
-  Eigen::Isometry3d diff;
-  if (mobile_frame_)
+  if (parameterization_type_ == moveit_msgs::OrientationConstraint::ROTATION_VECTOR)
   {
-    // getFrameTransform() returns a valid isometry by contract
-    Eigen::Matrix3d tmp = state.getFrameTransform(desired_rotation_frame_id_).linear() * desired_rotation_matrix_;
-    // getGlobalLinkTransform() returns a valid isometry by contract
-    diff = Eigen::Isometry3d(tmp.transpose() * state.getGlobalLinkTransform(link_model_).linear());  // valid isometry
-  }
-  else
-  {
-    // diff is valid isometry by construction
-    diff = Eigen::Isometry3d(desired_rotation_matrix_inv_ * state.getGlobalLinkTransform(link_model_).linear());
+    // the rotation vector follows from the error quaternion directly, without going through Eigen::AngleAxis
+    Eigen::Quaterniond q(link_rotation);
+    if (mobile_frame_)
+      q = desired_rotation_quaternion_inv_ *
+          Eigen::Quaterniond(state.getFrameTransform(desired_rotation_frame_id_).linear()).conjugate() * q;
+    else
+      q = desired_rotation_quaternion_inv_ * q;
+    const double sin_half_angle = q.vec().norm();
+    // the angle is 2 atan2(|v|, |w|), and angle / |v| tends to 2 / |w| for small angles
+    const double scale = sin_half_angle > std::numeric_limits<double>::epsilon() ?
+                             2.0 * std::atan2(sin_half_angle, std::abs(q.w())) / sin_half_angle :
+                             2.0 / std::abs(q.w());
+    return (scale * q.vec()).cwiseAbs();
   }
 
-  // This needs to live outside the if-block scope (as xyz_rotation points to its data).
-  std::tuple<Eigen::Vector3d, bool> euler_angles_error;
-  Eigen::Vector3d xyz_rotation;
-  if (parameterization_type_ == moveit_msgs::OrientationConstraint::XYZ_EULER_ANGLES)
+  Eigen::Matrix3d diff;
+  if (mobile_frame_)
+    diff = (state.getFrameTransform(desired_rotation_frame_id_).linear() * desired_rotation_matrix_).transpose() *
+           link_rotation;
+  else
+    diff = desired_rotation_matrix_inv_ * link_rotation;
+
+  // parameterization_type_ is validated in configure, so this is XYZ_EULER_ANGLES
+  std::tuple<Eigen::Vector3d, bool> euler_angles_error = CalcEulerAngles(diff);
+  // Converting from a rotation matrix to intrinsic XYZ Euler angles has 2 singularities:
+  // pitch ~= pi/2 ==> roll + yaw = theta
+  // pitch ~= -pi/2 ==> roll - yaw = theta
+  // in those cases CalcEulerAngles will set roll (xyz_rotation(0)) to theta and yaw (xyz_rotation(2)) to zero, so for
+  // us to be able to capture yaw tolerance violations we do the following: If theta violates the absolute yaw
+  // tolerance we think of it as a pure yaw rotation and set roll to zero.
+  Eigen::Vector3d xyz_rotation = std::get<Eigen::Vector3d>(euler_angles_error);
+  if (!std::get<bool>(euler_angles_error))
   {
-    euler_angles_error = CalcEulerAngles(diff.linear());
-    // Converting from a rotation matrix to intrinsic XYZ Euler angles has 2 singularities:
-    // pitch ~= pi/2 ==> roll + yaw = theta
-    // pitch ~= -pi/2 ==> roll - yaw = theta
-    // in those cases CalcEulerAngles will set roll (xyz_rotation(0)) to theta and yaw (xyz_rotation(2)) to zero, so for
-    // us to be able to capture yaw tolerance violations we do the following: If theta violates the absolute yaw
-    // tolerance we think of it as a pure yaw rotation and set roll to zero.
-    xyz_rotation = std::get<Eigen::Vector3d>(euler_angles_error);
-    if (!std::get<bool>(euler_angles_error))
+    if (normalizeAbsoluteAngle(xyz_rotation(0)) > absolute_tolerances_(2))
     {
-      if (normalizeAbsoluteAngle(xyz_rotation(0)) > absolute_z_axis_tolerance_ + std::numeric_limits<double>::epsilon())
-      {
-        xyz_rotation(2) = xyz_rotation(0);
-        xyz_rotation(0) = 0;
-      }
+      xyz_rotation(2) = xyz_rotation(0);
+      xyz_rotation(0) = 0;
     }
-    // Account for angle wrapping
-    xyz_rotation = xyz_rotation.unaryExpr(&normalizeAbsoluteAngle);
-  }
-  else if (parameterization_type_ == moveit_msgs::OrientationConstraint::ROTATION_VECTOR)
-  {
-    Eigen::AngleAxisd aa(diff.linear());
-    xyz_rotation = aa.axis() * aa.angle();
-    xyz_rotation(0) = fabs(xyz_rotation(0));
-    xyz_rotation(1) = fabs(xyz_rotation(1));
-    xyz_rotation(2) = fabs(xyz_rotation(2));
-  }
-  else
-  {
-    /* The parameterization type should be validated in configure, so this should never happen. */
-    ROS_ERROR_STREAM_NAMED("kinematic_constraints",
-                           "The parameterization type for the orientation constraints is invalid.");
   }
+  // Account for angle wrapping
+  return xyz_rotation.unaryExpr(&normalizeAbsoluteAngle);
+}
 
-  bool result = xyz_rotation(2) < absolute_z_axis_tolerance_ + std::numeric_limits<double>::epsilon() &&
-                xyz_rotation(1) < absolute_y_axis_tolerance_ + std::numeric_limits<double>::epsilon() &&
-                xyz_rotation(0) < absolute_x_axis_tolerance_ + std::numeric_limits<double>::epsilon();
+ConstraintEvaluationResult OrientationConstraint::decide(const moveit::core::RobotState& state, bool verbose) const
+{
+  if (!link_model_)
+    return ConstraintEvaluationResult(true, 0.0);
+
+  const Eigen::Vector3d xyz_rotation = computeError(state);
+  bool result = (xyz_rotation.array() < absolute_tolerances_.array()).all();
 
   if (verbose)
   {
@@ -740,6 +1159,76 @@ ConstraintEvaluationResult OrientationConstraint::decide(const moveit::core::Rob
   return ConstraintEvaluationResult(result, constraint_weight_ * (xyz_rotation(0) + xyz_rotation(1) + xyz_rotation(2)));
 }
 
+void OrientationConstraint::decideBatch(const std::vector<const moveit::core::RobotState*>& states,
+                                        std::vector<bool>& satisfied) const
+{
+  if (!link_model_)
+    return;
+
+  std::vector<std::size_t> indices;
+  collectUnrejected(satisfied, indices);
+  if (!mobile_frame_ && min_error_trace_ > -1.0)
+  {
+    Eigen::Matrix<double, 9, Eigen::Dynamic> rotations(9, indices.size());
+    for (std::size_t k = 0; k < indices.size(); ++k)
+      Eigen::Map<Eigen::Matrix3d>(rotations.col(k).data()) =
+          states[indices[k]]->getGlobalLinkTransform(link_model_).linear();
+
+    // the trace of the error rotation is 1 + 2 cos(angle); as a sum of element-wise products it is
+    // evaluated for all states with a single matrix-vector product
+    const Eigen::Matrix<double, 1, Eigen::Dynamic> traces =
+        Eigen::Map<const Eigen::Matrix<double, 9, 1>>(desired_rotation_matrix_.data()).transpose() * rotations;
+    for (std::size_t k = 0; k < indices.size(); ++k)
+      if (traces[k] < min_error_trace_)
+        satisfied[indices[k]] = false;
+  }
+
+  for (std::size_t index : indices)
+    if (satisfied[index])
+      satisfied[index] = (computeError(*states[index]).array() < absolute_tolerances_.array()).all();
+}
+
+bool OrientationConstraint::computeJacobian(const moveit::core::RobotState& state,
+                                            const moveit::core::JointModelGroup* group, Eigen::VectorXd& violation,
+                                            Eigen::MatrixXd& jacobian) const
+{
+  violation = Eigen::VectorXd::Zero(3);
+  jacobian = Eigen::MatrixXd::Zero(3, group->getVariableCount());
+  if (!link_model_)
+    return true;
+
+  Eigen::MatrixXd link_jacobian;
+  if (!computeLinkJacobian(state, group, link_model_, Eigen::Vector3d::Zero(), link_jacobian))
+    return false;
+
+  // the violation is measured on the rotation vector of the error in the desired frame, for both parameterizations
+  const Eigen::Matrix3d desired =
+      mobile_frame_ ? Eigen::Matrix3d(state.getFrameTransform(desired_rotation_frame_id_).linear() *
+                                      desired_rotation_matrix_) :
+                      desired_rotation_matrix_;
+  const Eigen::AngleAxisd error_rotation(desired.transpose() * state.getGlobalLinkTransform(link_model_).linear());
+  const double angle = error_rotation.angle();
+  const Eigen::Vector3d error = angle * error_rotation.axis();
+  Eigen::Vector3d mask;
+  for (int i = 0; i < 3; ++i)
+  {
+    violation(i) = error(i) - std::max(-absolute_tolerances_(i), std::min(absolute_tolerances_(i), error(i)));
+    mask(i) = violation(i) != 0.0 ? 1.0 : 0.0;
+  }
+  if (mask.isZero())
+    return true;
+
+  // a rotation u (in the desired frame) applied to the link changes the error by the inverse left Jacobian of SO(3)
+  Eigen::Matrix3d skew;
+  skew << 0.0, -error(2), error(1), error(2), 0.0, -error(0), -error(1), error(0), 0.0;
+  Eigen::Matrix3d inverse_left_jacobian = Eigen::Matrix3d::Identity() - 0.5 * skew;
+  if (angle > 1e-6)
+    inverse_left_jacobian +=
+        (1.0 / (angle * angle) - (1.0 + std::cos(angle)) / (2.0 * angle * std::sin(angle))) * skew * skew;
+  jacobian = mask.asDiagonal() * inverse_left_jacobian * desired.transpose() * link_jacobian.bottomRows<3>();
+  return true;
+}
+
 void OrientationConstraint::print(std::ostream& out) const
 {
   if (link_model_)
@@ -752,6 +1241,64 @@ void OrientationConstraint::print(std::ostream& out) const
     out << "No constraint" << std::endl;
 }
 
+// build the mesh of the visibility cone from the sensor pose, the target pose and the points on the base disc
+static shapes::Mesh* createVisibilityCone(const Eigen::Isometry3d& sp, const Eigen::Isometry3d& tp,
+                                          const EigenSTL::vector_Vector3d& points)
+{
+  // allocate memory for a mesh to represent the visibility cone
+  shapes::Mesh* m = new shapes::Mesh();
+  m->vertex_count = points.size() + 2;
+  m->vertices = new double[m->vertex_count * 3];
+  m->triangle_count = points.size() * 2;
+  m->triangles = new unsigned int[m->triangle_count * 3];
+  // we do NOT allocate normals because we do not compute them
+
+  // the sensor origin
+  m->vertices[0] = sp.translation().x();
+  m->vertices[1] = sp.translation().y();
+  m->vertices[2] = sp.translation().z();
+
+  // the center of the base of the cone approximation
+  m->vertices[3] = tp.translation().x();
+  m->vertices[4] = tp.translation().y();
+  m->vertices[5] = tp.translation().z();
+
+  // the points that approximate the base disc
+  for (std::size_t i = 0; i < points.size(); ++i)
+  {
+    m->vertices[i * 3 + 6] = points[i].x();
+    m->vertices[i * 3 + 7] = points[i].y();
+    m->vertices[i * 3 + 8] = points[i].z();
+  }
+
+  // add the triangles
+  std::size_t p3 = points.size() * 3;
+  for (std::size_t i = 1; i < points.size(); ++i)
+  {
+    // triangle forming a side of the cone, using the sensor origin
+    std::size_t i3 = (i - 1) * 3;
+    m->triangles[i3] = i + 1;
+    m->triangles[i3 + 1] = 0;
+    m->triangles[i3 + 2] = i + 2;
+    // triangle forming a part of the base of the cone, using the center of the base
+    std::size_t i6 = p3 + i3;
+    m->triangles[i6] = i + 1;
+    m->triangles[i6 + 1] = 1;
+    m->triangles[i6 + 2] = i + 2;
+  }
+
+  // last triangles
+  m->triangles[p3 - 3] = points.size() + 1;
+  m->triangles[p3 - 2] = 0;
+  m->triangles[p3 - 1] = 2;
+  p3 *= 2;
+  m->triangles[p3 - 3] = points.size() + 1;
+  m->triangles[p3 - 2] = 1;
+  m->triangles[p3 - 1] = 2;
+
+  return m;
+}
+
 VisibilityConstraint::VisibilityConstraint(const moveit::core::RobotModelConstPtr& model)
   : KinematicConstraint(model), collision_env_(new collision_detection::CollisionEnvFCL(model))
 {
@@ -772,6 +1319,7 @@ void VisibilityConstraint::clear()
   target_radius_ = -1.0;
   max_view_angle_ = 0.0;
   max_range_angle_ = 0.0;
+  cone_.reset();
 }
 
 bool VisibilityConstraint::configure(const moveit_msgs::VisibilityConstraint& vc, const moveit::core::Transforms& tf)
@@ -850,6 +1398,19 @@ bool VisibilityConstraint::configure(const moveit_msgs::VisibilityConstraint& vc
   max_range_angle_ = vc.max_range_angle;
   sensor_view_direction_ = vc.sensor_view_direction;
 
+  // if sensor and target are fixed relative to each other the cone keeps its shape and is only moved along with the
+  // sensor frame, so it is built once here
+  if (!mobile_sensor_frame_ && !mobile_target_frame_)
+    cone_.reset(createVisibilityCone(sensor_pose_, target_pose_, points_));
+  else if (mobile_sensor_frame_ && mobile_target_frame_ &&
+           moveit::core::Transforms::sameFrame(sensor_frame_id_, target_frame_id_))
+  {
+    EigenSTL::vector_Vector3d points(points_.size());
+    for (std::size_t i = 0; i < points_.size(); ++i)
+      points[i] = target_pose_ * points_[i];
+    cone_.reset(createVisibilityCone(sensor_pose_, target_pose_, points));
+  }
+
   return target_radius_ > std::numeric_limits<double>::epsilon();
 }
 
@@ -897,68 +1458,12 @@ shapes::Mesh* VisibilityConstraint::getVisibilityCone(const moveit::core::RobotS
       mobile_target_frame_ ? state.getFrameTransform(target_frame_id_) * target_pose_ : target_pose_;
 
   // transform the points on the disc to the desired target frame
-  const EigenSTL::vector_Vector3d* points = &points_;
-  std::unique_ptr<EigenSTL::vector_Vector3d> temp_points;
-  if (mobile_target_frame_)
-  {
-    temp_points = std::make_unique<EigenSTL::vector_Vector3d>(points_.size());
-    for (std::size_t i = 0; i < points_.size(); ++i)
-      temp_points->at(i) = tp * points_[i];
-    points = temp_points.get();
-  }
-
-  // allocate memory for a mesh to represent the visibility cone
-  shapes::Mesh* m = new shapes::Mesh();
-  m->vertex_count = cone_sides_ + 2;
-  m->vertices = new double[m->vertex_count * 3];
-  m->triangle_count = cone_sides_ * 2;
-  m->triangles = new unsigned int[m->triangle_count * 3];
-  // we do NOT allocate normals because we do not compute them
-
-  // the sensor origin
-  m->vertices[0] = sp.translation().x();
-  m->vertices[1] = sp.translation().y();
-  m->vertices[2] = sp.translation().z();
-
-  // the center of the base of the cone approximation
-  m->vertices[3] = tp.translation().x();
-  m->vertices[4] = tp.translation().y();
-  m->vertices[5] = tp.translation().z();
-
-  // the points that approximate the base disc
-  for (std::size_t i = 0; i < points->size(); ++i)
-  {
-    m->vertices[i * 3 + 6] = points->at(i).x();
-    m->vertices[i * 3 + 7] = points->at(i).y();
-    m->vertices[i * 3 + 8] = points->at(i).z();
-  }
-
-  // add the triangles
-  std::size_t p3 = points->size() * 3;
-  for (std::size_t i = 1; i < points->size(); ++i)
-  {
-    // triangle forming a side of the cone, using the sensor origin
-    std::size_t i3 = (i - 1) * 3;
-    m->triangles[i3] = i + 1;
-    m->triangles[i3 + 1] = 0;
-    m->triangles[i3 + 2] = i + 2;
-    // triangle forming a part of the base of the cone, using the center of the base
-    std::size_t i6 = p3 + i3;
-    m->triangles[i6] = i + 1;
-    m->triangles[i6 + 1] = 1;
-    m->triangles[i6 + 2] = i + 2;
-  }
-
-  // last triangles
-  m->triangles[p3 - 3] = points->size() + 1;
-  m->triangles[p3 - 2] = 0;
-  m->triangles[p3 - 1] = 2;
-  p3 *= 2;
-  m->triangles[p3 - 3] = points->size() + 1;
-  m->triangles[p3 - 2] = 1;
-  m->triangles[p3 - 1] = 2;
-
-  return m;
+  if (!mobile_target_frame_)
+    return createVisibilityCone(sp, tp, points_);
+  EigenSTL::vector_Vector3d points(points_.size());
+  for (std::size_t i = 0; i < points_.size(); ++i)
+    points[i] = tp * points_[i];
+  return createVisibilityCone(sp, tp, points);
 }
 
 void VisibilityConstraint::getMarkers(const moveit::core::RobotState& state,
@@ -1041,16 +1546,16 @@ ConstraintEvaluationResult VisibilityConstraint::decide(const moveit::core::Robo
   if (target_radius_ <= std::numeric_limits<double>::epsilon())
     return ConstraintEvaluationResult(true, 0.0);
 
+  // getFrameTransform() returns a valid isometry by contract
+  // sensor_pose_ is valid isometry (checked in configure())
+  const Eigen::Isometry3d& sp =
+      mobile_sensor_frame_ ? state.getFrameTransform(sensor_frame_id_) * sensor_pose_ : sensor_pose_;
+  // target_pose_ is valid isometry (checked in configure())
+  const Eigen::Isometry3d& tp =
+      mobile_target_frame_ ? state.getFrameTransform(target_frame_id_) * target_pose_ : target_pose_;
+
   if (max_view_angle_ > 0.0 || max_range_angle_ > 0.0)
   {
-    // getFrameTransform() returns a valid isometry by contract
-    // sensor_pose_ is valid isometry (checked in configure())
-    const Eigen::Isometry3d& sp =
-        mobile_sensor_frame_ ? state.getFrameTransform(sensor_frame_id_) * sensor_pose_ : sensor_pose_;
-    // target_pose_ is valid isometry (checked in configure())
-    const Eigen::Isometry3d& tp =
-        mobile_target_frame_ ? state.getFrameTransform(target_frame_id_) * target_pose_ : target_pose_;
-
     // necessary to do subtraction as SENSOR_Z is 0 and SENSOR_X is 2
     const Eigen::Vector3d& normal2 = sp.linear().col(2 - sensor_view_direction_);
 
@@ -1101,12 +1606,22 @@ ConstraintEvaluationResult VisibilityConstraint::decide(const moveit::core::Robo
     }
   }
 
-  shapes::Mesh* m = getVisibilityCone(state);
-  if (!m)
-    return ConstraintEvaluationResult(false, 0.0);
+  if (!mayIntersectLinks(state, sp, tp))
+  {
+    if (verbose)
+      ROS_INFO_NAMED("kinematic_constraints",
+                     "Visibility constraint satisfied. No link is close to the visibility cone");
+    return ConstraintEvaluationResult(true, 0.0);
+  }
 
-  // add the visibility cone as an object
-  collision_env_->getWorld()->addToObject("cone", shapes::ShapeConstPtr(m), Eigen::Isometry3d::Identity());
+  // add the visibility cone as an object; a cached cone only needs to be moved along with the sensor frame
+  shapes::ShapeConstPtr cone = cone_;
+  Eigen::Isometry3d cone_pose = Eigen::Isometry3d::Identity();
+  if (!cone)
+    cone.reset(getVisibilityCone(state));
+  else if (mobile_sensor_frame_)
+    cone_pose = state.getFrameTransform(sensor_frame_id_);
+  collision_env_->getWorld()->addToObject("cone", cone, cone_pose);
 
   // check for collisions between the robot and the cone
   collision_detection::CollisionRequest req;
@@ -1121,7 +1636,7 @@ ConstraintEvaluationResult VisibilityConstraint::decide(const moveit::core::Robo
   if (verbose)
   {
     std::stringstream ss;
-    m->print(ss);
+    cone->print(ss);
     ROS_INFO_NAMED("kinematic_constraints", "Visibility constraint %ssatisfied. Visibility cone approximation:\n %s",
                    res.collision ? "not " : "", ss.str().c_str());
   }
@@ -1131,6 +1646,53 @@ ConstraintEvaluationResult VisibilityConstraint::decide(const moveit::core::Robo
   return ConstraintEvaluationResult(!res.collision, res.collision ? res.contacts.begin()->second.front().depth : 0.0);
 }
 
+bool VisibilityConstraint::mayIntersectLinks(const moveit::core::RobotState& state, const Eigen::Isometry3d& sp,
+                                             const Eigen::Isometry3d& tp) const
+{
+  // The visibility cone is the convex hull of the sensor origin and the points on the base disc. It is enclosed by
+  // the circular cone around the line from the sensor to the target that contains all these points, truncated at the
+  // farthest of them.
+  const Eigen::Vector3d& apex = sp.translation();
+  Eigen::Vector3d axis = tp.translation() - apex;
+  const double length = axis.norm();
+  if (length <= std::numeric_limits<double>::epsilon())
+    return true;
+  axis /= length;
+
+  double max_axial = length;
+  double tan_half_angle = 0.0;
+  for (const Eigen::Vector3d& point : points_)
+  {
+    const Eigen::Vector3d v = (mobile_target_frame_ ? tp * point : point) - apex;
+    const double axial = v.dot(axis);
+    if (axial <= std::numeric_limits<double>::epsilon())
+      return true;
+    max_axial = std::max(max_axial, axial);
+    tan_half_angle = std::max(tan_half_angle, (v - axial * axis).norm() / axial);
+  }
+  const double cos_half_angle = 1.0 / std::sqrt(1.0 + tan_half_angle * tan_half_angle);
+  const double sin_half_angle = tan_half_angle * cos_half_angle;
+
+  for (const moveit::core::LinkModel* link : robot_model_->getLinkModelsWithCollisionGeometry())
+  {
+    // contacts with these links are accepted by decideContact()
+    if (moveit::core::Transforms::sameFrame(link->getName(), sensor_frame_id_) ||
+        moveit::core::Transforms::sameFrame(link->getName(), target_frame_id_))
+      continue;
+
+    const Eigen::Vector3d v = state.getGlobalLinkTransform(link) * link->getCenteredBoundingBoxOffset() - apex;
+    const double radius = 0.5 * link->getShapeExtentsAtOrigin().norm() + 1e-9;
+    const double axial = v.dot(axis);
+    if (axial < -radius || axial > max_axial + radius)
+      continue;
+    // the cone lies within the half-space bounded by the plane through its side line in the plane of the sphere center
+    if ((v - axial * axis).norm() * cos_half_angle - axial * sin_half_angle > radius)
+      continue;
+    return true;
+  }
+  return false;
+}
+
 bool VisibilityConstraint::decideContact(const collision_detection::Contact& contact) const
 {
   if (contact.body_type_1 == collision_detection::BodyTypes::ROBOT_ATTACHED ||
@@ -1169,6 +1731,10 @@ void VisibilityConstraint::print(std::ostream& out) const
 
 void KinematicConstraintSet::clear()
 {
+  {
+    std::lock_guard<std::mutex> slock(statistics_lock_);
+    statistics_.clear();
+  }
   all_constraints_ = moveit_msgs::Constraints();
   kinematic_constraints_.clear();
   joint_constraints_.clear();
@@ -1249,6 +1815,62 @@ bool KinematicConstraintSet::add(const moveit_msgs::Constraints& c, const moveit
   return j && p && o && v;
 }
 
+bool KinematicConstraintSet::update(const moveit_msgs::Constraints& c, const moveit::core::Transforms& tf)
+{
+  // the member constraints can be re-targeted if they are laid out as add() lays out c
+  bool same_structure = c.joint_constraints.size() == joint_constraints_.size() &&
+                        c.position_constraints.size() == position_constraints_.size() &&
+                        c.orientation_constraints.size() == orientation_constraints_.size() &&
+                        c.visibility_constraints.size() == visibility_constraints_.size();
+  std::size_t index = 0;
+  for (std::size_t i = 0; same_structure && i < joint_constraints_.size(); ++i)
+    same_structure = kinematic_constraints_[index++]->getType() == KinematicConstraint::JOINT_CONSTRAINT;
+  for (std::size_t i = 0; same_structure && i < position_constraints_.size(); ++i)
+    same_structure = kinematic_constraints_[index++]->getType() == KinematicConstraint::POSITION_CONSTRAINT &&
+                     c.position_constraints[i].link_name == position_constraints_[i].link_name &&
+                     c.position_constraints[i].constraint_region.primitives ==
+                         position_constraints_[i].constraint_region.primitives &&
+                     c.position_constraints[i].constraint_region.meshes ==
+                         position_constraints_[i].constraint_region.meshes;
+  for (std::size_t i = 0; same_structure && i < orientation_constraints_.size(); ++i)
+    same_structure = kinematic_constraints_[index++]->getType() == KinematicConstraint::ORIENTATION_CONSTRAINT;
+  for (std::size_t i = 0; same_structure && i < visibility_constraints_.size(); ++i)
+    same_structure = kinematic_constraints_[index++]->getType() == KinematicConstraint::VISIBILITY_CONSTRAINT;
+  if (!same_structure)
+  {
+    clear();
+    return add(c, tf);
+  }
+
+  // joint, orientation and visibility constraints are cheap to configure; only regions are kept
+  bool result = true;
+  index = 0;
+  for (const moveit_msgs::JointConstraint& joint_constraint : c.joint_constraints)
+    result = static_cast<JointConstraint&>(*kinematic_constraints_[index++]).configure(joint_constraint) && result;
+  for (const moveit_msgs::PositionConstraint& position_constraint : c.position_constraints)
+  {
+    PositionConstraint& constraint = static_cast<PositionConstraint&>(*kinematic_constraints_[index++]);
+    if (!constraint.retarget(position_constraint, tf))
+      result = constraint.configure(position_constraint, tf) && result;
+  }
+  for (const moveit_msgs::OrientationConstraint& orientation_constraint : c.orientation_constraints)
+  {
+    OrientationConstraint& constraint = static_cast<OrientationConstraint&>(*kinematic_constraints_[index++]);
+    result = constraint.configure(orientation_constraint, tf) && result;
+  }
+  for (const moveit_msgs::VisibilityConstraint& visibility_constraint : c.visibility_constraints)
+  {
+    VisibilityConstraint& constraint = static_cast<VisibilityConstraint&>(*kinematic_constraints_[index++]);
+    result = constraint.configure(visibility_constraint, tf) && result;
+  }
+
+  joint_constraints_ = all_constraints_.joint_constraints = c.joint_constraints;
+  position_constraints_ = all_constraints_.position_constraints = c.position_constraints;
+  orientation_constraints_ = all_constraints_.orientation_constraints = c.orientation_constraints;
+  visibility_constraints_ = all_constraints_.visibility_constraints = c.visibility_constraints;
+  return result;
+}
+
 ConstraintEvaluationResult KinematicConstraintSet::decide(const moveit::core::RobotState& state, bool verbose) const
 {
   ConstraintEvaluationResult res(true, 0.0);
@@ -1278,6 +1900,80 @@ ConstraintEvaluationResult KinematicConstraintSet::decide(const moveit::core::Ro
   return result;
 }
 
+void KinematicConstraintSet::decideBatch(const std::vector<const moveit::core::RobotState*>& states,
+                                         std::vector<bool>& satisfied) const
+{
+  satisfied.assign(states.size(), true);
+  if (states.empty() || kinematic_constraints_.empty())
+    return;
+
+  // order the constraints by their expected cost per rejected state
+  std::vector<std::size_t> order(kinematic_constraints_.size());
+  std::iota(order.begin(), order.end(), 0);
+  {
+    std::lock_guard<std::mutex> slock(statistics_lock_);
+    statistics_.resize(kinematic_constraints_.size());
+    std::vector<double> expected_cost(kinematic_constraints_.size(), 0.0);
+    for (std::size_t i = 0; i < statistics_.size(); ++i)
+      if (statistics_[i].states > 0)
+        expected_cost[i] = statistics_[i].seconds * (statistics_[i].states + 2) /
+                           (statistics_[i].states * (statistics_[i].rejected + 1.0));
+    std::stable_sort(order.begin(), order.end(),
+                     [&expected_cost](std::size_t a, std::size_t b) { return expected_cost[a] < expected_cost[b]; });
+  }
+
+  std::vector<ConstraintStatistics> batch_statistics(kinematic_constraints_.size());
+  std::size_t remaining = states.size();
+  for (std::size_t i : order)
+  {
+    const auto start = std::chrono::steady_clock::now();
+    kinematic_constraints_[i]->decideBatch(states, satisfied);
+    const std::size_t still_satisfied = std::count(satisfied.begin(), satisfied.end(), true);
+    batch_statistics[i].seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    batch_statistics[i].states = remaining;
+    batch_statistics[i].rejected = remaining - still_satisfied;
+    remaining = still_satisfied;
+    if (remaining == 0)
+      break;
+  }
+
+  std::lock_guard<std::mutex> slock(statistics_lock_);
+  if (statistics_.size() != batch_statistics.size())
+    return;
+  for (std::size_t i = 0; i < statistics_.size(); ++i)
+  {
+    statistics_[i].seconds += batch_statistics[i].seconds;
+    statistics_[i].states += batch_statistics[i].states;
+    statistics_[i].rejected += batch_statistics[i].rejected;
+  }
+}
+
+bool KinematicConstraintSet::computeJacobian(const moveit::core::RobotState& state,
+                                             const moveit::core::JointModelGroup* group, Eigen::VectorXd& violation,
+                                             Eigen::MatrixXd& jacobian) const
+{
+  std::vector<Eigen::VectorXd> violations(kinematic_constraints_.size());
+  std::vector<Eigen::MatrixXd> jacobians(kinematic_constraints_.size());
+  Eigen::Index rows = 0;
+  for (std::size_t i = 0; i < kinematic_constraints_.size(); ++i)
+  {
+    if (!kinematic_constraints_[i]->computeJacobian(state, group, violations[i], jacobians[i]))
+      return false;
+    rows += violations[i].size();
+  }
+
+  violation.resize(rows);
+  jacobian.resize(rows, group->getVariableCount());
+  Eigen::Index row = 0;
+  for (std::size_t i = 0; i < kinematic_constraints_.size(); ++i)
+  {
+    violation.segment(row, violations[i].size()) = violations[i];
+    jacobian.middleRows(row, jacobians[i].rows()) = jacobians[i];
+    row += violations[i].size();
+  }
+  return true;
+}
+
 void KinematicConstraintSet::print(std::ostream& out) const
 {
   out << kinematic_constraints_.size() << " kinematic constraints" << std::endl;
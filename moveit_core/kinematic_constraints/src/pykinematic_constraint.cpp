@@ -47,6 +47,11 @@ namespace py = pybind11;
 
 using namespace kinematic_constraints;
 
+// Defined in pyrobot_state.cpp
+std::vector<moveit::core::RobotState> statesFromPositions(const moveit::core::RobotState& state,
+                                                          const double* positions, std::size_t count,
+                                                          std::size_t columns, const std::string& group);
+
 void def_kinematic_constraints_bindings(py::module& m)
 {
   m.doc() = "Class for joint, position, visibility, and other constraints";
@@ -65,6 +70,34 @@ void def_kinematic_constraints_bindings(py::module& m)
       .def("decide",
            py::overload_cast<const moveit::core::RobotState&, bool>(&KinematicConstraintSet::decide, py::const_),
            py::arg("state"), py::arg("verbose") = false)
+      .def(
+          "decideBatch",
+          [](const KinematicConstraintSet& constraints, const moveit::core::RobotState& state,
+             const py::array_t<double, py::array::c_style | py::array::forcecast>& positions,
+             const std::string& group) {
+            if (positions.ndim() != 2)
+              throw std::invalid_argument("Expected a 2-dimensional array of positions");
+            const double* data = positions.data();
+            const std::size_t count = positions.shape(0);
+            const std::size_t columns = positions.shape(1);
+            py::array_t<bool> satisfied(count);
+            bool* out = satisfied.mutable_data();
+            {
+              py::gil_scoped_release release;
+              std::vector<moveit::core::RobotState> states = statesFromPositions(state, data, count, columns, group);
+              std::vector<const moveit::core::RobotState*> state_ptrs;
+              for (const moveit::core::RobotState& s : states)
+                state_ptrs.push_back(&s);
+              std::vector<bool> result;
+              constraints.decideBatch(state_ptrs, result);
+              std::copy(result.begin(), result.end(), out);
+            }
+            return satisfied;
+          },
+          py::arg("state"), py::arg("positions"), py::arg("group") = "",
+          "Decide whether many states satisfy all constraints without holding the GIL. Each row of positions holds "
+          "the variables of group (of the whole robot if empty), the other variables are taken from state. Returns "
+          "one flag per state.")
       //
       ;
 
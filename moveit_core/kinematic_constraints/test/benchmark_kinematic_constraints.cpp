@@ -0,0 +1,121 @@
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2026, PickNik LLC.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of PickNik LLC nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *********************************************************************/
+
+/* Google Benchmark based micro-benchmarks of kinematic constraint evaluation. Write JSON results for regression
+   tracking with --benchmark_out=<file> --benchmark_out_format=json */
+
+#include <moveit/kinematic_constraints/kinematic_constraint.h>
+#include <moveit/kinematic_constraints/utils.h>
+#include <moveit/utils/robot_model_test_utils.h>
+#include <random_numbers/random_numbers.h>
+#include <tf2_eigen/tf2_eigen.h>
+#include <benchmark/benchmark.h>
+
+namespace
+{
+enum class Constraint
+{
+  JOINT,
+  POSE,
+  VISIBILITY
+};
+
+// Evaluate constraints on the default state of the arm against random states of it
+void evaluate(benchmark::State& st, const std::string& robot, const std::string& group, const std::string& tip,
+              Constraint type)
+{
+  moveit::core::RobotModelPtr model = moveit::core::loadTestingRobotModel(robot);
+  moveit::core::Transforms tf(model->getModelFrame());
+  moveit::core::RobotState state(model);
+  const moveit::core::JointModelGroup* jmg = model->getJointModelGroup(group);
+  state.setToDefaultValues();
+  state.update();
+
+  moveit_msgs::Constraints msg;
+  if (type == Constraint::JOINT)
+    msg = kinematic_constraints::constructGoalConstraints(state, jmg, 0.1);
+  else
+  {
+    geometry_msgs::PoseStamped pose;
+    pose.header.frame_id = model->getModelFrame();
+    pose.pose = tf2::toMsg(state.getGlobalLinkTransform(tip));
+    msg = kinematic_constraints::constructGoalConstraints(tip, pose, 0.05, 0.1);
+    if (type == Constraint::VISIBILITY)
+    {
+      moveit_msgs::VisibilityConstraint vc;
+      vc.target_radius = 0.05;
+      vc.target_pose = pose;
+      vc.target_pose.pose.position.z += 0.5;
+      vc.cone_sides = 8;
+      vc.sensor_pose = pose;
+      vc.sensor_pose.header.frame_id = tip;
+      vc.sensor_pose.pose = tf2::toMsg(Eigen::Isometry3d::Identity());
+      vc.max_view_angle = 0.0;
+      vc.max_range_angle = 0.0;
+      vc.sensor_view_direction = moveit_msgs::VisibilityConstraint::SENSOR_Z;
+      vc.weight = 1.0;
+      msg.visibility_constraints.push_back(vc);
+    }
+  }
+  kinematic_constraints::KinematicConstraintSet constraints(model);
+  if (!constraints.add(msg, tf))
+  {
+    st.SkipWithError("Failed to construct the constraints");
+    return;
+  }
+
+  random_numbers::RandomNumberGenerator rng(7);
+  const moveit::core::RobotState default_state(state);
+  std::vector<moveit::core::RobotState> states;
+  for (std::size_t i = 0; i < 64; ++i)
+  {
+    state.setToRandomPositionsNearBy(jmg, default_state, 0.2, rng);
+    state.update();
+    states.push_back(state);
+  }
+
+  std::size_t i = 0, satisfied = 0;
+  for (auto _ : st)
+    satisfied += constraints.decide(states[i++ % states.size()]).satisfied;
+  st.counters["satisfied_rate"] = benchmark::Counter(satisfied, benchmark::Counter::kAvgIterations);
+}
+}  // namespace
+
+BENCHMARK_CAPTURE(evaluate, panda_joint, "panda", "panda_arm", "panda_link8", Constraint::JOINT);
+BENCHMARK_CAPTURE(evaluate, panda_pose, "panda", "panda_arm", "panda_link8", Constraint::POSE);
+BENCHMARK_CAPTURE(evaluate, panda_visibility, "panda", "panda_arm", "panda_link8", Constraint::VISIBILITY);
+BENCHMARK_CAPTURE(evaluate, pr2_joint, "pr2", "right_arm", "r_wrist_roll_link", Constraint::JOINT);
+BENCHMARK_CAPTURE(evaluate, pr2_pose, "pr2", "right_arm", "r_wrist_roll_link", Constraint::POSE);
+
+BENCHMARK_MAIN();
@@ -431,6 +431,62 @@ TEST_F(LoadPlanningModelsPr2, PositionConstraintsFixed)
   EXPECT_TRUE(pc.decide(robot_state).satisfied);
 }
 
+TEST_F(LoadPlanningModelsPr2, PositionConstraintsManyRegions)
+{
+  moveit::core::RobotState robot_state(robot_model_);
+  robot_state.setToDefaultValues();
+  robot_state.update(true);
+  moveit::core::Transforms tf(robot_model_->getModelFrame());
+  kinematic_constraints::PositionConstraint pc(robot_model_);
+  moveit_msgs::PositionConstraint pcm;
+
+  pcm.link_name = "l_wrist_roll_link";
+  pcm.header.frame_id = robot_model_->getModelFrame();
+  pcm.weight = 1.0;
+
+  // a grid of small boxes and spheres around the default position of the link, enough to be searched with a tree
+  const Eigen::Vector3d center = robot_state.getGlobalLinkTransform("l_wrist_roll_link").translation();
+  for (int x = -3; x <= 3; ++x)
+    for (int y = -3; y <= 3; ++y)
+    {
+      shape_msgs::SolidPrimitive primitive;
+      primitive.type = (x + y) % 2 ? shape_msgs::SolidPrimitive::SPHERE : shape_msgs::SolidPrimitive::BOX;
+      primitive.dimensions.assign(primitive.type == shape_msgs::SolidPrimitive::SPHERE ? 1 : 3, 0.1);
+      geometry_msgs::Pose pose;
+      pose.position.x = center.x() + 0.15 * x;
+      pose.position.y = center.y() + 0.15 * y;
+      pose.position.z = center.z();
+      pose.orientation.w = 1.0;
+      pcm.constraint_region.primitives.push_back(primitive);
+      pcm.constraint_region.primitive_poses.push_back(pose);
+    }
+
+  EXPECT_TRUE(pc.configure(pcm, tf));
+  EXPECT_TRUE(pc.decide(robot_state).satisfied);
+
+  // reconfiguring from the same message gives the same regions
+  kinematic_constraints::PositionConstraint pc2(robot_model_);
+  EXPECT_TRUE(pc2.configure(pcm, tf));
+  EXPECT_TRUE(pc.equal(pc2, 1e-12));
+
+  // the tree search (non-verbose) agrees with the linear search (verbose) in the result and the reported distance
+  const moveit::core::RobotState default_state(robot_state);
+  const moveit::core::JointModelGroup* jmg = robot_model_->getJointModelGroup("left_arm");
+  std::size_t satisfied = 0;
+  for (int i = 0; i < 500; ++i)
+  {
+    robot_state.setToRandomPositionsNearBy(jmg, default_state, 0.3);
+    robot_state.update();
+    const kinematic_constraints::ConstraintEvaluationResult tree_result = pc.decide(robot_state, false);
+    const kinematic_constraints::ConstraintEvaluationResult linear_result = pc.decide(robot_state, true);
+    EXPECT_EQ(tree_result.satisfied, linear_result.satisfied);
+    EXPECT_DOUBLE_EQ(tree_result.distance, linear_result.distance);
+    if (tree_result.satisfied)
+      ++satisfied;
+  }
+  EXPECT_GT(satisfied, 0u);
+}
+
 TEST_F(LoadPlanningModelsPr2, PositionConstraintsMobile)
 {
   moveit::core::RobotState robot_state(robot_model_);
@@ -852,6 +908,228 @@ TEST_F(LoadPlanningModelsPr2, TestKinematicConstraintSet)
   EXPECT_FALSE(kcs.decide(robot_state).satisfied);
 }
 
+TEST_F(LoadPlanningModelsPr2, TestKinematicConstraintSetBatch)
+{
+  moveit::core::RobotState robot_state(robot_model_);
+  robot_state.setToDefaultValues();
+  robot_state.update();
+  moveit::core::Transforms tf(robot_model_->getModelFrame());
+
+  kinematic_constraints::KinematicConstraintSet kcs(robot_model_);
+  moveit_msgs::Constraints c;
+
+  c.joint_constraints.resize(1);
+  c.joint_constraints[0].joint_name = "r_forearm_roll_joint";
+  c.joint_constraints[0].position = 0.0;
+  c.joint_constraints[0].tolerance_above = 2.0;
+  c.joint_constraints[0].tolerance_below = 2.0;
+  c.joint_constraints[0].weight = 1.0;
+
+  // a sphere around the wrist in the default state
+  const Eigen::Vector3d wrist = robot_state.getGlobalLinkTransform("r_wrist_roll_link").translation();
+  c.position_constraints.resize(1);
+  c.position_constraints[0].header.frame_id = robot_model_->getModelFrame();
+  c.position_constraints[0].link_name = "r_wrist_roll_link";
+  c.position_constraints[0].constraint_region.primitives.resize(1);
+  c.position_constraints[0].constraint_region.primitives[0].type = shape_msgs::SolidPrimitive::SPHERE;
+  c.position_constraints[0].constraint_region.primitives[0].dimensions.push_back(0.4);
+  c.position_constraints[0].constraint_region.primitive_poses.resize(1);
+  c.position_constraints[0].constraint_region.primitive_poses[0].position = tf2::toMsg(wrist);
+  c.position_constraints[0].constraint_region.primitive_poses[0].orientation.w = 1.0;
+  c.position_constraints[0].weight = 1.0;
+
+  c.orientation_constraints.resize(1);
+  c.orientation_constraints[0].header.frame_id = robot_model_->getModelFrame();
+  c.orientation_constraints[0].link_name = "r_wrist_roll_link";
+  c.orientation_constraints[0].orientation =
+      tf2::toMsg(Eigen::Quaterniond(robot_state.getGlobalLinkTransform("r_wrist_roll_link").linear()));
+  c.orientation_constraints[0].absolute_x_axis_tolerance = 0.8;
+  c.orientation_constraints[0].absolute_y_axis_tolerance = 0.8;
+  c.orientation_constraints[0].absolute_z_axis_tolerance = 0.8;
+  c.orientation_constraints[0].weight = 1.0;
+  EXPECT_TRUE(kcs.add(c, tf));
+
+  // states close to the default state, so that the constraints accept some of them
+  std::vector<moveit::core::RobotStatePtr> samples;
+  std::vector<const moveit::core::RobotState*> states;
+  for (std::size_t i = 0; i < 200; ++i)
+  {
+    samples.push_back(std::make_shared<moveit::core::RobotState>(robot_state));
+    samples.back()->setToRandomPositionsNearBy(robot_model_->getJointModelGroup("right_arm"), robot_state, 1.0);
+    samples.back()->update();
+    states.push_back(samples.back().get());
+  }
+
+  // the batch evaluation agrees with the individual decisions, also once constraints are reordered
+  for (int repeat = 0; repeat < 3; ++repeat)
+  {
+    std::vector<bool> satisfied;
+    kcs.decideBatch(states, satisfied);
+    ASSERT_EQ(satisfied.size(), states.size());
+    for (std::size_t i = 0; i < states.size(); ++i)
+      EXPECT_EQ(satisfied[i], kcs.decide(*states[i]).satisfied);
+  }
+}
+
+TEST_F(LoadPlanningModelsPr2, TestKinematicConstraintSetUpdate)
+{
+  moveit::core::RobotState robot_state(robot_model_);
+  robot_state.setToDefaultValues();
+  robot_state.update();
+  moveit::core::Transforms tf(robot_model_->getModelFrame());
+  const moveit::core::JointModelGroup* jmg = robot_model_->getJointModelGroup("right_arm");
+
+  moveit_msgs::Constraints c;
+  c.joint_constraints.resize(1);
+  c.joint_constraints[0].joint_name = "r_forearm_roll_joint";
+  c.joint_constraints[0].tolerance_above = 1.0;
+  c.joint_constraints[0].tolerance_below = 1.0;
+  c.joint_constraints[0].weight = 1.0;
+
+  c.position_constraints.resize(1);
+  c.position_constraints[0].header.frame_id = robot_model_->getModelFrame();
+  c.position_constraints[0].link_name = "r_wrist_roll_link";
+  c.position_constraints[0].constraint_region.primitives.resize(1);
+  c.position_constraints[0].constraint_region.primitives[0].type = shape_msgs::SolidPrimitive::SPHERE;
+  c.position_constraints[0].constraint_region.primitives[0].dimensions.push_back(0.2);
+  c.position_constraints[0].constraint_region.primitive_poses.resize(1);
+  c.position_constraints[0].constraint_region.primitive_poses[0].orientation.w = 1.0;
+  c.position_constraints[0].weight = 1.0;
+
+  c.orientation_constraints.resize(1);
+  c.orientation_constraints[0].header.frame_id = robot_model_->getModelFrame();
+  c.orientation_constraints[0].link_name = "r_wrist_roll_link";
+  c.orientation_constraints[0].absolute_x_axis_tolerance = 0.5;
+  c.orientation_constraints[0].absolute_y_axis_tolerance = 0.5;
+  c.orientation_constraints[0].absolute_z_axis_tolerance = 0.5;
+  c.orientation_constraints[0].weight = 1.0;
+
+  // re-targeting the set to the pose of a random state each time agrees with building a new set
+  kinematic_constraints::KinematicConstraintSet kcs(robot_model_);
+  moveit::core::RobotState target(robot_state);
+  for (std::size_t i = 0; i < 20; ++i)
+  {
+    target.setToRandomPositions(jmg);
+    target.update();
+    const Eigen::Isometry3d& wrist = target.getGlobalLinkTransform("r_wrist_roll_link");
+    c.joint_constraints[0].position = target.getVariablePosition("r_forearm_roll_joint");
+    c.position_constraints[0].constraint_region.primitive_poses[0].position = tf2::toMsg(wrist.translation());
+    c.orientation_constraints[0].orientation = tf2::toMsg(Eigen::Quaterniond(wrist.linear()));
+    EXPECT_TRUE(kcs.update(c, tf));
+    EXPECT_TRUE(kcs.decide(target).satisfied);
+
+    kinematic_constraints::KinematicConstraintSet fresh(robot_model_);
+    EXPECT_TRUE(fresh.add(c, tf));
+    EXPECT_TRUE(kcs.equal(fresh, 1e-9));
+    for (std::size_t j = 0; j < 10; ++j)
+    {
+      robot_state.setToRandomPositionsNearBy(jmg, target, 0.3);
+      robot_state.update();
+      EXPECT_EQ(kcs.decide(robot_state).satisfied, fresh.decide(robot_state).satisfied);
+    }
+  }
+  EXPECT_EQ(kcs.getAllConstraints().position_constraints.size(), 1u);
+
+  // a different structure replaces the constraints
+  c.position_constraints.clear();
+  EXPECT_TRUE(kcs.update(c, tf));
+  EXPECT_EQ(kcs.getPositionConstraints().size(), 0u);
+  EXPECT_EQ(kcs.getJointConstraints().size(), 1u);
+}
+
+TEST_F(LoadPlanningModelsPr2, TestKinematicConstraintSetJacobian)
+{
+  moveit::core::RobotState robot_state(robot_model_);
+  robot_state.setToDefaultValues();
+  robot_state.update();
+  moveit::core::Transforms tf(robot_model_->getModelFrame());
+  const moveit::core::JointModelGroup* jmg = robot_model_->getJointModelGroup("left_arm");
+
+  moveit_msgs::Constraints c;
+  c.joint_constraints.resize(1);
+  c.joint_constraints[0].joint_name = "l_elbow_flex_joint";
+  c.joint_constraints[0].position = robot_state.getVariablePosition("l_elbow_flex_joint") - 0.5;
+  c.joint_constraints[0].tolerance_above = 0.1;
+  c.joint_constraints[0].tolerance_below = 0.1;
+  c.joint_constraints[0].weight = 1.0;
+
+  // a box next to the wrist, so the wrist is outside of it in x and y
+  const Eigen::Isometry3d wrist = robot_state.getGlobalLinkTransform("l_wrist_roll_link");
+  c.position_constraints.resize(1);
+  c.position_constraints[0].header.frame_id = robot_model_->getModelFrame();
+  c.position_constraints[0].link_name = "l_wrist_roll_link";
+  c.position_constraints[0].target_point_offset.x = 0.05;
+  c.position_constraints[0].constraint_region.primitives.resize(1);
+  c.position_constraints[0].constraint_region.primitives[0].type = shape_msgs::SolidPrimitive::BOX;
+  c.position_constraints[0].constraint_region.primitives[0].dimensions.assign(3, 0.1);
+  c.position_constraints[0].constraint_region.primitive_poses.resize(1);
+  c.position_constraints[0].constraint_region.primitive_poses[0].position =
+      tf2::toMsg(Eigen::Vector3d(wrist.translation() + Eigen::Vector3d(0.3, 0.2, 0.0)));
+  c.position_constraints[0].constraint_region.primitive_poses[0].orientation.w = 1.0;
+  c.position_constraints[0].weight = 1.0;
+
+  // an orientation rotated away from the current one about the x and y axes
+  c.orientation_constraints.resize(1);
+  c.orientation_constraints[0].header.frame_id = robot_model_->getModelFrame();
+  c.orientation_constraints[0].link_name = "l_wrist_roll_link";
+  c.orientation_constraints[0].orientation = tf2::toMsg(Eigen::Quaterniond(
+      wrist.linear() * Eigen::AngleAxisd(0.5, Eigen::Vector3d(1.0, 1.0, 0.0).normalized()).toRotationMatrix()));
+  c.orientation_constraints[0].absolute_x_axis_tolerance = 0.1;
+  c.orientation_constraints[0].absolute_y_axis_tolerance = 0.1;
+  c.orientation_constraints[0].absolute_z_axis_tolerance = 0.1;
+  c.orientation_constraints[0].parameterization = moveit_msgs::OrientationConstraint::ROTATION_VECTOR;
+  c.orientation_constraints[0].weight = 1.0;
+
+  kinematic_constraints::KinematicConstraintSet kcs(robot_model_);
+  ASSERT_TRUE(kcs.add(c, tf));
+  EXPECT_FALSE(kcs.decide(robot_state).satisfied);
+
+  Eigen::VectorXd violation;
+  Eigen::MatrixXd jacobian;
+  ASSERT_TRUE(kcs.computeJacobian(robot_state, jmg, violation, jacobian));
+  ASSERT_EQ(violation.size(), 7);
+  ASSERT_EQ(jacobian.rows(), 7);
+  ASSERT_EQ(jacobian.cols(), static_cast<Eigen::Index>(jmg->getVariableCount()));
+  EXPECT_NEAR(violation(0), 0.4, 1e-9);
+  EXPECT_GT(violation.segment<3>(1).norm(), 0.0);
+  EXPECT_GT(violation.segment<3>(4).norm(), 0.0);
+
+  // the analytic Jacobian matches central differences
+  const double h = 1e-6;
+  Eigen::VectorXd values;
+  robot_state.copyJointGroupPositions(jmg, values);
+  for (Eigen::Index j = 0; j < values.size(); ++j)
+  {
+    Eigen::VectorXd violation_plus, violation_minus;
+    Eigen::MatrixXd unused;
+    Eigen::VectorXd perturbed = values;
+    perturbed(j) += h;
+    robot_state.setJointGroupPositions(jmg, perturbed);
+    robot_state.update();
+    ASSERT_TRUE(kcs.computeJacobian(robot_state, jmg, violation_plus, unused));
+    perturbed(j) -= 2.0 * h;
+    robot_state.setJointGroupPositions(jmg, perturbed);
+    robot_state.update();
+    ASSERT_TRUE(kcs.computeJacobian(robot_state, jmg, violation_minus, unused));
+    EXPECT_LT((jacobian.col(j) - (violation_plus - violation_minus) / (2.0 * h)).norm(), 1e-5) << "column " << j;
+  }
+
+  // satisfied constraints have no violation, and groups that are not chains are not supported
+  kinematic_constraints::KinematicConstraintSet satisfied_kcs(robot_model_);
+  c.joint_constraints[0].tolerance_above = 1.0;
+  c.position_constraints[0].constraint_region.primitives[0].dimensions.assign(3, 1.0);
+  c.orientation_constraints[0].absolute_x_axis_tolerance = 1.0;
+  c.orientation_constraints[0].absolute_y_axis_tolerance = 1.0;
+  ASSERT_TRUE(satisfied_kcs.add(c, tf));
+  robot_state.setJointGroupPositions(jmg, values);
+  robot_state.update();
+  EXPECT_TRUE(satisfied_kcs.decide(robot_state).satisfied);
+  ASSERT_TRUE(satisfied_kcs.computeJacobian(robot_state, jmg, violation, jacobian));
+  EXPECT_TRUE(violation.isZero());
+  EXPECT_TRUE(jacobian.isZero());
+  EXPECT_FALSE(kcs.computeJacobian(robot_state, robot_model_->getJointModelGroup("arms"), violation, jacobian));
+}
+
 TEST_F(LoadPlanningModelsPr2, TestKinematicConstraintSetEquality)
 {
   moveit::core::RobotState robot_state(robot_model_);
@@ -474,6 +474,69 @@ TEST_F(FloatingJointRobot, OrientationConstraintsParameterization)
   EXPECT_FALSE(oc_rotvec.decide(robot_state).satisfied);
 }
 
+TEST_F(FloatingJointRobot, OrientationConstraintsBatch)
+{
+  moveit::core::RobotState robot_state(robot_model_);
+  robot_state.setToDefaultValues();
+  robot_state.update();
+  moveit::core::Transforms tf(robot_model_->getModelFrame());
+
+  moveit_msgs::OrientationConstraint ocm;
+  ocm.link_name = "ee";
+  ocm.header.frame_id = robot_model_->getModelFrame();
+  ocm.orientation = tf2::toMsg(rotation_vector_to_quat(0.1, -0.2, 0.3));
+  ocm.absolute_x_axis_tolerance = 0.5;
+  ocm.absolute_y_axis_tolerance = 0.5;
+  ocm.absolute_z_axis_tolerance = 0.5;
+  ocm.weight = 1.0;
+
+  // states around the nominal orientation, including the boundary cases of the test data
+  const Eigen::Quaterniond nominal = rotation_vector_to_quat(0.1, -0.2, 0.3);
+  std::vector<moveit::core::RobotStatePtr> samples;
+  std::vector<const moveit::core::RobotState*> states;
+  for (Eigen::Index i_row{ 0 }; i_row < valid_euler_data_.rows(); ++i_row)
+    for (const Eigen::Matrix<double, 8, 4>* data : { &valid_euler_data_, &valid_rotvec_data_ })
+    {
+      const Eigen::Quaterniond offset((*data)(i_row, 3), (*data)(i_row, 0), (*data)(i_row, 1), (*data)(i_row, 2));
+      samples.push_back(std::make_shared<moveit::core::RobotState>(robot_state));
+      setRobotEndEffectorOrientation(*samples.back(), nominal * offset);
+    }
+  for (double angle = 0.0; angle < 3.0; angle += 0.25)
+  {
+    samples.push_back(std::make_shared<moveit::core::RobotState>(robot_state));
+    setRobotEndEffectorOrientation(*samples.back(), nominal * rotation_vector_to_quat(angle, 0.5 * angle, -angle));
+  }
+  for (const moveit::core::RobotStatePtr& sample : samples)
+    states.push_back(sample.get());
+
+  for (int parameterization : { moveit_msgs::OrientationConstraint::XYZ_EULER_ANGLES,
+                                moveit_msgs::OrientationConstraint::ROTATION_VECTOR })
+  {
+    ocm.parameterization = parameterization;
+    kinematic_constraints::OrientationConstraint oc(robot_model_);
+    EXPECT_TRUE(oc.configure(ocm, tf));
+
+    std::vector<bool> satisfied(states.size(), true);
+    oc.decideBatch(states, satisfied);
+    std::size_t accepted = 0;
+    for (std::size_t i = 0; i < states.size(); ++i)
+    {
+      EXPECT_EQ(satisfied[i], oc.decide(*states[i]).satisfied);
+      accepted += satisfied[i];
+
+      if (parameterization == moveit_msgs::OrientationConstraint::ROTATION_VECTOR)
+      {
+        // the distance is the sum of the absolute rotation vector components of the error
+        Eigen::AngleAxisd error(nominal.toRotationMatrix().transpose() *
+                                states[i]->getGlobalLinkTransform("ee").linear());
+        EXPECT_NEAR(oc.decide(*states[i]).distance, (error.angle() * error.axis()).cwiseAbs().sum(), 1e-9);
+      }
+    }
+    EXPECT_GT(accepted, 0u);
+    EXPECT_LT(accepted, states.size());
+  }
+}
+
 int main(int argc, char** argv)
 {
   testing::InitGoogleTest(&argc, argv);
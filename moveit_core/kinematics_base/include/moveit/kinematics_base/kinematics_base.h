@@ -42,6 +42,7 @@
 #include <ros/node_handle.h>
 
 #include <boost/function.hpp>
+#include <functional>
 #include <string>
 
 #include <moveit/moveit_kinematics_base_export.h>
@@ -112,6 +113,7 @@ struct KinematicsQueryOptions
     : lock_redundant_joints(false)
     , return_approximate_solution(false)
     , discretization_method(DiscretizationMethods::NO_DISCRETIZATION)
+    , parallel_seeds(0)
   {
   }
 
@@ -119,6 +121,9 @@ struct KinematicsQueryOptions
   bool return_approximate_solution;           /**<  KinematicsQueryOptions#return_approximate_solution. */
   DiscretizationMethod discretization_method; /**<  Enumeration value that indicates the method for discretizing the
                                                     redundant. joints KinematicsQueryOptions#discretization_method. */
+  unsigned int parallel_seeds;                /**<  Number of seeds RobotState::setFromIK() searches concurrently
+                                                    through searchPositionIKBatch(). 0 or 1 keeps the sequential
+                                                    search of the solver. */
 };
 
 /*
@@ -153,6 +158,12 @@ public:
   using IKCallbackFn =
       boost::function<void(const geometry_msgs::Pose&, const std::vector<double>&, moveit_msgs::MoveItErrorCodes&)>;
 
+  /** @brief Signature for a callback to validate several IK solutions for the same pose at once, e.g. with a batched
+   *  collision check. The last argument has one entry per solution, initialized to false, to be set for the valid
+   *  ones. */
+  using IKBatchCallbackFn = boost::function<void(const geometry_msgs::Pose&, const std::vector<std::vector<double>>&,
+                                                 std::vector<bool>&)>;
+
   /**
    * @brief Given a desired pose of the end-effector, compute the joint angles to reach it
    *
@@ -321,6 +332,54 @@ public:
     return false;
   }
 
+  /**
+   * @brief Search the joint angles for many independent poses of the tip link at once, e.g. for the grasp candidates
+   * of a pick or a reachability map. Each pose is solved like searchPositionIK() without consistency limits and
+   * callback, but solvers can set up their internal data once per batch instead of once per pose and solve the poses
+   * in parallel.
+   * The default implementation calls searchPositionIK() for one pose after the other and ignores \e threads, as
+   * solvers are not required to be thread-safe.
+   * @param ik_poses the desired poses of the tip link
+   * @param ik_seed_states the seed of every pose one after the other, each in the order of getJointNames(), or a
+   * single seed used for all poses
+   * @param timeout The amount of time (in seconds) available to the solver for each pose
+   * @param solutions the solutions of all poses one after the other, the solution of pose i starts at index
+   * i * getJointNames().size(). Entries of poses without solution are unspecified.
+   * @param found set to one flag per pose, true if a solution was found for it
+   * @param options container for other IK options. See definition of KinematicsQueryOptions for details.
+   * @param threads the maximal number of threads solvers that support it distribute the poses over, 0 for all cores
+   * @return True if a solution was found for every pose, false otherwise
+   */
+  virtual bool
+  searchPositionIKBatch(const std::vector<geometry_msgs::Pose>& ik_poses, const std::vector<double>& ik_seed_states,
+                        double timeout, std::vector<double>& solutions, std::vector<bool>& found,
+                        const kinematics::KinematicsQueryOptions& options = kinematics::KinematicsQueryOptions(),
+                        unsigned int threads = 1) const;
+
+  /**
+   * @brief Given a desired pose of the end-effector, search for the joint angles required to reach it, validating
+   * candidate solutions through \e batch_callback.
+   *
+   * Solvers that enumerate candidate solutions, like analytic ones, pass several candidates to one call of the
+   * callback. The default implementation calls searchPositionIK() with a solution callback forwarding one candidate
+   * at a time.
+   * @param ik_pose the desired pose of the link
+   * @param ik_seed_state an initial guess solution for the inverse kinematics
+   * @param timeout The amount of time (in seconds) available to the solver
+   * @param consistency_limits the distance that any joint in the solution can be from the corresponding joints in the
+   * current seed state
+   * @param solution the solution vector
+   * @param batch_callback A callback marking which of several candidate solutions are valid
+   * @param error_code an error code that encodes the reason for failure or success
+   * @param options container for other IK options. See definition of KinematicsQueryOptions for details.
+   * @return True if a valid solution was found, false otherwise
+   */
+  virtual bool searchPositionIKWithBatchCallback(
+      const geometry_msgs::Pose& ik_pose, const std::vector<double>& ik_seed_state, double timeout,
+      const std::vector<double>& consistency_limits, std::vector<double>& solution,
+      const IKBatchCallbackFn& batch_callback, moveit_msgs::MoveItErrorCodes& error_code,
+      const KinematicsQueryOptions& options = KinematicsQueryOptions()) const;
+
   /**
    * @brief Given a set of joint angles and a set of links, compute their pose
    * @param link_names A set of links for which FK needs to be computed
@@ -585,6 +644,19 @@ public:
   KinematicsBase();
 
 protected:
+  /** @brief Solves one pose of a batch, see searchPositionIKBatch(). Owns the data the solver sets up per thread. */
+  using BatchSolveFn = std::function<bool(const geometry_msgs::Pose& ik_pose, const std::vector<double>& ik_seed_state,
+                                          std::vector<double>& solution)>;
+
+  /**
+   * @brief Helper for implementations of searchPositionIKBatch(): checks the seeds, distributes the poses over
+   * \e threads threads (the calling thread is one of them) and gathers the solutions.
+   * @param make_solver called once per thread, returns the function that solves the poses of that thread
+   */
+  bool solveIKBatch(const std::vector<geometry_msgs::Pose>& ik_poses, const std::vector<double>& ik_seed_states,
+                    std::vector<double>& solutions, std::vector<bool>& found, unsigned int threads,
+                    const std::function<BatchSolveFn()>& make_solver) const;
+
   moveit::core::RobotModelConstPtr robot_model_;
   std::string robot_description_;
   std::string group_name_;
@@ -37,6 +37,11 @@
 #include <moveit/kinematics_base/kinematics_base.h>
 #include <moveit/robot_model/joint_model_group.h>
 
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <thread>
+
 static const std::string LOGNAME = "kinematics_base";
 
 namespace kinematics
@@ -177,6 +182,94 @@ bool KinematicsBase::supportsGroup(const moveit::core::JointModelGroup* jmg, std
   return true;
 }
 
+bool KinematicsBase::searchPositionIKBatch(const std::vector<geometry_msgs::Pose>& ik_poses,
+                                           const std::vector<double>& ik_seed_states, double timeout,
+                                           std::vector<double>& solutions, std::vector<bool>& found,
+                                           const KinematicsQueryOptions& options, unsigned int /*threads*/) const
+{
+  return solveIKBatch(ik_poses, ik_seed_states, solutions, found, 1, [this, timeout, &options]() -> BatchSolveFn {
+    return [this, timeout, &options](const geometry_msgs::Pose& ik_pose, const std::vector<double>& ik_seed_state,
+                                     std::vector<double>& solution) {
+      moveit_msgs::MoveItErrorCodes error_code;
+      return searchPositionIK(ik_pose, ik_seed_state, timeout, solution, error_code, options);
+    };
+  });
+}
+
+bool KinematicsBase::searchPositionIKWithBatchCallback(const geometry_msgs::Pose& ik_pose,
+                                                       const std::vector<double>& ik_seed_state, double timeout,
+                                                       const std::vector<double>& consistency_limits,
+                                                       std::vector<double>& solution,
+                                                       const IKBatchCallbackFn& batch_callback,
+                                                       moveit_msgs::MoveItErrorCodes& error_code,
+                                                       const KinematicsQueryOptions& options) const
+{
+  if (batch_callback.empty())
+    return searchPositionIK(ik_pose, ik_seed_state, timeout, consistency_limits, solution, error_code, options);
+
+  std::vector<std::vector<double>> candidates(1);
+  std::vector<bool> valid;
+  return searchPositionIK(
+      ik_pose, ik_seed_state, timeout, consistency_limits, solution,
+      [&](const geometry_msgs::Pose& pose, const std::vector<double>& candidate, moveit_msgs::MoveItErrorCodes& code) {
+        candidates[0] = candidate;
+        valid.assign(1, false);
+        batch_callback(pose, candidates, valid);
+        code.val = !valid.empty() && valid[0] ? moveit_msgs::MoveItErrorCodes::SUCCESS :
+                                                moveit_msgs::MoveItErrorCodes::NO_IK_SOLUTION;
+      },
+      error_code, options);
+}
+
+bool KinematicsBase::solveIKBatch(const std::vector<geometry_msgs::Pose>& ik_poses,
+                                  const std::vector<double>& ik_seed_states, std::vector<double>& solutions,
+                                  std::vector<bool>& found, unsigned int threads,
+                                  const std::function<BatchSolveFn()>& make_solver) const
+{
+  const std::size_t count = ik_poses.size();
+  const std::size_t dof = getJointNames().size();
+  found.assign(count, false);
+  if (ik_seed_states.size() != dof && ik_seed_states.size() != count * dof)
+  {
+    ROS_ERROR_NAMED(LOGNAME, "Expected %zu or %zu seed values for %zu poses, got %zu", dof, count * dof, count,
+                    ik_seed_states.size());
+    return false;
+  }
+  solutions.resize(count * dof);
+  if (count == 0)
+    return true;
+
+  if (threads == 0)
+    threads = std::max(1u, std::thread::hardware_concurrency());
+  threads = std::min<std::size_t>(threads, count);
+
+  // std::vector<bool> cannot be written concurrently
+  std::unique_ptr<bool[]> flags(new bool[count]);
+  std::atomic<std::size_t> next_pose(0);
+  auto work = [&]() {
+    const BatchSolveFn solve = make_solver();
+    std::vector<double> seed(dof), solution;
+    for (std::size_t i = next_pose++; i < count; i = next_pose++)
+    {
+      const std::size_t seed_offset = ik_seed_states.size() == dof ? 0 : i * dof;
+      seed.assign(ik_seed_states.begin() + seed_offset, ik_seed_states.begin() + seed_offset + dof);
+      flags[i] = solve(ik_poses[i], seed, solution) && solution.size() == dof;
+      if (flags[i])
+        std::copy(solution.begin(), solution.end(), solutions.begin() + i * dof);
+    }
+  };
+
+  std::vector<std::thread> workers;
+  for (unsigned int t = 1; t < threads; ++t)
+    workers.emplace_back(work);
+  work();
+  for (std::thread& worker : workers)
+    worker.join();
+
+  found.assign(flags.get(), flags.get() + count);
+  return std::find(found.begin(), found.end(), false) == found.end();
+}
+
 KinematicsBase::KinematicsBase()
   : tip_frame_("DEPRECATED")
   // help users understand why this variable might not be set
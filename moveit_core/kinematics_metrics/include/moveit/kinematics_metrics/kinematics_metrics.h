@@ -124,6 +124,31 @@ public:
   bool getManipulability(const moveit::core::RobotState& state, const moveit::core::JointModelGroup* joint_model_group,
                          double& condition_number, bool translation = false) const;
 
+  /**
+   * @brief Get the manipulability index of a group for many joint configurations at once, e.g. the waypoints of a
+   * trajectory or the IK solutions to rank. The Jacobians are computed with batched forward kinematics and the
+   * states are split over all cores.
+   * @param states The states to evaluate; only their joint positions are used
+   * @param joint_model_group A pointer to the desired joint model group
+   * @param manipulability_indices The manipulability index of each state, as computed by getManipulabilityIndex()
+   * @return False if the group is not a chain
+   */
+  bool getManipulabilityIndices(const std::vector<const moveit::core::RobotState*>& states,
+                                const moveit::core::JointModelGroup* joint_model_group,
+                                std::vector<double>& manipulability_indices, bool translation = false) const;
+
+  /**
+   * @brief Get the manipulability = sigma_min/sigma_max of a group for many joint configurations at once,
+   * like getManipulabilityIndices() does for the manipulability index
+   * @param states The states to evaluate; only their joint positions are used
+   * @param joint_model_group A pointer to the desired joint model group
+   * @param condition_numbers The manipulability of each state, as computed by getManipulability()
+   * @return False if the group is not a chain
+   */
+  bool getManipulabilities(const std::vector<const moveit::core::RobotState*>& states,
+                           const moveit::core::JointModelGroup* joint_model_group,
+                           std::vector<double>& condition_numbers, bool translation = false) const;
+
   void setPenaltyMultiplier(double multiplier)
   {
     penalty_multiplier_ = fabs(multiplier);
@@ -153,6 +178,11 @@ private:
   double getJointLimitsPenalty(const moveit::core::RobotState& state,
                                const moveit::core::JointModelGroup* joint_model_group) const;
 
+  /** \brief Shared implementation of getManipulabilityIndices() and getManipulabilities() */
+  bool getBatchMetric(const std::vector<const moveit::core::RobotState*>& states,
+                      const moveit::core::JointModelGroup* joint_model_group, bool translation,
+                      bool condition_number, std::vector<double>& values) const;
+
   double penalty_multiplier_;
 };
 }  // namespace kinematics_metrics
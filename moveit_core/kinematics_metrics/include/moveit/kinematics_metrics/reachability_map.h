@@ -0,0 +1,142 @@
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2026, PickNik LLC.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of PickNik LLC nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *********************************************************************/
+
+#pragma once
+
+#include <moveit/robot_state/robot_state.h>
+#include <moveit/macros/class_forward.h>
+#include <Eigen/Geometry>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace kinematics_metrics
+{
+MOVEIT_CLASS_FORWARD(ReachabilityMap);  // Defines ReachabilityMapPtr, ConstPtr, WeakPtr... etc
+
+/**
+ * \brief A precomputed map of the tip poses the IK solver of a group can reach.
+ *
+ * Positions are voxelized in a cube around the base frame of the solver, orientations are binned by the direction of
+ * the tip's z axis (a cube map with direction_resolution x direction_resolution cells per face) and by the roll around
+ * it. Each (voxel, orientation bin) pair holds one bit, set if IK succeeded for the pose at the center of the bin.
+ * Lookups are O(1), so grasp filters and base placement can reject poses before calling IK.
+ *
+ * The map is a discretization: a pose may be flagged reachable while its exact IK fails, or vice versa at the border
+ * of the workspace. It is a pre-filter, not a replacement for IK.
+ */
+class ReachabilityMap
+{
+public:
+  struct Options
+  {
+    /** \brief Half the side of the mapped cube, centered at the base frame */
+    double radius = 1.0;
+    /** \brief Side of a position voxel */
+    double resolution = 0.05;
+    /** \brief Cells per cube face for the approach direction (6 * n * n directions) */
+    unsigned int direction_resolution = 2;
+    /** \brief Bins for the roll around the approach direction */
+    unsigned int roll_bins = 4;
+    /** \brief IK timeout per pose */
+    double timeout = 0.005;
+    /** \brief Threads passed to KinematicsBase::searchPositionIKBatch(); 0 uses all cores */
+    unsigned int threads = 0;
+  };
+
+  ReachabilityMap() = default;
+
+  /** \brief Fill the map for \e group with batched IK. Returns false if the group has no IK solver. */
+  bool compute(const moveit::core::JointModelGroup* group, const Options& options = Options());
+
+  /** \brief Write the map to a compact binary file */
+  bool saveToFile(const std::string& filename) const;
+
+  /** \brief Read a map written by saveToFile() */
+  bool loadFromFile(const std::string& filename);
+
+  bool empty() const
+  {
+    return bits_.empty();
+  }
+
+  const std::string& getGroupName() const
+  {
+    return group_name_;
+  }
+
+  /** \brief The frame tip poses are expressed in */
+  const std::string& getBaseFrame() const
+  {
+    return base_frame_;
+  }
+
+  const std::string& getTipFrame() const
+  {
+    return tip_frame_;
+  }
+
+  /** \brief Whether \e position (in the base frame) lies inside the mapped cube */
+  bool contains(const Eigen::Vector3d& position) const;
+
+  /** \brief Whether the tip pose \e pose (in the base frame) falls into a reachable bin.
+      Poses outside the mapped cube are unreachable. */
+  bool isReachable(const Eigen::Isometry3d& pose) const;
+
+  /** \brief Fraction of orientation bins reachable in the voxel containing \e position (0 outside the map) */
+  double getReachabilityIndex(const Eigen::Vector3d& position) const;
+
+private:
+  std::size_t getVoxelIndex(const Eigen::Vector3d& position) const;
+  std::size_t getOrientationBin(const Eigen::Matrix3d& rotation) const;
+  Eigen::Matrix3d getOrientationBinCenter(std::size_t bin) const;
+
+  bool getBit(std::size_t voxel, std::size_t bin) const
+  {
+    return bits_[voxel * bytes_per_voxel_ + bin / 8] & (1u << (bin % 8));
+  }
+
+  std::string group_name_;
+  std::string base_frame_;
+  std::string tip_frame_;
+  double radius_ = 0.0;
+  double resolution_ = 0.0;
+  std::int32_t num_cells_ = 0;
+  std::uint32_t direction_resolution_ = 0;
+  std::uint32_t roll_bins_ = 0;
+  std::size_t num_bins_ = 0;
+  std::size_t bytes_per_voxel_ = 0;
+  std::vector<std::uint8_t> bits_;
+};
+}  // namespace kinematics_metrics
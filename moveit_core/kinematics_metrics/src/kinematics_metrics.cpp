@@ -35,12 +35,34 @@
 /* Author: Sachin Chitta */
 
 #include <moveit/kinematics_metrics/kinematics_metrics.h>
+#include <moveit/robot_state/batch_forward_kinematics.h>
 #include <Eigen/Dense>
 #include <Eigen/Eigenvalues>
 #include <boost/math/constants/constants.hpp>
+#include <algorithm>
+#include <stdexcept>
+#include <thread>
 
 namespace kinematics_metrics
 {
+namespace
+{
+// batches are only split over several threads for at least this many states per thread
+constexpr std::size_t MIN_STATES_PER_THREAD = 16;
+
+// Jacobians have at most 6 rows, so their Gram matrices fit on the stack
+using GramMatrix = Eigen::Matrix<double, Eigen::Dynamic, Eigen::Dynamic, 0, 6, 6>;
+
+// J * J^T, or J^T * J if J has fewer columns than rows; its eigenvalues are the squared nonzero singular values of J
+template <typename Derived>
+GramMatrix gramMatrix(const Eigen::MatrixBase<Derived>& jacobian)
+{
+  if (jacobian.cols() >= jacobian.rows())
+    return jacobian * jacobian.transpose();
+  return jacobian.transpose() * jacobian;
+}
+}  // namespace
+
 double KinematicsMetrics::getJointLimitsPenalty(const moveit::core::RobotState& state,
                                                 const moveit::core::JointModelGroup* joint_model_group) const
 {
@@ -234,4 +256,88 @@ bool KinematicsMetrics::getManipulability(const moveit::core::RobotState& state,
   return true;
 }
 
+bool KinematicsMetrics::getManipulabilityIndices(const std::vector<const moveit::core::RobotState*>& states,
+                                                 const moveit::core::JointModelGroup* joint_model_group,
+                                                 std::vector<double>& manipulability_indices, bool translation) const
+{
+  return getBatchMetric(states, joint_model_group, translation, false, manipulability_indices);
+}
+
+bool KinematicsMetrics::getManipulabilities(const std::vector<const moveit::core::RobotState*>& states,
+                                            const moveit::core::JointModelGroup* joint_model_group,
+                                            std::vector<double>& condition_numbers, bool translation) const
+{
+  return getBatchMetric(states, joint_model_group, translation, true, condition_numbers);
+}
+
+bool KinematicsMetrics::getBatchMetric(const std::vector<const moveit::core::RobotState*>& states,
+                                       const moveit::core::JointModelGroup* joint_model_group, bool translation,
+                                       bool condition_number, std::vector<double>& values) const
+{
+  // state.getJacobian() only works for chain groups.
+  if (!joint_model_group->isChain())
+  {
+    return false;
+  }
+  const std::size_t count = states.size();
+  values.resize(count);
+  const moveit::core::LinkModel* tip = joint_model_group->getLinkModels().back();
+  const Eigen::Index dof = joint_model_group->getVariableCount();
+  const Eigen::Index rows = translation ? 3 : 6;
+
+  // the Jacobians of each chunk of states are computed together; the chunks are evaluated in parallel
+  auto evaluate = [&](std::size_t begin, std::size_t end) {
+    if (begin >= end)
+      return;
+    moveit::core::BatchForwardKinematics batch(robot_model_);
+    batch.setStates(std::vector<const moveit::core::RobotState*>(states.begin() + begin, states.begin() + end));
+    batch.computeLinkTransforms();
+    Eigen::Matrix<double, 6, Eigen::Dynamic> jacobians;
+    try
+    {
+      batch.computeJacobians(joint_model_group, tip, Eigen::Vector3d::Zero(), jacobians);
+    }
+    catch (std::invalid_argument&)
+    {
+      // joints the batch does not support; evaluate the states one by one
+      for (std::size_t i = begin; i < end; ++i)
+      {
+        moveit::core::RobotState state(*states[i]);
+        state.update();
+        if (condition_number)
+          getManipulability(state, joint_model_group, values[i], translation);
+        else
+          getManipulabilityIndex(state, joint_model_group, values[i], translation);
+      }
+      return;
+    }
+
+    for (std::size_t i = begin; i < end; ++i)
+    {
+      const GramMatrix gram = gramMatrix(jacobians.block(0, (i - begin) * dof, rows, dof));
+      double value;
+      if (condition_number)
+      {
+        Eigen::SelfAdjointEigenSolver<GramMatrix> solver(gram, Eigen::EigenvaluesOnly);
+        const auto& eigenvalues = solver.eigenvalues();  // in increasing order
+        value = std::sqrt(std::max(0.0, eigenvalues(0)) / eigenvalues(eigenvalues.size() - 1));
+      }
+      else
+        value = std::sqrt(std::max(0.0, gram.determinant()));
+      values[i] = getJointLimitsPenalty(*states[i], joint_model_group) * value;
+    }
+  };
+
+  const std::size_t threads = std::min<std::size_t>(std::max(1u, std::thread::hardware_concurrency()),
+                                                    count / MIN_STATES_PER_THREAD + 1);
+  const std::size_t chunk = (count + threads - 1) / threads;
+  std::vector<std::thread> workers;
+  for (std::size_t t = 1; t < threads; ++t)
+    workers.emplace_back(evaluate, std::min(count, t * chunk), std::min(count, (t + 1) * chunk));
+  evaluate(0, std::min(count, chunk));
+  for (std::thread& worker : workers)
+    worker.join();
+  return true;
+}
+
 }  // end of namespace kinematics_metrics
@@ -0,0 +1,317 @@
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2026, PickNik LLC.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of PickNik LLC nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *********************************************************************/
+
+#include <moveit/kinematics_metrics/reachability_map.h>
+#include <tf2_eigen/tf2_eigen.h>
+#include <ros/console.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+
+namespace kinematics_metrics
+{
+namespace
+{
+const std::string LOGNAME = "reachability_map";
+
+/** \brief Header of the files written by ReachabilityMap::saveToFile(), followed by the group, base and tip names */
+struct BinaryFileHeader
+{
+  char magic[8];
+  std::uint32_t version;
+  std::int32_t num_cells;
+  std::uint32_t direction_resolution;
+  std::uint32_t roll_bins;
+  double radius;
+  double resolution;
+  std::uint32_t name_sizes[3];
+  std::uint32_t reserved;
+};
+
+const char BINARY_FILE_MAGIC[8] = { 'M', 'V', 'T', 'R', 'M', 'A', 'P', '\0' };
+const std::uint32_t BINARY_FILE_VERSION = 1;
+
+/** \brief Zero roll direction for approach direction \e z on the cube face of \e axis: the next coordinate axis,
+    projected onto the plane normal to \e z. \e z is never parallel to it, since z[axis] is its largest component. */
+Eigen::Vector3d rollReference(int axis, const Eigen::Vector3d& z)
+{
+  Eigen::Vector3d ref = Eigen::Vector3d::Unit((axis + 1) % 3);
+  return (ref - ref.dot(z) * z).normalized();
+}
+}  // namespace
+
+bool ReachabilityMap::compute(const moveit::core::JointModelGroup* group, const Options& options)
+{
+  const kinematics::KinematicsBaseConstPtr& solver = group->getSolverInstance();
+  if (!solver)
+  {
+    ROS_ERROR_NAMED(LOGNAME, "No kinematics solver instantiated for group '%s'", group->getName().c_str());
+    return false;
+  }
+
+  group_name_ = group->getName();
+  base_frame_ = solver->getBaseFrame();
+  tip_frame_ = solver->getTipFrame();
+  radius_ = options.radius;
+  resolution_ = options.resolution;
+  num_cells_ = std::max(1, static_cast<std::int32_t>(std::ceil(2.0 * radius_ / resolution_)));
+  direction_resolution_ = std::max(1u, options.direction_resolution);
+  roll_bins_ = std::max(1u, options.roll_bins);
+  num_bins_ = 6 * direction_resolution_ * direction_resolution_ * roll_bins_;
+  bytes_per_voxel_ = (num_bins_ + 7) / 8;
+  bits_.assign(static_cast<std::size_t>(num_cells_) * num_cells_ * num_cells_ * bytes_per_voxel_, 0);
+
+  std::vector<Eigen::Matrix3d> bin_rotations(num_bins_);
+  for (std::size_t bin = 0; bin < num_bins_; ++bin)
+    bin_rotations[bin] = getOrientationBinCenter(bin);
+
+  // all poses start from the default state, in the joint order of the solver
+  std::vector<double> default_values;
+  group->getVariableDefaultPositions(default_values);
+  const std::vector<unsigned int>& bij = group->getKinematicsSolverJointBijection();
+  std::vector<double> seed(bij.size());
+  for (std::size_t i = 0; i < bij.size(); ++i)
+    seed[i] = default_values[bij[i]];
+
+  // one batch per x slab bounds the memory used for poses and solutions
+  std::vector<geometry_msgs::Pose> poses;
+  std::vector<std::size_t> voxels;
+  std::vector<double> solutions;
+  std::vector<bool> found;
+  std::size_t num_reachable = 0;
+  for (std::int32_t x = 0; x < num_cells_; ++x)
+  {
+    poses.clear();
+    voxels.clear();
+    for (std::int32_t y = 0; y < num_cells_; ++y)
+      for (std::int32_t z = 0; z < num_cells_; ++z)
+      {
+        const Eigen::Vector3d center = (Eigen::Vector3d(x, y, z) + Eigen::Vector3d::Constant(0.5)) * resolution_ -
+                                       Eigen::Vector3d::Constant(radius_);
+        if (center.norm() > radius_)
+          continue;
+        voxels.push_back((static_cast<std::size_t>(x) * num_cells_ + y) * num_cells_ + z);
+        for (const Eigen::Matrix3d& rotation : bin_rotations)
+        {
+          Eigen::Isometry3d pose = Eigen::Isometry3d::Identity();
+          pose.linear() = rotation;
+          pose.translation() = center;
+          poses.push_back(tf2::toMsg(pose));
+        }
+      }
+    if (poses.empty())
+      continue;
+
+    solver->searchPositionIKBatch(poses, seed, options.timeout, solutions, found,
+                                  kinematics::KinematicsQueryOptions(), options.threads);
+    for (std::size_t i = 0; i < found.size(); ++i)
+      if (found[i])
+      {
+        const std::size_t voxel = voxels[i / num_bins_];
+        const std::size_t bin = i % num_bins_;
+        bits_[voxel * bytes_per_voxel_ + bin / 8] |= 1u << (bin % 8);
+        ++num_reachable;
+      }
+    ROS_DEBUG_NAMED(LOGNAME, "Reachability map for '%s': slab %d of %d done", group_name_.c_str(), x + 1, num_cells_);
+  }
+
+  ROS_INFO_NAMED(LOGNAME, "Reachability map for '%s' has %zu reachable poses", group_name_.c_str(), num_reachable);
+  return true;
+}
+
+bool ReachabilityMap::saveToFile(const std::string& filename) const
+{
+  std::ofstream os(filename.c_str(), std::ios::out | std::ios::binary | std::ios::trunc);
+  if (!os.good())
+  {
+    ROS_ERROR_NAMED(LOGNAME, "Unable to open '%s' for writing", filename.c_str());
+    return false;
+  }
+
+  BinaryFileHeader header;
+  std::memset(&header, 0, sizeof(header));
+  std::memcpy(header.magic, BINARY_FILE_MAGIC, sizeof(header.magic));
+  header.version = BINARY_FILE_VERSION;
+  header.num_cells = num_cells_;
+  header.direction_resolution = direction_resolution_;
+  header.roll_bins = roll_bins_;
+  header.radius = radius_;
+  header.resolution = resolution_;
+  header.name_sizes[0] = group_name_.size();
+  header.name_sizes[1] = base_frame_.size();
+  header.name_sizes[2] = tip_frame_.size();
+  os.write(reinterpret_cast<const char*>(&header), sizeof(header));
+  os.write(group_name_.data(), group_name_.size());
+  os.write(base_frame_.data(), base_frame_.size());
+  os.write(tip_frame_.data(), tip_frame_.size());
+  os.write(reinterpret_cast<const char*>(bits_.data()), bits_.size());
+  os.close();
+  return !os.fail();
+}
+
+bool ReachabilityMap::loadFromFile(const std::string& filename)
+{
+  std::ifstream is(filename.c_str(), std::ios::in | std::ios::binary);
+  BinaryFileHeader header;
+  if (!is.read(reinterpret_cast<char*>(&header), sizeof(header)) ||
+      std::memcmp(header.magic, BINARY_FILE_MAGIC, sizeof(header.magic)) != 0 ||
+      header.version != BINARY_FILE_VERSION || header.num_cells <= 0 || header.direction_resolution == 0 ||
+      header.roll_bins == 0)
+  {
+    ROS_ERROR_NAMED(LOGNAME, "'%s' is not a reachability map", filename.c_str());
+    return false;
+  }
+
+  std::string names[3];
+  for (int i = 0; i < 3; ++i)
+  {
+    names[i].resize(header.name_sizes[i]);
+    is.read(&names[i][0], header.name_sizes[i]);
+  }
+
+  const std::size_t num_bins = 6 * header.direction_resolution * header.direction_resolution * header.roll_bins;
+  const std::size_t bytes_per_voxel = (num_bins + 7) / 8;
+  std::vector<std::uint8_t> bits(static_cast<std::size_t>(header.num_cells) * header.num_cells * header.num_cells *
+                                 bytes_per_voxel);
+  if (!is.read(reinterpret_cast<char*>(bits.data()), bits.size()))
+  {
+    ROS_ERROR_NAMED(LOGNAME, "Reachability map '%s' is truncated", filename.c_str());
+    return false;
+  }
+
+  group_name_ = names[0];
+  base_frame_ = names[1];
+  tip_frame_ = names[2];
+  radius_ = header.radius;
+  resolution_ = header.resolution;
+  num_cells_ = header.num_cells;
+  direction_resolution_ = header.direction_resolution;
+  roll_bins_ = header.roll_bins;
+  num_bins_ = num_bins;
+  bytes_per_voxel_ = bytes_per_voxel;
+  bits_.swap(bits);
+  return true;
+}
+
+bool ReachabilityMap::contains(const Eigen::Vector3d& position) const
+{
+  const double size = num_cells_ * resolution_;
+  for (int i = 0; i < 3; ++i)
+    if (!(position[i] >= -radius_ && position[i] < size - radius_))
+      return false;
+  return !bits_.empty();
+}
+
+bool ReachabilityMap::isReachable(const Eigen::Isometry3d& pose) const
+{
+  if (!contains(pose.translation()))
+    return false;
+  return getBit(getVoxelIndex(pose.translation()), getOrientationBin(pose.linear()));
+}
+
+double ReachabilityMap::getReachabilityIndex(const Eigen::Vector3d& position) const
+{
+  if (!contains(position))
+    return 0.0;
+  const std::size_t voxel = getVoxelIndex(position);
+  std::size_t count = 0;
+  for (std::size_t bin = 0; bin < num_bins_; ++bin)
+    count += getBit(voxel, bin);
+  return static_cast<double>(count) / num_bins_;
+}
+
+std::size_t ReachabilityMap::getVoxelIndex(const Eigen::Vector3d& position) const
+{
+  std::size_t index = 0;
+  for (int i = 0; i < 3; ++i)
+  {
+    const std::int32_t cell = static_cast<std::int32_t>((position[i] + radius_) / resolution_);
+    index = index * num_cells_ + std::min(std::max(cell, 0), num_cells_ - 1);
+  }
+  return index;
+}
+
+std::size_t ReachabilityMap::getOrientationBin(const Eigen::Matrix3d& rotation) const
+{
+  // the approach direction selects a cell of the cube map
+  const Eigen::Vector3d z = rotation.col(2);
+  int axis;
+  z.cwiseAbs().maxCoeff(&axis);
+  const std::size_t face = 2 * axis + (z[axis] < 0.0 ? 1 : 0);
+  const double n = direction_resolution_;
+  auto cell = [&](double coordinate) {
+    const double c = (coordinate / std::abs(z[axis]) + 1.0) * 0.5 * n;
+    return static_cast<std::size_t>(std::min(std::max(c, 0.0), n - 1.0));
+  };
+  const std::size_t u = cell(z[(axis + 1) % 3]);
+  const std::size_t v = cell(z[(axis + 2) % 3]);
+
+  // the roll is the angle of the x axis around the approach direction
+  const Eigen::Vector3d ref = rollReference(axis, z);
+  const Eigen::Vector3d x = rotation.col(0);
+  const double roll = std::atan2(x.dot(z.cross(ref)), x.dot(ref));
+  const std::size_t r = std::min<std::size_t>(roll_bins_ - 1, (roll + M_PI) / (2.0 * M_PI) * roll_bins_);
+
+  return ((face * direction_resolution_ + u) * direction_resolution_ + v) * roll_bins_ + r;
+}
+
+Eigen::Matrix3d ReachabilityMap::getOrientationBinCenter(std::size_t bin) const
+{
+  const std::size_t r = bin % roll_bins_;
+  bin /= roll_bins_;
+  const std::size_t v = bin % direction_resolution_;
+  bin /= direction_resolution_;
+  const std::size_t u = bin % direction_resolution_;
+  const std::size_t face = bin / direction_resolution_;
+
+  const int axis = face / 2;
+  Eigen::Vector3d z;
+  z[axis] = face % 2 ? -1.0 : 1.0;
+  z[(axis + 1) % 3] = (u + 0.5) / direction_resolution_ * 2.0 - 1.0;
+  z[(axis + 2) % 3] = (v + 0.5) / direction_resolution_ * 2.0 - 1.0;
+  z.normalize();
+
+  const Eigen::Vector3d ref = rollReference(axis, z);
+  const double roll = (r + 0.5) / roll_bins_ * 2.0 * M_PI - M_PI;
+  const Eigen::Vector3d x = std::cos(roll) * ref + std::sin(roll) * z.cross(ref);
+
+  Eigen::Matrix3d rotation;
+  rotation.col(0) = x;
+  rotation.col(1) = z.cross(x);
+  rotation.col(2) = z;
+  return rotation;
+}
+}  // namespace kinematics_metrics
@@ -0,0 +1,89 @@
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2026, PickNik LLC.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of PickNik LLC nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *********************************************************************/
+
+#include <moveit/kinematics_metrics/kinematics_metrics.h>
+#include <moveit/utils/robot_model_test_utils.h>
+#include <gtest/gtest.h>
+
+namespace
+{
+void checkBatchAgainstSingleStates(bool translation)
+{
+  const moveit::core::RobotModelPtr model = moveit::core::loadTestingRobotModel("panda");
+  const moveit::core::JointModelGroup* group = model->getJointModelGroup("panda_arm");
+  ASSERT_TRUE(group);
+  kinematics_metrics::KinematicsMetrics metrics(model);
+  metrics.setPenaltyMultiplier(1.0);
+
+  // enough states to be split over several threads
+  std::vector<moveit::core::RobotState> states(100, moveit::core::RobotState(model));
+  std::vector<const moveit::core::RobotState*> state_ptrs;
+  for (moveit::core::RobotState& state : states)
+  {
+    state.setToRandomPositions();
+    state.update();
+    state_ptrs.push_back(&state);
+  }
+
+  std::vector<double> indices, condition_numbers;
+  ASSERT_TRUE(metrics.getManipulabilityIndices(state_ptrs, group, indices, translation));
+  ASSERT_TRUE(metrics.getManipulabilities(state_ptrs, group, condition_numbers, translation));
+  ASSERT_EQ(indices.size(), states.size());
+  ASSERT_EQ(condition_numbers.size(), states.size());
+  for (std::size_t i = 0; i < states.size(); ++i)
+  {
+    double index, condition_number;
+    ASSERT_TRUE(metrics.getManipulabilityIndex(states[i], group, index, translation));
+    ASSERT_TRUE(metrics.getManipulability(states[i], group, condition_number, translation));
+    EXPECT_NEAR(indices[i], index, 1e-9) << "state " << i;
+    EXPECT_NEAR(condition_numbers[i], condition_number, 1e-9) << "state " << i;
+  }
+}
+}  // namespace
+
+TEST(KinematicsMetrics, BatchMatchesSingleStates)
+{
+  checkBatchAgainstSingleStates(false);
+}
+
+TEST(KinematicsMetrics, BatchMatchesSingleStatesTranslation)
+{
+  checkBatchAgainstSingleStates(true);
+}
+
+int main(int argc, char** argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -51,6 +51,12 @@ struct MotionPlanResponse
   moveit_msgs::RobotState start_state_;
   std::string planner_id_;
 
+  /** \brief Wall time [s] spent in each stage of the planning pipeline (request adapters, planning context setup,
+      solving, ...), in the order in which the stages completed. A description of the form "parent/child" denotes a
+      part of an enclosing stage that is also reported on its own. */
+  std::vector<std::string> stage_description_;
+  std::vector<double> stage_time_;
+
   [[deprecated("Use trajectory_ instead.")]] const robot_trajectory::RobotTrajectoryPtr& trajectory;
   [[deprecated("Use planning_time_ instead.")]] const double& planning_time;
   [[deprecated("Use error_code_ instead.")]] const moveit::core::MoveItErrorCode& error_code;
@@ -80,9 +86,18 @@ struct MotionPlanResponse
     error_code_ = response.error_code_;
     start_state_ = response.start_state_;
     planner_id_ = response.planner_id_;
+    stage_description_ = response.stage_description_;
+    stage_time_ = response.stage_time_;
     return *this;
   }
 
+  /// Record the wall time [s] spent in a stage of the planning pipeline
+  void addStageTime(const std::string& description, double time)
+  {
+    stage_description_.push_back(description);
+    stage_time_.push_back(time);
+  }
+
   void getMessage(moveit_msgs::MotionPlanResponse& msg) const;
 
   // Enable checking of query success or failure, for example if(response) ...
@@ -103,6 +118,10 @@ struct MotionPlanDetailedResponse
   moveit_msgs::RobotState start_state_;
   std::string planner_id_;
 
+  /// Wall time [s] spent in each stage of the planning pipeline, see MotionPlanResponse::stage_description_
+  std::vector<std::string> stage_description_;
+  std::vector<double> stage_time_;
+
   // Enable checking of query success or failure, for example if(response) ...
   explicit operator bool() const
   {
@@ -71,6 +71,16 @@ public:
     return "";
   }
 
+  /** \brief Whether this adapter only changes requests whose start state is invalid, i.e. it calls the planner with
+      the unchanged request and leaves the response alone if the start state is within the bounds of the planning
+      group (with continuous, planar and floating joints normalized), not in collision and satisfying the path
+      constraints. A PlanningRequestAdapterChain checks the start state once for all such adapters and skips them
+      if it is valid. */
+  virtual bool onlyFixesInvalidStartState() const
+  {
+    return false;
+  }
+
   bool adaptAndPlan(const planning_interface::PlannerManagerPtr& planner,
                     const planning_scene::PlanningSceneConstPtr& planning_scene,
                     const planning_interface::MotionPlanRequest& req,
@@ -92,7 +102,10 @@ public:
                             std::vector<std::size_t>& added_path_index) const = 0;
 };
 
-/// Apply a sequence of adapters to a motion plan
+/** \brief Apply a sequence of adapters to a motion plan.
+
+    Adapters that only fix invalid start states (see PlanningRequestAdapter::onlyFixesInvalidStartState()) share a
+    single check of the start state and are skipped if it is valid. */
 class PlanningRequestAdapterChain
 {
 public:
@@ -36,6 +36,9 @@
 
 #include <moveit/utils/moveit_error_code.h>
 #include <moveit/planning_request_adapter/planning_request_adapter.h>
+#include <moveit/kinematic_constraints/kinematic_constraint.h>
+#include <moveit/robot_state/conversions.h>
+#include <ros/time.h>
 #include <functional>
 #include <algorithm>
 
@@ -43,16 +46,68 @@ namespace planning_request_adapter
 {
 namespace
 {
+// Wall time accumulated by the planner over all calls made by the adapters
+struct PlannerTime
+{
+  double context_setup = 0.0;
+  double solve = 0.0;
+};
+
 bool callPlannerInterfaceSolve(const planning_interface::PlannerManager& planner,
                                const planning_scene::PlanningSceneConstPtr& planning_scene,
                                const planning_interface::MotionPlanRequest& req,
-                               planning_interface::MotionPlanResponse& res)
+                               planning_interface::MotionPlanResponse& res, PlannerTime* time = nullptr)
 {
+  ros::WallTime start = ros::WallTime::now();
   planning_interface::PlanningContextPtr context = planner.getPlanningContext(planning_scene, req, res.error_code_);
-  if (context)
-    return context->solve(res);
-  else
+  ros::WallTime setup_done = ros::WallTime::now();
+  bool result = context ? context->solve(res) : false;
+  if (time)
+  {
+    time->context_setup += (setup_done - start).toSec();
+    time->solve += (ros::WallTime::now() - setup_done).toSec();
+  }
+  return result;
+}
+
+void addPlannerStageTimes(const PlannerTime& time, planning_interface::MotionPlanResponse& res)
+{
+  res.addStageTime("planning context setup", time.context_setup);
+  res.addStageTime("solve", time.solve);
+}
+
+// Whether none of the adapters that fix invalid start states would change \e req: its start state is within the
+// bounds of the joints of the planning group and normalized, not in collision and satisfies the path constraints
+bool isStartStateValid(const planning_scene::PlanningScene& planning_scene,
+                       const planning_interface::MotionPlanRequest& req)
+{
+  moveit::core::RobotState start_state = planning_scene.getCurrentState();
+  moveit::core::robotStateMsgToRobotState(planning_scene.getTransforms(), req.start_state, start_state);
+
+  const moveit::core::RobotModel& robot_model = *planning_scene.getRobotModel();
+  const std::vector<const moveit::core::JointModel*>& jmodels =
+      robot_model.hasJointModelGroup(req.group_name) ?
+          robot_model.getJointModelGroup(req.group_name)->getJointModels() :
+          robot_model.getJointModels();
+  std::vector<double> values;
+  for (const moveit::core::JointModel* jmodel : jmodels)
+  {
+    const double* positions = start_state.getJointPositions(jmodel);
+    values.assign(positions, positions + jmodel->getVariableCount());
+    if (jmodel->enforcePositionBounds(values.data()))
+      return false;
+  }
+
+  collision_detection::CollisionRequest creq;
+  creq.group_name = req.group_name;
+  collision_detection::CollisionResult cres;
+  planning_scene.checkCollision(creq, cres, start_state);
+  if (cres.collision)
     return false;
+
+  kinematic_constraints::KinematicConstraintSet path_constraints(planning_scene.getRobotModel());
+  path_constraints.add(req.path_constraints, planning_scene.getTransforms());
+  return path_constraints.decide(start_state).satisfied;
 }
 
 bool callAdapter(const PlanningRequestAdapter& adapter, const PlanningRequestAdapter::PlannerFn& planner,
@@ -121,34 +176,74 @@ bool PlanningRequestAdapterChain::adaptAndPlan(const planning_interface::Planner
   if (adapters_.empty())
   {
     added_path_index.clear();
-    return callPlannerInterfaceSolve(*planner, planning_scene, req, res);
+    PlannerTime planner_time;
+    bool result = callPlannerInterfaceSolve(*planner, planning_scene, req, res, &planner_time);
+    addPlannerStageTimes(planner_time, res);
+    return result;
   }
   else
   {
     // the index values added by each adapter
     std::vector<std::vector<std::size_t> > added_path_index_each(adapters_.size());
 
+    // check the start state once for all adapters that only fix invalid start states, and skip them if it is valid
+    std::vector<bool> skip(adapters_.size(), false);
+    if (std::any_of(adapters_.begin(), adapters_.end(), [](const PlanningRequestAdapterConstPtr& adapter) {
+          return adapter->onlyFixesInvalidStartState();
+        }))
+    {
+      ros::WallTime start = ros::WallTime::now();
+      if (isStartStateValid(*planning_scene, req))
+        for (std::size_t i = 0; i < adapters_.size(); ++i)
+          skip[i] = adapters_[i]->onlyFixesInvalidStartState();
+      res.addStageTime("start state check", (ros::WallTime::now() - start).toSec());
+    }
+
+    // the wall time spent in each adapter, including the adapters and the planner it calls
+    std::vector<double> adapter_time(adapters_.size(), 0.0);
+    PlannerTime planner_time;
+
     // if there are adapters, construct a function for each, in order,
     // so that in the end we have a nested sequence of functions that calls all adapters
     // and eventually the planner in the correct order.
-    PlanningRequestAdapter::PlannerFn fn = [&planner = *planner](const planning_scene::PlanningSceneConstPtr& scene,
-                                                                 const planning_interface::MotionPlanRequest& req,
-                                                                 planning_interface::MotionPlanResponse& res) {
-      return callPlannerInterfaceSolve(planner, scene, req, res);
+    PlanningRequestAdapter::PlannerFn fn = [&planner = *planner, &planner_time](
+                                               const planning_scene::PlanningSceneConstPtr& scene,
+                                               const planning_interface::MotionPlanRequest& req,
+                                               planning_interface::MotionPlanResponse& res) {
+      return callPlannerInterfaceSolve(planner, scene, req, res, &planner_time);
     };
 
     for (int i = adapters_.size() - 1; i >= 0; --i)
     {
-      fn = [&adapter = *adapters_[i], fn, &added_path_index = added_path_index_each[i]](
+      if (skip[i])
+        continue;
+      fn = [&adapter = *adapters_[i], fn, &added_path_index = added_path_index_each[i], &time = adapter_time[i]](
                const planning_scene::PlanningSceneConstPtr& scene, const planning_interface::MotionPlanRequest& req,
                planning_interface::MotionPlanResponse& res) {
-        return callAdapter(adapter, fn, scene, req, res, added_path_index);
+        ros::WallTime start = ros::WallTime::now();
+        bool result = callAdapter(adapter, fn, scene, req, res, added_path_index);
+        time += (ros::WallTime::now() - start).toSec();
+        return result;
       };
     }
 
     bool result = fn(planning_scene, req, res);
     added_path_index.clear();
 
+    // report the time spent in each adapter itself, excluding what it spent waiting on the rest of the chain
+    for (std::size_t i = 0; i < adapters_.size(); ++i)
+    {
+      if (skip[i])
+        continue;
+      std::size_t next = i + 1;
+      while (next < adapters_.size() && skip[next])
+        ++next;
+      double inner_time =
+          next < adapters_.size() ? adapter_time[next] : planner_time.context_setup + planner_time.solve;
+      res.addStageTime(adapters_[i]->getDescription(), std::max(0.0, adapter_time[i] - inner_time));
+    }
+    addPlannerStageTimes(planner_time, res);
+
     // merge the index values from each adapter
     for (std::vector<std::size_t>& added_states_by_each_adapter : added_path_index_each)
       for (std::size_t& added_index : added_states_by_each_adapter)
@@ -43,6 +43,7 @@
 #include <moveit/collision_detection/world_diff.h>
 #include <moveit/collision_detection/collision_env.h>
 #include <moveit/kinematic_constraints/kinematic_constraint.h>
+#include <moveit/planning_scene/state_validity_cache.h>
 #include <moveit/kinematics_base/kinematics_base.h>
 #include <moveit/robot_trajectory/robot_trajectory.h>
 #include <moveit/macros/class_forward.h>
@@ -54,7 +55,10 @@
 #include <boost/noncopyable.hpp>
 #include <boost/function.hpp>
 #include <boost/concept_check.hpp>
+#include <cstdint>
+#include <deque>
 #include <memory>
+#include <mutex>
 
 // Import/export for windows dll's and visibility for gcc shared libraries.
 #include <moveit/moveit_planning_scene_export.h>
@@ -84,6 +88,20 @@ using ObjectColorMap = std::map<std::string, std_msgs::ColorRGBA>;
 /** \brief A map from object names (e.g., attached bodies, collision objects) to their types */
 using ObjectTypeMap = std::map<std::string, object_recognition_msgs::ObjectType>;
 
+/** \brief Options for PlanningScene::isPathValid() when checking the waypoints of a trajectory in parallel */
+struct PathValidityOptions
+{
+  /** \brief Number of threads the waypoints are distributed over. 0 uses one thread per hardware core */
+  unsigned int threads = 1;
+
+  /** \brief Check the first and last waypoint first, then recursively the midpoints of the remaining segments,
+      so that invalid paths are typically rejected after checking only a few waypoints */
+  bool bisection_order = false;
+
+  /** \brief Report details about invalid waypoints */
+  bool verbose = false;
+};
+
 /** \brief This class maintains the representation of the
     environment as seen by a planning instance. The environment
     geometry, the robot geometry and state are maintained. */
@@ -125,6 +143,10 @@ public:
    *  They are shared with the parent.  So if changes to these are made in the parent they will be visible in the child.
    * But if any of these is modified (i.e. if the get*NonConst functions are called) in the child then a copy is made
    * and subsequent changes to the corresponding member of the parent will no longer be visible in the child.
+   *
+   * If a maximum diff depth is set (see setMaxDiffDepth()) and the new child would exceed it, the chain of parents is
+   * flattened first: the child is created from a parent-free clone of this scene. Lookups in the child then no longer
+   * walk the chain, but changes made to this scene or its parents afterwards are not visible in the child.
    */
   PlanningScenePtr diff() const;
 
@@ -138,6 +160,22 @@ public:
     return parent_;
   }
 
+  /** \brief Get the number of parents this scene has, i.e. the length of its diff chain */
+  std::size_t getDiffDepth() const;
+
+  /** \brief Limit the length of the diff chains created by diff() to \e depth parents; 0 means unlimited, which is
+      the default. Diffs of this scene inherit the limit. */
+  void setMaxDiffDepth(std::size_t depth)
+  {
+    max_diff_depth_ = depth;
+  }
+
+  /** \brief Get the maximum length of the diff chains created by diff(); 0 means unlimited */
+  std::size_t getMaxDiffDepth() const
+  {
+    return max_diff_depth_;
+  }
+
   /** \brief Get the kinematic model for which the planning scene is maintained */
   const moveit::core::RobotModelConstPtr& getRobotModel() const
   {
@@ -226,6 +264,31 @@ public:
    * body id or a collision object */
   bool knowsFrameTransform(const moveit::core::RobotState& state, const std::string& id) const;
 
+  /** \brief A frame id resolved by resolveFrame(), for repeated lookups of its transform without searching the robot
+   * links, attached bodies, world objects and fixed frames by name */
+  struct FrameHandle
+  {
+    std::string id;
+    const moveit::core::LinkModel* link = nullptr;         // set for robot links
+    const moveit::core::Transforms* transforms = nullptr;  // set for fixed frames of these transforms
+    moveit::core::Transforms::FrameHandle fixed_frame = moveit::core::Transforms::INVALID_FRAME_HANDLE;
+  };
+
+  /** \brief Resolve the frame \e id for getFrameTransform(). Robot links and fixed frames are looked up directly,
+   * all other frames by name as before. The handle reflects the frames known when it was resolved, so it should be
+   * resolved again if an object or attached body with the name of a fixed frame is added. */
+  FrameHandle resolveFrame(const std::string& id) const;
+
+  /** \brief Get the transform of the frame of \e handle, as getFrameTransform(const std::string&) does */
+  const Eigen::Isometry3d& getFrameTransform(const FrameHandle& handle) const
+  {
+    return getFrameTransform(getCurrentState(), handle);
+  }
+
+  /** \brief Get the transform of the frame of \e handle, as getFrameTransform(const moveit::core::RobotState&, const
+   * std::string&) does */
+  const Eigen::Isometry3d& getFrameTransform(const moveit::core::RobotState& state, const FrameHandle& handle) const;
+
   /**@}*/
 
   /**
@@ -246,6 +309,10 @@ public:
    * collision detector will always be available unless it is removed by
    * calling setActiveCollisionDetector() with exclusive=true.
    *
+   * All added collision detectors observe the world and stay up to date, so switching between them with
+   * setActiveCollisionDetector() or querying one with getCollisionEnv(name) costs nothing. Diff scenes only allocate
+   * the active detector up front and the others when they are first used.
+   *
    * example: to add FCL collision detection (normally not necessary) call
    *   planning_scene->addCollisionDetector(collision_detection::CollisionDetectorAllocatorFCL::create());
    *
@@ -295,6 +362,12 @@ public:
     return world_;
   }
 
+  /** \brief Get the ids of the world objects whose bounding boxes come within \e distance of the bounding box of
+   * link \e link_name in \e state. This is a cheap broadphase query on the spatial index of the world; the
+   * objects found are not necessarily that close to the link geometry itself. */
+  std::vector<std::string> getWorldObjectIdsNearLink(const moveit::core::RobotState& state,
+                                                     const std::string& link_name, double distance) const;
+
   /** \brief Get the active collision environment */
   const collision_detection::CollisionEnvConstPtr& getCollisionEnv() const
   {
@@ -374,6 +447,12 @@ public:
       If a group name is specified, collision checking is done for that group only. */
   bool isStateColliding(const moveit_msgs::RobotState& state, const std::string& group = "", bool verbose = false) const;
 
+  /** \brief Check many states for collisions (with the environment or self collision), e.g. the waypoints of a dense
+      trajectory. \e colliding receives one flag per state. The states are distributed over \e threads threads.
+      It is expected that the link transforms of all states are up to date. */
+  void isStateColliding(const std::vector<const moveit::core::RobotState*>& states, std::vector<bool>& colliding,
+                        const std::string& group = "", unsigned int threads = 1) const;
+
   /** \brief Check whether the current state is in collision, and if needed, updates the collision transforms of the
    * current state before the computation. */
   void checkCollision(const collision_detection::CollisionRequest& req, collision_detection::CollisionResult& res);
@@ -765,6 +844,8 @@ cylinder
   /** \brief Fill the message \e scene with the differences between this instance of PlanningScene with respect to the
      parent.
       If there is no parent, everything is considered to be a diff and the function behaves like getPlanningSceneMsg()
+      World objects whose shapes, subframes and type equal those in the parent are sent as MOVE operations carrying
+      only the new pose, so geometry is only sent when it actually changed.
      */
   void getPlanningSceneDiffMsg(moveit_msgs::PlanningScene& scene) const;
 
@@ -852,6 +933,36 @@ cylinder
   /** \brief Set the callback to be triggered when changes are made to the current scene world */
   void setCollisionObjectUpdateCallback(const collision_detection::World::ObserverCallbackFn& callback);
 
+  /** \brief A change recorded in the change journal of this scene */
+  struct SceneChange
+  {
+    enum Type
+    {
+      WORLD_OBJECT,             // a collision object changed, as described by action
+      ATTACHED_BODY,            // a body was attached to or detached from the current state
+      ALLOWED_COLLISION_MATRIX  // the allowed collision matrix was modified or replaced
+    };
+
+    std::uint64_t version;                      // the change version of the scene after this change
+    Type type;
+    std::string id;                             // the object or attached body id, empty for the ACM
+    collision_detection::World::Action action;  // for WORLD_OBJECT changes
+    bool attached;                              // for ATTACHED_BODY changes
+  };
+
+  /** \brief Get the change version of this scene. It increases with every change recorded in the change journal. */
+  std::uint64_t getChangeVersion() const
+  {
+    return change_version_;
+  }
+
+  /** \brief Get the changes made to this scene since it had the change version \e version, in order. This lets
+   * consumers update incrementally instead of rebuilding from the whole scene. Changes of the robot's joint values
+   * are not recorded.
+   * @return False if the journal does not reach back to \e version (it is bounded, and clearDiffs() resets it), in
+   * which case the scene should be processed as a whole */
+  bool getChangesSince(std::uint64_t version, std::vector<SceneChange>& changes) const;
+
   bool hasObjectColor(const std::string& id) const;
 
   const std_msgs::ColorRGBA& getObjectColor(const std::string& id) const;
@@ -877,6 +988,17 @@ cylinder
       that scene may be. If there is no parent specified, this function is a no-op. */
   void pushDiffs(const PlanningScenePtr& scene);
 
+  /** \brief Record the content of this scene to return to it later with restoreCheckpoint(), e.g. to roll back
+   * speculative changes. The checkpoint is a diff of the same parent that shares the components this scene overrides,
+   * so creating and restoring it take time proportional to the changes with respect to the parent.
+   * @return The checkpoint, or NULL if this scene has no parent */
+  PlanningSceneConstPtr checkpoint() const;
+
+  /** \brief Return this scene to the content recorded by checkpoint(). As far as the change journal reaches back,
+   * only the world objects changed since the checkpoint are restored; otherwise the diffs are cleared first.
+   * @return False if \e checkpoint was not created by this scene */
+  bool restoreCheckpoint(const PlanningSceneConstPtr& checkpoint);
+
   /** \brief Make sure that all the data maintained in this
       scene is local. All unmodified data is copied from the
       parent and the pointer to the parent is discarded. */
@@ -911,6 +1033,20 @@ cylinder
     return motion_feasibility_;
   }
 
+  /** \brief Memoize the results of non-verbose collision checks and constraint evaluations in \e cache, or stop
+      memoizing if \e cache is empty. The cache is meant for the duration of a single planning query: it is not
+      passed on to diff() scenes and the caller must clear it whenever this scene changes. */
+  void setStateValidityCache(const StateValidityCachePtr& cache)
+  {
+    state_validity_cache_ = cache;
+  }
+
+  /** \brief Get the cache for the results of validity checks, if any */
+  const StateValidityCachePtr& getStateValidityCache() const
+  {
+    return state_validity_cache_;
+  }
+
   /** \brief Check if a given state is feasible, in accordance to the feasibility predicate specified by
    * setStateFeasibilityPredicate(). Returns true if no feasibility predicate was specified. */
   bool isStateFeasible(const moveit_msgs::RobotState& state, bool verbose = false) const;
@@ -1010,6 +1146,16 @@ cylinder
   bool isPathValid(const robot_trajectory::RobotTrajectory& trajectory, const std::string& group = "",
                    bool verbose = false, std::vector<std::size_t>* invalid_index = nullptr) const;
 
+  /** \brief Check if a given path is valid, distributing the waypoints over the worker threads configured in \e
+   * options. Each state is checked for validity (collision avoidance, feasibility and constraint satisfaction) and the
+   * last state is checked against the goal constraints. If \e invalid_index is nullptr, all workers stop as soon as
+   * one invalid waypoint is found; otherwise all waypoints are checked and the invalid ones are reported in ascending
+   * order. The state feasibility predicate, if set, must be safe to call concurrently. */
+  bool isPathValid(const robot_trajectory::RobotTrajectory& trajectory,
+                   const moveit_msgs::Constraints& path_constraints,
+                   const std::vector<moveit_msgs::Constraints>& goal_constraints, const PathValidityOptions& options,
+                   const std::string& group = "", std::vector<std::size_t>* invalid_index = nullptr) const;
+
   /** \brief Get the top \e max_costs cost sources for a specified trajectory. The resulting costs are stored in \e
    * costs */
   void getCostSources(const robot_trajectory::RobotTrajectory& trajectory, std::size_t max_costs,
@@ -1048,6 +1194,12 @@ cylinder
   /** \brief Clone a planning scene. Even if the scene \e scene depends on a parent, the cloned scene will not. */
   static PlanningScenePtr clone(const PlanningSceneConstPtr& scene);
 
+  /** \brief Clone a planning scene like clone(), but share the allowed collision matrix, object colors and object
+      types with \e scene until either scene modifies them. The world is shared object by object anyway.
+      References obtained from get*NonConst() functions of \e scene before the call must not be used to modify it
+      afterwards, since they may refer to shared data. */
+  static PlanningScenePtr shallowClone(const PlanningSceneConstPtr& scene);
+
 private:
   /* Private constructor used by the diff() methods. */
   PlanningScene(const PlanningSceneConstPtr& parent);
@@ -1060,11 +1212,30 @@ private:
   static moveit::core::RobotModelPtr createRobotModel(const urdf::ModelInterfaceSharedPtr& urdf_model,
                                                       const srdf::ModelConstSharedPtr& srdf_model);
 
+  /* Shapes and poses of a collision object message, constructed ahead of adding the object */
+  struct PreparedCollisionObject
+  {
+    EIGEN_MAKE_ALIGNED_OPERATOR_NEW
+
+    bool valid = false;
+    Eigen::Isometry3d pose;
+    std::vector<shapes::ShapeConstPtr> shapes;
+    EigenSTL::vector_Isometry3d shape_poses;
+  };
+
+  /* Process the collision objects in order. For messages with many objects, the shapes, meshes and collision checker
+   * data are constructed in parallel before the objects are added to the world one by one. */
+  bool processCollisionObjectMsgs(const std::vector<moveit_msgs::CollisionObject>& objects);
+
   /* Helper functions for processing collision objects */
-  bool processCollisionObjectAdd(const moveit_msgs::CollisionObject& object);
+  bool processCollisionObjectAdd(const moveit_msgs::CollisionObject& object,
+                                 const PreparedCollisionObject* prepared = nullptr);
   bool processCollisionObjectRemove(const moveit_msgs::CollisionObject& object);
   bool processCollisionObjectMove(const moveit_msgs::CollisionObject& object);
 
+  /* True if world object \e id differs from the one in the parent scene only by its pose */
+  bool isObjectPoseDiff(const std::string& id) const;
+
   /* For exporting and importing the planning scene */
   bool readPoseFromText(std::istream& in, Eigen::Isometry3d& pose) const;
   void writePoseToText(std::ostream& out, const Eigen::Isometry3d& pose) const;
@@ -1078,14 +1249,22 @@ private:
   struct CollisionDetector
   {
     collision_detection::CollisionDetectorAllocatorPtr alloc_;
-    collision_detection::CollisionEnvPtr cenv_;  // never NULL
-    collision_detection::CollisionEnvConstPtr cenv_const_;
+    mutable collision_detection::CollisionEnvPtr cenv_;  // never NULL once allocated
+    mutable collision_detection::CollisionEnvConstPtr cenv_const_;
 
-    collision_detection::CollisionEnvPtr cenv_unpadded_;
-    collision_detection::CollisionEnvConstPtr cenv_unpadded_const_;
+    mutable collision_detection::CollisionEnvPtr cenv_unpadded_;
+    mutable collision_detection::CollisionEnvConstPtr cenv_unpadded_const_;
 
     CollisionDetectorConstPtr parent_;  // may be NULL
 
+    // Scene whose world and active padding the environments are allocated for on first use, NULL once they are
+    // (inactive detectors of diff scenes)
+    mutable const PlanningScene* lazy_scene_ = nullptr;
+    mutable std::once_flag allocated_;
+
+    /** \brief Allocate the environments of a lazy detector, thread-safe */
+    void allocate() const;
+
     const collision_detection::CollisionEnvConstPtr& getCollisionEnv() const
     {
       return cenv_const_ ? cenv_const_ : parent_->getCollisionEnv();
@@ -1134,9 +1313,37 @@ private:
   StateFeasibilityFn state_feasibility_;
   MotionFeasibilityFn motion_feasibility_;
 
-  std::unique_ptr<ObjectColorMap> object_colors_;
+  StateValidityCachePtr state_validity_cache_;  // NULL unless results of validity checks are memoized
+
+  // the allowed collision matrix, the object colors and object types may be shared by shallowClone() and
+  // are copied before being modified if they are
+  std::shared_ptr<ObjectColorMap> object_colors_;
 
   // a map of object types
-  std::unique_ptr<ObjectTypeMap> object_types_;
+  std::shared_ptr<ObjectTypeMap> object_types_;
+
+  std::size_t max_diff_depth_;  // 0 for unlimited
+
+  void recordChange(SceneChange::Type type, const std::string& id,
+                    collision_detection::World::Action action = collision_detection::World::Action(),
+                    bool attached = false);
+  void invalidateChangeJournal();
+
+  // set the octomap world object to \e octree at pose \e t, as an update of the previous octree if the pose is the same
+  void replaceOctomap(const shapes::ShapeConstPtr& octree, const Eigen::Isometry3d& t);
+
+  // set the object \e object_id of world_ to its state in \e world, or remove it if \e world does not have it
+  void restoreWorldObject(const collision_detection::World& world, const std::string& object_id);
+  // install the journal's observers on world_ and robot_state_
+  void observeWorld();
+  void observeCurrentState();
+
+  std::deque<SceneChange> change_journal_;  // sorted by version
+  std::uint64_t change_version_;
+  std::uint64_t change_journal_start_;  // the oldest version the journal reports the changes since
+  collision_detection::World::ObserverHandle change_journal_observer_handle_;
+
+  const PlanningScene* checkpoint_source_;  // for checkpoints, the scene they were created of
+  std::uint64_t checkpoint_version_;        // for checkpoints, the change version of checkpoint_source_
 };
 }  // namespace planning_scene
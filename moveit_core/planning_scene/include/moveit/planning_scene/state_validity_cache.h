@@ -0,0 +1,143 @@
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2026, PickNik LLC.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of PickNik LLC nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *********************************************************************/
+
+#pragma once
+
+#include <moveit/robot_state/robot_state.h>
+#include <moveit/macros/class_forward.h>
+#include <ros/serialization.h>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <moveit/moveit_planning_scene_export.h>
+
+namespace planning_scene
+{
+MOVEIT_CLASS_FORWARD(StateValidityCache);  // Defines StateValidityCachePtr, ConstPtr, WeakPtr... etc
+
+/** \brief Memoizes results of validity checks (collision checks, constraint evaluations) for robot states.
+
+    States are identified by their joint values quantized to a resolution, together with a context that identifies
+    the check, such as a group name or a set of constraints. The cache is meant to live for one planning query,
+    while the planning scene does not change, so the adapters of a planning pipeline and the final path check do not
+    repeat work on the same states. It is safe to use from several threads; the entries are spread over independently
+    locked shards. */
+class MOVEIT_PLANNING_SCENE_EXPORT StateValidityCache
+{
+public:
+  /** \brief Constructor
+      \param resolution States whose joint values round to the same multiples of this resolution share entries
+      \param max_entries The cache is cleared when it holds more entries than this */
+  StateValidityCache(double resolution = 1e-9, std::size_t max_entries = 1000000);
+
+  StateValidityCache(const StateValidityCache&) = delete;
+  StateValidityCache& operator=(const StateValidityCache&) = delete;
+
+  /** \brief Look up the result of the check identified by \e context for \e state. Return false if it is not known. */
+  bool find(const moveit::core::RobotState& state, std::size_t context, bool& result) const;
+
+  /** \brief Store the result of the check identified by \e context for \e state */
+  void insert(const moveit::core::RobotState& state, std::size_t context, bool result);
+
+  /** \brief Remove all entries */
+  void clear();
+
+  /** \brief Get the number of stored results */
+  std::size_t size() const;
+
+  /** \brief Get the number of successful lookups */
+  std::size_t getHitCount() const
+  {
+    return hits_;
+  }
+
+  /** \brief Get the number of failed lookups */
+  std::size_t getMissCount() const
+  {
+    return misses_;
+  }
+
+  /** \brief Compute a context for a check identified by a string, e.g. a kind of check and a group name */
+  static std::size_t makeContext(const std::string& id);
+
+  /** \brief Compute a context for a check identified by the serialized content of a message */
+  template <typename Message>
+  static std::size_t makeContext(const std::string& id, const Message& msg)
+  {
+    std::string key(id);
+    key.resize(id.size() + ros::serialization::serializationLength(msg));
+    ros::serialization::OStream stream(reinterpret_cast<uint8_t*>(&key[id.size()]), key.size() - id.size());
+    ros::serialization::serialize(stream, msg);
+    return makeContext(key);
+  }
+
+private:
+  struct Key
+  {
+    std::size_t context;
+    std::vector<int64_t> values;
+
+    bool operator==(const Key& other) const
+    {
+      return context == other.context && values == other.values;
+    }
+  };
+
+  struct KeyHash
+  {
+    std::size_t operator()(const Key& key) const;
+  };
+
+  struct Shard
+  {
+    mutable std::mutex lock;
+    std::unordered_map<Key, bool, KeyHash> entries;
+  };
+
+  static const std::size_t SHARD_COUNT = 16;
+
+  Key makeKey(const moveit::core::RobotState& state, std::size_t context) const;
+
+  double inverse_resolution_;
+  std::size_t max_shard_entries_;
+  Shard shards_[SHARD_COUNT];
+  mutable std::atomic<std::size_t> hits_;
+  mutable std::atomic<std::size_t> misses_;
+};
+}  // namespace planning_scene
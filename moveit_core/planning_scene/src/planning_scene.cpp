@@ -37,6 +37,7 @@
 #include <boost/algorithm/string.hpp>
 #include <moveit/planning_scene/planning_scene.h>
 #include <moveit/collision_detection/occupancy_map.h>
+#include <moveit/collision_detection/geometry_cache.h>
 #include <moveit/collision_detection_fcl/collision_detector_allocator_fcl.h>
 #include <geometric_shapes/shape_operations.h>
 #include <moveit/collision_detection/collision_tools.h>
@@ -47,8 +48,11 @@
 #include <moveit/utils/message_checks.h>
 #include <octomap_msgs/conversions.h>
 #include <tf2_eigen/tf2_eigen.h>
+#include <algorithm>
+#include <atomic>
 #include <memory>
 #include <set>
+#include <thread>
 
 namespace planning_scene
 {
@@ -57,6 +61,22 @@ const std::string PlanningScene::DEFAULT_SCENE_NAME = "(noname)";
 
 const std::string LOGNAME = "planning_scene";
 
+// minimum number of added collision objects per thread for processing a message in parallel
+constexpr std::size_t PARALLEL_COLLISION_OBJECTS_MIN = 16;
+// number of changes kept in the change journal
+constexpr std::size_t MAX_CHANGE_JOURNAL_SIZE = 4096;
+
+namespace
+{
+// copy a component shared by shallowClone() before modifying it
+template <typename T>
+void makeUnique(std::shared_ptr<T>& component)
+{
+  if (component && component.use_count() > 1)
+    component = std::make_shared<T>(*component);
+}
+}  // namespace
+
 class SceneTransforms : public moveit::core::Transforms
 {
 public:
@@ -139,17 +159,26 @@ PlanningScene::~PlanningScene()
 {
   if (current_world_object_update_callback_)
     world_->removeObserver(current_world_object_update_observer_handle_);
+  world_->removeObserver(change_journal_observer_handle_);
 }
 
 void PlanningScene::initialize()
 {
   name_ = DEFAULT_SCENE_NAME;
+  max_diff_depth_ = 0;
+  change_version_ = change_journal_start_ = 0;
+  checkpoint_source_ = nullptr;
+  checkpoint_version_ = 0;
+  observeWorld();
 
   scene_transforms_ = std::make_shared<SceneTransforms>(this);
 
   robot_state_ = std::make_shared<moveit::core::RobotState>(robot_model_);
+  // the current state is copied for every planning request; let the copies share its transforms
+  robot_state_->setShareTransformsOnCopy(true);
   robot_state_->setToDefaultValues();
   robot_state_->update();
+  observeCurrentState();
 
   acm_ = std::make_shared<collision_detection::AllowedCollisionMatrix>(*getRobotModel()->getSRDF());
 
@@ -167,7 +196,13 @@ moveit::core::RobotModelPtr PlanningScene::createRobotModel(const urdf::ModelInt
   return robot_model;
 }
 
-PlanningScene::PlanningScene(const PlanningSceneConstPtr& parent) : parent_(parent)
+PlanningScene::PlanningScene(const PlanningSceneConstPtr& parent)
+  : parent_(parent)
+  , max_diff_depth_(parent ? parent->max_diff_depth_ : 0)
+  , change_version_(0)
+  , change_journal_start_(0)
+  , checkpoint_source_(nullptr)
+  , checkpoint_version_(0)
 {
   if (!parent_)
     throw moveit::ConstructException("NULL parent pointer for planning scene");
@@ -181,11 +216,12 @@ PlanningScene::PlanningScene(const PlanningSceneConstPtr& parent) : parent_(pare
   // info is shared until it is modified.
   world_ = std::make_shared<collision_detection::World>(*parent_->world_);
   world_const_ = world_;
+  observeWorld();
 
   // record changes to the world
   world_diff_ = std::make_shared<collision_detection::WorldDiff>(world_);
 
-  // Set up the same collision detectors as the parent
+  // Set up the same collision detectors as the parent, only allocating the active one right away
   for (const std::pair<const std::string, CollisionDetectorPtr>& it : parent_->collision_)
   {
     const CollisionDetectorPtr& parent_detector = it.second;
@@ -193,6 +229,11 @@ PlanningScene::PlanningScene(const PlanningSceneConstPtr& parent) : parent_(pare
     detector = std::make_shared<CollisionDetector>();
     detector->alloc_ = parent_detector->alloc_;
     detector->parent_ = parent_detector;
+    if (parent_detector != parent_->active_collision_)
+    {
+      detector->lazy_scene_ = this;
+      continue;
+    }
 
     detector->cenv_ = detector->alloc_->allocateEnv(parent_detector->cenv_, world_);
     detector->cenv_const_ = detector->cenv_;
@@ -205,7 +246,28 @@ PlanningScene::PlanningScene(const PlanningSceneConstPtr& parent) : parent_(pare
 
 PlanningScenePtr PlanningScene::clone(const PlanningSceneConstPtr& scene)
 {
-  PlanningScenePtr result = scene->diff();
+  // not using diff(), which may flatten the chain through clone() itself
+  PlanningScenePtr result(new PlanningScene(scene));
+  result->decoupleParent();
+  result->setName(scene->getName());
+  return result;
+}
+
+PlanningScenePtr PlanningScene::shallowClone(const PlanningSceneConstPtr& scene)
+{
+  PlanningScenePtr result(new PlanningScene(scene));
+
+  // share the components owned by the nearest scene in the chain, if no other scene contributes to them
+  const PlanningScene* owner = scene.get();
+  while (!owner->acm_)
+    owner = owner->parent_.get();
+  result->acm_ = owner->acm_;
+  if (!scene->parent_)
+  {
+    result->object_colors_ = scene->object_colors_;
+    result->object_types_ = scene->object_types_;
+  }
+
   result->decoupleParent();
   result->setName(scene->getName());
   return result;
@@ -213,9 +275,19 @@ PlanningScenePtr PlanningScene::clone(const PlanningSceneConstPtr& scene)
 
 PlanningScenePtr PlanningScene::diff() const
 {
+  if (max_diff_depth_ > 0 && getDiffDepth() >= max_diff_depth_)
+    return PlanningScenePtr(new PlanningScene(shallowClone(shared_from_this())));
   return PlanningScenePtr(new PlanningScene(shared_from_this()));
 }
 
+std::size_t PlanningScene::getDiffDepth() const
+{
+  std::size_t depth = 0;
+  for (const PlanningScene* scene = parent_.get(); scene; scene = scene->parent_.get())
+    ++depth;
+  return depth;
+}
+
 PlanningScenePtr PlanningScene::diff(const moveit_msgs::PlanningScene& msg) const
 {
   PlanningScenePtr result = diff();
@@ -223,8 +295,28 @@ PlanningScenePtr PlanningScene::diff(const moveit_msgs::PlanningScene& msg) cons
   return result;
 }
 
+void PlanningScene::CollisionDetector::allocate() const
+{
+  std::call_once(allocated_, [this] {
+    if (!lazy_scene_)
+      return;
+
+    // the world of the scene may differ from the one of the parent by now, so build the environments from scratch
+    const collision_detection::CollisionEnvConstPtr& active = lazy_scene_->getCollisionEnv();
+    cenv_ = alloc_->allocateEnv(lazy_scene_->world_, lazy_scene_->getRobotModel());
+    cenv_->setLinkPadding(active->getLinkPadding());
+    cenv_->setLinkScale(active->getLinkScale());
+    cenv_const_ = cenv_;
+    cenv_unpadded_ = alloc_->allocateEnv(lazy_scene_->world_, lazy_scene_->getRobotModel());
+    cenv_unpadded_const_ = cenv_unpadded_;
+    lazy_scene_ = nullptr;
+  });
+}
+
 void PlanningScene::CollisionDetector::copyPadding(const PlanningScene::CollisionDetector& src)
 {
+  if (lazy_scene_)
+    return;  // takes the padding of the active detector when allocated
   cenv_->setLinkPadding(src.getCollisionEnv()->getLinkPadding());
   cenv_->setLinkScale(src.getCollisionEnv()->getLinkScale());
 }
@@ -268,14 +360,9 @@ void PlanningScene::addCollisionDetector(const collision_detection::CollisionDet
   detector->cenv_ = detector->alloc_->allocateEnv(world_, getRobotModel());
   detector->cenv_const_ = detector->cenv_;
 
-  // if the current active detector is not the added one, copy its padding to the new one and allocate unpadded
+  // if the current active detector is not the added one, copy its padding to the new one
   if (detector != active_collision_)
-  {
-    detector->cenv_unpadded_ = detector->alloc_->allocateEnv(world_, getRobotModel());
-    detector->cenv_unpadded_const_ = detector->cenv_unpadded_;
-
     detector->copyPadding(*active_collision_);
-  }
 
   detector->cenv_unpadded_ = detector->alloc_->allocateEnv(world_, getRobotModel());
   detector->cenv_unpadded_const_ = detector->cenv_unpadded_;
@@ -296,6 +383,7 @@ void PlanningScene::setActiveCollisionDetector(const collision_detection::Collis
 
     if (p)
     {
+      p->allocate();
       collision_[allocator->getName()] = p;
       active_collision_ = p;
       return;
@@ -311,6 +399,7 @@ bool PlanningScene::setActiveCollisionDetector(const std::string& collision_dete
   CollisionDetectorIterator it = collision_.find(collision_detector_name);
   if (it != collision_.end())
   {
+    it->second->allocate();
     active_collision_ = it->second;
     return true;
   }
@@ -343,6 +432,7 @@ PlanningScene::getCollisionEnv(const std::string& collision_detector_name) const
     return active_collision_->getCollisionEnv();
   }
 
+  it->second->allocate();
   return it->second->getCollisionEnv();
 }
 
@@ -359,6 +449,7 @@ PlanningScene::getCollisionEnvUnpadded(const std::string& collision_detector_nam
     return active_collision_->getCollisionEnvUnpadded();
   }
 
+  it->second->allocate();
   return it->second->getCollisionEnvUnpadded();
 }
 
@@ -368,8 +459,11 @@ void PlanningScene::clearDiffs()
     return;
 
   // clear everything, reset the world, record diffs
+  world_->removeObserver(change_journal_observer_handle_);
   world_ = std::make_shared<collision_detection::World>(*parent_->world_);
   world_const_ = world_;
+  observeWorld();
+  invalidateChangeJournal();
   world_diff_ = std::make_shared<collision_detection::WorldDiff>(world_);
   if (current_world_object_update_callback_)
     current_world_object_update_observer_handle_ = world_->addObserver(current_world_object_update_callback_);
@@ -377,11 +471,15 @@ void PlanningScene::clearDiffs()
   // use parent crobot_ if it exists.  Otherwise copy padding from parent.
   for (std::pair<const std::string, CollisionDetectorPtr>& it : collision_)
   {
+    if (it.second->lazy_scene_)
+      continue;  // allocated for the reset world when first used
+
     if (!it.second->parent_)
       it.second->findParent(*this);
 
     if (it.second->parent_)
     {
+      it.second->parent_->allocate();
       it.second->cenv_unpadded_ = it.second->alloc_->allocateEnv(it.second->parent_->cenv_unpadded_, world_);
       it.second->cenv_unpadded_const_ = it.second->cenv_unpadded_;
 
@@ -459,6 +557,94 @@ void PlanningScene::pushDiffs(const PlanningScenePtr& scene)
   }
 }
 
+PlanningSceneConstPtr PlanningScene::checkpoint() const
+{
+  if (!parent_)
+  {
+    ROS_ERROR_NAMED(LOGNAME, "Checkpoints are only supported for planning scenes with a parent");
+    return PlanningSceneConstPtr();
+  }
+
+  PlanningScenePtr result(new PlanningScene(parent_));
+  result->checkpoint_source_ = this;
+  result->checkpoint_version_ = change_version_;
+
+  // world objects and the robot state are copied, all other components are copied before being modified
+  if (world_diff_)
+    for (const std::pair<const std::string, collision_detection::World::Action>& it : *world_diff_)
+      result->restoreWorldObject(*world_, it.first);
+  if (robot_state_)
+    result->getCurrentStateNonConst() = *robot_state_;
+  if (scene_transforms_)
+    result->getTransformsNonConst().setAllTransforms(scene_transforms_->getAllTransforms());
+  result->acm_ = acm_;
+  result->object_colors_ = object_colors_;
+  result->object_types_ = object_types_;
+
+  collision_detection::CollisionEnvPtr active_cenv = result->getCollisionEnvNonConst();
+  active_cenv->setLinkPadding(active_collision_->cenv_->getLinkPadding());
+  active_cenv->setLinkScale(active_collision_->cenv_->getLinkScale());
+  result->propogateRobotPadding();
+  return result;
+}
+
+bool PlanningScene::restoreCheckpoint(const PlanningSceneConstPtr& checkpoint)
+{
+  if (!checkpoint || checkpoint->checkpoint_source_ != this || checkpoint->parent_ != parent_)
+  {
+    ROS_ERROR_NAMED(LOGNAME, "Cannot restore a checkpoint that was not created of planning scene '%s'", name_.c_str());
+    return false;
+  }
+
+  std::vector<SceneChange> changes;
+  if (getChangesSince(checkpoint->checkpoint_version_, changes))
+  {
+    // the checkpoint's world holds the state at the checkpoint of all objects, modified or not
+    std::set<std::string> changed_objects;
+    for (const SceneChange& change : changes)
+      if (change.type == SceneChange::WORLD_OBJECT)
+        changed_objects.insert(change.id);
+    for (const std::string& object_id : changed_objects)
+      restoreWorldObject(*checkpoint->world_, object_id);
+  }
+  else
+  {
+    clearDiffs();
+    for (const std::pair<const std::string, collision_detection::World::Action>& it : *checkpoint->world_diff_)
+      restoreWorldObject(*checkpoint->world_, it.first);
+  }
+
+  getCurrentStateNonConst() = checkpoint->getCurrentState();
+  if (checkpoint->scene_transforms_)
+    getTransformsNonConst().setAllTransforms(checkpoint->scene_transforms_->getAllTransforms());
+  else
+    scene_transforms_.reset();
+  if (acm_ != checkpoint->acm_)
+  {
+    acm_ = checkpoint->acm_;
+    recordChange(SceneChange::ALLOWED_COLLISION_MATRIX, std::string());
+  }
+  object_colors_ = checkpoint->object_colors_;
+  object_types_ = checkpoint->object_types_;
+
+  collision_detection::CollisionEnvPtr active_cenv = getCollisionEnvNonConst();
+  active_cenv->setLinkPadding(checkpoint->active_collision_->cenv_->getLinkPadding());
+  active_cenv->setLinkScale(checkpoint->active_collision_->cenv_->getLinkScale());
+  propogateRobotPadding();
+  return true;
+}
+
+void PlanningScene::restoreWorldObject(const collision_detection::World& world, const std::string& object_id)
+{
+  collision_detection::World::ObjectConstPtr obj = world.getObject(object_id);
+  world_->removeObject(object_id);
+  if (obj)
+  {
+    world_->addToObject(obj->id_, obj->pose_, obj->shapes_, obj->shape_poses_);
+    world_->setSubframesOfObject(obj->id_, obj->subframe_poses_);
+  }
+}
+
 void PlanningScene::checkCollision(const collision_detection::CollisionRequest& req,
                                    collision_detection::CollisionResult& res)
 {
@@ -579,7 +765,7 @@ moveit::core::RobotState& PlanningScene::getCurrentStateNonConst()
   if (!robot_state_)
   {
     robot_state_ = std::make_shared<moveit::core::RobotState>(parent_->getCurrentState());
-    robot_state_->setAttachedBodyUpdateCallback(current_state_attached_body_callback_);
+    observeCurrentState();
   }
   robot_state_->update();
   return *robot_state_;
@@ -594,9 +780,8 @@ moveit::core::RobotStatePtr PlanningScene::getCurrentStateUpdated(const moveit_m
 
 void PlanningScene::setAttachedBodyUpdateCallback(const moveit::core::AttachedBodyCallback& callback)
 {
+  // called by the observer of robot_state_
   current_state_attached_body_callback_ = callback;
-  if (robot_state_)
-    robot_state_->setAttachedBodyUpdateCallback(callback);
 }
 
 void PlanningScene::setCollisionObjectUpdateCallback(const collision_detection::World::ObserverCallbackFn& callback)
@@ -608,10 +793,61 @@ void PlanningScene::setCollisionObjectUpdateCallback(const collision_detection::
   current_world_object_update_callback_ = callback;
 }
 
+bool PlanningScene::getChangesSince(std::uint64_t version, std::vector<SceneChange>& changes) const
+{
+  changes.clear();
+  if (version < change_journal_start_ || version > change_version_)
+    return false;
+  std::deque<SceneChange>::const_iterator it =
+      std::upper_bound(change_journal_.begin(), change_journal_.end(), version,
+                       [](std::uint64_t version, const SceneChange& change) { return version < change.version; });
+  changes.assign(it, change_journal_.end());
+  return true;
+}
+
+void PlanningScene::recordChange(SceneChange::Type type, const std::string& id,
+                                 collision_detection::World::Action action, bool attached)
+{
+  change_journal_.push_back(SceneChange{ ++change_version_, type, id, action, attached });
+  if (change_journal_.size() > MAX_CHANGE_JOURNAL_SIZE)
+  {
+    change_journal_start_ = change_journal_.front().version;
+    change_journal_.pop_front();
+  }
+}
+
+void PlanningScene::invalidateChangeJournal()
+{
+  change_journal_.clear();
+  change_journal_start_ = ++change_version_;
+}
+
+void PlanningScene::observeWorld()
+{
+  change_journal_observer_handle_ =
+      world_->addObserver([this](const collision_detection::World::ObjectConstPtr& object,
+                                 collision_detection::World::Action action) {
+        recordChange(SceneChange::WORLD_OBJECT, object->id_, action);
+      });
+}
+
+void PlanningScene::observeCurrentState()
+{
+  robot_state_->setAttachedBodyUpdateCallback([this](moveit::core::AttachedBody* body, bool attached) {
+    recordChange(SceneChange::ATTACHED_BODY, body->getName(), collision_detection::World::Action(), attached);
+    if (current_state_attached_body_callback_)
+      current_state_attached_body_callback_(body, attached);
+  });
+}
+
 collision_detection::AllowedCollisionMatrix& PlanningScene::getAllowedCollisionMatrixNonConst()
 {
+  // the matrix may be modified through the returned reference
+  recordChange(SceneChange::ALLOWED_COLLISION_MATRIX, std::string());
   if (!acm_)
     acm_ = std::make_shared<collision_detection::AllowedCollisionMatrix>(parent_->getAllowedCollisionMatrix());
+  else
+    makeUnique(acm_);
   return *acm_;
 }
 
@@ -636,6 +872,70 @@ moveit::core::Transforms& PlanningScene::getTransformsNonConst()
   return *scene_transforms_;
 }
 
+namespace
+{
+bool sameShape(const shapes::Shape& a, const shapes::Shape& b)
+{
+  if (&a == &b)
+    return true;
+  if (a.type != b.type)
+    return false;
+  switch (a.type)
+  {
+    case shapes::SPHERE:
+      return static_cast<const shapes::Sphere&>(a).radius == static_cast<const shapes::Sphere&>(b).radius;
+    case shapes::CYLINDER:
+      return static_cast<const shapes::Cylinder&>(a).radius == static_cast<const shapes::Cylinder&>(b).radius &&
+             static_cast<const shapes::Cylinder&>(a).length == static_cast<const shapes::Cylinder&>(b).length;
+    case shapes::CONE:
+      return static_cast<const shapes::Cone&>(a).radius == static_cast<const shapes::Cone&>(b).radius &&
+             static_cast<const shapes::Cone&>(a).length == static_cast<const shapes::Cone&>(b).length;
+    case shapes::BOX:
+      return std::equal(static_cast<const shapes::Box&>(a).size, static_cast<const shapes::Box&>(a).size + 3,
+                        static_cast<const shapes::Box&>(b).size);
+    case shapes::PLANE:
+    {
+      const shapes::Plane& pa = static_cast<const shapes::Plane&>(a);
+      const shapes::Plane& pb = static_cast<const shapes::Plane&>(b);
+      return pa.a == pb.a && pa.b == pb.b && pa.c == pb.c && pa.d == pb.d;
+    }
+    case shapes::MESH:
+    {
+      // meshes are usually interned by the world, so equal meshes share their instance and are caught above
+      const shapes::Mesh& ma = static_cast<const shapes::Mesh&>(a);
+      const shapes::Mesh& mb = static_cast<const shapes::Mesh&>(b);
+      return ma.vertex_count == mb.vertex_count && ma.triangle_count == mb.triangle_count &&
+             collision_detection::GeometryCache::computeMeshHash(ma) ==
+                 collision_detection::GeometryCache::computeMeshHash(mb);
+    }
+    default:
+      // octrees are only compared by identity
+      return false;
+  }
+}
+
+/** \brief True if \e object differs from \e parent_object only by its pose, i.e. a MOVE operation suffices to
+    bring a subscriber holding \e parent_object up to date */
+bool onlyObjectPoseChanged(const collision_detection::World::Object& object,
+                           const collision_detection::World::Object& parent_object)
+{
+  if (object.shapes_.size() != parent_object.shapes_.size() ||
+      object.subframe_poses_.size() != parent_object.subframe_poses_.size())
+    return false;
+  for (std::size_t i = 0; i < object.shapes_.size(); ++i)
+    if (!sameShape(*object.shapes_[i], *parent_object.shapes_[i]) ||
+        !object.shape_poses_[i].isApprox(parent_object.shape_poses_[i]))
+      return false;
+  for (const auto& subframe : object.subframe_poses_)
+  {
+    auto it = parent_object.subframe_poses_.find(subframe.first);
+    if (it == parent_object.subframe_poses_.end() || !it->second.isApprox(subframe.second))
+      return false;
+  }
+  return true;
+}
+}  // namespace
+
 void PlanningScene::getPlanningSceneDiffMsg(moveit_msgs::PlanningScene& scene_msg) const
 {
   scene_msg.name = name_;
@@ -700,6 +1000,16 @@ void PlanningScene::getPlanningSceneDiffMsg(moveit_msgs::PlanningScene& scene_ms
           scene_msg.world.collision_objects.push_back(co);
         }
       }
+      else if (isObjectPoseDiff(it.first))
+      {
+        // the geometry is known to subscribers already, only send the new pose
+        moveit_msgs::CollisionObject co;
+        co.header.frame_id = getPlanningFrame();
+        co.id = it.first;
+        co.operation = moveit_msgs::CollisionObject::MOVE;
+        co.pose = tf2::toMsg(world_->getObject(it.first)->pose_);
+        scene_msg.world.collision_objects.push_back(co);
+      }
       else
       {
         scene_msg.world.collision_objects.emplace_back();
@@ -763,6 +1073,27 @@ private:
 };
 }  // namespace
 
+bool PlanningScene::isObjectPoseDiff(const std::string& id) const
+{
+  if (!parent_)
+    return false;
+  collision_detection::World::ObjectConstPtr obj = world_->getObject(id);
+  collision_detection::World::ObjectConstPtr parent_obj = parent_->getWorld()->getObject(id);
+  if (!obj || !parent_obj || !onlyObjectPoseChanged(*obj, *parent_obj))
+    return false;
+
+  // the object type is only sent along with the geometry
+  if (hasObjectType(id) != parent_->hasObjectType(id))
+    return false;
+  if (hasObjectType(id))
+  {
+    const object_recognition_msgs::ObjectType& type = getObjectType(id);
+    const object_recognition_msgs::ObjectType& parent_type = parent_->getObjectType(id);
+    return type.key == parent_type.key && type.db == parent_type.db;
+  }
+  return true;
+}
+
 bool PlanningScene::getCollisionObjectMsg(moveit_msgs::CollisionObject& collision_obj, const std::string& ns) const
 {
   collision_detection::CollisionEnv::ObjectConstPtr obj = world_->getObject(ns);
@@ -1171,7 +1502,7 @@ void PlanningScene::setCurrentState(const moveit_msgs::RobotState& state)
     if (!robot_state_)
     {
       robot_state_ = std::make_shared<moveit::core::RobotState>(parent_->getCurrentState());
-      robot_state_->setAttachedBodyUpdateCallback(current_state_attached_body_callback_);
+      observeCurrentState();
     }
     moveit::core::robotStateMsgToRobotState(getTransforms(), state_no_attached, *robot_state_);
   }
@@ -1212,7 +1543,7 @@ void PlanningScene::decoupleParent()
   if (!robot_state_)
   {
     robot_state_ = std::make_shared<moveit::core::RobotState>(parent_->getCurrentState());
-    robot_state_->setAttachedBodyUpdateCallback(current_state_attached_body_callback_);
+    observeCurrentState();
   }
 
   if (!acm_)
@@ -1228,7 +1559,7 @@ void PlanningScene::decoupleParent()
   {
     ObjectColorMap kc;
     parent_->getKnownObjectColors(kc);
-    object_colors_ = std::make_unique<ObjectColorMap>(kc);
+    object_colors_ = std::make_shared<ObjectColorMap>(kc);
   }
   else
   {
@@ -1236,14 +1567,17 @@ void PlanningScene::decoupleParent()
     parent_->getKnownObjectColors(kc);
     for (ObjectColorMap::const_iterator it = kc.begin(); it != kc.end(); ++it)
       if (object_colors_->find(it->first) == object_colors_->end())
+      {
+        makeUnique(object_colors_);
         (*object_colors_)[it->first] = it->second;
+      }
   }
 
   if (!object_types_)
   {
     ObjectTypeMap kc;
     parent_->getKnownObjectTypes(kc);
-    object_types_ = std::make_unique<ObjectTypeMap>(kc);
+    object_types_ = std::make_shared<ObjectTypeMap>(kc);
   }
   else
   {
@@ -1251,7 +1585,10 @@ void PlanningScene::decoupleParent()
     parent_->getKnownObjectTypes(kc);
     for (ObjectTypeMap::const_iterator it = kc.begin(); it != kc.end(); ++it)
       if (object_types_->find(it->first) == object_types_->end())
+      {
+        makeUnique(object_types_);
         (*object_types_)[it->first] = it->second;
+      }
   }
 
   parent_.reset();
@@ -1285,12 +1622,17 @@ bool PlanningScene::setPlanningSceneDiffMsg(const moveit_msgs::PlanningScene& sc
 
   // if at least some links are mentioned in the allowed collision matrix, then we have an update
   if (!scene_msg.allowed_collision_matrix.entry_names.empty())
+  {
     acm_ = std::make_shared<collision_detection::AllowedCollisionMatrix>(scene_msg.allowed_collision_matrix);
+    recordChange(SceneChange::ALLOWED_COLLISION_MATRIX, std::string());
+  }
 
   if (!scene_msg.link_padding.empty() || !scene_msg.link_scale.empty())
   {
     for (std::pair<const std::string, CollisionDetectorPtr>& it : collision_)
     {
+      if (it.second->lazy_scene_)
+        continue;  // takes the padding of the active detector when allocated
       it.second->cenv_->setPadding(scene_msg.link_padding);
       it.second->cenv_->setScale(scene_msg.link_scale);
     }
@@ -1301,8 +1643,7 @@ bool PlanningScene::setPlanningSceneDiffMsg(const moveit_msgs::PlanningScene& sc
     setObjectColor(object_color.id, object_color.color);
 
   // process collision object updates
-  for (const moveit_msgs::CollisionObject& collision_object : scene_msg.world.collision_objects)
-    result &= processCollisionObjectMsg(collision_object);
+  result &= processCollisionObjectMsgs(scene_msg.world.collision_objects);
 
   // if an octomap was specified, replace the one we have with that one
   if (!scene_msg.world.octomap.octomap.data.empty())
@@ -1327,12 +1668,15 @@ bool PlanningScene::setPlanningSceneMsg(const moveit_msgs::PlanningScene& scene_
   scene_transforms_->setTransforms(scene_msg.fixed_frame_transforms);
   setCurrentState(scene_msg.robot_state);
   acm_ = std::make_shared<collision_detection::AllowedCollisionMatrix>(scene_msg.allowed_collision_matrix);
+  recordChange(SceneChange::ALLOWED_COLLISION_MATRIX, std::string());
   for (std::pair<const std::string, CollisionDetectorPtr>& it : collision_)
   {
+    if (it.second->lazy_scene_)
+      continue;
     it.second->cenv_->setPadding(scene_msg.link_padding);
     it.second->cenv_->setScale(scene_msg.link_scale);
   }
-  object_colors_ = std::make_unique<ObjectColorMap>();
+  object_colors_ = std::make_shared<ObjectColorMap>();
   for (const moveit_msgs::ObjectColor& object_color : scene_msg.object_colors)
     setObjectColor(object_color.id, object_color.color);
   world_->clearObjects();
@@ -1341,13 +1685,64 @@ bool PlanningScene::setPlanningSceneMsg(const moveit_msgs::PlanningScene& scene_
 
 bool PlanningScene::processPlanningSceneWorldMsg(const moveit_msgs::PlanningSceneWorld& world)
 {
-  bool result = true;
-  for (const moveit_msgs::CollisionObject& collision_object : world.collision_objects)
-    result &= processCollisionObjectMsg(collision_object);
+  bool result = processCollisionObjectMsgs(world.collision_objects);
   processOctomapMsg(world.octomap);
   return result;
 }
 
+bool PlanningScene::processCollisionObjectMsgs(const std::vector<moveit_msgs::CollisionObject>& objects)
+{
+  auto is_add = [](const moveit_msgs::CollisionObject& object) {
+    return object.id != OCTOMAP_NS && (object.operation == moveit_msgs::CollisionObject::ADD ||
+                                       object.operation == moveit_msgs::CollisionObject::APPEND);
+  };
+  const std::size_t adds = std::count_if(objects.begin(), objects.end(), is_add);
+  const unsigned int threads =
+      std::min<std::size_t>(std::thread::hardware_concurrency(), adds / PARALLEL_COLLISION_OBJECTS_MIN);
+
+  bool result = true;
+  if (threads < 2)
+  {
+    for (const moveit_msgs::CollisionObject& collision_object : objects)
+      result &= processCollisionObjectMsg(collision_object);
+    return result;
+  }
+
+  // construct shapes, meshes and collision checker data in parallel; neither needs the world
+  std::vector<PreparedCollisionObject, Eigen::aligned_allocator<PreparedCollisionObject>> prepared(objects.size());
+  std::atomic<std::size_t> next(0);
+  auto worker = [&]() {
+    for (std::size_t i = next++; i < objects.size(); i = next++)
+    {
+      const moveit_msgs::CollisionObject& object = objects[i];
+      if (!is_add(object) || (object.primitives.empty() && object.meshes.empty() && object.planes.empty()))
+        continue;
+      PreparedCollisionObject& p = prepared[i];
+      p.valid = shapesAndPosesFromCollisionObjectMessage(object, p.pose, p.shapes, p.shape_poses);
+      if (!p.valid)
+        continue;
+      for (shapes::ShapeConstPtr& shape : p.shapes)
+        shape = collision_detection::GeometryCache::getGlobal().intern(shape);
+      for (const std::pair<const std::string, CollisionDetectorPtr>& it : collision_)
+        if (!it.second->lazy_scene_)
+          it.second->cenv_->prepareWorldShapes(p.shapes);
+    }
+  };
+  std::vector<std::thread> workers;
+  workers.reserve(threads - 1);
+  for (unsigned int t = 1; t < threads; ++t)
+    workers.emplace_back(worker);
+  worker();
+  for (std::thread& thread : workers)
+    thread.join();
+
+  // the world is updated in message order
+  for (std::size_t i = 0; i < objects.size(); ++i)
+    result &= is_add(objects[i]) ? processCollisionObjectAdd(objects[i], &prepared[i]) :
+                                   processCollisionObjectMsg(objects[i]);
+  return result;
+}
+
 bool PlanningScene::usePlanningSceneMsg(const moveit_msgs::PlanningScene& scene_msg)
 {
   if (scene_msg.is_diff)
@@ -1379,14 +1774,16 @@ collision_detection::OccMapTreePtr createOctomap(const octomap_msgs::Octomap& ma
 void PlanningScene::processOctomapMsg(const octomap_msgs::Octomap& map)
 {
   // each octomap replaces any previous one
-  world_->removeObject(OCTOMAP_NS);
-
   if (map.data.empty())
+  {
+    world_->removeObject(OCTOMAP_NS);
     return;
+  }
 
   if (map.id != "OcTree")
   {
     ROS_ERROR_NAMED(LOGNAME, "Received octomap is of type '%s' but type 'OcTree' is expected.", map.id.c_str());
+    world_->removeObject(OCTOMAP_NS);
     return;
   }
 
@@ -1394,11 +1791,11 @@ void PlanningScene::processOctomapMsg(const octomap_msgs::Octomap& map)
   if (!map.header.frame_id.empty())
   {
     const Eigen::Isometry3d& t = getFrameTransform(map.header.frame_id);
-    world_->addToObject(OCTOMAP_NS, shapes::ShapeConstPtr(new shapes::OcTree(om)), t);
+    replaceOctomap(shapes::ShapeConstPtr(new shapes::OcTree(om)), t);
   }
   else
   {
-    world_->addToObject(OCTOMAP_NS, shapes::ShapeConstPtr(new shapes::OcTree(om)), Eigen::Isometry3d::Identity());
+    replaceOctomap(shapes::ShapeConstPtr(new shapes::OcTree(om)), Eigen::Isometry3d::Identity());
   }
 }
 
@@ -1417,14 +1814,16 @@ void PlanningScene::removeAllCollisionObjects()
 void PlanningScene::processOctomapMsg(const octomap_msgs::OctomapWithPose& map)
 {
   // each octomap replaces any previous one
-  world_->removeObject(OCTOMAP_NS);
-
   if (map.octomap.data.empty())
+  {
+    world_->removeObject(OCTOMAP_NS);
     return;
+  }
 
   if (map.octomap.id != "OcTree")
   {
     ROS_ERROR_NAMED(LOGNAME, "Received octomap is of type '%s' but type 'OcTree' is expected.", map.octomap.id.c_str());
+    world_->removeObject(OCTOMAP_NS);
     return;
   }
 
@@ -1434,7 +1833,24 @@ void PlanningScene::processOctomapMsg(const octomap_msgs::OctomapWithPose& map)
   Eigen::Isometry3d p;
   PlanningScene::poseMsgToEigen(map.origin, p);
   p = t * p;
-  world_->addToObject(OCTOMAP_NS, shapes::ShapeConstPtr(new shapes::OcTree(om)), p);
+  replaceOctomap(shapes::ShapeConstPtr(new shapes::OcTree(om)), p);
+}
+
+void PlanningScene::replaceOctomap(const shapes::ShapeConstPtr& octree, const Eigen::Isometry3d& t)
+{
+  // an octomap at the same pose is a new version of the previous one, which collision environments can apply
+  // incrementally instead of rebuilding their representation of the octomap
+  collision_detection::CollisionEnv::ObjectConstPtr map = world_->getObject(OCTOMAP_NS);
+  if (map && map->shapes_.size() == 1 && map->shapes_[0]->type == shapes::OCTREE &&
+      map->shape_poses_[0].isApprox(t, std::numeric_limits<double>::epsilon() * 100.0))
+  {
+    map.reset();  // reset this pointer first so that caching optimizations can be used in CollisionWorld
+    world_->updateShapeInObject(OCTOMAP_NS, 0, octree);
+    return;
+  }
+
+  world_->removeObject(OCTOMAP_NS);
+  world_->addToObject(OCTOMAP_NS, octree, t);
 }
 
 void PlanningScene::processOctomapPtr(const std::shared_ptr<const octomap::OcTree>& octree, const Eigen::Isometry3d& t)
@@ -1451,6 +1867,10 @@ void PlanningScene::processOctomapPtr(const std::shared_ptr<const octomap::OcTre
         // if the pose changed, we update it
         if (map->shape_poses_[0].isApprox(t, std::numeric_limits<double>::epsilon() * 100.0))
         {
+          // the octree was modified in place, collision environments can update incrementally
+          shapes::ShapeConstPtr shape = map->shapes_[0];
+          map.reset();
+          world_->updateShapeInObject(OCTOMAP_NS, 0, shape);
           if (world_diff_)
             world_diff_->set(OCTOMAP_NS, collision_detection::World::DESTROY | collision_detection::World::CREATE |
                                              collision_detection::World::ADD_SHAPE);
@@ -1487,7 +1907,7 @@ bool PlanningScene::processAttachedCollisionObjectMsg(const moveit_msgs::Attache
   if (!robot_state_)  // there must be a parent in this case
   {
     robot_state_ = std::make_shared<moveit::core::RobotState>(parent_->getCurrentState());
-    robot_state_->setAttachedBodyUpdateCallback(current_state_attached_body_callback_);
+    observeCurrentState();
   }
   robot_state_->update();
 
@@ -1808,7 +2228,8 @@ bool PlanningScene::shapesAndPosesFromCollisionObjectMessage(const moveit_msgs::
   return true;
 }
 
-bool PlanningScene::processCollisionObjectAdd(const moveit_msgs::CollisionObject& object)
+bool PlanningScene::processCollisionObjectAdd(const moveit_msgs::CollisionObject& object,
+                                              const PreparedCollisionObject* prepared)
 {
   if (!knowsFrameTransform(object.header.frame_id))
   {
@@ -1827,14 +2248,24 @@ bool PlanningScene::processCollisionObjectAdd(const moveit_msgs::CollisionObject
     world_->removeObject(object.id);
 
   const Eigen::Isometry3d& world_to_object_header_transform = getFrameTransform(object.header.frame_id);
-  Eigen::Isometry3d header_to_pose_transform;
-  std::vector<shapes::ShapeConstPtr> shapes;
-  EigenSTL::vector_Isometry3d shape_poses;
-  if (!shapesAndPosesFromCollisionObjectMessage(object, header_to_pose_transform, shapes, shape_poses))
-    return false;
-  const Eigen::Isometry3d object_frame_transform = world_to_object_header_transform * header_to_pose_transform;
+  if (prepared)
+  {
+    if (!prepared->valid)
+      return false;
+    world_->addToObject(object.id, world_to_object_header_transform * prepared->pose, prepared->shapes,
+                        prepared->shape_poses);
+  }
+  else
+  {
+    Eigen::Isometry3d header_to_pose_transform;
+    std::vector<shapes::ShapeConstPtr> shapes;
+    EigenSTL::vector_Isometry3d shape_poses;
+    if (!shapesAndPosesFromCollisionObjectMessage(object, header_to_pose_transform, shapes, shape_poses))
+      return false;
+    const Eigen::Isometry3d object_frame_transform = world_to_object_header_transform * header_to_pose_transform;
 
-  world_->addToObject(object.id, object_frame_transform, shapes, shape_poses);
+    world_->addToObject(object.id, object_frame_transform, shapes, shape_poses);
+  }
 
   if (!object.type.key.empty() || !object.type.db.empty())
     setObjectType(object.id, object.type);
@@ -1926,6 +2357,51 @@ const Eigen::Isometry3d& PlanningScene::getFrameTransform(const moveit::core::Ro
   return getTransforms().Transforms::getTransform(frame_id);
 }
 
+PlanningScene::FrameHandle PlanningScene::resolveFrame(const std::string& frame_id) const
+{
+  FrameHandle handle;
+  handle.id = !frame_id.empty() && frame_id[0] == '/' ? frame_id.substr(1) : frame_id;
+
+  // same precedence as getFrameTransform(): the model frame, robot links, attached bodies and world objects, then the
+  // fixed frames
+  bool found = false;
+  if (handle.id != getRobotModel()->getModelFrame())
+  {
+    handle.link = getRobotModel()->getLinkModel(handle.id, &found);
+    if (found)
+      return handle;
+    if (getCurrentState().knowsFrameTransform(handle.id) || getWorld()->knowsTransform(handle.id))
+      return handle;
+  }
+  handle.fixed_frame = getTransforms().getFrameHandle(handle.id);
+  if (handle.fixed_frame != moveit::core::Transforms::INVALID_FRAME_HANDLE)
+    handle.transforms = &getTransforms();
+  return handle;
+}
+
+const Eigen::Isometry3d& PlanningScene::getFrameTransform(const moveit::core::RobotState& state,
+                                                          const FrameHandle& handle) const
+{
+  if (handle.link)
+    return state.getGlobalLinkTransform(handle.link);
+  // fixed frame handles are specific to the Transforms they were resolved with
+  if (handle.transforms == &getTransforms() && handle.transforms->canTransform(handle.fixed_frame))
+    return handle.transforms->getTransform(handle.fixed_frame);
+  return getFrameTransform(state, handle.id);
+}
+
+std::vector<std::string> PlanningScene::getWorldObjectIdsNearLink(const moveit::core::RobotState& state,
+                                                                 const std::string& link_name, double distance) const
+{
+  const moveit::core::LinkModel* link = getRobotModel()->getLinkModel(link_name);
+  if (!link)
+    return std::vector<std::string>();
+
+  const Eigen::Isometry3d pose =
+      state.getGlobalLinkTransform(link) * Eigen::Translation3d(link->getCenteredBoundingBoxOffset());
+  return getWorld()->getObjectIdsNearBox(pose, link->getShapeExtentsAtOrigin(), distance);
+}
+
 bool PlanningScene::knowsFrameTransform(const std::string& frame_id) const
 {
   return knowsFrameTransform(getCurrentState(), frame_id);
@@ -1970,14 +2446,19 @@ const object_recognition_msgs::ObjectType& PlanningScene::getObjectType(const st
 void PlanningScene::setObjectType(const std::string& object_id, const object_recognition_msgs::ObjectType& type)
 {
   if (!object_types_)
-    object_types_ = std::make_unique<ObjectTypeMap>();
+    object_types_ = std::make_shared<ObjectTypeMap>();
+  else
+    makeUnique(object_types_);
   (*object_types_)[object_id] = type;
 }
 
 void PlanningScene::removeObjectType(const std::string& object_id)
 {
-  if (object_types_)
+  if (object_types_ && object_types_->count(object_id))
+  {
+    makeUnique(object_types_);
     object_types_->erase(object_id);
+  }
 }
 
 void PlanningScene::getKnownObjectTypes(ObjectTypeMap& kc) const
@@ -2032,14 +2513,19 @@ void PlanningScene::setObjectColor(const std::string& object_id, const std_msgs:
     return;
   }
   if (!object_colors_)
-    object_colors_ = std::make_unique<ObjectColorMap>();
+    object_colors_ = std::make_shared<ObjectColorMap>();
+  else
+    makeUnique(object_colors_);
   (*object_colors_)[object_id] = color;
 }
 
 void PlanningScene::removeObjectColor(const std::string& object_id)
 {
-  if (object_colors_)
+  if (object_colors_ && object_colors_->count(object_id))
+  {
+    makeUnique(object_colors_);
     object_colors_->erase(object_id);
+  }
 }
 
 bool PlanningScene::isStateColliding(const moveit_msgs::RobotState& state, const std::string& group, bool verbose) const
@@ -2059,6 +2545,26 @@ bool PlanningScene::isStateColliding(const std::string& group, bool verbose)
 
 bool PlanningScene::isStateColliding(const moveit::core::RobotState& state, const std::string& group, bool verbose) const
 {
+  if (!verbose)
+  {
+    std::size_t context = 0;
+    bool colliding;
+    if (state_validity_cache_)
+    {
+      context = StateValidityCache::makeContext("collision/" + group);
+      if (state_validity_cache_->find(state, context, colliding))
+        return colliding;
+    }
+
+    // binary checks, same environments as in checkCollision()
+    const collision_detection::AllowedCollisionMatrix& acm = getAllowedCollisionMatrix();
+    colliding = getCollisionEnv()->isRobotColliding(state, acm, group) ||
+                getCollisionEnvUnpadded()->isSelfColliding(state, acm, group);
+    if (state_validity_cache_)
+      state_validity_cache_->insert(state, context, colliding);
+    return colliding;
+  }
+
   collision_detection::CollisionRequest req;
   req.verbose = verbose;
   req.group_name = group;
@@ -2067,6 +2573,28 @@ bool PlanningScene::isStateColliding(const moveit::core::RobotState& state, cons
   return res.collision;
 }
 
+void PlanningScene::isStateColliding(const std::vector<const moveit::core::RobotState*>& states,
+                                     std::vector<bool>& colliding, const std::string& group, unsigned int threads) const
+{
+  // same environments as in checkCollision(): the world check is padded, the self check is not
+  const collision_detection::AllowedCollisionMatrix& acm = getAllowedCollisionMatrix();
+  getCollisionEnv()->isRobotColliding(states, acm, colliding, group, threads);
+
+  // only states that are not in collision with the world need a self collision check
+  std::vector<const moveit::core::RobotState*> remaining;
+  std::vector<std::size_t> remaining_index;
+  for (std::size_t i = 0; i < states.size(); ++i)
+    if (!colliding[i])
+    {
+      remaining.push_back(states[i]);
+      remaining_index.push_back(i);
+    }
+  std::vector<bool> self_colliding;
+  getCollisionEnvUnpadded()->isSelfColliding(remaining, acm, self_colliding, group, threads);
+  for (std::size_t i = 0; i < remaining.size(); ++i)
+    colliding[remaining_index[i]] = self_colliding[i];
+}
+
 bool PlanningScene::isStateFeasible(const moveit_msgs::RobotState& state, bool verbose) const
 {
   if (state_feasibility_)
@@ -2096,13 +2624,23 @@ bool PlanningScene::isStateConstrained(const moveit_msgs::RobotState& state, con
 bool PlanningScene::isStateConstrained(const moveit::core::RobotState& state, const moveit_msgs::Constraints& constr,
                                        bool verbose) const
 {
+  // a cache hit also saves constructing the constraints
+  std::size_t context = 0;
+  bool satisfied;
+  if (state_validity_cache_ && !verbose)
+  {
+    context = StateValidityCache::makeContext("constraints", constr);
+    if (state_validity_cache_->find(state, context, satisfied))
+      return satisfied;
+  }
+
   kinematic_constraints::KinematicConstraintSetPtr ks(
       new kinematic_constraints::KinematicConstraintSet(getRobotModel()));
   ks->add(constr, getTransforms());
-  if (ks->empty())
-    return true;
-  else
-    return isStateConstrained(state, *ks, verbose);
+  satisfied = ks->empty() || isStateConstrained(state, *ks, verbose);
+  if (state_validity_cache_ && !verbose)
+    state_validity_cache_->insert(state, context, satisfied);
+  return satisfied;
 }
 
 bool PlanningScene::isStateConstrained(const moveit_msgs::RobotState& state,
@@ -2212,16 +2750,42 @@ bool PlanningScene::isPathValid(const robot_trajectory::RobotTrajectory& traject
   kinematic_constraints::KinematicConstraintSet ks_p(getRobotModel());
   ks_p.add(path_constraints, getTransforms());
   std::size_t n_wp = trajectory.getWayPointCount();
+
+  // path constraint results are shared with isStateConstrained() through the cache, if there is one
+  const bool use_cache = state_validity_cache_ && !verbose && !ks_p.empty();
+  const std::size_t path_context = use_cache ? StateValidityCache::makeContext("constraints", path_constraints) : 0;
+  const auto satisfies_path_constraints = [&](const moveit::core::RobotState& st) {
+    if (ks_p.empty())
+      return true;
+    bool satisfied;
+    if (use_cache && state_validity_cache_->find(st, path_context, satisfied))
+      return satisfied;
+    satisfied = ks_p.decide(st, verbose).satisfied;
+    if (use_cache)
+      state_validity_cache_->insert(st, path_context, satisfied);
+    return satisfied;
+  };
+
+  // all waypoints are checked if the invalid ones are requested, so check them for collisions in one batch
+  std::vector<bool> colliding;
+  if (invalid_index && !verbose)
+  {
+    std::vector<const moveit::core::RobotState*> waypoints(n_wp);
+    for (std::size_t i = 0; i < n_wp; ++i)
+      waypoints[i] = &trajectory.getWayPoint(i);
+    isStateColliding(waypoints, colliding, group);
+  }
+
   for (std::size_t i = 0; i < n_wp; ++i)
   {
     const moveit::core::RobotState& st = trajectory.getWayPoint(i);
 
     bool this_state_valid = true;
-    if (isStateColliding(st, group, verbose))
+    if (colliding.empty() ? isStateColliding(st, group, verbose) : colliding[i])
       this_state_valid = false;
     if (!isStateFeasible(st, verbose))
       this_state_valid = false;
-    if (!ks_p.empty() && !ks_p.decide(st, verbose).satisfied)
+    if (!satisfies_path_constraints(st))
       this_state_valid = false;
 
     if (!this_state_valid)
@@ -2283,6 +2847,106 @@ bool PlanningScene::isPathValid(const robot_trajectory::RobotTrajectory& traject
   return isPathValid(trajectory, EMP_CONSTRAINTS, EMP_CONSTRAINTS_VECTOR, group, verbose, invalid_index);
 }
 
+bool PlanningScene::isPathValid(const robot_trajectory::RobotTrajectory& trajectory,
+                                const moveit_msgs::Constraints& path_constraints,
+                                const std::vector<moveit_msgs::Constraints>& goal_constraints,
+                                const PathValidityOptions& options, const std::string& group,
+                                std::vector<std::size_t>* invalid_index) const
+{
+  if (invalid_index)
+    invalid_index->clear();
+  const std::size_t n_wp = trajectory.getWayPointCount();
+  if (n_wp == 0)
+    return true;
+
+  kinematic_constraints::KinematicConstraintSet ks_p(getRobotModel());
+  ks_p.add(path_constraints, getTransforms());
+
+  // order in which the waypoints are handed out to the workers
+  std::vector<std::size_t> order;
+  order.reserve(n_wp);
+  if (options.bisection_order && n_wp > 2)
+  {
+    order.push_back(0);
+    order.push_back(n_wp - 1);
+    std::size_t stride = 1;
+    while (stride < n_wp - 1)
+      stride *= 2;
+    // visit the multiples of each stride that were not visited with a coarser one
+    for (stride /= 2; stride > 0; stride /= 2)
+      for (std::size_t i = stride; i < n_wp - 1; i += 2 * stride)
+        order.push_back(i);
+  }
+  else
+  {
+    for (std::size_t i = 0; i < n_wp; ++i)
+      order.push_back(i);
+  }
+
+  std::unique_ptr<bool[]> valid(new bool[n_wp]);
+  std::fill(valid.get(), valid.get() + n_wp, true);
+  std::atomic<std::size_t> next(0);
+  std::atomic<bool> cancelled(false);
+  auto worker = [&]() {
+    for (std::size_t k = next++; k < n_wp && !cancelled.load(std::memory_order_relaxed); k = next++)
+    {
+      const std::size_t i = order[k];
+      const moveit::core::RobotState& st = trajectory.getWayPoint(i);
+      if (isStateColliding(st, group, options.verbose) || !isStateFeasible(st, options.verbose) ||
+          (!ks_p.empty() && !ks_p.decide(st, options.verbose).satisfied))
+      {
+        valid[i] = false;
+        if (!invalid_index)
+          cancelled = true;
+      }
+    }
+  };
+
+  unsigned int threads = options.threads ? options.threads : std::thread::hardware_concurrency();
+  threads = std::max(1u, static_cast<unsigned int>(std::min<std::size_t>(threads, n_wp)));
+  std::vector<std::thread> workers;
+  workers.reserve(threads - 1);
+  for (unsigned int t = 1; t < threads; ++t)
+    workers.emplace_back(worker);
+  worker();
+  for (std::thread& thread : workers)
+    thread.join();
+
+  if (cancelled)
+    return false;
+
+  bool result = true;
+  if (invalid_index)
+    for (std::size_t i = 0; i < n_wp; ++i)
+      if (!valid[i])
+      {
+        invalid_index->push_back(i);
+        result = false;
+      }
+
+  // check goal for last state
+  if (!goal_constraints.empty())
+  {
+    const moveit::core::RobotState& last = trajectory.getLastWayPoint();
+    bool found = false;
+    for (const moveit_msgs::Constraints& goal_constraint : goal_constraints)
+      if (isStateConstrained(last, goal_constraint))
+      {
+        found = true;
+        break;
+      }
+    if (!found)
+    {
+      if (options.verbose)
+        ROS_INFO_NAMED(LOGNAME, "Goal not satisfied");
+      if (invalid_index)
+        invalid_index->push_back(n_wp - 1);
+      result = false;
+    }
+  }
+  return result;
+}
+
 void PlanningScene::getCostSources(const robot_trajectory::RobotTrajectory& trajectory, std::size_t max_costs,
                                    std::set<collision_detection::CostSource>& costs, double overlap_fraction) const
 {
@@ -34,8 +34,11 @@
 
 /* Author: Peter Mitrano */
 
+#include <algorithm>
 #include <memory>
+#include <thread>
 #include <pybind11/pybind11.h>
+#include <pybind11/numpy.h>
 #include <pybind11/stl.h>
 #include <moveit/python/pybind_rosmsg_typecasters.h>
 #include <moveit/planning_scene/planning_scene.h>
@@ -43,6 +46,11 @@
 namespace py = pybind11;
 using namespace planning_scene;
 
+// Defined in pyrobot_state.cpp
+std::vector<moveit::core::RobotState> statesFromPositions(const moveit::core::RobotState& state,
+                                                          const double* positions, std::size_t count,
+                                                          std::size_t columns, const std::string& group);
+
 void def_planning_scene_bindings(py::module& m)
 {
   m.doc() = "The planning scene represents the state of the world and the robot, "
@@ -108,6 +116,36 @@ void def_planning_scene_bindings(py::module& m)
            py::overload_cast<const moveit::core::RobotState&, const kinematic_constraints::KinematicConstraintSet&,
                              const std::string&, bool>(&PlanningScene::isStateValid, py::const_),
            py::arg("state"), py::arg("constr"), py::arg("group"), py::arg("verbose") = false)
+      .def(
+          "isStateCollidingBatch",
+          [](const PlanningScene& scene, const moveit::core::RobotState& state,
+             const py::array_t<double, py::array::c_style | py::array::forcecast>& positions, const std::string& group,
+             unsigned int threads) {
+            if (positions.ndim() != 2)
+              throw std::invalid_argument("Expected a 2-dimensional array of positions");
+            const double* data = positions.data();
+            const std::size_t count = positions.shape(0);
+            const std::size_t columns = positions.shape(1);
+            py::array_t<bool> colliding(count);
+            bool* out = colliding.mutable_data();
+            {
+              py::gil_scoped_release release;
+              std::vector<moveit::core::RobotState> states = statesFromPositions(state, data, count, columns, group);
+              std::vector<const moveit::core::RobotState*> state_ptrs;
+              for (const moveit::core::RobotState& s : states)
+                state_ptrs.push_back(&s);
+              std::vector<bool> result;
+              if (!threads)
+                threads = std::max(1u, std::thread::hardware_concurrency());
+              scene.isStateColliding(state_ptrs, result, group, threads);
+              std::copy(result.begin(), result.end(), out);
+            }
+            return colliding;
+          },
+          py::arg("state"), py::arg("positions"), py::arg("group") = "", py::arg("threads") = 0,
+          "Check many states for collisions without holding the GIL. Each row of positions holds the variables of "
+          "group (of the whole robot if empty), the other variables are taken from state. threads = 0 uses all "
+          "cores. Returns one flag per state.")
       .def("setCurrentState", py::overload_cast<const moveit_msgs::RobotState&>(&PlanningScene::setCurrentState))
       .def("setCurrentState", py::overload_cast<const robot_state::RobotState&>(&PlanningScene::setCurrentState))
       //
@@ -0,0 +1,122 @@
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2026, PickNik LLC.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of PickNik LLC nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *********************************************************************/
+
+#include <moveit/planning_scene/state_validity_cache.h>
+#include <boost/functional/hash.hpp>
+#include <algorithm>
+#include <cmath>
+#include <utility>
+
+namespace planning_scene
+{
+StateValidityCache::StateValidityCache(double resolution, std::size_t max_entries)
+  : inverse_resolution_(resolution > 0.0 ? 1.0 / resolution : 1e9)
+  , max_shard_entries_(std::max<std::size_t>(1, max_entries / SHARD_COUNT))
+  , hits_(0)
+  , misses_(0)
+{
+}
+
+std::size_t StateValidityCache::KeyHash::operator()(const Key& key) const
+{
+  std::size_t seed = key.context;
+  boost::hash_range(seed, key.values.begin(), key.values.end());
+  return seed;
+}
+
+StateValidityCache::Key StateValidityCache::makeKey(const moveit::core::RobotState& state, std::size_t context) const
+{
+  Key key;
+  key.context = context;
+  const std::size_t n = state.getVariableCount();
+  const double* positions = state.getVariablePositions();
+  key.values.resize(n);
+  for (std::size_t i = 0; i < n; ++i)
+    key.values[i] = std::llround(positions[i] * inverse_resolution_);
+  return key;
+}
+
+bool StateValidityCache::find(const moveit::core::RobotState& state, std::size_t context, bool& result) const
+{
+  const Key key = makeKey(state, context);
+  const Shard& shard = shards_[KeyHash()(key) % SHARD_COUNT];
+  std::lock_guard<std::mutex> slock(shard.lock);
+  auto it = shard.entries.find(key);
+  if (it == shard.entries.end())
+  {
+    ++misses_;
+    return false;
+  }
+  ++hits_;
+  result = it->second;
+  return true;
+}
+
+void StateValidityCache::insert(const moveit::core::RobotState& state, std::size_t context, bool result)
+{
+  Key key = makeKey(state, context);
+  Shard& shard = shards_[KeyHash()(key) % SHARD_COUNT];
+  std::lock_guard<std::mutex> slock(shard.lock);
+  if (shard.entries.size() >= max_shard_entries_)
+    shard.entries.clear();
+  shard.entries[std::move(key)] = result;
+}
+
+void StateValidityCache::clear()
+{
+  for (Shard& shard : shards_)
+  {
+    std::lock_guard<std::mutex> slock(shard.lock);
+    shard.entries.clear();
+  }
+  hits_ = 0;
+  misses_ = 0;
+}
+
+std::size_t StateValidityCache::size() const
+{
+  std::size_t result = 0;
+  for (const Shard& shard : shards_)
+  {
+    std::lock_guard<std::mutex> slock(shard.lock);
+    result += shard.entries.size();
+  }
+  return result;
+}
+
+std::size_t StateValidityCache::makeContext(const std::string& id)
+{
+  return std::hash<std::string>()(id);
+}
+}  // namespace planning_scene
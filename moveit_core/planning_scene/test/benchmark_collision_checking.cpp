@@ -0,0 +1,170 @@
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2026, PickNik LLC.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of PickNik LLC nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *********************************************************************/
+
+/* Google Benchmark based micro-benchmarks of self, world and octomap collision checking with FCL and Bullet. Write
+   JSON results for regression tracking with --benchmark_out=<file> --benchmark_out_format=json */
+
+#include <moveit/planning_scene/planning_scene.h>
+#include <moveit/collision_detection_fcl/collision_detector_allocator_fcl.h>
+#ifdef MOVEIT_BENCHMARK_BULLET
+#include <moveit/collision_detection_bullet/collision_detector_allocator_bullet.h>
+#endif
+#include <moveit/utils/robot_model_test_utils.h>
+#include <geometric_shapes/shapes.h>
+#include <random_numbers/random_numbers.h>
+#include <octomap/octomap.h>
+#include <benchmark/benchmark.h>
+
+namespace
+{
+enum class Detector
+{
+  FCL,
+  BULLET
+};
+
+enum class World
+{
+  NONE,
+  BOXES,
+  OCTOMAP
+};
+
+collision_detection::CollisionDetectorAllocatorPtr allocator(Detector detector)
+{
+#ifdef MOVEIT_BENCHMARK_BULLET
+  if (detector == Detector::BULLET)
+    return collision_detection::CollisionDetectorAllocatorBullet::create();
+#endif
+  return collision_detection::CollisionDetectorAllocatorFCL::create();
+}
+
+// A scene of the robot surrounded by obstacles that some of the random states collide with
+planning_scene::PlanningScenePtr createScene(const std::string& robot, Detector detector, World world)
+{
+  auto scene = std::make_shared<planning_scene::PlanningScene>(moveit::core::loadTestingRobotModel(robot));
+  scene->setActiveCollisionDetector(allocator(detector), true);
+
+  random_numbers::RandomNumberGenerator rng(42);
+  if (world == World::BOXES)
+  {
+    for (std::size_t i = 0; i < 20; ++i)
+    {
+      Eigen::Isometry3d pose = Eigen::Isometry3d::Identity();
+      pose.translation() = Eigen::Vector3d(rng.uniformReal(-1.0, 1.0), rng.uniformReal(-1.0, 1.0),
+                                           rng.uniformReal(0.0, 1.5));
+      scene->getWorldNonConst()->addToObject("box" + std::to_string(i), std::make_shared<shapes::Box>(0.1, 0.1, 0.1),
+                                             pose);
+    }
+  }
+  else if (world == World::OCTOMAP)
+  {
+    // a sparse cloud of occupied voxels, as a depth sensor would report for a cluttered workspace
+    auto tree = std::make_shared<octomap::OcTree>(0.02);
+    for (std::size_t i = 0; i < 20000; ++i)
+      tree->updateNode(
+          octomap::point3d(rng.uniformReal(-1.0, 1.0), rng.uniformReal(-1.0, 1.0), rng.uniformReal(0.0, 1.5)), true);
+    scene->getWorldNonConst()->addToObject("octomap", std::make_shared<shapes::OcTree>(tree),
+                                           Eigen::Isometry3d::Identity());
+  }
+  return scene;
+}
+
+// The same random states of the robot's arm in every run, so that results are comparable between runs
+std::vector<moveit::core::RobotState> randomStates(const planning_scene::PlanningScene& scene, std::size_t count = 64)
+{
+  moveit::core::RobotState state(scene.getRobotModel());
+  const moveit::core::JointModelGroup* jmg =
+      state.getJointModelGroup(scene.getRobotModel()->getName() == "panda" ? "panda_arm" : "right_arm");
+  random_numbers::RandomNumberGenerator rng(7);
+  state.setToDefaultValues();
+  std::vector<moveit::core::RobotState> states;
+  for (std::size_t i = 0; i < count; ++i)
+  {
+    state.setToRandomPositions(jmg, rng);
+    state.update();
+    states.push_back(state);
+  }
+  return states;
+}
+}  // namespace
+
+static void selfCollision(benchmark::State& st, const std::string& robot, Detector detector)
+{
+  planning_scene::PlanningScenePtr scene = createScene(robot, detector, World::NONE);
+  std::vector<moveit::core::RobotState> states = randomStates(*scene);
+  collision_detection::CollisionRequest req;
+  std::size_t i = 0, collisions = 0;
+  for (auto _ : st)
+  {
+    collision_detection::CollisionResult res;
+    scene->checkSelfCollision(req, res, states[i++ % states.size()]);
+    collisions += res.collision;
+  }
+  st.counters["collision_rate"] = benchmark::Counter(collisions, benchmark::Counter::kAvgIterations);
+}
+
+static void worldCollision(benchmark::State& st, const std::string& robot, Detector detector, World world)
+{
+  planning_scene::PlanningScenePtr scene = createScene(robot, detector, world);
+  std::vector<moveit::core::RobotState> states = randomStates(*scene);
+  const collision_detection::AllowedCollisionMatrix& acm = scene->getAllowedCollisionMatrix();
+  collision_detection::CollisionRequest req;
+  std::size_t i = 0, collisions = 0;
+  for (auto _ : st)
+  {
+    collision_detection::CollisionResult res;
+    scene->getCollisionEnv()->checkRobotCollision(req, res, states[i++ % states.size()], acm);
+    collisions += res.collision;
+  }
+  st.counters["collision_rate"] = benchmark::Counter(collisions, benchmark::Counter::kAvgIterations);
+}
+
+BENCHMARK_CAPTURE(selfCollision, panda_fcl, "panda", Detector::FCL);
+BENCHMARK_CAPTURE(selfCollision, pr2_fcl, "pr2", Detector::FCL);
+BENCHMARK_CAPTURE(worldCollision, panda_boxes_fcl, "panda", Detector::FCL, World::BOXES);
+BENCHMARK_CAPTURE(worldCollision, pr2_boxes_fcl, "pr2", Detector::FCL, World::BOXES);
+BENCHMARK_CAPTURE(worldCollision, panda_octomap_fcl, "panda", Detector::FCL, World::OCTOMAP);
+BENCHMARK_CAPTURE(worldCollision, pr2_octomap_fcl, "pr2", Detector::FCL, World::OCTOMAP);
+
+#ifdef MOVEIT_BENCHMARK_BULLET
+BENCHMARK_CAPTURE(selfCollision, panda_bullet, "panda", Detector::BULLET);
+BENCHMARK_CAPTURE(selfCollision, pr2_bullet, "pr2", Detector::BULLET);
+BENCHMARK_CAPTURE(worldCollision, panda_boxes_bullet, "panda", Detector::BULLET, World::BOXES);
+BENCHMARK_CAPTURE(worldCollision, pr2_boxes_bullet, "pr2", Detector::BULLET, World::BOXES);
+BENCHMARK_CAPTURE(worldCollision, panda_octomap_bullet, "panda", Detector::BULLET, World::OCTOMAP);
+BENCHMARK_CAPTURE(worldCollision, pr2_octomap_bullet, "pr2", Detector::BULLET, World::OCTOMAP);
+#endif
+
+BENCHMARK_MAIN();
@@ -345,6 +345,142 @@ TEST_P(CollisionDetectorTests, ClearDiff)
   parent.reset();
 }
 
+TEST_P(CollisionDetectorTests, BatchCollisionChecks)
+{
+  const std::string plugin_name = GetParam();
+  SCOPED_TRACE(plugin_name);
+
+  moveit::core::RobotModelPtr robot_model = moveit::core::loadTestingRobotModel("panda");
+  auto scene = std::make_shared<planning_scene::PlanningScene>(robot_model);
+  collision_detection::CollisionPluginCache loader;
+  if (!loader.activate(plugin_name, scene, true))
+  {
+#if defined(GTEST_SKIP_)
+    GTEST_SKIP_("Failed to load collision plugin");
+#else
+    return;
+#endif
+  }
+
+  Eigen::Isometry3d pose = Eigen::Isometry3d::Identity();
+  pose.translation() = Eigen::Vector3d(0.4, 0.0, 0.4);
+  scene->getWorldNonConst()->addToObject("box", std::make_shared<shapes::Box>(0.3, 0.3, 0.3), pose);
+
+  std::vector<moveit::core::RobotState> states(25, scene->getCurrentState());
+  std::vector<const moveit::core::RobotState*> state_ptrs;
+  for (moveit::core::RobotState& state : states)
+  {
+    state.setToRandomPositions();
+    state.update();
+    state_ptrs.push_back(&state);
+  }
+
+  for (unsigned int threads : { 1u, 4u })
+  {
+    std::vector<bool> colliding;
+    scene->isStateColliding(state_ptrs, colliding, "panda_arm", threads);
+    ASSERT_EQ(colliding.size(), states.size());
+    for (std::size_t i = 0; i < states.size(); ++i)
+      EXPECT_EQ(colliding[i], scene->isStateColliding(states[i], "panda_arm", true)) << "state " << i;
+  }
+
+  std::vector<bool> colliding;
+  scene->isStateColliding(std::vector<const moveit::core::RobotState*>(), colliding);
+  EXPECT_TRUE(colliding.empty());
+}
+
+TEST(PlanningScene, ParallelPathValidity)
+{
+  moveit::core::RobotModelPtr robot_model = moveit::core::loadTestingRobotModel("panda");
+  auto scene = std::make_shared<planning_scene::PlanningScene>(robot_model);
+  Eigen::Isometry3d pose = Eigen::Isometry3d::Identity();
+  pose.translation() = Eigen::Vector3d(0.4, 0.0, 0.4);
+  scene->getWorldNonConst()->addToObject("box", std::make_shared<shapes::Box>(0.3, 0.3, 0.3), pose);
+
+  robot_trajectory::RobotTrajectory trajectory(robot_model, "panda_arm");
+  moveit::core::RobotState state(scene->getCurrentState());
+  for (std::size_t i = 0; i < 37; ++i)
+  {
+    state.setToRandomPositions();
+    state.update();
+    trajectory.addSuffixWayPoint(state, 0.1);
+  }
+
+  static const moveit_msgs::Constraints EMP_CONSTRAINTS;
+  static const std::vector<moveit_msgs::Constraints> EMP_CONSTRAINTS_VECTOR;
+  std::vector<std::size_t> expected;
+  const bool expected_valid = scene->isPathValid(trajectory, "panda_arm", false, &expected);
+
+  for (unsigned int threads : { 1u, 4u })
+    for (bool bisection : { false, true })
+    {
+      planning_scene::PathValidityOptions options;
+      options.threads = threads;
+      options.bisection_order = bisection;
+      std::vector<std::size_t> invalid;
+      EXPECT_EQ(scene->isPathValid(trajectory, EMP_CONSTRAINTS, EMP_CONSTRAINTS_VECTOR, options, "panda_arm", &invalid),
+                expected_valid);
+      EXPECT_EQ(invalid, expected);
+      EXPECT_EQ(scene->isPathValid(trajectory, EMP_CONSTRAINTS, EMP_CONSTRAINTS_VECTOR, options, "panda_arm"),
+                expected_valid);
+    }
+}
+
+TEST(PlanningScene, StateValidityCache)
+{
+  moveit::core::RobotModelPtr robot_model = moveit::core::loadTestingRobotModel("panda");
+  auto scene = std::make_shared<planning_scene::PlanningScene>(robot_model);
+  Eigen::Isometry3d pose = Eigen::Isometry3d::Identity();
+  pose.translation() = Eigen::Vector3d(0.4, 0.0, 0.4);
+  scene->getWorldNonConst()->addToObject("box", std::make_shared<shapes::Box>(0.3, 0.3, 0.3), pose);
+
+  moveit_msgs::Constraints constraints;
+  constraints.joint_constraints.resize(1);
+  constraints.joint_constraints[0].joint_name = "panda_joint1";
+  constraints.joint_constraints[0].tolerance_above = 0.5;
+  constraints.joint_constraints[0].tolerance_below = 0.5;
+  constraints.joint_constraints[0].weight = 1.0;
+
+  robot_trajectory::RobotTrajectory trajectory(robot_model, "panda_arm");
+  moveit::core::RobotState state(scene->getCurrentState());
+  for (std::size_t i = 0; i < 20; ++i)
+  {
+    state.setToRandomPositions();
+    state.update();
+    trajectory.addSuffixWayPoint(state, 0.1);
+  }
+  std::vector<std::size_t> expected;
+  const bool expected_valid = scene->isPathValid(trajectory, constraints, "panda_arm", false, &expected);
+
+  // the cached results agree with the uncached ones, and a second check is answered from the cache
+  auto cache = std::make_shared<planning_scene::StateValidityCache>();
+  scene->setStateValidityCache(cache);
+  for (int pass = 0; pass < 2; ++pass)
+  {
+    std::vector<std::size_t> invalid;
+    EXPECT_EQ(scene->isPathValid(trajectory, constraints, "panda_arm", false, &invalid), expected_valid);
+    EXPECT_EQ(invalid, expected);
+  }
+  EXPECT_EQ(cache->getMissCount(), cache->size());
+  EXPECT_EQ(cache->getHitCount(), cache->size());
+
+  for (std::size_t i = 0; i < trajectory.getWayPointCount(); ++i)
+  {
+    const moveit::core::RobotState& st = trajectory.getWayPoint(i);
+    scene->setStateValidityCache(planning_scene::StateValidityCachePtr());
+    const bool colliding = scene->isStateColliding(st, "panda_arm");
+    const bool constrained = scene->isStateConstrained(st, constraints);
+    scene->setStateValidityCache(cache);
+    EXPECT_EQ(scene->isStateColliding(st, "panda_arm"), colliding);
+    EXPECT_EQ(scene->isStateConstrained(st, constraints), constrained);
+  }
+
+  // diff scenes do not share the cache
+  EXPECT_FALSE(scene->diff()->getStateValidityCache());
+  cache->clear();
+  EXPECT_EQ(cache->size(), 0u);
+}
+
 // Returns a planning scene diff message
 moveit_msgs::PlanningScene create_planning_scene_diff(const planning_scene::PlanningScene& ps,
                                                       const std::string& object_name, const int8_t operation,
@@ -487,6 +623,299 @@ TEST(PlanningScene, RobotStateDiffBug)
   }
 }
 
+TEST(PlanningScene, PoseOnlyDiff)
+{
+  auto urdf_model = moveit::core::loadModelInterface("panda");
+  auto srdf_model = std::make_shared<srdf::Model>();
+  auto ps = std::make_shared<planning_scene::PlanningScene>(urdf_model, srdf_model);
+  ps->usePlanningSceneMsg(create_planning_scene_diff(*ps, "object1", moveit_msgs::CollisionObject::ADD));
+  ps->usePlanningSceneMsg(create_planning_scene_diff(*ps, "object2", moveit_msgs::CollisionObject::ADD));
+
+  // a subscriber holding the same scene as the parent
+  auto subscriber = planning_scene::PlanningScene::clone(ps);
+
+  Eigen::Isometry3d pose = Eigen::Isometry3d::Identity();
+  pose.translation() = Eigen::Vector3d(0.5, -0.2, 1.0);
+  auto child = ps->diff();
+  child->getWorldNonConst()->setObjectPose("object1", pose);
+  // re-adding equal geometry does not resend it either
+  moveit_msgs::CollisionObject object2;
+  ASSERT_TRUE(ps->getCollisionObjectMsg(object2, "object2"));
+  ASSERT_EQ(object2.operation, moveit_msgs::CollisionObject::ADD);
+  child->processCollisionObjectMsg(object2);
+  // new geometry is sent in full
+  child->getWorldNonConst()->addToObject("object3", std::make_shared<const shapes::Box>(1.0, 1.0, 1.0),
+                                         Eigen::Isometry3d::Identity());
+
+  moveit_msgs::PlanningScene msg;
+  child->getPlanningSceneDiffMsg(msg);
+  ASSERT_EQ(msg.world.collision_objects.size(), 3u);
+  for (const moveit_msgs::CollisionObject& co : msg.world.collision_objects)
+  {
+    if (co.id == "object3")
+    {
+      EXPECT_EQ(co.operation, moveit_msgs::CollisionObject::ADD);
+      EXPECT_EQ(co.primitives.size(), 1u);
+    }
+    else
+    {
+      EXPECT_EQ(co.operation, moveit_msgs::CollisionObject::MOVE) << co.id;
+      EXPECT_TRUE(co.primitives.empty());
+    }
+  }
+
+  ASSERT_TRUE(subscriber->usePlanningSceneMsg(msg));
+  EXPECT_EQ(get_collision_objects_names(*subscriber), (std::set<std::string>{ "object1", "object2", "object3" }));
+  EXPECT_TRUE(subscriber->getWorld()->getObject("object1")->pose_.isApprox(pose));
+  EXPECT_EQ(subscriber->getWorld()->getObject("object1")->shapes_.size(), 1u);
+}
+
+TEST(PlanningScene, MaxDiffDepth)
+{
+  auto ps = std::make_shared<planning_scene::PlanningScene>(moveit::core::loadTestingRobotModel("panda"));
+  ps->setMaxDiffDepth(3);
+  ps->usePlanningSceneMsg(create_planning_scene_diff(*ps, "object1", moveit_msgs::CollisionObject::ADD));
+
+  planning_scene::PlanningScenePtr scene = ps;
+  for (std::size_t i = 0; i < 10; ++i)
+  {
+    scene = scene->diff();
+    EXPECT_LE(scene->getDiffDepth(), 3u);
+    EXPECT_EQ(scene->getMaxDiffDepth(), 3u);
+    scene->getAllowedCollisionMatrixNonConst().setEntry("object1", "panda_link" + std::to_string(i % 8), true);
+  }
+  EXPECT_EQ(get_collision_objects_names(*scene), (std::set<std::string>{ "object1" }));
+  collision_detection::AllowedCollision::Type type;
+  for (std::size_t i = 0; i < 8; ++i)
+  {
+    ASSERT_TRUE(scene->getAllowedCollisionMatrix().getEntry("object1", "panda_link" + std::to_string(i), type));
+    EXPECT_EQ(type, collision_detection::AllowedCollision::ALWAYS);
+  }
+
+  // without a limit, the chain keeps growing
+  ps->setMaxDiffDepth(0);
+  EXPECT_EQ(ps->diff()->diff()->diff()->getDiffDepth(), 3u);
+}
+
+TEST(PlanningScene, ShallowClone)
+{
+  auto ps = std::make_shared<planning_scene::PlanningScene>(moveit::core::loadTestingRobotModel("panda"));
+  ps->usePlanningSceneMsg(create_planning_scene_diff(*ps, "object1", moveit_msgs::CollisionObject::ADD));
+  std_msgs::ColorRGBA red;
+  red.r = red.a = 1.0;
+  ps->setObjectColor("object1", red);
+
+  planning_scene::PlanningScenePtr clone = planning_scene::PlanningScene::shallowClone(ps);
+  EXPECT_FALSE(clone->getParent());
+  EXPECT_EQ(get_collision_objects_names(*clone), (std::set<std::string>{ "object1" }));
+  EXPECT_EQ(&clone->getAllowedCollisionMatrix(), &ps->getAllowedCollisionMatrix());
+  EXPECT_EQ(clone->getObjectColor("object1").r, 1.0);
+
+  // modifying either scene does not affect the other one
+  clone->getAllowedCollisionMatrixNonConst().setEntry("object1", "panda_link0", true);
+  EXPECT_NE(&clone->getAllowedCollisionMatrix(), &ps->getAllowedCollisionMatrix());
+  EXPECT_FALSE(ps->getAllowedCollisionMatrix().hasEntry("object1", "panda_link0"));
+  ps->removeObjectColor("object1");
+  EXPECT_FALSE(ps->hasObjectColor("object1"));
+  EXPECT_TRUE(clone->hasObjectColor("object1"));
+}
+
+TEST(PlanningScene, InactiveCollisionDetectors)
+{
+  auto parent = std::make_shared<planning_scene::PlanningScene>(moveit::core::loadTestingRobotModel("panda"));
+  collision_detection::CollisionPluginCache loader;
+  if (!loader.add("Bullet", parent))
+  {
+#if defined(GTEST_SKIP_)
+    GTEST_SKIP_("Failed to load collision plugin");
+#else
+    return;
+#endif
+  }
+  EXPECT_EQ(parent->getActiveCollisionDetectorName(), "FCL");
+
+  // a box around the base of the robot, added to the diff scene before its Bullet environment is allocated
+  planning_scene::PlanningScenePtr child = parent->diff();
+  child->getWorldNonConst()->addToObject("box", std::make_shared<shapes::Box>(0.5, 0.5, 0.5),
+                                         Eigen::Isometry3d::Identity());
+
+  collision_detection::CollisionRequest req;
+  collision_detection::CollisionResult res;
+  const moveit::core::RobotState& state = child->getCurrentState();
+  for (const std::string& name : { "FCL", "Bullet" })
+  {
+    SCOPED_TRACE(name);
+    res.clear();
+    child->getCollisionEnv(name)->checkRobotCollision(req, res, state, child->getAllowedCollisionMatrix());
+    EXPECT_TRUE(res.collision);
+    res.clear();
+    parent->getCollisionEnv(name)->checkRobotCollision(req, res, state, parent->getAllowedCollisionMatrix());
+    EXPECT_FALSE(res.collision);
+  }
+
+  // switching keeps the environments
+  const collision_detection::CollisionEnvConstPtr bullet = child->getCollisionEnv("Bullet");
+  EXPECT_TRUE(child->setActiveCollisionDetector("Bullet"));
+  EXPECT_EQ(child->getCollisionEnv(), bullet);
+  EXPECT_EQ(parent->getActiveCollisionDetectorName(), "FCL");
+}
+
+TEST(PlanningScene, ManyCollisionObjects)
+{
+  auto ps = std::make_shared<planning_scene::PlanningScene>(moveit::core::loadTestingRobotModel("panda"));
+  moveit_msgs::PlanningSceneWorld world;
+  for (std::size_t i = 0; i < 200; ++i)
+  {
+    moveit_msgs::CollisionObject co;
+    co.header.frame_id = ps->getPlanningFrame();
+    co.id = "box" + std::to_string(i);
+    co.operation = moveit_msgs::CollisionObject::ADD;
+    co.primitives.resize(1);
+    co.primitives[0].type = shape_msgs::SolidPrimitive::BOX;
+    co.primitives[0].dimensions = { 0.1, 0.2, 0.3 };
+    co.primitive_poses.resize(1);
+    co.primitive_poses[0].orientation.w = 1.0;
+    co.pose.position.x = i;
+    co.pose.orientation.w = 1.0;
+    world.collision_objects.push_back(co);
+  }
+  // invalid objects are skipped
+  world.collision_objects[17].header.frame_id = "unknown_frame";
+  // later operations apply to objects added earlier in the same message
+  moveit_msgs::CollisionObject remove;
+  remove.id = "box3";
+  remove.operation = moveit_msgs::CollisionObject::REMOVE;
+  world.collision_objects.push_back(remove);
+
+  EXPECT_FALSE(ps->processPlanningSceneWorldMsg(world));
+  EXPECT_EQ(ps->getWorld()->size(), 198u);
+  EXPECT_FALSE(ps->getWorld()->hasObject("box3"));
+  EXPECT_FALSE(ps->getWorld()->hasObject("box17"));
+  collision_detection::World::ObjectConstPtr obj = ps->getWorld()->getObject("box150");
+  ASSERT_TRUE(obj);
+  ASSERT_EQ(obj->shapes_.size(), 1u);
+  EXPECT_EQ(obj->shapes_[0]->type, shapes::BOX);
+  EXPECT_DOUBLE_EQ(obj->pose_.translation().x(), 150.0);
+}
+
+TEST(PlanningScene, FrameHandles)
+{
+  auto ps = std::make_shared<planning_scene::PlanningScene>(moveit::core::loadTestingRobotModel("panda"));
+  ps->usePlanningSceneMsg(create_planning_scene_diff(*ps, "object1", moveit_msgs::CollisionObject::ADD));
+  const Eigen::Isometry3d fixed(Eigen::Translation3d(1.0, 2.0, 3.0));
+  ps->getTransformsNonConst().setTransform(fixed, "fixed_frame");
+  ps->getCurrentStateNonConst().setToRandomPositions();
+  ps->getCurrentStateNonConst().update();
+
+  const planning_scene::PlanningScene::FrameHandle link = ps->resolveFrame("/panda_link5");
+  EXPECT_TRUE(link.link);
+  EXPECT_TRUE(ps->getFrameTransform(link).isApprox(ps->getFrameTransform("panda_link5")));
+
+  const planning_scene::PlanningScene::FrameHandle object = ps->resolveFrame("object1");
+  EXPECT_FALSE(object.link);
+  EXPECT_FALSE(object.transforms);
+  EXPECT_TRUE(ps->getFrameTransform(object).isApprox(ps->getFrameTransform("object1")));
+
+  const planning_scene::PlanningScene::FrameHandle fixed_frame = ps->resolveFrame("fixed_frame");
+  EXPECT_EQ(fixed_frame.transforms, &ps->getTransforms());
+  EXPECT_TRUE(ps->getFrameTransform(fixed_frame).isApprox(fixed));
+  EXPECT_TRUE(ps->getFrameTransform(ps->resolveFrame(ps->getPlanningFrame())).isApprox(Eigen::Isometry3d::Identity()));
+
+  // handles of the parent's fixed frames fall back to lookups by name in a diff
+  planning_scene::PlanningScenePtr diff = ps->diff();
+  const Eigen::Isometry3d moved(Eigen::Translation3d(-1.0, 0.0, 0.0));
+  diff->getTransformsNonConst().setTransform(moved, "fixed_frame");
+  EXPECT_TRUE(diff->getFrameTransform(fixed_frame).isApprox(moved));
+}
+
+TEST(PlanningScene, ChangeJournal)
+{
+  auto ps = std::make_shared<planning_scene::PlanningScene>(moveit::core::loadTestingRobotModel("panda"));
+  using SceneChange = planning_scene::PlanningScene::SceneChange;
+  const std::uint64_t start = ps->getChangeVersion();
+  std::vector<SceneChange> changes;
+  ASSERT_TRUE(ps->getChangesSince(start, changes));
+  EXPECT_TRUE(changes.empty());
+
+  ps->usePlanningSceneMsg(create_planning_scene_diff(*ps, "object1", moveit_msgs::CollisionObject::ADD));
+  ps->getAllowedCollisionMatrixNonConst().setEntry("object1", "panda_link0", true);
+  const std::uint64_t middle = ps->getChangeVersion();
+  ps->usePlanningSceneMsg(create_planning_scene_diff(*ps, "object1", moveit_msgs::CollisionObject::ADD, true, false));
+
+  ASSERT_TRUE(ps->getChangesSince(start, changes));
+  ASSERT_GE(changes.size(), 3u);
+  EXPECT_EQ(changes.front().type, SceneChange::WORLD_OBJECT);
+  EXPECT_EQ(changes.front().id, "object1");
+  EXPECT_TRUE(changes.front().action & collision_detection::World::CREATE);
+  EXPECT_EQ(changes.back().version, ps->getChangeVersion());
+  for (std::size_t i = 1; i < changes.size(); ++i)
+    EXPECT_LT(changes[i - 1].version, changes[i].version);
+
+  // only the changes after middle: object1 was removed and attached to the robot
+  ASSERT_TRUE(ps->getChangesSince(middle, changes));
+  bool removed = false, attached = false;
+  for (const SceneChange& change : changes)
+  {
+    EXPECT_GT(change.version, middle);
+    removed |= change.type == SceneChange::WORLD_OBJECT && (change.action & collision_detection::World::DESTROY);
+    attached |= change.type == SceneChange::ATTACHED_BODY && change.attached && change.id == "object1";
+  }
+  EXPECT_TRUE(removed);
+  EXPECT_TRUE(attached);
+
+  EXPECT_FALSE(ps->getChangesSince(ps->getChangeVersion() + 1, changes));
+
+  // a diff starts its own journal, which clearDiffs() resets
+  planning_scene::PlanningScenePtr diff = ps->diff();
+  const std::uint64_t diff_start = diff->getChangeVersion();
+  diff->getAllowedCollisionMatrixNonConst().setEntry("object2", "panda_link0", true);
+  ASSERT_TRUE(diff->getChangesSince(diff_start, changes));
+  ASSERT_EQ(changes.size(), 1u);
+  EXPECT_EQ(changes[0].type, SceneChange::ALLOWED_COLLISION_MATRIX);
+  diff->clearDiffs();
+  EXPECT_FALSE(diff->getChangesSince(diff_start, changes));
+}
+
+TEST(PlanningScene, CheckpointRestore)
+{
+  auto ps = std::make_shared<planning_scene::PlanningScene>(moveit::core::loadTestingRobotModel("panda"));
+  ps->usePlanningSceneMsg(create_planning_scene_diff(*ps, "object1", moveit_msgs::CollisionObject::ADD));
+  EXPECT_FALSE(ps->checkpoint());
+
+  planning_scene::PlanningScenePtr diff = ps->diff();
+  diff->usePlanningSceneMsg(create_planning_scene_diff(*diff, "object2", moveit_msgs::CollisionObject::ADD));
+  diff->getAllowedCollisionMatrixNonConst().setEntry("object2", "panda_link0", true);
+  const Eigen::Isometry3d pose = diff->getWorld()->getObject("object2")->pose_;
+  planning_scene::PlanningSceneConstPtr checkpoint = diff->checkpoint();
+  ASSERT_TRUE(checkpoint);
+  EXPECT_EQ(get_collision_objects_names(*checkpoint), (std::set<std::string>{ "object1", "object2" }));
+
+  // speculative changes of the diff
+  diff->getWorldNonConst()->moveObject("object2", Eigen::Isometry3d(Eigen::Translation3d(1.0, 0.0, 0.0)));
+  diff->usePlanningSceneMsg(
+      create_planning_scene_diff(*diff, "object1", moveit_msgs::CollisionObject::ADD, true, false));
+  diff->usePlanningSceneMsg(create_planning_scene_diff(*diff, "object3", moveit_msgs::CollisionObject::ADD));
+  diff->getAllowedCollisionMatrixNonConst().setEntry("object2", "panda_link0", false);
+  EXPECT_EQ(get_attached_collision_objects_names(*diff), (std::set<std::string>{ "object1" }));
+
+  ASSERT_TRUE(diff->restoreCheckpoint(checkpoint));
+  EXPECT_EQ(get_collision_objects_names(*diff), (std::set<std::string>{ "object1", "object2" }));
+  EXPECT_TRUE(get_attached_collision_objects_names(*diff).empty());
+  EXPECT_TRUE(diff->getWorld()->getObject("object2")->pose_.isApprox(pose));
+  collision_detection::AllowedCollision::Type type;
+  ASSERT_TRUE(diff->getAllowedCollisionMatrix().getEntry("object2", "panda_link0", type));
+  EXPECT_EQ(type, collision_detection::AllowedCollision::ALWAYS);
+
+  // after clearDiffs() the checkpoint's diffs are applied again
+  diff->clearDiffs();
+  EXPECT_EQ(get_collision_objects_names(*diff), (std::set<std::string>{ "object1" }));
+  ASSERT_TRUE(diff->restoreCheckpoint(checkpoint));
+  EXPECT_EQ(get_collision_objects_names(*diff), (std::set<std::string>{ "object1", "object2" }));
+
+  // checkpoints are specific to their scene
+  EXPECT_FALSE(ps->diff()->restoreCheckpoint(checkpoint));
+}
+
 #ifndef INSTANTIATE_TEST_SUITE_P  // prior to gtest 1.10
 #define INSTANTIATE_TEST_SUITE_P(...) INSTANTIATE_TEST_CASE_P(__VA_ARGS__)
 #endif
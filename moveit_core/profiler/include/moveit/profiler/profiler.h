@@ -68,7 +68,9 @@ namespace tools
     spent in various chunks of code. This is different from
     external profiling tools in that it allows the user to count
     time spent in various bits of code (sub-function granularity)
-    or count how many times certain pieces of code are executed.*/
+    or count how many times certain pieces of code are executed.
+    Every call takes a global lock; for code that stays instrumented
+    in production, use the trace zones of moveit/profiler/trace.h.*/
 class Profiler : private boost::noncopyable
 {
 public:
@@ -0,0 +1,188 @@
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2026, PickNik LLC.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of PickNik LLC nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *********************************************************************/
+
+#pragma once
+
+/** MOVEIT_ENABLE_TRACING can be set externally to 0 to compile the trace zones out entirely. Otherwise they are
+    compiled in and cost a single relaxed atomic load each while recording is stopped. */
+#ifndef MOVEIT_ENABLE_TRACING
+#define MOVEIT_ENABLE_TRACING 1
+#endif
+
+#include <atomic>
+#include <cstdint>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace moveit
+{
+namespace tools
+{
+/** \brief Records when scoped trace zones are entered and left, for finding latency spikes in running systems.
+ *
+ *  Unlike Profiler, recording takes no lock and allocates nothing: zone names are interned into numeric ids once,
+ *  and every thread writes nanosecond timestamped events into its own ring buffer, which keeps the most recent
+ *  events. The recorded zones can be exported in the Chrome trace event format, which chrome://tracing and Perfetto
+ *  display as a nested timeline per thread.
+ *
+ *  While recording, each thread also counts how often it entered every zone and how long it spent inside, which is
+ *  kept regardless of the ring buffer size. Only the first MAX_COUNTED_ZONES interned zones are counted.
+ *
+ *  If the environment variable MOVEIT_TRACE_FILE is set, recording starts right away and the trace is written to
+ *  that file when the process exits. */
+class TraceRecorder
+{
+public:
+  /** \brief The number of zone ids that are counted per thread */
+  static const std::size_t MAX_COUNTED_ZONES = 256;
+
+  /** \brief How often a zone was left and the time spent in it, including nested zones */
+  struct ZoneStatistics
+  {
+    std::uint64_t count = 0;
+    std::uint64_t total_ns = 0;
+  };
+
+  /** \brief Return the instance of the class */
+  static TraceRecorder& instance();
+
+  /** \brief Start recording zones */
+  void start();
+
+  /** \brief Stop recording zones. Zones entered before stay open until they are left. */
+  void stop();
+
+  /** \brief Check if zones are recorded */
+  bool recording() const
+  {
+    return recording_.load(std::memory_order_relaxed);
+  }
+
+  /** \brief Discard all recorded events */
+  void clear();
+
+  /** \brief Return the id of the zone called \e name, which stays valid for the lifetime of the process */
+  std::uint32_t intern(const std::string& name);
+
+  /** \brief Record that the calling thread entered the zone \e id */
+  void begin(std::uint32_t id);
+
+  /** \brief Record that the calling thread left the zone \e id */
+  void end(std::uint32_t id);
+
+  /** \brief Write the recorded events of all threads in the Chrome trace event format. Recording may continue
+   *  meanwhile; events overwritten during the export are left out. */
+  void writeChromeTrace(std::ostream& out);
+
+  /** \brief Write the recorded events to the file \e filename, see above */
+  bool writeChromeTrace(const std::string& filename);
+
+  /** \brief Get the statistics of the zones the calling thread left while recording, indexed by zone id. The
+   *  counters only grow, so measuring a section of code means taking the difference of two calls. */
+  void getThreadZoneStatistics(std::vector<ZoneStatistics>& statistics);
+
+  /** \brief Get the statistics of all threads combined, indexed by zone id, see above */
+  void getZoneStatistics(std::vector<ZoneStatistics>& statistics);
+
+  /** \brief Return the names of the interned zones, indexed by zone id */
+  std::vector<std::string> getZoneNames();
+
+  /** \brief Set the number of events each thread keeps (rounded up to a power of two). Applies to the buffers of
+   *  threads that record their first event afterwards. */
+  void setThreadBufferSize(std::size_t events);
+
+private:
+  class ThreadBuffer;
+
+  TraceRecorder();
+  ~TraceRecorder();
+
+  ThreadBuffer& threadBuffer();
+
+  std::atomic<bool> recording_;
+  std::atomic<std::size_t> thread_buffer_size_;
+  std::string exit_trace_file_;
+
+  /** \brief Protects the names and the list of buffers, which are only accessed on slow paths */
+  std::mutex lock_;
+  std::unordered_map<std::string, std::uint32_t> ids_;
+  std::vector<std::string> names_;
+  std::vector<std::shared_ptr<ThreadBuffer>> buffers_;
+};
+
+/** \brief Records the zone it was constructed with as entered until it goes out of scope */
+class TraceZone
+{
+public:
+  explicit TraceZone(std::uint32_t id) : id_(id), recorded_(TraceRecorder::instance().recording())
+  {
+    if (recorded_)
+      TraceRecorder::instance().begin(id_);
+  }
+
+  ~TraceZone()
+  {
+    // a zone that was entered is also left in the trace, even if recording stopped meanwhile
+    if (recorded_)
+      TraceRecorder::instance().end(id_);
+  }
+
+  TraceZone(const TraceZone&) = delete;
+  TraceZone& operator=(const TraceZone&) = delete;
+
+private:
+  std::uint32_t id_;
+  bool recorded_;
+};
+}  // namespace tools
+}  // namespace moveit
+
+#define MOVEIT_TRACE_CONCAT_DETAIL(a, b) a##b
+#define MOVEIT_TRACE_CONCAT(a, b) MOVEIT_TRACE_CONCAT_DETAIL(a, b)
+
+#if MOVEIT_ENABLE_TRACING
+/** \brief Record the rest of the enclosing scope as the trace zone \e name, which must be a string literal or
+    otherwise stay the same for every pass */
+#define MOVEIT_TRACE_ZONE(name)                                                                                        \
+  static const std::uint32_t MOVEIT_TRACE_CONCAT(moveit_trace_zone_id_, __LINE__) =                                    \
+      moveit::tools::TraceRecorder::instance().intern(name);                                                           \
+  const moveit::tools::TraceZone MOVEIT_TRACE_CONCAT(moveit_trace_zone_, __LINE__)(                                    \
+      MOVEIT_TRACE_CONCAT(moveit_trace_zone_id_, __LINE__))
+#else
+#define MOVEIT_TRACE_ZONE(name)
+#endif
@@ -0,0 +1,388 @@
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2026, PickNik LLC.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of PickNik LLC nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *********************************************************************/
+
+#include <moveit/profiler/trace.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <unistd.h>
+
+namespace moveit
+{
+namespace tools
+{
+namespace
+{
+const std::size_t DEFAULT_THREAD_BUFFER_SIZE = 1 << 14;
+
+// zones nested deeper than this are still traced, but not timed for the zone statistics
+const std::size_t MAX_TIMED_DEPTH = 64;
+
+std::uint64_t nowNanoseconds()
+{
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch())
+      .count();
+}
+
+void writeEscaped(std::ostream& out, const std::string& text)
+{
+  for (char c : text)
+  {
+    if (c == '"' || c == '\\')
+      out << '\\' << c;
+    else if (static_cast<unsigned char>(c) < 0x20)
+      out << "\\u" << std::hex << std::setw(4) << std::setfill('0') << static_cast<int>(c) << std::dec;
+    else
+      out << c;
+  }
+}
+}  // namespace
+
+/** \brief A ring buffer of events with a single writing thread. Other threads may read it at any time and detect
+ *  the events the writer overwrote while they were reading. */
+class TraceRecorder::ThreadBuffer
+{
+public:
+  ThreadBuffer(std::size_t size, std::uint32_t index)
+    : events_(new Event[size])
+    , size_(size)
+    , head_(0)
+    , cleared_(0)
+    , index_(index)
+    , in_use_(true)
+    , zones_(new ZoneCounter[MAX_COUNTED_ZONES])
+    , depth_(0)
+  {
+    for (std::size_t i = 0; i < MAX_COUNTED_ZONES; ++i)
+    {
+      zones_[i].count.store(0, std::memory_order_relaxed);
+      zones_[i].total_ns.store(0, std::memory_order_relaxed);
+    }
+  }
+
+  /** \brief Append an event. Only called by the thread owning the buffer. */
+  void push(std::uint64_t time, std::uint64_t data)
+  {
+    const std::uint64_t head = head_.load(std::memory_order_relaxed);
+    // readers that see the new event data also see that head_ reached this event, and thereby that it is
+    // overwriting an old one
+    std::atomic_thread_fence(std::memory_order_release);
+    Event& event = events_[head & (size_ - 1)];
+    event.time.store(time, std::memory_order_relaxed);
+    event.data.store(data, std::memory_order_relaxed);
+    head_.store(head + 1, std::memory_order_release);
+  }
+
+  /** \brief Copy the events that are still in the buffer, oldest first */
+  void read(std::vector<std::pair<std::uint64_t, std::uint64_t>>& events) const
+  {
+    const std::uint64_t head = head_.load(std::memory_order_acquire);
+    const std::uint64_t first = std::max(head > size_ ? head - size_ : 0, cleared_.load(std::memory_order_relaxed));
+    events.clear();
+    for (std::uint64_t i = first; i < head; ++i)
+    {
+      const Event& event = events_[i & (size_ - 1)];
+      events.emplace_back(event.time.load(std::memory_order_relaxed), event.data.load(std::memory_order_relaxed));
+    }
+
+    // drop the events the writer overwrote meanwhile, including the one it may be writing right now
+    std::atomic_thread_fence(std::memory_order_acquire);
+    const std::uint64_t new_head = head_.load(std::memory_order_relaxed);
+    const std::uint64_t valid_first = new_head + 1 > size_ ? new_head + 1 - size_ : 0;
+    if (valid_first > first)
+      events.erase(events.begin(), events.begin() + std::min<std::uint64_t>(valid_first - first, events.size()));
+  }
+
+  /** \brief Remember when the zone entered at \e time started. Only called by the thread owning the buffer. */
+  void enterZone(std::uint64_t time)
+  {
+    if (depth_ < MAX_TIMED_DEPTH)
+      entered_[depth_] = time;
+    ++depth_;
+  }
+
+  /** \brief Count the zone \e id left at \e time. Only called by the thread owning the buffer. */
+  void leaveZone(std::uint32_t id, std::uint64_t time)
+  {
+    if (depth_ == 0)
+      return;
+    --depth_;
+    if (id >= MAX_COUNTED_ZONES || depth_ >= MAX_TIMED_DEPTH)
+      return;
+    // only the owning thread writes, so there is no need for an atomic read-modify-write
+    ZoneCounter& zone = zones_[id];
+    zone.count.store(zone.count.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    zone.total_ns.store(zone.total_ns.load(std::memory_order_relaxed) + (time - entered_[depth_]),
+                        std::memory_order_relaxed);
+  }
+
+  /** \brief Add the zone statistics of this buffer to \e statistics, which has MAX_COUNTED_ZONES entries */
+  void addZoneStatistics(std::vector<ZoneStatistics>& statistics) const
+  {
+    for (std::size_t i = 0; i < MAX_COUNTED_ZONES; ++i)
+    {
+      statistics[i].count += zones_[i].count.load(std::memory_order_relaxed);
+      statistics[i].total_ns += zones_[i].total_ns.load(std::memory_order_relaxed);
+    }
+  }
+
+  /** \brief Hide the events recorded so far from read() */
+  void clear()
+  {
+    cleared_.store(head_.load(std::memory_order_acquire), std::memory_order_relaxed);
+  }
+
+  std::uint32_t index() const
+  {
+    return index_;
+  }
+
+  /** \brief Let the buffer be reused by another thread, once its thread exited */
+  std::atomic<bool>& inUse()
+  {
+    return in_use_;
+  }
+
+private:
+  struct Event
+  {
+    std::atomic<std::uint64_t> time;
+    std::atomic<std::uint64_t> data;
+  };
+
+  struct ZoneCounter
+  {
+    std::atomic<std::uint64_t> count;
+    std::atomic<std::uint64_t> total_ns;
+  };
+
+  std::unique_ptr<Event[]> events_;
+  const std::size_t size_;
+  std::atomic<std::uint64_t> head_;
+  std::atomic<std::uint64_t> cleared_;
+  const std::uint32_t index_;
+  std::atomic<bool> in_use_;
+
+  // the zone statistics survive clear() and reuse of the buffer by another thread, as they are read as differences
+  std::unique_ptr<ZoneCounter[]> zones_;
+  std::uint64_t entered_[MAX_TIMED_DEPTH];
+  std::size_t depth_;
+};
+
+const std::size_t TraceRecorder::MAX_COUNTED_ZONES;
+
+TraceRecorder& TraceRecorder::instance()
+{
+  static TraceRecorder recorder;
+  return recorder;
+}
+
+TraceRecorder::TraceRecorder() : recording_(false), thread_buffer_size_(DEFAULT_THREAD_BUFFER_SIZE)
+{
+  const char* filename = std::getenv("MOVEIT_TRACE_FILE");
+  if (filename && *filename)
+  {
+    exit_trace_file_ = filename;
+    recording_ = true;
+  }
+}
+
+TraceRecorder::~TraceRecorder()
+{
+  if (!exit_trace_file_.empty())
+  {
+    stop();
+    if (!writeChromeTrace(exit_trace_file_))
+      std::cerr << "Failed to write the MoveIt trace to " << exit_trace_file_ << std::endl;
+  }
+}
+
+void TraceRecorder::start()
+{
+  recording_.store(true, std::memory_order_relaxed);
+}
+
+void TraceRecorder::stop()
+{
+  recording_.store(false, std::memory_order_relaxed);
+}
+
+void TraceRecorder::clear()
+{
+  std::lock_guard<std::mutex> _(lock_);
+  for (const std::shared_ptr<ThreadBuffer>& buffer : buffers_)
+    buffer->clear();
+}
+
+std::uint32_t TraceRecorder::intern(const std::string& name)
+{
+  std::lock_guard<std::mutex> _(lock_);
+  std::unordered_map<std::string, std::uint32_t>::const_iterator it = ids_.find(name);
+  if (it != ids_.end())
+    return it->second;
+  names_.push_back(name);
+  return ids_[name] = names_.size() - 1;
+}
+
+void TraceRecorder::setThreadBufferSize(std::size_t events)
+{
+  std::size_t size = 1;
+  while (size < events)
+    size <<= 1;
+  thread_buffer_size_ = size;
+}
+
+TraceRecorder::ThreadBuffer& TraceRecorder::threadBuffer()
+{
+  // returns the buffer for reuse when the thread exits, as threads may come and go a lot
+  struct Holder
+  {
+    std::shared_ptr<ThreadBuffer> buffer;
+    ~Holder()
+    {
+      if (buffer)
+        buffer->inUse() = false;
+    }
+  };
+  static thread_local Holder holder;
+
+  if (!holder.buffer)
+  {
+    std::lock_guard<std::mutex> _(lock_);
+    for (const std::shared_ptr<ThreadBuffer>& buffer : buffers_)
+      if (!buffer->inUse().exchange(true))
+      {
+        holder.buffer = buffer;
+        break;
+      }
+    if (!holder.buffer)
+    {
+      holder.buffer = std::make_shared<ThreadBuffer>(thread_buffer_size_, buffers_.size());
+      buffers_.push_back(holder.buffer);
+    }
+  }
+  return *holder.buffer;
+}
+
+void TraceRecorder::begin(std::uint32_t id)
+{
+  ThreadBuffer& buffer = threadBuffer();
+  const std::uint64_t time = nowNanoseconds();
+  buffer.push(time, static_cast<std::uint64_t>(id) << 1);
+  buffer.enterZone(time);
+}
+
+void TraceRecorder::end(std::uint32_t id)
+{
+  ThreadBuffer& buffer = threadBuffer();
+  const std::uint64_t time = nowNanoseconds();
+  buffer.push(time, (static_cast<std::uint64_t>(id) << 1) | 1);
+  buffer.leaveZone(id, time);
+}
+
+void TraceRecorder::getThreadZoneStatistics(std::vector<ZoneStatistics>& statistics)
+{
+  statistics.assign(MAX_COUNTED_ZONES, ZoneStatistics());
+  threadBuffer().addZoneStatistics(statistics);
+}
+
+void TraceRecorder::getZoneStatistics(std::vector<ZoneStatistics>& statistics)
+{
+  std::vector<std::shared_ptr<ThreadBuffer>> buffers;
+  {
+    std::lock_guard<std::mutex> _(lock_);
+    buffers = buffers_;
+  }
+  statistics.assign(MAX_COUNTED_ZONES, ZoneStatistics());
+  for (const std::shared_ptr<ThreadBuffer>& buffer : buffers)
+    buffer->addZoneStatistics(statistics);
+}
+
+std::vector<std::string> TraceRecorder::getZoneNames()
+{
+  std::lock_guard<std::mutex> _(lock_);
+  return names_;
+}
+
+void TraceRecorder::writeChromeTrace(std::ostream& out)
+{
+  std::vector<std::string> names;
+  std::vector<std::shared_ptr<ThreadBuffer>> buffers;
+  {
+    std::lock_guard<std::mutex> _(lock_);
+    names = names_;
+    buffers = buffers_;
+  }
+
+  const int pid = getpid();
+  std::vector<std::pair<std::uint64_t, std::uint64_t>> events;
+  bool first = true;
+  out << "{\"traceEvents\":[";
+  for (const std::shared_ptr<ThreadBuffer>& buffer : buffers)
+  {
+    buffer->read(events);
+    // the zones entered before the oldest kept event are not in the buffer anymore, so leaving them is left out too
+    std::size_t depth = 0;
+    for (const std::pair<std::uint64_t, std::uint64_t>& event : events)
+    {
+      const bool end = event.second & 1;
+      const std::uint64_t id = event.second >> 1;
+      if (end && depth == 0)
+        continue;
+      depth = end ? depth - 1 : depth + 1;
+
+      out << (first ? "\n" : ",\n") << "{\"name\":\"";
+      writeEscaped(out, id < names.size() ? names[id] : std::string("unknown"));
+      out << "\",\"ph\":\"" << (end ? 'E' : 'B') << "\",\"ts\":" << event.first / 1000 << '.' << std::setw(3)
+          << std::setfill('0') << event.first % 1000 << std::setfill(' ') << ",\"pid\":" << pid
+          << ",\"tid\":" << buffer->index() << '}';
+      first = false;
+    }
+  }
+  out << "\n]}" << std::endl;
+}
+
+bool TraceRecorder::writeChromeTrace(const std::string& filename)
+{
+  std::ofstream out(filename);
+  if (!out)
+    return false;
+  writeChromeTrace(out);
+  return static_cast<bool>(out);
+}
+}  // namespace tools
+}  // namespace moveit
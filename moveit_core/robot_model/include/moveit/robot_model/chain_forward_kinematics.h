@@ -0,0 +1,273 @@
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2026, PickNik LLC.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of PickNik LLC nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *********************************************************************/
+
+#pragma once
+
+#include <moveit/robot_model/joint_model_group.h>
+#include <moveit/robot_model/revolute_joint_model.h>
+#include <moveit/robot_model/prismatic_joint_model.h>
+#include <array>
+#include <cmath>
+#include <stdexcept>
+#include <utility>
+
+namespace moveit
+{
+namespace core
+{
+namespace chain_fk
+{
+/** \brief Post-multiply the column-major 4x4 matrix \e d by a rotation about the principal axis \e AXIS
+    (0 = x, 1 = y, 2 = z), given the cosine \e c and sine \e s of the angle.
+    Only the two columns orthogonal to the axis change, so this needs 12 multiplications instead of 36. */
+template <int AXIS>
+inline void rotateAboutPrincipalAxis(double* d, double c, double s)
+{
+  constexpr int A = ((AXIS + 1) % 3) * 4;
+  constexpr int B = ((AXIS + 2) % 3) * 4;
+  for (int r = 0; r < 3; ++r)
+  {
+    const double a = d[A + r];
+    const double b = d[B + r];
+    d[A + r] = c * a + s * b;
+    d[B + r] = c * b - s * a;
+  }
+}
+
+/** \brief Runtime dispatch of rotateAboutPrincipalAxis() */
+inline void rotateAboutPrincipalAxis(int axis, double* d, double c, double s)
+{
+  switch (axis)
+  {
+    case 0:
+      rotateAboutPrincipalAxis<0>(d, c, s);
+      break;
+    case 1:
+      rotateAboutPrincipalAxis<1>(d, c, s);
+      break;
+    default:
+      rotateAboutPrincipalAxis<2>(d, c, s);
+      break;
+  }
+}
+
+/** \brief Write the rotation about principal axis \e axis into the column-major 4x4 matrix \e d and zero the
+    translation. This produces the same result as RevoluteJointModel::computeTransform() */
+inline void setPrincipalAxisRotation(int axis, double* d, double c, double s)
+{
+  for (int i = 0; i < 3; ++i)
+    for (int r = 0; r < 3; ++r)
+      d[i * 4 + r] = (i == r) ? 1.0 : 0.0;
+  d[12] = d[13] = d[14] = 0.0;
+  rotateAboutPrincipalAxis(axis, d, c, s);
+}
+
+/** \brief Data of one joint of a specialized chain */
+struct ChainJoint
+{
+  EIGEN_MAKE_ALIGNED_OPERATOR_NEW
+
+  const JointModel* joint;
+  /** \brief Transform from the child link of the previous chain joint (or the chain base) to the joint frame,
+      with all fixed joints in between folded in */
+  Eigen::Isometry3d origin;
+  /** \brief Sign of the principal axis of revolute joints */
+  double sign;
+};
+
+/** \brief Revolute joint about the positive or negative principal axis \e AXIS (0 = x, 1 = y, 2 = z) */
+template <int AXIS>
+struct RevolutePrincipal
+{
+  static bool matches(const JointModel* joint, double& sign)
+  {
+    if (joint->getType() != JointModel::REVOLUTE)
+      return false;
+    const RevoluteJointModel* revolute = static_cast<const RevoluteJointModel*>(joint);
+    sign = revolute->getPrincipalAxisSign();
+    return revolute->getPrincipalAxis() == AXIS;
+  }
+
+  static void apply(const ChainJoint& joint, double value, Eigen::Isometry3d& frame)
+  {
+    const double angle = joint.sign * value;
+    rotateAboutPrincipalAxis<AXIS>(frame.data(), std::cos(angle), std::sin(angle));
+  }
+};
+
+using RevoluteX = RevolutePrincipal<0>;
+using RevoluteY = RevolutePrincipal<1>;
+using RevoluteZ = RevolutePrincipal<2>;
+
+/** \brief Revolute joint about an arbitrary axis */
+struct Revolute
+{
+  static bool matches(const JointModel* joint, double& sign)
+  {
+    sign = 1.0;
+    return joint->getType() == JointModel::REVOLUTE;
+  }
+
+  static void apply(const ChainJoint& joint, double value, Eigen::Isometry3d& frame)
+  {
+    Eigen::Isometry3d rotation;
+    // qualified call: no virtual dispatch
+    static_cast<const RevoluteJointModel*>(joint.joint)->RevoluteJointModel::computeTransform(&value, rotation);
+    frame.linear() = frame.linear() * rotation.linear();
+  }
+};
+
+/** \brief Prismatic joint along an arbitrary axis */
+struct Prismatic
+{
+  static bool matches(const JointModel* joint, double& sign)
+  {
+    sign = 1.0;
+    return joint->getType() == JointModel::PRISMATIC;
+  }
+
+  static void apply(const ChainJoint& joint, double value, Eigen::Isometry3d& frame)
+  {
+    frame.translation() += frame.linear() * (static_cast<const PrismaticJointModel*>(joint.joint)->getAxis() * value);
+  }
+};
+
+/** \brief Forward kinematics for a serial chain whose joint types are known at compile time, e.g.
+    \code
+    ChainFK<RevoluteZ, RevoluteY, RevoluteZ, RevoluteY, RevoluteZ, RevoluteY, RevoluteZ> fk(arm_group);
+    \endcode
+    The constructor verifies that \e group is a serial chain of single-DOF, non-mimic joints matching the template
+    arguments and throws std::invalid_argument otherwise. Fixed joints between the active joints are folded into
+    the joint origins, so evaluating the chain costs one transform product and one specialized joint kernel per
+    joint, without virtual calls or checks for mimic joints. */
+template <typename... Joints>
+class ChainFK
+{
+public:
+  EIGEN_MAKE_ALIGNED_OPERATOR_NEW
+
+  static constexpr std::size_t DOF = sizeof...(Joints);
+
+  explicit ChainFK(const JointModelGroup* group)
+  {
+    const std::vector<const JointModel*>& joints = group->getActiveJointModels();
+    if (!group->isChain() || joints.size() != DOF || group->getVariableCount() != DOF)
+      throw std::invalid_argument("Group '" + group->getName() + "' is not a serial chain with " +
+                                  std::to_string(DOF) + " active joints");
+
+    initJoints(group, joints, std::index_sequence_for<Joints...>());
+    tip_ = joints.back()->getChildLinkModel();
+  }
+
+  /** \brief The link the chain is attached to; all transforms are expressed in this frame */
+  const LinkModel* getBaseLink() const
+  {
+    return base_;
+  }
+
+  /** \brief The child link of the last joint of the chain */
+  const LinkModel* getTipLink() const
+  {
+    return tip_;
+  }
+
+  /** \brief Compute the transforms of the child links of all chain joints relative to getBaseLink().
+      \e values holds one value per active joint, in the order of JointModelGroup::getActiveJointModels() */
+  void computeLinkTransforms(const double* values, Eigen::Isometry3d* transforms) const
+  {
+    Eigen::Isometry3d frame = Eigen::Isometry3d::Identity();
+    computeImpl(values, frame, transforms, std::index_sequence_for<Joints...>());
+  }
+
+  /** \brief Compute the transform of getTipLink() relative to getBaseLink() */
+  Eigen::Isometry3d computeTipTransform(const double* values) const
+  {
+    Eigen::Isometry3d frame = Eigen::Isometry3d::Identity();
+    computeImpl(values, frame, nullptr, std::index_sequence_for<Joints...>());
+    return frame;
+  }
+
+private:
+  template <std::size_t... I>
+  void initJoints(const JointModelGroup* group, const std::vector<const JointModel*>& joints,
+                  std::index_sequence<I...> /*unused*/)
+  {
+    const bool matched[DOF] = { Joints::matches(joints[I], joints_[I].sign)... };
+    base_ = joints.front()->getParentLinkModel();
+    const LinkModel* previous = base_;
+    for (std::size_t i = 0; i < DOF; ++i)
+    {
+      if (!matched[i] || joints[i]->getMimic())
+        throw std::invalid_argument("Joint '" + joints[i]->getName() + "' of group '" + group->getName() +
+                                    "' does not match the specialized chain kernel");
+
+      // fold the fixed joints between the previous chain joint and this one
+      Eigen::Isometry3d folded = Eigen::Isometry3d::Identity();
+      for (const LinkModel* link = joints[i]->getParentLinkModel(); link != previous; link = link->getParentLinkModel())
+      {
+        if (!link || !link->parentJointIsFixed())
+          throw std::invalid_argument("Group '" + group->getName() + "' is not a serial chain");
+        folded = link->getJointOriginTransform() * folded;
+      }
+      joints_[i].joint = joints[i];
+      joints_[i].origin = folded * joints[i]->getChildLinkModel()->getJointOriginTransform();
+      previous = joints[i]->getChildLinkModel();
+    }
+  }
+
+  template <std::size_t... I>
+  void computeImpl(const double* values, Eigen::Isometry3d& frame, Eigen::Isometry3d* transforms,
+                   std::index_sequence<I...> /*unused*/) const
+  {
+    // expands to one inlined kernel call per joint, in chain order
+    const int expand[] = { (step<Joints>(joints_[I], values[I], frame, transforms ? transforms + I : nullptr), 0)... };
+    (void)expand;
+  }
+
+  template <typename J>
+  static void step(const ChainJoint& joint, double value, Eigen::Isometry3d& frame, Eigen::Isometry3d* out)
+  {
+    frame = frame * joint.origin;
+    J::apply(joint, value, frame);
+    if (out)
+      *out = frame;
+  }
+
+  std::array<ChainJoint, DOF> joints_;
+  const LinkModel* base_;
+  const LinkModel* tip_;
+};
+}  // namespace chain_fk
+}  // namespace core
+}  // namespace moveit
@@ -0,0 +1,224 @@
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2026, PickNik LLC.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of PickNik LLC nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *********************************************************************/
+
+
+#pragma once
+
+#include <moveit/robot_model/joint_model_group.h>
+#include <moveit/robot_model/revolute_joint_model.h>
+#include <moveit/robot_model/prismatic_joint_model.h>
+
+namespace moveit
+{
+namespace core
+{
+/** \brief Allocation-free computation of the geometric Jacobian of a serial chain and of its time derivative.
+
+    The functions are templated on an accessor returning the global transform of a link, so they work on the link
+    transforms of a RobotState as well as on those computed by BatchForwardKinematics. The Jacobian maps the
+    velocities of the group variables to the linear (first three rows) and angular (last three rows) velocity of the
+    reference point, expressed in the frame of the parent link of the group's root joint. Mimic joints contribute to
+    the column of the joint they mimic. */
+namespace chain_jacobian
+{
+using Matrix6Xd = Eigen::Matrix<double, 6, Eigen::Dynamic>;
+
+/** \brief Get the column of state variable \e variable_index within \e group, or -1 if it is not part of the group.
+    This is a linear search, which is faster than a name lookup for the short chains Jacobians are computed for. */
+inline int getGroupColumn(const JointModelGroup* group, int variable_index)
+{
+  const std::vector<int>& indices = group->getVariableIndexList();
+  for (std::size_t i = 0; i < indices.size(); ++i)
+    if (indices[i] == variable_index)
+      return static_cast<int>(i);
+  return -1;
+}
+
+/** \brief Call \e visit(joint, column, factor, joint_frame) for every joint with variables between \e link and the
+    root of \e group that contributes to the motion of \e link. \e joint_frame is the transform of the child link of
+    the joint, relative to \e reference. Returns false if the chain contains a joint type that is not supported. */
+template <typename GetLinkTransform, typename Visitor>
+bool visitChainJoints(const JointModelGroup* group, const LinkModel* link, const Eigen::Isometry3d& reference,
+                      const GetLinkTransform& get_link_transform, const Visitor& visit)
+{
+  const JointModel* root_joint = group->getJointModels()[0];
+  for (; link; link = link->getParentJointModel()->getParentLinkModel())
+  {
+    const JointModel* joint = link->getParentJointModel();
+    if (joint->getVariableCount() > 0)
+    {
+      const JointModel* active = joint->getMimic() ? joint->getMimic() : joint;
+      const int column = getGroupColumn(group, active->getFirstVariableIndex());
+      if (column >= 0)
+      {
+        if (joint->getType() != JointModel::REVOLUTE && joint->getType() != JointModel::PRISMATIC &&
+            joint->getType() != JointModel::PLANAR)
+          return false;
+        visit(joint, column, joint->getMimic() ? joint->getMimicFactor() : 1.0, reference * get_link_transform(link));
+      }
+    }
+    if (joint == root_joint)
+      break;
+  }
+  return true;
+}
+
+/** \brief Get the transform from the global frame to the frame the Jacobian of \e group is expressed in */
+template <typename GetLinkTransform>
+Eigen::Isometry3d getReferenceTransform(const JointModelGroup* group, const GetLinkTransform& get_link_transform)
+{
+  const LinkModel* root_link = group->getJointModels()[0]->getParentLinkModel();
+  return root_link ? Eigen::Isometry3d(get_link_transform(root_link).inverse()) : Eigen::Isometry3d::Identity();
+}
+
+/** \brief Compute the Jacobian of \e reference_point_position (expressed in the frame of \e link) into \e jacobian,
+    which must have one column per variable of \e group. \e group must be a chain updating \e link; this is not
+    checked. Returns false if the size of \e jacobian or the joint types of the chain are not supported. */
+template <typename GetLinkTransform>
+bool compute(const JointModelGroup* group, const LinkModel* link, const Eigen::Vector3d& reference_point_position,
+             const GetLinkTransform& get_link_transform, Eigen::Ref<Matrix6Xd> jacobian)
+{
+  if (jacobian.cols() != static_cast<Eigen::Index>(group->getVariableCount()))
+    return false;
+
+  const Eigen::Isometry3d reference = getReferenceTransform(group, get_link_transform);
+  const Eigen::Vector3d point = reference * (get_link_transform(link) * reference_point_position);
+  jacobian.setZero();
+  return visitChainJoints(
+      group, link, reference, get_link_transform,
+      [&](const JointModel* joint, int column, double factor, const Eigen::Isometry3d& frame) {
+        if (joint->getType() == JointModel::REVOLUTE)
+        {
+          const Eigen::Vector3d axis = frame.linear() * static_cast<const RevoluteJointModel*>(joint)->getAxis();
+          jacobian.col(column).head<3>() += factor * axis.cross(point - frame.translation());
+          jacobian.col(column).tail<3>() += factor * axis;
+        }
+        else if (joint->getType() == JointModel::PRISMATIC)
+        {
+          const Eigen::Vector3d axis = frame.linear() * static_cast<const PrismaticJointModel*>(joint)->getAxis();
+          jacobian.col(column).head<3>() += factor * axis;
+        }
+        else  // planar: x, y, theta
+        {
+          jacobian.col(column).head<3>() += frame.linear().col(0);
+          jacobian.col(column + 1).head<3>() += frame.linear().col(1);
+          jacobian.col(column + 2).head<3>() += frame.linear().col(2).cross(point - frame.translation());
+          jacobian.col(column + 2).tail<3>() += frame.linear().col(2);
+        }
+      });
+}
+
+/** \brief Compute the time derivative of the Jacobian computed by compute(), for the variable velocities
+    \e velocities (indexed like the variables of the full robot state). Revolute and prismatic joints are supported.
+
+    With z_i the axis and p_i the origin of joint i, the column of a revolute joint is [z_i x (p - p_i); z_i], so its
+    derivative is [dz_i x (p - p_i) + z_i x (dp - dp_i); dz_i], where dz_i = w_i x z_i and w_i, dp_i are the angular
+    velocity and the velocity of p_i caused by the joints preceding i. These are obtained from the totals over the
+    chain minus the sums over the joints following i, so two passes over the chain suffice. */
+template <typename GetLinkTransform>
+bool computeDerivative(const JointModelGroup* group, const LinkModel* link,
+                       const Eigen::Vector3d& reference_point_position, const GetLinkTransform& get_link_transform,
+                       const double* velocities, Eigen::Ref<Matrix6Xd> jacobian_derivative)
+{
+  if (jacobian_derivative.cols() != static_cast<Eigen::Index>(group->getVariableCount()))
+    return false;
+
+  // The velocity of a point x caused by a set of joints is w x x - m + v, with w the sum of qdot * z over the
+  // revolute joints, m the sum of qdot * (z x p) over the revolute joints and v the sum of qdot * z over the
+  // prismatic joints
+  struct Motion
+  {
+    Eigen::Vector3d w = Eigen::Vector3d::Zero();
+    Eigen::Vector3d m = Eigen::Vector3d::Zero();
+    Eigen::Vector3d v = Eigen::Vector3d::Zero();
+  };
+  const auto get_axis = [](const JointModel* joint, const Eigen::Isometry3d& frame) -> Eigen::Vector3d {
+    if (joint->getType() == JointModel::REVOLUTE)
+      return frame.linear() * static_cast<const RevoluteJointModel*>(joint)->getAxis();
+    return frame.linear() * static_cast<const PrismaticJointModel*>(joint)->getAxis();
+  };
+  const auto accumulate = [&](Motion& motion, const JointModel* joint, double factor, const Eigen::Isometry3d& frame,
+                              const Eigen::Vector3d& axis) {
+    const JointModel* active = joint->getMimic() ? joint->getMimic() : joint;
+    const double qdot = factor * velocities[active->getFirstVariableIndex()];
+    if (joint->getType() == JointModel::REVOLUTE)
+    {
+      motion.w += qdot * axis;
+      motion.m += qdot * axis.cross(frame.translation());
+    }
+    else
+      motion.v += qdot * axis;
+  };
+
+  const Eigen::Isometry3d reference = getReferenceTransform(group, get_link_transform);
+  const Eigen::Vector3d point = reference * (get_link_transform(link) * reference_point_position);
+
+  bool supported = true;
+  Motion total;
+  if (!visitChainJoints(group, link, reference, get_link_transform,
+                        [&](const JointModel* joint, int /*column*/, double factor, const Eigen::Isometry3d& frame) {
+                          if (joint->getType() == JointModel::PLANAR)
+                            supported = false;
+                          else
+                            accumulate(total, joint, factor, frame, get_axis(joint, frame));
+                        }) ||
+      !supported)
+    return false;
+  const Eigen::Vector3d point_velocity = total.w.cross(point) - total.m + total.v;
+
+  // walking from the tip to the root, 'following' accumulates the motion caused by joint i and its successors
+  Motion following;
+  jacobian_derivative.setZero();
+  return visitChainJoints(
+      group, link, reference, get_link_transform,
+      [&](const JointModel* joint, int column, double factor, const Eigen::Isometry3d& frame) {
+        const Eigen::Vector3d axis = get_axis(joint, frame);
+        accumulate(following, joint, factor, frame, axis);
+        const Eigen::Vector3d w = total.w - following.w;
+        const Eigen::Vector3d joint_velocity = w.cross(frame.translation()) - (total.m - following.m) +
+                                               (total.v - following.v);
+        const Eigen::Vector3d axis_derivative = w.cross(axis);
+        if (joint->getType() == JointModel::REVOLUTE)
+        {
+          jacobian_derivative.col(column).head<3>() += factor * (axis_derivative.cross(point - frame.translation()) +
+                                                                 axis.cross(point_velocity - joint_velocity));
+          jacobian_derivative.col(column).tail<3>() += factor * axis_derivative;
+        }
+        else
+          jacobian_derivative.col(column).head<3>() += factor * axis_derivative;
+      });
+}
+}  // namespace chain_jacobian
+}  // namespace core
+}  // namespace moveit
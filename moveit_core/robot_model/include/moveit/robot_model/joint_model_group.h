@@ -404,6 +404,11 @@ public:
   double distance(const double* state1, const double* state2) const;
   void interpolate(const double* from, const double* to, double t, double* state) const;
 
+  /** \brief Compute the distance from \e state to each of the \e count group states stored one after another in
+      \e states (getVariableCount() values each), e.g. for nearest-neighbor queries. \e result must hold \e count
+      values. */
+  void distances(const double* state, const double* states, std::size_t count, double* result) const;
+
   /** \brief Get the number of variables that describe this joint group. This includes variables necessary for mimic
       joints, so will always be >= the number of items returned by getActiveVariableNames() */
   unsigned int getVariableCount() const
@@ -742,6 +747,12 @@ protected:
 
   std::vector<GroupMimicUpdate> group_mimic_update_;
 
+  /** \brief Distance factor and wrap flag (1.0 for continuous joints) of every variable. Only filled if the group
+      consists of revolute and prismatic joints without mimic joints, so distance() and interpolate() can use the
+      vectorized joint_space kernels instead of the virtual functions of the joints. */
+  std::vector<double> variable_distance_factors_;
+  std::vector<double> variable_wrap_flags_;
+
   std::pair<KinematicsSolver, KinematicsSolverMap> group_kinematics_;
 
   srdf::Model::Group config_;
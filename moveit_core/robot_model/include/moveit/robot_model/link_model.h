@@ -67,6 +67,18 @@ using LinkModelMapConst = std::map<std::string, const LinkModel*>;
 using LinkTransformMap = std::map<const LinkModel*, Eigen::Isometry3d, std::less<const LinkModel*>,
                                   Eigen::aligned_allocator<std::pair<const LinkModel* const, Eigen::Isometry3d> > >;
 
+/** \brief A sphere that, possibly together with other spheres, encloses a collision shape */
+struct BoundingSphere
+{
+  Eigen::Vector3d center;
+  double radius;
+};
+
+/** \brief Compute a few spheres whose union encloses \e shape, in the frame of the shape. Elongated boxes, cylinders
+    and meshes are split along their longest axis, so the spheres are tighter than a single bounding sphere.
+    Shapes that cannot be bounded (planes, octrees) get no spheres. */
+void computeBoundingSpheres(const shapes::Shape& shape, std::vector<BoundingSphere>& spheres);
+
 /** \brief A link from the robot. Contains the constant transform applied to the link and its geometry */
 class LinkModel
 {
@@ -193,6 +205,13 @@ public:
     return centered_bounding_box_offset_;
   }
 
+  /** \brief Get the bounding spheres of each collision shape (see computeBoundingSpheres()), expressed in the frame of
+      the shape, i.e. relative to getCollisionOriginTransforms(). Scaling and padding are not included. */
+  const std::vector<std::vector<BoundingSphere>>& getShapeBoundingSpheres() const
+  {
+    return shape_bounding_spheres_;
+  }
+
   /** \brief Get the set of links that are attached to this one via fixed transforms. The returned transforms are
    * guaranteed to be valid isometries. */
   const LinkTransformMap& getAssociatedFixedTransforms() const
@@ -268,6 +287,9 @@ private:
   /** \brief Center of the axis aligned bounding box with size shape_extents_ (zero if symmetric along all axes). */
   Eigen::Vector3d centered_bounding_box_offset_;
 
+  /** \brief Bounding spheres of each collision shape, in the frame of the shape */
+  std::vector<std::vector<BoundingSphere>> shape_bounding_spheres_;
+
   /** \brief Filename associated with the visual geometry mesh of this link. If empty, no mesh was used. */
   std::string visual_mesh_filename_;
 
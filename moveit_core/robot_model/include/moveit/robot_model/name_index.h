@@ -0,0 +1,125 @@
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2026, PickNik LLC.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of PickNik LLC nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *********************************************************************/
+
+#pragma once
+
+#include <functional>
+#include <map>
+#include <string>
+#include <vector>
+
+namespace moveit
+{
+namespace core
+{
+class RobotModel;
+class JointModel;
+
+/** \brief Immutable hash table mapping names to indices.
+
+    The table is built once and stored in flat arrays using open addressing, so lookups neither allocate nor lock and
+    usually touch a single slot. This replaces the std::map lookups of RobotModel in hot paths such as message
+    conversion. */
+class NameIndex
+{
+public:
+  NameIndex() = default;
+
+  /** \brief Build an index such that find(names[i]) == i. For duplicated names, the first occurrence is used. */
+  explicit NameIndex(const std::vector<std::string>& names);
+
+  /** \brief Build an index mapping the keys of \e indices to their values */
+  explicit NameIndex(const std::map<std::string, int>& indices);
+
+  /** \brief Get the index of \e name, or -1 if \e name is not known */
+  int find(const std::string& name) const
+  {
+    if (slots_.empty())
+      return -1;
+    const std::size_t hash = std::hash<std::string>()(name);
+    for (std::size_t i = hash & mask_;; i = (i + 1) & mask_)
+    {
+      const Slot& slot = slots_[i];
+      if (slot.name < 0)
+        return -1;
+      if (slot.hash == hash && names_[slot.name] == name)
+        return slot.index;
+    }
+  }
+
+  /** \brief Get the number of names in the index */
+  std::size_t size() const
+  {
+    return names_.size();
+  }
+
+private:
+  struct Slot
+  {
+    std::size_t hash;
+    int name;  // index into names_, -1 for empty slots
+    int index;
+  };
+
+  void insert(const std::string& name, int index);
+
+  std::vector<Slot> slots_;
+  std::vector<std::string> names_;
+  std::size_t mask_ = 0;
+};
+
+/** \brief Cache of the joint models for an ordered list of joint names.
+
+    Messages like sensor_msgs::JointState usually arrive with the same joint names in the same order, so the name
+    lookups only need to be repeated when the names change. */
+class JointNameMapping
+{
+public:
+  /** \brief Make the mapping correspond to \e names for joints of \e model. Returns true if the mapping had to be
+      rebuilt, false if it was already up to date. */
+  bool update(const RobotModel& model, const std::vector<std::string>& names);
+
+  /** \brief Get the joint model of every name passed to update(), or nullptr for unknown names */
+  const std::vector<const JointModel*>& getJointModels() const
+  {
+    return joints_;
+  }
+
+private:
+  const RobotModel* model_ = nullptr;
+  std::vector<std::string> names_;
+  std::vector<const JointModel*> joints_;
+};
+}  // namespace core
+}  // namespace moveit
@@ -84,6 +84,19 @@ public:
   /** \brief Set the axis of rotation */
   void setAxis(const Eigen::Vector3d& axis);
 
+  /** \brief If the axis of rotation is (anti-)parallel to the x, y or z axis, return its index (0, 1, 2),
+      otherwise return -1. Specialized forward kinematics kernels use this to skip the full rotation matrix. */
+  int getPrincipalAxis() const
+  {
+    return principal_axis_;
+  }
+
+  /** \brief The sign (1 or -1) of the principal axis returned by getPrincipalAxis() */
+  double getPrincipalAxisSign() const
+  {
+    return principal_axis_sign_;
+  }
+
 protected:
   /** \brief The axis of the joint */
   Eigen::Vector3d axis_;
@@ -93,6 +106,8 @@ protected:
 
 private:
   double x2_, y2_, z2_, xy_, xz_, yz_;
+  int principal_axis_;
+  double principal_axis_sign_;
 };
 }  // namespace core
 }  // namespace moveit
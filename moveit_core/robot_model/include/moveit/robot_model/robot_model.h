@@ -49,6 +49,7 @@
 #include <moveit/robot_model/planar_joint_model.h>
 #include <moveit/robot_model/revolute_joint_model.h>
 #include <moveit/robot_model/prismatic_joint_model.h>
+#include <moveit/robot_model/name_index.h>
 
 #include <Eigen/Geometry>
 #include <iostream>
@@ -501,6 +502,9 @@ protected:
   /** \brief The vector of link names that corresponds to link_model_vector_ */
   std::vector<std::string> link_model_names_vector_;
 
+  /** \brief Flat index from link names to their index in link_model_vector_, used for lookups by name */
+  NameIndex link_name_index_;
+
   /** \brief Only links that have collision geometry specified */
   std::vector<const LinkModel*> link_models_with_collision_geometry_vector_;
 
@@ -527,6 +531,9 @@ protected:
   /** \brief The vector of joint names that corresponds to joint_model_vector_ */
   std::vector<std::string> joint_model_names_vector_;
 
+  /** \brief Flat index from joint names to their index in joint_model_vector_, used for lookups by name */
+  NameIndex joint_name_index_;
+
   /** \brief The vector of joints in the model, in the order they appear in the state vector */
   std::vector<JointModel*> active_joint_model_vector_;
 
@@ -569,6 +576,9 @@ protected:
       Additionaly, it includes the names of the joints and the index for the first variable of that joint. */
   VariableIndexMap joint_variables_index_map_;
 
+  /** \brief Flat index equivalent to joint_variables_index_map_, used for lookups by name */
+  NameIndex variable_name_index_;
+
   std::vector<int> active_joint_model_start_index_;
 
   /** \brief The bounds for all the active joint models */
@@ -594,6 +604,9 @@ protected:
   /** \brief A vector of all group names, in alphabetical order */
   std::vector<std::string> joint_model_group_names_;
 
+  /** \brief Flat index from group names to their index in joint_model_groups_, used for lookups by name */
+  NameIndex group_name_index_;
+
   /** \brief The array of end-effectors, in alphabetical order */
   std::vector<const JointModelGroup*> end_effectors_;
 
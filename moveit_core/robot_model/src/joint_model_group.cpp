@@ -38,6 +38,7 @@
 #include <moveit/robot_model/robot_model.h>
 #include <moveit/robot_model/joint_model_group.h>
 #include <moveit/robot_model/revolute_joint_model.h>
+#include <moveit/robot_model/joint_space_kernels.h>
 #include <moveit/exceptions/exceptions.h>
 #include <boost/lexical_cast.hpp>
 #include <algorithm>
@@ -162,6 +163,20 @@ JointModelGroup::JointModelGroup(const std::string& group_name, const srdf::Mode
       fixed_joints_.push_back(joint_model);
   }
 
+  // groups of revolute and prismatic joints only have independent, contiguous variables
+  if (mimic_joints_.empty() && variable_count_ > 0 &&
+      std::all_of(active_joint_model_vector_.begin(), active_joint_model_vector_.end(), [](const JointModel* jm) {
+        return jm->getType() == JointModel::REVOLUTE || jm->getType() == JointModel::PRISMATIC;
+      }))
+    for (const JointModel* joint_model : active_joint_model_vector_)
+    {
+      variable_distance_factors_.push_back(joint_model->getDistanceFactor());
+      variable_wrap_flags_.push_back(joint_model->getType() == JointModel::REVOLUTE &&
+                                             static_cast<const RevoluteJointModel*>(joint_model)->isContinuous() ?
+                                         1.0 :
+                                         0.0);
+    }
+
   // now we need to find all the set of joints within this group
   // that root distinct subtrees
   for (const JointModel* active_joint_model : active_joint_model_vector_)
@@ -410,6 +425,10 @@ double JointModelGroup::getMaximumExtent(const JointBoundsVector& active_joint_b
 
 double JointModelGroup::distance(const double* state1, const double* state2) const
 {
+  if (!variable_distance_factors_.empty())
+    return joint_space::distance(state1, state2, variable_distance_factors_.data(), variable_wrap_flags_.data(),
+                                 variable_count_);
+
   double d = 0.0;
   for (std::size_t i = 0; i < active_joint_model_vector_.size(); ++i)
     d += active_joint_model_vector_[i]->getDistanceFactor() *
@@ -418,8 +437,24 @@ double JointModelGroup::distance(const double* state1, const double* state2) con
   return d;
 }
 
+void JointModelGroup::distances(const double* state, const double* states, std::size_t count, double* result) const
+{
+  if (!variable_distance_factors_.empty())
+    joint_space::distances(state, states, count, variable_distance_factors_.data(), variable_wrap_flags_.data(),
+                           variable_count_, result);
+  else
+    for (std::size_t k = 0; k < count; ++k)
+      result[k] = distance(state, states + k * variable_count_);
+}
+
 void JointModelGroup::interpolate(const double* from, const double* to, double t, double* state) const
 {
+  if (!variable_distance_factors_.empty())
+  {
+    joint_space::interpolate(from, to, t, variable_wrap_flags_.data(), variable_count_, state);
+    return;
+  }
+
   // we interpolate values only for active joint models (non-mimic)
   for (std::size_t i = 0; i < active_joint_model_vector_.size(); ++i)
     active_joint_model_vector_[i]->interpolate(from + active_joint_model_start_index_[i],
@@ -39,11 +39,125 @@
 #include <geometric_shapes/check_isometry.h>
 #include <geometric_shapes/shape_operations.h>
 #include <moveit/robot_model/aabb.h>
+#include <algorithm>
+#include <cmath>
 
 namespace moveit
 {
 namespace core
 {
+namespace
+{
+constexpr std::size_t MAX_BOUNDING_SPHERES = 4;
+
+// number of segments an extent of \e length is split into, so that each is about as long as \e width
+std::size_t segmentCount(double length, double width)
+{
+  if (width <= 0.0)
+    return MAX_BOUNDING_SPHERES;
+  const std::size_t count = static_cast<std::size_t>(std::ceil(length / width));
+  return std::max<std::size_t>(1, std::min(MAX_BOUNDING_SPHERES, count));
+}
+
+// spheres enclosing a box (or cylinder) of extent \e length along \e axis, centered at the origin
+void addSegmentSpheres(int axis, double length, double cross_radius, std::size_t count,
+                       std::vector<BoundingSphere>& spheres)
+{
+  const double segment = length / count;
+  const double radius = std::sqrt(cross_radius * cross_radius + 0.25 * segment * segment);
+  for (std::size_t i = 0; i < count; ++i)
+  {
+    BoundingSphere sphere{ Eigen::Vector3d::Zero(), radius };
+    sphere.center[axis] = -0.5 * length + (i + 0.5) * segment;
+    spheres.push_back(sphere);
+  }
+}
+
+void computeMeshBoundingSpheres(const shapes::Mesh& mesh, std::vector<BoundingSphere>& spheres)
+{
+  if (mesh.vertex_count == 0)
+    return;
+  const auto vertex = [&mesh](unsigned int i) { return Eigen::Map<const Eigen::Vector3d>(&mesh.vertices[3 * i]); };
+
+  Eigen::AlignedBox3d aabb;
+  for (unsigned int i = 0; i < mesh.vertex_count; ++i)
+    aabb.extend(vertex(i));
+  const Eigen::Vector3d sizes = aabb.sizes();
+  int axis;
+  sizes.maxCoeff(&axis);
+  const double width = std::max(sizes[(axis + 1) % 3], sizes[(axis + 2) % 3]);
+  const std::size_t count = segmentCount(sizes[axis], width);
+  const double segment = sizes[axis] / count;
+
+  // triangles are assigned to slabs along the longest axis by their centroid; the sphere of a slab encloses all
+  // vertices of its triangles, and with them the triangles themselves
+  const auto slab = [&](double coordinate) {
+    if (segment <= 0.0)
+      return std::size_t(0);
+    return std::min(count - 1, static_cast<std::size_t>((coordinate - aabb.min()[axis]) / segment));
+  };
+  std::vector<Eigen::AlignedBox3d> boxes(count);
+  std::vector<double> radii(count, 0.0);
+  const auto for_each_assignment = [&](const auto& visit) {
+    if (mesh.triangle_count == 0)
+      for (unsigned int i = 0; i < mesh.vertex_count; ++i)
+        visit(slab(vertex(i)[axis]), i);
+    for (unsigned int t = 0; t < mesh.triangle_count; ++t)
+    {
+      const unsigned int* v = &mesh.triangles[3 * t];
+      const std::size_t s = slab((vertex(v[0])[axis] + vertex(v[1])[axis] + vertex(v[2])[axis]) / 3.0);
+      for (int k = 0; k < 3; ++k)
+        visit(s, v[k]);
+    }
+  };
+  for_each_assignment([&](std::size_t s, unsigned int i) { boxes[s].extend(vertex(i)); });
+  for_each_assignment([&](std::size_t s, unsigned int i) {
+    radii[s] = std::max(radii[s], (vertex(i) - boxes[s].center()).norm());
+  });
+  for (std::size_t s = 0; s < count; ++s)
+    if (!boxes[s].isEmpty())
+      spheres.push_back(BoundingSphere{ boxes[s].center(), radii[s] });
+}
+}  // namespace
+
+void computeBoundingSpheres(const shapes::Shape& shape, std::vector<BoundingSphere>& spheres)
+{
+  spheres.clear();
+  switch (shape.type)
+  {
+    case shapes::BOX:
+    {
+      const double* size = static_cast<const shapes::Box&>(shape).size;
+      const int axis = static_cast<int>(std::max_element(size, size + 3) - size);
+      const double a = size[(axis + 1) % 3];
+      const double b = size[(axis + 2) % 3];
+      addSegmentSpheres(axis, size[axis], 0.5 * std::sqrt(a * a + b * b), segmentCount(size[axis], std::max(a, b)),
+                        spheres);
+      break;
+    }
+    case shapes::CYLINDER:
+    {
+      const shapes::Cylinder& cylinder = static_cast<const shapes::Cylinder&>(shape);
+      addSegmentSpheres(2, cylinder.length, cylinder.radius, segmentCount(cylinder.length, 2.0 * cylinder.radius),
+                        spheres);
+      break;
+    }
+    case shapes::MESH:
+      computeMeshBoundingSpheres(static_cast<const shapes::Mesh&>(shape), spheres);
+      break;
+    case shapes::SPHERE:
+    case shapes::CONE:
+    {
+      BoundingSphere sphere;
+      shapes::computeShapeBoundingSphere(&shape, sphere.center, sphere.radius);
+      spheres.push_back(sphere);
+      break;
+    }
+    default:
+      break;
+  }
+}
+
 LinkModel::LinkModel(const std::string& name)
   : name_(name)
   , parent_joint_model_(nullptr)
@@ -78,6 +192,7 @@ void LinkModel::setGeometry(const std::vector<shapes::ShapeConstPtr>& shapes, co
   shapes_ = shapes;
   collision_origin_transform_ = origins;
   collision_origin_transform_is_identity_.resize(collision_origin_transform_.size());
+  shape_bounding_spheres_.resize(shapes_.size());
 
   core::AABB aabb;
 
@@ -90,6 +205,7 @@ void LinkModel::setGeometry(const std::vector<shapes::ShapeConstPtr>& shapes, co
             1 :
             0;
     Eigen::Isometry3d transform = collision_origin_transform_[i];
+    computeBoundingSpheres(*shapes_[i], shape_bounding_spheres_[i]);
 
     if (shapes_[i]->type != shapes::MESH)
     {
@@ -0,0 +1,243 @@
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2026, PickNik LLC.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of PickNik LLC nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *********************************************************************/
+
+#include <moveit/robot_model/mesh_cache.h>
+#include <geometric_shapes/mesh_operations.h>
+#include <ros/console.h>
+#include <ros/package.h>
+#include <boost/filesystem.hpp>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <tuple>
+
+namespace moveit
+{
+namespace core
+{
+namespace
+{
+constexpr char LOGNAME[] = "mesh_cache";
+
+// bump when the layout of cache files changes
+constexpr std::uint32_t CACHE_FILE_MAGIC = 0x434d564d;  // "MVMC"
+constexpr std::uint32_t CACHE_FILE_VERSION = 1;
+
+struct CacheFileHeader
+{
+  std::uint32_t magic;
+  std::uint32_t version;
+  std::uint32_t vertex_count;
+  std::uint32_t triangle_count;
+  std::uint32_t has_triangle_normals;
+  std::uint32_t has_vertex_normals;
+};
+
+using MeshKey = std::tuple<std::string, double, double, double>;
+
+std::mutex& memoryCacheMutex()
+{
+  static std::mutex mutex;
+  return mutex;
+}
+
+std::map<MeshKey, std::shared_ptr<const shapes::Mesh>>& memoryCache()
+{
+  static std::map<MeshKey, std::shared_ptr<const shapes::Mesh>> cache;
+  return cache;
+}
+
+/// Local file referred to by \e resource, or an empty path for remote resources
+boost::filesystem::path resolveResourceFile(const std::string& resource)
+{
+  static const std::string FILE_PREFIX = "file://";
+  static const std::string PACKAGE_PREFIX = "package://";
+  if (resource.compare(0, FILE_PREFIX.size(), FILE_PREFIX) == 0)
+    return resource.substr(FILE_PREFIX.size());
+  if (resource.compare(0, PACKAGE_PREFIX.size(), PACKAGE_PREFIX) == 0)
+  {
+    const std::string path = resource.substr(PACKAGE_PREFIX.size());
+    const std::size_t slash = path.find('/');
+    if (slash == std::string::npos)
+      return boost::filesystem::path();
+    const std::string package_path = ros::package::getPath(path.substr(0, slash));
+    if (package_path.empty())
+      return boost::filesystem::path();
+    return boost::filesystem::path(package_path) / path.substr(slash + 1);
+  }
+  return boost::filesystem::path();
+}
+
+/// Cache file for the mesh of \e resource with \e scale, or an empty path if the disk cache is not used for it
+boost::filesystem::path cacheFile(const std::string& resource, const Eigen::Vector3d& scale)
+{
+  const char* cache_dir = std::getenv("MOVEIT_MESH_CACHE_DIR");
+  if (!cache_dir || !*cache_dir)
+    return boost::filesystem::path();
+  const boost::filesystem::path file = resolveResourceFile(resource);
+  boost::system::error_code ec;
+  if (file.empty() || !boost::filesystem::is_regular_file(file, ec))
+    return boost::filesystem::path();
+  const std::uintmax_t size = boost::filesystem::file_size(file, ec);
+  const std::time_t mtime = boost::filesystem::last_write_time(file, ec);
+  if (ec)
+    return boost::filesystem::path();
+
+  std::stringstream key;
+  key.precision(17);
+  key << resource << '|' << scale.x() << '|' << scale.y() << '|' << scale.z() << '|' << size << '|' << mtime;
+
+  // FNV-1a
+  std::uint64_t hash = 14695981039346656037ull;
+  for (const char c : key.str())
+  {
+    hash ^= static_cast<unsigned char>(c);
+    hash *= 1099511628211ull;
+  }
+  char name[32];
+  std::snprintf(name, sizeof(name), "%016llx.mesh", static_cast<unsigned long long>(hash));
+  return boost::filesystem::path(cache_dir) / name;
+}
+
+shapes::Mesh* readCacheFile(const boost::filesystem::path& path)
+{
+  std::ifstream in(path.string(), std::ios::binary);
+  if (!in)
+    return nullptr;
+  CacheFileHeader header;
+  if (!in.read(reinterpret_cast<char*>(&header), sizeof(header)) || header.magic != CACHE_FILE_MAGIC ||
+      header.version != CACHE_FILE_VERSION)
+    return nullptr;
+
+  auto mesh = std::make_unique<shapes::Mesh>(header.vertex_count, header.triangle_count);
+  in.read(reinterpret_cast<char*>(mesh->vertices), sizeof(double) * 3 * header.vertex_count);
+  in.read(reinterpret_cast<char*>(mesh->triangles), sizeof(unsigned int) * 3 * header.triangle_count);
+  if (header.has_triangle_normals)
+  {
+    mesh->triangle_normals = new double[3 * header.triangle_count];
+    in.read(reinterpret_cast<char*>(mesh->triangle_normals), sizeof(double) * 3 * header.triangle_count);
+  }
+  if (header.has_vertex_normals)
+  {
+    mesh->vertex_normals = new double[3 * header.vertex_count];
+    in.read(reinterpret_cast<char*>(mesh->vertex_normals), sizeof(double) * 3 * header.vertex_count);
+  }
+  if (!in)
+  {
+    ROS_WARN_NAMED(LOGNAME, "Ignoring truncated mesh cache file '%s'", path.string().c_str());
+    return nullptr;
+  }
+  return mesh.release();
+}
+
+void writeCacheFile(const boost::filesystem::path& path, const shapes::Mesh& mesh)
+{
+  // write to a file of our own and rename it, so concurrent readers never see a partial file
+  boost::system::error_code ec;
+  const boost::filesystem::path tmp_path =
+      path.parent_path() / boost::filesystem::unique_path(path.filename().string() + ".%%%%%%%%", ec);
+  if (ec)
+    return;
+  {
+    std::ofstream out(tmp_path.string(), std::ios::binary);
+    if (!out)
+    {
+      ROS_DEBUG_NAMED(LOGNAME, "Cannot write mesh cache file '%s'", tmp_path.string().c_str());
+      return;
+    }
+    CacheFileHeader header;
+    header.magic = CACHE_FILE_MAGIC;
+    header.version = CACHE_FILE_VERSION;
+    header.vertex_count = mesh.vertex_count;
+    header.triangle_count = mesh.triangle_count;
+    header.has_triangle_normals = mesh.triangle_normals != nullptr;
+    header.has_vertex_normals = mesh.vertex_normals != nullptr;
+    out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    out.write(reinterpret_cast<const char*>(mesh.vertices), sizeof(double) * 3 * mesh.vertex_count);
+    out.write(reinterpret_cast<const char*>(mesh.triangles), sizeof(unsigned int) * 3 * mesh.triangle_count);
+    if (mesh.triangle_normals)
+      out.write(reinterpret_cast<const char*>(mesh.triangle_normals), sizeof(double) * 3 * mesh.triangle_count);
+    if (mesh.vertex_normals)
+      out.write(reinterpret_cast<const char*>(mesh.vertex_normals), sizeof(double) * 3 * mesh.vertex_count);
+    if (!out)
+    {
+      out.close();
+      boost::filesystem::remove(tmp_path, ec);
+      return;
+    }
+  }
+  boost::filesystem::rename(tmp_path, path, ec);
+  if (ec)
+    boost::filesystem::remove(tmp_path, ec);
+}
+}  // namespace
+
+shapes::Mesh* loadMeshFromResource(const std::string& resource, const Eigen::Vector3d& scale)
+{
+  const MeshKey key(resource, scale.x(), scale.y(), scale.z());
+  {
+    std::lock_guard<std::mutex> lock(memoryCacheMutex());
+    auto it = memoryCache().find(key);
+    if (it != memoryCache().end())
+      return it->second->clone();
+  }
+
+  const boost::filesystem::path cache_file = cacheFile(resource, scale);
+  shapes::Mesh* mesh = cache_file.empty() ? nullptr : readCacheFile(cache_file);
+  if (!mesh)
+  {
+    mesh = shapes::createMeshFromResource(resource, scale);
+    if (!mesh)
+      return nullptr;
+    if (!cache_file.empty())
+      writeCacheFile(cache_file, *mesh);
+  }
+
+  std::lock_guard<std::mutex> lock(memoryCacheMutex());
+  memoryCache()[key].reset(mesh->clone());
+  return mesh;
+}
+
+void clearMeshCache()
+{
+  std::lock_guard<std::mutex> lock(memoryCacheMutex());
+  memoryCache().clear();
+}
+}  // namespace core
+}  // namespace moveit
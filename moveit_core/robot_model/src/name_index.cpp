@@ -0,0 +1,102 @@
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2026, PickNik LLC.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of PickNik LLC nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *********************************************************************/
+
+#include <moveit/robot_model/name_index.h>
+#include <moveit/robot_model/robot_model.h>
+
+namespace moveit
+{
+namespace core
+{
+namespace
+{
+std::size_t computeCapacity(std::size_t count)
+{
+  // keep the load factor below 0.5, so probe sequences stay short
+  std::size_t capacity = 4;
+  while (capacity < 2 * count)
+    capacity *= 2;
+  return capacity;
+}
+}  // namespace
+
+NameIndex::NameIndex(const std::vector<std::string>& names)
+{
+  names_.reserve(names.size());
+  slots_.assign(computeCapacity(names.size()), Slot{ 0, -1, -1 });
+  mask_ = slots_.size() - 1;
+  for (std::size_t i = 0; i < names.size(); ++i)
+    insert(names[i], static_cast<int>(i));
+}
+
+NameIndex::NameIndex(const std::map<std::string, int>& indices)
+{
+  names_.reserve(indices.size());
+  slots_.assign(computeCapacity(indices.size()), Slot{ 0, -1, -1 });
+  mask_ = slots_.size() - 1;
+  for (const std::pair<const std::string, int>& it : indices)
+    insert(it.first, it.second);
+}
+
+void NameIndex::insert(const std::string& name, int index)
+{
+  const std::size_t hash = std::hash<std::string>()(name);
+  for (std::size_t i = hash & mask_;; i = (i + 1) & mask_)
+  {
+    Slot& slot = slots_[i];
+    if (slot.name < 0)
+    {
+      slot = Slot{ hash, static_cast<int>(names_.size()), index };
+      names_.push_back(name);
+      return;
+    }
+    if (slot.hash == hash && names_[slot.name] == name)
+      return;
+  }
+}
+
+bool JointNameMapping::update(const RobotModel& model, const std::vector<std::string>& names)
+{
+  if (model_ == &model && names_ == names)
+    return false;
+
+  model_ = &model;
+  names_ = names;
+  joints_.resize(names.size());
+  for (std::size_t i = 0; i < names.size(); ++i)
+    joints_[i] = model.getJointModel(names[i]);
+  return true;
+}
+}  // namespace core
+}  // namespace moveit
@@ -40,13 +40,24 @@
 #include <boost/math/constants/constants.hpp>
 #include <algorithm>
 #include <cmath>
+#include <limits>
 
 namespace moveit
 {
 namespace core
 {
 RevoluteJointModel::RevoluteJointModel(const std::string& name)
-  : JointModel(name), axis_(0.0, 0.0, 0.0), continuous_(false), x2_(0.0), y2_(0.0), z2_(0.0), xy_(0.0), xz_(0.0), yz_(0.0)
+  : JointModel(name)
+  , axis_(0.0, 0.0, 0.0)
+  , continuous_(false)
+  , x2_(0.0)
+  , y2_(0.0)
+  , z2_(0.0)
+  , xy_(0.0)
+  , xz_(0.0)
+  , yz_(0.0)
+  , principal_axis_(-1)
+  , principal_axis_sign_(1.0)
 {
   type_ = REVOLUTE;
   variable_names_.push_back(name_);
@@ -72,6 +83,15 @@ void RevoluteJointModel::setAxis(const Eigen::Vector3d& axis)
   xy_ = axis_.x() * axis_.y();
   xz_ = axis_.x() * axis_.z();
   yz_ = axis_.y() * axis_.z();
+
+  principal_axis_ = -1;
+  principal_axis_sign_ = 1.0;
+  for (int i = 0; i < 3; ++i)
+    if (std::fabs(std::fabs(axis_[i]) - 1.0) < std::numeric_limits<double>::epsilon())
+    {
+      principal_axis_ = i;
+      principal_axis_sign_ = axis_[i] > 0.0 ? 1.0 : -1.0;
+    }
 }
 
 void RevoluteJointModel::setContinuous(bool flag)
@@ -36,6 +36,7 @@
 /* Author: Ioan Sucan */
 
 #include <moveit/robot_model/robot_model.h>
+#include <moveit/robot_model/mesh_cache.h>
 #include <geometric_shapes/shape_operations.h>
 #include <boost/math/constants/constants.hpp>
 #include <moveit/profiler/profiler.h>
@@ -108,6 +109,9 @@ void RobotModel::buildModel(const urdf::ModelInterface& urdf_model, const srdf::
 
     ROS_DEBUG_NAMED(LOGNAME, "... computing joint indexing");
     buildJointInfo();
+    link_name_index_ = NameIndex(link_model_names_vector_);
+    joint_name_index_ = NameIndex(joint_model_names_vector_);
+    variable_name_index_ = NameIndex(joint_variables_index_map_);
 
     if (link_models_with_collision_geometry_vector_.empty())
       ROS_WARN_NAMED(LOGNAME, "No geometry is associated to any robot links");
@@ -475,29 +479,23 @@ JointModelGroup* RobotModel::getEndEffector(const std::string& name)
 
 bool RobotModel::hasJointModelGroup(const std::string& name) const
 {
-  return joint_model_group_map_.find(name) != joint_model_group_map_.end();
+  return group_name_index_.find(name) >= 0;
 }
 
 const JointModelGroup* RobotModel::getJointModelGroup(const std::string& name) const
 {
-  JointModelGroupMap::const_iterator it = joint_model_group_map_.find(name);
-  if (it == joint_model_group_map_.end())
-  {
-    ROS_ERROR_NAMED(LOGNAME, "Group '%s' not found in model '%s'", name.c_str(), model_name_.c_str());
-    return nullptr;
-  }
-  return it->second;
+  return const_cast<RobotModel*>(this)->getJointModelGroup(name);
 }
 
 JointModelGroup* RobotModel::getJointModelGroup(const std::string& name)
 {
-  JointModelGroupMap::const_iterator it = joint_model_group_map_.find(name);
-  if (it == joint_model_group_map_.end())
+  const int index = group_name_index_.find(name);
+  if (index < 0)
   {
     ROS_ERROR_NAMED(LOGNAME, "Group '%s' not found in model '%s'", name.c_str(), model_name_.c_str());
     return nullptr;
   }
-  return it->second;
+  return joint_model_groups_[index];
 }
 
 void RobotModel::buildGroups(const srdf::Model& srdf_model)
@@ -547,6 +545,7 @@ void RobotModel::buildGroups(const srdf::Model& srdf_model)
     joint_model_groups_const_.push_back(joint_model_group);
     joint_model_group_names_.push_back(joint_model_group->getName());
   }
+  group_name_index_ = NameIndex(joint_model_group_names_);
 
   buildGroupsInfoSubgroups();
   buildGroupsInfoEndEffectors(srdf_model);
@@ -743,7 +742,9 @@ bool RobotModel::addJointModelGroup(const srdf::Model::Group& gc)
   // add joints from subgroups
   for (const std::string& subgroup : gc.subgroups_)
   {
-    const JointModelGroup* sg = getJointModelGroup(subgroup);
+    // group_name_index_ is only built once all groups are added
+    JointModelGroupMap::const_iterator sg_it = joint_model_group_map_.find(subgroup);
+    const JointModelGroup* sg = sg_it != joint_model_group_map_.end() ? sg_it->second : nullptr;
     if (sg)
     {
       // active joints
@@ -1093,7 +1094,7 @@ shapes::ShapePtr RobotModel::constructShape(const urdf::Geometry* geom)
       if (!mesh->filename.empty())
       {
         Eigen::Vector3d scale(mesh->scale.x, mesh->scale.y, mesh->scale.z);
-        shapes::Mesh* m = shapes::createMeshFromResource(mesh->filename, scale);
+        shapes::Mesh* m = loadMeshFromResource(mesh->filename, scale);
         new_shape = m;
       }
     }
@@ -1108,21 +1109,17 @@ shapes::ShapePtr RobotModel::constructShape(const urdf::Geometry* geom)
 
 bool RobotModel::hasJointModel(const std::string& name) const
 {
-  return joint_model_map_.find(name) != joint_model_map_.end();
+  return joint_name_index_.find(name) >= 0;
 }
 
 bool RobotModel::hasLinkModel(const std::string& name) const
 {
-  return link_model_map_.find(name) != link_model_map_.end();
+  return link_name_index_.find(name) >= 0;
 }
 
 const JointModel* RobotModel::getJointModel(const std::string& name) const
 {
-  JointModelMap::const_iterator it = joint_model_map_.find(name);
-  if (it != joint_model_map_.end())
-    return it->second;
-  ROS_ERROR_NAMED(LOGNAME, "Joint '%s' not found in model '%s'", name.c_str(), model_name_.c_str());
-  return nullptr;
+  return const_cast<RobotModel*>(this)->getJointModel(name);
 }
 
 const JointModel* RobotModel::getJointModel(int index) const
@@ -1138,9 +1135,9 @@ const JointModel* RobotModel::getJointModel(int index) const
 
 JointModel* RobotModel::getJointModel(const std::string& name)
 {
-  JointModelMap::const_iterator it = joint_model_map_.find(name);
-  if (it != joint_model_map_.end())
-    return it->second;
+  const int index = joint_name_index_.find(name);
+  if (index >= 0)
+    return joint_model_vector_[index];
   ROS_ERROR_NAMED(LOGNAME, "Joint '%s' not found in model '%s'", name.c_str(), model_name_.c_str());
   return nullptr;
 }
@@ -1165,9 +1162,9 @@ LinkModel* RobotModel::getLinkModel(const std::string& name, bool* has_link)
 {
   if (has_link)
     *has_link = true;  // Start out optimistic
-  LinkModelMap::const_iterator it = link_model_map_.find(name);
-  if (it != link_model_map_.end())
-    return it->second;
+  const int index = link_name_index_.find(name);
+  if (index >= 0)
+    return link_model_vector_[index];
 
   if (has_link)
     *has_link = false;  // Report failure via argument
@@ -1248,10 +1245,10 @@ void RobotModel::getMissingVariableNames(const std::vector<std::string>& variabl
 
 int RobotModel::getVariableIndex(const std::string& variable) const
 {
-  VariableIndexMap::const_iterator it = joint_variables_index_map_.find(variable);
-  if (it == joint_variables_index_map_.end())
+  const int index = variable_name_index_.find(variable);
+  if (index < 0)
     throw Exception("Variable '" + variable + "' is not known to model '" + model_name_ + "'");
-  return it->second;
+  return index;
 }
 
 double RobotModel::getMaximumExtent(const JointBoundsVector& active_joint_bounds) const
@@ -41,6 +41,7 @@
 #include <boost/filesystem/path.hpp>
 #include <moveit/profiler/profiler.h>
 #include <moveit/utils/robot_model_test_utils.h>
+#include <geometric_shapes/shapes.h>
 
 class LoadPlanningModelsPr2 : public testing::Test
 {
@@ -118,6 +119,88 @@ TEST(SiblingAssociateLinks, SimpleYRobot)
   }
 }
 
+TEST_F(LoadPlanningModelsPr2, NameLookups)
+{
+  for (const moveit::core::LinkModel* link : robot_model_->getLinkModels())
+    EXPECT_EQ(robot_model_->getLinkModel(link->getName()), link);
+  for (const std::string& variable : robot_model_->getVariableNames())
+    EXPECT_EQ(robot_model_->getVariableNames()[robot_model_->getVariableIndex(variable)], variable);
+  for (const moveit::core::JointModelGroup* group : robot_model_->getJointModelGroups())
+    EXPECT_EQ(robot_model_->getJointModelGroup(group->getName()), group);
+
+  EXPECT_FALSE(robot_model_->hasLinkModel("no_such_link"));
+  EXPECT_FALSE(robot_model_->hasJointModel(""));
+  EXPECT_FALSE(robot_model_->hasJointModelGroup("no_such_group"));
+  EXPECT_THROW(robot_model_->getVariableIndex("no_such_variable"), moveit::Exception);
+}
+
+TEST(NameIndex, FindAndMapping)
+{
+  const std::vector<std::string> names = { "a", "b", "c", "a" };
+  moveit::core::NameIndex index(names);
+  EXPECT_EQ(index.size(), 3u);
+  EXPECT_EQ(index.find("a"), 0);
+  EXPECT_EQ(index.find("c"), 2);
+  EXPECT_EQ(index.find("d"), -1);
+  EXPECT_EQ(moveit::core::NameIndex().find("a"), -1);
+
+  moveit::core::RobotModelConstPtr model = moveit::core::loadTestingRobotModel("pr2");
+  moveit::core::JointNameMapping mapping;
+  const std::vector<std::string> joints = { "r_shoulder_pan_joint", "unknown_joint", "torso_lift_joint" };
+  EXPECT_TRUE(mapping.update(*model, joints));
+  EXPECT_FALSE(mapping.update(*model, joints));
+  ASSERT_EQ(mapping.getJointModels().size(), 3u);
+  EXPECT_EQ(mapping.getJointModels()[0], model->getJointModel("r_shoulder_pan_joint"));
+  EXPECT_EQ(mapping.getJointModels()[1], nullptr);
+  EXPECT_TRUE(mapping.update(*model, { "torso_lift_joint" }));
+  EXPECT_EQ(mapping.getJointModels()[0], model->getJointModel("torso_lift_joint"));
+}
+
+namespace
+{
+bool enclosed(const std::vector<moveit::core::BoundingSphere>& spheres, const Eigen::Vector3d& point)
+{
+  for (const moveit::core::BoundingSphere& sphere : spheres)
+    if ((point - sphere.center).norm() <= sphere.radius + 1e-9)
+      return true;
+  return false;
+}
+}  // namespace
+
+TEST_F(LoadPlanningModelsPr2, BoundingSpheres)
+{
+  for (const moveit::core::LinkModel* link : robot_model_->getLinkModelsWithCollisionGeometry())
+  {
+    ASSERT_EQ(link->getShapeBoundingSpheres().size(), link->getShapes().size());
+    for (std::size_t i = 0; i < link->getShapes().size(); ++i)
+    {
+      const std::vector<moveit::core::BoundingSphere>& spheres = link->getShapeBoundingSpheres()[i];
+      EXPECT_LE(spheres.size(), 4u);
+      const shapes::Shape* shape = link->getShapes()[i].get();
+      if (shape->type != shapes::MESH)
+        continue;
+      const shapes::Mesh* mesh = static_cast<const shapes::Mesh*>(shape);
+      ASSERT_FALSE(spheres.empty());
+      for (unsigned int v = 0; v < mesh->vertex_count; ++v)
+        EXPECT_TRUE(enclosed(spheres, Eigen::Map<const Eigen::Vector3d>(&mesh->vertices[3 * v])))
+            << link->getName() << " vertex " << v;
+    }
+  }
+
+  // an elongated box is split along its longest axis, and the spheres enclose all corners
+  const shapes::Box box(0.1, 0.8, 0.2);
+  std::vector<moveit::core::BoundingSphere> spheres;
+  moveit::core::computeBoundingSpheres(box, spheres);
+  EXPECT_EQ(spheres.size(), 4u);
+  for (int corner = 0; corner < 8; ++corner)
+    EXPECT_TRUE(enclosed(spheres, Eigen::Vector3d((corner & 1 ? 0.05 : -0.05), (corner & 2 ? 0.4 : -0.4),
+                                                  (corner & 4 ? 0.1 : -0.1))));
+
+  // planes are unbounded
+  moveit::core::computeBoundingSpheres(shapes::Plane(0.0, 0.0, 1.0, 0.0), spheres);
+  EXPECT_TRUE(spheres.empty());
+}
+
 int main(int argc, char** argv)
 {
   testing::InitGoogleTest(&argc, argv);
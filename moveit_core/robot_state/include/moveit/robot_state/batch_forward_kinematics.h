@@ -0,0 +1,182 @@
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2026, PickNik LLC.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of PickNik LLC nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *********************************************************************/
+
+#pragma once
+
+#include <moveit/robot_state/robot_state.h>
+#include <vector>
+
+namespace moveit
+{
+namespace core
+{
+MOVEIT_CLASS_FORWARD(BatchForwardKinematics);  // Defines BatchForwardKinematicsPtr, ConstPtr, WeakPtr... etc
+
+/** \brief Compute forward kinematics for many states of the same robot in one pass.
+
+    Joint values are stored in structure-of-arrays layout: for every variable of the robot model there is one
+    contiguous row holding the value of that variable for all states of the batch. Link transforms are stored the
+    same way (12 rows per link: the column-major 3x3 rotation followed by the translation), so the revolute and
+    prismatic kernels run as tight loops over the batch that the compiler can vectorize.
+
+    Only link transforms are computed; collision body transforms and attached bodies are left to RobotState. */
+class BatchForwardKinematics
+{
+public:
+  /** \brief Construct a batch evaluator for \e robot_model holding \e batch_size states */
+  BatchForwardKinematics(const RobotModelConstPtr& robot_model, std::size_t batch_size = 0);
+
+  /** \brief Get the robot model this batch is constructed for. */
+  const RobotModelConstPtr& getRobotModel() const
+  {
+    return robot_model_;
+  }
+
+  /** \brief Get the number of states in the batch */
+  std::size_t getBatchSize() const
+  {
+    return batch_size_;
+  }
+
+  /** \brief Change the number of states in the batch. Previously stored values are not preserved. */
+  void setBatchSize(std::size_t batch_size);
+
+  /** \brief Get the row of values for variable \e variable_index (one value per state, getBatchSize() entries) */
+  double* getVariableRow(std::size_t variable_index)
+  {
+    return positions_.data() + variable_index * batch_size_;
+  }
+
+  /** \brief Get the row of values for variable \e variable_index (one value per state, getBatchSize() entries) */
+  const double* getVariableRow(std::size_t variable_index) const
+  {
+    return positions_.data() + variable_index * batch_size_;
+  }
+
+  /** \brief Set all variable positions of state \e state_index. \e positions holds
+      RobotModel::getVariableCount() values, in the order of RobotState::getVariablePositions() */
+  void setVariablePositions(std::size_t state_index, const double* positions);
+
+  /** \brief Copy the variable positions of \e state into slot \e state_index */
+  void setVariablePositions(std::size_t state_index, const RobotState& state)
+  {
+    setVariablePositions(state_index, state.getVariablePositions());
+  }
+
+  /** \brief Copy the variable positions of state \e state_index into \e positions */
+  void copyVariablePositions(std::size_t state_index, double* positions) const;
+
+  /** \brief Set the batch to hold the positions of a sequence of \e states (resizes the batch) */
+  void setStates(const std::vector<const RobotState*>& states);
+
+  /** \brief Fill the batch with \e count states linearly interpolated between \e from and \e to (both included,
+      if \e count > 1), using the interpolation of the joint models of the robot */
+  void interpolate(const RobotState& from, const RobotState& to, std::size_t count);
+
+  /** \brief Compute the global transforms of all links for all states of the batch */
+  void computeLinkTransforms();
+
+  /** \brief Get the global transform of \e link for state \e state_index. computeLinkTransforms() must have been
+      called after the last change of variable values. */
+  Eigen::Isometry3d getGlobalLinkTransform(std::size_t state_index, const LinkModel* link) const;
+
+  /** \brief Get the translation of \e link for state \e state_index */
+  Eigen::Vector3d getGlobalLinkTranslation(std::size_t state_index, const LinkModel* link) const;
+
+  /** \brief Compute the Jacobians of \e reference_point_position on \e link for chain group \e group for all states
+      of the batch, like RobotState::getJacobian() does for one state. The Jacobian of state i is stored in the block
+      of columns [i * n, (i + 1) * n) of \e jacobians, with n the number of variables of \e group; \e jacobians is
+      only reallocated if its size changes. computeLinkTransforms() must have been called before.
+      Throws std::invalid_argument if \e group is not a chain updating \e link or contains unsupported joints. */
+  void computeJacobians(const JointModelGroup* group, const LinkModel* link,
+                        const Eigen::Vector3d& reference_point_position,
+                        Eigen::Matrix<double, 6, Eigen::Dynamic>& jacobians) const;
+
+private:
+  /** \brief How the transform of a link's parent joint is evaluated */
+  enum class JointKernel
+  {
+    FIXED,
+    REVOLUTE,
+    PRISMATIC,
+    GENERIC
+  };
+
+  /** \brief Precomputed per-link data, stored in the order links are evaluated (parents before children) */
+  struct LinkStep
+  {
+    JointKernel kernel;
+    const JointModel* joint;
+    int link_index;
+    int parent_link_index;  // -1 for the root link
+    int variable_index;     // first variable of the parent joint (after resolving mimic joints)
+    double mimic_factor;
+    double mimic_offset;
+    double origin[12];  // column-major 3x4 joint origin transform
+    double axis[3];
+    // precomputed terms of the Rodrigues formula for revolute joints
+    double x2, y2, z2, xy, xz, yz;
+  };
+
+  double* linkRow(int link_index, int component)
+  {
+    return transforms_.data() + (static_cast<std::size_t>(link_index) * 12 + component) * batch_size_;
+  }
+
+  const double* linkRow(int link_index, int component) const
+  {
+    return transforms_.data() + (static_cast<std::size_t>(link_index) * 12 + component) * batch_size_;
+  }
+
+  /** \brief Compute the parent transform times the joint origin into \e out (12 rows of batch_size_ values) */
+  void computeOriginFrames(const LinkStep& step, double* out) const;
+  void applyRevolute(const LinkStep& step, const double* frames);
+  void applyPrismatic(const LinkStep& step, const double* frames);
+  void applyGeneric(const LinkStep& step, const double* frames);
+
+  RobotModelConstPtr robot_model_;
+  std::size_t batch_size_;
+  std::vector<LinkStep> steps_;
+
+  /** \brief Variable positions, positions_[variable * batch_size_ + state] */
+  std::vector<double> positions_;
+
+  /** \brief Link transforms, transforms_[(link * 12 + component) * batch_size_ + state] */
+  std::vector<double> transforms_;
+
+  /** \brief Scratch memory for the composed parent * origin frames of a single link */
+  std::vector<double> frames_;
+};
+}  // namespace core
+}  // namespace moveit
@@ -92,6 +92,25 @@ struct MaxEEFStep
   double rotation;     // Radians
 };
 
+/** \brief Struct for enabling Jacobian stepping in computeCartesianPath
+
+    When enabled, each step of the path is reached by a few damped pseudo-inverse Jacobian iterations from the previous
+    state, which is much cheaper than an IK query. The IK solver is only called for steps that the iterations do not
+    reach within the tolerances. The validity callback is not passed to these queries, but evaluated for all states of
+    the path at once after it was computed; the path is truncated before the first invalid state. */
+struct JacobianStepping
+{
+  explicit JacobianStepping(bool enabled = false) : enabled(enabled)
+  {
+  }
+
+  bool enabled;
+  double translation_tolerance = 1e-5;  // Meters
+  double rotation_tolerance = 1e-4;     // Radians
+  unsigned int max_iterations = 5;
+  double damping = 1e-3;
+};
+
 class CartesianInterpolator
 {
   // TODO(mlautman): Eventually, this planner should be moved out of robot_state
@@ -108,6 +127,8 @@ public:
      call to setFromIK(). In case of IK failure, the computation of the path stops and the value returned corresponds to
      the distance that was achieved and for which corresponding states were added to the path.  At the end of the
      function call, the state of the group corresponds to the last attempted Cartesian pose.
+     The states in \e traj are copies of \e start_state, so if \e start_state was constructed with a RobotStatePool,
+     all of them draw their memory from that pool.
 
      During the computation of the trajectory, it is usually preferred if consecutive joint values do not 'jump' by a
      large amount in joint space, even if the Cartesian distance between the corresponding points is small as expected.
@@ -154,7 +175,8 @@ public:
      In contrast to the previous function, the Cartesian path is specified as a target frame to be reached (\e target)
      for a virtual frame attached to the robot \e link with the given \e link_offset.
      The target frame is assumed to be specified either w.r.t. to the global reference frame or the virtual link frame.
-     This function returns the fraction (0..1) of path that was achieved. All other comments from the previous function apply. */
+     This function returns the fraction (0..1) of path that was achieved. All other comments from the previous function apply.
+     If \e jacobian_stepping is enabled, consecutive states are computed by Jacobian stepping, see JacobianStepping. */
   static double
   computeCartesianPath(RobotState* start_state, const JointModelGroup* group,
                        std::vector<std::shared_ptr<RobotState>>& traj, const LinkModel* link,
@@ -162,7 +184,8 @@ public:
                        const JumpThreshold& jump_threshold,
                        const GroupStateValidityCallbackFn& validCallback = GroupStateValidityCallbackFn(),
                        const kinematics::KinematicsQueryOptions& options = kinematics::KinematicsQueryOptions(),
-                       const Eigen::Isometry3d& link_offset = Eigen::Isometry3d::Identity());
+                       const Eigen::Isometry3d& link_offset = Eigen::Isometry3d::Identity(),
+                       const JacobianStepping& jacobian_stepping = JacobianStepping());
 
   /** \brief Compute the sequence of joint values that perform a general Cartesian path.
 
@@ -177,7 +200,8 @@ public:
                        const MaxEEFStep& max_step, const JumpThreshold& jump_threshold,
                        const GroupStateValidityCallbackFn& validCallback = GroupStateValidityCallbackFn(),
                        const kinematics::KinematicsQueryOptions& options = kinematics::KinematicsQueryOptions(),
-                       const Eigen::Isometry3d& link_offset = Eigen::Isometry3d::Identity());
+                       const Eigen::Isometry3d& link_offset = Eigen::Isometry3d::Identity(),
+                       const JacobianStepping& jacobian_stepping = JacobianStepping());
 
   /** \brief Tests joint space jumps of a trajectory.
 
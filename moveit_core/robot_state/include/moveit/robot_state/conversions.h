@@ -139,5 +139,60 @@ void robotStateToStream(const RobotState& state, std::ostream& out,
  * \return true on success
  */
 void streamToRobotState(RobotState& state, const std::string& line, const std::string& separator = ",");
+
+/**
+ * @brief Reusable conversions between RobotState and messages of a fixed layout.
+ *
+ * The free conversion functions look up every joint by name and rebuild the output messages from scratch. Components
+ * like move_group, servo or the execution manager convert messages of the same layout over and over, so this class
+ * caches the mapping from the joint names of incoming messages to variable indices (rebuilt only when the names
+ * change) and fills outgoing messages in place, reusing their memory. The results are the same as for the free
+ * functions. A plan is not thread-safe; use one per thread.
+ */
+class RobotStateConversionPlan
+{
+public:
+  explicit RobotStateConversionPlan(const RobotModelConstPtr& robot_model);
+
+  const RobotModelConstPtr& getRobotModel() const
+  {
+    return robot_model_;
+  }
+
+  /** @brief Same as moveit::core::jointStateToRobotState() */
+  bool jointStateToRobotState(const sensor_msgs::JointState& joint_state, RobotState& state);
+
+  /**
+   * @brief Same as moveit::core::robotStateMsgToRobotState(), including incremental (is_diff) updates of the
+   * attached bodies. \e tf is used to transform multi-DOF joint states and attached objects if given.
+   */
+  bool robotStateMsgToRobotState(const moveit_msgs::RobotState& robot_state, RobotState& state,
+                                 bool copy_attached_bodies = true, const Transforms* tf = nullptr);
+
+  /** @brief Same as moveit::core::robotStateToJointStateMsg(), but reusing the memory of \e joint_state */
+  void robotStateToJointStateMsg(const RobotState& state, sensor_msgs::JointState& joint_state) const;
+
+  /** @brief Same as moveit::core::robotStateToRobotStateMsg(), but reusing the memory of \e robot_state */
+  void robotStateToRobotStateMsg(const RobotState& state, moveit_msgs::RobotState& robot_state,
+                                 bool copy_attached_bodies = true) const;
+
+private:
+  /** @brief Update the variable indices for the names of an incoming joint state message if they changed */
+  void mapVariables(const std::vector<std::string>& names);
+
+  /** @brief Set the variables of \e joint_state in \e state, without updating its transforms */
+  bool setJointState(const sensor_msgs::JointState& joint_state, RobotState& state);
+
+  RobotModelConstPtr robot_model_;
+
+  // incoming messages
+  std::vector<std::string> variable_names_;
+  std::vector<int> variable_indices_;
+  JointNameMapping multi_dof_mapping_;
+
+  // outgoing messages
+  std::vector<std::string> single_dof_names_;
+  std::vector<int> single_dof_indices_;
+};
 }  // namespace core
 }  // namespace moveit
@@ -45,6 +45,7 @@
 #include <std_msgs/ColorRGBA.h>
 #include <geometry_msgs/Twist.h>
 #include <cassert>
+#include <memory>
 
 #include <boost/assert.hpp>
 
@@ -59,7 +60,8 @@ namespace moveit
 {
 namespace core
 {
-MOVEIT_CLASS_FORWARD(RobotState);  // Defines RobotStatePtr, ConstPtr, WeakPtr... etc
+MOVEIT_CLASS_FORWARD(RobotState);      // Defines RobotStatePtr, ConstPtr, WeakPtr... etc
+MOVEIT_CLASS_FORWARD(RobotStatePool);  // Defines RobotStatePoolPtr, ConstPtr, WeakPtr... etc
 
 /** \brief Signature for functions that can verify that if the group \e joint_group in \e robot_state is set to \e
    joint_group_variable_values
@@ -92,9 +94,13 @@ public:
   /** \brief A state can be constructed from a specified robot model. No values are initialized.
       Call setToDefaultValues() if a state needs to provide valid information. */
   RobotState(const RobotModelConstPtr& robot_model);
+
+  /** \brief Construct a state whose memory is drawn from (and returned to) \e pool.
+      Copies of this state share the pool. The pool must have been created for \e robot_model. */
+  RobotState(const RobotModelConstPtr& robot_model, const RobotStatePoolPtr& pool);
   ~RobotState();
 
-  /** \brief Copy constructor. */
+  /** \brief Copy constructor. If \e other uses a RobotStatePool, the copy draws its memory from the same pool. */
   RobotState(const RobotState& other);
 
   /** \brief Copy operator */
@@ -106,6 +112,37 @@ public:
     return robot_model_;
   }
 
+  /** \brief Get the pool the memory of this state is drawn from (nullptr if allocated on the heap) */
+  const RobotStatePoolPtr& getMemoryPool() const
+  {
+    return memory_pool_;
+  }
+
+  /** \brief Enable copy-on-write sharing of the link and collision body transforms for copies of this state.
+
+      When enabled and the link transforms are up to date, the first copy moves the transforms into an immutable,
+      reference-counted snapshot. All further copies share that snapshot instead of copying the transforms, until
+      this state or the copy computes transforms again. This is meant for states that are copied often but rarely
+      modified, such as the current state of a planning scene. Copies of a state that shares a snapshot always
+      share it too, independently of this setting. Disabled by default. */
+  void setShareTransformsOnCopy(bool share)
+  {
+    share_transforms_on_copy_ = share;
+  }
+
+  /** \brief Check whether copies of this state share its transforms, see setShareTransformsOnCopy() */
+  bool getShareTransformsOnCopy() const
+  {
+    return share_transforms_on_copy_;
+  }
+
+  /** \brief Check whether the link and collision body transforms of this state are read from a snapshot shared
+      with other states */
+  bool hasSharedTransforms() const
+  {
+    return global_link_transforms_ != variable_joint_transforms_ + robot_model_->getJointModelCount();
+  }
+
   /** \brief Get the number of variables that make up this state. */
   std::size_t getVariableCount() const
   {
@@ -633,6 +670,14 @@ public:
    *   of mimic joints), set those as the new values that correspond to the group */
   void setJointGroupPositions(const JointModelGroup* group, const double* gstate);
 
+  /** \brief Notify the state that the positions of the variables of \e group were written in place, through
+   *   getVariablePositions(). Mimic joints are updated and the transforms below the group are marked dirty, as
+   *   setJointGroupPositions() would do. This avoids the forced full update otherwise needed after such writes. */
+  void markJointGroupPositionsChanged(const JointModelGroup* group)
+  {
+    updateMimicJoints(group);
+  }
+
   /** \brief Given positions for the variables that make up a group, in the order found in the group (including values
    *   of mimic joints), set those as the new values that correspond to the group */
   void setJointGroupPositions(const std::string& joint_group_name, const Eigen::VectorXd& values)
@@ -1081,6 +1126,20 @@ public:
     return setFromIK(group, poses, tips, consistency_limits, timeout, constraint, options);
   }
 
+  /**
+      \brief setFromIK for a single tip that searches KinematicsQueryOptions::parallel_seeds seeds concurrently.
+      Each round solves all seeds with a single attempt through searchPositionIKBatch(); the first seed of the first
+      round is \e seed, all others are random. The valid solution closest to \e seed ends the search, the remaining
+      seeds of later rounds are never started.
+      @param ik_query The pose of the solver tip, in the frame of the solver
+      @param seed The initial joint values, in the order of the solver
+      @param timeout The total time spent on all rounds
+      @param constraint A state validity constraint to be required for IK solutions */
+  bool setFromIKParallelSeeds(const JointModelGroup* group, const kinematics::KinematicsBaseConstPtr& solver,
+                              const geometry_msgs::Pose& ik_query, const std::vector<double>& seed, double timeout,
+                              const GroupStateValidityCallbackFn& constraint,
+                              const kinematics::KinematicsQueryOptions& options);
+
   /**
       \brief setFromIK for multiple poses and tips (end effectors) when no solver exists for the jmg that can solver for
       non-chain kinematics. In this case, we divide the group into subgroups and do IK solving individually
@@ -1225,6 +1284,59 @@ public:
                                                              use_quaternion_representation);
   }
 
+  /** \brief Compute the Jacobian with reference to a particular point on a given link, for a specified group, into
+   * a fixed-size matrix without allocating memory. Rows are the linear and angular velocity of the reference point,
+   * expressed in the frame of the parent link of the group's root joint; the quaternion representation is not
+   * supported. \e DOF must match the number of variables of \e group. If \e DOF is Eigen::Dynamic, \e jacobian
+   * has to be resized to the number of variables beforehand.
+   * \param group The group to compute the Jacobian for
+   * \param link The link model to compute the Jacobian for
+   * \param reference_point_position The reference point position (with respect to the link specified in link)
+   * \param jacobian The resultant jacobian
+   * \return True if jacobian was successfully computed, false otherwise
+   */
+  template <int DOF>
+  bool getJacobian(const JointModelGroup* group, const LinkModel* link, const Eigen::Vector3d& reference_point_position,
+                   Eigen::Matrix<double, 6, DOF>& jacobian) const
+  {
+    return computeJacobian(group, link, reference_point_position, jacobian, nullptr);
+  }
+
+  /** \brief Compute the Jacobian with reference to a particular point on a given link, for a specified group, into
+   * a fixed-size matrix without allocating memory. See the const version for details. */
+  template <int DOF>
+  bool getJacobian(const JointModelGroup* group, const LinkModel* link, const Eigen::Vector3d& reference_point_position,
+                   Eigen::Matrix<double, 6, DOF>& jacobian)
+  {
+    updateLinkTransforms();
+    return static_cast<const RobotState*>(this)->getJacobian(group, link, reference_point_position, jacobian);
+  }
+
+  /** \brief Compute the time derivative of the Jacobian computed by the fixed-size getJacobian(), for the current
+   * variable velocities of this state. Only revolute and prismatic joints are supported. No memory is allocated.
+   * \param group The group to compute the Jacobian derivative for
+   * \param link The link model to compute the Jacobian derivative for
+   * \param reference_point_position The reference point position (with respect to the link specified in link)
+   * \param jacobian_derivative The resultant derivative, with one column per variable of \e group
+   * \return True if the derivative was successfully computed, false otherwise (e.g. if the state has no velocities)
+   */
+  bool getJacobianDerivative(const JointModelGroup* group, const LinkModel* link,
+                             const Eigen::Vector3d& reference_point_position,
+                             Eigen::Ref<Eigen::Matrix<double, 6, Eigen::Dynamic>> jacobian_derivative) const
+  {
+    return computeJacobian(group, link, reference_point_position, jacobian_derivative, velocity_);
+  }
+
+  /** \brief Compute the time derivative of the Jacobian. See the const version for details. */
+  bool getJacobianDerivative(const JointModelGroup* group, const LinkModel* link,
+                             const Eigen::Vector3d& reference_point_position,
+                             Eigen::Ref<Eigen::Matrix<double, 6, Eigen::Dynamic>> jacobian_derivative)
+  {
+    updateLinkTransforms();
+    return static_cast<const RobotState*>(this)->getJacobianDerivative(group, link, reference_point_position,
+                                                                       jacobian_derivative);
+  }
+
   /** \brief Compute the Jacobian with reference to the last link of a specified group. If the group is not a chain, an
    * exception is thrown.
    * \param group The group to compute the Jacobian for
@@ -1864,6 +1976,11 @@ public:
   bool setToIKSolverFrame(Eigen::Isometry3d& pose, const std::string& ik_frame);
 
 private:
+  friend class RobotStatePool;
+
+  /** \brief Number of bytes allocMemory() needs for a state of \e robot_model */
+  static std::size_t getMemoryBlockSize(const RobotModel& robot_model);
+
   void allocMemory();
   void initTransforms();
   void copyFrom(const RobotState& other);
@@ -1871,19 +1988,31 @@ private:
   void markDirtyJointTransforms(const JointModel* joint)
   {
     dirty_joint_transforms_[joint->getJointIndex()] = 1;
-    dirty_link_transforms_ =
-        dirty_link_transforms_ == nullptr ? joint : robot_model_->getCommonRoot(dirty_link_transforms_, joint);
+    addDirtySubtree(dirty_link_subtrees_, dirty_link_transforms_, joint);
   }
 
   void markDirtyJointTransforms(const JointModelGroup* group)
   {
     for (const JointModel* jm : group->getActiveJointModels())
       dirty_joint_transforms_[jm->getJointIndex()] = 1;
-    dirty_link_transforms_ = dirty_link_transforms_ == nullptr ?
-                                 group->getCommonRoot() :
-                                 robot_model_->getCommonRoot(dirty_link_transforms_, group->getCommonRoot());
+    addDirtySubtree(dirty_link_subtrees_, dirty_link_transforms_, group->getCommonRoot());
   }
 
+  /** \brief A small set of disjoint subtrees, identified by their root joints, whose transforms are dirty */
+  struct DirtySubtrees
+  {
+    static constexpr std::size_t CAPACITY = 4;
+    const JointModel* roots[CAPACITY];
+    std::size_t count = 0;
+  };
+
+  /** \brief Add the subtree rooted at \e joint to \e subtrees and update \e common_root to the common root of all
+      dirty subtrees. Subtrees already covered are ignored and subtrees covered by \e joint are dropped. If more than
+      DirtySubtrees::CAPACITY disjoint subtrees become dirty, they are merged into the subtree below \e common_root.
+      The dirty pointers (dirty_link_transforms_, dirty_collision_body_transforms_) must only be set through this
+      function, so the subtrees stay in sync with them. */
+  void addDirtySubtree(DirtySubtrees& subtrees, const JointModel*& common_root, const JointModel* joint) const;
+
   void markVelocity();
   void markAcceleration();
   void markEffort();
@@ -1927,6 +2056,20 @@ private:
 
   void updateLinkTransformsInternal(const JointModel* start);
 
+  /** \brief Called before the link or collision body transforms are written: if they are read from a shared
+      snapshot, copy them into memory_ and drop the snapshot */
+  void unshareTransforms();
+
+  /** \brief Update the transform of \e link if its parent joint is a revolute joint about a principal axis,
+      using the specialized chain_fk kernels. Returns false (and does nothing) for all other joints. */
+  bool updatePrincipalAxisLinkTransform(const LinkModel* link, int idx_link, int idx_parent);
+
+  /** \brief Allocation-free implementation of the fixed-size getJacobian() and, if \e velocities is given, of
+      getJacobianDerivative() */
+  bool computeJacobian(const JointModelGroup* group, const LinkModel* link,
+                       const Eigen::Vector3d& reference_point_position,
+                       Eigen::Ref<Eigen::Matrix<double, 6, Eigen::Dynamic>> result, const double* velocities) const;
+
   void getMissingKeys(const std::map<std::string, double>& variable_map,
                       std::vector<std::string>& missing_variables) const;
   void getStateTreeJointString(std::ostream& ss, const JointModel* jm, const std::string& pfx0, bool last) const;
@@ -1941,6 +2084,7 @@ private:
   bool checkCollisionTransforms() const;
 
   RobotModelConstPtr robot_model_;
+  RobotStatePoolPtr memory_pool_;
   void* memory_;
 
   double* position_;
@@ -1954,6 +2098,11 @@ private:
   const JointModel* dirty_link_transforms_;
   const JointModel* dirty_collision_body_transforms_;
 
+  // Disjoint dirty subtrees below dirty_link_transforms_ resp. dirty_collision_body_transforms_, so that touching
+  // e.g. both wrists of a dual-arm robot does not recompute the whole tree below their common root
+  DirtySubtrees dirty_link_subtrees_;
+  DirtySubtrees dirty_collision_subtrees_;
+
   // All the following transform variables point into aligned memory in memory_
   // They are updated lazily, based on the flags in dirty_joint_transforms_
   // resp. the pointers dirty_link_transforms_ and dirty_collision_body_transforms_
@@ -1962,6 +2111,13 @@ private:
   Eigen::Isometry3d* global_collision_body_transforms_;  ///< Transforms from model frame to collision bodies
   unsigned char* dirty_joint_transforms_;
 
+  // Immutable copy of the link transforms followed by the collision body transforms, shared with copies of this
+  // state. While it is set, its content equals the transforms of this state, and global_link_transforms_ and
+  // global_collision_body_transforms_ may point into it instead of memory_ (see hasSharedTransforms()).
+  // Copies of a const state create it, so it is only accessed with std::atomic_load() / std::atomic_store().
+  mutable std::shared_ptr<const EigenSTL::vector_Isometry3d> transform_snapshot_;
+  bool share_transforms_on_copy_;
+
   /** \brief All attached bodies that are part of this state, indexed by their name */
   std::map<std::string, std::unique_ptr<AttachedBody>> attached_body_map_;
 
@@ -0,0 +1,103 @@
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2026, PickNik LLC.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of PickNik LLC nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *********************************************************************/
+
+#pragma once
+
+#include <moveit/robot_state/robot_state.h>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace moveit
+{
+namespace core
+{
+/** \brief A pool of memory blocks for RobotState instances of one robot model.
+
+    Every RobotState owns one contiguous block holding positions, velocities, accelerations, transforms and dirty
+    flags. States constructed with a pool (and all their copies) take their block from the pool and give it back
+    when they are destroyed, so building long trajectories out of short-lived states does not hit the heap
+    allocator for every waypoint. Blocks returned to the pool are kept until release() is called or the pool
+    is destroyed; states keep their pool alive, so a pool can safely be dropped while states are still in use.
+
+    The pool is thread-safe. Create it with std::make_shared. */
+class RobotStatePool : public std::enable_shared_from_this<RobotStatePool>
+{
+public:
+  /** \brief Construct a pool for states of \e robot_model, preallocating \e reserve blocks */
+  RobotStatePool(const RobotModelConstPtr& robot_model, std::size_t reserve = 0);
+  ~RobotStatePool();
+
+  RobotStatePool(const RobotStatePool&) = delete;
+  RobotStatePool& operator=(const RobotStatePool&) = delete;
+
+  /** \brief Get the robot model the pooled states are constructed for */
+  const RobotModelConstPtr& getRobotModel() const
+  {
+    return robot_model_;
+  }
+
+  /** \brief Construct a new state (no values initialized) whose memory is taken from this pool */
+  RobotStatePtr allocate();
+
+  /** \brief Construct a copy of \e state whose memory is taken from this pool */
+  RobotStatePtr clone(const RobotState& state);
+
+  /** \brief Make sure at least \e count blocks are available without further allocation */
+  void reserve(std::size_t count);
+
+  /** \brief Free all cached blocks at once. Blocks in use by states are not affected. */
+  void release();
+
+  /** \brief Number of blocks currently cached (not used by any state) */
+  std::size_t getCachedBlockCount() const;
+
+  /** \brief Number of blocks currently used by states */
+  std::size_t getUsedBlockCount() const;
+
+private:
+  friend class RobotState;
+
+  void* acquireBlock();
+  void releaseBlock(void* block);
+
+  RobotModelConstPtr robot_model_;
+  std::size_t block_size_;
+
+  mutable std::mutex lock_;
+  std::vector<void*> free_blocks_;
+  std::size_t used_blocks_;
+};
+}  // namespace core
+}  // namespace moveit
@@ -0,0 +1,355 @@
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2026, PickNik LLC.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of PickNik LLC nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *********************************************************************/
+
+#include <moveit/robot_state/batch_forward_kinematics.h>
+#include <moveit/robot_model/revolute_joint_model.h>
+#include <moveit/robot_model/prismatic_joint_model.h>
+#include <moveit/robot_model/chain_jacobian.h>
+#include <algorithm>
+#include <cmath>
+
+namespace moveit
+{
+namespace core
+{
+namespace
+{
+// Copy the affine part of an isometry into a column-major 3x4 array
+void toArray(const Eigen::Isometry3d& t, double* out)
+{
+  const auto& rot = t.linear();
+  for (int c = 0; c < 3; ++c)
+    for (int r = 0; r < 3; ++r)
+      out[c * 3 + r] = rot(r, c);
+  out[9] = t.translation().x();
+  out[10] = t.translation().y();
+  out[11] = t.translation().z();
+}
+}  // namespace
+
+BatchForwardKinematics::BatchForwardKinematics(const RobotModelConstPtr& robot_model, std::size_t batch_size)
+  : robot_model_(robot_model), batch_size_(0)
+{
+  if (robot_model == nullptr)
+    throw std::invalid_argument("BatchForwardKinematics cannot be constructed with nullptr RobotModelConstPtr");
+
+  const std::vector<const LinkModel*>& links = robot_model_->getRootJoint()->getDescendantLinkModels();
+  steps_.reserve(links.size());
+  for (const LinkModel* link : links)
+  {
+    LinkStep step;
+    const JointModel* joint = link->getParentJointModel();
+    step.joint = joint;
+    step.link_index = link->getLinkIndex();
+    step.parent_link_index = link->getParentLinkModel() ? link->getParentLinkModel()->getLinkIndex() : -1;
+    step.variable_index = joint->getFirstVariableIndex();
+    step.mimic_factor = 1.0;
+    step.mimic_offset = 0.0;
+    toArray(link->getJointOriginTransform(), step.origin);
+    std::fill(step.axis, step.axis + 3, 0.0);
+    step.x2 = step.y2 = step.z2 = step.xy = step.xz = step.yz = 0.0;
+
+    if (joint->getMimic() && (joint->getType() == JointModel::REVOLUTE || joint->getType() == JointModel::PRISMATIC))
+    {
+      step.variable_index = joint->getMimic()->getFirstVariableIndex();
+      step.mimic_factor = joint->getMimicFactor();
+      step.mimic_offset = joint->getMimicOffset();
+    }
+
+    switch (joint->getType())
+    {
+      case JointModel::FIXED:
+        step.kernel = JointKernel::FIXED;
+        break;
+      case JointModel::REVOLUTE:
+      {
+        step.kernel = JointKernel::REVOLUTE;
+        const Eigen::Vector3d& axis = static_cast<const RevoluteJointModel*>(joint)->getAxis();
+        step.axis[0] = axis.x();
+        step.axis[1] = axis.y();
+        step.axis[2] = axis.z();
+        step.x2 = axis.x() * axis.x();
+        step.y2 = axis.y() * axis.y();
+        step.z2 = axis.z() * axis.z();
+        step.xy = axis.x() * axis.y();
+        step.xz = axis.x() * axis.z();
+        step.yz = axis.y() * axis.z();
+        break;
+      }
+      case JointModel::PRISMATIC:
+      {
+        step.kernel = JointKernel::PRISMATIC;
+        const Eigen::Vector3d& axis = static_cast<const PrismaticJointModel*>(joint)->getAxis();
+        step.axis[0] = axis.x();
+        step.axis[1] = axis.y();
+        step.axis[2] = axis.z();
+        break;
+      }
+      default:
+        step.kernel = JointKernel::GENERIC;
+        break;
+    }
+    steps_.push_back(step);
+  }
+
+  setBatchSize(batch_size);
+}
+
+void BatchForwardKinematics::setBatchSize(std::size_t batch_size)
+{
+  batch_size_ = batch_size;
+  positions_.assign(robot_model_->getVariableCount() * batch_size_, 0.0);
+  transforms_.assign(robot_model_->getLinkModelCount() * 12 * batch_size_, 0.0);
+  frames_.assign(12 * batch_size_, 0.0);
+}
+
+void BatchForwardKinematics::setVariablePositions(std::size_t state_index, const double* positions)
+{
+  assert(state_index < batch_size_);
+  const std::size_t n = robot_model_->getVariableCount();
+  for (std::size_t v = 0; v < n; ++v)
+    positions_[v * batch_size_ + state_index] = positions[v];
+}
+
+void BatchForwardKinematics::copyVariablePositions(std::size_t state_index, double* positions) const
+{
+  assert(state_index < batch_size_);
+  const std::size_t n = robot_model_->getVariableCount();
+  for (std::size_t v = 0; v < n; ++v)
+    positions[v] = positions_[v * batch_size_ + state_index];
+}
+
+void BatchForwardKinematics::setStates(const std::vector<const RobotState*>& states)
+{
+  setBatchSize(states.size());
+  for (std::size_t i = 0; i < states.size(); ++i)
+    setVariablePositions(i, *states[i]);
+}
+
+void BatchForwardKinematics::interpolate(const RobotState& from, const RobotState& to, std::size_t count)
+{
+  setBatchSize(count);
+  std::vector<double> tmp(robot_model_->getVariableCount());
+  for (std::size_t i = 0; i < count; ++i)
+  {
+    const double t = count > 1 ? static_cast<double>(i) / static_cast<double>(count - 1) : 0.0;
+    robot_model_->interpolate(from.getVariablePositions(), to.getVariablePositions(), t, tmp.data());
+    setVariablePositions(i, tmp.data());
+  }
+}
+
+void BatchForwardKinematics::computeOriginFrames(const LinkStep& step, double* out) const
+{
+  const std::size_t n = batch_size_;
+  const double* o = step.origin;
+  if (step.parent_link_index < 0)
+  {
+    for (int c = 0; c < 12; ++c)
+      std::fill(out + c * n, out + (c + 1) * n, o[c]);
+    return;
+  }
+
+  const double* p = linkRow(step.parent_link_index, 0);
+  // out = P * O, for every column j of the rotation and for the translation
+  for (int j = 0; j < 3; ++j)
+    for (int r = 0; r < 3; ++r)
+    {
+      const double* p0 = p + r * n;
+      const double* p1 = p + (3 + r) * n;
+      const double* p2 = p + (6 + r) * n;
+      double* d = out + (j * 3 + r) * n;
+      const double o0 = o[j * 3], o1 = o[j * 3 + 1], o2 = o[j * 3 + 2];
+      for (std::size_t i = 0; i < n; ++i)
+        d[i] = p0[i] * o0 + p1[i] * o1 + p2[i] * o2;
+    }
+  for (int r = 0; r < 3; ++r)
+  {
+    const double* p0 = p + r * n;
+    const double* p1 = p + (3 + r) * n;
+    const double* p2 = p + (6 + r) * n;
+    const double* pt = p + (9 + r) * n;
+    double* d = out + (9 + r) * n;
+    for (std::size_t i = 0; i < n; ++i)
+      d[i] = p0[i] * o[9] + p1[i] * o[10] + p2[i] * o[11] + pt[i];
+  }
+}
+
+void BatchForwardKinematics::applyRevolute(const LinkStep& step, const double* frames)
+{
+  const std::size_t n = batch_size_;
+  const double* q = positions_.data() + step.variable_index * n;
+  double* out = linkRow(step.link_index, 0);
+  const double ax = step.axis[0], ay = step.axis[1], az = step.axis[2];
+
+  for (std::size_t i = 0; i < n; ++i)
+  {
+    const double angle = step.mimic_factor * q[i] + step.mimic_offset;
+    const double c = std::cos(angle);
+    const double s = std::sin(angle);
+    const double t = 1.0 - c;
+
+    // column-major rotation about the joint axis, identical to RevoluteJointModel::computeTransform()
+    const double j00 = t * step.x2 + c, j10 = t * step.xy + az * s, j20 = t * step.xz - ay * s;
+    const double j01 = t * step.xy - az * s, j11 = t * step.y2 + c, j21 = t * step.yz + ax * s;
+    const double j02 = t * step.xz + ay * s, j12 = t * step.yz - ax * s, j22 = t * step.z2 + c;
+
+    for (int r = 0; r < 3; ++r)
+    {
+      const double f0 = frames[r * n + i];
+      const double f1 = frames[(3 + r) * n + i];
+      const double f2 = frames[(6 + r) * n + i];
+      out[r * n + i] = f0 * j00 + f1 * j10 + f2 * j20;
+      out[(3 + r) * n + i] = f0 * j01 + f1 * j11 + f2 * j21;
+      out[(6 + r) * n + i] = f0 * j02 + f1 * j12 + f2 * j22;
+      out[(9 + r) * n + i] = frames[(9 + r) * n + i];
+    }
+  }
+}
+
+void BatchForwardKinematics::applyPrismatic(const LinkStep& step, const double* frames)
+{
+  const std::size_t n = batch_size_;
+  const double* q = positions_.data() + step.variable_index * n;
+  double* out = linkRow(step.link_index, 0);
+
+  std::copy(frames, frames + 9 * n, out);
+  for (int r = 0; r < 3; ++r)
+  {
+    const double* f0 = frames + r * n;
+    const double* f1 = frames + (3 + r) * n;
+    const double* f2 = frames + (6 + r) * n;
+    const double* ft = frames + (9 + r) * n;
+    double* d = out + (9 + r) * n;
+    for (std::size_t i = 0; i < n; ++i)
+    {
+      const double v = step.mimic_factor * q[i] + step.mimic_offset;
+      d[i] = ft[i] + v * (f0[i] * step.axis[0] + f1[i] * step.axis[1] + f2[i] * step.axis[2]);
+    }
+  }
+}
+
+void BatchForwardKinematics::applyGeneric(const LinkStep& step, const double* frames)
+{
+  const std::size_t n = batch_size_;
+  const std::size_t var_count = step.joint->getVariableCount();
+  double* out = linkRow(step.link_index, 0);
+  double values[7];  // floating joints have the largest number of variables
+  assert(var_count <= 7);
+  Eigen::Isometry3d joint_transform;
+  joint_transform.makeAffine();
+  double f[12], j[12];
+  for (std::size_t i = 0; i < n; ++i)
+  {
+    for (std::size_t v = 0; v < var_count; ++v)
+      values[v] = positions_[(step.variable_index + v) * n + i];
+    step.joint->computeTransform(values, joint_transform);
+    toArray(joint_transform, j);
+    for (int c = 0; c < 12; ++c)
+      f[c] = frames[c * n + i];
+    for (int col = 0; col < 3; ++col)
+      for (int r = 0; r < 3; ++r)
+        out[(col * 3 + r) * n + i] = f[r] * j[col * 3] + f[3 + r] * j[col * 3 + 1] + f[6 + r] * j[col * 3 + 2];
+    for (int r = 0; r < 3; ++r)
+      out[(9 + r) * n + i] = f[r] * j[9] + f[3 + r] * j[10] + f[6 + r] * j[11] + f[9 + r];
+  }
+}
+
+void BatchForwardKinematics::computeLinkTransforms()
+{
+  if (batch_size_ == 0)
+    return;
+  for (const LinkStep& step : steps_)
+  {
+    if (step.kernel == JointKernel::FIXED)
+    {
+      // the composed frame is the final transform, no scratch memory needed
+      computeOriginFrames(step, linkRow(step.link_index, 0));
+      continue;
+    }
+    computeOriginFrames(step, frames_.data());
+    switch (step.kernel)
+    {
+      case JointKernel::REVOLUTE:
+        applyRevolute(step, frames_.data());
+        break;
+      case JointKernel::PRISMATIC:
+        applyPrismatic(step, frames_.data());
+        break;
+      default:
+        applyGeneric(step, frames_.data());
+        break;
+    }
+  }
+}
+
+Eigen::Isometry3d BatchForwardKinematics::getGlobalLinkTransform(std::size_t state_index, const LinkModel* link) const
+{
+  assert(state_index < batch_size_);
+  const double* base = linkRow(link->getLinkIndex(), 0) + state_index;
+  Eigen::Isometry3d result;
+  result.makeAffine();
+  for (int c = 0; c < 3; ++c)
+    for (int r = 0; r < 3; ++r)
+      result.linear()(r, c) = base[(c * 3 + r) * batch_size_];
+  result.translation() = getGlobalLinkTranslation(state_index, link);
+  return result;
+}
+
+Eigen::Vector3d BatchForwardKinematics::getGlobalLinkTranslation(std::size_t state_index, const LinkModel* link) const
+{
+  assert(state_index < batch_size_);
+  const double* base = linkRow(link->getLinkIndex(), 9) + state_index;
+  return Eigen::Vector3d(base[0], base[batch_size_], base[2 * batch_size_]);
+}
+
+void BatchForwardKinematics::computeJacobians(const JointModelGroup* group, const LinkModel* link,
+                                              const Eigen::Vector3d& reference_point_position,
+                                              Eigen::Matrix<double, 6, Eigen::Dynamic>& jacobians) const
+{
+  if (!group->isChain() || !group->isLinkUpdated(link->getName()))
+    throw std::invalid_argument("Group '" + group->getName() + "' is not a chain updating link '" + link->getName() +
+                                "'");
+
+  const std::size_t columns = group->getVariableCount();
+  jacobians.resize(Eigen::NoChange, columns * batch_size_);
+  for (std::size_t i = 0; i < batch_size_; ++i)
+  {
+    const auto get_link_transform = [this, i](const LinkModel* l) { return getGlobalLinkTransform(i, l); };
+    if (!chain_jacobian::compute(group, link, reference_point_position, get_link_transform,
+                                 jacobians.middleCols(i * columns, columns)))
+      throw std::invalid_argument("Group '" + group->getName() + "' contains joints not supported in Jacobians");
+  }
+}
+}  // namespace core
+}  // namespace moveit
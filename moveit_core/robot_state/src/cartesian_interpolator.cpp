@@ -38,6 +38,7 @@
 
 #include <memory>
 #include <moveit/robot_state/cartesian_interpolator.h>
+#include <Eigen/Cholesky>
 #include <geometric_shapes/check_isometry.h>
 
 namespace moveit
@@ -52,6 +53,48 @@ static const std::size_t MIN_STEPS_FOR_JUMP_THRESH = 10;
 
 const std::string LOGNAME = "cartesian_interpolator";
 
+namespace
+{
+/** \brief Move \e state towards the pose \e target of the virtual frame \e link * \e link_offset by damped
+    least-squares Jacobian iterations. Returns true if the pose was reached within the tolerances of \e stepping. */
+bool stepTowardsPose(RobotState& state, const JointModelGroup* group, const LinkModel* link,
+                     const Eigen::Isometry3d& link_offset, const Eigen::Isometry3d& target,
+                     const JacobianStepping& stepping, Eigen::Matrix<double, 6, Eigen::Dynamic>& jacobian,
+                     Eigen::VectorXd& positions)
+{
+  // the Jacobian is expressed in the frame of the parent link of the group's root joint
+  const LinkModel* root_link = group->getJointModels()[0]->getParentLinkModel();
+  for (unsigned int iteration = 0;; ++iteration)
+  {
+    state.updateLinkTransforms();
+    const Eigen::Isometry3d pose = state.getGlobalLinkTransform(link) * link_offset;
+    const Eigen::AngleAxisd rotation_error(target.linear() * pose.linear().transpose());
+    Eigen::Matrix<double, 6, 1> error;
+    error.head<3>() = target.translation() - pose.translation();
+    error.tail<3>() = rotation_error.angle() * rotation_error.axis();
+    if (error.head<3>().norm() <= stepping.translation_tolerance &&
+        std::fabs(rotation_error.angle()) <= stepping.rotation_tolerance)
+      return true;
+    if (iteration == stepping.max_iterations || !state.getJacobian(group, link, link_offset.translation(), jacobian))
+      return false;
+
+    if (root_link)
+    {
+      const Eigen::Matrix3d root_rotation = state.getGlobalLinkTransform(root_link).linear().transpose();
+      error.head<3>() = root_rotation * error.head<3>();
+      error.tail<3>() = root_rotation * error.tail<3>();
+    }
+    const Eigen::Matrix<double, 6, 6> damped =
+        jacobian * jacobian.transpose() +
+        stepping.damping * stepping.damping * Eigen::Matrix<double, 6, 6>::Identity();
+    positions += jacobian.transpose() * damped.ldlt().solve(error);
+    state.setJointGroupPositions(group, positions);
+    state.enforceBounds(group);
+    state.copyJointGroupPositions(group, positions);
+  }
+}
+}  // namespace
+
 double CartesianInterpolator::computeCartesianPath(RobotState* start_state, const JointModelGroup* group,
                                                    std::vector<RobotStatePtr>& traj, const LinkModel* link,
                                                    const Eigen::Vector3d& translation, bool global_reference_frame,
@@ -77,7 +120,8 @@ double CartesianInterpolator::computeCartesianPath(RobotState* start_state, cons
                                                    const MaxEEFStep& max_step, const JumpThreshold& jump_threshold,
                                                    const GroupStateValidityCallbackFn& validCallback,
                                                    const kinematics::KinematicsQueryOptions& options,
-                                                   const Eigen::Isometry3d& link_offset)
+                                                   const Eigen::Isometry3d& link_offset,
+                                                   const JacobianStepping& jacobian_stepping)
 {
   // check unsanitized inputs for non-isometry
   ASSERT_ISOMETRY(target)
@@ -149,6 +193,13 @@ double CartesianInterpolator::computeCartesianPath(RobotState* start_state, cons
   traj.clear();
   traj.push_back(std::make_shared<moveit::core::RobotState>(*start_state));
 
+  // With Jacobian stepping, IK is only a fallback and validity is checked for all states at the end
+  const GroupStateValidityCallbackFn& ik_callback =
+      jacobian_stepping.enabled ? GroupStateValidityCallbackFn() : validCallback;
+  Eigen::Matrix<double, 6, Eigen::Dynamic> jacobian(6, group->getVariableCount());
+  Eigen::VectorXd positions;
+  Eigen::VectorXd previous_positions;
+
   double last_valid_percentage = 0.0;
   for (std::size_t i = 1; i <= steps; ++i)
   {
@@ -157,9 +208,20 @@ double CartesianInterpolator::computeCartesianPath(RobotState* start_state, cons
     Eigen::Isometry3d pose(start_quaternion.slerp(percentage, target_quaternion));
     pose.translation() = percentage * rotated_target.translation() + (1 - percentage) * start_pose.translation();
 
+    bool stepped = false;
+    if (jacobian_stepping.enabled)
+    {
+      start_state->copyJointGroupPositions(group, positions);
+      previous_positions = positions;
+      stepped = stepTowardsPose(*start_state, group, link, link_offset, pose, jacobian_stepping, jacobian, positions);
+      if (!stepped)  // seed IK from the previous state, as without stepping
+        start_state->setJointGroupPositions(group, previous_positions);
+    }
+
     // Explicitly use a single IK attempt only: We want a smooth trajectory.
     // Random seeding (of additional attempts) would probably create IK jumps.
-    if (start_state->setFromIK(group, pose * offset, link->getName(), consistency_limits, 0.0, validCallback, options))
+    if (stepped ||
+        start_state->setFromIK(group, pose * offset, link->getName(), consistency_limits, 0.0, ik_callback, options))
       traj.push_back(std::make_shared<moveit::core::RobotState>(*start_state));
     else
       break;
@@ -167,6 +229,21 @@ double CartesianInterpolator::computeCartesianPath(RobotState* start_state, cons
     last_valid_percentage = percentage;
   }
 
+  if (jacobian_stepping.enabled && validCallback)
+  {
+    std::vector<double> values;
+    for (std::size_t i = 1; i < traj.size(); ++i)
+    {
+      traj[i]->copyJointGroupPositions(group, values);
+      if (!validCallback(traj[i].get(), group, values.data()))
+      {
+        traj.resize(i);
+        last_valid_percentage = (double)(i - 1) / (double)steps;
+        break;
+      }
+    }
+  }
+
   last_valid_percentage *= checkJointSpaceJump(group, traj, jump_threshold);
 
   return last_valid_percentage;
@@ -176,7 +253,8 @@ double CartesianInterpolator::computeCartesianPath(
     RobotState* start_state, const JointModelGroup* group, std::vector<RobotStatePtr>& traj, const LinkModel* link,
     const EigenSTL::vector_Isometry3d& waypoints, bool global_reference_frame, const MaxEEFStep& max_step,
     const JumpThreshold& jump_threshold, const GroupStateValidityCallbackFn& validCallback,
-    const kinematics::KinematicsQueryOptions& options, const Eigen::Isometry3d& link_offset)
+    const kinematics::KinematicsQueryOptions& options, const Eigen::Isometry3d& link_offset,
+    const JacobianStepping& jacobian_stepping)
 {
   double percentage_solved = 0.0;
   for (std::size_t i = 0; i < waypoints.size(); ++i)
@@ -186,7 +264,7 @@ double CartesianInterpolator::computeCartesianPath(
     std::vector<RobotStatePtr> waypoint_traj;
     double wp_percentage_solved =
         computeCartesianPath(start_state, group, waypoint_traj, link, waypoints[i], global_reference_frame, max_step,
-                             NO_JOINT_SPACE_JUMP_TEST, validCallback, options, link_offset);
+                             NO_JOINT_SPACE_JUMP_TEST, validCallback, options, link_offset, jacobian_stepping);
     if (fabs(wp_percentage_solved - 1.0) < std::numeric_limits<double>::epsilon())
     {
       percentage_solved = (double)(i + 1) / (double)waypoints.size();
@@ -66,8 +66,10 @@ static bool _jointStateToRobotState(const sensor_msgs::JointState& joint_state,
   return true;
 }
 
+// joint_models optionally holds the joint models matching mjs.joint_names, to avoid looking them up by name
 static bool _multiDOFJointsToRobotState(const sensor_msgs::MultiDOFJointState& mjs, RobotState& state,
-                                        const Transforms* tf)
+                                        const Transforms* tf,
+                                        const std::vector<const JointModel*>* joint_models = nullptr)
 {
   std::size_t nj = mjs.joint_names.size();
   if (nj != mjs.transforms.size())
@@ -110,7 +112,12 @@ static bool _multiDOFJointsToRobotState(const sensor_msgs::MultiDOFJointState& m
   for (std::size_t i = 0; i < nj; ++i)
   {
     const std::string& joint_name = mjs.joint_names[i];
-    if (!state.getRobotModel()->hasJointModel(joint_name))
+    const JointModel* joint_model = nullptr;
+    if (joint_models)
+      joint_model = (*joint_models)[i];
+    else if (state.getRobotModel()->hasJointModel(joint_name))
+      joint_model = state.getRobotModel()->getJointModel(joint_name);
+    if (!joint_model)
     {
       ROS_WARN_NAMED(LOGNAME, "No joint matching multi-dof joint '%s'", joint_name.c_str());
       error = true;
@@ -121,7 +128,7 @@ static bool _multiDOFJointsToRobotState(const sensor_msgs::MultiDOFJointState& m
     if (use_inv_t)
       transf = transf * inv_t;
 
-    state.setJointPositions(joint_name, transf);
+    state.setJointPositions(joint_model, transf);
   }
 
   return !error;
@@ -130,10 +137,12 @@ static bool _multiDOFJointsToRobotState(const sensor_msgs::MultiDOFJointState& m
 static inline void _robotStateToMultiDOFJointState(const RobotState& state, sensor_msgs::MultiDOFJointState& mjs)
 {
   const std::vector<const JointModel*>& js = state.getRobotModel()->getMultiDOFJointModels();
-  mjs.joint_names.clear();
-  mjs.transforms.clear();
-  for (const JointModel* joint_model : js)
+  // assign element-wise, so repeated conversions into the same message reuse its memory
+  mjs.joint_names.resize(js.size());
+  mjs.transforms.resize(js.size());
+  for (std::size_t i = 0; i < js.size(); ++i)
   {
+    const JointModel* joint_model = js[i];
     geometry_msgs::TransformStamped p;
     if (state.dirtyJointTransform(joint_model))
     {
@@ -144,8 +153,8 @@ static inline void _robotStateToMultiDOFJointState(const RobotState& state, sens
     }
     else
       p = tf2::eigenToTransform(state.getJointTransform(joint_model));
-    mjs.joint_names.push_back(joint_model->getName());
-    mjs.transforms.push_back(p.transform);
+    mjs.joint_names[i] = joint_model->getName();
+    mjs.transforms[i] = p.transform;
   }
   mjs.header.frame_id = state.getRobotModel()->getModelFrame();
 }
@@ -348,6 +357,15 @@ static void _msgToAttachedBody(const Transforms* tf, const moveit_msgs::Attached
     ROS_ERROR_NAMED(LOGNAME, "Unknown collision object operation: %d", aco.object.operation);
 }
 
+static void _attachedBodiesMsgToRobotState(const Transforms* tf, const moveit_msgs::RobotState& robot_state,
+                                           RobotState& state)
+{
+  if (!robot_state.is_diff)
+    state.clearAttachedBodies();
+  for (const moveit_msgs::AttachedCollisionObject& attached_collision_object : robot_state.attached_collision_objects)
+    _msgToAttachedBody(tf, attached_collision_object, state);
+}
+
 static bool _robotStateMsgToRobotStateHelper(const Transforms* tf, const moveit_msgs::RobotState& robot_state,
                                              RobotState& state, bool copy_attached_bodies)
 {
@@ -365,12 +383,7 @@ static bool _robotStateMsgToRobotStateHelper(const Transforms* tf, const moveit_
   valid = result1 || result2;
 
   if (valid && copy_attached_bodies)
-  {
-    if (!robot_state.is_diff)
-      state.clearAttachedBodies();
-    for (const moveit_msgs::AttachedCollisionObject& attached_collision_object : robot_state.attached_collision_objects)
-      _msgToAttachedBody(tf, attached_collision_object, state);
-  }
+    _attachedBodiesMsgToRobotState(tf, robot_state, state);
 
   return valid;
 }
@@ -553,5 +566,113 @@ void streamToRobotState(RobotState& state, const std::string& line, const std::s
   }
 }
 
+RobotStateConversionPlan::RobotStateConversionPlan(const RobotModelConstPtr& robot_model) : robot_model_(robot_model)
+{
+  for (const JointModel* joint_model : robot_model_->getSingleDOFJointModels())
+  {
+    single_dof_names_.push_back(joint_model->getName());
+    single_dof_indices_.push_back(joint_model->getFirstVariableIndex());
+  }
+}
+
+void RobotStateConversionPlan::mapVariables(const std::vector<std::string>& names)
+{
+  if (names == variable_names_)
+    return;
+  // getVariableIndex() throws for unknown names, like RobotState::setVariablePositions() does
+  std::vector<int> indices(names.size());
+  for (std::size_t i = 0; i < names.size(); ++i)
+    indices[i] = robot_model_->getVariableIndex(names[i]);
+  variable_indices_.swap(indices);
+  variable_names_ = names;
+}
+
+bool RobotStateConversionPlan::setJointState(const sensor_msgs::JointState& joint_state, RobotState& state)
+{
+  if (joint_state.name.size() != joint_state.position.size())
+  {
+    ROS_ERROR_NAMED(LOGNAME, "Different number of names and positions in JointState message: %zu, %zu",
+                    joint_state.name.size(), joint_state.position.size());
+    return false;
+  }
+
+  mapVariables(joint_state.name);
+  const std::size_t n = variable_indices_.size();
+  for (std::size_t i = 0; i < n; ++i)
+    state.setVariablePosition(variable_indices_[i], joint_state.position[i]);
+  if (joint_state.velocity.size() == n && n > 0)
+    for (std::size_t i = 0; i < n; ++i)
+      state.setVariableVelocity(variable_indices_[i], joint_state.velocity[i]);
+  return true;
+}
+
+bool RobotStateConversionPlan::jointStateToRobotState(const sensor_msgs::JointState& joint_state, RobotState& state)
+{
+  bool result = setJointState(joint_state, state);
+  state.update();
+  return result;
+}
+
+bool RobotStateConversionPlan::robotStateMsgToRobotState(const moveit_msgs::RobotState& robot_state, RobotState& state,
+                                                         bool copy_attached_bodies, const Transforms* tf)
+{
+  bool valid = false;
+  if (!robot_state.is_diff && robot_state.joint_state.name.empty() &&
+      robot_state.multi_dof_joint_state.joint_names.empty())
+    ROS_ERROR_NAMED(LOGNAME, "Found empty JointState message");
+  else
+  {
+    bool result1 = setJointState(robot_state.joint_state, state);
+    multi_dof_mapping_.update(*robot_model_, robot_state.multi_dof_joint_state.joint_names);
+    bool result2 = _multiDOFJointsToRobotState(robot_state.multi_dof_joint_state, state, tf,
+                                               &multi_dof_mapping_.getJointModels());
+    valid = result1 || result2;
+
+    if (valid && copy_attached_bodies)
+      _attachedBodiesMsgToRobotState(tf, robot_state, state);
+  }
+  state.update();
+  return valid;
+}
+
+void RobotStateConversionPlan::robotStateToJointStateMsg(const RobotState& state,
+                                                         sensor_msgs::JointState& joint_state) const
+{
+  const std::size_t n = single_dof_indices_.size();
+  // comparing the names does not allocate, copying them does
+  if (joint_state.name != single_dof_names_)
+    joint_state.name = single_dof_names_;
+  joint_state.position.resize(n);
+  for (std::size_t i = 0; i < n; ++i)
+    joint_state.position[i] = state.getVariablePosition(single_dof_indices_[i]);
+  if (state.hasVelocities())
+  {
+    joint_state.velocity.resize(n);
+    for (std::size_t i = 0; i < n; ++i)
+      joint_state.velocity[i] = state.getVariableVelocity(single_dof_indices_[i]);
+  }
+  else
+    joint_state.velocity.clear();
+  joint_state.effort.clear();
+  joint_state.header.seq = 0;
+  joint_state.header.stamp = ros::Time();
+  joint_state.header.frame_id = robot_model_->getModelFrame();
+}
+
+void RobotStateConversionPlan::robotStateToRobotStateMsg(const RobotState& state, moveit_msgs::RobotState& robot_state,
+                                                         bool copy_attached_bodies) const
+{
+  robot_state.is_diff = false;
+  robotStateToJointStateMsg(state, robot_state.joint_state);
+  _robotStateToMultiDOFJointState(state, robot_state.multi_dof_joint_state);
+
+  if (copy_attached_bodies)
+  {
+    std::vector<const AttachedBody*> attached_bodies;
+    state.getAttachedBodies(attached_bodies);
+    attachedBodiesToAttachedCollisionObjectMsgs(attached_bodies, robot_state.attached_collision_objects);
+  }
+}
+
 }  // end of namespace core
 }  // end of namespace moveit
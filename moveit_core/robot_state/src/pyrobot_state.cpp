@@ -41,10 +41,64 @@
 
 #include <moveit/robot_state/robot_state.h>
 #include <moveit/robot_state/conversions.h>
+#include <moveit/robot_state/batch_forward_kinematics.h>
+
+#include <algorithm>
+#include <stdexcept>
 
 namespace py = pybind11;
 using namespace robot_state;
 
+using PositionArray = py::array_t<double, py::array::c_style | py::array::forcecast>;
+
+namespace
+{
+const double* rowMajorData(const PositionArray& array, py::ssize_t columns = -1)
+{
+  if (array.ndim() != 2 || (columns >= 0 && array.shape(1) != columns))
+    throw std::invalid_argument("Expected a 2-dimensional array" +
+                                (columns >= 0 ? " with " + std::to_string(columns) + " columns" : std::string()));
+  return array.data();
+}
+
+// Get the group whose variables a row of positions holds, nullptr for all variables of the robot
+const JointModelGroup* positionsGroup(const RobotState& state, const std::string& group, std::size_t columns)
+{
+  const JointModelGroup* jmg = nullptr;
+  if (!group.empty() && !(jmg = state.getRobotModel()->getJointModelGroup(group)))
+    throw std::invalid_argument("Unknown group '" + group + "'");
+  const std::size_t variable_count = jmg ? jmg->getVariableCount() : state.getVariableCount();
+  if (columns != variable_count)
+    throw std::invalid_argument("Expected " + std::to_string(variable_count) + " positions per state, got " +
+                                std::to_string(columns));
+  return jmg;
+}
+
+void setRowPositions(RobotState& state, const JointModelGroup* jmg, const double* row)
+{
+  if (jmg)
+    state.setJointGroupPositions(jmg, row);
+  else
+    state.setVariablePositions(row);
+}
+}  // namespace
+
+// Build one state per row of \e positions, a \e count x \e columns row-major array. A row holds the variables of
+// \e group, or of the whole robot if \e group is empty; all other variables are copied from \e state. The link
+// transforms of the returned states are up to date. Does not touch Python objects, so it can run without the GIL.
+std::vector<RobotState> statesFromPositions(const RobotState& state, const double* positions, std::size_t count,
+                                            std::size_t columns, const std::string& group)
+{
+  const JointModelGroup* jmg = positionsGroup(state, group, columns);
+  std::vector<RobotState> states(count, state);
+  for (std::size_t i = 0; i < count; ++i)
+  {
+    setRowPositions(states[i], jmg, positions + i * columns);
+    states[i].update();
+  }
+  return states;
+}
+
 void def_robot_state_bindings(py::module& m)
 {
   m.doc() = "Representation of a robot's state. This includes position, velocity, acceleration and effort.";
@@ -68,6 +122,86 @@ void def_robot_state_bindings(py::module& m)
            py::overload_cast<const JointModelGroup*, double>(&RobotState::satisfiesBounds, py::const_),
            py::arg("joint_model_group"), py::arg("margin") = 0.0)
       .def("update", &RobotState::update, py::arg("force") = false)
+      .def(
+          "getGlobalLinkTransformsBatch",
+          [](const RobotState& state, const PositionArray& positions, const std::vector<std::string>& link_names,
+             const std::string& group) {
+            const double* data = rowMajorData(positions);
+            const std::size_t count = positions.shape(0);
+            const std::size_t columns = positions.shape(1);
+            std::vector<const LinkModel*> links;
+            for (const std::string& link_name : link_names)
+              links.push_back(state.getLinkModel(link_name));
+            if (std::find(links.begin(), links.end(), nullptr) != links.end())
+              throw std::invalid_argument("Unknown link name");
+
+            py::array_t<double> transforms({ count, links.size(), std::size_t(4), std::size_t(4) });
+            double* out = transforms.mutable_data();
+            {
+              py::gil_scoped_release release;
+              const JointModelGroup* jmg = positionsGroup(state, group, columns);
+              BatchForwardKinematics fk(state.getRobotModel(), count);
+              RobotState row_state(state);
+              for (std::size_t i = 0; i < count; ++i)
+              {
+                setRowPositions(row_state, jmg, data + i * columns);
+                fk.setVariablePositions(i, row_state);
+              }
+              fk.computeLinkTransforms();
+              for (std::size_t i = 0; i < count; ++i)
+                for (const LinkModel* link : links)
+                {
+                  // row-major 4x4 matrices, as numpy expects
+                  Eigen::Map<Eigen::Matrix<double, 4, 4, Eigen::RowMajor>>(out) =
+                      fk.getGlobalLinkTransform(i, link).matrix();
+                  out += 16;
+                }
+            }
+            return transforms;
+          },
+          py::arg("positions"), py::arg("link_names"), py::arg("group") = "",
+          "Compute the global transforms of links for many states at once, without holding the GIL. Each row of "
+          "positions holds the variables of group (of the whole robot if empty), the other variables are taken from "
+          "this state. Returns an array of shape (states, links, 4, 4).")
+      .def(
+          "setFromIKBatch",
+          [](const RobotState& state, const std::string& group, const PositionArray& poses, const std::string& tip,
+             double timeout) {
+            const double* data = rowMajorData(poses, 7);
+            const std::size_t count = poses.shape(0);
+            const JointModelGroup* jmg = state.getJointModelGroup(group);
+            if (!jmg)
+              throw std::invalid_argument("Unknown group '" + group + "'");
+
+            const std::size_t variable_count = jmg->getVariableCount();
+            py::array_t<double> solutions({ count, variable_count });
+            py::array_t<bool> found(count);
+            double* solution = solutions.mutable_data();
+            bool* success = found.mutable_data();
+            {
+              py::gil_scoped_release release;
+              // solvers are not required to be thread-safe, so the poses are solved one after the other
+              RobotState ik_state(state);
+              for (std::size_t i = 0; i < count; ++i, data += 7, solution += variable_count)
+              {
+                const Eigen::Isometry3d pose = Eigen::Translation3d(data[0], data[1], data[2]) *
+                                               Eigen::Quaterniond(data[6], data[3], data[4], data[5]).normalized();
+                // a successful solution seeds the next pose, which suits poses along a path
+                std::vector<double> seed;
+                ik_state.copyJointGroupPositions(jmg, seed);
+                success[i] = tip.empty() ? ik_state.setFromIK(jmg, pose, timeout) :
+                                           ik_state.setFromIK(jmg, pose, tip, timeout);
+                if (!success[i])
+                  ik_state.setJointGroupPositions(jmg, seed);
+                ik_state.copyJointGroupPositions(jmg, solution);
+              }
+            }
+            return py::make_tuple(solutions, found);
+          },
+          py::arg("group"), py::arg("poses"), py::arg("tip") = "", py::arg("timeout") = 0.0,
+          "Solve IK for many poses (rows of x, y, z, qx, qy, qz, qw in the model frame) without holding the GIL. "
+          "The first pose is seeded with this state, the others with the previous solution. Returns the solutions "
+          "(one row of group variables per pose, the seed if no solution was found) and a flag per pose.")
       .def("printStateInfo",
            [](const RobotState& s) {
              std::stringstream ss;
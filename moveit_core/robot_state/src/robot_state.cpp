@@ -36,14 +36,19 @@
 /* Author: Ioan Sucan, Sachin Chitta, Acorn Pooley, Mario Prats, Dave Coleman */
 
 #include <moveit/robot_state/robot_state.h>
+#include <moveit/robot_state/robot_state_pool.h>
 #include <moveit/robot_state/cartesian_interpolator.h>
+#include <moveit/robot_model/chain_forward_kinematics.h>
+#include <moveit/robot_model/chain_jacobian.h>
 #include <moveit/transforms/transforms.h>
 #include <geometric_shapes/check_isometry.h>
 #include <geometric_shapes/shape_operations.h>
 #include <tf2_eigen/tf2_eigen.h>
 #include <moveit/backtrace/backtrace.h>
 #include <moveit/profiler/profiler.h>
+#include <moveit/profiler/trace.h>
 #include <moveit/macros/console_colors.h>
+#include <algorithm>
 #include <functional>
 #include <moveit/robot_model/aabb.h>
 
@@ -56,28 +61,39 @@ namespace
 constexpr char LOGNAME[] = "robot_state";
 }  // namespace
 
-RobotState::RobotState(const RobotModelConstPtr& robot_model)
+RobotState::RobotState(const RobotModelConstPtr& robot_model) : RobotState(robot_model, RobotStatePoolPtr())
+{
+}
+
+RobotState::RobotState(const RobotModelConstPtr& robot_model, const RobotStatePoolPtr& pool)
   : robot_model_(robot_model)
+  , memory_pool_(pool)
   , has_velocity_(false)
   , has_acceleration_(false)
   , has_effort_(false)
   , dirty_link_transforms_(nullptr)
   , dirty_collision_body_transforms_(nullptr)
+  , share_transforms_on_copy_(false)
   , rng_(nullptr)
 {
   if (robot_model == nullptr)
   {
     throw std::invalid_argument("RobotState cannot be constructed with nullptr RobotModelConstPtr");
   }
+  if (pool && pool->getRobotModel() != robot_model)
+  {
+    throw std::invalid_argument("RobotStatePool was created for a different robot model");
+  }
 
-  dirty_link_transforms_ = robot_model_->getRootJoint();
+  addDirtySubtree(dirty_link_subtrees_, dirty_link_transforms_, robot_model_->getRootJoint());
   allocMemory();
   initTransforms();
 }
 
-RobotState::RobotState(const RobotState& other) : rng_(nullptr)
+RobotState::RobotState(const RobotState& other) : share_transforms_on_copy_(false), rng_(nullptr)
 {
   robot_model_ = other.robot_model_;
+  memory_pool_ = other.memory_pool_;
   allocMemory();
   copyFrom(other);
 }
@@ -85,11 +101,26 @@ RobotState::RobotState(const RobotState& other) : rng_(nullptr)
 RobotState::~RobotState()
 {
   clearAttachedBodies();
-  free(memory_);
+  if (memory_pool_)
+    memory_pool_->releaseBlock(memory_);
+  else
+    free(memory_);
   if (rng_)
     delete rng_;
 }
 
+std::size_t RobotState::getMemoryBlockSize(const RobotModel& robot_model)
+{
+  constexpr unsigned int extra_alignment_bytes = EIGEN_MAX_ALIGN_BYTES - 1;
+  // memory for the dirty joint transforms
+  const int nr_doubles_for_dirty_joint_transforms =
+      1 + robot_model.getJointModelCount() / (sizeof(double) / sizeof(unsigned char));
+  return sizeof(Eigen::Isometry3d) * (robot_model.getJointModelCount() + robot_model.getLinkModelCount() +
+                                      robot_model.getLinkGeometryCount()) +
+         sizeof(double) * (robot_model.getVariableCount() * 3 + nr_doubles_for_dirty_joint_transforms) +
+         extra_alignment_bytes;
+}
+
 void RobotState::allocMemory()
 {
   static_assert((sizeof(Eigen::Isometry3d) / EIGEN_MAX_ALIGN_BYTES) * EIGEN_MAX_ALIGN_BYTES == sizeof(Eigen::Isometry3d),
@@ -99,12 +130,7 @@ void RobotState::allocMemory()
   // memory for the dirty joint transforms
   const int nr_doubles_for_dirty_joint_transforms =
       1 + robot_model_->getJointModelCount() / (sizeof(double) / sizeof(unsigned char));
-  const size_t bytes =
-      sizeof(Eigen::Isometry3d) * (robot_model_->getJointModelCount() + robot_model_->getLinkModelCount() +
-                                   robot_model_->getLinkGeometryCount()) +
-      sizeof(double) * (robot_model_->getVariableCount() * 3 + nr_doubles_for_dirty_joint_transforms) +
-      extra_alignment_bytes;
-  memory_ = malloc(bytes);
+  memory_ = memory_pool_ ? memory_pool_->acquireBlock() : malloc(getMemoryBlockSize(*robot_model_));
 
   // make the memory for transforms align at EIGEN_MAX_ALIGN_BYTES
   // https://eigen.tuxfamily.org/dox/classEigen_1_1aligned__allocator.html
@@ -149,6 +175,13 @@ void RobotState::copyFrom(const RobotState& other)
 
   dirty_collision_body_transforms_ = other.dirty_collision_body_transforms_;
   dirty_link_transforms_ = other.dirty_link_transforms_;
+  dirty_collision_subtrees_ = other.dirty_collision_subtrees_;
+  dirty_link_subtrees_ = other.dirty_link_subtrees_;
+
+  // the transforms are overwritten below, so stop reading from a previously shared snapshot
+  std::atomic_store(&transform_snapshot_, std::shared_ptr<const EigenSTL::vector_Isometry3d>());
+  global_link_transforms_ = variable_joint_transforms_ + robot_model_->getJointModelCount();
+  global_collision_body_transforms_ = global_link_transforms_ + robot_model_->getLinkModelCount();
 
   if (dirty_link_transforms_ == robot_model_->getRootJoint())
   {
@@ -161,17 +194,44 @@ void RobotState::copyFrom(const RobotState& other)
   }
   else
   {
-    // copy all the memory; maybe avoid copying velocity and acceleration if possible
+    // memory following the transforms; maybe avoid copying velocity and acceleration if possible
     const int nr_doubles_for_dirty_joint_transforms =
         1 + robot_model_->getJointModelCount() / (sizeof(double) / sizeof(unsigned char));
-    const size_t bytes =
-        sizeof(Eigen::Isometry3d) * (robot_model_->getJointModelCount() + robot_model_->getLinkModelCount() +
-                                     robot_model_->getLinkGeometryCount()) +
+    const size_t state_bytes =
         sizeof(double) *
-            (robot_model_->getVariableCount() * (1 + ((has_velocity_ || has_acceleration_ || has_effort_) ? 1 : 0) +
-                                                 ((has_acceleration_ || has_effort_) ? 1 : 0)) +
-             nr_doubles_for_dirty_joint_transforms);
-    memcpy((void*)variable_joint_transforms_, (void*)other.variable_joint_transforms_, bytes);
+        (robot_model_->getVariableCount() * (1 + ((has_velocity_ || has_acceleration_ || has_effort_) ? 1 : 0) +
+                                             ((has_acceleration_ || has_effort_) ? 1 : 0)) +
+         nr_doubles_for_dirty_joint_transforms);
+
+    std::shared_ptr<const EigenSTL::vector_Isometry3d> snapshot = std::atomic_load(&other.transform_snapshot_);
+    if (!snapshot && other.share_transforms_on_copy_ && other.dirty_link_transforms_ == nullptr)
+    {
+      // first copy of a state that allows sharing: all following copies reuse this snapshot
+      snapshot = std::make_shared<EigenSTL::vector_Isometry3d>(
+          other.global_link_transforms_, other.global_collision_body_transforms_ + robot_model_->getLinkGeometryCount());
+      std::atomic_store(&other.transform_snapshot_, snapshot);
+    }
+
+    if (snapshot)
+    {
+      // share the link and collision body transforms, copy everything else
+      memcpy((void*)variable_joint_transforms_, (void*)other.variable_joint_transforms_,
+             sizeof(Eigen::Isometry3d) * robot_model_->getJointModelCount());
+      memcpy(dirty_joint_transforms_, other.dirty_joint_transforms_, state_bytes);
+      std::atomic_store(&transform_snapshot_, snapshot);
+      // the snapshot is never written: unshareTransforms() is called before any transform update
+      global_link_transforms_ = const_cast<Eigen::Isometry3d*>(snapshot->data());
+      global_collision_body_transforms_ = global_link_transforms_ + robot_model_->getLinkModelCount();
+    }
+    else
+    {
+      // copy all the memory
+      const size_t bytes =
+          sizeof(Eigen::Isometry3d) * (robot_model_->getJointModelCount() + robot_model_->getLinkModelCount() +
+                                       robot_model_->getLinkGeometryCount()) +
+          state_bytes;
+      memcpy((void*)variable_joint_transforms_, (void*)other.variable_joint_transforms_, bytes);
+    }
   }
 
   // copy attached bodies
@@ -284,7 +344,7 @@ void RobotState::setToRandomPositions()
   random_numbers::RandomNumberGenerator& rng = getRandomNumberGenerator();
   robot_model_->getVariableRandomPositions(rng, position_);
   memset(dirty_joint_transforms_, 1, robot_model_->getJointModelCount() * sizeof(unsigned char));
-  dirty_link_transforms_ = robot_model_->getRootJoint();
+  addDirtySubtree(dirty_link_subtrees_, dirty_link_transforms_, robot_model_->getRootJoint());
   // mimic values are correctly set in RobotModel
 }
 
@@ -362,7 +422,7 @@ void RobotState::setToDefaultValues()
   // set velocity & acceleration to 0
   memset(velocity_, 0, sizeof(double) * 2 * robot_model_->getVariableCount());
   memset(dirty_joint_transforms_, 1, robot_model_->getJointModelCount() * sizeof(unsigned char));
-  dirty_link_transforms_ = robot_model_->getRootJoint();
+  addDirtySubtree(dirty_link_subtrees_, dirty_link_transforms_, robot_model_->getRootJoint());
 }
 
 void RobotState::setVariablePositions(const double* position)
@@ -374,7 +434,7 @@ void RobotState::setVariablePositions(const double* position)
 
   // Since all joint values have potentially changed, we will need to recompute all transforms
   memset(dirty_joint_transforms_, 1, robot_model_->getJointModelCount() * sizeof(unsigned char));
-  dirty_link_transforms_ = robot_model_->getRootJoint();
+  addDirtySubtree(dirty_link_subtrees_, dirty_link_transforms_, robot_model_->getRootJoint());
 }
 
 void RobotState::setVariablePositions(const std::map<std::string, double>& variable_map)
@@ -657,7 +717,7 @@ void RobotState::update(bool force)
   if (force)
   {
     memset(dirty_joint_transforms_, 1, robot_model_->getJointModelCount() * sizeof(unsigned char));
-    dirty_link_transforms_ = robot_model_->getRootJoint();
+    addDirtySubtree(dirty_link_subtrees_, dirty_link_transforms_, robot_model_->getRootJoint());
   }
 
   // this actually triggers all needed updates
@@ -671,24 +731,26 @@ void RobotState::updateCollisionBodyTransforms()
 
   if (dirty_collision_body_transforms_ != nullptr)
   {
-    const std::vector<const LinkModel*>& links = dirty_collision_body_transforms_->getDescendantLinkModels();
+    unshareTransforms();
     dirty_collision_body_transforms_ = nullptr;
 
-    for (const LinkModel* link : links)
-    {
-      const EigenSTL::vector_Isometry3d& ot = link->getCollisionOriginTransforms();
-      const std::vector<int>& ot_id = link->areCollisionOriginTransformsIdentity();
-      const int index_co = link->getFirstCollisionBodyTransformIndex();
-      const int index_l = link->getLinkIndex();
-      for (std::size_t j = 0, end = ot.size(); j != end; ++j)
+    for (std::size_t i = 0; i < dirty_collision_subtrees_.count; ++i)
+      for (const LinkModel* link : dirty_collision_subtrees_.roots[i]->getDescendantLinkModels())
       {
-        if (ot_id[j])
-          global_collision_body_transforms_[index_co + j] = global_link_transforms_[index_l];
-        else
-          global_collision_body_transforms_[index_co + j].affine().noalias() =
-              global_link_transforms_[index_l].affine() * ot[j].matrix();
+        const EigenSTL::vector_Isometry3d& ot = link->getCollisionOriginTransforms();
+        const std::vector<int>& ot_id = link->areCollisionOriginTransformsIdentity();
+        const int index_co = link->getFirstCollisionBodyTransformIndex();
+        const int index_l = link->getLinkIndex();
+        for (std::size_t j = 0, end = ot.size(); j != end; ++j)
+        {
+          if (ot_id[j])
+            global_collision_body_transforms_[index_co + j] = global_link_transforms_[index_l];
+          else
+            global_collision_body_transforms_[index_co + j].affine().noalias() =
+                global_link_transforms_[index_l].affine() * ot[j].matrix();
+        }
       }
-    }
+    dirty_collision_subtrees_.count = 0;
   }
 }
 
@@ -696,16 +758,67 @@ void RobotState::updateLinkTransforms()
 {
   if (dirty_link_transforms_ != nullptr)
   {
-    updateLinkTransformsInternal(dirty_link_transforms_);
-    if (dirty_collision_body_transforms_)
-      dirty_collision_body_transforms_ =
-          robot_model_->getCommonRoot(dirty_collision_body_transforms_, dirty_link_transforms_);
-    else
-      dirty_collision_body_transforms_ = dirty_link_transforms_;
+    MOVEIT_TRACE_ZONE("RobotState::updateLinkTransforms");
+    unshareTransforms();
+    // the dirty subtrees are disjoint, so the parent links of their roots are up to date
+    for (std::size_t i = 0; i < dirty_link_subtrees_.count; ++i)
+    {
+      updateLinkTransformsInternal(dirty_link_subtrees_.roots[i]);
+      addDirtySubtree(dirty_collision_subtrees_, dirty_collision_body_transforms_, dirty_link_subtrees_.roots[i]);
+    }
+    dirty_link_subtrees_.count = 0;
     dirty_link_transforms_ = nullptr;
   }
 }
 
+void RobotState::unshareTransforms()
+{
+  if (!transform_snapshot_)
+    return;
+  if (hasSharedTransforms())
+  {
+    Eigen::Isometry3d* own_transforms = variable_joint_transforms_ + robot_model_->getJointModelCount();
+    std::copy(transform_snapshot_->begin(), transform_snapshot_->end(), own_transforms);
+    global_link_transforms_ = own_transforms;
+    global_collision_body_transforms_ = own_transforms + robot_model_->getLinkModelCount();
+  }
+  // the transforms are about to change, so the snapshot must not be handed out to new copies anymore
+  std::atomic_store(&transform_snapshot_, std::shared_ptr<const EigenSTL::vector_Isometry3d>());
+}
+
+void RobotState::addDirtySubtree(DirtySubtrees& subtrees, const JointModel*& common_root, const JointModel* joint) const
+{
+  if (common_root == nullptr)
+  {
+    subtrees.roots[0] = joint;
+    subtrees.count = 1;
+    common_root = joint;
+    return;
+  }
+
+  std::size_t kept = 0;
+  for (std::size_t i = 0; i < subtrees.count; ++i)
+  {
+    const JointModel* root = subtrees.roots[i];
+    const JointModel* common = robot_model_->getCommonRoot(root, joint);
+    if (common == root)  // joint is already covered by a dirty subtree
+      return;
+    if (common != joint)  // keep subtrees that are not covered by joint
+      subtrees.roots[kept++] = root;
+  }
+  common_root = robot_model_->getCommonRoot(common_root, joint);
+  if (kept < DirtySubtrees::CAPACITY)
+  {
+    subtrees.roots[kept] = joint;
+    subtrees.count = kept + 1;
+  }
+  else
+  {
+    subtrees.roots[0] = common_root;
+    subtrees.count = 1;
+  }
+}
+
 void RobotState::updateLinkTransformsInternal(const JointModel* start)
 {
   for (const LinkModel* link : start->getDescendantLinkModels())
@@ -718,6 +831,10 @@ void RobotState::updateLinkTransformsInternal(const JointModel* start)
       if (link->parentJointIsFixed())  // fixed joint
         global_link_transforms_[idx_link].affine().noalias() =
             global_link_transforms_[idx_parent].affine() * link->getJointOriginTransform().matrix();
+      else if (updatePrincipalAxisLinkTransform(link, idx_link, idx_parent))
+      {
+        // revolute joint about a principal axis, handled by the specialized kernel
+      }
       else  // non-fixed joint
       {
         if (link->jointOriginTransformIsIdentity())  // Link has identity transform
@@ -745,16 +862,45 @@ void RobotState::updateLinkTransformsInternal(const JointModel* start)
         global_link_transforms_[attached_body.second->getAttachedLink()->getLinkIndex()]);
 }
 
+bool RobotState::updatePrincipalAxisLinkTransform(const LinkModel* link, int idx_link, int idx_parent)
+{
+  const JointModel* joint = link->getParentJointModel();
+  if (joint->getType() != JointModel::REVOLUTE)
+    return false;
+  const RevoluteJointModel* revolute = static_cast<const RevoluteJointModel*>(joint);
+  const int axis = revolute->getPrincipalAxis();
+  if (axis < 0)
+    return false;
+
+  const double angle = revolute->getPrincipalAxisSign() * position_[joint->getFirstVariableIndex()];
+  const double c = cos(angle);
+  const double s = sin(angle);
+
+  // keep the cached joint transform consistent with what getJointTransform() would compute
+  const int idx_joint = joint->getJointIndex();
+  if (dirty_joint_transforms_[idx_joint])
+  {
+    chain_fk::setPrincipalAxisRotation(axis, variable_joint_transforms_[idx_joint].data(), c, s);
+    dirty_joint_transforms_[idx_joint] = 0;
+  }
+
+  Eigen::Isometry3d& transform = global_link_transforms_[idx_link];
+  if (link->jointOriginTransformIsIdentity())
+    transform = global_link_transforms_[idx_parent];
+  else
+    transform.affine().noalias() =
+        global_link_transforms_[idx_parent].affine() * link->getJointOriginTransform().matrix();
+  chain_fk::rotateAboutPrincipalAxis(axis, transform.data(), c, s);
+  return true;
+}
+
 void RobotState::updateStateWithLinkAt(const LinkModel* link, const Eigen::Isometry3d& transform, bool backward)
 {
   updateLinkTransforms();  // no link transforms must be dirty, otherwise the transform we set will be overwritten
+  unshareTransforms();
 
   // update the fact that collision body transforms are out of date
-  if (dirty_collision_body_transforms_)
-    dirty_collision_body_transforms_ =
-        robot_model_->getCommonRoot(dirty_collision_body_transforms_, link->getParentJointModel());
-  else
-    dirty_collision_body_transforms_ = link->getParentJointModel();
+  addDirtySubtree(dirty_collision_subtrees_, dirty_collision_body_transforms_, link->getParentJointModel());
 
   global_link_transforms_[link->getLinkIndex()] = transform;
 
@@ -788,7 +934,7 @@ void RobotState::updateStateWithLinkAt(const LinkModel* link, const Eigen::Isome
           updateLinkTransformsInternal(joint);
     }
     // all collision body transforms are invalid now
-    dirty_collision_body_transforms_ = parent_link->getParentJointModel();
+    addDirtySubtree(dirty_collision_subtrees_, dirty_collision_body_transforms_, parent_link->getParentJointModel());
   }
 
   // update attached bodies tf; these are usually very few, so we update them all
@@ -935,6 +1081,13 @@ bool RobotState::isValidVelocityMove(const RobotState& other, const JointModelGr
 
 double RobotState::distance(const RobotState& other, const JointModelGroup* joint_group) const
 {
+  if (joint_group->isContiguousWithinState())
+  {
+    // the group state is a contiguous block of the full state
+    const int first = joint_group->getVariableIndexList()[0];
+    return joint_group->distance(position_ + first, other.position_ + first);
+  }
+
   double d = 0.0;
   const std::vector<const JointModel*>& jm = joint_group->getActiveJointModels();
   for (const JointModel* joint : jm)
@@ -951,17 +1104,25 @@ void RobotState::interpolate(const RobotState& to, double t, RobotState& state)
   robot_model_->interpolate(getVariablePositions(), to.getVariablePositions(), t, state.getVariablePositions());
 
   memset(state.dirty_joint_transforms_, 1, state.robot_model_->getJointModelCount() * sizeof(unsigned char));
-  state.dirty_link_transforms_ = state.robot_model_->getRootJoint();
+  state.addDirtySubtree(state.dirty_link_subtrees_, state.dirty_link_transforms_, state.robot_model_->getRootJoint());
 }
 
 void RobotState::interpolate(const RobotState& to, double t, RobotState& state, const JointModelGroup* joint_group) const
 {
   moveit::core::checkInterpolationParamBounds(LOGNAME, t);
-  const std::vector<const JointModel*>& jm = joint_group->getActiveJointModels();
-  for (const JointModel* joint : jm)
+  if (joint_group->isContiguousWithinState())
   {
-    const int idx = joint->getFirstVariableIndex();
-    joint->interpolate(position_ + idx, to.position_ + idx, t, state.position_ + idx);
+    const int first = joint_group->getVariableIndexList()[0];
+    joint_group->interpolate(position_ + first, to.position_ + first, t, state.position_ + first);
+  }
+  else
+  {
+    const std::vector<const JointModel*>& jm = joint_group->getActiveJointModels();
+    for (const JointModel* joint : jm)
+    {
+      const int idx = joint->getFirstVariableIndex();
+      joint->interpolate(position_ + idx, to.position_ + idx, t, state.position_ + idx);
+    }
   }
   state.updateMimicJoints(joint_group);
 }
@@ -1275,6 +1436,56 @@ Eigen::MatrixXd RobotState::getJacobian(const JointModelGroup* group,
   return result;
 }
 
+bool RobotState::computeJacobian(const JointModelGroup* group, const LinkModel* link,
+                                 const Eigen::Vector3d& reference_point_position,
+                                 Eigen::Ref<Eigen::Matrix<double, 6, Eigen::Dynamic>> result,
+                                 const double* velocities) const
+{
+  BOOST_VERIFY(checkLinkTransforms());
+
+  if (!group->isChain())
+  {
+    ROS_ERROR_NAMED(LOGNAME, "The group '%s' is not a chain. Cannot compute Jacobian.", group->getName().c_str());
+    return false;
+  }
+  if (!group->isLinkUpdated(link->getName()))
+  {
+    ROS_ERROR_NAMED(LOGNAME, "Link name '%s' does not exist in the chain '%s' or is not a child for this chain",
+                    link->getName().c_str(), group->getName().c_str());
+    return false;
+  }
+  if (result.cols() != static_cast<Eigen::Index>(group->getVariableCount()))
+  {
+    ROS_ERROR_NAMED(LOGNAME, "Jacobian of group '%s' needs %u columns, but the given matrix has %d",
+                    group->getName().c_str(), group->getVariableCount(), static_cast<int>(result.cols()));
+    return false;
+  }
+
+  const auto get_link_transform = [this](const LinkModel* l) -> const Eigen::Isometry3d& {
+    return global_link_transforms_[l->getLinkIndex()];
+  };
+  if (velocities)
+  {
+    if (!has_velocity_)
+    {
+      ROS_ERROR_NAMED(LOGNAME, "Cannot compute the Jacobian derivative of a state without velocities");
+      return false;
+    }
+    if (!chain_jacobian::computeDerivative(group, link, reference_point_position, get_link_transform, velocities,
+                                           result))
+    {
+      ROS_ERROR_NAMED(LOGNAME, "The Jacobian derivative only supports revolute and prismatic joints");
+      return false;
+    }
+  }
+  else if (!chain_jacobian::compute(group, link, reference_point_position, get_link_transform, result))
+  {
+    ROS_ERROR_NAMED(LOGNAME, "Unknown type of joint in Jacobian computation");
+    return false;
+  }
+  return true;
+}
+
 bool RobotState::getJacobian(const JointModelGroup* group, const LinkModel* link,
                              const Eigen::Vector3d& reference_point_position, Eigen::MatrixXd& jacobian,
                              bool use_quaternion_representation) const
@@ -1789,6 +2000,10 @@ bool RobotState::setFromIK(const JointModelGroup* jmg, const EigenSTL::vector_Is
   for (std::size_t i = 0; i < bij.size(); ++i)
     seed[i] = initial_values[bij[i]];
 
+  // the batch API solves single poses without consistency limits
+  if (options.parallel_seeds > 1 && ik_queries.size() == 1 && consistency_limits.empty())
+    return setFromIKParallelSeeds(jmg, solver, ik_queries[0], seed, timeout, constraint, options);
+
   // compute the IK solution
   std::vector<double> ik_sol;
   moveit_msgs::MoveItErrorCodes error;
@@ -1805,6 +2020,69 @@ bool RobotState::setFromIK(const JointModelGroup* jmg, const EigenSTL::vector_Is
   return false;
 }
 
+bool RobotState::setFromIKParallelSeeds(const JointModelGroup* jmg, const kinematics::KinematicsBaseConstPtr& solver,
+                                        const geometry_msgs::Pose& ik_query, const std::vector<double>& seed,
+                                        double timeout, const GroupStateValidityCallbackFn& constraint,
+                                        const kinematics::KinematicsQueryOptions& options)
+{
+  const std::vector<unsigned int>& bij = jmg->getKinematicsSolverJointBijection();
+  const std::size_t dof = bij.size();
+  const unsigned int num_seeds = options.parallel_seeds;
+  const std::vector<geometry_msgs::Pose> ik_queries(num_seeds, ik_query);
+  random_numbers::RandomNumberGenerator& rng = getRandomNumberGenerator();
+
+  std::vector<double> seeds(num_seeds * dof);
+  std::vector<double> ik_sols, random_values;
+  std::vector<double> solution(dof), best_solution;
+  std::vector<bool> found;
+  bool first_round = true;
+  ros::WallTime start = ros::WallTime::now();
+  do
+  {
+    for (unsigned int s = 0; s < num_seeds; ++s)
+    {
+      // the first seed is the initial state
+      if (first_round && s == 0)
+      {
+        std::copy(seed.begin(), seed.end(), seeds.begin());
+        continue;
+      }
+      jmg->getVariableRandomPositions(rng, random_values);
+      for (std::size_t i = 0; i < dof; ++i)
+        seeds[s * dof + i] = random_values[bij[i]];
+    }
+    first_round = false;
+
+    // a zero timeout limits each seed to a single attempt, so a round ends as soon as all seeds made one
+    solver->searchPositionIKBatch(ik_queries, seeds, 0.0, ik_sols, found, options, num_seeds);
+
+    double best_distance = std::numeric_limits<double>::infinity();
+    for (unsigned int s = 0; s < num_seeds && s < found.size(); ++s)
+    {
+      if (!found[s])
+        continue;
+      for (std::size_t i = 0; i < dof; ++i)
+        solution[bij[i]] = ik_sols[s * dof + i];
+      if (constraint && !constraint(this, jmg, &solution[0]))
+        continue;
+      double distance = 0.0;
+      for (std::size_t i = 0; i < dof; ++i)
+        distance += std::fabs(ik_sols[s * dof + i] - seed[i]);
+      if (distance < best_distance)
+      {
+        best_distance = distance;
+        best_solution = solution;
+      }
+    }
+    if (!best_solution.empty())
+    {
+      setJointGroupPositions(jmg, best_solution);
+      return true;
+    }
+  } while ((ros::WallTime::now() - start).toSec() < timeout);
+  return false;
+}
+
 bool RobotState::setFromIKSubgroups(const JointModelGroup* jmg, const EigenSTL::vector_Isometry3d& poses_in,
                                     const std::vector<std::string>& tips_in,
                                     const std::vector<std::vector<double> >& consistency_limits, double timeout,
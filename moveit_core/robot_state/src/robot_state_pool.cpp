@@ -0,0 +1,130 @@
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2026, PickNik LLC.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of PickNik LLC nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *********************************************************************/
+
+#include <moveit/robot_state/robot_state_pool.h>
+#include <cstdlib>
+#include <new>
+
+namespace moveit
+{
+namespace core
+{
+RobotStatePool::RobotStatePool(const RobotModelConstPtr& robot_model, std::size_t reserve)
+  : robot_model_(robot_model), block_size_(0), used_blocks_(0)
+{
+  if (robot_model == nullptr)
+    throw std::invalid_argument("RobotStatePool cannot be constructed with nullptr RobotModelConstPtr");
+  block_size_ = RobotState::getMemoryBlockSize(*robot_model_);
+  this->reserve(reserve);
+}
+
+RobotStatePool::~RobotStatePool()
+{
+  // states hold a shared pointer to their pool, so no block can be in use anymore
+  release();
+}
+
+RobotStatePtr RobotStatePool::allocate()
+{
+  return std::make_shared<RobotState>(robot_model_, shared_from_this());
+}
+
+RobotStatePtr RobotStatePool::clone(const RobotState& state)
+{
+  RobotStatePtr copy = allocate();
+  *copy = state;
+  return copy;
+}
+
+void RobotStatePool::reserve(std::size_t count)
+{
+  std::lock_guard<std::mutex> slock(lock_);
+  free_blocks_.reserve(count);
+  while (free_blocks_.size() < count)
+  {
+    void* block = malloc(block_size_);
+    if (!block)
+      throw std::bad_alloc();
+    free_blocks_.push_back(block);
+  }
+}
+
+void RobotStatePool::release()
+{
+  std::lock_guard<std::mutex> slock(lock_);
+  for (void* block : free_blocks_)
+    free(block);
+  free_blocks_.clear();
+  free_blocks_.shrink_to_fit();
+}
+
+std::size_t RobotStatePool::getCachedBlockCount() const
+{
+  std::lock_guard<std::mutex> slock(lock_);
+  return free_blocks_.size();
+}
+
+std::size_t RobotStatePool::getUsedBlockCount() const
+{
+  std::lock_guard<std::mutex> slock(lock_);
+  return used_blocks_;
+}
+
+void* RobotStatePool::acquireBlock()
+{
+  std::lock_guard<std::mutex> slock(lock_);
+  void* block;
+  if (free_blocks_.empty())
+  {
+    block = malloc(block_size_);
+    if (!block)
+      throw std::bad_alloc();
+  }
+  else
+  {
+    block = free_blocks_.back();
+    free_blocks_.pop_back();
+  }
+  ++used_blocks_;
+  return block;
+}
+
+void RobotStatePool::releaseBlock(void* block)
+{
+  std::lock_guard<std::mutex> slock(lock_);
+  --used_blocks_;
+  free_blocks_.push_back(block);
+}
+}  // namespace core
+}  // namespace moveit
@@ -0,0 +1,220 @@
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2026, PickNik LLC.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of PickNik LLC nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *********************************************************************/
+
+/* Google Benchmark based micro-benchmarks of the RobotState hot paths. Write JSON results for regression tracking
+   with --benchmark_out=<file> --benchmark_out_format=json, see moveit_core/README.md */
+
+#include <moveit/robot_model/robot_model.h>
+#include <moveit/robot_state/robot_state.h>
+#include <moveit/robot_state/conversions.h>
+#include <moveit/utils/robot_model_test_utils.h>
+#include <random_numbers/random_numbers.h>
+#include <benchmark/benchmark.h>
+#include <ros/ros.h>
+
+namespace
+{
+struct TestRobot
+{
+  const char* robot;
+  const char* group;
+  const char* base_link;
+  const char* tip_link;
+};
+
+const TestRobot PANDA = { "panda", "panda_arm", "panda_link0", "panda_link8" };
+const TestRobot PR2 = { "pr2", "right_arm", "torso_lift_link", "r_wrist_roll_link" };
+
+// The robot models are loaded once and shared by all benchmarks
+const moveit::core::RobotModelPtr& getModel(const TestRobot& robot)
+{
+  static std::map<std::string, moveit::core::RobotModelPtr> models;
+  moveit::core::RobotModelPtr& model = models[robot.robot];
+  if (!model)
+    model = moveit::core::loadTestingRobotModel(robot.robot);
+  return model;
+}
+
+// The same random states of the group in every run, cycled through by the benchmarks so that no result is cached
+std::vector<moveit::core::RobotState> randomStates(const TestRobot& robot, std::size_t count = 64)
+{
+  moveit::core::RobotState state(getModel(robot));
+  const moveit::core::JointModelGroup* jmg = state.getJointModelGroup(robot.group);
+  random_numbers::RandomNumberGenerator rng(7);
+  state.setToDefaultValues();
+  std::vector<moveit::core::RobotState> states;
+  for (std::size_t i = 0; i < count; ++i)
+  {
+    state.setToRandomPositions(jmg, rng);
+    state.update();
+    states.push_back(state);
+  }
+  return states;
+}
+}  // namespace
+
+static void forwardKinematics(benchmark::State& st, const TestRobot& robot)
+{
+  std::vector<moveit::core::RobotState> states = randomStates(robot);
+  moveit::core::RobotState state(states[0]);
+  std::size_t i = 0;
+  for (auto _ : st)
+  {
+    state.setVariablePositions(states[i++ % states.size()].getVariablePositions());
+    state.updateLinkTransforms();
+    benchmark::DoNotOptimize(state.getGlobalLinkTransform(robot.tip_link).translation());
+  }
+}
+BENCHMARK_CAPTURE(forwardKinematics, panda, PANDA);
+BENCHMARK_CAPTURE(forwardKinematics, pr2, PR2);
+
+static void jacobian(benchmark::State& st, const TestRobot& robot)
+{
+  std::vector<moveit::core::RobotState> states = randomStates(robot);
+  const moveit::core::JointModelGroup* jmg = states[0].getJointModelGroup(robot.group);
+  const moveit::core::LinkModel* tip = states[0].getLinkModel(robot.tip_link);
+  Eigen::MatrixXd jacobian;
+  std::size_t i = 0;
+  for (auto _ : st)
+  {
+    states[i++ % states.size()].getJacobian(jmg, tip, Eigen::Vector3d::Zero(), jacobian);
+    benchmark::DoNotOptimize(jacobian.data());
+  }
+}
+BENCHMARK_CAPTURE(jacobian, panda, PANDA);
+BENCHMARK_CAPTURE(jacobian, pr2, PR2);
+
+static void distance(benchmark::State& st, const TestRobot& robot)
+{
+  std::vector<moveit::core::RobotState> states = randomStates(robot);
+  std::size_t i = 0;
+  for (auto _ : st)
+  {
+    benchmark::DoNotOptimize(states[i % states.size()].distance(states[(i + 1) % states.size()]));
+    ++i;
+  }
+}
+BENCHMARK_CAPTURE(distance, panda, PANDA);
+BENCHMARK_CAPTURE(distance, pr2, PR2);
+
+static void interpolate(benchmark::State& st, const TestRobot& robot)
+{
+  std::vector<moveit::core::RobotState> states = randomStates(robot);
+  moveit::core::RobotState result(states[0]);
+  std::size_t i = 0;
+  for (auto _ : st)
+  {
+    states[i % states.size()].interpolate(states[(i + 1) % states.size()], 0.3, result);
+    benchmark::DoNotOptimize(result.getVariablePositions());
+    ++i;
+  }
+}
+BENCHMARK_CAPTURE(interpolate, panda, PANDA);
+BENCHMARK_CAPTURE(interpolate, pr2, PR2);
+
+static void stateToMsg(benchmark::State& st, const TestRobot& robot)
+{
+  std::vector<moveit::core::RobotState> states = randomStates(robot);
+  moveit_msgs::RobotState msg;
+  std::size_t i = 0;
+  for (auto _ : st)
+  {
+    moveit::core::robotStateToRobotStateMsg(states[i++ % states.size()], msg);
+    benchmark::DoNotOptimize(msg.joint_state.position.data());
+  }
+}
+BENCHMARK_CAPTURE(stateToMsg, panda, PANDA);
+BENCHMARK_CAPTURE(stateToMsg, pr2, PR2);
+
+static void msgToState(benchmark::State& st, const TestRobot& robot)
+{
+  std::vector<moveit::core::RobotState> states = randomStates(robot);
+  std::vector<moveit_msgs::RobotState> msgs(states.size());
+  for (std::size_t i = 0; i < states.size(); ++i)
+    moveit::core::robotStateToRobotStateMsg(states[i], msgs[i]);
+  moveit::core::RobotState state(states[0]);
+  std::size_t i = 0;
+  for (auto _ : st)
+  {
+    moveit::core::robotStateMsgToRobotState(msgs[i++ % msgs.size()], state);
+    benchmark::DoNotOptimize(state.getVariablePositions());
+  }
+}
+BENCHMARK_CAPTURE(msgToState, panda, PANDA);
+BENCHMARK_CAPTURE(msgToState, pr2, PR2);
+
+// Solve IK for poses reached by random states, starting from the default state
+static void inverseKinematics(benchmark::State& st, const TestRobot& robot, const std::string& plugin)
+{
+  moveit::core::RobotModelPtr model = moveit::core::loadTestingRobotModel(robot.robot);
+  moveit::core::JointModelGroup* jmg = model->getJointModelGroup(robot.group);
+  try
+  {
+    moveit::core::loadIKPluginForGroup(jmg, robot.base_link, robot.tip_link, plugin);
+  }
+  catch (std::exception& ex)
+  {
+    ROS_ERROR("%s", ex.what());
+  }
+  if (!jmg->getSolverInstance())
+  {
+    st.SkipWithError(("Failed to load " + plugin).c_str());
+    return;
+  }
+
+  std::vector<moveit::core::RobotState> states = randomStates(robot);
+  moveit::core::RobotState state(model);
+  std::size_t i = 0, failures = 0;
+  for (auto _ : st)
+  {
+    const moveit::core::RobotState& target = states[i++ % states.size()];
+    st.PauseTiming();
+    state.setToDefaultValues();
+    st.ResumeTiming();
+    if (!state.setFromIK(jmg, target.getGlobalLinkTransform(robot.tip_link), robot.tip_link, 0.1))
+      ++failures;
+  }
+  st.counters["failure_rate"] = benchmark::Counter(failures, benchmark::Counter::kAvgIterations);
+}
+BENCHMARK_CAPTURE(inverseKinematics, panda_kdl, PANDA, "kdl_kinematics_plugin/KDLKinematicsPlugin");
+BENCHMARK_CAPTURE(inverseKinematics, pr2_kdl, PR2, "kdl_kinematics_plugin/KDLKinematicsPlugin");
+
+int main(int argc, char** argv)
+{
+  // kinematics plugins read their parameters through a node handle
+  ros::init(argc, argv, "benchmark_robot_state", ros::init_options::AnonymousName);
+  benchmark::Initialize(&argc, argv);
+  benchmark::RunSpecifiedBenchmarks();
+  return 0;
+}
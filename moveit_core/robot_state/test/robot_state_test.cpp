@@ -35,6 +35,8 @@
 /* Author: Ioan Sucan */
 #include <moveit/robot_model/robot_model.h>
 #include <moveit/robot_state/robot_state.h>
+#include <moveit/robot_state/robot_state_pool.h>
+#include <moveit/robot_model/chain_forward_kinematics.h>
 #include <moveit/utils/robot_model_test_utils.h>
 #include <urdf_parser/urdf_parser.h>
 #include <tf2_geometry_msgs/tf2_geometry_msgs.h>
@@ -537,6 +539,14 @@ TEST_F(OneRobot, FK)
   EXPECT_NEAR_TRACED(state.getGlobalLinkTransform("link_c").translation(), Eigen::Vector3d(0.0, 0.4, 0));
   EXPECT_NEAR_TRACED(state.getGlobalLinkTransform("link_d").translation(), Eigen::Vector3d(1.7, 0.5, 0));
   EXPECT_NEAR_TRACED(state.getGlobalLinkTransform("link_e").translation(), Eigen::Vector3d(2.8, 0.6, 0));
+
+  // positions written in place need markJointGroupPositionsChanged()
+  state.getVariablePositions()[model->getJointModel("joint_f")->getFirstVariableIndex()] = 0.0;
+  state.markJointGroupPositionsChanged(g_mim);
+  EXPECT_EQ(state.getVariablePosition("mim_f"), 0.1);
+  EXPECT_TRUE(state.dirtyLinkTransforms());
+  EXPECT_NEAR_TRACED(state.getGlobalLinkTransform("link_d").translation(), Eigen::Vector3d(0.2, 0.5, 0));
+  EXPECT_NEAR_TRACED(state.getGlobalLinkTransform("link_e").translation(), Eigen::Vector3d(0.3, 0.6, 0));
 }
 
 TEST_F(OneRobot, testPrintCurrentPositionWithJointLimits)
@@ -707,6 +717,254 @@ TEST_F(OneRobot, rigidlyConnectedParent)
   EXPECT_EQ(nullptr, state.getRigidlyConnectedParentLinkModel("/"));
 }
 
+TEST(ChainFK, PandaArm)
+{
+  using namespace moveit::core::chain_fk;
+  moveit::core::RobotModelPtr model = moveit::core::loadTestingRobotModel("panda");
+  const moveit::core::JointModelGroup* group = model->getJointModelGroup("panda_arm");
+  ChainFK<RevoluteZ, RevoluteZ, RevoluteZ, RevoluteZ, RevoluteZ, RevoluteZ, RevoluteZ> fk(group);
+
+  // a chain with mismatching joint kernels is rejected
+  EXPECT_THROW((ChainFK<RevoluteX, RevoluteZ, RevoluteZ, RevoluteZ, RevoluteZ, RevoluteZ, RevoluteZ>(group)),
+               std::invalid_argument);
+  EXPECT_THROW(ChainFK<RevoluteZ>{ group }, std::invalid_argument);
+
+  moveit::core::RobotState state(model);
+  for (int trial = 0; trial < 10; ++trial)
+  {
+    state.setToRandomPositions(group);
+    state.update();
+
+    std::vector<double> values;
+    state.copyJointGroupPositions(group, values);
+    Eigen::Isometry3d transforms[7];
+    fk.computeLinkTransforms(values.data(), transforms);
+
+    const Eigen::Isometry3d& base = state.getGlobalLinkTransform(fk.getBaseLink());
+    const std::vector<const moveit::core::JointModel*>& joints = group->getActiveJointModels();
+    for (std::size_t i = 0; i < joints.size(); ++i)
+      EXPECT_TRUE(
+          (base * transforms[i]).isApprox(state.getGlobalLinkTransform(joints[i]->getChildLinkModel()), EPSILON));
+    EXPECT_TRUE((base * fk.computeTipTransform(values.data()))
+                    .isApprox(state.getGlobalLinkTransform(fk.getTipLink()), EPSILON));
+
+    // the specialized kernel in RobotState keeps the cached joint transforms consistent
+    for (const moveit::core::JointModel* joint : joints)
+    {
+      Eigen::Isometry3d expected;
+      joint->computeTransform(state.getJointPositions(joint), expected);
+      const moveit::core::RobotState& const_state = state;
+      EXPECT_FALSE(const_state.dirtyJointTransform(joint));
+      EXPECT_TRUE(expected.isApprox(const_state.getJointTransform(joint), EPSILON));
+    }
+  }
+}
+
+TEST(RobotStatePool, ReusesMemory)
+{
+  moveit::core::RobotModelPtr model = moveit::core::loadTestingRobotModel("panda");
+  auto pool = std::make_shared<moveit::core::RobotStatePool>(model, 2);
+  EXPECT_EQ(pool->getCachedBlockCount(), 2u);
+
+  moveit::core::RobotState reference(model);
+  reference.setToRandomPositions();
+  {
+    moveit::core::RobotStatePtr state = pool->clone(reference);
+    EXPECT_EQ(state->getMemoryPool(), pool);
+    EXPECT_EQ(pool->getUsedBlockCount(), 1u);
+    EXPECT_EQ(pool->getCachedBlockCount(), 1u);
+    for (std::size_t i = 0; i < model->getVariableCount(); ++i)
+      EXPECT_EQ(state->getVariablePosition(i), reference.getVariablePosition(i));
+
+    // copies share the pool of the original
+    moveit::core::RobotState copy(*state);
+    EXPECT_EQ(copy.getMemoryPool(), pool);
+    EXPECT_EQ(pool->getUsedBlockCount(), 2u);
+    EXPECT_EQ(pool->getCachedBlockCount(), 0u);
+    EXPECT_TRUE(copy.getGlobalLinkTransform("panda_link8").isApprox(reference.getGlobalLinkTransform("panda_link8")));
+  }
+  EXPECT_EQ(pool->getUsedBlockCount(), 0u);
+  EXPECT_EQ(pool->getCachedBlockCount(), 2u);
+
+  pool->release();
+  EXPECT_EQ(pool->getCachedBlockCount(), 0u);
+
+  // a pool can only serve states of its own robot model
+  EXPECT_THROW(moveit::core::RobotState(moveit::core::loadTestingRobotModel("pr2"), pool), std::invalid_argument);
+}
+
+TEST(RobotState, DisjointDirtySubtrees)
+{
+  moveit::core::RobotModelPtr model = moveit::core::loadTestingRobotModel("pr2");
+  moveit::core::RobotState state(model);
+  state.setToRandomPositions();
+  state.update();
+
+  // disjoint subtrees (both wrists and the head), one subtree contained in another and finally one containing all
+  const std::vector<std::vector<std::string>> batches = {
+    { "r_wrist_roll_joint", "l_wrist_flex_joint", "l_wrist_roll_joint", "head_pan_joint" },
+    { "l_wrist_roll_joint", "r_elbow_flex_joint", "r_wrist_roll_joint" },
+    { "l_wrist_flex_joint", "torso_lift_joint", "head_pan_joint" }
+  };
+  for (const std::vector<std::string>& joints : batches)
+  {
+    for (const std::string& joint : joints)
+      state.setVariablePosition(joint, state.getVariablePosition(joint) + 0.05);
+    moveit::core::RobotState expected(state);
+    expected.update(true);
+    state.updateCollisionBodyTransforms();
+    for (const moveit::core::LinkModel* link : model->getLinkModels())
+    {
+      EXPECT_TRUE(expected.getGlobalLinkTransform(link).isApprox(state.getGlobalLinkTransform(link), 1e-10))
+          << joints.front() << " " << link->getName();
+      for (std::size_t i = 0; i < link->getShapes().size(); ++i)
+      {
+        const Eigen::Isometry3d& actual = state.getCollisionBodyTransform(link, i);
+        EXPECT_TRUE(expected.getCollisionBodyTransform(link, i).isApprox(actual, 1e-10))
+            << joints.front() << " " << link->getName();
+      }
+    }
+  }
+}
+
+TEST(RobotState, FixedSizeJacobian)
+{
+  moveit::core::RobotModelPtr model = moveit::core::loadTestingRobotModel("panda");
+  const moveit::core::JointModelGroup* group = model->getJointModelGroup("panda_arm");
+  const moveit::core::LinkModel* tip = model->getLinkModel("panda_link8");
+  const Eigen::Vector3d point(0.1, 0.0, 0.05);
+  moveit::core::RobotState state(model);
+  state.setToRandomPositions(group);
+  state.update();
+
+  Eigen::MatrixXd expected;
+  ASSERT_TRUE(state.getJacobian(group, tip, point, expected));
+  Eigen::Matrix<double, 6, 7> jacobian;
+  ASSERT_TRUE(state.getJacobian(group, tip, point, jacobian));
+  EXPECT_TRUE(expected.isApprox(jacobian, 1e-10));
+
+  // the number of columns has to match the group
+  Eigen::Matrix<double, 6, 6> too_small;
+  EXPECT_FALSE(state.getJacobian(group, tip, point, too_small));
+
+  // compare the derivative with central differences of the Jacobian along the velocity
+  Eigen::Matrix<double, 6, 7> derivative;
+  EXPECT_FALSE(state.getJacobianDerivative(group, tip, point, derivative));  // no velocities yet
+  Eigen::VectorXd positions, velocities = Eigen::VectorXd::Random(7);
+  state.copyJointGroupPositions(group, positions);
+  state.setJointGroupVelocities(group, velocities);
+  ASSERT_TRUE(state.getJacobianDerivative(group, tip, point, derivative));
+
+  const double dt = 1e-6;
+  Eigen::Matrix<double, 6, 7> forward, backward;
+  state.setJointGroupPositions(group, positions + dt * velocities);
+  ASSERT_TRUE(state.getJacobian(group, tip, point, forward));
+  state.setJointGroupPositions(group, positions - dt * velocities);
+  ASSERT_TRUE(state.getJacobian(group, tip, point, backward));
+  EXPECT_TRUE(derivative.isApprox((forward - backward) / (2 * dt), 1e-5));
+}
+
+TEST(RobotState, GroupDistanceAndInterpolation)
+{
+  // the PR2 arm has continuous joints, which wrap around in distance() and interpolate()
+  moveit::core::RobotModelPtr model = moveit::core::loadTestingRobotModel("pr2");
+  const moveit::core::JointModelGroup* group = model->getJointModelGroup("right_arm");
+  ASSERT_TRUE(group->isContiguousWithinState());
+  moveit::core::RobotState from(model), to(model), actual(model), expected(model);
+  std::vector<moveit::core::RobotState> others(5, moveit::core::RobotState(model));
+  std::vector<double> other_values;
+  for (moveit::core::RobotState& other : others)
+  {
+    other.setToRandomPositions(group);
+    std::vector<double> values;
+    other.copyJointGroupPositions(group, values);
+    other_values.insert(other_values.end(), values.begin(), values.end());
+  }
+
+  for (int trial = 0; trial < 20; ++trial)
+  {
+    from.setToRandomPositions(group);
+    to.setToRandomPositions(group);
+
+    double expected_distance = 0.0;
+    for (const moveit::core::JointModel* joint : group->getActiveJointModels())
+      expected_distance += joint->getDistanceFactor() * from.distance(to, joint);
+    EXPECT_NEAR(from.distance(to, group), expected_distance, 1e-10);
+
+    for (double t : { 0.0, 0.3, 0.5, 1.0 })
+    {
+      from.interpolate(to, t, actual, group);
+      expected = actual;
+      for (const moveit::core::JointModel* joint : group->getActiveJointModels())
+        from.interpolate(to, t, expected, joint);
+      for (const moveit::core::JointModel* joint : group->getActiveJointModels())
+        EXPECT_NEAR(actual.distance(expected, joint), 0.0, 1e-10) << joint->getName() << " at t = " << t;
+    }
+
+    std::vector<double> values, result(others.size());
+    from.copyJointGroupPositions(group, values);
+    group->distances(values.data(), other_values.data(), others.size(), result.data());
+    for (std::size_t i = 0; i < others.size(); ++i)
+      EXPECT_NEAR(result[i], from.distance(others[i], group), 1e-10);
+  }
+}
+
+TEST(RobotState, CopyOnWriteTransforms)
+{
+  moveit::core::RobotModelPtr model = moveit::core::loadTestingRobotModel("panda");
+  const moveit::core::JointModelGroup* group = model->getJointModelGroup("panda_arm");
+  const moveit::core::LinkModel* tip = model->getLinkModel("panda_link8");
+  moveit::core::RobotState source(model);
+  source.setToRandomPositions();
+  source.update();
+
+  // sharing is disabled by default
+  moveit::core::RobotState plain(source);
+  EXPECT_FALSE(plain.hasSharedTransforms());
+
+  source.setShareTransformsOnCopy(true);
+  moveit::core::RobotState first(source), second(model);
+  second = source;
+  moveit::core::RobotState copy_of_copy(first);
+  EXPECT_FALSE(source.hasSharedTransforms());
+  EXPECT_TRUE(first.hasSharedTransforms());
+  EXPECT_TRUE(second.hasSharedTransforms());
+  EXPECT_TRUE(copy_of_copy.hasSharedTransforms());
+  EXPECT_EQ(&first.getGlobalLinkTransform(tip), &second.getGlobalLinkTransform(tip));
+  EXPECT_EQ(&first.getGlobalLinkTransform(tip), &copy_of_copy.getGlobalLinkTransform(tip));
+  for (const moveit::core::LinkModel* link : model->getLinkModels())
+    EXPECT_TRUE(source.getGlobalLinkTransform(link).isApprox(first.getGlobalLinkTransform(link)));
+
+  // writing to a copy does not affect the others
+  const Eigen::Isometry3d expected = source.getGlobalLinkTransform(tip);
+  first.setToRandomPositions(group);
+  first.update();
+  EXPECT_FALSE(first.hasSharedTransforms());
+  EXPECT_FALSE(first.getGlobalLinkTransform(tip).isApprox(expected));
+  EXPECT_TRUE(second.getGlobalLinkTransform(tip).isApprox(expected));
+  EXPECT_TRUE(source.getGlobalLinkTransform(tip).isApprox(expected));
+
+  // partial updates of a sharing copy start from the shared transforms
+  copy_of_copy.setVariablePosition("panda_joint7", source.getVariablePosition("panda_joint7"));
+  copy_of_copy.update();
+  EXPECT_FALSE(copy_of_copy.hasSharedTransforms());
+  for (const moveit::core::LinkModel* link : model->getLinkModels())
+  {
+    EXPECT_TRUE(copy_of_copy.getGlobalLinkTransform(link).isApprox(source.getGlobalLinkTransform(link)));
+    for (std::size_t j = 0; j < link->getCollisionOriginTransforms().size(); ++j)
+      EXPECT_TRUE(copy_of_copy.getCollisionBodyTransform(link, j).isApprox(source.getCollisionBodyTransform(link, j)));
+  }
+
+  // writing to the source does not affect existing copies
+  source.setToRandomPositions(group);
+  source.update();
+  EXPECT_TRUE(second.getGlobalLinkTransform(tip).isApprox(expected));
+  moveit::core::RobotState third(source);
+  EXPECT_TRUE(third.hasSharedTransforms());
+  EXPECT_NE(&second.getGlobalLinkTransform(tip), &third.getGlobalLinkTransform(tip));
+  EXPECT_TRUE(third.getGlobalLinkTransform(tip).isApprox(source.getGlobalLinkTransform(tip)));
+}
+
 int main(int argc, char** argv)
 {
   testing::InitGoogleTest(&argc, argv);
@@ -0,0 +1,137 @@
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2026, PickNik LLC.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of PickNik LLC nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *********************************************************************/
+
+#include <moveit/robot_state/batch_forward_kinematics.h>
+#include <moveit/utils/robot_model_test_utils.h>
+#include <gtest/gtest.h>
+
+namespace
+{
+void checkAgainstRobotState(const moveit::core::RobotModelPtr& model)
+{
+  constexpr std::size_t BATCH_SIZE = 17;
+  std::vector<moveit::core::RobotState> states(BATCH_SIZE, moveit::core::RobotState(model));
+  std::vector<const moveit::core::RobotState*> state_ptrs;
+  for (moveit::core::RobotState& state : states)
+  {
+    state.setToRandomPositions();
+    state.update();
+    state_ptrs.push_back(&state);
+  }
+
+  moveit::core::BatchForwardKinematics batch(model);
+  batch.setStates(state_ptrs);
+  ASSERT_EQ(batch.getBatchSize(), BATCH_SIZE);
+  batch.computeLinkTransforms();
+
+  for (std::size_t i = 0; i < BATCH_SIZE; ++i)
+    for (const moveit::core::LinkModel* link : model->getLinkModels())
+    {
+      const Eigen::Isometry3d expected = states[i].getGlobalLinkTransform(link);
+      const Eigen::Isometry3d actual = batch.getGlobalLinkTransform(i, link);
+      EXPECT_TRUE(expected.isApprox(actual, 1e-10)) << "state " << i << ", link " << link->getName();
+      EXPECT_TRUE(expected.translation().isApprox(batch.getGlobalLinkTranslation(i, link), 1e-10));
+    }
+}
+}  // namespace
+
+TEST(BatchForwardKinematics, MatchesRobotStatePanda)
+{
+  checkAgainstRobotState(moveit::core::loadTestingRobotModel("panda"));
+}
+
+TEST(BatchForwardKinematics, MatchesRobotStatePR2)
+{
+  // PR2 includes floating, planar, prismatic and mimic joints
+  checkAgainstRobotState(moveit::core::loadTestingRobotModel("pr2"));
+}
+
+TEST(BatchForwardKinematics, Interpolate)
+{
+  moveit::core::RobotModelPtr model = moveit::core::loadTestingRobotModel("panda");
+  moveit::core::RobotState from(model), to(model), expected(model);
+  from.setToRandomPositions();
+  to.setToRandomPositions();
+
+  moveit::core::BatchForwardKinematics batch(model);
+  batch.interpolate(from, to, 5);
+  batch.computeLinkTransforms();
+
+  const moveit::core::LinkModel* tip = model->getLinkModel("panda_link8");
+  for (std::size_t i = 0; i < 5; ++i)
+  {
+    from.interpolate(to, i / 4.0, expected);
+    expected.update();
+    EXPECT_TRUE(expected.getGlobalLinkTransform(tip).isApprox(batch.getGlobalLinkTransform(i, tip), 1e-10));
+  }
+}
+
+TEST(BatchForwardKinematics, Jacobians)
+{
+  moveit::core::RobotModelPtr model = moveit::core::loadTestingRobotModel("panda");
+  const moveit::core::JointModelGroup* group = model->getJointModelGroup("panda_arm");
+  const moveit::core::LinkModel* tip = model->getLinkModel("panda_link8");
+  moveit::core::RobotState from(model), to(model), state(model);
+  from.setToRandomPositions();
+  to.setToRandomPositions();
+
+  moveit::core::BatchForwardKinematics batch(model);
+  batch.interpolate(from, to, 4);
+  batch.computeLinkTransforms();
+  Eigen::Matrix<double, 6, Eigen::Dynamic> jacobians;
+  batch.computeJacobians(group, tip, Eigen::Vector3d::Zero(), jacobians);
+  ASSERT_EQ(jacobians.cols(), 4 * 7);
+
+  Eigen::MatrixXd expected;
+  for (std::size_t i = 0; i < 4; ++i)
+  {
+    from.interpolate(to, i / 3.0, state);
+    state.update();
+    ASSERT_TRUE(state.getJacobian(group, tip, Eigen::Vector3d::Zero(), expected));
+    EXPECT_TRUE(expected.isApprox(jacobians.middleCols(i * 7, 7), 1e-10)) << "state " << i;
+  }
+}
+
+TEST(BatchForwardKinematics, EmptyBatch)
+{
+  moveit::core::BatchForwardKinematics batch(moveit::core::loadTestingRobotModel("panda"));
+  EXPECT_EQ(batch.getBatchSize(), 0u);
+  batch.computeLinkTransforms();
+}
+
+int main(int argc, char** argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
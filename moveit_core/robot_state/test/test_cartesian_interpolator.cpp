@@ -365,6 +365,43 @@ TEST_F(PandaRobot, testRotationOffset)
   EXPECT_EIGEN_NEAR(result_.back()->getGlobalLinkTransform(link_) * offset, goal, prec_);
 }
 
+TEST_F(PandaRobot, testJacobianStepping)
+{
+  Eigen::Isometry3d goal = start_pose_;
+  goal.translation().x() += 0.2;  // move by 0.2 along world's x-axis
+  const JacobianStepping stepping(true);
+  const double tolerance = 1e-4;
+
+  ASSERT_DOUBLE_EQ(CartesianInterpolator::computeCartesianPath(start_state_.get(), jmg_, result_, link_, goal, true,
+                                                               MaxEEFStep(0.01), JumpThreshold(),
+                                                               GroupStateValidityCallbackFn(),
+                                                               kinematics::KinematicsQueryOptions(),
+                                                               Eigen::Isometry3d::Identity(), stepping),
+                   1.0);
+  EXPECT_EIGEN_EQ(result_.front()->getGlobalLinkTransform(link_), start_pose_);
+  for (const auto& waypoint : result_)
+    EXPECT_EIGEN_NEAR(waypoint->getGlobalLinkTransform(link_).linear(), start_pose_.linear(), tolerance);
+  EXPECT_EIGEN_NEAR(result_.back()->getGlobalLinkTransform(link_).translation(), goal.translation(), tolerance);
+
+  // the validity of the states is checked after the path was computed, and it is truncated before the first invalid
+  // state
+  const double x_limit = start_pose_.translation().x() + 0.1 + tolerance;
+  const GroupStateValidityCallbackFn valid = [this, x_limit](RobotState* state, const JointModelGroup* group,
+                                                             const double* values) {
+    state->setJointGroupPositions(group, values);
+    state->update();
+    return state->getGlobalLinkTransform(link_).translation().x() <= x_limit;
+  };
+  ASSERT_TRUE(start_state_->setToDefaultValues(jmg_, "ready"));
+  const double fraction = CartesianInterpolator::computeCartesianPath(
+      start_state_.get(), jmg_, result_, link_, goal, true, MaxEEFStep(0.01), JumpThreshold(), valid,
+      kinematics::KinematicsQueryOptions(), Eigen::Isometry3d::Identity(), stepping);
+  EXPECT_NEAR(fraction, 0.5, 0.05);
+  EXPECT_EQ(result_.size(), 11u);
+  for (const auto& waypoint : result_)
+    EXPECT_LE(waypoint->getGlobalLinkTransform(link_).translation().x(), x_limit);
+}
+
 int main(int argc, char** argv)
 {
   testing::InitGoogleTest(&argc, argv);
@@ -38,6 +38,7 @@
 #include <moveit/robot_state/robot_state.h>
 #include <moveit/robot_state/conversions.h>
 #include <urdf_parser/urdf_parser.h>
+#include <algorithm>
 #include <fstream>
 #include <gtest/gtest.h>
 #include <boost/filesystem/path.hpp>
@@ -353,6 +354,47 @@ TEST_F(LoadPlanningModelsPr2, ObjectPoseAndSubframes)
   EXPECT_TRUE(p.isApprox(p2, EPSILON));
 }
 
+TEST_F(LoadPlanningModelsPr2, ConversionPlan)
+{
+  moveit::core::RobotState state(robot_model_);
+  state.setToRandomPositions();
+  state.setVariableVelocities(std::vector<double>(robot_model_->getVariableCount(), 0.5));
+  state.update();
+
+  moveit::core::RobotStateConversionPlan plan(robot_model_);
+  moveit_msgs::RobotState expected, msg;
+  moveit::core::robotStateToRobotStateMsg(state, expected);
+  // convert twice into the same message; the second conversion reuses its memory
+  for (int i = 0; i < 2; ++i)
+  {
+    plan.robotStateToRobotStateMsg(state, msg);
+    EXPECT_EQ(msg.joint_state.name, expected.joint_state.name);
+    EXPECT_EQ(msg.joint_state.position, expected.joint_state.position);
+    EXPECT_EQ(msg.joint_state.velocity, expected.joint_state.velocity);
+    EXPECT_EQ(msg.multi_dof_joint_state.joint_names, expected.multi_dof_joint_state.joint_names);
+    EXPECT_EQ(msg.multi_dof_joint_state.transforms.size(), expected.multi_dof_joint_state.transforms.size());
+  }
+
+  // shuffle the joint order, as a different publisher would
+  std::reverse(msg.joint_state.name.begin(), msg.joint_state.name.end());
+  std::reverse(msg.joint_state.position.begin(), msg.joint_state.position.end());
+  std::reverse(msg.joint_state.velocity.begin(), msg.joint_state.velocity.end());
+  for (int i = 0; i < 2; ++i)
+  {
+    moveit::core::RobotState converted(robot_model_);
+    converted.setToDefaultValues();
+    ASSERT_TRUE(plan.robotStateMsgToRobotState(msg, converted));
+    for (const moveit::core::JointModel* joint : robot_model_->getSingleDOFJointModels())
+      EXPECT_NEAR(converted.getJointPositions(joint)[0], state.getJointPositions(joint)[0], 1e-9) << joint->getName();
+    EXPECT_TRUE(converted.getGlobalLinkTransform("r_gripper_palm_link")
+                    .isApprox(state.getGlobalLinkTransform("r_gripper_palm_link"), 1e-9));
+  }
+
+  sensor_msgs::JointState invalid;
+  invalid.name.push_back("r_shoulder_pan_joint");
+  EXPECT_FALSE(plan.jointStateToRobotState(invalid, state));
+}
+
 int main(int argc, char** argv)
 {
   testing::InitGoogleTest(&argc, argv);
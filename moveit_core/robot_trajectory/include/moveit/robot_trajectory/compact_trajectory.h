@@ -0,0 +1,188 @@
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2026, PickNik LLC.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of PickNik LLC nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *********************************************************************/
+
+#pragma once
+
+#include <moveit/robot_trajectory/robot_trajectory.h>
+#include <Eigen/Core>
+#include <vector>
+
+namespace robot_trajectory
+{
+MOVEIT_CLASS_FORWARD(CompactTrajectory);  // Defines CompactTrajectoryPtr, ConstPtr, WeakPtr... etc
+
+/** \brief A trajectory for a JointModelGroup that stores only the group's variables.
+
+    Positions, velocities and accelerations are kept in three contiguous column-major matrices with one column of
+    JointModelGroup::getVariableCount() values per waypoint, instead of one full RobotState (including all link
+    transforms of the robot) per waypoint as in RobotTrajectory. Variables outside the group are taken from a
+    reference state. Full RobotStates are only materialized on demand by getWayPoint(). */
+class CompactTrajectory
+{
+public:
+  /** \brief Construct an empty trajectory for \e group. \e reference_state provides the values of all
+      variables that are not part of \e group. */
+  CompactTrajectory(const moveit::core::RobotState& reference_state, const moveit::core::JointModelGroup* group);
+
+  /** \brief Construct a compact copy of \e trajectory, using its first waypoint as reference state.
+      \e trajectory must have a group and at least one waypoint. */
+  explicit CompactTrajectory(const RobotTrajectory& trajectory);
+
+  const moveit::core::RobotModelConstPtr& getRobotModel() const
+  {
+    return reference_state_.getRobotModel();
+  }
+
+  const moveit::core::JointModelGroup* getGroup() const
+  {
+    return group_;
+  }
+
+  const moveit::core::RobotState& getReferenceState() const
+  {
+    return reference_state_;
+  }
+
+  void setReferenceState(const moveit::core::RobotState& state);
+
+  std::size_t getVariableCount() const
+  {
+    return variable_count_;
+  }
+
+  std::size_t getWayPointCount() const
+  {
+    return durations_.size();
+  }
+
+  bool empty() const
+  {
+    return durations_.empty();
+  }
+
+  void clear();
+
+  void reserve(std::size_t count);
+
+  /** \brief Append a waypoint. \e velocities and \e accelerations may be nullptr (they are then set to zero).
+      All arrays hold getVariableCount() values in the order of JointModelGroup::getVariableNames(). */
+  CompactTrajectory& addSuffixWayPoint(const double* positions, const double* velocities,
+                                       const double* accelerations, double dt);
+
+  /** \brief Append the group variables of \e state as a waypoint */
+  CompactTrajectory& addSuffixWayPoint(const moveit::core::RobotState& state, double dt);
+
+  /** \brief Matrix of positions, one column per waypoint */
+  Eigen::Map<const Eigen::MatrixXd> getPositions() const
+  {
+    return Eigen::Map<const Eigen::MatrixXd>(positions_.data(), variable_count_, getWayPointCount());
+  }
+
+  Eigen::Map<Eigen::MatrixXd> getPositions()
+  {
+    return Eigen::Map<Eigen::MatrixXd>(positions_.data(), variable_count_, getWayPointCount());
+  }
+
+  /** \brief Matrix of velocities, one column per waypoint */
+  Eigen::Map<const Eigen::MatrixXd> getVelocities() const
+  {
+    return Eigen::Map<const Eigen::MatrixXd>(velocities_.data(), variable_count_, getWayPointCount());
+  }
+
+  Eigen::Map<Eigen::MatrixXd> getVelocities()
+  {
+    return Eigen::Map<Eigen::MatrixXd>(velocities_.data(), variable_count_, getWayPointCount());
+  }
+
+  /** \brief Matrix of accelerations, one column per waypoint */
+  Eigen::Map<const Eigen::MatrixXd> getAccelerations() const
+  {
+    return Eigen::Map<const Eigen::MatrixXd>(accelerations_.data(), variable_count_, getWayPointCount());
+  }
+
+  Eigen::Map<Eigen::MatrixXd> getAccelerations()
+  {
+    return Eigen::Map<Eigen::MatrixXd>(accelerations_.data(), variable_count_, getWayPointCount());
+  }
+
+  const std::vector<double>& getWayPointDurations() const
+  {
+    return durations_;
+  }
+
+  double getWayPointDurationFromPrevious(std::size_t index) const
+  {
+    return index < durations_.size() ? durations_[index] : 0.0;
+  }
+
+  CompactTrajectory& setWayPointDurationFromPrevious(std::size_t index, double value)
+  {
+    durations_[index] = value;
+    return *this;
+  }
+
+  double getDuration() const;
+
+  /** \brief Unwind the positions of the continuous joints of the group, as RobotTrajectory::unwind() does */
+  CompactTrajectory& unwind();
+
+  /** \brief Get waypoint \e index as a full RobotState, materialized from the reference state and the compact
+      storage. The returned state is reused and only remains valid until the next call to getWayPoint().
+      This function is not thread-safe. */
+  const moveit::core::RobotState& getWayPoint(std::size_t index) const;
+
+  /** \brief Replace the content of this trajectory by the group variables of \e trajectory */
+  CompactTrajectory& setRobotTrajectory(const RobotTrajectory& trajectory);
+
+  /** \brief Expand this trajectory into full RobotStates */
+  void getRobotTrajectory(RobotTrajectory& trajectory) const;
+
+  /** \brief Convert to a message directly from the compact storage. Velocities and accelerations are always
+      filled in. Multi-DOF joints are converted through materialized waypoints. */
+  void getRobotTrajectoryMsg(moveit_msgs::RobotTrajectory& trajectory) const;
+
+private:
+  const moveit::core::JointModelGroup* group_;
+  std::size_t variable_count_;
+  moveit::core::RobotState reference_state_;
+
+  std::vector<double> positions_;
+  std::vector<double> velocities_;
+  std::vector<double> accelerations_;
+  std::vector<double> durations_;
+
+  /** \brief Cache for getWayPoint() */
+  mutable moveit::core::RobotState materialized_;
+};
+}  // namespace robot_trajectory
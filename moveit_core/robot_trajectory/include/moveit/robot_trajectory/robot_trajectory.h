@@ -38,10 +38,12 @@
 
 #include <moveit/macros/class_forward.h>
 #include <moveit/robot_state/robot_state.h>
+#include <moveit/robot_state/robot_state_pool.h>
 #include <moveit_msgs/RobotTrajectory.h>
 #include <moveit_msgs/RobotState.h>
 #include <deque>
 #include <memory>
+#include <vector>
 
 namespace robot_trajectory
 {
@@ -90,6 +92,21 @@ public:
 
   const std::string& getGroupName() const;
 
+  /** @brief Let waypoints that this trajectory copies (e.g. in addSuffixWayPoint(const RobotState&, double) or
+   *  setRobotTrajectoryMsg()) draw their memory from \e pool. Pass nullptr to allocate them on the heap again.
+   *  Waypoints added by pointer keep the memory they were created with.
+   */
+  RobotTrajectory& setStatePool(const moveit::core::RobotStatePoolPtr& pool)
+  {
+    state_pool_ = pool;
+    return *this;
+  }
+
+  const moveit::core::RobotStatePoolPtr& getStatePool() const
+  {
+    return state_pool_;
+  }
+
   RobotTrajectory& setGroupName(const std::string& group_name)
   {
     group_ = robot_model_->getJointModelGroup(group_name);
@@ -157,6 +174,7 @@ public:
     if (duration_from_previous_.size() <= index)
       duration_from_previous_.resize(index + 1, 0.0);
     duration_from_previous_[index] = value;
+    time_from_start_.reset();
     return *this;
   }
 
@@ -172,7 +190,7 @@ public:
    */
   RobotTrajectory& addSuffixWayPoint(const moveit::core::RobotState& state, double dt)
   {
-    return addSuffixWayPoint(std::make_shared<moveit::core::RobotState>(state), dt);
+    return addSuffixWayPoint(copyWayPoint(state), dt);
   }
 
   /**
@@ -185,12 +203,13 @@ public:
     state->update();
     waypoints_.push_back(state);
     duration_from_previous_.push_back(dt);
+    time_from_start_.reset();
     return *this;
   }
 
   RobotTrajectory& addPrefixWayPoint(const moveit::core::RobotState& state, double dt)
   {
-    return addPrefixWayPoint(std::make_shared<moveit::core::RobotState>(state), dt);
+    return addPrefixWayPoint(copyWayPoint(state), dt);
   }
 
   RobotTrajectory& addPrefixWayPoint(const moveit::core::RobotStatePtr& state, double dt)
@@ -198,12 +217,13 @@ public:
     state->update();
     waypoints_.push_front(state);
     duration_from_previous_.push_front(dt);
+    time_from_start_.reset();
     return *this;
   }
 
   RobotTrajectory& insertWayPoint(std::size_t index, const moveit::core::RobotState& state, double dt)
   {
-    return insertWayPoint(index, std::make_shared<moveit::core::RobotState>(state), dt);
+    return insertWayPoint(index, copyWayPoint(state), dt);
   }
 
   RobotTrajectory& insertWayPoint(std::size_t index, const moveit::core::RobotStatePtr& state, double dt)
@@ -211,6 +231,7 @@ public:
     state->update();
     waypoints_.insert(waypoints_.begin() + index, state);
     duration_from_previous_.insert(duration_from_previous_.begin() + index, dt);
+    time_from_start_.reset();
     return *this;
   }
 
@@ -233,6 +254,7 @@ public:
   {
     waypoints_.clear();
     duration_from_previous_.clear();
+    time_from_start_.reset();
     return *this;
   }
 
@@ -277,7 +299,7 @@ public:
   RobotTrajectory& unwind();
   RobotTrajectory& unwind(const moveit::core::RobotState& state);
 
-  /** @brief Finds the waypoint indicies before and after a duration from start.
+  /** @brief Finds the waypoint indicies before and after a duration from start, by binary search.
    *  @param The duration from start.
    *  @param The waypoint index before the supplied duration.
    *  @param The waypoint index after (or equal to) the supplied duration.
@@ -294,11 +316,29 @@ public:
    */
   bool getStateAtDurationFromStart(const double request_duration, moveit::core::RobotStatePtr& output_state) const;
 
+  /** @brief Interpolate the robot state at a duration from start into the caller-owned \e output_state, without
+   *  allocating memory once \e output_state holds velocities and accelerations.
+   *  @return True if state is valid, false otherwise (trajectory is empty).
+   */
+  bool getStateAtDurationFromStart(const double request_duration, moveit::core::RobotState& output_state) const;
+
 private:
+  /** @brief The duration from start of every waypoint. It is computed on first use and dropped whenever a duration
+   *  changes; concurrent readers may each compute it, but always see a complete index. */
+  std::shared_ptr<const std::vector<double>> getTimeFromStartIndex() const;
+
+  /** @brief Copy \e state into a new waypoint, using the state pool if one is set */
+  moveit::core::RobotStatePtr copyWayPoint(const moveit::core::RobotState& state) const
+  {
+    return state_pool_ ? state_pool_->clone(state) : std::make_shared<moveit::core::RobotState>(state);
+  }
+
   moveit::core::RobotModelConstPtr robot_model_;
   const moveit::core::JointModelGroup* group_;
+  moveit::core::RobotStatePoolPtr state_pool_;
   std::deque<moveit::core::RobotStatePtr> waypoints_;
   std::deque<double> duration_from_previous_;
+  mutable std::shared_ptr<const std::vector<double>> time_from_start_;
 };
 
 /// \brief Calculate the path length of a given trajectory based on the
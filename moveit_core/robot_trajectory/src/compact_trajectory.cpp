@@ -0,0 +1,242 @@
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2026, PickNik LLC.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of PickNik LLC nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *********************************************************************/
+
+#include <moveit/robot_trajectory/compact_trajectory.h>
+#include <tf2_eigen/tf2_eigen.h>
+#include <boost/math/constants/constants.hpp>
+#include <numeric>
+
+namespace robot_trajectory
+{
+CompactTrajectory::CompactTrajectory(const moveit::core::RobotState& reference_state,
+                                     const moveit::core::JointModelGroup* group)
+  : group_(group)
+  , variable_count_(group ? group->getVariableCount() : 0)
+  , reference_state_(reference_state)
+  , materialized_(reference_state)
+{
+  if (!group_)
+    throw std::invalid_argument("CompactTrajectory requires a JointModelGroup");
+}
+
+CompactTrajectory::CompactTrajectory(const RobotTrajectory& trajectory)
+  : CompactTrajectory(trajectory.getFirstWayPoint(), trajectory.getGroup())
+{
+  setRobotTrajectory(trajectory);
+}
+
+void CompactTrajectory::setReferenceState(const moveit::core::RobotState& state)
+{
+  reference_state_ = state;
+  materialized_ = state;
+}
+
+void CompactTrajectory::clear()
+{
+  positions_.clear();
+  velocities_.clear();
+  accelerations_.clear();
+  durations_.clear();
+}
+
+void CompactTrajectory::reserve(std::size_t count)
+{
+  positions_.reserve(count * variable_count_);
+  velocities_.reserve(count * variable_count_);
+  accelerations_.reserve(count * variable_count_);
+  durations_.reserve(count);
+}
+
+CompactTrajectory& CompactTrajectory::addSuffixWayPoint(const double* positions, const double* velocities,
+                                                        const double* accelerations, double dt)
+{
+  positions_.insert(positions_.end(), positions, positions + variable_count_);
+  if (velocities)
+    velocities_.insert(velocities_.end(), velocities, velocities + variable_count_);
+  else
+    velocities_.resize(velocities_.size() + variable_count_, 0.0);
+  if (accelerations)
+    accelerations_.insert(accelerations_.end(), accelerations, accelerations + variable_count_);
+  else
+    accelerations_.resize(accelerations_.size() + variable_count_, 0.0);
+  durations_.push_back(dt);
+  return *this;
+}
+
+CompactTrajectory& CompactTrajectory::addSuffixWayPoint(const moveit::core::RobotState& state, double dt)
+{
+  const std::size_t offset = positions_.size();
+  positions_.resize(offset + variable_count_);
+  velocities_.resize(offset + variable_count_, 0.0);
+  accelerations_.resize(offset + variable_count_, 0.0);
+  state.copyJointGroupPositions(group_, &positions_[offset]);
+  if (state.hasVelocities())
+    state.copyJointGroupVelocities(group_, &velocities_[offset]);
+  if (state.hasAccelerations())
+    state.copyJointGroupAccelerations(group_, &accelerations_[offset]);
+  durations_.push_back(dt);
+  return *this;
+}
+
+double CompactTrajectory::getDuration() const
+{
+  return std::accumulate(durations_.begin(), durations_.end(), 0.0);
+}
+
+CompactTrajectory& CompactTrajectory::unwind()
+{
+  const std::size_t count = getWayPointCount();
+  if (count == 0)
+    return *this;
+
+  for (const moveit::core::JointModel* cont_joint : group_->getContinuousJointModels())
+  {
+    const int column = group_->getVariableGroupIndex(cont_joint->getName());
+    double running_offset = 0.0;
+    double last_value = positions_[column];
+    for (std::size_t i = 1; i < count; ++i)
+    {
+      double& current_value = positions_[i * variable_count_ + column];
+      if (last_value > current_value + boost::math::constants::pi<double>())
+        running_offset += 2.0 * boost::math::constants::pi<double>();
+      else if (current_value > last_value + boost::math::constants::pi<double>())
+        running_offset -= 2.0 * boost::math::constants::pi<double>();
+      last_value = current_value;
+      current_value += running_offset;
+    }
+  }
+  return *this;
+}
+
+const moveit::core::RobotState& CompactTrajectory::getWayPoint(std::size_t index) const
+{
+  const std::size_t offset = index * variable_count_;
+  materialized_.setJointGroupPositions(group_, &positions_[offset]);
+  materialized_.setJointGroupVelocities(group_, &velocities_[offset]);
+  materialized_.setJointGroupAccelerations(group_, &accelerations_[offset]);
+  materialized_.update();
+  return materialized_;
+}
+
+CompactTrajectory& CompactTrajectory::setRobotTrajectory(const RobotTrajectory& trajectory)
+{
+  clear();
+  reserve(trajectory.getWayPointCount());
+  for (std::size_t i = 0; i < trajectory.getWayPointCount(); ++i)
+    addSuffixWayPoint(trajectory.getWayPoint(i), trajectory.getWayPointDurationFromPrevious(i));
+  return *this;
+}
+
+void CompactTrajectory::getRobotTrajectory(RobotTrajectory& trajectory) const
+{
+  trajectory = RobotTrajectory(getRobotModel(), group_);
+  moveit::core::RobotState state(reference_state_);
+  for (std::size_t i = 0; i < getWayPointCount(); ++i)
+  {
+    const std::size_t offset = i * variable_count_;
+    state.setJointGroupPositions(group_, &positions_[offset]);
+    state.setJointGroupVelocities(group_, &velocities_[offset]);
+    state.setJointGroupAccelerations(group_, &accelerations_[offset]);
+    trajectory.addSuffixWayPoint(state, durations_[i]);
+  }
+}
+
+void CompactTrajectory::getRobotTrajectoryMsg(moveit_msgs::RobotTrajectory& trajectory) const
+{
+  trajectory = moveit_msgs::RobotTrajectory();
+  if (empty())
+    return;
+
+  // column of each single-DOF joint within the compact storage
+  std::vector<std::size_t> onedof_columns;
+  std::vector<const moveit::core::JointModel*> mdof;
+  for (const moveit::core::JointModel* joint : group_->getActiveJointModels())
+  {
+    if (joint->getVariableCount() == 1)
+    {
+      trajectory.joint_trajectory.joint_names.push_back(joint->getName());
+      onedof_columns.push_back(group_->getVariableGroupIndex(joint->getName()));
+    }
+    else
+    {
+      trajectory.multi_dof_joint_trajectory.joint_names.push_back(joint->getName());
+      mdof.push_back(joint);
+    }
+  }
+
+  const std::size_t count = getWayPointCount();
+  if (!onedof_columns.empty())
+  {
+    trajectory.joint_trajectory.header.frame_id = getRobotModel()->getModelFrame();
+    trajectory.joint_trajectory.header.stamp = ros::Time(0);
+    trajectory.joint_trajectory.points.resize(count);
+  }
+  if (!mdof.empty())
+  {
+    trajectory.multi_dof_joint_trajectory.header.frame_id = getRobotModel()->getModelFrame();
+    trajectory.multi_dof_joint_trajectory.header.stamp = ros::Time(0);
+    trajectory.multi_dof_joint_trajectory.points.resize(count);
+  }
+
+  double total_time = 0.0;
+  for (std::size_t i = 0; i < count; ++i)
+  {
+    total_time += durations_[i];
+    const std::size_t offset = i * variable_count_;
+    if (!onedof_columns.empty())
+    {
+      trajectory_msgs::JointTrajectoryPoint& point = trajectory.joint_trajectory.points[i];
+      point.positions.resize(onedof_columns.size());
+      point.velocities.resize(onedof_columns.size());
+      point.accelerations.resize(onedof_columns.size());
+      for (std::size_t j = 0; j < onedof_columns.size(); ++j)
+      {
+        point.positions[j] = positions_[offset + onedof_columns[j]];
+        point.velocities[j] = velocities_[offset + onedof_columns[j]];
+        point.accelerations[j] = accelerations_[offset + onedof_columns[j]];
+      }
+      point.time_from_start = ros::Duration(total_time);
+    }
+    if (!mdof.empty())
+    {
+      getWayPoint(i);
+      trajectory_msgs::MultiDOFJointTrajectoryPoint& point = trajectory.multi_dof_joint_trajectory.points[i];
+      point.transforms.resize(mdof.size());
+      for (std::size_t j = 0; j < mdof.size(); ++j)
+        point.transforms[j] = tf2::eigenToTransform(materialized_.getJointTransform(mdof[j])).transform;
+      point.time_from_start = ros::Duration(total_time);
+    }
+  }
+}
+}  // namespace robot_trajectory
@@ -38,6 +38,7 @@
 #include <moveit/robot_state/conversions.h>
 #include <tf2_eigen/tf2_eigen.h>
 #include <boost/math/constants/constants.hpp>
+#include <algorithm>
 #include <numeric>
 
 namespace robot_trajectory
@@ -66,7 +67,7 @@ RobotTrajectory::RobotTrajectory(const RobotTrajectory& other, bool deepcopy)
     this->waypoints_.clear();
     for (const auto& waypoint : other.waypoints_)
     {
-      this->waypoints_.emplace_back(std::make_shared<moveit::core::RobotState>(*waypoint));
+      this->waypoints_.emplace_back(copyWayPoint(*waypoint));
     }
   }
 }
@@ -98,6 +99,8 @@ void RobotTrajectory::swap(RobotTrajectory& other)
   std::swap(group_, other.group_);
   waypoints_.swap(other.waypoints_);
   duration_from_previous_.swap(other.duration_from_previous_);
+  time_from_start_.swap(other.time_from_start_);
+  state_pool_.swap(other.state_pool_);
 }
 
 RobotTrajectory& RobotTrajectory::append(const RobotTrajectory& source, double dt, size_t start_index, size_t end_index)
@@ -113,6 +116,7 @@ RobotTrajectory& RobotTrajectory::append(const RobotTrajectory& source, double d
                                  std::next(source.duration_from_previous_.begin(), end_index));
   if (duration_from_previous_.size() > index)
     duration_from_previous_[index] += dt;
+  time_from_start_.reset();
 
   return *this;
 }
@@ -130,6 +134,7 @@ RobotTrajectory& RobotTrajectory::reverse()
     duration_from_previous_.push_back(duration_from_previous_.front());
     std::reverse(duration_from_previous_.begin(), duration_from_previous_.end());
     duration_from_previous_.pop_back();
+    time_from_start_.reset();
   }
 
   return *this;
@@ -367,7 +372,7 @@ RobotTrajectory& RobotTrajectory::setRobotTrajectoryMsg(const moveit::core::Robo
   for (std::size_t i = 0; i < state_count; ++i)
   {
     this_time_stamp = trajectory.header.stamp + trajectory.points[i].time_from_start;
-    moveit::core::RobotStatePtr st(new moveit::core::RobotState(copy));
+    moveit::core::RobotStatePtr st = copyWayPoint(copy);
     st->setVariablePositions(trajectory.joint_names, trajectory.points[i].positions);
     if (!trajectory.points[i].velocities.empty())
       st->setVariableVelocities(trajectory.joint_names, trajectory.points[i].velocities);
@@ -398,7 +403,7 @@ RobotTrajectory& RobotTrajectory::setRobotTrajectoryMsg(const moveit::core::Robo
 
   for (std::size_t i = 0; i < state_count; ++i)
   {
-    moveit::core::RobotStatePtr st(new moveit::core::RobotState(copy));
+    moveit::core::RobotStatePtr st = copyWayPoint(copy);
     if (trajectory.joint_trajectory.points.size() > i)
     {
       st->setVariablePositions(trajectory.joint_trajectory.joint_names, trajectory.joint_trajectory.points[i].positions);
@@ -439,6 +444,24 @@ RobotTrajectory& RobotTrajectory::setRobotTrajectoryMsg(const moveit::core::Robo
   return setRobotTrajectoryMsg(st, trajectory);
 }
 
+std::shared_ptr<const std::vector<double>> RobotTrajectory::getTimeFromStartIndex() const
+{
+  std::shared_ptr<const std::vector<double>> index = std::atomic_load(&time_from_start_);
+  if (index)
+    return index;
+
+  auto time_from_start = std::make_shared<std::vector<double>>(duration_from_previous_.size());
+  double time = 0.0;
+  for (std::size_t i = 0; i < duration_from_previous_.size(); ++i)
+  {
+    time += duration_from_previous_[i];
+    (*time_from_start)[i] = time;
+  }
+  index = std::move(time_from_start);
+  std::atomic_store(&time_from_start_, index);
+  return index;
+}
+
 void RobotTrajectory::findWayPointIndicesForDurationAfterStart(const double& duration, int& before, int& after,
                                                                double& blend) const
 {
@@ -450,24 +473,23 @@ void RobotTrajectory::findWayPointIndicesForDurationAfterStart(const double& dur
     return;
   }
 
-  // Find indicies
-  std::size_t index = 0, num_points = waypoints_.size();
-  double running_duration = 0.0;
-  for (; index < num_points; ++index)
-  {
-    running_duration += duration_from_previous_[index];
-    if (running_duration >= duration)
-      break;
-  }
+  // Find indicies: the first waypoint reached at or after duration
+  const std::shared_ptr<const std::vector<double>> time_from_start = getTimeFromStartIndex();
+  const std::size_t num_points = std::min(waypoints_.size(), time_from_start->size());
+  const std::size_t index =
+      std::lower_bound(time_from_start->begin(), time_from_start->begin() + num_points, duration) -
+      time_from_start->begin();
   before = std::max<int>(index - 1, 0);
   after = std::min<int>(index, num_points - 1);
 
   // Compute duration blend
-  double before_time = running_duration - duration_from_previous_[index];
   if (after == before)
     blend = 1.0;
   else
+  {
+    double before_time = (*time_from_start)[index] - duration_from_previous_[index];
     blend = (duration - before_time) / duration_from_previous_[index];
+  }
 }
 
 double RobotTrajectory::getWayPointDurationFromStart(std::size_t index) const
@@ -477,10 +499,7 @@ double RobotTrajectory::getWayPointDurationFromStart(std::size_t index) const
   if (index >= duration_from_previous_.size())
     index = duration_from_previous_.size() - 1;
 
-  double time = 0.0;
-  for (std::size_t i = 0; i <= index; ++i)
-    time += duration_from_previous_[i];
-  return time;
+  return (*getTimeFromStartIndex())[index];
 }
 
 double RobotTrajectory::getWaypointDurationFromStart(std::size_t index) const
@@ -490,6 +509,12 @@ double RobotTrajectory::getWaypointDurationFromStart(std::size_t index) const
 
 bool RobotTrajectory::getStateAtDurationFromStart(const double request_duration,
                                                   moveit::core::RobotStatePtr& output_state) const
+{
+  return getStateAtDurationFromStart(request_duration, *output_state);
+}
+
+bool RobotTrajectory::getStateAtDurationFromStart(const double request_duration,
+                                                  moveit::core::RobotState& output_state) const
 {
   // If there are no waypoints we can't do anything
   if (getWayPointCount() == 0)
@@ -500,7 +525,7 @@ bool RobotTrajectory::getStateAtDurationFromStart(const double request_duration,
   findWayPointIndicesForDurationAfterStart(request_duration, before, after, blend);
   // ROS_DEBUG_NAMED("robot_trajectory", "Interpolating %.3f of the way between index %d and %d.", blend, before,
   // after);
-  waypoints_[before]->interpolate(*waypoints_[after], blend, *output_state);
+  waypoints_[before]->interpolate(*waypoints_[after], blend, output_state);
   return true;
 }
 
@@ -252,6 +252,42 @@ TEST_F(RobotTrajectoryTestFixture, RobotTrajectoryDeepCopy)
   EXPECT_NE(trajectory->getWayPointDurationFromPrevious(0), trajectory_copy->getWayPointDurationFromPrevious(0));
 }
 
+TEST_F(RobotTrajectoryTestFixture, DurationLookup)
+{
+  robot_trajectory::RobotTrajectoryPtr trajectory;
+  initTestTrajectory(trajectory);
+
+  int before, after;
+  double blend;
+  trajectory->findWayPointIndicesForDurationAfterStart(0.25, before, after, blend);
+  EXPECT_EQ(before, 1);
+  EXPECT_EQ(after, 2);
+  EXPECT_NEAR(blend, 0.5, 1e-9);
+  EXPECT_NEAR(trajectory->getWayPointDurationFromStart(2), 0.3, 1e-9);
+
+  // beyond the end, the last waypoint is returned
+  trajectory->findWayPointIndicesForDurationAfterStart(1.0, before, after, blend);
+  EXPECT_EQ(before, 4);
+  EXPECT_EQ(after, 4);
+  EXPECT_EQ(blend, 1.0);
+
+  // modifying a duration invalidates the lookup index
+  trajectory->setWayPointDurationFromPrevious(1, 0.3);
+  EXPECT_NEAR(trajectory->getWayPointDurationFromStart(2), 0.5, 1e-9);
+  trajectory->findWayPointIndicesForDurationAfterStart(0.25, before, after, blend);
+  EXPECT_EQ(before, 0);
+  EXPECT_EQ(after, 1);
+  trajectory->addPrefixWayPoint(*robot_state_, 0.2);
+  EXPECT_NEAR(trajectory->getWayPointDurationFromStart(3), 0.7, 1e-9);
+
+  // interpolation into a caller-owned state
+  moveit::core::RobotState state(*robot_state_);
+  EXPECT_TRUE(trajectory->getStateAtDurationFromStart(0.4, state));
+  EXPECT_EQ(state.getVariablePosition(0), robot_state_->getVariablePosition(0));
+  trajectory->clear();
+  EXPECT_FALSE(trajectory->getStateAtDurationFromStart(0.4, state));
+}
+
 int main(int argc, char** argv)
 {
   testing::InitGoogleTest(&argc, argv);
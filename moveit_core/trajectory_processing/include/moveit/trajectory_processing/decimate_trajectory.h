@@ -0,0 +1,67 @@
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2026, PickNik LLC.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of PickNik LLC nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *********************************************************************/
+
+#pragma once
+
+#include <moveit/robot_trajectory/robot_trajectory.h>
+#include <string>
+#include <vector>
+
+namespace trajectory_processing
+{
+/**
+ * \brief Remove waypoints that can be reproduced by interpolating between their retained neighbors.
+ *
+ * A waypoint is dropped when linear interpolation in time between the surrounding retained waypoints reproduces
+ * every active joint of the trajectory's group within \e joint_tolerance (as measured by JointModel::distance())
+ * and, if \e cartesian_tolerance is positive, the origin of the checked link(s) within \e cartesian_tolerance [m].
+ * The first and last waypoints are always kept. Retained waypoints keep their time from start, velocities and
+ * accelerations, so the timing of a time-parameterized trajectory is preserved.
+ *
+ * \param[in,out] trajectory Trajectory to decimate
+ * \param[in] joint_tolerance Maximum joint-space deviation of a removed waypoint
+ * \param[in] cartesian_tolerance Maximum Cartesian deviation of a removed waypoint. Disabled if not positive.
+ * \param[in] link_name Link checked against \e cartesian_tolerance. Defaults to the end-effector tips of the group.
+ * \return false if the tolerances or the link are invalid. The trajectory is left untouched in that case.
+ */
+bool decimateTrajectory(robot_trajectory::RobotTrajectory& trajectory, const double joint_tolerance,
+                        const double cartesian_tolerance = 0.0, const std::string& link_name = "");
+
+/**
+ * \brief Same as above, also reporting the original indices of the retained waypoints in \e retained_indices.
+ */
+bool decimateTrajectory(robot_trajectory::RobotTrajectory& trajectory, const double joint_tolerance,
+                        const double cartesian_tolerance, const std::string& link_name,
+                        std::vector<std::size_t>& retained_indices);
+}  // namespace trajectory_processing
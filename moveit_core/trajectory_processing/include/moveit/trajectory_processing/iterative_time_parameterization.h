@@ -37,6 +37,7 @@
 #pragma once
 
 #include <moveit/robot_trajectory/robot_trajectory.h>
+#include <moveit/robot_trajectory/compact_trajectory.h>
 #include <moveit/trajectory_processing/time_parameterization.h>
 
 namespace trajectory_processing
@@ -54,6 +55,10 @@ public:
 
   static void updateTrajectory(robot_trajectory::RobotTrajectory& rob_trajectory, const std::vector<double>& time_diff);
 
+  /** \brief Same as above on the compact storage. The velocities of the first waypoint are always kept, as the
+      compact storage does not distinguish unset velocities from zero ones. */
+  static void updateTrajectory(robot_trajectory::CompactTrajectory& trajectory, const std::vector<double>& time_diff);
+
 private:
   unsigned int max_iterations_;    /// @brief maximum number of iterations to find solution
   double max_time_change_per_it_;  /// @brief maximum allowed time change per iteration in seconds
@@ -38,7 +38,9 @@
 #pragma once
 
 #include <moveit/macros/class_forward.h>
+#include <moveit/robot_trajectory/compact_trajectory.h>
 #include <string>
+#include <vector>
 namespace trajectory_processing
 {
 MOVEIT_CLASS_FORWARD(RobotTrajectory);
@@ -50,4 +52,14 @@ bool limitMaxCartesianLinkSpeed(robot_trajectory::RobotTrajectory& trajectory, c
                                 const moveit::core::LinkModel* link_model);
 bool limitMaxCartesianLinkSpeed(robot_trajectory::RobotTrajectory& trajectory, const double speed,
                                 const std::string& link_name = "");
+
+/** \brief Limit the Cartesian speed of all \e links in a single pass: the transforms of each waypoint are computed
+    once and every segment is stretched to the time required by its fastest link. */
+bool limitMaxCartesianLinkSpeed(robot_trajectory::RobotTrajectory& trajectory, const double speed,
+                                const std::vector<const moveit::core::LinkModel*>& links);
+
+/** \brief Same as above on the compact storage, computing the link transforms from the position matrix with a
+    single scratch state */
+bool limitMaxCartesianLinkSpeed(robot_trajectory::CompactTrajectory& trajectory, const double speed,
+                                const std::vector<const moveit::core::LinkModel*>& links);
 }  // namespace trajectory_processing
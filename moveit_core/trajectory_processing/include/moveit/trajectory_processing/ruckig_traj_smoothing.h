@@ -113,11 +113,17 @@ private:
                      ruckig::InputParameter<ruckig::DynamicDOFs>& ruckig_input, size_t batch_size = 100);
 
   /**
-   * \brief A utility function to instantiate and run Ruckig for a series of waypoints.
+   * \brief A utility function to run Ruckig for a series of waypoints.
+   * If a segment cannot be reached within the time step, all durations are stretched in place and the failing segment
+   * is checked first on the next attempt.
    * \param[in, out] trajectory      Trajectory to smooth.
    * \param[in, out] ruckig_input    Necessary input for Ruckig smoothing. Contains kinematic limits (vel, accel, jerk)
+   * \param[in, out] ruckig          Preallocated Ruckig instance for the DOF of the group. Its time step is set here.
+   * \param[out] ruckig_output       Preallocated output of \e ruckig
    */
   [[nodiscard]] static bool runRuckig(robot_trajectory::RobotTrajectory& trajectory,
-                                      ruckig::InputParameter<ruckig::DynamicDOFs>& ruckig_input);
+                                      ruckig::InputParameter<ruckig::DynamicDOFs>& ruckig_input,
+                                      ruckig::Ruckig<ruckig::DynamicDOFs>& ruckig,
+                                      ruckig::OutputParameter<ruckig::DynamicDOFs>& ruckig_output);
 };
 }  // namespace trajectory_processing
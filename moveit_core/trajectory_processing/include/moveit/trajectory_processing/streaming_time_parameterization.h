@@ -0,0 +1,90 @@
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2026, PickNik LLC.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of PickNik LLC nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *********************************************************************/
+
+#pragma once
+
+#include <moveit/robot_trajectory/robot_trajectory.h>
+#include <moveit/trajectory_processing/time_parameterization.h>
+#include <deque>
+
+namespace trajectory_processing
+{
+/// \brief Times a path while its waypoints are still arriving, so execution can start before the path is complete.
+///
+/// Waypoints are added with addWayPoint(). Each call to computeTimeStamps() times the pending waypoints, starting
+/// from the last released waypoint and coming to rest at the last known waypoint, and releases a prefix of the timed
+/// waypoints. The last \e lookahead pending waypoints are held back and timed again once more waypoints arrive, so the
+/// released trajectory does not slow down at every window end. Since every window ends at rest, the trajectory
+/// released so far can always be completed safely by stopping at the known end of the path.
+///
+/// Holding waypoints back requires a parameterization that starts from the velocities of the first waypoint (see
+/// TimeParameterization::supportsInitialVelocity()), such as IterativeSplineParameterization. Otherwise, or if the
+/// parameterization resamples the path, every window is released completely and the stream stops at window ends.
+MOVEIT_CLASS_FORWARD(StreamingTimeParameterization);
+class StreamingTimeParameterization
+{
+public:
+  /** \brief Constructor
+      \param parameterization The parameterization that times each window
+      \param lookahead The number of pending waypoints held back for the next window */
+  StreamingTimeParameterization(const TimeParameterizationConstPtr& parameterization, std::size_t lookahead = 5,
+                                double max_velocity_scaling_factor = 1.0, double max_acceleration_scaling_factor = 1.0);
+
+  /** \brief Add a waypoint at the end of the path */
+  void addWayPoint(const moveit::core::RobotState& state);
+
+  /** \brief Time the pending waypoints and append the released ones to \e released, which determines the group.
+      If \e finish is true, all pending waypoints are released and the trajectory comes to rest at the last one.
+      Return false if the parameterization failed; the waypoints remain pending in that case. */
+  bool computeTimeStamps(robot_trajectory::RobotTrajectory& released, bool finish = false);
+
+  /** \brief Forget the pending waypoints and the last released waypoint, to start a new path */
+  void reset();
+
+  /** \brief Get the number of waypoints that were added but not released yet */
+  std::size_t getPendingWayPointCount() const
+  {
+    return pending_.size();
+  }
+
+private:
+  TimeParameterizationConstPtr parameterization_;
+  std::size_t lookahead_;
+  double max_velocity_scaling_factor_;
+  double max_acceleration_scaling_factor_;
+
+  moveit::core::RobotStatePtr anchor_;  // last released waypoint with its velocities and accelerations, if any
+  std::deque<moveit::core::RobotStatePtr> pending_;
+};
+}  // namespace trajectory_processing
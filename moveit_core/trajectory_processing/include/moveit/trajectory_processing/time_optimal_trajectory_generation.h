@@ -40,53 +40,71 @@
 
 #include <Eigen/Core>
 #include <list>
+#include <vector>
 #include <moveit/robot_trajectory/robot_trajectory.h>
+#include <moveit/robot_trajectory/compact_trajectory.h>
 #include <moveit/trajectory_processing/time_parameterization.h>
 
 namespace trajectory_processing
 {
+/// @brief A linear segment or a circular blend of a Path, stored by value and evaluated without virtual dispatch
 class PathSegment
 {
 public:
-  PathSegment(double length = 0.0) : length_(length)
-  {
-  }
-  virtual ~PathSegment()  // is required for destructing derived classes
-  {
-  }
+  /// @brief Create a linear segment from \e start to \e end
+  static PathSegment createLinear(const Eigen::VectorXd& start, const Eigen::VectorXd& end);
+
+  /** @brief Create a circular blend from \e start to \e end around the corner at \e intersection, deviating at most
+      \e max_deviation from the corner */
+  static PathSegment createCircular(const Eigen::VectorXd& start, const Eigen::VectorXd& intersection,
+                                    const Eigen::VectorXd& end, double max_deviation);
+
   double getLength() const
   {
     return length_;
   }
-  virtual Eigen::VectorXd getConfig(double s) const = 0;
-  virtual Eigen::VectorXd getTangent(double s) const = 0;
-  virtual Eigen::VectorXd getCurvature(double s) const = 0;
-  virtual std::list<double> getSwitchingPoints() const = 0;
-  virtual PathSegment* clone() const = 0;
+  Eigen::VectorXd getConfig(double s) const;
+  Eigen::VectorXd getTangent(double s) const;
+  Eigen::VectorXd getCurvature(double s) const;
+  /// @brief Append the switching points within the segment to \e switching_points, in ascending order
+  void getSwitchingPoints(std::vector<double>& switching_points) const;
 
   double position_;
 
-protected:
+private:
+  PathSegment(bool circular, double length) : position_(0.0), circular_(circular), length_(length), radius_(1.0)
+  {
+  }
+
+  bool circular_;
   double length_;
+  // linear segments
+  Eigen::VectorXd start_;
+  Eigen::VectorXd end_;
+  // circular segments
+  double radius_;
+  Eigen::VectorXd center_;
+  Eigen::VectorXd x_;
+  Eigen::VectorXd y_;
 };
 
 class Path
 {
 public:
   Path(const std::list<Eigen::VectorXd>& path, double max_deviation = 0.0);
-  Path(const Path& path);
   double getLength() const;
   Eigen::VectorXd getConfig(double s) const;
   Eigen::VectorXd getTangent(double s) const;
   Eigen::VectorXd getCurvature(double s) const;
   double getNextSwitchingPoint(double s, bool& discontinuity) const;
-  std::list<std::pair<double, bool>> getSwitchingPoints() const;
+  const std::vector<std::pair<double, bool>>& getSwitchingPoints() const;
 
 private:
-  PathSegment* getPathSegment(double& s) const;
+  /// @brief Find the segment containing \e s by binary search and make \e s relative to it
+  const PathSegment& getPathSegment(double& s) const;
   double length_;
-  std::list<std::pair<double, bool>> switching_points_;
-  std::list<std::unique_ptr<PathSegment>> path_segments_;
+  std::vector<std::pair<double, bool>> switching_points_;  // sorted by position
+  std::vector<PathSegment> path_segments_;                 // sorted by position
 };
 
 class Trajectory
@@ -134,8 +152,10 @@ private:
                                          double& before_acceleration, double& after_acceleration);
   bool getNextVelocitySwitchingPoint(double path_pos, TrajectoryStep& next_switching_point, double& before_acceleration,
                                      double& after_acceleration);
-  bool integrateForward(std::list<TrajectoryStep>& trajectory, double acceleration);
-  void integrateBackward(std::list<TrajectoryStep>& start_trajectory, double path_pos, double path_vel,
+  /// @brief Sample the conditions for velocity switching points along the whole path, using several threads
+  void sampleVelocitySwitchingConditions();
+  bool integrateForward(std::vector<TrajectoryStep>& trajectory, double acceleration);
+  void integrateBackward(std::vector<TrajectoryStep>& start_trajectory, double path_pos, double path_vel,
                          double acceleration);
   double getMinMaxPathAcceleration(double path_position, double path_velocity, bool max);
   double getMinMaxPhaseSlope(double path_position, double path_velocity, bool max);
@@ -144,20 +164,39 @@ private:
   double getAccelerationMaxPathVelocityDeriv(double path_pos);
   double getVelocityMaxPathVelocityDeriv(double path_pos);
 
-  std::list<TrajectoryStep>::const_iterator getTrajectorySegment(double time) const;
+  /// @brief Find the first step after \e time by binary search, or the last step
+  std::vector<TrajectoryStep>::const_iterator getTrajectorySegment(double time) const;
 
   Path path_;
   Eigen::VectorXd max_velocity_;
   Eigen::VectorXd max_acceleration_;
   unsigned int joint_num_;
   bool valid_;
-  std::list<TrajectoryStep> trajectory_;
-  std::list<TrajectoryStep> end_trajectory_;  // non-empty only if the trajectory generation failed.
+  std::vector<TrajectoryStep> trajectory_;
+  std::vector<TrajectoryStep> end_trajectory_;  // non-empty only if the trajectory generation failed.
+
+  /// Flags of the velocity switching conditions at equally spaced samples of the path, computed on first use
+  enum
+  {
+    SLOPE_REACHES_CURVE = 1,  // the minimum phase slope is at least the slope of the velocity limit curve
+    SLOPE_EXCEEDS_CURVE = 2   // the minimum phase slope is greater than the slope of the velocity limit curve
+  };
+  std::vector<char> velocity_switching_conditions_;
 
   const double time_step_;
+};
 
-  mutable double cached_time_;
-  mutable std::list<TrajectoryStep>::const_iterator cached_trajectory_segment_;
+/** \brief The scaled limits of a group, resolved once from the RobotModel and shared by any number of
+    computeTimeStamps() calls, also concurrent ones */
+struct TimeParameterizationContext
+{
+  const moveit::core::JointModelGroup* group = nullptr;
+  Eigen::VectorXd max_velocity;
+  Eigen::VectorXd max_acceleration;
+  /** Links whose Cartesian speed is limited to max_cartesian_speed. The limit is applied to the resampled output
+      within computeTimeStamps(), directly on the sampled positions. Disabled if empty. */
+  std::vector<const moveit::core::LinkModel*> cartesian_speed_limited_links;
+  double max_cartesian_speed = 0.0;
 };
 
 MOVEIT_CLASS_FORWARD(TimeOptimalTrajectoryGeneration);
@@ -170,6 +209,33 @@ public:
   bool computeTimeStamps(robot_trajectory::RobotTrajectory& trajectory, const double max_velocity_scaling_factor = 1.0,
                          const double max_acceleration_scaling_factor = 1.0) const override;
 
+  /** \brief Time-parameterize a compact trajectory, reading and writing its position matrix directly */
+  bool computeTimeStamps(robot_trajectory::CompactTrajectory& trajectory,
+                         const double max_velocity_scaling_factor = 1.0,
+                         const double max_acceleration_scaling_factor = 1.0) const;
+
+  /** \brief Validate the scaling factors and resolve the scaled limits of the variables of \e group into \e context.
+      Returns false if the limits of the group are invalid. */
+  bool createContext(const moveit::core::JointModelGroup* group, TimeParameterizationContext& context,
+                     const double max_velocity_scaling_factor = 1.0,
+                     const double max_acceleration_scaling_factor = 1.0) const;
+
+  /** \brief Time-parameterize \e trajectory with limits resolved beforehand by createContext(). The trajectory must
+      belong to the group of the context. */
+  bool computeTimeStamps(robot_trajectory::RobotTrajectory& trajectory,
+                         const TimeParameterizationContext& context) const;
+
+  /** \brief Time-parameterize a compact trajectory with limits resolved beforehand by createContext() */
+  bool computeTimeStamps(robot_trajectory::CompactTrajectory& trajectory,
+                         const TimeParameterizationContext& context) const;
+
+  /** \brief Time-parameterize many trajectories of the group of \e context in parallel, e.g. to rank candidates by
+      duration. \e success receives for each trajectory whether it was parameterized; the number of parameterized
+      trajectories is returned. A \e thread_count of 0 uses all hardware threads. */
+  std::size_t computeTimeStamps(const std::vector<robot_trajectory::RobotTrajectoryPtr>& trajectories,
+                                const TimeParameterizationContext& context, std::vector<bool>& success,
+                                unsigned int thread_count = 0) const;
+
 private:
   const double path_tolerance_;
   const double resample_dt_;
@@ -15,5 +15,12 @@ public:
   virtual bool computeTimeStamps(robot_trajectory::RobotTrajectory& trajectory,
                                  const double max_velocity_scaling_factor = 1.0,
                                  const double max_acceleration_scaling_factor = 1.0) const = 0;
+
+  /** \brief Whether computeTimeStamps() starts from the velocities and accelerations of the first waypoint, if it has
+   * them, rather than from rest */
+  virtual bool supportsInitialVelocity() const
+  {
+    return false;
+  }
 };
 }  // namespace trajectory_processing
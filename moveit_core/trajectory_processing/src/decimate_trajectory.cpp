@@ -0,0 +1,168 @@
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2026, PickNik LLC.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of PickNik LLC nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *********************************************************************/
+
+#include <moveit/trajectory_processing/decimate_trajectory.h>
+#include <ros/console.h>
+
+namespace trajectory_processing
+{
+namespace
+{
+const std::string LOGNAME = "trajectory_processing.decimate_trajectory";
+}  // namespace
+
+bool decimateTrajectory(robot_trajectory::RobotTrajectory& trajectory, const double joint_tolerance,
+                        const double cartesian_tolerance, const std::string& link_name)
+{
+  std::vector<std::size_t> retained_indices;
+  return decimateTrajectory(trajectory, joint_tolerance, cartesian_tolerance, link_name, retained_indices);
+}
+
+bool decimateTrajectory(robot_trajectory::RobotTrajectory& trajectory, const double joint_tolerance,
+                        const double cartesian_tolerance, const std::string& link_name,
+                        std::vector<std::size_t>& retained_indices)
+{
+  retained_indices.clear();
+  if (joint_tolerance < 0.0)
+  {
+    ROS_ERROR_NAMED(LOGNAME, "Joint tolerance must not be negative");
+    return false;
+  }
+
+  const moveit::core::RobotModel& model = *trajectory.getRobotModel();
+  const moveit::core::JointModelGroup* group = trajectory.getGroup();
+  const std::vector<const moveit::core::JointModel*>& joints =
+      group ? group->getActiveJointModels() : model.getActiveJointModels();
+
+  std::vector<const moveit::core::LinkModel*> links;
+  if (cartesian_tolerance > 0.0)
+  {
+    if (!link_name.empty())
+    {
+      bool found = false;
+      const moveit::core::LinkModel* link = model.getLinkModel(link_name, &found);
+      if (!found)
+      {
+        ROS_ERROR_STREAM_NAMED(LOGNAME, "Unknown link model '" << link_name << "'");
+        return false;
+      }
+      links.push_back(link);
+    }
+    else if (group)
+      group->getEndEffectorTips(links);
+    if (links.empty())
+    {
+      ROS_ERROR_NAMED(LOGNAME, "No link(s) specified for the Cartesian tolerance");
+      return false;
+    }
+  }
+
+  const std::size_t num_waypoints = trajectory.getWayPointCount();
+  retained_indices.reserve(num_waypoints);
+  retained_indices.push_back(0);
+  if (num_waypoints < 3)
+  {
+    for (std::size_t i = 1; i < num_waypoints; ++i)
+      retained_indices.push_back(i);
+    return true;
+  }
+
+  std::vector<double> time_from_start(num_waypoints, 0.0);
+  for (std::size_t i = 1; i < num_waypoints; ++i)
+    time_from_start[i] = time_from_start[i - 1] + trajectory.getWayPointDurationFromPrevious(i);
+
+  std::vector<double> interpolated(model.getVariableCount());
+  moveit::core::RobotState scratch(trajectory.getWayPoint(0));
+
+  // Check whether all waypoints strictly between first and last are reproduced by interpolating first and last
+  auto reproducible = [&](std::size_t first, std::size_t last) {
+    const moveit::core::RobotState& from = trajectory.getWayPoint(first);
+    const moveit::core::RobotState& to = trajectory.getWayPoint(last);
+    const double span = time_from_start[last] - time_from_start[first];
+    for (std::size_t i = first + 1; i < last; ++i)
+    {
+      // fall back to index spacing for segments without timing
+      const double t = span > 0.0 ? (time_from_start[i] - time_from_start[first]) / span :
+                                    static_cast<double>(i - first) / (last - first);
+      const moveit::core::RobotState& waypoint = trajectory.getWayPoint(i);
+      for (const moveit::core::JointModel* joint : joints)
+      {
+        joint->interpolate(from.getJointPositions(joint), to.getJointPositions(joint), t, interpolated.data());
+        if (joint->distance(interpolated.data(), waypoint.getJointPositions(joint)) > joint_tolerance)
+          return false;
+      }
+      if (links.empty())
+        continue;
+
+      if (group)
+        from.interpolate(to, t, scratch, group);
+      else
+        from.interpolate(to, t, scratch);
+      moveit::core::RobotState& original = *trajectory.getWayPointPtr(i);
+      for (const moveit::core::LinkModel* link : links)
+        if ((scratch.getGlobalLinkTransform(link).translation() - original.getGlobalLinkTransform(link).translation())
+                .norm() > cartesian_tolerance)
+          return false;
+    }
+    return true;
+  };
+
+  // Greedily extend each segment from the last retained waypoint as far as the tolerances allow
+  std::size_t anchor = 0;
+  for (std::size_t last = 2; last < num_waypoints; ++last)
+  {
+    if (!reproducible(anchor, last))
+    {
+      anchor = last - 1;
+      retained_indices.push_back(anchor);
+    }
+  }
+  retained_indices.push_back(num_waypoints - 1);
+
+  if (retained_indices.size() == num_waypoints)
+    return true;
+
+  // Rebuild the trajectory from the retained waypoints, sharing their states and keeping their time from start
+  robot_trajectory::RobotTrajectory decimated(trajectory.getRobotModel(), group);
+  decimated.setStatePool(trajectory.getStatePool());
+  decimated.addSuffixWayPoint(trajectory.getWayPointPtr(0), trajectory.getWayPointDurationFromPrevious(0));
+  for (std::size_t i = 1; i < retained_indices.size(); ++i)
+    decimated.addSuffixWayPoint(trajectory.getWayPointPtr(retained_indices[i]),
+                                time_from_start[retained_indices[i]] - time_from_start[retained_indices[i - 1]]);
+
+  ROS_DEBUG_NAMED(LOGNAME, "Decimated trajectory from %zu to %zu waypoints", num_waypoints, retained_indices.size());
+  trajectory.swap(decimated);
+  return true;
+}
+}  // namespace trajectory_processing
@@ -36,6 +36,7 @@
 
 #include <moveit/trajectory_processing/iterative_spline_parameterization.h>
 #include <moveit/robot_state/conversions.h>
+#include <algorithm>
 #include <vector>
 
 static const double VLIMIT = 1.0;  // default if not specified in model
@@ -43,30 +44,51 @@ static const double ALIMIT = 1.0;  // default if not specified in model
 
 namespace trajectory_processing
 {
-static void fit_cubic_spline(const int n, const double dt[], const double x[], double x1[], double x2[]);
-static void adjust_two_positions(const int n, const double dt[], double x[], double x1[], double x2[],
-                                 const double x2_i, const double x2_f);
-static void init_times(const int n, double dt[], const double x[], const double max_velocity, const double min_velocity);
-static double global_adjustment_factor(const int n, double x1[], double x2[], const double max_velocity,
-                                       const double min_velocity, const double max_acceleration,
-                                       const double min_acceleration);
-
-// The path of a single joint: positions, velocities, and accelerations
-struct SingleJointTrajectory
+// The path of all joints, stored point by point: the values of all joints at a waypoint are contiguous, so the
+// spline fit runs the same recurrence for every joint in an inner loop that the compiler can vectorize
+struct MultiJointTrajectory
 {
-  std::vector<double> positions_;  // joint's position at time[x]
+  MultiJointTrajectory(unsigned int num_joints, unsigned int num_points)
+    : num_joints_(num_joints)
+    , positions_(num_points * num_joints, 0.0)
+    , velocities_(num_points * num_joints, 0.0)
+    , accelerations_(num_points * num_joints, 0.0)
+    , initial_acceleration_(num_joints, 0.0)
+    , final_acceleration_(num_joints, 0.0)
+    , min_velocity_(num_joints)
+    , max_velocity_(num_joints)
+    , min_acceleration_(num_joints)
+    , max_acceleration_(num_joints)
+    , coefficients_(num_points)
+    , a0_(num_joints)
+    , b0_(num_joints)
+  {
+  }
+
+  unsigned int num_joints_;
+  std::vector<double> positions_;  // joint j's position at time[i] is positions_[i * num_joints_ + j]
   std::vector<double> velocities_;
   std::vector<double> accelerations_;
-  double initial_acceleration_;
-  double final_acceleration_;
-  double min_velocity_;
-  double max_velocity_;
-  double min_acceleration_;
-  double max_acceleration_;
+  std::vector<double> initial_acceleration_;
+  std::vector<double> final_acceleration_;
+  std::vector<double> min_velocity_;
+  std::vector<double> max_velocity_;
+  std::vector<double> min_acceleration_;
+  std::vector<double> max_acceleration_;
+
+  // scratch space of the spline fit, allocated once per trajectory
+  std::vector<double> coefficients_;
+  std::vector<double> a0_;
+  std::vector<double> b0_;
 };
 
-void globalAdjustment(std::vector<SingleJointTrajectory>& t2, int num_joints, const int num_points,
-                      std::vector<double>& time_diff);
+static void fit_cubic_splines(const int n, MultiJointTrajectory& t2, const double dt[]);
+static void adjust_two_positions(const int n, MultiJointTrajectory& t2, const double dt[]);
+static void init_times(const int n, double dt[], const double x[], const double max_velocity, const double min_velocity,
+                       const int stride);
+static double global_adjustment_factor(const int n, const MultiJointTrajectory& t2);
+
+void globalAdjustment(MultiJointTrajectory& t2, const int num_points, std::vector<double>& time_diff);
 
 IterativeSplineParameterization::IterativeSplineParameterization(bool add_points) : add_points_(add_points)
 {
@@ -153,82 +175,79 @@ bool IterativeSplineParameterization::computeTimeStamps(robot_trajectory::RobotT
     }
   }
 
-  // JointTrajectory indexes in [point][joint] order.
-  // We need [joint][point] order to solve efficiently,
-  // so convert form here.
+  // JointTrajectory indexes in [point][joint] order, which is kept here: the spline fit of all joints shares
+  // the same time intervals, so it sweeps over the points once and handles all joints at each point.
 
-  std::vector<SingleJointTrajectory> t2(num_joints);
+  MultiJointTrajectory t2(num_joints, num_points);
+  const moveit::core::RobotState& first_point = *trajectory.getWayPointPtr(0);
+  const moveit::core::RobotState& last_point = *trajectory.getWayPointPtr(num_points - 1);
+  const unsigned int last = (num_points - 1) * num_joints;
 
-  for (unsigned int j = 0; j < num_joints; j++)
+  // Copy positions
+  for (unsigned int i = 0; i < num_points; i++)
   {
-    // Copy positions
-    t2[j].positions_.resize(num_points, 0.0);
-    for (unsigned int i = 0; i < num_points; i++)
-    {
-      t2[j].positions_[i] = trajectory.getWayPointPtr(i)->getVariablePosition(idx[j]);
-    }
+    const moveit::core::RobotState& point = *trajectory.getWayPointPtr(i);
+    for (unsigned int j = 0; j < num_joints; j++)
+      t2.positions_[i * num_joints + j] = point.getVariablePosition(idx[j]);
+  }
 
-    // Initialize velocities
-    t2[j].velocities_.resize(num_points, 0.0);
+  for (unsigned int j = 0; j < num_joints; j++)
+  {
     // Copy initial/final velocities if specified
-    if (trajectory.getWayPointPtr(0)->hasVelocities())
-      t2[j].velocities_[0] = trajectory.getWayPointPtr(0)->getVariableVelocity(idx[j]);
-    if (trajectory.getWayPointPtr(num_points - 1)->hasVelocities())
-      t2[j].velocities_[num_points - 1] = trajectory.getWayPointPtr(num_points - 1)->getVariableVelocity(idx[j]);
-
-    // Initialize accelerations
-    t2[j].accelerations_.resize(num_points, 0.0);
-    t2[j].initial_acceleration_ = 0.0;
-    t2[j].final_acceleration_ = 0.0;
+    if (first_point.hasVelocities())
+      t2.velocities_[j] = first_point.getVariableVelocity(idx[j]);
+    if (last_point.hasVelocities())
+      t2.velocities_[last + j] = last_point.getVariableVelocity(idx[j]);
+
     // Copy initial/final accelerations if specified
-    if (trajectory.getWayPointPtr(0)->hasAccelerations())
-      t2[j].initial_acceleration_ = trajectory.getWayPointPtr(0)->getVariableAcceleration(idx[j]);
-    t2[j].accelerations_[0] = t2[j].initial_acceleration_;
-    if (trajectory.getWayPointPtr(num_points - 1)->hasAccelerations())
-      t2[j].final_acceleration_ = trajectory.getWayPointPtr(num_points - 1)->getVariableAcceleration(idx[j]);
-    t2[j].accelerations_[num_points - 1] = t2[j].final_acceleration_;
+    if (first_point.hasAccelerations())
+      t2.initial_acceleration_[j] = first_point.getVariableAcceleration(idx[j]);
+    t2.accelerations_[j] = t2.initial_acceleration_[j];
+    if (last_point.hasAccelerations())
+      t2.final_acceleration_[j] = last_point.getVariableAcceleration(idx[j]);
+    t2.accelerations_[last + j] = t2.final_acceleration_[j];
 
     // Set bounds based on model, or default limits
     const moveit::core::VariableBounds& bounds = rmodel.getVariableBounds(vars[j]);
-    t2[j].max_velocity_ = VLIMIT;
-    t2[j].min_velocity_ = -VLIMIT;
+    t2.max_velocity_[j] = VLIMIT;
+    t2.min_velocity_[j] = -VLIMIT;
     if (bounds.velocity_bounded_)
     {
-      t2[j].max_velocity_ = bounds.max_velocity_;
-      t2[j].min_velocity_ = bounds.min_velocity_;
-      if (t2[j].min_velocity_ == 0.0)
-        t2[j].min_velocity_ = -t2[j].max_velocity_;
+      t2.max_velocity_[j] = bounds.max_velocity_;
+      t2.min_velocity_[j] = bounds.min_velocity_;
+      if (t2.min_velocity_[j] == 0.0)
+        t2.min_velocity_[j] = -t2.max_velocity_[j];
     }
-    t2[j].max_velocity_ *= velocity_scaling_factor;
-    t2[j].min_velocity_ *= velocity_scaling_factor;
+    t2.max_velocity_[j] *= velocity_scaling_factor;
+    t2.min_velocity_[j] *= velocity_scaling_factor;
 
-    t2[j].max_acceleration_ = ALIMIT;
-    t2[j].min_acceleration_ = -ALIMIT;
+    t2.max_acceleration_[j] = ALIMIT;
+    t2.min_acceleration_[j] = -ALIMIT;
     if (bounds.acceleration_bounded_)
     {
-      t2[j].max_acceleration_ = bounds.max_acceleration_;
-      t2[j].min_acceleration_ = bounds.min_acceleration_;
-      if (t2[j].min_acceleration_ == 0.0)
-        t2[j].min_acceleration_ = -t2[j].max_acceleration_;
+      t2.max_acceleration_[j] = bounds.max_acceleration_;
+      t2.min_acceleration_[j] = bounds.min_acceleration_;
+      if (t2.min_acceleration_[j] == 0.0)
+        t2.min_acceleration_[j] = -t2.max_acceleration_[j];
     }
-    t2[j].max_acceleration_ *= acceleration_scaling_factor;
-    t2[j].min_acceleration_ *= acceleration_scaling_factor;
+    t2.max_acceleration_[j] *= acceleration_scaling_factor;
+    t2.min_acceleration_[j] *= acceleration_scaling_factor;
 
     // Error out if bounds don't make sense
-    if (t2[j].max_velocity_ <= 0.0 || t2[j].max_acceleration_ <= 0.0)
+    if (t2.max_velocity_[j] <= 0.0 || t2.max_acceleration_[j] <= 0.0)
     {
       ROS_ERROR_NAMED("trajectory_processing.iterative_spline_parameterization",
                       "Joint %d max velocity %f and max acceleration %f must be greater than zero "
                       "or a solution won't be found.\n",
-                      j, t2[j].max_velocity_, t2[j].max_acceleration_);
+                      j, t2.max_velocity_[j], t2.max_acceleration_[j]);
       return false;
     }
-    if (t2[j].min_velocity_ >= 0.0 || t2[j].min_acceleration_ >= 0.0)
+    if (t2.min_velocity_[j] >= 0.0 || t2.min_acceleration_[j] >= 0.0)
     {
       ROS_ERROR_NAMED("trajectory_processing.iterative_spline_parameterization",
                       "Joint %d min velocity %f and min acceleration %f must be less than zero "
                       "or a solution won't be found.\n",
-                      j, t2[j].min_velocity_, t2[j].min_acceleration_);
+                      j, t2.min_velocity_[j], t2.min_acceleration_[j]);
       return false;
     }
   }
@@ -242,30 +261,29 @@ bool IterativeSplineParameterization::computeTimeStamps(robot_trajectory::RobotT
   }
   for (unsigned int j = 0; j < num_joints; j++)
   {
-    if (t2[j].velocities_[0] > t2[j].max_velocity_ || t2[j].velocities_[0] < t2[j].min_velocity_)
+    if (t2.velocities_[j] > t2.max_velocity_[j] || t2.velocities_[j] < t2.min_velocity_[j])
     {
       ROS_ERROR_NAMED("trajectory_processing.iterative_spline_parameterization", "Initial velocity %f out of bounds\n",
-                      t2[j].velocities_[0]);
+                      t2.velocities_[j]);
       return false;
     }
-    else if (t2[j].velocities_[num_points - 1] > t2[j].max_velocity_ ||
-             t2[j].velocities_[num_points - 1] < t2[j].min_velocity_)
+    else if (t2.velocities_[last + j] > t2.max_velocity_[j] || t2.velocities_[last + j] < t2.min_velocity_[j])
     {
       ROS_ERROR_NAMED("trajectory_processing.iterative_spline_parameterization", "Final velocity %f out of bounds\n",
-                      t2[j].velocities_[num_points - 1]);
+                      t2.velocities_[last + j]);
       return false;
     }
-    else if (t2[j].accelerations_[0] > t2[j].max_acceleration_ || t2[j].accelerations_[0] < t2[j].min_acceleration_)
+    else if (t2.accelerations_[j] > t2.max_acceleration_[j] || t2.accelerations_[j] < t2.min_acceleration_[j])
     {
       ROS_ERROR_NAMED("trajectory_processing.iterative_spline_parameterization",
-                      "Initial acceleration %f out of bounds\n", t2[j].accelerations_[0]);
+                      "Initial acceleration %f out of bounds\n", t2.accelerations_[j]);
       return false;
     }
-    else if (t2[j].accelerations_[num_points - 1] > t2[j].max_acceleration_ ||
-             t2[j].accelerations_[num_points - 1] < t2[j].min_acceleration_)
+    else if (t2.accelerations_[last + j] > t2.max_acceleration_[j] ||
+             t2.accelerations_[last + j] < t2.min_acceleration_[j])
     {
       ROS_ERROR_NAMED("trajectory_processing.iterative_spline_parameterization",
-                      "Final acceleration %f out of bounds\n", t2[j].accelerations_[num_points - 1]);
+                      "Final acceleration %f out of bounds\n", t2.accelerations_[last + j]);
       return false;
     }
   }
@@ -275,33 +293,34 @@ bool IterativeSplineParameterization::computeTimeStamps(robot_trajectory::RobotT
   // epsilon to prevent divide-by-zero
   std::vector<double> time_diff(trajectory.getWayPointCount() - 1, std::numeric_limits<double>::epsilon());
   for (unsigned int j = 0; j < num_joints; j++)
-    init_times(num_points, &time_diff[0], &t2[j].positions_[0], t2[j].max_velocity_, t2[j].min_velocity_);
+    init_times(num_points, &time_diff[0], &t2.positions_[j], t2.max_velocity_[j], t2.min_velocity_[j], num_joints);
 
   // Stretch intervals until close to the bounds
+  std::vector<double> time_factor(num_points - 1);
   while (1)
   {
     int loop = 0;
 
+    // Move points to satisfy initial/final acceleration
+    if (add_points_)
+      adjust_two_positions(num_points, t2, &time_diff[0]);
+
+    fit_cubic_splines(num_points, t2, &time_diff[0]);
+
     // Calculate the interval stretches due to acceleration
-    std::vector<double> time_factor(num_points - 1, 1.00);
-    for (unsigned j = 0; j < num_joints; j++)
+    std::fill(time_factor.begin(), time_factor.end(), 1.00);
+    for (unsigned i = 0; i < num_points; i++)
     {
-      // Move points to satisfy initial/final acceleration
-      if (add_points_)
+      for (unsigned j = 0; j < num_joints; j++)
       {
-        adjust_two_positions(num_points, &time_diff[0], &t2[j].positions_[0], &t2[j].velocities_[0],
-                             &t2[j].accelerations_[0], t2[j].initial_acceleration_, t2[j].final_acceleration_);
-      }
-
-      fit_cubic_spline(num_points, &time_diff[0], &t2[j].positions_[0], &t2[j].velocities_[0], &t2[j].accelerations_[0]);
-      for (unsigned i = 0; i < num_points; i++)
-      {
-        const double acc = t2[j].accelerations_[i];
+        const double acc = t2.accelerations_[i * num_joints + j];
         double atfactor = 1.0;
-        if (acc > t2[j].max_acceleration_)
-          atfactor = sqrt(acc / t2[j].max_acceleration_);
-        if (acc < t2[j].min_acceleration_)
-          atfactor = sqrt(acc / t2[j].min_acceleration_);
+        if (acc > t2.max_acceleration_[j])
+          atfactor = sqrt(acc / t2.max_acceleration_[j]);
+        else if (acc < t2.min_acceleration_[j])
+          atfactor = sqrt(acc / t2.min_acceleration_[j]);
+        else
+          continue;  // within bounds, so neither neighboring segment is stretched
         if (atfactor > 1.01)  // within 1%
           loop = 1;
         atfactor = (atfactor - 1.0) / 16.0 + 1.0;  // 1/16th
@@ -315,13 +334,13 @@ bool IterativeSplineParameterization::computeTimeStamps(robot_trajectory::RobotT
     if (loop == 0)
       break;  // finished
 
-    // Stretch
+    // Stretch only the segments next to a violation
     for (unsigned i = 0; i < num_points - 1; i++)
       time_diff[i] *= time_factor[i];
   }
 
   // Final adjustment forces the trajectory within bounds
-  globalAdjustment(t2, num_joints, num_points, time_diff);
+  globalAdjustment(t2, num_points, time_diff);
 
   // Convert back to JointTrajectory form
   for (unsigned int i = 1; i < num_points; i++)
@@ -330,15 +349,15 @@ bool IterativeSplineParameterization::computeTimeStamps(robot_trajectory::RobotT
   {
     for (unsigned int j = 0; j < num_joints; j++)
     {
-      trajectory.getWayPointPtr(i)->setVariableVelocity(idx[j], t2[j].velocities_[i]);
-      trajectory.getWayPointPtr(i)->setVariableAcceleration(idx[j], t2[j].accelerations_[i]);
+      trajectory.getWayPointPtr(i)->setVariableVelocity(idx[j], t2.velocities_[i * num_joints + j]);
+      trajectory.getWayPointPtr(i)->setVariableAcceleration(idx[j], t2.accelerations_[i * num_joints + j]);
     }
 
     // Only update position of additionally inserted points (at second and next-to-last position)
     if (add_points_ && (i == 1 || i == num_points - 2))
     {
       for (unsigned int j = 0; j < num_joints; j++)
-        trajectory.getWayPointPtr(i)->setVariablePosition(idx[j], t2[j].positions_[i]);
+        trajectory.getWayPointPtr(i)->setVariablePosition(idx[j], t2.positions_[i * num_joints + j]);
       trajectory.getWayPointPtr(i)->update();
     }
   }
@@ -371,50 +390,75 @@ bool IterativeSplineParameterization::computeTimeStamps(robot_trajectory::RobotT
   using the tridiagonal algorithm.
   There is a forward propogation pass followed by a backsubstitution pass.
 
+  The coefficients of the forward pass only depend on the time intervals, so they are computed once and shared by
+  all joints, whose splines are fitted together in the same sweep over the points.
+
   n is the number of points
   dt contains the time difference between each point (size=n-1)
-  x  contains the positions                          (size=n)
-  x1 contains the 1st derivative (velocities)        (size=n)
-     x1[0] and x1[n-1] MUST be specified.
-  x2 contains the 2nd derivative (accelerations)     (size=n)
+  In t2, for each of the m joints (values of point i at [i*m, (i+1)*m)):
+  x  contains the positions                          (size=n*m)
+  x1 contains the 1st derivative (velocities)        (size=n*m)
+     x1 at points 0 and n-1 MUST be specified.
+  x2 contains the 2nd derivative (accelerations)     (size=n*m)
   x1 and x2 are filled in by the algorithm.
 */
 
-static void fit_cubic_spline(const int n, const double dt[], const double x[], double x1[], double x2[])
+static void fit_cubic_splines(const int n, MultiJointTrajectory& t2, const double dt[])
 {
-  int i;
-  const double x1_i = x1[0], x1_f = x1[n - 1];
+  int i, j;
+  const int m = t2.num_joints_;
+  const double* x = t2.positions_.data();
+  double* x1 = t2.velocities_.data();
+  double* x2 = t2.accelerations_.data();
 
   // Tridiagonal alg - forward sweep
-  // x1 and x2 used to store the temporary coefficients c and d
+  // x2 used to store the temporary coefficients d of all joints
   // (will get overwritten during backsubstitution)
-  double *c = x1, *d = x2;
+  double *c = t2.coefficients_.data(), *d = x2;
   c[0] = 0.5;
-  d[0] = 3.0 * ((x[1] - x[0]) / dt[0] - x1_i) / dt[0];
+  for (j = 0; j < m; j++)
+    d[j] = 3.0 * ((x[m + j] - x[j]) / dt[0] - x1[j]) / dt[0];
   for (i = 1; i <= n - 2; i++)
   {
     const double dt2 = dt[i - 1] + dt[i];
     const double a = dt[i - 1] / dt2;
     const double denom = 2.0 - a * c[i - 1];
     c[i] = (1.0 - a) / denom;
-    d[i] = 6.0 * ((x[i + 1] - x[i]) / dt[i] - (x[i] - x[i - 1]) / dt[i - 1]) / dt2;
-    d[i] = (d[i] - a * d[i - 1]) / denom;
+    const double *x_prev = x + (i - 1) * m, *x_cur = x + i * m, *x_next = x + (i + 1) * m;
+    const double* d_prev = d + (i - 1) * m;
+    double* d_cur = d + i * m;
+    for (j = 0; j < m; j++)
+    {
+      const double d_j = 6.0 * ((x_next[j] - x_cur[j]) / dt[i] - (x_cur[j] - x_prev[j]) / dt[i - 1]) / dt2;
+      d_cur[j] = (d_j - a * d_prev[j]) / denom;
+    }
   }
   const double denom = dt[n - 2] * (2.0 - c[n - 2]);
-  d[n - 1] = 6.0 * (x1_f - (x[n - 1] - x[n - 2]) / dt[n - 2]);
-  d[n - 1] = (d[n - 1] - dt[n - 2] * d[n - 2]) / denom;
+  for (j = 0; j < m; j++)
+  {
+    const double d_j = 6.0 * (x1[(n - 1) * m + j] - (x[(n - 1) * m + j] - x[(n - 2) * m + j]) / dt[n - 2]);
+    d[(n - 1) * m + j] = (d_j - dt[n - 2] * d[(n - 2) * m + j]) / denom;
+  }
 
   // Tridiagonal alg - backsubstitution sweep
-  // 2nd derivative
-  x2[n - 1] = d[n - 1];
+  // 2nd derivative (x2 at point n-1 already holds d)
   for (i = n - 2; i >= 0; i--)
-    x2[i] = d[i] - c[i] * x2[i + 1];
+  {
+    const double* x2_next = x2 + (i + 1) * m;
+    double* x2_cur = x2 + i * m;
+    for (j = 0; j < m; j++)
+      x2_cur[j] = x2_cur[j] - c[i] * x2_next[j];
+  }
 
-  // 1st derivative
-  x1[0] = x1_i;
+  // 1st derivative (x1 at points 0 and n-1 keeps the specified values)
   for (i = 1; i < n - 1; i++)
-    x1[i] = (x[i + 1] - x[i]) / dt[i] - (2 * x2[i] + x2[i + 1]) * dt[i] / 6.0;
-  x1[n - 1] = x1_f;
+  {
+    const double *x_cur = x + i * m, *x_next = x + (i + 1) * m;
+    const double *x2_cur = x2 + i * m, *x2_next = x2 + (i + 1) * m;
+    double* x1_cur = x1 + i * m;
+    for (j = 0; j < m; j++)
+      x1_cur[j] = (x_next[j] - x_cur[j]) / dt[i] - (2 * x2_cur[j] + x2_next[j]) * dt[i] / 6.0;
+  }
 }
 
 /*
@@ -426,26 +470,46 @@ static void fit_cubic_spline(const int n, const double dt[], const double x[], d
   x2_i and x2_f are the (initial and final) 2nd derivative at 0 and N-1
 */
 
-static void adjust_two_positions(const int n, const double dt[], double x[], double x1[], double x2[],
-                                 const double x2_i, const double x2_f)
+static void adjust_two_positions(const int n, MultiJointTrajectory& t2, const double dt[])
 {
-  x[1] = x[0];
-  x[n - 2] = x[n - 3];
-  fit_cubic_spline(n, dt, x, x1, x2);
-  double a0 = x2[0];
-  double b0 = x2[n - 1];
-
-  x[1] = x[2];
-  x[n - 2] = x[n - 1];
-  fit_cubic_spline(n, dt, x, x1, x2);
-  double a2 = x2[0];
-  double b2 = x2[n - 1];
-
-  // we can solve this with linear equation (use two-point form)
-  if (a2 != a0)
-    x[1] = x[0] + ((x[2] - x[0]) / (a2 - a0)) * (x2_i - a0);
-  if (b2 != b0)
-    x[n - 2] = x[n - 3] + ((x[n - 1] - x[n - 3]) / (b2 - b0)) * (x2_f - b0);
+  int j;
+  const int m = t2.num_joints_;
+  double* x = t2.positions_.data();
+  const double* x2 = t2.accelerations_.data();
+  // x_k points to the positions of all joints at point k, with nK standing for n-K
+  const double *x_0 = x, *x_2 = x + 2 * m, *x_n3 = x + (n - 3) * m, *x_n1 = x + (n - 1) * m;
+  double *x_1 = x + m, *x_n2 = x + (n - 2) * m;
+
+  for (j = 0; j < m; j++)
+  {
+    x_1[j] = x_0[j];
+    x_n2[j] = x_n3[j];
+  }
+  fit_cubic_splines(n, t2, dt);
+  for (j = 0; j < m; j++)
+  {
+    t2.a0_[j] = x2[j];
+    t2.b0_[j] = x2[(n - 1) * m + j];
+  }
+
+  for (j = 0; j < m; j++)
+  {
+    x_1[j] = x_2[j];
+    x_n2[j] = x_n1[j];
+  }
+  fit_cubic_splines(n, t2, dt);
+  for (j = 0; j < m; j++)
+  {
+    const double a0 = t2.a0_[j], b0 = t2.b0_[j];
+    const double a2 = x2[j];
+    const double b2 = x2[(n - 1) * m + j];
+
+    // we can solve this with linear equation (use two-point form)
+    if (a2 != a0)
+      x_1[j] = x_0[j] + ((x_2[j] - x_0[j]) / (a2 - a0)) * (t2.initial_acceleration_[j] - a0);
+    if (b2 != b0)
+      x_n2[j] = x_n3[j] + ((x_n1[j] - x_n3[j]) / (b2 - b0)) * (t2.final_acceleration_[j] - b0);
+  }
 }
 
 /*
@@ -453,13 +517,14 @@ static void adjust_two_positions(const int n, const double dt[], double x[], dou
   Increase a segment's time interval if the current time isn't long enough.
 */
 
-static void init_times(const int n, double dt[], const double x[], const double max_velocity, const double min_velocity)
+static void init_times(const int n, double dt[], const double x[], const double max_velocity, const double min_velocity,
+                       const int stride)
 {
   int i;
   for (i = 0; i < n - 1; i++)
   {
     double time;
-    double dx = x[i + 1] - x[i];
+    double dx = x[(i + 1) * stride] - x[i * stride];
     if (dx >= 0.0)
       time = (dx / max_velocity);
     else
@@ -471,98 +536,42 @@ static void init_times(const int n, double dt[], const double x[], const double
   }
 }
 
-#if 0  // unused function
-/*
-  Fit a spline, then check each interval to see if bounds are met.
-  If all bounds met (no time adjustments made), return 0.
-  If bounds not met (time adjustments made), slightly increase the
-  surrounding time intervals and return 1.
-
-  n is the number of points
-  dt contains the time difference between each point (size=n-1)
-  x  contains the positions                          (size=n)
-  x1 contains the 1st derivative (velocities)        (size=n)
-     x1[0] and x1[n-1] MUST be specified.
-  x2 contains the 2nd derivative (accelerations)     (size=n)
-  max_velocity is the max velocity for this joint.
-  min_velocity is the min velocity for this joint.
-  max_acceleration is the max acceleration for this joint.
-  min_acceleration is the min acceleration for this joint.
-  tfactor is the time adjustment (multiplication) factor.
-  x1 and x2 are filled in by the algorithm.
-*/
-
-static int fit_spline_and_adjust_times(const int n, double dt[], const double x[], double x1[], double x2[],
-                                       const double max_velocity, const double min_velocity,
-                                       const double max_acceleration, const double min_acceleration,
-                                       const double tfactor)
-{
-  int i, ret = 0;
-
-  fit_cubic_spline(n, dt, x, x1, x2);
-
-  // Instantaneous velocity is calculated at each point
-  for (i = 0; i < n - 1; i++)
-  {
-    const double vel = x1[i];
-    const double vel2 = x1[i + 1];
-    if (vel > max_velocity || vel < min_velocity || vel2 > max_velocity || vel2 < min_velocity)
-    {
-      dt[i] *= tfactor;
-      ret = 1;
-    }
-  }
-  // Instantaneous acceleration is calculated at each point
-  if (ret == 0)
-  {
-    for (i = 0; i < n - 1; i++)
-    {
-      const double acc = x2[i];
-      const double acc2 = x2[i + 1];
-      if (acc > max_acceleration || acc < min_acceleration || acc2 > max_acceleration || acc2 < min_acceleration)
-      {
-        dt[i] *= tfactor;
-        ret = 1;
-      }
-    }
-  }
-
-  return ret;
-}
-#endif
-
 // return global expansion multiplicative factor required
 // to force within bounds.
 // Assumes that the spline is already fit
-// (fit_cubic_spline must have been called before this).
-static double global_adjustment_factor(const int n, double x1[], double x2[], const double max_velocity,
-                                       const double min_velocity, const double max_acceleration,
-                                       const double min_acceleration)
+// (fit_cubic_splines must have been called before this).
+static double global_adjustment_factor(const int n, const MultiJointTrajectory& t2)
 {
-  int i;
+  int i, j;
+  const int m = t2.num_joints_;
   double tfactor2 = 1.00;
 
   for (i = 0; i < n; i++)
   {
-    double tfactor;
-    tfactor = x1[i] / max_velocity;
-    if (tfactor2 < tfactor)
-      tfactor2 = tfactor;
-    tfactor = x1[i] / min_velocity;
-    if (tfactor2 < tfactor)
-      tfactor2 = tfactor;
-
-    if (x2[i] >= 0)
+    for (j = 0; j < m; j++)
     {
-      tfactor = sqrt(fabs(x2[i] / max_acceleration));
+      const double x1 = t2.velocities_[i * m + j];
+      const double x2 = t2.accelerations_[i * m + j];
+      double tfactor;
+      tfactor = x1 / t2.max_velocity_[j];
       if (tfactor2 < tfactor)
         tfactor2 = tfactor;
-    }
-    else
-    {
-      tfactor = sqrt(fabs(x2[i] / min_acceleration));
+      tfactor = x1 / t2.min_velocity_[j];
       if (tfactor2 < tfactor)
         tfactor2 = tfactor;
+
+      if (x2 >= 0)
+      {
+        tfactor = sqrt(fabs(x2 / t2.max_acceleration_[j]));
+        if (tfactor2 < tfactor)
+          tfactor2 = tfactor;
+      }
+      else
+      {
+        tfactor = sqrt(fabs(x2 / t2.min_acceleration_[j]));
+        if (tfactor2 < tfactor)
+          tfactor2 = tfactor;
+      }
     }
   }
 
@@ -570,26 +579,14 @@ static double global_adjustment_factor(const int n, double x1[], double x2[], co
 }
 
 // Expands the entire trajectory to fit exactly within bounds
-void globalAdjustment(std::vector<SingleJointTrajectory>& t2, int num_joints, const int num_points,
-                      std::vector<double>& time_diff)
+void globalAdjustment(MultiJointTrajectory& t2, const int num_points, std::vector<double>& time_diff)
 {
-  double gtfactor = 1.0;
-  for (int j = 0; j < num_joints; j++)
-  {
-    double tfactor;
-    tfactor = global_adjustment_factor(num_points, &t2[j].velocities_[0], &t2[j].accelerations_[0], t2[j].max_velocity_,
-                                       t2[j].min_velocity_, t2[j].max_acceleration_, t2[j].min_acceleration_);
-    if (tfactor > gtfactor)
-      gtfactor = tfactor;
-  }
+  const double gtfactor = global_adjustment_factor(num_points, t2);
 
   // printf("# Global adjustment: %0.4f%%\n", 100.0 * (gtfactor - 1.0));
   for (int i = 0; i < num_points - 1; i++)
     time_diff[i] *= gtfactor;
 
-  for (int j = 0; j < num_joints; j++)
-  {
-    fit_cubic_spline(num_points, &time_diff[0], &t2[j].positions_[0], &t2[j].velocities_[0], &t2[j].accelerations_[0]);
-  }
+  fit_cubic_splines(num_points, t2, &time_diff[0]);
 }
 }  // namespace trajectory_processing
@@ -294,6 +294,50 @@ void IterativeParabolicTimeParameterization::updateTrajectory(robot_trajectory::
   }
 }
 
+void IterativeParabolicTimeParameterization::updateTrajectory(robot_trajectory::CompactTrajectory& trajectory,
+                                                              const std::vector<double>& time_diff)
+{
+  if (time_diff.empty())
+    return;
+
+  const int num_points = trajectory.getWayPointCount();
+  trajectory.setWayPointDurationFromPrevious(0, 0.0);
+  for (int i = 1; i < num_points; ++i)
+    trajectory.setWayPointDurationFromPrevious(i, time_diff[i - 1]);
+  if (num_points <= 1)
+    return;
+
+  const Eigen::Map<const Eigen::MatrixXd> positions =
+      static_cast<const robot_trajectory::CompactTrajectory&>(trajectory).getPositions();
+  Eigen::Map<Eigen::MatrixXd> velocities = trajectory.getVelocities();
+  Eigen::Map<Eigen::MatrixXd> accelerations = trajectory.getAccelerations();
+
+  // The same finite differences as above, one column of group variables at a time
+  for (int i = 0; i < num_points; ++i)
+  {
+    const double dt1 = i == 0 ? time_diff[0] : time_diff[i - 1];
+    const double dt2 = i == num_points - 1 ? time_diff[i - 1] : time_diff[i];
+    if (dt1 == 0.0 || dt2 == 0.0)
+    {
+      velocities.col(i).setZero();
+      accelerations.col(i).setZero();
+    }
+    else if (i == 0)
+    {
+      // keep the start velocity
+      accelerations.col(i).setZero();
+    }
+    else
+    {
+      const Eigen::VectorXd v1 = (positions.col(i) - positions.col(i - 1)) / dt1;
+      const Eigen::VectorXd v2 =
+          i < num_points - 1 ? Eigen::VectorXd((positions.col(i + 1) - positions.col(i)) / dt2) : Eigen::VectorXd(-v1);
+      velocities.col(i) = (v2 + v1) / 2.0;
+      accelerations.col(i) = 2.0 * (v2 - v1) / (dt1 + dt2);
+    }
+  }
+}
+
 // Applies Acceleration constraints
 void IterativeParabolicTimeParameterization::applyAccelerationConstraints(
     robot_trajectory::RobotTrajectory& rob_trajectory, std::vector<double>& time_diff,
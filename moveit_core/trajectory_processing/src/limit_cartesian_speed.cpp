@@ -37,6 +37,7 @@
 
 #include <moveit/trajectory_processing/iterative_time_parameterization.h>
 #include <moveit/trajectory_processing/limit_cartesian_speed.h>
+#include <algorithm>
 
 // Name of logger
 const char* LOGGER_NAME = "trajectory_processing.cartesian_speed";
@@ -70,18 +71,42 @@ bool limitMaxCartesianLinkSpeed(robot_trajectory::RobotTrajectory& trajectory, c
     }
   }
 
-  // Call function for speed setting using the created link model
-  for (const auto& link : links)
+  if (links.empty())
+    return false;
+  return limitMaxCartesianLinkSpeed(trajectory, max_speed, links);
+}
+
+bool limitMaxCartesianLinkSpeed(robot_trajectory::RobotTrajectory& trajectory, const double max_speed,
+                                const moveit::core::LinkModel* link_model)
+{
+  return limitMaxCartesianLinkSpeed(trajectory, max_speed, std::vector<const moveit::core::LinkModel*>{ link_model });
+}
+
+namespace
+{
+/** Compute the minimum duration of each segment from the link positions of consecutive waypoints, which
+    \e link_positions writes for waypoint \e i into its second argument */
+template <typename LinkPositions>
+void computeSegmentDurations(std::size_t num_waypoints, std::size_t num_links, const double max_speed,
+                             const LinkPositions& link_positions, std::vector<double>& min_time_diff)
+{
+  std::vector<Eigen::Vector3d> previous(num_links), current(num_links);
+  link_positions(0, previous);
+  min_time_diff.assign(num_waypoints - 1, 0.0);
+  for (std::size_t i = 0; i < num_waypoints - 1; ++i)
   {
-    if (!limitMaxCartesianLinkSpeed(trajectory, max_speed, link))
-      return false;
+    link_positions(i + 1, current);
+    double max_distance = 0.0;
+    for (std::size_t l = 0; l < num_links; ++l)
+      max_distance = std::max(max_distance, (current[l] - previous[l]).norm());
+    min_time_diff[i] = max_distance / max_speed;
+    previous.swap(current);
   }
-
-  return !links.empty();
 }
+}  // namespace
 
 bool limitMaxCartesianLinkSpeed(robot_trajectory::RobotTrajectory& trajectory, const double max_speed,
-                                const moveit::core::LinkModel* link_model)
+                                const std::vector<const moveit::core::LinkModel*>& links)
 {
   if (max_speed <= 0.0)
   {
@@ -90,29 +115,58 @@ bool limitMaxCartesianLinkSpeed(robot_trajectory::RobotTrajectory& trajectory, c
   }
 
   size_t num_waypoints = trajectory.getWayPointCount();
-  if (num_waypoints == 0)
+  if (num_waypoints == 0 || links.empty())
     return false;
 
-  // do forward kinematics to get Cartesian positions of link for current waypoint
-  double euclidean_distance, new_time_diff, old_time_diff;
-  std::vector<double> time_diff(num_waypoints - 1, 0.0);
+  // do forward kinematics once per waypoint to get the Cartesian positions of all links
+  std::vector<double> time_diff;
+  computeSegmentDurations(num_waypoints, links.size(), max_speed,
+                          [&](std::size_t i, std::vector<Eigen::Vector3d>& positions) {
+                            moveit::core::RobotState& waypoint = *trajectory.getWayPointPtr(i);
+                            for (std::size_t l = 0; l < links.size(); ++l)
+                              positions[l] = waypoint.getGlobalLinkTransform(links[l]).translation();
+                          },
+                          time_diff);
 
+  // slow-down segments that were too fast before
   for (size_t i = 0; i < num_waypoints - 1; i++)
+    time_diff[i] = std::max(time_diff[i], trajectory.getWayPointDurationFromPrevious(i + 1));
+
+  // update time stamps, velocities and accelerations of the trajectory
+  IterativeParabolicTimeParameterization::updateTrajectory(trajectory, time_diff);
+  return true;
+}
+
+bool limitMaxCartesianLinkSpeed(robot_trajectory::CompactTrajectory& trajectory, const double max_speed,
+                                const std::vector<const moveit::core::LinkModel*>& links)
+{
+  if (max_speed <= 0.0)
   {
-    // get link state for current and next waypoint
-    const Eigen::Isometry3d& current_link_state = trajectory.getWayPointPtr(i)->getGlobalLinkTransform(link_model);
-    const Eigen::Isometry3d& next_link_state = trajectory.getWayPointPtr(i + 1)->getGlobalLinkTransform(link_model);
+    ROS_ERROR_STREAM_NAMED(LOGGER_NAME, "Link speed must be greater than 0.");
+    return false;
+  }
 
-    // get Euclidean distance between the two waypoints
-    euclidean_distance = (next_link_state.translation() - current_link_state.translation()).norm();
+  size_t num_waypoints = trajectory.getWayPointCount();
+  if (num_waypoints == 0 || links.empty())
+    return false;
 
-    new_time_diff = (euclidean_distance / max_speed);
-    old_time_diff = trajectory.getWayPointDurationFromPrevious(i + 1);
+  const moveit::core::JointModelGroup* group = trajectory.getGroup();
+  const Eigen::Map<const Eigen::MatrixXd> positions =
+      static_cast<const robot_trajectory::CompactTrajectory&>(trajectory).getPositions();
+  moveit::core::RobotState state(trajectory.getReferenceState());
+
+  std::vector<double> time_diff;
+  computeSegmentDurations(num_waypoints, links.size(), max_speed,
+                          [&](std::size_t i, std::vector<Eigen::Vector3d>& link_positions) {
+                            state.setJointGroupPositions(group, positions.col(i).data());
+                            for (std::size_t l = 0; l < links.size(); ++l)
+                              link_positions[l] = state.getGlobalLinkTransform(links[l]).translation();
+                          },
+                          time_diff);
+
+  for (size_t i = 0; i < num_waypoints - 1; i++)
+    time_diff[i] = std::max(time_diff[i], trajectory.getWayPointDurationFromPrevious(i + 1));
 
-    // slow-down segment if it was too fast before
-    time_diff[i] = std::max(new_time_diff, old_time_diff);
-  }
-  // update time stamps, velocities and accelerations of the trajectory
   IterativeParabolicTimeParameterization::updateTrajectory(trajectory, time_diff);
   return true;
 }
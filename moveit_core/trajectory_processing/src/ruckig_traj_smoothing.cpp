@@ -172,6 +172,11 @@ RuckigSmoothing::runRuckigInBatches(const size_t num_waypoints, const robot_traj
       robot_trajectory::RobotTrajectory(trajectory, false /* deep copy */);
   output_trajectory.clear();
 
+  // A single Ruckig instance serves all batches and retries, only its time step is changed between them
+  const size_t num_dof = trajectory.getGroup()->getVariableCount();
+  ruckig::Ruckig<ruckig::DynamicDOFs> ruckig(num_dof, trajectory.getAverageSegmentDuration());
+  ruckig::OutputParameter<ruckig::DynamicDOFs> ruckig_output{ num_dof };
+
   while (batch_end_idx <= full_traj_final_idx)
   {
     sub_trajectory.clear();
@@ -189,7 +194,7 @@ RuckigSmoothing::runRuckigInBatches(const size_t num_waypoints, const robot_traj
       first_point_previously_smoothed = true;
     }
 
-    if (!runRuckig(sub_trajectory, ruckig_input))
+    if (!runRuckig(sub_trajectory, ruckig_input, ruckig, ruckig_output))
     {
       return std::nullopt;
     }
@@ -209,7 +214,8 @@ RuckigSmoothing::runRuckigInBatches(const size_t num_waypoints, const robot_traj
     batch_end_idx += batch_size;
   }
 
-  return std::make_optional<robot_trajectory::RobotTrajectory>(output_trajectory, true /* deep copy */);
+  // The waypoints were copied when they were added, so no deep copy is needed
+  return std::make_optional<robot_trajectory::RobotTrajectory>(std::move(output_trajectory));
 }
 
 bool RuckigSmoothing::validateGroup(const robot_trajectory::RobotTrajectory& trajectory)
@@ -271,79 +277,87 @@ bool RuckigSmoothing::getRobotModelBounds(const double max_velocity_scaling_fact
 }
 
 bool RuckigSmoothing::runRuckig(robot_trajectory::RobotTrajectory& trajectory,
-                                ruckig::InputParameter<ruckig::DynamicDOFs>& ruckig_input)
+                                ruckig::InputParameter<ruckig::DynamicDOFs>& ruckig_input,
+                                ruckig::Ruckig<ruckig::DynamicDOFs>& ruckig,
+                                ruckig::OutputParameter<ruckig::DynamicDOFs>& ruckig_output)
 {
   const size_t num_waypoints = trajectory.getWayPointCount();
   moveit::core::JointModelGroup const* const group = trajectory.getGroup();
   const size_t num_dof = group->getVariableCount();
-  ruckig::OutputParameter<ruckig::DynamicDOFs> ruckig_output{ num_dof };
   const std::vector<int>& move_group_idx = group->getVariableIndexList();
 
   // This lib does not work properly when angles wrap, so we need to unwind the path first
   trajectory.unwind();
 
   // Initialize the smoother
-  double timestep = trajectory.getAverageSegmentDuration();
-  std::unique_ptr<ruckig::Ruckig<ruckig::DynamicDOFs>> ruckig_ptr;
-  ruckig_ptr = std::make_unique<ruckig::Ruckig<ruckig::DynamicDOFs>>(num_dof, timestep);
+  const double original_timestep = trajectory.getAverageSegmentDuration();
+  ruckig.delta_time = original_timestep;
   initializeRuckigState(*trajectory.getFirstWayPointPtr(), group, ruckig_input, ruckig_output);
 
-  // Cache the trajectory in case we need to reset it
-  robot_trajectory::RobotTrajectory original_trajectory =
-      robot_trajectory::RobotTrajectory(trajectory, true /* deep copy */);
+  // Cache the durations and velocities, so the trajectory can be stretched in place instead of being copied
+  std::vector<double> original_durations(num_waypoints);
+  std::vector<double> original_velocities(num_waypoints * num_dof);
+  for (size_t waypoint_idx = 0; waypoint_idx < num_waypoints; ++waypoint_idx)
+  {
+    original_durations[waypoint_idx] = trajectory.getWayPointDurationFromPrevious(waypoint_idx);
+    const moveit::core::RobotState& waypoint = trajectory.getWayPoint(waypoint_idx);
+    for (size_t joint = 0; joint < num_dof; ++joint)
+      original_velocities[waypoint_idx * num_dof + joint] = waypoint.getVariableVelocity(move_group_idx[joint]);
+  }
 
   ruckig::Result ruckig_result;
   double duration_extension_factor = 1;
   bool smoothing_complete = false;
+  size_t failed_segment = 0;
   while ((duration_extension_factor <= MAX_DURATION_EXTENSION_FACTOR) && !smoothing_complete)
   {
-    for (size_t waypoint_idx = 0; waypoint_idx < num_waypoints - 1; ++waypoint_idx)
+    smoothing_complete = true;
+    for (size_t segment = 0; segment < num_waypoints - 1; ++segment)
     {
-      moveit::core::RobotStatePtr next_waypoint = trajectory.getWayPointPtr(waypoint_idx + 1);
+      // Check the segment that failed last first, so that a stretch which is still too short costs a single update
+      size_t waypoint_idx = segment;
+      if (segment == 0)
+        waypoint_idx = failed_segment;
+      else if (segment <= failed_segment)
+        waypoint_idx = segment - 1;
 
-      getNextRuckigInput(trajectory.getWayPointPtr(waypoint_idx), next_waypoint, group, ruckig_input);
+      getNextRuckigInput(trajectory.getWayPointPtr(waypoint_idx), trajectory.getWayPointPtr(waypoint_idx + 1), group,
+                         ruckig_input);
 
       // Run Ruckig
-      ruckig_result = ruckig_ptr->update(ruckig_input, ruckig_output);
+      ruckig_result = ruckig.update(ruckig_input, ruckig_output);
 
-      if ((waypoint_idx == num_waypoints - 2) && ruckig_result == ruckig::Result::Finished)
+      // Extend the trajectory duration if Ruckig could not reach the waypoint successfully
+      if (ruckig_result != ruckig::Result::Finished)
       {
-        smoothing_complete = true;
+        failed_segment = waypoint_idx;
+        smoothing_complete = false;
         break;
       }
+    }
 
-      // Extend the trajectory duration if Ruckig could not reach the waypoint successfully
-      if (ruckig_result != ruckig::Result::Finished)
+    if (!smoothing_complete)
+    {
+      duration_extension_factor *= DURATION_EXTENSION_FRACTION;
+      const double timestep = duration_extension_factor * original_timestep;
+      for (size_t time_stretch_idx = 1; time_stretch_idx < num_waypoints; ++time_stretch_idx)
       {
-        duration_extension_factor *= DURATION_EXTENSION_FRACTION;
-        // Reset the trajectory
-        trajectory = robot_trajectory::RobotTrajectory(original_trajectory, true /* deep copy */);
-        for (size_t time_stretch_idx = 1; time_stretch_idx < num_waypoints; ++time_stretch_idx)
+        trajectory.setWayPointDurationFromPrevious(time_stretch_idx,
+                                                   duration_extension_factor * original_durations[time_stretch_idx]);
+        // re-calculate waypoint velocity and acceleration
+        auto target_state = trajectory.getWayPointPtr(time_stretch_idx);
+        const auto prev_state = trajectory.getWayPointPtr(time_stretch_idx - 1);
+        for (size_t joint = 0; joint < num_dof; ++joint)
         {
-          trajectory.setWayPointDurationFromPrevious(
-              time_stretch_idx,
-              duration_extension_factor * original_trajectory.getWayPointDurationFromPrevious(time_stretch_idx));
-          // re-calculate waypoint velocity and acceleration
-          auto target_state = trajectory.getWayPointPtr(time_stretch_idx);
-          const auto prev_state = trajectory.getWayPointPtr(time_stretch_idx - 1);
-          timestep = trajectory.getAverageSegmentDuration();
-          for (size_t joint = 0; joint < num_dof; ++joint)
-          {
-            target_state->setVariableVelocity(move_group_idx.at(joint),
-                                              (1 / duration_extension_factor) *
-                                                  target_state->getVariableVelocity(move_group_idx.at(joint)));
-
-            double prev_velocity = prev_state->getVariableVelocity(move_group_idx.at(joint));
-            double curr_velocity = target_state->getVariableVelocity(move_group_idx.at(joint));
-            target_state->setVariableAcceleration(move_group_idx.at(joint), (curr_velocity - prev_velocity) / timestep);
-          }
-          target_state->update();
+          const double curr_velocity =
+              original_velocities[time_stretch_idx * num_dof + joint] / duration_extension_factor;
+          const double prev_velocity = prev_state->getVariableVelocity(move_group_idx[joint]);
+          target_state->setVariableVelocity(move_group_idx[joint], curr_velocity);
+          target_state->setVariableAcceleration(move_group_idx[joint], (curr_velocity - prev_velocity) / timestep);
         }
-        ruckig_ptr = std::make_unique<ruckig::Ruckig<ruckig::DynamicDOFs>>(num_dof, timestep);
-        initializeRuckigState(*trajectory.getFirstWayPointPtr(), group, ruckig_input, ruckig_output);
-        // Begin the while() loop again
-        break;
+        target_state->update();
       }
+      ruckig.delta_time = timestep;
     }
   }
 
@@ -0,0 +1,101 @@
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2026, PickNik LLC.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of PickNik LLC nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *********************************************************************/
+
+#include <moveit/trajectory_processing/streaming_time_parameterization.h>
+#include <limits>
+
+namespace trajectory_processing
+{
+StreamingTimeParameterization::StreamingTimeParameterization(const TimeParameterizationConstPtr& parameterization,
+                                                             std::size_t lookahead, double max_velocity_scaling_factor,
+                                                             double max_acceleration_scaling_factor)
+  : parameterization_(parameterization)
+  , lookahead_(lookahead)
+  , max_velocity_scaling_factor_(max_velocity_scaling_factor)
+  , max_acceleration_scaling_factor_(max_acceleration_scaling_factor)
+{
+}
+
+void StreamingTimeParameterization::addWayPoint(const moveit::core::RobotState& state)
+{
+  pending_.push_back(std::make_shared<moveit::core::RobotState>(state));
+}
+
+void StreamingTimeParameterization::reset()
+{
+  anchor_.reset();
+  pending_.clear();
+}
+
+bool StreamingTimeParameterization::computeTimeStamps(robot_trajectory::RobotTrajectory& released, bool finish)
+{
+  if (pending_.empty() || (!finish && pending_.size() <= lookahead_))
+    return true;
+
+  // the window starts at the last released waypoint and comes to rest at the last pending waypoint
+  robot_trajectory::RobotTrajectory window(released.getRobotModel(), released.getGroup());
+  if (anchor_)
+    window.addSuffixWayPoint(std::make_shared<moveit::core::RobotState>(*anchor_), 0.0);
+  for (const moveit::core::RobotStatePtr& waypoint : pending_)
+    window.addSuffixWayPoint(std::make_shared<moveit::core::RobotState>(*waypoint), 0.0);
+  window.getLastWayPointPtr()->zeroVelocities();
+  window.getLastWayPointPtr()->zeroAccelerations();
+  if (!parameterization_->computeTimeStamps(window, max_velocity_scaling_factor_, max_acceleration_scaling_factor_))
+    return false;
+
+  // hold back the last waypoints if the next window can continue from the velocities of the last released one and
+  // the parameterization kept that waypoint; waypoints the parameterization inserted only ever precede it
+  const std::size_t first = anchor_ ? 1 : 0;
+  std::size_t end = window.getWayPointCount();
+  std::size_t released_count = pending_.size();
+  if (!finish && lookahead_ > 0 && parameterization_->supportsInitialVelocity())
+  {
+    const std::size_t last = pending_.size() - lookahead_ - 1;
+    for (std::size_t i = first + last; i < window.getWayPointCount(); ++i)
+      if (window.getWayPoint(i).distance(*pending_[last], released.getGroup()) <=
+          std::numeric_limits<double>::epsilon())
+      {
+        end = i + 1;
+        released_count = last + 1;
+        break;
+      }
+  }
+
+  for (std::size_t i = first; i < end; ++i)
+    released.addSuffixWayPoint(window.getWayPointPtr(i), window.getWayPointDurationFromPrevious(i));
+  anchor_ = window.getWayPointPtr(end - 1);
+  pending_.erase(pending_.begin(), pending_.begin() + released_count);
+  return true;
+}
+}  // namespace trajectory_processing
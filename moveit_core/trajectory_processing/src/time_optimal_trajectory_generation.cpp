@@ -37,159 +37,132 @@
  */
 
 #include <limits>
+#include <atomic>
 #include <Eigen/Geometry>
 #include <algorithm>
 #include <cmath>
 #include <moveit/trajectory_processing/time_optimal_trajectory_generation.h>
+#include <moveit/trajectory_processing/limit_cartesian_speed.h>
 #include <ros/console.h>
+#include <thread>
 #include <vector>
 
 namespace trajectory_processing
 {
 const std::string LOGNAME = "trajectory_processing.time_optimal_trajectory_generation";
 constexpr double EPS = 0.000001;
-class LinearPathSegment : public PathSegment
+// spacing of the samples of the velocity limit curve searched for velocity switching points
+constexpr double VELOCITY_SWITCHING_STEP = 0.001;
+// the velocity limit curve is only sampled in parallel for at least this many samples per thread
+constexpr std::size_t MIN_SAMPLES_PER_THREAD = 4096;
+PathSegment PathSegment::createLinear(const Eigen::VectorXd& start, const Eigen::VectorXd& end)
 {
-public:
-  LinearPathSegment(const Eigen::VectorXd& start, const Eigen::VectorXd& end)
-    : PathSegment((end - start).norm()), end_(end), start_(start)
-  {
-  }
+  PathSegment segment(false, (end - start).norm());
+  segment.start_ = start;
+  segment.end_ = end;
+  return segment;
+}
 
-  Eigen::VectorXd getConfig(double s) const override
+PathSegment PathSegment::createCircular(const Eigen::VectorXd& start, const Eigen::VectorXd& intersection,
+                                        const Eigen::VectorXd& end, double max_deviation)
+{
+  PathSegment segment(true, 0.0);
+  if ((intersection - start).norm() < 0.000001 || (end - intersection).norm() < 0.000001)
   {
-    s /= length_;
-    s = std::max(0.0, std::min(1.0, s));
-    return (1.0 - s) * start_ + s * end_;
+    segment.center_ = intersection;
+    segment.x_ = Eigen::VectorXd::Zero(start.size());
+    segment.y_ = Eigen::VectorXd::Zero(start.size());
+    return segment;
   }
 
-  Eigen::VectorXd getTangent(double /* s */) const override
-  {
-    return (end_ - start_) / length_;
-  }
+  const Eigen::VectorXd start_direction = (intersection - start).normalized();
+  const Eigen::VectorXd end_direction = (end - intersection).normalized();
+  const double start_dot_end = start_direction.dot(end_direction);
 
-  Eigen::VectorXd getCurvature(double /* s */) const override
+  // catch division by 0 in computations below
+  if (start_dot_end > 0.999999 || start_dot_end < -0.999999)
   {
-    return Eigen::VectorXd::Zero(start_.size());
+    segment.center_ = intersection;
+    segment.x_ = Eigen::VectorXd::Zero(start.size());
+    segment.y_ = Eigen::VectorXd::Zero(start.size());
+    return segment;
   }
 
-  std::list<double> getSwitchingPoints() const override
-  {
-    return std::list<double>();
-  }
+  const double angle = acos(start_dot_end);
+  const double start_distance = (start - intersection).norm();
+  const double end_distance = (end - intersection).norm();
 
-  LinearPathSegment* clone() const override
-  {
-    return new LinearPathSegment(*this);
-  }
+  // enforce max deviation
+  double distance = std::min(start_distance, end_distance);
+  distance = std::min(distance, max_deviation * sin(0.5 * angle) / (1.0 - cos(0.5 * angle)));
 
-private:
-  Eigen::VectorXd end_;
-  Eigen::VectorXd start_;
-};
+  segment.radius_ = distance / tan(0.5 * angle);
+  segment.length_ = angle * segment.radius_;
 
-class CircularPathSegment : public PathSegment
-{
-public:
-  CircularPathSegment(const Eigen::VectorXd& start, const Eigen::VectorXd& intersection, const Eigen::VectorXd& end,
-                      double max_deviation)
-  {
-    if ((intersection - start).norm() < 0.000001 || (end - intersection).norm() < 0.000001)
-    {
-      length_ = 0.0;
-      radius = 1.0;
-      center = intersection;
-      x = Eigen::VectorXd::Zero(start.size());
-      y = Eigen::VectorXd::Zero(start.size());
-      return;
-    }
-
-    const Eigen::VectorXd start_direction = (intersection - start).normalized();
-    const Eigen::VectorXd end_direction = (end - intersection).normalized();
-    const double start_dot_end = start_direction.dot(end_direction);
-
-    // catch division by 0 in computations below
-    if (start_dot_end > 0.999999 || start_dot_end < -0.999999)
-    {
-      length_ = 0.0;
-      radius = 1.0;
-      center = intersection;
-      x = Eigen::VectorXd::Zero(start.size());
-      y = Eigen::VectorXd::Zero(start.size());
-      return;
-    }
-
-    const double angle = acos(start_dot_end);
-    const double start_distance = (start - intersection).norm();
-    const double end_distance = (end - intersection).norm();
-
-    // enforce max deviation
-    double distance = std::min(start_distance, end_distance);
-    distance = std::min(distance, max_deviation * sin(0.5 * angle) / (1.0 - cos(0.5 * angle)));
-
-    radius = distance / tan(0.5 * angle);
-    length_ = angle * radius;
-
-    center = intersection + (end_direction - start_direction).normalized() * radius / cos(0.5 * angle);
-    x = (intersection - distance * start_direction - center).normalized();
-    y = start_direction;
-  }
+  segment.center_ = intersection + (end_direction - start_direction).normalized() * segment.radius_ / cos(0.5 * angle);
+  segment.x_ = (intersection - distance * start_direction - segment.center_).normalized();
+  segment.y_ = start_direction;
+  return segment;
+}
 
-  Eigen::VectorXd getConfig(double s) const override
+Eigen::VectorXd PathSegment::getConfig(double s) const
+{
+  if (circular_)
   {
-    const double angle = s / radius;
-    return center + radius * (x * cos(angle) + y * sin(angle));
+    const double angle = s / radius_;
+    return center_ + radius_ * (x_ * cos(angle) + y_ * sin(angle));
   }
+  s /= length_;
+  s = std::max(0.0, std::min(1.0, s));
+  return (1.0 - s) * start_ + s * end_;
+}
 
-  Eigen::VectorXd getTangent(double s) const override
+Eigen::VectorXd PathSegment::getTangent(double s) const
+{
+  if (circular_)
   {
-    const double angle = s / radius;
-    return -x * sin(angle) + y * cos(angle);
+    const double angle = s / radius_;
+    return -x_ * sin(angle) + y_ * cos(angle);
   }
+  return (end_ - start_) / length_;
+}
 
-  Eigen::VectorXd getCurvature(double s) const override
+Eigen::VectorXd PathSegment::getCurvature(double s) const
+{
+  if (circular_)
   {
-    const double angle = s / radius;
-    return -1.0 / radius * (x * cos(angle) + y * sin(angle));
+    const double angle = s / radius_;
+    return -1.0 / radius_ * (x_ * cos(angle) + y_ * sin(angle));
   }
+  return Eigen::VectorXd::Zero(start_.size());
+}
 
-  std::list<double> getSwitchingPoints() const override
+void PathSegment::getSwitchingPoints(std::vector<double>& switching_points) const
+{
+  if (!circular_)
+    return;
+  const std::size_t first = switching_points.size();
+  for (Eigen::Index i = 0; i < x_.size(); ++i)
   {
-    std::list<double> switching_points;
-    const double dim = x.size();
-    for (unsigned int i = 0; i < dim; ++i)
+    double switching_angle = atan2(y_[i], x_[i]);
+    if (switching_angle < 0.0)
     {
-      double switching_angle = atan2(y[i], x[i]);
-      if (switching_angle < 0.0)
-      {
-        switching_angle += M_PI;
-      }
-      const double switching_point = switching_angle * radius;
-      if (switching_point < length_)
-      {
-        switching_points.push_back(switching_point);
-      }
+      switching_angle += M_PI;
+    }
+    const double switching_point = switching_angle * radius_;
+    if (switching_point < length_)
+    {
+      switching_points.push_back(switching_point);
     }
-    switching_points.sort();
-    return switching_points;
-  }
-
-  CircularPathSegment* clone() const override
-  {
-    return new CircularPathSegment(*this);
   }
-
-private:
-  double radius;
-  Eigen::VectorXd center;
-  Eigen::VectorXd x;
-  Eigen::VectorXd y;
-};
+  std::sort(switching_points.begin() + first, switching_points.end());
+}
 
 Path::Path(const std::list<Eigen::VectorXd>& path, double max_deviation) : length_(0.0)
 {
   if (path.size() < 2)
     return;
+  path_segments_.reserve(2 * path.size());
   std::list<Eigen::VectorXd>::const_iterator path_iterator1 = path.begin();
   std::list<Eigen::VectorXd>::const_iterator path_iterator2 = path_iterator1;
   ++path_iterator2;
@@ -201,21 +174,20 @@ Path::Path(const std::list<Eigen::VectorXd>& path, double max_deviation) : lengt
     ++path_iterator3;
     if (max_deviation > 0.0 && path_iterator3 != path.end())
     {
-      CircularPathSegment* blend_segment =
-          new CircularPathSegment(0.5 * (*path_iterator1 + *path_iterator2), *path_iterator2,
-                                  0.5 * (*path_iterator2 + *path_iterator3), max_deviation);
-      Eigen::VectorXd end_config = blend_segment->getConfig(0.0);
+      PathSegment blend_segment =
+          PathSegment::createCircular(0.5 * (*path_iterator1 + *path_iterator2), *path_iterator2,
+                                      0.5 * (*path_iterator2 + *path_iterator3), max_deviation);
+      Eigen::VectorXd end_config = blend_segment.getConfig(0.0);
       if ((end_config - start_config).norm() > 0.000001)
       {
-        path_segments_.push_back(std::make_unique<LinearPathSegment>(start_config, end_config));
+        path_segments_.push_back(PathSegment::createLinear(start_config, end_config));
       }
-      path_segments_.emplace_back(blend_segment);
-
-      start_config = blend_segment->getConfig(blend_segment->getLength());
+      start_config = blend_segment.getConfig(blend_segment.getLength());
+      path_segments_.push_back(std::move(blend_segment));
     }
     else
     {
-      path_segments_.push_back(std::make_unique<LinearPathSegment>(start_config, *path_iterator2));
+      path_segments_.push_back(PathSegment::createLinear(start_config, *path_iterator2));
       start_config = *path_iterator2;
     }
     path_iterator1 = path_iterator2;
@@ -223,17 +195,19 @@ Path::Path(const std::list<Eigen::VectorXd>& path, double max_deviation) : lengt
   }
 
   // Create list of switching point candidates, calculate total path length and
-  // absolute positions of path segments
-  for (std::unique_ptr<PathSegment>& path_segment : path_segments_)
+  // absolute positions of path segments. Blends have at most one switching point per joint.
+  switching_points_.reserve(path_segments_.size() * (path.front().size() + 1));
+  std::vector<double> local_switching_points;
+  for (PathSegment& path_segment : path_segments_)
   {
-    path_segment->position_ = length_;
-    std::list<double> local_switching_points = path_segment->getSwitchingPoints();
-    for (std::list<double>::const_iterator point = local_switching_points.begin();
-         point != local_switching_points.end(); ++point)
+    path_segment.position_ = length_;
+    local_switching_points.clear();
+    path_segment.getSwitchingPoints(local_switching_points);
+    for (double point : local_switching_points)
     {
-      switching_points_.push_back(std::make_pair(length_ + *point, false));
+      switching_points_.push_back(std::make_pair(length_ + point, false));
     }
-    length_ += path_segment->getLength();
+    length_ += path_segment.getLength();
     while (!switching_points_.empty() && switching_points_.back().first >= length_)
       switching_points_.pop_back();
     switching_points_.push_back(std::make_pair(length_, true));
@@ -241,58 +215,45 @@ Path::Path(const std::list<Eigen::VectorXd>& path, double max_deviation) : lengt
   switching_points_.pop_back();
 }
 
-Path::Path(const Path& path) : length_(path.length_), switching_points_(path.switching_points_)
-{
-  for (const std::unique_ptr<PathSegment>& path_segment : path.path_segments_)
-  {
-    path_segments_.emplace_back(path_segment->clone());
-  }
-}
-
 double Path::getLength() const
 {
   return length_;
 }
 
-PathSegment* Path::getPathSegment(double& s) const
+const PathSegment& Path::getPathSegment(double& s) const
 {
-  std::list<std::unique_ptr<PathSegment>>::const_iterator it = path_segments_.begin();
-  std::list<std::unique_ptr<PathSegment>>::const_iterator next = it;
-  ++next;
-  while (next != path_segments_.end() && s >= (*next)->position_)
-  {
-    it = next;
-    ++next;
-  }
-  s -= (*it)->position_;
-  return (*it).get();
+  // the last segment starting at or before s, or the first segment
+  std::vector<PathSegment>::const_iterator it =
+      std::upper_bound(path_segments_.begin() + 1, path_segments_.end(), s,
+                       [](double position, const PathSegment& segment) { return position < segment.position_; });
+  --it;
+  s -= it->position_;
+  return *it;
 }
 
 Eigen::VectorXd Path::getConfig(double s) const
 {
-  const PathSegment* path_segment = getPathSegment(s);
-  return path_segment->getConfig(s);
+  const PathSegment& path_segment = getPathSegment(s);
+  return path_segment.getConfig(s);
 }
 
 Eigen::VectorXd Path::getTangent(double s) const
 {
-  const PathSegment* path_segment = getPathSegment(s);
-  return path_segment->getTangent(s);
+  const PathSegment& path_segment = getPathSegment(s);
+  return path_segment.getTangent(s);
 }
 
 Eigen::VectorXd Path::getCurvature(double s) const
 {
-  const PathSegment* path_segment = getPathSegment(s);
-  return path_segment->getCurvature(s);
+  const PathSegment& path_segment = getPathSegment(s);
+  return path_segment.getCurvature(s);
 }
 
 double Path::getNextSwitchingPoint(double s, bool& discontinuity) const
 {
-  std::list<std::pair<double, bool>>::const_iterator it = switching_points_.begin();
-  while (it != switching_points_.end() && it->first <= s)
-  {
-    ++it;
-  }
+  std::vector<std::pair<double, bool>>::const_iterator it =
+      std::upper_bound(switching_points_.begin(), switching_points_.end(), s,
+                       [](double position, const std::pair<double, bool>& point) { return position < point.first; });
   if (it == switching_points_.end())
   {
     discontinuity = true;
@@ -302,7 +263,7 @@ double Path::getNextSwitchingPoint(double s, bool& discontinuity) const
   return it->first;
 }
 
-std::list<std::pair<double, bool>> Path::getSwitchingPoints() const
+const std::vector<std::pair<double, bool>>& Path::getSwitchingPoints() const
 {
   return switching_points_;
 }
@@ -315,7 +276,6 @@ Trajectory::Trajectory(const Path& path, const Eigen::VectorXd& max_velocity, co
   , joint_num_(max_velocity.size())
   , valid_(true)
   , time_step_(time_step)
-  , cached_time_(std::numeric_limits<double>::max())
 {
   trajectory_.push_back(TrajectoryStep(0.0, 0.0));
   double after_acceleration = getMinMaxPathAcceleration(0.0, 0.0, true);
@@ -339,16 +299,13 @@ Trajectory::Trajectory(const Path& path, const Eigen::VectorXd& max_velocity, co
   if (valid_)
   {
     // Calculate timing
-    std::list<TrajectoryStep>::iterator previous = trajectory_.begin();
-    std::list<TrajectoryStep>::iterator it = previous;
-    it->time_ = 0.0;
-    ++it;
-    while (it != trajectory_.end())
+    trajectory_.front().time_ = 0.0;
+    for (std::size_t i = 1; i < trajectory_.size(); ++i)
     {
-      it->time_ =
-          previous->time_ + (it->path_pos_ - previous->path_pos_) / ((it->path_vel_ + previous->path_vel_) / 2.0);
-      previous = it;
-      ++it;
+      const TrajectoryStep& previous = trajectory_[i - 1];
+      TrajectoryStep& step = trajectory_[i];
+      step.time_ =
+          previous.time_ + (step.path_pos_ - previous.path_pos_) / ((step.path_vel_ + previous.path_vel_) / 2.0);
     }
   }
 }
@@ -455,33 +412,61 @@ bool Trajectory::getNextAccelerationSwitchingPoint(double path_pos, TrajectorySt
   return false;
 }
 
+void Trajectory::sampleVelocitySwitchingConditions()
+{
+  const std::size_t count = static_cast<std::size_t>(std::ceil(path_.getLength() / VELOCITY_SWITCHING_STEP));
+  velocity_switching_conditions_.resize(count);
+  const auto sample = [this](std::size_t begin, std::size_t end) {
+    for (std::size_t k = begin; k < end; ++k)
+    {
+      const double path_pos = k * VELOCITY_SWITCHING_STEP;
+      const double phase_slope = getMinMaxPhaseSlope(path_pos, getVelocityMaxPathVelocity(path_pos), false);
+      const double curve_slope = getVelocityMaxPathVelocityDeriv(path_pos);
+      char conditions = 0;
+      if (phase_slope >= curve_slope)
+        conditions |= SLOPE_REACHES_CURVE;
+      if (phase_slope > curve_slope)
+        conditions |= SLOPE_EXCEEDS_CURVE;
+      velocity_switching_conditions_[k] = conditions;
+    }
+  };
+
+  // the samples are independent, so long paths are split in chunks over several threads
+  const std::size_t threads = std::min<std::size_t>(std::max(1u, std::thread::hardware_concurrency()),
+                                                    count / MIN_SAMPLES_PER_THREAD + 1);
+  const std::size_t chunk = (count + threads - 1) / threads;
+  std::vector<std::thread> workers;
+  for (std::size_t t = 1; t < threads; ++t)
+    workers.emplace_back(sample, std::min(count, t * chunk), std::min(count, (t + 1) * chunk));
+  sample(0, std::min(count, chunk));
+  for (std::thread& worker : workers)
+    worker.join();
+}
+
 bool Trajectory::getNextVelocitySwitchingPoint(double path_pos, TrajectoryStep& next_switching_point,
                                                double& before_acceleration, double& after_acceleration)
 {
-  const double step_size = 0.001;
   const double accuracy = 0.000001;
 
-  bool start = false;
-  path_pos -= step_size;
-  do
-  {
-    path_pos += step_size;
+  if (velocity_switching_conditions_.empty())
+    sampleVelocitySwitchingConditions();
 
-    if (getMinMaxPhaseSlope(path_pos, getVelocityMaxPathVelocity(path_pos), false) >=
-        getVelocityMaxPathVelocityDeriv(path_pos))
-    {
-      start = true;
-    }
-  } while ((!start || getMinMaxPhaseSlope(path_pos, getVelocityMaxPathVelocity(path_pos), false) >
-                          getVelocityMaxPathVelocityDeriv(path_pos)) &&
-           path_pos < path_.getLength());
+  // find the first sample from path_pos on where the phase slope reaches the slope of the velocity limit curve, and
+  // the first sample from there on where it no longer exceeds it
+  const std::size_t count = velocity_switching_conditions_.size();
+  std::size_t k = static_cast<std::size_t>(std::max(0.0, std::ceil(path_pos / VELOCITY_SWITCHING_STEP)));
+  while (k < count && !(velocity_switching_conditions_[k] & SLOPE_REACHES_CURVE))
+    ++k;
+  while (k < count && (velocity_switching_conditions_[k] & SLOPE_EXCEEDS_CURVE))
+    ++k;
 
-  if (path_pos >= path_.getLength())
+  if (k >= count)
   {
     return true;  // end of trajectory reached
   }
+  path_pos = k * VELOCITY_SWITCHING_STEP;
 
-  double before_path_pos = path_pos - step_size;
+  double before_path_pos = path_pos - VELOCITY_SWITCHING_STEP;
   double after_path_pos = path_pos;
   while (after_path_pos - before_path_pos > accuracy)
   {
@@ -504,13 +489,13 @@ bool Trajectory::getNextVelocitySwitchingPoint(double path_pos, TrajectoryStep&
 }
 
 // Returns true if end of path is reached
-bool Trajectory::integrateForward(std::list<TrajectoryStep>& trajectory, double acceleration)
+bool Trajectory::integrateForward(std::vector<TrajectoryStep>& trajectory, double acceleration)
 {
   double path_pos = trajectory.back().path_pos_;
   double path_vel = trajectory.back().path_vel_;
 
-  std::list<std::pair<double, bool>> switching_points = path_.getSwitchingPoints();
-  std::list<std::pair<double, bool>>::iterator next_discontinuity = switching_points.begin();
+  const std::vector<std::pair<double, bool>>& switching_points = path_.getSwitchingPoints();
+  std::vector<std::pair<double, bool>>::const_iterator next_discontinuity = switching_points.begin();
 
   while (true)
   {
@@ -620,32 +605,31 @@ bool Trajectory::integrateForward(std::list<TrajectoryStep>& trajectory, double
   }
 }
 
-void Trajectory::integrateBackward(std::list<TrajectoryStep>& start_trajectory, double path_pos, double path_vel,
+void Trajectory::integrateBackward(std::vector<TrajectoryStep>& start_trajectory, double path_pos, double path_vel,
                                    double acceleration)
 {
-  std::list<TrajectoryStep>::iterator start2 = start_trajectory.end();
-  --start2;
-  std::list<TrajectoryStep>::iterator start1 = start2;
-  --start1;
-  std::list<TrajectoryStep> trajectory;
+  std::size_t start2 = start_trajectory.size() - 1;
+  std::size_t start1 = start2 - 1;
+  // the backward trajectory in reverse order, so steps are appended rather than prepended
+  std::vector<TrajectoryStep> trajectory;
   double slope;
-  assert(start1->path_pos_ <= path_pos);
+  assert(start_trajectory[start1].path_pos_ <= path_pos);
 
-  while (start1 != start_trajectory.begin() || path_pos >= 0.0)
+  while (start1 != 0 || path_pos >= 0.0)
   {
-    if (start1->path_pos_ <= path_pos)
+    if (start_trajectory[start1].path_pos_ <= path_pos)
     {
-      trajectory.push_front(TrajectoryStep(path_pos, path_vel));
+      trajectory.push_back(TrajectoryStep(path_pos, path_vel));
       path_vel -= time_step_ * acceleration;
-      path_pos -= time_step_ * 0.5 * (path_vel + trajectory.front().path_vel_);
+      path_pos -= time_step_ * 0.5 * (path_vel + trajectory.back().path_vel_);
       acceleration = getMinMaxPathAcceleration(path_pos, path_vel, false);
-      slope = (trajectory.front().path_vel_ - path_vel) / (trajectory.front().path_pos_ - path_pos);
+      slope = (trajectory.back().path_vel_ - path_vel) / (trajectory.back().path_pos_ - path_pos);
 
       if (path_vel < 0.0)
       {
         valid_ = false;
         ROS_ERROR_NAMED(LOGNAME, "Error while integrating backward: Negative path velocity");
-        end_trajectory_ = trajectory;
+        end_trajectory_.assign(trajectory.rbegin(), trajectory.rend());
         return;
       }
     }
@@ -657,41 +641,39 @@ void Trajectory::integrateBackward(std::list<TrajectoryStep>& start_trajectory,
 
     // Check for intersection between current start trajectory and backward
     // trajectory segments
-    const double start_slope = (start2->path_vel_ - start1->path_vel_) / (start2->path_pos_ - start1->path_pos_);
+    const TrajectoryStep& step1 = start_trajectory[start1];
+    const TrajectoryStep& step2 = start_trajectory[start2];
+    const double start_slope = (step2.path_vel_ - step1.path_vel_) / (step2.path_pos_ - step1.path_pos_);
     const double intersection_path_pos =
-        (start1->path_vel_ - path_vel + slope * path_pos - start_slope * start1->path_pos_) / (slope - start_slope);
-    if (std::max(start1->path_pos_, path_pos) - EPS <= intersection_path_pos &&
-        intersection_path_pos <= EPS + std::min(start2->path_pos_, trajectory.front().path_pos_))
+        (step1.path_vel_ - path_vel + slope * path_pos - start_slope * step1.path_pos_) / (slope - start_slope);
+    if (std::max(step1.path_pos_, path_pos) - EPS <= intersection_path_pos &&
+        intersection_path_pos <= EPS + std::min(step2.path_pos_, trajectory.back().path_pos_))
     {
-      const double intersection_path_vel =
-          start1->path_vel_ + start_slope * (intersection_path_pos - start1->path_pos_);
-      start_trajectory.erase(start2, start_trajectory.end());
+      const double intersection_path_vel = step1.path_vel_ + start_slope * (intersection_path_pos - step1.path_pos_);
+      start_trajectory.resize(start2);
       start_trajectory.push_back(TrajectoryStep(intersection_path_pos, intersection_path_vel));
-      start_trajectory.splice(start_trajectory.end(), trajectory);
+      start_trajectory.insert(start_trajectory.end(), trajectory.rbegin(), trajectory.rend());
       return;
     }
   }
 
   valid_ = false;
   ROS_ERROR_NAMED(LOGNAME, "Error while integrating backward: Did not hit start trajectory");
-  end_trajectory_ = trajectory;
+  end_trajectory_.assign(trajectory.rbegin(), trajectory.rend());
 }
 
 double Trajectory::getMinMaxPathAcceleration(double path_pos, double path_vel, bool max)
 {
-  Eigen::VectorXd config_deriv = path_.getTangent(path_pos);
-  Eigen::VectorXd config_deriv2 = path_.getCurvature(path_pos);
+  const Eigen::ArrayXd config_deriv = path_.getTangent(path_pos).array();
+  const Eigen::ArrayXd config_deriv2 = path_.getCurvature(path_pos).array();
   double factor = max ? 1.0 : -1.0;
-  double max_path_acceleration = std::numeric_limits<double>::max();
-  for (unsigned int i = 0; i < joint_num_; ++i)
-  {
-    if (config_deriv[i] != 0.0)
-    {
-      max_path_acceleration =
-          std::min(max_path_acceleration, max_acceleration_[i] / std::abs(config_deriv[i]) -
-                                              factor * config_deriv2[i] * path_vel * path_vel / config_deriv[i]);
-    }
-  }
+  // joints that do not move along the path do not limit the acceleration
+  const double max_path_acceleration =
+      (config_deriv != 0.0)
+          .select(max_acceleration_.array() / config_deriv.abs() -
+                      factor * config_deriv2 * path_vel * path_vel / config_deriv,
+                  std::numeric_limits<double>::max())
+          .minCoeff();
   return factor * max_path_acceleration;
 }
 
@@ -734,12 +716,7 @@ double Trajectory::getAccelerationMaxPathVelocity(double path_pos) const
 double Trajectory::getVelocityMaxPathVelocity(double path_pos) const
 {
   const Eigen::VectorXd tangent = path_.getTangent(path_pos);
-  double max_path_velocity = std::numeric_limits<double>::max();
-  for (unsigned int i = 0; i < joint_num_; ++i)
-  {
-    max_path_velocity = std::min(max_path_velocity, max_velocity_[i] / std::abs(tangent[i]));
-  }
-  return max_path_velocity;
+  return std::min(std::numeric_limits<double>::max(), (max_velocity_.array() / tangent.array().abs()).minCoeff());
 }
 
 double Trajectory::getAccelerationMaxPathVelocityDeriv(double path_pos)
@@ -751,17 +728,8 @@ double Trajectory::getAccelerationMaxPathVelocityDeriv(double path_pos)
 double Trajectory::getVelocityMaxPathVelocityDeriv(double path_pos)
 {
   const Eigen::VectorXd tangent = path_.getTangent(path_pos);
-  double max_path_velocity = std::numeric_limits<double>::max();
-  unsigned int active_constraint;
-  for (unsigned int i = 0; i < joint_num_; ++i)
-  {
-    const double this_max_path_velocity = max_velocity_[i] / std::abs(tangent[i]);
-    if (this_max_path_velocity < max_path_velocity)
-    {
-      max_path_velocity = this_max_path_velocity;
-      active_constraint = i;
-    }
-  }
+  Eigen::Index active_constraint;
+  (max_velocity_.array() / tangent.array().abs()).minCoeff(&active_constraint);
   return -(max_velocity_[active_constraint] * path_.getCurvature(path_pos)[active_constraint]) /
          (tangent[active_constraint] * std::abs(tangent[active_constraint]));
 }
@@ -776,34 +744,18 @@ double Trajectory::getDuration() const
   return trajectory_.back().time_;
 }
 
-std::list<Trajectory::TrajectoryStep>::const_iterator Trajectory::getTrajectorySegment(double time) const
+std::vector<Trajectory::TrajectoryStep>::const_iterator Trajectory::getTrajectorySegment(double time) const
 {
   if (time >= trajectory_.back().time_)
-  {
-    std::list<TrajectoryStep>::const_iterator last = trajectory_.end();
-    last--;
-    return last;
-  }
-  else
-  {
-    if (time < cached_time_)
-    {
-      cached_trajectory_segment_ = trajectory_.begin();
-    }
-    while (time >= cached_trajectory_segment_->time_)
-    {
-      ++cached_trajectory_segment_;
-    }
-    cached_time_ = time;
-    return cached_trajectory_segment_;
-  }
+    return trajectory_.end() - 1;
+  return std::upper_bound(trajectory_.begin(), trajectory_.end(), time,
+                          [](double t, const TrajectoryStep& step) { return t < step.time_; });
 }
 
 Eigen::VectorXd Trajectory::getPosition(double time) const
 {
-  std::list<TrajectoryStep>::const_iterator it = getTrajectorySegment(time);
-  std::list<TrajectoryStep>::const_iterator previous = it;
-  previous--;
+  std::vector<TrajectoryStep>::const_iterator it = getTrajectorySegment(time);
+  std::vector<TrajectoryStep>::const_iterator previous = it - 1;
 
   double time_step = it->time_ - previous->time_;
   const double acceleration =
@@ -818,9 +770,8 @@ Eigen::VectorXd Trajectory::getPosition(double time) const
 
 Eigen::VectorXd Trajectory::getVelocity(double time) const
 {
-  std::list<TrajectoryStep>::const_iterator it = getTrajectorySegment(time);
-  std::list<TrajectoryStep>::const_iterator previous = it;
-  previous--;
+  std::vector<TrajectoryStep>::const_iterator it = getTrajectorySegment(time);
+  std::vector<TrajectoryStep>::const_iterator previous = it - 1;
 
   double time_step = it->time_ - previous->time_;
   const double acceleration =
@@ -836,9 +787,8 @@ Eigen::VectorXd Trajectory::getVelocity(double time) const
 
 Eigen::VectorXd Trajectory::getAcceleration(double time) const
 {
-  std::list<TrajectoryStep>::const_iterator it = getTrajectorySegment(time);
-  std::list<TrajectoryStep>::const_iterator previous = it;
-  previous--;
+  std::vector<TrajectoryStep>::const_iterator it = getTrajectorySegment(time);
+  std::vector<TrajectoryStep>::const_iterator previous = it - 1;
 
   double time_step = it->time_ - previous->time_;
   const double acceleration =
@@ -861,20 +811,11 @@ TimeOptimalTrajectoryGeneration::TimeOptimalTrajectoryGeneration(const double pa
 {
 }
 
-bool TimeOptimalTrajectoryGeneration::computeTimeStamps(robot_trajectory::RobotTrajectory& trajectory,
-                                                        const double max_velocity_scaling_factor,
-                                                        const double max_acceleration_scaling_factor) const
+bool TimeOptimalTrajectoryGeneration::createContext(const moveit::core::JointModelGroup* group,
+                                                    TimeParameterizationContext& context,
+                                                    const double max_velocity_scaling_factor,
+                                                    const double max_acceleration_scaling_factor) const
 {
-  if (trajectory.empty())
-    return true;
-
-  const moveit::core::JointModelGroup* group = trajectory.getGroup();
-  if (!group)
-  {
-    ROS_ERROR_NAMED(LOGNAME, "It looks like the planner did not set the group the plan was computed for");
-    return false;
-  }
-
   // Validate scaling
   double velocity_scaling_factor = 1.0;
   if (max_velocity_scaling_factor > 0.0 && max_velocity_scaling_factor <= 1.0)
@@ -908,19 +849,17 @@ bool TimeOptimalTrajectoryGeneration::computeTimeStamps(robot_trajectory::RobotT
                    max_acceleration_scaling_factor, acceleration_scaling_factor);
   }
 
-  // This lib does not actually work properly when angles wrap around, so we need to unwind the path first
-  trajectory.unwind();
-
   // This is pretty much copied from IterativeParabolicTimeParameterization::applyVelocityConstraints
   const std::vector<std::string>& vars = group->getVariableNames();
-  const std::vector<int>& idx = group->getVariableIndexList();
   const moveit::core::RobotModel& rmodel = group->getParentModel();
   const unsigned num_joints = group->getVariableCount();
-  const unsigned num_points = trajectory.getWayPointCount();
 
   // Get the limits (we do this at same time, unlike IterativeParabolicTimeParameterization)
-  Eigen::VectorXd max_velocity(num_joints);
-  Eigen::VectorXd max_acceleration(num_joints);
+  context.group = group;
+  Eigen::VectorXd& max_velocity = context.max_velocity;
+  Eigen::VectorXd& max_acceleration = context.max_acceleration;
+  max_velocity.resize(num_joints);
+  max_acceleration.resize(num_joints);
   for (size_t j = 0; j < num_joints; ++j)
   {
     const moveit::core::VariableBounds& bounds = rmodel.getVariableBounds(vars[j]);
@@ -952,6 +891,48 @@ bool TimeOptimalTrajectoryGeneration::computeTimeStamps(robot_trajectory::RobotT
                             acceleration_scaling_factor;
     }
   }
+  return true;
+}
+
+bool TimeOptimalTrajectoryGeneration::computeTimeStamps(robot_trajectory::RobotTrajectory& trajectory,
+                                                        const double max_velocity_scaling_factor,
+                                                        const double max_acceleration_scaling_factor) const
+{
+  if (trajectory.empty())
+    return true;
+
+  const moveit::core::JointModelGroup* group = trajectory.getGroup();
+  if (!group)
+  {
+    ROS_ERROR_NAMED(LOGNAME, "It looks like the planner did not set the group the plan was computed for");
+    return false;
+  }
+
+  TimeParameterizationContext context;
+  if (!createContext(group, context, max_velocity_scaling_factor, max_acceleration_scaling_factor))
+    return false;
+  return computeTimeStamps(trajectory, context);
+}
+
+bool TimeOptimalTrajectoryGeneration::computeTimeStamps(robot_trajectory::RobotTrajectory& trajectory,
+                                                        const TimeParameterizationContext& context) const
+{
+  if (trajectory.empty())
+    return true;
+
+  const moveit::core::JointModelGroup* group = trajectory.getGroup();
+  if (!group || group != context.group)
+  {
+    ROS_ERROR_NAMED(LOGNAME, "The trajectory does not belong to the group of the time parameterization context");
+    return false;
+  }
+
+  // This lib does not actually work properly when angles wrap around, so we need to unwind the path first
+  trajectory.unwind();
+
+  const std::vector<int>& idx = group->getVariableIndexList();
+  const unsigned num_joints = group->getVariableCount();
+  const unsigned num_points = trajectory.getWayPointCount();
 
   // Have to convert into Eigen data structs and remove repeated points
   //  (https://github.com/tobiaskunz/trajectories/issues/3)
@@ -991,7 +972,7 @@ bool TimeOptimalTrajectoryGeneration::computeTimeStamps(robot_trajectory::RobotT
   }
 
   // Now actually call the algorithm
-  Trajectory parameterized(Path(points, path_tolerance_), max_velocity, max_acceleration, 0.001);
+  Trajectory parameterized(Path(points, path_tolerance_), context.max_velocity, context.max_acceleration, 0.001);
   if (!parameterized.isValid())
   {
     ROS_ERROR_NAMED(LOGNAME, "Unable to parameterize trajectory.");
@@ -1024,6 +1005,110 @@ bool TimeOptimalTrajectoryGeneration::computeTimeStamps(robot_trajectory::RobotT
     last_t = t;
   }
 
+  if (!context.cartesian_speed_limited_links.empty() &&
+      !limitMaxCartesianLinkSpeed(trajectory, context.max_cartesian_speed, context.cartesian_speed_limited_links))
+    return false;
   return true;
 }
+
+bool TimeOptimalTrajectoryGeneration::computeTimeStamps(robot_trajectory::CompactTrajectory& trajectory,
+                                                        const double max_velocity_scaling_factor,
+                                                        const double max_acceleration_scaling_factor) const
+{
+  if (trajectory.empty())
+    return true;
+
+  TimeParameterizationContext context;
+  if (!createContext(trajectory.getGroup(), context, max_velocity_scaling_factor, max_acceleration_scaling_factor))
+    return false;
+  return computeTimeStamps(trajectory, context);
+}
+
+bool TimeOptimalTrajectoryGeneration::computeTimeStamps(robot_trajectory::CompactTrajectory& trajectory,
+                                                        const TimeParameterizationContext& context) const
+{
+  if (trajectory.empty())
+    return true;
+
+  if (trajectory.getGroup() != context.group)
+  {
+    ROS_ERROR_NAMED(LOGNAME, "The trajectory does not belong to the group of the time parameterization context");
+    return false;
+  }
+
+  // This lib does not actually work properly when angles wrap around, so we need to unwind the path first
+  trajectory.unwind();
+
+  const robot_trajectory::CompactTrajectory& const_trajectory = trajectory;
+  const Eigen::Map<const Eigen::MatrixXd> positions = const_trajectory.getPositions();
+
+  // Remove repeated points (https://github.com/tobiaskunz/trajectories/issues/3), working on the columns directly
+  std::list<Eigen::VectorXd> points;
+  points.push_back(positions.col(0));
+  for (Eigen::Index p = 1; p < positions.cols(); ++p)
+    if ((positions.col(p) - points.back()).cwiseAbs().maxCoeff() > min_angle_change_)
+      points.push_back(positions.col(p));
+
+  if (points.size() == 1)
+  {
+    ROS_DEBUG_NAMED(LOGNAME,
+                    "Trajectory is parameterized with 0.0 dynamics since it only contains a single distinct waypoint.");
+    const Eigen::VectorXd first = points.front();
+    trajectory.clear();
+    trajectory.addSuffixWayPoint(first.data(), nullptr, nullptr, 0.0);
+    return true;
+  }
+
+  Trajectory parameterized(Path(points, path_tolerance_), context.max_velocity, context.max_acceleration, 0.001);
+  if (!parameterized.isValid())
+  {
+    ROS_ERROR_NAMED(LOGNAME, "Unable to parameterize trajectory.");
+    return false;
+  }
+
+  const size_t sample_count = std::ceil(parameterized.getDuration() / resample_dt_);
+  trajectory.clear();
+  trajectory.reserve(sample_count + 1);
+  double last_t = 0;
+  for (size_t sample = 0; sample <= sample_count; ++sample)
+  {
+    // always sample the end of the trajectory as well
+    double t = std::min(parameterized.getDuration(), sample * resample_dt_);
+    const Eigen::VectorXd position = parameterized.getPosition(t);
+    const Eigen::VectorXd velocity = parameterized.getVelocity(t);
+    const Eigen::VectorXd acceleration = parameterized.getAcceleration(t);
+    trajectory.addSuffixWayPoint(position.data(), velocity.data(), acceleration.data(), t - last_t);
+    last_t = t;
+  }
+
+  if (!context.cartesian_speed_limited_links.empty() &&
+      !limitMaxCartesianLinkSpeed(trajectory, context.max_cartesian_speed, context.cartesian_speed_limited_links))
+    return false;
+  return true;
+}
+
+std::size_t TimeOptimalTrajectoryGeneration::computeTimeStamps(
+    const std::vector<robot_trajectory::RobotTrajectoryPtr>& trajectories, const TimeParameterizationContext& context,
+    std::vector<bool>& success, unsigned int thread_count) const
+{
+  // the trajectories are independent and the context is only read, so workers just pull the next unclaimed one
+  std::vector<char> parameterized(trajectories.size(), 0);
+  std::atomic<std::size_t> next(0);
+  const auto work = [&]() {
+    for (std::size_t i = next++; i < trajectories.size(); i = next++)
+      parameterized[i] = trajectories[i] && computeTimeStamps(*trajectories[i], context);
+  };
+
+  if (thread_count == 0)
+    thread_count = std::max(1u, std::thread::hardware_concurrency());
+  std::vector<std::thread> workers;
+  for (std::size_t t = 1; t < std::min<std::size_t>(thread_count, trajectories.size()); ++t)
+    workers.emplace_back(work);
+  work();
+  for (std::thread& worker : workers)
+    worker.join();
+
+  success.assign(parameterized.begin(), parameterized.end());
+  return std::count(parameterized.begin(), parameterized.end(), 1);
+}
 }  // namespace trajectory_processing
@@ -0,0 +1,135 @@
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2026, PickNik LLC.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of PickNik LLC nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *********************************************************************/
+
+/* Google Benchmark based micro-benchmarks of the time parameterization and smoothing algorithms. Write JSON results
+   for regression tracking with --benchmark_out=<file> --benchmark_out_format=json */
+
+#include <moveit/trajectory_processing/iterative_time_parameterization.h>
+#include <moveit/trajectory_processing/iterative_spline_parameterization.h>
+#include <moveit/trajectory_processing/ruckig_traj_smoothing.h>
+#include <moveit/trajectory_processing/time_optimal_trajectory_generation.h>
+#include <moveit/utils/robot_model_test_utils.h>
+#include <random_numbers/random_numbers.h>
+#include <benchmark/benchmark.h>
+
+namespace
+{
+// An untimed path through a few random states of the group, densely sampled as a planner would return it
+robot_trajectory::RobotTrajectory createPath(const std::string& robot, const std::string& group,
+                                             std::size_t waypoints)
+{
+  moveit::core::RobotModelPtr model = moveit::core::loadTestingRobotModel(robot);
+  const moveit::core::JointModelGroup* jmg = model->getJointModelGroup(group);
+  robot_trajectory::RobotTrajectory path(model, jmg);
+
+  random_numbers::RandomNumberGenerator rng(7);
+  moveit::core::RobotState from(model), to(model), state(model);
+  from.setToDefaultValues();
+  to.setToDefaultValues();
+  state.setToDefaultValues();
+  const std::size_t segments = 4;
+  for (std::size_t segment = 0; segment < segments; ++segment)
+  {
+    to.setToRandomPositions(jmg, rng);
+    for (std::size_t i = 0; i < waypoints / segments; ++i)
+    {
+      from.interpolate(to, static_cast<double>(i) / (waypoints / segments), state, jmg);
+      path.addSuffixWayPoint(state, 0.0);
+    }
+    from = to;
+  }
+  path.addSuffixWayPoint(from, 0.0);
+  return path;
+}
+
+void parameterize(benchmark::State& st, const trajectory_processing::TimeParameterization& algorithm)
+{
+  const robot_trajectory::RobotTrajectory path = createPath("panda", "panda_arm", st.range(0));
+  for (auto _ : st)
+  {
+    st.PauseTiming();
+    robot_trajectory::RobotTrajectory trajectory(path, true);
+    st.ResumeTiming();
+    if (!algorithm.computeTimeStamps(trajectory))
+    {
+      st.SkipWithError("Time parameterization failed");
+      break;
+    }
+  }
+}
+}  // namespace
+
+static void iterativeParabolic(benchmark::State& st)
+{
+  parameterize(st, trajectory_processing::IterativeParabolicTimeParameterization());
+}
+BENCHMARK(iterativeParabolic)->Arg(20)->Arg(200)->Unit(benchmark::kMicrosecond);
+
+static void iterativeSpline(benchmark::State& st)
+{
+  parameterize(st, trajectory_processing::IterativeSplineParameterization());
+}
+BENCHMARK(iterativeSpline)->Arg(20)->Arg(200)->Unit(benchmark::kMicrosecond);
+
+static void timeOptimal(benchmark::State& st)
+{
+  parameterize(st, trajectory_processing::TimeOptimalTrajectoryGeneration());
+}
+BENCHMARK(timeOptimal)->Arg(20)->Arg(200)->Unit(benchmark::kMicrosecond);
+
+// Ruckig smooths a trajectory that is already timed
+static void ruckigSmoothing(benchmark::State& st)
+{
+  robot_trajectory::RobotTrajectory timed = createPath("panda", "panda_arm", st.range(0));
+  trajectory_processing::TimeOptimalTrajectoryGeneration totg;
+  if (!totg.computeTimeStamps(timed))
+  {
+    st.SkipWithError("Time parameterization failed");
+    return;
+  }
+  for (auto _ : st)
+  {
+    st.PauseTiming();
+    robot_trajectory::RobotTrajectory trajectory(timed, true);
+    st.ResumeTiming();
+    if (!trajectory_processing::RuckigSmoothing::applySmoothing(trajectory))
+    {
+      st.SkipWithError("Ruckig smoothing failed");
+      break;
+    }
+  }
+}
+BENCHMARK(ruckigSmoothing)->Arg(20)->Arg(200)->Unit(benchmark::kMicrosecond);
+
+BENCHMARK_MAIN();
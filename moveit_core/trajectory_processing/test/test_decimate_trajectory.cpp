@@ -0,0 +1,142 @@
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2026, PickNik LLC.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of PickNik LLC nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *********************************************************************/
+
+#include <gtest/gtest.h>
+#include <moveit/trajectory_processing/decimate_trajectory.h>
+#include <moveit/robot_state/robot_state.h>
+#include <moveit/utils/robot_model_test_utils.h>
+#include <cmath>
+
+namespace
+{
+constexpr double DEFAULT_TIMESTEP = 0.01;  // sec
+constexpr char JOINT_GROUP[] = "panda_arm";
+
+class DecimateTrajectoryTests : public testing::Test
+{
+protected:
+  void SetUp() override
+  {
+    robot_model_ = moveit::core::loadTestingRobotModel("panda");
+    trajectory_ = std::make_shared<robot_trajectory::RobotTrajectory>(robot_model_, JOINT_GROUP);
+  }
+
+  // Add waypoints moving the first two joints along the curve given by position()
+  template <typename Function>
+  void addWayPoints(std::size_t count, const Function& position)
+  {
+    moveit::core::RobotState robot_state(robot_model_);
+    robot_state.setToDefaultValues();
+    std::vector<double> joint_positions;
+    robot_state.copyJointGroupPositions(JOINT_GROUP, joint_positions);
+    for (std::size_t i = 0; i < count; ++i)
+    {
+      joint_positions.at(0) = position(i);
+      joint_positions.at(1) = 0.5 * position(i);
+      robot_state.setJointGroupPositions(JOINT_GROUP, joint_positions);
+      robot_state.update();
+      trajectory_->addSuffixWayPoint(robot_state, i == 0 ? 0.0 : DEFAULT_TIMESTEP);
+    }
+  }
+
+  moveit::core::RobotModelPtr robot_model_;
+  robot_trajectory::RobotTrajectoryPtr trajectory_;
+};
+
+}  // namespace
+
+TEST_F(DecimateTrajectoryTests, straight_line)
+{
+  addWayPoints(101, [](std::size_t i) { return 0.01 * i; });
+  const double duration = trajectory_->getDuration();
+
+  std::vector<std::size_t> retained;
+  EXPECT_TRUE(trajectory_processing::decimateTrajectory(*trajectory_, 1e-6, 0.0, "", retained));
+  EXPECT_EQ(trajectory_->getWayPointCount(), 2u);
+  EXPECT_EQ(retained, (std::vector<std::size_t>{ 0, 100 }));
+  EXPECT_NEAR(trajectory_->getDuration(), duration, 1e-12);
+}
+
+TEST_F(DecimateTrajectoryTests, corner_is_kept)
+{
+  addWayPoints(101, [](std::size_t i) { return i <= 50 ? 0.01 * i : 1.0 - 0.01 * i; });
+
+  std::vector<std::size_t> retained;
+  EXPECT_TRUE(trajectory_processing::decimateTrajectory(*trajectory_, 1e-6, 0.0, "", retained));
+  EXPECT_EQ(retained, (std::vector<std::size_t>{ 0, 50, 100 }));
+  EXPECT_NEAR(trajectory_->getWayPointDurationFromStart(1), 0.5, 1e-12);
+  EXPECT_NEAR(trajectory_->getWayPoint(1).getVariablePosition("panda_joint1"), 0.5, 1e-12);
+}
+
+TEST_F(DecimateTrajectoryTests, tolerances_bound_the_deviation)
+{
+  addWayPoints(201, [](std::size_t i) { return std::sin(0.03 * i); });
+  robot_trajectory::RobotTrajectory original(*trajectory_, true);
+
+  const double joint_tolerance = 1e-3;
+  const double cartesian_tolerance = 1e-3;
+  std::vector<std::size_t> retained;
+  EXPECT_TRUE(trajectory_processing::decimateTrajectory(*trajectory_, joint_tolerance, cartesian_tolerance,
+                                                        "panda_link8", retained));
+  EXPECT_LT(trajectory_->getWayPointCount(), original.getWayPointCount());
+  EXPECT_GT(trajectory_->getWayPointCount(), 2u);
+  EXPECT_NEAR(trajectory_->getDuration(), original.getDuration(), 1e-12);
+
+  // every original waypoint is reproduced by the decimated trajectory at its own time stamp
+  moveit::core::RobotState state(robot_model_);
+  for (std::size_t i = 0; i < original.getWayPointCount(); ++i)
+  {
+    ASSERT_TRUE(trajectory_->getStateAtDurationFromStart(original.getWayPointDurationFromStart(i), state));
+    EXPECT_NEAR(state.getVariablePosition("panda_joint1"),
+                original.getWayPoint(i).getVariablePosition("panda_joint1"), joint_tolerance + 1e-9);
+    EXPECT_LE((state.getGlobalLinkTransform("panda_link8").translation() -
+               original.getWayPointPtr(i)->getGlobalLinkTransform("panda_link8").translation())
+                  .norm(),
+              cartesian_tolerance + 1e-9);
+  }
+}
+
+TEST_F(DecimateTrajectoryTests, invalid_arguments)
+{
+  addWayPoints(10, [](std::size_t i) { return 0.01 * i; });
+  EXPECT_FALSE(trajectory_processing::decimateTrajectory(*trajectory_, -1.0));
+  EXPECT_FALSE(trajectory_processing::decimateTrajectory(*trajectory_, 1e-3, 1e-3, "no_such_link"));
+  EXPECT_EQ(trajectory_->getWayPointCount(), 10u);
+}
+
+int main(int argc, char** argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
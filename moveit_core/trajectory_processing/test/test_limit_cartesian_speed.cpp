@@ -44,6 +44,7 @@
 #include <moveit/robot_trajectory/robot_trajectory.h>
 #include <moveit/trajectory_processing/iterative_time_parameterization.h>
 #include <moveit/trajectory_processing/limit_cartesian_speed.h>
+#include <moveit/trajectory_processing/time_optimal_trajectory_generation.h>
 #include <moveit/utils/robot_model_test_utils.h>
 
 // Static variables used in all tests
@@ -185,6 +186,60 @@ TEST(TestCartesianSpeed, TestCartesianEndEffectorSpeed)
   }
 }
 
+TEST(TestCartesianSpeed, TestMultipleLinksAndCompactTrajectory)
+{
+  trajectory_processing::IterativeParabolicTimeParameterization time_parameterization;
+  robot_trajectory::RobotTrajectory trajectory(RMODEL, "panda_arm");
+  EXPECT_TRUE(initStraightTrajectory(trajectory));
+  EXPECT_TRUE(time_parameterization.computeTimeStamps(trajectory));
+  robot_trajectory::CompactTrajectory compact(trajectory);
+
+  // limiting both links at once matches limiting them one after the other
+  const std::vector<const moveit::core::LinkModel*> links = { RMODEL->getLinkModel("panda_link8"),
+                                                              RMODEL->getLinkModel("panda_link4") };
+  robot_trajectory::RobotTrajectory sequential(trajectory, true);
+  EXPECT_TRUE(trajectory_processing::limitMaxCartesianLinkSpeed(sequential, 0.01, links[0]));
+  EXPECT_TRUE(trajectory_processing::limitMaxCartesianLinkSpeed(sequential, 0.01, links[1]));
+  EXPECT_TRUE(trajectory_processing::limitMaxCartesianLinkSpeed(trajectory, 0.01, links));
+  EXPECT_TRUE(trajectory_processing::limitMaxCartesianLinkSpeed(compact, 0.01, links));
+
+  ASSERT_EQ(trajectory.getWayPointCount(), sequential.getWayPointCount());
+  ASSERT_EQ(trajectory.getWayPointCount(), compact.getWayPointCount());
+  for (size_t i = 0; i < trajectory.getWayPointCount(); i++)
+  {
+    EXPECT_NEAR(trajectory.getWayPointDurationFromPrevious(i), sequential.getWayPointDurationFromPrevious(i), 1e-12);
+    EXPECT_NEAR(trajectory.getWayPointDurationFromPrevious(i), compact.getWayPointDurationFromPrevious(i), 1e-12);
+  }
+  for (size_t i = 1; i < trajectory.getWayPointCount(); i++)
+    for (size_t j = 0; j < compact.getVariableCount(); j++)
+    {
+      const int index = trajectory.getGroup()->getVariableIndexList()[j];
+      EXPECT_NEAR(trajectory.getWayPoint(i).getVariableVelocity(index), compact.getVelocities()(j, i), 1e-9);
+      EXPECT_NEAR(trajectory.getWayPoint(i).getVariableAcceleration(index), compact.getAccelerations()(j, i), 1e-9);
+    }
+}
+
+TEST(TestCartesianSpeed, TestTimeOptimalWithCartesianLimit)
+{
+  trajectory_processing::TimeOptimalTrajectoryGeneration totg;
+  robot_trajectory::RobotTrajectory trajectory(RMODEL, "panda_arm");
+  EXPECT_TRUE(initStraightTrajectory(trajectory));
+
+  trajectory_processing::TimeParameterizationContext context;
+  ASSERT_TRUE(totg.createContext(trajectory.getGroup(), context));
+  context.cartesian_speed_limited_links = { RMODEL->getLinkModel("panda_link8") };
+  context.max_cartesian_speed = 0.05;
+  ASSERT_TRUE(totg.computeTimeStamps(trajectory, context));
+
+  for (size_t i = 1; i < trajectory.getWayPointCount(); i++)
+  {
+    const double distance = (trajectory.getWayPointPtr(i)->getGlobalLinkTransform("panda_link8").translation() -
+                             trajectory.getWayPointPtr(i - 1)->getGlobalLinkTransform("panda_link8").translation())
+                                .norm();
+    EXPECT_LE(distance / trajectory.getWayPointDurationFromPrevious(i), 0.05 + 1e-9);
+  }
+}
+
 int main(int argc, char** argv)
 {
   testing::InitGoogleTest(&argc, argv);
@@ -131,6 +131,28 @@ TEST_F(RuckigTests, single_waypoint)
   }
 }
 
+TEST_F(RuckigTests, trajectory_needing_stretch)
+{
+  // The waypoints are too far apart to be reached within the timestep, so the durations have to be extended
+
+  moveit::core::RobotState robot_state(robot_model_);
+  robot_state.setToDefaultValues();
+  std::vector<double> joint_positions;
+  robot_state.copyJointGroupPositions(JOINT_GROUP, joint_positions);
+  for (size_t i = 0; i < 30; ++i)
+  {
+    joint_positions.at(0) += (i % 10 == 5) ? 0.2 : 0.01;
+    robot_state.setJointGroupPositions(JOINT_GROUP, joint_positions);
+    robot_state.update();
+    trajectory_->addSuffixWayPoint(robot_state, DEFAULT_TIMESTEP);
+  }
+  const double original_duration = trajectory_->getDuration();
+
+  EXPECT_TRUE(
+      smoother_.applySmoothing(*trajectory_, 1.0 /* max vel scaling factor */, 1.0 /* max accel scaling factor */));
+  EXPECT_GT(trajectory_->getDuration(), original_duration);
+}
+
 int main(int argc, char** argv)
 {
   testing::InitGoogleTest(&argc, argv);
@@ -348,6 +348,92 @@ TEST(time_optimal_trajectory_generation, testPluginAPI)
   ASSERT_EQ(first_trajectory_msg_end, third_trajectory_msg_end);
 }
 
+TEST(time_optimal_trajectory_generation, testCompactTrajectory)
+{
+  auto robot_model = moveit::core::loadTestingRobotModel("panda");
+  auto group = robot_model->getJointModelGroup("panda_arm");
+  moveit::core::RobotState waypoint_state(robot_model);
+  waypoint_state.setToDefaultValues();
+
+  robot_trajectory::RobotTrajectory trajectory(robot_model, group);
+  waypoint_state.setJointGroupPositions(group, std::vector<double>{ -0.5, -3.52, 1.35, -2.51, -0.88, 0.63, 0.0 });
+  trajectory.addSuffixWayPoint(waypoint_state, 0.1);
+  waypoint_state.setJointGroupPositions(group, std::vector<double>{ -0.5, -3.52, 1.35, -2.51, -0.88, 0.63, 0.0 });
+  trajectory.addSuffixWayPoint(waypoint_state, 0.1);
+  waypoint_state.setJointGroupPositions(group, std::vector<double>{ 0.0, -3.5, 1.4, -1.2, -1.0, -0.2, 0.0 });
+  trajectory.addSuffixWayPoint(waypoint_state, 0.1);
+  waypoint_state.setJointGroupPositions(group, std::vector<double>{ -0.5, -3.52, 1.35, -2.51, -0.88, 0.63, 0.0 });
+  trajectory.addSuffixWayPoint(waypoint_state, 0.1);
+
+  robot_trajectory::CompactTrajectory compact(trajectory);
+  ASSERT_EQ(compact.getWayPointCount(), trajectory.getWayPointCount());
+
+  TimeOptimalTrajectoryGeneration totg;
+  ASSERT_TRUE(totg.computeTimeStamps(trajectory));
+  ASSERT_TRUE(totg.computeTimeStamps(compact));
+
+  // both representations must produce the same result
+  ASSERT_EQ(compact.getWayPointCount(), trajectory.getWayPointCount());
+  EXPECT_NEAR(compact.getDuration(), trajectory.getDuration(), 1e-12);
+  moveit_msgs::RobotTrajectory full_msg, compact_msg;
+  trajectory.getRobotTrajectoryMsg(full_msg);
+  compact.getRobotTrajectoryMsg(compact_msg);
+  ASSERT_EQ(full_msg.joint_trajectory.points.size(), compact_msg.joint_trajectory.points.size());
+  EXPECT_EQ(full_msg.joint_trajectory.joint_names, compact_msg.joint_trajectory.joint_names);
+  for (std::size_t i = 0; i < full_msg.joint_trajectory.points.size(); ++i)
+  {
+    EXPECT_EQ(full_msg.joint_trajectory.points[i].positions, compact_msg.joint_trajectory.points[i].positions);
+    EXPECT_EQ(full_msg.joint_trajectory.points[i].velocities, compact_msg.joint_trajectory.points[i].velocities);
+    EXPECT_NEAR(full_msg.joint_trajectory.points[i].time_from_start.toSec(),
+                compact_msg.joint_trajectory.points[i].time_from_start.toSec(), 1e-9);
+    EXPECT_TRUE(compact.getWayPoint(i)
+                    .getGlobalLinkTransform("panda_link8")
+                    .isApprox(trajectory.getWayPoint(i).getGlobalLinkTransform("panda_link8")));
+  }
+}
+
+TEST(time_optimal_trajectory_generation, testBatchWithContext)
+{
+  auto robot_model = moveit::core::loadTestingRobotModel("panda");
+  auto group = robot_model->getJointModelGroup("panda_arm");
+  moveit::core::RobotState waypoint_state(robot_model);
+  waypoint_state.setToDefaultValues();
+
+  TimeOptimalTrajectoryGeneration totg;
+  trajectory_processing::TimeParameterizationContext context;
+  ASSERT_TRUE(totg.createContext(group, context, 0.5, 0.5));
+
+  // candidates of growing length, plus one for a different group that must be rejected
+  std::vector<robot_trajectory::RobotTrajectoryPtr> candidates;
+  std::vector<robot_trajectory::RobotTrajectory> expected;
+  for (std::size_t i = 0; i < 20; ++i)
+  {
+    auto trajectory = std::make_shared<robot_trajectory::RobotTrajectory>(robot_model, group);
+    waypoint_state.setJointGroupPositions(group, std::vector<double>{ -0.5, -3.52, 1.35, -2.51, -0.88, 0.63, 0.0 });
+    trajectory->addSuffixWayPoint(waypoint_state, 0.0);
+    waypoint_state.setJointGroupPositions(group,
+                                          std::vector<double>{ 0.05 * i, -3.5, 1.4, -1.2, -1.0, -0.2, 0.01 * i });
+    trajectory->addSuffixWayPoint(waypoint_state, 0.0);
+    candidates.push_back(trajectory);
+    expected.emplace_back(*trajectory, true /* deep copy */);
+    ASSERT_TRUE(totg.computeTimeStamps(expected.back(), 0.5, 0.5));
+  }
+  candidates.push_back(
+      std::make_shared<robot_trajectory::RobotTrajectory>(robot_model, robot_model->getJointModelGroup("hand")));
+  candidates.back()->addSuffixWayPoint(waypoint_state, 0.0);
+
+  std::vector<bool> success;
+  EXPECT_EQ(totg.computeTimeStamps(candidates, context, success, 4), expected.size());
+  ASSERT_EQ(success.size(), candidates.size());
+  EXPECT_FALSE(success.back());
+  for (std::size_t i = 0; i < expected.size(); ++i)
+  {
+    EXPECT_TRUE(success[i]);
+    ASSERT_EQ(candidates[i]->getWayPointCount(), expected[i].getWayPointCount());
+    EXPECT_EQ(candidates[i]->getDuration(), expected[i].getDuration());
+  }
+}
+
 int main(int argc, char** argv)
 {
   testing::InitGoogleTest(&argc, argv);
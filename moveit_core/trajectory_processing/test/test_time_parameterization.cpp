@@ -41,6 +41,7 @@
 #include <moveit/robot_trajectory/robot_trajectory.h>
 #include <moveit/trajectory_processing/iterative_spline_parameterization.h>
 #include <moveit/trajectory_processing/iterative_time_parameterization.h>
+#include <moveit/trajectory_processing/streaming_time_parameterization.h>
 #include <moveit/utils/robot_model_test_utils.h>
 
 // Static variables used in all tests
@@ -177,6 +178,53 @@ TEST(TestTimeParameterization, TestRepeatedPoint)
   ASSERT_LT(TRAJECTORY.getWayPointDurationFromStart(TRAJECTORY.getWayPointCount() - 1), 0.001);
 }
 
+TEST(TestTimeParameterization, TestStreaming)
+{
+  EXPECT_EQ(initStraightTrajectory(TRAJECTORY), 0);
+  const int idx = TRAJECTORY.getGroup()->getVariableIndexList()[0];
+
+  // waypoints arrive one at a time, and the last three are held back until more arrive
+  trajectory_processing::StreamingTimeParameterization streaming(
+      std::make_shared<trajectory_processing::IterativeSplineParameterization>(true), 3);
+  robot_trajectory::RobotTrajectory released(RMODEL, "right_arm");
+  for (std::size_t i = 0; i < TRAJECTORY.getWayPointCount(); ++i)
+  {
+    streaming.addWayPoint(TRAJECTORY.getWayPoint(i));
+    EXPECT_TRUE(streaming.computeTimeStamps(released));
+    EXPECT_LE(streaming.getPendingWayPointCount(), 3u);
+  }
+  EXPECT_TRUE(streaming.computeTimeStamps(released, true));
+  EXPECT_EQ(streaming.getPendingWayPointCount(), 0u);
+  printTrajectory(released);
+
+  // all waypoints are released in order, and the robot only comes to rest at the end
+  std::size_t next = 0;
+  for (std::size_t i = 0; i < released.getWayPointCount(); ++i)
+  {
+    if (i > 0)
+      EXPECT_GT(released.getWayPointDurationFromPrevious(i), 0.0);
+    const double position = released.getWayPoint(i).getVariablePosition(idx);
+    if (next < TRAJECTORY.getWayPointCount() && position == TRAJECTORY.getWayPoint(next).getVariablePosition(idx))
+    {
+      if (next > 0 && next + 1 < TRAJECTORY.getWayPointCount())
+        EXPECT_GT(released.getWayPoint(i).getVariableVelocity(idx), 0.0);
+      ++next;
+    }
+  }
+  EXPECT_EQ(next, TRAJECTORY.getWayPointCount());
+  EXPECT_NEAR(released.getLastWayPoint().getVariableVelocity(idx), 0.0, 1e-9);
+
+  // parameterizations that always start at rest release complete windows
+  trajectory_processing::StreamingTimeParameterization stopping(
+      std::make_shared<trajectory_processing::IterativeParabolicTimeParameterization>(), 3);
+  released.clear();
+  for (std::size_t i = 0; i < 4; ++i)
+    stopping.addWayPoint(TRAJECTORY.getWayPoint(i));
+  EXPECT_TRUE(stopping.computeTimeStamps(released));
+  EXPECT_EQ(stopping.getPendingWayPointCount(), 0u);
+  EXPECT_EQ(released.getWayPointCount(), 4u);
+}
+
 int main(int argc, char** argv)
 {
   testing::InitGoogleTest(&argc, argv);
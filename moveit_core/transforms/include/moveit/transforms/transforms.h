@@ -40,6 +40,9 @@
 #include <Eigen/Geometry>
 #include <boost/noncopyable.hpp>
 #include <moveit/macros/class_forward.h>
+#include <cstdint>
+#include <limits>
+#include <unordered_map>
 
 namespace moveit
 {
@@ -58,6 +61,13 @@ using FixedTransformsMap = std::map<std::string, Eigen::Isometry3d, std::less<st
 class Transforms : private boost::noncopyable
 {
 public:
+  /** @brief Index of a frame in the frame table of a Transforms object. The handle of a frame stays valid for the
+   *  lifetime of that object, even if the frame is removed and added again. */
+  using FrameHandle = std::size_t;
+
+  /** @brief The handle returned for unknown frames */
+  static constexpr FrameHandle INVALID_FRAME_HANDLE = std::numeric_limits<FrameHandle>::max();
+
   /**
    * @brief Construct a transform list
    */
@@ -122,6 +132,47 @@ public:
 
   /**@}*/
 
+  /**
+   * \name Access by frame handle
+   * Resolving a frame name once and using its handle avoids repeated name lookups, e.g. in constraint evaluation.
+   */
+  /**@{*/
+
+  /**
+   * @brief Get the handle of a fixed frame
+   * @return The handle, or INVALID_FRAME_HANDLE if the frame is unknown
+   */
+  FrameHandle getFrameHandle(const std::string& frame) const;
+
+  /** @brief Check whether the frame of \e handle currently has a transform */
+  bool canTransform(FrameHandle handle) const
+  {
+    return handle < frames_.size() && frames_[handle].transform;
+  }
+
+  /**
+   * @brief Get the transform of the frame of \e handle (w.r.t target frame)
+   * @return The transform, or identity if the frame has no transform. It is guaranteed to be a valid isometry.
+   */
+  const Eigen::Isometry3d& getTransform(FrameHandle handle) const;
+
+  /**
+   * @brief Get the version stamp of a frame, which changes whenever the frame's transform changes, or the frame is
+   * added or removed
+   */
+  std::uint64_t getFrameVersion(FrameHandle handle) const
+  {
+    return handle < frames_.size() ? frames_[handle].version : 0;
+  }
+
+  /** @brief Get the version stamp of all transforms, which changes whenever any frame changes */
+  std::uint64_t getVersion() const
+  {
+    return version_;
+  }
+
+  /**@}*/
+
   /**
    * \name Applying transforms
    */
@@ -199,6 +250,20 @@ public:
 protected:
   std::string target_frame_;
   FixedTransformsMap transforms_map_;
+
+private:
+  /** @brief Set the transform of a frame, updating its version only if the transform changes */
+  void updateTransform(const Eigen::Isometry3d& t, const std::string& from_frame);
+
+  struct Frame
+  {
+    const Eigen::Isometry3d* transform;  // points into transforms_map_, nullptr if the frame was removed
+    std::uint64_t version;
+  };
+
+  std::vector<Frame> frames_;
+  std::unordered_map<std::string, FrameHandle> frame_handles_;
+  std::uint64_t version_;
 };
 }  // namespace core
 }  // namespace moveit
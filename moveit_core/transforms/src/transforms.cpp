@@ -44,14 +44,16 @@ namespace moveit
 {
 namespace core
 {
-Transforms::Transforms(const std::string& target_frame) : target_frame_(target_frame)
+constexpr Transforms::FrameHandle Transforms::INVALID_FRAME_HANDLE;
+
+Transforms::Transforms(const std::string& target_frame) : target_frame_(target_frame), version_(0)
 {
   boost::trim(target_frame_);
   if (target_frame_.empty())
     ROS_ERROR_NAMED("transforms", "The target frame for MoveIt Transforms cannot be empty.");
   else
   {
-    transforms_map_[target_frame_] = Eigen::Isometry3d::Identity();
+    updateTransform(Eigen::Isometry3d::Identity(), target_frame_);
   }
 }
 
@@ -80,7 +82,61 @@ void Transforms::setAllTransforms(const FixedTransformsMap& transforms)
   {
     ASSERT_ISOMETRY(t.second)  // unsanitized input, could contain a non-isometry
   }
-  transforms_map_ = transforms;
+
+  // removed frames keep their handles, in case they are added again
+  for (FixedTransformsMap::iterator it = transforms_map_.begin(); it != transforms_map_.end();)
+    if (transforms.find(it->first) == transforms.end())
+    {
+      Frame& frame = frames_[frame_handles_[it->first]];
+      frame.transform = nullptr;
+      frame.version = ++version_;
+      it = transforms_map_.erase(it);
+    }
+    else
+      ++it;
+  for (const auto& t : transforms)
+    updateTransform(t.second, t.first);
+}
+
+void Transforms::updateTransform(const Eigen::Isometry3d& t, const std::string& from_frame)
+{
+  std::pair<FixedTransformsMap::iterator, bool> inserted = transforms_map_.insert(std::make_pair(from_frame, t));
+  if (inserted.second)
+  {
+    std::unordered_map<std::string, FrameHandle>::iterator it = frame_handles_.find(from_frame);
+    if (it == frame_handles_.end())
+    {
+      frame_handles_[from_frame] = frames_.size();
+      frames_.push_back(Frame{ &inserted.first->second, ++version_ });
+    }
+    else
+      frames_[it->second] = Frame{ &inserted.first->second, ++version_ };
+  }
+  // only an actual change of the transform bumps the version, so unchanged frames are not reprocessed
+  else if (inserted.first->second.matrix() != t.matrix())
+  {
+    inserted.first->second = t;
+    frames_[frame_handles_[from_frame]].version = ++version_;
+  }
+}
+
+Transforms::FrameHandle Transforms::getFrameHandle(const std::string& frame) const
+{
+  std::unordered_map<std::string, FrameHandle>::const_iterator it = frame_handles_.find(frame);
+  if (it == frame_handles_.end() || !frames_[it->second].transform)
+    return INVALID_FRAME_HANDLE;
+  return it->second;
+}
+
+const Eigen::Isometry3d& Transforms::getTransform(FrameHandle handle) const
+{
+  if (canTransform(handle))
+    return *frames_[handle].transform;
+
+  ROS_ERROR_NAMED("transforms", "Unable to transform from unknown frame handle to frame '%s'. Returning identity.",
+                  target_frame_.c_str());
+  static const Eigen::Isometry3d IDENTITY = Eigen::Isometry3d::Identity();
+  return IDENTITY;
 }
 
 bool Transforms::isFixedFrame(const std::string& frame) const
@@ -123,7 +179,7 @@ void Transforms::setTransform(const Eigen::Isometry3d& t, const std::string& fro
   if (from_frame.empty())
     ROS_ERROR_NAMED("transforms", "Cannot record transform with empty name");
   else
-    transforms_map_[from_frame] = t;
+    updateTransform(t, from_frame);
 }
 
 void Transforms::setTransform(const geometry_msgs::TransformStamped& transform)
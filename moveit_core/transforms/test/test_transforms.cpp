@@ -61,6 +61,42 @@ TEST(Transforms, Simple)
   EXPECT_TRUE(tf.isFixedFrame("global"));
 }
 
+TEST(Transforms, FrameHandles)
+{
+  moveit::core::Transforms tf("global");
+  EXPECT_EQ(tf.getFrameHandle("some_frame"), moveit::core::Transforms::INVALID_FRAME_HANDLE);
+  EXPECT_FALSE(tf.canTransform(moveit::core::Transforms::INVALID_FRAME_HANDLE));
+
+  const Eigen::Isometry3d t1(Eigen::Translation3d(1.0, 2.0, 3.0));
+  tf.setTransform(t1, "some_frame");
+  const moveit::core::Transforms::FrameHandle handle = tf.getFrameHandle("some_frame");
+  ASSERT_TRUE(tf.canTransform(handle));
+  EXPECT_TRUE(tf.getTransform(handle).isApprox(t1));
+
+  // setting an unchanged transform keeps the versions
+  const std::uint64_t version = tf.getVersion();
+  const std::uint64_t frame_version = tf.getFrameVersion(handle);
+  tf.setTransform(t1, "some_frame");
+  EXPECT_EQ(tf.getVersion(), version);
+  EXPECT_EQ(tf.getFrameVersion(handle), frame_version);
+
+  const Eigen::Isometry3d t2(Eigen::Translation3d(-1.0, 0.0, 0.0));
+  tf.setTransform(t2, "some_frame");
+  EXPECT_GT(tf.getFrameVersion(handle), frame_version);
+  EXPECT_TRUE(tf.getTransform(handle).isApprox(t2));
+
+  // removed frames keep their handle when added again
+  moveit::core::FixedTransformsMap all = tf.getAllTransforms();
+  all.erase("some_frame");
+  tf.setAllTransforms(all);
+  EXPECT_FALSE(tf.canTransform(handle));
+  EXPECT_EQ(tf.getFrameHandle("some_frame"), moveit::core::Transforms::INVALID_FRAME_HANDLE);
+  tf.setTransform(t1, "some_frame");
+  EXPECT_EQ(tf.getFrameHandle("some_frame"), handle);
+  EXPECT_TRUE(tf.getTransform(handle).isApprox(t1));
+  EXPECT_TRUE(tf.isFixedFrame("global"));
+}
+
 int main(int argc, char** argv)
 {
   testing::InitGoogleTest(&argc, argv);
@@ -34,6 +34,7 @@
 
 /* Author: Mark Moll */
 
+#include <algorithm>
 #include <chrono>
 #include <cstdlib>
 
@@ -212,6 +213,68 @@ bool CachedIKKinematicsPlugin<KinematicsPlugin>::searchPositionIK(
   return solution_found;
 }
 
+template <class KinematicsPlugin>
+bool CachedIKKinematicsPlugin<KinematicsPlugin>::searchPositionIKBatch(const std::vector<geometry_msgs::Pose>& ik_poses,
+                                                                       const std::vector<double>& ik_seed_states,
+                                                                       double timeout, std::vector<double>& solutions,
+                                                                       std::vector<bool>& found,
+                                                                       const KinematicsQueryOptions& options,
+                                                                       unsigned int threads) const
+{
+  // cache lookups and updates are serialized; only the wrapped solver runs in parallel
+  std::vector<Pose> poses;
+  std::vector<IKEntry> nearest;
+  std::vector<double> cache_seeds;
+  poses.reserve(ik_poses.size());
+  nearest.reserve(ik_poses.size());
+  for (const geometry_msgs::Pose& ik_pose : ik_poses)
+  {
+    poses.emplace_back(ik_pose);
+    nearest.push_back(cache_.getBestApproximateIKSolution(poses.back()));
+    cache_seeds.insert(cache_seeds.end(), nearest.back().second.begin(), nearest.back().second.end());
+  }
+
+  bool all_found = KinematicsPlugin::searchPositionIKBatch(ik_poses, cache_seeds, timeout, solutions, found, options,
+                                                           threads);
+  const std::size_t dof = ik_poses.empty() ? 0 : solutions.size() / ik_poses.size();
+  if (!all_found && dof > 0)
+  {
+    // retry the poses the cached seeds did not solve with the caller's seeds
+    std::vector<std::size_t> failed;
+    std::vector<geometry_msgs::Pose> retry_poses;
+    std::vector<double> retry_seeds;
+    const bool shared_seed = ik_seed_states.size() == dof;
+    for (std::size_t i = 0; i < ik_poses.size(); ++i)
+    {
+      if (found[i])
+        continue;
+      failed.push_back(i);
+      retry_poses.push_back(ik_poses[i]);
+      if (!shared_seed)
+        retry_seeds.insert(retry_seeds.end(), ik_seed_states.begin() + i * dof,
+                           ik_seed_states.begin() + (i + 1) * dof);
+    }
+    std::vector<double> retry_solutions;
+    std::vector<bool> retry_found;
+    KinematicsPlugin::searchPositionIKBatch(retry_poses, shared_seed ? ik_seed_states : retry_seeds, timeout,
+                                            retry_solutions, retry_found, options, threads);
+    for (std::size_t k = 0; k < failed.size(); ++k)
+      if (retry_found[k])
+      {
+        std::copy(retry_solutions.begin() + k * dof, retry_solutions.begin() + (k + 1) * dof,
+                  solutions.begin() + failed[k] * dof);
+        found[failed[k]] = true;
+      }
+    all_found = std::find(found.begin(), found.end(), false) == found.end();
+  }
+
+  for (std::size_t i = 0; i < ik_poses.size(); ++i)
+    if (found[i])
+      cache_.updateCache(nearest[i], poses[i],
+                         std::vector<double>(solutions.begin() + i * dof, solutions.begin() + (i + 1) * dof));
+  return all_found;
+}
+
 template <class KinematicsPlugin>
 bool CachedMultiTipIKKinematicsPlugin<KinematicsPlugin>::searchPositionIK(
     const std::vector<geometry_msgs::Pose>& ik_poses, const std::vector<double>& ik_seed_state, double timeout,
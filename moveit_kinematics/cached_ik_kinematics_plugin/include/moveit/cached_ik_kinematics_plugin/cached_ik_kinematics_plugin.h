@@ -43,6 +43,7 @@
 #include <tf2/LinearMath/Quaternion.h>
 #include <moveit/cached_ik_kinematics_plugin/detail/NearestNeighborsGNAT.h>
 #include <boost/filesystem.hpp>
+#include <boost/thread/shared_mutex.hpp>
 #include <unordered_map>
 #include <mutex>
 #include <utility>
@@ -76,6 +77,7 @@ public:
     Pose() = default;
     Pose(const geometry_msgs::Pose& pose);
     tf2::Vector3 position;
+    /** unit quaternion, normalized on construction so distance() can skip the norms */
     tf2::Quaternion orientation;
     /** compute the distance between this pose and another pose */
     double distance(const Pose& pose) const;
@@ -117,6 +119,10 @@ protected:
   double configDistance2(const std::vector<double>& config1, const std::vector<double>& config2) const;
   /** save current state of cache to disk */
   void saveCache() const;
+  /** nearest cache entry to \e query, or nullptr if the cache is empty; adds entries not yet in ik_nn_ first */
+  const IKEntry* nearest(const IKEntry& query) const;
+  /** insert \e entry and save the cache if enough entries were added since the last save */
+  void addEntry(IKEntry&& entry) const;
 
   /** number of joints in the system */
   unsigned int num_joints_;
@@ -141,8 +147,16 @@ protected:
   mutable NearestNeighborsGNAT<IKEntry*> ik_nn_;
   /** size of the cache when it was last saved */
   mutable unsigned int last_saved_cache_size_{ 0 };
-  /** mutex for changing IK cache */
-  mutable std::mutex lock_;
+  /**
+    number of leading cache entries in ik_nn_. Entries read from disk
+    and inserted by updateCache() are indexed in one batch by the next
+    lookup, so loading a cache does not build the tree.
+  */
+  mutable std::size_t num_indexed_{ 0 };
+  /** lookups share the lock, changes to the IK cache hold it exclusively */
+  mutable boost::shared_mutex lock_;
+  /** serializes writing the cache file, which only needs the shared lock */
+  mutable std::mutex save_lock_;
 };
 
 /** a container of IK caches for cases where there is no fixed base frame */
@@ -256,6 +270,11 @@ public:
                         const IKCallbackFn& solution_callback, moveit_msgs::MoveItErrorCodes& error_code,
                         const KinematicsQueryOptions& options = KinematicsQueryOptions()) const override;
 
+  bool searchPositionIKBatch(const std::vector<geometry_msgs::Pose>& ik_poses,
+                             const std::vector<double>& ik_seed_states, double timeout, std::vector<double>& solutions,
+                             std::vector<bool>& found, const KinematicsQueryOptions& options = KinematicsQueryOptions(),
+                             unsigned int threads = 1) const override;
+
 private:
   IKCache cache_;
 
@@ -35,6 +35,9 @@
 /* Author: Mark Moll */
 
 #include <boost/filesystem/fstream.hpp>
+#include <boost/iostreams/device/mapped_file.hpp>
+#include <algorithm>
+#include <cmath>
 #include <numeric>
 
 #include <moveit/cached_ik_kinematics_plugin/cached_ik_kinematics_plugin.h>
@@ -70,7 +73,7 @@ void IKCache::initializeCache(const std::string& robot_id, const std::string& gr
   std::string cached_ik_path = opts.cached_ik_path;
 
   // use mutex lock for rest of initialization
-  std::lock_guard<std::mutex> slock(lock_);
+  boost::unique_lock<boost::shared_mutex> slock(lock_);
   // determine cache file name
   boost::filesystem::path prefix(!cached_ik_path.empty() ? cached_ik_path : boost::filesystem::current_path());
   // create cache directory if necessary
@@ -82,52 +85,65 @@ void IKCache::initializeCache(const std::string& robot_id, const std::string& gr
 
   ik_cache_.clear();
   ik_nn_.clear();
+  num_indexed_ = 0;
   last_saved_cache_size_ = 0;
   if (boost::filesystem::exists(cache_file_name_))
   {
-    // read cache
-    boost::filesystem::ifstream cache_file(cache_file_name_, std::ios_base::binary | std::ios_base::in);
-    cache_file.read((char*)&last_saved_cache_size_, sizeof(unsigned int));
-    unsigned int num_dofs;
-    cache_file.read((char*)&num_dofs, sizeof(unsigned int));
-    unsigned int num_tips;
-    cache_file.read((char*)&num_tips, sizeof(unsigned int));
+    // map the cache file and decode the entries in place instead of reading them one by one
+    boost::iostreams::mapped_file_source cache_file;
+    try
+    {
+      cache_file.open(cache_file_name_.string());
+    }
+    catch (std::exception& e)
+    {
+      ROS_ERROR_NAMED("cached_ik", "Unable to map cache file %s: %s", cache_file_name_.string().c_str(), e.what());
+    }
 
-    ROS_INFO_NAMED("cached_ik", "Found %d IK solutions for a %d-dof system with %d end effectors in %s",
-                   last_saved_cache_size_, num_dofs, num_tips, cache_file_name_.string().c_str());
+    unsigned int header[3] = { 0, 0, 0 };
+    if (cache_file.is_open() && cache_file.size() >= sizeof(header))
+      memcpy(header, cache_file.data(), sizeof(header));
+    unsigned int num_entries = header[0];
+    unsigned int num_dofs = header[1];
+    unsigned int num_tips = header[2];
 
     unsigned int position_size = 3 * sizeof(tf2Scalar);
     unsigned int orientation_size = 4 * sizeof(tf2Scalar);
     unsigned int pose_size = position_size + orientation_size;
     unsigned int config_size = num_dofs * sizeof(double);
     unsigned int offset_conf = pose_size * num_tips;
-    unsigned int bufsize = offset_conf + config_size;
-    char* buffer = new char[bufsize];
+    std::size_t bufsize = offset_conf + config_size;
+
+    if (cache_file.is_open() && cache_file.size() != sizeof(header) + num_entries * bufsize)
+    {
+      ROS_ERROR_NAMED("cached_ik", "Cache file %s is truncated or corrupt, ignoring it",
+                      cache_file_name_.string().c_str());
+      num_entries = 0;
+    }
+    else if (cache_file.is_open())
+      ROS_INFO_NAMED("cached_ik", "Found %d IK solutions for a %d-dof system with %d end effectors in %s", num_entries,
+                     num_dofs, num_tips, cache_file_name_.string().c_str());
+
     IKEntry entry;
     entry.first.resize(num_tips);
     entry.second.resize(num_dofs);
-    ik_cache_.reserve(last_saved_cache_size_);
-
-    for (unsigned i = 0; i < last_saved_cache_size_; ++i)
+    ik_cache_.reserve(num_entries);
+    const char* buffer = num_entries > 0 ? cache_file.data() + sizeof(header) : nullptr;
+    for (unsigned i = 0; i < num_entries; ++i, buffer += bufsize)
     {
       unsigned int j = 0;
-      cache_file.read(buffer, bufsize);
       for (auto& pose : entry.first)
       {
         memcpy(&pose.position[0], buffer + j * pose_size, position_size);
         memcpy(&pose.orientation[0], buffer + j * pose_size + position_size, orientation_size);
+        pose.orientation.normalize();
         ++j;
       }
       memcpy(&entry.second[0], buffer + offset_conf, config_size);
       ik_cache_.push_back(entry);
     }
-    ROS_INFO_NAMED("cached_ik", "freeing buffer");
-    delete[] buffer;
-    ROS_INFO_NAMED("cached_ik", "freed buffer");
-    std::vector<IKEntry*> ik_entry_ptrs(last_saved_cache_size_);
-    for (unsigned int i = 0; i < last_saved_cache_size_; ++i)
-      ik_entry_ptrs[i] = &ik_cache_[i];
-    ik_nn_.add(ik_entry_ptrs);
+    // the nearest-neighbor structure over these entries is built by the first lookup
+    last_saved_cache_size_ = num_entries;
   }
 
   num_joints_ = num_joints;
@@ -146,69 +162,91 @@ double IKCache::configDistance2(const std::vector<double>& config1, const std::v
   return dist;
 }
 
-const IKCache::IKEntry& IKCache::getBestApproximateIKSolution(const Pose& pose) const
+const IKCache::IKEntry* IKCache::nearest(const IKEntry& query) const
 {
-  if (ik_cache_.empty())
   {
-    static IKEntry dummy = std::make_pair(std::vector<Pose>(1, pose), std::vector<double>(num_joints_, 0.));
-    return dummy;
+    boost::shared_lock<boost::shared_mutex> slock(lock_);
+    if (ik_cache_.empty())
+      return nullptr;
+    if (num_indexed_ == ik_cache_.size())
+      return ik_nn_.nearest(&query);
   }
+
+  boost::unique_lock<boost::shared_mutex> slock(lock_);
+  if (num_indexed_ < ik_cache_.size())
+  {
+    std::vector<IKEntry*> ik_entry_ptrs(ik_cache_.size() - num_indexed_);
+    for (std::size_t i = 0; i < ik_entry_ptrs.size(); ++i)
+      ik_entry_ptrs[i] = &ik_cache_[num_indexed_ + i];
+    ik_nn_.add(ik_entry_ptrs);
+    num_indexed_ = ik_cache_.size();
+  }
+  return ik_nn_.nearest(&query);
+}
+
+const IKCache::IKEntry& IKCache::getBestApproximateIKSolution(const Pose& pose) const
+{
   IKEntry query = std::make_pair(std::vector<Pose>(1, pose), std::vector<double>());
-  return *ik_nn_.nearest(&query);
+  if (const IKEntry* entry = nearest(query))
+    return *entry;
+  static IKEntry dummy = std::make_pair(std::vector<Pose>(1, pose), std::vector<double>(num_joints_, 0.));
+  return dummy;
 }
 
 const IKCache::IKEntry& IKCache::getBestApproximateIKSolution(const std::vector<Pose>& poses) const
 {
-  if (ik_cache_.empty())
-  {
-    static IKEntry dummy = std::make_pair(poses, std::vector<double>(num_joints_, 0.));
-    return dummy;
-  }
   IKEntry query = std::make_pair(poses, std::vector<double>());
-  return *ik_nn_.nearest(&query);
+  if (const IKEntry* entry = nearest(query))
+    return *entry;
+  static IKEntry dummy = std::make_pair(poses, std::vector<double>(num_joints_, 0.));
+  return dummy;
 }
 
-void IKCache::updateCache(const IKEntry& nearest, const Pose& pose, const std::vector<double>& config) const
+void IKCache::addEntry(IKEntry&& entry) const
 {
-  if (ik_cache_.size() < ik_cache_.capacity() && (nearest.first[0].distance(pose) > min_pose_distance_ ||
-                                                  configDistance2(nearest.second, config) > min_config_distance2_))
   {
-    std::lock_guard<std::mutex> slock(lock_);
-    ik_cache_.emplace_back(std::vector<Pose>(1u, pose), config);
-    ik_nn_.add(&ik_cache_.back());
-    if (ik_cache_.size() >= last_saved_cache_size_ + 500u || ik_cache_.size() == max_cache_size_)
-      saveCache();
+    boost::unique_lock<boost::shared_mutex> slock(lock_);
+    // entries are never moved, since lookups hand out references to them
+    if (ik_cache_.size() >= ik_cache_.capacity())
+      return;
+    ik_cache_.push_back(std::move(entry));
+    if (ik_cache_.size() < last_saved_cache_size_ + 500u && ik_cache_.size() != max_cache_size_)
+      return;
   }
+
+  // writing the file only reads the cache, so lookups may continue meanwhile
+  std::lock_guard<std::mutex> save_lock(save_lock_);
+  boost::shared_lock<boost::shared_mutex> slock(lock_);
+  if (ik_cache_.size() > last_saved_cache_size_)
+    saveCache();
+}
+
+void IKCache::updateCache(const IKEntry& nearest, const Pose& pose, const std::vector<double>& config) const
+{
+  if (nearest.first[0].distance(pose) > min_pose_distance_ ||
+      configDistance2(nearest.second, config) > min_config_distance2_)
+    addEntry(IKEntry(std::vector<Pose>(1u, pose), config));
 }
 
 void IKCache::updateCache(const IKEntry& nearest, const std::vector<Pose>& poses,
                           const std::vector<double>& config) const
 {
-  if (ik_cache_.size() < ik_cache_.capacity())
+  bool add_to_cache = configDistance2(nearest.second, config) > min_config_distance2_;
+  if (!add_to_cache)
   {
-    bool add_to_cache = configDistance2(nearest.second, config) > min_config_distance2_;
-    if (!add_to_cache)
+    double dist = 0.;
+    for (unsigned int i = 0; i < poses.size(); ++i)
     {
-      double dist = 0.;
-      for (unsigned int i = 0; i < poses.size(); ++i)
+      dist += nearest.first[i].distance(poses[i]);
+      if (dist > min_pose_distance_)
       {
-        dist += nearest.first[i].distance(poses[i]);
-        if (dist > min_pose_distance_)
-        {
-          add_to_cache = true;
-          break;
-        }
+        add_to_cache = true;
+        break;
       }
     }
-    if (add_to_cache)
-    {
-      std::lock_guard<std::mutex> slock(lock_);
-      ik_cache_.emplace_back(poses, config);
-      ik_nn_.add(&ik_cache_.back());
-      if (ik_cache_.size() >= last_saved_cache_size_ + 500u || ik_cache_.size() == max_cache_size_)
-        saveCache();
-    }
   }
+  if (add_to_cache)
+    addEntry(IKEntry(poses, config));
 }
 
 void IKCache::saveCache() const
@@ -275,11 +313,14 @@ IKCache::Pose::Pose(const geometry_msgs::Pose& pose)
   position.setY(pose.position.y);
   position.setZ(pose.position.z);
   orientation = tf2::Quaternion(pose.orientation.x, pose.orientation.y, pose.orientation.z, pose.orientation.w);
+  orientation.normalize();
 }
 
 double IKCache::Pose::distance(const Pose& pose) const
 {
-  return (position - pose.position).length() + (orientation.angleShortestPath(pose.orientation));
+  // same as tf2::Quaternion::angleShortestPath() for unit quaternions, without its square root
+  double dot = std::min(1., std::abs(orientation.dot(pose.orientation)));
+  return (position - pose.position).length() + 2. * std::acos(dot);
 }
 
 IKCacheMap::IKCacheMap(const std::string& robot_description, const std::string& group_name, unsigned int num_joints)
@@ -48,6 +48,9 @@
 #include <tf2_kdl/tf2_kdl.h>
 #include <tf2_eigen/tf2_eigen.h>
 
+#include <algorithm>
+#include <limits>
+
 using namespace moveit::core;
 
 // Need a floating point tolerance when checking joint limits, in case the joint starts at limit
@@ -135,18 +138,49 @@ enum IkParameterizationType
   /// when serializing the ik parameterizations
 };
 
-// struct for storing and sorting solutions
-struct LimitObeyingSol
+// Solutions of one or more IKFast calls, one per column, so that joint limits and distances to the seed are evaluated
+// for all of them at once with array operations
+struct SolutionBatch
 {
-  std::vector<double> value;
-  double dist_from_seed;
+  using Solutions = Eigen::Block<Eigen::MatrixXd, Eigen::Dynamic, Eigen::Dynamic, true>;
+
+  Eigen::MatrixXd values;
+  Eigen::Index size = 0;
+
+  void clear()
+  {
+    size = 0;
+  }
+
+  // Add a column for a solution of num_joints values and return its storage
+  double* append(Eigen::Index num_joints)
+  {
+    if (size == values.cols())
+      values.conservativeResize(num_joints, std::max<Eigen::Index>(8, 2 * size));
+    return values.col(size++).data();
+  }
+
+  Solutions solutions()
+  {
+    return values.leftCols(size);
+  }
 
-  bool operator<(const LimitObeyingSol& a) const
+  std::vector<double> getSolution(Eigen::Index i) const
   {
-    return dist_from_seed < a.dist_from_seed;
+    return std::vector<double>(values.col(i).data(), values.col(i).data() + values.rows());
   }
 };
 
+// Cost used to order the solutions of a batch
+enum class SolutionCost
+{
+  SUM_JOINT_DISTANCE,  // sum of the absolute joint distances to the seed
+  MAX_JOINT_DISTANCE   // largest absolute joint distance to the seed
+};
+
+// Number of values of the free parameter solved at once by a search that returns the first feasible solution
+const size_t FREE_VALUE_BATCH_SIZE = 16;
+
 // Code generated by IKFast56/61
 #include "_ROBOT_NAME___GROUP_NAME__ikfast_solver.cpp"
 
@@ -156,6 +190,12 @@ class IKFastKinematicsPlugin : public kinematics::KinematicsBase
   std::vector<double> joint_min_vector_;
   std::vector<double> joint_max_vector_;
   std::vector<bool> joint_has_limits_vector_;
+  // joint limits for the batched solution filters, +/- infinity for joints without limits
+  Eigen::VectorXd joint_lower_bounds_;
+  Eigen::VectorXd joint_upper_bounds_;
+  // bounds within which a joint may be rotated by 2 pi towards the seed; they rule out joints without limits
+  Eigen::VectorXd wrap_lower_bounds_;
+  Eigen::VectorXd wrap_upper_bounds_;
   std::vector<std::string> link_names_;
   const size_t num_joints_;
   std::vector<int> free_params_;
@@ -295,6 +335,26 @@ public:
       const IKCallbackFn& solution_callback, moveit_msgs::MoveItErrorCodes& error_code,
       const kinematics::KinematicsQueryOptions& options = kinematics::KinematicsQueryOptions()) const override;
 
+  /**
+   * @brief Solve IK for several poses at once. The analytic solver keeps no per-query state,
+   * so the poses are distributed over up to \e threads worker threads.
+   */
+  bool searchPositionIKBatch(const std::vector<geometry_msgs::Pose>& ik_poses,
+                             const std::vector<double>& ik_seed_states, double timeout, std::vector<double>& solutions,
+                             std::vector<bool>& found,
+                             const kinematics::KinematicsQueryOptions& options = kinematics::KinematicsQueryOptions(),
+                             unsigned int threads = 1) const override;
+
+  /**
+   * @brief Search the redundancy like searchPositionIK(), passing all candidate solutions of a step through the
+   * redundancy, or of the whole search when optimizing, to one call of @a batch_callback.
+   */
+  bool searchPositionIKWithBatchCallback(
+      const geometry_msgs::Pose& ik_pose, const std::vector<double>& ik_seed_state, double timeout,
+      const std::vector<double>& consistency_limits, std::vector<double>& solution,
+      const IKBatchCallbackFn& batch_callback, moveit_msgs::MoveItErrorCodes& error_code,
+      const kinematics::KinematicsQueryOptions& options = kinematics::KinematicsQueryOptions()) const override;
+
   /**
    * @brief Given a set of joint angles and a set of links, compute their pose
    *
@@ -334,20 +394,41 @@ private:
   size_t solve(KDL::Frame& pose_frame, const std::vector<double>& vfree, IkSolutionList<IkReal>& solutions) const;
 
   /**
-   * @brief Gets a specific solution from the set
+   * @brief Calls the IK solver for every value of the first free parameter in @a free_values, or once with @a vfree
+   * if there are none, and appends all solutions to @a batch. Joints with limits are rotated by multiples of 2 pi
+   * into their limits where possible.
+   */
+  void solveBatch(KDL::Frame& pose_frame, std::vector<double> vfree, const std::vector<double>& free_values,
+                  SolutionBatch& batch) const;
+
+  /**
+   * @brief Rotates the joints of all solutions of the batch by +/-360° to be near the seed state where possible
    */
-  void getSolution(const IkSolutionList<IkReal>& solutions, int i, std::vector<double>& solution) const;
+  void moveTowardsSeed(SolutionBatch& batch, const Eigen::VectorXd& ik_seed_state) const;
 
   /**
-   * @brief Gets a specific solution from the set with joints rotated 360° to be near seed state where possible
+   * @brief Collects the indices of the solutions of the batch that obey the joint limits, widened by @a tolerance.
+   * If @a sort is set, they are ordered by increasing @a cost, otherwise they keep the order of the batch.
    */
-  void getSolution(const IkSolutionList<IkReal>& solutions, const std::vector<double>& ik_seed_state, int i,
-                   std::vector<double>& solution) const;
+  void filterSolutions(SolutionBatch& batch, const Eigen::VectorXd& ik_seed_state, double tolerance,
+                       SolutionCost cost, bool sort, std::vector<Eigen::Index>& indices) const;
 
   /**
-   * @brief If the value is outside of min/max then it tries to +/- 2 * pi to put the value into the range
+   * @brief Picks the first of the solutions @a indices that passes the callback. Either callback may be empty;
+   * without any, the first solution is picked.
    */
-  double enforceLimits(double val, double min, double max) const;
+  bool selectSolution(const geometry_msgs::Pose& ik_pose, const SolutionBatch& batch,
+                      const std::vector<Eigen::Index>& indices, const IKCallbackFn& solution_callback,
+                      const IKBatchCallbackFn& batch_callback, std::vector<double>& solution,
+                      moveit_msgs::MoveItErrorCodes& error_code) const;
+
+  /**
+   * @brief Implementation of the searchPositionIK() variants, validating solutions with whichever callback is set
+   */
+  bool searchSolutions(const geometry_msgs::Pose& ik_pose, const std::vector<double>& ik_seed_state,
+                       const std::vector<double>& consistency_limits, std::vector<double>& solution,
+                       const IKCallbackFn& solution_callback, const IKBatchCallbackFn& batch_callback,
+                       moveit_msgs::MoveItErrorCodes& error_code) const;
 
   void fillFreeParams(int count, int* array);
   bool getCount(int& count, const int& max_count, const int& min_count) const;
@@ -505,6 +586,20 @@ bool IKFastKinematicsPlugin::initialize(const moveit::core::RobotModel& robot_mo
                                                          << joint_max_vector_[joint_id] << " "
                                                          << joint_has_limits_vector_[joint_id]);
 
+  const double inf = std::numeric_limits<double>::infinity();
+  joint_lower_bounds_.resize(num_joints_);
+  joint_upper_bounds_.resize(num_joints_);
+  wrap_lower_bounds_.resize(num_joints_);
+  wrap_upper_bounds_.resize(num_joints_);
+  for (size_t joint_id = 0; joint_id < num_joints_; ++joint_id)
+  {
+    const bool limited = joint_has_limits_vector_[joint_id];
+    joint_lower_bounds_[joint_id] = limited ? joint_min_vector_[joint_id] : -inf;
+    joint_upper_bounds_[joint_id] = limited ? joint_max_vector_[joint_id] : inf;
+    wrap_lower_bounds_[joint_id] = limited ? joint_min_vector_[joint_id] - LIMIT_TOLERANCE : inf;
+    wrap_upper_bounds_[joint_id] = limited ? joint_max_vector_[joint_id] + LIMIT_TOLERANCE : -inf;
+  }
+
   initialized_ = true;
   return true;
 }
@@ -649,73 +744,120 @@ size_t IKFastKinematicsPlugin::solve(KDL::Frame& pose_frame, const std::vector<d
   }
 }
 
-void IKFastKinematicsPlugin::getSolution(const IkSolutionList<IkReal>& solutions, int i,
-                                         std::vector<double>& solution) const
+void IKFastKinematicsPlugin::solveBatch(KDL::Frame& pose_frame, std::vector<double> vfree,
+                                        const std::vector<double>& free_values, SolutionBatch& batch) const
 {
-  solution.clear();
-  solution.resize(num_joints_);
-
-  // IKFast56/61
-  const IkSolutionBase<IkReal>& sol = solutions.GetSolution(i);
-  std::vector<IkReal> vsolfree(sol.GetFree().size());
-  sol.GetSolution(&solution[0], vsolfree.size() > 0 ? &vsolfree[0] : nullptr);
-
-  for (std::size_t joint_id = 0; joint_id < num_joints_; ++joint_id)
+  IkSolutionList<IkReal> solutions;
+  std::vector<IkReal> vsolfree;
+  const size_t num_solves = free_values.empty() ? 1 : free_values.size();
+  for (size_t i = 0; i < num_solves; ++i)
   {
-    if (joint_has_limits_vector_[joint_id])
+    if (!free_values.empty())
+      vfree[0] = free_values[i];
+    const size_t numsol = solve(pose_frame, vfree, solutions);
+    for (size_t s = 0; s < numsol; ++s)
     {
-      solution[joint_id] = enforceLimits(solution[joint_id], joint_min_vector_[joint_id], joint_max_vector_[joint_id]);
+      // IKFast56/61
+      const IkSolutionBase<IkReal>& sol = solutions.GetSolution(s);
+      vsolfree.assign(sol.GetFree().size(), 0.0);
+      sol.GetSolution(batch.append(num_joints_), vsolfree.size() > 0 ? &vsolfree[0] : nullptr);
     }
   }
+
+  // shift every value above (below) its limits down (up) by the number of full turns that brings it inside
+  SolutionBatch::Solutions block = batch.solutions();
+  auto values = block.array();
+  const double two_pi = 2 * M_PI;
+  values -= two_pi * ((values.colwise() - joint_upper_bounds_.array()).max(0.0) / two_pi).ceil();
+  values += two_pi * ((-(values.colwise() - joint_lower_bounds_.array())).max(0.0) / two_pi).ceil();
 }
 
-void IKFastKinematicsPlugin::getSolution(const IkSolutionList<IkReal>& solutions,
-                                         const std::vector<double>& ik_seed_state, int i,
-                                         std::vector<double>& solution) const
+void IKFastKinematicsPlugin::moveTowardsSeed(SolutionBatch& batch, const Eigen::VectorXd& ik_seed_state) const
 {
-  solution.clear();
-  solution.resize(num_joints_);
+  SolutionBatch::Solutions block = batch.solutions();
+  auto values = block.array();
+  Eigen::ArrayXXd signed_distance = values.colwise() - ik_seed_state.array();
+  const double two_pi = 2 * M_PI;
+  while (true)
+  {
+    // rotate all joints that are more than half a turn away from the seed and stay within their limits at once
+    const Eigen::ArrayXXd down =
+        ((signed_distance > M_PI) && ((values - two_pi).colwise() - wrap_lower_bounds_.array() > 0.0)).cast<double>();
+    const Eigen::ArrayXXd up =
+        ((signed_distance < -M_PI) && ((values + two_pi).colwise() - wrap_upper_bounds_.array() < 0.0)).cast<double>();
+    if ((down == 0.0).all() && (up == 0.0).all())
+      break;
+    values += two_pi * (up - down);
+    signed_distance += two_pi * (up - down);
+  }
+}
 
-  // IKFast56/61
-  const IkSolutionBase<IkReal>& sol = solutions.GetSolution(i);
-  std::vector<IkReal> vsolfree(sol.GetFree().size());
-  sol.GetSolution(&solution[0], vsolfree.size() > 0 ? &vsolfree[0] : nullptr);
+void IKFastKinematicsPlugin::filterSolutions(SolutionBatch& batch, const Eigen::VectorXd& ik_seed_state,
+                                             double tolerance, SolutionCost cost, bool sort,
+                                             std::vector<Eigen::Index>& indices) const
+{
+  SolutionBatch::Solutions block = batch.solutions();
+  auto values = block.array();
+  const Eigen::Array<bool, 1, Eigen::Dynamic> obeys_limits =
+      ((values.colwise() - (joint_lower_bounds_.array() - tolerance)).colwise().minCoeff() >= 0.0) &&
+      ((values.colwise() - (joint_upper_bounds_.array() + tolerance)).colwise().maxCoeff() <= 0.0);
+  const Eigen::ArrayXXd distance = (values.colwise() - ik_seed_state.array()).abs();
+  Eigen::Array<double, 1, Eigen::Dynamic> costs;
+  if (cost == SolutionCost::SUM_JOINT_DISTANCE)
+    costs = distance.colwise().sum();
+  else
+    costs = distance.colwise().maxCoeff();
+
+  indices.clear();
+  for (Eigen::Index i = 0; i < batch.size; ++i)
+    if (obeys_limits[i])
+      indices.push_back(i);
+  if (sort)
+    std::stable_sort(indices.begin(), indices.end(),
+                     [&costs](Eigen::Index a, Eigen::Index b) { return costs[a] < costs[b]; });
+  ROS_DEBUG_STREAM_NAMED(name_, indices.size() << " of " << batch.size << " solutions obey the joint limits");
+}
 
-  // rotate joints by +/-360° where it is possible and useful
-  for (std::size_t i = 0; i < num_joints_; ++i)
+bool IKFastKinematicsPlugin::selectSolution(const geometry_msgs::Pose& ik_pose, const SolutionBatch& batch,
+                                            const std::vector<Eigen::Index>& indices,
+                                            const IKCallbackFn& solution_callback,
+                                            const IKBatchCallbackFn& batch_callback, std::vector<double>& solution,
+                                            moveit_msgs::MoveItErrorCodes& error_code) const
+{
+  if (!batch_callback.empty())
   {
-    if (joint_has_limits_vector_[i])
+    if (indices.empty())
+      return false;
+    std::vector<std::vector<double>> candidates;
+    candidates.reserve(indices.size());
+    for (Eigen::Index i : indices)
+      candidates.push_back(batch.getSolution(i));
+    std::vector<bool> valid(candidates.size(), false);
+    batch_callback(ik_pose, candidates, valid);
+    for (size_t i = 0; i < candidates.size() && i < valid.size(); ++i)
     {
-      solution[i] = enforceLimits(solution[i], joint_min_vector_[i], joint_max_vector_[i]);
-      double signed_distance = solution[i] - ik_seed_state[i];
-      while (signed_distance > M_PI && solution[i] - 2 * M_PI > (joint_min_vector_[i] - LIMIT_TOLERANCE))
+      if (valid[i])
       {
-        signed_distance -= 2 * M_PI;
-        solution[i] -= 2 * M_PI;
-      }
-      while (signed_distance < -M_PI && solution[i] + 2 * M_PI < (joint_max_vector_[i] + LIMIT_TOLERANCE))
-      {
-        signed_distance += 2 * M_PI;
-        solution[i] += 2 * M_PI;
+        solution = std::move(candidates[i]);
+        error_code.val = error_code.SUCCESS;
+        return true;
       }
     }
-  }
-}
-
-double IKFastKinematicsPlugin::enforceLimits(double joint_value, double min, double max) const
-{
-  // If the joint_value is greater than max subtract 2 * PI until it is less than the max
-  while (joint_value > max)
-  {
-    joint_value -= 2 * M_PI;
+    error_code.val = error_code.NO_IK_SOLUTION;
+    return false;
   }
 
-  // If the joint_value is less than the min, add 2 * PI until it is more than the min
-  while (joint_value < min)
+  for (Eigen::Index i : indices)
   {
-    joint_value += 2 * M_PI;
+    solution = batch.getSolution(i);
+    if (!solution_callback.empty())
+      solution_callback(ik_pose, solution, error_code);
+    else
+      error_code.val = error_code.SUCCESS;
+    if (error_code.val == error_code.SUCCESS)
+      return true;
   }
-  return joint_value;
+  return false;
 }
 
 void IKFastKinematicsPlugin::fillFreeParams(int count, int* array)
@@ -855,63 +997,29 @@ bool IKFastKinematicsPlugin::searchPositionIK(const geometry_msgs::Pose& ik_pose
                                               moveit_msgs::MoveItErrorCodes& error_code,
                                               const kinematics::KinematicsQueryOptions& options) const
 {
-  // "SEARCH_MODE" is fixed during code generation
-  SEARCH_MODE search_mode = _SEARCH_MODE_;
-
-  // Check if there are no redundant joints
-  if (free_params_.size() == 0)
-  {
-    ROS_DEBUG_STREAM_NAMED(name_, "No need to search since no free params/redundant joints");
-
-    std::vector<geometry_msgs::Pose> ik_poses(1, ik_pose);
-    std::vector<std::vector<double>> solutions;
-    kinematics::KinematicsResult kinematic_result;
-    // Find all IK solutions within joint limits
-    if (!getPositionIK(ik_poses, ik_seed_state, solutions, kinematic_result, options))
-    {
-      ROS_DEBUG_STREAM_NAMED(name_, "No solution whatsoever");
-      error_code.val = moveit_msgs::MoveItErrorCodes::NO_IK_SOLUTION;
-      return false;
-    }
-
-    // sort solutions by their distance to the seed
-    std::vector<LimitObeyingSol> solutions_obey_limits;
-    for (std::size_t i = 0; i < solutions.size(); ++i)
-    {
-      double dist_from_seed = 0.0;
-      for (std::size_t j = 0; j < ik_seed_state.size(); ++j)
-      {
-        dist_from_seed += fabs(ik_seed_state[j] - solutions[i][j]);
-      }
-
-      solutions_obey_limits.push_back({ solutions[i], dist_from_seed });
-    }
-    std::sort(solutions_obey_limits.begin(), solutions_obey_limits.end());
+  return searchSolutions(ik_pose, ik_seed_state, consistency_limits, solution, solution_callback, IKBatchCallbackFn(),
+                         error_code);
+}
 
-    // check for collisions if a callback is provided
-    if (!solution_callback.empty())
-    {
-      for (std::size_t i = 0; i < solutions_obey_limits.size(); ++i)
-      {
-        solution_callback(ik_pose, solutions_obey_limits[i].value, error_code);
-        if (error_code.val == moveit_msgs::MoveItErrorCodes::SUCCESS)
-        {
-          solution = solutions_obey_limits[i].value;
-          ROS_DEBUG_STREAM_NAMED(name_, "Solution passes callback");
-          return true;
-        }
-      }
+bool IKFastKinematicsPlugin::searchPositionIKWithBatchCallback(
+    const geometry_msgs::Pose& ik_pose, const std::vector<double>& ik_seed_state, double timeout,
+    const std::vector<double>& consistency_limits, std::vector<double>& solution,
+    const IKBatchCallbackFn& batch_callback, moveit_msgs::MoveItErrorCodes& error_code,
+    const kinematics::KinematicsQueryOptions& options) const
+{
+  return searchSolutions(ik_pose, ik_seed_state, consistency_limits, solution, IKCallbackFn(), batch_callback,
+                         error_code);
+}
 
-      ROS_DEBUG_STREAM_NAMED(name_, "Solution has error code " << error_code);
-      return false;
-    }
-    else
-    {
-      solution = solutions_obey_limits[0].value;
-      error_code.val = moveit_msgs::MoveItErrorCodes::SUCCESS;
-      return true;  // no collision check callback provided
-    }
-  }
+bool IKFastKinematicsPlugin::searchSolutions(const geometry_msgs::Pose& ik_pose,
+                                             const std::vector<double>& ik_seed_state,
+                                             const std::vector<double>& consistency_limits,
+                                             std::vector<double>& solution, const IKCallbackFn& solution_callback,
+                                             const IKBatchCallbackFn& batch_callback,
+                                             moveit_msgs::MoveItErrorCodes& error_code) const
+{
+  // "SEARCH_MODE" is fixed during code generation
+  SEARCH_MODE search_mode = _SEARCH_MODE_;
 
   // -------------------------------------------------------------------------------------------------
   // Error Checking
@@ -944,9 +1052,36 @@ bool IKFastKinematicsPlugin::searchPositionIK(const geometry_msgs::Pose& ik_pose
   KDL::Frame frame;
   transformToChainFrame(ik_pose, frame);
 
+  const Eigen::VectorXd seed = Eigen::Map<const Eigen::VectorXd>(ik_seed_state.data(), ik_seed_state.size());
   std::vector<double> vfree(free_params_.size());
+  SolutionBatch batch;
+  std::vector<Eigen::Index> candidates;
 
-  int counter = 0;
+  // Check if there are no redundant joints
+  if (free_params_.size() == 0)
+  {
+    ROS_DEBUG_STREAM_NAMED(name_, "No need to search since no free params/redundant joints");
+
+    // Find all IK solutions within joint limits, sorted by their distance to the seed
+    solveBatch(frame, vfree, std::vector<double>(), batch);
+    moveTowardsSeed(batch, seed);
+    filterSolutions(batch, seed, LIMIT_TOLERANCE, SolutionCost::SUM_JOINT_DISTANCE, true, candidates);
+    if (candidates.empty())
+    {
+      ROS_DEBUG_STREAM_NAMED(name_, "No solution whatsoever");
+      error_code.val = moveit_msgs::MoveItErrorCodes::NO_IK_SOLUTION;
+      return false;
+    }
+
+    // check for collisions if a callback is provided
+    if (selectSolution(ik_pose, batch, candidates, solution_callback, batch_callback, solution, error_code))
+    {
+      ROS_DEBUG_STREAM_NAMED(name_, "Solution passes callback");
+      return true;
+    }
+    ROS_DEBUG_STREAM_NAMED(name_, "Solution has error code " << error_code);
+    return false;
+  }
 
   double initial_guess = ik_seed_state[free_params_[0]];
   vfree[0] = initial_guess;
@@ -982,102 +1117,63 @@ bool IKFastKinematicsPlugin::searchPositionIK(const geometry_msgs::Pose& ik_pose
   if ((search_mode & OPTIMIZE_MAX_JOINT) && (num_positive_increments + num_negative_increments) > 1000)
     ROS_WARN_STREAM_ONCE_NAMED(name_, "Large search space, consider increasing the search discretization");
 
-  double best_costs = -1.0;
-  std::vector<double> best_solution;
-  int nattempts = 0, nvalid = 0;
-
-  while (true)
+  // The values of the free parameter in the order they are searched: alternating around the initial guess
+  std::vector<double> free_values(1, initial_guess);
+  for (int counter = 0; getCount(counter, num_positive_increments, -num_negative_increments);)
+    free_values.push_back(initial_guess + search_discretization * counter);
+
+  // When optimizing, all values are solved at once and the candidates are sorted by their largest joint motion, so
+  // the first one passing the callback is the best. Otherwise the values are solved in batches, in search order, so
+  // that the search stops at the first feasible solution.
+  const bool optimize = search_mode & OPTIMIZE_MAX_JOINT;
+  const size_t batch_size = optimize ? free_values.size() : FREE_VALUE_BATCH_SIZE;
+  std::vector<double> batch_free_values;
+  size_t nattempts = 0;
+  for (size_t begin = 0; begin < free_values.size(); begin += batch_size)
   {
-    IkSolutionList<IkReal> solutions;
-    size_t numsol = solve(frame, vfree, solutions);
-
-    ROS_DEBUG_STREAM_NAMED(name_, "Found " << numsol << " solutions from IKFast");
-
-    if (numsol > 0)
-    {
-      for (size_t s = 0; s < numsol; ++s)
-      {
-        nattempts++;
-        std::vector<double> sol;
-        getSolution(solutions, ik_seed_state, s, sol);
-
-        bool obeys_limits = true;
-        for (size_t i = 0; i < sol.size(); i++)
-        {
-          if (joint_has_limits_vector_[i] && (sol[i] < joint_min_vector_[i] || sol[i] > joint_max_vector_[i]))
-          {
-            obeys_limits = false;
-            break;
-          }
-          // ROS_INFO_STREAM_NAMED(name_,"Num " << i << " value " << sol[i] << " has limits " <<
-          // joint_has_limits_vector_[i] << " " << joint_min_vector_[i] << " " << joint_max_vector_[i]);
-        }
-        if (obeys_limits)
-        {
-          getSolution(solutions, ik_seed_state, s, solution);
-
-          // This solution is within joint limits, now check if in collision (if callback provided)
-          if (!solution_callback.empty())
-          {
-            solution_callback(ik_pose, solution, error_code);
-          }
-          else
-          {
-            error_code.val = error_code.SUCCESS;
-          }
-
-          if (error_code.val == error_code.SUCCESS)
-          {
-            nvalid++;
-            if (search_mode & OPTIMIZE_MAX_JOINT)
-            {
-              // Costs for solution: Largest joint motion
-              double costs = 0.0;
-              for (unsigned int i = 0; i < solution.size(); i++)
-              {
-                double d = fabs(ik_seed_state[i] - solution[i]);
-                if (d > costs)
-                  costs = d;
-              }
-              if (costs < best_costs || best_costs == -1.0)
-              {
-                best_costs = costs;
-                best_solution = solution;
-              }
-            }
-            else
-              // Return first feasible solution
-              return true;
-          }
-        }
-      }
-    }
-
-    if (!getCount(counter, num_positive_increments, -num_negative_increments))
+    const size_t end = std::min(begin + batch_size, free_values.size());
+    batch_free_values.assign(free_values.begin() + begin, free_values.begin() + end);
+    batch.clear();
+    solveBatch(frame, vfree, batch_free_values, batch);
+    nattempts += batch.size;
+    moveTowardsSeed(batch, seed);
+    filterSolutions(batch, seed, 0.0, SolutionCost::MAX_JOINT_DISTANCE, optimize, candidates);
+    if (selectSolution(ik_pose, batch, candidates, solution_callback, batch_callback, solution, error_code))
     {
-      // Everything searched
-      error_code.val = moveit_msgs::MoveItErrorCodes::NO_IK_SOLUTION;
-      break;
+      ROS_DEBUG_STREAM_NAMED(name_, "Found a valid solution among " << nattempts << " solutions");
+      return true;
     }
-
-    vfree[0] = initial_guess + search_discretization * counter;
-    // ROS_DEBUG_STREAM_NAMED(name_,"Attempt " << counter << " with 0th free joint having value " << vfree[0]);
   }
 
-  ROS_DEBUG_STREAM_NAMED(name_, "Valid solutions: " << nvalid << "/" << nattempts);
-
-  if ((search_mode & OPTIMIZE_MAX_JOINT) && best_costs != -1.0)
-  {
-    solution = best_solution;
-    error_code.val = error_code.SUCCESS;
-    return true;
-  }
+  ROS_DEBUG_STREAM_NAMED(name_, "No valid solution among " << nattempts << " solutions");
 
   // No solution found
   error_code.val = moveit_msgs::MoveItErrorCodes::NO_IK_SOLUTION;
   return false;
 }
 
+bool IKFastKinematicsPlugin::searchPositionIKBatch(const std::vector<geometry_msgs::Pose>& ik_poses,
+                                                   const std::vector<double>& ik_seed_states, double timeout,
+                                                   std::vector<double>& solutions, std::vector<bool>& found,
+                                                   const kinematics::KinematicsQueryOptions& options,
+                                                   unsigned int threads) const
+{
+  if (!initialized_)
+  {
+    ROS_ERROR_STREAM_NAMED(name_, "Kinematics not active");
+    found.assign(ik_poses.size(), false);
+    return false;
+  }
+
+  return solveIKBatch(ik_poses, ik_seed_states, solutions, found, threads, [this, timeout, &options]() -> BatchSolveFn {
+    return [this, timeout, &options](const geometry_msgs::Pose& ik_pose, const std::vector<double>& ik_seed_state,
+                                     std::vector<double>& solution) {
+      moveit_msgs::MoveItErrorCodes error_code;
+      return searchPositionIK(ik_pose, ik_seed_state, timeout, solution, error_code, options);
+    };
+  });
+}
+
 // Used when there are no redundant joints - aka no free params
 bool IKFastKinematicsPlugin::getPositionIK(const geometry_msgs::Pose& ik_pose, const std::vector<double>& ik_seed_state,
                                            std::vector<double>& solution, moveit_msgs::MoveItErrorCodes& error_code,
@@ -1124,62 +1220,18 @@ bool IKFastKinematicsPlugin::getPositionIK(const geometry_msgs::Pose& ik_pose, c
   KDL::Frame frame;
   transformToChainFrame(ik_pose, frame);
 
-  IkSolutionList<IkReal> solutions;
-  size_t numsol = solve(frame, vfree, solutions);
-  ROS_DEBUG_STREAM_NAMED(name_, "Found " << numsol << " solutions from IKFast");
-
-  std::vector<LimitObeyingSol> solutions_obey_limits;
+  SolutionBatch batch;
+  solveBatch(frame, vfree, std::vector<double>(), batch);
+  ROS_DEBUG_STREAM_NAMED(name_, "Found " << batch.size << " solutions from IKFast");
 
-  if (numsol)
-  {
-    std::vector<double> solution_obey_limits;
-    for (std::size_t s = 0; s < numsol; ++s)
-    {
-      std::vector<double> sol;
-      getSolution(solutions, ik_seed_state, s, sol);
-      ROS_DEBUG_NAMED(name_, "Sol %d: %e   %e   %e   %e   %e   %e", static_cast<int>(s), sol[0], sol[1], sol[2], sol[3],
-                      sol[4], sol[5]);
-
-      bool obeys_limits = true;
-      for (std::size_t i = 0; i < sol.size(); i++)
-      {
-        // Add tolerance to limit check
-        if (joint_has_limits_vector_[i] && ((sol[i] < (joint_min_vector_[i] - LIMIT_TOLERANCE)) ||
-                                            (sol[i] > (joint_max_vector_[i] + LIMIT_TOLERANCE))))
-        {
-          // One element of solution is not within limits
-          obeys_limits = false;
-          ROS_DEBUG_STREAM_NAMED(name_, "Not in limits! " << static_cast<int>(i) << " value " << sol[i]
-                                                          << " has limit: " << joint_has_limits_vector_[i]
-                                                          << "  being  " << joint_min_vector_[i] << " to "
-                                                          << joint_max_vector_[i]);
-          break;
-        }
-      }
-      if (obeys_limits)
-      {
-        // All elements of this solution obey limits
-        getSolution(solutions, ik_seed_state, s, solution_obey_limits);
-        double dist_from_seed = 0.0;
-        for (std::size_t i = 0; i < ik_seed_state.size(); ++i)
-        {
-          dist_from_seed += fabs(ik_seed_state[i] - solution_obey_limits[i]);
-        }
-
-        solutions_obey_limits.push_back({ solution_obey_limits, dist_from_seed });
-      }
-    }
-  }
-  else
-  {
-    ROS_DEBUG_STREAM_NAMED(name_, "No IK solution");
-  }
-
-  // Sort the solutions under limits and find the one that is closest to ik_seed_state
+  // Find the solution under limits that is closest to ik_seed_state
+  const Eigen::VectorXd seed = Eigen::Map<const Eigen::VectorXd>(ik_seed_state.data(), num_joints_);
+  std::vector<Eigen::Index> solutions_obey_limits;
+  moveTowardsSeed(batch, seed);
+  filterSolutions(batch, seed, LIMIT_TOLERANCE, SolutionCost::SUM_JOINT_DISTANCE, true, solutions_obey_limits);
   if (!solutions_obey_limits.empty())
   {
-    std::sort(solutions_obey_limits.begin(), solutions_obey_limits.end());
-    solution = solutions_obey_limits[0].value;
+    solution = batch.getSolution(solutions_obey_limits[0]);
     error_code.val = moveit_msgs::MoveItErrorCodes::SUCCESS;
     return true;
   }
@@ -1228,10 +1280,8 @@ bool IKFastKinematicsPlugin::getPositionIK(const std::vector<geometry_msgs::Pose
   transformToChainFrame(ik_poses[0], frame);
 
   // solving ik
-  std::vector<IkSolutionList<IkReal>> solution_set;
-  IkSolutionList<IkReal> ik_solutions;
-  std::vector<double> vfree;
-  int numsol = 0;
+  SolutionBatch batch;
+  std::vector<double> vfree(free_params_.size());
   std::vector<double> sampled_joint_vals;
   if (!redundant_joint_indices_.empty())
   {
@@ -1260,63 +1310,23 @@ bool IKFastKinematicsPlugin::getPositionIK(const std::vector<geometry_msgs::Pose
       result.kinematic_error = kinematics::KinematicErrors::UNSUPORTED_DISCRETIZATION_REQUESTED;
       return false;
     }
-
-    for (unsigned int i = 0; i < sampled_joint_vals.size(); i++)
-    {
-      vfree.clear();
-      vfree.push_back(sampled_joint_vals[i]);
-      numsol += solve(frame, vfree, ik_solutions);
-      solution_set.push_back(ik_solutions);
-    }
-  }
-  else
-  {
-    // computing for single solution set
-    numsol = solve(frame, vfree, ik_solutions);
-    solution_set.push_back(ik_solutions);
   }
 
-  ROS_DEBUG_STREAM_NAMED(name_, "Found " << numsol << " solutions from IKFast");
-  bool solutions_found = false;
-  if (numsol > 0)
-  {
-    /*
-      Iterating through all solution sets and storing those that do not exceed joint limits.
-    */
-    for (unsigned int r = 0; r < solution_set.size(); r++)
-    {
-      ik_solutions = solution_set[r];
-      numsol = ik_solutions.GetNumSolutions();
-      for (int s = 0; s < numsol; ++s)
-      {
-        std::vector<double> sol;
-        getSolution(ik_solutions, ik_seed_state, s, sol);
-
-        bool obeys_limits = true;
-        for (unsigned int i = 0; i < sol.size(); i++)
-        {
-          // Add tolerance to limit check
-          if (joint_has_limits_vector_[i] && ((sol[i] < (joint_min_vector_[i] - LIMIT_TOLERANCE)) ||
-                                              (sol[i] > (joint_max_vector_[i] + LIMIT_TOLERANCE))))
-          {
-            // One element of solution is not within limits
-            obeys_limits = false;
-            ROS_DEBUG_STREAM_NAMED(name_, "Not in limits! " << i << " value " << sol[i] << " has limit: "
-                                                            << joint_has_limits_vector_[i] << "  being  "
-                                                            << joint_min_vector_[i] << " to " << joint_max_vector_[i]);
-            break;
-          }
-        }
-        if (obeys_limits)
-        {
-          // All elements of solution obey limits
-          solutions_found = true;
-          solutions.push_back(sol);
-        }
-      }
-    }
+  // solving for all sampled values of the redundant joint at once, or for a single solution set without one
+  solveBatch(frame, vfree, sampled_joint_vals, batch);
 
-    if (solutions_found)
+  ROS_DEBUG_STREAM_NAMED(name_, "Found " << batch.size << " solutions from IKFast");
+  if (batch.size > 0)
+  {
+    // storing all solutions that do not exceed joint limits
+    const Eigen::VectorXd seed = Eigen::Map<const Eigen::VectorXd>(ik_seed_state.data(), num_joints_);
+    std::vector<Eigen::Index> solutions_obey_limits;
+    moveTowardsSeed(batch, seed);
+    filterSolutions(batch, seed, LIMIT_TOLERANCE, SolutionCost::SUM_JOINT_DISTANCE, false, solutions_obey_limits);
+    for (Eigen::Index i : solutions_obey_limits)
+      solutions.push_back(batch.getSolution(i));
+
+    if (!solutions_obey_limits.empty())
     {
       result.kinematic_error = kinematics::KinematicErrors::OK;
       return true;
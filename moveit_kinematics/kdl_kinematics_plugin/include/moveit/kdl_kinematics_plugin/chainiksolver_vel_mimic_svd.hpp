@@ -110,6 +110,8 @@ private:
   ChainJntToJacSolver jnt2jac_;
 
   Eigen::JacobiSVD<Eigen::MatrixXd> svd_;
+  Eigen::MatrixXd jac_rows_;  // rows of the weighted Jacobian passed to the SVD
+  Eigen::VectorXd svd_tmp_;   // intermediate of the least-squares solve
   Eigen::VectorXd qdot_out_reduced_;
 
   Jacobian jac_;          // full Jacobian
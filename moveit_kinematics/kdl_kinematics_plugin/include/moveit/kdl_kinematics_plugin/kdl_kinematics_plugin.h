@@ -104,6 +104,12 @@ public:
       const IKCallbackFn& solution_callback, moveit_msgs::MoveItErrorCodes& error_code,
       const kinematics::KinematicsQueryOptions& options = kinematics::KinematicsQueryOptions()) const override;
 
+  bool searchPositionIKBatch(const std::vector<geometry_msgs::Pose>& ik_poses,
+                             const std::vector<double>& ik_seed_states, double timeout, std::vector<double>& solutions,
+                             std::vector<bool>& found,
+                             const kinematics::KinematicsQueryOptions& options = kinematics::KinematicsQueryOptions(),
+                             unsigned int threads = 1) const override;
+
   bool getPositionFK(const std::vector<std::string>& link_names, const std::vector<double>& joint_angles,
                      std::vector<geometry_msgs::Pose>& poses) const override;
 
@@ -124,13 +130,34 @@ public:
 protected:
   typedef Eigen::Matrix<double, 6, 1> Twist;
 
+  /// Buffers CartToJnt() reuses across its iterations, sized for the number of joints
+  struct IterationBuffers
+  {
+    explicit IterationBuffers(unsigned int num_joints);
+    KDL::JntArray delta_q;
+    KDL::JntArray q_backup;
+    Eigen::ArrayXd extra_joint_weights;
+    Eigen::VectorXd weights;
+  };
+
   /// Solve position IK given initial joint values
   // NOLINTNEXTLINE(readability-identifier-naming)
   int CartToJnt(KDL::ChainIkSolverVelMimicSVD& ik_solver, const KDL::JntArray& q_init, const KDL::Frame& p_in,
                 KDL::JntArray& q_out, const unsigned int max_iter, const Eigen::VectorXd& joint_weights,
                 const Twist& cartesian_weights) const;
 
+  /// Solve position IK given initial joint values, using the given FK solver and buffers.
+  /// Does not allocate once the buffers are sized.
+  // NOLINTNEXTLINE(readability-identifier-naming)
+  int CartToJnt(KDL::ChainFkSolverPos& fk_solver, KDL::ChainIkSolverVelMimicSVD& ik_solver, IterationBuffers& buffers,
+                const KDL::JntArray& q_init, const KDL::Frame& p_in, KDL::JntArray& q_out, const unsigned int max_iter,
+                const Eigen::VectorXd& joint_weights, const Twist& cartesian_weights) const;
+
 private:
+  /// Solvers, random state and buffers for one thread of searchPositionIK() calls, defined in the source file
+  struct SolverWorkspace;
+  std::shared_ptr<SolverWorkspace> createWorkspace() const;
+
   void getJointWeights();
   bool timedOut(const ros::WallTime& start_time, double duration) const;
 
@@ -143,15 +170,23 @@ private:
   bool checkConsistency(const Eigen::VectorXd& seed_state, const std::vector<double>& consistency_limits,
                         const Eigen::VectorXd& solution) const;
 
-  void getRandomConfiguration(Eigen::VectorXd& jnt_array) const;
+  /** @brief Implementation of searchPositionIK(). The workspace is passed in, so that searchPositionIKBatch()
+   *  can solve poses concurrently with one workspace per thread. */
+  bool searchPositionIK(const geometry_msgs::Pose& ik_pose, const std::vector<double>& ik_seed_state, double timeout,
+                        const std::vector<double>& consistency_limits, std::vector<double>& solution,
+                        const IKCallbackFn& solution_callback, moveit_msgs::MoveItErrorCodes& error_code,
+                        const kinematics::KinematicsQueryOptions& options, SolverWorkspace& workspace) const;
+
+  void getRandomConfiguration(moveit::core::RobotState& state, Eigen::VectorXd& jnt_array) const;
 
   /** @brief Get a random configuration within consistency limits close to the seed state
+   *  @param state State providing the random number generator
    *  @param seed_state Seed state
    *  @param consistency_limits
    *  @param jnt_array Returned random configuration
    */
-  void getRandomConfiguration(const Eigen::VectorXd& seed_state, const std::vector<double>& consistency_limits,
-                              Eigen::VectorXd& jnt_array) const;
+  void getRandomConfiguration(moveit::core::RobotState& state, const Eigen::VectorXd& seed_state,
+                              const std::vector<double>& consistency_limits, Eigen::VectorXd& jnt_array) const;
 
   /// clip q_delta such that joint limits will not be violated
   void clipToJointLimits(const KDL::JntArray& q, KDL::JntArray& q_delta, Eigen::ArrayXd& weighting) const;
@@ -165,6 +200,7 @@ private:
   moveit::core::RobotStatePtr state_;
   KDL::Chain kdl_chain_;
   std::unique_ptr<KDL::ChainFkSolverPos> fk_solver_;
+  std::shared_ptr<SolverWorkspace> workspace_;  ///< preallocated at initialize() for searchPositionIK()
   std::vector<JointMimic> mimic_joints_;
   std::vector<double> joint_weights_;
   Eigen::VectorXd joint_min_, joint_max_;  ///< joint limits
@@ -24,6 +24,7 @@
 // Copyright  (C)  2013  Sachin Chitta, Willow Garage
 
 #include <moveit/kdl_kinematics_plugin/chainiksolver_vel_mimic_svd.hpp>
+#include <algorithm>
 
 namespace
 {
@@ -51,6 +52,9 @@ ChainIkSolverVelMimicSVD::ChainIkSolverVelMimicSVD(const Chain& chain,
   // Performing a position-only IK, we just need to consider the first 3 rows of the Jacobian for SVD
   // SVD doesn't consider mimic joints, but only their driving joints
   , svd_(position_ik ? 3 : 6, chain_.getNrOfJoints() - num_mimic_joints_, Eigen::ComputeThinU | Eigen::ComputeThinV)
+  , jac_rows_(svd_.rows(), svd_.cols())
+  , svd_tmp_(std::min(svd_.rows(), svd_.cols()))
+  , qdot_out_reduced_(svd_.cols())
   , jac_(chain_.getNrOfJoints())
   , jac_reduced_(svd_.cols())
 {
@@ -110,18 +114,26 @@ int ChainIkSolverVelMimicSVD::CartToJnt(const JntArray& q_in, const Twist& v_in,
   vin.bottomRows<3>() = Eigen::Map<const Eigen::Array3d>(v_in.rot.data, 3) * cartesian_weights.bottomRows<3>().array();
 
   // Do a singular value decomposition: J = U*S*V^t
-  svd_.compute(jac.topRows(rows));
+  // Copying into a preallocated matrix avoids the temporary that passing a row block would create.
+  jac_rows_ = jac.topRows(rows);
+  svd_.compute(jac_rows_);
+
+  // Least-squares solution V * S^-1 * U^t * v, as svd_.solve() computes it, but into preallocated storage
+  const Eigen::Index rank = svd_.rank();
+  auto tmp = svd_tmp_.head(rank);
+  tmp.noalias() = svd_.matrixU().leftCols(rank).adjoint() * vin.topRows(rows);
+  tmp.array() /= svd_.singularValues().head(rank).array();
 
   if (num_mimic_joints_ > 0)
   {
-    qdot_out_reduced_.noalias() = svd_.solve(vin.topRows(rows));
+    qdot_out_reduced_.noalias() = svd_.matrixV().leftCols(rank) * tmp;
     qdot_out_reduced_.array() *= joint_weights.array();
     for (unsigned int i = 0; i < chain_.getNrOfJoints(); ++i)
       qdot_out(i) = qdot_out_reduced_[mimic_joints_[i].map_index] * mimic_joints_[i].multiplier;
   }
   else
   {
-    qdot_out.data.noalias() = svd_.solve(vin.topRows(rows));
+    qdot_out.data.noalias() = svd_.matrixV().leftCols(rank) * tmp;
     qdot_out.data.array() *= joint_weights.array();
   }
 
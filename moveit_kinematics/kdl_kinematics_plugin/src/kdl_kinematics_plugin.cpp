@@ -51,21 +51,54 @@ CLASS_LOADER_REGISTER_CLASS(kdl_kinematics_plugin::KDLKinematicsPlugin, kinemati
 
 namespace kdl_kinematics_plugin
 {
+struct KDLKinematicsPlugin::SolverWorkspace
+{
+  SolverWorkspace(const KDL::Chain& chain, const std::vector<JointMimic>& mimic_joints, bool position_ik,
+                  const moveit::core::RobotModelConstPtr& robot_model, unsigned int dimension,
+                  const std::vector<double>& joint_weights)
+    : fk_solver(chain)
+    , ik_solver_vel(chain, mimic_joints, position_ik)
+    , state(robot_model)
+    , jnt_seed_state(dimension)
+    , jnt_pos_in(dimension)
+    , jnt_pos_out(dimension)
+    , joint_weights(Eigen::Map<const Eigen::VectorXd>(joint_weights.data(), joint_weights.size()))
+    , buffers(dimension)
+  {
+    consistency_limits_mimic.reserve(dimension);
+  }
+
+  KDL::ChainFkSolverPos_recursive fk_solver;
+  KDL::ChainIkSolverVelMimicSVD ik_solver_vel;
+  moveit::core::RobotState state;  ///< random number generator for restarts
+  KDL::JntArray jnt_seed_state;
+  KDL::JntArray jnt_pos_in;
+  KDL::JntArray jnt_pos_out;
+  Eigen::VectorXd joint_weights;
+  IterationBuffers buffers;
+  std::vector<double> consistency_limits_mimic;
+};
+
+KDLKinematicsPlugin::IterationBuffers::IterationBuffers(unsigned int num_joints)
+  : delta_q(num_joints), q_backup(num_joints), extra_joint_weights(num_joints), weights(num_joints)
+{
+}
+
 KDLKinematicsPlugin::KDLKinematicsPlugin() : initialized_(false)
 {
 }
 
-void KDLKinematicsPlugin::getRandomConfiguration(Eigen::VectorXd& jnt_array) const
+void KDLKinematicsPlugin::getRandomConfiguration(moveit::core::RobotState& state, Eigen::VectorXd& jnt_array) const
 {
-  state_->setToRandomPositions(joint_model_group_);
-  state_->copyJointGroupPositions(joint_model_group_, &jnt_array[0]);
+  state.setToRandomPositions(joint_model_group_);
+  state.copyJointGroupPositions(joint_model_group_, &jnt_array[0]);
 }
 
-void KDLKinematicsPlugin::getRandomConfiguration(const Eigen::VectorXd& seed_state,
+void KDLKinematicsPlugin::getRandomConfiguration(moveit::core::RobotState& state, const Eigen::VectorXd& seed_state,
                                                  const std::vector<double>& consistency_limits,
                                                  Eigen::VectorXd& jnt_array) const
 {
-  joint_model_group_->getVariableRandomPositionsNearBy(state_->getRandomNumberGenerator(), &jnt_array[0],
+  joint_model_group_->getVariableRandomPositionsNearBy(state.getRandomNumberGenerator(), &jnt_array[0],
                                                        &seed_state[0], consistency_limits);
 }
 
@@ -260,6 +293,7 @@ bool KDLKinematicsPlugin::initialize(const moveit::core::RobotModel& robot_model
   state_ = std::make_shared<moveit::core::RobotState>(robot_model_);
 
   fk_solver_ = std::make_unique<KDL::ChainFkSolverPos_recursive>(kdl_chain_);
+  workspace_ = createWorkspace();
 
   initialized_ = true;
   ROS_DEBUG_NAMED("kdl", "KDL solver initialized");
@@ -318,6 +352,56 @@ bool KDLKinematicsPlugin::searchPositionIK(const geometry_msgs::Pose& ik_pose, c
                                            std::vector<double>& solution, const IKCallbackFn& solution_callback,
                                            moveit_msgs::MoveItErrorCodes& error_code,
                                            const kinematics::KinematicsQueryOptions& options) const
+{
+  if (!initialized_)
+  {
+    ROS_ERROR_NAMED("kdl", "kinematics solver not initialized");
+    error_code.val = error_code.NO_IK_SOLUTION;
+    return false;
+  }
+
+  return searchPositionIK(ik_pose, ik_seed_state, timeout, consistency_limits, solution, solution_callback, error_code,
+                          options, *workspace_);
+}
+
+std::shared_ptr<KDLKinematicsPlugin::SolverWorkspace> KDLKinematicsPlugin::createWorkspace() const
+{
+  return std::make_shared<SolverWorkspace>(kdl_chain_, mimic_joints_, orientation_vs_position_weight_ == 0.0,
+                                           robot_model_, dimension_, joint_weights_);
+}
+
+bool KDLKinematicsPlugin::searchPositionIKBatch(const std::vector<geometry_msgs::Pose>& ik_poses,
+                                                const std::vector<double>& ik_seed_states, double timeout,
+                                                std::vector<double>& solutions, std::vector<bool>& found,
+                                                const kinematics::KinematicsQueryOptions& options,
+                                                unsigned int threads) const
+{
+  if (!initialized_)
+  {
+    ROS_ERROR_NAMED("kdl", "kinematics solver not initialized");
+    found.assign(ik_poses.size(), false);
+    return false;
+  }
+
+  return solveIKBatch(ik_poses, ik_seed_states, solutions, found, threads, [this, timeout, &options]() -> BatchSolveFn {
+    // the workspace is set up once per thread and shared by its poses
+    std::shared_ptr<SolverWorkspace> workspace = createWorkspace();
+    return [this, timeout, &options, workspace](const geometry_msgs::Pose& ik_pose,
+                                                const std::vector<double>& ik_seed_state,
+                                                std::vector<double>& solution) {
+      moveit_msgs::MoveItErrorCodes error_code;
+      return searchPositionIK(ik_pose, ik_seed_state, timeout, std::vector<double>(), solution, IKCallbackFn(),
+                              error_code, options, *workspace);
+    };
+  });
+}
+
+bool KDLKinematicsPlugin::searchPositionIK(const geometry_msgs::Pose& ik_pose, const std::vector<double>& ik_seed_state,
+                                           double timeout, const std::vector<double>& consistency_limits,
+                                           std::vector<double>& solution, const IKCallbackFn& solution_callback,
+                                           moveit_msgs::MoveItErrorCodes& error_code,
+                                           const kinematics::KinematicsQueryOptions& options,
+                                           SolverWorkspace& workspace) const
 {
   ros::WallTime start_time = ros::WallTime::now();
   if (!initialized_)
@@ -336,7 +420,8 @@ bool KDLKinematicsPlugin::searchPositionIK(const geometry_msgs::Pose& ik_pose, c
   }
 
   // Resize consistency limits to remove mimic joints
-  std::vector<double> consistency_limits_mimic;
+  std::vector<double>& consistency_limits_mimic = workspace.consistency_limits_mimic;
+  consistency_limits_mimic.clear();
   if (!consistency_limits.empty())
   {
     if (consistency_limits.size() != dimension_)
@@ -357,13 +442,12 @@ bool KDLKinematicsPlugin::searchPositionIK(const geometry_msgs::Pose& ik_pose, c
   cartesian_weights.topRows<3>().setConstant(1.0);
   cartesian_weights.bottomRows<3>().setConstant(orientation_vs_position_weight_);
 
-  KDL::JntArray jnt_seed_state(dimension_);
-  KDL::JntArray jnt_pos_in(dimension_);
-  KDL::JntArray jnt_pos_out(dimension_);
+  KDL::JntArray& jnt_seed_state = workspace.jnt_seed_state;
+  KDL::JntArray& jnt_pos_in = workspace.jnt_pos_in;
+  KDL::JntArray& jnt_pos_out = workspace.jnt_pos_out;
   jnt_seed_state.data = Eigen::Map<const Eigen::VectorXd>(ik_seed_state.data(), ik_seed_state.size());
   jnt_pos_in = jnt_seed_state;
 
-  KDL::ChainIkSolverVelMimicSVD ik_solver_vel(kdl_chain_, mimic_joints_, orientation_vs_position_weight_ == 0.0);
   solution.resize(dimension_);
 
   KDL::Frame pose_desired;
@@ -381,15 +465,15 @@ bool KDLKinematicsPlugin::searchPositionIK(const geometry_msgs::Pose& ik_pose, c
     if (attempt > 1)  // randomly re-seed after first attempt
     {
       if (!consistency_limits_mimic.empty())
-        getRandomConfiguration(jnt_seed_state.data, consistency_limits_mimic, jnt_pos_in.data);
+        getRandomConfiguration(workspace.state, jnt_seed_state.data, consistency_limits_mimic, jnt_pos_in.data);
       else
-        getRandomConfiguration(jnt_pos_in.data);
+        getRandomConfiguration(workspace.state, jnt_pos_in.data);
       ROS_DEBUG_STREAM_NAMED("kdl", "New random configuration (" << attempt << "): " << jnt_pos_in);
     }
 
-    int ik_valid =
-        CartToJnt(ik_solver_vel, jnt_pos_in, pose_desired, jnt_pos_out, max_solver_iterations_,
-                  Eigen::Map<const Eigen::VectorXd>(joint_weights_.data(), joint_weights_.size()), cartesian_weights);
+    int ik_valid = CartToJnt(workspace.fk_solver, workspace.ik_solver_vel, workspace.buffers, jnt_pos_in,
+                             pose_desired, jnt_pos_out, max_solver_iterations_, workspace.joint_weights,
+                             cartesian_weights);
     if (ik_valid == 0 || options.return_approximate_solution)  // found acceptable solution
     {
       if (!consistency_limits_mimic.empty() &&
@@ -422,13 +506,24 @@ bool KDLKinematicsPlugin::searchPositionIK(const geometry_msgs::Pose& ik_pose, c
 int KDLKinematicsPlugin::CartToJnt(KDL::ChainIkSolverVelMimicSVD& ik_solver, const KDL::JntArray& q_init,
                                    const KDL::Frame& p_in, KDL::JntArray& q_out, const unsigned int max_iter,
                                    const Eigen::VectorXd& joint_weights, const Twist& cartesian_weights) const
+{
+  IterationBuffers buffers(q_out.rows());
+  return CartToJnt(*fk_solver_, ik_solver, buffers, q_init, p_in, q_out, max_iter, joint_weights, cartesian_weights);
+}
+
+// NOLINTNEXTLINE(readability-identifier-naming)
+int KDLKinematicsPlugin::CartToJnt(KDL::ChainFkSolverPos& fk_solver, KDL::ChainIkSolverVelMimicSVD& ik_solver,
+                                   IterationBuffers& buffers, const KDL::JntArray& q_init, const KDL::Frame& p_in,
+                                   KDL::JntArray& q_out, const unsigned int max_iter,
+                                   const Eigen::VectorXd& joint_weights, const Twist& cartesian_weights) const
 {
   double last_delta_twist_norm = DBL_MAX;
   double step_size = 1.0;
   KDL::Frame f;
   KDL::Twist delta_twist;
-  KDL::JntArray delta_q(q_out.rows()), q_backup(q_out.rows());
-  Eigen::ArrayXd extra_joint_weights(joint_weights.rows());
+  KDL::JntArray& delta_q = buffers.delta_q;
+  KDL::JntArray& q_backup = buffers.q_backup;
+  Eigen::ArrayXd& extra_joint_weights = buffers.extra_joint_weights;
   extra_joint_weights.setOnes();
 
   q_out = q_init;
@@ -438,7 +533,7 @@ int KDLKinematicsPlugin::CartToJnt(KDL::ChainIkSolverVelMimicSVD& ik_solver, con
   bool success = false;
   for (i = 0; i < max_iter; ++i)
   {
-    fk_solver_->JntToCart(q_out, f);
+    fk_solver.JntToCart(q_out, f);
     delta_twist = diff(f, p_in);
     ROS_DEBUG_STREAM_NAMED("kdl", "[" << std::setw(3) << i << "] delta_twist: " << delta_twist);
 
@@ -468,7 +563,8 @@ int KDLKinematicsPlugin::CartToJnt(KDL::ChainIkSolverVelMimicSVD& ik_solver, con
       step_size = 1.0;   // reset step size
       last_delta_twist_norm = delta_twist_norm;
 
-      ik_solver.CartToJnt(q_out, delta_twist, delta_q, extra_joint_weights * joint_weights.array(), cartesian_weights);
+      buffers.weights.array() = extra_joint_weights * joint_weights.array();
+      ik_solver.CartToJnt(q_out, delta_twist, delta_q, buffers.weights, cartesian_weights);
     }
 
     clipToJointLimits(q_out, delta_q, extra_joint_weights);
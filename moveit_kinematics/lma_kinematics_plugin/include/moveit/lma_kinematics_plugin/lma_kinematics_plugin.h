@@ -60,12 +60,29 @@
 namespace lma_kinematics_plugin
 {
 /**
- * @brief Implementation of kinematics using Levenberg-Marquardt (LMA) solver from KDL.
+ * @brief Implementation of kinematics using a Levenberg-Marquardt (LMA) solver.
  * This version supports any kinematic chain without mimic joints.
+ *
+ * Each iteration updates the link transforms of a RobotState once and derives both the tip pose and the Jacobian
+ * from them. The last solution of each workspace is used as a warm start for queries close to the last solved pose.
  */
 class LMAKinematicsPlugin : public kinematics::KinematicsBase
 {
 public:
+  /** @brief When the Levenberg-Marquardt iteration stops. The members are read from the parameters named in
+   *  their documentation. */
+  struct TerminationCriteria
+  {
+    /** "max_solver_iterations": maximum number of iterations per attempt */
+    int max_iterations = 500;
+    /** "epsilon": converged when the norm of the weighted pose error falls below this value */
+    double epsilon = 1e-5;
+    /** "epsilon_joints": give up the attempt when a step changes the joints by less than this norm */
+    double epsilon_joints = 1e-15;
+    /** "max_damping": give up the attempt when the damping has to be raised above this value to make progress */
+    double max_damping = 1e9;
+  };
+
   /**
    *  @brief Default constructor
    */
@@ -98,6 +115,12 @@ public:
       const IKCallbackFn& solution_callback, moveit_msgs::MoveItErrorCodes& error_code,
       const kinematics::KinematicsQueryOptions& options = kinematics::KinematicsQueryOptions()) const override;
 
+  bool searchPositionIKBatch(const std::vector<geometry_msgs::Pose>& ik_poses,
+                             const std::vector<double>& ik_seed_states, double timeout, std::vector<double>& solutions,
+                             std::vector<bool>& found,
+                             const kinematics::KinematicsQueryOptions& options = kinematics::KinematicsQueryOptions(),
+                             unsigned int threads = 1) const override;
+
   bool getPositionFK(const std::vector<std::string>& link_names, const std::vector<double>& joint_angles,
                      std::vector<geometry_msgs::Pose>& poses) const override;
 
@@ -115,7 +138,33 @@ public:
    */
   const std::vector<std::string>& getLinkNames() const override;
 
+  const TerminationCriteria& getTerminationCriteria() const
+  {
+    return termination_;
+  }
+
+  /** @brief Change the termination criteria. Must not be called concurrently with IK queries. */
+  void setTerminationCriteria(const TerminationCriteria& termination)
+  {
+    termination_ = termination;
+  }
+
 private:
+  /// Random state, link transforms, linear algebra buffers and warm start of one thread of queries,
+  /// defined in the source file
+  struct SolverWorkspace;
+  std::shared_ptr<SolverWorkspace> createWorkspace() const;
+
+  /** @brief Run Levenberg-Marquardt from @a q_init towards @a target (relative to the Jacobian reference frame).
+   *  @return true if the iteration converged; @a q_out holds the last iterate either way */
+  bool solveLMA(SolverWorkspace& workspace, const Eigen::Isometry3d& target, const Eigen::VectorXd& q_init,
+                Eigen::VectorXd& q_out) const;
+
+  /** @brief Set the group to @a q and return the weighted error twist from its tip pose to @a target */
+  Eigen::Matrix<double, 6, 1> computeError(SolverWorkspace& workspace, const Eigen::Isometry3d& target,
+                                           const Eigen::VectorXd& q) const;
+
+
   bool timedOut(const ros::WallTime& start_time, double duration) const;
 
   /** @brief Check whether the solution lies within the consistency limits of the seed state
@@ -131,15 +180,26 @@ private:
   /** Harmonize revolute joint values into the range -2 Pi .. 2 Pi */
   void harmonize(Eigen::VectorXd& values) const;
 
-  void getRandomConfiguration(Eigen::VectorXd& jnt_array) const;
+  /** @brief Implementation of searchPositionIK(). The workspace is passed in, so that searchPositionIKBatch()
+   *  can solve poses concurrently with one workspace per thread. */
+  bool searchPositionIK(const geometry_msgs::Pose& ik_pose, const std::vector<double>& ik_seed_state, double timeout,
+                        const std::vector<double>& consistency_limits, std::vector<double>& solution,
+                        const IKCallbackFn& solution_callback, moveit_msgs::MoveItErrorCodes& error_code,
+                        const kinematics::KinematicsQueryOptions& options, SolverWorkspace& workspace) const;
+
+  /** Cartesian weights passed to the LMA solver, derived from orientation_vs_position_weight_ */
+  Eigen::Matrix<double, 6, 1> getCartesianWeights() const;
+
+  void getRandomConfiguration(moveit::core::RobotState& state, Eigen::VectorXd& jnt_array) const;
 
   /** @brief Get a random configuration within consistency limits close to the seed state
+   *  @param state State providing the random number generator
    *  @param seed_state Seed state
    *  @param consistency_limits
    *  @param jnt_array Returned random configuration
    */
-  void getRandomConfiguration(const Eigen::VectorXd& seed_state, const std::vector<double>& consistency_limits,
-                              Eigen::VectorXd& jnt_array) const;
+  void getRandomConfiguration(moveit::core::RobotState& state, const Eigen::VectorXd& seed_state,
+                              const std::vector<double>& consistency_limits, Eigen::VectorXd& jnt_array) const;
 
   bool initialized_;  ///< Internal variable that indicates whether solver is configured and ready
 
@@ -147,14 +207,18 @@ private:
   moveit_msgs::KinematicSolverInfo solver_info_;  ///< Stores information for the inverse kinematics solver
 
   const moveit::core::JointModelGroup* joint_model_group_;
-  moveit::core::RobotStatePtr state_;
   KDL::Chain kdl_chain_;
   std::unique_ptr<KDL::ChainFkSolverPos> fk_solver_;
+  std::shared_ptr<SolverWorkspace> workspace_;  ///< used by searchPositionIK(), created at initialize()
   std::vector<const moveit::core::JointModel*> joints_;
   std::vector<std::string> joint_names_;
+  const moveit::core::LinkModel* base_link_;
+  const moveit::core::LinkModel* tip_link_;
 
-  int max_solver_iterations_;
-  double epsilon_;
+  TerminationCriteria termination_;
+  /** queries whose pose is within this distance (meters plus radians) of the last solved pose of a workspace
+   *  start from its solution before trying the seed state; 0 disables the warm start */
+  double warm_start_distance_;
   /** weight of orientation error vs position error
    *
    * < 1.0: orientation has less importance than position
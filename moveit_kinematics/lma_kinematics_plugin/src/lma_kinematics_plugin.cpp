@@ -35,8 +35,9 @@
 /* Author: Francisco Suarez-Ruiz */
 
 #include <moveit/lma_kinematics_plugin/lma_kinematics_plugin.h>
+#include <moveit/robot_model/chain_jacobian.h>
 #include <kdl/chainfksolverpos_recursive.hpp>
-#include <kdl/chainiksolverpos_lma.hpp>
+#include <Eigen/Cholesky>
 
 #include <tf2_kdl/tf2_kdl.h>
 #include <kdl_parser/kdl_parser.hpp>
@@ -49,24 +50,74 @@ CLASS_LOADER_REGISTER_CLASS(lma_kinematics_plugin::LMAKinematicsPlugin, kinemati
 
 namespace lma_kinematics_plugin
 {
-LMAKinematicsPlugin::LMAKinematicsPlugin() : initialized_(false)
+struct LMAKinematicsPlugin::SolverWorkspace
+{
+  SolverWorkspace(const moveit::core::RobotModelConstPtr& robot_model, unsigned int dimension)
+    : state(robot_model)
+    , jacobian(6, dimension)
+    , hessian(dimension, dimension)
+    , system(dimension, dimension)
+    , ldlt(dimension)
+    , gradient(dimension)
+    , delta_q(dimension)
+    , q_trial(dimension)
+    , seed(dimension)
+    , q_init(dimension)
+    , q_out(dimension)
+    , last_solution(dimension)
+  {
+    // variables outside of the group only affect the constant transform to the reference frame
+    state.setToDefaultValues();
+  }
+
+  moveit::core::RobotState state;  ///< transforms of the current iterate; random number generator for restarts
+  Eigen::Isometry3d reference;     ///< transform from the model frame to the Jacobian reference frame
+  moveit::core::chain_jacobian::Matrix6Xd jacobian;
+  Eigen::MatrixXd hessian;  ///< Gauss-Newton approximation J^T * J of the weighted Jacobian
+  Eigen::MatrixXd system;   ///< damped hessian
+  Eigen::LDLT<Eigen::MatrixXd> ldlt;
+  Eigen::VectorXd gradient;
+  Eigen::VectorXd delta_q;
+  Eigen::VectorXd q_trial;
+  Eigen::VectorXd seed;
+  Eigen::VectorXd q_init;
+  Eigen::VectorXd q_out;
+
+  bool has_last_solution = false;
+  Eigen::Isometry3d last_target;  ///< last solved target, relative to the reference frame
+  Eigen::VectorXd last_solution;
+};
+
+LMAKinematicsPlugin::LMAKinematicsPlugin() : initialized_(false), base_link_(nullptr), tip_link_(nullptr)
 {
 }
 
-void LMAKinematicsPlugin::getRandomConfiguration(Eigen::VectorXd& jnt_array) const
+void LMAKinematicsPlugin::getRandomConfiguration(moveit::core::RobotState& state, Eigen::VectorXd& jnt_array) const
 {
-  state_->setToRandomPositions(joint_model_group_);
-  state_->copyJointGroupPositions(joint_model_group_, &jnt_array[0]);
+  state.setToRandomPositions(joint_model_group_);
+  state.copyJointGroupPositions(joint_model_group_, &jnt_array[0]);
 }
 
-void LMAKinematicsPlugin::getRandomConfiguration(const Eigen::VectorXd& seed_state,
+void LMAKinematicsPlugin::getRandomConfiguration(moveit::core::RobotState& state, const Eigen::VectorXd& seed_state,
                                                  const std::vector<double>& consistency_limits,
                                                  Eigen::VectorXd& jnt_array) const
 {
-  joint_model_group_->getVariableRandomPositionsNearBy(state_->getRandomNumberGenerator(), &jnt_array[0],
+  joint_model_group_->getVariableRandomPositionsNearBy(state.getRandomNumberGenerator(), &jnt_array[0],
                                                        &seed_state[0], consistency_limits);
 }
 
+Eigen::Matrix<double, 6, 1> LMAKinematicsPlugin::getCartesianWeights() const
+{
+  Eigen::Matrix<double, 6, 1> cartesian_weights;
+  cartesian_weights(0) = 1;
+  cartesian_weights(1) = 1;
+  cartesian_weights(2) = 1;
+  cartesian_weights(3) = orientation_vs_position_weight_;
+  cartesian_weights(4) = orientation_vs_position_weight_;
+  cartesian_weights(5) = orientation_vs_position_weight_;
+  return cartesian_weights;
+}
+
 bool LMAKinematicsPlugin::checkConsistency(const Eigen::VectorXd& seed_state,
                                            const std::vector<double>& consistency_limits,
                                            const Eigen::VectorXd& solution) const
@@ -119,10 +170,28 @@ bool LMAKinematicsPlugin::initialize(const moveit::core::RobotModel& robot_model
     }
   }
   dimension_ = joints_.size();
+  if (dimension_ != joint_model_group_->getVariableCount())
+  {
+    ROS_ERROR_NAMED("lma", "Group '%s' includes mimic joints, which are not supported", group_name.c_str());
+    return false;
+  }
+
+  base_link_ = robot_model_->getLinkModel(base_frame_);
+  tip_link_ = robot_model_->getLinkModel(getTipFrame());
+  if (!base_link_ || !tip_link_)
+  {
+    ROS_ERROR_NAMED("lma", "Base frame '%s' or tip frame '%s' is not a link of the robot model", base_frame_.c_str(),
+                    getTipFrame().c_str());
+    return false;
+  }
 
   // Get Solver Parameters
-  lookupParam("max_solver_iterations", max_solver_iterations_, 500);
-  lookupParam("epsilon", epsilon_, 1e-5);
+  const TerminationCriteria defaults;
+  lookupParam("max_solver_iterations", termination_.max_iterations, defaults.max_iterations);
+  lookupParam("epsilon", termination_.epsilon, defaults.epsilon);
+  lookupParam("epsilon_joints", termination_.epsilon_joints, defaults.epsilon_joints);
+  lookupParam("max_damping", termination_.max_damping, defaults.max_damping);
+  lookupParam("warm_start_distance", warm_start_distance_, 0.05);
   lookupParam("orientation_vs_position", orientation_vs_position_weight_, 0.01);
 
   bool position_ik;
@@ -132,10 +201,9 @@ bool LMAKinematicsPlugin::initialize(const moveit::core::RobotModel& robot_model
   if (orientation_vs_position_weight_ == 0.0)
     ROS_INFO_NAMED("lma", "Using position only ik");
 
-  // Setup the joint state groups that we need
-  state_ = std::make_shared<moveit::core::RobotState>(robot_model_);
-
   fk_solver_ = std::make_unique<KDL::ChainFkSolverPos_recursive>(kdl_chain_);
+  // Setup the state and buffers used for solving
+  workspace_ = createWorkspace();
 
   initialized_ = true;
   ROS_DEBUG_NAMED("lma", "LMA solver initialized");
@@ -210,6 +278,127 @@ bool LMAKinematicsPlugin::searchPositionIK(const geometry_msgs::Pose& ik_pose, c
                                            std::vector<double>& solution, const IKCallbackFn& solution_callback,
                                            moveit_msgs::MoveItErrorCodes& error_code,
                                            const kinematics::KinematicsQueryOptions& options) const
+{
+  if (!initialized_)
+  {
+    ROS_ERROR_NAMED("lma", "kinematics solver not initialized");
+    error_code.val = error_code.NO_IK_SOLUTION;
+    return false;
+  }
+
+  return searchPositionIK(ik_pose, ik_seed_state, timeout, consistency_limits, solution, solution_callback, error_code,
+                          options, *workspace_);
+}
+
+std::shared_ptr<LMAKinematicsPlugin::SolverWorkspace> LMAKinematicsPlugin::createWorkspace() const
+{
+  return std::make_shared<SolverWorkspace>(robot_model_, dimension_);
+}
+
+bool LMAKinematicsPlugin::searchPositionIKBatch(const std::vector<geometry_msgs::Pose>& ik_poses,
+                                                const std::vector<double>& ik_seed_states, double timeout,
+                                                std::vector<double>& solutions, std::vector<bool>& found,
+                                                const kinematics::KinematicsQueryOptions& options,
+                                                unsigned int threads) const
+{
+  if (!initialized_)
+  {
+    ROS_ERROR_NAMED("lma", "kinematics solver not initialized");
+    found.assign(ik_poses.size(), false);
+    return false;
+  }
+
+  return solveIKBatch(ik_poses, ik_seed_states, solutions, found, threads, [this, timeout, &options]() -> BatchSolveFn {
+    // the workspace is set up once per thread, so consecutive nearby poses also share its warm start
+    std::shared_ptr<SolverWorkspace> workspace = createWorkspace();
+    return [this, timeout, &options, workspace](const geometry_msgs::Pose& ik_pose,
+                                                const std::vector<double>& ik_seed_state,
+                                                std::vector<double>& solution) {
+      moveit_msgs::MoveItErrorCodes error_code;
+      return searchPositionIK(ik_pose, ik_seed_state, timeout, std::vector<double>(), solution, IKCallbackFn(),
+                              error_code, options, *workspace);
+    };
+  });
+}
+
+Eigen::Matrix<double, 6, 1> LMAKinematicsPlugin::computeError(SolverWorkspace& workspace,
+                                                              const Eigen::Isometry3d& target,
+                                                              const Eigen::VectorXd& q) const
+{
+  workspace.state.setJointGroupPositions(joint_model_group_, q);
+  workspace.state.updateLinkTransforms();
+  const Eigen::Isometry3d tip = workspace.reference * workspace.state.getGlobalLinkTransform(tip_link_);
+
+  Eigen::Matrix<double, 6, 1> error;
+  error.head<3>() = target.translation() - tip.translation();
+  const Eigen::AngleAxisd rotation_error(target.linear() * tip.linear().transpose());
+  error.tail<3>() = rotation_error.angle() * rotation_error.axis();
+  return error.cwiseProduct(getCartesianWeights());
+}
+
+bool LMAKinematicsPlugin::solveLMA(SolverWorkspace& workspace, const Eigen::Isometry3d& target,
+                                   const Eigen::VectorXd& q_init, Eigen::VectorXd& q_out) const
+{
+  const auto get_link_transform = [&workspace](const moveit::core::LinkModel* link) -> const Eigen::Isometry3d& {
+    return workspace.state.getGlobalLinkTransform(link);
+  };
+  const Eigen::Matrix<double, 6, 1> cartesian_weights = getCartesianWeights();
+
+  q_out = q_init;
+  Eigen::Matrix<double, 6, 1> error = computeError(workspace, target, q_out);
+  double error_norm = error.norm();
+  bool linearized = false;
+  double damping = 1e-3;
+  for (int i = 0; i < termination_.max_iterations && error_norm >= termination_.epsilon; ++i)
+  {
+    if (!linearized)
+    {
+      // the state still holds the transforms of q_out, so the Jacobian costs no further forward kinematics
+      if (!moveit::core::chain_jacobian::compute(joint_model_group_, tip_link_, Eigen::Vector3d::Zero(),
+                                                 get_link_transform, workspace.jacobian))
+        return false;
+      workspace.jacobian.array().colwise() *= cartesian_weights.array();
+      workspace.hessian.noalias() = workspace.jacobian.transpose() * workspace.jacobian;
+      workspace.gradient.noalias() = workspace.jacobian.transpose() * error;
+      linearized = true;
+    }
+
+    workspace.system = workspace.hessian;
+    workspace.system.diagonal().array() += damping;
+    workspace.ldlt.compute(workspace.system);
+    workspace.delta_q = workspace.ldlt.solve(workspace.gradient);
+    if (workspace.delta_q.norm() < termination_.epsilon_joints)
+      return false;
+
+    workspace.q_trial = q_out + workspace.delta_q;
+    const Eigen::Matrix<double, 6, 1> trial_error = computeError(workspace, target, workspace.q_trial);
+    const double trial_error_norm = trial_error.norm();
+    if (trial_error_norm < error_norm)
+    {
+      // accept the step and move towards Gauss-Newton
+      q_out.swap(workspace.q_trial);
+      error = trial_error;
+      error_norm = trial_error_norm;
+      damping = std::max(damping * 0.1, 1e-12);
+      linearized = false;
+    }
+    else
+    {
+      // reject the step and move towards gradient descent
+      damping *= 10.0;
+      if (damping > termination_.max_damping)
+        return false;
+    }
+  }
+  return error_norm < termination_.epsilon;
+}
+
+bool LMAKinematicsPlugin::searchPositionIK(const geometry_msgs::Pose& ik_pose, const std::vector<double>& ik_seed_state,
+                                           double timeout, const std::vector<double>& consistency_limits,
+                                           std::vector<double>& solution, const IKCallbackFn& solution_callback,
+                                           moveit_msgs::MoveItErrorCodes& error_code,
+                                           const kinematics::KinematicsQueryOptions& options,
+                                           SolverWorkspace& workspace) const
 {
   ros::WallTime start_time = ros::WallTime::now();
   if (!initialized_)
@@ -235,53 +424,68 @@ bool LMAKinematicsPlugin::searchPositionIK(const geometry_msgs::Pose& ik_pose, c
     return false;
   }
 
-  Eigen::Matrix<double, 6, 1> cartesian_weights;
-  cartesian_weights(0) = 1;
-  cartesian_weights(1) = 1;
-  cartesian_weights(2) = 1;
-  cartesian_weights(3) = orientation_vs_position_weight_;
-  cartesian_weights(4) = orientation_vs_position_weight_;
-  cartesian_weights(5) = orientation_vs_position_weight_;
+  Eigen::VectorXd& seed = workspace.seed;
+  Eigen::VectorXd& q_init = workspace.q_init;
+  Eigen::VectorXd& q_out = workspace.q_out;
+  seed = Eigen::Map<const Eigen::VectorXd>(ik_seed_state.data(), ik_seed_state.size());
 
-  KDL::JntArray jnt_seed_state(dimension_);
-  KDL::JntArray jnt_pos_in(dimension_);
-  KDL::JntArray jnt_pos_out(dimension_);
-  jnt_seed_state.data = Eigen::Map<const Eigen::VectorXd>(ik_seed_state.data(), ik_seed_state.size());
-  jnt_pos_in = jnt_seed_state;
-
-  KDL::ChainIkSolverPos_LMA ik_solver_pos(kdl_chain_, cartesian_weights, epsilon_, max_solver_iterations_);
   solution.resize(dimension_);
 
-  KDL::Frame pose_desired;
-  tf2::fromMsg(ik_pose, pose_desired);
+  // express the target in the frame the Jacobian is computed in
+  const auto get_link_transform = [&workspace](const moveit::core::LinkModel* link) -> const Eigen::Isometry3d& {
+    return workspace.state.getGlobalLinkTransform(link);
+  };
+  workspace.state.updateLinkTransforms();
+  workspace.reference = moveit::core::chain_jacobian::getReferenceTransform(joint_model_group_, get_link_transform);
+  const Eigen::Isometry3d target =
+      workspace.reference * get_link_transform(base_link_) * Eigen::Translation3d(ik_pose.position.x, ik_pose.position.y, ik_pose.position.z) *
+      Eigen::Quaterniond(ik_pose.orientation.w, ik_pose.orientation.x, ik_pose.orientation.y, ik_pose.orientation.z)
+          .normalized();
+
+  // start from the last solution if this query is close to the last solved one; the consistency limits refer to
+  // the seed state, so they rule out the warm start
+  bool warm_start = false;
+  if (workspace.has_last_solution && consistency_limits.empty() && warm_start_distance_ > 0.0)
+  {
+    const double distance =
+        (target.translation() - workspace.last_target.translation()).norm() +
+        Eigen::AngleAxisd(target.linear() * workspace.last_target.linear().transpose()).angle();
+    warm_start = distance < warm_start_distance_;
+  }
 
   ROS_DEBUG_STREAM_NAMED("lma", "searchPositionIK2: Position request pose is "
                                     << ik_pose.position.x << " " << ik_pose.position.y << " " << ik_pose.position.z
                                     << " " << ik_pose.orientation.x << " " << ik_pose.orientation.y << " "
                                     << ik_pose.orientation.z << " " << ik_pose.orientation.w);
+  // the seed state is tried even if the timeout expired during the warm start attempt
+  const unsigned int first_random_attempt = warm_start ? 3 : 2;
   unsigned int attempt = 0;
   do
   {
     ++attempt;
-    if (attempt > 1)  // randomly re-seed after first attempt
+    if (attempt == 1)
+      q_init = warm_start ? workspace.last_solution : seed;
+    else if (attempt < first_random_attempt)
+      q_init = seed;
+    else  // randomly re-seed after the warm start and the seed state
     {
       if (!consistency_limits.empty())
-        getRandomConfiguration(jnt_seed_state.data, consistency_limits, jnt_pos_in.data);
+        getRandomConfiguration(workspace.state, seed, consistency_limits, q_init);
       else
-        getRandomConfiguration(jnt_pos_in.data);
-      ROS_DEBUG_STREAM_NAMED("lma", "New random configuration (" << attempt << "): " << jnt_pos_in);
+        getRandomConfiguration(workspace.state, q_init);
+      ROS_DEBUG_STREAM_NAMED("lma", "New random configuration (" << attempt << "): " << q_init.transpose());
     }
 
-    int ik_valid = ik_solver_pos.CartToJnt(jnt_pos_in, pose_desired, jnt_pos_out);
-    if (ik_valid == 0 || options.return_approximate_solution)  // found acceptable solution
+    bool ik_valid = solveLMA(workspace, target, q_init, q_out);
+    if (ik_valid || options.return_approximate_solution)  // found acceptable solution
     {
-      harmonize(jnt_pos_out.data);
-      if (!consistency_limits.empty() && !checkConsistency(jnt_seed_state.data, consistency_limits, jnt_pos_out.data))
+      harmonize(q_out);
+      if (!consistency_limits.empty() && !checkConsistency(seed, consistency_limits, q_out))
         continue;
-      if (!obeysLimits(jnt_pos_out.data))
+      if (!obeysLimits(q_out))
         continue;
 
-      Eigen::Map<Eigen::VectorXd>(solution.data(), solution.size()) = jnt_pos_out.data;
+      Eigen::Map<Eigen::VectorXd>(solution.data(), solution.size()) = q_out;
       if (!solution_callback.empty())
       {
         solution_callback(ik_pose, solution, error_code);
@@ -290,12 +494,15 @@ bool LMAKinematicsPlugin::searchPositionIK(const geometry_msgs::Pose& ik_pose, c
       }
 
       // solution passed consistency check and solution callback
+      workspace.has_last_solution = true;
+      workspace.last_target = target;
+      workspace.last_solution = q_out;
       error_code.val = error_code.SUCCESS;
       ROS_DEBUG_STREAM_NAMED("lma", "Solved after " << (ros::WallTime::now() - start_time).toSec() << " < " << timeout
                                                     << "s and " << attempt << " attempts");
       return true;
     }
-  } while (!timedOut(start_time, timeout));
+  } while (attempt + 1 < first_random_attempt || !timedOut(start_time, timeout));
 
   ROS_DEBUG_STREAM_NAMED("lma", "IK timed out after " << (ros::WallTime::now() - start_time).toSec() << " > " << timeout
                                                       << "s and " << attempt << " attempts");
@@ -566,6 +566,49 @@ TEST_F(KinematicsTest, searchIK)
   EXPECT_GE(success, EXPECTED_SUCCESS_RATE * num_ik_tests_);
 }
 
+TEST_F(KinematicsTest, searchIKBatch)
+{
+  const std::size_t dof = kinematics_solver_->getJointNames().size();
+  const std::vector<std::string>& fk_names = kinematics_solver_->getTipFrames();
+  moveit::core::RobotState robot_state(robot_model_);
+  robot_state.setToDefaultValues();
+
+  std::vector<geometry_msgs::Pose> ik_poses;
+  std::vector<double> fk_values(dof, 0.0);
+  for (unsigned int i = 0; i < num_ik_tests_; ++i)
+  {
+    robot_state.setToRandomPositions(jmg_, this->rng_);
+    robot_state.copyJointGroupPositions(jmg_, fk_values);
+    std::vector<geometry_msgs::Pose> poses;
+    ASSERT_TRUE(kinematics_solver_->getPositionFK(fk_names, fk_values, poses));
+    ik_poses.push_back(poses[0]);
+  }
+
+  // a single seed of size dof is shared by all poses
+  std::vector<double> seed(dof, 0.0), solutions;
+  std::vector<bool> found;
+  kinematics_solver_->searchPositionIKBatch(ik_poses, seed, timeout_, solutions, found,
+                                            kinematics::KinematicsQueryOptions(), 0);
+  ASSERT_EQ(found.size(), ik_poses.size());
+  ASSERT_EQ(solutions.size(), ik_poses.size() * dof);
+
+  unsigned int success = 0;
+  for (std::size_t i = 0; i < ik_poses.size(); ++i)
+  {
+    if (!found[i])
+      continue;
+    success++;
+
+    std::vector<double> solution(solutions.begin() + i * dof, solutions.begin() + (i + 1) * dof);
+    std::vector<geometry_msgs::Pose> poses(1, ik_poses[i]), reached_poses;
+    kinematics_solver_->getPositionFK(fk_names, solution, reached_poses);
+    EXPECT_NEAR_POSES(poses, reached_poses, tolerance_);
+  }
+
+  ROS_INFO_STREAM("Success Rate: " << (double)success / num_ik_tests_);
+  EXPECT_GE(success, EXPECTED_SUCCESS_RATE * num_ik_tests_);
+}
+
 TEST_F(KinematicsTest, searchIKWithCallback)
 {
   std::vector<double> seed, fk_values, solution;
@@ -609,6 +652,55 @@ TEST_F(KinematicsTest, searchIKWithCallback)
   EXPECT_GE(success, EXPECTED_SUCCESS_RATE * num_ik_cb_tests_);
 }
 
+TEST_F(KinematicsTest, searchIKWithBatchCallback)
+{
+  std::vector<double> fk_values, solution;
+  moveit_msgs::MoveItErrorCodes error_code;
+  const std::vector<std::string>& fk_names = kinematics_solver_->getTipFrames();
+  moveit::core::RobotState robot_state(robot_model_);
+  robot_state.setToDefaultValues();
+
+  unsigned int success = 0;
+  for (unsigned int i = 0; i < num_ik_cb_tests_; ++i)
+  {
+    fk_values.resize(kinematics_solver_->getJointNames().size(), 0.0);
+    robot_state.setToRandomPositions(jmg_, this->rng_);
+    robot_state.copyJointGroupPositions(jmg_, fk_values);
+    std::vector<geometry_msgs::Pose> poses;
+    ASSERT_TRUE(kinematics_solver_->getPositionFK(fk_names, fk_values, poses));
+    if (poses[0].position.z <= 0.0f)
+    {
+      --i;  // draw a new random state
+      continue;
+    }
+
+    kinematics_solver_->searchPositionIKWithBatchCallback(
+        poses[0], fk_values, timeout_, std::vector<double>(), solution,
+        [this](const geometry_msgs::Pose& /*unused*/, const std::vector<std::vector<double>>& candidates,
+               std::vector<bool>& valid) {
+          ASSERT_EQ(candidates.size(), valid.size());
+          for (std::size_t c = 0; c < candidates.size(); ++c)
+          {
+            moveit_msgs::MoveItErrorCodes candidate_error_code;
+            searchIKCallback(candidates[c], candidate_error_code);
+            valid[c] = candidate_error_code.val == candidate_error_code.SUCCESS;
+          }
+        },
+        error_code);
+    if (error_code.val == error_code.SUCCESS)
+      success++;
+    else
+      continue;
+
+    std::vector<geometry_msgs::Pose> reached_poses;
+    kinematics_solver_->getPositionFK(fk_names, solution, reached_poses);
+    EXPECT_NEAR_POSES(poses, reached_poses, tolerance_);
+  }
+
+  ROS_INFO_STREAM("Success Rate: " << (double)success / num_ik_cb_tests_);
+  EXPECT_GE(success, EXPECTED_SUCCESS_RATE * num_ik_cb_tests_);
+}
+
 TEST_F(KinematicsTest, getIK)
 {
   std::vector<double> fk_values, solution;
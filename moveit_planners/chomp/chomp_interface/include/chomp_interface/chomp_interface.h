@@ -47,7 +47,8 @@ MOVEIT_CLASS_FORWARD(CHOMPInterface);  // Defines CHOMPInterfacePtr, ConstPtr, W
 class CHOMPInterface : public chomp::ChompPlanner
 {
 public:
-  CHOMPInterface(const ros::NodeHandle& nh = ros::NodeHandle("~"));
+  /** @param use_stomp optimize with noisy rollouts (STOMP) instead of CHOMP's covariant gradient */
+  CHOMPInterface(const ros::NodeHandle& nh = ros::NodeHandle("~"), bool use_stomp = false);
 
   const chomp::ChompParameters& getParams() const
   {
@@ -53,7 +53,7 @@ public:
   bool terminate() override;
 
   CHOMPPlanningContext(const std::string& name, const std::string& group, const moveit::core::RobotModelConstPtr& model,
-                       ros::NodeHandle& nh);
+                       ros::NodeHandle& nh, bool use_stomp = false);
 
   ~CHOMPPlanningContext() override = default;
 
@@ -38,9 +38,13 @@
 
 namespace chomp_interface
 {
-CHOMPInterface::CHOMPInterface(const ros::NodeHandle& nh) : ChompPlanner(), nh_(nh)
+CHOMPInterface::CHOMPInterface(const ros::NodeHandle& nh, bool use_stomp) : ChompPlanner(), nh_(nh)
 {
   loadParams();
+  params_.use_stomp_ = use_stomp;
+  if (params_.trajectory_cache_size_ > 0)
+    setTrajectoryCache(std::make_shared<chomp::ChompTrajectoryCache>(params_.trajectory_cache_size_,
+                                                                     params_.trajectory_cache_tolerance_));
 }
 
 void CHOMPInterface::loadParams()
@@ -66,6 +70,7 @@ void CHOMPInterface::loadParams()
   nh_.param("collision_clearance", params_.min_clearance_, 0.2);
   nh_.param("collision_threshold", params_.collision_threshold_, 0.07);
   nh_.param("use_stochastic_descent", params_.use_stochastic_descent_, true);
+  nh_.param("num_threads", params_.num_threads_, 0);
   {
     params_.trajectory_initialization_method_ = "quintic-spline";
     std::string method;
@@ -75,5 +80,11 @@ void CHOMPInterface::loadParams()
   }
   nh_.param("enable_failure_recovery", params_.enable_failure_recovery_, false);
   nh_.param("max_recovery_attempts", params_.max_recovery_attempts_, 5);
+  nh_.param("trajectory_cache_size", params_.trajectory_cache_size_, 0);
+  nh_.param("trajectory_cache_tolerance", params_.trajectory_cache_tolerance_, 0.1);
+  nh_.param("stomp_num_rollouts", params_.stomp_num_rollouts_, 16);
+  nh_.param("stomp_noise_stddev", params_.stomp_noise_stddev_, 0.1);
+  nh_.param("stomp_noise_decay", params_.stomp_noise_decay_, 0.95);
+  nh_.param("stomp_cost_sensitivity", params_.stomp_cost_sensitivity_, 10.0);
 }
 }  // namespace chomp_interface
@@ -42,10 +42,11 @@
 namespace chomp_interface
 {
 CHOMPPlanningContext::CHOMPPlanningContext(const std::string& name, const std::string& group,
-                                           const moveit::core::RobotModelConstPtr& model, ros::NodeHandle& nh)
+                                           const moveit::core::RobotModelConstPtr& model, ros::NodeHandle& nh,
+                                           bool use_stomp)
   : planning_interface::PlanningContext(name, group), robot_model_(model)
 {
-  chomp_interface_ = std::make_shared<CHOMPInterface>(nh);
+  chomp_interface_ = std::make_shared<CHOMPInterface>(nh, use_stomp);
 }
 
 bool CHOMPPlanningContext::solve(planning_interface::MotionPlanDetailedResponse& res)
@@ -118,6 +118,37 @@ protected:
   std::map<std::string, CHOMPPlanningContextPtr> planning_contexts_;
 };
 
+/** \brief Plans like CHOMPPlannerManager, but optimizes with noisy rollouts evaluated in parallel (STOMP) */
+class STOMPPlannerManager : public CHOMPPlannerManager
+{
+public:
+  bool initialize(const moveit::core::RobotModelConstPtr& model, const std::string& ns) override
+  {
+    ros::NodeHandle nh("~");
+    if (!ns.empty())
+      nh = ros::NodeHandle(ns);
+
+    for (const std::string& group : model->getJointModelGroupNames())
+    {
+      planning_contexts_[group] =
+          std::make_shared<CHOMPPlanningContext>("stomp_planning_context", group, model, nh, true);
+    }
+    return true;
+  }
+
+  std::string getDescription() const override
+  {
+    return "STOMP";
+  }
+
+  void getPlanningAlgorithms(std::vector<std::string>& algs) const override
+  {
+    algs.resize(1);
+    algs[0] = "STOMP";
+  }
+};
+
 }  // namespace chomp_interface
 
 PLUGINLIB_EXPORT_CLASS(chomp_interface::CHOMPPlannerManager, planning_interface::PlannerManager);
+PLUGINLIB_EXPORT_CLASS(chomp_interface::STOMPPlannerManager, planning_interface::PlannerManager);
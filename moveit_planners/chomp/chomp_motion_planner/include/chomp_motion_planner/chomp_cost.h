@@ -37,13 +37,21 @@
 #pragma once
 
 #include <eigen3/Eigen/Core>
+#include <eigen3/Eigen/SparseCore>
+#include <eigen3/Eigen/SparseCholesky>
 #include <chomp_motion_planner/chomp_trajectory.h>
+#include <cmath>
+#include <memory>
 #include <vector>
 
 namespace chomp
 {
 /**
  * \brief Represents the smoothness cost for CHOMP, for a single joint
+ *
+ * The quadratic cost is banded, so it is stored sparse and its inverse is applied through a banded Cholesky
+ * factorization instead of a dense inverse. Memory and time per update grow linearly with the trajectory length. Copies
+ * of a cost share the factorization.
  */
 class ChompCost
 {
@@ -55,9 +63,18 @@ public:
   template <typename Derived>
   void getDerivative(const Eigen::MatrixXd::ColXpr& joint_trajectory, Eigen::MatrixBase<Derived>& derivative) const;
 
-  const Eigen::MatrixXd& getQuadraticCostInverse() const;
+  /** \brief Multiply \a rhs with the inverse of the quadratic cost of the free variables */
+  template <typename Derived>
+  Eigen::VectorXd applyQuadraticCostInverse(const Eigen::MatrixBase<Derived>& rhs) const;
+
+  /** \brief Map white noise \a rhs to a sample whose covariance is the inverse of the quadratic cost */
+  template <typename Derived>
+  Eigen::VectorXd getCorrelatedNoise(const Eigen::MatrixBase<Derived>& rhs) const;
+
+  /** \brief Get column \a index of the inverse of the quadratic cost of the free variables */
+  Eigen::VectorXd getQuadraticCostInverseColumn(int index) const;
 
-  const Eigen::MatrixXd& getQuadraticCost() const;
+  const Eigen::SparseMatrix<double>& getQuadraticCost() const;
 
   double getCost(const Eigen::MatrixXd::ColXpr& joint_trajectory) const;
 
@@ -66,12 +83,16 @@ public:
   void scale(double scale);
 
 private:
-  Eigen::MatrixXd quad_cost_full_;
-  Eigen::MatrixXd quad_cost_;
+  using Factorization = Eigen::SimplicialLLT<Eigen::SparseMatrix<double>, Eigen::Lower, Eigen::NaturalOrdering<int> >;
+
+  Eigen::SparseMatrix<double> quad_cost_full_;
+  Eigen::SparseMatrix<double> quad_cost_;
   // Eigen::VectorXd linear_cost_;
-  Eigen::MatrixXd quad_cost_inv_;
+  std::shared_ptr<const Factorization> quad_cost_llt_;  // of quad_cost_ before scaling
+  double quad_cost_inv_scale_;
+  double max_quad_cost_inv_value_;
 
-  Eigen::MatrixXd getDiffMatrix(int size, const double* diff_rule) const;
+  Eigen::SparseMatrix<double> getDiffMatrix(int size, const double* diff_rule) const;
 };
 
 template <typename Derived>
@@ -81,19 +102,29 @@ void ChompCost::getDerivative(const Eigen::MatrixXd::ColXpr& joint_trajectory,
   derivative = (quad_cost_full_ * (2.0 * joint_trajectory));
 }
 
-inline const Eigen::MatrixXd& ChompCost::getQuadraticCostInverse() const
+template <typename Derived>
+Eigen::VectorXd ChompCost::applyQuadraticCostInverse(const Eigen::MatrixBase<Derived>& rhs) const
+{
+  return quad_cost_inv_scale_ * quad_cost_llt_->solve(rhs.eval());
+}
+
+template <typename Derived>
+Eigen::VectorXd ChompCost::getCorrelatedNoise(const Eigen::MatrixBase<Derived>& rhs) const
 {
-  return quad_cost_inv_;
+  // with the cost L * L^T, the covariance of L^-T * rhs is the inverse of the cost
+  Eigen::VectorXd noise = rhs;
+  quad_cost_llt_->matrixU().solveInPlace(noise);
+  return std::sqrt(quad_cost_inv_scale_) * noise;
 }
 
-inline const Eigen::MatrixXd& ChompCost::getQuadraticCost() const
+inline const Eigen::SparseMatrix<double>& ChompCost::getQuadraticCost() const
 {
   return quad_cost_;
 }
 
 inline double ChompCost::getCost(const Eigen::MatrixXd::ColXpr& joint_trajectory) const
 {
-  return joint_trajectory.dot(quad_cost_full_ * joint_trajectory);
+  return joint_trajectory.dot((quad_cost_full_ * joint_trajectory).eval());
 }
 
 }  // namespace chomp
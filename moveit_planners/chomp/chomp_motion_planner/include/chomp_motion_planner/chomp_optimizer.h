@@ -81,34 +81,15 @@ public:
   }
 
 private:
-  inline double getPotential(double field_distance, double radius, double clearance)
-  {
-    double d = field_distance - radius;
-
-    if (d >= clearance)  // everything is fine
-    {
-      return 0.0;
-    }
-    else if (d >= 0.0)  // transition phase, no collision yet
-    {
-      const double diff = (d - clearance);
-      const double gradient_magnitude = diff / clearance;
-      return 0.5 * gradient_magnitude * diff;  // 0.5 * (d - clearance)^2 / clearance
-    }
-    else  // d < 0.0: collision
-    {
-      return -d + 0.5 * clearance;  // linearly increase, starting from 0.5 * clearance
-    }
-  }
   template <typename Derived>
-  void getJacobian(int trajectoryPoint, Eigen::Vector3d& collision_point_pos, std::string& jointName,
+  void getJacobian(int trajectoryPoint, const Eigen::Vector3d& collision_point_pos, int collision_point,
                    Eigen::MatrixBase<Derived>& jacobian) const;
 
   // void getRandomState(const moveit::core::RobotState& currentState,
   //                     const std::string& group_name,
   //                     Eigen::VectorXd& state_vec);
 
-  void setRobotStateFromPoint(ChompTrajectory& group_trajectory, int i);
+  void setRobotStateFromPoint(ChompTrajectory& group_trajectory, int i, moveit::core::RobotState& state) const;
 
   // collision_proximity::CollisionProximitySpace::TrajectorySafety checkCurrentIterValidity();
 
@@ -137,6 +118,13 @@ private:
   bool initialized_;
 
   std::vector<std::vector<std::string> > collision_point_joint_names_;
+  /// for each collision point, whether each joint of the group moves it (the Jacobian's non-zero columns)
+  std::vector<std::vector<int> > collision_point_moved_by_joint_;
+  /// the robot state and group state representation of each trajectory point, reused across iterations
+  std::vector<moveit::core::RobotState> point_states_;
+  std::vector<collision_detection::GroupStateRepresentationPtr> point_gsrs_;
+  /// the number of threads that evaluate trajectory points and joints
+  int num_threads_;
   std::vector<EigenSTL::vector_Vector3d> collision_point_pos_eigen_;
   std::vector<EigenSTL::vector_Vector3d> collision_point_vel_eigen_;
   std::vector<EigenSTL::vector_Vector3d> collision_point_acc_eigen_;
@@ -169,10 +157,6 @@ private:
   Eigen::MatrixXd final_increments_;
 
   // temporary variables for all functions:
-  Eigen::VectorXd smoothness_derivative_;
-  Eigen::MatrixXd jacobian_;
-  Eigen::MatrixXd jacobian_pseudo_inverse_;
-  Eigen::MatrixXd jacobian_jacobian_tranpose_;
   Eigen::VectorXd random_state_;
   Eigen::VectorXd joint_state_velocities_;
 
@@ -212,8 +196,7 @@ private:
   void getRandomMomentum();
   void updateMomentum();
   void updatePositionFromMomentum();
-  void calculatePseudoInverse();
-  void computeJointProperties(int trajectoryPoint);
+  void computeJointProperties(int trajectoryPoint, const moveit::core::RobotState& state);
   bool isCurrentTrajectoryMeshToMeshCollisionFree() const;
 };
 }  // namespace chomp
@@ -97,6 +97,16 @@ public:
                                   /// an initial path is not found with the specified chomp parameters
   int max_recovery_attempts_;     /// this the maximum recovery attempts to find a collision free path after an initial
                                   /// failure to find a solution
+  int num_threads_;  /// number of threads evaluating trajectory points in parallel, 0 uses all hardware threads
+
+  int trajectory_cache_size_;          /// number of solutions kept to warm-start similar requests, 0 disables the cache
+  double trajectory_cache_tolerance_;  /// maximum joint distance of start and goal to a cached solution to reuse it
+
+  bool use_stomp_;                 /// optimize with noisy rollouts (STOMP) instead of the covariant gradient of CHOMP
+  int stomp_num_rollouts_;         /// number of noisy trajectories evaluated in parallel per STOMP iteration
+  double stomp_noise_stddev_;      /// standard deviation of the rollout noise of the free trajectory points
+  double stomp_noise_decay_;       /// factor the rollout noise is scaled with after every STOMP iteration
+  double stomp_cost_sensitivity_;  /// sensitivity of the rollout weights to the rollout costs
 };
 
 }  // namespace chomp
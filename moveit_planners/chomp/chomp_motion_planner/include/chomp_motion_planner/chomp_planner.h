@@ -37,6 +37,7 @@
 #pragma once
 
 #include <chomp_motion_planner/chomp_parameters.h>
+#include <chomp_motion_planner/chomp_trajectory_cache.h>
 #include <moveit/planning_interface/planning_request.h>
 #include <moveit/planning_interface/planning_response.h>
 #include <moveit/planning_scene/planning_scene.h>
@@ -52,5 +53,19 @@ public:
   bool solve(const planning_scene::PlanningSceneConstPtr& planning_scene,
              const planning_interface::MotionPlanRequest& req, const ChompParameters& params,
              planning_interface::MotionPlanDetailedResponse& res) const;
+
+  /** \brief Warm-start requests from the solutions in \a cache and store successful solutions in it */
+  void setTrajectoryCache(const ChompTrajectoryCachePtr& cache)
+  {
+    trajectory_cache_ = cache;
+  }
+
+  const ChompTrajectoryCachePtr& getTrajectoryCache() const
+  {
+    return trajectory_cache_;
+  }
+
+private:
+  ChompTrajectoryCachePtr trajectory_cache_;
 };
 }  // namespace chomp
@@ -136,6 +136,14 @@ public:
    */
   bool fillInFromTrajectory(const robot_trajectory::RobotTrajectory& trajectory);
 
+  /**
+   * \brief Like fillInFromTrajectory(), but keeps the current start and goal points
+   *
+   * The offsets between them and the endpoints of \a trajectory are blended linearly along the path, so a solution of a
+   * nearby problem (e.g. a cached one) can seed the optimization.
+   */
+  bool warmStartFromTrajectory(const robot_trajectory::RobotTrajectory& trajectory);
+
   /**
    * \brief This function assigns the given \a source RobotState to the row at index \a chomp_trajectory_point
    *
@@ -0,0 +1,94 @@
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2026, PickNik LLC.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of PickNik LLC nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *********************************************************************/
+#pragma once
+
+#include <moveit/macros/class_forward.h>
+#include <moveit/planning_scene/planning_scene.h>
+#include <moveit/robot_trajectory/robot_trajectory.h>
+
+#include <list>
+#include <mutex>
+
+namespace chomp
+{
+MOVEIT_CLASS_FORWARD(ChompTrajectoryCache);  // Defines ChompTrajectoryCachePtr, ConstPtr, WeakPtr... etc
+
+/**
+ * \brief Stores recent CHOMP solutions to warm-start later requests with nearby start and goal states
+ *
+ * Entries are keyed on the planning group, the start and goal positions of the group and a hash of the collision
+ * world. A lookup matches when all joints of the start and the goal are within the tolerance of an entry; the closest
+ * match is returned. The least recently used entries are evicted once the cache is full. All methods are thread safe.
+ */
+class ChompTrajectoryCache
+{
+public:
+  ChompTrajectoryCache(std::size_t max_size = 64, double tolerance = 0.1);
+
+  /**
+   * \brief Find the cached solution closest to the given problem
+   * @return the cached trajectory, or nullptr if no entry is close enough
+   */
+  robot_trajectory::RobotTrajectoryConstPtr lookup(const planning_scene::PlanningScene& scene,
+                                                   const std::string& group_name,
+                                                   const moveit::core::RobotState& start_state,
+                                                   const moveit::core::RobotState& goal_state);
+
+  /** \brief Store \a trajectory as the solution from its first to its last waypoint in \a scene */
+  void insert(const planning_scene::PlanningScene& scene, const robot_trajectory::RobotTrajectoryConstPtr& trajectory);
+
+  void clear();
+
+  std::size_t size() const;
+
+  /** \brief Hash of the ids, poses and shapes of the world's collision objects */
+  static std::size_t getWorldHash(const planning_scene::PlanningScene& scene);
+
+private:
+  struct Entry
+  {
+    std::string group_name;
+    std::size_t world_hash;
+    std::vector<double> start;
+    std::vector<double> goal;
+    robot_trajectory::RobotTrajectoryConstPtr trajectory;
+  };
+
+  std::size_t max_size_;
+  double tolerance_;
+
+  mutable std::mutex lock_;
+  std::list<Entry> entries_;  // most recently used first
+};
+}  // namespace chomp
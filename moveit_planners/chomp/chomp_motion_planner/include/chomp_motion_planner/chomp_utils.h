@@ -84,4 +84,25 @@ static inline double shortestAngularDistance(double start, double end)
   return normalizeAngle(res);
 }
 
+/** \brief Obstacle potential of a collision sphere of \a radius at \a field_distance from the nearest obstacle */
+static inline double getObstaclePotential(double field_distance, double radius, double clearance)
+{
+  double d = field_distance - radius;
+
+  if (d >= clearance)  // everything is fine
+  {
+    return 0.0;
+  }
+  else if (d >= 0.0)  // transition phase, no collision yet
+  {
+    const double diff = (d - clearance);
+    const double gradient_magnitude = diff / clearance;
+    return 0.5 * gradient_magnitude * diff;  // 0.5 * (d - clearance)^2 / clearance
+  }
+  else  // d < 0.0: collision
+  {
+    return -d + 0.5 * clearance;  // linearly increase, starting from 0.5 * clearance
+  }
+}
+
 }  // namespace chomp
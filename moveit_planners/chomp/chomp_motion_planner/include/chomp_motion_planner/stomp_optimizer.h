@@ -0,0 +1,138 @@
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2026, PickNik LLC.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of PickNik LLC nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *********************************************************************/
+#pragma once
+
+#include <chomp_motion_planner/chomp_parameters.h>
+#include <chomp_motion_planner/chomp_trajectory.h>
+#include <chomp_motion_planner/chomp_cost.h>
+#include <moveit/robot_model/robot_model.h>
+#include <moveit/planning_scene/planning_scene.h>
+#include <moveit/collision_distance_field/collision_env_hybrid.h>
+
+#include <Eigen/Core>
+#include <random>
+#include <vector>
+
+namespace chomp
+{
+/**
+ * \brief Derivative-free trajectory optimizer in the style of STOMP
+ *
+ * Every iteration perturbs the current trajectory with noise drawn from the inverse of the CHOMP smoothness cost, so
+ * the rollouts stay smooth. All waypoints of all rollouts are checked against the distance field in one batch and
+ * the rollouts are then combined per waypoint, weighted by their exponentiated cost-to-go. Rollouts are independent,
+ * so their generation and evaluation is spread over ChompParameters::num_threads_ threads.
+ */
+class StompOptimizer
+{
+public:
+  StompOptimizer(ChompTrajectory* trajectory, const planning_scene::PlanningSceneConstPtr& planning_scene,
+                 const std::string& planning_group, const ChompParameters* parameters,
+                 const moveit::core::RobotState& start_state);
+
+  virtual ~StompOptimizer() = default;
+
+  /**
+   * Optimizes the CHOMP cost function by sampling and tries to find a collision free path
+   * @return true if a collision free path is found else returns false
+   */
+  bool optimize();
+
+  bool isInitialized() const
+  {
+    return initialized_;
+  }
+
+  bool isCollisionFree() const
+  {
+    return is_collision_free_;
+  }
+
+private:
+  void initialize();
+  /** \brief Perturb the current trajectory with new noise, rollout 0 remains noise free */
+  void generateRollouts();
+  /** \brief Compute the cost of every free waypoint of every rollout */
+  void evaluateRollouts();
+  /** \brief Move the trajectory towards the cost weighted average of the rollout noise */
+  void updateTrajectory();
+  void clampToJointLimits(Eigen::MatrixXd& trajectory) const;
+  void updateFullTrajectory();
+  bool isCurrentTrajectoryMeshToMeshCollisionFree() const;
+
+  int num_joints_;
+  int num_vars_free_;
+  int num_vars_all_;
+  int free_vars_start_;
+  int free_vars_end_;
+  int num_rollouts_;
+  int num_threads_;
+  int iteration_;
+
+  ChompTrajectory* full_trajectory_;
+  const moveit::core::RobotModelConstPtr& robot_model_;
+  std::string planning_group_;
+  const ChompParameters* parameters_;
+  ChompTrajectory group_trajectory_;
+  planning_scene::PlanningSceneConstPtr planning_scene_;
+  moveit::core::RobotState start_state_;
+  const moveit::core::JointModelGroup* joint_model_group_;
+  const collision_detection::CollisionEnvHybrid* hy_env_;
+  bool initialized_;
+  bool is_collision_free_;
+
+  std::vector<ChompCost> joint_costs_;
+  /// position limits of each joint, infinite for continuous joints
+  std::vector<std::pair<double, double> > joint_limits_;
+  double noise_stddev_;
+
+  /// the full trajectory and free point noise of each rollout
+  std::vector<Eigen::MatrixXd> rollouts_;
+  std::vector<Eigen::MatrixXd> rollout_noise_;
+  /// the obstacle and smoothness cost of each free point (rows) of each rollout (columns)
+  Eigen::MatrixXd rollout_costs_;
+  /// the obstacle cost of each rollout
+  Eigen::VectorXd rollout_collision_costs_;
+  /// a random generator per rollout, so rollouts can be sampled concurrently
+  std::vector<std::mt19937> rollout_generators_;
+  /// the robot state and group state representation of each free point of each rollout, reused across iterations
+  std::vector<moveit::core::RobotState> rollout_states_;
+  std::vector<collision_detection::GroupStateRepresentationPtr> rollout_gsrs_;
+
+  Eigen::MatrixXd best_group_trajectory_;
+  double best_group_trajectory_cost_;
+  int last_improvement_iteration_;
+  std::vector<std::string> joint_names_;
+};
+}  // namespace chomp
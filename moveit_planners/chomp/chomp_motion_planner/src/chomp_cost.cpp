@@ -36,20 +36,55 @@
 
 #include <chomp_motion_planner/chomp_cost.h>
 #include <chomp_motion_planner/chomp_utils.h>
-#include <eigen3/Eigen/LU>
+#include <ros/console.h>
+#include <algorithm>
 
 using namespace Eigen;
 using namespace std;
 
 namespace chomp
 {
+namespace
+{
+/**
+ * Use Takahashi's recurrence to compute the diagonal of the inverse of L * L^T from the banded Cholesky factor L.
+ * Only the entries of the inverse within the band are needed, which takes O(n * band^2) time and O(n * band) memory.
+ */
+VectorXd getInverseDiagonal(const SparseMatrix<double>& l)
+{
+  const int size = l.rows();
+  int band = 0;
+  for (int i = 0; i < l.outerSize(); ++i)
+    for (SparseMatrix<double>::InnerIterator it(l, i); it; ++it)
+      band = std::max(band, static_cast<int>(it.row()) - i);
+
+  // inverse(i, i + d) = inverse(i + d, i) is stored at band_inverse(i, d)
+  MatrixXd band_inverse = MatrixXd::Zero(size, band + 1);
+  auto inverse = [&band_inverse](int i, int j) { return i < j ? band_inverse(i, j - i) : band_inverse(j, i - j); };
+  for (int i = size - 1; i >= 0; --i)
+  {
+    const double diagonal = l.coeff(i, i);
+    for (int j = std::min(size - 1, i + band); j >= i; --j)
+    {
+      double sum = 0.0;
+      for (SparseMatrix<double>::InnerIterator it(l, i); it; ++it)
+        if (it.row() > i)
+          sum += it.value() * inverse(it.row(), j);
+      band_inverse(i, j - i) = ((i == j ? 1.0 / diagonal : 0.0) - sum) / diagonal;
+    }
+  }
+  return band_inverse.col(0);
+}
+}  // namespace
+
 ChompCost::ChompCost(const ChompTrajectory& trajectory, int /* joint_number */,
                      const std::vector<double>& derivative_costs, double ridge_factor)
+  : quad_cost_inv_scale_(1.0)
 {
   int num_vars_all = trajectory.getNumPoints();
   int num_vars_free = num_vars_all - 2 * (DIFF_RULE_LENGTH - 1);
-  MatrixXd diff_matrix = MatrixXd::Zero(num_vars_all, num_vars_all);
-  quad_cost_full_ = MatrixXd::Zero(num_vars_all, num_vars_all);
+  SparseMatrix<double> diff_matrix;
+  quad_cost_full_.resize(num_vars_all, num_vars_all);
 
   // construct the quad cost for all variables, as a sum of squared differentiation matrices
   double multiplier = 1.0;
@@ -57,22 +92,28 @@ ChompCost::ChompCost(const ChompTrajectory& trajectory, int /* joint_number */,
   {
     multiplier *= trajectory.getDiscretization();
     diff_matrix = getDiffMatrix(num_vars_all, &DIFF_RULES[i][0]);
-    quad_cost_full_ += (derivative_costs[i] * multiplier) * (diff_matrix.transpose() * diff_matrix);
+    quad_cost_full_ += (derivative_costs[i] * multiplier) * SparseMatrix<double>(diff_matrix.transpose() * diff_matrix);
   }
-  quad_cost_full_ += MatrixXd::Identity(num_vars_all, num_vars_all) * ridge_factor;
+  SparseMatrix<double> identity(num_vars_all, num_vars_all);
+  identity.setIdentity();
+  quad_cost_full_ += identity * ridge_factor;
+  quad_cost_full_.prune(0.0);
 
   // extract the quad cost just for the free variables:
   quad_cost_ = quad_cost_full_.block(DIFF_RULE_LENGTH - 1, DIFF_RULE_LENGTH - 1, num_vars_free, num_vars_free);
 
-  // invert the matrix:
-  quad_cost_inv_ = quad_cost_.inverse();
-
-  // cout << quad_cost_inv_ << endl;
+  // factorize the matrix, the natural ordering keeps the factor within the band of the cost:
+  auto llt = std::make_shared<Factorization>(quad_cost_);
+  if (llt->info() != Eigen::Success)
+    ROS_ERROR_NAMED("chomp_cost", "The smoothness cost is not positive definite, consider increasing the ridge_factor");
+  max_quad_cost_inv_value_ = getInverseDiagonal(SparseMatrix<double>(llt->matrixL())).maxCoeff();
+  quad_cost_llt_ = llt;
 }
 
-Eigen::MatrixXd ChompCost::getDiffMatrix(int size, const double* diff_rule) const
+Eigen::SparseMatrix<double> ChompCost::getDiffMatrix(int size, const double* diff_rule) const
 {
-  MatrixXd matrix = MatrixXd::Zero(size, size);
+  std::vector<Triplet<double> > entries;
+  entries.reserve(size * DIFF_RULE_LENGTH);
   for (int i = 0; i < size; i++)
   {
     for (int j = -DIFF_RULE_LENGTH / 2; j <= DIFF_RULE_LENGTH / 2; j++)
@@ -82,21 +123,30 @@ Eigen::MatrixXd ChompCost::getDiffMatrix(int size, const double* diff_rule) cons
         continue;
       if (index >= size)
         continue;
-      matrix(i, index) = diff_rule[j + DIFF_RULE_LENGTH / 2];
+      entries.emplace_back(i, index, diff_rule[j + DIFF_RULE_LENGTH / 2]);
     }
   }
+  SparseMatrix<double> matrix(size, size);
+  matrix.setFromTriplets(entries.begin(), entries.end());
   return matrix;
 }
 
+Eigen::VectorXd ChompCost::getQuadraticCostInverseColumn(int index) const
+{
+  return applyQuadraticCostInverse(VectorXd::Unit(quad_cost_.rows(), index));
+}
+
 double ChompCost::getMaxQuadCostInvValue() const
 {
-  return quad_cost_inv_.maxCoeff();
+  // the largest entry of a positive definite matrix lies on its diagonal
+  return max_quad_cost_inv_value_;
 }
 
 void ChompCost::scale(double scale)
 {
   double inv_scale = 1.0 / scale;
-  quad_cost_inv_ *= inv_scale;
+  quad_cost_inv_scale_ *= inv_scale;
+  max_quad_cost_inv_value_ *= inv_scale;
   quad_cost_ *= scale;
   quad_cost_full_ *= scale;
 }
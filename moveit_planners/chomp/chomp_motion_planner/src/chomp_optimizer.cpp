@@ -43,7 +43,9 @@
 #include <moveit/planning_scene/planning_scene.h>
 #include <eigen3/Eigen/LU>
 #include <eigen3/Eigen/Core>
+#include <algorithm>
 #include <random>
+#include <thread>
 
 namespace chomp
 {
@@ -66,6 +68,8 @@ ChompOptimizer::ChompOptimizer(ChompTrajectory* trajectory, const planning_scene
   , state_(start_state)
   , start_state_(start_state)
   , initialized_(false)
+  , num_threads_(parameters->num_threads_ > 0 ? parameters->num_threads_ :
+                                                 std::max(1u, std::thread::hardware_concurrency()))
 {
   std::vector<std::string> cd_names;
   planning_scene->getCollisionDetectorNames(cd_names);
@@ -112,26 +116,17 @@ void ChompOptimizer::initialize()
   }
 
   // set up the joint costs:
-  joint_costs_.reserve(num_joints_);
-
-  double max_cost_scale = 0.0;
-
   joint_model_group_ = planning_scene_->getRobotModel()->getJointModelGroup(planning_group_);
 
-  const std::vector<const moveit::core::JointModel*> joint_models = joint_model_group_->getActiveJointModels();
-  for (size_t i = 0; i < joint_models.size(); i++)
-  {
-    double joint_cost = 1.0;
-    // nh.param("joint_costs/" + joint_models[i]->getName(), joint_cost, 1.0);
-    std::vector<double> derivative_costs(3);
-    derivative_costs[0] = joint_cost * parameters_->smoothness_cost_velocity_;
-    derivative_costs[1] = joint_cost * parameters_->smoothness_cost_acceleration_;
-    derivative_costs[2] = joint_cost * parameters_->smoothness_cost_jerk_;
-    joint_costs_.push_back(ChompCost(group_trajectory_, i, derivative_costs, parameters_->ridge_factor_));
-    double cost_scale = joint_costs_[i].getMaxQuadCostInvValue();
-    if (max_cost_scale < cost_scale)
-      max_cost_scale = cost_scale;
-  }
+  // all joints have the same cost, so it is factorized only once and shared
+  double joint_cost = 1.0;
+  // nh.param("joint_costs/" + joint_models[i]->getName(), joint_cost, 1.0);
+  std::vector<double> derivative_costs(3);
+  derivative_costs[0] = joint_cost * parameters_->smoothness_cost_velocity_;
+  derivative_costs[1] = joint_cost * parameters_->smoothness_cost_acceleration_;
+  derivative_costs[2] = joint_cost * parameters_->smoothness_cost_jerk_;
+  joint_costs_.assign(num_joints_, ChompCost(group_trajectory_, 0, derivative_costs, parameters_->ridge_factor_));
+  double max_cost_scale = joint_costs_[0].getMaxQuadCostInvValue();
 
   // scale the smoothness costs
   for (int i = 0; i < num_joints_; i++)
@@ -143,10 +138,6 @@ void ChompOptimizer::initialize()
   smoothness_increments_ = Eigen::MatrixXd::Zero(num_vars_free_, num_joints_);
   collision_increments_ = Eigen::MatrixXd::Zero(num_vars_free_, num_joints_);
   final_increments_ = Eigen::MatrixXd::Zero(num_vars_free_, num_joints_);
-  smoothness_derivative_ = Eigen::VectorXd::Zero(num_vars_all_);
-  jacobian_ = Eigen::MatrixXd::Zero(3, num_joints_);
-  jacobian_pseudo_inverse_ = Eigen::MatrixXd::Zero(num_joints_, 3);
-  jacobian_jacobian_tranpose_ = Eigen::MatrixXd::Zero(3, 3);
   random_state_ = Eigen::VectorXd::Zero(num_joints_);
   joint_state_velocities_ = Eigen::VectorXd::Zero(num_joints_);
 
@@ -171,6 +162,9 @@ void ChompOptimizer::initialize()
 
   last_improvement_iteration_ = -1;
 
+  point_states_.assign(num_vars_all_, state_);
+  point_gsrs_.clear();
+
   /// TODO: HMC BASED COMMENTED CODE BELOW, Need to uncomment and perform extensive testing by varying the HMC
   /// parameters values in the chomp_planning.yaml file so that CHOMP can find optimal paths
 
@@ -178,13 +172,13 @@ void ChompOptimizer::initialize()
   // momentum_ = Eigen::MatrixXd::Zero(num_vars_free_, num_joints_);
   // random_momentum_ = Eigen::MatrixXd::Zero(num_vars_free_, num_joints_);
   // random_joint_momentum_ = Eigen::VectorXd::Zero(num_vars_free_);
-  multivariate_gaussian_.clear();
+  // multivariate_gaussian_.clear();
   stochasticity_factor_ = 1.0;
-  for (int i = 0; i < num_joints_; i++)
-  {
-    multivariate_gaussian_.push_back(
-        MultivariateGaussian(Eigen::VectorXd::Zero(num_vars_free_), joint_costs_[i].getQuadraticCostInverse()));
-  }
+  // for (int i = 0; i < num_joints_; i++)
+  // {
+  //   multivariate_gaussian_.push_back(
+  //       MultivariateGaussian(Eigen::VectorXd::Zero(num_vars_free_), dense inverse of joint_costs_[i]));
+  // }
 
   std::map<std::string, std::string> fixed_link_resolution_map;
   for (int i = 0; i < num_joints_; i++)
@@ -254,6 +248,11 @@ void ChompOptimizer::initialize()
       }
     }
   }
+
+  collision_point_moved_by_joint_.resize(num_collision_points_, std::vector<int>(num_joints_, 0));
+  for (int j = 0; j < num_collision_points_; ++j)
+    for (int k = 0; k < num_joints_; ++k)
+      collision_point_moved_by_joint_[j][k] = isParent(collision_point_joint_names_[start][j], joint_names_[k]);
   initialized_ = true;
 }
 
@@ -583,24 +582,17 @@ bool ChompOptimizer::isCurrentTrajectoryMeshToMeshCollisionFree() const
 
 void ChompOptimizer::calculateSmoothnessIncrements()
 {
+#pragma omp parallel for num_threads(num_threads_)
   for (int i = 0; i < num_joints_; i++)
   {
-    joint_costs_[i].getDerivative(group_trajectory_.getJointTrajectory(i), smoothness_derivative_);
-    smoothness_increments_.col(i) = -smoothness_derivative_.segment(group_trajectory_.getStartIndex(), num_vars_free_);
+    Eigen::VectorXd smoothness_derivative(num_vars_all_);
+    joint_costs_[i].getDerivative(group_trajectory_.getJointTrajectory(i), smoothness_derivative);
+    smoothness_increments_.col(i) = -smoothness_derivative.segment(group_trajectory_.getStartIndex(), num_vars_free_);
   }
 }
 
 void ChompOptimizer::calculateCollisionIncrements()
 {
-  double potential;
-  double vel_mag_sq;
-  double vel_mag;
-  Eigen::Vector3d potential_gradient;
-  Eigen::Vector3d normalized_velocity;
-  Eigen::Matrix3d orthogonal_projector;
-  Eigen::Vector3d curvature_vector;
-  Eigen::Vector3d cartesian_gradient;
-
   collision_increments_.setZero(num_vars_free_, num_joints_);
 
   int start_point = 0;
@@ -622,38 +614,45 @@ void ChompOptimizer::calculateCollisionIncrements()
     start_point = free_vars_start_;
   }
 
+  // every trajectory point only writes its own row of the increments
+#pragma omp parallel for num_threads(num_threads_) if (end_point > start_point)
   for (int i = start_point; i <= end_point; i++)
   {
+    Eigen::Matrix<double, 3, Eigen::Dynamic> jacobian(3, num_joints_);
     for (int j = 0; j < num_collision_points_; j++)
     {
-      potential = collision_point_potential_[i][j];
+      double potential = collision_point_potential_[i][j];
 
       if (potential < 0.0001)
         continue;
 
-      potential_gradient = -collision_point_potential_gradient_[i][j];
+      Eigen::Vector3d potential_gradient = -collision_point_potential_gradient_[i][j];
 
-      vel_mag = collision_point_vel_mag_[i][j];
-      vel_mag_sq = vel_mag * vel_mag;
+      double vel_mag = collision_point_vel_mag_[i][j];
+      double vel_mag_sq = vel_mag * vel_mag;
 
       // all math from the CHOMP paper:
 
-      normalized_velocity = collision_point_vel_eigen_[i][j] / vel_mag;
-      orthogonal_projector = Eigen::Matrix3d::Identity() - (normalized_velocity * normalized_velocity.transpose());
-      curvature_vector = (orthogonal_projector * collision_point_acc_eigen_[i][j]) / vel_mag_sq;
-      cartesian_gradient = vel_mag * (orthogonal_projector * potential_gradient - potential * curvature_vector);
+      Eigen::Vector3d normalized_velocity = collision_point_vel_eigen_[i][j] / vel_mag;
+      Eigen::Matrix3d orthogonal_projector =
+          Eigen::Matrix3d::Identity() - (normalized_velocity * normalized_velocity.transpose());
+      Eigen::Vector3d curvature_vector = (orthogonal_projector * collision_point_acc_eigen_[i][j]) / vel_mag_sq;
+      Eigen::Vector3d cartesian_gradient =
+          vel_mag * (orthogonal_projector * potential_gradient - potential * curvature_vector);
 
       // pass it through the jacobian transpose to get the increments
-      getJacobian(i, collision_point_pos_eigen_[i][j], collision_point_joint_names_[i][j], jacobian_);
+      getJacobian(i, collision_point_pos_eigen_[i][j], j, jacobian);
 
       if (parameters_->use_pseudo_inverse_)
       {
-        calculatePseudoInverse();
-        collision_increments_.row(i - free_vars_start_).transpose() -= jacobian_pseudo_inverse_ * cartesian_gradient;
+        const Eigen::Matrix3d jacobian_jacobian_transpose =
+            jacobian * jacobian.transpose() + Eigen::Matrix3d::Identity() * parameters_->pseudo_inverse_ridge_factor_;
+        collision_increments_.row(i - free_vars_start_).transpose() -=
+            jacobian.transpose() * (jacobian_jacobian_transpose.inverse() * cartesian_gradient);
       }
       else
       {
-        collision_increments_.row(i - free_vars_start_).transpose() -= jacobian_.transpose() * cartesian_gradient;
+        collision_increments_.row(i - free_vars_start_).transpose() -= jacobian.transpose() * cartesian_gradient;
       }
 
       /*
@@ -667,21 +666,15 @@ void ChompOptimizer::calculateCollisionIncrements()
   // cout << collision_increments_ << endl;
 }
 
-void ChompOptimizer::calculatePseudoInverse()
-{
-  jacobian_jacobian_tranpose_ =
-      jacobian_ * jacobian_.transpose() + Eigen::MatrixXd::Identity(3, 3) * parameters_->pseudo_inverse_ridge_factor_;
-  jacobian_pseudo_inverse_ = jacobian_.transpose() * jacobian_jacobian_tranpose_.inverse();
-}
-
 void ChompOptimizer::calculateTotalIncrements()
 {
+#pragma omp parallel for num_threads(num_threads_)
   for (int i = 0; i < num_joints_; i++)
   {
     final_increments_.col(i) =
-        parameters_->learning_rate_ * (joint_costs_[i].getQuadraticCostInverse() *
-                                       (parameters_->smoothness_cost_weight_ * smoothness_increments_.col(i) +
-                                        parameters_->obstacle_cost_weight_ * collision_increments_.col(i)));
+        parameters_->learning_rate_ *
+        joint_costs_[i].applyQuadraticCostInverse(parameters_->smoothness_cost_weight_ * smoothness_increments_.col(i) +
+                                                  parameters_->obstacle_cost_weight_ * collision_increments_.col(i));
   }
 }
 
@@ -759,11 +752,11 @@ double ChompOptimizer::getCollisionCost()
   return parameters_->obstacle_cost_weight_ * collision_cost;
 }
 
-void ChompOptimizer::computeJointProperties(int trajectory_point)
+void ChompOptimizer::computeJointProperties(int trajectory_point, const moveit::core::RobotState& state)
 {
   for (int j = 0; j < num_joints_; j++)
   {
-    const moveit::core::JointModel* joint_model = state_.getJointModel(joint_names_[j]);
+    const moveit::core::JointModel* joint_model = state.getJointModel(joint_names_[j]);
     const moveit::core::RevoluteJointModel* revolute_joint =
         dynamic_cast<const moveit::core::RevoluteJointModel*>(joint_model);
     const moveit::core::PrismaticJointModel* prismatic_joint =
@@ -771,9 +764,9 @@ void ChompOptimizer::computeJointProperties(int trajectory_point)
 
     std::string parent_link_name = joint_model->getParentLinkModel()->getName();
     std::string child_link_name = joint_model->getChildLinkModel()->getName();
-    Eigen::Isometry3d joint_transform = state_.getGlobalLinkTransform(parent_link_name) *
+    Eigen::Isometry3d joint_transform = state.getGlobalLinkTransform(parent_link_name) *
                                         (robot_model_->getLinkModel(child_link_name)->getJointOriginTransform() *
-                                         (state_.getJointTransform(joint_model)));
+                                         (state.getJointTransform(joint_model)));
 
     // joint_transform = inverseWorldTransform * jointTransform;
     Eigen::Vector3d axis;
@@ -799,12 +792,12 @@ void ChompOptimizer::computeJointProperties(int trajectory_point)
 }
 
 template <typename Derived>
-void ChompOptimizer::getJacobian(int trajectory_point, Eigen::Vector3d& collision_point_pos, std::string& joint_name,
+void ChompOptimizer::getJacobian(int trajectory_point, const Eigen::Vector3d& collision_point_pos, int collision_point,
                                  Eigen::MatrixBase<Derived>& jacobian) const
 {
   for (int j = 0; j < num_joints_; j++)
   {
-    if (isParent(joint_name, joint_names_[j]))
+    if (collision_point_moved_by_joint_[collision_point][j])
     {
       Eigen::Vector3d column = joint_axes_[trajectory_point][j].cross(
           Eigen::Vector3d(collision_point_pos(0), collision_point_pos(1), collision_point_pos(2)) -
@@ -893,10 +886,9 @@ void ChompOptimizer::handleJointLimits()
       if (violation)
       {
         int free_var_index = max_violation_index - free_vars_start_;
-        double multiplier =
-            max_violation / joint_costs_[joint_i].getQuadraticCostInverse()(free_var_index, free_var_index);
-        group_trajectory_.getFreeJointTrajectoryBlock(joint_i) +=
-            multiplier * joint_costs_[joint_i].getQuadraticCostInverse().col(free_var_index);
+        const Eigen::VectorXd inverse_column = joint_costs_[joint_i].getQuadraticCostInverseColumn(free_var_index);
+        double multiplier = max_violation / inverse_column(free_var_index);
+        group_trajectory_.getFreeJointTrajectoryBlock(joint_i) += multiplier * inverse_column;
       }
       if (++count > 10)
         break;
@@ -918,68 +910,63 @@ void ChompOptimizer::performForwardKinematics()
     end = num_vars_all_ - 1;
   }
 
-  is_collision_free_ = true;
+  // the forward kinematics of the points are independent, so they are computed concurrently and their proximity
+  // gradients are looked up in one batch
+  std::vector<const moveit::core::RobotState*> states(end - start + 1);
+#pragma omp parallel for num_threads(num_threads_)
+  for (int i = start; i <= end; ++i)
+  {
+    setRobotStateFromPoint(group_trajectory_, i, point_states_[i]);
+    computeJointProperties(i, point_states_[i]);
+    states[i - start] = &point_states_[i];
+  }
 
-  ros::WallDuration total_dur(0.0);
+  // the group state representations are reused as long as the same points are evaluated, i.e. after the first iteration
+  if (point_gsrs_.size() != states.size())
+    point_gsrs_.clear();
+  collision_detection::CollisionRequest req;
+  req.group_name = planning_group_;
+  ros::WallTime grad = ros::WallTime::now();
+  hy_env_->getCollisionGradients(req, states, nullptr, point_gsrs_, num_threads_);
+  ROS_DEBUG_STREAM("Collision gradients of " << states.size() << " points took " << (ros::WallTime::now() - grad));
 
-  // for each point in the trajectory
+  bool is_collision_free = true;
+#pragma omp parallel for num_threads(num_threads_) reduction(&& : is_collision_free)
   for (int i = start; i <= end; ++i)
   {
-    // Set Robot state from trajectory point...
-    collision_detection::CollisionRequest req;
-    collision_detection::CollisionResult res;
-    req.group_name = planning_group_;
-    setRobotStateFromPoint(group_trajectory_, i);
-    ros::WallTime grad = ros::WallTime::now();
-
-    hy_env_->getCollisionGradients(req, res, state_, nullptr, gsr_);
-    total_dur += (ros::WallTime::now() - grad);
-    computeJointProperties(i);
     state_is_in_collision_[i] = false;
 
-    // Keep vars in scope
+    size_t j = 0;
+    for (const collision_detection::GradientInfo& info : point_gsrs_[i - start]->gradients_)
     {
-      size_t j = 0;
-      for (const collision_detection::GradientInfo& info : gsr_->gradients_)
+      for (size_t k = 0; k < info.sphere_locations.size(); k++)
       {
-        for (size_t k = 0; k < info.sphere_locations.size(); k++)
-        {
-          collision_point_pos_eigen_[i][j][0] = info.sphere_locations[k].x();
-          collision_point_pos_eigen_[i][j][1] = info.sphere_locations[k].y();
-          collision_point_pos_eigen_[i][j][2] = info.sphere_locations[k].z();
+        collision_point_pos_eigen_[i][j][0] = info.sphere_locations[k].x();
+        collision_point_pos_eigen_[i][j][1] = info.sphere_locations[k].y();
+        collision_point_pos_eigen_[i][j][2] = info.sphere_locations[k].z();
 
-          collision_point_potential_[i][j] =
-              getPotential(info.distances[k], info.sphere_radii[k], parameters_->min_clearance_);
-          collision_point_potential_gradient_[i][j][0] = info.gradients[k].x();
-          collision_point_potential_gradient_[i][j][1] = info.gradients[k].y();
-          collision_point_potential_gradient_[i][j][2] = info.gradients[k].z();
+        collision_point_potential_[i][j] =
+            getObstaclePotential(info.distances[k], info.sphere_radii[k], parameters_->min_clearance_);
+        collision_point_potential_gradient_[i][j][0] = info.gradients[k].x();
+        collision_point_potential_gradient_[i][j][1] = info.gradients[k].y();
+        collision_point_potential_gradient_[i][j][2] = info.gradients[k].z();
 
-          point_is_in_collision_[i][j] = (info.distances[k] - info.sphere_radii[k] < info.sphere_radii[k]);
+        point_is_in_collision_[i][j] = (info.distances[k] - info.sphere_radii[k] < info.sphere_radii[k]);
 
-          if (point_is_in_collision_[i][j])
-          {
-            state_is_in_collision_[i] = true;
-            // if(is_collision_free_ == true) {
-            //   ROS_INFO_STREAM("We know it's not collision free " << g);
-            //   ROS_INFO_STREAM("Sphere location " << info.sphere_locations[k].x() << " " <<
-            //   info.sphere_locations[k].y() << " " << info.sphere_locations[k].z());
-            //   ROS_INFO_STREAM("Gradient " << info.gradients[k].x() << " " << info.gradients[k].y() << " " <<
-            //   info.gradients[k].z() << " distance " << info.distances[k] << " radii " << info.sphere_radii[k]);
-            //   ROS_INFO_STREAM("Radius " << info.sphere_radii[k] << " potential " <<
-            //   collision_point_potential_[i][j]);
-            // }
-
-            is_collision_free_ = false;
-          }
-          j++;
+        if (point_is_in_collision_[i][j])
+        {
+          state_is_in_collision_[i] = true;
+          is_collision_free = false;
         }
+        j++;
       }
     }
   }
-
-  // ROS_INFO_STREAM("Total dur " << total_dur << " total checks " << end-start+1);
+  is_collision_free_ = is_collision_free;
+  state_ = point_states_[end];
 
   // now, get the vel and acc for each collision point (using finite differencing)
+#pragma omp parallel for num_threads(num_threads_)
   for (int i = free_vars_start_; i <= free_vars_end_; i++)
   {
     for (int j = 0; j < num_collision_points_; j++)
@@ -1000,7 +987,8 @@ void ChompOptimizer::performForwardKinematics()
   }
 }
 
-void ChompOptimizer::setRobotStateFromPoint(ChompTrajectory& group_trajectory, int i)
+void ChompOptimizer::setRobotStateFromPoint(ChompTrajectory& group_trajectory, int i,
+                                            moveit::core::RobotState& state) const
 {
   const Eigen::MatrixXd::RowXpr& point = group_trajectory.getTrajectoryPoint(i);
 
@@ -1009,8 +997,8 @@ void ChompOptimizer::setRobotStateFromPoint(ChompTrajectory& group_trajectory, i
   for (size_t j = 0; j < group_trajectory.getNumJoints(); j++)
     joint_states.emplace_back(point(0, j));
 
-  state_.setJointGroupPositions(planning_group_, joint_states);
-  state_.update();
+  state.setJointGroupPositions(planning_group_, joint_states);
+  state.update();
 }
 
 void ChompOptimizer::perturbTrajectory()
@@ -1042,7 +1030,7 @@ void ChompOptimizer::perturbTrajectory()
   for (int i = 0; i < num_joints_; i++)
   {
     group_trajectory_.getFreeJointTrajectoryBlock(i) +=
-        joint_costs_[i].getQuadraticCostInverse().col(mp_free_vars_index) * random_state_(i);
+        joint_costs_[i].getQuadraticCostInverseColumn(mp_free_vars_index) * random_state_(i);
   }
 }
 
@@ -62,6 +62,14 @@ ChompParameters::ChompParameters()
   trajectory_initialization_method_ = std::string("quintic-spline");
   enable_failure_recovery_ = false;
   max_recovery_attempts_ = 5;
+  num_threads_ = 0;
+  trajectory_cache_size_ = 0;
+  trajectory_cache_tolerance_ = 0.1;
+  use_stomp_ = false;
+  stomp_num_rollouts_ = 16;
+  stomp_noise_stddev_ = 0.1;
+  stomp_noise_decay_ = 0.95;
+  stomp_cost_sensitivity_ = 10.0;
 }
 
 ChompParameters::~ChompParameters() = default;
@@ -38,11 +38,34 @@
 #include <chomp_motion_planner/chomp_planner.h>
 #include <chomp_motion_planner/chomp_trajectory.h>
 #include <chomp_motion_planner/chomp_optimizer.h>
+#include <chomp_motion_planner/stomp_optimizer.h>
 #include <moveit/robot_state/conversions.h>
 #include <moveit_msgs/MotionPlanRequest.h>
 
 namespace chomp
 {
+namespace
+{
+/**
+ * Optimize \a trajectory with an \a Optimizer
+ * @return false if the optimizer could not be initialized, else whether the optimized trajectory is collision free
+ * is stored in \a collision_free
+ */
+template <typename Optimizer>
+bool runOptimizer(ChompTrajectory& trajectory, const planning_scene::PlanningSceneConstPtr& planning_scene,
+                  const std::string& group_name, const ChompParameters& params,
+                  const moveit::core::RobotState& start_state, bool& collision_free)
+{
+  Optimizer optimizer(&trajectory, planning_scene, group_name, &params, start_state);
+  if (!optimizer.isInitialized())
+    return false;
+
+  optimizer.optimize();
+  collision_free = optimizer.isCollisionFree();
+  return true;
+}
+}  // namespace
+
 bool ChompPlanner::solve(const planning_scene::PlanningSceneConstPtr& planning_scene,
                          const planning_interface::MotionPlanRequest& req, const ChompParameters& params,
                          planning_interface::MotionPlanDetailedResponse& res) const
@@ -117,8 +140,17 @@ bool ChompPlanner::solve(const planning_scene::PlanningSceneConstPtr& planning_s
     }
   }
 
+  // a cached solution of a nearby problem in the same world is closer to the optimum than any other initialization
+  robot_trajectory::RobotTrajectoryConstPtr cached_trajectory;
+  if (trajectory_cache_)
+    cached_trajectory = trajectory_cache_->lookup(*planning_scene, req.group_name, start_state, goal_state);
+
   // fill in an initial trajectory based on user choice from the chomp_config.yaml file
-  if (params.trajectory_initialization_method_.compare("quintic-spline") == 0)
+  if (cached_trajectory && trajectory.warmStartFromTrajectory(*cached_trajectory))
+  {
+    ROS_INFO_NAMED("chomp_planner", "CHOMP trajectory initialized from a cached solution");
+  }
+  else if (params.trajectory_initialization_method_.compare("quintic-spline") == 0)
     trajectory.fillInMinJerk();
   else if (params.trajectory_initialization_method_.compare("linear") == 0)
     trajectory.fillInLinearInterpolation();
@@ -144,8 +176,9 @@ bool ChompPlanner::solve(const planning_scene::PlanningSceneConstPtr& planning_s
     return false;
   }
 
-  ROS_INFO_NAMED("chomp_planner", "CHOMP trajectory initialized using method: %s ",
-                 (params.trajectory_initialization_method_).c_str());
+  if (!cached_trajectory)
+    ROS_INFO_NAMED("chomp_planner", "CHOMP trajectory initialized using method: %s ",
+                   (params.trajectory_initialization_method_).c_str());
 
   // optimize!
   ros::WallTime create_time = ros::WallTime::now();
@@ -161,7 +194,7 @@ bool ChompPlanner::solve(const planning_scene::PlanningSceneConstPtr& planning_s
   org_planning_time_limit = params.planning_time_limit_;
   org_max_iterations = params.max_iterations_;
 
-  std::unique_ptr<ChompOptimizer> optimizer;
+  bool collision_free = false;
 
   // create a non_const_params variable which stores the non constant version of the const params variable
   ChompParameters params_nonconst = params;
@@ -177,20 +210,20 @@ bool ChompPlanner::solve(const planning_scene::PlanningSceneConstPtr& planning_s
                                         params_nonconst.planning_time_limit_ + 5, params_nonconst.max_iterations_ + 50);
     }
 
-    // initialize a ChompOptimizer object to load up the optimizer with default parameters or with updated parameters in
-    // case of a recovery behaviour
-    optimizer =
-        std::make_unique<ChompOptimizer>(&trajectory, planning_scene, req.group_name, &params_nonconst, start_state);
-    if (!optimizer->isInitialized())
+    // run the optimizer with default parameters or with updated parameters in case of a recovery behaviour
+    bool initialized =
+        params_nonconst.use_stomp_ ?
+            runOptimizer<StompOptimizer>(trajectory, planning_scene, req.group_name, params_nonconst, start_state,
+                                         collision_free) :
+            runOptimizer<ChompOptimizer>(trajectory, planning_scene, req.group_name, params_nonconst, start_state,
+                                         collision_free);
+    if (!initialized)
     {
       ROS_ERROR_STREAM_NAMED("chomp_planner", "Could not initialize optimizer");
       res.error_code_.val = moveit_msgs::MoveItErrorCodes::PLANNING_FAILED;
       return false;
     }
-
-    ROS_DEBUG_NAMED("chomp_planner", "Optimization took %f sec to create", (ros::WallTime::now() - create_time).toSec());
-
-    bool optimization_result = optimizer->optimize();
+    bool optimization_result = collision_free;
 
     // replan with updated parameters if no solution is found
     if (params_nonconst.enable_failure_recovery_)
@@ -256,7 +289,7 @@ bool ChompPlanner::solve(const planning_scene::PlanningSceneConstPtr& planning_s
   res.processing_time_[0] = (ros::WallTime::now() - start_time).toSec();
 
   // report planning failure if path has collisions
-  if (not optimizer->isCollisionFree())
+  if (!collision_free)
   {
     ROS_ERROR_STREAM_NAMED("chomp_planner", "Motion plan is invalid.");
     res.error_code_.val = moveit_msgs::MoveItErrorCodes::INVALID_MOTION_PLAN;
@@ -276,6 +309,8 @@ bool ChompPlanner::solve(const planning_scene::PlanningSceneConstPtr& planning_s
     }
   }
 
+  if (trajectory_cache_)
+    trajectory_cache_->insert(*planning_scene, result);
   return true;
 }
 }  // namespace chomp
@@ -209,6 +209,24 @@ bool ChompTrajectory::fillInFromTrajectory(const robot_trajectory::RobotTrajecto
   return true;
 }
 
+bool ChompTrajectory::warmStartFromTrajectory(const robot_trajectory::RobotTrajectory& trajectory)
+{
+  const size_t max_index = getNumPoints() - 1;
+  const Eigen::RowVectorXd start = trajectory_.row(0);
+  const Eigen::RowVectorXd goal = trajectory_.row(max_index);
+  if (!fillInFromTrajectory(trajectory))
+    return false;
+
+  const Eigen::RowVectorXd start_offset = start - trajectory_.row(0);
+  const Eigen::RowVectorXd goal_offset = goal - trajectory_.row(max_index);
+  for (size_t i = 0; i <= max_index; i++)
+  {
+    const double fraction = static_cast<double>(i) / max_index;
+    trajectory_.row(i) += (1.0 - fraction) * start_offset + fraction * goal_offset;
+  }
+  return true;
+}
+
 void ChompTrajectory::assignCHOMPTrajectoryPointFromRobotState(const moveit::core::RobotState& source,
                                                                size_t chomp_trajectory_point_index,
                                                                const moveit::core::JointModelGroup* group)
@@ -0,0 +1,154 @@
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2026, PickNik LLC.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of PickNik LLC nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *********************************************************************/
+#include <chomp_motion_planner/chomp_trajectory_cache.h>
+#include <boost/functional/hash.hpp>
+#include <algorithm>
+#include <cmath>
+
+namespace chomp
+{
+namespace
+{
+// poses are hashed at this resolution so that numerically identical scenes match
+constexpr double POSE_RESOLUTION = 1e-4;
+
+void hashPose(std::size_t& seed, const Eigen::Isometry3d& pose)
+{
+  for (int i = 0; i < 3; ++i)
+    for (int j = 0; j < 4; ++j)
+      boost::hash_combine(seed, std::lround(pose.matrix()(i, j) / POSE_RESOLUTION));
+}
+
+double maxDistance(const std::vector<double>& a, const std::vector<double>& b)
+{
+  double distance = 0.0;
+  for (std::size_t i = 0; i < a.size(); ++i)
+    distance = std::max(distance, std::fabs(a[i] - b[i]));
+  return distance;
+}
+}  // namespace
+
+ChompTrajectoryCache::ChompTrajectoryCache(std::size_t max_size, double tolerance)
+  : max_size_(max_size), tolerance_(tolerance)
+{
+}
+
+robot_trajectory::RobotTrajectoryConstPtr ChompTrajectoryCache::lookup(const planning_scene::PlanningScene& scene,
+                                                                       const std::string& group_name,
+                                                                       const moveit::core::RobotState& start_state,
+                                                                       const moveit::core::RobotState& goal_state)
+{
+  std::vector<double> start, goal;
+  start_state.copyJointGroupPositions(group_name, start);
+  goal_state.copyJointGroupPositions(group_name, goal);
+  const std::size_t world_hash = getWorldHash(scene);
+
+  std::lock_guard<std::mutex> slock(lock_);
+  auto best = entries_.end();
+  double best_distance = tolerance_;
+  for (auto it = entries_.begin(); it != entries_.end(); ++it)
+  {
+    if (it->group_name != group_name || it->world_hash != world_hash)
+      continue;
+    const double distance = std::max(maxDistance(it->start, start), maxDistance(it->goal, goal));
+    if (distance <= best_distance)
+    {
+      best_distance = distance;
+      best = it;
+    }
+  }
+  if (best == entries_.end())
+    return robot_trajectory::RobotTrajectoryConstPtr();
+
+  entries_.splice(entries_.begin(), entries_, best);
+  return entries_.front().trajectory;
+}
+
+void ChompTrajectoryCache::insert(const planning_scene::PlanningScene& scene,
+                                  const robot_trajectory::RobotTrajectoryConstPtr& trajectory)
+{
+  if (!trajectory || trajectory->getWayPointCount() < 2 || !trajectory->getGroup() || max_size_ == 0)
+    return;
+
+  Entry entry;
+  entry.group_name = trajectory->getGroupName();
+  entry.world_hash = getWorldHash(scene);
+  trajectory->getFirstWayPoint().copyJointGroupPositions(entry.group_name, entry.start);
+  trajectory->getLastWayPoint().copyJointGroupPositions(entry.group_name, entry.goal);
+  entry.trajectory = trajectory;
+
+  std::lock_guard<std::mutex> slock(lock_);
+  // a new solution for the same problem replaces the old one
+  entries_.remove_if([&entry](const Entry& other) {
+    return other.group_name == entry.group_name && other.world_hash == entry.world_hash &&
+           maxDistance(other.start, entry.start) == 0.0 && maxDistance(other.goal, entry.goal) == 0.0;
+  });
+  entries_.push_front(std::move(entry));
+  while (entries_.size() > max_size_)
+    entries_.pop_back();
+}
+
+void ChompTrajectoryCache::clear()
+{
+  std::lock_guard<std::mutex> slock(lock_);
+  entries_.clear();
+}
+
+std::size_t ChompTrajectoryCache::size() const
+{
+  std::lock_guard<std::mutex> slock(lock_);
+  return entries_.size();
+}
+
+std::size_t ChompTrajectoryCache::getWorldHash(const planning_scene::PlanningScene& scene)
+{
+  std::size_t seed = 0;
+  const collision_detection::WorldConstPtr& world = scene.getWorld();
+  for (const std::string& id : world->getObjectIds())
+  {
+    const collision_detection::World::ObjectConstPtr object = world->getObject(id);
+    boost::hash_combine(seed, id);
+    hashPose(seed, object->pose_);
+    for (std::size_t i = 0; i < object->shapes_.size(); ++i)
+    {
+      boost::hash_combine(seed, static_cast<int>(object->shapes_[i]->type));
+      // the contents of octomaps and meshes change without changing their type, so their identity is hashed as well
+      if (object->shapes_[i]->type == shapes::OCTREE || object->shapes_[i]->type == shapes::MESH)
+        boost::hash_combine(seed, object->shapes_[i].get());
+      hashPose(seed, object->shape_poses_[i]);
+    }
+  }
+  return seed;
+}
+}  // namespace chomp
@@ -0,0 +1,331 @@
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2026, PickNik LLC.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of PickNik LLC nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *********************************************************************/
+
+#include <chomp_motion_planner/stomp_optimizer.h>
+#include <chomp_motion_planner/chomp_utils.h>
+#include <moveit/robot_state/conversions.h>
+#include <ros/ros.h>
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <thread>
+
+namespace chomp
+{
+StompOptimizer::StompOptimizer(ChompTrajectory* trajectory, const planning_scene::PlanningSceneConstPtr& planning_scene,
+                               const std::string& planning_group, const ChompParameters* parameters,
+                               const moveit::core::RobotState& start_state)
+  : num_threads_(parameters->num_threads_ > 0 ? parameters->num_threads_ :
+                                                 std::max(1u, std::thread::hardware_concurrency()))
+  , iteration_(0)
+  , full_trajectory_(trajectory)
+  , robot_model_(planning_scene->getRobotModel())
+  , planning_group_(planning_group)
+  , parameters_(parameters)
+  , group_trajectory_(*full_trajectory_, planning_group_, DIFF_RULE_LENGTH)
+  , planning_scene_(planning_scene)
+  , start_state_(start_state)
+  , initialized_(false)
+  , is_collision_free_(false)
+{
+  hy_env_ = dynamic_cast<const collision_detection::CollisionEnvHybrid*>(
+      planning_scene->getCollisionEnv(planning_scene->getActiveCollisionDetectorName()).get());
+  if (!hy_env_)
+  {
+    ROS_WARN_STREAM("Could not initialize hybrid collision world from planning scene");
+    return;
+  }
+
+  initialize();
+}
+
+void StompOptimizer::initialize()
+{
+  num_vars_free_ = group_trajectory_.getNumFreePoints();
+  num_vars_all_ = group_trajectory_.getNumPoints();
+  num_joints_ = group_trajectory_.getNumJoints();
+
+  free_vars_start_ = group_trajectory_.getStartIndex();
+  free_vars_end_ = group_trajectory_.getEndIndex();
+
+  joint_model_group_ = planning_scene_->getRobotModel()->getJointModelGroup(planning_group_);
+
+  // the smoothness cost is the same as CHOMP's, scaled so the largest variance of the rollout noise is one
+  std::vector<double> derivative_costs(3);
+  derivative_costs[0] = parameters_->smoothness_cost_velocity_;
+  derivative_costs[1] = parameters_->smoothness_cost_acceleration_;
+  derivative_costs[2] = parameters_->smoothness_cost_jerk_;
+  joint_costs_.assign(num_joints_, ChompCost(group_trajectory_, 0, derivative_costs, parameters_->ridge_factor_));
+  double max_cost_scale = joint_costs_[0].getMaxQuadCostInvValue();
+  for (ChompCost& joint_cost : joint_costs_)
+    joint_cost.scale(max_cost_scale);
+
+  for (const moveit::core::JointModel* joint_model : joint_model_group_->getActiveJointModels())
+  {
+    joint_names_.push_back(joint_model->getName());
+
+    const moveit::core::RevoluteJointModel* revolute_joint =
+        dynamic_cast<const moveit::core::RevoluteJointModel*>(joint_model);
+    if (revolute_joint && revolute_joint->isContinuous())
+    {
+      joint_limits_.emplace_back(-std::numeric_limits<double>::infinity(), std::numeric_limits<double>::infinity());
+      continue;
+    }
+
+    double joint_min = std::numeric_limits<double>::max();
+    double joint_max = -std::numeric_limits<double>::max();
+    for (const moveit::core::VariableBounds& bound : joint_model->getVariableBounds())
+    {
+      joint_min = std::min(joint_min, bound.min_position_);
+      joint_max = std::max(joint_max, bound.max_position_);
+    }
+    joint_limits_.emplace_back(joint_min, joint_max);
+  }
+
+  // rollout 0 is the current trajectory without noise
+  num_rollouts_ = std::max(1, parameters_->stomp_num_rollouts_) + 1;
+  noise_stddev_ = parameters_->stomp_noise_stddev_;
+  rollouts_.assign(num_rollouts_, group_trajectory_.getTrajectory());
+  rollout_noise_.assign(num_rollouts_, Eigen::MatrixXd::Zero(num_vars_free_, num_joints_));
+  rollout_costs_ = Eigen::MatrixXd::Zero(num_vars_free_, num_rollouts_);
+  rollout_collision_costs_ = Eigen::VectorXd::Zero(num_rollouts_);
+  rollout_states_.assign(num_rollouts_ * num_vars_free_, start_state_);
+
+  std::random_device seed;
+  for (int k = 0; k < num_rollouts_; ++k)
+    rollout_generators_.emplace_back(seed());
+
+  initialized_ = true;
+}
+
+bool StompOptimizer::optimize()
+{
+  ros::WallTime start_time = ros::WallTime::now();
+  is_collision_free_ = false;
+
+  for (iteration_ = 0; iteration_ < parameters_->max_iterations_; ++iteration_)
+  {
+    generateRollouts();
+    evaluateRollouts();
+
+    double cost = rollout_costs_.col(0).sum();
+    if (iteration_ == 0 || cost < best_group_trajectory_cost_)
+    {
+      best_group_trajectory_ = group_trajectory_.getTrajectory();
+      best_group_trajectory_cost_ = cost;
+      last_improvement_iteration_ = iteration_;
+    }
+
+    if ((iteration_ % 10 == 0 || rollout_collision_costs_(0) < parameters_->collision_threshold_) &&
+        isCurrentTrajectoryMeshToMeshCollisionFree())
+    {
+      ROS_INFO("Stomp got mesh to mesh safety at iter %d. Breaking out early.", iteration_);
+      best_group_trajectory_ = group_trajectory_.getTrajectory();
+      last_improvement_iteration_ = iteration_;
+      is_collision_free_ = true;
+      iteration_++;
+      break;
+    }
+
+    if ((ros::WallTime::now() - start_time).toSec() > parameters_->planning_time_limit_)
+    {
+      ROS_WARN("Breaking out early due to time limit constraints.");
+      break;
+    }
+
+    updateTrajectory();
+    noise_stddev_ *= parameters_->stomp_noise_decay_;
+  }
+
+  if (is_collision_free_)
+    ROS_INFO("Stomp path is collision free");
+  else
+    ROS_ERROR("Stomp path is not collision free!");
+
+  group_trajectory_.getTrajectory() = best_group_trajectory_;
+  updateFullTrajectory();
+
+  ROS_INFO("Terminated after %d iterations, using path from iteration %d", iteration_, last_improvement_iteration_);
+  ROS_INFO("Optimization core finished in %f sec", (ros::WallTime::now() - start_time).toSec());
+
+  return is_collision_free_;
+}
+
+void StompOptimizer::generateRollouts()
+{
+#pragma omp parallel for num_threads(num_threads_)
+  for (int k = 0; k < num_rollouts_; ++k)
+  {
+    rollouts_[k] = group_trajectory_.getTrajectory();
+    if (k == 0)
+      continue;
+
+    std::normal_distribution<double> normal(0.0, noise_stddev_);
+    Eigen::VectorXd white_noise(num_vars_free_);
+    for (int j = 0; j < num_joints_; ++j)
+    {
+      for (int i = 0; i < num_vars_free_; ++i)
+        white_noise(i) = normal(rollout_generators_[k]);
+      rollouts_[k].block(free_vars_start_, j, num_vars_free_, 1) += joint_costs_[j].getCorrelatedNoise(white_noise);
+    }
+    clampToJointLimits(rollouts_[k]);
+
+    // only the noise that survived the joint limits moves the trajectory
+    rollout_noise_[k] = rollouts_[k].block(free_vars_start_, 0, num_vars_free_, num_joints_) -
+                        group_trajectory_.getTrajectory().block(free_vars_start_, 0, num_vars_free_, num_joints_);
+  }
+}
+
+void StompOptimizer::evaluateRollouts()
+{
+  // the free points of all rollouts are looked up in a single batch
+  std::vector<const moveit::core::RobotState*> states(rollout_states_.size());
+#pragma omp parallel for num_threads(num_threads_)
+  for (int s = 0; s < static_cast<int>(rollout_states_.size()); ++s)
+  {
+    const Eigen::VectorXd point = rollouts_[s / num_vars_free_].row(free_vars_start_ + s % num_vars_free_).transpose();
+    rollout_states_[s].setJointGroupPositions(joint_model_group_, point);
+    rollout_states_[s].update();
+    states[s] = &rollout_states_[s];
+  }
+
+  collision_detection::CollisionRequest req;
+  req.group_name = planning_group_;
+  ros::WallTime grad = ros::WallTime::now();
+  hy_env_->getCollisionGradients(req, states, nullptr, rollout_gsrs_, num_threads_);
+  ROS_DEBUG_STREAM("Collision gradients of " << states.size() << " points took " << (ros::WallTime::now() - grad));
+
+#pragma omp parallel for num_threads(num_threads_)
+  for (int k = 0; k < num_rollouts_; ++k)
+  {
+    // x^T A x is split into the contributions x_i * (A x)_i of the single points
+    Eigen::VectorXd smoothness_cost = Eigen::VectorXd::Zero(num_vars_free_);
+    Eigen::VectorXd smoothness_derivative(num_vars_all_);
+    for (int j = 0; j < num_joints_; ++j)
+    {
+      joint_costs_[j].getDerivative(rollouts_[k].col(j), smoothness_derivative);
+      smoothness_cost += 0.5 * rollouts_[k].block(free_vars_start_, j, num_vars_free_, 1).cwiseProduct(
+                                   smoothness_derivative.segment(free_vars_start_, num_vars_free_));
+    }
+
+    double collision_cost = 0.0;
+    for (int i = 0; i < num_vars_free_; ++i)
+    {
+      double obstacle_cost = 0.0;
+      for (const collision_detection::GradientInfo& info : rollout_gsrs_[k * num_vars_free_ + i]->gradients_)
+      {
+        for (size_t l = 0; l < info.sphere_radii.size(); ++l)
+          obstacle_cost += getObstaclePotential(info.distances[l], info.sphere_radii[l], parameters_->min_clearance_);
+      }
+      obstacle_cost *= parameters_->obstacle_cost_weight_;
+      collision_cost += obstacle_cost;
+      rollout_costs_(i, k) = obstacle_cost + parameters_->smoothness_cost_weight_ * smoothness_cost(i);
+    }
+    rollout_collision_costs_(k) = collision_cost;
+  }
+}
+
+void StompOptimizer::updateTrajectory()
+{
+  // a rollout is weighted at every point by the cost it accumulates from there to the goal
+  Eigen::MatrixXd costs_to_go = rollout_costs_.rightCols(num_rollouts_ - 1);
+  for (int i = num_vars_free_ - 2; i >= 0; --i)
+    costs_to_go.row(i) += costs_to_go.row(i + 1);
+
+  Eigen::MatrixXd update = Eigen::MatrixXd::Zero(num_vars_free_, num_joints_);
+  for (int i = 0; i < num_vars_free_; ++i)
+  {
+    const double min_cost = costs_to_go.row(i).minCoeff();
+    const double cost_range = costs_to_go.row(i).maxCoeff() - min_cost;
+    Eigen::ArrayXd weights = Eigen::ArrayXd::Ones(num_rollouts_ - 1);
+    if (cost_range > 1e-10)
+      weights = (-parameters_->stomp_cost_sensitivity_ * (costs_to_go.row(i).transpose().array() - min_cost) /
+                 cost_range)
+                    .exp();
+    weights /= weights.sum();
+
+    for (int k = 1; k < num_rollouts_; ++k)
+      update.row(i) += weights(k - 1) * rollout_noise_[k].row(i);
+  }
+
+  // the weights vary along the trajectory, so the update is smoothed through the inverse of the smoothness cost,
+  // keeping the magnitude of the averaged noise
+#pragma omp parallel for num_threads(num_threads_)
+  for (int j = 0; j < num_joints_; ++j)
+  {
+    Eigen::VectorXd smoothed_update = joint_costs_[j].applyQuadraticCostInverse(update.col(j));
+    const double smoothed_max = smoothed_update.cwiseAbs().maxCoeff();
+    if (smoothed_max > 0.0)
+      smoothed_update *=
+          std::min(update.col(j).cwiseAbs().maxCoeff(), parameters_->joint_update_limit_) / smoothed_max;
+    group_trajectory_.getFreeJointTrajectoryBlock(j) += smoothed_update;
+  }
+  clampToJointLimits(group_trajectory_.getTrajectory());
+}
+
+void StompOptimizer::clampToJointLimits(Eigen::MatrixXd& trajectory) const
+{
+  for (int j = 0; j < num_joints_; ++j)
+  {
+    trajectory.block(free_vars_start_, j, num_vars_free_, 1) = trajectory.block(free_vars_start_, j, num_vars_free_, 1)
+                                                                   .cwiseMax(joint_limits_[j].first)
+                                                                   .cwiseMin(joint_limits_[j].second);
+  }
+}
+
+void StompOptimizer::updateFullTrajectory()
+{
+  full_trajectory_->updateFromGroupTrajectory(group_trajectory_);
+}
+
+bool StompOptimizer::isCurrentTrajectoryMeshToMeshCollisionFree() const
+{
+  moveit_msgs::RobotTrajectory traj;
+  traj.joint_trajectory.joint_names = joint_names_;
+
+  const Eigen::MatrixXd& trajectory = rollouts_[0];
+  for (int i = 0; i < num_vars_all_; i++)
+  {
+    trajectory_msgs::JointTrajectoryPoint point;
+    for (int j = 0; j < num_joints_; j++)
+    {
+      point.positions.push_back(trajectory(i, j));
+    }
+    traj.joint_trajectory.points.push_back(point);
+  }
+  moveit_msgs::RobotState start_state_msg;
+  moveit::core::robotStateToRobotStateMsg(start_state_, start_state_msg);
+  return planning_scene_->isPathValid(start_state_msg, traj, planning_group_);
+}
+}  // namespace chomp
@@ -153,6 +153,11 @@ public:
       ROS_INFO_STREAM(
           "Param use_stochastic_descent was not set. Using default value: " << params_.use_stochastic_descent_);
     }
+    if (!nh.getParam("num_threads", params_.num_threads_))
+    {
+      params_.num_threads_ = 0;
+      ROS_INFO_STREAM("Param num_threads was not set. Using default value: " << params_.num_threads_);
+    }
     // default
     params_.trajectory_initialization_method_ = std::string("fillTrajectory");
     std::string trajectory_initialization_method;
@@ -167,6 +172,21 @@ public:
                        << trajectory_initialization_method << "'. Using '" << params_.trajectory_initialization_method_
                        << "' instead.");
     }
+    if (!nh.getParam("trajectory_cache_size", params_.trajectory_cache_size_))
+    {
+      params_.trajectory_cache_size_ = 0;
+      ROS_INFO_STREAM(
+          "Param trajectory_cache_size was not set. Using default value: " << params_.trajectory_cache_size_);
+    }
+    if (!nh.getParam("trajectory_cache_tolerance", params_.trajectory_cache_tolerance_))
+    {
+      params_.trajectory_cache_tolerance_ = 0.1;
+      ROS_INFO_STREAM(
+          "Param trajectory_cache_tolerance was not set. Using default value: " << params_.trajectory_cache_tolerance_);
+    }
+    if (params_.trajectory_cache_size_ > 0)
+      trajectory_cache_ =
+          std::make_shared<ChompTrajectoryCache>(params_.trajectory_cache_size_, params_.trajectory_cache_tolerance_);
   }
 
   std::string getDescription() const override
@@ -193,6 +213,7 @@ public:
     planning_scene->setActiveCollisionDetector(hybrid_cd, true);
 
     chomp::ChompPlanner chomp_planner;
+    chomp_planner.setTrajectoryCache(trajectory_cache_);
     planning_interface::MotionPlanDetailedResponse res_detailed;
     res_detailed.trajectory_.push_back(res.trajectory_);
 
@@ -210,6 +231,7 @@ public:
 
 private:
   chomp::ChompParameters params_;
+  ChompTrajectoryCachePtr trajectory_cache_;  // shared by all requests, the OMPL path seeds cache misses
 };
 }  // namespace chomp
 
@@ -0,0 +1,90 @@
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2026, PickNik LLC.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of PickNik LLC nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *********************************************************************/
+
+#pragma once
+
+#include <moveit/ompl_interface/detail/state_validity_checker.h>
+#include <ompl/base/MotionValidator.h>
+
+namespace ompl_interface
+{
+OMPL_CLASS_FORWARD(StateValidityChecker);
+class ModelBasedPlanningContext;
+
+/** @class ClearanceMotionValidator
+    @brief Motion validator that adapts the collision checking resolution to the distance to obstacles.
+
+    For every joint of the planning group, the validator precomputes how far any point of the robot
+    (including the bodies attached in the initial state) can move per unit of motion of that joint.
+    The sum of these bounds over a motion bounds the swept distance of every point on the robot, so
+    when a state along the motion has clearance \e d, the next \e d of swept distance is collision free
+    and can be skipped. Steps are never smaller than those of OMPL's DiscreteMotionValidator.
+
+    Intermediate states are checked one step at a time when there are path constraints, when the
+    collision checker does not report distances or when the group contains planar or floating joints,
+    for which no bound is available. */
+class ClearanceMotionValidator : public ompl::base::MotionValidator
+{
+public:
+  ClearanceMotionValidator(const ompl::base::SpaceInformationPtr& si, const ModelBasedPlanningContext* pc,
+                           const StateValidityCheckerPtr& checker);
+
+  bool checkMotion(const ompl::base::State* s1, const ompl::base::State* s2) const override;
+  bool checkMotion(const ompl::base::State* s1, const ompl::base::State* s2,
+                   std::pair<ompl::base::State*, double>& last_valid) const override;
+
+  /** \brief Get the bound on the distance any point of the robot moves along the motion from \e s1 to \e s2
+      (infinity if no bound is available) */
+  double getSweptDistanceBound(const ompl::base::State* s1, const ompl::base::State* s2) const;
+
+protected:
+  /** \brief Check the states of the motion in order, starting at \e s1 and ending just before \e s2.
+      Return the fraction of the motion up to the last valid state, or a negative value if all states are valid. */
+  double checkStates(const ompl::base::State* s1, const ompl::base::State* s2) const;
+
+  struct JointReach
+  {
+    // index of the first variable of the joint in the OMPL state
+    int index;
+    const moveit::core::JointModel* joint;
+    // distance a point of the robot moves at most per unit of joint distance
+    double reach;
+  };
+
+  StateValidityCheckerPtr checker_;
+  bool has_path_constraints_;
+  std::vector<JointReach> reaches_;
+  bool bounded_;
+};
+}  // namespace ompl_interface
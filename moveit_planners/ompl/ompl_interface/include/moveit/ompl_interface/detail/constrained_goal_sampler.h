@@ -43,20 +43,41 @@
 #include <moveit/robot_state/robot_state.h>
 #include <moveit/robot_model/joint_model_group.h>
 
+#include <boost/lockfree/queue.hpp>
+#include <atomic>
+#include <thread>
+
 namespace ompl_interface
 {
 class ModelBasedPlanningContext;
 
 /** @class ConstrainedGoalSampler
- *  An interface to the OMPL goal lazy sampler*/
+ *  An interface to the OMPL goal lazy sampler.
+ *
+ *  When the planner configuration sets 'goal_sampling_threads', that many extra threads sample goals
+ *  with their own constraint samplers, seeded from the start state and from random states. Their goals
+ *  are passed to OMPL's sampling thread through a lock-free queue. The kinematics solver of the group
+ *  must then support concurrent queries. */
 class ConstrainedGoalSampler : public ompl::base::GoalLazySamples
 {
 public:
   ConstrainedGoalSampler(const ModelBasedPlanningContext* pc, kinematic_constraints::KinematicConstraintSetPtr ks,
                          constraint_samplers::ConstraintSamplerPtr cs = constraint_samplers::ConstraintSamplerPtr());
+  ~ConstrainedGoalSampler() override;
+
+  /** \brief Get the number of threads that sample goals in addition to OMPL's sampling thread */
+  unsigned int getSamplingThreadCount() const
+  {
+    return sampling_thread_count_;
+  }
 
 private:
   bool sampleUsingConstraintSampler(const ompl::base::GoalLazySamples* gls, ompl::base::State* new_goal);
+  bool sampleGoal(const ompl::base::GoalLazySamples* gls, ompl::base::State* new_goal);
+  void startSamplingThreads();
+  void stopSamplingThreads();
+  void sampleInThread(unsigned int index, const constraint_samplers::ConstraintSamplerPtr& sampler);
+  bool popSampledGoal(ompl::base::State* new_goal);
   bool stateValidityCallback(ompl::base::State* new_goal, moveit::core::RobotState const* state,
                              const moveit::core::JointModelGroup* /*jmg*/, const double* /*jpos*/,
                              bool verbose = false) const;
@@ -71,5 +92,12 @@ private:
   unsigned int invalid_sampled_constraints_;
   bool warned_invalid_samples_;
   unsigned int verbose_display_;
+
+  unsigned int sampling_thread_count_;
+  std::vector<std::thread> sampling_threads_;
+  std::atomic<bool> stop_sampling_threads_;
+  std::atomic<unsigned int> sampling_thread_attempts_;
+  std::atomic<unsigned int> queued_goal_count_;
+  boost::lockfree::queue<ompl::base::State*> sampled_goals_;
 };
 }  // namespace ompl_interface
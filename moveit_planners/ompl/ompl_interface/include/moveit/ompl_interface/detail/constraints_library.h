@@ -41,6 +41,9 @@
 #include <moveit/kinematic_constraints/kinematic_constraint.h>
 #include <ompl/base/StateStorage.h>
 #include <boost/serialization/map.hpp>
+#include <cstdint>
+#include <limits>
+#include <memory>
 
 namespace ompl_interface
 {
@@ -48,6 +51,61 @@ typedef std::pair<std::vector<std::size_t>, std::map<std::size_t, std::pair<std:
     ConstrainedStateMetadata;
 typedef ompl::base::StateStorageWithMetadata<ConstrainedStateMetadata> ConstraintApproximationStateStorage;
 
+/** \brief For every milestone of a constraint approximation, the indices of its nearest milestones ordered by
+    increasing distance. The index is computed once when the approximation is constructed and stored with it, so
+    it can be used directly from a memory-mapped database file. */
+class NearestMilestoneIndex
+{
+public:
+  /** \brief Marks unused entries when a milestone has fewer than getNeighborCount() neighbors */
+  static constexpr std::uint64_t INVALID = std::numeric_limits<std::uint64_t>::max();
+
+  NearestMilestoneIndex() = default;
+
+  /** \brief Take ownership of \e neighbors, which holds \e k entries per milestone */
+  NearestMilestoneIndex(std::size_t k, std::vector<std::uint64_t> neighbors);
+
+  /** \brief Refer to \e milestones * \e k entries at \e data, which stay valid as long as \e storage is alive */
+  NearestMilestoneIndex(std::size_t k, std::size_t milestones, const std::uint64_t* data,
+                        std::shared_ptr<const void> storage);
+
+  /** \brief The maximum number of neighbors stored per milestone */
+  std::size_t getNeighborCount() const
+  {
+    return k_;
+  }
+
+  std::size_t getMilestoneCount() const
+  {
+    return milestones_;
+  }
+
+  /** \brief The getNeighborCount() neighbors of \e milestone, padded with INVALID */
+  const std::uint64_t* getNeighbors(std::size_t milestone) const
+  {
+    return data_ + milestone * k_;
+  }
+
+private:
+  std::size_t k_ = 0;
+  std::size_t milestones_ = 0;
+  const std::uint64_t* data_ = nullptr;
+  std::shared_ptr<const void> storage_;
+};
+
+/** \brief Check whether \e filename holds a constraint approximation in the binary database format */
+bool isConstraintApproximationFile(const std::string& filename);
+
+/** \brief Store \e storage, its milestone count and its nearest milestone index in the binary database format.
+    States are written with the state space serialization, connections as flat index arrays. */
+bool storeConstraintApproximationFile(const std::string& filename, const ConstraintApproximationStateStorage& storage,
+                                      std::size_t milestones, const NearestMilestoneIndex& nearest_milestones);
+
+/** \brief Load a file written by storeConstraintApproximationFile() into the empty \e storage. The file is
+    memory-mapped; \e nearest_milestones refers to the mapping directly instead of copying it. */
+bool loadConstraintApproximationFile(const std::string& filename, ConstraintApproximationStateStorage& storage,
+                                     std::size_t& milestones, NearestMilestoneIndex& nearest_milestones);
+
 MOVEIT_CLASS_FORWARD(ConstraintApproximation);
 
 class ConstraintApproximation
@@ -110,6 +168,16 @@ public:
     return ompldb_filename_;
   }
 
+  const NearestMilestoneIndex& getNearestMilestoneIndex() const
+  {
+    return nearest_milestones_;
+  }
+
+  void setNearestMilestoneIndex(const NearestMilestoneIndex& nearest_milestones)
+  {
+    nearest_milestones_ = nearest_milestones;
+  }
+
 protected:
   std::string group_;
   std::string state_space_parameterization_;
@@ -123,6 +191,7 @@ protected:
   ompl::base::StateStoragePtr state_storage_ptr_;
   ConstraintApproximationStateStorage* state_storage_;
   std::size_t milestones_;
+  NearestMilestoneIndex nearest_milestones_;
 };
 
 struct ConstraintApproximationConstructionOptions
@@ -134,6 +203,8 @@ struct ConstraintApproximationConstructionOptions
     , explicit_motions(false)
     , explicit_points_resolution(0.0)
     , max_explicit_points(0)
+    , nearest_neighbors(16)
+    , num_threads(0)
   {
   }
 
@@ -144,6 +215,10 @@ struct ConstraintApproximationConstructionOptions
   bool explicit_motions;
   double explicit_points_resolution;
   unsigned int max_explicit_points;
+  /** \brief Number of nearest milestones stored per milestone; they are also the candidates for edges */
+  unsigned int nearest_neighbors;
+  /** \brief Number of threads used for construction, 0 to use the OpenMP default */
+  unsigned int num_threads;
 };
 
 struct ConstraintApproximationConstructionResults
@@ -194,7 +269,8 @@ private:
   constructConstraintApproximation(ModelBasedPlanningContext* pcontext, const moveit_msgs::Constraints& constr_sampling,
                                    const moveit_msgs::Constraints& constr_hard,
                                    const ConstraintApproximationConstructionOptions& options,
-                                   ConstraintApproximationConstructionResults& result);
+                                   ConstraintApproximationConstructionResults& result,
+                                   NearestMilestoneIndex& nearest_milestones);
 
   ModelBasedPlanningContext* context_;
   std::map<std::string, ConstraintApproximationPtr> constraint_approximations_;
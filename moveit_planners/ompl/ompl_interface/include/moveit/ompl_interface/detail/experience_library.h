@@ -0,0 +1,95 @@
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2026, PickNik LLC.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of PickNik LLC nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *********************************************************************/
+
+#pragma once
+
+#include <moveit/macros/class_forward.h>
+#include <moveit/planning_scene/planning_scene.h>
+
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace ompl_interface
+{
+MOVEIT_CLASS_FORWARD(ExperienceLibrary);  // Defines ExperienceLibraryPtr, ConstPtr, WeakPtr... etc
+
+/** @class ExperienceLibrary
+    @brief Solved paths of a planner configuration, reused for similar requests (experience-based planning).
+
+    The waypoints of a path are stored as joint group positions, together with a hash of the scene the path was
+    planned in. Paths are looked up by their start and goal; the ModelBasedPlanningContext repairs a retrieved path
+    in the current scene while planning from scratch, and uses whichever finishes first. The library is shared
+    by all contexts of a planner configuration and is safe to use concurrently. */
+class ExperienceLibrary
+{
+public:
+  struct Experience
+  {
+    std::vector<std::vector<double>> waypoints;
+    std::size_t scene_hash;
+  };
+  typedef std::shared_ptr<const Experience> ExperienceConstPtr;
+
+  /** \brief Create a library holding at most \e max_size paths. If \e path is not empty, the library is loaded
+      from that file and stored back to it on destruction. */
+  ExperienceLibrary(std::size_t max_size, const std::string& path = "");
+  ~ExperienceLibrary();
+
+  /** \brief Add a solved path. An experience of the same scene whose start and goal are within \e tolerance of
+      the new path's (Euclidean distance of the joint group positions) is replaced. When the library is full,
+      the oldest experience is dropped. */
+  void add(std::vector<std::vector<double>> waypoints, std::size_t scene_hash, double tolerance = 1e-3);
+
+  /** \brief Get the stored experiences, oldest first */
+  std::vector<ExperienceConstPtr> getExperiences() const;
+
+  std::size_t size() const;
+
+  bool load(const std::string& path);
+  bool store(const std::string& path) const;
+
+private:
+  std::size_t max_size_;
+  std::string path_;
+  std::deque<ExperienceConstPtr> experiences_;
+  mutable std::mutex lock_;
+};
+
+/** \brief Hash of the world objects (ids and world-frame bounding boxes) of \e scene. Paths planned in scenes with
+    the same hash were planned among the same obstacles. */
+std::size_t computeSceneHash(const planning_scene::PlanningScene& scene);
+}  // namespace ompl_interface
@@ -52,7 +52,8 @@ namespace ompl_interface
 class ModelBasedPlanningContext;
 
 /** @class ProjectionEvaluatorLinkPose
-    @brief */
+    @brief Projects onto the position of a link. The link transform computed when the state was validity
+    checked is used when it is still available, so forward kinematics often does not need to run again. */
 class ProjectionEvaluatorLinkPose : public ompl::base::ProjectionEvaluator
 {
 public:
@@ -82,4 +83,39 @@ public:
 private:
   std::vector<unsigned int> variables_;
 };
+
+/** @class ProjectionEvaluatorPCA
+    @brief Projects onto the principal components of the joint values of valid states.
+
+    The components are learned the first time the projection is set up with a validity checker, from
+    uniformly sampled states that are valid. Cell sizes follow the spread of the samples along each
+    component. */
+class ProjectionEvaluatorPCA : public ompl::base::ProjectionEvaluator
+{
+public:
+  ProjectionEvaluatorPCA(const ModelBasedPlanningContext* pc, unsigned int dimension, unsigned int samples = 1000);
+
+  unsigned int getDimension() const override;
+  void defaultCellSizes() override;
+  void setup() override;
+  void project(const ompl::base::State* state, OMPLProjection projection) const override;
+
+  /** \brief Check whether the components were learned from valid states */
+  bool isLearned() const
+  {
+    return learned_;
+  }
+
+private:
+  void learn();
+
+  const ModelBasedPlanningContext* planning_context_;
+  unsigned int dimension_;
+  unsigned int samples_;
+  bool learned_;
+  Eigen::VectorXd mean_;
+  // one principal component per row, largest variance first
+  Eigen::MatrixXd components_;
+  Eigen::VectorXd extents_;
+};
 }  // namespace ompl_interface
@@ -0,0 +1,86 @@
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2026, PickNik LLC.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of PickNik LLC nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *********************************************************************/
+
+#pragma once
+
+#include <moveit/planning_scene/planning_scene.h>
+#include <ompl/base/PlannerData.h>
+
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+
+namespace ompl_interface
+{
+/** @class RoadmapSceneSnapshot
+    @brief The world a multi-query roadmap was validated in: the bounding box of each world object and
+    the names of the bodies attached to the robot.
+
+    Comparing the snapshot of the next planning scene to the previous one yields the volumes in which
+    roadmap edges may have become invalid. Changes to the allowed collision matrix are not tracked. */
+class RoadmapSceneSnapshot
+{
+public:
+  RoadmapSceneSnapshot() = default;
+  RoadmapSceneSnapshot(const planning_scene::PlanningScene& scene, const moveit::core::RobotState& start_state);
+
+  /** \brief Get the bounding boxes of the objects that were added or changed in \e next.
+      Removed objects cannot invalidate edges and are not returned. */
+  std::vector<Eigen::AlignedBox3d> getChangedVolumes(const RoadmapSceneSnapshot& next) const;
+
+  bool hasSameAttachedBodies(const RoadmapSceneSnapshot& other) const
+  {
+    return attached_bodies_ == other.attached_bodies_;
+  }
+
+  /** \brief Load the snapshot from \e path. Returns false if the file cannot be read. */
+  bool load(const std::string& path);
+
+  /** \brief Store the snapshot to \e path. Returns false if the file cannot be written. */
+  bool store(const std::string& path) const;
+
+private:
+  std::map<std::string, Eigen::AlignedBox3d> objects_;
+  std::set<std::string> attached_bodies_;
+};
+
+/** \brief Remove the vertices and edges of the roadmap \e data whose swept volume intersects any of \e volumes.
+
+    The swept volume of an edge is bounded by the boxes around the links of the planning group (and the bodies
+    attached to them) at consecutive states along the edge, sampled at the resolution used for motion validation.
+    \e robot_state is used as scratch state and provides the attached bodies. Returns the number of removed edges. */
+std::size_t pruneRoadmap(ompl::base::PlannerData& data, const std::vector<Eigen::AlignedBox3d>& volumes,
+                         moveit::core::RobotState& robot_state);
+}  // namespace ompl_interface
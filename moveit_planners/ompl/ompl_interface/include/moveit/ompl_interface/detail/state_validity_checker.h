@@ -53,7 +53,7 @@ public:
 
   bool isValid(const ompl::base::State* state) const override
   {
-    return isValid(state, verbose_);
+    return lazy_collision_checking_ ? satisfiesConstraints(state, verbose_) : isValid(state, verbose_);
   }
 
   bool isValid(const ompl::base::State* state, double& dist) const override
@@ -67,15 +67,41 @@ public:
     return isValid(state, dist, verbose_);
   }
 
+  /** \brief Full validity check (bounds, path constraints, feasibility and collisions), also in lazy mode */
   bool isValid(const ompl::base::State* state, bool verbose) const;
   bool isValid(const ompl::base::State* state, double& dist, bool verbose) const;
 
+  /** \brief Check only bounds, path constraints and feasibility of \e state, but not collisions.
+      A positive result is cached in the state, so a later full check only needs to check collisions. */
+  bool satisfiesConstraints(const ompl::base::State* state, bool verbose) const;
+
   virtual double cost(const ompl::base::State* state) const;
   double clearance(const ompl::base::State* state) const override;
 
   void setVerbose(bool flag);
 
+  /** \brief Get the RobotState in which the calling thread last checked \e state, if it still holds the values
+      of \e state and its link transforms are up to date. Returns nullptr otherwise. */
+  const moveit::core::RobotState* getCheckedRobotState(const ompl::base::State* state) const;
+
+  /** \brief In lazy mode, isValid(state) only checks the cheap constraints and collision checking is
+      deferred to motion validation (see LazyMotionValidator), so states that never become part of
+      an edge are never collision checked. */
+  void setLazyCollisionChecking(bool flag);
+
+  bool getLazyCollisionChecking() const
+  {
+    return lazy_collision_checking_;
+  }
+
 protected:
+  /** \brief Check the cheap constraints of \e state. If the check was not answered from the cached
+      information, \e robot_state is set to the state storage holding the state, otherwise it is nullptr. */
+  bool checkConstraints(const ompl::base::State* state, moveit::core::RobotState*& robot_state, bool verbose) const;
+
+  /** \brief The RobotState \e state is bound to, or the thread's state storage holding a copy of \e state */
+  moveit::core::RobotState* getRobotState(const ompl::base::State* state) const;
+
   const ModelBasedPlanningContext* planning_context_;
   std::string group_name_;
   TSStateStorage tss_;
@@ -86,5 +112,6 @@ protected:
 
   collision_detection::CollisionRequest collision_request_with_cost_;
   bool verbose_;
+  bool lazy_collision_checking_;
 };
 }  // namespace ompl_interface
@@ -37,11 +37,15 @@
 #pragma once
 
 #include <moveit/robot_state/robot_state.h>
+#include <cstdint>
 #include <thread>
 #include <mutex>
 
 namespace ompl_interface
 {
+/** \brief A RobotState for every thread that uses the storage, each initialized to the start state.
+    Lookups are answered from a small thread-local cache without locking; the mutex is only taken the first
+    time a thread asks for its state. */
 class TSStateStorage
 {
 public:
@@ -52,7 +56,12 @@ public:
   moveit::core::RobotState* getStateStorage() const;
 
 private:
+  moveit::core::RobotState* getStateStorageSlow() const;
+
   moveit::core::RobotState start_state_;
+
+  /// Unique over the lifetime of the process, so that cached entries of destroyed storages never match
+  const std::uint64_t id_;
   mutable std::map<std::thread::id, moveit::core::RobotState*> thread_states_;
   mutable std::mutex lock_;
 };
@@ -37,8 +37,10 @@
 #pragma once
 
 #include <moveit/ompl_interface/parameterization/model_based_state_space.h>
+#include <moveit/ompl_interface/detail/experience_library.h>
 #include <moveit/constraint_samplers/constraint_sampler_manager.h>
 #include <moveit/planning_interface/planning_interface.h>
+#include <moveit/robot_state/robot_state_pool.h>
 
 #include <ompl/geometric/SimpleSetup.h>
 #include <ompl/tools/benchmark/Benchmark.h>
@@ -68,6 +70,8 @@ struct ModelBasedPlanningContextSpecification
 
   ModelBasedStateSpacePtr state_space_;
   og::SimpleSetupPtr ompl_simple_setup_;  // pass in the correct simple setup type
+
+  ExperienceLibraryPtr experience_library_;  // optional, solved paths shared by the contexts of a configuration
 };
 
 class ModelBasedPlanningContext : public planning_interface::PlanningContext
@@ -241,6 +245,7 @@ public:
   void setConstraintsApproximations(const ConstraintsLibraryPtr& constraints_library)
   {
     constraints_library_ = constraints_library;
+    loaded_constraint_approximations_path_.clear();
   }
 
   ConstraintsLibraryPtr getConstraintsLibraryNonConst()
@@ -268,11 +273,77 @@ public:
     interpolate_ = flag;
   }
 
+  bool getPipelinedSimplification() const
+  {
+    return pipelined_simplification_;
+  }
+
+  /** \brief Simplify solutions while planning continues: every path found is handed to a simplification thread and
+      the planner searches again for another one. The simplified paths are hybridized with the best one so far. The
+      planner runs until the time limit, so the full planning time is used. */
+  void setPipelinedSimplification(bool flag)
+  {
+    pipelined_simplification_ = flag;
+  }
+
+  unsigned int getSimplificationThreads() const
+  {
+    return simplification_threads_;
+  }
+
+  /** \brief Set the number of threads that simplify paths in pipelined simplification mode */
+  void setSimplificationThreads(unsigned int threads)
+  {
+    simplification_threads_ = threads;
+  }
+
   void setHybridize(bool flag)
   {
     hybridize_ = flag;
   }
 
+  /** \brief Get the number of planners that run concurrently in portfolio mode (0 if the mode is not used) */
+  std::size_t getPortfolioSize() const
+  {
+    return portfolio_.size();
+  }
+
+  bool getLazyCollisionChecking() const
+  {
+    return lazy_collision_checking_;
+  }
+
+  /** \brief Defer collision checks of sampled states to motion validation. Takes effect on the next configure(). */
+  void setLazyCollisionChecking(bool flag)
+  {
+    lazy_collision_checking_ = flag;
+  }
+
+  bool getAdaptiveMotionValidation() const
+  {
+    return adaptive_motion_validation_;
+  }
+
+  /** \brief Take collision checking steps along motions that grow with the distance to obstacles.
+      Not used in lazy mode. Takes effect on the next configure(). */
+  void setAdaptiveMotionValidation(bool flag)
+  {
+    adaptive_motion_validation_ = flag;
+  }
+
+  bool getProjectPathConstraints() const
+  {
+    return project_path_constraints_;
+  }
+
+  /** \brief Project sampled and interpolated states onto the path constraints with Jacobian steps.
+      Only used for chain groups and when no constraint approximation is available. Takes effect on the next
+      configure(). */
+  void setProjectPathConstraints(bool flag)
+  {
+    project_path_constraints_ = flag;
+  }
+
   /* @brief Solve the planning problem. Return true if the problem is solved
      @param timeout The time to spend on solving
      @param count The number of runs to combine the paths of, in an attempt to generate better quality paths
@@ -299,6 +370,25 @@ public:
     return last_simplify_time_;
   }
 
+  /* @brief Get the amount of time spent in the last call to configure() */
+  double getLastSetupTime() const
+  {
+    return last_setup_time_;
+  }
+
+  /* @brief True if the last call to configure() kept the planner and settings of the previous request, because the
+     planner configuration did not change */
+  bool isLastSetupPartial() const
+  {
+    return last_setup_partial_;
+  }
+
+  /** \brief Return true if the last solution was repaired from a stored experience instead of planned from scratch */
+  bool isLastSolutionFromExperience() const
+  {
+    return last_solution_from_experience_;
+  }
+
   /* @brief Apply smoothing and try to simplify the plan
      @param timeout The amount of time allowed to be spent on simplifying the plan*/
   void simplifySolution(double timeout);
@@ -312,7 +402,7 @@ public:
   void convertPath(const og::PathGeometric& pg, robot_trajectory::RobotTrajectory& traj) const;
 
   /** @brief Look up param server 'constraint_approximations' and use its value as the path to load constraint
-   * approximations to */
+   * approximations to. Approximations already loaded from the same path are kept. */
   bool loadConstraintApproximations(const ros::NodeHandle& nh);
 
   /** @brief Look up param server 'constraint_approximations' and use its value as the path to save constraint
@@ -322,6 +412,8 @@ public:
   /** \brief Configure ompl_simple_setup_ and optionally the constraints_library_.
    *
    * ompl_simple_setup_ gets a start state, state sampler, and state validity checker.
+   * The planner, projection evaluator and space information parameters are only set up again (useConfig()) if the
+   * planner configuration changed since the last call; otherwise they are kept from the previous request.
    *
    * \param nh ROS node handle used to load the constraint approximations.
    * \param use_constraints_approximations Set to true if we want to load the constraint approximation.
@@ -337,6 +429,8 @@ protected:
 
   virtual ob::ProjectionEvaluatorPtr getProjectionEvaluator(const std::string& peval) const;
   virtual ob::StateSamplerPtr allocPathConstrainedSampler(const ompl::base::StateSpace* ss) const;
+  // interpolate in joint space and project the interpolated states onto the path constraints
+  void useProjectedInterpolation();
   virtual void useConfig();
   virtual ob::GoalPtr constructGoal();
 
@@ -371,6 +465,23 @@ protected:
   void registerTerminationCondition(const ob::PlannerTerminationCondition& ptc);
   void unregisterTerminationCondition();
 
+  /** \brief Get the stored experiences whose final state satisfies one of the goal constraints, the ones planned in
+      the current scene and closest to the start state first */
+  std::vector<ExperienceLibrary::ExperienceConstPtr> findExperiences() const;
+
+  /** \brief Adapt a stored experience to the current request: it is connected to the start state, waypoints that
+      became invalid are dropped and invalid segments are replanned with RRTConnect. */
+  bool repairExperience(const ExperienceLibrary::Experience& experience, const ob::PlannerTerminationCondition& ptc,
+                        og::PathGeometric& path) const;
+
+  /** \brief Add the current solution path to the experience library */
+  void recordExperience();
+
+  /** \brief Plan with ompl_simple_setup_ until \e planning_ptc, simplifying and hybridizing the paths found in
+      parallel until \e ptc. The best path becomes the solution. */
+  ob::PlannerStatus solvePipelined(const ob::PlannerTerminationCondition& planning_ptc,
+                                   const ob::PlannerTerminationCondition& ptc);
+
   /** \brief Convert OMPL PlannerStatus to moveit_msgs::msg::MoveItErrorCode */
   int32_t errorCode(const ompl::base::PlannerStatus& status);
 
@@ -378,6 +489,9 @@ protected:
 
   moveit::core::RobotState complete_initial_robot_state_;
 
+  /// memory for the waypoints of solution paths, reused across planning requests
+  moveit::core::RobotStatePoolPtr state_pool_;
+
   /// the OMPL planning context; this contains the problem definition and the planner used
   og::SimpleSetupPtr ompl_simple_setup_;
 
@@ -402,6 +516,26 @@ protected:
   /// the time spent simplifying the last plan
   double last_simplify_time_;
 
+  /// true if the last solution was retrieved from the experience library
+  bool last_solution_from_experience_;
+
+  /// true if the last solution was already simplified while planning
+  bool last_solution_simplified_;
+
+  /// the time spent in the last call to configure()
+  double last_setup_time_;
+
+  /// true if the last call to configure() reused the setup of the previous one
+  bool last_setup_partial_;
+
+  /// the planner configuration and segment length useConfig() was last run with, to detect when it has to run again
+  std::map<std::string, std::string> configured_config_;
+  double configured_max_solution_segment_length_;
+  bool configured_;
+
+  /// the path constraint approximations were last loaded from
+  std::string loaded_constraint_approximations_path_;
+
   /// maximum number of valid states to store in the goal region for any planning request (when such sampling is
   /// possible)
   unsigned int max_goal_samples_;
@@ -427,6 +561,9 @@ protected:
   /// when false, clears planners before running solve()
   bool multi_query_planning_enabled_;
 
+  /// when true, multi-query roadmaps keep their validity across requests, edges affected by scene changes are removed
+  bool scene_aware_roadmap_;
+
   ConstraintsLibraryPtr constraints_library_;
 
   bool simplify_solutions_;
@@ -436,5 +573,26 @@ protected:
 
   // if false parallel plan returns the first solution found
   bool hybridize_;
+
+  // if true sampled states are only collision checked as part of a motion
+  bool lazy_collision_checking_;
+
+  // if true motions are checked with steps that adapt to the distance to obstacles
+  bool adaptive_motion_validation_;
+
+  // if true states are projected onto the path constraints when sampling and interpolating
+  bool project_path_constraints_;
+
+  // if true solutions are simplified in parallel with continued planning
+  bool pipelined_simplification_;
+
+  // the number of threads that simplify solutions in pipelined mode
+  unsigned int simplification_threads_;
+
+  // planners of different types that run concurrently on the problem (parameter 'portfolio')
+  std::vector<ob::PlannerAllocator> portfolio_;
+
+  // if true the portfolio runs until the deadline and the best solution is used, otherwise the first one
+  bool portfolio_wait_for_best_;
 };
 }  // namespace ompl_interface
@@ -0,0 +1,94 @@
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2026, PickNik LLC.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of PickNik LLC nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *********************************************************************/
+
+#pragma once
+
+#include <moveit/ompl_interface/parameterization/model_based_state_space.h>
+
+namespace ompl_interface
+{
+/** \brief A joint space parameterization whose states keep their values inside a RobotState.
+ *
+ * The values of every state point into the variable storage of a RobotState owned by that state, so validity
+ * checking can use it in place instead of copying into a separate RobotState first (see getBoundRobotState()).
+ * The variables of the other joints are taken from the reference state. This trades the memory of a full
+ * RobotState per allocated state for the copies, and requires a group that is contiguous within the robot state. */
+class RobotStateBoundStateSpace : public ModelBasedStateSpace
+{
+public:
+  static const std::string PARAMETERIZATION_TYPE;
+
+  class BoundStateType : public StateType
+  {
+  public:
+    BoundStateType(const moveit::core::RobotState& reference_state, std::size_t first_variable_index,
+                   unsigned int generation)
+      : StateType(), robot_state(reference_state), reference_generation(generation)
+    {
+      values = robot_state.getVariablePositions() + first_variable_index;
+    }
+
+    moveit::core::RobotState robot_state;
+
+    /// The reference state generation the other joints of robot_state were copied from
+    unsigned int reference_generation;
+  };
+
+  RobotStateBoundStateSpace(const ModelBasedStateSpaceSpecification& spec);
+
+  const std::string& getParameterizationType() const override
+  {
+    return PARAMETERIZATION_TYPE;
+  }
+
+  ompl::base::State* allocState() const override;
+  void freeState(ompl::base::State* state) const override;
+
+  moveit::core::RobotState* getBoundRobotState(const ompl::base::State* state) const override;
+
+  /** \brief Set the values of the joints outside the group, for all states. Not thread-safe with respect to
+      planning, call it before planning starts. */
+  void setReferenceState(const moveit::core::RobotState& reference_state);
+
+  const moveit::core::RobotState& getReferenceState() const
+  {
+    return reference_state_;
+  }
+
+private:
+  moveit::core::RobotState reference_state_;
+  unsigned int reference_generation_;
+  std::size_t first_variable_index_;
+};
+}  // namespace ompl_interface
@@ -83,7 +83,8 @@ public:
       GOAL_DISTANCE_KNOWN = 2,
       VALIDITY_TRUE = 4,
       IS_START_STATE = 8,
-      IS_GOAL_STATE = 16
+      IS_GOAL_STATE = 16,
+      CONSTRAINTS_SATISFIED = 32
     };
 
     StateType() : ompl::base::State(), values(nullptr), tag(-1), flags(0), distance(0.0)
@@ -120,6 +121,17 @@ public:
       return flags & VALIDITY_KNOWN;
     }
 
+    /** \brief Bounds, path constraints and feasibility are satisfied; collisions may not be checked yet */
+    void markConstraintsSatisfied()
+    {
+      flags |= CONSTRAINTS_SATISFIED;
+    }
+
+    bool areConstraintsSatisfied() const
+    {
+      return flags & CONSTRAINTS_SATISFIED;
+    }
+
     void clearKnownInformation()
     {
       flags = 0;
@@ -254,6 +266,13 @@ public:
   virtual void copyJointToOMPLState(ompl::base::State* state, const moveit::core::RobotState& robot_state,
                                     const moveit::core::JointModel* joint_model, int ompl_state_joint_index) const;
 
+  /// Get the up-to-date RobotState that holds the values of \e state, if states of this space are bound to one.
+  //  Returns nullptr otherwise; use copyToRobotState() in that case.
+  virtual moveit::core::RobotState* getBoundRobotState(const ompl::base::State* /*state*/) const
+  {
+    return nullptr;
+  }
+
   double getTagSnapToSegment() const;
   void setTagSnapToSegment(double snap);
 
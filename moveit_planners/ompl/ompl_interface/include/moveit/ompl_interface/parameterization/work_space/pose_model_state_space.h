@@ -104,6 +104,9 @@ public:
 
   bool computeStateFK(ompl::base::State* state) const;
   bool computeStateIK(ompl::base::State* state) const;
+  /** \brief Compute the joint values of \e state from its pose, seeding IK with the joint values already stored in
+      \e state and, if that fails, with those of \e near (e.g. the tree neighbour the state was interpolated from) */
+  bool computeStateIK(ompl::base::State* state, const ompl::base::State* near) const;
   bool computeStateK(ompl::base::State* state) const;
 
   void setPlanningVolume(double minX, double maxX, double minY, double maxY, double minZ, double maxZ) override;
@@ -122,7 +125,9 @@ private:
                   const moveit::core::JointModelGroup::KinematicsSolver& k);
 
     bool computeStateFK(StateType* full_state, unsigned int idx) const;
-    bool computeStateIK(StateType* full_state, unsigned int idx) const;
+    bool computeStateIK(StateType* full_state, unsigned int idx, const StateType* near) const;
+    bool solveIK(const geometry_msgs::Pose& pose, const std::vector<double>& seed, std::vector<double>& solution,
+                 moveit_msgs::MoveItErrorCodes& err_code) const;
 
     bool operator<(const PoseComponent& o) const
     {
@@ -134,6 +139,8 @@ private:
     std::vector<unsigned int> bijection_;
     ompl::base::StateSpacePtr state_space_;
     std::vector<std::string> fk_link_;
+    /// the solver is analytic (e.g. IKFast) and returns all solutions for a pose in a single call
+    bool analytic_;
   };
 
   std::vector<PoseComponent> poses_;
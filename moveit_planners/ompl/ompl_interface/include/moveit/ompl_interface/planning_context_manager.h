@@ -37,12 +37,14 @@
 #pragma once
 
 #include <moveit/ompl_interface/model_based_planning_context.h>
+#include <moveit/ompl_interface/detail/roadmap_scene_snapshot.h>
 #include <moveit/ompl_interface/parameterization/model_based_state_space_factory.h>
 #include <moveit/constraint_samplers/constraint_sampler_manager.h>
 #include <moveit/macros/class_forward.h>
 
 #include <ompl/base/PlannerDataStorage.h>
 
+#include <functional>
 #include <string>
 #include <map>
 
@@ -58,7 +60,23 @@ public:
   ob::PlannerPtr allocatePlanner(const ob::SpaceInformationPtr& si, const std::string& new_name,
                                  const ModelBasedPlanningContextSpecification& spec);
 
+  /** @brief Bring the roadmap of the multi-query planner \e planner_name up to date with the planning scene of
+      the next request (parameter 'scene_aware_roadmap'). Only edges whose swept volume intersects objects that were
+      added or changed since the previous request are removed. A roadmap loaded from disk is compared to the scene
+      it was stored with. Must be called before the planner is allocated for the request. */
+  void updatePlanningScene(const std::string& planner_name, const planning_scene::PlanningScene& scene,
+                           const moveit::core::RobotState& start_state);
+
 private:
+  struct RoadmapScene
+  {
+    RoadmapSceneSnapshot snapshot;
+    moveit::core::RobotStatePtr robot_state;
+  };
+
+  ob::PlannerPtr updateRoadmap(const std::string& planner_name, const ob::PlannerPtr& planner,
+                               const RoadmapSceneSnapshot& previous, const RoadmapScene& next);
+
   template <typename T>
   ob::PlannerPtr allocatePlannerImpl(const ob::SpaceInformationPtr& si, const std::string& new_name,
                                      const ModelBasedPlanningContextSpecification& spec, bool load_planner_data = false,
@@ -74,6 +92,12 @@ private:
 
   // Store and load planner data
   ob::PlannerDataStorage storage_;
+
+  // Scene each scene-aware roadmap is valid in
+  std::map<std::string, RoadmapScene> roadmap_scenes_;
+
+  // Rebuild scene-aware planners from pruned planner data
+  std::map<std::string, std::function<ob::PlannerPtr(const ob::PlannerData&)>> persistent_planner_allocators_;
 };
 
 class PlanningContextManager
@@ -258,8 +282,8 @@ protected:
   /// needed)
   unsigned int minimum_waypoint_count_;
 
-  /// Multi-query planner allocator
-  MultiQueryPlannerAllocator planner_allocator_;
+  /// Multi-query planner allocator (mutable, as scene-aware roadmaps are updated when a context is requested)
+  mutable MultiQueryPlannerAllocator planner_allocator_;
 
 private:
   MOVEIT_STRUCT_FORWARD(CachedContexts);
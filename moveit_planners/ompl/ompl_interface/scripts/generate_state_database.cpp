@@ -73,6 +73,12 @@ struct GenerateStateDatabaseParameters
     construction_opts.explicit_points_resolution = nh.param("explicit_points_resolution", 0.05);
     construction_opts.max_explicit_points = nh.param("max_explicit_points", 200);
 
+    // nearest milestones stored with the database, also the candidates for edges
+    construction_opts.nearest_neighbors = nh.param("nearest_neighbors", 16);
+
+    // threads used for construction, 0 for one per core
+    construction_opts.num_threads = nh.param("num_threads", 0);
+
     // local planning in JointModel state space
     construction_opts.state_space_parameterization =
         nh.param<std::string>("state_space_parameterization", "JointModel");
@@ -0,0 +1,211 @@
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2026, PickNik LLC.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of PickNik LLC nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *********************************************************************/
+
+#include <moveit/ompl_interface/detail/clearance_motion_validator.h>
+#include <moveit/ompl_interface/model_based_planning_context.h>
+#include <geometric_shapes/shape_operations.h>
+#include <ompl/base/SpaceInformation.h>
+
+#include <cmath>
+#include <limits>
+
+namespace ompl_interface
+{
+namespace
+{
+// radius of a sphere about the link frame that contains the link's collision geometry and attached bodies
+double computeLinkRadius(const moveit::core::LinkModel* link,
+                         const std::vector<const moveit::core::AttachedBody*>& attached_bodies)
+{
+  double radius = 0.0;
+  if (!link->getShapes().empty())
+    radius = link->getCenteredBoundingBoxOffset().norm() + 0.5 * link->getShapeExtentsAtOrigin().norm();
+  for (const moveit::core::AttachedBody* body : attached_bodies)
+  {
+    if (body->getAttachedLink() != link)
+      continue;
+    for (std::size_t i = 0; i < body->getShapes().size(); ++i)
+      radius = std::max(radius, body->getShapePosesInLinkFrame()[i].translation().norm() +
+                                    0.5 * shapes::computeShapeExtents(body->getShapes()[i].get()).norm());
+  }
+  return radius;
+}
+
+// largest distance between the frame of link and any point of the robot below it, for any configuration
+double computeSubtreeRadius(const moveit::core::LinkModel* link,
+                            const std::vector<const moveit::core::AttachedBody*>& attached_bodies)
+{
+  double radius = computeLinkRadius(link, attached_bodies);
+  for (const moveit::core::JointModel* joint : link->getChildJointModels())
+  {
+    double travel = 0.0;
+    if (joint->getType() == moveit::core::JointModel::PRISMATIC)
+    {
+      const moveit::core::VariableBounds& bounds = joint->getVariableBounds()[0];
+      travel = std::max(std::fabs(bounds.min_position_), std::fabs(bounds.max_position_));
+    }
+    else if (joint->getType() == moveit::core::JointModel::PLANAR ||
+             joint->getType() == moveit::core::JointModel::FLOATING)
+      return std::numeric_limits<double>::infinity();
+    const moveit::core::LinkModel* child = joint->getChildLinkModel();
+    radius = std::max(radius, child->getJointOriginTransform().translation().norm() + travel +
+                                  computeSubtreeRadius(child, attached_bodies));
+  }
+  return radius;
+}
+
+// distance a point of the robot moves at most per unit of motion of joint (ignoring the joints it mimics)
+double computeJointReach(const moveit::core::JointModel* joint,
+                         const std::vector<const moveit::core::AttachedBody*>& attached_bodies)
+{
+  double reach;
+  switch (joint->getType())
+  {
+    case moveit::core::JointModel::REVOLUTE:
+      reach = computeSubtreeRadius(joint->getChildLinkModel(), attached_bodies);
+      break;
+    case moveit::core::JointModel::PRISMATIC:
+      reach = 1.0;
+      break;
+    default:
+      return std::numeric_limits<double>::infinity();
+  }
+  for (const moveit::core::JointModel* mimic : joint->getMimicRequests())
+    reach += std::fabs(mimic->getMimicFactor()) * computeJointReach(mimic, attached_bodies);
+  return reach;
+}
+}  // namespace
+}  // namespace ompl_interface
+
+ompl_interface::ClearanceMotionValidator::ClearanceMotionValidator(const ompl::base::SpaceInformationPtr& si,
+                                                                   const ModelBasedPlanningContext* pc,
+                                                                   const StateValidityCheckerPtr& checker)
+  : ompl::base::MotionValidator(si)
+  , checker_(checker)
+  , has_path_constraints_(static_cast<bool>(pc->getPathConstraints()))
+  , bounded_(true)
+{
+  std::vector<const moveit::core::AttachedBody*> attached_bodies;
+  pc->getCompleteInitialRobotState().getAttachedBodies(attached_bodies);
+
+  const moveit::core::JointModelGroup* jmg = pc->getJointModelGroup();
+  for (const moveit::core::JointModel* joint : jmg->getActiveJointModels())
+  {
+    const double reach = computeJointReach(joint, attached_bodies);
+    if (!std::isfinite(reach))
+    {
+      bounded_ = false;
+      break;
+    }
+    reaches_.push_back(JointReach{ jmg->getVariableGroupIndex(joint->getVariableNames()[0]), joint, reach });
+  }
+}
+
+double ompl_interface::ClearanceMotionValidator::getSweptDistanceBound(const ompl::base::State* s1,
+                                                                       const ompl::base::State* s2) const
+{
+  if (!bounded_)
+    return std::numeric_limits<double>::infinity();
+  const double* values1 = s1->as<ModelBasedStateSpace::StateType>()->values;
+  const double* values2 = s2->as<ModelBasedStateSpace::StateType>()->values;
+  double bound = 0.0;
+  for (const JointReach& jr : reaches_)
+    bound += jr.reach * jr.joint->distance(values1 + jr.index, values2 + jr.index);
+  return bound;
+}
+
+double ompl_interface::ClearanceMotionValidator::checkStates(const ompl::base::State* s1,
+                                                             const ompl::base::State* s2) const
+{
+  const double min_step = 1.0 / std::max(1u, si_->getStateSpace()->validSegmentCount(s1, s2));
+  const double bound = has_path_constraints_ ? std::numeric_limits<double>::infinity() :
+                                               getSweptDistanceBound(s1, s2);
+
+  double result = -1.0;
+  double last_valid = 0.0;
+  ompl::base::State* test = si_->allocState();
+  for (double t = 0.0; t < 1.0;)
+  {
+    if (t > 0.0)
+      si_->getStateSpace()->interpolate(s1, s2, t, test);
+    else
+      si_->copyState(test, s1);
+    double dist;
+    if (!checker_->isValid(test, dist, false))
+    {
+      result = last_valid;
+      break;
+    }
+    last_valid = t;
+
+    // no point of the robot moves farther than bound * step, so a step within the clearance is collision free
+    double step = min_step;
+    if (dist > 0.0 && std::isfinite(bound))
+      step = std::max(step, dist / bound);
+    t += step;
+  }
+  si_->freeState(test);
+  return result;
+}
+
+bool ompl_interface::ClearanceMotionValidator::checkMotion(const ompl::base::State* s1,
+                                                           const ompl::base::State* s2) const
+{
+  // like OMPL's DiscreteMotionValidator, the end of the motion is checked first
+  const bool result = si_->isValid(s2) && checkStates(s1, s2) < 0.0;
+  if (result)
+    valid_++;
+  else
+    invalid_++;
+  return result;
+}
+
+bool ompl_interface::ClearanceMotionValidator::checkMotion(const ompl::base::State* s1, const ompl::base::State* s2,
+                                                           std::pair<ompl::base::State*, double>& last_valid) const
+{
+  double t = checkStates(s1, s2);
+  if (t < 0.0 && !si_->isValid(s2))
+    t = 1.0 - 1.0 / std::max(1u, si_->getStateSpace()->validSegmentCount(s1, s2));
+
+  if (t < 0.0)
+  {
+    valid_++;
+    return true;
+  }
+  last_valid.second = t;
+  if (last_valid.first)
+    si_->getStateSpace()->interpolate(s1, s2, t, last_valid.first);
+  invalid_++;
+  return false;
+}
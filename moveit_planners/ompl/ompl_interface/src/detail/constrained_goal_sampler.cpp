@@ -38,7 +38,10 @@
 #include <moveit/ompl_interface/model_based_planning_context.h>
 #include <moveit/ompl_interface/detail/state_validity_checker.h>
 #include <moveit/profiler/profiler.h>
+#include <boost/lexical_cast.hpp>
+#include <random_numbers/random_numbers.h>
 
+#include <algorithm>
 #include <utility>
 
 namespace ompl_interface
@@ -62,13 +65,121 @@ ompl_interface::ConstrainedGoalSampler::ConstrainedGoalSampler(const ModelBasedP
   , invalid_sampled_constraints_(0)
   , warned_invalid_samples_(false)
   , verbose_display_(0)
+  , sampling_thread_count_(0)
+  , stop_sampling_threads_(false)
+  , sampling_thread_attempts_(0)
+  , queued_goal_count_(0)
+  , sampled_goals_(std::max(1u, pc->getMaximumGoalSamples()))
 {
   if (!constraint_sampler_)
     default_sampler_ = si_->allocStateSampler();
+
+  // the sampling threads need their own constraint samplers, which are only available from a sampler manager
+  const std::map<std::string, std::string>& config = pc->getSpecificationConfig();
+  auto it = config.find("goal_sampling_threads");
+  if (it != config.end() && constraint_sampler_ && pc->getSpecification().constraint_sampler_manager_)
+    sampling_thread_count_ = boost::lexical_cast<unsigned int>(it->second);
+
   ROS_DEBUG_NAMED(LOGNAME, "Constructed a ConstrainedGoalSampler instance at address %p", this);
   startSampling();
 }
 
+ompl_interface::ConstrainedGoalSampler::~ConstrainedGoalSampler()
+{
+  // OMPL's sampling thread uses the members of this class, so it is stopped before they are destroyed
+  stopSampling();
+  stopSamplingThreads();
+  ob::State* state;
+  while (sampled_goals_.pop(state))
+    si_->freeState(state);
+}
+
+void ompl_interface::ConstrainedGoalSampler::startSamplingThreads()
+{
+  if (sampling_thread_count_ == 0 || !sampling_threads_.empty())
+    return;
+
+  std::vector<constraint_samplers::ConstraintSamplerPtr> samplers;
+  for (unsigned int i = 0; i < sampling_thread_count_; ++i)
+  {
+    constraint_samplers::ConstraintSamplerPtr sampler =
+        planning_context_->getSpecification().constraint_sampler_manager_->selectSampler(
+            planning_context_->getPlanningScene(), planning_context_->getGroupName(),
+            kinematic_constraint_set_->getAllConstraints());
+    if (!sampler)
+      break;
+    samplers.push_back(sampler);
+  }
+
+  stop_sampling_threads_ = false;
+  sampling_thread_attempts_ = 0;
+  for (unsigned int i = 0; i < samplers.size(); ++i)
+    sampling_threads_.emplace_back([this, i, sampler = samplers[i]] { sampleInThread(i, sampler); });
+  ROS_DEBUG_NAMED(LOGNAME, "Started %zu goal sampling threads", sampling_threads_.size());
+}
+
+void ompl_interface::ConstrainedGoalSampler::stopSamplingThreads()
+{
+  stop_sampling_threads_ = true;
+  for (std::thread& thread : sampling_threads_)
+    thread.join();
+  sampling_threads_.clear();
+}
+
+void ompl_interface::ConstrainedGoalSampler::sampleInThread(unsigned int index,
+                                                            const constraint_samplers::ConstraintSamplerPtr& sampler)
+{
+  random_numbers::RandomNumberGenerator rng;
+  moveit::core::RobotState state(planning_context_->getCompleteInitialRobotState());
+  const moveit::core::JointModelGroup* jmg = planning_context_->getJointModelGroup();
+  const unsigned int max_attempts = planning_context_->getMaximumGoalSamplingAttempts();
+  const unsigned int max_samples = planning_context_->getMaximumGoalSamples();
+
+  ob::State* goal = si_->allocState();
+  sampler->setGroupStateValidityCallback([this, goal](moveit::core::RobotState* robot_state,
+                                                      const moveit::core::JointModelGroup* joint_group,
+                                                      const double* joint_group_variable_values) {
+    return stateValidityCallback(goal, robot_state, joint_group, joint_group_variable_values);
+  });
+
+  while (!stop_sampling_threads_ && sampling_thread_attempts_++ < max_attempts &&
+         getStateCount() + queued_goal_count_ < max_samples &&
+         !planning_context_->getOMPLSimpleSetup()->getProblemDefinition()->hasSolution())
+  {
+    // the first thread seeds the constraint sampler with the start state, the others with random states
+    if (index > 0)
+      state.setToRandomPositions(jmg, rng);
+    if (!sampler->sample(state, planning_context_->getMaximumStateSamplingAttempts()))
+      continue;
+    state.update();
+    if (!kinematic_constraint_set_->decide(state).satisfied || !checkStateValidity(goal, state))
+      continue;
+    if (!sampled_goals_.bounded_push(goal))
+      break;
+    queued_goal_count_++;
+
+    // the validity callback writes into the goal state, so a new one is used for the next sample
+    goal = si_->allocState();
+    sampler->setGroupStateValidityCallback([this, goal](moveit::core::RobotState* robot_state,
+                                                        const moveit::core::JointModelGroup* joint_group,
+                                                        const double* joint_group_variable_values) {
+      return stateValidityCallback(goal, robot_state, joint_group, joint_group_variable_values);
+    });
+  }
+  si_->freeState(goal);
+}
+
+bool ompl_interface::ConstrainedGoalSampler::popSampledGoal(ob::State* new_goal)
+{
+  ob::State* state;
+  if (!sampled_goals_.pop(state))
+    return false;
+  queued_goal_count_--;
+  si_->copyState(new_goal, state);
+  si_->freeState(state);
+  return true;
+}
+
 bool ompl_interface::ConstrainedGoalSampler::checkStateValidity(ob::State* new_goal,
                                                                 const moveit::core::RobotState& state,
                                                                 bool verbose) const
@@ -91,6 +202,16 @@ bool ompl_interface::ConstrainedGoalSampler::stateValidityCallback(ob::State* ne
 
 bool ompl_interface::ConstrainedGoalSampler::sampleUsingConstraintSampler(const ob::GoalLazySamples* gls,
                                                                           ob::State* new_goal)
+{
+  // the sampling threads run while OMPL's sampling thread does, and are started again with it
+  startSamplingThreads();
+  if (sampleGoal(gls, new_goal))
+    return true;
+  stopSamplingThreads();
+  return false;
+}
+
+bool ompl_interface::ConstrainedGoalSampler::sampleGoal(const ob::GoalLazySamples* gls, ob::State* new_goal)
 {
   //  moveit::Profiler::ScopedBlock sblock("ConstrainedGoalSampler::sampleUsingConstraintSampler");
 
@@ -112,6 +233,10 @@ bool ompl_interface::ConstrainedGoalSampler::sampleUsingConstraintSampler(const
   unsigned int max_attempts_div2 = max_attempts / 2;
   for (unsigned int a = gls->samplingAttemptsCount(); a < max_attempts && gls->isSampling(); ++a)
   {
+    // goals found by the sampling threads are used first
+    if (popSampledGoal(new_goal))
+      return true;
+
     bool verbose = false;
     if (gls->getStateCount() == 0 && a >= max_attempts_div2)
       if (verbose_display_ < 1)
@@ -163,5 +288,5 @@ bool ompl_interface::ConstrainedGoalSampler::sampleUsingConstraintSampler(const
       }
     }
   }
-  return false;
+  return gls->isSampling() && popSampledGoal(new_goal);
 }
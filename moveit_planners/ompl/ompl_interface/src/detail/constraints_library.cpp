@@ -36,10 +36,17 @@
 
 #include <boost/date_time/posix_time/posix_time.hpp>
 #include <boost/filesystem.hpp>
+#include <boost/interprocess/file_mapping.hpp>
+#include <boost/interprocess/mapped_region.hpp>
+#include <algorithm>
+#include <cstring>
 #include <fstream>
 #include <moveit/ompl_interface/detail/constrained_sampler.h>
 #include <moveit/ompl_interface/detail/constraints_library.h>
 #include <moveit/profiler/profiler.h>
+#include <numeric>
+#include <omp.h>
+#include <ompl/datastructures/NearestNeighborsGNAT.h>
 #include <ompl/tools/config/SelfConfig.h>
 #include <utility>
 
@@ -79,14 +86,240 @@ void hexToMsg(const std::string& hex, T& msg)
   ros::serialization::IStream stream_arg(buffer_arg.get(), serial_size_arg);
   ros::serialization::deserialize(stream_arg, msg);
 }
+
+const char FILE_MAGIC[8] = { 'M', 'V', 'T', 'C', 'A', 'P', 'X', '\0' };
+const std::uint32_t FILE_VERSION = 1;
+
+/* Layout of a binary constraint approximation file (native byte order). Every section starts at an offset that is a
+   multiple of 8, so the index arrays can be used in place when the file is memory-mapped:
+   - states: state_count serialized states of state_size bytes each
+   - adjacency: state_count + 1 offsets into the edge_count connected state indices that follow
+   - motions: edge_count (first, last) ranges of explicit motion states, INVALID for edges without one
+   - neighbors: neighbor_count nearest milestones for each of the milestone_count milestones */
+struct FileHeader
+{
+  char magic[8];
+  std::uint32_t version;
+  std::uint32_t state_size;
+  std::uint64_t state_count;
+  std::uint64_t milestone_count;
+  std::uint64_t edge_count;
+  std::uint64_t neighbor_count;
+  std::uint64_t states_offset;
+  std::uint64_t adjacency_offset;
+  std::uint64_t motions_offset;
+  std::uint64_t neighbors_offset;
+};
+
+std::uint64_t alignOffset(std::uint64_t offset)
+{
+  return (offset + 7) & ~static_cast<std::uint64_t>(7);
+}
+
+void writeArray(std::ofstream& out, const std::vector<std::uint64_t>& data)
+{
+  out.write(reinterpret_cast<const char*>(data.data()), data.size() * sizeof(std::uint64_t));
+}
+
+void writePadding(std::ofstream& out, std::uint64_t offset)
+{
+  static const char ZEROS[8] = { 0 };
+  out.write(ZEROS, alignOffset(offset) - offset);
+}
+
+unsigned int getThreadCount(const ConstraintApproximationConstructionOptions& options)
+{
+  return options.num_threads > 0 ? options.num_threads : static_cast<unsigned int>(omp_get_max_threads());
+}
+
+/* Interpolate \e isteps states from \e from towards \e to into \e int_states and check that the
+   intermediate ones satisfy \e kset */
+bool interpolateConstrainedMotion(const ModelBasedStateSpacePtr& space, const ob::State* from, const ob::State* to,
+                                  unsigned int isteps, const kinematic_constraints::KinematicConstraintSet& kset,
+                                  moveit::core::RobotState& robot_state, std::vector<ob::State*>& int_states)
+{
+  double step = 1.0 / (double)isteps;
+  space->interpolate(from, to, step, int_states[0]);
+  for (unsigned int k = 1; k < isteps; ++k)
+  {
+    double this_step = step / (1.0 - (k - 1) * step);
+    space->interpolate(int_states[k - 1], to, this_step, int_states[k]);
+    space->copyToRobotState(robot_state, int_states[k]);
+    if (!kset.decide(robot_state).satisfied)
+      return false;
+  }
+  return true;
+}
 }  // namespace
 
+constexpr std::uint64_t NearestMilestoneIndex::INVALID;
+
+NearestMilestoneIndex::NearestMilestoneIndex(std::size_t k, std::vector<std::uint64_t> neighbors)
+  : k_(k), milestones_(k > 0 ? neighbors.size() / k : 0)
+{
+  auto owned = std::make_shared<std::vector<std::uint64_t>>(std::move(neighbors));
+  data_ = owned->data();
+  storage_ = owned;
+}
+
+NearestMilestoneIndex::NearestMilestoneIndex(std::size_t k, std::size_t milestones, const std::uint64_t* data,
+                                             std::shared_ptr<const void> storage)
+  : k_(k), milestones_(milestones), data_(data), storage_(std::move(storage))
+{
+}
+
+bool isConstraintApproximationFile(const std::string& filename)
+{
+  std::ifstream in(filename.c_str(), std::ios::binary);
+  char magic[sizeof(FILE_MAGIC)];
+  return in.read(magic, sizeof(magic)) && memcmp(magic, FILE_MAGIC, sizeof(magic)) == 0;
+}
+
+bool storeConstraintApproximationFile(const std::string& filename, const ConstraintApproximationStateStorage& storage,
+                                      std::size_t milestones, const NearestMilestoneIndex& nearest_milestones)
+{
+  std::ofstream out(filename.c_str(), std::ios::binary);
+  if (!out.good())
+  {
+    ROS_ERROR_NAMED(LOGNAME, "Unable to open '%s' for writing", filename.c_str());
+    return false;
+  }
+
+  const ob::StateSpacePtr& space = storage.getStateSpace();
+  std::vector<std::uint64_t> offsets(storage.size() + 1, 0);
+  std::vector<std::uint64_t> edges;
+  std::vector<std::uint64_t> motions;
+  for (std::size_t i = 0; i < storage.size(); ++i)
+  {
+    const ConstrainedStateMetadata& md = storage.getMetadata(i);
+    for (std::size_t j : md.first)
+    {
+      edges.push_back(j);
+      auto it = md.second.find(j);
+      motions.push_back(it == md.second.end() ? NearestMilestoneIndex::INVALID : it->second.first);
+      motions.push_back(it == md.second.end() ? NearestMilestoneIndex::INVALID : it->second.second);
+    }
+    offsets[i + 1] = edges.size();
+  }
+
+  FileHeader header;
+  memset(&header, 0, sizeof(header));
+  memcpy(header.magic, FILE_MAGIC, sizeof(FILE_MAGIC));
+  header.version = FILE_VERSION;
+  header.state_size = space->getSerializationLength();
+  header.state_count = storage.size();
+  header.milestone_count = milestones;
+  header.edge_count = edges.size();
+  header.neighbor_count =
+      nearest_milestones.getMilestoneCount() == milestones ? nearest_milestones.getNeighborCount() : 0;
+  header.states_offset = alignOffset(sizeof(FileHeader));
+  header.adjacency_offset = alignOffset(header.states_offset + header.state_count * header.state_size);
+  header.motions_offset = header.adjacency_offset + (offsets.size() + edges.size()) * sizeof(std::uint64_t);
+  header.neighbors_offset = header.motions_offset + motions.size() * sizeof(std::uint64_t);
+
+  out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+  writePadding(out, sizeof(header));
+  std::vector<char> buffer(header.state_size);
+  for (std::size_t i = 0; i < storage.size(); ++i)
+  {
+    space->serialize(buffer.data(), storage.getState(i));
+    out.write(buffer.data(), buffer.size());
+  }
+  writePadding(out, header.states_offset + header.state_count * header.state_size);
+  writeArray(out, offsets);
+  writeArray(out, edges);
+  writeArray(out, motions);
+  if (header.neighbor_count > 0)
+    out.write(reinterpret_cast<const char*>(nearest_milestones.getNeighbors(0)),
+              milestones * header.neighbor_count * sizeof(std::uint64_t));
+
+  if (!out.good())
+  {
+    ROS_ERROR_NAMED(LOGNAME, "Failed writing constraint approximation to '%s'", filename.c_str());
+    return false;
+  }
+  return true;
+}
+
+bool loadConstraintApproximationFile(const std::string& filename, ConstraintApproximationStateStorage& storage,
+                                     std::size_t& milestones, NearestMilestoneIndex& nearest_milestones)
+{
+  std::shared_ptr<boost::interprocess::mapped_region> region;
+  try
+  {
+    boost::interprocess::file_mapping mapping(filename.c_str(), boost::interprocess::read_only);
+    region = std::make_shared<boost::interprocess::mapped_region>(mapping, boost::interprocess::read_only);
+  }
+  catch (boost::interprocess::interprocess_exception& ex)
+  {
+    ROS_ERROR_NAMED(LOGNAME, "Unable to map '%s': %s", filename.c_str(), ex.what());
+    return false;
+  }
+
+  const char* data = static_cast<const char*>(region->get_address());
+  const std::size_t size = region->get_size();
+  FileHeader header;
+  if (size < sizeof(header))
+  {
+    ROS_ERROR_NAMED(LOGNAME, "File '%s' is too short for a constraint approximation", filename.c_str());
+    return false;
+  }
+  memcpy(&header, data, sizeof(header));
+
+  const ob::StateSpacePtr& space = storage.getStateSpace();
+  if (memcmp(header.magic, FILE_MAGIC, sizeof(FILE_MAGIC)) != 0 || header.version != FILE_VERSION)
+  {
+    ROS_ERROR_NAMED(LOGNAME, "File '%s' is not a constraint approximation of version %u", filename.c_str(),
+                    FILE_VERSION);
+    return false;
+  }
+  if (header.state_size != space->getSerializationLength())
+  {
+    ROS_ERROR_NAMED(LOGNAME, "States stored in '%s' do not match the state space '%s'", filename.c_str(),
+                    space->getName().c_str());
+    return false;
+  }
+  if (header.milestone_count > header.state_count ||
+      header.neighbors_offset + header.milestone_count * header.neighbor_count * sizeof(std::uint64_t) > size)
+  {
+    ROS_ERROR_NAMED(LOGNAME, "Constraint approximation file '%s' is truncated", filename.c_str());
+    return false;
+  }
+
+  ob::State* state = space->allocState();
+  for (std::size_t i = 0; i < header.state_count; ++i)
+  {
+    space->deserialize(state, data + header.states_offset + i * header.state_size);
+    storage.addState(state);
+  }
+  space->freeState(state);
+
+  const auto* offsets = reinterpret_cast<const std::uint64_t*>(data + header.adjacency_offset);
+  const std::uint64_t* edges = offsets + header.state_count + 1;
+  const auto* motions = reinterpret_cast<const std::uint64_t*>(data + header.motions_offset);
+  for (std::size_t i = 0; i < header.state_count; ++i)
+  {
+    ConstrainedStateMetadata& md = storage.getMetadata(i);
+    md.first.assign(edges + offsets[i], edges + offsets[i + 1]);
+    for (std::uint64_t e = offsets[i]; e < offsets[i + 1]; ++e)
+      if (motions[2 * e] != NearestMilestoneIndex::INVALID)
+        md.second[edges[e]] = std::make_pair(motions[2 * e], motions[2 * e + 1]);
+  }
+
+  milestones = header.milestone_count;
+  nearest_milestones =
+      NearestMilestoneIndex(header.neighbor_count, header.neighbor_count > 0 ? header.milestone_count : 0,
+                            reinterpret_cast<const std::uint64_t*>(data + header.neighbors_offset), region);
+  return true;
+}
+
 class ConstraintApproximationStateSampler : public ob::StateSampler
 {
 public:
   ConstraintApproximationStateSampler(const ob::StateSpace* space,
-                                      const ConstraintApproximationStateStorage* state_storage, std::size_t milestones)
-    : ob::StateSampler(space), state_storage_(state_storage)
+                                      const ConstraintApproximationStateStorage* state_storage, std::size_t milestones,
+                                      const NearestMilestoneIndex* nearest_milestones)
+    : ob::StateSampler(space), state_storage_(state_storage), nearest_milestones_(nearest_milestones)
   {
     max_index_ = milestones - 1;
     inv_dim_ = space->getDimension() > 0 ? 1.0 / (double)space->getDimension() : 1.0;
@@ -118,6 +351,16 @@ public:
         else
           dirty_.insert(index);
       }
+      else if (static_cast<std::size_t>(tag) < nearest_milestones_->getMilestoneCount())
+      {
+        // without connections, the nearest milestones are the best guess for states nearby
+        const std::uint64_t* neighbors = nearest_milestones_->getNeighbors(tag);
+        std::size_t count = 0;
+        while (count < nearest_milestones_->getNeighborCount() && neighbors[count] != NearestMilestoneIndex::INVALID)
+          ++count;
+        if (count > 0)
+          index = neighbors[rng_.uniformInt(0, count - 1)];
+      }
     }
     if (index < 0)
       index = rng_.uniformInt(0, max_index_);
@@ -141,6 +384,8 @@ public:
 protected:
   /** \brief The states to sample from */
   const ConstraintApproximationStateStorage* state_storage_;
+  /** \brief The nearest milestones of each milestone, possibly empty */
+  const NearestMilestoneIndex* nearest_milestones_;
   std::set<std::size_t> dirty_;
   unsigned int max_index_;
   double inv_dim_;
@@ -194,14 +439,15 @@ ompl_interface::InterpolationFunction ompl_interface::ConstraintApproximation::g
 ompl::base::StateSamplerPtr
 allocConstraintApproximationStateSampler(const ob::StateSpace* space, const std::vector<int>& expected_signature,
                                          const ConstraintApproximationStateStorage* state_storage,
-                                         std::size_t milestones)
+                                         std::size_t milestones, const NearestMilestoneIndex* nearest_milestones)
 {
   std::vector<int> sig;
   space->computeSignature(sig);
   if (sig != expected_signature)
     return ompl::base::StateSamplerPtr();
   else
-    return ompl::base::StateSamplerPtr(new ConstraintApproximationStateSampler(space, state_storage, milestones));
+    return ompl::base::StateSamplerPtr(
+        new ConstraintApproximationStateSampler(space, state_storage, milestones, nearest_milestones));
 }
 }  // namespace ompl_interface
 
@@ -228,7 +474,8 @@ ompl_interface::ConstraintApproximation::getStateSamplerAllocator(const moveit_m
   if (state_storage_->size() == 0)
     return ompl::base::StateSamplerAllocator();
   return [this](const ompl::base::StateSpace* ss) {
-    return allocConstraintApproximationStateSampler(ss, space_signature_, state_storage_, milestones_);
+    return allocConstraintApproximationStateSampler(ss, space_signature_, state_storage_, milestones_,
+                                                    &nearest_milestones_);
   };
 }
 /*
@@ -328,10 +575,21 @@ void ompl_interface::ConstraintsLibrary::loadConstraintApproximations(const std:
     moveit_msgs::Constraints msg;
     hexToMsg(serialization, msg);
     auto* cass = new ConstraintApproximationStateStorage(context_->getOMPLSimpleSetup()->getStateSpace());
-    cass->load((std::string{ path }.append("/").append(filename)).c_str());
+    ompl::base::StateStoragePtr storage(cass);
+    const std::string full_filename = std::string{ path }.append("/").append(filename);
+    NearestMilestoneIndex nearest_milestones;
+    if (isConstraintApproximationFile(full_filename))
+    {
+      std::size_t stored_milestones;
+      if (!loadConstraintApproximationFile(full_filename, *cass, stored_milestones, nearest_milestones))
+        continue;
+      milestones = stored_milestones;
+    }
+    else
+      cass->load(full_filename.c_str());
     ConstraintApproximationPtr cap(new ConstraintApproximation(group, state_space_parameterization, explicit_motions,
-                                                               msg, filename, ompl::base::StateStoragePtr(cass),
-                                                               milestones));
+                                                               msg, filename, storage, milestones));
+    cap->setNearestMilestoneIndex(nearest_milestones);
     if (constraint_approximations_.find(cap->getName()) != constraint_approximations_.end())
       ROS_WARN_NAMED(LOGNAME, "Overwriting constraint approximation named '%s'", cap->getName().c_str());
     constraint_approximations_[cap->getName()] = cap;
@@ -374,7 +632,10 @@ void ompl_interface::ConstraintsLibrary::saveConstraintApproximations(const std:
       fout << serialization << std::endl;
       fout << it->second->getFilename() << std::endl;
       if (it->second->getStateStorage())
-        it->second->getStateStorage()->store((path + "/" + it->second->getFilename()).c_str());
+        storeConstraintApproximationFile(
+            path + "/" + it->second->getFilename(),
+            *static_cast<const ConstraintApproximationStateStorage*>(it->second->getStateStorage().get()),
+            it->second->getMilestoneCount(), it->second->getNearestMilestoneIndex());
     }
   else
     ROS_ERROR_NAMED(LOGNAME, "Unable to save constraint approximation to '%s'", path.c_str());
@@ -441,8 +702,9 @@ ompl_interface::ConstraintsLibrary::addConstraintApproximation(const moveit_msgs
   context_->setCompleteInitialState(scene->getCurrentState());
 
   ros::WallTime start = ros::WallTime::now();
+  NearestMilestoneIndex nearest_milestones;
   ompl::base::StateStoragePtr state_storage =
-      constructConstraintApproximation(context_, constr_sampling, constr_hard, options, res);
+      constructConstraintApproximation(context_, constr_sampling, constr_hard, options, res, nearest_milestones);
   ROS_INFO_NAMED(LOGNAME, "Spent %lf seconds constructing the database", (ros::WallTime::now() - start).toSec());
   if (state_storage)
   {
@@ -451,6 +713,7 @@ ompl_interface::ConstraintsLibrary::addConstraintApproximation(const moveit_msgs
         group + "_" + boost::posix_time::to_iso_extended_string(boost::posix_time::microsec_clock::universal_time()) +
             ".ompldb",
         state_storage, res.milestones));
+    constraint_approx->setNearestMilestoneIndex(nearest_milestones);
     if (constraint_approximations_.find(constraint_approx->getName()) != constraint_approximations_.end())
       ROS_WARN_NAMED(LOGNAME, "Overwriting constraint approximation named '%s'", constraint_approx->getName().c_str());
     constraint_approximations_[constraint_approx->getName()] = constraint_approx;
@@ -464,7 +727,7 @@ ompl_interface::ConstraintsLibrary::addConstraintApproximation(const moveit_msgs
 ompl::base::StateStoragePtr ompl_interface::ConstraintsLibrary::constructConstraintApproximation(
     ModelBasedPlanningContext* pcontext, const moveit_msgs::Constraints& constr_sampling,
     const moveit_msgs::Constraints& constr_hard, const ConstraintApproximationConstructionOptions& options,
-    ConstraintApproximationConstructionResults& result)
+    ConstraintApproximationConstructionResults& result, NearestMilestoneIndex& nearest_milestones)
 {
   // state storage structure
   ConstraintApproximationStateStorage* cass = new ConstraintApproximationStateStorage(pcontext->getOMPLStateSpace());
@@ -476,153 +739,207 @@ ompl::base::StateStoragePtr ompl_interface::ConstraintsLibrary::constructConstra
   kset.add(constr_hard, no_transforms);
 
   const moveit::core::RobotState& default_state = pcontext->getCompleteInitialRobotState();
+  const ModelBasedStateSpacePtr& space = pcontext->getOMPLStateSpace();
+  const unsigned int num_threads = getThreadCount(options);
 
-  unsigned int attempts = 0;
+  std::size_t attempts = 0;
 
   double bounds_val = std::numeric_limits<double>::max() / 2.0 - 1.0;
-  pcontext->getOMPLStateSpace()->setPlanningVolume(-bounds_val, bounds_val, -bounds_val, bounds_val, -bounds_val,
-                                                   bounds_val);
-  pcontext->getOMPLStateSpace()->setup();
+  space->setPlanningVolume(-bounds_val, bounds_val, -bounds_val, bounds_val, -bounds_val, bounds_val);
+  space->setup();
 
-  // construct the constrained states
-
-  moveit::core::RobotState robot_state(default_state);
+  // construct the constrained states, every thread with its own sampler
   const constraint_samplers::ConstraintSamplerManagerPtr& csmng = pcontext->getConstraintSamplerManager();
-  ConstrainedSampler* constrained_sampler = nullptr;
-  if (csmng)
-  {
-    constraint_samplers::ConstraintSamplerPtr constraint_sampler =
-        csmng->selectSampler(pcontext->getPlanningScene(), pcontext->getJointModelGroup()->getName(), constr_sampling);
-    if (constraint_sampler)
-      constrained_sampler = new ConstrainedSampler(pcontext, constraint_sampler);
-  }
-
-  ob::StateSamplerPtr ss(constrained_sampler ? ob::StateSamplerPtr(constrained_sampler) :
-                                               pcontext->getOMPLStateSpace()->allocDefaultStateSampler());
-
-  ompl::base::ScopedState<> temp(pcontext->getOMPLStateSpace());
   int done = -1;
   bool slow_warn = false;
+  double sampling_success_rate = 0.0;
+  unsigned int constrained_samplers = 0;
   ompl::time::point start = ompl::time::now();
-  while (state_storage->size() < options.samples)
+#pragma omp parallel num_threads(num_threads)
   {
-    ++attempts;
-    int done_now = 100 * state_storage->size() / options.samples;
-    if (done != done_now)
+    moveit::core::RobotState robot_state(default_state);
+    ConstrainedSampler* constrained_sampler = nullptr;
+    ob::StateSamplerPtr ss;
+#pragma omp critical(constraint_approximation_sampler)
     {
-      done = done_now;
-      ROS_INFO_NAMED(LOGNAME, "%d%% complete (kept %0.1lf%% sampled states)", done,
-                     100.0 * (double)state_storage->size() / (double)attempts);
+      if (csmng)
+      {
+        constraint_samplers::ConstraintSamplerPtr constraint_sampler = csmng->selectSampler(
+            pcontext->getPlanningScene(), pcontext->getJointModelGroup()->getName(), constr_sampling);
+        if (constraint_sampler)
+          constrained_sampler = new ConstrainedSampler(pcontext, constraint_sampler);
+      }
+      ss = constrained_sampler ? ob::StateSamplerPtr(constrained_sampler) : space->allocDefaultStateSampler();
     }
 
-    if (!slow_warn && attempts > 10 && attempts > state_storage->size() * 100)
+    ompl::base::ScopedState<> temp(space);
+    bool finished = options.samples == 0;
+    while (!finished)
     {
-      slow_warn = true;
-      ROS_WARN_NAMED(LOGNAME, "Computation of valid state database is very slow...");
-    }
+      ss->sampleUniform(temp.get());
+      space->copyToRobotState(robot_state, temp.get());
+      bool satisfied = kset.decide(robot_state).satisfied;
 
-    if (attempts > options.samples && state_storage->size() == 0)
-    {
-      ROS_ERROR_NAMED(LOGNAME, "Unable to generate any samples");
-      break;
+#pragma omp critical(constraint_approximation_storage)
+      {
+        ++attempts;
+        if (satisfied && state_storage->size() < options.samples)
+        {
+          temp->as<ModelBasedStateSpace::StateType>()->tag = state_storage->size();
+          state_storage->addState(temp.get());
+        }
+
+        int done_now = 100 * state_storage->size() / options.samples;
+        if (done != done_now)
+        {
+          done = done_now;
+          ROS_INFO_NAMED(LOGNAME, "%d%% complete (kept %0.1lf%% sampled states)", done,
+                         100.0 * (double)state_storage->size() / (double)attempts);
+        }
+
+        if (!slow_warn && attempts > 10 && attempts > state_storage->size() * 100)
+        {
+          slow_warn = true;
+          ROS_WARN_NAMED(LOGNAME, "Computation of valid state database is very slow...");
+        }
+
+        finished = state_storage->size() >= options.samples ||
+                   (attempts > options.samples && state_storage->size() == 0);
+      }
     }
 
-    ss->sampleUniform(temp.get());
-    pcontext->getOMPLStateSpace()->copyToRobotState(robot_state, temp.get());
-    if (kset.decide(robot_state).satisfied)
+    if (constrained_sampler)
     {
-      if (state_storage->size() < options.samples)
+#pragma omp critical(constraint_approximation_storage)
       {
-        temp->as<ModelBasedStateSpace::StateType>()->tag = state_storage->size();
-        state_storage->addState(temp.get());
+        sampling_success_rate += constrained_sampler->getConstrainedSamplingRate();
+        ++constrained_samplers;
       }
     }
   }
 
+  if (state_storage->size() == 0)
+    ROS_ERROR_NAMED(LOGNAME, "Unable to generate any samples");
+
   result.state_sampling_time = ompl::time::seconds(ompl::time::now() - start);
-  ROS_INFO_NAMED(LOGNAME, "Generated %u states in %lf seconds", (unsigned int)state_storage->size(),
-                 result.state_sampling_time);
-  if (constrained_sampler)
+  ROS_INFO_NAMED(LOGNAME, "Generated %u states in %lf seconds using %u threads", (unsigned int)state_storage->size(),
+                 result.state_sampling_time, num_threads);
+  if (constrained_samplers > 0)
   {
-    result.sampling_success_rate = constrained_sampler->getConstrainedSamplingRate();
+    result.sampling_success_rate = sampling_success_rate / constrained_samplers;
     ROS_INFO_NAMED(LOGNAME, "Constrained sampling rate: %lf", result.sampling_success_rate);
   }
 
   result.milestones = state_storage->size();
+  const std::size_t milestones = state_storage->size();
+
+  // index the nearest milestones of each milestone; they are the candidates for connections as well
+  const std::size_t neighbor_count =
+      milestones > 0 ?
+          std::min<std::size_t>(std::max(options.nearest_neighbors, options.edges_per_sample), milestones - 1) :
+          0;
+  std::vector<std::uint64_t> neighbors(milestones * neighbor_count, NearestMilestoneIndex::INVALID);
+  if (neighbor_count > 0)
+  {
+    start = ompl::time::now();
+    ompl::NearestNeighborsGNAT<std::size_t> nn;
+    nn.setDistanceFunction([&state_storage, &space](std::size_t a, std::size_t b) {
+      return space->distance(state_storage->getState(a), state_storage->getState(b));
+    });
+    std::vector<std::size_t> milestone_indices(milestones);
+    std::iota(milestone_indices.begin(), milestone_indices.end(), 0);
+    nn.add(milestone_indices);
+
+#pragma omp parallel for schedule(dynamic) num_threads(num_threads)
+    for (std::size_t j = 0; j < milestones; ++j)
+    {
+      std::vector<std::size_t> nbh;
+      nn.nearestK(j, neighbor_count + 1, nbh);
+      std::size_t count = 0;
+      for (std::size_t i : nbh)
+        if (i != j && count < neighbor_count)
+          neighbors[j * neighbor_count + count++] = i;
+    }
+    ROS_INFO_NAMED(LOGNAME, "Indexed %lu nearest milestones per milestone in %lf seconds", neighbor_count,
+                   ompl::time::seconds(ompl::time::now() - start));
+  }
+  nearest_milestones = NearestMilestoneIndex(neighbor_count, std::move(neighbors));
+
   if (options.edges_per_sample > 0)
   {
     ROS_INFO_NAMED(LOGNAME, "Computing graph connections (max %u edges per sample) ...", options.edges_per_sample);
 
-    // construct connections
-    const ob::StateSpacePtr& space = pcontext->getOMPLSimpleSetup()->getStateSpace();
-    unsigned int milestones = state_storage->size();
-    std::vector<ob::State*> int_states(options.max_explicit_points, nullptr);
-    pcontext->getOMPLSimpleSetup()->getSpaceInformation()->allocStates(int_states);
-
-    ompl::time::point start = ompl::time::now();
-    int good = 0;
-    int done = -1;
+    start = ompl::time::now();
 
-    for (std::size_t j = 0; j < milestones; ++j)
+    // check the motions to the nearest milestones in parallel; a pair of milestones that are nearest to each
+    // other is only checked once, from the lower index
+    std::vector<std::vector<std::size_t>> valid_neighbors(milestones);
+#pragma omp parallel num_threads(num_threads)
     {
-      int done_now = 100 * j / milestones;
-      if (done != done_now)
-      {
-        done = done_now;
-        ROS_INFO_NAMED(LOGNAME, "%d%% complete", done);
-      }
-      if (cass->getMetadata(j).first.size() >= options.edges_per_sample)
-        continue;
+      moveit::core::RobotState robot_state(default_state);
+      std::vector<ob::State*> int_states(options.max_explicit_points, nullptr);
+      pcontext->getOMPLSimpleSetup()->getSpaceInformation()->allocStates(int_states);
 
-      const ob::State* sj = state_storage->getState(j);
-
-      for (std::size_t i = j + 1; i < milestones; ++i)
+#pragma omp for schedule(dynamic)
+      for (std::size_t j = 0; j < milestones; ++j)
       {
-        if (cass->getMetadata(i).first.size() >= options.edges_per_sample)
-          continue;
-        double d = space->distance(state_storage->getState(i), sj);
-        if (d >= options.max_edge_length)
-          continue;
-        unsigned int isteps =
-            std::min<unsigned int>(options.max_explicit_points, d / options.explicit_points_resolution);
-        double step = 1.0 / (double)isteps;
-        bool ok = true;
-        space->interpolate(state_storage->getState(i), sj, step, int_states[0]);
-        for (unsigned int k = 1; k < isteps; ++k)
+        const std::uint64_t* nbh = nearest_milestones.getNeighbors(j);
+        for (std::size_t c = 0; c < neighbor_count && nbh[c] != NearestMilestoneIndex::INVALID; ++c)
         {
-          double this_step = step / (1.0 - (k - 1) * step);
-          space->interpolate(int_states[k - 1], sj, this_step, int_states[k]);
-          pcontext->getOMPLStateSpace()->copyToRobotState(robot_state, int_states[k]);
-          if (!kset.decide(robot_state).satisfied)
-          {
-            ok = false;
+          std::size_t i = nbh[c];
+          const std::uint64_t* nbh_i = nearest_milestones.getNeighbors(i);
+          if (i < j && std::find(nbh_i, nbh_i + neighbor_count, j) != nbh_i + neighbor_count)
+            continue;
+          double d = space->distance(state_storage->getState(i), state_storage->getState(j));
+          if (d >= options.max_edge_length)
             break;
-          }
+          unsigned int isteps = std::max(
+              1u, std::min<unsigned int>(options.max_explicit_points, d / options.explicit_points_resolution));
+          if (interpolateConstrainedMotion(space, state_storage->getState(i), state_storage->getState(j), isteps,
+                                           kset, robot_state, int_states))
+            valid_neighbors[j].push_back(i);
         }
+      }
+      pcontext->getOMPLSimpleSetup()->getSpaceInformation()->freeStates(int_states);
+    }
 
-        if (ok)
-        {
-          cass->getMetadata(i).first.push_back(j);
-          cass->getMetadata(j).first.push_back(i);
+    // add the connections in order, respecting the maximum number of edges per sample
+    std::vector<ob::State*> int_states(options.max_explicit_points, nullptr);
+    pcontext->getOMPLSimpleSetup()->getSpaceInformation()->allocStates(int_states);
+    moveit::core::RobotState robot_state(default_state);
+    int good = 0;
+    for (std::size_t j = 0; j < milestones; ++j)
+      for (std::size_t i : valid_neighbors[j])
+      {
+        if (cass->getMetadata(j).first.size() >= options.edges_per_sample)
+          break;
+        std::vector<std::size_t>& edges_i = cass->getMetadata(i).first;
+        if (edges_i.size() >= options.edges_per_sample || std::find(edges_i.begin(), edges_i.end(), j) != edges_i.end())
+          continue;
 
-          if (options.explicit_motions)
+        cass->getMetadata(i).first.push_back(j);
+        cass->getMetadata(j).first.push_back(i);
+
+        if (options.explicit_motions)
+        {
+          const ob::State* si = state_storage->getState(i);
+          const ob::State* sj = state_storage->getState(j);
+          unsigned int isteps = std::max(1u, std::min<unsigned int>(options.max_explicit_points,
+                                                                    space->distance(si, sj) /
+                                                                        options.explicit_points_resolution));
+          interpolateConstrainedMotion(space, si, sj, isteps, kset, robot_state, int_states);
+          cass->getMetadata(i).second[j].first = state_storage->size();
+          for (unsigned int k = 0; k < isteps; ++k)
           {
-            cass->getMetadata(i).second[j].first = state_storage->size();
-            for (unsigned int k = 0; k < isteps; ++k)
-            {
-              int_states[k]->as<ModelBasedStateSpace::StateType>()->tag = -1;
-              state_storage->addState(int_states[k]);
-            }
-            cass->getMetadata(i).second[j].second = state_storage->size();
-            cass->getMetadata(j).second[i] = cass->getMetadata(i).second[j];
+            int_states[k]->as<ModelBasedStateSpace::StateType>()->tag = -1;
+            state_storage->addState(int_states[k]);
           }
-
-          good++;
-          if (cass->getMetadata(j).first.size() >= options.edges_per_sample)
-            break;
+          cass->getMetadata(i).second[j].second = state_storage->size();
+          cass->getMetadata(j).second[i] = cass->getMetadata(i).second[j];
         }
+
+        good++;
       }
-    }
 
     result.state_connection_time = ompl::time::seconds(ompl::time::now() - start);
     ROS_INFO_NAMED(LOGNAME, "Computed possible connections in %lf seconds. Added %d connections",
@@ -0,0 +1,178 @@
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2026, PickNik LLC.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of PickNik LLC nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *********************************************************************/
+
+#include <moveit/ompl_interface/detail/experience_library.h>
+#include <boost/functional/hash.hpp>
+#include <ros/console.h>
+
+#include <fstream>
+#include <iomanip>
+#include <limits>
+
+namespace ompl_interface
+{
+constexpr char LOGNAME[] = "experience_library";
+
+namespace
+{
+double squaredDistance(const std::vector<double>& a, const std::vector<double>& b)
+{
+  if (a.size() != b.size())
+    return std::numeric_limits<double>::infinity();
+  double d = 0.0;
+  for (std::size_t i = 0; i < a.size(); ++i)
+    d += (a[i] - b[i]) * (a[i] - b[i]);
+  return d;
+}
+}  // namespace
+
+ExperienceLibrary::ExperienceLibrary(std::size_t max_size, const std::string& path) : max_size_(max_size), path_(path)
+{
+  if (!path_.empty() && !load(path_))
+    ROS_INFO_NAMED(LOGNAME, "No experiences loaded from '%s'", path_.c_str());
+}
+
+ExperienceLibrary::~ExperienceLibrary()
+{
+  if (!path_.empty() && !store(path_))
+    ROS_ERROR_NAMED(LOGNAME, "Failed to store experiences to '%s'", path_.c_str());
+}
+
+void ExperienceLibrary::add(std::vector<std::vector<double>> waypoints, std::size_t scene_hash, double tolerance)
+{
+  if (waypoints.size() < 2 || max_size_ == 0)
+    return;
+
+  auto experience = std::make_shared<Experience>();
+  experience->waypoints = std::move(waypoints);
+  experience->scene_hash = scene_hash;
+
+  const double squared_tolerance = tolerance * tolerance;
+  std::unique_lock<std::mutex> slock(lock_);
+  for (auto it = experiences_.begin(); it != experiences_.end(); ++it)
+    if ((*it)->scene_hash == scene_hash &&
+        squaredDistance((*it)->waypoints.front(), experience->waypoints.front()) <= squared_tolerance &&
+        squaredDistance((*it)->waypoints.back(), experience->waypoints.back()) <= squared_tolerance)
+    {
+      experiences_.erase(it);
+      break;
+    }
+  if (experiences_.size() >= max_size_)
+    experiences_.pop_front();
+  experiences_.push_back(std::move(experience));
+}
+
+std::vector<ExperienceLibrary::ExperienceConstPtr> ExperienceLibrary::getExperiences() const
+{
+  std::unique_lock<std::mutex> slock(lock_);
+  return std::vector<ExperienceConstPtr>(experiences_.begin(), experiences_.end());
+}
+
+std::size_t ExperienceLibrary::size() const
+{
+  std::unique_lock<std::mutex> slock(lock_);
+  return experiences_.size();
+}
+
+bool ExperienceLibrary::load(const std::string& path)
+{
+  std::ifstream in(path);
+  std::string keyword;
+  std::size_t count;
+  if (!in.good() || !(in >> keyword >> count) || keyword != "experiences")
+    return false;
+
+  std::deque<ExperienceConstPtr> experiences;
+  for (std::size_t i = 0; i < count; ++i)
+  {
+    auto experience = std::make_shared<Experience>();
+    std::size_t waypoint_count, variable_count;
+    if (!(in >> experience->scene_hash >> waypoint_count >> variable_count))
+      return false;
+    experience->waypoints.resize(waypoint_count, std::vector<double>(variable_count));
+    for (std::vector<double>& waypoint : experience->waypoints)
+      for (double& value : waypoint)
+        if (!(in >> value))
+          return false;
+    if (waypoint_count >= 2)
+      experiences.push_back(std::move(experience));
+  }
+  while (experiences.size() > max_size_)
+    experiences.pop_front();
+
+  std::unique_lock<std::mutex> slock(lock_);
+  experiences_.swap(experiences);
+  return true;
+}
+
+bool ExperienceLibrary::store(const std::string& path) const
+{
+  std::ofstream out(path);
+  if (!out.good())
+    return false;
+
+  std::unique_lock<std::mutex> slock(lock_);
+  out << std::setprecision(std::numeric_limits<double>::max_digits10);
+  out << "experiences " << experiences_.size() << '\n';
+  for (const ExperienceConstPtr& experience : experiences_)
+  {
+    out << experience->scene_hash << ' ' << experience->waypoints.size() << ' '
+        << experience->waypoints.front().size() << '\n';
+    for (const std::vector<double>& waypoint : experience->waypoints)
+    {
+      for (std::size_t i = 0; i < waypoint.size(); ++i)
+        out << (i ? " " : "") << waypoint[i];
+      out << '\n';
+    }
+  }
+  return out.good();
+}
+
+std::size_t computeSceneHash(const planning_scene::PlanningScene& scene)
+{
+  std::size_t hash = 0;
+  const collision_detection::WorldConstPtr& world = scene.getWorld();
+  for (const std::string& id : world->getObjectIds())
+  {
+    boost::hash_combine(hash, id);
+    const Eigen::AlignedBox3d box = world->getObjectAABB(id);
+    for (int i = 0; i < 3; ++i)
+    {
+      boost::hash_combine(hash, box.min()[i]);
+      boost::hash_combine(hash, box.max()[i]);
+    }
+  }
+  return hash;
+}
+}  // namespace ompl_interface
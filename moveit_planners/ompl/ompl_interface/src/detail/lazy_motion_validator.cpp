@@ -0,0 +1,132 @@
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2026, PickNik LLC.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of PickNik LLC nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *********************************************************************/
+
+#include <moveit/ompl_interface/detail/lazy_motion_validator.h>
+#include <ompl/base/SpaceInformation.h>
+
+#include <queue>
+
+ompl_interface::LazyMotionValidator::LazyMotionValidator(const ompl::base::SpaceInformationPtr& si,
+                                                         const StateValidityCheckerPtr& checker)
+  : ompl::base::MotionValidator(si), checker_(checker)
+{
+}
+
+bool ompl_interface::LazyMotionValidator::checkMotion(const ompl::base::State* s1, const ompl::base::State* s2) const
+{
+  // s1 may only have been checked lazily, so it is checked here as well (usually answered from the cache)
+  if (!checker_->isValid(s1, false) || !checker_->isValid(s2, false))
+  {
+    invalid_++;
+    return false;
+  }
+
+  // check the intermediate states in bisection order, so collisions in the middle of the motion are found early
+  bool result = true;
+  const int nd = si_->getStateSpace()->validSegmentCount(s1, s2);
+  if (nd >= 2)
+  {
+    std::queue<std::pair<int, int>> pos;
+    pos.emplace(1, nd - 1);
+    ompl::base::State* test = si_->allocState();
+    while (!pos.empty())
+    {
+      const std::pair<int, int> x = pos.front();
+      pos.pop();
+      const int mid = (x.first + x.second) / 2;
+      si_->getStateSpace()->interpolate(s1, s2, static_cast<double>(mid) / nd, test);
+      if (!checker_->isValid(test, false))
+      {
+        result = false;
+        break;
+      }
+      if (x.first < mid)
+        pos.emplace(x.first, mid - 1);
+      if (x.second > mid)
+        pos.emplace(mid + 1, x.second);
+    }
+    si_->freeState(test);
+  }
+
+  if (result)
+    valid_++;
+  else
+    invalid_++;
+  return result;
+}
+
+bool ompl_interface::LazyMotionValidator::checkMotion(const ompl::base::State* s1, const ompl::base::State* s2,
+                                                      std::pair<ompl::base::State*, double>& last_valid) const
+{
+  if (!checker_->isValid(s1, false))
+  {
+    last_valid.second = 0.0;
+    if (last_valid.first)
+      si_->copyState(last_valid.first, s1);
+    invalid_++;
+    return false;
+  }
+
+  // check the intermediate states in order, so the last valid state along the motion is known
+  bool result = true;
+  const int nd = si_->getStateSpace()->validSegmentCount(s1, s2);
+  ompl::base::State* test = si_->allocState();
+  for (int j = 1; j < nd; ++j)
+  {
+    si_->getStateSpace()->interpolate(s1, s2, static_cast<double>(j) / nd, test);
+    if (!checker_->isValid(test, false))
+    {
+      last_valid.second = static_cast<double>(j - 1) / nd;
+      result = false;
+      break;
+    }
+  }
+  si_->freeState(test);
+
+  if (result && !checker_->isValid(s2, false))
+  {
+    last_valid.second = static_cast<double>(nd - 1) / nd;
+    result = false;
+  }
+
+  if (result)
+    valid_++;
+  else
+  {
+    if (last_valid.first)
+      si_->getStateSpace()->interpolate(s1, s2, last_valid.second, last_valid.first);
+    invalid_++;
+  }
+  return result;
+}
@@ -37,9 +37,19 @@
 #include <moveit/ompl_interface/detail/projection_evaluators.h>
 #include <moveit/ompl_interface/model_based_planning_context.h>
 #include <moveit/ompl_interface/parameterization/model_based_state_space.h>
+#include <moveit/ompl_interface/detail/state_validity_checker.h>
+#include <ompl/base/SpaceInformation.h>
+#include <Eigen/Eigenvalues>
 
+#include <algorithm>
+#include <limits>
 #include <utility>
 
+namespace ompl_interface
+{
+constexpr char LOGNAME[] = "projection_evaluators";
+}  // namespace ompl_interface
+
 ompl_interface::ProjectionEvaluatorLinkPose::ProjectionEvaluatorLinkPose(const ModelBasedPlanningContext* pc,
                                                                          const std::string& link)
   : ompl::base::ProjectionEvaluator(pc->getOMPLStateSpace())
@@ -65,8 +75,16 @@ void ompl_interface::ProjectionEvaluatorLinkPose::defaultCellSizes()
 void ompl_interface::ProjectionEvaluatorLinkPose::project(const ompl::base::State* state,
                                                           OMPLProjection projection) const
 {
-  moveit::core::RobotState* s = tss_.getStateStorage();
-  planning_context_->getOMPLStateSpace()->copyToRobotState(*s, state);
+  // reuse the transforms of the validity check of this state, if the calling thread did it last
+  const ompl::base::SpaceInformationPtr& si = planning_context_->getOMPLSimpleSetup()->getSpaceInformation();
+  const auto* checker = static_cast<const StateValidityChecker*>(si->getStateValidityChecker().get());
+  const moveit::core::RobotState* s = checker ? checker->getCheckedRobotState(state) : nullptr;
+  if (!s)
+  {
+    moveit::core::RobotState* storage = tss_.getStateStorage();
+    planning_context_->getOMPLStateSpace()->copyToRobotState(*storage, state);
+    s = storage;
+  }
 
   const Eigen::Vector3d& o = s->getGlobalLinkTransform(link_).translation();
   projection(0) = o.x();
@@ -97,3 +115,94 @@ void ompl_interface::ProjectionEvaluatorJointValue::project(const ompl::base::St
   for (std::size_t i = 0; i < variables_.size(); ++i)
     projection(i) = state->as<ModelBasedStateSpace::StateType>()->values[variables_[i]];
 }
+
+ompl_interface::ProjectionEvaluatorPCA::ProjectionEvaluatorPCA(const ModelBasedPlanningContext* pc,
+                                                               unsigned int dimension, unsigned int samples)
+  : ompl::base::ProjectionEvaluator(pc->getOMPLStateSpace())
+  , planning_context_(pc)
+  , dimension_(std::min(dimension, pc->getJointModelGroup()->getVariableCount()))
+  , samples_(std::max(samples, dimension_ + 1))
+  , learned_(false)
+{
+  // until the components are learned, the projection is onto the first joint values
+  const unsigned int n = pc->getJointModelGroup()->getVariableCount();
+  mean_ = Eigen::VectorXd::Zero(n);
+  components_ = Eigen::MatrixXd::Identity(dimension_, n);
+  extents_ = Eigen::VectorXd::Constant(dimension_, 2.0);
+}
+
+unsigned int ompl_interface::ProjectionEvaluatorPCA::getDimension() const
+{
+  return dimension_;
+}
+
+void ompl_interface::ProjectionEvaluatorPCA::defaultCellSizes()
+{
+  // about 20 cells along each component, like OMPL uses for inferred cell sizes
+  cellSizes_.resize(dimension_);
+  for (unsigned int i = 0; i < dimension_; ++i)
+    cellSizes_[i] = extents_[i] > std::numeric_limits<double>::epsilon() ? extents_[i] / 20.0 : 0.1;
+}
+
+void ompl_interface::ProjectionEvaluatorPCA::setup()
+{
+  if (!learned_ && planning_context_->getOMPLSimpleSetup()->getStateValidityChecker())
+    learn();
+  ompl::base::ProjectionEvaluator::setup();
+}
+
+void ompl_interface::ProjectionEvaluatorPCA::learn()
+{
+  learned_ = true;
+  if (dimension_ == 0)
+    return;
+
+  const ompl::base::SpaceInformationPtr& si = planning_context_->getOMPLSimpleSetup()->getSpaceInformation();
+  const ompl::base::StateValidityCheckerPtr& checker = si->getStateValidityChecker();
+  const unsigned int n = mean_.size();
+  ompl::base::StateSamplerPtr sampler = space_->allocDefaultStateSampler();
+  ompl::base::State* state = space_->allocState();
+
+  Eigen::MatrixXd data(n, samples_);
+  Eigen::MatrixXd invalid_data(n, samples_);
+  unsigned int valid = 0, invalid = 0;
+  for (unsigned int i = 0; i < samples_; ++i)
+  {
+    sampler->sampleUniform(state);
+    const Eigen::Map<const Eigen::VectorXd> values(state->as<ModelBasedStateSpace::StateType>()->values, n);
+    if (checker->isValid(state))
+      data.col(valid++) = values;
+    else
+      invalid_data.col(invalid++) = values;
+  }
+  space_->freeState(state);
+
+  // in very cluttered scenes, the invalid samples are used as well
+  if (valid <= dimension_)
+  {
+    ROS_WARN_NAMED(LOGNAME, "Only %u of %u sampled states are valid, learning the projection from all samples",
+                   valid, samples_);
+    data.middleCols(valid, invalid) = invalid_data.leftCols(invalid);
+    valid = samples_;
+  }
+  data.conservativeResize(n, valid);
+
+  mean_ = data.rowwise().mean();
+  data.colwise() -= mean_;
+  const Eigen::MatrixXd covariance = data * data.transpose() / std::max(1u, valid - 1);
+  const Eigen::SelfAdjointEigenSolver<Eigen::MatrixXd> solver(covariance);
+  for (unsigned int i = 0; i < dimension_; ++i)
+    components_.row(i) = solver.eigenvectors().col(n - 1 - i).transpose();
+
+  const Eigen::MatrixXd projected = components_ * data;
+  extents_ = projected.rowwise().maxCoeff() - projected.rowwise().minCoeff();
+  ROS_DEBUG_NAMED(LOGNAME, "Learned a %u-dimensional projection for group '%s' from %u states", dimension_,
+                  planning_context_->getGroupName().c_str(), valid);
+}
+
+void ompl_interface::ProjectionEvaluatorPCA::project(const ompl::base::State* state, OMPLProjection projection) const
+{
+  const Eigen::Map<const Eigen::VectorXd> values(state->as<ModelBasedStateSpace::StateType>()->values, mean_.size());
+  for (unsigned int i = 0; i < dimension_; ++i)
+    projection(i) = components_.row(i).dot(values - mean_);
+}
@@ -0,0 +1,275 @@
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2026, PickNik LLC.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of PickNik LLC nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *********************************************************************/
+
+#include <moveit/ompl_interface/detail/roadmap_scene_snapshot.h>
+#include <moveit/ompl_interface/parameterization/model_based_state_space.h>
+#include <moveit/robot_model/aabb.h>
+#include <geometric_shapes/shape_operations.h>
+#include <ompl/base/SpaceInformation.h>
+
+#include <fstream>
+#include <iomanip>
+#include <limits>
+
+namespace ompl_interface
+{
+namespace
+{
+bool sameBox(const Eigen::AlignedBox3d& a, const Eigen::AlignedBox3d& b)
+{
+  return a.min() == b.min() && a.max() == b.max();
+}
+
+// read a double token, accepting the "inf" and "-inf" written for unbounded objects
+bool readDouble(std::istream& in, double& value)
+{
+  std::string token;
+  if (!(in >> token))
+    return false;
+  try
+  {
+    value = std::stod(token);
+  }
+  catch (std::exception&)
+  {
+    return false;
+  }
+  return true;
+}
+
+// world-frame boxes around the moving links with geometry and their attached bodies; always in the same order
+void computeStateBoxes(const ModelBasedStateSpace& space, const ompl::base::State* state,
+                       moveit::core::RobotState& robot_state, std::vector<moveit::core::AABB>& boxes)
+{
+  space.copyToRobotState(robot_state, state);
+  boxes.clear();
+  for (const moveit::core::LinkModel* link : space.getJointModelGroup()->getUpdatedLinkModelsWithGeometry())
+  {
+    Eigen::Isometry3d transform = robot_state.getGlobalLinkTransform(link);
+    transform.translate(link->getCenteredBoundingBoxOffset());
+    boxes.emplace_back();
+    boxes.back().extendWithTransformedBox(transform, link->getShapeExtentsAtOrigin());
+  }
+
+  std::vector<const moveit::core::AttachedBody*> attached_bodies;
+  robot_state.getAttachedBodies(attached_bodies, space.getJointModelGroup());
+  for (const moveit::core::AttachedBody* body : attached_bodies)
+  {
+    boxes.emplace_back();
+    for (std::size_t i = 0; i < body->getShapes().size(); ++i)
+      boxes.back().extendWithTransformedBox(body->getGlobalCollisionBodyTransforms()[i],
+                                            shapes::computeShapeExtents(body->getShapes()[i].get()));
+  }
+}
+
+bool intersects(const Eigen::AlignedBox3d& box, const std::vector<Eigen::AlignedBox3d>& volumes)
+{
+  for (const Eigen::AlignedBox3d& volume : volumes)
+    if (box.intersects(volume))
+      return true;
+  return false;
+}
+}  // namespace
+
+RoadmapSceneSnapshot::RoadmapSceneSnapshot(const planning_scene::PlanningScene& scene,
+                                           const moveit::core::RobotState& start_state)
+{
+  const collision_detection::WorldConstPtr& world = scene.getWorld();
+  for (const std::string& id : world->getObjectIds())
+    objects_[id] = world->getObjectAABB(id);
+
+  std::vector<const moveit::core::AttachedBody*> attached_bodies;
+  start_state.getAttachedBodies(attached_bodies);
+  for (const moveit::core::AttachedBody* body : attached_bodies)
+    attached_bodies_.insert(body->getName());
+}
+
+std::vector<Eigen::AlignedBox3d> RoadmapSceneSnapshot::getChangedVolumes(const RoadmapSceneSnapshot& next) const
+{
+  std::vector<Eigen::AlignedBox3d> volumes;
+  for (const std::pair<const std::string, Eigen::AlignedBox3d>& object : next.objects_)
+  {
+    auto it = objects_.find(object.first);
+    if (it == objects_.end() || !sameBox(it->second, object.second))
+      volumes.push_back(object.second);
+  }
+  return volumes;
+}
+
+bool RoadmapSceneSnapshot::load(const std::string& path)
+{
+  std::ifstream in(path);
+  std::string keyword;
+  std::size_t count;
+  if (!in.good() || !(in >> keyword >> count) || keyword != "objects")
+    return false;
+
+  std::map<std::string, Eigen::AlignedBox3d> objects;
+  for (std::size_t i = 0; i < count; ++i)
+  {
+    std::string id;
+    in >> std::ws;
+    if (!std::getline(in, id))
+      return false;
+    Eigen::AlignedBox3d box;
+    for (int j = 0; j < 3; ++j)
+      if (!readDouble(in, box.min()[j]))
+        return false;
+    for (int j = 0; j < 3; ++j)
+      if (!readDouble(in, box.max()[j]))
+        return false;
+    objects[id] = box;
+  }
+
+  std::set<std::string> attached_bodies;
+  if (!(in >> keyword >> count) || keyword != "attached")
+    return false;
+  for (std::size_t i = 0; i < count; ++i)
+  {
+    std::string name;
+    in >> std::ws;
+    if (!std::getline(in, name))
+      return false;
+    attached_bodies.insert(name);
+  }
+
+  objects_.swap(objects);
+  attached_bodies_.swap(attached_bodies);
+  return true;
+}
+
+bool RoadmapSceneSnapshot::store(const std::string& path) const
+{
+  std::ofstream out(path);
+  if (!out.good())
+    return false;
+
+  out << std::setprecision(std::numeric_limits<double>::max_digits10);
+  out << "objects " << objects_.size() << '\n';
+  for (const std::pair<const std::string, Eigen::AlignedBox3d>& object : objects_)
+  {
+    out << object.first << '\n';
+    out << object.second.min().x() << ' ' << object.second.min().y() << ' ' << object.second.min().z() << ' '
+        << object.second.max().x() << ' ' << object.second.max().y() << ' ' << object.second.max().z() << '\n';
+  }
+  out << "attached " << attached_bodies_.size() << '\n';
+  for (const std::string& name : attached_bodies_)
+    out << name << '\n';
+  return out.good();
+}
+
+std::size_t pruneRoadmap(ompl::base::PlannerData& data, const std::vector<Eigen::AlignedBox3d>& volumes,
+                         moveit::core::RobotState& robot_state)
+{
+  if (volumes.empty() || data.numVertices() == 0)
+    return 0;
+
+  const ompl::base::SpaceInformationPtr& si = data.getSpaceInformation();
+  const auto space = std::dynamic_pointer_cast<ModelBasedStateSpace>(si->getStateSpace());
+  if (!space)
+    return 0;
+
+  // vertices inside a changed volume are removed together with their edges
+  const unsigned int vertex_count = data.numVertices();
+  std::vector<std::vector<moveit::core::AABB>> vertex_boxes(vertex_count);
+  std::vector<bool> vertex_invalid(vertex_count, false);
+  for (unsigned int v = 0; v < vertex_count; ++v)
+  {
+    computeStateBoxes(*space, data.getVertex(v).getState(), robot_state, vertex_boxes[v]);
+    for (const moveit::core::AABB& box : vertex_boxes[v])
+      if (intersects(box, volumes))
+      {
+        vertex_invalid[v] = true;
+        break;
+      }
+  }
+
+  // each edge is swept by the boxes of consecutive states along it
+  std::vector<std::pair<unsigned int, unsigned int>> invalid_edges;
+  std::vector<unsigned int> neighbors;
+  std::vector<moveit::core::AABB> previous, current;
+  ompl::base::State* test = si->allocState();
+  for (unsigned int v1 = 0; v1 < vertex_count; ++v1)
+  {
+    data.getEdges(v1, neighbors);
+    for (unsigned int v2 : neighbors)
+    {
+      // undirected roadmaps store both directions of each edge, check them once
+      if (v2 < v1 && data.edgeExists(v2, v1))
+        continue;
+      if (vertex_invalid[v1] || vertex_invalid[v2])
+        continue;
+
+      const ompl::base::State* s1 = data.getVertex(v1).getState();
+      const ompl::base::State* s2 = data.getVertex(v2).getState();
+      const unsigned int nd = space->validSegmentCount(s1, s2);
+      previous = vertex_boxes[v1];
+      bool invalid = false;
+      for (unsigned int j = 1; j <= nd && !invalid; ++j)
+      {
+        if (j < nd)
+        {
+          space->interpolate(s1, s2, static_cast<double>(j) / nd, test);
+          computeStateBoxes(*space, test, robot_state, current);
+        }
+        else
+          current = vertex_boxes[v2];
+        for (std::size_t k = 0; k < current.size() && !invalid; ++k)
+          invalid = intersects(current[k].merged(previous[k]), volumes);
+        previous.swap(current);
+      }
+      if (invalid)
+        invalid_edges.emplace_back(v1, v2);
+    }
+  }
+  si->freeState(test);
+
+  std::size_t removed = invalid_edges.size();
+  for (const std::pair<unsigned int, unsigned int>& edge : invalid_edges)
+  {
+    data.removeEdge(edge.first, edge.second);
+    data.removeEdge(edge.second, edge.first);
+  }
+
+  // removing a vertex shifts the indices of the following ones, so go backwards
+  for (unsigned int v = vertex_count; v-- > 0;)
+    if (vertex_invalid[v])
+    {
+      data.getEdges(v, neighbors);
+      removed += neighbors.size();
+      data.removeVertex(v);
+    }
+  return removed;
+}
+}  // namespace ompl_interface
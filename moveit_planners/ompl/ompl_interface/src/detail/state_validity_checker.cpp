@@ -50,6 +50,7 @@ ompl_interface::StateValidityChecker::StateValidityChecker(const ModelBasedPlann
   , group_name_(pc->getGroupName())
   , tss_(pc->getCompleteInitialRobotState())
   , verbose_(false)
+  , lazy_collision_checking_(false)
 {
   specs_.clearanceComputationType = ompl::base::StateValidityCheckerSpecs::APPROXIMATE;
   specs_.hasValidDirectionComputation = false;
@@ -73,11 +74,51 @@ void ompl_interface::StateValidityChecker::setVerbose(bool flag)
   verbose_ = flag;
 }
 
-bool ompl_interface::StateValidityChecker::isValid(const ompl::base::State* state, bool verbose) const
+void ompl_interface::StateValidityChecker::setLazyCollisionChecking(bool flag)
+{
+  lazy_collision_checking_ = flag;
+}
+
+moveit::core::RobotState* ompl_interface::StateValidityChecker::getRobotState(const ompl::base::State* state) const
+{
+  // states bound to a RobotState are checked in place
+  moveit::core::RobotState* robot_state = planning_context_->getOMPLStateSpace()->getBoundRobotState(state);
+  if (!robot_state)
+  {
+    robot_state = tss_.getStateStorage();
+    planning_context_->getOMPLStateSpace()->copyToRobotState(*robot_state, state);
+  }
+  return robot_state;
+}
+
+const moveit::core::RobotState*
+ompl_interface::StateValidityChecker::getCheckedRobotState(const ompl::base::State* state) const
 {
+  const moveit::core::RobotState* robot_state = planning_context_->getOMPLStateSpace()->getBoundRobotState(state);
+  if (robot_state)
+    return robot_state;
+
+  robot_state = tss_.getStateStorage();
+  if (robot_state->dirtyLinkTransforms())
+    return nullptr;
+  const double* values = state->as<ModelBasedStateSpace::StateType>()->values;
+  const std::vector<int>& indices = planning_context_->getJointModelGroup()->getVariableIndexList();
+  for (std::size_t i = 0; i < indices.size(); ++i)
+    if (robot_state->getVariablePosition(indices[i]) != values[i])
+      return nullptr;
+  return robot_state;
+}
+
+bool ompl_interface::StateValidityChecker::checkConstraints(const ompl::base::State* state,
+                                                            moveit::core::RobotState*& robot_state, bool verbose) const
+{
+  robot_state = nullptr;
+
   // Use cached validity if it is available
   if (state->as<ModelBasedStateSpace::StateType>()->isValidityKnown())
     return state->as<ModelBasedStateSpace::StateType>()->isMarkedValid();
+  if (state->as<ModelBasedStateSpace::StateType>()->areConstraintsSatisfied())
+    return true;
 
   if (!si_->satisfiesBounds(state))
   {
@@ -87,8 +128,7 @@ bool ompl_interface::StateValidityChecker::isValid(const ompl::base::State* stat
     return false;
   }
 
-  moveit::core::RobotState* robot_state = tss_.getStateStorage();
-  planning_context_->getOMPLStateSpace()->copyToRobotState(*robot_state, state);
+  robot_state = getRobotState(state);
 
   // check path constraints
   const kinematic_constraints::KinematicConstraintSetPtr& kset = planning_context_->getPathConstraints();
@@ -105,11 +145,35 @@ bool ompl_interface::StateValidityChecker::isValid(const ompl::base::State* stat
     return false;
   }
 
-  // check collision avoidance
-  collision_detection::CollisionResult res;
-  planning_context_->getPlanningScene()->checkCollision(
-      verbose ? collision_request_simple_verbose_ : collision_request_simple_, res, *robot_state);
-  if (!res.collision)
+  const_cast<ob::State*>(state)->as<ModelBasedStateSpace::StateType>()->markConstraintsSatisfied();
+  return true;
+}
+
+bool ompl_interface::StateValidityChecker::satisfiesConstraints(const ompl::base::State* state, bool verbose) const
+{
+  moveit::core::RobotState* robot_state;
+  return checkConstraints(state, robot_state, verbose);
+}
+
+bool ompl_interface::StateValidityChecker::isValid(const ompl::base::State* state, bool verbose) const
+{
+  if (state->as<ModelBasedStateSpace::StateType>()->isValidityKnown())
+    return state->as<ModelBasedStateSpace::StateType>()->isMarkedValid();
+
+  // the cheap checks come first, they are answered from the cache if the state was checked lazily before
+  moveit::core::RobotState* robot_state;
+  if (!checkConstraints(state, robot_state, verbose))
+    return false;
+  if (!robot_state)
+  {
+    robot_state = getRobotState(state);
+  }
+
+  // check collision avoidance (binary check, no contacts are computed)
+  const bool collision =
+      planning_context_->getPlanningScene()->isStateColliding(*robot_state, collision_request_simple_.group_name,
+                                                               verbose);
+  if (!collision)
   {
     const_cast<ob::State*>(state)->as<ModelBasedStateSpace::StateType>()->markValid();
   }
@@ -117,7 +181,7 @@ bool ompl_interface::StateValidityChecker::isValid(const ompl::base::State* stat
   {
     const_cast<ob::State*>(state)->as<ModelBasedStateSpace::StateType>()->markInvalid();
   }
-  return !res.collision;
+  return !collision;
 }
 
 bool ompl_interface::StateValidityChecker::isValid(const ompl::base::State* state, double& dist, bool verbose) const
@@ -138,8 +202,7 @@ bool ompl_interface::StateValidityChecker::isValid(const ompl::base::State* stat
     return false;
   }
 
-  moveit::core::RobotState* robot_state = tss_.getStateStorage();
-  planning_context_->getOMPLStateSpace()->copyToRobotState(*robot_state, state);
+  moveit::core::RobotState* robot_state = getRobotState(state);
 
   // check path constraints
   const kinematic_constraints::KinematicConstraintSetPtr& kset = planning_context_->getPathConstraints();
@@ -158,6 +221,7 @@ bool ompl_interface::StateValidityChecker::isValid(const ompl::base::State* stat
   if (!planning_context_->getPlanningScene()->isStateFeasible(*robot_state, verbose))
   {
     dist = 0.0;
+    const_cast<ob::State*>(state)->as<ModelBasedStateSpace::StateType>()->markInvalid(dist);
     return false;
   }
 
@@ -166,6 +230,10 @@ bool ompl_interface::StateValidityChecker::isValid(const ompl::base::State* stat
   planning_context_->getPlanningScene()->checkCollision(
       verbose ? collision_request_with_distance_verbose_ : collision_request_with_distance_, res, *robot_state);
   dist = res.distance;
+  if (res.collision)
+    const_cast<ob::State*>(state)->as<ModelBasedStateSpace::StateType>()->markInvalid(dist);
+  else
+    const_cast<ob::State*>(state)->as<ModelBasedStateSpace::StateType>()->markValid(dist);
   return !res.collision;
 }
 
@@ -173,8 +241,7 @@ double ompl_interface::StateValidityChecker::cost(const ompl::base::State* state
 {
   double cost = 0.0;
 
-  moveit::core::RobotState* robot_state = tss_.getStateStorage();
-  planning_context_->getOMPLStateSpace()->copyToRobotState(*robot_state, state);
+  moveit::core::RobotState* robot_state = getRobotState(state);
 
   // Calculates cost from a summation of distance to obstacles times the size of the obstacle
   collision_detection::CollisionResult res;
@@ -188,8 +255,7 @@ double ompl_interface::StateValidityChecker::cost(const ompl::base::State* state
 
 double ompl_interface::StateValidityChecker::clearance(const ompl::base::State* state) const
 {
-  moveit::core::RobotState* robot_state = tss_.getStateStorage();
-  planning_context_->getOMPLStateSpace()->copyToRobotState(*robot_state, state);
+  moveit::core::RobotState* robot_state = getRobotState(state);
 
   collision_detection::CollisionResult res;
   planning_context_->getPlanningScene()->checkCollision(collision_request_with_distance_, res, *robot_state);
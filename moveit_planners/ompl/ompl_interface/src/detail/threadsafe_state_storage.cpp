@@ -35,14 +35,33 @@
 /* Author: Ioan Sucan */
 
 #include <moveit/ompl_interface/detail/threadsafe_state_storage.h>
+#include <array>
+#include <atomic>
+
+namespace
+{
+std::atomic<std::uint64_t> next_storage_id(1);
+
+struct ThreadStateCacheEntry
+{
+  std::uint64_t storage_id = 0;
+  moveit::core::RobotState* state = nullptr;
+};
+
+// each thread remembers its states of the storages it used most recently
+constexpr std::size_t THREAD_STATE_CACHE_SIZE = 8;
+thread_local std::array<ThreadStateCacheEntry, THREAD_STATE_CACHE_SIZE> thread_state_cache;
+thread_local std::size_t thread_state_cache_next = 0;
+}  // namespace
 
 ompl_interface::TSStateStorage::TSStateStorage(const moveit::core::RobotModelPtr& robot_model)
-  : start_state_(robot_model)
+  : start_state_(robot_model), id_(next_storage_id++)
 {
   start_state_.setToDefaultValues();
 }
 
-ompl_interface::TSStateStorage::TSStateStorage(const moveit::core::RobotState& start_state) : start_state_(start_state)
+ompl_interface::TSStateStorage::TSStateStorage(const moveit::core::RobotState& start_state)
+  : start_state_(start_state), id_(next_storage_id++)
 {
 }
 
@@ -53,17 +72,32 @@ ompl_interface::TSStateStorage::~TSStateStorage()
 }
 
 moveit::core::RobotState* ompl_interface::TSStateStorage::getStateStorage() const
+{
+  for (const ThreadStateCacheEntry& entry : thread_state_cache)
+    if (entry.storage_id == id_)
+      return entry.state;
+  return getStateStorageSlow();
+}
+
+moveit::core::RobotState* ompl_interface::TSStateStorage::getStateStorageSlow() const
 {
   moveit::core::RobotState* st = nullptr;
-  std::unique_lock<std::mutex> slock(lock_);  /// \todo use Thread Local Storage?
-  std::map<std::thread::id, moveit::core::RobotState*>::const_iterator it =
-      thread_states_.find(std::this_thread::get_id());
-  if (it == thread_states_.end())
   {
-    st = new moveit::core::RobotState(start_state_);
-    thread_states_[std::this_thread::get_id()] = st;
+    std::unique_lock<std::mutex> slock(lock_);
+    std::map<std::thread::id, moveit::core::RobotState*>::const_iterator it =
+        thread_states_.find(std::this_thread::get_id());
+    if (it == thread_states_.end())
+    {
+      st = new moveit::core::RobotState(start_state_);
+      thread_states_[std::this_thread::get_id()] = st;
+    }
+    else
+      st = it->second;
   }
-  else
-    st = it->second;
+
+  ThreadStateCacheEntry& entry = thread_state_cache[thread_state_cache_next];
+  thread_state_cache_next = (thread_state_cache_next + 1) % THREAD_STATE_CACHE_SIZE;
+  entry.storage_id = id_;
+  entry.state = st;
   return st;
 }
@@ -39,18 +39,24 @@
 
 #include <moveit/ompl_interface/model_based_planning_context.h>
 #include <moveit/ompl_interface/detail/state_validity_checker.h>
+#include <moveit/ompl_interface/detail/lazy_motion_validator.h>
+#include <moveit/ompl_interface/detail/clearance_motion_validator.h>
 #include <moveit/ompl_interface/detail/constrained_sampler.h>
 #include <moveit/ompl_interface/detail/constrained_goal_sampler.h>
 #include <moveit/ompl_interface/detail/goal_union.h>
 #include <moveit/ompl_interface/detail/projection_evaluators.h>
 #include <moveit/ompl_interface/detail/constraints_library.h>
+#include <moveit/ompl_interface/detail/threadsafe_state_storage.h>
+#include <moveit/ompl_interface/parameterization/joint_space/robot_state_bound_state_space.h>
 
+#include <moveit/constraint_samplers/projection_constraint_sampler.h>
 #include <moveit/kinematic_constraints/utils.h>
 #include <moveit/profiler/profiler.h>
 #include <moveit/utils/lexical_casts.h>
 
 #include <ompl/config.h>
 #include <ompl/base/samplers/UniformValidStateSampler.h>
+#include <ompl/base/DiscreteMotionValidator.h>
 #include <ompl/base/goals/GoalLazySamples.h>
 #include <ompl/tools/config/SelfConfig.h>
 #include <ompl/base/spaces/SE3StateSpace.h>
@@ -71,10 +77,27 @@
 #include "ompl/base/objectives/StateCostIntegralObjective.h"
 #include "ompl/base/objectives/MaximizeMinClearanceObjective.h"
 #include <ompl/geometric/planners/prm/LazyPRM.h>
+#include <ompl/geometric/planners/rrt/RRTConnect.h>
+#include <ompl/geometric/PathHybridization.h>
+#include <ompl/geometric/PathSimplifier.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
 
 namespace ompl_interface
 {
 constexpr char LOGNAME[] = "model_based_planning_context";
+
+namespace
+{
+// number of stored experiences that are repaired, one after the other, while planning from scratch
+constexpr std::size_t MAX_EXPERIENCE_CANDIDATES = 3;
+}  // namespace
 }  // namespace ompl_interface
 
 ompl_interface::ModelBasedPlanningContext::ModelBasedPlanningContext(const std::string& name,
@@ -82,12 +105,19 @@ ompl_interface::ModelBasedPlanningContext::ModelBasedPlanningContext(const std::
   : planning_interface::PlanningContext(name, spec.state_space_->getJointModelGroup()->getName())
   , spec_(spec)
   , complete_initial_robot_state_(spec.state_space_->getRobotModel())
+  , state_pool_(std::make_shared<moveit::core::RobotStatePool>(spec.state_space_->getRobotModel()))
   , ompl_simple_setup_(spec.ompl_simple_setup_)
   , ompl_benchmark_(*ompl_simple_setup_)
   , ompl_parallel_plan_(ompl_simple_setup_->getProblemDefinition())
   , ptc_(nullptr)
   , last_plan_time_(0.0)
   , last_simplify_time_(0.0)
+  , last_solution_from_experience_(false)
+  , last_solution_simplified_(false)
+  , last_setup_time_(0.0)
+  , last_setup_partial_(false)
+  , configured_max_solution_segment_length_(0.0)
+  , configured_(false)
   , max_goal_samples_(0)
   , max_state_sampling_attempts_(0)
   , max_goal_sampling_attempts_(0)
@@ -95,9 +125,16 @@ ompl_interface::ModelBasedPlanningContext::ModelBasedPlanningContext(const std::
   , max_solution_segment_length_(0.0)
   , minimum_waypoint_count_(0)
   , multi_query_planning_enabled_(false)  // maintain "old" behavior by default
+  , scene_aware_roadmap_(false)
   , simplify_solutions_(true)
   , interpolate_(true)
   , hybridize_(true)
+  , lazy_collision_checking_(false)
+  , adaptive_motion_validation_(false)
+  , project_path_constraints_(false)
+  , pipelined_simplification_(false)
+  , simplification_threads_(2)
+  , portfolio_wait_for_best_(false)
 {
   complete_initial_robot_state_.update();
 
@@ -106,11 +143,11 @@ ompl_interface::ModelBasedPlanningContext::ModelBasedPlanningContext(const std::
 
 void ompl_interface::ModelBasedPlanningContext::configure(const ros::NodeHandle& nh, bool use_constraints_approximations)
 {
-  loadConstraintApproximations(nh);
-  if (!use_constraints_approximations)
-  {
+  ros::WallTime start = ros::WallTime::now();
+  if (use_constraints_approximations)
+    loadConstraintApproximations(nh);
+  else
     setConstraintsApproximations(ConstraintsLibraryPtr());
-  }
   complete_initial_robot_state_.update();
   ompl_simple_setup_->getStateSpace()->computeSignature(space_signature_);
   ompl_simple_setup_->getStateSpace()->setStateSamplerAllocator(
@@ -120,8 +157,10 @@ void ompl_interface::ModelBasedPlanningContext::configure(const ros::NodeHandle&
   ompl::base::ScopedState<> ompl_start_state(spec_.state_space_);
   spec_.state_space_->copyToOMPLState(ompl_start_state.get(), getCompleteInitialRobotState());
   ompl_simple_setup_->setStartState(ompl_start_state);
-  ompl_simple_setup_->setStateValidityChecker(ob::StateValidityCheckerPtr(new StateValidityChecker(this)));
+  auto state_validity_checker = std::make_shared<StateValidityChecker>(this);
+  ompl_simple_setup_->setStateValidityChecker(state_validity_checker);
 
+  bool precomputed_interpolation = false;
   if (path_constraints_ && constraints_library_)
   {
     const ConstraintApproximationPtr& constraint_approx =
@@ -130,12 +169,44 @@ void ompl_interface::ModelBasedPlanningContext::configure(const ros::NodeHandle&
     {
       getOMPLStateSpace()->setInterpolationFunction(constraint_approx->getInterpolationFunction());
       ROS_INFO_NAMED(LOGNAME, "Using precomputed interpolation states");
+      precomputed_interpolation = true;
     }
   }
 
-  useConfig();
+  // the planner, projection evaluator and parameters only depend on the configuration; when just the start state,
+  // goals or scene changed since the last request, they are kept instead of being allocated again
+  last_setup_partial_ = configured_ && spec_.config_ == configured_config_ &&
+                        max_solution_segment_length_ == configured_max_solution_segment_length_;
+  if (!last_setup_partial_)
+  {
+    useConfig();
+    configured_config_ = spec_.config_;
+    configured_max_solution_segment_length_ = max_solution_segment_length_;
+    configured_ = true;
+  }
+
+  if (project_path_constraints_ && path_constraints_ && !precomputed_interpolation)
+    useProjectedInterpolation();
+
+  // in lazy mode, collisions are only checked along motions; the motion validator is replaced back
+  // by OMPL's default one when lazy mode and adaptive motion validation are disabled again
+  const ob::SpaceInformationPtr& si = ompl_simple_setup_->getSpaceInformation();
+  state_validity_checker->setLazyCollisionChecking(lazy_collision_checking_);
+  if (lazy_collision_checking_)
+    si->setMotionValidator(std::make_shared<LazyMotionValidator>(si, state_validity_checker));
+  else if (adaptive_motion_validation_)
+    // the swept distance bounds depend on the attached bodies, so the validator is created for every request
+    si->setMotionValidator(std::make_shared<ClearanceMotionValidator>(si, this, state_validity_checker));
+  else if (std::dynamic_pointer_cast<LazyMotionValidator>(si->getMotionValidator()) ||
+           std::dynamic_pointer_cast<ClearanceMotionValidator>(si->getMotionValidator()))
+    si->setMotionValidator(std::make_shared<ob::DiscreteMotionValidator>(si));
+
   if (ompl_simple_setup_->getGoal())
     ompl_simple_setup_->setup();
+
+  last_setup_time_ = (ros::WallTime::now() - start).toSec();
+  ROS_DEBUG_NAMED(LOGNAME, "%s: %s setup took %lf seconds", name_.c_str(), last_setup_partial_ ? "Partial" : "Full",
+                  last_setup_time_);
 }
 
 void ompl_interface::ModelBasedPlanningContext::setProjectionEvaluator(const std::string& peval)
@@ -198,6 +269,25 @@ ompl_interface::ModelBasedPlanningContext::getProjectionEvaluator(const std::str
     else
       return ob::ProjectionEvaluatorPtr(new ProjectionEvaluatorJointValue(this, j));
   }
+  else if (peval == "pca" || (peval.compare(0, 4, "pca(") == 0 && peval[peval.length() - 1] == ')'))
+  {
+    // the projection is learned from the valid states of the group, onto 3 dimensions unless specified otherwise
+    unsigned int dimension = 3;
+    if (peval != "pca")
+    {
+      try
+      {
+        dimension = boost::lexical_cast<unsigned int>(boost::trim_copy(peval.substr(4, peval.length() - 5)));
+      }
+      catch (boost::bad_lexical_cast&)
+      {
+        ROS_ERROR_NAMED(LOGNAME, "%s: Invalid dimension in projection evaluator description '%s'", name_.c_str(),
+                        peval.c_str());
+        return ob::ProjectionEvaluatorPtr();
+      }
+    }
+    return ob::ProjectionEvaluatorPtr(new ProjectionEvaluatorPCA(this, dimension));
+  }
   else
     ROS_ERROR_NAMED(LOGNAME, "Unable to allocate projection evaluator based on description: '%s'", peval.c_str());
   return ob::ProjectionEvaluatorPtr();
@@ -216,6 +306,18 @@ ompl_interface::ModelBasedPlanningContext::allocPathConstrainedSampler(const omp
 
   if (path_constraints_)
   {
+    if (project_path_constraints_)
+    {
+      auto projection_sampler = std::make_shared<constraint_samplers::ProjectionConstraintSampler>(
+          getPlanningScene(), getGroupName());
+      if (projection_sampler->configure(path_constraints_->getAllConstraints()))
+      {
+        ROS_DEBUG_NAMED(LOGNAME, "%s: Allocating state sampler that projects onto the path constraints",
+                        name_.c_str());
+        return ob::StateSamplerPtr(new ConstrainedSampler(this, projection_sampler));
+      }
+    }
+
     if (constraints_library_)
     {
       const ConstraintApproximationPtr& constraint_approx =
@@ -253,6 +355,41 @@ ompl_interface::ModelBasedPlanningContext::allocPathConstrainedSampler(const omp
   return state_space->allocDefaultStateSampler();
 }
 
+void ompl_interface::ModelBasedPlanningContext::useProjectedInterpolation()
+{
+  auto projection_sampler =
+      std::make_shared<constraint_samplers::ProjectionConstraintSampler>(getPlanningScene(), getGroupName());
+  if (!projection_sampler->configure(path_constraints_->getAllConstraints()))
+  {
+    ROS_DEBUG_NAMED(LOGNAME, "%s: Path constraints cannot be projected for group '%s'", name_.c_str(),
+                    getGroupName().c_str());
+    return;
+  }
+
+  // the function is owned by the state space, so the space is not captured by a shared pointer
+  ModelBasedStateSpace* state_space = spec_.state_space_.get();
+  auto storage = std::make_shared<TSStateStorage>(getCompleteInitialRobotState());
+  state_space->setInterpolationFunction([state_space, projection_sampler, storage](
+                                            const ob::State* from, const ob::State* to, const double t,
+                                            ob::State* state) {
+    state_space->getJointModelGroup()->interpolate(from->as<ModelBasedStateSpace::StateType>()->values,
+                                                   to->as<ModelBasedStateSpace::StateType>()->values, t,
+                                                   state->as<ModelBasedStateSpace::StateType>()->values);
+    state->as<ModelBasedStateSpace::StateType>()->tag = -1;
+
+    // the end points are kept as they are, states in between are moved onto the constraints if possible
+    if (t > 0.0 && t < 1.0)
+    {
+      moveit::core::RobotState* robot_state = storage->getStateStorage();
+      state_space->copyToRobotState(*robot_state, state);
+      if (projection_sampler->project(*robot_state))
+        state_space->copyToOMPLState(state, *robot_state);
+    }
+    return true;
+  });
+  ROS_DEBUG_NAMED(LOGNAME, "%s: Projecting interpolated states onto the path constraints", name_.c_str());
+}
+
 void ompl_interface::ModelBasedPlanningContext::useConfig()
 {
   const std::map<std::string, std::string>& config = spec_.config_;
@@ -341,6 +478,18 @@ void ompl_interface::ModelBasedPlanningContext::useConfig()
   if (it != cfg.end())
     multi_query_planning_enabled_ = boost::lexical_cast<bool>(it->second);
 
+  // roadmaps of multi-query planners are updated to scene changes by the PlanningContextManager
+  it = cfg.find("scene_aware_roadmap");
+  if (it != cfg.end())
+  {
+    scene_aware_roadmap_ = boost::lexical_cast<bool>(it->second);
+    cfg.erase(it);
+  }
+
+  // the experience library is set up by the PlanningContextManager
+  for (const char* experience_param : { "use_experience", "experience_path", "max_experiences" })
+    cfg.erase(experience_param);
+
   // check whether the path returned by the planner should be interpolated
   it = cfg.find("interpolate");
   if (it != cfg.end())
@@ -349,6 +498,54 @@ void ompl_interface::ModelBasedPlanningContext::useConfig()
     cfg.erase(it);
   }
 
+  // check whether collision checks of sampled states should be deferred to motion validation
+  it = cfg.find("lazy_collision_checking");
+  if (it != cfg.end())
+  {
+    lazy_collision_checking_ = boost::lexical_cast<bool>(it->second);
+    cfg.erase(it);
+  }
+
+  // check whether the collision checking resolution along motions should adapt to the distance to obstacles
+  it = cfg.find("adaptive_motion_validation");
+  if (it != cfg.end())
+  {
+    adaptive_motion_validation_ = boost::lexical_cast<bool>(it->second);
+    cfg.erase(it);
+  }
+
+  // check whether sampled and interpolated states should be projected onto the path constraints
+  it = cfg.find("project_path_constraints");
+  if (it != cfg.end())
+  {
+    project_path_constraints_ = boost::lexical_cast<bool>(it->second);
+    cfg.erase(it);
+  }
+
+  // check whether solutions should be simplified while planning continues
+  it = cfg.find("pipelined_simplification");
+  if (it != cfg.end())
+  {
+    pipelined_simplification_ = boost::lexical_cast<bool>(it->second);
+    cfg.erase(it);
+  }
+  it = cfg.find("simplification_threads");
+  if (it != cfg.end())
+  {
+    simplification_threads_ = boost::lexical_cast<unsigned int>(it->second);
+    cfg.erase(it);
+  }
+
+  // the parameterization is chosen by the planning context manager
+  it = cfg.find("bind_robot_state");
+  if (it != cfg.end())
+    cfg.erase(it);
+
+  // the number of goal sampling threads is read by the ConstrainedGoalSampler
+  it = cfg.find("goal_sampling_threads");
+  if (it != cfg.end())
+    cfg.erase(it);
+
   // check whether solution paths from parallel planning should be hybridized
   it = cfg.find("hybridize");
   if (it != cfg.end())
@@ -357,6 +554,37 @@ void ompl_interface::ModelBasedPlanningContext::useConfig()
     cfg.erase(it);
   }
 
+  // planners of different types that run concurrently, e.g. "geometric::RRTConnect, geometric::BiTRRT"
+  it = cfg.find("portfolio");
+  if (it != cfg.end())
+  {
+    portfolio_.clear();
+    std::vector<std::string> types;
+    boost::split(types, it->second, boost::is_any_of(","));
+    for (std::string& type : types)
+    {
+      boost::trim(type);
+      if (type.empty())
+        continue;
+      ConfiguredPlannerAllocator allocator = spec_.planner_selector_(type);
+      if (!allocator)
+        continue;
+      const std::string planner_name = getGroupName() + "/" + name_ + "/" + type;
+      portfolio_.push_back([planner_name, &spec = this->spec_, allocator](const ob::SpaceInformationPtr& si) {
+        return allocator(si, planner_name, spec);
+      });
+    }
+    cfg.erase(it);
+  }
+
+  // wait for the best solution of the portfolio until the deadline, instead of using the first one
+  it = cfg.find("portfolio_wait_for_best");
+  if (it != cfg.end())
+  {
+    portfolio_wait_for_best_ = boost::lexical_cast<bool>(it->second);
+    cfg.erase(it);
+  }
+
   // remove the 'type' parameter; the rest are parameters for the planner itself
   it = cfg.find("type");
   if (it == cfg.end())
@@ -444,6 +672,8 @@ void ompl_interface::ModelBasedPlanningContext::convertPath(const ompl::geometri
                                                             robot_trajectory::RobotTrajectory& traj) const
 {
   moveit::core::RobotState ks = complete_initial_robot_state_;
+  if (!traj.getStatePool() && traj.getRobotModel() == state_pool_->getRobotModel())
+    traj.setStatePool(state_pool_);
   for (std::size_t i = 0; i < pg.getStateCount(); ++i)
   {
     spec_.state_space_->copyToRobotState(ks, pg.getState(i));
@@ -556,6 +786,10 @@ void ompl_interface::ModelBasedPlanningContext::setCompleteInitialState(
 {
   complete_initial_robot_state_ = complete_initial_robot_state;
   complete_initial_robot_state_.update();
+
+  // states bound to a RobotState take the joints outside the group from the initial state
+  if (auto* bound_space = dynamic_cast<RobotStateBoundStateSpace*>(spec_.state_space_.get()))
+    bound_space->setReferenceState(complete_initial_robot_state_);
 }
 
 void ompl_interface::ModelBasedPlanningContext::clear()
@@ -569,9 +803,10 @@ void ompl_interface::ModelBasedPlanningContext::clear()
     // For LazyPRM and LazyPRMstar we assume that the environment *could* have changed
     // This means that we need to reset the validity flags for every node and edge in
     // the roadmap. For PRM and PRMstar we assume that the environment is static. If
-    // this is not the case, then multi-query planning should not be enabled.
+    // this is not the case, then multi-query planning should not be enabled, unless
+    // the roadmap is scene-aware: then only the edges affected by scene changes are removed.
     auto planner = dynamic_cast<ompl::geometric::LazyPRM*>(ompl_simple_setup_->getPlanner().get());
-    if (planner != nullptr)
+    if (planner != nullptr && !scene_aware_roadmap_)
       planner->clearValidity();
   }
 #endif
@@ -686,14 +921,21 @@ bool ompl_interface::ModelBasedPlanningContext::solve(planning_interface::Motion
   if (res.error_code_.val == moveit_msgs::MoveItErrorCodes::SUCCESS)
   {
     double ptime = getLastPlanTime();
-    if (simplify_solutions_)
+    res.addStageTime("solve/plan", ptime);
+    if (simplify_solutions_ && !last_solution_simplified_)
     {
       simplifySolution(request_.allowed_planning_time - ptime);
       ptime += getLastSimplifyTime();
+      res.addStageTime("solve/simplify", getLastSimplifyTime());
     }
+    recordExperience();
 
     if (interpolate_)
+    {
+      ompl::time::point start_interpolate = ompl::time::now();
       interpolateSolution();
+      res.addStageTime("solve/interpolate", ompl::time::seconds(ompl::time::now() - start_interpolate));
+    }
 
     // fill the response
     ROS_DEBUG_NAMED(LOGNAME, "%s: Returning successful solution with %lu states", getName().c_str(),
@@ -727,7 +969,7 @@ bool ompl_interface::ModelBasedPlanningContext::solve(planning_interface::Motion
     getSolutionPath(*res.trajectory_.back());
 
     // simplify solution if time remains
-    if (simplify_solutions_)
+    if (simplify_solutions_ && !last_solution_simplified_)
     {
       simplifySolution(request_.allowed_planning_time - ptime);
       res.processing_time_.push_back(getLastSimplifyTime());
@@ -736,6 +978,7 @@ bool ompl_interface::ModelBasedPlanningContext::solve(planning_interface::Motion
       res.trajectory_.back() = std::make_shared<robot_trajectory::RobotTrajectory>(getRobotModel(), getGroupName());
       getSolutionPath(*res.trajectory_.back());
     }
+    recordExperience();
 
     if (interpolate_)
     {
@@ -769,10 +1012,62 @@ const moveit_msgs::MoveItErrorCodes ompl_interface::ModelBasedPlanningContext::s
   result.val = moveit_msgs::MoveItErrorCodes::FAILURE;
   ob::PlannerTerminationCondition ptc = constructPlannerTerminationCondition(timeout, start);
   registerTerminationCondition(ptc);
-  if (count <= 1 || multi_query_planning_enabled_)  // multi-query planners should always run in single instances
+
+  // Stored experiences are repaired while planning from scratch, whichever finishes first cancels the other
+  last_solution_from_experience_ = false;
+  last_solution_simplified_ = false;
+  std::atomic<bool> experience_repaired(false);
+  og::PathGeometric repaired_path(ompl_simple_setup_->getSpaceInformation());
+  std::thread repair_thread;
+  ob::PlannerTerminationCondition planning_ptc = ptc;
+  const std::vector<ExperienceLibrary::ExperienceConstPtr> experiences = findExperiences();
+  if (!experiences.empty())
+  {
+    ROS_DEBUG_NAMED(LOGNAME, "%s: Repairing %zu stored experiences while planning...", name_.c_str(),
+                    experiences.size());
+    repair_thread = std::thread([this, &experiences, &ptc, &experience_repaired, &repaired_path] {
+      ob::PlannerTerminationCondition repair_ptc = ob::plannerOrTerminationCondition(
+          ptc, ob::exactSolnPlannerTerminationCondition(ompl_simple_setup_->getProblemDefinition()));
+      for (const ExperienceLibrary::ExperienceConstPtr& experience : experiences)
+        if (!repair_ptc() && repairExperience(*experience, repair_ptc, repaired_path))
+        {
+          experience_repaired = true;
+          break;
+        }
+    });
+    planning_ptc = ob::plannerOrTerminationCondition(
+        ptc, ob::PlannerTerminationCondition([&experience_repaired] { return experience_repaired.load(); }));
+  }
+
+  if (!portfolio_.empty() && !multi_query_planning_enabled_)
+  {
+    ROS_DEBUG_NAMED(LOGNAME, "%s: Solving the planning problem with a portfolio of %zu planners...", name_.c_str(),
+                    portfolio_.size());
+    ompl_parallel_plan_.clearHybridizationPaths();
+    ompl_parallel_plan_.clearPlanners();
+    for (const ob::PlannerAllocator& allocator : portfolio_)
+      ompl_parallel_plan_.addPlannerAllocator(allocator);
+
+    // the first solution cancels the other planners, unless the best solution until the deadline is requested
+    result.val = errorCode(portfolio_wait_for_best_ ?
+                               ompl_parallel_plan_.solve(planning_ptc, hybridize_) :
+                               ompl_parallel_plan_.solve(planning_ptc, 1, portfolio_.size(), false));
+    last_plan_time_ = ompl::time::seconds(ompl::time::now() - start);
+    const std::vector<ob::PlannerSolution> solutions = ompl_simple_setup_->getProblemDefinition()->getSolutions();
+    if (!solutions.empty())
+      ROS_DEBUG_NAMED(LOGNAME, "%s: Best solution found by '%s'", name_.c_str(),
+                      solutions.front().plannerName_.c_str());
+  }
+  else if (pipelined_simplification_ && simplify_solutions_ && !multi_query_planning_enabled_)
+  {
+    ROS_DEBUG_NAMED(LOGNAME, "%s: Solving the planning problem with pipelined simplification...", name_.c_str());
+    result.val = errorCode(solvePipelined(planning_ptc, ptc));
+    last_plan_time_ = ompl::time::seconds(ompl::time::now() - start);
+  }
+  else if (count <= 1 || multi_query_planning_enabled_)  // multi-query planners should always run in single instances
   {
     ROS_DEBUG_NAMED(LOGNAME, "%s: Solving the planning problem once...", name_.c_str());
-    result.val = errorCode(ompl_simple_setup_->solve(ptc));
+    result.val = errorCode(ompl_simple_setup_->solve(planning_ptc));
     last_plan_time_ = ompl_simple_setup_->getLastPlanComputationTime();
   }
   else
@@ -780,7 +1075,7 @@ const moveit_msgs::MoveItErrorCodes ompl_interface::ModelBasedPlanningContext::s
     ROS_DEBUG_NAMED(LOGNAME, "%s: Solving the planning problem %u times...", name_.c_str(), count);
     ompl_parallel_plan_.clearHybridizationPaths();
 
-    auto plan_parallel = [this, &ptc](unsigned int num_planners) {
+    auto plan_parallel = [this, &ptc = planning_ptc](unsigned int num_planners) {
       ompl_parallel_plan_.clearPlanners();
       if (ompl_simple_setup_->getPlannerAllocator())
         for (unsigned int i = 0; i < num_planners; ++i)
@@ -799,18 +1094,224 @@ const moveit_msgs::MoveItErrorCodes ompl_interface::ModelBasedPlanningContext::s
     else
     {
       int n = count / max_planning_threads_;
-      for (int i = 0; i < n && result.val != moveit_msgs::MoveItErrorCodes::SUCCESS && !ptc(); ++i)
+      for (int i = 0; i < n && result.val != moveit_msgs::MoveItErrorCodes::SUCCESS && !planning_ptc(); ++i)
         result.val = plan_parallel(max_planning_threads_);
-      if (result.val != moveit_msgs::MoveItErrorCodes::SUCCESS && !ptc())
+      if (result.val != moveit_msgs::MoveItErrorCodes::SUCCESS && !planning_ptc())
         result.val = plan_parallel(count % max_planning_threads_);
     }
     last_plan_time_ = ompl::time::seconds(ompl::time::now() - start);
   }
+
+  if (repair_thread.joinable())
+  {
+    repair_thread.join();
+    if (experience_repaired && result.val != moveit_msgs::MoveItErrorCodes::SUCCESS)
+    {
+      ROS_DEBUG_NAMED(LOGNAME, "%s: Using a repaired experience with %zu states", name_.c_str(),
+                      repaired_path.getStateCount());
+      ompl_simple_setup_->getProblemDefinition()->clearSolutionPaths();
+      ompl_simple_setup_->getProblemDefinition()->addSolutionPath(std::make_shared<og::PathGeometric>(repaired_path),
+                                                                  false, 0.0, "experience");
+      last_solution_from_experience_ = true;
+      last_plan_time_ = ompl::time::seconds(ompl::time::now() - start);
+      result.val = moveit_msgs::MoveItErrorCodes::SUCCESS;
+    }
+  }
   unregisterTerminationCondition();
   postSolve();
   return result;
 }
 
+ompl::base::PlannerStatus
+ompl_interface::ModelBasedPlanningContext::solvePipelined(const ob::PlannerTerminationCondition& planning_ptc,
+                                                          const ob::PlannerTerminationCondition& ptc)
+{
+  ob::PlannerStatus status = ompl_simple_setup_->solve(planning_ptc);
+  if (status != ob::PlannerStatus::EXACT_SOLUTION)
+    return status;
+
+  const ob::SpaceInformationPtr& si = ompl_simple_setup_->getSpaceInformation();
+  const ob::ProblemDefinitionPtr& pdef = ompl_simple_setup_->getProblemDefinition();
+  const unsigned int thread_count = std::max(1u, simplification_threads_);
+  std::mutex lock;
+  std::condition_variable condition;
+  std::deque<og::PathGeometric> pending;
+  std::shared_ptr<og::PathGeometric> best;
+  bool planning_done = false;
+
+  // each simplified path is hybridized with the best path so far, and the shortest of them is kept
+  std::vector<std::thread> simplifiers;
+  for (unsigned int i = 0; i < thread_count; ++i)
+    simplifiers.emplace_back([&] {
+      og::PathSimplifier simplifier(si, pdef->getGoal());
+      std::unique_lock<std::mutex> guard(lock);
+      while (true)
+      {
+        condition.wait(guard, [&] { return planning_done || !pending.empty(); });
+        if (pending.empty())
+          return;
+        auto path = std::make_shared<og::PathGeometric>(pending.front());
+        pending.pop_front();
+        std::shared_ptr<og::PathGeometric> other = best;
+        condition.notify_all();
+        guard.unlock();
+
+        simplifier.simplify(*path, ptc);
+        std::shared_ptr<og::PathGeometric> candidate = path;
+        if (other)
+        {
+          og::PathHybridization hybridization(si);
+          hybridization.recordPath(path, false);
+          hybridization.recordPath(other, false);
+          hybridization.computeHybridPath();
+          const auto hybrid = std::dynamic_pointer_cast<og::PathGeometric>(hybridization.getHybridPath());
+          if (hybrid && hybrid->length() < candidate->length())
+            candidate = std::make_shared<og::PathGeometric>(*hybrid);
+        }
+
+        guard.lock();
+        if (!best || candidate->length() < best->length())
+          best = candidate;
+      }
+    });
+
+  // the planner searches again from scratch for every new path, so the hybridized paths differ
+  unsigned int path_count = 0;
+  while (status == ob::PlannerStatus::EXACT_SOLUTION)
+  {
+    ++path_count;
+    std::unique_lock<std::mutex> guard(lock);
+    pending.push_back(ompl_simple_setup_->getSolutionPath());
+    condition.notify_all();
+    while (pending.size() >= thread_count && !planning_ptc())
+      condition.wait_for(guard, std::chrono::milliseconds(10));
+    guard.unlock();
+    if (planning_ptc())
+      break;
+    ompl_simple_setup_->getPlanner()->clear();
+    pdef->clearSolutionPaths();
+    status = ompl_simple_setup_->solve(planning_ptc);
+  }
+
+  {
+    std::lock_guard<std::mutex> guard(lock);
+    planning_done = true;
+  }
+  condition.notify_all();
+  for (std::thread& simplifier : simplifiers)
+    simplifier.join();
+
+  ROS_DEBUG_NAMED(LOGNAME, "%s: Simplified and hybridized %u paths, the best has %zu states", name_.c_str(),
+                  path_count, best->getStateCount());
+  pdef->clearSolutionPaths();
+  pdef->addSolutionPath(best, false, 0.0, ompl_simple_setup_->getPlanner()->getName());
+  last_solution_simplified_ = true;
+  last_simplify_time_ = 0.0;
+  return ob::PlannerStatus::EXACT_SOLUTION;
+}
+
+std::vector<ompl_interface::ExperienceLibrary::ExperienceConstPtr>
+ompl_interface::ModelBasedPlanningContext::findExperiences() const
+{
+  std::vector<ExperienceLibrary::ExperienceConstPtr> experiences;
+  const ob::ProblemDefinitionPtr& pdef = ompl_simple_setup_->getProblemDefinition();
+  if (!spec_.experience_library_ || pdef->getStartStateCount() == 0)
+    return experiences;
+
+  const moveit::core::JointModelGroup* jmg = getJointModelGroup();
+  const double* start = pdef->getStartState(0)->as<ModelBasedStateSpace::StateType>()->values;
+  const std::size_t scene_hash = computeSceneHash(*getPlanningScene());
+  moveit::core::RobotState robot_state(complete_initial_robot_state_);
+
+  // sort key: experiences of the current scene first, then by the distance of their start to the start state
+  std::vector<std::pair<std::pair<bool, double>, ExperienceLibrary::ExperienceConstPtr>> candidates;
+  for (const ExperienceLibrary::ExperienceConstPtr& experience : spec_.experience_library_->getExperiences())
+  {
+    if (experience->waypoints.front().size() != jmg->getVariableCount())
+      continue;
+    robot_state.setJointGroupPositions(jmg, experience->waypoints.back());
+    robot_state.update();
+    bool satisfies_goal = false;
+    for (const kinematic_constraints::KinematicConstraintSetPtr& goal_constraint : goal_constraints_)
+      if (goal_constraint->decide(robot_state).satisfied)
+      {
+        satisfies_goal = true;
+        break;
+      }
+    if (satisfies_goal)
+    {
+      const double distance = jmg->distance(start, experience->waypoints.front().data());
+      candidates.emplace_back(std::make_pair(experience->scene_hash != scene_hash, distance), experience);
+    }
+  }
+  std::sort(candidates.begin(), candidates.end(), [](const auto& a, const auto& b) { return a.first < b.first; });
+
+  for (std::size_t i = 0; i < candidates.size() && i < MAX_EXPERIENCE_CANDIDATES; ++i)
+    experiences.push_back(candidates[i].second);
+  return experiences;
+}
+
+bool ompl_interface::ModelBasedPlanningContext::repairExperience(const ExperienceLibrary::Experience& experience,
+                                                                 const ob::PlannerTerminationCondition& ptc,
+                                                                 og::PathGeometric& path) const
+{
+  const ob::SpaceInformationPtr& si = ompl_simple_setup_->getSpaceInformation();
+  path = og::PathGeometric(si, ompl_simple_setup_->getProblemDefinition()->getStartState(0));
+
+  ob::ScopedState<> waypoint(si);
+  for (std::size_t i = 0; i < experience.waypoints.size() && !ptc(); ++i)
+  {
+    std::copy(experience.waypoints[i].begin(), experience.waypoints[i].end(),
+              waypoint->as<ModelBasedStateSpace::StateType>()->values);
+    waypoint->as<ModelBasedStateSpace::StateType>()->clearKnownInformation();
+
+    // waypoints that became invalid are skipped, except for the final one that satisfies the goal
+    if (!si->isValid(waypoint.get()))
+    {
+      if (i + 1 == experience.waypoints.size())
+        return false;
+      continue;
+    }
+
+    ob::State* last = path.getState(path.getStateCount() - 1);
+    if (si->checkMotion(last, waypoint.get()))
+    {
+      path.append(waypoint.get());
+      continue;
+    }
+
+    // replan the invalid segment
+    auto pdef = std::make_shared<ob::ProblemDefinition>(si);
+    pdef->setStartAndGoalStates(last, waypoint.get());
+    og::RRTConnect planner(si);
+    planner.setProblemDefinition(pdef);
+    planner.setup();
+    if (planner.solve(ptc) != ob::PlannerStatus::EXACT_SOLUTION)
+      return false;
+    const og::PathGeometric& segment = static_cast<const og::PathGeometric&>(*pdef->getSolutionPath());
+    for (std::size_t j = 1; j < segment.getStateCount(); ++j)
+      path.append(segment.getState(j));
+  }
+  return !ptc() && path.getStateCount() > 1;
+}
+
+void ompl_interface::ModelBasedPlanningContext::recordExperience()
+{
+  if (!spec_.experience_library_ || !ompl_simple_setup_->haveExactSolutionPath())
+    return;
+
+  const og::PathGeometric& path = ompl_simple_setup_->getSolutionPath();
+  const std::size_t variable_count = getJointModelGroup()->getVariableCount();
+  std::vector<std::vector<double>> waypoints;
+  waypoints.reserve(path.getStateCount());
+  for (const ob::State* state : path.getStates())
+  {
+    const double* values = state->as<ModelBasedStateSpace::StateType>()->values;
+    waypoints.emplace_back(values, values + variable_count);
+  }
+  spec_.experience_library_->add(std::move(waypoints), computeSceneHash(*getPlanningScene()));
+}
+
 void ompl_interface::ModelBasedPlanningContext::registerTerminationCondition(const ob::PlannerTerminationCondition& ptc)
 {
   std::unique_lock<std::mutex> slock(ptc_lock_);
@@ -896,7 +1397,13 @@ bool ompl_interface::ModelBasedPlanningContext::loadConstraintApproximations(con
   std::string constraint_path;
   if (nh.getParam("constraint_approximations_path", constraint_path))
   {
+    // loading is expensive, the approximations stay valid for later requests
+    if (constraints_library_ && constraint_path == loaded_constraint_approximations_path_)
+      return true;
+    if (!constraints_library_)
+      constraints_library_ = std::make_shared<ConstraintsLibrary>(this);
     constraints_library_->loadConstraintApproximations(constraint_path);
+    loaded_constraint_approximations_path_ = constraint_path;
     std::stringstream ss;
     constraints_library_->printConstraintApproximations(ss);
     ROS_INFO_STREAM(ss.str());
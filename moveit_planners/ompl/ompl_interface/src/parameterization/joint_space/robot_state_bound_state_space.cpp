@@ -0,0 +1,84 @@
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2026, PickNik LLC.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of PickNik LLC nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *********************************************************************/
+
+#include <moveit/ompl_interface/parameterization/joint_space/robot_state_bound_state_space.h>
+
+const std::string ompl_interface::RobotStateBoundStateSpace::PARAMETERIZATION_TYPE = "RobotStateBound";
+
+ompl_interface::RobotStateBoundStateSpace::RobotStateBoundStateSpace(const ModelBasedStateSpaceSpecification& spec)
+  : ModelBasedStateSpace(spec), reference_state_(spec.robot_model_), reference_generation_(0)
+{
+  if (!spec_.joint_model_group_->isContiguousWithinState())
+    throw std::runtime_error("Group '" + spec_.joint_model_group_->getName() +
+                             "' is not contiguous within the robot state and cannot be bound to it");
+  reference_state_.setToDefaultValues();
+  first_variable_index_ = spec_.joint_model_group_->getVariableIndexList().front();
+  setName(getName() + "_" + PARAMETERIZATION_TYPE);
+}
+
+ompl::base::State* ompl_interface::RobotStateBoundStateSpace::allocState() const
+{
+  return new BoundStateType(reference_state_, first_variable_index_, reference_generation_);
+}
+
+void ompl_interface::RobotStateBoundStateSpace::freeState(ompl::base::State* state) const
+{
+  // the values are owned by the robot state
+  delete state->as<BoundStateType>();
+}
+
+moveit::core::RobotState*
+ompl_interface::RobotStateBoundStateSpace::getBoundRobotState(const ompl::base::State* state) const
+{
+  auto* bound_state = const_cast<BoundStateType*>(state->as<BoundStateType>());
+  if (bound_state->reference_generation != reference_generation_)
+  {
+    // the other joints still hold the values of an earlier reference state
+    std::vector<double> values(bound_state->values, bound_state->values + variable_count_);
+    bound_state->robot_state = reference_state_;
+    memcpy(bound_state->values, values.data(), state_values_size_);
+    bound_state->reference_generation = reference_generation_;
+  }
+
+  // OMPL wrote the values in place, so the state does not know which transforms are outdated
+  bound_state->robot_state.markJointGroupPositionsChanged(spec_.joint_model_group_);
+  bound_state->robot_state.update();
+  return &bound_state->robot_state;
+}
+
+void ompl_interface::RobotStateBoundStateSpace::setReferenceState(const moveit::core::RobotState& reference_state)
+{
+  reference_state_ = reference_state;
+  ++reference_generation_;
+}
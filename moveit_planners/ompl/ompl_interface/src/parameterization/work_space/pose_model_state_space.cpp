@@ -38,6 +38,9 @@
 #include <ompl/base/spaces/SE3StateSpace.h>
 #include <moveit/profiler/profiler.h>
 
+#include <algorithm>
+#include <cmath>
+#include <limits>
 #include <utility>
 
 namespace ompl_interface
@@ -130,6 +133,13 @@ void ompl_interface::PoseModelStateSpace::interpolate(const ompl::base::State* f
 {
   //  moveit::Profiler::ScopedBlock sblock("interpolate");
 
+  // the end points already carry their joint solutions, no need to run IK again
+  if (t <= 0.0 || t >= 1.0)
+  {
+    copyState(state, t <= 0.0 ? from : to);
+    return;
+  }
+
   // we want to interpolate in Cartesian space; we do not have a guarantee that from and to
   // have their poses computed, but this is very unlikely to happen (depends how the planner gets its input states)
 
@@ -153,8 +163,8 @@ void ompl_interface::PoseModelStateSpace::interpolate(const ompl::base::State* f
   */
 
   // after interpolation we cannot be sure about the joint values (we use them as seed only)
-  // so we recompute IK if needed
-  if (computeStateIK(state))
+  // so we recompute IK if needed, falling back to the closer end point as seed
+  if (computeStateIK(state, t < 0.5 ? from : to))
   {
     double dj = jump_factor_ * ModelBasedStateSpace::distance(from, to);
     double d_from = ModelBasedStateSpace::distance(from, state);
@@ -190,6 +200,10 @@ ompl_interface::PoseModelStateSpace::PoseComponent::PoseComponent(
   fk_link_.resize(1, kinematics_solver_->getTipFrame());
   if (!fk_link_[0].empty() && fk_link_[0][0] == '/')
     fk_link_[0] = fk_link_[0].substr(1);
+  const std::vector<kinematics::DiscretizationMethod> methods = kinematics_solver_->getSupportedDiscretizationMethods();
+  analytic_ = std::any_of(methods.begin(), methods.end(), [](kinematics::DiscretizationMethod method) {
+    return method != kinematics::DiscretizationMethods::NO_DISCRETIZATION;
+  });
 }
 
 bool ompl_interface::PoseModelStateSpace::PoseComponent::computeStateFK(StateType* full_state, unsigned int idx) const
@@ -216,20 +230,14 @@ bool ompl_interface::PoseModelStateSpace::PoseComponent::computeStateFK(StateTyp
   return true;
 }
 
-bool ompl_interface::PoseModelStateSpace::PoseComponent::computeStateIK(StateType* full_state, unsigned int idx) const
+bool ompl_interface::PoseModelStateSpace::PoseComponent::computeStateIK(StateType* full_state, unsigned int idx,
+                                                                         const StateType* near) const
 {
   // read the values from the joint state, in the order expected by the kinematics solver; use these as the seed
   std::vector<double> seed_values(bijection_.size());
   for (std::size_t i = 0; i < bijection_.size(); ++i)
     seed_values[i] = full_state->values[bijection_[i]];
 
-  /*
-  std::cout << "seed: ";
-  for (std::size_t i = 0 ; i < seed_values.size() ; ++i)
-    std::cout << seed_values[i] << " ";
-  std::cout << std::endl;
-  */
-
   // construct the pose
   geometry_msgs::Pose pose;
   const ompl::base::SE3StateSpace::StateType* se3_state = full_state->poses[idx];
@@ -242,12 +250,20 @@ bool ompl_interface::PoseModelStateSpace::PoseComponent::computeStateIK(StateTyp
   pose.orientation.z = so3_state.z;
   pose.orientation.w = so3_state.w;
 
-  // run IK
+  // run IK; if the seed does not converge, warm-start from the neighbouring state before searching
   std::vector<double> solution(bijection_.size());
   moveit_msgs::MoveItErrorCodes err_code;
-  if (!kinematics_solver_->getPositionIK(pose, seed_values, solution, err_code))
+  bool found = solveIK(pose, seed_values, solution, err_code);
+  if (!found && near)
   {
-    if (err_code.val != moveit_msgs::MoveItErrorCodes::TIMED_OUT ||
+    std::vector<double> near_values(bijection_.size());
+    for (std::size_t i = 0; i < bijection_.size(); ++i)
+      near_values[i] = near->values[bijection_[i]];
+    found = solveIK(pose, near_values, solution, err_code);
+  }
+  if (!found)
+  {
+    if (analytic_ || err_code.val != moveit_msgs::MoveItErrorCodes::TIMED_OUT ||
         !kinematics_solver_->searchPositionIK(pose, seed_values, kinematics_solver_->getDefaultTimeout() * 2.0,
                                               solution, err_code))
       return false;
@@ -259,6 +275,41 @@ bool ompl_interface::PoseModelStateSpace::PoseComponent::computeStateIK(StateTyp
   return true;
 }
 
+bool ompl_interface::PoseModelStateSpace::PoseComponent::solveIK(const geometry_msgs::Pose& pose,
+                                                                 const std::vector<double>& seed,
+                                                                 std::vector<double>& solution,
+                                                                 moveit_msgs::MoveItErrorCodes& err_code) const
+{
+  if (!analytic_)
+    return kinematics_solver_->getPositionIK(pose, seed, solution, err_code);
+
+  // analytic solvers return every solution at once; keep the one closest to the seed so the path stays continuous
+  std::vector<std::vector<double>> solutions;
+  kinematics::KinematicsResult result;
+  if (!kinematics_solver_->getPositionIK(std::vector<geometry_msgs::Pose>(1, pose), seed, solutions, result,
+                                         kinematics::KinematicsQueryOptions()) ||
+      solutions.empty())
+  {
+    err_code.val = moveit_msgs::MoveItErrorCodes::NO_IK_SOLUTION;
+    return false;
+  }
+
+  double best_distance = std::numeric_limits<double>::infinity();
+  for (const std::vector<double>& candidate : solutions)
+  {
+    double d = 0.0;
+    for (std::size_t i = 0; i < seed.size(); ++i)
+      d += fabs(candidate[i] - seed[i]);
+    if (d < best_distance)
+    {
+      best_distance = d;
+      solution = candidate;
+    }
+  }
+  err_code.val = moveit_msgs::MoveItErrorCodes::SUCCESS;
+  return true;
+}
+
 bool ompl_interface::PoseModelStateSpace::computeStateFK(ompl::base::State* state) const
 {
   if (state->as<StateType>()->poseComputed())
@@ -274,11 +325,17 @@ bool ompl_interface::PoseModelStateSpace::computeStateFK(ompl::base::State* stat
 }
 
 bool ompl_interface::PoseModelStateSpace::computeStateIK(ompl::base::State* state) const
+{
+  return computeStateIK(state, nullptr);
+}
+
+bool ompl_interface::PoseModelStateSpace::computeStateIK(ompl::base::State* state, const ompl::base::State* near) const
 {
   if (state->as<StateType>()->jointsComputed())
     return true;
+  const StateType* near_state = near ? near->as<StateType>() : nullptr;
   for (std::size_t i = 0; i < poses_.size(); ++i)
-    if (!poses_[i].computeStateIK(state->as<StateType>(), i))
+    if (!poses_[i].computeStateIK(state->as<StateType>(), i, near_state))
     {
       state->as<StateType>()->markInvalid();
       return false;
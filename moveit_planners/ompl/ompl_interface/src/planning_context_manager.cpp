@@ -69,6 +69,8 @@
 
 #include <moveit/ompl_interface/parameterization/joint_space/joint_model_state_space_factory.h>
 #include <moveit/ompl_interface/parameterization/joint_space/joint_model_state_space.h>
+#include <moveit/ompl_interface/parameterization/joint_space/robot_state_bound_state_space_factory.h>
+#include <moveit/ompl_interface/parameterization/joint_space/robot_state_bound_state_space.h>
 #include <moveit/ompl_interface/parameterization/work_space/pose_model_state_space_factory.h>
 
 using namespace std::placeholders;
@@ -77,9 +79,16 @@ namespace ompl_interface
 {
 constexpr char LOGNAME[] = "planning_context_manager";
 
+// the scene of a stored scene-aware roadmap is written next to its planner data
+constexpr char ROADMAP_SCENE_FILE_SUFFIX[] = ".scene";
+
+// default capacity of the experience library of a planner configuration
+constexpr std::size_t DEFAULT_MAX_EXPERIENCES = 256;
+
 struct PlanningContextManager::CachedContexts
 {
   std::map<std::pair<std::string, std::string>, std::vector<ModelBasedPlanningContextPtr> > contexts_;
+  std::map<std::string, ExperienceLibraryPtr> experience_libraries_;
   std::mutex lock_;
 };
 
@@ -94,9 +103,68 @@ ompl_interface::MultiQueryPlannerAllocator::~MultiQueryPlannerAllocator()
     ob::PlannerData data(planners_[entry.first]->getSpaceInformation());
     planners_[entry.first]->getPlannerData(data);
     storage_.store(data, entry.second.c_str());
+
+    auto scene_it = roadmap_scenes_.find(entry.first);
+    if (scene_it != roadmap_scenes_.end() && !scene_it->second.snapshot.store(entry.second + ROADMAP_SCENE_FILE_SUFFIX))
+      ROS_ERROR_NAMED(LOGNAME, "Failed to store the roadmap scene of '%s'", entry.first.c_str());
   }
 }
 
+void ompl_interface::MultiQueryPlannerAllocator::updatePlanningScene(const std::string& planner_name,
+                                                                     const planning_scene::PlanningScene& scene,
+                                                                     const moveit::core::RobotState& start_state)
+{
+  RoadmapScene next{ RoadmapSceneSnapshot(scene, start_state),
+                     std::make_shared<moveit::core::RobotState>(start_state) };
+
+  // planners that are not allocated yet are validated against this scene (or pruned to it, when loaded from disk)
+  auto planner_it = planners_.find(planner_name);
+  auto scene_it = roadmap_scenes_.find(planner_name);
+  if (planner_it != planners_.end() && scene_it != roadmap_scenes_.end())
+    planner_it->second = updateRoadmap(planner_name, planner_it->second, scene_it->second.snapshot, next);
+  roadmap_scenes_[planner_name] = std::move(next);
+}
+
+ompl::base::PlannerPtr ompl_interface::MultiQueryPlannerAllocator::updateRoadmap(const std::string& planner_name,
+                                                                                 const ob::PlannerPtr& planner,
+                                                                                 const RoadmapSceneSnapshot& previous,
+                                                                                 const RoadmapScene& next)
+{
+  // attached bodies change the geometry of the robot itself, which invalidates any edge
+  if (!previous.hasSameAttachedBodies(next.snapshot))
+  {
+    ROS_INFO_NAMED(LOGNAME, "Attached bodies changed, clearing the roadmap of '%s'", planner_name.c_str());
+    planner->clear();
+    return planner;
+  }
+
+  const std::vector<Eigen::AlignedBox3d> volumes = previous.getChangedVolumes(next.snapshot);
+  if (volumes.empty())
+    return planner;
+
+  ob::PlannerData data(planner->getSpaceInformation());
+  planner->getPlannerData(data);
+  const std::size_t removed = pruneRoadmap(data, volumes, *next.robot_state);
+  ROS_DEBUG_NAMED(LOGNAME, "%zu objects changed, %zu edges of the roadmap of '%s' are invalidated", volumes.size(),
+                  removed, planner_name.c_str());
+  if (removed == 0)
+    return planner;
+
+  // the planner is rebuilt from the pruned data, so its connected components are recomputed
+  auto allocator_it = persistent_planner_allocators_.find(planner_name);
+  ob::PlannerPtr pruned_planner;
+  if (allocator_it != persistent_planner_allocators_.end())
+    pruned_planner = allocator_it->second(data);
+  if (!pruned_planner)
+  {
+    ROS_WARN_NAMED(LOGNAME, "Planner '%s' cannot be rebuilt from a pruned roadmap, clearing the roadmap",
+                   planner_name.c_str());
+    planner->clear();
+    return planner;
+  }
+  return pruned_planner;
+}
+
 template <typename T>
 ompl::base::PlannerPtr ompl_interface::MultiQueryPlannerAllocator::allocatePlanner(
     const ob::SpaceInformationPtr& si, const std::string& new_name, const ModelBasedPlanningContextSpecification& spec)
@@ -160,24 +228,60 @@ ompl::base::PlannerPtr ompl_interface::MultiQueryPlannerAllocator::allocatePlann
     const ob::SpaceInformationPtr& si, const std::string& new_name, const ModelBasedPlanningContextSpecification& spec,
     bool load_planner_data, bool store_planner_data, const std::string& file_path)
 {
+  auto persistent_planner_allocator = [this, new_name, config = spec.config_](const ob::PlannerData& data) {
+    ob::PlannerPtr planner{ allocatePersistentPlanner<T>(data) };
+    if (planner)
+    {
+      if (!new_name.empty())
+        planner->setName(new_name);
+      planner->params().setParams(config, true);
+    }
+    return planner;
+  };
+
   ob::PlannerPtr planner;
+  auto scene_it = roadmap_scenes_.find(new_name);
   // Try to initialize planner with loaded planner data
   if (load_planner_data)
   {
     ROS_INFO("Loading planner data");
     ob::PlannerData data(si);
     storage_.load(file_path.c_str(), data);
-    planner = std::shared_ptr<ob::Planner>{ allocatePersistentPlanner<T>(data) };
-    if (!planner)
-      ROS_ERROR_NAMED(LOGNAME,
-                      "Creating a '%s' planner from persistent data is not supported. Going to create a new instance.",
-                      new_name.c_str());
+
+    // A scene-aware roadmap is pruned to the current scene. Without the scene it was stored with,
+    // every object of the current scene is treated as new.
+    bool use_data = true;
+    if (scene_it != roadmap_scenes_.end())
+    {
+      RoadmapSceneSnapshot stored_snapshot;
+      if (!stored_snapshot.load(file_path + ROADMAP_SCENE_FILE_SUFFIX))
+        ROS_WARN_NAMED(LOGNAME, "No roadmap scene stored for '%s', validating the roadmap against all objects",
+                       new_name.c_str());
+      use_data = stored_snapshot.hasSameAttachedBodies(scene_it->second.snapshot);
+      if (use_data)
+        pruneRoadmap(data, stored_snapshot.getChangedVolumes(scene_it->second.snapshot),
+                     *scene_it->second.robot_state);
+      else
+        ROS_INFO_NAMED(LOGNAME, "Attached bodies changed, dropping the stored roadmap of '%s'", new_name.c_str());
+    }
+    if (use_data)
+    {
+      planner = persistent_planner_allocator(data);
+      if (!planner)
+        ROS_ERROR_NAMED(
+            LOGNAME, "Creating a '%s' planner from persistent data is not supported. Going to create a new instance.",
+            new_name.c_str());
+    }
   }
   if (!planner)
+  {
     planner = std::make_shared<T>(si);
-  if (!new_name.empty())
-    planner->setName(new_name);
-  planner->params().setParams(spec.config_, true);
+    if (!new_name.empty())
+      planner->setName(new_name);
+    planner->params().setParams(spec.config_, true);
+  }
+  if (scene_it != roadmap_scenes_.end())
+    persistent_planner_allocators_[new_name] = persistent_planner_allocator;
   //  Remember which planner instances to store when the destructor is called
   if (store_planner_data)
     planner_data_storage_paths_[new_name] = file_path;
@@ -295,6 +399,7 @@ void ompl_interface::PlanningContextManager::registerDefaultPlanners()
 void ompl_interface::PlanningContextManager::registerDefaultStateSpaces()
 {
   registerStateSpaceFactory(ModelBasedStateSpaceFactoryPtr(new JointModelStateSpaceFactory()));
+  registerStateSpaceFactory(ModelBasedStateSpaceFactoryPtr(new RobotStateBoundStateSpaceFactory()));
   registerStateSpaceFactory(ModelBasedStateSpaceFactoryPtr(new PoseModelStateSpaceFactory()));
 }
 
@@ -343,6 +448,24 @@ ompl_interface::ModelBasedPlanningContextPtr ompl_interface::PlanningContextMana
     // Choose the correct simple setup type to load
     context_spec.ompl_simple_setup_ = std::make_shared<ompl::geometric::SimpleSetup>(context_spec.state_space_);
 
+    // All contexts of a planner configuration share its experience library
+    auto use_experience = config.config.find("use_experience");
+    if (use_experience != config.config.end() && boost::lexical_cast<bool>(use_experience->second))
+    {
+      std::unique_lock<std::mutex> slock(cached_contexts_->lock_);
+      ExperienceLibraryPtr& library = cached_contexts_->experience_libraries_[config.name];
+      if (!library)
+      {
+        auto path = config.config.find("experience_path");
+        auto max_experiences = config.config.find("max_experiences");
+        library = std::make_shared<ExperienceLibrary>(
+            max_experiences != config.config.end() ? boost::lexical_cast<std::size_t>(max_experiences->second) :
+                                                     DEFAULT_MAX_EXPERIENCES,
+            path != config.config.end() ? path->second : std::string());
+      }
+      context_spec.experience_library_ = library;
+    }
+
     ROS_DEBUG_NAMED(LOGNAME, "Creating new planning context");
     context = std::make_shared<ModelBasedPlanningContext>(config.name, context_spec);
     {
@@ -460,8 +583,12 @@ ompl_interface::ModelBasedPlanningContextPtr ompl_interface::PlanningContextMana
   // in JointModelStateSpace.
   ModelBasedStateSpaceFactoryPtr factory;
   auto it = pc->second.config.find("enforce_joint_model_state_space");
+  // 'bind_robot_state' selects the joint space parameterization that validates states in place
+  auto bind = pc->second.config.find("bind_robot_state");
 
-  if (it != pc->second.config.end() && boost::lexical_cast<bool>(it->second))
+  if (bind != pc->second.config.end() && boost::lexical_cast<bool>(bind->second))
+    factory = getStateSpaceFactory(RobotStateBoundStateSpace::PARAMETERIZATION_TYPE);
+  else if (it != pc->second.config.end() && boost::lexical_cast<bool>(it->second))
     factory = getStateSpaceFactory(JointModelStateSpace::PARAMETERIZATION_TYPE);
   else
     factory = getStateSpaceFactory(pc->second.group, req);
@@ -479,6 +606,12 @@ ompl_interface::ModelBasedPlanningContextPtr ompl_interface::PlanningContextMana
     context->setMotionPlanRequest(req);
     context->setCompleteInitialState(*start_state);
 
+    // scene-aware roadmaps are pruned before configure() fetches the planner
+    auto scene_aware_roadmap = pc->second.config.find("scene_aware_roadmap");
+    if (scene_aware_roadmap != pc->second.config.end() && boost::lexical_cast<bool>(scene_aware_roadmap->second))
+      planner_allocator_.updatePlanningScene(context->getGroupName() + "/" + context->getName(), *planning_scene,
+                                             *start_state);
+
     context->setPlanningVolume(req.workspace_parameters);
     if (!context->setPathConstraints(req.path_constraints, &error_code))
       return ModelBasedPlanningContextPtr();
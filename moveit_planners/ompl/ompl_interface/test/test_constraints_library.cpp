@@ -0,0 +1,139 @@
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2026, PickNik LLC.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of PickNik LLC nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *********************************************************************/
+
+#include <moveit/ompl_interface/detail/constraints_library.h>
+#include <moveit/ompl_interface/parameterization/joint_space/joint_model_state_space.h>
+#include <moveit/utils/robot_model_test_utils.h>
+#include <gtest/gtest.h>
+#include <boost/filesystem.hpp>
+
+class ConstraintApproximationFileTest : public testing::Test
+{
+protected:
+  void SetUp() override
+  {
+    robot_model_ = moveit::core::loadTestingRobotModel("panda");
+    ompl_interface::ModelBasedStateSpaceSpecification spec(robot_model_, "panda_arm");
+    space_ = std::make_shared<ompl_interface::JointModelStateSpace>(spec);
+    space_->setup();
+    filename_ = (boost::filesystem::temp_directory_path() / boost::filesystem::unique_path()).string();
+  }
+
+  void TearDown() override
+  {
+    boost::filesystem::remove(filename_);
+  }
+
+  /* Fill \e storage with milestones 0 - 2, edges 0-1 (with explicit motion states 3 - 4) and 1-2 */
+  void fillStorage(ompl_interface::ConstraintApproximationStateStorage& storage)
+  {
+    ompl::base::ScopedState<> state(space_);
+    for (int i = 0; i < 5; ++i)
+    {
+      state.random();
+      state->as<ompl_interface::ModelBasedStateSpace::StateType>()->tag = i < 3 ? i : -1;
+      storage.addState(state.get());
+    }
+    storage.getMetadata(0).first = { 1 };
+    storage.getMetadata(1).first = { 0, 2 };
+    storage.getMetadata(2).first = { 1 };
+    storage.getMetadata(0).second[1] = std::make_pair(3, 5);
+    storage.getMetadata(1).second[0] = std::make_pair(3, 5);
+  }
+
+  moveit::core::RobotModelPtr robot_model_;
+  ompl_interface::ModelBasedStateSpacePtr space_;
+  std::string filename_;
+};
+
+TEST_F(ConstraintApproximationFileTest, StoreAndLoad)
+{
+  ompl_interface::ConstraintApproximationStateStorage storage(space_);
+  fillStorage(storage);
+  ompl_interface::NearestMilestoneIndex index(2, { 1, 2, 0, 2, 1, ompl_interface::NearestMilestoneIndex::INVALID });
+  ASSERT_TRUE(ompl_interface::storeConstraintApproximationFile(filename_, storage, 3, index));
+  EXPECT_TRUE(ompl_interface::isConstraintApproximationFile(filename_));
+
+  ompl_interface::ConstraintApproximationStateStorage loaded(space_);
+  std::size_t milestones = 0;
+  ompl_interface::NearestMilestoneIndex loaded_index;
+  ASSERT_TRUE(ompl_interface::loadConstraintApproximationFile(filename_, loaded, milestones, loaded_index));
+
+  EXPECT_EQ(milestones, 3u);
+  ASSERT_EQ(loaded.size(), storage.size());
+  for (std::size_t i = 0; i < storage.size(); ++i)
+  {
+    EXPECT_TRUE(space_->equalStates(loaded.getState(i), storage.getState(i)));
+    EXPECT_EQ(loaded.getState(i)->as<ompl_interface::ModelBasedStateSpace::StateType>()->tag,
+              storage.getState(i)->as<ompl_interface::ModelBasedStateSpace::StateType>()->tag);
+    EXPECT_EQ(loaded.getMetadata(i).first, storage.getMetadata(i).first);
+    EXPECT_EQ(loaded.getMetadata(i).second, storage.getMetadata(i).second);
+  }
+
+  ASSERT_EQ(loaded_index.getNeighborCount(), 2u);
+  ASSERT_EQ(loaded_index.getMilestoneCount(), 3u);
+  for (std::size_t i = 0; i < 3; ++i)
+    for (std::size_t j = 0; j < 2; ++j)
+      EXPECT_EQ(loaded_index.getNeighbors(i)[j], index.getNeighbors(i)[j]);
+}
+
+TEST_F(ConstraintApproximationFileTest, LegacyFileIsNotRecognized)
+{
+  ompl_interface::ConstraintApproximationStateStorage storage(space_);
+  fillStorage(storage);
+  storage.store(filename_.c_str());
+  EXPECT_FALSE(ompl_interface::isConstraintApproximationFile(filename_));
+}
+
+TEST_F(ConstraintApproximationFileTest, RejectsMismatchingStateSpace)
+{
+  ompl_interface::ConstraintApproximationStateStorage storage(space_);
+  fillStorage(storage);
+  ASSERT_TRUE(ompl_interface::storeConstraintApproximationFile(filename_, storage, 3,
+                                                               ompl_interface::NearestMilestoneIndex()));
+
+  ompl_interface::ModelBasedStateSpaceSpecification spec(robot_model_, "hand");
+  ompl_interface::ModelBasedStateSpacePtr other_space = std::make_shared<ompl_interface::JointModelStateSpace>(spec);
+  other_space->setup();
+  ompl_interface::ConstraintApproximationStateStorage loaded(other_space);
+  std::size_t milestones = 0;
+  ompl_interface::NearestMilestoneIndex loaded_index;
+  EXPECT_FALSE(ompl_interface::loadConstraintApproximationFile(filename_, loaded, milestones, loaded_index));
+}
+
+int main(int argc, char** argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,119 @@
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2026, PickNik LLC.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of PickNik LLC nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *********************************************************************/
+
+#include <moveit/ompl_interface/detail/experience_library.h>
+#include <moveit/utils/robot_model_test_utils.h>
+#include <geometric_shapes/shapes.h>
+
+#include <gtest/gtest.h>
+
+#include <cstdio>
+
+namespace
+{
+std::vector<std::vector<double>> makePath(double start, double goal)
+{
+  return { { start, 0.0 }, { 0.5 * (start + goal), 1.0 }, { goal, 0.0 } };
+}
+}  // namespace
+
+TEST(ExperienceLibrary, AddReplacesDuplicates)
+{
+  ompl_interface::ExperienceLibrary library(10);
+  library.add(makePath(0.0, 1.0), 1);
+  library.add(makePath(0.0, 2.0), 1);
+  EXPECT_EQ(library.size(), 2u);
+
+  // same start and goal in the same scene replaces the stored path
+  library.add(makePath(0.0, 1.0), 1);
+  EXPECT_EQ(library.size(), 2u);
+  EXPECT_EQ(library.getExperiences().back()->waypoints.back()[0], 1.0);
+
+  // ... but not in a different scene
+  library.add(makePath(0.0, 1.0), 2);
+  EXPECT_EQ(library.size(), 3u);
+
+  // paths without intermediate motion are ignored
+  library.add({ { 0.0, 0.0 } }, 1);
+  EXPECT_EQ(library.size(), 3u);
+}
+
+TEST(ExperienceLibrary, DropsOldest)
+{
+  ompl_interface::ExperienceLibrary library(2);
+  library.add(makePath(0.0, 1.0), 1);
+  library.add(makePath(0.0, 2.0), 1);
+  library.add(makePath(0.0, 3.0), 1);
+  const std::vector<ompl_interface::ExperienceLibrary::ExperienceConstPtr> experiences = library.getExperiences();
+  ASSERT_EQ(experiences.size(), 2u);
+  EXPECT_EQ(experiences[0]->waypoints.back()[0], 2.0);
+  EXPECT_EQ(experiences[1]->waypoints.back()[0], 3.0);
+}
+
+TEST(ExperienceLibrary, StoreAndLoad)
+{
+  const std::string path = "test_experience_library.txt";
+  {
+    ompl_interface::ExperienceLibrary library(10, path);
+    library.add(makePath(0.1, 1.0 / 3.0), 42);
+  }  // stored on destruction
+
+  ompl_interface::ExperienceLibrary loaded(10, path);
+  std::remove(path.c_str());
+  const std::vector<ompl_interface::ExperienceLibrary::ExperienceConstPtr> experiences = loaded.getExperiences();
+  ASSERT_EQ(experiences.size(), 1u);
+  EXPECT_EQ(experiences[0]->scene_hash, 42u);
+  EXPECT_EQ(experiences[0]->waypoints, makePath(0.1, 1.0 / 3.0));
+}
+
+TEST(ExperienceLibrary, SceneHash)
+{
+  planning_scene::PlanningScene scene(moveit::core::loadTestingRobotModel("panda"));
+  const std::size_t empty_hash = ompl_interface::computeSceneHash(scene);
+
+  scene.getWorldNonConst()->addToObject("box", std::make_shared<shapes::Box>(0.1, 0.1, 0.1),
+                                        Eigen::Isometry3d::Identity());
+  const std::size_t box_hash = ompl_interface::computeSceneHash(scene);
+  EXPECT_NE(empty_hash, box_hash);
+  EXPECT_EQ(box_hash, ompl_interface::computeSceneHash(*scene.diff()));
+
+  scene.getWorldNonConst()->moveObject("box", Eigen::Isometry3d(Eigen::Translation3d(0.0, 0.0, 1.0)));
+  EXPECT_NE(box_hash, ompl_interface::computeSceneHash(scene));
+}
+
+int main(int argc, char** argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -52,6 +52,8 @@
 
 #include "load_test_robot.h"
 
+#include <algorithm>
+
 #include <gtest/gtest.h>
 
 #include <tf2_eigen/tf2_eigen.h>
@@ -63,6 +65,7 @@
 #include <moveit/kinematic_constraints/utils.h>
 #include <moveit/constraint_samplers/constraint_sampler_manager.h>
 #include <moveit/ompl_interface/parameterization/joint_space/joint_model_state_space.h>
+#include <moveit/ompl_interface/detail/projection_evaluators.h>
 
 /** \brief Generic implementation of the tests that can be executed on different robots. **/
 class TestPlanningContext : public ompl_interface_testing::LoadTestRobot, public testing::Test
@@ -110,6 +113,122 @@ public:
     ASSERT_TRUE(pc->solve(res));
   }
 
+  void testContextReuse(const std::vector<double>& start, const std::vector<double>& goal)
+  {
+    planning_interface::PlannerConfigurationSettings pconfig_settings;
+    pconfig_settings.group = group_name_;
+    pconfig_settings.name = group_name_;
+    pconfig_settings.config = { { "enforce_joint_model_state_space", "0" } };
+
+    planning_interface::PlannerConfigurationMap pconfig_map{ { pconfig_settings.name, pconfig_settings } };
+    moveit_msgs::MoveItErrorCodes error_code;
+    planning_interface::MotionPlanRequest request = createRequest(start, goal);
+
+    ompl_interface::PlanningContextManager pcm(robot_model_, constraint_sampler_manager_);
+    pcm.setPlannerConfigurations(pconfig_map);
+
+    auto pc = pcm.getPlanningContext(planning_scene_, request, error_code, node_handle_, false);
+    ASSERT_NE(pc, nullptr);
+    EXPECT_FALSE(pc->isLastSetupPartial());
+    EXPECT_GT(pc->getLastSetupTime(), 0.0);
+    planning_interface::MotionPlanDetailedResponse res;
+    ASSERT_TRUE(pc->solve(res));
+    const ompl_interface::ModelBasedPlanningContext* first_context = pc.get();
+    const ompl::base::Planner* first_planner = pc->getOMPLSimpleSetup()->getPlanner().get();
+
+    // a new goal in the same configuration reuses the cached context and keeps its planner
+    pc.reset();
+    request = createRequest(goal, start);
+    pc = pcm.getPlanningContext(planning_scene_, request, error_code, node_handle_, false);
+    ASSERT_NE(pc, nullptr);
+    EXPECT_EQ(pc.get(), first_context);
+    EXPECT_TRUE(pc->isLastSetupPartial());
+    EXPECT_EQ(pc->getOMPLSimpleSetup()->getPlanner().get(), first_planner);
+    ASSERT_TRUE(pc->solve(res));
+
+    // changing the configuration sets the context up again
+    pc.reset();
+    pconfig_settings.config["longest_valid_segment_fraction"] = "0.01";
+    pcm.setPlannerConfigurations({ { pconfig_settings.name, pconfig_settings } });
+    pc = pcm.getPlanningContext(planning_scene_, request, error_code, node_handle_, false);
+    ASSERT_NE(pc, nullptr);
+    EXPECT_FALSE(pc->isLastSetupPartial());
+    ASSERT_TRUE(pc->solve(res));
+  }
+
+  void testPipelinedSimplification(const std::vector<double>& start, const std::vector<double>& goal)
+  {
+    planning_interface::PlannerConfigurationSettings pconfig_settings;
+    pconfig_settings.group = group_name_;
+    pconfig_settings.name = group_name_;
+    pconfig_settings.config = { { "enforce_joint_model_state_space", "0" },
+                                { "pipelined_simplification", "1" },
+                                { "simplification_threads", "2" } };
+
+    planning_interface::PlannerConfigurationMap pconfig_map{ { pconfig_settings.name, pconfig_settings } };
+    moveit_msgs::MoveItErrorCodes error_code;
+    planning_interface::MotionPlanRequest request = createRequest(start, goal);
+    request.allowed_planning_time = 1.0;
+
+    ompl_interface::PlanningContextManager pcm(robot_model_, constraint_sampler_manager_);
+    pcm.setPlannerConfigurations(pconfig_map);
+
+    auto pc = pcm.getPlanningContext(planning_scene_, request, error_code, node_handle_, false);
+    ASSERT_NE(pc, nullptr);
+    EXPECT_TRUE(pc->getPipelinedSimplification());
+    EXPECT_EQ(pc->getSimplificationThreads(), 2u);
+
+    // planning continues until the time limit, and no separate simplification step is reported
+    planning_interface::MotionPlanDetailedResponse res;
+    ASSERT_TRUE(pc->solve(res));
+    EXPECT_GE(pc->getLastPlanTime(), 0.9);
+    EXPECT_EQ(std::count(res.description_.begin(), res.description_.end(), "simplify"), 0);
+    ASSERT_FALSE(res.trajectory_.empty());
+    EXPECT_GE(res.trajectory_.front()->getWayPointCount(), 2u);
+  }
+
+  void testProjectionEvaluators(const std::vector<double>& start, const std::vector<double>& goal)
+  {
+    planning_interface::PlannerConfigurationSettings pconfig_settings;
+    pconfig_settings.group = group_name_;
+    pconfig_settings.name = group_name_;
+    pconfig_settings.config = { { "enforce_joint_model_state_space", "0" },
+                                { "type", "geometric::KPIECE" },
+                                { "projection_evaluator", "pca(2)" } };
+
+    planning_interface::PlannerConfigurationMap pconfig_map{ { pconfig_settings.name, pconfig_settings } };
+    moveit_msgs::MoveItErrorCodes error_code;
+    planning_interface::MotionPlanRequest request = createRequest(start, goal);
+
+    ompl_interface::PlanningContextManager pcm(robot_model_, constraint_sampler_manager_);
+    pcm.setPlannerConfigurations(pconfig_map);
+
+    // the learned projection is used by KPIECE
+    auto pc = pcm.getPlanningContext(planning_scene_, request, error_code, node_handle_, false);
+    ASSERT_NE(pc, nullptr);
+    auto pca = std::dynamic_pointer_cast<ompl_interface::ProjectionEvaluatorPCA>(
+        pc->getOMPLStateSpace()->getDefaultProjection());
+    ASSERT_NE(pca, nullptr);
+    EXPECT_TRUE(pca->isLearned());
+    EXPECT_EQ(pca->getDimension(), 2u);
+    planning_interface::MotionPlanDetailedResponse res;
+    ASSERT_TRUE(pc->solve(res));
+
+    // the link projection gives the same position whether or not the state was just validity checked
+    ompl_interface::ProjectionEvaluatorLinkPose link_pose(pc.get(), ee_link_name_);
+    robot_state_->setJointGroupPositions(joint_model_group_, goal);
+    robot_state_->update();
+    ompl::base::ScopedState<> state(pc->getOMPLStateSpace());
+    pc->getOMPLStateSpace()->copyToOMPLState(state.get(), *robot_state_);
+    Eigen::VectorXd projection(3), checked_projection(3);
+    link_pose.project(state.get(), projection);
+    EXPECT_TRUE(pc->getOMPLSimpleSetup()->getStateValidityChecker()->isValid(state.get()));
+    link_pose.project(state.get(), checked_projection);
+    const Eigen::Vector3d expected = robot_state_->getGlobalLinkTransform(ee_link_name_).translation();
+    EXPECT_TRUE(projection.isApprox(expected, 1e-10));
+    EXPECT_TRUE(checked_projection.isApprox(expected, 1e-10));
+  }
+
   void testPathConstraints(const std::vector<double>& start, const std::vector<double>& goal)
   {
     // create all the test specific input necessary to make the getPlanningContext call possible
@@ -319,6 +438,21 @@ TEST_F(PandaTestPlanningContext, testSimpleRequest)
   testSimpleRequest({ 0, -0.785, 0, -2.356, 0, 1.571, 0.785 }, { 0, -0.785, 0, -2.356, 0, 1.571, 0.685 });
 }
 
+TEST_F(PandaTestPlanningContext, testContextReuse)
+{
+  testContextReuse({ 0, -0.785, 0, -2.356, 0, 1.571, 0.785 }, { 0, -0.785, 0, -2.356, 0, 1.571, 0.685 });
+}
+
+TEST_F(PandaTestPlanningContext, testPipelinedSimplification)
+{
+  testPipelinedSimplification({ 0, -0.785, 0, -2.356, 0, 1.571, 0.785 }, { 0, -0.785, 0, -2.356, 0, 1.571, 0.685 });
+}
+
+TEST_F(PandaTestPlanningContext, testProjectionEvaluators)
+{
+  testProjectionEvaluators({ 0, -0.785, 0, -2.356, 0, 1.571, 0.785 }, { 0, -0.785, 0, -2.356, 0, 1.571, 0.685 });
+}
+
 TEST_F(PandaTestPlanningContext, testPathConstraints)
 {
   testPathConstraints({ 0, -0.785, 0, -2.356, 0, 1.571, 0.785 }, { 0, -0.785, 0, -2.356, 0, 1.571, 0.685 });
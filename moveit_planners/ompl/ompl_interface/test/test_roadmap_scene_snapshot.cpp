@@ -0,0 +1,156 @@
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2026, PickNik LLC.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of PickNik LLC nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *********************************************************************/
+
+#include "load_test_robot.h"
+
+#include <moveit/ompl_interface/detail/roadmap_scene_snapshot.h>
+#include <moveit/ompl_interface/parameterization/joint_space/joint_model_state_space.h>
+#include <moveit/planning_scene/planning_scene.h>
+#include <geometric_shapes/shapes.h>
+
+#include <ompl/base/ScopedState.h>
+#include <ompl/base/SpaceInformation.h>
+
+#include <gtest/gtest.h>
+
+#include <cstdio>
+
+class RoadmapSceneSnapshotTest : public ompl_interface_testing::LoadTestRobot, public testing::Test
+{
+protected:
+  RoadmapSceneSnapshotTest() : LoadTestRobot("panda", "panda_arm")
+  {
+  }
+
+  void SetUp() override
+  {
+    ompl_interface::ModelBasedStateSpaceSpecification space_spec(robot_model_, group_name_);
+    state_space_ = std::make_shared<ompl_interface::JointModelStateSpace>(space_spec);
+    state_space_->computeLocations();
+    si_ = std::make_shared<ompl::base::SpaceInformation>(state_space_);
+    si_->setup();
+    scene_ = std::make_shared<planning_scene::PlanningScene>(robot_model_);
+  }
+
+  void addBox(const std::string& id, const Eigen::Vector3d& position)
+  {
+    Eigen::Isometry3d pose = Eigen::Isometry3d::Identity();
+    pose.translation() = position;
+    scene_->getWorldNonConst()->addToObject(id, std::make_shared<shapes::Box>(0.1, 0.1, 0.1), pose);
+  }
+
+  // roadmap with a single edge between the "ready" state and the same state with the first joint rotated by 2 rad
+  void createRoadmap(ompl::base::PlannerData& data)
+  {
+    ompl::base::ScopedState<> from(state_space_), to(state_space_);
+    std::vector<double> positions{ 0, -0.785, 0, -2.356, 0, 1.571, 0.785 };
+    robot_state_->setJointGroupPositions(joint_model_group_, positions);
+    state_space_->copyToOMPLState(from.get(), *robot_state_);
+    positions[0] += 2.0;
+    robot_state_->setJointGroupPositions(joint_model_group_, positions);
+    state_space_->copyToOMPLState(to.get(), *robot_state_);
+    positions[0] -= 2.0;
+    robot_state_->setJointGroupPositions(joint_model_group_, positions);
+    robot_state_->update();
+
+    data.addEdge(ompl::base::PlannerDataVertex(si_->cloneState(from.get())),
+                 ompl::base::PlannerDataVertex(si_->cloneState(to.get())));
+    data.addEdge(1, 0);
+  }
+
+  ompl_interface::ModelBasedStateSpacePtr state_space_;
+  ompl::base::SpaceInformationPtr si_;
+  planning_scene::PlanningScenePtr scene_;
+};
+
+TEST_F(RoadmapSceneSnapshotTest, ChangedVolumes)
+{
+  addBox("static", Eigen::Vector3d(1.0, 1.0, 0.0));
+  addBox("moving", Eigen::Vector3d(-1.0, 1.0, 0.0));
+  ompl_interface::RoadmapSceneSnapshot previous(*scene_, *robot_state_);
+  EXPECT_TRUE(previous.getChangedVolumes(previous).empty());
+
+  scene_->getWorldNonConst()->moveObject("moving", Eigen::Isometry3d(Eigen::Translation3d(0.0, 0.0, 1.0)));
+  scene_->getWorldNonConst()->removeObject("static");
+  addBox("new", Eigen::Vector3d(0.0, -1.0, 0.0));
+  ompl_interface::RoadmapSceneSnapshot next(*scene_, *robot_state_);
+
+  // the moved and the new object are reported, the removed one is not
+  const std::vector<Eigen::AlignedBox3d> volumes = previous.getChangedVolumes(next);
+  ASSERT_EQ(volumes.size(), 2u);
+  EXPECT_TRUE(previous.hasSameAttachedBodies(next));
+}
+
+TEST_F(RoadmapSceneSnapshotTest, StoreAndLoad)
+{
+  addBox("box", Eigen::Vector3d(1.0, 0.5, 0.25));
+  ompl_interface::RoadmapSceneSnapshot snapshot(*scene_, *robot_state_);
+
+  const std::string path = "test_roadmap_scene_snapshot.scene";
+  ASSERT_TRUE(snapshot.store(path));
+  ompl_interface::RoadmapSceneSnapshot loaded;
+  ASSERT_TRUE(loaded.load(path));
+  std::remove(path.c_str());
+
+  EXPECT_TRUE(loaded.getChangedVolumes(snapshot).empty());
+  EXPECT_EQ(ompl_interface::RoadmapSceneSnapshot().getChangedVolumes(loaded).size(), 1u);
+  EXPECT_FALSE(loaded.load("does_not_exist.scene"));
+}
+
+TEST_F(RoadmapSceneSnapshotTest, PruneRoadmap)
+{
+  ompl::base::PlannerData data(si_);
+  createRoadmap(data);
+  ASSERT_EQ(data.numEdges(), 2u);
+
+  // a box far away from the robot keeps the edge
+  addBox("far", Eigen::Vector3d(5.0, 5.0, 5.0));
+  ompl_interface::RoadmapSceneSnapshot empty;
+  EXPECT_EQ(ompl_interface::pruneRoadmap(data, empty.getChangedVolumes({ *scene_, *robot_state_ }), *robot_state_), 0u);
+  EXPECT_EQ(data.numEdges(), 2u);
+
+  // a box halfway along the path of the end-effector invalidates the edge, but not the vertices
+  const Eigen::Vector3d ee = robot_state_->getGlobalLinkTransform(ee_link_name_).translation();
+  addBox("near", Eigen::AngleAxisd(1.0, Eigen::Vector3d::UnitZ()) * ee);
+  ompl_interface::RoadmapSceneSnapshot next(*scene_, *robot_state_);
+  EXPECT_GT(ompl_interface::pruneRoadmap(data, empty.getChangedVolumes(next), *robot_state_), 0u);
+  EXPECT_EQ(data.numEdges(), 0u);
+  EXPECT_EQ(data.numVertices(), 2u);
+}
+
+int main(int argc, char** argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -38,6 +38,7 @@
 
 #include <moveit/ompl_interface/parameterization/joint_space/joint_model_state_space.h>
 #include <moveit/ompl_interface/parameterization/work_space/pose_model_state_space.h>
+#include <moveit/ompl_interface/parameterization/joint_space/robot_state_bound_state_space.h>
 
 #include <urdf_parser/urdf_parser.h>
 
@@ -184,6 +185,61 @@ TEST_F(LoadPlanningModelsPr2, StateSpaceCopy)
   joint_model_state_space.freeState(state);
 }
 
+TEST(RobotStateBoundStateSpace, ValuesAliasRobotState)
+{
+  moveit::core::RobotModelPtr robot_model = moveit::core::loadTestingRobotModel("panda");
+  const moveit::core::JointModelGroup* jmg = robot_model->getJointModelGroup("panda_arm");
+  ompl_interface::ModelBasedStateSpaceSpecification spec(robot_model, jmg);
+  ompl_interface::RobotStateBoundStateSpace space(spec);
+  space.setup();
+
+  moveit::core::RobotState reference_state(robot_model);
+  reference_state.setToRandomPositions();
+  space.setReferenceState(reference_state);
+
+  ompl::base::State* ompl_state = space.allocState();
+  space.allocDefaultStateSampler()->sampleUniform(ompl_state);
+
+  moveit::core::RobotState* bound = space.getBoundRobotState(ompl_state);
+  ASSERT_NE(bound, nullptr);
+
+  // the bound state matches a copy of the OMPL state, including its transforms
+  moveit::core::RobotState copy(reference_state);
+  space.copyToRobotState(copy, ompl_state);
+  EXPECT_EQ(bound->distance(copy), 0.0);
+  const moveit::core::LinkModel* tip = robot_model->getLinkModel("panda_link8");
+  EXPECT_TRUE(bound->getGlobalLinkTransform(tip).isApprox(copy.getGlobalLinkTransform(tip)));
+
+  // writes through the OMPL state are seen by the bound state
+  ompl_state->as<ompl_interface::ModelBasedStateSpace::StateType>()->values[0] = 0.5;
+  bound = space.getBoundRobotState(ompl_state);
+  EXPECT_EQ(bound->getVariablePosition("panda_joint1"), 0.5);
+  copy.setVariablePosition("panda_joint1", 0.5);
+  copy.update();
+  EXPECT_TRUE(bound->getGlobalLinkTransform(tip).isApprox(copy.getGlobalLinkTransform(tip)));
+
+  // a new reference state updates the other joints but keeps the values of the group
+  moveit::core::RobotState other_reference(robot_model);
+  other_reference.setToRandomPositions();
+  space.setReferenceState(other_reference);
+  bound = space.getBoundRobotState(ompl_state);
+  EXPECT_EQ(bound->getVariablePosition("panda_joint1"), 0.5);
+  EXPECT_EQ(bound->getVariablePosition("panda_finger_joint1"),
+            other_reference.getVariablePosition("panda_finger_joint1"));
+
+  space.freeState(ompl_state);
+}
+
+TEST_F(LoadPlanningModelsPr2, ModelBasedStateSpaceIsNotBound)
+{
+  ompl_interface::ModelBasedStateSpaceSpecification spec(robot_model_, "right_arm");
+  ompl_interface::JointModelStateSpace space(spec);
+  space.setup();
+  ompl::base::State* state = space.allocState();
+  EXPECT_EQ(space.getBoundRobotState(state), nullptr);
+  space.freeState(state);
+}
+
 int main(int argc, char** argv)
 {
   testing::InitGoogleTest(&argc, argv);
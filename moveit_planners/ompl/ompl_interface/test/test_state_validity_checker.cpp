@@ -39,6 +39,8 @@
  *        - States inside and outside joint limits.
  *        - States that are in self-collision.
  *        - Position constraints on the robot's end-effector link.
+ *        - Lazy collision checking of sampled states.
+ *        - Motion validation with steps that adapt to the distance to obstacles.
  *
  *    It does not yet test:
  *        - Collision with objects in the environment.
@@ -56,10 +58,13 @@
 #include <gtest/gtest.h>
 
 #include <moveit/ompl_interface/detail/state_validity_checker.h>
+#include <moveit/ompl_interface/detail/lazy_motion_validator.h>
+#include <moveit/ompl_interface/detail/clearance_motion_validator.h>
 #include <moveit/ompl_interface/model_based_planning_context.h>
 #include <moveit/ompl_interface/parameterization/joint_space/joint_model_state_space.h>
 #include <moveit/planning_scene/planning_scene.h>
 
+#include <ompl/base/DiscreteMotionValidator.h>
 #include <ompl/geometric/SimpleSetup.h>
 
 /** \brief This flag sets the verbosity level for the state validity checker. **/
@@ -148,6 +153,73 @@ public:
     EXPECT_TRUE(robot_state_->satisfiesBounds());
   }
 
+  /** In lazy mode only the cheap checks run for sampled states, collisions are checked along motions. **/
+  void testLazyCollisionChecking(const std::vector<double>& position_in_self_collision)
+  {
+    auto checker = std::make_shared<ompl_interface::StateValidityChecker>(planning_context_.get());
+    checker->setVerbose(VERBOSE);
+    checker->setLazyCollisionChecking(true);
+
+    robot_state_->setJointGroupPositions(joint_model_group_, position_in_self_collision);
+    ompl::base::ScopedState<> ompl_state(state_space_);
+    state_space_->copyToOMPLState(ompl_state.get(), *robot_state_);
+
+    // the state satisfies bounds and constraints, so the lazy check accepts it and caches that result
+    EXPECT_TRUE(checker->isValid(ompl_state.get()));
+    EXPECT_TRUE(ompl_state->as<ompl_interface::JointModelStateSpace::StateType>()->areConstraintsSatisfied());
+    EXPECT_FALSE(ompl_state->as<ompl_interface::JointModelStateSpace::StateType>()->isValidityKnown());
+
+    // motion validation checks the collision and caches the full result
+    ompl::base::SpaceInformationPtr si = planning_context_->getOMPLSimpleSetup()->getSpaceInformation();
+    ompl_interface::LazyMotionValidator motion_validator(si, checker);
+    EXPECT_FALSE(motion_validator.checkMotion(ompl_state.get(), ompl_state.get()));
+    EXPECT_TRUE(ompl_state->as<ompl_interface::JointModelStateSpace::StateType>()->isValidityKnown());
+    EXPECT_FALSE(checker->isValid(ompl_state.get()));
+
+    // states outside the bounds are still rejected by the lazy check
+    ompl_state->as<ompl_interface::JointModelStateSpace::StateType>()->values[0] = std::numeric_limits<double>::max();
+    ompl_state->as<ompl_interface::JointModelStateSpace::StateType>()->clearKnownInformation();
+    EXPECT_FALSE(checker->isValid(ompl_state.get()));
+  }
+
+  /** The adaptive motion validator agrees with OMPL's discrete one on motions into and out of collision. **/
+  void testAdaptiveMotionValidation(const std::vector<double>& position_valid,
+                                    const std::vector<double>& position_in_self_collision)
+  {
+    auto checker = std::make_shared<ompl_interface::StateValidityChecker>(planning_context_.get());
+    checker->setVerbose(VERBOSE);
+    ompl::base::SpaceInformationPtr si = planning_context_->getOMPLSimpleSetup()->getSpaceInformation();
+    ompl_interface::ClearanceMotionValidator motion_validator(si, planning_context_.get(), checker);
+    ompl::base::DiscreteMotionValidator discrete_validator(si);
+
+    ompl::base::ScopedState<> valid_state(state_space_), colliding_state(state_space_), nearby_state(state_space_);
+    robot_state_->setJointGroupPositions(joint_model_group_, position_valid);
+    state_space_->copyToOMPLState(valid_state.get(), *robot_state_);
+    robot_state_->setJointGroupPositions(joint_model_group_, position_in_self_collision);
+    state_space_->copyToOMPLState(colliding_state.get(), *robot_state_);
+    std::vector<double> position_nearby = position_valid;
+    position_nearby[0] += 0.1;
+    robot_state_->setJointGroupPositions(joint_model_group_, position_nearby);
+    state_space_->copyToOMPLState(nearby_state.get(), *robot_state_);
+
+    EXPECT_EQ(motion_validator.getSweptDistanceBound(valid_state.get(), valid_state.get()), 0.0);
+    EXPECT_GT(motion_validator.getSweptDistanceBound(valid_state.get(), nearby_state.get()), 0.0);
+
+    EXPECT_TRUE(motion_validator.checkMotion(valid_state.get(), nearby_state.get()));
+    EXPECT_TRUE(discrete_validator.checkMotion(valid_state.get(), nearby_state.get()));
+    EXPECT_FALSE(motion_validator.checkMotion(valid_state.get(), colliding_state.get()));
+
+    // the last valid state along the motion is reported, and it is valid
+    ompl::base::ScopedState<> last_valid_state(state_space_);
+    std::pair<ompl::base::State*, double> last_valid(last_valid_state.get(), 0.0);
+    EXPECT_FALSE(motion_validator.checkMotion(valid_state.get(), colliding_state.get(), last_valid));
+    EXPECT_LT(last_valid.second, 1.0);
+    EXPECT_TRUE(checker->isValid(last_valid_state.get(), false));
+
+    EXPECT_EQ(motion_validator.getValidMotionCount(), 1u);
+    EXPECT_EQ(motion_validator.getInvalidMotionCount(), 2u);
+  }
+
   void testPathConstraints(const std::vector<double>& position_in_joint_limits)
   {
     ASSERT_NE(planning_context_, nullptr) << "Initialize planning context before adding path constraints.";
@@ -290,6 +362,17 @@ TEST_F(PandaValidity, testSelfCollision)
   testSelfCollision({ 2.31827, -0.169668, 2.5225, -2.98568, -0.36355, 0.808339, 0.0843406 });
 }
 
+TEST_F(PandaValidity, testLazyCollisionChecking)
+{
+  testLazyCollisionChecking({ 2.31827, -0.169668, 2.5225, -2.98568, -0.36355, 0.808339, 0.0843406 });
+}
+
+TEST_F(PandaValidity, testAdaptiveMotionValidation)
+{
+  testAdaptiveMotionValidation({ 0, -0.785, 0, -2.356, 0, 1.571, 0.785 },
+                               { 2.31827, -0.169668, 2.5225, -2.98568, -0.36355, 0.808339, 0.0843406 });
+}
+
 TEST_F(PandaValidity, testPathConstraints)
 {
   // use the panda "ready" state from the srdf config
@@ -326,6 +409,17 @@ TEST_F(FanucTest, testSelfCollision)
   testSelfCollision({ -2.95993, -0.682185, -2.43873, -0.939784, 3.0544, 0.882294 });
 }
 
+TEST_F(FanucTest, testLazyCollisionChecking)
+{
+  testLazyCollisionChecking({ -2.95993, -0.682185, -2.43873, -0.939784, 3.0544, 0.882294 });
+}
+
+TEST_F(FanucTest, testAdaptiveMotionValidation)
+{
+  testAdaptiveMotionValidation({ 0.0, 0.0, 0.0, 0.0, 0.0, 0.0 },
+                               { -2.95993, -0.682185, -2.43873, -0.939784, 3.0544, 0.882294 });
+}
+
 TEST_F(FanucTest, testPathConstraints)
 {
   // I assume the Fanucs's zero state is within limits and self-collision free
@@ -0,0 +1,103 @@
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2026, PickNik LLC.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of PickNik LLC nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *********************************************************************/
+
+#include <moveit/ompl_interface/detail/threadsafe_state_storage.h>
+#include <moveit/utils/robot_model_test_utils.h>
+#include <gtest/gtest.h>
+#include <memory>
+#include <set>
+
+TEST(TSStateStorage, SameStateWithinThread)
+{
+  moveit::core::RobotModelPtr robot_model = moveit::core::loadTestingRobotModel("panda");
+  ompl_interface::TSStateStorage storage(robot_model);
+  moveit::core::RobotState* state = storage.getStateStorage();
+  ASSERT_NE(state, nullptr);
+  EXPECT_EQ(storage.getStateStorage(), state);
+}
+
+TEST(TSStateStorage, DistinctStatesAcrossThreads)
+{
+  moveit::core::RobotModelPtr robot_model = moveit::core::loadTestingRobotModel("panda");
+  moveit::core::RobotState start_state(robot_model);
+  start_state.setToRandomPositions();
+  ompl_interface::TSStateStorage storage(start_state);
+
+  constexpr std::size_t THREAD_COUNT = 4;
+  std::vector<moveit::core::RobotState*> states(THREAD_COUNT, nullptr);
+  std::vector<std::thread> threads;
+  for (std::size_t i = 0; i < THREAD_COUNT; ++i)
+    threads.emplace_back([&storage, &states, i] {
+      states[i] = storage.getStateStorage();
+      // repeated lookups are served from the thread-local cache
+      for (int j = 0; j < 100; ++j)
+        if (storage.getStateStorage() != states[i])
+          states[i] = nullptr;
+    });
+  for (std::thread& thread : threads)
+    thread.join();
+
+  std::set<moveit::core::RobotState*> unique_states(states.begin(), states.end());
+  EXPECT_EQ(unique_states.size(), THREAD_COUNT);
+  ASSERT_EQ(unique_states.count(nullptr), 0u);
+  for (const moveit::core::RobotState* state : states)
+    EXPECT_EQ(state->distance(start_state), 0.0);
+}
+
+TEST(TSStateStorage, ManyStoragesInOneThread)
+{
+  // more storages than thread-local cache entries, each needs to keep returning its own state
+  moveit::core::RobotModelPtr robot_model = moveit::core::loadTestingRobotModel("panda");
+  std::vector<std::unique_ptr<ompl_interface::TSStateStorage>> storages;
+  std::vector<moveit::core::RobotState*> states;
+  for (int i = 0; i < 20; ++i)
+  {
+    storages.push_back(std::make_unique<ompl_interface::TSStateStorage>(robot_model));
+    states.push_back(storages.back()->getStateStorage());
+  }
+  for (std::size_t i = 0; i < storages.size(); ++i)
+    EXPECT_EQ(storages[i]->getStateStorage(), states[i]);
+
+  // a new storage never reuses the cached state of a destroyed one
+  storages.clear();
+  ompl_interface::TSStateStorage storage(robot_model);
+  moveit::core::RobotState* state = storage.getStateStorage();
+  EXPECT_EQ(storage.getStateStorage(), state);
+}
+
+int main(int argc, char** argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -34,6 +34,7 @@
 
 #pragma once
 
+#include <functional>
 #include <string>
 
 #include <boost/optional.hpp>
@@ -96,12 +97,49 @@ public:
    * which it belongs to. Starts states can even be incomplete. In this case
    * default values are set for the unset joints.
    *
+   * Please note:
+   * With the parameter "sequence_planning_threads" greater than 1 (or 0 for
+   * all cores), the sequence items with known start states and the blends are
+   * computed in parallel. This requires the kinematics solvers of the groups
+   * to be thread-safe.
+   *
    * @return Contains the calculated/generated trajectories.
    */
   RobotTrajCont solve(const planning_scene::PlanningSceneConstPtr& planning_scene,
                       const planning_pipeline::PlanningPipelinePtr& planning_pipeline,
                       const moveit_msgs::MotionSequenceRequest& req_list);
 
+  //! Receives the parts of the result which are final, see the streaming solve().
+  using SegmentCallback = std::function<void(const robot_trajectory::RobotTrajectoryPtr&)>;
+
+  /**
+   * @brief Generates the same trajectories as solve(), but passes each part
+   * of the result to the specified callback as soon as it is final.
+   *
+   * The requests are planned and blended one after another. Once a request
+   * is planned, the trajectory up to its blend with the previous request can
+   * no longer change and is passed on, so the execution of long sequences
+   * can start while the following requests are still being planned.
+   *
+   * The segments are passed on in order. Concatenating the consecutive
+   * segments of the same group gives the trajectories of the result; a
+   * segment whose group differs from the previous one starts a new result
+   * trajectory. The callback is called from the planning thread and should
+   * hand the segment over (e.g. to an execution queue) instead of blocking.
+   *
+   * Please note: The request list is validated as described for solve(),
+   * but overlapping blend radii are only detected once both requests are
+   * planned. An exception can therefore be thrown after segments have been
+   * passed on.
+   *
+   * @param segment_callback Called with each new final segment.
+   *
+   * @return Contains the calculated/generated trajectories.
+   */
+  RobotTrajCont solve(const planning_scene::PlanningSceneConstPtr& planning_scene,
+                      const planning_pipeline::PlanningPipelinePtr& planning_pipeline,
+                      const moveit_msgs::MotionSequenceRequest& req_list, const SegmentCallback& segment_callback);
+
 private:
   using MotionResponseCont = std::vector<planning_interface::MotionPlanResponse>;
   using RobotState_OptRef = boost::optional<const robot_state::RobotState&>;
@@ -118,15 +156,44 @@ private:
    */
   void checkForOverlappingRadii(const MotionResponseCont& resp_cont, const RadiiCont& radii) const;
 
+  /**
+   * @brief Validates that the blending radii of the commands with the
+   * specified index and the next index do not overlap.
+   */
+  void checkForOverlappingRadii(const MotionResponseCont& resp_cont, const RadiiCont& radii,
+                                MotionResponseCont::size_type index) const;
+
   /**
    * @brief Solve each sequence item individually.
    *
+   * Sequence items whose start state is known before planning are solved in
+   * parallel, see predictStartStates(). A parallel solution is only used, if
+   * it starts where the previous trajectory of its group actually ends.
+   * Otherwise, and for all other items, the items are solved one after another.
+   *
    * @param planning_scene The planning_scene to be used for trajectory
    * generation.
    * @param req_list Container of requests for calculation/generation.
    *
    * @return Container of generated trajectories.
    */
+  /**
+   * @brief Solve a single sequence item, starting at the end of the previous
+   * trajectory of its group.
+   *
+   * @param planning_scene The planning_scene to be used for trajectory
+   * generation.
+   * @param seq_item The sequence item to solve.
+   * @param motion_plan_responses Trajectories of the previous sequence items.
+   *
+   * @return The generated trajectory.
+   */
+  planning_interface::MotionPlanResponse
+  solveSequenceItem(const planning_scene::PlanningSceneConstPtr& planning_scene,
+                    const planning_pipeline::PlanningPipelinePtr& planning_pipeline,
+                    const moveit_msgs::MotionSequenceItem& seq_item,
+                    const MotionResponseCont& motion_plan_responses) const;
+
   MotionResponseCont solveSequenceItems(const planning_scene::PlanningSceneConstPtr& planning_scene,
                                         const planning_pipeline::PlanningPipelinePtr& planning_pipeline,
                                         const moveit_msgs::MotionSequenceRequest& req_list) const;
@@ -140,6 +207,19 @@ private:
                             const robot_trajectory::RobotTrajectory& traj_B, const double radii_B) const;
 
 private:
+  /**
+   * @brief Predicts the start state of each sequence item which is known
+   * before planning: The first item of each group starts at its own start
+   * state. Each following item starts at the joint goal of the previous item
+   * of the group, if that goal states all joints of the group.
+   *
+   * @return The predicted start states, an empty optional for each item whose
+   * start state is not known.
+   */
+  static std::vector<boost::optional<moveit_msgs::RobotState>>
+  predictStartStates(const planning_scene::PlanningSceneConstPtr& planning_scene,
+                     const moveit_msgs::MotionSequenceRequest& req_list);
+
   /**
    * @return The last RobotState of the specified group which can
    * be found in the specified vector.
@@ -212,6 +292,9 @@ private:
   //! @brief Builder to construct the container containing the final
   //! trajectories.
   PlanComponentsBuilder plan_comp_builder_;
+
+  //! Number of threads sequence items and blends are computed on.
+  unsigned int num_threads_;
 };
 
 inline void CommandListManager::checkLastBlendRadiusZero(const moveit_msgs::MotionSequenceRequest& req_list)
@@ -99,6 +99,25 @@ public:
   void append(const planning_scene::PlanningSceneConstPtr& planning_scene,
               const robot_trajectory::RobotTrajectoryPtr& other, const double blend_radius);
 
+  /**
+   * @brief Appends the specified trajectories like consecutive calls of the
+   * single trajectory append(), but computes the blends in parallel.
+   *
+   * The blend radii must not overlap, so that each blend only replaces the
+   * end of one trajectory and the start of the next one.
+   *
+   * @param others Trajectories which have to be added to the trajectory
+   * container under construction.
+   *
+   * @param blend_radii The blending radius between each trajectory and its
+   * predecessor.
+   *
+   * @param num_threads Number of threads the blends are computed on.
+   */
+  void append(const planning_scene::PlanningSceneConstPtr& planning_scene,
+              const std::vector<robot_trajectory::RobotTrajectoryPtr>& others, const std::vector<double>& blend_radii,
+              unsigned int num_threads);
+
   /**
    * @brief Clears the trajectory container under construction.
    */
@@ -109,10 +128,45 @@ public:
    */
   std::vector<robot_trajectory::RobotTrajectoryPtr> build() const;
 
+  /**
+   * @brief Returns the waypoints which were added to the trajectory container
+   * under construction since the last call, one segment per container element.
+   *
+   * Waypoints in the container can no longer change through further append
+   * calls, so the segments can be executed while later trajectories are still
+   * being appended. Concatenating the segments of a container element gives the
+   * element, if the last call is made after build().
+   */
+  std::vector<robot_trajectory::RobotTrajectoryPtr> extractNewSegments();
+
 private:
   void blend(const planning_scene::PlanningSceneConstPtr& planning_scene,
              const robot_trajectory::RobotTrajectoryPtr& other, const double blend_radius);
 
+  /**
+   * @return True if the specified trajectory is blended with the previously
+   * added trajectory.
+   */
+  bool isBlended(const robot_trajectory::RobotTrajectoryPtr& other, const double blend_radius) const;
+
+  /**
+   * @brief Blends the two specified trajectories with the blender.
+   */
+  bool computeBlend(const planning_scene::PlanningSceneConstPtr& planning_scene,
+                    const robot_trajectory::RobotTrajectoryPtr& first,
+                    const robot_trajectory::RobotTrajectoryPtr& second, const double blend_radius,
+                    pilz_industrial_motion_planner::TrajectoryBlendResponse& blend_response) const;
+
+  /**
+   * @brief Appends the result of blending the previously added trajectory.
+   *
+   * @param blended_first The first trajectory of the blend. It either is the
+   * previously added trajectory, or that trajectory before its start was
+   * replaced by the previous blend.
+   */
+  void appendBlend(const robot_trajectory::RobotTrajectory& blended_first,
+                   const pilz_industrial_motion_planner::TrajectoryBlendResponse& blend_response);
+
 private:
   /**
    * @brief Appends a trajectory to a result trajectory leaving out the
@@ -139,6 +193,12 @@ private:
   //! The trajectory container under construction.
   std::vector<robot_trajectory::RobotTrajectoryPtr> traj_cont_;
 
+  //! Index of the container element extractNewSegments() continues with.
+  std::size_t extracted_elements_{ 0 };
+
+  //! Number of waypoints of that element returned by extractNewSegments().
+  std::size_t extracted_waypoints_{ 0 };
+
 private:
   //! Constant to check for equality of variables of two RobotState instances.
   static constexpr double ROBOT_STATE_EQUALITY_EPSILON = 1e-4;
@@ -158,6 +218,8 @@ inline void PlanComponentsBuilder::reset()
 {
   traj_tail_ = nullptr;
   traj_cont_.clear();
+  extracted_elements_ = 0;
+  extracted_waypoints_ = 0;
 }
 
 }  // namespace pilz_industrial_motion_planner
@@ -122,8 +122,13 @@ bool verifySampleJointLimits(const std::map<std::string, double>& position_last,
  * point will have zero velocity
  * and acceleration
  * @param error_code: detailed error information
- * @param check_self_collision: check for self collision during creation
+ * @param check_self_collision: check all samples for self collision in one
+ * batch after the joint trajectory is created
  * @return true if succeed
+ *
+ * The IK of every sample is seeded from the solution of the previous sample
+ * and computed by damped least squares steps on the Jacobian. The IK solver of
+ * the group is only used for samples where these steps do not converge.
  */
 bool generateJointTrajectory(const planning_scene::PlanningSceneConstPtr& scene,
                              const JointLimitsContainer& joint_limits, const KDL::Trajectory& trajectory,
@@ -140,6 +145,8 @@ bool generateJointTrajectory(const planning_scene::PlanningSceneConstPtr& scene,
  * @param sampling_time
  * @param joint_trajectory
  * @param error_code
+ * @param check_self_collision: check all samples for self collision in one
+ * batch after the joint trajectory is created
  * @return true if succeed
  */
 bool generateJointTrajectory(const planning_scene::PlanningSceneConstPtr& scene,
@@ -36,7 +36,9 @@
 
 #include <cassert>
 #include <functional>
+#include <map>
 #include <sstream>
+#include <thread>
 
 #include <moveit/planning_pipeline/planning_pipeline.h>
 #include <moveit/robot_state/conversions.h>
@@ -44,6 +46,7 @@
 
 #include "pilz_industrial_motion_planner/cartesian_limits_aggregator.h"
 #include "pilz_industrial_motion_planner/joint_limits_aggregator.h"
+#include "pilz_industrial_motion_planner/parallel_for.h"
 #include "pilz_industrial_motion_planner/tip_frame_getter.h"
 #include "pilz_industrial_motion_planner/trajectory_blend_request.h"
 #include "pilz_industrial_motion_planner/trajectory_blender_transition_window.h"
@@ -51,6 +54,8 @@
 namespace pilz_industrial_motion_planner
 {
 static const std::string PARAM_NAMESPACE_LIMITS = "robot_description_planning";
+//! Tolerance within which a parallel solved item starts at the end of its predecessor
+static constexpr double START_STATE_EQUALITY_EPSILON = 1e-4;
 
 CommandListManager::CommandListManager(const ros::NodeHandle& nh, const moveit::core::RobotModelConstPtr& model)
   : nh_(nh), model_(model)
@@ -73,6 +78,10 @@ CommandListManager::CommandListManager(const ros::NodeHandle& nh, const moveit::
   plan_comp_builder_.setModel(model);
   plan_comp_builder_.setBlender(std::unique_ptr<pilz_industrial_motion_planner::TrajectoryBlender>(
       new pilz_industrial_motion_planner::TrajectoryBlenderTransitionWindow(limits)));
+
+  int num_threads;
+  nh_.param("sequence_planning_threads", num_threads, 1);
+  num_threads_ = num_threads > 0 ? num_threads : std::max(1u, std::thread::hardware_concurrency());
 }
 
 RobotTrajCont CommandListManager::solve(const planning_scene::PlanningSceneConstPtr& planning_scene,
@@ -94,18 +103,72 @@ RobotTrajCont CommandListManager::solve(const planning_scene::PlanningSceneConst
   RadiiCont radii{ extractBlendRadii(*model_, req_list) };
   checkForOverlappingRadii(resp_cont, radii);
 
-  plan_comp_builder_.reset();
+  RobotTrajCont trajectories(resp_cont.size());
+  RadiiCont blend_radii(resp_cont.size());
   for (MotionResponseCont::size_type i = 0; i < resp_cont.size(); ++i)
   {
-    plan_comp_builder_.append(planning_scene, resp_cont.at(i).trajectory_,
-                              // The blend radii has to be "attached" to
-                              // the second part of a blend trajectory,
-                              // therefore: "i-1".
-                              (i > 0 ? radii.at(i - 1) : 0.));
+    trajectories.at(i) = resp_cont.at(i).trajectory_;
+    // The blend radii has to be "attached" to
+    // the second part of a blend trajectory,
+    // therefore: "i-1".
+    blend_radii.at(i) = (i > 0 ? radii.at(i - 1) : 0.);
   }
+
+  plan_comp_builder_.reset();
+  plan_comp_builder_.append(planning_scene, trajectories, blend_radii, num_threads_);
   return plan_comp_builder_.build();
 }
 
+RobotTrajCont CommandListManager::solve(const planning_scene::PlanningSceneConstPtr& planning_scene,
+                                        const planning_pipeline::PlanningPipelinePtr& planning_pipeline,
+                                        const moveit_msgs::MotionSequenceRequest& req_list,
+                                        const SegmentCallback& segment_callback)
+{
+  if (req_list.items.empty())
+  {
+    return RobotTrajCont();
+  }
+
+  checkForNegativeRadii(req_list);
+  checkLastBlendRadiusZero(req_list);
+  checkStartStates(req_list);
+
+  assert(model_);
+  RadiiCont radii{ extractBlendRadii(*model_, req_list) };
+
+  const auto pass_on_new_segments = [this, &segment_callback]() {
+    for (const robot_trajectory::RobotTrajectoryPtr& segment : plan_comp_builder_.extractNewSegments())
+    {
+      if (segment_callback)
+      {
+        segment_callback(segment);
+      }
+    }
+  };
+
+  MotionResponseCont resp_cont;
+  resp_cont.reserve(req_list.items.size());
+  plan_comp_builder_.reset();
+  for (MotionResponseCont::size_type i = 0; i < req_list.items.size(); ++i)
+  {
+    resp_cont.emplace_back(solveSequenceItem(planning_scene, planning_pipeline, req_list.items.at(i), resp_cont));
+    ROS_DEBUG_STREAM("Solved [" << i + 1 << "/" << req_list.items.size() << "]");
+
+    // Both radii of the blend with the previous command are known now
+    if (i > 0 && i + 1 < req_list.items.size())
+    {
+      checkForOverlappingRadii(resp_cont, radii, i - 1);
+    }
+
+    plan_comp_builder_.append(planning_scene, resp_cont.at(i).trajectory_, (i > 0 ? radii.at(i - 1) : 0.));
+    pass_on_new_segments();
+  }
+
+  RobotTrajCont res_vec{ plan_comp_builder_.build() };
+  pass_on_new_segments();
+  return res_vec;
+}
+
 bool CommandListManager::checkRadiiForOverlap(const robot_trajectory::RobotTrajectory& traj_A, const double radii_A,
                                               const robot_trajectory::RobotTrajectory& traj_B,
                                               const double radii_B) const
@@ -142,13 +205,19 @@ void CommandListManager::checkForOverlappingRadii(const MotionResponseCont& resp
 
   for (MotionResponseCont::size_type i = 0; i < resp_cont.size() - 2; ++i)
   {
-    if (checkRadiiForOverlap(*(resp_cont.at(i).trajectory_), radii.at(i), *(resp_cont.at(i + 1).trajectory_),
-                             radii.at(i + 1)))
-    {
-      std::ostringstream os;
-      os << "Overlapping blend radii between command [" << i << "] and [" << i + 1 << "].";
-      throw OverlappingBlendRadiiException(os.str());
-    }
+    checkForOverlappingRadii(resp_cont, radii, i);
+  }
+}
+
+void CommandListManager::checkForOverlappingRadii(const MotionResponseCont& resp_cont, const RadiiCont& radii,
+                                                  MotionResponseCont::size_type index) const
+{
+  if (checkRadiiForOverlap(*(resp_cont.at(index).trajectory_), radii.at(index),
+                           *(resp_cont.at(index + 1).trajectory_), radii.at(index + 1)))
+  {
+    std::ostringstream os;
+    os << "Overlapping blend radii between command [" << index << "] and [" << index + 1 << "].";
+    throw OverlappingBlendRadiiException(os.str());
   }
 }
 
@@ -226,28 +295,130 @@ CommandListManager::solveSequenceItems(const planning_scene::PlanningSceneConstP
                                        const planning_pipeline::PlanningPipelinePtr& planning_pipeline,
                                        const moveit_msgs::MotionSequenceRequest& req_list) const
 {
+  const size_t num_req{ req_list.items.size() };
+
+  // Solve the items whose start states are known in parallel
+  std::vector<boost::optional<moveit_msgs::RobotState>> start_states;
+  std::vector<boost::optional<planning_interface::MotionPlanResponse>> parallel_responses(num_req);
+  if (num_threads_ > 1)
+  {
+    start_states = predictStartStates(planning_scene, req_list);
+    parallelFor(num_req, num_threads_, [&](size_t i) {
+      if (!start_states.at(i))
+      {
+        return;
+      }
+      planning_interface::MotionPlanRequest req{ req_list.items.at(i).req };
+      req.start_state = start_states.at(i).value();
+      planning_interface::MotionPlanResponse res;
+      // Failures are reported when the item is solved again below
+      try
+      {
+        planning_pipeline->generatePlan(planning_scene, req, res);
+      }
+      catch (const std::exception& ex)
+      {
+        ROS_DEBUG_STREAM("Parallel planning of request [" << i << "] failed: " << ex.what());
+        return;
+      }
+      if (res.error_code_.val == res.error_code_.SUCCESS)
+      {
+        parallel_responses.at(i) = res;
+      }
+    });
+  }
+
+  // Stitch the parallel solutions and solve the remaining items in order
   MotionResponseCont motion_plan_responses;
   size_t curr_req_index{ 0 };
-  const size_t num_req{ req_list.items.size() };
   for (const auto& seq_item : req_list.items)
   {
-    planning_interface::MotionPlanRequest req{ seq_item.req };
-    setStartState(motion_plan_responses, req.group_name, req.start_state);
-
-    planning_interface::MotionPlanResponse res;
-    planning_pipeline->generatePlan(planning_scene, req, res);
-    if (res.error_code_.val != res.error_code_.SUCCESS)
+    const auto& parallel_res{ parallel_responses.at(curr_req_index) };
+    RobotState_OptRef prev_end_state{ getPreviousEndState(motion_plan_responses, seq_item.req.group_name) };
+    if (parallel_res &&
+        (!prev_end_state || isRobotStateEqual(prev_end_state.value(), parallel_res->trajectory_->getFirstWayPoint(),
+                                              seq_item.req.group_name, START_STATE_EQUALITY_EPSILON)))
     {
-      std::ostringstream os;
-      os << "Could not solve request\n---\n" << req << "\n---\n";
-      throw PlanningPipelineException(os.str(), res.error_code_.val);
+      motion_plan_responses.emplace_back(parallel_res.value());
+    }
+    else
+    {
+      motion_plan_responses.emplace_back(
+          solveSequenceItem(planning_scene, planning_pipeline, seq_item, motion_plan_responses));
     }
-    motion_plan_responses.emplace_back(res);
     ROS_DEBUG_STREAM("Solved [" << ++curr_req_index << "/" << num_req << "]");
   }
   return motion_plan_responses;
 }
 
+std::vector<boost::optional<moveit_msgs::RobotState>>
+CommandListManager::predictStartStates(const planning_scene::PlanningSceneConstPtr& planning_scene,
+                                       const moveit_msgs::MotionSequenceRequest& req_list)
+{
+  std::vector<boost::optional<moveit_msgs::RobotState>> start_states(req_list.items.size());
+  // Start state of the first item of each group, followed by the joint goal
+  // of the last item of the group, if it is known
+  std::map<std::string, moveit::core::RobotState> group_states;
+  std::map<std::string, bool> group_state_known;
+  for (size_t i = 0; i < req_list.items.size(); ++i)
+  {
+    const planning_interface::MotionPlanRequest& req{ req_list.items.at(i).req };
+    auto group_state{ group_states.find(req.group_name) };
+    if (group_state == group_states.end())
+    {
+      group_state = group_states.emplace(req.group_name, planning_scene->getCurrentState()).first;
+      moveit::core::robotStateMsgToRobotState(req.start_state, group_state->second);
+      group_state_known[req.group_name] = true;
+      start_states.at(i) = req.start_state;
+    }
+    else if (group_state_known.at(req.group_name))
+    {
+      start_states.at(i) = moveit_msgs::RobotState();
+      moveit::core::robotStateToRobotStateMsg(group_state->second, start_states.at(i).value());
+    }
+
+    // The trajectory ends at the goal, if the goal states all joints
+    const moveit::core::JointModelGroup* group{ planning_scene->getRobotModel()->getJointModelGroup(req.group_name) };
+    std::vector<std::string> goal_joints;
+    if (!req.goal_constraints.empty())
+    {
+      for (const moveit_msgs::JointConstraint& joint_constraint : req.goal_constraints.front().joint_constraints)
+      {
+        group_state->second.setVariablePosition(joint_constraint.joint_name, joint_constraint.position);
+        goal_joints.push_back(joint_constraint.joint_name);
+      }
+    }
+    group_state_known.at(req.group_name) =
+        std::all_of(group->getActiveJointModelNames().cbegin(), group->getActiveJointModelNames().cend(),
+                    [&goal_joints](const std::string& joint_name) {
+                      return std::find(goal_joints.cbegin(), goal_joints.cend(), joint_name) != goal_joints.cend();
+                    });
+    group_state->second.zeroVelocities();
+    group_state->second.zeroAccelerations();
+  }
+  return start_states;
+}
+
+planning_interface::MotionPlanResponse
+CommandListManager::solveSequenceItem(const planning_scene::PlanningSceneConstPtr& planning_scene,
+                                      const planning_pipeline::PlanningPipelinePtr& planning_pipeline,
+                                      const moveit_msgs::MotionSequenceItem& seq_item,
+                                      const MotionResponseCont& motion_plan_responses) const
+{
+  planning_interface::MotionPlanRequest req{ seq_item.req };
+  setStartState(motion_plan_responses, req.group_name, req.start_state);
+
+  planning_interface::MotionPlanResponse res;
+  planning_pipeline->generatePlan(planning_scene, req, res);
+  if (res.error_code_.val != res.error_code_.SUCCESS)
+  {
+    std::ostringstream os;
+    os << "Could not solve request\n---\n" << req << "\n---\n";
+    throw PlanningPipelineException(os.str(), res.error_code_.val);
+  }
+  return res;
+}
+
 void CommandListManager::checkForNegativeRadii(const moveit_msgs::MotionSequenceRequest& req_list)
 {
   if (!std::all_of(req_list.items.begin(), req_list.items.end(),
@@ -35,7 +35,9 @@
 #include "pilz_industrial_motion_planner/plan_components_builder.h"
 
 #include <cassert>
+#include <exception>
 
+#include "pilz_industrial_motion_planner/parallel_for.h"
 #include "pilz_industrial_motion_planner/tip_frame_getter.h"
 
 namespace pilz_industrial_motion_planner
@@ -51,6 +53,33 @@ std::vector<robot_trajectory::RobotTrajectoryPtr> PlanComponentsBuilder::build()
   return res_vec;
 }
 
+std::vector<robot_trajectory::RobotTrajectoryPtr> PlanComponentsBuilder::extractNewSegments()
+{
+  std::vector<robot_trajectory::RobotTrajectoryPtr> segments;
+  while (extracted_elements_ < traj_cont_.size())
+  {
+    const robot_trajectory::RobotTrajectory& element{ *traj_cont_.at(extracted_elements_) };
+    if (extracted_waypoints_ < element.getWayPointCount())
+    {
+      segments.emplace_back(new robot_trajectory::RobotTrajectory(model_, element.getGroupName()));
+      for (size_t i = extracted_waypoints_; i < element.getWayPointCount(); ++i)
+      {
+        segments.back()->addSuffixWayPoint(element.getWayPoint(i), element.getWayPointDurationFromPrevious(i));
+      }
+      extracted_waypoints_ = element.getWayPointCount();
+    }
+
+    // The last element still grows with the following append calls
+    if (extracted_elements_ + 1 == traj_cont_.size())
+    {
+      break;
+    }
+    ++extracted_elements_;
+    extracted_waypoints_ = 0;
+  }
+  return segments;
+}
+
 void PlanComponentsBuilder::appendWithStrictTimeIncrease(robot_trajectory::RobotTrajectory& result,
                                                          const robot_trajectory::RobotTrajectory& source)
 {
@@ -78,22 +107,59 @@ void PlanComponentsBuilder::blend(const planning_scene::PlanningSceneConstPtr& p
 
   assert(other->getGroupName() == traj_tail_->getGroupName());
 
+  pilz_industrial_motion_planner::TrajectoryBlendResponse blend_response;
+  if (!computeBlend(planning_scene, traj_tail_, other, blend_radius, blend_response))
+  {
+    throw BlendingFailedException("Blending failed");
+  }
+  appendBlend(*traj_tail_, blend_response);
+}
+
+bool PlanComponentsBuilder::isBlended(const robot_trajectory::RobotTrajectoryPtr& other,
+                                      const double blend_radius) const
+{
+  return traj_tail_ && other->getGroupName() == traj_tail_->getGroupName() && blend_radius > 0.0;
+}
+
+bool PlanComponentsBuilder::computeBlend(const planning_scene::PlanningSceneConstPtr& planning_scene,
+                                         const robot_trajectory::RobotTrajectoryPtr& first,
+                                         const robot_trajectory::RobotTrajectoryPtr& second, const double blend_radius,
+                                         pilz_industrial_motion_planner::TrajectoryBlendResponse& blend_response) const
+{
   pilz_industrial_motion_planner::TrajectoryBlendRequest blend_request;
 
-  blend_request.first_trajectory = traj_tail_;
-  blend_request.second_trajectory = other;
+  blend_request.first_trajectory = first;
+  blend_request.second_trajectory = second;
   blend_request.blend_radius = blend_radius;
-  blend_request.group_name = traj_tail_->getGroupName();
+  blend_request.group_name = first->getGroupName();
   blend_request.link_name = getSolverTipFrame(model_->getJointModelGroup(blend_request.group_name));
 
-  pilz_industrial_motion_planner::TrajectoryBlendResponse blend_response;
-  if (!blender_->blend(planning_scene, blend_request, blend_response))
-  {
-    throw BlendingFailedException("Blending failed");
-  }
+  return blender_->blend(planning_scene, blend_request, blend_response);
+}
+
+void PlanComponentsBuilder::appendBlend(const robot_trajectory::RobotTrajectory& blended_first,
+                                        const pilz_industrial_motion_planner::TrajectoryBlendResponse& blend_response)
+{
+  // Number of waypoints at the start of the blended trajectory which the
+  // previous blend already replaced
+  const size_t replaced{ blended_first.getWayPointCount() - traj_tail_->getWayPointCount() };
 
   // Append the new trajectory elements
-  appendWithStrictTimeIncrease(*(traj_cont_.back()), *blend_response.first_trajectory);
+  if (replaced == 0)
+  {
+    appendWithStrictTimeIncrease(*(traj_cont_.back()), *blend_response.first_trajectory);
+  }
+  else
+  {
+    robot_trajectory::RobotTrajectory first_part(model_, traj_tail_->getGroupName());
+    for (size_t i = replaced; i < blend_response.first_trajectory->getWayPointCount(); ++i)
+    {
+      first_part.addSuffixWayPoint(blend_response.first_trajectory->getWayPoint(i),
+                                   i == replaced ? traj_tail_->getWayPointDurationFromPrevious(0) :
+                                                   blend_response.first_trajectory->getWayPointDurationFromPrevious(i));
+    }
+    appendWithStrictTimeIncrease(*(traj_cont_.back()), first_part);
+  }
   traj_cont_.back()->append(*blend_response.blend_trajectory, 0.0);
   // Store the last new trajectory element for future processing
   traj_tail_ = blend_response.second_trajectory;  // first for next blending segment
@@ -136,4 +202,73 @@ void PlanComponentsBuilder::append(const planning_scene::PlanningSceneConstPtr&
   blend(planning_scene, other, blend_radius);
 }
 
+void PlanComponentsBuilder::append(const planning_scene::PlanningSceneConstPtr& planning_scene,
+                                   const std::vector<robot_trajectory::RobotTrajectoryPtr>& others,
+                                   const std::vector<double>& blend_radii, unsigned int num_threads)
+{
+  assert(others.size() == blend_radii.size());
+  if (!model_)
+  {
+    throw NoRobotModelSetException("No robot model set");
+  }
+
+  // Trajectory each blend starts with, before any blend replaced its start
+  std::vector<robot_trajectory::RobotTrajectoryPtr> firsts(others.size());
+  for (size_t i = 0; i < others.size(); ++i)
+  {
+    firsts.at(i) = (i > 0 ? others.at(i - 1) : traj_tail_);
+    const bool is_blended{ firsts.at(i) && others.at(i)->getGroupName() == firsts.at(i)->getGroupName() &&
+                           blend_radii.at(i) > 0.0 };
+    if (!is_blended)
+    {
+      firsts.at(i) = nullptr;
+    }
+    else if (!blender_)
+    {
+      throw NoBlenderSetException("No blender set");
+    }
+  }
+
+  // As the blend radii do not overlap, the blends are independent of each
+  // other and can be computed from the trajectories before blending
+  std::vector<pilz_industrial_motion_planner::TrajectoryBlendResponse> blend_responses(others.size());
+  std::unique_ptr<bool[]> blend_succeeded(new bool[others.size()]());
+  std::vector<std::exception_ptr> blend_exceptions(others.size());
+  parallelFor(others.size(), num_threads, [&](size_t i) {
+    if (!firsts.at(i))
+    {
+      return;
+    }
+    try
+    {
+      blend_succeeded[i] = computeBlend(planning_scene, firsts.at(i), others.at(i), blend_radii.at(i),
+                                        blend_responses.at(i));
+    }
+    catch (...)
+    {
+      blend_exceptions.at(i) = std::current_exception();
+    }
+  });
+
+  for (size_t i = 0; i < others.size(); ++i)
+  {
+    if (!firsts.at(i))
+    {
+      append(planning_scene, others.at(i), 0.0);
+      continue;
+    }
+
+    assert(isBlended(others.at(i), blend_radii.at(i)));
+    if (blend_exceptions.at(i))
+    {
+      std::rethrow_exception(blend_exceptions.at(i));
+    }
+    if (!blend_succeeded[i])
+    {
+      throw BlendingFailedException("Blending failed");
+    }
+    appendBlend(*firsts.at(i), blend_responses.at(i));
+  }
+}
+
 }  // namespace pilz_industrial_motion_planner
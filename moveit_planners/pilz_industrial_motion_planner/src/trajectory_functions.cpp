@@ -40,6 +40,128 @@
 #include <tf2_kdl/tf2_kdl.h>
 #include <tf2_geometry_msgs/tf2_geometry_msgs.h>
 
+#include <thread>
+
+namespace
+{
+/// Maximal number of damped least squares steps of the local IK before the IK solver is used
+const std::size_t LOCAL_IK_MAX_ITERATIONS = 10;
+/// Position [m] and orientation [rad] tolerance of the local IK
+const double LOCAL_IK_TOLERANCE = 1e-6;
+/// Damping of the least squares steps, keeps the steps bounded close to singularities
+const double LOCAL_IK_DAMPING = 1e-4;
+
+/**
+ * @brief Moves the group from its current positions to the given pose by damped least squares steps
+ * on the Jacobian. Converges within a few steps if the pose is close to the current pose of the link,
+ * as it is the case for consecutive samples of a Cartesian trajectory. Keeps the IK branch of the
+ * current positions.
+ * @return true if the pose is reached within LOCAL_IK_TOLERANCE and the joint limits are satisfied.
+ */
+bool computeLocalPoseIK(robot_state::RobotState& rstate, const robot_state::JointModelGroup* group,
+                        const robot_state::LinkModel* link, const Eigen::Isometry3d& pose)
+{
+  // the Jacobian is given relative to the parent link of the chain
+  const robot_state::LinkModel* root_link = group->getJointModels().front()->getParentLinkModel();
+
+  Eigen::VectorXd positions;
+  rstate.copyJointGroupPositions(group, positions);
+  Eigen::MatrixXd jacobian;
+  Eigen::Matrix<double, 6, 1> error;
+  for (std::size_t i = 0; i <= LOCAL_IK_MAX_ITERATIONS; ++i)
+  {
+    rstate.updateLinkTransforms();
+    const Eigen::Isometry3d& current = rstate.getGlobalLinkTransform(link);
+    const Eigen::AngleAxisd rotation_error(pose.linear() * current.linear().transpose());
+    error.head<3>() = pose.translation() - current.translation();
+    error.tail<3>() = rotation_error.angle() * rotation_error.axis();
+    if (error.head<3>().norm() < LOCAL_IK_TOLERANCE && error.tail<3>().norm() < LOCAL_IK_TOLERANCE)
+    {
+      return rstate.satisfiesBounds(group);
+    }
+    if (i == LOCAL_IK_MAX_ITERATIONS || !rstate.getJacobian(group, link, Eigen::Vector3d::Zero(), jacobian))
+    {
+      break;
+    }
+
+    if (root_link)
+    {
+      const Eigen::Matrix3d root_rotation = rstate.getGlobalLinkTransform(root_link).linear().transpose();
+      error.head<3>() = root_rotation * error.head<3>();
+      error.tail<3>() = root_rotation * error.tail<3>();
+    }
+    Eigen::MatrixXd jjt = jacobian * jacobian.transpose();
+    jjt.diagonal().array() += LOCAL_IK_DAMPING * LOCAL_IK_DAMPING;
+    positions += jacobian.transpose() * jjt.ldlt().solve(error);
+    rstate.setJointGroupPositions(group, positions);
+  }
+  return false;
+}
+
+/**
+ * @brief Computes the IK solution of one sample of a Cartesian trajectory.
+ *
+ * The state has to hold the solution of the previous sample. The local IK seeded from it is tried
+ * first, the IK solver of the group (analytic, if one is configured) is only called if it does not
+ * converge. No collision checking is done here, see checkSamplesForSelfCollision().
+ * On success, the state holds the solution afterwards.
+ */
+bool computeSamplePoseIK(const planning_scene::PlanningSceneConstPtr& scene, const std::string& group_name,
+                         const std::string& link_name, const Eigen::Isometry3d& pose, robot_state::RobotState& rstate,
+                         const std::map<std::string, double>& seed, std::map<std::string, double>& solution)
+{
+  const moveit::core::RobotModelConstPtr& robot_model = scene->getRobotModel();
+  const robot_state::JointModelGroup* group = robot_model->getJointModelGroup(group_name);
+  const bool local_ik_possible = group && group->isChain() && group->isLinkUpdated(link_name);
+
+  if (!local_ik_possible || !computeLocalPoseIK(rstate, group, robot_model->getLinkModel(link_name), pose))
+  {
+    if (!pilz_industrial_motion_planner::computePoseIK(scene, group_name, link_name, pose,
+                                                       robot_model->getModelFrame(), seed, solution, false))
+    {
+      return false;
+    }
+    rstate.setVariablePositions(solution);
+    rstate.update();
+    return true;
+  }
+
+  for (const auto& joint_name : group->getActiveJointModelNames())
+  {
+    solution[joint_name] = rstate.getVariablePosition(joint_name);
+  }
+  return true;
+}
+
+/**
+ * @brief Checks the sampled states for self collision in one batch distributed over all cores.
+ * @return true if none of the states is in self collision
+ */
+bool checkSamplesForSelfCollision(const planning_scene::PlanningSceneConstPtr& scene, const std::string& group_name,
+                                  const std::vector<robot_state::RobotState>& sample_states)
+{
+  std::vector<const robot_state::RobotState*> states;
+  states.reserve(sample_states.size());
+  for (const auto& state : sample_states)
+  {
+    states.push_back(&state);
+  }
+
+  std::vector<bool> colliding;
+  scene->getCollisionEnvUnpadded()->isSelfColliding(states, scene->getAllowedCollisionMatrix(), colliding, group_name,
+                                                    std::max(1u, std::thread::hardware_concurrency()));
+  for (std::size_t i = 0; i < colliding.size(); ++i)
+  {
+    if (colliding[i])
+    {
+      ROS_ERROR_STREAM("The " << i << "th sample of the trajectory is in self collision.");
+      return false;
+    }
+  }
+  return true;
+}
+}  // namespace
+
 bool pilz_industrial_motion_planner::computePoseIK(const planning_scene::PlanningSceneConstPtr& scene,
                                                    const std::string& group_name, const std::string& link_name,
                                                    const Eigen::Isometry3d& pose, const std::string& frame_id,
@@ -226,13 +348,19 @@ bool pilz_industrial_motion_planner::generateJointTrajectory(
     joint_velocity_last[item.first] = 0.0;
   }
 
+  // holds the solution of the last sample, which seeds the IK of the next one
+  robot_state::RobotState rstate(robot_model);
+  rstate.setToDefaultValues();
+  rstate.setVariablePositions(initial_joint_position);
+  rstate.update();
+  std::vector<robot_state::RobotState> sample_states;
+
   for (std::vector<double>::const_iterator time_iter = time_samples.begin(); time_iter != time_samples.end();
        ++time_iter)
   {
     tf2::fromMsg(tf2::toMsg(trajectory.Pos(*time_iter)), pose_sample);
 
-    if (!computePoseIK(scene, group_name, link_name, pose_sample, robot_model->getModelFrame(), ik_solution_last,
-                       ik_solution, check_self_collision))
+    if (!computeSamplePoseIK(scene, group_name, link_name, pose_sample, rstate, ik_solution_last, ik_solution))
     {
       ROS_ERROR("Failed to compute inverse kinematics solution for sampled "
                 "Cartesian pose.");
@@ -300,6 +428,17 @@ bool pilz_industrial_motion_planner::generateJointTrajectory(
     // update joint trajectory
     joint_trajectory.points.push_back(point);
     ik_solution_last = ik_solution;
+    if (check_self_collision)
+    {
+      sample_states.push_back(rstate);
+    }
+  }
+
+  if (check_self_collision && !checkSamplesForSelfCollision(scene, group_name, sample_states))
+  {
+    error_code.val = moveit_msgs::MoveItErrorCodes::NO_IK_SOLUTION;
+    joint_trajectory.points.clear();
+    return false;
   }
 
   error_code.val = moveit_msgs::MoveItErrorCodes::SUCCESS;
@@ -334,11 +473,20 @@ bool pilz_industrial_motion_planner::generateJointTrajectory(
     joint_trajectory.joint_names.push_back(joint_position.first);
   }
   std::map<std::string, double> ik_solution;
+
+  // holds the solution of the last sample, which seeds the IK of the next one
+  robot_state::RobotState rstate(robot_model);
+  rstate.setToDefaultValues();
+  rstate.setVariablePositions(initial_joint_position);
+  rstate.update();
+  std::vector<robot_state::RobotState> sample_states;
+
+  Eigen::Isometry3d pose_sample;
   for (size_t i = 0; i < trajectory.points.size(); ++i)
   {
     // compute inverse kinematics
-    if (!computePoseIK(scene, group_name, link_name, trajectory.points.at(i).pose, robot_model->getModelFrame(),
-                       ik_solution_last, ik_solution, check_self_collision))
+    tf2::fromMsg(trajectory.points.at(i).pose, pose_sample);
+    if (!computeSamplePoseIK(scene, group_name, link_name, pose_sample, rstate, ik_solution_last, ik_solution))
     {
       ROS_ERROR("Failed to compute inverse kinematics solution for sampled "
                 "Cartesian pose.");
@@ -393,6 +541,17 @@ bool pilz_industrial_motion_planner::generateJointTrajectory(
     joint_trajectory.points.push_back(waypoint_joint);
     ik_solution_last = ik_solution;
     duration_last = duration_current;
+    if (check_self_collision)
+    {
+      sample_states.push_back(rstate);
+    }
+  }
+
+  if (check_self_collision && !checkSamplesForSelfCollision(scene, group_name, sample_states))
+  {
+    error_code.val = moveit_msgs::MoveItErrorCodes::NO_IK_SOLUTION;
+    joint_trajectory.points.clear();
+    return false;
   }
 
   error_code.val = moveit_msgs::MoveItErrorCodes::SUCCESS;
@@ -353,6 +353,81 @@ TEST_F(IntegrationTestCommandListManager, blendTwoSegments)
   pub.publish(display_trajectory);
 }
 
+/**
+ * @brief Tests that the streaming solve passes on the result in segments.
+ *
+ *  - Test Sequence:
+ *    1. Solve a blended sequence with and without streaming.
+ *
+ *  - Expected Results:
+ *    1. More than one segment is passed on. Concatenated, the segments
+ *       have the waypoints and durations of the result trajectory.
+ */
+TEST_F(IntegrationTestCommandListManager, streamSegments)
+{
+  Sequence seq{ data_loader_->getSequence("ComplexSequence") };
+  ASSERT_GE(seq.size(), 3u);
+  moveit_msgs::MotionSequenceRequest req{ seq.toRequest() };
+
+  RobotTrajCont segments;
+  RobotTrajCont res_vec{ manager_->solve(
+      scene_, pipeline_, req,
+      [&segments](const robot_trajectory::RobotTrajectoryPtr& segment) { segments.push_back(segment); }) };
+  ASSERT_EQ(res_vec.size(), 1u);
+  EXPECT_GT(segments.size(), 1u);
+
+  size_t waypoint_index{ 0 };
+  for (const auto& segment : segments)
+  {
+    for (size_t i = 0; i < segment->getWayPointCount(); ++i, ++waypoint_index)
+    {
+      ASSERT_LT(waypoint_index, res_vec.front()->getWayPointCount());
+      EXPECT_NEAR(segment->getWayPointDurationFromPrevious(i),
+                  res_vec.front()->getWayPointDurationFromPrevious(waypoint_index), 1e-9);
+    }
+  }
+  EXPECT_EQ(waypoint_index, res_vec.front()->getWayPointCount());
+
+  RobotTrajCont blocking_res_vec{ manager_->solve(scene_, pipeline_, req) };
+  ASSERT_EQ(blocking_res_vec.size(), 1u);
+  EXPECT_EQ(blocking_res_vec.front()->getWayPointCount(), res_vec.front()->getWayPointCount());
+}
+
+/**
+ * @brief Tests that planning a sequence in parallel gives the same result as
+ * planning it one item after another.
+ *
+ *  - Test Sequence:
+ *    1. Solve a blended sequence with a manager using one and four threads.
+ *
+ *  - Expected Results:
+ *    1. Both results have the same waypoints and durations.
+ */
+TEST_F(IntegrationTestCommandListManager, parallelSequencePlanning)
+{
+  Sequence seq{ data_loader_->getSequence("ComplexSequence") };
+  ASSERT_GE(seq.size(), 3u);
+  moveit_msgs::MotionSequenceRequest req{ seq.toRequest() };
+
+  RobotTrajCont res_vec{ manager_->solve(scene_, pipeline_, req) };
+
+  ph_.setParam("sequence_planning_threads", 4);
+  CommandListManager parallel_manager(ph_, robot_model_);
+  ph_.deleteParam("sequence_planning_threads");
+  RobotTrajCont parallel_res_vec{ parallel_manager.solve(scene_, pipeline_, req) };
+
+  ASSERT_EQ(res_vec.size(), 1u);
+  ASSERT_EQ(parallel_res_vec.size(), 1u);
+  ASSERT_EQ(parallel_res_vec.front()->getWayPointCount(), res_vec.front()->getWayPointCount());
+  for (size_t i = 0; i < res_vec.front()->getWayPointCount(); ++i)
+  {
+    EXPECT_NEAR(parallel_res_vec.front()->getWayPointDurationFromPrevious(i),
+                res_vec.front()->getWayPointDurationFromPrevious(i), 1e-9);
+    EXPECT_TRUE(isRobotStateEqual(parallel_res_vec.front()->getWayPoint(i), res_vec.front()->getWayPoint(i),
+                                  res_vec.front()->getGroupName(), 1e-4));
+  }
+}
+
 // ------------------
 // FAILURE cases
 // ------------------
@@ -122,6 +122,20 @@ TEST_F(IntegrationTestPlanComponentBuilder, TestNoBlenderSet)
   EXPECT_THROW(builder.append(planning_scene_, traj, 1.0), NoBlenderSetException);
 }
 
+/**
+ * @brief Checks that exception is thrown if no blender is set and the
+ * trajectories are appended at once.
+ *
+ */
+TEST_F(IntegrationTestPlanComponentBuilder, TestNoBlenderSetParallel)
+{
+  robot_trajectory::RobotTrajectoryPtr traj{ new robot_trajectory::RobotTrajectory(robot_model_, planning_group_) };
+  PlanComponentsBuilder builder;
+  builder.setModel(robot_model_);
+
+  EXPECT_THROW(builder.append(planning_scene_, { traj, traj }, { 0.0, 1.0 }, 2), NoBlenderSetException);
+}
+
 int main(int argc, char** argv)
 {
   ros::init(argc, argv, "integrationtest_plan_components_builder");
@@ -54,6 +54,7 @@
 #include <moveit_msgs/RobotTrajectory.h>
 #include <tf2_eigen/tf2_eigen.h>
 #include <tf2_geometry_msgs/tf2_geometry_msgs.h>
+#include <tf2_kdl/tf2_kdl.h>
 
 #include "pilz_industrial_motion_planner/cartesian_trajectory.h"
 #include "pilz_industrial_motion_planner/cartesian_trajectory_point.h"
@@ -716,6 +717,69 @@ TEST_P(TrajectoryFunctionsTestFlangeAndGripper, testGenerateJointTrajectoryWithI
       joint_trajectory, error_code, check_self_collision));
 }
 
+/**
+ * @brief Check that the joint trajectory generated from a Cartesian line
+ * reaches all sampled poses, while the IK of the samples is seeded from the
+ * previous sample and the self collision is checked after sampling.
+ *
+ * Test Sequence:
+ *    1. Generate a joint trajectory from a short line starting at a bent
+ * configuration of the robot.
+ *    2. Compute the forward kinematics of every joint trajectory point.
+ *
+ * Expected Results:
+ *    1. Function returns 'true'.
+ *    2. Every point matches the Cartesian pose of its time sample.
+ */
+TEST_P(TrajectoryFunctionsTestFlangeAndGripper, testGenerateJointTrajectoryReachesSampledPoses)
+{
+  std::map<std::string, double> initial_joint_position = zero_state_;
+  initial_joint_position[joint_names_.at(1)] = 0.3;
+  initial_joint_position[joint_names_.at(2)] = 0.8;
+  initial_joint_position[joint_names_.at(4)] = 0.6;
+
+  Eigen::Isometry3d start_pose;
+  ASSERT_TRUE(
+      pilz_industrial_motion_planner::computeLinkFK(robot_model_, tcp_link_, initial_joint_position, start_pose));
+  Eigen::Isometry3d goal_pose = start_pose;
+  goal_pose.translation() += Eigen::Vector3d(0.05, 0.02, -0.03);
+
+  KDL::Frame kdl_start_pose, kdl_goal_pose;
+  tf2::fromMsg(tf2::toMsg(start_pose), kdl_start_pose);
+  tf2::fromMsg(tf2::toMsg(goal_pose), kdl_goal_pose);
+  // Note: 'path' is deleted by KDL::Trajectory_Segment
+  KDL::Path_RoundedComposite* path =
+      new KDL::Path_RoundedComposite(0.2, 0.01, new KDL::RotationalInterpolation_SingleAxis());
+  path->Add(kdl_start_pose);
+  path->Add(kdl_goal_pose);
+  path->Finish();
+  // Note: 'velprof' is deleted by KDL::Trajectory_Segment
+  KDL::VelocityProfile* vel_prof = new KDL::VelocityProfile_Trap(0.5, 0.1);
+  vel_prof->SetProfile(0, path->PathLength());
+  KDL::Trajectory_Segment kdl_trajectory(path, vel_prof);
+
+  pilz_industrial_motion_planner::JointLimitsContainer joint_limits;
+  double sampling_time{ 0.01 };
+  trajectory_msgs::JointTrajectory joint_trajectory;
+  moveit_msgs::MoveItErrorCodes error_code;
+  bool check_self_collision{ true };
+
+  ASSERT_TRUE(pilz_industrial_motion_planner::generateJointTrajectory(
+      planning_scene_, joint_limits, kdl_trajectory, planning_group_, tcp_link_, initial_joint_position, sampling_time,
+      joint_trajectory, error_code, check_self_collision));
+  EXPECT_EQ(moveit_msgs::MoveItErrorCodes::SUCCESS, error_code.val);
+  ASSERT_GT(joint_trajectory.points.size(), 2u);
+
+  for (const auto& point : joint_trajectory.points)
+  {
+    Eigen::Isometry3d pose_expect, pose_actual;
+    tf2::fromMsg(tf2::toMsg(kdl_trajectory.Pos(point.time_from_start.toSec())), pose_expect);
+    ASSERT_TRUE(pilz_industrial_motion_planner::computeLinkFK(robot_model_, tcp_link_, joint_trajectory.joint_names,
+                                                              point.positions, pose_actual));
+    EXPECT_TRUE(tfNear(pose_expect, pose_actual, 1.0e-4));
+  }
+}
+
 /**
  * @brief Check that function determineAndCheckSamplingTime() returns 'false' if
  * both of the needed vectors have an incorrect vector size.
@@ -37,6 +37,8 @@
 #pragma once
 
 #include <boost/thread.hpp>
+#include <cstddef>
+#include <vector>
 
 namespace sbpl_interface
 {
@@ -60,6 +62,8 @@ private:
   volatile bool running;
 
   void search(int, int, int volatile*, int*, int&, int&);
+  void searchParallel(unsigned int);
+  void expandWavefront(const std::vector<int>&, std::size_t, std::size_t, int, std::vector<int>&);
   inline int getNode(int, int, int);
 
 public:
@@ -73,6 +77,14 @@ public:
 
   void run(int, int, int);
 
+  // Runs the search to completion before returning, the wavefront of each distance is
+  // expanded by up to the given number of threads (0 uses all cores)
+  void run(int, int, int, unsigned int);
+
   int getDistance(int, int, int);
+
+  // Identifies grids with the same walls, so finished searches can be reused
+  std::size_t getWallHash() const;
+  bool hasSameWalls(const BFS_3D&) const;
 };
 }  // namespace sbpl_interface
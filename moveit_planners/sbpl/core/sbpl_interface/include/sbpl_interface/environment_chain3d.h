@@ -82,6 +82,7 @@ struct PlanningParameters
     , attempt_full_shortcut_(true)
     , interpolation_distance_(DEFAULT_INTERPOLATION_DISTANCE)
     , joint_motion_primitive_distance_(DEFAULT_JOINT_MOTION_PRIMITIVE_DISTANCE)
+    , num_threads_(0)
   {
   }
 
@@ -90,6 +91,8 @@ struct PlanningParameters
   bool attempt_full_shortcut_;
   double interpolation_distance_;
   double joint_motion_primitive_distance_;
+  // threads for the BFS heuristic and the collision checks of successors, 0 uses all cores
+  unsigned int num_threads_;
 };
 
 /** Environment to be used when planning for a Robotic Arm using the SBPL. */
@@ -242,7 +245,7 @@ protected:
   planning_scene::PlanningSceneConstPtr planning_scene_;
 
   double angle_discretization_;
-  BFS_3D* bfs_;
+  boost::shared_ptr<BFS_3D> bfs_;
 
   std::vector<boost::shared_ptr<JointMotionWrapper> > joint_motion_wrappers_;
   std::vector<boost::shared_ptr<JointMotionPrimitive> > possible_actions_;
@@ -261,6 +264,9 @@ protected:
   PlanningParameters planning_parameters_;
   int maximum_distance_for_motion_;
 
+  // template for the states of successors checked in parallel, holds the start state
+  moveit::core::RobotStatePtr succ_state_template_;
+
   planning_models::RobotState* interpolation_state_1_;
   planning_models::RobotState* interpolation_state_2_;
   planning_models::RobotState* interpolation_state_temp_;
@@ -275,6 +281,11 @@ protected:
   void convertCoordToJointAngles(const std::vector<int>& coord, std::vector<double>& angles);
   void convertJointAnglesToCoord(const std::vector<double>& angle, std::vector<int>& coord);
 
+  void runBFS(const int (&goal_xyz)[3]);
+
+  void checkSuccessorsForCollision(const std::vector<std::vector<double> >& succ_joint_angles,
+                                   const std::vector<bool>& generated, std::vector<bool>& colliding);
+
   int calculateCost(EnvChain3DHashEntry* HashEntry1, EnvChain3DHashEntry* HashEntry2);
   int getBFSCostToGoal(int x, int y, int z) const;
   int getEndEffectorHeuristic(int FromStateID, int ToStateID);
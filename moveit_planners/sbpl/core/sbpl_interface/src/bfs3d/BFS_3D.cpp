@@ -33,6 +33,8 @@
  *********************************************************************/
 
 #include <sbpl_interface/bfs3d/BFS_3D.h>
+#include <boost/functional/hash.hpp>
+#include <algorithm>
 
 namespace sbpl_interface
 {
@@ -138,6 +140,25 @@ void BFS_3D::run(int x, int y, int z)
   running = true;
 }
 
+void BFS_3D::run(int x, int y, int z, unsigned int threads)
+{
+  if (running)
+  {
+    // error "Search already running"
+    return;
+  }
+
+  for (int i = 0; i < dim_xyz; i++)
+    if (distance_grid[i] != WALL)
+      distance_grid[i] = UNDISCOVERED;
+
+  origin = getNode(x, y, z);
+  distance_grid[origin] = 0;
+
+  running = true;
+  searchParallel(threads == 0 ? std::max(1u, boost::thread::hardware_concurrency()) : threads);
+}
+
 int BFS_3D::getDistance(int x, int y, int z)
 {
   int node = getNode(x, y, z);
@@ -145,4 +166,26 @@ int BFS_3D::getDistance(int x, int y, int z)
     ;
   return distance_grid[node];
 }
+
+std::size_t BFS_3D::getWallHash() const
+{
+  std::size_t hash = 0;
+  boost::hash_combine(hash, dim_x);
+  boost::hash_combine(hash, dim_y);
+  boost::hash_combine(hash, dim_z);
+  for (int i = 0; i < dim_xyz; i++)
+    if (distance_grid[i] == WALL)
+      boost::hash_combine(hash, i);
+  return hash;
+}
+
+bool BFS_3D::hasSameWalls(const BFS_3D& other) const
+{
+  if (dim_x != other.dim_x || dim_y != other.dim_y || dim_z != other.dim_z)
+    return false;
+  for (int i = 0; i < dim_xyz; i++)
+    if ((distance_grid[i] == WALL) != (other.distance_grid[i] == WALL))
+      return false;
+  return true;
+}
 }  // namespace sbpl_interface
@@ -35,6 +35,8 @@
 #include <sbpl_interface/bfs3d/BFS_3D.h>
 #include <iostream>
 #include <boost/thread.hpp>
+#include <algorithm>
+#include <boost/bind.hpp>
 
 namespace sbpl_interface
 {
@@ -83,4 +85,60 @@ void BFS_3D::search(int width, int planeSize, int volatile* distance_grid, int*
   // std::cerr << "Search thread done" << std::endl;
   running = false;
 }
+
+// Minimal number of wavefront cells per thread, smaller wavefronts are not worth starting threads for
+static const std::size_t MIN_CELLS_PER_THREAD = 2048;
+
+void BFS_3D::expandWavefront(const std::vector<int>& wavefront, std::size_t begin, std::size_t end, int cost,
+                             std::vector<int>& next)
+{
+  const int offsets[26] = { -dim_x, 1, dim_x, -1, -dim_x - 1, -dim_x + 1, dim_x + 1, dim_x - 1,
+                            dim_xy, -dim_x + dim_xy, 1 + dim_xy, dim_x + dim_xy, -1 + dim_xy,
+                            -dim_x - 1 + dim_xy, -dim_x + 1 + dim_xy, dim_x + 1 + dim_xy, dim_x - 1 + dim_xy,
+                            -dim_xy, -dim_x - dim_xy, 1 - dim_xy, dim_x - dim_xy, -1 - dim_xy,
+                            -dim_x - 1 - dim_xy, -dim_x + 1 - dim_xy, dim_x + 1 - dim_xy, dim_x - 1 - dim_xy };
+
+  for (std::size_t i = begin; i < end; i++)
+  {
+    for (int offset : offsets)
+    {
+      int node = wavefront[i] + offset;
+      // several threads may reach the same cell, only the one that discovers it adds it to its wavefront
+      if (distance_grid[node] < 0 && __sync_bool_compare_and_swap(&distance_grid[node], (int)UNDISCOVERED, cost))
+        next.push_back(node);
+    }
+  }
+}
+
+void BFS_3D::searchParallel(unsigned int threads)
+{
+  std::vector<int> wavefront(1, origin);
+  std::vector<std::vector<int> > next(threads);
+  int cost = 0;
+  while (!wavefront.empty())
+  {
+    cost++;
+    std::size_t thread_count =
+        std::min<std::size_t>(threads, (wavefront.size() + MIN_CELLS_PER_THREAD - 1) / MIN_CELLS_PER_THREAD);
+    std::size_t chunk = (wavefront.size() + thread_count - 1) / thread_count;
+
+    boost::thread_group workers;
+    for (std::size_t t = 0; t < thread_count; t++)
+    {
+      next[t].clear();
+      std::size_t begin = t * chunk, end = std::min(wavefront.size(), begin + chunk);
+      if (t + 1 < thread_count)
+        workers.create_thread(
+            boost::bind(&BFS_3D::expandWavefront, this, boost::cref(wavefront), begin, end, cost, boost::ref(next[t])));
+      else
+        expandWavefront(wavefront, begin, end, cost, next[t]);
+    }
+    workers.join_all();
+
+    wavefront.clear();
+    for (std::size_t t = 0; t < thread_count; t++)
+      wavefront.insert(wavefront.end(), next[t].begin(), next[t].end());
+  }
+  running = false;
+}
 }  // namespace sbpl_interface
@@ -39,6 +39,8 @@
 #include <planning_models/conversions.h>
 #include <boost/timer.hpp>
 #include <planning_models/angle_utils.h>
+#include <moveit/robot_state/conversions.h>
+#include <boost/thread/mutex.hpp>
 
 static const unsigned int DEBUG_OVER = 1;
 static const unsigned int PRINT_HEURISTIC_UNDER = 1;
@@ -47,9 +49,20 @@ static const double JOINT_DIST_MULT = 1000.0;
 
 namespace sbpl_interface
 {
+// Finished BFS heuristic grids of previous plans, most recently used first. Repeated plans in the same
+// world towards the same goal cell reuse them instead of searching again.
+struct BFSCacheEntry
+{
+  std::size_t wall_hash;
+  int goal_xyz[3];
+  boost::shared_ptr<BFS_3D> bfs;
+};
+static const std::size_t BFS_CACHE_SIZE = 4;
+static boost::mutex bfs_cache_lock;
+static std::list<BFSCacheEntry> bfs_cache;
+
 EnvironmentChain3D::EnvironmentChain3D(const planning_scene::PlanningSceneConstPtr& planning_scene)
   : planning_scene_(planning_scene)
-  , bfs_(NULL)
   , state_(planning_scene->getCurrentState())
   , planning_data_(StateID2IndexMapping)
   , goal_constraint_set_(planning_scene->getRobotModel(), planning_scene->getTransforms())
@@ -63,10 +76,6 @@ EnvironmentChain3D::EnvironmentChain3D(const planning_scene::PlanningSceneConstP
 
 EnvironmentChain3D::~EnvironmentChain3D()
 {
-  if (bfs_ != NULL)
-  {
-    delete bfs_;
-  }
 }
 
 /////////////////////////////////////////////////////////////////////////////
@@ -185,12 +194,25 @@ void EnvironmentChain3D::GetSuccs(int source_state_ID, std::vector<int>* succ_id
 
   planning_statistics_.total_expansions_++;
 
+  // generate all successors first, so their collision checks can be distributed over threads
+  std::vector<std::vector<double> > generated_joint_angles(possible_actions_.size());
+  std::vector<bool> generated(possible_actions_.size()), colliding;
   for (unsigned int i = 0; i < possible_actions_.size(); i++)
   {
-    if (!possible_actions_[i]->generateSuccessorState(source_joint_angles, succ_joint_angles))
+    generated[i] = possible_actions_[i]->generateSuccessorState(source_joint_angles, generated_joint_angles[i]);
+  }
+  if (planning_parameters_.use_standard_collision_checking_)
+  {
+    checkSuccessorsForCollision(generated_joint_angles, generated, colliding);
+  }
+
+  for (unsigned int i = 0; i < possible_actions_.size(); i++)
+  {
+    if (!generated[i])
     {
       continue;
     }
+    succ_joint_angles = generated_joint_angles[i];
 
     // for(unsigned int j = 0; j < planning_data_.goal_hash_entry_->angles.size(); j++) {
     //   if(joint_is_continuous_[j]) {
@@ -241,27 +263,28 @@ void EnvironmentChain3D::GetSuccs(int source_state_ID, std::vector<int>* succ_id
     //   //std::cerr << "Successor doesn't satisfy bounds" << std::endl;
     //   continue;
     // }
-    ros::WallTime before_coll = ros::WallTime::now();
-    collision_detection::CollisionRequest req;
-    collision_detection::CollisionResult res;
-    req.group_name = planning_group_;
     if (!planning_parameters_.use_standard_collision_checking_)
     {
+      // the distance field checks share gsr_, so they stay serial
+      ros::WallTime before_coll = ros::WallTime::now();
+      collision_detection::CollisionRequest req;
+      collision_detection::CollisionResult res;
+      req.group_name = planning_group_;
       hy_env_->checkCollisionDistanceField(req, res, *hy_env_->getCollisionRobotDistanceField().get(), state_, gsr_);
+      planning_statistics_.coll_checks_++;
+      // std::cerr << "Elapsed " << t.elapsed() << std::endl;
+      ros::WallDuration dur(ros::WallTime::now() - before_coll);
+      // std::cerr << dur.toSec() << std::endl;
+      // ROS_DEBUG_STREAM("Time " << ros::WallTime::now()-before_coll);
+      planning_statistics_.total_coll_check_time_ += dur;
+      if (res.collision)
+      {
+        // std::cerr << "Successor in collision" << std::endl;
+        continue;
+      }
     }
-    else
+    else if (colliding[i])
     {
-      planning_scene_->checkCollision(req, res, state_);
-    }
-    planning_statistics_.coll_checks_++;
-    // std::cerr << "Elapsed " << t.elapsed() << std::endl;
-    ros::WallDuration dur(ros::WallTime::now() - before_coll);
-    // std::cerr << dur.toSec() << std::endl;
-    // ROS_DEBUG_STREAM("Time " << ros::WallTime::now()-before_coll);
-    planning_statistics_.total_coll_check_time_ += dur;
-    if (res.collision)
-    {
-      // std::cerr << "Successor in collision" << std::endl;
       continue;
     }
 
@@ -459,6 +482,9 @@ bool EnvironmentChain3D::setupForMotionPlan(const planning_scene::PlanningSceneC
 
   planning_models::robotStateMsgToRobotState(*planning_scene->getTransforms(), mreq.motion_plan_request.start_state,
                                              state_);
+  succ_state_template_.reset(new moveit::core::RobotState(planning_scene->getCurrentState()));
+  moveit::core::robotStateMsgToRobotState(*planning_scene->getTransforms(), mreq.motion_plan_request.start_state,
+                                          *succ_state_template_);
   joint_state_group_ = state_.getJointStateGroup(planning_group_);
   interpolation_joint_state_group_1_ = interpolation_state_1_.getJointStateGroup(planning_group_);
   interpolation_joint_state_group_2_ = interpolation_state_2_.getJointStateGroup(planning_group_);
@@ -500,8 +526,8 @@ bool EnvironmentChain3D::setupForMotionPlan(const planning_scene::PlanningSceneC
   }
   if (!planning_parameters_.use_standard_collision_checking_ && planning_parameters_.use_bfs_)
   {
-    bfs_ = new BFS_3D(gsr_->dfce_->distance_field_->getXNumCells(), gsr_->dfce_->distance_field_->getYNumCells(),
-                      gsr_->dfce_->distance_field_->getZNumCells());
+    bfs_.reset(new BFS_3D(gsr_->dfce_->distance_field_->getXNumCells(), gsr_->dfce_->distance_field_->getYNumCells(),
+                          gsr_->dfce_->distance_field_->getZNumCells()));
 
     boost::shared_ptr<const distance_field::DistanceField> world_distance_field =
         hy_env_->getCollisionWorldDistanceField()->getDistanceField();
@@ -624,7 +650,7 @@ bool EnvironmentChain3D::setupForMotionPlan(const planning_scene::PlanningSceneC
   // std::cerr << "Running bfs with goal " << goal_xyz[0] << " " <<  goal_xyz[1] << " " << goal_xyz[2] << std::endl;
   if (planning_parameters_.use_bfs_)
   {
-    bfs_->run(goal_xyz[0], goal_xyz[1], goal_xyz[2]);
+    runBFS(goal_xyz);
     // std::cerr << "Got start " << start_xyz[0] << " " <<  start_xyz[1] << " " << start_xyz[2] << " cost "
     //           << getBFSCostToGoal(start_xyz[0], start_xyz[1], start_xyz[2]) << std::endl;
   }
@@ -636,6 +662,81 @@ bool EnvironmentChain3D::setupForMotionPlan(const planning_scene::PlanningSceneC
   return true;
 }
 
+void EnvironmentChain3D::runBFS(const int (&goal_xyz)[3])
+{
+  std::size_t wall_hash = bfs_->getWallHash();
+  {
+    boost::mutex::scoped_lock slock(bfs_cache_lock);
+    for (std::list<BFSCacheEntry>::iterator it = bfs_cache.begin(); it != bfs_cache.end(); ++it)
+    {
+      if (it->wall_hash == wall_hash && std::equal(goal_xyz, goal_xyz + 3, it->goal_xyz) &&
+          it->bfs->hasSameWalls(*bfs_))
+      {
+        ROS_DEBUG_STREAM("Reusing BFS heuristic of a previous plan");
+        bfs_ = it->bfs;
+        bfs_cache.splice(bfs_cache.begin(), bfs_cache, it);
+        return;
+      }
+    }
+  }
+
+  bfs_->run(goal_xyz[0], goal_xyz[1], goal_xyz[2], planning_parameters_.num_threads_);
+
+  boost::mutex::scoped_lock slock(bfs_cache_lock);
+  BFSCacheEntry entry;
+  entry.wall_hash = wall_hash;
+  std::copy(goal_xyz, goal_xyz + 3, entry.goal_xyz);
+  entry.bfs = bfs_;
+  bfs_cache.push_front(entry);
+  if (bfs_cache.size() > BFS_CACHE_SIZE)
+  {
+    bfs_cache.pop_back();
+  }
+}
+
+void EnvironmentChain3D::checkSuccessorsForCollision(const std::vector<std::vector<double> >& succ_joint_angles,
+                                                     const std::vector<bool>& generated, std::vector<bool>& colliding)
+{
+  ros::WallTime before_coll = ros::WallTime::now();
+  const moveit::core::JointModelGroup* group = succ_state_template_->getJointModelGroup(planning_group_);
+
+  std::vector<unsigned int> indices;
+  std::vector<moveit::core::RobotState> succ_states;
+  for (unsigned int i = 0; i < succ_joint_angles.size(); i++)
+  {
+    if (generated[i])
+    {
+      indices.push_back(i);
+      succ_states.push_back(*succ_state_template_);
+      succ_states.back().setJointGroupPositions(group, succ_joint_angles[i]);
+      succ_states.back().updateCollisionBodyTransforms();
+    }
+  }
+  std::vector<const moveit::core::RobotState*> states;
+  for (unsigned int i = 0; i < succ_states.size(); i++)
+  {
+    states.push_back(&succ_states[i]);
+  }
+
+  // same checks as PlanningScene::checkCollision(), self collisions with the unpadded robot
+  unsigned int threads = planning_parameters_.num_threads_ == 0 ? std::max(1u, boost::thread::hardware_concurrency()) :
+                                                                  planning_parameters_.num_threads_;
+  std::vector<bool> self_colliding, world_colliding;
+  planning_scene_->getCollisionEnvUnpadded()->isSelfColliding(states, planning_scene_->getAllowedCollisionMatrix(),
+                                                              self_colliding, planning_group_, threads);
+  planning_scene_->getCollisionEnv()->isRobotColliding(states, planning_scene_->getAllowedCollisionMatrix(),
+                                                       world_colliding, planning_group_, threads);
+
+  colliding.assign(succ_joint_angles.size(), true);
+  for (unsigned int i = 0; i < indices.size(); i++)
+  {
+    colliding[indices[i]] = self_colliding[i] || world_colliding[i];
+  }
+
+  planning_statistics_.coll_checks_ += states.size();
+  planning_statistics_.total_coll_check_time_ += ros::WallTime::now() - before_coll;
+}
+
 void EnvironmentChain3D::setMotionPrimitives(const std::string& group_name)
 {
   possible_actions_.clear();
@@ -2,7 +2,11 @@
 
 #include <moveit/planning_scene/planning_scene.h>
 
+#include <trajopt_sco/modeling.hpp>
+#include <trajopt_sco/modeling_utils.hpp>
+
 #include <Eigen/Geometry>
+#include <memory>
 
 namespace trajopt_interface
 {
@@ -60,11 +64,42 @@ struct CartPoseErrCalculator : public sco::VectorOfVector
   Eigen::VectorXd operator()(const Eigen::VectorXd& dof_vals) const override;
 };
 
-// TODO(omid): The following should be added and adjusted from trajopt
-// JointPosEqCost
-// JointPosIneqCost
-// JointPosEqConstraint
-// JointPosIneqConstraint
+/**
+ * @brief Used to calculate the error for JointPoseTermInfo
+ * This is converted to a cost or constraint using CostFromErrFunc or ConstraintFromErrFunc. The targets are shared
+ * with the term info, so the terms of a reused problem can be retargeted without constructing them again.
+ */
+struct JointPosErrCalculator : sco::VectorOfVector
+{
+  /** @brief Position target of each dof */
+  std::shared_ptr<const Eigen::VectorXd> targets_;
+  /** @brief Upper tolerance of each dof */
+  Eigen::VectorXd upper_tols_;
+  /** @brief Lower tolerance of each dof */
+  Eigen::VectorXd lower_tols_;
+  /** @brief If true, the error is the distance to the targets, else the violation of both tolerances */
+  bool is_equality_;
+
+  JointPosErrCalculator(std::shared_ptr<const Eigen::VectorXd> targets, const Eigen::VectorXd& upper_tols,
+                        const Eigen::VectorXd& lower_tols, bool is_equality)
+    : targets_(std::move(targets)), upper_tols_(upper_tols), lower_tols_(lower_tols), is_equality_(is_equality)
+  {
+  }
+
+  /** @param var_vals the joint values of consecutive timesteps */
+  Eigen::VectorXd operator()(const Eigen::VectorXd& var_vals) const override;
+};
+
+struct JointPosJacobianCalculator : sco::MatrixOfVector
+{
+  bool is_equality_;
+
+  JointPosJacobianCalculator(bool is_equality) : is_equality_(is_equality)
+  {
+  }
+
+  Eigen::MatrixXd operator()(const Eigen::VectorXd& var_vals) const override;
+};
 
 struct JointVelErrCalculator : sco::VectorOfVector
 {
@@ -90,4 +125,98 @@ struct JointVelJacobianCalculator : sco::MatrixOfVector
   Eigen::MatrixXd operator()(const Eigen::VectorXd& var_vals) const;
 };
 
+/**
+ * @brief Evaluates the distances of the robot to the world and to itself at all timesteps of a CollisionTermInfo
+ * The states of the timesteps are updated, queried with one batched distance request and linearized on num_threads
+ * threads. The SQP evaluates the same trajectory for the value and the convexification of a term, so the contacts of
+ * the last evaluated trajectory are cached.
+ */
+class CollisionEvaluator
+{
+public:
+  /** @brief A contact closer than the safety margin, linearized in the dofs of its timestep */
+  struct Contact
+  {
+    /** @brief Index of the timestep in the step vars of the evaluator */
+    std::size_t step;
+    /** @brief Signed distance of the contact */
+    double distance;
+    /** @brief Gradient of the distance with respect to the dofs of the timestep */
+    Eigen::VectorXd gradient;
+  };
+
+  /** @param step_vars The joint vars of each timestep the distances are evaluated at
+   *  @param num_threads Number of threads, 0 uses all cores */
+  CollisionEvaluator(const planning_scene::PlanningSceneConstPtr& planning_scene, const std::string& group_name,
+                     const std::vector<sco::VarVector>& step_vars, double safety_margin, unsigned int num_threads);
+
+  /** @brief Query the distances in \a planning_scene from now on, e.g. when the problem is reused */
+  void setPlanningScene(const planning_scene::PlanningSceneConstPtr& planning_scene);
+
+  /** @brief Returns the contacts closer than the safety margin of all timesteps of the trajectory \a x */
+  const std::vector<Contact>& getContacts(const sco::DblVec& x);
+
+  const std::vector<sco::VarVector>& getStepVars() const
+  {
+    return step_vars_;
+  }
+
+  double getSafetyMargin() const
+  {
+    return safety_margin_;
+  }
+
+private:
+  /** @brief Appends the contacts of \a result closer than the safety margin to \a contacts */
+  void linearizeContacts(std::size_t step, const collision_detection::DistanceResult& result,
+                         std::vector<Contact>& contacts) const;
+
+  planning_scene::PlanningSceneConstPtr planning_scene_;
+  const moveit::core::JointModelGroup* group_;
+  std::vector<sco::VarVector> step_vars_;
+  double safety_margin_;
+  unsigned int num_threads_;
+  collision_detection::DistanceRequest request_;
+  /** @brief One state per timestep, so the timesteps can be updated concurrently */
+  std::vector<moveit::core::RobotStatePtr> states_;
+  /** @brief Dofs of all timesteps of the cached evaluation */
+  Eigen::VectorXd cached_dofs_;
+  std::vector<Contact> contacts_;
+};
+
+/**
+ * @brief Penalizes every contact closer than the safety margin with coeff * max(0, safety_margin - distance)
+ */
+class CollisionCost : public sco::Cost
+{
+public:
+  CollisionCost(std::shared_ptr<CollisionEvaluator> evaluator, double coeff);
+
+  double value(const sco::DblVec& x) override;
+  sco::ConvexObjective::Ptr convex(const sco::DblVec& x, sco::Model* model) override;
+  sco::VarVector getVars() override;
+
+private:
+  std::shared_ptr<CollisionEvaluator> evaluator_;
+  double coeff_;
+};
+
+/**
+ * @brief Requires every contact to be at least the safety margin apart
+ * The value of each timestep is the penalty of CollisionCost of its contacts.
+ */
+class CollisionConstraint : public sco::IneqConstraint
+{
+public:
+  CollisionConstraint(std::shared_ptr<CollisionEvaluator> evaluator, double coeff);
+
+  sco::DblVec value(const sco::DblVec& x) override;
+  sco::ConvexConstraints::Ptr convex(const sco::DblVec& x, sco::Model* model) override;
+  sco::VarVector getVars() override;
+
+private:
+  std::shared_ptr<CollisionEvaluator> evaluator_;
+  double coeff_;
+};
+
 }  // namespace trajopt_interface
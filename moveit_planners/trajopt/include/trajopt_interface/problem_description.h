@@ -52,8 +52,19 @@ MOVEIT_CLASS_FORWARD(CartPoseTermInfo);  // Defines CartPoseTermInfoPtr, ConstPt
 struct JointVelTermInfo;
 MOVEIT_CLASS_FORWARD(JointVelTermInfo);  // Defines JointVelTermInfoPtr, ConstPtr, WeakPtr... etc
 
+struct CollisionTermInfo;
+MOVEIT_CLASS_FORWARD(CollisionTermInfo);  // Defines CollisionTermInfoPtr, ConstPtr, WeakPtr... etc
+
+class CollisionEvaluator;
+
 struct ProblemInfo;
 TrajOptProblemPtr ConstructProblem(const ProblemInfo&);
+/**
+ * @brief Update a problem built by ConstructProblem(\a constructed_pci) in place to solve \a pci
+ * @return false if \a pci differs in more than the values its terms can be updated with, then the problem has to be
+ * constructed again
+ */
+bool UpdateProblem(TrajOptProblem& prob, const ProblemInfo& constructed_pci, const ProblemInfo& pci);
 
 enum TermType
 {
@@ -134,6 +145,14 @@ struct TermInfo
   }
   //  virtual void fromJson(ProblemConstructionInfo& pci, const Json::Value& v) = 0;
   virtual void addObjectiveTerms(TrajOptProblem& prob) = 0;
+  /**
+   * @brief Update the terms this added to \a prob with the values of \a info
+   * @return false if \a info differs in structure or the terms can not be updated in place
+   */
+  virtual bool updateObjectiveTerms(TrajOptProblem& /*prob*/, const TermInfo& /*info*/)
+  {
+    return false;
+  }
 
   static TermInfoPtr fromName(const std::string& type);
 
@@ -220,10 +239,19 @@ public:
   {
     return dof_;
   }
+  /** @brief Returns the name of the active joint model group */
+  const std::string& GetPlanningGroup()
+  {
+    return planning_group_;
+  }
   planning_scene::PlanningSceneConstPtr GetPlanningScene()
   {
     return planning_scene_;
   }
+  void SetPlanningScene(const planning_scene::PlanningSceneConstPtr& planning_scene)
+  {
+    planning_scene_ = planning_scene;
+  }
   void SetInitTraj(const trajopt::TrajArray& x)
   {
     matrix_init_traj = x;
@@ -315,6 +343,8 @@ struct JointPoseTermInfo : public TermInfo
   int first_step = 0;
   /** @brief Last time step to which the term is applied. Default: prob.GetNumSteps() - 1*/
   int last_step = -1;
+  /** @brief Targets of the terms added to the problem, shared with their error functions so they can be updated */
+  std::shared_ptr<Eigen::VectorXd> term_targets;
 
   /** @brief Initialize term with it's supported types */
   JointPoseTermInfo() : TermInfo(TT_COST | TT_CNT | TT_USE_TIME)
@@ -323,12 +353,18 @@ struct JointPoseTermInfo : public TermInfo
 
   /** @brief Converts term info into cost/constraint and adds it to trajopt problem */
   void addObjectiveTerms(TrajOptProblem& prob) override;
+  /** @brief Retargets the terms to the targets of \a info, if everything else is equal */
+  bool updateObjectiveTerms(TrajOptProblem& prob, const TermInfo& info) override;
 
   static TermInfoPtr create()
   {
     TermInfoPtr out(new JointPoseTermInfo());
     return out;
   }
+
+private:
+  /** @brief Fills in the defaults of optional parameters and checks the parameter sizes */
+  void applyDefaults(TrajOptProblem& prob);
 };
 
 struct JointVelTermInfo : public TermInfo
@@ -353,12 +389,65 @@ struct JointVelTermInfo : public TermInfo
 
   /** @brief Converts term info into cost/constraint and adds it to trajopt problem */
   void addObjectiveTerms(TrajOptProblem& prob) override;
+  /** @brief The terms have no values to update, so this only checks that \a info is equal */
+  bool updateObjectiveTerms(TrajOptProblem& prob, const TermInfo& info) override;
 
   static TermInfoPtr create()
   {
     TermInfoPtr out(new JointVelTermInfo());
     return out;
   }
+
+private:
+  /** @brief Fills in the defaults of optional parameters and checks the parameter sizes */
+  void applyDefaults(TrajOptProblem& prob);
+};
+
+/**
+  \brief Collision avoidance cost or constraint
+    Penalizes every pair of bodies closer than safety_margin at the time steps of the term, with the robot at each
+    time step checked against the world and itself
+
+  \f{align*}{
+  \sum_t \sum_{pairs} c \max(0, d_{safe} - d_{t,pair})
+  \f}
+  where \f$c\f$ is coeff and \f$d_{safe}\f$ is safety_margin. The distances of all time steps are queried in one
+  batched request and linearized in parallel, see CollisionEvaluator. Requires the planning group to be a chain.
+ */
+struct CollisionTermInfo : public TermInfo
+{
+  /** @brief Coefficient that scales the penalty of each pair. Default: 20 */
+  double coeff = 20.0;
+  /** @brief Distance below which a pair is penalized. Default: 0.025 */
+  double safety_margin = 0.025;
+  /** @brief First time step to which the term is applied. Default: 0 */
+  int first_step = 0;
+  /** @brief Last time step to which the term is applied. Default: prob.GetNumSteps() - 1*/
+  int last_step = -1;
+  /** @brief Number of threads the time steps are evaluated on, 0 uses all cores. Default: 0 */
+  unsigned int num_threads = 0;
+  /** @brief Evaluator shared by the terms added to the problem, so they can be moved to a new planning scene */
+  std::shared_ptr<CollisionEvaluator> evaluator;
+
+  /** @brief Initialize term with it's supported types */
+  CollisionTermInfo() : TermInfo(TT_COST | TT_CNT)
+  {
+  }
+
+  /** @brief Converts term info into cost/constraint and adds it to trajopt problem */
+  void addObjectiveTerms(TrajOptProblem& prob) override;
+  /** @brief Moves the terms to the planning scene of \a prob, if \a info is equal */
+  bool updateObjectiveTerms(TrajOptProblem& prob, const TermInfo& info) override;
+
+  static TermInfoPtr create()
+  {
+    TermInfoPtr out(new CollisionTermInfo());
+    return out;
+  }
+
+private:
+  /** @brief Fills in the defaults of optional parameters */
+  void applyDefaults(TrajOptProblem& prob);
 };
 
 void generateInitialTrajectory(const ProblemInfo& pci, const std::vector<double>& current_joint_values,
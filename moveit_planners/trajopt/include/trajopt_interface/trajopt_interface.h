@@ -70,6 +70,8 @@ protected:
   sco::BasicTrustRegionSQPParameters params_;
   std::vector<sco::Optimizer::Callback> optimizer_callbacks_;
   TrajOptProblemPtr trajopt_problem_;
+  /** @brief The info trajopt_problem_ was constructed from, to reuse the problem for requests of the same structure */
+  std::shared_ptr<ProblemInfo> trajopt_problem_info_;
   std::string name_;
 };
 
@@ -1,5 +1,6 @@
 #include <Eigen/Geometry>
 #include <boost/format.hpp>
+#include <thread>
 
 #include <trajopt_sco/expr_ops.hpp>
 #include <trajopt_sco/modeling_utils.hpp>
@@ -19,6 +20,34 @@ VectorXd CartPoseErrCalculator::operator()(const VectorXd& dof_vals) const
   return err;
 }
 
+VectorXd JointPosErrCalculator::operator()(const VectorXd& var_vals) const
+{
+  int n_dof = static_cast<int>(targets_->rows());
+  assert(var_vals.rows() % n_dof == 0);
+  int num_steps = static_cast<int>(var_vals.rows()) / n_dof;
+  VectorXd diff = var_vals - targets_->replicate(num_steps, 1);
+  if (is_equality_)
+    return diff;
+
+  // positive where a tolerance is violated
+  VectorXd result(diff.rows() * 2);
+  result.topRows(diff.rows()) = diff - upper_tols_.replicate(num_steps, 1);
+  result.bottomRows(diff.rows()) = lower_tols_.replicate(num_steps, 1) - diff;
+  return result;
+}
+
+MatrixXd JointPosJacobianCalculator::operator()(const VectorXd& var_vals) const
+{
+  int num_vals = static_cast<int>(var_vals.rows());
+  if (is_equality_)
+    return MatrixXd::Identity(num_vals, num_vals);
+
+  MatrixXd jac(num_vals * 2, num_vals);
+  jac.topRows(num_vals) = MatrixXd::Identity(num_vals, num_vals);
+  jac.bottomRows(num_vals) = -MatrixXd::Identity(num_vals, num_vals);
+  return jac;
+}
+
 VectorXd JointVelErrCalculator::operator()(const VectorXd& var_vals) const
 {
   assert(var_vals.rows() % 2 == 0);
@@ -61,4 +90,197 @@ MatrixXd JointVelJacobianCalculator::operator()(const VectorXd& var_vals) const
   return jac;
 }
 
+CollisionEvaluator::CollisionEvaluator(const planning_scene::PlanningSceneConstPtr& planning_scene,
+                                       const std::string& group_name, const std::vector<sco::VarVector>& step_vars,
+                                       double safety_margin, unsigned int num_threads)
+  : group_(planning_scene->getRobotModel()->getJointModelGroup(group_name))
+  , step_vars_(step_vars)
+  , safety_margin_(safety_margin)
+  , num_threads_(num_threads > 0 ? num_threads : std::max(1u, std::thread::hardware_concurrency()))
+{
+  // the closest points of each pair are needed to linearize the distances, pairs beyond the margin are not
+  request_.type = collision_detection::DistanceRequestType::SINGLE;
+  request_.enable_nearest_points = true;
+  request_.enable_signed_distance = true;
+  request_.distance_threshold = safety_margin_;
+  request_.group_name = group_name;
+  request_.enableGroup(planning_scene->getRobotModel());
+  setPlanningScene(planning_scene);
+}
+
+void CollisionEvaluator::setPlanningScene(const planning_scene::PlanningSceneConstPtr& planning_scene)
+{
+  planning_scene_ = planning_scene;
+  request_.acm = &planning_scene_->getAllowedCollisionMatrix();
+
+  states_.clear();
+  for (std::size_t i = 0; i < step_vars_.size(); ++i)
+    states_.push_back(std::make_shared<moveit::core::RobotState>(planning_scene_->getCurrentState()));
+  cached_dofs_.resize(0);
+}
+
+const std::vector<CollisionEvaluator::Contact>& CollisionEvaluator::getContacts(const DblVec& x)
+{
+  const int n_steps = static_cast<int>(step_vars_.size());
+  const int n_dof = static_cast<int>(group_->getVariableCount());
+  VectorXd dofs(n_steps * n_dof);
+  for (int i = 0; i < n_steps; ++i)
+    dofs.segment(i * n_dof, n_dof) = getVec(x, step_vars_[i]);
+  if (dofs.size() == cached_dofs_.size() && dofs == cached_dofs_)
+    return contacts_;
+
+#pragma omp parallel for num_threads(num_threads_)
+  for (int i = 0; i < n_steps; ++i)
+  {
+    states_[i]->setJointGroupPositions(group_, VectorXd(dofs.segment(i * n_dof, n_dof)));
+    states_[i]->update();
+  }
+
+  std::vector<const moveit::core::RobotState*> states;
+  states.reserve(n_steps);
+  for (const moveit::core::RobotStatePtr& state : states_)
+    states.push_back(state.get());
+  std::vector<collision_detection::DistanceResult> world_results, self_results;
+  const collision_detection::CollisionEnvConstPtr& env = planning_scene_->getCollisionEnv();
+  env->distanceRobot(request_, states, world_results, num_threads_);
+  env->distanceSelf(request_, states, self_results, num_threads_);
+
+  std::vector<std::vector<Contact>> step_contacts(n_steps);
+#pragma omp parallel for num_threads(num_threads_)
+  for (int i = 0; i < n_steps; ++i)
+  {
+    linearizeContacts(i, world_results[i], step_contacts[i]);
+    linearizeContacts(i, self_results[i], step_contacts[i]);
+  }
+
+  contacts_.clear();
+  for (std::vector<Contact>& contacts : step_contacts)
+    contacts_.insert(contacts_.end(), std::make_move_iterator(contacts.begin()),
+                     std::make_move_iterator(contacts.end()));
+  cached_dofs_ = dofs;
+  return contacts_;
+}
+
+void CollisionEvaluator::linearizeContacts(std::size_t step, const collision_detection::DistanceResult& result,
+                                           std::vector<Contact>& contacts) const
+{
+  const moveit::core::RobotState& state = *states_[step];
+  // getJacobian() is expressed in the frame of the parent link of the group's root joint
+  const moveit::core::LinkModel* root_link = group_->getJointModels()[0]->getParentLinkModel();
+  const Matrix3d root_rotation = root_link ? state.getGlobalLinkTransform(root_link).linear() : Matrix3d::Identity();
+  MatrixXd jacobian;
+
+  for (const auto& pair : result.distances)
+  {
+    for (const collision_detection::DistanceResultsData& data : pair.second)
+    {
+      if (data.distance >= safety_margin_)
+        continue;
+
+      Contact contact{ step, data.distance, VectorXd::Zero(group_->getVariableCount()) };
+      for (int k = 0; k < 2; ++k)
+      {
+        const moveit::core::LinkModel* link = nullptr;
+        if (data.body_types[k] == collision_detection::BodyTypes::ROBOT_LINK)
+        {
+          link = state.getLinkModel(data.link_names[k]);
+        }
+        else if (data.body_types[k] == collision_detection::BodyTypes::ROBOT_ATTACHED)
+        {
+          const moveit::core::AttachedBody* body = state.getAttachedBody(data.link_names[k]);
+          link = body ? body->getAttachedLink() : nullptr;
+        }
+        // bodies the group does not move have no gradient
+        if (!link || !group_->isLinkUpdated(link->getName()))
+          continue;
+
+        Vector3d point = state.getGlobalLinkTransform(link).inverse() * data.nearest_points[k];
+        if (!state.getJacobian(group_, link, point, jacobian))
+          continue;
+        // the normal points from the first to the second body, so moving the second body along it separates them
+        double sign = k == 0 ? -1.0 : 1.0;
+        contact.gradient += sign * (root_rotation * jacobian.topRows<3>()).transpose() * data.normal;
+      }
+      contacts.push_back(std::move(contact));
+    }
+  }
+}
+
+namespace
+{
+/** @brief Linearization of safety_margin - distance around the dofs \a x */
+AffExpr linearizedPenetration(const CollisionEvaluator::Contact& contact, const VarVector& vars, const DblVec& x,
+                              double safety_margin)
+{
+  AffExpr expr(safety_margin - contact.distance + contact.gradient.dot(getVec(x, vars)));
+  exprInc(expr, varDot(-contact.gradient, vars));
+  return expr;
+}
+}  // namespace
+
+CollisionCost::CollisionCost(std::shared_ptr<CollisionEvaluator> evaluator, double coeff)
+  : evaluator_(std::move(evaluator)), coeff_(coeff)
+{
+}
+
+double CollisionCost::value(const DblVec& x)
+{
+  double cost = 0.0;
+  for (const CollisionEvaluator::Contact& contact : evaluator_->getContacts(x))
+    cost += coeff_ * std::max(0.0, evaluator_->getSafetyMargin() - contact.distance);
+  return cost;
+}
+
+ConvexObjective::Ptr CollisionCost::convex(const DblVec& x, Model* model)
+{
+  ConvexObjective::Ptr out(new ConvexObjective(model));
+  for (const CollisionEvaluator::Contact& contact : evaluator_->getContacts(x))
+    out->addHinge(linearizedPenetration(contact, evaluator_->getStepVars()[contact.step], x,
+                                        evaluator_->getSafetyMargin()),
+                  coeff_);
+  return out;
+}
+
+VarVector CollisionCost::getVars()
+{
+  VarVector vars;
+  for (const VarVector& step_vars : evaluator_->getStepVars())
+    vars.insert(vars.end(), step_vars.begin(), step_vars.end());
+  return vars;
+}
+
+CollisionConstraint::CollisionConstraint(std::shared_ptr<CollisionEvaluator> evaluator, double coeff)
+  : evaluator_(std::move(evaluator)), coeff_(coeff)
+{
+}
+
+DblVec CollisionConstraint::value(const DblVec& x)
+{
+  DblVec violations(evaluator_->getStepVars().size(), 0.0);
+  for (const CollisionEvaluator::Contact& contact : evaluator_->getContacts(x))
+    violations[contact.step] += coeff_ * std::max(0.0, evaluator_->getSafetyMargin() - contact.distance);
+  return violations;
+}
+
+ConvexConstraints::Ptr CollisionConstraint::convex(const DblVec& x, Model* model)
+{
+  ConvexConstraints::Ptr out(new ConvexConstraints(model));
+  for (const CollisionEvaluator::Contact& contact : evaluator_->getContacts(x))
+  {
+    AffExpr expr = linearizedPenetration(contact, evaluator_->getStepVars()[contact.step], x,
+                                         evaluator_->getSafetyMargin());
+    exprScale(expr, coeff_);
+    out->addIneqCnt(expr);
+  }
+  return out;
+}
+
+VarVector CollisionConstraint::getVars()
+{
+  VarVector vars;
+  for (const VarVector& step_vars : evaluator_->getStepVars())
+    vars.insert(vars.end(), step_vars.begin(), step_vars.end());
+  return vars;
+}
+
 }  // namespace trajopt_interface
@@ -136,56 +136,14 @@ TrajOptProblem::TrajOptProblem(const ProblemInfo& problem_info)
   // its size is n_steps by n_dof
 }
 
-TrajOptProblemPtr ConstructProblem(const ProblemInfo& pci)
+namespace
 {
-  const BasicInfo& bi = pci.basic_info;
-  int n_steps = bi.n_steps;
-
-  bool use_time = false;
-  // Check that all costs and constraints support the types that are specified in pci
-  for (TermInfoPtr cost : pci.cost_infos)
-  {
-    if (cost->term_type & TT_CNT)
-      ROS_WARN("%s is listed as a type TT_CNT but was added to cost_infos", (cost->name).c_str());
-    if (!(cost->getSupportedTypes() & TT_COST))
-      PRINT_AND_THROW(boost::format("%s is only a constraint, but you listed it as a cost") % cost->name);
-    if (cost->term_type & TT_USE_TIME)
-    {
-      use_time = true;
-      if (!(cost->getSupportedTypes() & TT_USE_TIME))
-        PRINT_AND_THROW(boost::format("%s does not support time, but you listed it as a using time") % cost->name);
-    }
-  }
-  for (TermInfoPtr cnt : pci.cnt_infos)
-  {
-    if (cnt->term_type & TT_COST)
-      ROS_WARN("%s is listed as a type TT_COST but was added to cnt_infos", (cnt->name).c_str());
-    if (!(cnt->getSupportedTypes() & TT_CNT))
-      PRINT_AND_THROW(boost::format("%s is only a cost, but you listed it as a constraint") % cnt->name);
-    if (cnt->term_type & TT_USE_TIME)
-    {
-      use_time = true;
-      if (!(cnt->getSupportedTypes() & TT_USE_TIME))
-        PRINT_AND_THROW(boost::format("%s does not support time, but you listed it as a using time") % cnt->name);
-    }
-  }
-
-  // Check that if a cost or constraint uses time, basic_info is set accordingly
-  if ((use_time == true) && (pci.basic_info.use_time == false))
-    PRINT_AND_THROW("A term is using time and basic_info is not set correctly. Try basic_info.use_time = true");
-
-  // This could be removed in the future once we are sure that all costs are
-  if ((use_time == false) && (pci.basic_info.use_time == true))
-    PRINT_AND_THROW("No terms use time and basic_info is not set correctly. Try basic_info.use_time = false");
-
-  TrajOptProblemPtr prob(new TrajOptProblem(pci));
-
-  // Generate initial trajectory and check its size
-  moveit::core::RobotModelConstPtr robot_model = pci.planning_scene->getRobotModel();
+/** @brief Generates the initial trajectory of \a pci from the current state of its planning scene */
+trajopt::TrajArray getInitialTrajectory(const ProblemInfo& pci, int n_dof)
+{
+  int n_steps = pci.basic_info.n_steps;
   moveit::core::RobotState current_state = pci.planning_scene->getCurrentState();
-
   const moveit::core::JointModelGroup* joint_model_group = current_state.getJointModelGroup(pci.planning_group_name);
-  int n_dof = prob->GetNumDOF();
 
   std::vector<double> current_joint_values;
   current_state.copyJointGroupPositions(joint_model_group, current_joint_values);
@@ -195,7 +153,6 @@ TrajOptProblemPtr ConstructProblem(const ProblemInfo& pci)
 
   if (pci.basic_info.use_time == true)
   {
-    prob->SetHasTime(true);
     if (init_traj.rows() != n_steps || init_traj.cols() != n_dof + 1)
     {
       PRINT_AND_THROW(boost::format("Initial trajectory is not the right size matrix\n"
@@ -206,7 +163,6 @@ TrajOptProblemPtr ConstructProblem(const ProblemInfo& pci)
   }
   else
   {
-    prob->SetHasTime(false);
     if (init_traj.rows() != n_steps || init_traj.cols() != n_dof)
     {
       PRINT_AND_THROW(boost::format("Initial trajectory is not the right size matrix\n"
@@ -215,9 +171,23 @@ TrajOptProblemPtr ConstructProblem(const ProblemInfo& pci)
                       n_steps % n_dof % init_traj.rows() % init_traj.cols());
     }
   }
-  prob->SetInitTraj(init_traj);
+  return init_traj;
+}
+
+/**
+ * @brief Fixes the first time step (if start_fixed) and the fixed dofs to their initial values
+ * The values are fixed through the variable bounds instead of linear constraints, so they can be updated when the
+ * problem is reused.
+ */
+void fixInitialValues(TrajOptProblem& prob, const ProblemInfo& pci, const trajopt::TrajArray& init_traj)
+{
+  const BasicInfo& bi = pci.basic_info;
+  int n_dof = prob.GetNumDOF();
+  bool use_time = bi.use_time;
+
+  sco::VarVector fixed_vars;
+  trajopt::DblVec fixed_values;
 
-  trajopt::VarArray matrix_traj_vars_temp;
   // If start_fixed, constrain the joint values for the first time step to be their initialized values
   if (bi.start_fixed)
   {
@@ -234,26 +204,76 @@ TrajOptProblemPtr ConstructProblem(const ProblemInfo& pci)
 
     for (int j = 0; j < static_cast<int>(n_dof); ++j)
     {
-      matrix_traj_vars_temp = prob->GetVars();
-      prob->addLinearConstraint(sco::exprSub(sco::AffExpr(matrix_traj_vars_temp(0, j)), init_traj(0, j)), sco::EQ);
+      fixed_vars.push_back(prob.GetVar(0, j));
+      fixed_values.push_back(init_traj(0, j));
     }
   }
 
   // Apply constraint to each fixed dof to its initial value for all timesteps (freeze that column)
-  if (!bi.dofs_fixed.empty())
+  for (const int& dof_ind : bi.dofs_fixed)
   {
-    for (const int& dof_ind : bi.dofs_fixed)
+    for (int i = 1; i < prob.GetNumSteps(); ++i)
     {
-      for (int i = 1; i < prob->GetNumSteps(); ++i)
-      {
-        matrix_traj_vars_temp = prob->GetVars();
-        prob->addLinearConstraint(sco::exprSub(sco::AffExpr(matrix_traj_vars_temp(i, dof_ind)),
-                                               sco::AffExpr(init_traj(0, dof_ind))),
-                                  sco::EQ);
-      }
+      fixed_vars.push_back(prob.GetVar(i, dof_ind));
+      fixed_values.push_back(init_traj(0, dof_ind));
     }
   }
 
+  if (!fixed_vars.empty())
+  {
+    prob.setLowerBounds(fixed_values, fixed_vars);
+    prob.setUpperBounds(fixed_values, fixed_vars);
+  }
+}
+}  // namespace
+
+TrajOptProblemPtr ConstructProblem(const ProblemInfo& pci)
+{
+  bool use_time = false;
+  // Check that all costs and constraints support the types that are specified in pci
+  for (TermInfoPtr cost : pci.cost_infos)
+  {
+    if (cost->term_type & TT_CNT)
+      ROS_WARN("%s is listed as a type TT_CNT but was added to cost_infos", (cost->name).c_str());
+    if (!(cost->getSupportedTypes() & TT_COST))
+      PRINT_AND_THROW(boost::format("%s is only a constraint, but you listed it as a cost") % cost->name);
+    if (cost->term_type & TT_USE_TIME)
+    {
+      use_time = true;
+      if (!(cost->getSupportedTypes() & TT_USE_TIME))
+        PRINT_AND_THROW(boost::format("%s does not support time, but you listed it as a using time") % cost->name);
+    }
+  }
+  for (TermInfoPtr cnt : pci.cnt_infos)
+  {
+    if (cnt->term_type & TT_COST)
+      ROS_WARN("%s is listed as a type TT_COST but was added to cnt_infos", (cnt->name).c_str());
+    if (!(cnt->getSupportedTypes() & TT_CNT))
+      PRINT_AND_THROW(boost::format("%s is only a cost, but you listed it as a constraint") % cnt->name);
+    if (cnt->term_type & TT_USE_TIME)
+    {
+      use_time = true;
+      if (!(cnt->getSupportedTypes() & TT_USE_TIME))
+        PRINT_AND_THROW(boost::format("%s does not support time, but you listed it as a using time") % cnt->name);
+    }
+  }
+
+  // Check that if a cost or constraint uses time, basic_info is set accordingly
+  if ((use_time == true) && (pci.basic_info.use_time == false))
+    PRINT_AND_THROW("A term is using time and basic_info is not set correctly. Try basic_info.use_time = true");
+
+  // This could be removed in the future once we are sure that all costs are
+  if ((use_time == false) && (pci.basic_info.use_time == true))
+    PRINT_AND_THROW("No terms use time and basic_info is not set correctly. Try basic_info.use_time = false");
+
+  TrajOptProblemPtr prob(new TrajOptProblem(pci));
+  prob->SetHasTime(pci.basic_info.use_time);
+
+  // Generate initial trajectory and check its size
+  trajopt::TrajArray init_traj = getInitialTrajectory(pci, prob->GetNumDOF());
+  prob->SetInitTraj(init_traj);
+  fixInitialValues(*prob, pci, init_traj);
+
   for (const TermInfoPtr& ci : pci.cost_infos)
   {
     ci->addObjectiveTerms(*prob);
@@ -266,6 +286,37 @@ TrajOptProblemPtr ConstructProblem(const ProblemInfo& pci)
   return prob;
 }
 
+bool UpdateProblem(TrajOptProblem& prob, const ProblemInfo& constructed_pci, const ProblemInfo& pci)
+{
+  const BasicInfo& bi = pci.basic_info;
+  const BasicInfo& constructed_bi = constructed_pci.basic_info;
+  if (pci.planning_group_name != constructed_pci.planning_group_name || bi.start_fixed != constructed_bi.start_fixed ||
+      bi.n_steps != constructed_bi.n_steps || bi.dofs_fixed != constructed_bi.dofs_fixed ||
+      bi.convex_solver != constructed_bi.convex_solver || bi.use_time != constructed_bi.use_time ||
+      bi.dt_upper_lim != constructed_bi.dt_upper_lim || bi.dt_lower_lim != constructed_bi.dt_lower_lim ||
+      pci.cost_infos.size() != constructed_pci.cost_infos.size() ||
+      pci.cnt_infos.size() != constructed_pci.cnt_infos.size())
+    return false;
+
+  // terms that depend on the scene pick it up from the problem
+  prob.SetPlanningScene(pci.planning_scene);
+  for (std::size_t i = 0; i < pci.cost_infos.size(); ++i)
+  {
+    if (!constructed_pci.cost_infos[i]->updateObjectiveTerms(prob, *pci.cost_infos[i]))
+      return false;
+  }
+  for (std::size_t i = 0; i < pci.cnt_infos.size(); ++i)
+  {
+    if (!constructed_pci.cnt_infos[i]->updateObjectiveTerms(prob, *pci.cnt_infos[i]))
+      return false;
+  }
+
+  trajopt::TrajArray init_traj = getInitialTrajectory(pci, prob.GetNumDOF());
+  prob.SetInitTraj(init_traj);
+  fixInitialValues(prob, pci, init_traj);
+  return true;
+}
+
 CartPoseTermInfo::CartPoseTermInfo() : TermInfo(TT_COST | TT_CNT)
 {
   pos_coeffs = Eigen::Vector3d::Ones();
@@ -308,7 +359,7 @@ void CartPoseTermInfo::addObjectiveTerms(TrajOptProblem& prob)
   }
 }
 
-void JointPoseTermInfo::addObjectiveTerms(TrajOptProblem& prob)
+void JointPoseTermInfo::applyDefaults(TrajOptProblem& prob)
 {
   unsigned int n_dof = prob.GetActiveGroupNumDOF();
 
@@ -344,52 +395,49 @@ void JointPoseTermInfo::addObjectiveTerms(TrajOptProblem& prob)
   checkParameterSize(targets, n_dof, "JointPoseTermInfo targets", true);
   checkParameterSize(upper_tols, n_dof, "JointPoseTermInfo upper_tols", true);
   checkParameterSize(lower_tols, n_dof, "JointPoseTermInfo lower_tols", true);
+}
+
+void JointPoseTermInfo::addObjectiveTerms(TrajOptProblem& prob)
+{
+  unsigned int n_dof = prob.GetActiveGroupNumDOF();
+  applyDefaults(prob);
 
   // Check if tolerances are all zeros
   bool is_upper_zeros =
       std::all_of(upper_tols.begin(), upper_tols.end(), [](double i) { return util::doubleEquals(i, 0.); });
   bool is_lower_zeros =
       std::all_of(lower_tols.begin(), lower_tols.end(), [](double i) { return util::doubleEquals(i, 0.); });
+  bool is_equality = is_upper_zeros && is_lower_zeros;
 
-  // Get vars associated with joints
-  trajopt::VarArray vars = prob.GetVars();
-  trajopt::VarArray joint_vars = vars.block(0, 0, vars.rows(), static_cast<int>(n_dof));
+  // Get vars associated with joints of all time steps of the term
+  sco::VarVector joint_vars_vec;
+  for (int i = first_step; i <= last_step; ++i)
+  {
+    sco::VarVector row = prob.GetVarRow(i, 0, static_cast<int>(n_dof));
+    joint_vars_vec.insert(joint_vars_vec.end(), row.begin(), row.end());
+  }
   if (prob.GetHasTime())
     ROS_INFO("JointPoseTermInfo does not differ based on setting of TT_USE_TIME");
 
+  // The targets are shared with the error function, so UpdateProblem can retarget the term
+  term_targets = std::make_shared<Eigen::VectorXd>(util::toVectorXd(targets));
+  sco::VectorOfVector::Ptr f(new JointPosErrCalculator(term_targets, util::toVectorXd(upper_tols),
+                                                       util::toVectorXd(lower_tols), is_equality));
+  sco::MatrixOfVector::Ptr dfdx(new JointPosJacobianCalculator(is_equality));
+  int num_errors = static_cast<int>(joint_vars_vec.size()) * (is_equality ? 1 : 2);
+  Eigen::VectorXd term_coeffs = util::toVectorXd(coeffs).replicate(num_errors / n_dof, 1);
+
   if (term_type & TT_COST)
   {
     // If the tolerances are 0, an equality cost is set. Otherwise it's a hinged "inequality" cost
-    if (is_upper_zeros && is_lower_zeros)
-    {
-      prob.addCost(sco::Cost::Ptr(new trajopt::JointPosEqCost(joint_vars, util::toVectorXd(coeffs),
-                                                              util::toVectorXd(targets), first_step, last_step)));
-      prob.getCosts().back()->setName(name);
-    }
-    else
-    {
-      prob.addCost(sco::Cost::Ptr(new trajopt::JointPosIneqCost(joint_vars, util::toVectorXd(coeffs),
-                                                                util::toVectorXd(targets), util::toVectorXd(upper_tols),
-                                                                util::toVectorXd(lower_tols), first_step, last_step)));
-      prob.getCosts().back()->setName(name);
-    }
+    prob.addCost(sco::Cost::Ptr(new sco::CostFromErrFunc(f, dfdx, joint_vars_vec, term_coeffs,
+                                                         is_equality ? sco::SQUARED : sco::HINGE, name)));
   }
   else if (term_type & TT_CNT)
   {
     // If the tolerances are 0, an equality cnt is set. Otherwise it's an inequality constraint
-    if (is_upper_zeros && is_lower_zeros)
-    {
-      prob.addConstraint(sco::Constraint::Ptr(new trajopt::JointPosEqConstraint(
-          joint_vars, util::toVectorXd(coeffs), util::toVectorXd(targets), first_step, last_step)));
-      prob.getConstraints().back()->setName(name);
-    }
-    else
-    {
-      prob.addConstraint(sco::Constraint::Ptr(new trajopt::JointPosIneqConstraint(
-          joint_vars, util::toVectorXd(coeffs), util::toVectorXd(targets), util::toVectorXd(upper_tols),
-          util::toVectorXd(lower_tols), first_step, last_step)));
-      prob.getConstraints().back()->setName(name);
-    }
+    prob.addConstraint(sco::Constraint::Ptr(new sco::ConstraintFromErrFunc(f, dfdx, joint_vars_vec, term_coeffs,
+                                                                           is_equality ? sco::EQ : sco::INEQ, name)));
   }
   else
   {
@@ -397,7 +445,25 @@ void JointPoseTermInfo::addObjectiveTerms(TrajOptProblem& prob)
   }
 }
 
-void JointVelTermInfo::addObjectiveTerms(TrajOptProblem& prob)
+bool JointPoseTermInfo::updateObjectiveTerms(TrajOptProblem& prob, const TermInfo& info)
+{
+  const JointPoseTermInfo* update_info = dynamic_cast<const JointPoseTermInfo*>(&info);
+  if (!update_info || !term_targets)
+    return false;
+
+  JointPoseTermInfo update(*update_info);
+  update.applyDefaults(prob);
+  if (update.name != name || update.term_type != term_type || update.coeffs != coeffs ||
+      update.upper_tols != upper_tols || update.lower_tols != lower_tols || update.first_step != first_step ||
+      update.last_step != last_step)
+    return false;
+
+  targets = update.targets;
+  *term_targets = util::toVectorXd(targets);
+  return true;
+}
+
+void JointVelTermInfo::applyDefaults(TrajOptProblem& prob)
 {
   unsigned int n_dof = prob.GetNumDOF();
 
@@ -433,6 +499,12 @@ void JointVelTermInfo::addObjectiveTerms(TrajOptProblem& prob)
   checkParameterSize(lower_tols, n_dof, "JointVelTermInfo lower_tols", true);
   assert(last_step > first_step);
   assert(first_step >= 0);
+}
+
+void JointVelTermInfo::addObjectiveTerms(TrajOptProblem& prob)
+{
+  unsigned int n_dof = prob.GetNumDOF();
+  applyDefaults(prob);
 
   // Check if tolerances are all zeros
   bool is_upper_zeros =
@@ -546,6 +618,84 @@ void JointVelTermInfo::addObjectiveTerms(TrajOptProblem& prob)
   }
 }
 
+bool JointVelTermInfo::updateObjectiveTerms(TrajOptProblem& prob, const TermInfo& info)
+{
+  const JointVelTermInfo* update_info = dynamic_cast<const JointVelTermInfo*>(&info);
+  if (!update_info)
+    return false;
+
+  JointVelTermInfo update(*update_info);
+  update.applyDefaults(prob);
+  return update.name == name && update.term_type == term_type && update.coeffs == coeffs &&
+         update.targets == targets && update.upper_tols == upper_tols && update.lower_tols == lower_tols &&
+         update.first_step == first_step && update.last_step == last_step;
+}
+
+void CollisionTermInfo::applyDefaults(TrajOptProblem& prob)
+{
+  if (last_step <= -1 || (prob.GetNumSteps() - 1) <= last_step)
+    last_step = prob.GetNumSteps() - 1;
+  if (last_step < first_step)
+  {
+    int tmp = first_step;
+    first_step = last_step;
+    last_step = tmp;
+    ROS_WARN("Last time step for CollisionTerm comes before first step. Reversing them.");
+  }
+  if (first_step < 0)
+    first_step = 0;
+}
+
+void CollisionTermInfo::addObjectiveTerms(TrajOptProblem& prob)
+{
+  int n_dof = prob.GetActiveGroupNumDOF();
+  applyDefaults(prob);
+
+  if (!prob.GetPlanningScene()->getRobotModel()->getJointModelGroup(prob.GetPlanningGroup())->isChain())
+  {
+    ROS_WARN("CollisionTermInfo requires the planning group to be a chain. No cost/constraint applied");
+    return;
+  }
+
+  std::vector<sco::VarVector> step_vars;
+  for (int i = first_step; i <= last_step; ++i)
+    step_vars.push_back(prob.GetVarRow(i, 0, n_dof));
+  evaluator = std::make_shared<CollisionEvaluator>(prob.GetPlanningScene(), prob.GetPlanningGroup(), step_vars,
+                                                   safety_margin, num_threads);
+
+  if (term_type & TT_COST)
+  {
+    prob.addCost(sco::Cost::Ptr(new CollisionCost(evaluator, coeff)));
+    prob.getCosts().back()->setName(name);
+  }
+  else if (term_type & TT_CNT)
+  {
+    prob.addConstraint(sco::Constraint::Ptr(new CollisionConstraint(evaluator, coeff)));
+    prob.getConstraints().back()->setName(name);
+  }
+  else
+  {
+    ROS_WARN("CollisionTermInfo does not have a valid term_type defined. No cost/constraint applied");
+  }
+}
+
+bool CollisionTermInfo::updateObjectiveTerms(TrajOptProblem& prob, const TermInfo& info)
+{
+  const CollisionTermInfo* update_info = dynamic_cast<const CollisionTermInfo*>(&info);
+  if (!update_info || !evaluator)
+    return false;
+
+  CollisionTermInfo update(*update_info);
+  update.applyDefaults(prob);
+  if (update.name != name || update.term_type != term_type || update.coeff != coeff ||
+      update.safety_margin != safety_margin || update.first_step != first_step || update.last_step != last_step ||
+      update.num_threads != num_threads)
+    return false;
+
+  evaluator->setPlanningScene(prob.GetPlanningScene());
+  return true;
+}
+
 void generateInitialTrajectory(const ProblemInfo& pci, const std::vector<double>& current_joint_values,
                                trajopt::TrajArray& init_traj)
 {
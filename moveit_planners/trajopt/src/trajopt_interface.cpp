@@ -215,6 +215,24 @@ bool TrajOptInterface::solve(const planning_scene::PlanningSceneConstPtr& planni
   joint_vel->term_type = trajopt_interface::TT_COST;
   problem_info.cost_infos.push_back(joint_vel);
 
+  ROS_INFO(" ======================================= Collision Costs");
+  bool use_collision_term;
+  nh_.param("collision_term_info/enable", use_collision_term, true);
+  if (use_collision_term)
+  {
+    CollisionTermInfoPtr collision(new CollisionTermInfo);
+    int num_threads;
+    nh_.param("collision_term_info/coeff", collision->coeff, 20.0);
+    nh_.param("collision_term_info/safety_margin", collision->safety_margin, 0.025);
+    nh_.param("collision_term_info/num_threads", num_threads, 0);
+    collision->num_threads = static_cast<unsigned int>(std::max(0, num_threads));
+    collision->first_step = 0;
+    collision->last_step = problem_info.basic_info.n_steps - 1;
+    collision->name = "collision";
+    collision->term_type = trajopt_interface::TT_COST;
+    problem_info.cost_infos.push_back(collision);
+  }
+
   ROS_INFO(" ======================================= Visibility Constraints");
   if (!req.goal_constraints[0].visibility_constraints.empty())
   {
@@ -257,8 +275,20 @@ bool TrajOptInterface::solve(const planning_scene::PlanningSceneConstPtr& planni
   ROS_DEBUG_STREAM_NAMED(name_, "problem_info.basic_info.type: " << problem_info_type);
   ROS_DEBUG_STREAM_NAMED(name_, "problem_info.basic_info.dt: " << problem_info.init_info.dt);
 
-  ROS_INFO(" ======================================= Construct problem");
-  trajopt_problem_ = ConstructProblem(problem_info);
+  // Constructing the problem dominates short horizons, so if the previous request had the same structure its problem,
+  // including the convex solver model and its workspace, is updated with the values of this request instead
+  bool reuse_problem;
+  nh_.param("problem_info/reuse_problem", reuse_problem, true);
+  if (reuse_problem && trajopt_problem_info_ && UpdateProblem(*trajopt_problem_, *trajopt_problem_info_, problem_info))
+  {
+    ROS_INFO(" ======================================= Reuse problem");
+  }
+  else
+  {
+    ROS_INFO(" ======================================= Construct problem");
+    trajopt_problem_ = ConstructProblem(problem_info);
+    trajopt_problem_info_ = std::make_shared<ProblemInfo>(problem_info);
+  }
 
   ROS_INFO_STREAM_NAMED("num_cost", trajopt_problem_->getNumCosts());
   ROS_INFO_STREAM_NAMED("num_constraints", trajopt_problem_->getNumConstraints());
@@ -45,8 +45,10 @@ namespace moveit_fake_controller_manager
 {
 BaseFakeController::BaseFakeController(const std::string& name, const std::vector<std::string>& joints,
                                        const ros::Publisher& pub)
-  : moveit_controller_manager::MoveItControllerHandle(name), joints_(joints), pub_(pub)
+  : moveit_controller_manager::MoveItControllerHandle(name), joints_(joints), pub_(pub), speedup_(1.0)
 {
+  ros::param::get("~fake_execution_speedup", speedup_);
+
   std::stringstream ss;
   ss << "Fake controller '" << name << "' with joints [ ";
   std::copy(joints.begin(), joints.end(), std::ostream_iterator<std::string>(ss, " "));
@@ -59,6 +61,11 @@ void BaseFakeController::getJoints(std::vector<std::string>& joints) const
   joints = joints_;
 }
 
+ros::Duration BaseFakeController::elapsedSince(const ros::Time& start) const
+{
+  return (ros::Time::now() - start) * speedup_;
+}
+
 moveit_controller_manager::ExecutionStatus BaseFakeController::getLastExecutionStatus()
 {
   return moveit_controller_manager::ExecutionStatus::SUCCEEDED;
@@ -174,11 +181,11 @@ void ViaPointController::execTrajectory(const moveit_msgs::RobotTrajectory& t)
     js.velocity = via->velocities;
     js.effort = via->effort;
 
-    ros::Duration wait_time = via->time_from_start - (ros::Time::now() - start_time);
-    if (wait_time.toSec() > std::numeric_limits<float>::epsilon())
+    ros::Duration wait_time = via->time_from_start - elapsedSince(start_time);
+    if (!instant() && wait_time.toSec() > std::numeric_limits<float>::epsilon())
     {
       ROS_DEBUG("Fake execution: waiting %0.1fs for next via point, %ld remaining", wait_time.toSec(), end - via);
-      wait_time.sleep();
+      ros::Duration(wait_time.toSec() / speedup_).sleep();
     }
     js.header.stamp = ros::Time::now();
     pub_.publish(js);
@@ -231,9 +238,9 @@ void InterpolatingController::execTrajectory(const moveit_msgs::RobotTrajectory&
       end = points.end();
 
   ros::Time start_time = ros::Time::now();
-  while (!cancelled())
+  while (!cancelled() && !instant())
   {
-    ros::Duration elapsed = ros::Time::now() - start_time;
+    ros::Duration elapsed = elapsedSince(start_time);
     // hop to next targetted via point
     while (next != end && elapsed > next->time_from_start)
     {
@@ -256,12 +263,12 @@ void InterpolatingController::execTrajectory(const moveit_msgs::RobotTrajectory&
   if (cancelled())
     return;
 
-  ros::Duration elapsed = ros::Time::now() - start_time;
+  ros::Duration elapsed = elapsedSince(start_time);
   ROS_DEBUG("elapsed: %.3f via points %td,%td / %td  alpha: 1.0", elapsed.toSec(), prev - points.begin(),
             next - points.begin(), end - points.begin());
 
   // publish last point
-  interpolate(js, *prev, *prev, prev->time_from_start);
+  interpolate(js, points.back(), points.back(), points.back().time_from_start);
   js.header.stamp = ros::Time::now();
   pub_.publish(js);
 
@@ -58,8 +58,17 @@ public:
   void getJoints(std::vector<std::string>& joints) const;
 
 protected:
+  /// Trajectory time passed since \e start, scaled by the execution speedup
+  ros::Duration elapsedSince(const ros::Time& start) const;
+  /// Whether trajectories are executed instantly
+  bool instant() const
+  {
+    return speedup_ <= 0.0;
+  }
+
   std::vector<std::string> joints_;
   const ros::Publisher& pub_;
+  double speedup_;  // how many times faster than real time trajectories are executed, 0 for instant execution
 };
 
 class LastPointController : public BaseFakeController
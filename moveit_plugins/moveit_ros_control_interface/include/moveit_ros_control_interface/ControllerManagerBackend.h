@@ -0,0 +1,76 @@
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2026, PickNik LLC.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of PickNik LLC nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *********************************************************************/
+
+#pragma once
+
+#include <controller_manager_msgs/ListControllers.h>
+#include <controller_manager_msgs/SwitchController.h>
+#include <moveit/macros/class_forward.h>
+
+#include <string>
+
+namespace moveit_ros_control_interface
+{
+MOVEIT_CLASS_FORWARD(ControllerManagerBackend);  // Defines ControllerManagerBackendPtr, ConstPtr, WeakPtr... etc
+
+/**
+ * \brief Access to the list_controllers and switch_controller functionality of a ros_control controller_manager.
+ * By default, MoveItControllerManager calls the services of the controller_manager through persistent connections.
+ */
+class ControllerManagerBackend
+{
+public:
+  virtual bool listControllers(controller_manager_msgs::ListControllers::Request& req,
+                               controller_manager_msgs::ListControllers::Response& res) = 0;
+  virtual bool switchController(controller_manager_msgs::SwitchController::Request& req,
+                                controller_manager_msgs::SwitchController::Response& res) = 0;
+  virtual ~ControllerManagerBackend()
+  {
+  }
+};
+
+/**
+ * \brief Register \e backend for the controller_manager in namespace \e ns (as given to MoveItControllerManager,
+ * without the controller_manager/ part). A process hosting both move_group and the controller_manager can register a
+ * backend that calls the controller_manager directly, which MoveItControllerManager instances for \e ns created
+ * afterwards use instead of service calls. Registering a null pointer removes the backend.
+ */
+void registerControllerManagerBackend(const std::string& ns, const ControllerManagerBackendPtr& backend);
+
+/**
+ * \brief Get the backend registered for namespace \e ns, or a null pointer
+ */
+ControllerManagerBackendPtr getControllerManagerBackend(const std::string& ns);
+
+}  // namespace moveit_ros_control_interface
@@ -0,0 +1,80 @@
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2026, PickNik LLC.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of PickNik LLC nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *********************************************************************/
+
+#include <moveit_ros_control_interface/ControllerManagerBackend.h>
+#include <ros/names.h>
+
+#include <map>
+#include <mutex>
+
+namespace moveit_ros_control_interface
+{
+namespace
+{
+std::mutex& backendsMutex()
+{
+  static std::mutex mutex;
+  return mutex;
+}
+
+std::map<std::string, ControllerManagerBackendPtr>& backends()
+{
+  static std::map<std::string, ControllerManagerBackendPtr> backends;
+  return backends;
+}
+
+// namespaces are compared in their clean form, so that e.g. "/robot" and "/robot/" match
+std::string backendKey(const std::string& ns)
+{
+  return ros::names::clean(ns);
+}
+}  // namespace
+
+void registerControllerManagerBackend(const std::string& ns, const ControllerManagerBackendPtr& backend)
+{
+  std::lock_guard<std::mutex> lock(backendsMutex());
+  if (backend)
+    backends()[backendKey(ns)] = backend;
+  else
+    backends().erase(backendKey(ns));
+}
+
+ControllerManagerBackendPtr getControllerManagerBackend(const std::string& ns)
+{
+  std::lock_guard<std::mutex> lock(backendsMutex());
+  auto it = backends().find(backendKey(ns));
+  return it != backends().end() ? it->second : ControllerManagerBackendPtr();
+}
+
+}  // namespace moveit_ros_control_interface
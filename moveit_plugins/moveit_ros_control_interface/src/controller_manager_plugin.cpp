@@ -39,6 +39,7 @@
 #include <moveit/macros/class_forward.h>
 
 #include <moveit_ros_control_interface/ControllerHandle.h>
+#include <moveit_ros_control_interface/ControllerManagerBackend.h>
 
 #include <moveit/controller_manager/controller_manager.h>
 
@@ -73,6 +74,51 @@ bool checkTimeout(ros::Time& t, double timeout, bool force = false)
   return false;
 }
 
+/**
+ * \brief Calls the services of a controller_manager, keeping the connections open between calls
+ */
+class ServiceControllerManagerBackend : public ControllerManagerBackend
+{
+  ros::NodeHandle nh_;
+  const std::string list_service_;
+  const std::string switch_service_;
+  ros::ServiceClient list_client_;
+  ros::ServiceClient switch_client_;
+
+  /**
+   * \brief Call a service through a persistent client, which is (re)connected if needed
+   */
+  template <typename Request, typename Response>
+  bool call(ros::ServiceClient& client, const std::string& service, Request& req, Response& res)
+  {
+    if (!client.isValid())
+      client = nh_.serviceClient<Request, Response>(service, true);
+    if (client.call(req, res))
+      return true;
+    // the connection might have been established with a previous instance of the controller_manager
+    client = nh_.serviceClient<Request, Response>(service, true);
+    return client.call(req, res);
+  }
+
+public:
+  ServiceControllerManagerBackend(const std::string& list_service, const std::string& switch_service)
+    : list_service_(list_service), switch_service_(switch_service)
+  {
+  }
+
+  bool listControllers(controller_manager_msgs::ListControllers::Request& req,
+                       controller_manager_msgs::ListControllers::Response& res) override
+  {
+    return call(list_client_, list_service_, req, res);
+  }
+
+  bool switchController(controller_manager_msgs::SwitchController::Request& req,
+                        controller_manager_msgs::SwitchController::Response& res) override
+  {
+    return call(switch_client_, switch_service_, req, res);
+  }
+};
+
 MOVEIT_CLASS_FORWARD(MoveItControllerManager);  // Defines MoveItControllerManagerPtr, ConstPtr, WeakPtr... etc
 
 /**
@@ -97,6 +143,8 @@ class MoveItControllerManager : public moveit_controller_manager::MoveItControll
   ros::Time controllers_stamp_;
   boost::mutex controllers_mutex_;
 
+  ControllerManagerBackendPtr backend_;
+
   /**
    * \brief Check if given controller is active
    * @param s state of controller
@@ -119,7 +167,7 @@ class MoveItControllerManager : public moveit_controller_manager::MoveItControll
       return;
 
     controller_manager_msgs::ListControllers srv;
-    if (!ros::service::call(getAbsName("controller_manager/list_controllers"), srv))
+    if (!backend_->listControllers(srv.request, srv.response))
     {
       ROS_WARN_STREAM("Failed to read controllers from " << ns_ << "controller_manager/list_controllers");
     }
@@ -184,6 +232,19 @@ class MoveItControllerManager : public moveit_controller_manager::MoveItControll
     return ros::names::append(ns_, name);
   }
 
+  /**
+   * \brief Use the backend registered for ns_, or call the services of the controller_manager
+   */
+  void initBackend()
+  {
+    backend_ = getControllerManagerBackend(ns_);
+    if (backend_)
+      ROS_INFO_STREAM("Using the in-process controller_manager backend registered for " << ns_);
+    else
+      backend_ = std::make_shared<ServiceControllerManagerBackend>(getAbsName("controller_manager/list_controllers"),
+                                                                   getAbsName("controller_manager/switch_controller"));
+  }
+
 public:
   /**
    * \brief The default constructor. Reads the namespace from ~ros_control_namespace param and defaults to /
@@ -193,6 +254,7 @@ public:
     , loader_("moveit_ros_control_interface", "moveit_ros_control_interface::ControllerHandleAllocator")
   {
     ROS_INFO_STREAM("Started moveit_ros_control_interface::MoveItControllerManager for namespace " << ns_);
+    initBackend();
   }
 
   /**
@@ -202,6 +264,7 @@ public:
   MoveItControllerManager(const std::string& ns)
     : ns_(ns), loader_("moveit_ros_control_interface", "moveit_ros_control_interface::ControllerHandleAllocator")
   {
+    initBackend();
   }
 
   /**
@@ -357,7 +420,7 @@ public:
 
     if (!srv.request.start_controllers.empty() || !srv.request.stop_controllers.empty())
     {  // something to switch?
-      if (!ros::service::call(getAbsName("controller_manager/switch_controller"), srv))
+      if (!backend_->switchController(srv.request, srv.response))
       {
         ROS_ERROR_STREAM("Could switch controllers at " << ns_);
       }
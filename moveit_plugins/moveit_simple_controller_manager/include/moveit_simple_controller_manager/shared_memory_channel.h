@@ -0,0 +1,137 @@
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2026, PickNik LLC.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of PickNik LLC nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *********************************************************************/
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+namespace moveit_simple_controller_manager
+{
+/*
+ * Layout of the shared memory segment through which a controller running on the same host executes trajectories.
+ * The controller creates and initializes the segment, MoveIt opens it. Both sides only rely on lock-free atomics,
+ * so neither can block the other.
+ *
+ * To send a trajectory, MoveIt stores its start time and point count, then publishes a new goal_id and streams the
+ * points, tagged with that id, through the points ring buffer. The controller replaces its trajectory whenever
+ * goal_id changes and drops points of older goals. It reports progress through the feedback ring buffer and the
+ * outcome by storing status and then status_goal_id. Cancelling a goal stores its id in cancel_goal_id.
+ */
+namespace shared_memory
+{
+constexpr std::uint32_t CHANNEL_VERSION = 1;
+constexpr std::size_t MAX_JOINTS = 32;
+constexpr std::size_t MAX_JOINT_NAME_LENGTH = 64;  // including the terminating null character
+constexpr std::size_t POINT_CAPACITY = 256;
+constexpr std::size_t FEEDBACK_CAPACITY = 64;
+
+/* Single-producer single-consumer ring buffer of trivially copyable items */
+template <typename T, std::size_t N>
+struct RingBuffer
+{
+  std::atomic<std::uint64_t> head;  // index of the next item to read, only written by the consumer
+  std::atomic<std::uint64_t> tail;  // index of the next item to write, only written by the producer
+  T items[N];
+
+  bool push(const T& item)
+  {
+    const std::uint64_t tail_index = tail.load(std::memory_order_relaxed);
+    if (tail_index - head.load(std::memory_order_acquire) >= N)
+      return false;
+    items[tail_index % N] = item;
+    tail.store(tail_index + 1, std::memory_order_release);
+    return true;
+  }
+
+  bool pop(T& item)
+  {
+    const std::uint64_t head_index = head.load(std::memory_order_relaxed);
+    if (head_index == tail.load(std::memory_order_acquire))
+      return false;
+    item = items[head_index % N];
+    head.store(head_index + 1, std::memory_order_release);
+    return true;
+  }
+};
+
+/* Joint values are ordered as the joint names of the channel */
+struct TrajectoryPoint
+{
+  std::uint64_t goal_id;
+  std::uint32_t index;  // index of the point within its trajectory
+  double time_from_start;
+  double positions[MAX_JOINTS];
+  double velocities[MAX_JOINTS];
+  double accelerations[MAX_JOINTS];
+};
+
+struct Feedback
+{
+  std::uint64_t goal_id;
+  double time_from_start;  // of the desired state
+  double position_errors[MAX_JOINTS];
+};
+
+enum GoalStatus : std::int32_t
+{
+  ACTIVE = 0,
+  SUCCEEDED = 1,
+  ABORTED = 2,
+  PREEMPTED = 3
+};
+
+struct Channel
+{
+  /* written once by the controller, before setting ready */
+  std::uint32_t version;
+  std::uint32_t joint_count;
+  char joint_names[MAX_JOINTS][MAX_JOINT_NAME_LENGTH];
+  std::atomic<bool> ready;
+
+  /* written by MoveIt */
+  std::atomic<std::uint64_t> goal_id;
+  std::atomic<std::int64_t> goal_start_time;  // ROS time in nanoseconds, 0 to start right away
+  std::atomic<std::uint32_t> goal_point_count;
+  std::atomic<std::uint64_t> cancel_goal_id;
+  RingBuffer<TrajectoryPoint, POINT_CAPACITY> points;
+
+  /* written by the controller */
+  std::atomic<std::int32_t> status;
+  std::atomic<std::uint64_t> status_goal_id;
+  RingBuffer<Feedback, FEEDBACK_CAPACITY> feedback;
+};
+}  // namespace shared_memory
+}  // namespace moveit_simple_controller_manager
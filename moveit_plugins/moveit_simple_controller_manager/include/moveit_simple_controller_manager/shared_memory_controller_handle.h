@@ -0,0 +1,102 @@
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2026, PickNik LLC.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of PickNik LLC nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *********************************************************************/
+
+#pragma once
+
+#include <moveit_simple_controller_manager/action_based_controller_handle.h>
+#include <moveit_simple_controller_manager/shared_memory_channel.h>
+#include <boost/interprocess/shared_memory_object.hpp>
+#include <boost/interprocess/mapped_region.hpp>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+namespace moveit_simple_controller_manager
+{
+/*
+ * Executes joint trajectories on a controller running on the same host, by streaming them through a shared memory
+ * segment (see shared_memory_channel.h) instead of sending FollowJointTrajectory action goals.
+ */
+class SharedMemoryControllerHandle : public ActionBasedControllerHandleBase
+{
+public:
+  SharedMemoryControllerHandle(const std::string& name, const std::string& segment_name);
+  ~SharedMemoryControllerHandle() override;
+
+  bool isConnected() const
+  {
+    return channel_ != nullptr;
+  }
+
+  bool sendTrajectory(const moveit_msgs::RobotTrajectory& trajectory) override;
+  bool cancelExecution() override;
+  bool waitForExecution(const ros::Duration& timeout = ros::Duration(0)) override;
+  moveit_controller_manager::ExecutionStatus getLastExecutionStatus() override;
+
+  void addJoint(const std::string& name) override;
+  void getJoints(std::vector<std::string>& joints) override;
+  void configure(XmlRpc::XmlRpcValue& config) override;
+
+private:
+  bool openChannel(const std::string& segment_name);
+
+  /* push as many pending points as fit into the ring buffer; requires mutex_ */
+  void pushPendingPoints();
+
+  /* stream pending points and watch for feedback and the goal status */
+  void pollChannel();
+
+  boost::interprocess::shared_memory_object segment_;
+  boost::interprocess::mapped_region region_;
+  shared_memory::Channel* channel_ = nullptr;
+  std::vector<std::string> channel_joints_;
+
+  std::vector<std::string> joints_;
+
+  std::mutex mutex_;
+  std::condition_variable done_condition_;
+  std::vector<shared_memory::TrajectoryPoint> pending_points_;
+  std::size_t next_point_ = 0;
+  std::uint64_t goal_id_ = 0;
+  bool done_ = true;
+  moveit_controller_manager::ExecutionStatus last_exec_ = moveit_controller_manager::ExecutionStatus::SUCCEEDED;
+
+  std::chrono::microseconds poll_period_{ 500 };
+  std::atomic<bool> stop_{ false };
+  std::thread poll_thread_;
+};
+
+}  // end namespace moveit_simple_controller_manager
@@ -214,8 +214,13 @@ void FollowJointTrajectoryControllerHandle::controllerActiveCallback()
 }
 
 void FollowJointTrajectoryControllerHandle::controllerFeedbackCallback(
-    const control_msgs::FollowJointTrajectoryFeedbackConstPtr& /* feedback */)
+    const control_msgs::FollowJointTrajectoryFeedbackConstPtr& feedback)
 {
+  moveit_controller_manager::ExecutionProgress progress;
+  progress.time_from_start = feedback->desired.time_from_start;
+  progress.joint_names = feedback->joint_names;
+  progress.position_errors = feedback->error.positions;
+  reportProgress(progress);
 }
 
 }  // end namespace moveit_simple_controller_manager
@@ -39,6 +39,7 @@
 #include <moveit_simple_controller_manager/action_based_controller_handle.h>
 #include <moveit_simple_controller_manager/gripper_controller_handle.h>
 #include <moveit_simple_controller_manager/follow_joint_trajectory_controller_handle.h>
+#include <moveit_simple_controller_manager/shared_memory_controller_handle.h>
 #include <moveit/utils/xmlrpc_casts.h>
 #include <pluginlib/class_list_macros.hpp>
 #include <algorithm>
@@ -126,6 +127,26 @@ public:
             controllers_[name] = new_handle;
           }
         }
+        else if (type == "FollowJointTrajectory" && controller_list[i].hasMember("transport") &&
+                 std::string(controller_list[i]["transport"]) == "shared_memory")
+        {
+          // controllers on the same host can be reached through shared memory instead of an action server
+          std::string segment_name;
+          if (controller_list[i].hasMember("segment_name"))
+            segment_name = std::string(controller_list[i]["segment_name"]);
+          else
+          {
+            segment_name = name + "_" + action_ns;
+            std::replace(segment_name.begin(), segment_name.end(), '/', '_');
+          }
+          auto h = new SharedMemoryControllerHandle(name, segment_name);
+          new_handle.reset(h);
+          if (h->isConnected())
+          {
+            ROS_INFO_STREAM_NAMED(LOGNAME, "Added shared memory FollowJointTrajectory controller for " << name);
+            controllers_[name] = new_handle;
+          }
+        }
         else if (type == "FollowJointTrajectory")
         {
           auto h = new FollowJointTrajectoryControllerHandle(name, action_ns);
@@ -0,0 +1,300 @@
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2026, PickNik LLC.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of PickNik LLC nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *********************************************************************/
+
+#include <moveit_simple_controller_manager/shared_memory_controller_handle.h>
+#include <moveit/utils/xmlrpc_casts.h>
+#include <algorithm>
+#include <cstring>
+
+using namespace moveit::core;
+static const std::string LOGNAME("SimpleControllerManager");
+
+namespace moveit_simple_controller_manager
+{
+SharedMemoryControllerHandle::SharedMemoryControllerHandle(const std::string& name, const std::string& segment_name)
+  : ActionBasedControllerHandleBase(name)
+{
+  // like for action servers, wait for the controller to create the segment
+  ros::NodeHandle nh("~");
+  double timeout;
+  nh.param("trajectory_execution/controller_connection_timeout", timeout, 15.0);
+  const ros::WallTime deadline = ros::WallTime::now() + ros::WallDuration(timeout);
+  while (!openChannel(segment_name) && ros::ok() && (timeout == 0.0 || ros::WallTime::now() < deadline))
+  {
+    ROS_WARN_STREAM_NAMED(LOGNAME, "Waiting for shared memory segment " << segment_name << " to come up");
+    ros::WallDuration(1.0).sleep();
+  }
+  if (!channel_)
+  {
+    ROS_ERROR_STREAM_NAMED(LOGNAME, "Shared memory segment not connected: " << segment_name);
+    return;
+  }
+
+  // continue the goal ids of the controller, so that a restarted MoveIt does not reuse them
+  goal_id_ = channel_->goal_id.load();
+  poll_thread_ = std::thread([this] { pollChannel(); });
+}
+
+SharedMemoryControllerHandle::~SharedMemoryControllerHandle()
+{
+  stop_ = true;
+  if (poll_thread_.joinable())
+    poll_thread_.join();
+}
+
+bool SharedMemoryControllerHandle::openChannel(const std::string& segment_name)
+{
+  try
+  {
+    segment_ = boost::interprocess::shared_memory_object(boost::interprocess::open_only, segment_name.c_str(),
+                                                         boost::interprocess::read_write);
+    region_ = boost::interprocess::mapped_region(segment_, boost::interprocess::read_write);
+  }
+  catch (boost::interprocess::interprocess_exception& ex)
+  {
+    ROS_DEBUG_STREAM_NAMED(LOGNAME, "Cannot open shared memory segment " << segment_name << ": " << ex.what());
+    return false;
+  }
+  if (region_.get_size() < sizeof(shared_memory::Channel))
+  {
+    ROS_DEBUG_STREAM_NAMED(LOGNAME, "Shared memory segment " << segment_name << " is too small");
+    return false;
+  }
+
+  auto* channel = static_cast<shared_memory::Channel*>(region_.get_address());
+  if (!channel->ready.load(std::memory_order_acquire))
+    return false;
+  if (channel->version != shared_memory::CHANNEL_VERSION || channel->joint_count > shared_memory::MAX_JOINTS)
+  {
+    ROS_ERROR_STREAM_NAMED(LOGNAME, "Shared memory segment " << segment_name << " has version " << channel->version
+                                                             << ", expected " << shared_memory::CHANNEL_VERSION);
+    return false;
+  }
+  if (!channel->goal_id.is_lock_free() || !channel->points.tail.is_lock_free())
+  {
+    ROS_ERROR_NAMED(LOGNAME, "Shared memory controllers need lock-free 64 bit atomics");
+    return false;
+  }
+
+  channel_joints_.clear();
+  for (std::uint32_t i = 0; i < channel->joint_count; ++i)
+    channel_joints_.emplace_back(channel->joint_names[i],
+                                 strnlen(channel->joint_names[i], shared_memory::MAX_JOINT_NAME_LENGTH));
+  channel_ = channel;
+  return true;
+}
+
+void SharedMemoryControllerHandle::addJoint(const std::string& name)
+{
+  joints_.push_back(name);
+}
+
+void SharedMemoryControllerHandle::getJoints(std::vector<std::string>& joints)
+{
+  joints = joints_;
+}
+
+void SharedMemoryControllerHandle::configure(XmlRpc::XmlRpcValue& config)
+{
+  if (config.hasMember("poll_period"))
+    poll_period_ = std::chrono::microseconds(static_cast<int64_t>(parseDouble(config["poll_period"]) * 1e6));
+
+  for (const std::string& joint : joints_)
+    if (std::find(channel_joints_.begin(), channel_joints_.end(), joint) == channel_joints_.end())
+      ROS_WARN_NAMED(LOGNAME, "Joint '%s' of controller '%s' is not driven through its shared memory segment",
+                     joint.c_str(), name_.c_str());
+}
+
+bool SharedMemoryControllerHandle::sendTrajectory(const moveit_msgs::RobotTrajectory& trajectory)
+{
+  ROS_DEBUG_STREAM_NAMED(LOGNAME, "new trajectory to " << name_);
+
+  if (!channel_)
+    return false;
+
+  if (!trajectory.multi_dof_joint_trajectory.points.empty())
+  {
+    ROS_WARN_NAMED(LOGNAME, "%s cannot execute multi-dof trajectories.", name_.c_str());
+  }
+
+  // the controller expects values for all of its joints, in the order of the channel
+  const trajectory_msgs::JointTrajectory& joint_trajectory = trajectory.joint_trajectory;
+  std::vector<std::size_t> source_index(channel_joints_.size());
+  for (std::size_t i = 0; i < channel_joints_.size(); ++i)
+  {
+    auto it = std::find(joint_trajectory.joint_names.begin(), joint_trajectory.joint_names.end(), channel_joints_[i]);
+    if (it == joint_trajectory.joint_names.end())
+    {
+      ROS_ERROR_NAMED(LOGNAME, "Trajectory for controller '%s' does not specify joint '%s'", name_.c_str(),
+                      channel_joints_[i].c_str());
+      return false;
+    }
+    source_index[i] = it - joint_trajectory.joint_names.begin();
+  }
+
+  std::vector<shared_memory::TrajectoryPoint> points(joint_trajectory.points.size());
+  for (std::size_t k = 0; k < points.size(); ++k)
+  {
+    const trajectory_msgs::JointTrajectoryPoint& source = joint_trajectory.points[k];
+    shared_memory::TrajectoryPoint& point = points[k];
+    point.index = k;
+    point.time_from_start = source.time_from_start.toSec();
+    for (std::size_t i = 0; i < source_index.size(); ++i)
+    {
+      const std::size_t j = source_index[i];
+      point.positions[i] = source.positions[j];
+      point.velocities[i] = j < source.velocities.size() ? source.velocities[j] : 0.0;
+      point.accelerations[i] = j < source.accelerations.size() ? source.accelerations[j] : 0.0;
+    }
+  }
+
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (done_)
+    ROS_DEBUG_STREAM_NAMED(LOGNAME, "sending trajectory to " << name_);
+  else
+    ROS_DEBUG_STREAM_NAMED(LOGNAME, "sending replacement for the currently executed trajectory to " << name_);
+
+  ++goal_id_;
+  for (shared_memory::TrajectoryPoint& point : points)
+    point.goal_id = goal_id_;
+  pending_points_.swap(points);
+  next_point_ = 0;
+
+  channel_->goal_start_time.store(joint_trajectory.header.stamp.toNSec(), std::memory_order_relaxed);
+  channel_->goal_point_count.store(pending_points_.size(), std::memory_order_relaxed);
+  channel_->goal_id.store(goal_id_, std::memory_order_release);
+  pushPendingPoints();
+
+  done_ = false;
+  last_exec_ = moveit_controller_manager::ExecutionStatus::RUNNING;
+  return true;
+}
+
+void SharedMemoryControllerHandle::pushPendingPoints()
+{
+  while (next_point_ < pending_points_.size() && channel_->points.push(pending_points_[next_point_]))
+    ++next_point_;
+}
+
+bool SharedMemoryControllerHandle::cancelExecution()
+{
+  if (!channel_)
+    return false;
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (!done_)
+  {
+    ROS_INFO_STREAM_NAMED(LOGNAME, "Cancelling execution for " << name_);
+    channel_->cancel_goal_id.store(goal_id_, std::memory_order_release);
+    pending_points_.clear();
+    last_exec_ = moveit_controller_manager::ExecutionStatus::PREEMPTED;
+    done_ = true;
+    done_condition_.notify_all();
+  }
+  return true;
+}
+
+bool SharedMemoryControllerHandle::waitForExecution(const ros::Duration& timeout)
+{
+  std::unique_lock<std::mutex> lock(mutex_);
+  const ros::WallTime deadline = ros::WallTime::now() + ros::WallDuration(timeout.toSec());
+  // wait in slices, to notice shutdown
+  while (!done_ && ros::ok())
+  {
+    if (timeout > ros::Duration(0) && ros::WallTime::now() >= deadline)
+      return false;
+    done_condition_.wait_for(lock, std::chrono::milliseconds(100));
+  }
+  return done_;
+}
+
+moveit_controller_manager::ExecutionStatus SharedMemoryControllerHandle::getLastExecutionStatus()
+{
+  std::lock_guard<std::mutex> lock(mutex_);
+  return last_exec_;
+}
+
+void SharedMemoryControllerHandle::pollChannel()
+{
+  shared_memory::Feedback feedback;
+  while (!stop_)
+  {
+    std::uint64_t goal_id;
+    bool done;
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      pushPendingPoints();
+      goal_id = goal_id_;
+      done = done_;
+    }
+
+    // feedback is consumed even when not executing, to keep the ring buffer from filling up with stale entries
+    while (channel_->feedback.pop(feedback))
+    {
+      if (done || feedback.goal_id != goal_id)
+        continue;
+      moveit_controller_manager::ExecutionProgress progress;
+      progress.time_from_start = ros::Duration(feedback.time_from_start);
+      progress.joint_names = channel_joints_;
+      progress.position_errors.assign(feedback.position_errors, feedback.position_errors + channel_joints_.size());
+      reportProgress(progress);
+    }
+
+    if (!done && channel_->status_goal_id.load(std::memory_order_acquire) == goal_id)
+    {
+      const std::int32_t status = channel_->status.load(std::memory_order_relaxed);
+      if (status != shared_memory::ACTIVE)
+      {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!done_ && goal_id_ == goal_id)  // unless cancelled or replaced meanwhile
+        {
+          ROS_DEBUG_STREAM_NAMED(LOGNAME, "Controller " << name_ << " is done with status " << status);
+          if (status == shared_memory::SUCCEEDED)
+            last_exec_ = moveit_controller_manager::ExecutionStatus::SUCCEEDED;
+          else if (status == shared_memory::ABORTED)
+            last_exec_ = moveit_controller_manager::ExecutionStatus::ABORTED;
+          else if (status == shared_memory::PREEMPTED)
+            last_exec_ = moveit_controller_manager::ExecutionStatus::PREEMPTED;
+          else
+            last_exec_ = moveit_controller_manager::ExecutionStatus::FAILED;
+          done_ = true;
+          done_condition_.notify_all();
+        }
+      }
+    }
+
+    std::this_thread::sleep_for(poll_period_);
+  }
+}
+
+}  // end namespace moveit_simple_controller_manager
@@ -58,6 +58,9 @@ namespace moveit_ros_benchmarks
 {
 /// A class that executes motion plan requests and aggregates data across multiple runs
 /// Note: This class operates outside of MoveGroup and does NOT use PlanningRequestAdapters
+/// If the benchmark is configured with num_threads > 1, the runs of all planners of a query are distributed over worker
+/// threads, each with its own planning pipelines and copy of the planning scene. Pre-run and post-run events are then
+/// invoked concurrently from the worker threads; all other events are invoked from the calling thread.
 class BenchmarkExecutor
 {
 public:
@@ -198,6 +201,21 @@ protected:
   void runBenchmark(moveit_msgs::MotionPlanRequest request,
                     const std::map<std::string, std::vector<std::string>>& planners, int runs);
 
+  /// Execute the given motion plan request like runBenchmark(), distributing the runs over the worker threads
+  void runBenchmarkParallel(const moveit_msgs::MotionPlanRequest& request,
+                            const std::map<std::string, std::vector<std::string>>& planners, int runs);
+
+  /// Solve a single run of a benchmark request, using \e context if given and the full \e pipeline otherwise, and
+  /// collect its metrics in \e run_data. Returns whether the request was solved.
+  bool runPlanner(const planning_pipeline::PlanningPipelinePtr& pipeline,
+                  const planning_scene::PlanningSceneConstPtr& scene,
+                  const planning_interface::PlanningContextPtr& context, moveit_msgs::MotionPlanRequest& request,
+                  planning_interface::MotionPlanDetailedResponse& response, PlannerRunData& run_data);
+
+  /// Load the planning pipelines configured in the given child namespaces of the private node handle
+  std::map<std::string, planning_pipeline::PlanningPipelinePtr>
+  loadPlanningPipelines(const std::vector<std::string>& planning_pipeline_names);
+
   planning_scene_monitor::PlanningSceneMonitor* psm_;
   moveit_warehouse::PlanningSceneStorage* pss_;
   moveit_warehouse::PlanningSceneWorldStorage* psws_;
@@ -211,6 +229,10 @@ protected:
   BenchmarkOptions options_;
 
   std::map<std::string, planning_pipeline::PlanningPipelinePtr> planning_pipelines_;
+  std::vector<std::string> planning_pipeline_names_;
+
+  /// Planning pipelines of each worker thread of runBenchmarkParallel(); the first worker uses planning_pipelines_
+  std::vector<std::map<std::string, planning_pipeline::PlanningPipelinePtr>> worker_pipelines_;
 
   std::vector<PlannerBenchmarkData> benchmark_data_;
 
@@ -35,6 +35,8 @@
 /* Author: Ryan Luna */
 
 #include <moveit/benchmarks/BenchmarkExecutor.h>
+#include <moveit/benchmarks/AllocationCounter.h>
+#include <moveit/profiler/trace.h>
 #include <moveit/utils/lexical_casts.h>
 #include <moveit/version.h>
 #include <tf2_eigen/tf2_eigen.h>
@@ -47,7 +49,15 @@
 #include <boost/math/constants/constants.hpp>
 #include <boost/filesystem.hpp>
 #include <boost/date_time/posix_time/posix_time.hpp>
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <cstdlib>
+#include <fstream>
+#include <mutex>
+#include <thread>
 #ifndef _WIN32
+#include <sys/resource.h>
 #include <unistd.h>
 #else
 #include <winsock2.h>
@@ -69,6 +79,39 @@ static std::string getHostname()
   }
 }
 
+// Replace the characters that are not allowed in the column names of the benchmark log
+static std::string toMetricName(std::string name)
+{
+  std::replace_if(
+      name.begin(), name.end(), [](char c) { return !std::isalnum(static_cast<unsigned char>(c)); }, '_');
+  return name;
+}
+
+// Reset the peak resident set size of the process to the current one, where the kernel supports it
+static void resetPeakMemory()
+{
+  std::ofstream clear_refs("/proc/self/clear_refs");
+  if (clear_refs)
+    clear_refs << "5";
+}
+
+// Return the peak resident set size of the process in kB, or -1 if it is unknown
+static long getPeakMemory()
+{
+  std::ifstream status("/proc/self/status");
+  std::string line;
+  while (std::getline(status, line))
+    if (line.compare(0, 6, "VmHWM:") == 0)
+      return std::strtol(line.c_str() + 6, nullptr, 10);
+#ifndef _WIN32
+  // never reset, so this is the peak over the lifetime of the process
+  struct rusage usage;
+  if (getrusage(RUSAGE_SELF, &usage) == 0)
+    return usage.ru_maxrss;
+#endif
+  return -1;
+}
+
 BenchmarkExecutor::BenchmarkExecutor(const std::string& robot_description_param)
 {
   pss_ = nullptr;
@@ -92,7 +135,25 @@ BenchmarkExecutor::~BenchmarkExecutor()
 
 void BenchmarkExecutor::initialize(const std::vector<std::string>& planning_pipeline_names)
 {
-  planning_pipelines_.clear();
+  planning_pipeline_names_ = planning_pipeline_names;
+  planning_pipelines_ = loadPlanningPipelines(planning_pipeline_names);
+  worker_pipelines_.clear();
+
+  // Error check
+  if (planning_pipelines_.empty())
+    ROS_ERROR("No planning pipelines have been loaded. Nothing to do for the benchmarking service.");
+  else
+  {
+    ROS_INFO("Available planning pipelines:");
+    for (const std::pair<const std::string, planning_pipeline::PlanningPipelinePtr>& entry : planning_pipelines_)
+      ROS_INFO_STREAM("Pipeline: " << entry.first << ", Planner: " << entry.second->getPlannerPluginName());
+  }
+}
+
+std::map<std::string, planning_pipeline::PlanningPipelinePtr>
+BenchmarkExecutor::loadPlanningPipelines(const std::vector<std::string>& planning_pipeline_names)
+{
+  std::map<std::string, planning_pipeline::PlanningPipelinePtr> planning_pipelines;
 
   ros::NodeHandle pnh("~");
   for (const std::string& planning_pipeline_name : planning_pipeline_names)
@@ -112,18 +173,9 @@ void BenchmarkExecutor::initialize(const std::vector<std::string>& planning_pipe
     // Disable visualizations and store pipeline
     pipeline->displayComputedMotionPlans(false);
     pipeline->checkSolutionPaths(false);
-    planning_pipelines_[planning_pipeline_name] = pipeline;
-  }
-
-  // Error check
-  if (planning_pipelines_.empty())
-    ROS_ERROR("No planning pipelines have been loaded. Nothing to do for the benchmarking service.");
-  else
-  {
-    ROS_INFO("Available planning pipelines:");
-    for (const std::pair<const std::string, planning_pipeline::PlanningPipelinePtr>& entry : planning_pipelines_)
-      ROS_INFO_STREAM("Pipeline: " << entry.first << ", Planner: " << entry.second->getPlannerPluginName());
+    planning_pipelines[planning_pipeline_name] = pipeline;
   }
+  return planning_pipelines;
 }
 
 void BenchmarkExecutor::clear()
@@ -209,6 +261,30 @@ bool BenchmarkExecutor::runBenchmarks(const BenchmarkOptions& opts)
     if (!queriesAndPlannersCompatible(queries, opts.getPlanningPipelineConfigurations()))
       return false;
 
+    // Planners are not thread-safe, so every worker thread gets its own set of planning pipelines
+    std::size_t num_workers = std::max(1, options_.getNumThreads());
+    if (num_workers > 1 && worker_pipelines_.size() != num_workers)
+    {
+      ROS_INFO("Loading planning pipelines for %zu worker threads", num_workers);
+      worker_pipelines_.resize(1);
+      worker_pipelines_[0] = planning_pipelines_;
+      while (worker_pipelines_.size() < num_workers)
+      {
+        worker_pipelines_.push_back(loadPlanningPipelines(planning_pipeline_names_));
+        if (worker_pipelines_.back().size() != planning_pipelines_.size())
+        {
+          ROS_ERROR("Failed to load the planning pipelines of worker thread %zu", worker_pipelines_.size() - 1);
+          worker_pipelines_.clear();
+          return false;
+        }
+      }
+    }
+
+    // the trace zones count collision checks and forward kinematics for the run metrics
+    moveit::tools::TraceRecorder& trace = moveit::tools::TraceRecorder::instance();
+    const bool was_recording = trace.recording();
+    trace.start();
+
     for (std::size_t i = 0; i < queries.size(); ++i)
     {
       // Configure planning scene
@@ -230,7 +306,10 @@ bool BenchmarkExecutor::runBenchmarks(const BenchmarkOptions& opts)
 
       ROS_INFO("Benchmarking query '%s' (%lu of %lu)", queries[i].name.c_str(), i + 1, queries.size());
       ros::WallTime start_time = ros::WallTime::now();
-      runBenchmark(queries[i].request, options_.getPlanningPipelineConfigurations(), options_.getNumRuns());
+      if (num_workers > 1)
+        runBenchmarkParallel(queries[i].request, options_.getPlanningPipelineConfigurations(), options_.getNumRuns());
+      else
+        runBenchmark(queries[i].request, options_.getPlanningPipelineConfigurations(), options_.getNumRuns());
       double duration = (ros::WallTime::now() - start_time).toSec();
 
       for (QueryCompletionEventFunction& query_end_fn : query_end_fns_)
@@ -239,6 +318,8 @@ bool BenchmarkExecutor::runBenchmarks(const BenchmarkOptions& opts)
       writeOutput(queries[i], boost::posix_time::to_iso_extended_string(start_time.toBoost()), duration);
     }
 
+    if (!was_recording)
+      trace.stop();
     return true;
   }
   return false;
@@ -599,10 +680,12 @@ bool BenchmarkExecutor::loadQueries(const std::string& regex, const std::string&
   if (regex.empty())
     return true;
 
+  // fetching all queries of the scene at once is much faster than one by one on large databases
+  std::vector<moveit_warehouse::MotionPlanRequestWithMetadata> planning_queries;
   std::vector<std::string> query_names;
   try
   {
-    pss_->getPlanningQueriesNames(regex, query_names, scene_name);
+    pss_->getPlanningQueries(regex, planning_queries, query_names, scene_name);
   }
   catch (std::exception& ex)
   {
@@ -616,22 +699,11 @@ bool BenchmarkExecutor::loadQueries(const std::string& regex, const std::string&
     return false;
   }
 
-  for (const std::string& query_name : query_names)
+  for (std::size_t i = 0; i < planning_queries.size(); ++i)
   {
-    moveit_warehouse::MotionPlanRequestWithMetadata planning_query;
-    try
-    {
-      pss_->getPlanningQuery(planning_query, scene_name, query_name);
-    }
-    catch (std::exception& ex)
-    {
-      ROS_ERROR("Error loading motion planning query '%s': %s", query_name.c_str(), ex.what());
-      continue;
-    }
-
     BenchmarkRequest query;
-    query.name = query_name;
-    query.request = static_cast<moveit_msgs::MotionPlanRequest>(*planning_query);
+    query.name = query_names[i];
+    query.request = static_cast<moveit_msgs::MotionPlanRequest>(*planning_queries[i]);
     queries.push_back(query);
   }
   ROS_INFO("Loaded queries successfully");
@@ -642,31 +714,23 @@ bool BenchmarkExecutor::loadStates(const std::string& regex, std::vector<StartSt
 {
   if (!regex.empty())
   {
-    boost::regex start_regex(regex);
+    std::vector<moveit_warehouse::RobotStateWithMetadata> robot_states;
     std::vector<std::string> state_names;
-    rs_->getKnownRobotStates(state_names);
-    for (const std::string& state_name : state_names)
+    try
     {
-      boost::cmatch match;
-      if (boost::regex_match(state_name.c_str(), match, start_regex))
-      {
-        moveit_warehouse::RobotStateWithMetadata robot_state;
-        try
-        {
-          if (rs_->getRobotState(robot_state, state_name))
-          {
-            StartState start_state;
-            start_state.state = moveit_msgs::RobotState(*robot_state);
-            start_state.name = state_name;
-            start_states.push_back(start_state);
-          }
-        }
-        catch (std::exception& ex)
-        {
-          ROS_ERROR("Runtime error when loading state '%s': %s", state_name.c_str(), ex.what());
-          continue;
-        }
-      }
+      rs_->getRobotStates(regex, robot_states, state_names);
+    }
+    catch (std::exception& ex)
+    {
+      ROS_ERROR("Runtime error when loading states: %s", ex.what());
+    }
+
+    for (std::size_t i = 0; i < robot_states.size(); ++i)
+    {
+      StartState start_state;
+      start_state.state = moveit_msgs::RobotState(*robot_states[i]);
+      start_state.name = state_names[i];
+      start_states.push_back(start_state);
     }
 
     if (start_states.empty())
@@ -680,27 +744,23 @@ bool BenchmarkExecutor::loadPathConstraints(const std::string& regex, std::vecto
 {
   if (!regex.empty())
   {
+    std::vector<moveit_warehouse::ConstraintsWithMetadata> constrs;
     std::vector<std::string> cnames;
-    cs_->getKnownConstraints(regex, cnames);
+    try
+    {
+      cs_->getConstraints(regex, constrs, cnames);
+    }
+    catch (std::exception& ex)
+    {
+      ROS_ERROR("Runtime error when loading path constraints: %s", ex.what());
+    }
 
-    for (const std::string& cname : cnames)
+    for (std::size_t i = 0; i < constrs.size(); ++i)
     {
-      moveit_warehouse::ConstraintsWithMetadata constr;
-      try
-      {
-        if (cs_->getConstraints(constr, cname))
-        {
-          PathConstraints constraint;
-          constraint.constraints.push_back(*constr);
-          constraint.name = cname;
-          constraints.push_back(constraint);
-        }
-      }
-      catch (std::exception& ex)
-      {
-        ROS_ERROR("Runtime error when loading path constraint '%s': %s", cname.c_str(), ex.what());
-        continue;
-      }
+      PathConstraints constraint;
+      constraint.constraints.push_back(*constrs[i]);
+      constraint.name = cnames[i];
+      constraints.push_back(constraint);
     }
 
     if (constraints.empty())
@@ -786,41 +846,8 @@ void BenchmarkExecutor::runBenchmark(moveit_msgs::MotionPlanRequest request,
       // Iterate runs
       for (int j = 0; j < runs; ++j)
       {
-        // Pre-run events
-        for (PreRunEventFunction& pre_event_fn : pre_event_fns_)
-          pre_event_fn(request);
-
-        // Solve problem
-        ros::WallTime start = ros::WallTime::now();
-        if (use_planning_context)
-        {
-          solved[j] = planning_context->solve(responses[j]);
-        }
-        else
-        {
-          // The planning pipeline does not support MotionPlanDetailedResponse
-          planning_interface::MotionPlanResponse response;
-          solved[j] = planning_pipeline->generatePlan(planning_scene_, request, response);
-          responses[j].error_code_ = response.error_code_;
-          if (response.trajectory_)
-          {
-            responses[j].description_.push_back("plan");
-            responses[j].trajectory_.push_back(response.trajectory_);
-            responses[j].processing_time_.push_back(response.planning_time_);
-          }
-        }
-        double total_time = (ros::WallTime::now() - start).toSec();
-
-        // Collect data
-        start = ros::WallTime::now();
-
-        // Post-run events
-        for (PostRunEventFunction& post_event_fn : post_event_fns_)
-          post_event_fn(request, responses[j], planner_data[j]);
-        collectMetrics(planner_data[j], responses[j], solved[j], total_time);
-        double metrics_time = (ros::WallTime::now() - start).toSec();
-        ROS_DEBUG("Spent %lf seconds collecting metrics", metrics_time);
-
+        solved[j] = runPlanner(planning_pipeline, planning_scene_, planning_context, request, responses[j],
+                               planner_data[j]);
         ++progress;
       }
 
@@ -835,6 +862,186 @@ void BenchmarkExecutor::runBenchmark(moveit_msgs::MotionPlanRequest request,
   }
 }
 
+void BenchmarkExecutor::runBenchmarkParallel(const moveit_msgs::MotionPlanRequest& request,
+                                             const std::map<std::string, std::vector<std::string>>& pipeline_map,
+                                             int runs)
+{
+  benchmark_data_.clear();
+
+  // The results of all planners, in the order runBenchmark() produces them
+  struct PlannerRuns
+  {
+    std::string pipeline_name;
+    moveit_msgs::MotionPlanRequest request;
+    PlannerBenchmarkData planner_data;
+    std::vector<planning_interface::MotionPlanDetailedResponse> responses;
+    std::vector<char> solved;  // not std::vector<bool>, whose elements cannot be written concurrently
+  };
+  std::vector<PlannerRuns> planners;
+  for (const std::pair<const std::string, std::vector<std::string>>& pipeline_entry : pipeline_map)
+    for (const std::string& planner_id : pipeline_entry.second)
+    {
+      PlannerRuns planner_runs;
+      planner_runs.pipeline_name = pipeline_entry.first;
+      planner_runs.request = request;
+      planner_runs.request.planner_id = planner_id;
+      planner_runs.planner_data.resize(runs);
+      planner_runs.responses.resize(runs);
+      planner_runs.solved.resize(runs, false);
+      planners.push_back(std::move(planner_runs));
+    }
+
+  // Planner start events
+  for (PlannerRuns& planner_runs : planners)
+    for (PlannerStartEventFunction& planner_start_fn : planner_start_fns_)
+      planner_start_fn(planner_runs.request, planner_runs.planner_data);
+
+  // Each worker plans in its own copy of the scene, so that planners never share mutable state
+  std::vector<planning_scene::PlanningScenePtr> worker_scenes;
+  for (std::size_t worker = 0; worker < worker_pipelines_.size(); ++worker)
+    worker_scenes.push_back(planning_scene::PlanningScene::clone(planning_scene_));
+
+  // The (planner, run) tasks are handed out in order, each result is stored at its own index
+  const std::size_t num_tasks = planners.size() * runs;
+  std::atomic<std::size_t> next_task(0);
+  std::mutex progress_lock;
+  boost::progress_display progress(num_tasks, std::cout);
+
+  auto work = [&](std::size_t worker) {
+    std::map<std::size_t, planning_interface::PlanningContextPtr> contexts;
+    for (std::size_t task = next_task++; task < num_tasks; task = next_task++)
+    {
+      std::size_t planner_index = task / runs;
+      std::size_t run = task % runs;
+      PlannerRuns& planner_runs = planners[planner_index];
+      const planning_pipeline::PlanningPipelinePtr& planning_pipeline =
+          worker_pipelines_[worker].at(planner_runs.pipeline_name);
+
+      // Use the planning context if the pipeline only contains the planner plugin
+      planning_interface::PlanningContextPtr& planning_context = contexts[planner_index];
+      if (!planning_context && planning_pipeline->getAdapterPluginNames().empty())
+        planning_context =
+            planning_pipeline->getPlannerManager()->getPlanningContext(worker_scenes[worker], planner_runs.request);
+
+      moveit_msgs::MotionPlanRequest run_request = planner_runs.request;
+      planner_runs.solved[run] = runPlanner(planning_pipeline, worker_scenes[worker], planning_context, run_request,
+                                            planner_runs.responses[run], planner_runs.planner_data[run]);
+
+      std::lock_guard<std::mutex> lock(progress_lock);
+      ++progress;
+    }
+  };
+
+  std::vector<std::thread> threads;
+  for (std::size_t worker = 0; worker < worker_pipelines_.size(); ++worker)
+    threads.emplace_back(work, worker);
+  for (std::thread& thread : threads)
+    thread.join();
+
+  for (PlannerRuns& planner_runs : planners)
+  {
+    computeAveragePathSimilarities(planner_runs.planner_data, planner_runs.responses,
+                                   std::vector<bool>(planner_runs.solved.begin(), planner_runs.solved.end()));
+
+    // Planner completion events
+    for (PlannerCompletionEventFunction& planner_completion_fn : planner_completion_fns_)
+      planner_completion_fn(planner_runs.request, planner_runs.planner_data);
+
+    benchmark_data_.push_back(planner_runs.planner_data);
+  }
+}
+
+bool BenchmarkExecutor::runPlanner(const planning_pipeline::PlanningPipelinePtr& pipeline,
+                                   const planning_scene::PlanningSceneConstPtr& scene,
+                                   const planning_interface::PlanningContextPtr& context,
+                                   moveit_msgs::MotionPlanRequest& request,
+                                   planning_interface::MotionPlanDetailedResponse& response, PlannerRunData& run_data)
+{
+  // Pre-run events
+  for (PreRunEventFunction& pre_event_fn : pre_event_fns_)
+    pre_event_fn(request);
+
+  // The counters are those of the calling thread, so that parallel runs do not mix. Work a planner hands off to
+  // threads of its own is not counted.
+  moveit::tools::TraceRecorder& trace = moveit::tools::TraceRecorder::instance();
+  std::vector<moveit::tools::TraceRecorder::ZoneStatistics> zones_before, zones_after;
+  resetPeakMemory();
+  trace.getThreadZoneStatistics(zones_before);
+  const std::uint64_t allocations_before = getThreadAllocationCount();
+
+  // Solve problem
+  bool solved;
+  ros::WallTime start = ros::WallTime::now();
+  if (context)
+  {
+    solved = context->solve(response);
+  }
+  else
+  {
+    // The planning pipeline does not support MotionPlanDetailedResponse
+    planning_interface::MotionPlanResponse pipeline_response;
+    solved = pipeline->generatePlan(scene, request, pipeline_response);
+    response.error_code_ = pipeline_response.error_code_;
+    response.stage_description_ = pipeline_response.stage_description_;
+    response.stage_time_ = pipeline_response.stage_time_;
+    if (pipeline_response.trajectory_)
+    {
+      response.description_.push_back("plan");
+      response.trajectory_.push_back(pipeline_response.trajectory_);
+      response.processing_time_.push_back(pipeline_response.planning_time_);
+    }
+  }
+  double total_time = (ros::WallTime::now() - start).toSec();
+
+  const std::uint64_t allocations = getThreadAllocationCount() - allocations_before;
+  trace.getThreadZoneStatistics(zones_after);
+  const long peak_memory = getPeakMemory();
+
+  // Collect data
+  start = ros::WallTime::now();
+
+  run_data["allocations INTEGER"] = std::to_string(allocations);
+  if (peak_memory >= 0)
+    run_data["peak_memory_kb INTEGER"] = std::to_string(peak_memory);
+
+  std::uint64_t collision_checks = 0, fk_calls = 0;
+  double collision_check_time = 0.0, fk_time = 0.0;
+  const std::vector<std::string> zone_names = trace.getZoneNames();
+  for (std::size_t id = 0; id < zone_names.size() && id < zones_after.size(); ++id)
+  {
+    const std::uint64_t count = zones_after[id].count - zones_before[id].count;
+    if (count == 0)
+      continue;
+    const double time = (zones_after[id].total_ns - zones_before[id].total_ns) * 1e-9;
+    const std::string& name = zone_names[id];
+    if (name.compare(0, 12, "CollisionEnv") == 0 && name.find("::check") != std::string::npos)
+    {
+      collision_checks += count;
+      collision_check_time += time;
+    }
+    else if (name == "RobotState::updateLinkTransforms")
+    {
+      fk_calls += count;
+      fk_time += time;
+    }
+    run_data["zone_" + toMetricName(name) + "_count INTEGER"] = std::to_string(count);
+    run_data["zone_" + toMetricName(name) + "_time REAL"] = moveit::core::toString(time);
+  }
+  run_data["collision_checks INTEGER"] = std::to_string(collision_checks);
+  run_data["collision_check_time REAL"] = moveit::core::toString(collision_check_time);
+  run_data["fk_calls INTEGER"] = std::to_string(fk_calls);
+  run_data["fk_time REAL"] = moveit::core::toString(fk_time);
+
+  // Post-run events
+  for (PostRunEventFunction& post_event_fn : post_event_fns_)
+    post_event_fn(request, response, run_data);
+  collectMetrics(run_data, response, solved, total_time);
+  double metrics_time = (ros::WallTime::now() - start).toSec();
+  ROS_DEBUG("Spent %lf seconds collecting metrics", metrics_time);
+
+  return solved;
+}
+
 void BenchmarkExecutor::collectMetrics(PlannerRunData& metrics,
                                        const planning_interface::MotionPlanDetailedResponse& mp_res, bool solved,
                                        double total_time)
@@ -842,6 +1049,13 @@ void BenchmarkExecutor::collectMetrics(PlannerRunData& metrics,
   metrics["time REAL"] = moveit::core::toString(total_time);
   metrics["solved BOOLEAN"] = boost::lexical_cast<std::string>(solved);
 
+  // stages that run several times, e.g. when an adapter replans, are summed
+  std::map<std::string, double> stage_times;
+  for (std::size_t i = 0; i < mp_res.stage_description_.size() && i < mp_res.stage_time_.size(); ++i)
+    stage_times[toMetricName(mp_res.stage_description_[i])] += mp_res.stage_time_[i];
+  for (const std::pair<const std::string, double>& stage_time : stage_times)
+    metrics["stage_" + stage_time.first + "_time REAL"] = moveit::core::toString(stage_time.second);
+
   if (solved)
   {
     // Analyzing the trajectory(ies) geometrically
@@ -48,6 +48,9 @@ namespace pick_place
 class ManipulationPipeline
 {
 public:
+  /** \brief Strict weak ordering of manipulation plans; plans ordered first are processed first */
+  typedef boost::function<bool(const ManipulationPlanPtr&, const ManipulationPlanPtr&)> PlanOrderFn;
+
   ManipulationPipeline(const std::string& name, unsigned int nthreads);
   virtual ~ManipulationPipeline();
 
@@ -56,6 +59,8 @@ public:
     return name_;
   }
 
+  /** \brief Set the callback invoked once the pipeline found as many successful plans as it was asked for
+      (see setMaxSuccessfulPlans()) */
   void setSolutionCallback(const boost::function<void()>& callback)
   {
     solution_callback_ = callback;
@@ -66,6 +71,20 @@ public:
     empty_queue_callback_ = callback;
   }
 
+  /** \brief Process queued plans best-first by \e order rather than in the order they were pushed. Successful plans
+      are kept ordered as well, so the best one found is last in getSuccessfulManipulationPlans(). */
+  void setPlanOrder(const PlanOrderFn& order)
+  {
+    plan_order_ = order;
+  }
+
+  /** \brief Stop processing as soon as \e count plans succeeded, dropping the plans still queued. If \e count is 0,
+      all plans are processed. The default is to stop at the first successful plan. */
+  void setMaxSuccessfulPlans(unsigned int count)
+  {
+    max_successful_plans_ = count;
+  }
+
   ManipulationPipeline& addStage(const ManipulationStagePtr& next);
   const ManipulationStagePtr& getFirstStage() const;
   const ManipulationStagePtr& getLastStage() const;
@@ -78,6 +97,15 @@ public:
   void stop();
 
   void push(const ManipulationPlanPtr& grasp);
+
+  /** \brief Evaluate the first \e stage_count stages for all \e plans at once, then queue the plans that passed
+      them for the remaining stages, ordered by the plan order (see setPlanOrder()).
+
+      The cheap filtering stages of all candidates run in parallel on as many threads as there are cores, before any
+      candidate enters the more expensive stages, so the candidates can be ranked by what the filter computed.
+      Plans that fail are recorded as failures. Evaluation stops early once the pipeline is stopped or the plans
+      time out. The pipeline must be started. Returns the number of plans queued. */
+  std::size_t pushBatch(const std::vector<ManipulationPlanPtr>& plans, std::size_t stage_count);
   void clear();
 
   const std::vector<ManipulationPlanPtr>& getSuccessfulManipulationPlans() const
@@ -95,6 +123,13 @@ public:
 protected:
   void processingThread(unsigned int index);
 
+  /** \brief Run the stages of \e plan from its current processing stage up to \e stage_end. A plan that fails is
+      recorded as failure. Returns true if all those stages succeeded. */
+  bool evaluateStages(const ManipulationPlanPtr& plan, std::size_t stage_end, unsigned int thread_index);
+
+  /** \brief Insert \e plan into the queue according to the plan order. Requires queue_access_lock_ to be held. */
+  void enqueue(const ManipulationPlanPtr& plan);
+
   std::string name_;
   unsigned int nthreads_;
   bool verbose_;
@@ -113,6 +148,9 @@ protected:
   boost::function<void()> empty_queue_callback_;
   unsigned int empty_queue_threads_;
 
+  PlanOrderFn plan_order_;
+  unsigned int max_successful_plans_;
+
   bool stop_processing_;
 };
 }  // namespace pick_place
@@ -41,6 +41,7 @@
 #include <moveit/pick_place/pick_place_params.h>
 #include <moveit/constraint_sampler_manager_loader/constraint_sampler_manager_loader.h>
 #include <moveit/planning_pipeline/planning_pipeline.h>
+#include <moveit/kinematics_metrics/reachability_map.h>
 #include <moveit_msgs/PickupAction.h>
 #include <moveit_msgs/PlaceAction.h>
 #include <boost/noncopyable.hpp>
@@ -78,6 +79,13 @@ public:
 protected:
   void initialize();
   void waitForPipeline(const ros::WallTime& endtime);
+
+  /** \brief Pass \e plans through the pipeline. The goal poses of all plans are filtered for reachability at once,
+      and the plans that pass are tried best-first: by descending \e quality (indexed by plan id), and among plans of
+      equal quality, those with goal states closer to \e current_state in joint space first. Waits until as many
+      plans as configured succeeded, all plans were tried, or \e endtime. */
+  void processPlans(const std::vector<ManipulationPlanPtr>& plans, const std::vector<double>& quality,
+                    const moveit::core::RobotState& current_state, const ros::WallTime& endtime);
   void foundSolution();
   void emptyQueue();
 
@@ -136,6 +144,9 @@ public:
     return planning_pipeline_->getRobotModel();
   }
 
+  /** \brief The reachability map loaded for \e group from the ~reachability_maps parameter, if any */
+  kinematics_metrics::ReachabilityMapConstPtr getReachabilityMap(const std::string& group) const;
+
   /** \brief Plan the sequence of motions that perform a pickup action */
   PickPlanPtr planPick(const planning_scene::PlanningSceneConstPtr& planning_scene,
                        const moveit_msgs::PickupGoal& goal) const;
@@ -162,5 +173,6 @@ private:
   ros::Publisher grasps_publisher_;
 
   constraint_sampler_manager_loader::ConstraintSamplerManagerLoaderPtr constraint_sampler_manager_loader_;
+  std::map<std::string, kinematics_metrics::ReachabilityMapConstPtr> reachability_maps_;
 };
 }  // namespace pick_place
@@ -39,6 +39,7 @@
 #include <moveit/pick_place/manipulation_stage.h>
 #include <moveit/constraint_samplers/constraint_sampler_manager.h>
 #include <moveit/planning_scene/planning_scene.h>
+#include <moveit/kinematics_metrics/reachability_map.h>
 
 namespace pick_place
 {
@@ -47,7 +48,9 @@ class ReachableAndValidPoseFilter : public ManipulationStage
 public:
   ReachableAndValidPoseFilter(const planning_scene::PlanningSceneConstPtr& scene,
                               const collision_detection::AllowedCollisionMatrixConstPtr& collision_matrix,
-                              const constraint_samplers::ConstraintSamplerManagerPtr& constraints_sampler_manager);
+                              const constraint_samplers::ConstraintSamplerManagerPtr& constraints_sampler_manager,
+                              const kinematics_metrics::ReachabilityMapConstPtr& reachability_map =
+                                  kinematics_metrics::ReachabilityMapConstPtr());
 
   bool evaluate(const ManipulationPlanPtr& plan) const override;
 
@@ -57,5 +60,7 @@ private:
   planning_scene::PlanningSceneConstPtr planning_scene_;
   collision_detection::AllowedCollisionMatrixConstPtr collision_matrix_;
   constraint_samplers::ConstraintSamplerManagerPtr constraints_sampler_manager_;
+  /** \brief Optional precomputed map used to reject unreachable goal poses before sampling IK */
+  kinematics_metrics::ReachabilityMapConstPtr reachability_map_;
 };
 }  // namespace pick_place
@@ -235,6 +235,11 @@ bool ApproachAndTranslateStage::evaluate(const ManipulationPlanPtr& plan) const
                                     joint_group_variable_values);
       };
   plan->goal_sampler_->setVerbose(verbose_);
+
+  // a diff on top of our actual planning scene, which is rolled back to its checkpoint for every retreat attempt
+  planning_scene::PlanningScenePtr planning_scene_after_approach;
+  planning_scene::PlanningSceneConstPtr planning_scene_checkpoint;
+
   std::size_t attempted_possible_goal_states = 0;
   do  // continously sample possible goal states
   {
@@ -272,7 +277,13 @@ bool ApproachAndTranslateStage::evaluate(const ManipulationPlanPtr& plan) const
         if (plan->retreat_.desired_distance > 0.0)
         {
           // construct a planning scene that is just a diff on top of our actual planning scene
-          planning_scene::PlanningScenePtr planning_scene_after_approach = planning_scene_->diff();
+          if (!planning_scene_after_approach)
+          {
+            planning_scene_after_approach = planning_scene_->diff();
+            planning_scene_checkpoint = planning_scene_after_approach->checkpoint();
+          }
+          else
+            planning_scene_after_approach->restoreCheckpoint(planning_scene_checkpoint);
 
           // assume the current state of the diff world is the one we plan to reach
           planning_scene_after_approach->getCurrentStateNonConst() = *plan->possible_goal_states_[i];
@@ -36,11 +36,13 @@
 
 #include <moveit/pick_place/manipulation_pipeline.h>
 #include <ros/console.h>
+#include <algorithm>
+#include <atomic>
 
 namespace pick_place
 {
 ManipulationPipeline::ManipulationPipeline(const std::string& name, unsigned int nthreads)
-  : name_(name), nthreads_(nthreads), verbose_(false), stop_processing_(true)
+  : name_(name), nthreads_(nthreads), verbose_(false), max_successful_plans_(1), stop_processing_(true)
 {
   processing_threads_.resize(nthreads, nullptr);
 }
@@ -169,31 +171,31 @@ void ManipulationPipeline::processingThread(unsigned int index)
       try
       {
         g->error_code_.val = moveit_msgs::MoveItErrorCodes::FAILURE;
-        for (std::size_t i = 0; !stop_processing_ && i < stages_.size(); ++i)
-        {
-          bool res = stages_[i]->evaluate(g);
-          g->processing_stage_ = i + 1;
-          if (!res)
-          {
-            boost::mutex::scoped_lock slock(result_lock_);
-            failed_.push_back(g);
-            ROS_INFO_STREAM_NAMED("manipulation", "Manipulation plan " << g->id_ << " failed at stage '"
-                                                                       << stages_[i]->getName() << "' on thread "
-                                                                       << index);
-            break;
-          }
-        }
+        evaluateStages(g, stages_.size(), index);
         if (g->error_code_.val == moveit_msgs::MoveItErrorCodes::SUCCESS)
         {
           g->processing_stage_++;
+          bool found_all;
           {
             boost::mutex::scoped_lock slock(result_lock_);
-            success_.push_back(g);
+            // keep the preferred plans last; among equally good ones, the plan found last is last
+            auto position = success_.end();
+            if (plan_order_)
+              position = std::upper_bound(success_.begin(), success_.end(), g,
+                                          [this](const ManipulationPlanPtr& a, const ManipulationPlanPtr& b) {
+                                            return plan_order_(b, a);
+                                          });
+            success_.insert(position, g);
+            found_all = max_successful_plans_ > 0 && success_.size() >= max_successful_plans_;
           }
-          signalStop();
           ROS_INFO_STREAM_NAMED("manipulation", "Found successful manipulation plan!");
-          if (solution_callback_)
-            solution_callback_();
+          if (found_all)
+          {
+            // cancel the remaining work
+            signalStop();
+            if (solution_callback_)
+              solution_callback_();
+          }
         }
       }
       catch (std::exception& ex)
@@ -205,10 +207,84 @@ void ManipulationPipeline::processingThread(unsigned int index)
   }
 }
 
+bool ManipulationPipeline::evaluateStages(const ManipulationPlanPtr& g, std::size_t stage_end,
+                                          unsigned int thread_index)
+{
+  // plans that were filtered by pushBatch() continue where they stopped
+  for (std::size_t i = g->processing_stage_; !stop_processing_ && i < stage_end; ++i)
+  {
+    bool res = stages_[i]->evaluate(g);
+    g->processing_stage_ = i + 1;
+    if (!res)
+    {
+      boost::mutex::scoped_lock slock(result_lock_);
+      failed_.push_back(g);
+      ROS_INFO_STREAM_NAMED("manipulation", "Manipulation plan " << g->id_ << " failed at stage '"
+                                                                 << stages_[i]->getName() << "' on thread "
+                                                                 << thread_index);
+      return false;
+    }
+  }
+  return !stop_processing_;
+}
+
+std::size_t ManipulationPipeline::pushBatch(const std::vector<ManipulationPlanPtr>& plans, std::size_t stage_count)
+{
+  stage_count = std::min(stage_count, stages_.size());
+  std::vector<char> passed(plans.size(), 0);
+  std::atomic<std::size_t> next_plan(0);
+
+  auto evaluate_plans = [&](unsigned int thread_index) {
+    for (std::size_t k = next_plan++; k < plans.size() && !stop_processing_; k = next_plan++)
+    {
+      const ManipulationPlanPtr& g = plans[k];
+      if (ros::WallTime::now() > g->shared_data_->timeout_)
+        break;
+      try
+      {
+        g->error_code_.val = moveit_msgs::MoveItErrorCodes::FAILURE;
+        passed[k] = evaluateStages(g, stage_count, thread_index);
+      }
+      catch (std::exception& ex)
+      {
+        ROS_ERROR_NAMED("manipulation", "[%s:%u] %s", name_.c_str(), thread_index, ex.what());
+      }
+    }
+  };
+
+  const unsigned int nthreads = std::max(nthreads_, boost::thread::hardware_concurrency());
+  boost::thread_group threads;
+  for (unsigned int i = 1; i < nthreads; ++i)
+    threads.create_thread([&evaluate_plans, i] { evaluate_plans(i); });
+  evaluate_plans(0);
+  threads.join_all();
+
+  boost::mutex::scoped_lock slock(queue_access_lock_);
+  std::size_t queued = 0;
+  for (std::size_t k = 0; k < plans.size(); ++k)
+    if (passed[k])
+    {
+      enqueue(plans[k]);
+      ++queued;
+    }
+  ROS_INFO_STREAM_NAMED("manipulation", queued << " of " << plans.size() << " plans passed the first stages of '"
+                                               << name_ << "'. Queue is now of size " << queue_.size());
+  queue_access_cond_.notify_all();
+  return queued;
+}
+
+void ManipulationPipeline::enqueue(const ManipulationPlanPtr& plan)
+{
+  if (plan_order_)
+    queue_.insert(std::upper_bound(queue_.begin(), queue_.end(), plan, plan_order_), plan);
+  else
+    queue_.push_back(plan);
+}
+
 void ManipulationPipeline::push(const ManipulationPlanPtr& plan)
 {
   boost::mutex::scoped_lock slock(queue_access_lock_);
-  queue_.push_back(plan);
+  enqueue(plan);
   ROS_INFO_STREAM_NAMED("manipulation",
                         "Added plan for pipeline '" << name_ << "'. Queue is now of size " << queue_.size());
   queue_access_cond_.notify_all();
@@ -222,7 +298,7 @@ void ManipulationPipeline::reprocessLastFailure()
   ManipulationPlanPtr plan = failed_.back();
   failed_.pop_back();
   plan->clear();
-  queue_.push_back(plan);
+  enqueue(plan);
   ROS_INFO_STREAM_NAMED("manipulation", "Re-added last failed plan for pipeline '"
                                             << name_ << "'. Queue is now of size " << queue_.size());
   queue_access_cond_.notify_all();
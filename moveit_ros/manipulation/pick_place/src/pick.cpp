@@ -160,7 +160,8 @@ bool PickPlan::plan(const planning_scene::PlanningSceneConstPtr& planning_scene,
   // configure the manipulation pipeline
   pipeline_.reset();
   ManipulationStagePtr stage1(
-      new ReachableAndValidPoseFilter(planning_scene, approach_grasp_acm, pick_place_->getConstraintsSamplerManager()));
+      new ReachableAndValidPoseFilter(planning_scene, approach_grasp_acm, pick_place_->getConstraintsSamplerManager(),
+                                      pick_place_->getReachabilityMap(plan_data->planning_group_->getName())));
   ManipulationStagePtr stage2(new ApproachAndTranslateStage(planning_scene, approach_grasp_acm));
   ManipulationStagePtr stage3(new PlanStage(planning_scene, pick_place_->getPlanningPipeline()));
   pipeline_.addStage(stage1).addStage(stage2).addStage(stage3);
@@ -177,6 +178,8 @@ bool PickPlan::plan(const planning_scene::PlanningSceneConstPtr& planning_scene,
   std::stable_sort(grasp_order.begin(), grasp_order.end(), oq);
 
   // feed the available grasps to the stages we set up
+  std::vector<ManipulationPlanPtr> plans;
+  std::vector<double> quality(goal.possible_grasps.size());
   for (std::size_t i = 0; i < goal.possible_grasps.size(); ++i)
   {
     ManipulationPlanPtr p(new ManipulationPlan(const_plan_data));
@@ -190,11 +193,11 @@ bool PickPlan::plan(const planning_scene::PlanningSceneConstPtr& planning_scene,
       p->goal_pose_.header.frame_id = goal.target_name;
     p->approach_posture_ = g.pre_grasp_posture;
     p->retreat_posture_ = g.grasp_posture;
-    pipeline_.push(p);
+    quality[p->id_] = g.grasp_quality;
+    plans.push_back(p);
   }
 
-  // wait till we're done
-  waitForPipeline(endtime);
+  processPlans(plans, quality, planning_scene->getCurrentState(), endtime);
   pipeline_.stop();
 
   last_plan_time_ = (ros::WallTime::now() - start_time).toSec();
@@ -38,6 +38,7 @@
 #include <moveit/robot_state/conversions.h>
 #include <moveit_msgs/DisplayTrajectory.h>
 #include <visualization_msgs/MarkerArray.h>
+#include <limits>
 
 namespace pick_place
 {
@@ -89,11 +90,53 @@ void PickPlacePlanBase::waitForPipeline(const ros::WallTime& endtime)
     done_condition_.timed_wait(lock, (endtime - ros::WallTime::now()).toBoost());
 }
 
+void PickPlacePlanBase::processPlans(const std::vector<ManipulationPlanPtr>& plans, const std::vector<double>& quality,
+                                     const moveit::core::RobotState& current_state, const ros::WallTime& endtime)
+{
+  // the first stage computes the goal states; the distance of a plan's first goal state to the current state
+  // estimates how much the robot needs to move. The order outlives this call (failed plans may be reprocessed),
+  // so it keeps its own copies.
+  auto state = std::make_shared<const moveit::core::RobotState>(current_state);
+  auto distance = [state](const ManipulationPlanPtr& plan) {
+    return plan->possible_goal_states_.empty() ?
+               std::numeric_limits<double>::infinity() :
+               state->distance(*plan->possible_goal_states_.front(), plan->shared_data_->planning_group_);
+  };
+  pipeline_.setPlanOrder([quality, distance](const ManipulationPlanPtr& a, const ManipulationPlanPtr& b) {
+    if (quality[a->id_] != quality[b->id_])
+      return quality[a->id_] > quality[b->id_];
+    return distance(a) < distance(b);
+  });
+  pipeline_.setMaxSuccessfulPlans(GetGlobalPickPlaceParams().max_successful_plans_);
+
+  if (pipeline_.pushBatch(plans, 1) > 0)
+    waitForPipeline(endtime);
+}
+
 PickPlace::PickPlace(const planning_pipeline::PlanningPipelinePtr& planning_pipeline)
   : nh_("~"), planning_pipeline_(planning_pipeline), display_computed_motion_plans_(false), display_grasps_(false)
 {
   constraint_sampler_manager_loader_ =
       std::make_shared<constraint_sampler_manager_loader::ConstraintSamplerManagerLoader>();
+
+  // maps written by moveit_compute_reachability_map, keyed by group name
+  std::map<std::string, std::string> reachability_map_files;
+  nh_.getParam("reachability_maps", reachability_map_files);
+  for (const std::pair<const std::string, std::string>& file : reachability_map_files)
+  {
+    auto map = std::make_shared<kinematics_metrics::ReachabilityMap>();
+    if (map->loadFromFile(file.second) && map->getGroupName() == file.first)
+      reachability_maps_[file.first] = map;
+    else
+      ROS_ERROR_NAMED("manipulation", "Unable to load the reachability map for group '%s' from '%s'",
+                      file.first.c_str(), file.second.c_str());
+  }
+}
+
+kinematics_metrics::ReachabilityMapConstPtr PickPlace::getReachabilityMap(const std::string& group) const
+{
+  auto it = reachability_maps_.find(group);
+  return it == reachability_maps_.end() ? kinematics_metrics::ReachabilityMapConstPtr() : it->second;
 }
 
 void PickPlace::displayProcessedGrasps(bool flag)
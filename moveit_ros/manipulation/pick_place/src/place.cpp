@@ -309,7 +309,8 @@ bool PlacePlan::plan(const planning_scene::PlanningSceneConstPtr& planning_scene
   pipeline_.reset();
 
   ManipulationStagePtr stage1(
-      new ReachableAndValidPoseFilter(planning_scene, approach_place_acm, pick_place_->getConstraintsSamplerManager()));
+      new ReachableAndValidPoseFilter(planning_scene, approach_place_acm, pick_place_->getConstraintsSamplerManager(),
+                                      pick_place_->getReachabilityMap(plan_data->planning_group_->getName())));
   ManipulationStagePtr stage2(new ApproachAndTranslateStage(planning_scene, approach_place_acm));
   ManipulationStagePtr stage3(new PlanStage(planning_scene, pick_place_->getPlanningPipeline()));
   pipeline_.addStage(stage1).addStage(stage2).addStage(stage3);
@@ -327,6 +328,8 @@ bool PlacePlan::plan(const planning_scene::PlanningSceneConstPtr& planning_scene
   std::stable_sort(place_locations_order.begin(), place_locations_order.end(), oq);
 
   // add possible place locations
+  std::vector<ManipulationPlanPtr> plans;
+  std::vector<double> quality(goal.place_locations.size());
   for (std::size_t i = 0; i < goal.place_locations.size(); ++i)
   {
     ManipulationPlanPtr p(new ManipulationPlan(const_plan_data));
@@ -350,12 +353,12 @@ bool PlacePlan::plan(const planning_scene::PlanningSceneConstPtr& planning_scene
     p->id_ = place_locations_order[i];
     if (p->retreat_posture_.joint_names.empty())
       p->retreat_posture_ = attached_body->getDetachPosture();
-    pipeline_.push(p);
+    quality[p->id_] = pl.quality;
+    plans.push_back(p);
   }
   ROS_INFO_NAMED("manipulation", "Added %d place locations", (int)goal.place_locations.size());
 
-  // wait till we're done
-  waitForPipeline(endtime);
+  processPlans(plans, quality, planning_scene->getCurrentState(), endtime);
 
   pipeline_.stop();
 
@@ -43,11 +43,13 @@
 pick_place::ReachableAndValidPoseFilter::ReachableAndValidPoseFilter(
     const planning_scene::PlanningSceneConstPtr& scene,
     const collision_detection::AllowedCollisionMatrixConstPtr& collision_matrix,
-    const constraint_samplers::ConstraintSamplerManagerPtr& constraints_sampler_manager)
+    const constraint_samplers::ConstraintSamplerManagerPtr& constraints_sampler_manager,
+    const kinematics_metrics::ReachabilityMapConstPtr& reachability_map)
   : ManipulationStage("reachable & valid pose filter")
   , planning_scene_(scene)
   , collision_matrix_(collision_matrix)
   , constraints_sampler_manager_(constraints_sampler_manager)
+  , reachability_map_(reachability_map)
 {
 }
 
@@ -110,6 +112,22 @@ bool pick_place::ReachableAndValidPoseFilter::evaluate(const ManipulationPlanPtr
   moveit::core::RobotStatePtr token_state(new moveit::core::RobotState(planning_scene_->getCurrentState()));
   if (isEndEffectorFree(plan, *token_state))
   {
+    // a precomputed reachability map rejects goal poses without calling IK
+    if (reachability_map_ && reachability_map_->getGroupName() == plan->shared_data_->planning_group_->getName() &&
+        reachability_map_->getTipFrame() == plan->shared_data_->ik_link_->getName())
+    {
+      const Eigen::Isometry3d pose_in_base =
+          planning_scene_->getFrameTransform(*token_state, reachability_map_->getBaseFrame()).inverse() *
+          plan->transformed_goal_pose_;
+      if (!reachability_map_->isReachable(pose_in_base))
+      {
+        if (verbose_)
+          ROS_INFO_NAMED("manipulation", "Goal pose is not in the reachability map");
+        plan->error_code_.val = moveit_msgs::MoveItErrorCodes::NO_IK_SOLUTION;
+        return false;
+      }
+    }
+
     // update the goal pose message if anything has changed; this is because the name of the frame in the input goal
     // pose
     // can be that of objects in the collision world but most components are unaware of those transforms,
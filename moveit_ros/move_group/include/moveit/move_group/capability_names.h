@@ -52,6 +52,11 @@ static const std::string SET_PLANNER_PARAMS_SERVICE_NAME =
 static const std::string MOVE_ACTION = "move_group";      // name of 'move' action
 static const std::string IK_SERVICE_NAME = "compute_ik";  // name of ik service
 static const std::string FK_SERVICE_NAME = "compute_fk";  // name of fk service
+static const std::string IK_SESSION_SERVICE_NAME = "open_ik_session";  // name of the service opening ik sessions
+static const std::string IK_SESSION_TARGET_TOPIC =
+    "ik_session_targets";  // name of the topic streaming pose targets to open ik sessions
+static const std::string IK_SESSION_SOLUTION_TOPIC =
+    "ik_session_solutions";  // name of the topic the solutions of ik session targets are published on
 static const std::string STATE_VALIDITY_SERVICE_NAME =
     "check_state_validity";  // name of the service that validates states
 static const std::string CARTESIAN_PATH_SERVICE_NAME =
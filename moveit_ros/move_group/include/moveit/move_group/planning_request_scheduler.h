@@ -0,0 +1,113 @@
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2026, PickNik LLC.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of PickNik LLC nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *********************************************************************/
+
+#pragma once
+
+#include <moveit/macros/class_forward.h>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <set>
+#include <utility>
+
+namespace move_group
+{
+MOVEIT_CLASS_FORWARD(PlanningRequestScheduler);  // Defines PlanningRequestSchedulerPtr, ConstPtr, WeakPtr... etc
+
+/** \brief Admits planning requests to a bounded number of concurrent slots.
+ *
+ *  Requests that cannot start right away wait for a slot, those with a higher priority first and otherwise in the
+ *  order they arrived. If the maximum number of requests is waiting already, further requests are rejected right
+ *  away, so that clients learn about the overload instead of piling up. */
+class PlanningRequestScheduler
+{
+public:
+  /** \brief Releases the slot of an admitted request when it goes out of scope */
+  class Slot
+  {
+  public:
+    explicit Slot(PlanningRequestScheduler& scheduler) : scheduler_(scheduler)
+    {
+    }
+
+    ~Slot()
+    {
+      scheduler_.release();
+    }
+
+    Slot(const Slot&) = delete;
+    Slot& operator=(const Slot&) = delete;
+
+  private:
+    PlanningRequestScheduler& scheduler_;
+  };
+
+  PlanningRequestScheduler(std::size_t max_active, std::size_t max_waiting);
+
+  /** \brief Wait until a slot is free for a request with the given \e priority. Returns false without waiting if
+   *  the maximum number of requests is waiting already. Every successful call needs a matching release(). */
+  bool acquire(int priority);
+
+  /** \brief Free the slot of a finished request */
+  void release();
+
+  std::size_t getMaxActive() const
+  {
+    return max_active_;
+  }
+
+  std::size_t getMaxWaiting() const
+  {
+    return max_waiting_;
+  }
+
+  /** \brief The number of requests currently holding a slot */
+  std::size_t getActiveCount() const;
+
+  /** \brief The number of requests currently waiting for a slot */
+  std::size_t getWaitingCount() const;
+
+private:
+  const std::size_t max_active_;
+  const std::size_t max_waiting_;
+
+  mutable std::mutex lock_;
+  std::condition_variable slot_freed_;
+  std::size_t active_;
+  std::uint64_t next_ticket_;
+
+  /// waiting requests as (-priority, ticket), so that the first one is the next to be admitted
+  std::set<std::pair<int, std::uint64_t>> waiting_;
+};
+}  // namespace move_group
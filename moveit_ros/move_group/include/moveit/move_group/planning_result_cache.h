@@ -0,0 +1,95 @@
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2026, PickNik LLC.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of PickNik LLC nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *********************************************************************/
+
+#pragma once
+
+#include <moveit/macros/class_forward.h>
+#include <moveit/planning_interface/planning_response.h>
+#include <moveit_msgs/MotionPlanRequest.h>
+#include <functional>
+#include <list>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <utility>
+
+namespace move_group
+{
+MOVEIT_CLASS_FORWARD(PlanningResultCache);  // Defines PlanningResultCachePtr, ConstPtr, WeakPtr... etc
+
+/** \brief Least recently used cache of successful planning results, keyed by the planning request.
+ *
+ *  The scene a result was planned in is not part of the key, as the monitored scene changes with every robot state
+ *  update. Instead, callers validate cached results against the current scene before using them. */
+class PlanningResultCache
+{
+public:
+  typedef std::function<bool(const planning_interface::MotionPlanResponse&)> ValidityFn;
+
+  /** \brief A cache that keeps the \e capacity most recently used results */
+  explicit PlanningResultCache(std::size_t capacity);
+
+  /** \brief Return the key of \e request. Fields that do not influence the result, like time stamps, are cleared
+   *  first, so that repeated requests map to the same key. */
+  static std::string getKey(const moveit_msgs::MotionPlanRequest& request);
+
+  /** \brief Get the result stored for \e key if \e is_valid accepts it. Results that are not valid anymore are
+   *  removed. \e is_valid is called without holding the cache lock. */
+  bool lookup(const std::string& key, const ValidityFn& is_valid, planning_interface::MotionPlanResponse& result);
+
+  /** \brief Store \e result for \e key, evicting the least recently used result if the cache is full */
+  void insert(const std::string& key, const planning_interface::MotionPlanResponse& result);
+
+  void clear();
+
+  std::size_t size() const;
+
+  /** \brief The number of lookups that returned a result */
+  std::size_t getHits() const;
+
+  /** \brief The number of lookups that found no valid result */
+  std::size_t getMisses() const;
+
+private:
+  typedef std::list<std::pair<std::string, planning_interface::MotionPlanResponse>> Entries;
+
+  const std::size_t capacity_;
+
+  mutable std::mutex lock_;
+  Entries entries_;  // most recently used first
+  std::unordered_map<std::string, Entries::iterator> index_;
+  std::size_t hits_;
+  std::size_t misses_;
+};
+}  // namespace move_group
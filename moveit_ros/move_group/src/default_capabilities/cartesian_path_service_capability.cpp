@@ -47,6 +47,9 @@
 #include <moveit/trajectory_processing/iterative_time_parameterization.h>
 #include <moveit/trajectory_processing/limit_cartesian_speed.h>
 
+#include <future>
+#include <thread>
+
 namespace
 {
 bool isStateValid(const planning_scene::PlanningScene* planning_scene,
@@ -58,17 +61,130 @@ bool isStateValid(const planning_scene::PlanningScene* planning_scene,
   return (!planning_scene || !planning_scene->isStateColliding(*state, group->getName())) &&
          (!constraint_set || constraint_set->decide(*state).satisfied);
 }
+
+// Index of the first of \e states failing \e validity_fn, or the number of states if all are valid
+std::size_t findFirstInvalidState(const std::vector<moveit::core::RobotStatePtr>& states,
+                                  const moveit::core::JointModelGroup* group,
+                                  const moveit::core::GroupStateValidityCallbackFn& validity_fn)
+{
+  std::vector<double> values;
+  for (std::size_t i = 0; i < states.size(); ++i)
+  {
+    states[i]->copyJointGroupPositions(group, values);
+    if (!validity_fn(states[i].get(), group, values.data()))
+      return i;
+  }
+  return states.size();
+}
+
+// Like the multi-waypoint CartesianInterpolator::computeCartesianPath(), but the states of each segment are only
+// checked for validity once the segment is complete, by up to \e threads tasks running while the next segments are
+// interpolated. Kinematics solvers need not be thread-safe, so the interpolation itself stays sequential.
+double computePipelinedCartesianPath(moveit::core::RobotState* start_state, const moveit::core::JointModelGroup* group,
+                                     std::vector<moveit::core::RobotStatePtr>& traj,
+                                     const moveit::core::LinkModel* link, const EigenSTL::vector_Isometry3d& waypoints,
+                                     bool global_reference_frame, const moveit::core::MaxEEFStep& max_step,
+                                     const moveit::core::JumpThreshold& jump_threshold,
+                                     const moveit::core::GroupStateValidityCallbackFn& validity_fn,
+                                     const moveit::core::JacobianStepping& jacobian_stepping, unsigned int threads)
+{
+  struct Segment
+  {
+    std::size_t begin;  // first state of traj checked for this segment
+    std::size_t size;   // number of states checked for this segment
+    double fraction;    // fraction of the segment interpolated
+    std::future<std::size_t> first_invalid;
+    std::size_t valid;  // number of valid states, once known
+  };
+
+  static const moveit::core::JumpThreshold NO_JOINT_SPACE_JUMP_TEST;
+  traj.clear();
+  std::vector<Segment> segments;
+  segments.reserve(waypoints.size());
+  std::size_t resolved = 0;
+  bool invalid_found = false;
+  auto resolve = [&segments, &resolved, &invalid_found] {
+    Segment& segment = segments[resolved++];
+    segment.valid = segment.first_invalid.get();
+    invalid_found |= segment.valid < segment.size;
+  };
+
+  for (std::size_t i = 0; i < waypoints.size() && !invalid_found; ++i)
+  {
+    std::vector<moveit::core::RobotStatePtr> segment_traj;
+    double fraction = moveit::core::CartesianInterpolator::computeCartesianPath(
+        start_state, group, segment_traj, link, waypoints[i], global_reference_frame, max_step,
+        NO_JOINT_SPACE_JUMP_TEST, moveit::core::GroupStateValidityCallbackFn(), kinematics::KinematicsQueryOptions(),
+        Eigen::Isometry3d::Identity(), jacobian_stepping);
+
+    // the first state of a segment is the last one of the previous segment, or the unchecked start state
+    const std::size_t skip = std::min<std::size_t>(1, segment_traj.size());
+    std::vector<moveit::core::RobotStatePtr> states(segment_traj.begin() + skip, segment_traj.end());
+    if (i == 0 && !segment_traj.empty())
+      traj.push_back(segment_traj.front());
+    Segment segment;
+    segment.begin = traj.size();
+    segment.size = states.size();
+    segment.fraction = fraction;
+    segment.valid = 0;
+    traj.insert(traj.end(), states.begin(), states.end());
+    segment.first_invalid = std::async(std::launch::async, [states = std::move(states), group, &validity_fn] {
+      return findFirstInvalidState(states, group, validity_fn);
+    });
+    segments.push_back(std::move(segment));
+
+    // pick up finished checks, and wait for the oldest one while too many are running
+    while (resolved < segments.size() &&
+           (segments.size() - resolved > threads ||
+            segments[resolved].first_invalid.wait_for(std::chrono::seconds(0)) == std::future_status::ready))
+      resolve();
+
+    if (fraction < 1.0)
+      break;
+  }
+  while (resolved < segments.size())
+    resolve();
+
+  // stitch the segments up to the first invalid state
+  double percentage_solved = 0.0;
+  for (std::size_t i = 0; i < segments.size(); ++i)
+  {
+    const Segment& segment = segments[i];
+    if (segment.valid < segment.size)
+    {
+      percentage_solved = (i + segment.fraction * segment.valid / segment.size) / waypoints.size();
+      traj.resize(segment.begin + segment.valid);
+      break;
+    }
+    percentage_solved = (i + segment.fraction) / waypoints.size();
+  }
+  if (!traj.empty())
+    *start_state = *traj.back();
+
+  percentage_solved *= moveit::core::CartesianInterpolator::checkJointSpaceJump(group, traj, jump_threshold);
+  return percentage_solved;
+}
 }  // namespace
 
 namespace move_group
 {
 MoveGroupCartesianPathService::MoveGroupCartesianPathService()
-  : MoveGroupCapability("CartesianPathService"), display_computed_paths_(true)
+  : MoveGroupCapability("CartesianPathService")
+  , display_computed_paths_(true)
+  , jacobian_stepping_(false)
+  , validity_threads_(1)
 {
 }
 
 void MoveGroupCartesianPathService::initialize()
 {
+  // Reach consecutive path states by Jacobian steps and only fall back to IK where these fail
+  node_handle_.param("cartesian_path_jacobian_stepping", jacobian_stepping_, false);
+  // Check the validity of completed segments of multi-waypoint paths in this many threads while the next segments
+  // are interpolated (0 for all cores, 1 to check each state during interpolation)
+  int validity_threads;
+  node_handle_.param("cartesian_path_validity_threads", validity_threads, 1);
+  validity_threads_ = validity_threads > 0 ? validity_threads : std::max(1u, std::thread::hardware_concurrency());
   display_path_ = node_handle_.advertise<moveit_msgs::DisplayTrajectory>(
       planning_pipeline::PlanningPipeline::DISPLAY_PATH_TOPIC, 10, true);
   cartesian_path_service_ = root_node_handle_.advertiseService(CARTESIAN_PATH_SERVICE_NAME,
@@ -153,9 +269,17 @@ bool MoveGroupCartesianPathService::computeService(moveit_msgs::GetCartesianPath
                          (unsigned int)waypoints.size(), link_name.c_str(), req.max_step, req.jump_threshold,
                          global_frame ? "global" : "link");
           std::vector<moveit::core::RobotStatePtr> traj;
-          res.fraction = moveit::core::CartesianInterpolator::computeCartesianPath(
-              &start_state, jmg, traj, start_state.getLinkModel(link_name), waypoints, global_frame,
-              moveit::core::MaxEEFStep(req.max_step), moveit::core::JumpThreshold(req.jump_threshold), constraint_fn);
+          if (validity_threads_ > 1 && waypoints.size() > 1 && constraint_fn)
+            res.fraction = computePipelinedCartesianPath(
+                &start_state, jmg, traj, start_state.getLinkModel(link_name), waypoints, global_frame,
+                moveit::core::MaxEEFStep(req.max_step), moveit::core::JumpThreshold(req.jump_threshold), constraint_fn,
+                moveit::core::JacobianStepping(jacobian_stepping_), validity_threads_);
+          else
+            res.fraction = moveit::core::CartesianInterpolator::computeCartesianPath(
+                &start_state, jmg, traj, start_state.getLinkModel(link_name), waypoints, global_frame,
+                moveit::core::MaxEEFStep(req.max_step), moveit::core::JumpThreshold(req.jump_threshold), constraint_fn,
+                kinematics::KinematicsQueryOptions(), Eigen::Isometry3d::Identity(),
+                moveit::core::JacobianStepping(jacobian_stepping_));
           moveit::core::robotStateToRobotStateMsg(start_state, res.start_state);
 
           robot_trajectory::RobotTrajectory rt(context_->planning_scene_monitor_->getRobotModel(), req.group_name);
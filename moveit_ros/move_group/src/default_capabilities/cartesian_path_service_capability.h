@@ -54,5 +54,7 @@ private:
   ros::ServiceServer cartesian_path_service_;
   ros::Publisher display_path_;
   bool display_computed_paths_;
+  bool jacobian_stepping_;
+  unsigned int validity_threads_;
 };
 }  // namespace move_group
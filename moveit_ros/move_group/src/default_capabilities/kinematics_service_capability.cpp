@@ -52,6 +52,15 @@ void MoveGroupKinematicsService::initialize()
       root_node_handle_.advertiseService(FK_SERVICE_NAME, &MoveGroupKinematicsService::computeFKService, this);
   ik_service_ =
       root_node_handle_.advertiseService(IK_SERVICE_NAME, &MoveGroupKinematicsService::computeIKService, this);
+
+  ik_session_service_ = root_node_handle_.advertiseService(IK_SESSION_SERVICE_NAME,
+                                                           &MoveGroupKinematicsService::openIKSessionService, this);
+  ik_session_solution_pub_ =
+      root_node_handle_.advertise<moveit_msgs::GetPositionIK::Response>(IK_SESSION_SOLUTION_TOPIC, 100);
+  // targets are streamed at a high rate, so don't let Nagle's algorithm delay them
+  ik_session_target_sub_ =
+      root_node_handle_.subscribe(IK_SESSION_TARGET_TOPIC, 100, &MoveGroupKinematicsService::ikSessionTargetCallback,
+                                  this, ros::TransportHints().tcpNoDelay());
 }
 
 namespace
@@ -178,6 +187,132 @@ bool MoveGroupKinematicsService::computeIKService(moveit_msgs::GetPositionIK::Re
   return true;
 }
 
+bool MoveGroupKinematicsService::openIKSessionService(moveit_msgs::GetPositionIK::Request& req,
+                                                      moveit_msgs::GetPositionIK::Response& res)
+{
+  const moveit::core::RobotModelConstPtr& robot_model = context_->planning_scene_monitor_->getRobotModel();
+  if (!robot_model->hasJointModelGroup(req.ik_request.group_name))
+  {
+    res.error_code.val = moveit_msgs::MoveItErrorCodes::INVALID_GROUP_NAME;
+    return true;
+  }
+
+  context_->planning_scene_monitor_->updateFrameTransforms();
+
+  auto session = std::make_shared<IKSession>();
+  session->request = req.ik_request;
+  session->state = std::make_shared<moveit::core::RobotState>(
+      planning_scene_monitor::LockedPlanningSceneRO(context_->planning_scene_monitor_)->getCurrentState());
+  if (!moveit::core::isEmpty(req.ik_request.robot_state))
+    moveit::core::robotStateMsgToRobotState(req.ik_request.robot_state, *session->state);
+
+  // an initial target is solved right away, otherwise the seed is returned
+  std::lock_guard<std::mutex> session_lock(session->lock);
+  if (!req.ik_request.pose_stamped.header.frame_id.empty())
+    solveIKSession(*session, req.ik_request.pose_stamped, res.solution, res.error_code);
+  else
+  {
+    moveit::core::robotStateToRobotStateMsg(*session->state, res.solution, false);
+    res.error_code.val = moveit_msgs::MoveItErrorCodes::SUCCESS;
+  }
+
+  // opening a session for a group replaces the previous one
+  std::lock_guard<std::mutex> sessions_lock(ik_sessions_lock_);
+  ik_sessions_[req.ik_request.group_name] = session;
+  ROS_DEBUG_NAMED(getName(), "Opened IK session for group '%s'", req.ik_request.group_name.c_str());
+  return true;
+}
+
+void MoveGroupKinematicsService::ikSessionTargetCallback(const moveit_msgs::PositionIKRequestConstPtr& target)
+{
+  IKSessionPtr session;
+  {
+    std::lock_guard<std::mutex> sessions_lock(ik_sessions_lock_);
+    auto it = ik_sessions_.find(target->group_name);
+    if (it != ik_sessions_.end())
+      session = it->second;
+  }
+
+  moveit_msgs::GetPositionIK::Response res;
+  if (!session)
+  {
+    ROS_WARN_THROTTLE_NAMED(1.0, getName(), "Received IK target for group '%s' without open session",
+                            target->group_name.c_str());
+    res.error_code.val = moveit_msgs::MoveItErrorCodes::INVALID_GROUP_NAME;
+  }
+  else
+  {
+    std::lock_guard<std::mutex> session_lock(session->lock);
+    if (!moveit::core::isEmpty(target->robot_state))
+      moveit::core::robotStateMsgToRobotState(target->robot_state, *session->state);
+    solveIKSession(*session, target->pose_stamped, res.solution, res.error_code);
+  }
+
+  // let the client match the solution to its target
+  res.solution.joint_state.header.stamp = target->pose_stamped.header.stamp;
+  ik_session_solution_pub_.publish(res);
+}
+
+void MoveGroupKinematicsService::solveIKSession(IKSession& session, geometry_msgs::PoseStamped target,
+                                                moveit_msgs::RobotState& solution,
+                                                moveit_msgs::MoveItErrorCodes& error_code)
+{
+  const moveit_msgs::PositionIKRequest& request = session.request;
+  const moveit::core::JointModelGroup* jmg = session.state->getJointModelGroup(request.group_name);
+  if (!performTransform(target, session.state->getRobotModel()->getModelFrame()))
+  {
+    error_code.val = moveit_msgs::MoveItErrorCodes::FRAME_TRANSFORM_FAILURE;
+    return;
+  }
+
+  // the snapshot is shared until the monitored scene changes, so the constraints are only set up again then
+  moveit::core::GroupStateValidityCallbackFn validity_callback;
+  if (request.avoid_collisions || !moveit::core::isEmpty(request.constraints))
+  {
+    planning_scene::PlanningSceneConstPtr scene = context_->planning_scene_monitor_->getPlanningSceneSnapshot();
+    if (!scene)
+    {
+      error_code.val = moveit_msgs::MoveItErrorCodes::FAILURE;
+      return;
+    }
+    if (scene != session.scene)
+    {
+      session.scene = scene;
+      session.constraints.reset();
+      if (!moveit::core::isEmpty(request.constraints))
+      {
+        session.constraints = std::make_shared<kinematic_constraints::KinematicConstraintSet>(scene->getRobotModel());
+        session.constraints->add(request.constraints, scene->getTransforms());
+      }
+    }
+    validity_callback = [collision_scene = request.avoid_collisions ? session.scene.get() : nullptr,
+                         kset = session.constraints.get()](moveit::core::RobotState* robot_state,
+                                                           const moveit::core::JointModelGroup* joint_group,
+                                                           const double* joint_group_variable_values) {
+      return isIKSolutionValid(collision_scene, kset, robot_state, joint_group, joint_group_variable_values);
+    };
+  }
+
+  // the previous solution is the seed; keep it if this target fails
+  std::vector<double> seed;
+  session.state->copyJointGroupPositions(jmg, seed);
+  const double timeout = request.timeout.toSec();
+  const bool found =
+      request.ik_link_name.empty() ?
+          session.state->setFromIK(jmg, target.pose, timeout, validity_callback) :
+          session.state->setFromIK(jmg, target.pose, request.ik_link_name, timeout, validity_callback);
+  if (found)
+  {
+    moveit::core::robotStateToRobotStateMsg(*session.state, solution, false);
+    error_code.val = moveit_msgs::MoveItErrorCodes::SUCCESS;
+  }
+  else
+  {
+    session.state->setJointGroupPositions(jmg, seed);
+    error_code.val = moveit_msgs::MoveItErrorCodes::NO_IK_SOLUTION;
+  }
+}
+
 bool MoveGroupKinematicsService::computeFKService(moveit_msgs::GetPositionFK::Request& req,
                                                   moveit_msgs::GetPositionFK::Response& res)
 {
@@ -37,8 +37,12 @@
 #pragma once
 
 #include <moveit/move_group/move_group_capability.h>
+#include <moveit/kinematic_constraints/kinematic_constraint.h>
 #include <moveit_msgs/GetPositionIK.h>
 #include <moveit_msgs/GetPositionFK.h>
+#include <map>
+#include <memory>
+#include <mutex>
 
 namespace move_group
 {
@@ -58,7 +62,39 @@ private:
                  const moveit::core::GroupStateValidityCallbackFn& constraint =
                      moveit::core::GroupStateValidityCallbackFn()) const;
 
+  /** \brief State kept between the targets of an IK session.
+
+      A session is opened through the IK_SESSION_SERVICE_NAME service with a GetPositionIK request, which fixes the
+      group, the tip link, the timeout, the constraints and whether collisions are avoided; its pose is solved right
+      away if it has a frame id. Reopening a session for the same group replaces it. Targets are then streamed
+      as PositionIKRequest messages on IK_SESSION_TARGET_TOPIC, of which only the group name, the pose and optionally
+      a new seed state are used. Each target is solved starting from the previous solution, against a planning scene
+      snapshot that is only replaced when the monitored scene changed, without locking the monitored scene. The
+      solutions are published on IK_SESSION_SOLUTION_TOPIC, stamped with the stamp of their target. */
+  struct IKSession
+  {
+    std::mutex lock;                          ///< serializes the targets of the session
+    moveit_msgs::PositionIKRequest request;   ///< the request the session was opened with
+    moveit::core::RobotStatePtr state;        ///< the last solution, seed for the next target
+    planning_scene::PlanningSceneConstPtr scene;  ///< snapshot the constraints were set up for
+    kinematic_constraints::KinematicConstraintSetPtr constraints;  ///< null if the session has no constraints
+  };
+  using IKSessionPtr = std::shared_ptr<IKSession>;
+
+  bool openIKSessionService(moveit_msgs::GetPositionIK::Request& req, moveit_msgs::GetPositionIK::Response& res);
+  void ikSessionTargetCallback(const moveit_msgs::PositionIKRequestConstPtr& target);
+
+  /// Solve @a target within @a session, whose lock must be held, and update its seed on success
+  void solveIKSession(IKSession& session, geometry_msgs::PoseStamped target, moveit_msgs::RobotState& solution,
+                      moveit_msgs::MoveItErrorCodes& error_code);
+
   ros::ServiceServer fk_service_;
   ros::ServiceServer ik_service_;
+
+  ros::ServiceServer ik_session_service_;
+  ros::Subscriber ik_session_target_sub_;
+  ros::Publisher ik_session_solution_pub_;
+  std::mutex ik_sessions_lock_;
+  std::map<std::string, IKSessionPtr> ik_sessions_;  ///< open sessions by group name
 };
 }  // namespace move_group
@@ -152,13 +152,19 @@ void MoveGroupMoveAction::executeMoveCallbackPlanOnly(const moveit_msgs::MoveGro
 {
   ROS_INFO_NAMED(getName(), "Planning request received for MoveGroup action. Forwarding to planning pipeline.");
 
+  planning_interface::MotionPlanResponse res;
+
   // lock the scene so that it does not modify the world representation while diff() is called
+  ros::WallTime lock_start = ros::WallTime::now();
   planning_scene_monitor::LockedPlanningSceneRO lscene(context_->planning_scene_monitor_);
+  ros::WallTime diff_start = ros::WallTime::now();
+  res.addStageTime("scene lock", (diff_start - lock_start).toSec());
   const planning_scene::PlanningSceneConstPtr& the_scene =
       (moveit::core::isEmpty(goal->planning_options.planning_scene_diff)) ?
           static_cast<const planning_scene::PlanningSceneConstPtr&>(lscene) :
           lscene->diff(goal->planning_options.planning_scene_diff);
-  planning_interface::MotionPlanResponse res;
+  if (!moveit::core::isEmpty(goal->planning_options.planning_scene_diff))
+    res.addStageTime("scene diff", (ros::WallTime::now() - diff_start).toSec());
 
   if (preempt_requested_)
   {
@@ -206,7 +212,9 @@ bool MoveGroupMoveAction::planUsingPlanningPipeline(const planning_interface::Mo
     return solved;
   }
 
+  ros::WallTime lock_start = ros::WallTime::now();
   planning_scene_monitor::LockedPlanningSceneRO lscene(plan.planning_scene_monitor_);
+  res.addStageTime("scene lock", (ros::WallTime::now() - lock_start).toSec());
   try
   {
     solved = planning_pipeline->generatePlan(plan.planning_scene_, req, res);
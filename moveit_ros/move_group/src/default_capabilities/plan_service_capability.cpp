@@ -37,21 +37,77 @@
 #include "plan_service_capability.h"
 #include <moveit/planning_pipeline/planning_pipeline.h>
 #include <moveit/move_group/capability_names.h>
+#include <moveit/robot_state/conversions.h>
+#include <algorithm>
 
 namespace move_group
 {
-MoveGroupPlanService::MoveGroupPlanService() : MoveGroupCapability("MotionPlanService")
+MoveGroupPlanService::MoveGroupPlanService()
+  : MoveGroupCapability("MotionPlanService"), result_cache_start_tolerance_(1e-4)
 {
 }
 
 void MoveGroupPlanService::initialize()
 {
+  int result_cache_size = node_handle_.param("plan_service/result_cache_size", 0);
+  if (result_cache_size > 0)
+  {
+    result_cache_ = std::make_shared<PlanningResultCache>(result_cache_size);
+    node_handle_.param("plan_service/result_cache_start_state_tolerance", result_cache_start_tolerance_,
+                       result_cache_start_tolerance_);
+    ROS_INFO_NAMED(getName(), "Caching up to %d planning results", result_cache_size);
+  }
+
+  int max_concurrent_requests = node_handle_.param("plan_service/max_concurrent_requests", 1);
+  if (max_concurrent_requests <= 1)
+  {
+    plan_service_ =
+        root_node_handle_.advertiseService(PLANNER_SERVICE_NAME, &MoveGroupPlanService::computePlanService, this);
+    return;
+  }
+
+  // Every waiting request blocks a thread until it is admitted, and one more thread is needed to reject requests
+  // while all others are busy
+  int max_waiting_requests = std::max(node_handle_.param("plan_service/max_waiting_requests", 8), 0);
+  node_handle_.getParam("plan_service/client_priorities", client_priorities_);
+  scheduler_ = std::make_shared<PlanningRequestScheduler>(max_concurrent_requests, max_waiting_requests);
+  plan_spinner_ =
+      std::make_unique<ros::AsyncSpinner>(max_concurrent_requests + max_waiting_requests + 1, &plan_queue_);
+  plan_spinner_->start();
+
+  ros::NodeHandle plan_node_handle(root_node_handle_);
+  plan_node_handle.setCallbackQueue(&plan_queue_);
   plan_service_ =
-      root_node_handle_.advertiseService(PLANNER_SERVICE_NAME, &MoveGroupPlanService::computePlanService, this);
+      plan_node_handle.advertiseService(PLANNER_SERVICE_NAME, &MoveGroupPlanService::computePlanService, this);
+  ROS_INFO_NAMED(getName(), "Handling up to %d planning service requests concurrently, with up to %d waiting",
+                 max_concurrent_requests, max_waiting_requests);
 }
 
-bool MoveGroupPlanService::computePlanService(moveit_msgs::GetMotionPlan::Request& req,
-                                              moveit_msgs::GetMotionPlan::Response& res)
+bool MoveGroupPlanService::computePlanService(PlanServiceEvent& event)
+{
+  const moveit_msgs::GetMotionPlan::Request& req = event.getRequest();
+  moveit_msgs::GetMotionPlan::Response& res = event.getResponse();
+  if (!scheduler_)
+  {
+    computePlan(req, res, false);
+    return true;
+  }
+
+  std::map<std::string, int>::const_iterator priority = client_priorities_.find(event.getCallerName());
+  if (!scheduler_->acquire(priority == client_priorities_.end() ? 0 : priority->second))
+  {
+    ROS_WARN_NAMED(getName(), "Rejecting planning service request of '%s': %zu requests are waiting already",
+                   event.getCallerName().c_str(), scheduler_->getMaxWaiting());
+    res.motion_plan_response.error_code.val = moveit_msgs::MoveItErrorCodes::FAILURE;
+    return true;
+  }
+  PlanningRequestScheduler::Slot slot(*scheduler_);
+  computePlan(req, res, true);
+  return true;
+}
+
+void MoveGroupPlanService::computePlan(const moveit_msgs::GetMotionPlan::Request& req,
+                                       moveit_msgs::GetMotionPlan::Response& res, bool use_snapshot)
 {
   ROS_INFO_NAMED(getName(), "Received new planning service request...");
   // before we start planning, ensure that we have the latest robot state received...
@@ -65,23 +121,77 @@ bool MoveGroupPlanService::computePlanService(moveit_msgs::GetMotionPlan::Reques
   if (!planning_pipeline)
   {
     res.motion_plan_response.error_code.val = moveit_msgs::MoveItErrorCodes::FAILURE;
-    return true;
+    return;
+  }
+
+  ros::WallTime lock_start = ros::WallTime::now();
+  std::unique_ptr<planning_scene_monitor::LockedPlanningSceneRO> lscene;
+  planning_scene::PlanningSceneConstPtr scene;
+  if (use_snapshot)
+    scene = context_->planning_scene_monitor_->getPlanningSceneSnapshot();
+  else
+  {
+    lscene = std::make_unique<planning_scene_monitor::LockedPlanningSceneRO>(context_->planning_scene_monitor_);
+    scene = *lscene;
+  }
+  double lock_time = (ros::WallTime::now() - lock_start).toSec();
+  if (!scene)
+  {
+    res.motion_plan_response.error_code.val = moveit_msgs::MoveItErrorCodes::FAILURE;
+    return;
+  }
+
+  std::string cache_key;
+  if (result_cache_)
+  {
+    // a cached path is only reused if it still starts at the requested start state and is valid in the current scene
+    ros::WallTime cache_start = ros::WallTime::now();
+    cache_key = PlanningResultCache::getKey(req.motion_plan_request);
+    planning_interface::MotionPlanResponse cached_res;
+    const moveit_msgs::MotionPlanRequest& request = req.motion_plan_request;
+    if (result_cache_->lookup(
+            cache_key,
+            [this, &scene, &request](const planning_interface::MotionPlanResponse& cached) {
+              moveit::core::RobotState start_state = scene->getCurrentState();
+              moveit::core::robotStateMsgToRobotState(scene->getTransforms(), request.start_state, start_state);
+              const moveit::core::RobotState& first_state = cached.trajectory_->getFirstWayPoint();
+              const moveit::core::JointModelGroup* group = cached.trajectory_->getGroup();
+              double distance = group ? start_state.distance(first_state, group) : start_state.distance(first_state);
+              return distance <= result_cache_start_tolerance_ &&
+                     scene->isPathValid(*cached.trajectory_, request.path_constraints, request.group_name);
+            },
+            cached_res))
+    {
+      double cache_time = (ros::WallTime::now() - cache_start).toSec();
+      cached_res.planning_time_ = lock_time + cache_time;
+      cached_res.stage_description_.clear();
+      cached_res.stage_time_.clear();
+      cached_res.addStageTime(use_snapshot ? "scene snapshot" : "scene lock", lock_time);
+      cached_res.addStageTime("result cache", cache_time);
+      cached_res.getMessage(res.motion_plan_response);
+      ROS_DEBUG_NAMED(getName(), "Returning cached planning result (%zu hits, %zu misses)", result_cache_->getHits(),
+                      result_cache_->getMisses());
+      return;
+    }
+    ROS_INFO_THROTTLE_NAMED(60.0, getName(), "Planning result cache: %zu hits, %zu misses, %zu entries",
+                            result_cache_->getHits(), result_cache_->getMisses(), result_cache_->size());
   }
 
-  planning_scene_monitor::LockedPlanningSceneRO ps(context_->planning_scene_monitor_);
   try
   {
     planning_interface::MotionPlanResponse mp_res;
-    planning_pipeline->generatePlan(ps, req.motion_plan_request, mp_res);
+    mp_res.addStageTime(use_snapshot ? "scene snapshot" : "scene lock", lock_time);
+    planning_pipeline->generatePlan(scene, req.motion_plan_request, mp_res);
     mp_res.getMessage(res.motion_plan_response);
+    if (result_cache_ && mp_res.error_code_.val == moveit_msgs::MoveItErrorCodes::SUCCESS && mp_res.trajectory_ &&
+        !mp_res.trajectory_->empty())
+      result_cache_->insert(cache_key, mp_res);
   }
   catch (std::exception& ex)
   {
     ROS_ERROR_NAMED(getName(), "Planning pipeline threw an exception: %s", ex.what());
     res.motion_plan_response.error_code.val = moveit_msgs::MoveItErrorCodes::FAILURE;
   }
-
-  return true;
 }
 }  // namespace move_group
 
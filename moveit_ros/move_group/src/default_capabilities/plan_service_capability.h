@@ -37,7 +37,12 @@
 #pragma once
 
 #include <moveit/move_group/move_group_capability.h>
+#include <moveit/move_group/planning_request_scheduler.h>
+#include <moveit/move_group/planning_result_cache.h>
 #include <moveit_msgs/GetMotionPlan.h>
+#include <ros/callback_queue.h>
+#include <map>
+#include <memory>
 
 namespace move_group
 {
@@ -49,7 +54,24 @@ public:
   void initialize() override;
 
 private:
-  bool computePlanService(moveit_msgs::GetMotionPlan::Request& req, moveit_msgs::GetMotionPlan::Response& res);
+  typedef ros::ServiceEvent<moveit_msgs::GetMotionPlan::Request, moveit_msgs::GetMotionPlan::Response> PlanServiceEvent;
+
+  bool computePlanService(PlanServiceEvent& event);
+
+  /** \brief Plan for \e req. With \e use_snapshot, plan on an immutable snapshot of the scene instead of keeping the
+   *  scene locked, so that concurrent requests do not hold up scene updates. */
+  void computePlan(const moveit_msgs::GetMotionPlan::Request& req, moveit_msgs::GetMotionPlan::Response& res,
+                   bool use_snapshot);
+
+  /// Only used when requests are handled concurrently, otherwise they are handled one by one on the main queue
+  ros::CallbackQueue plan_queue_;
+  PlanningRequestSchedulerPtr scheduler_;
+  std::map<std::string, int> client_priorities_;
+  std::unique_ptr<ros::AsyncSpinner> plan_spinner_;
+
+  /// Only set if results are cached
+  PlanningResultCachePtr result_cache_;
+  double result_cache_start_tolerance_;
 
   ros::ServiceServer plan_service_;
 };
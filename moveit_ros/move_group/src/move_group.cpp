@@ -42,6 +42,8 @@
 #include <boost/tokenizer.hpp>
 #include <moveit/macros/console_colors.h>
 #include <moveit/move_group/node_name.h>
+#include <moveit/kinematic_constraints/utils.h>
+#include <moveit/planning_pipeline/planning_pipeline.h>
 #include <memory>
 #include <set>
 
@@ -82,6 +84,12 @@ public:
     context_ =
         std::make_shared<MoveGroupContext>(moveit_cpp, default_planning_pipeline, allow_trajectory_execution, debug);
 
+    // optionally initialize everything that is set up lazily before the first request can arrive
+    bool warmup;
+    node_handle_.param("warmup", warmup, false);
+    if (warmup)
+      warmUp();
+
     // start the capabilities
     configureCapabilities();
   }
@@ -112,6 +120,67 @@ public:
   }
 
 private:
+  /** Run a first IK query, collision check and planning request, so that kinematics solvers (and their caches),
+      collision environments and planning contexts are initialized before the capabilities are offered.
+      The planning requests are trivial ones to the current state of each group listed in ~warmup_groups
+      (by default all groups with a kinematics solver). */
+  void warmUp()
+  {
+    ros::WallTime start = ros::WallTime::now();
+    const planning_scene::PlanningSceneConstPtr scene =
+        context_->planning_scene_monitor_->getPlanningSceneSnapshot();
+    const moveit::core::RobotState& current_state = scene->getCurrentState();
+
+    collision_detection::CollisionRequest collision_request;
+    collision_detection::CollisionResult collision_result;
+    scene->checkCollision(collision_request, collision_result, current_state);
+
+    std::vector<std::string> group_names;
+    if (!node_handle_.getParam("warmup_groups", group_names))
+      for (const moveit::core::JointModelGroup* jmg : scene->getRobotModel()->getJointModelGroups())
+        if (jmg->getSolverInstance())
+          group_names.push_back(jmg->getName());
+
+    double planning_time;
+    node_handle_.param("warmup_planning_time", planning_time, 1.0);
+
+    for (const std::string& group_name : group_names)
+    {
+      const moveit::core::JointModelGroup* jmg = scene->getRobotModel()->getJointModelGroup(group_name);
+      if (!jmg)
+      {
+        ROS_WARN_NAMED(LOGNAME, "Unknown warm-up group '%s'", group_name.c_str());
+        continue;
+      }
+
+      // IK for the current pose of the tip, which makes caching solvers load their caches
+      const kinematics::KinematicsBaseConstPtr solver = jmg->getSolverInstance();
+      if (solver && solver->getTipFrames().size() == 1)
+      {
+        moveit::core::RobotState state(current_state);
+        const Eigen::Isometry3d pose = state.getGlobalLinkTransform(solver->getTipFrame());
+        if (!state.setFromIK(jmg, pose, solver->getTipFrame(), jmg->getDefaultIKTimeout()))
+          ROS_DEBUG_NAMED(LOGNAME, "Warm-up IK query failed for group '%s'", group_name.c_str());
+      }
+
+      if (context_->planning_pipeline_)
+      {
+        planning_interface::MotionPlanRequest request;
+        request.group_name = group_name;
+        request.start_state.is_diff = true;
+        request.allowed_planning_time = planning_time;
+        request.num_planning_attempts = 1;
+        request.goal_constraints.push_back(kinematic_constraints::constructGoalConstraints(current_state, jmg));
+        planning_interface::MotionPlanResponse response;
+        if (!context_->planning_pipeline_->generatePlan(scene, request, response))
+          ROS_DEBUG_NAMED(LOGNAME, "Warm-up planning request failed for group '%s': %s", group_name.c_str(),
+                          moveit::core::MoveItErrorCode::toString(response.error_code_));
+      }
+    }
+    ROS_INFO_NAMED(LOGNAME, "Warm-up of %zu groups took %.3f seconds", group_names.size(),
+                   (ros::WallTime::now() - start).toSec());
+  }
+
   void configureCapabilities()
   {
     try
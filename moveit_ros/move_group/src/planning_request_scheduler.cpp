@@ -0,0 +1,89 @@
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2026, PickNik LLC.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of PickNik LLC nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *********************************************************************/
+
+#include <moveit/move_group/planning_request_scheduler.h>
+#include <algorithm>
+
+namespace move_group
+{
+PlanningRequestScheduler::PlanningRequestScheduler(std::size_t max_active, std::size_t max_waiting)
+  : max_active_(std::max<std::size_t>(max_active, 1)), max_waiting_(max_waiting), active_(0), next_ticket_(0)
+{
+}
+
+bool PlanningRequestScheduler::acquire(int priority)
+{
+  std::unique_lock<std::mutex> ulock(lock_);
+  if (waiting_.empty() && active_ < max_active_)
+  {
+    ++active_;
+    return true;
+  }
+  if (waiting_.size() >= max_waiting_)
+    return false;
+
+  const std::pair<int, std::uint64_t> entry(-priority, next_ticket_++);
+  waiting_.insert(entry);
+  slot_freed_.wait(ulock, [this, &entry] { return active_ < max_active_ && *waiting_.begin() == entry; });
+  waiting_.erase(waiting_.begin());
+  ++active_;
+
+  // more than one slot may have been freed meanwhile
+  if (active_ < max_active_ && !waiting_.empty())
+    slot_freed_.notify_all();
+  return true;
+}
+
+void PlanningRequestScheduler::release()
+{
+  {
+    std::lock_guard<std::mutex> slock(lock_);
+    --active_;
+  }
+  // only the first waiting request can proceed, but the condition variable cannot wake a particular one
+  slot_freed_.notify_all();
+}
+
+std::size_t PlanningRequestScheduler::getActiveCount() const
+{
+  std::lock_guard<std::mutex> slock(lock_);
+  return active_;
+}
+
+std::size_t PlanningRequestScheduler::getWaitingCount() const
+{
+  std::lock_guard<std::mutex> slock(lock_);
+  return waiting_.size();
+}
+}  // namespace move_group
@@ -0,0 +1,153 @@
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2026, PickNik LLC.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of PickNik LLC nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *********************************************************************/
+
+#include <moveit/move_group/planning_result_cache.h>
+#include <ros/serialization.h>
+
+namespace move_group
+{
+namespace
+{
+void clearStamps(moveit_msgs::Constraints& constraints)
+{
+  for (moveit_msgs::PositionConstraint& constraint : constraints.position_constraints)
+    constraint.header.stamp = ros::Time();
+  for (moveit_msgs::OrientationConstraint& constraint : constraints.orientation_constraints)
+    constraint.header.stamp = ros::Time();
+}
+}  // namespace
+
+PlanningResultCache::PlanningResultCache(std::size_t capacity) : capacity_(capacity), hits_(0), misses_(0)
+{
+}
+
+std::string PlanningResultCache::getKey(const moveit_msgs::MotionPlanRequest& request)
+{
+  moveit_msgs::MotionPlanRequest canonical = request;
+  canonical.workspace_parameters.header.stamp = ros::Time();
+  canonical.start_state.joint_state.header.stamp = ros::Time();
+  canonical.start_state.multi_dof_joint_state.header.stamp = ros::Time();
+  for (moveit_msgs::AttachedCollisionObject& object : canonical.start_state.attached_collision_objects)
+    object.object.header.stamp = ros::Time();
+  for (moveit_msgs::Constraints& constraints : canonical.goal_constraints)
+    clearStamps(constraints);
+  clearStamps(canonical.path_constraints);
+
+  std::string key(ros::serialization::serializationLength(canonical), '\0');
+  ros::serialization::OStream stream(reinterpret_cast<uint8_t*>(&key[0]), key.size());
+  ros::serialization::serialize(stream, canonical);
+  return key;
+}
+
+bool PlanningResultCache::lookup(const std::string& key, const ValidityFn& is_valid,
+                                 planning_interface::MotionPlanResponse& result)
+{
+  planning_interface::MotionPlanResponse candidate;
+  {
+    std::lock_guard<std::mutex> slock(lock_);
+    std::unordered_map<std::string, Entries::iterator>::iterator it = index_.find(key);
+    if (it == index_.end())
+    {
+      ++misses_;
+      return false;
+    }
+    entries_.splice(entries_.begin(), entries_, it->second);
+    candidate = it->second->second;
+  }
+
+  const bool valid = is_valid(candidate);
+  std::lock_guard<std::mutex> slock(lock_);
+  if (!valid)
+  {
+    // the entry may have been replaced by a newer result meanwhile, which is kept
+    std::unordered_map<std::string, Entries::iterator>::iterator it = index_.find(key);
+    if (it != index_.end() && it->second->second.trajectory_ == candidate.trajectory_)
+    {
+      entries_.erase(it->second);
+      index_.erase(it);
+    }
+    ++misses_;
+    return false;
+  }
+  ++hits_;
+  result = candidate;
+  return true;
+}
+
+void PlanningResultCache::insert(const std::string& key, const planning_interface::MotionPlanResponse& result)
+{
+  if (capacity_ == 0)
+    return;
+  std::lock_guard<std::mutex> slock(lock_);
+  std::unordered_map<std::string, Entries::iterator>::iterator it = index_.find(key);
+  if (it != index_.end())
+  {
+    it->second->second = result;
+    entries_.splice(entries_.begin(), entries_, it->second);
+    return;
+  }
+  entries_.emplace_front(key, result);
+  index_[key] = entries_.begin();
+  if (entries_.size() > capacity_)
+  {
+    index_.erase(entries_.back().first);
+    entries_.pop_back();
+  }
+}
+
+void PlanningResultCache::clear()
+{
+  std::lock_guard<std::mutex> slock(lock_);
+  entries_.clear();
+  index_.clear();
+}
+
+std::size_t PlanningResultCache::size() const
+{
+  std::lock_guard<std::mutex> slock(lock_);
+  return entries_.size();
+}
+
+std::size_t PlanningResultCache::getHits() const
+{
+  std::lock_guard<std::mutex> slock(lock_);
+  return hits_;
+}
+
+std::size_t PlanningResultCache::getMisses() const
+{
+  std::lock_guard<std::mutex> slock(lock_);
+  return misses_;
+}
+}  // namespace move_group
@@ -52,7 +52,8 @@ namespace moveit_servo
 enum CollisionCheckType
 {
   K_THRESHOLD_DISTANCE = 1,
-  K_STOP_DISTANCE = 2
+  K_STOP_DISTANCE = 2,
+  K_PREDICTIVE = 3
 };
 
 class CollisionCheck
@@ -66,6 +67,13 @@ public:
   CollisionCheck(ros::NodeHandle& nh, const moveit_servo::ServoParameters& parameters,
                  const planning_scene_monitor::PlanningSceneMonitorPtr& planning_scene_monitor);
 
+  /** \brief Constructor of a collision check shared by several servo instances, one in each of \e servo_nhs.
+   *  The velocity scale is sent to all of them, and the longest of their worst-case stop times is used.
+   *  parameters.move_group_name should contain the joints of all the servo instances.
+   */
+  CollisionCheck(const std::vector<ros::NodeHandle>& servo_nhs, const moveit_servo::ServoParameters& parameters,
+                 const planning_scene_monitor::PlanningSceneMonitorPtr& planning_scene_monitor);
+
   ~CollisionCheck()
   {
     timer_.stop();
@@ -81,11 +89,18 @@ private:
   /** \brief Run one iteration of collision checking */
   void run(const ros::TimerEvent& timer_event);
 
+  /** \brief Scale velocity by the distances to collision of the current state */
+  void checkDistances();
+
+  /** \brief Halt if the robot, continuing its current motion, would collide before it could stop */
+  void checkPredictedMotion();
+
   /** \brief Get a read-only copy of the planning scene */
   planning_scene_monitor::LockedPlanningSceneRO getLockedPlanningSceneRO() const;
 
-  /** \brief Callback for stopping time, from the thread that is aware of velocity and acceleration */
-  void worstCaseStopTimeCB(const std_msgs::Float64ConstPtr& msg);
+  /** \brief Callback for stopping time, from the thread of servo instance \e servo_index that is aware of velocity and
+   * acceleration */
+  void worstCaseStopTimeCB(const std_msgs::Float64ConstPtr& msg, std::size_t servo_index);
 
   ros::NodeHandle nh_;
 
@@ -116,6 +131,7 @@ private:
   double est_time_to_collision_ = 0;
   double safety_factor_ = 1000;
   double worst_case_stop_time_ = std::numeric_limits<double>::max();
+  std::vector<double> worst_case_stop_times_;  // of each servo instance
 
   const double self_velocity_scale_coefficient_;
   const double scene_velocity_scale_coefficient_;
@@ -124,11 +140,21 @@ private:
   collision_detection::CollisionRequest collision_request_;
   collision_detection::CollisionResult collision_result_;
 
+  // Variables for predictive collision checking. The predicted states are kept from one iteration to the next.
+  collision_detection::CollisionRequest prediction_request_;
+  std::vector<moveit::core::RobotState> predicted_states_;
+  std::vector<const moveit::core::RobotState*> predicted_state_ptrs_;
+  std::vector<bool> predicted_self_collisions_;
+  std::vector<double> positions_;
+  std::vector<double> velocities_;
+  std::vector<double> prev_positions_;
+  ros::Time prev_positions_time_;
+
   // ROS
   ros::Timer timer_;
   ros::Duration period_;
   ros::Subscriber joint_state_sub_;
-  ros::Publisher collision_velocity_scale_pub_;
-  ros::Subscriber worst_case_stop_time_sub_;
+  std::vector<ros::Publisher> collision_velocity_scale_pubs_;
+  std::vector<ros::Subscriber> worst_case_stop_time_subs_;
 };
 }  // namespace moveit_servo
@@ -0,0 +1,89 @@
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2026, PickNik LLC.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of PickNik LLC nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *********************************************************************/
+
+#pragma once
+
+#include <memory>
+#include <vector>
+
+#include <realtime_tools/realtime_buffer.h>
+#include <trajectory_msgs/JointTrajectory.h>
+
+namespace moveit_servo
+{
+/**
+ * Receives the commands calculated by servo instead of the command_out_topic, e.g. to hand them to a controller
+ * running in the same process without serializing them and waiting for a subscriber to be scheduled.
+ */
+class CommandSink
+{
+public:
+  virtual ~CommandSink() = default;
+
+  /** \brief Write one outgoing command. The joints are the active joints of the servoed group, in group order.
+   * Called from the servo loop for every command sent, so it should return quickly and not block.
+   */
+  virtual void write(const trajectory_msgs::JointTrajectory& command) = 0;
+};
+
+using CommandSinkPtr = std::shared_ptr<CommandSink>;
+
+/**
+ * Writes the positions or velocities of servo commands into the command buffer of a ros_control controller in the same
+ * process, e.g. the commands_buffer_ of a forward_command_controller::ForwardJointGroupCommandController. The
+ * controller's joints have to be the active joints of the servoed group, in the same order.
+ */
+class RealtimeBufferCommandSink : public CommandSink
+{
+public:
+  RealtimeBufferCommandSink(realtime_tools::RealtimeBuffer<std::vector<double>>& buffer, bool write_velocities)
+    : buffer_(buffer), write_velocities_(write_velocities)
+  {
+  }
+
+  void write(const trajectory_msgs::JointTrajectory& command) override
+  {
+    if (command.points.empty())
+      return;
+    const std::vector<double>& values =
+        write_velocities_ ? command.points.front().velocities : command.points.front().positions;
+    if (!values.empty())
+      buffer_.writeFromNonRT(values);
+  }
+
+private:
+  realtime_tools::RealtimeBuffer<std::vector<double>>& buffer_;
+  const bool write_velocities_;
+};
+}  // namespace moveit_servo
@@ -0,0 +1,98 @@
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2026, PickNik LLC.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of PickNik LLC nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *********************************************************************/
+
+#pragma once
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <moveit_servo/servo.h>
+
+namespace moveit_servo
+{
+/**
+ * Class MultiGroupServo - servo several joint groups of one robot, e.g. both arms of a dual-arm robot.
+ *
+ * Every group is served by a Servo instance in its own sub-namespace, configured like a single servo server. All of
+ * them share the planning scene monitor and thus the scene processing and joint state stream, and each one runs its
+ * calculations in its own thread. Collisions are checked once for all groups together, so collisions between the
+ * groups are detected, using the collision settings of the first group.
+ *
+ * Parameters:
+ *   servo_groups:          sub-namespaces of the servo instances, e.g. [left_arm, right_arm]
+ *   collision_check_group: a joint model group containing the joints of all servo groups, e.g. both_arms.
+ *                          Optional when only one group is servoed.
+ */
+class MultiGroupServo
+{
+public:
+  MultiGroupServo(ros::NodeHandle& nh, const planning_scene_monitor::PlanningSceneMonitorPtr& planning_scene_monitor);
+
+  ~MultiGroupServo();
+
+  /** \brief Start servoing all groups */
+  void start();
+
+  /** \brief Pause or unpause processing servo commands of all groups while keeping the timers alive */
+  void setPaused(bool paused);
+
+  /** \brief Get the servo instances, in the order of the servo_groups parameter */
+  const std::vector<std::unique_ptr<Servo>>& getServos() const
+  {
+    return servos_;
+  }
+
+private:
+  bool readParameters();
+
+  ros::NodeHandle nh_;
+
+  planning_scene_monitor::PlanningSceneMonitorPtr planning_scene_monitor_;
+
+  std::vector<std::string> servo_groups_;
+  std::string collision_check_group_;
+
+  std::vector<ros::NodeHandle> servo_nhs_;
+  std::vector<std::unique_ptr<Servo>> servos_;
+
+  // Settings of the joint collision check, those of the first servo group applied to collision_check_group_
+  ServoParameters collision_parameters_;
+  std::unique_ptr<CollisionCheck> collision_checker_;
+};
+
+// MultiGroupServoPtr using alias
+using MultiGroupServoPtr = std::shared_ptr<MultiGroupServo>;
+
+}  // namespace moveit_servo
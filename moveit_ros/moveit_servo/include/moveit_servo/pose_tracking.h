@@ -39,6 +39,7 @@
 #pragma once
 
 #include <atomic>
+#include <boost/circular_buffer.hpp>
 #include <boost/optional.hpp>
 #include <control_toolbox/pid.h>
 #include <moveit_servo/make_shared_from_pool.h>
@@ -62,6 +63,18 @@ struct PIDConfig
   double windup_limit = 0.1;
 };
 
+// Feed-forward of the target motion and gain scheduling by distance to the target
+struct TargetTrackingConfig
+{
+  // Number of recent target poses used to fit the target velocity. Less than 2 disables feed-forward
+  std::size_t feedforward_window = 0;
+  // PID outputs are scaled by gain_scale_near_target at the target, blending linearly to 1 at these errors.
+  // A distance of 0 disables gain scheduling
+  double gain_scheduling_distance = 0;  // [m]
+  double gain_scheduling_angle = 0;     // [rad]
+  double gain_scale_near_target = 1;
+};
+
 enum class PoseTrackingStatusCode : int8_t
 {
   INVALID = -1,
@@ -146,6 +159,12 @@ private:
   /** \brief Use PID controllers to calculate a full spatial velocity toward a pose */
   geometry_msgs::TwistStampedConstPtr calculateTwistCommand();
 
+  /** \brief Fit the target velocity to the recent target poses by linear least squares. Requires target_pose_mtx_ */
+  void updateTargetVelocity();
+
+  /** \brief Return the factor by which PID outputs are scaled at the given error */
+  double gainScale(const double error, const double scheduling_error) const;
+
   /** \brief Reset flags and PID controllers after a motion completes */
   void doPostMotionReset();
 
@@ -166,6 +185,7 @@ private:
   std::vector<control_toolbox::Pid> cartesian_orientation_pids_;
   // Cartesian PID configs
   PIDConfig x_pid_config_, y_pid_config_, z_pid_config_, angular_pid_config_;
+  TargetTrackingConfig tracking_config_;
 
   // Transforms w.r.t. planning_frame_
   Eigen::Isometry3d command_frame_transform_;
@@ -173,6 +193,19 @@ private:
   geometry_msgs::PoseStamped target_pose_;
   mutable std::mutex target_pose_mtx_;
 
+  // Recent target poses and the target velocity fitted to them, guarded by target_pose_mtx_
+  struct TargetSample
+  {
+    ros::Time stamp;
+    Eigen::Vector3d position;
+    Eigen::Quaterniond orientation;
+  };
+  boost::circular_buffer<TargetSample, Eigen::aligned_allocator<TargetSample>> target_history_;
+  Eigen::Vector3d target_linear_velocity_;
+  Eigen::Vector3d target_angular_velocity_;
+  // Average time between target samples, used to detect a target that stopped publishing
+  double target_sample_period_;
+
   // Subscribe to target pose
   ros::Subscriber target_pose_sub_;
 
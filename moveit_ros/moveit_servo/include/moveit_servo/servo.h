@@ -54,7 +54,11 @@ namespace moveit_servo
 class Servo
 {
 public:
-  Servo(ros::NodeHandle& nh, const planning_scene_monitor::PlanningSceneMonitorPtr& planning_scene_monitor);
+  /** \brief Constructor. If \e own_collision_check is false, this instance does not check collisions itself but obeys
+   * the velocity scale of a CollisionCheck shared with other servo instances, see MultiGroupServo.
+   */
+  Servo(ros::NodeHandle& nh, const planning_scene_monitor::PlanningSceneMonitorPtr& planning_scene_monitor,
+        bool own_collision_check = true);
 
   ~Servo();
 
@@ -95,6 +99,14 @@ public:
     servo_calcs_->changeRobotLinkCommandFrame(new_command_frame);
   }
 
+  /** \brief Send the outgoing commands to \e sink, e.g. a controller in the same process, instead of publishing them
+   * on command_out_topic. nullptr restores publishing.
+   */
+  void setCommandSink(const CommandSinkPtr& sink)
+  {
+    servo_calcs_->setCommandSink(sink);
+  }
+
   // Give test access to private/protected methods
   friend class ServoFixture;
 
@@ -43,9 +43,11 @@
 #include <mutex>
 #include <thread>
 #include <atomic>
+#include <memory>
 
 // ROS
 #include <control_msgs/JointJog.h>
+#include <Eigen/SVD>
 #include <geometry_msgs/TwistStamped.h>
 #include <geometry_msgs/TransformStamped.h>
 #include <moveit/planning_scene_monitor/planning_scene_monitor.h>
@@ -53,13 +55,16 @@
 #include <moveit_msgs/ChangeDriftDimensions.h>
 #include <moveit_msgs/ChangeControlDimensions.h>
 #include <sensor_msgs/JointState.h>
+#include <realtime_tools/realtime_publisher.h>
 #include <std_msgs/Float64.h>
+#include <std_msgs/Float64MultiArray.h>
 #include <std_msgs/Int8.h>
 #include <std_srvs/Empty.h>
 #include <tf2_eigen/tf2_eigen.h>
 #include <trajectory_msgs/JointTrajectory.h>
 
 // moveit_servo
+#include <moveit_servo/command_sink.h>
 #include <moveit_servo/servo_parameters.h>
 #include <moveit_servo/status_codes.h>
 #include <moveit_servo/low_pass_filter.h>
@@ -105,6 +110,9 @@ public:
    */
   void changeRobotLinkCommandFrame(const std::string& new_command_frame);
 
+  /** \brief Send the outgoing commands to \e sink instead of publishing them. nullptr restores publishing. */
+  void setCommandSink(const CommandSinkPtr& sink);
+
   // Give test access to private/protected methods
   friend class ServoFixture;
 
@@ -130,12 +138,12 @@ private:
   /** \brief If incoming velocity commands are from a unitless joystick, scale them to physical units.
    * Also, multiply by timestep to calculate a position change.
    */
-  Eigen::VectorXd scaleCartesianCommand(const geometry_msgs::TwistStamped& command) const;
+  Eigen::Matrix<double, 6, 1> scaleCartesianCommand(const geometry_msgs::TwistStamped& command) const;
 
   /** \brief If incoming velocity commands are from a unitless joystick, scale them to physical units.
-   * Also, multiply by timestep to calculate a position change.
+   * Also, multiply by timestep to calculate a position change, which is written to \e result.
    */
-  Eigen::VectorXd scaleJointCommand(const control_msgs::JointJog& command) const;
+  void scaleJointCommand(const control_msgs::JointJog& command, Eigen::ArrayXd& result) const;
 
   bool addJointIncrements(sensor_msgs::JointState& output, const Eigen::VectorXd& increments) const;
 
@@ -153,8 +161,8 @@ private:
   /** \brief Possibly calculate a velocity scaling factor, due to proximity of
    * singularity and direction of motion
    */
-  double velocityScalingFactorForSingularity(const Eigen::VectorXd& commanded_velocity,
-                                             const Eigen::JacobiSVD<Eigen::MatrixXd>& svd,
+  double velocityScalingFactorForSingularity(const Eigen::VectorXd& commanded_velocity, const Eigen::MatrixXd& matrix_u,
+                                             const Eigen::VectorXd& singular_values, const Eigen::MatrixXd& matrix_v,
                                              const Eigen::MatrixXd& pseudo_inverse);
 
   /**
@@ -188,13 +196,16 @@ private:
   void insertRedundantPointsIntoTrajectory(trajectory_msgs::JointTrajectory& joint_trajectory, int count) const;
 
   /**
-   * Remove the Jacobian row and the delta-x element of one Cartesian dimension, to take advantage of task redundancy
-   *
-   * @param matrix The Jacobian matrix.
-   * @param delta_x Vector of Cartesian delta commands, should be the same size as matrix.rows()
-   * @param row_to_remove Dimension that will be allowed to drift, e.g. row_to_remove = 2 allows z-translation drift.
+   * Copy the Jacobian rows and delta-x elements of the Cartesian dimensions that are not allowed to drift into
+   * controlled_jacobian_ and controlled_delta_x_, to take advantage of task redundancy
+   */
+  void selectControlledDimensions();
+
+  /**
+   * Compute the SVD of controlled_jacobian_ into svd_u_, svd_.singularValues() and svd_v_, warm-started from the
+   * decomposition of the previous iteration
    */
-  void removeDimension(Eigen::MatrixXd& matrix, Eigen::VectorXd& delta_x, unsigned int row_to_remove);
+  void decomposeControlledJacobian();
 
   /* \brief Callback for joint subsription */
   void jointStateCB(const sensor_msgs::JointStateConstPtr& msg);
@@ -263,7 +274,36 @@ private:
 
   std::vector<LowPassFilter> position_filters_;
 
-  trajectory_msgs::JointTrajectoryConstPtr last_sent_command_;
+  // The outgoing command is composed in place, so its memory is reused from one iteration to the next
+  trajectory_msgs::JointTrajectory outgoing_trajectory_;
+  trajectory_msgs::JointTrajectory last_sent_command_;
+  std_msgs::Float64MultiArray outgoing_array_;
+  CommandSinkPtr command_sink_;  // guarded by input_mutex_
+
+  // Workspaces of the Cartesian servoing calculations, sized for the group at startup so no memory is allocated
+  // while servoing. Only a change of the drift dimensions resizes the controlled ones.
+  Eigen::Matrix<double, 6, 1> delta_x_;
+  Eigen::Matrix<double, 6, Eigen::Dynamic> jacobian_;
+  Eigen::MatrixXd controlled_jacobian_;
+  Eigen::VectorXd controlled_delta_x_;
+  std::array<Eigen::Index, 6> controlled_dimensions_;
+  // Singular value decomposition of controlled_jacobian_ = svd_u_ * diag(svd_.singularValues()) * svd_v_^T
+  Eigen::JacobiSVD<Eigen::MatrixXd> svd_;
+  Eigen::MatrixXd svd_u_;
+  Eigen::MatrixXd svd_v_;
+  Eigen::MatrixXd rotated_jacobian_;
+  Eigen::MatrixXd rotated_jacobian_workspace_;
+  Eigen::MatrixXd svd_u_workspace_;
+  Eigen::MatrixXd svd_v_workspace_;
+  unsigned int svd_warm_starts_;
+  Eigen::MatrixXd scaled_v_;
+  Eigen::MatrixXd pseudo_inverse_;
+  // Workspaces of the look-ahead toward the nearest singularity
+  Eigen::VectorXd singular_vector_;
+  Eigen::VectorXd lookahead_theta_;
+  Eigen::Matrix<double, 6, Eigen::Dynamic> lookahead_jacobian_;
+  Eigen::Matrix<double, 6, Eigen::Dynamic> lookahead_jacobian_v_;
+  Eigen::VectorXd lookahead_singular_values_;
 
   // ROS
   ros::Subscriber joint_state_sub_;
@@ -273,6 +313,11 @@ private:
   ros::Publisher status_pub_;
   ros::Publisher worst_case_stop_time_pub_;
   ros::Publisher outgoing_cmd_pub_;
+  // In real-time mode, these send preallocated messages from their own threads instead of the publishers above
+  std::unique_ptr<realtime_tools::RealtimePublisher<std_msgs::Int8>> realtime_status_pub_;
+  std::unique_ptr<realtime_tools::RealtimePublisher<std_msgs::Float64>> realtime_worst_case_stop_time_pub_;
+  std::unique_ptr<realtime_tools::RealtimePublisher<trajectory_msgs::JointTrajectory>> realtime_trajectory_pub_;
+  std::unique_ptr<realtime_tools::RealtimePublisher<std_msgs::Float64MultiArray>> realtime_array_pub_;
   ros::ServiceServer drift_dimensions_server_;
   ros::ServiceServer control_dimensions_server_;
   ros::ServiceServer reset_servo_status_;
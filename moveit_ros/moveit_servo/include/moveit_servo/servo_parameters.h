@@ -72,6 +72,7 @@ struct ServoParameters
   bool publish_joint_velocities;
   bool publish_joint_accelerations;
   bool low_latency_mode;
+  int realtime_priority;
   // Collision checking
   bool check_collisions;
   std::string collision_check_type;
@@ -80,6 +81,7 @@ struct ServoParameters
   double self_collision_proximity_threshold;
   double collision_distance_safety_factor;
   double min_allowable_collision_distance;
+  int collision_prediction_steps;
 };
 
 }  // namespace moveit_servo
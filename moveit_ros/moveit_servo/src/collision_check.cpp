@@ -37,6 +37,8 @@
  *      Author    : Brian O'Neil, Andy Zelenak, Blake Anderson
  */
 
+#include <algorithm>
+
 #include <std_msgs/Float64.h>
 
 #include <moveit_servo/collision_check.h>
@@ -52,7 +54,14 @@ namespace moveit_servo
 // Constructor for the class that handles collision checking
 CollisionCheck::CollisionCheck(ros::NodeHandle& nh, const moveit_servo::ServoParameters& parameters,
                                const planning_scene_monitor::PlanningSceneMonitorPtr& planning_scene_monitor)
-  : nh_(nh)
+  : CollisionCheck(std::vector<ros::NodeHandle>{ nh }, parameters, planning_scene_monitor)
+{
+}
+
+CollisionCheck::CollisionCheck(const std::vector<ros::NodeHandle>& servo_nhs,
+                               const moveit_servo::ServoParameters& parameters,
+                               const planning_scene_monitor::PlanningSceneMonitorPtr& planning_scene_monitor)
+  : nh_(servo_nhs.front())
   , parameters_(parameters)
   , planning_scene_monitor_(planning_scene_monitor)
   , self_velocity_scale_coefficient_(-log(0.001) / parameters.self_collision_proximity_threshold)
@@ -64,19 +73,32 @@ CollisionCheck::CollisionCheck(ros::NodeHandle& nh, const moveit_servo::ServoPar
   collision_request_.distance = true;  // enable distance-based collision checking
   collision_request_.contacts = true;  // Record the names of collision pairs
 
+  // Predicted motion is only checked for collisions, which is much cheaper than computing distances
+  prediction_request_.group_name = parameters_.move_group_name;
+
   if (parameters_.collision_check_rate < MIN_RECOMMENDED_COLLISION_RATE)
     ROS_WARN_STREAM_THROTTLE_NAMED(ROS_LOG_THROTTLE_PERIOD, LOGNAME,
                                    "Collision check rate is low, increase it in yaml file if CPU allows");
 
-  collision_check_type_ =
-      (parameters_.collision_check_type == "threshold_distance" ? K_THRESHOLD_DISTANCE : K_STOP_DISTANCE);
+  if (parameters_.collision_check_type == "threshold_distance")
+    collision_check_type_ = K_THRESHOLD_DISTANCE;
+  else if (parameters_.collision_check_type == "predictive")
+    collision_check_type_ = K_PREDICTIVE;
+  else
+    collision_check_type_ = K_STOP_DISTANCE;
   safety_factor_ = parameters_.collision_distance_safety_factor;
 
-  // Internal namespace
-  ros::NodeHandle internal_nh(nh_, "internal");
-  collision_velocity_scale_pub_ = internal_nh.advertise<std_msgs::Float64>("collision_velocity_scale", ROS_QUEUE_SIZE);
-  worst_case_stop_time_sub_ =
-      internal_nh.subscribe("worst_case_stop_time", ROS_QUEUE_SIZE, &CollisionCheck::worstCaseStopTimeCB, this);
+  // Internal namespace of each servo instance
+  worst_case_stop_times_.assign(servo_nhs.size(), std::numeric_limits<double>::max());
+  for (std::size_t i = 0; i < servo_nhs.size(); ++i)
+  {
+    ros::NodeHandle internal_nh(servo_nhs[i], "internal");
+    collision_velocity_scale_pubs_.push_back(
+        internal_nh.advertise<std_msgs::Float64>("collision_velocity_scale", ROS_QUEUE_SIZE));
+    worst_case_stop_time_subs_.push_back(internal_nh.subscribe<std_msgs::Float64>(
+        "worst_case_stop_time", ROS_QUEUE_SIZE,
+        [this, i](const std_msgs::Float64ConstPtr& msg) { worstCaseStopTimeCB(msg, i); }));
+  }
 
   current_state_ = planning_scene_monitor_->getStateMonitor()->getCurrentState();
   acm_ = getLockedPlanningSceneRO()->getAllowedCollisionMatrix();
@@ -110,6 +132,23 @@ void CollisionCheck::run(const ros::TimerEvent& timer_event)
   // Update to the latest current state
   current_state_ = planning_scene_monitor_->getStateMonitor()->getCurrentState();
   current_state_->updateCollisionBodyTransforms();
+
+  if (collision_check_type_ == K_PREDICTIVE)
+    checkPredictedMotion();
+  else
+    checkDistances();
+
+  // publish message
+  {
+    auto msg = moveit::util::make_shared_from_pool<std_msgs::Float64>();
+    msg->data = velocity_scale_;
+    for (const ros::Publisher& collision_velocity_scale_pub : collision_velocity_scale_pubs_)
+      collision_velocity_scale_pub.publish(msg);
+  }
+}
+
+void CollisionCheck::checkDistances()
+{
   collision_detected_ = false;
 
   // Do a timer-safe distance-based collision detection
@@ -188,18 +227,94 @@ void CollisionCheck::run(const ros::TimerEvent& timer_event)
     // Update for the next iteration
     prev_collision_distance_ = current_collision_distance_;
   }
+}
 
-  // publish message
+void CollisionCheck::checkPredictedMotion()
+{
+  const moveit::core::JointModelGroup* group = current_state_->getJointModelGroup(parameters_.move_group_name);
+  const double step = period_.toSec();
+  const std::size_t num_states = parameters_.collision_prediction_steps + 1;
+
+  // Predict the motion from the joint velocities, the same ones the worst-case stop time is based on. If the joint
+  // states have no velocities, differentiate the positions since the previous iteration instead.
+  const ros::Time now = ros::Time::now();
+  current_state_->copyJointGroupPositions(group, positions_);
+  if (current_state_->hasVelocities())
+    current_state_->copyJointGroupVelocities(group, velocities_);
+  else
   {
-    auto msg = moveit::util::make_shared_from_pool<std_msgs::Float64>();
-    msg->data = velocity_scale_;
-    collision_velocity_scale_pub_.publish(msg);
+    velocities_.assign(positions_.size(), 0.0);
+    if (prev_positions_.size() == positions_.size() && now > prev_positions_time_)
+      for (std::size_t i = 0; i < positions_.size(); ++i)
+        velocities_[i] = (positions_[i] - prev_positions_[i]) / (now - prev_positions_time_).toSec();
+  }
+  prev_positions_ = positions_;
+  prev_positions_time_ = now;
+
+  // The states reached at the end of each of the next collision check periods, starting with the current one
+  if (predicted_states_.size() != num_states)
+  {
+    predicted_states_.assign(num_states, *current_state_);
+    predicted_state_ptrs_.clear();
+    for (const moveit::core::RobotState& state : predicted_states_)
+      predicted_state_ptrs_.push_back(&state);
+  }
+  for (std::size_t k = 0; k < num_states; ++k)
+  {
+    moveit::core::RobotState& state = predicted_states_[k];
+    state.setVariablePositions(current_state_->getVariablePositions());
+    for (std::size_t i = 0; i < positions_.size(); ++i)
+      positions_[i] = prev_positions_[i] + velocities_[i] * k * step;
+    state.setJointGroupPositions(group, positions_);
+    state.enforceBounds(group);
+    state.updateCollisionBodyTransforms();
+  }
+
+  // Find the first predicted collision. Self-collisions are checked for all states in one batch, and the motion
+  // between consecutive states is swept for collisions with the world, so thin obstacles in between are not missed.
+  planning_scene_monitor::LockedPlanningSceneRO scene = getLockedPlanningSceneRO();
+  std::size_t first_collision = num_states;
+  scene->getCollisionEnvUnpadded()->isSelfColliding(predicted_state_ptrs_, acm_, predicted_self_collisions_,
+                                                    parameters_.move_group_name);
+  for (std::size_t k = 0; k < num_states; ++k)
+    if (predicted_self_collisions_[k])
+    {
+      first_collision = k;
+      break;
+    }
+
+  collision_result_.clear();
+  scene->getCollisionEnv()->checkRobotCollision(prediction_request_, collision_result_, predicted_states_[0]);
+  if (collision_result_.collision)
+    first_collision = 0;
+  // a collision on the sweep to state k may happen right after state k - 1
+  for (std::size_t k = 1; k < first_collision; ++k)
+  {
+    collision_result_.clear();
+    scene->getCollisionEnv()->checkRobotCollision(prediction_request_, collision_result_, predicted_states_[k - 1],
+                                                  predicted_states_[k]);
+    if (collision_result_.collision)
+    {
+      first_collision = k - 1;
+      break;
+    }
+  }
+
+  // halt if the robot cannot stop before the predicted collision (including the safety factor)
+  collision_detected_ = first_collision == 0;
+  velocity_scale_ = 1;
+  if (first_collision < num_states && first_collision * step < safety_factor_ * worst_case_stop_time_)
+  {
+    velocity_scale_ = 0;
+    ROS_WARN_STREAM_THROTTLE_NAMED(ROS_LOG_THROTTLE_PERIOD, LOGNAME,
+                                   "Collision predicted in " << first_collision * step << " s. Halting.");
   }
 }
 
-void CollisionCheck::worstCaseStopTimeCB(const std_msgs::Float64ConstPtr& msg)
+void CollisionCheck::worstCaseStopTimeCB(const std_msgs::Float64ConstPtr& msg, std::size_t servo_index)
 {
-  worst_case_stop_time_ = msg->data;
+  worst_case_stop_times_[servo_index] = msg->data;
+  worst_case_stop_time_ = *std::max_element(worst_case_stop_times_.begin(), worst_case_stop_times_.end());
 }
 
 void CollisionCheck::setPaused(bool paused)
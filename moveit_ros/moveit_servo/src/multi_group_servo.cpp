@@ -0,0 +1,130 @@
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2026, PickNik LLC.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of PickNik LLC nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *********************************************************************/
+
+#include <rosparam_shortcuts/rosparam_shortcuts.h>
+
+#include <moveit_servo/multi_group_servo.h>
+
+static const std::string LOGNAME = "multi_group_servo";
+
+namespace moveit_servo
+{
+MultiGroupServo::MultiGroupServo(ros::NodeHandle& nh,
+                                 const planning_scene_monitor::PlanningSceneMonitorPtr& planning_scene_monitor)
+  : nh_(nh), planning_scene_monitor_(planning_scene_monitor)
+{
+  if (!readParameters())
+    exit(EXIT_FAILURE);
+
+  // The servo instances leave collision checking to the joint check below
+  for (const std::string& servo_group : servo_groups_)
+  {
+    servo_nhs_.emplace_back(nh_, servo_group);
+    servos_.push_back(std::make_unique<Servo>(servo_nhs_.back(), planning_scene_monitor_, false));
+  }
+
+  // The collision check group must move all servoed joints, so the predicted motion covers them
+  if (collision_check_group_.empty())
+    collision_check_group_ = servos_.front()->getParameters().move_group_name;
+  const moveit::core::RobotModelConstPtr& robot_model = planning_scene_monitor_->getRobotModel();
+  const moveit::core::JointModelGroup* collision_group = robot_model->getJointModelGroup(collision_check_group_);
+  if (!collision_group)
+    exit(EXIT_FAILURE);
+  for (const std::unique_ptr<Servo>& servo : servos_)
+  {
+    const std::string& group_name = servo->getParameters().move_group_name;
+    for (const std::string& joint_name : robot_model->getJointModelGroup(group_name)->getActiveJointModelNames())
+    {
+      if (!collision_group->hasJointModel(joint_name))
+      {
+        ROS_FATAL_STREAM_NAMED(LOGNAME, "Joint '" << joint_name << "' of servo group '" << group_name
+                                                  << "' is not in collision_check_group '" << collision_check_group_
+                                                  << "'");
+        exit(EXIT_FAILURE);
+      }
+    }
+  }
+
+  collision_parameters_ = servos_.front()->getParameters();
+  collision_parameters_.move_group_name = collision_check_group_;
+  collision_checker_ = std::make_unique<CollisionCheck>(servo_nhs_, collision_parameters_, planning_scene_monitor_);
+}
+
+bool MultiGroupServo::readParameters()
+{
+  std::size_t error = 0;
+  error += !rosparam_shortcuts::get(LOGNAME, nh_, "servo_groups", servo_groups_);
+  if (nh_.hasParam("collision_check_group"))
+    error += !rosparam_shortcuts::get(LOGNAME, nh_, "collision_check_group", collision_check_group_);
+  if (error)
+    return false;
+
+  if (servo_groups_.empty())
+  {
+    ROS_WARN_NAMED(LOGNAME, "Parameter 'servo_groups' should list at least one group. Check yaml file.");
+    return false;
+  }
+  if (servo_groups_.size() > 1 && collision_check_group_.empty())
+  {
+    ROS_WARN_NAMED(LOGNAME, "Parameter 'collision_check_group' is required to servo several groups. Check yaml file.");
+    return false;
+  }
+  return true;
+}
+
+MultiGroupServo::~MultiGroupServo()
+{
+  setPaused(true);
+}
+
+void MultiGroupServo::start()
+{
+  for (const std::unique_ptr<Servo>& servo : servos_)
+    servo->start();
+
+  if (collision_parameters_.check_collisions)
+  {
+    collision_checker_->setPaused(false);
+    collision_checker_->start();
+  }
+}
+
+void MultiGroupServo::setPaused(bool paused)
+{
+  for (const std::unique_ptr<Servo>& servo : servos_)
+    servo->setPaused(paused);
+  collision_checker_->setPaused(paused);
+}
+
+}  // namespace moveit_servo
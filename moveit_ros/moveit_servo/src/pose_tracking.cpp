@@ -51,8 +51,12 @@ PoseTracking::PoseTracking(const ros::NodeHandle& nh,
   , transform_listener_(transform_buffer_)
   , stop_requested_(false)
   , angular_error_(boost::none)
+  , target_linear_velocity_(Eigen::Vector3d::Zero())
+  , target_angular_velocity_(Eigen::Vector3d::Zero())
+  , target_sample_period_(0)
 {
   readROSParams();
+  target_history_.set_capacity(tracking_config_.feedforward_window);
 
   robot_model_ = planning_scene_monitor_->getRobotModel();
   joint_model_group_ = robot_model_->getJointModelGroup(move_group_name_);
@@ -200,6 +204,24 @@ void PoseTracking::readROSParams()
   error += !rosparam_shortcuts::get(LOGNAME, nh, "angular_integral_gain", angular_pid_config_.k_i);
   error += !rosparam_shortcuts::get(LOGNAME, nh, "angular_derivative_gain", angular_pid_config_.k_d);
 
+  // Optional feed-forward of the target motion and gain scheduling
+  if (nh.hasParam("feedforward_window"))
+    error += !rosparam_shortcuts::get(LOGNAME, nh, "feedforward_window", tracking_config_.feedforward_window);
+  if (nh.hasParam("gain_scheduling_distance"))
+    error +=
+        !rosparam_shortcuts::get(LOGNAME, nh, "gain_scheduling_distance", tracking_config_.gain_scheduling_distance);
+  if (nh.hasParam("gain_scheduling_angle"))
+    error += !rosparam_shortcuts::get(LOGNAME, nh, "gain_scheduling_angle", tracking_config_.gain_scheduling_angle);
+  if (nh.hasParam("gain_scale_near_target"))
+    error += !rosparam_shortcuts::get(LOGNAME, nh, "gain_scale_near_target", tracking_config_.gain_scale_near_target);
+  if (tracking_config_.gain_scheduling_distance < 0 || tracking_config_.gain_scheduling_angle < 0 ||
+      tracking_config_.gain_scale_near_target <= 0)
+  {
+    ++error;
+    ROS_ERROR_STREAM_NAMED(LOGNAME, "Parameters 'gain_scheduling_distance' and 'gain_scheduling_angle' must be >= 0 "
+                                    "and 'gain_scale_near_target' must be > 0");
+  }
+
   rosparam_shortcuts::shutdownIfError(ros::this_node::getName(), error);
 }
 
@@ -259,6 +281,61 @@ void PoseTracking::targetPoseCallback(const geometry_msgs::PoseStampedConstPtr&
       return;
     }
   }
+
+  if (tracking_config_.feedforward_window < 2)
+    return;
+
+  // A target pose that is not newer than the last one restarts the fit
+  if (!target_history_.empty() && target_pose_.header.stamp <= target_history_.back().stamp)
+    target_history_.clear();
+  const geometry_msgs::Pose& pose = target_pose_.pose;
+  const Eigen::Quaterniond orientation(pose.orientation.w, pose.orientation.x, pose.orientation.y, pose.orientation.z);
+  target_history_.push_back({ target_pose_.header.stamp,
+                              Eigen::Vector3d(pose.position.x, pose.position.y, pose.position.z),
+                              orientation.normalized() });
+  updateTargetVelocity();
+}
+
+void PoseTracking::updateTargetVelocity()
+{
+  target_linear_velocity_.setZero();
+  target_angular_velocity_.setZero();
+  const std::size_t num_samples = target_history_.size();
+  if (num_samples < 2)
+    return;
+
+  // Fit a constant velocity to each coordinate. Orientations are expressed as rotation vectors relative to the oldest
+  // sample, which holds as long as the target turns by less than pi within the window.
+  const TargetSample& oldest = target_history_.front();
+  double sum_t = 0, sum_tt = 0;
+  Eigen::Vector3d sum_p = Eigen::Vector3d::Zero(), sum_tp = Eigen::Vector3d::Zero();
+  Eigen::Vector3d sum_r = Eigen::Vector3d::Zero(), sum_tr = Eigen::Vector3d::Zero();
+  for (const TargetSample& sample : target_history_)
+  {
+    const double t = (sample.stamp - oldest.stamp).toSec();
+    const Eigen::AngleAxisd rotation(sample.orientation * oldest.orientation.inverse());
+    const Eigen::Vector3d r = rotation.angle() * rotation.axis();
+    sum_t += t;
+    sum_tt += t * t;
+    sum_p += sample.position;
+    sum_tp += t * sample.position;
+    sum_r += r;
+    sum_tr += t * r;
+  }
+  const double t_variance = sum_tt - sum_t * sum_t / num_samples;
+  if (t_variance <= 0)
+    return;
+  target_linear_velocity_ = (sum_tp - sum_t * sum_p / num_samples) / t_variance;
+  target_angular_velocity_ = (sum_tr - sum_t * sum_r / num_samples) / t_variance;
+  target_sample_period_ = (target_history_.back().stamp - oldest.stamp).toSec() / (num_samples - 1);
+}
+
+double PoseTracking::gainScale(const double error, const double scheduling_error) const
+{
+  if (scheduling_error <= 0)
+    return 1;
+  const double blend = std::min(error / scheduling_error, 1.0);
+  return tracking_config_.gain_scale_near_target + blend * (1 - tracking_config_.gain_scale_near_target);
 }
 
 geometry_msgs::TwistStampedConstPtr PoseTracking::calculateTwistCommand()
@@ -268,29 +345,53 @@ geometry_msgs::TwistStampedConstPtr PoseTracking::calculateTwistCommand()
 
   // Get twist components from PID controllers
   geometry_msgs::Twist& twist = msg->twist;
+  Eigen::Vector3d target_position;
   Eigen::Quaterniond q_desired;
+  Eigen::Vector3d linear_feedforward = Eigen::Vector3d::Zero();
+  Eigen::Vector3d angular_feedforward = Eigen::Vector3d::Zero();
 
   // Scope mutex locking only to operations which require access to target pose.
   {
     std::lock_guard<std::mutex> lock(target_pose_mtx_);
     msg->header.frame_id = target_pose_.header.frame_id;
 
-    // Position
-    twist.linear.x = cartesian_position_pids_[0].computeCommand(
-        target_pose_.pose.position.x - command_frame_transform_.translation()(0), loop_rate_.expectedCycleTime());
-    twist.linear.y = cartesian_position_pids_[1].computeCommand(
-        target_pose_.pose.position.y - command_frame_transform_.translation()(1), loop_rate_.expectedCycleTime());
-    twist.linear.z = cartesian_position_pids_[2].computeCommand(
-        target_pose_.pose.position.z - command_frame_transform_.translation()(2), loop_rate_.expectedCycleTime());
-
-    // Orientation algorithm:
-    // - Find the orientation error as a quaternion: q_error = q_desired * q_current ^ -1
-    // - Use the angle-axis PID controller to calculate an angular rate
-    // - Convert to angular velocity for the TwistStamped message
+    target_position = Eigen::Vector3d(target_pose_.pose.position.x, target_pose_.pose.position.y,
+                                      target_pose_.pose.position.z);
     q_desired = Eigen::Quaterniond(target_pose_.pose.orientation.w, target_pose_.pose.orientation.x,
                                    target_pose_.pose.orientation.y, target_pose_.pose.orientation.z);
+
+    // Feed-forward: extrapolate the target to the present and command its velocity, so the PID controllers only
+    // correct the remaining error. Once the target stops publishing it is assumed to hold still.
+    if (tracking_config_.feedforward_window >= 2 && !target_history_.empty())
+    {
+      const double age = (ros::Time::now() - target_history_.back().stamp).toSec();
+      if (age >= 0 && age < 2 * target_sample_period_)
+      {
+        linear_feedforward = target_linear_velocity_;
+        angular_feedforward = target_angular_velocity_;
+        target_position += age * linear_feedforward;
+        const double angular_speed = angular_feedforward.norm();
+        if (angular_speed > 0)
+          q_desired = Eigen::AngleAxisd(age * angular_speed, angular_feedforward / angular_speed) * q_desired;
+      }
+    }
   }
 
+  // Position
+  const Eigen::Vector3d position_error = target_position - command_frame_transform_.translation();
+  const double linear_gain_scale = gainScale(position_error.norm(), tracking_config_.gain_scheduling_distance);
+  twist.linear.x = linear_feedforward(0) + linear_gain_scale * cartesian_position_pids_[0].computeCommand(
+                                                                   position_error(0), loop_rate_.expectedCycleTime());
+  twist.linear.y = linear_feedforward(1) + linear_gain_scale * cartesian_position_pids_[1].computeCommand(
+                                                                   position_error(1), loop_rate_.expectedCycleTime());
+  twist.linear.z = linear_feedforward(2) + linear_gain_scale * cartesian_position_pids_[2].computeCommand(
+                                                                   position_error(2), loop_rate_.expectedCycleTime());
+
+  // Orientation algorithm:
+  // - Find the orientation error as a quaternion: q_error = q_desired * q_current ^ -1
+  // - Use the angle-axis PID controller to calculate an angular rate
+  // - Convert to angular velocity for the TwistStamped message
+
   Eigen::Quaterniond q_current(command_frame_transform_.rotation());
   Eigen::Quaterniond q_error = q_desired * q_current.inverse();
 
@@ -299,10 +400,11 @@ geometry_msgs::TwistStampedConstPtr PoseTracking::calculateTwistCommand()
   // Cache the angular error, for rotation tolerance checking
   angular_error_ = axis_angle.angle();
   double ang_vel_magnitude =
+      gainScale(*angular_error_, tracking_config_.gain_scheduling_angle) *
       cartesian_orientation_pids_[0].computeCommand(*angular_error_, loop_rate_.expectedCycleTime());
-  twist.angular.x = ang_vel_magnitude * axis_angle.axis()[0];
-  twist.angular.y = ang_vel_magnitude * axis_angle.axis()[1];
-  twist.angular.z = ang_vel_magnitude * axis_angle.axis()[2];
+  twist.angular.x = angular_feedforward(0) + ang_vel_magnitude * axis_angle.axis()[0];
+  twist.angular.y = angular_feedforward(1) + ang_vel_magnitude * axis_angle.axis()[1];
+  twist.angular.z = angular_feedforward(2) + ang_vel_magnitude * axis_angle.axis()[2];
 
   msg->header.stamp = ros::Time::now();
 
@@ -383,6 +485,8 @@ void PoseTracking::resetTargetPose()
   std::lock_guard<std::mutex> lock(target_pose_mtx_);
   target_pose_ = geometry_msgs::PoseStamped();
   target_pose_.header.stamp = ros::Time(0);
+  target_history_.clear();
+  updateTargetVelocity();
 }
 
 bool PoseTracking::getCommandFrameTransform(geometry_msgs::TransformStamped& transform)
@@ -51,7 +51,8 @@ namespace
 constexpr double ROBOT_STATE_WAIT_TIME = 10.0;  // seconds
 }  // namespace
 
-Servo::Servo(ros::NodeHandle& nh, const planning_scene_monitor::PlanningSceneMonitorPtr& planning_scene_monitor)
+Servo::Servo(ros::NodeHandle& nh, const planning_scene_monitor::PlanningSceneMonitorPtr& planning_scene_monitor,
+             bool own_collision_check)
   : nh_(nh), planning_scene_monitor_(planning_scene_monitor)
 {
   // Read ROS parameters, typically from YAML file
@@ -78,7 +79,8 @@ Servo::Servo(ros::NodeHandle& nh, const planning_scene_monitor::PlanningSceneMon
 
   servo_calcs_ = std::make_unique<ServoCalcs>(nh_, parameters_, planning_scene_monitor_);
 
-  collision_checker_ = std::make_unique<CollisionCheck>(nh_, parameters_, planning_scene_monitor_);
+  if (own_collision_check)
+    collision_checker_ = std::make_unique<CollisionCheck>(nh_, parameters_, planning_scene_monitor_);
 }
 
 // Read ROS parameters, typically from YAML file
@@ -159,6 +161,10 @@ bool Servo::readParameters()
                                     parameters_.collision_distance_safety_factor);
   error += !rosparam_shortcuts::get(LOGNAME, nh, "min_allowable_collision_distance",
                                     parameters_.min_allowable_collision_distance);
+  parameters_.collision_prediction_steps = 5;
+  if (nh.hasParam("collision_prediction_steps"))
+    error += !rosparam_shortcuts::get(LOGNAME, nh, "collision_prediction_steps",
+                                      parameters_.collision_prediction_steps);
 
   // This parameter name was changed recently.
   // Try retrieving from the correct name. If it fails, then try the deprecated name.
@@ -181,6 +187,10 @@ bool Servo::readParameters()
     parameters_.low_latency_mode = false;
   }
 
+  parameters_.realtime_priority = 0;
+  if (nh.hasParam("realtime_priority"))
+    error += !rosparam_shortcuts::get(LOGNAME, nh, "realtime_priority", parameters_.realtime_priority);
+
   rosparam_shortcuts::shutdownIfError(LOGNAME, error);
 
   // Input checking
@@ -222,6 +232,12 @@ bool Servo::readParameters()
                             "greater than or equal to zero. Check yaml file.");
     return false;
   }
+  if (parameters_.realtime_priority > 0 && parameters_.low_latency_mode)
+  {
+    ROS_WARN_NAMED(LOGNAME, "Parameter 'low_latency_mode' cannot be combined with a 'realtime_priority', which runs "
+                            "the servo loop at a fixed rate. Check yaml file.");
+    return false;
+  }
   if (parameters_.command_in_type != "unitless" && parameters_.command_in_type != "speed_units")
   {
     ROS_WARN_NAMED(LOGNAME, "command_in_type should be 'unitless' or "
@@ -253,9 +269,16 @@ bool Servo::readParameters()
     return false;
   }
   // Collision checking
-  if (parameters_.collision_check_type != "threshold_distance" && parameters_.collision_check_type != "stop_distance")
+  if (parameters_.collision_check_type != "threshold_distance" && parameters_.collision_check_type != "stop_distance" &&
+      parameters_.collision_check_type != "predictive")
   {
-    ROS_WARN_NAMED(LOGNAME, "collision_check_type must be 'threshold_distance' or 'stop_distance'");
+    ROS_WARN_NAMED(LOGNAME, "collision_check_type must be 'threshold_distance', 'stop_distance' or 'predictive'");
+    return false;
+  }
+  if (parameters_.collision_check_type == "predictive" && parameters_.collision_prediction_steps < 1)
+  {
+    ROS_WARN_NAMED(LOGNAME, "Parameter 'collision_prediction_steps' should be "
+                            "greater than zero. Check yaml file.");
     return false;
   }
   if (parameters_.self_collision_proximity_threshold < 0.)
@@ -305,7 +328,7 @@ void Servo::start()
   servo_calcs_->start();
 
   // Check collisions in this timer
-  if (parameters_.check_collisions)
+  if (parameters_.check_collisions && collision_checker_)
     collision_checker_->start();
 }
 
@@ -317,7 +340,8 @@ Servo::~Servo()
 void Servo::setPaused(bool paused)
 {
   servo_calcs_->setPaused(paused);
-  collision_checker_->setPaused(paused);
+  if (collision_checker_)
+    collision_checker_->setPaused(paused);
 }
 
 bool Servo::getCommandFrameTransform(Eigen::Isometry3d& transform)
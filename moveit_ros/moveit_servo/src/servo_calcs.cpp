@@ -37,16 +37,20 @@
  *      Author    : Brian O'Neil, Andy Zelenak, Blake Anderson
  */
 
+#include <algorithm>
 #include <cassert>
+#include <cstring>
+#include <pthread.h>
 
 #include <std_msgs/Bool.h>
-#include <std_msgs/Float64MultiArray.h>
 
 #include <moveit_servo/make_shared_from_pool.h>
 #include <moveit_servo/servo_calcs.h>
 
 static const std::string LOGNAME = "servo_calcs";
 constexpr size_t ROS_LOG_THROTTLE_PERIOD = 30;  // Seconds to throttle logs inside loops
+// Decompose the Jacobian from scratch this often, so round-off does not accumulate in the warm-started singular vectors
+constexpr unsigned int SVD_WARM_STARTS_PER_COLD_START = 1000;
 
 namespace moveit_servo
 {
@@ -81,6 +85,26 @@ geometry_msgs::TransformStamped convertIsometryToTransform(const Eigen::Isometry
 
   return output;
 }
+
+// Publish a copy of msg. A real-time publisher sends its preallocated copy from its own thread; if it is still busy
+// with the previous message, this one is dropped rather than waited for.
+template <typename T>
+void publishMessage(const T& msg, ros::Publisher& publisher,
+                    const std::unique_ptr<realtime_tools::RealtimePublisher<T>>& realtime_publisher)
+{
+  if (realtime_publisher)
+  {
+    if (realtime_publisher->trylock())
+    {
+      realtime_publisher->msg_ = msg;
+      realtime_publisher->unlockAndPublish();
+    }
+    return;
+  }
+  auto pool_msg = moveit::util::make_shared_from_pool<T>();
+  *pool_msg = msg;
+  publisher.publish(pool_msg);
+}
 }  // namespace
 
 // Constructor for the class that handles servoing calculations
@@ -118,17 +142,35 @@ ServoCalcs::ServoCalcs(ros::NodeHandle& nh, ServoParameters& parameters,
   ros::NodeHandle internal_nh(nh_, "internal");
   collision_velocity_scale_sub_ =
       internal_nh.subscribe("collision_velocity_scale", ROS_QUEUE_SIZE, &ServoCalcs::collisionVelocityScaleCB, this);
-  worst_case_stop_time_pub_ = internal_nh.advertise<std_msgs::Float64>("worst_case_stop_time", ROS_QUEUE_SIZE);
+  if (parameters_.realtime_priority > 0)
+  {
+    // The real-time loop hands its messages over to publisher threads instead of serializing them itself
+    realtime_worst_case_stop_time_pub_ = std::make_unique<realtime_tools::RealtimePublisher<std_msgs::Float64>>(
+        internal_nh, "worst_case_stop_time", ROS_QUEUE_SIZE);
+    if (parameters_.command_out_type == "trajectory_msgs/JointTrajectory")
+      realtime_trajectory_pub_ = std::make_unique<realtime_tools::RealtimePublisher<trajectory_msgs::JointTrajectory>>(
+          nh_, parameters_.command_out_topic, ROS_QUEUE_SIZE);
+    else if (parameters_.command_out_type == "std_msgs/Float64MultiArray")
+      realtime_array_pub_ = std::make_unique<realtime_tools::RealtimePublisher<std_msgs::Float64MultiArray>>(
+          nh_, parameters_.command_out_topic, ROS_QUEUE_SIZE);
+    realtime_status_pub_ = std::make_unique<realtime_tools::RealtimePublisher<std_msgs::Int8>>(
+        nh_, parameters_.status_topic, ROS_QUEUE_SIZE);
+  }
+  else
+  {
+    worst_case_stop_time_pub_ = internal_nh.advertise<std_msgs::Float64>("worst_case_stop_time", ROS_QUEUE_SIZE);
 
-  // Publish freshly-calculated joints to the robot.
-  // Put the outgoing msg in the right format (trajectory_msgs/JointTrajectory or std_msgs/Float64MultiArray).
-  if (parameters_.command_out_type == "trajectory_msgs/JointTrajectory")
-    outgoing_cmd_pub_ = nh_.advertise<trajectory_msgs::JointTrajectory>(parameters_.command_out_topic, ROS_QUEUE_SIZE);
-  else if (parameters_.command_out_type == "std_msgs/Float64MultiArray")
-    outgoing_cmd_pub_ = nh_.advertise<std_msgs::Float64MultiArray>(parameters_.command_out_topic, ROS_QUEUE_SIZE);
+    // Publish freshly-calculated joints to the robot.
+    // Put the outgoing msg in the right format (trajectory_msgs/JointTrajectory or std_msgs/Float64MultiArray).
+    if (parameters_.command_out_type == "trajectory_msgs/JointTrajectory")
+      outgoing_cmd_pub_ =
+          nh_.advertise<trajectory_msgs::JointTrajectory>(parameters_.command_out_topic, ROS_QUEUE_SIZE);
+    else if (parameters_.command_out_type == "std_msgs/Float64MultiArray")
+      outgoing_cmd_pub_ = nh_.advertise<std_msgs::Float64MultiArray>(parameters_.command_out_topic, ROS_QUEUE_SIZE);
 
-  // Publish status
-  status_pub_ = nh_.advertise<std_msgs::Int8>(parameters_.status_topic, ROS_QUEUE_SIZE);
+    // Publish status
+    status_pub_ = nh_.advertise<std_msgs::Int8>(parameters_.status_topic, ROS_QUEUE_SIZE);
+  }
 
   internal_joint_state_.name = joint_model_group_->getActiveJointModelNames();
   num_joints_ = internal_joint_state_.name.size();
@@ -147,6 +189,28 @@ ServoCalcs::ServoCalcs(ros::NodeHandle& nh, ServoParameters& parameters,
     position_filters_.emplace_back(parameters_.low_pass_filter_coeff);
   }
 
+  // Size the calculation workspaces for the group
+  delta_theta_ = Eigen::ArrayXd::Zero(num_joints_);
+  jacobian_.resize(6, num_joints_);
+  controlled_jacobian_.resize(6, num_joints_);
+  controlled_delta_x_.resize(6);
+  const Eigen::Index num_singular_values = std::min<Eigen::Index>(6, num_joints_);
+  svd_ = Eigen::JacobiSVD<Eigen::MatrixXd>(6, num_joints_, Eigen::ComputeThinU | Eigen::ComputeThinV);
+  svd_u_.resize(6, num_singular_values);
+  svd_v_.resize(num_joints_, num_singular_values);
+  rotated_jacobian_.resize(6, num_joints_);
+  rotated_jacobian_workspace_.resize(6, num_joints_);
+  svd_u_workspace_.resize(6, num_singular_values);
+  svd_v_workspace_.resize(num_joints_, num_singular_values);
+  svd_warm_starts_ = SVD_WARM_STARTS_PER_COLD_START;  // the first decomposition has nothing to start from
+  scaled_v_.resize(num_joints_, num_singular_values);
+  pseudo_inverse_.resize(num_joints_, 6);
+  singular_vector_.resize(6);
+  lookahead_theta_.resize(num_joints_);
+  lookahead_jacobian_.resize(6, num_joints_);
+  lookahead_jacobian_v_.resize(6, num_singular_values);
+  lookahead_singular_values_.resize(num_singular_values);
+
   // A matrix of all zeros is used to check whether matrices have been initialized
   Eigen::Matrix3d empty_matrix;
   empty_matrix.setZero();
@@ -165,13 +229,13 @@ void ServoCalcs::start()
   stop();
 
   // We will update last_sent_command_ every time we start servo
-  auto initial_joint_trajectory = moveit::util::make_shared_from_pool<trajectory_msgs::JointTrajectory>();
+  trajectory_msgs::JointTrajectory initial_joint_trajectory;
 
   // When a joint_trajectory_controller receives a new command, a stamp of 0 indicates "begin immediately"
   // See http://wiki.ros.org/joint_trajectory_controller#Trajectory_replacement
-  initial_joint_trajectory->header.stamp = ros::Time(0);
-  initial_joint_trajectory->header.frame_id = parameters_.planning_frame;
-  initial_joint_trajectory->joint_names = internal_joint_state_.name;
+  initial_joint_trajectory.header.stamp = ros::Time(0);
+  initial_joint_trajectory.header.frame_id = parameters_.planning_frame;
+  initial_joint_trajectory.joint_names = internal_joint_state_.name;
   trajectory_msgs::JointTrajectoryPoint point;
   point.time_from_start = ros::Duration(parameters_.publish_period);
 
@@ -190,9 +254,25 @@ void ServoCalcs::start()
     // Send all zeros, for now.
     point.accelerations.resize(num_joints_);
   }
-  initial_joint_trajectory->points.push_back(point);
+  initial_joint_trajectory.points.push_back(point);
   last_sent_command_ = initial_joint_trajectory;
 
+  // Allocate the outgoing messages up front, so composing them later only reuses their memory
+  outgoing_trajectory_ = initial_joint_trajectory;
+  outgoing_array_.data.resize(num_joints_);
+  if (realtime_trajectory_pub_)
+  {
+    realtime_trajectory_pub_->lock();
+    realtime_trajectory_pub_->msg_ = initial_joint_trajectory;
+    realtime_trajectory_pub_->unlock();
+  }
+  if (realtime_array_pub_)
+  {
+    realtime_array_pub_->lock();
+    realtime_array_pub_->msg_ = outgoing_array_;
+    realtime_array_pub_->unlock();
+  }
+
   current_state_ = planning_scene_monitor_->getStateMonitor()->getCurrentState();
   tf_moveit_to_ee_frame_ = current_state_->getGlobalLinkTransform(parameters_.planning_frame).inverse() *
                            current_state_->getGlobalLinkTransform(parameters_.ee_frame_name);
@@ -202,6 +282,17 @@ void ServoCalcs::start()
   stop_requested_ = false;
   thread_ = std::thread([this] { mainCalcLoop(); });
   new_input_cmd_ = false;
+
+  if (parameters_.realtime_priority > 0)
+  {
+    sched_param scheduling;
+    scheduling.sched_priority = parameters_.realtime_priority;
+    const int error = pthread_setschedparam(thread_.native_handle(), SCHED_FIFO, &scheduling);
+    if (error)
+      ROS_WARN_STREAM_NAMED(LOGNAME, "Cannot run the servo loop with real-time priority "
+                                         << parameters_.realtime_priority << ": " << std::strerror(error)
+                                         << ". Check the rtprio limit of this user.");
+  }
 }
 
 void ServoCalcs::stop()
@@ -231,8 +322,16 @@ void ServoCalcs::mainCalcLoop()
 
   while (ros::ok() && !stop_requested_)
   {
-    // lock the input state mutex
-    std::unique_lock<std::mutex> input_lock(input_mutex_);
+    // lock the input state mutex. The command callbacks only hold it briefly, so in real-time mode an iteration is
+    // skipped rather than having the loop wait for them.
+    std::unique_lock<std::mutex> input_lock(input_mutex_, std::defer_lock);
+    if (parameters_.realtime_priority <= 0)
+      input_lock.lock();
+    else if (!input_lock.try_lock())
+    {
+      rate.sleep();
+      continue;
+    }
 
     // low latency mode -- begin calculations as soon as a new command is received.
     if (parameters_.low_latency_mode)
@@ -268,18 +367,16 @@ void ServoCalcs::mainCalcLoop()
 void ServoCalcs::calculateSingleIteration()
 {
   // Publish status each loop iteration
-  auto status_msg = moveit::util::make_shared_from_pool<std_msgs::Int8>();
-  status_msg->data = static_cast<int8_t>(status_);
-  status_pub_.publish(status_msg);
+  std_msgs::Int8 status_msg;
+  status_msg.data = static_cast<int8_t>(status_);
+  publishMessage(status_msg, status_pub_, realtime_status_pub_);
 
   // Always update the joints and end-effector transform for 2 reasons:
   // 1) in case the getCommandFrameTransform() method is being used
   // 2) so the low-pass filters are up to date and don't cause a jump
+  // This also updates current_state_ from the latest state
   updateJoints();
 
-  // Update from latest state
-  current_state_ = planning_scene_monitor_->getStateMonitor()->getCurrentState();
-
   if (latest_twist_stamped_)
     twist_stamped_cmd_ = *latest_twist_stamped_;
   if (latest_joint_cmd_)
@@ -327,14 +424,14 @@ void ServoCalcs::calculateSingleIteration()
 
   // If not waiting for initial command, and not paused.
   // Do servoing calculations only if the robot should move, for efficiency
-  // Create new outgoing joint trajectory command message
-  auto joint_trajectory = moveit::util::make_shared_from_pool<trajectory_msgs::JointTrajectory>();
+  // Compose the outgoing joint trajectory command message
+  trajectory_msgs::JointTrajectory& joint_trajectory = outgoing_trajectory_;
 
   // Prioritize cartesian servoing above joint servoing
   // Only run commands if not stale and nonzero
   if (have_nonzero_twist_stamped_ && !twist_command_is_stale_)
   {
-    if (!cartesianServoCalcs(twist_stamped_cmd_, *joint_trajectory))
+    if (!cartesianServoCalcs(twist_stamped_cmd_, joint_trajectory))
     {
       resetLowPassFilters(original_joint_state_);
       return;
@@ -342,7 +439,7 @@ void ServoCalcs::calculateSingleIteration()
   }
   else if (have_nonzero_joint_command_ && !joint_command_is_stale_)
   {
-    if (!jointServoCalcs(joint_servo_cmd_, *joint_trajectory))
+    if (!jointServoCalcs(joint_servo_cmd_, joint_trajectory))
     {
       resetLowPassFilters(original_joint_state_);
       return;
@@ -351,8 +448,8 @@ void ServoCalcs::calculateSingleIteration()
   else
   {
     // Joint trajectory is not populated with anything, so set it to the last positions and 0 velocity
-    *joint_trajectory = *last_sent_command_;
-    for (auto& point : joint_trajectory->points)
+    joint_trajectory = last_sent_command_;
+    for (auto& point : joint_trajectory.points)
     {
       point.velocities.assign(point.velocities.size(), 0);
     }
@@ -369,7 +466,7 @@ void ServoCalcs::calculateSingleIteration()
   // If we should halt
   if (!have_nonzero_command_)
   {
-    suddenHalt(*joint_trajectory);
+    suddenHalt(joint_trajectory);
     have_nonzero_twist_stamped_ = false;
     have_nonzero_joint_command_ = false;
   }
@@ -402,23 +499,29 @@ void ServoCalcs::calculateSingleIteration()
 
   if (ok_to_publish_ && !paused_)
   {
-    // Put the outgoing msg in the right format
+    // Hand the command to the sink if there is one, bypassing the topic.
+    // Otherwise, put the outgoing msg in the right format
     // (trajectory_msgs/JointTrajectory or std_msgs/Float64MultiArray).
-    if (parameters_.command_out_type == "trajectory_msgs/JointTrajectory")
+    if (command_sink_)
+    {
+      joint_trajectory.header.stamp = ros::Time(0);
+      command_sink_->write(joint_trajectory);
+    }
+    else if (parameters_.command_out_type == "trajectory_msgs/JointTrajectory")
     {
       // When a joint_trajectory_controller receives a new command, a stamp of 0 indicates "begin immediately"
       // See http://wiki.ros.org/joint_trajectory_controller#Trajectory_replacement
-      joint_trajectory->header.stamp = ros::Time(0);
-      outgoing_cmd_pub_.publish(joint_trajectory);
+      joint_trajectory.header.stamp = ros::Time(0);
+      publishMessage(joint_trajectory, outgoing_cmd_pub_, realtime_trajectory_pub_);
     }
     else if (parameters_.command_out_type == "std_msgs/Float64MultiArray")
     {
-      auto joints = moveit::util::make_shared_from_pool<std_msgs::Float64MultiArray>();
-      if (parameters_.publish_joint_positions && !joint_trajectory->points.empty())
-        joints->data = joint_trajectory->points[0].positions;
-      else if (parameters_.publish_joint_velocities && !joint_trajectory->points.empty())
-        joints->data = joint_trajectory->points[0].velocities;
-      outgoing_cmd_pub_.publish(joints);
+      outgoing_array_.data.clear();
+      if (parameters_.publish_joint_positions && !joint_trajectory.points.empty())
+        outgoing_array_.data = joint_trajectory.points[0].positions;
+      else if (parameters_.publish_joint_velocities && !joint_trajectory.points.empty())
+        outgoing_array_.data = joint_trajectory.points[0].velocities;
+      publishMessage(outgoing_array_, outgoing_cmd_pub_, realtime_array_pub_);
     }
 
     last_sent_command_ = joint_trajectory;
@@ -507,34 +610,29 @@ bool ServoCalcs::cartesianServoCalcs(geometry_msgs::TwistStamped& cmd,
     cmd.twist.angular.z = angular_vector(2);
   }
 
-  Eigen::VectorXd delta_x = scaleCartesianCommand(cmd);
+  delta_x_ = scaleCartesianCommand(cmd);
 
   // Convert from cartesian commands to joint commands
-  Eigen::MatrixXd jacobian = current_state_->getJacobian(joint_model_group_);
+  if (!current_state_->getJacobian(joint_model_group_, joint_model_group_->getLinkModels().back(),
+                                   Eigen::Vector3d::Zero(), jacobian_))
+    return false;
 
   // May allow some dimensions to drift, based on drift_dimensions
   // i.e. take advantage of task redundancy.
-  // Remove the Jacobian rows corresponding to True in the vector drift_dimensions
-  // Work backwards through the 6-vector so indices don't get out of order
-  for (auto dimension = jacobian.rows() - 1; dimension >= 0; --dimension)
-  {
-    if (drift_dimensions_[dimension] && jacobian.rows() > 1)
-    {
-      removeDimension(jacobian, delta_x, dimension);
-    }
-  }
+  selectControlledDimensions();
 
-  Eigen::JacobiSVD<Eigen::MatrixXd> svd =
-      Eigen::JacobiSVD<Eigen::MatrixXd>(jacobian, Eigen::ComputeThinU | Eigen::ComputeThinV);
-  Eigen::MatrixXd matrix_s = svd.singularValues().asDiagonal();
-  Eigen::MatrixXd pseudo_inverse = svd.matrixV() * matrix_s.inverse() * svd.matrixU().transpose();
+  // The workspaces are preallocated, so the products are evaluated into them without temporaries
+  decomposeControlledJacobian();
+  scaled_v_.noalias() = svd_v_ * svd_.singularValues().cwiseInverse().asDiagonal();
+  pseudo_inverse_.noalias() = scaled_v_ * svd_u_.transpose();
 
-  delta_theta_ = pseudo_inverse * delta_x;
+  delta_theta_.matrix().noalias() = pseudo_inverse_ * controlled_delta_x_;
 
   enforceVelLimits(delta_theta_);
 
   // If close to a collision or a singularity, decelerate
-  applyVelocityScaling(delta_theta_, velocityScalingFactorForSingularity(delta_x, svd, pseudo_inverse));
+  applyVelocityScaling(delta_theta_, velocityScalingFactorForSingularity(
+                                         controlled_delta_x_, svd_u_, svd_.singularValues(), svd_v_, pseudo_inverse_));
 
   prev_joint_velocity_ = delta_theta_ / parameters_.publish_period;
 
@@ -555,7 +653,7 @@ bool ServoCalcs::jointServoCalcs(const control_msgs::JointJog& cmd, trajectory_m
   }
 
   // Apply user-defined scaling
-  delta_theta_ = scaleJointCommand(cmd);
+  scaleJointCommand(cmd, delta_theta_);
 
   enforceVelLimits(delta_theta_);
 
@@ -600,13 +698,12 @@ bool ServoCalcs::convertDeltasToOutgoingCmd(trajectory_msgs::JointTrajectory& jo
 void ServoCalcs::insertRedundantPointsIntoTrajectory(trajectory_msgs::JointTrajectory& joint_trajectory, int count) const
 {
   joint_trajectory.points.resize(count);
-  auto point = joint_trajectory.points[0];
   // Start from 2nd point (i = 1) because we already have the first point.
   // The timestamps are shifted up one period since first point is at 1 * publish_period, not 0.
   for (int i = 1; i < count; ++i)
   {
-    point.time_from_start = ros::Duration((i + 1) * parameters_.publish_period);
-    joint_trajectory.points[i] = point;
+    joint_trajectory.points[i] = joint_trajectory.points[0];
+    joint_trajectory.points[i].time_from_start = ros::Duration((i + 1) * parameters_.publish_period);
   }
 }
 
@@ -647,21 +744,27 @@ void ServoCalcs::composeJointTrajMessage(const sensor_msgs::JointState& joint_st
   joint_trajectory.header.frame_id = parameters_.planning_frame;
   joint_trajectory.joint_names = joint_state.name;
 
-  trajectory_msgs::JointTrajectoryPoint point;
+  // Overwrite the point of the previous command, so its memory is reused
+  joint_trajectory.points.resize(1);
+  trajectory_msgs::JointTrajectoryPoint& point = joint_trajectory.points.front();
   point.time_from_start = ros::Duration(parameters_.publish_period);
   if (parameters_.publish_joint_positions)
     point.positions = joint_state.position;
+  else
+    point.positions.clear();
   if (parameters_.publish_joint_velocities)
     point.velocities = joint_state.velocity;
+  else
+    point.velocities.clear();
   if (parameters_.publish_joint_accelerations)
   {
     // I do not know of a robot that takes acceleration commands.
     // However, some controllers check that this data is non-empty.
     // Send all zeros, for now.
-    std::vector<double> acceleration(num_joints_);
-    point.accelerations = acceleration;
+    point.accelerations.assign(num_joints_, 0.0);
   }
-  joint_trajectory.points.push_back(point);
+  else
+    point.accelerations.clear();
 }
 
 // Apply velocity scaling for proximity of collisions and singularities.
@@ -690,7 +793,9 @@ void ServoCalcs::applyVelocityScaling(Eigen::ArrayXd& delta_theta, double singul
 
 // Possibly calculate a velocity scaling factor, due to proximity of singularity and direction of motion
 double ServoCalcs::velocityScalingFactorForSingularity(const Eigen::VectorXd& commanded_velocity,
-                                                       const Eigen::JacobiSVD<Eigen::MatrixXd>& svd,
+                                                       const Eigen::MatrixXd& matrix_u,
+                                                       const Eigen::VectorXd& singular_values,
+                                                       const Eigen::MatrixXd& matrix_v,
                                                        const Eigen::MatrixXd& pseudo_inverse)
 {
   double velocity_scale = 1;
@@ -700,27 +805,35 @@ double ServoCalcs::velocityScalingFactorForSingularity(const Eigen::VectorXd& co
   // The last column of U from the SVD of the Jacobian points directly toward or away from the singularity.
   // The sign can flip at any time, so we have to do some extra checking.
   // Look ahead to see if the Jacobian's condition will decrease.
-  Eigen::VectorXd vector_toward_singularity = svd.matrixU().col(num_dimensions - 1);
+  Eigen::VectorXd& vector_toward_singularity = singular_vector_;
+  vector_toward_singularity = matrix_u.col(num_dimensions - 1);
 
-  double ini_condition = svd.singularValues()(0) / svd.singularValues()(svd.singularValues().size() - 1);
+  double ini_condition = singular_values(0) / singular_values(singular_values.size() - 1);
 
   // This singular vector tends to flip direction unpredictably. See R. Bro,
   // "Resolving the Sign Ambiguity in the Singular Value Decomposition".
   // Look ahead to see if the Jacobian's condition will decrease in this
   // direction. Start with a scaled version of the singular vector
-  Eigen::VectorXd delta_x(num_dimensions);
   double scale = 100;
-  delta_x = vector_toward_singularity / scale;
 
   // Calculate a small change in joints
-  Eigen::VectorXd new_theta;
-  current_state_->copyJointGroupPositions(joint_model_group_, new_theta);
-  new_theta += pseudo_inverse * delta_x;
-  current_state_->setJointGroupPositions(joint_model_group_, new_theta);
-  Eigen::MatrixXd new_jacobian = current_state_->getJacobian(joint_model_group_);
-
-  Eigen::JacobiSVD<Eigen::MatrixXd> new_svd(new_jacobian);
-  double new_condition = new_svd.singularValues()(0) / new_svd.singularValues()(new_svd.singularValues().size() - 1);
+  current_state_->copyJointGroupPositions(joint_model_group_, lookahead_theta_);
+  lookahead_theta_.noalias() += pseudo_inverse * vector_toward_singularity * (1.0 / scale);
+  current_state_->setJointGroupPositions(joint_model_group_, lookahead_theta_);
+  current_state_->getJacobian(joint_model_group_, joint_model_group_->getLinkModels().back(), Eigen::Vector3d::Zero(),
+                              lookahead_jacobian_);
+
+  // Rather than decomposing the look-ahead Jacobian J' of the controlled dimensions, estimate its singular values to
+  // first order from the current decomposition: sigma_i' = u_i^T * J' * v_i
+  lookahead_jacobian_v_.noalias() = lookahead_jacobian_ * matrix_v;
+  lookahead_singular_values_.setZero();
+  for (Eigen::Index i = 0; i < lookahead_singular_values_.size(); ++i)
+  {
+    for (Eigen::Index row = 0; row < matrix_u.rows(); ++row)
+      lookahead_singular_values_(i) += matrix_u(row, i) * lookahead_jacobian_v_(controlled_dimensions_[row], i);
+  }
+  double new_condition =
+      lookahead_singular_values_.cwiseAbs().maxCoeff() / lookahead_singular_values_.cwiseAbs().minCoeff();
   // If new_condition < ini_condition, the singular vector does point towards a
   // singularity. Otherwise, flip its direction.
   if (ini_condition >= new_condition)
@@ -757,17 +870,15 @@ double ServoCalcs::velocityScalingFactorForSingularity(const Eigen::VectorXd& co
 
 void ServoCalcs::enforceVelLimits(Eigen::ArrayXd& delta_theta)
 {
-  // Convert to joint angle velocities for checking and applying joint specific velocity limits.
-  Eigen::ArrayXd velocity = delta_theta / parameters_.publish_period;
-
   std::size_t joint_delta_index{ 0 };
   double velocity_scaling_factor{ 1.0 };
   for (const moveit::core::JointModel* joint : joint_model_group_->getActiveJointModels())
   {
+    // Convert to joint angle velocities for checking and applying joint specific velocity limits.
+    const double unbounded_velocity = delta_theta(joint_delta_index) / parameters_.publish_period;
     const auto& bounds = joint->getVariableBounds(joint->getName());
-    if (bounds.velocity_bounded_ && velocity(joint_delta_index) != 0.0)
+    if (bounds.velocity_bounded_ && unbounded_velocity != 0.0)
     {
-      const double unbounded_velocity = velocity(joint_delta_index);
       // Clamp each joint velocity to a joint specific [min_velocity, max_velocity] range.
       const auto bounded_velocity = std::min(std::max(unbounded_velocity, bounds.min_velocity_), bounds.max_velocity_);
       velocity_scaling_factor = std::min(velocity_scaling_factor, bounded_velocity / unbounded_velocity);
@@ -775,8 +886,8 @@ void ServoCalcs::enforceVelLimits(Eigen::ArrayXd& delta_theta)
     ++joint_delta_index;
   }
 
-  // Convert back to joint angle increments.
-  delta_theta = velocity_scaling_factor * velocity * parameters_.publish_period;
+  // Scale the joint angle increments.
+  delta_theta *= velocity_scaling_factor;
 }
 
 bool ServoCalcs::enforcePositionLimits(sensor_msgs::JointState& joint_state)
@@ -827,10 +938,13 @@ bool ServoCalcs::enforcePositionLimits(sensor_msgs::JointState& joint_state)
 // Is handled differently for position vs. velocity control.
 void ServoCalcs::suddenHalt(trajectory_msgs::JointTrajectory& joint_trajectory)
 {
-  // Prepare the joint trajectory message to stop the robot
-  joint_trajectory.points.clear();
-  joint_trajectory.points.emplace_back();
+  // Prepare the joint trajectory message to stop the robot, reusing the memory of its first point
+  joint_trajectory.points.resize(1);
   trajectory_msgs::JointTrajectoryPoint& point = joint_trajectory.points.front();
+  point.positions.clear();
+  point.velocities.clear();
+  point.accelerations.clear();
+  point.effort.clear();
 
   // When sending out trajectory_msgs/JointTrajectory type messages, the "trajectory" is just a single point.
   // That point cannot have the same timestamp as the start of trajectory execution since that would mean the
@@ -862,8 +976,8 @@ void ServoCalcs::suddenHalt(trajectory_msgs::JointTrajectory& joint_trajectory)
 // Parse the incoming joint msg for the joints of our MoveGroup
 void ServoCalcs::updateJoints()
 {
-  // Get the latest joint group positions
-  current_state_ = planning_scene_monitor_->getStateMonitor()->getCurrentState();
+  // Get the latest joint group positions, copying them into current_state_ rather than allocating a new state
+  planning_scene_monitor_->getStateMonitor()->setToCurrentState(*current_state_);
   current_state_->copyJointGroupPositions(joint_model_group_, internal_joint_state_.position);
   current_state_->copyJointGroupVelocities(joint_model_group_, internal_joint_state_.velocity);
 
@@ -871,21 +985,19 @@ void ServoCalcs::updateJoints()
   original_joint_state_ = internal_joint_state_;
 
   // Calculate worst case joint stop time, for collision checking
-  std::string joint_name = "";
-  moveit::core::JointModel::Bounds kinematic_bounds;
   double accel_limit = 0;
   double joint_velocity = 0;
   double worst_case_stop_time = 0;
   for (size_t jt_state_idx = 0; jt_state_idx < internal_joint_state_.velocity.size(); ++jt_state_idx)
   {
-    joint_name = internal_joint_state_.name[jt_state_idx];
+    const std::string& joint_name = internal_joint_state_.name[jt_state_idx];
 
     // Get acceleration limit for this joint
     for (auto joint_model : joint_model_group_->getActiveJointModels())
     {
       if (joint_model->getName() == joint_name)
       {
-        kinematic_bounds = joint_model->getVariableBounds();
+        const moveit::core::JointModel::Bounds& kinematic_bounds = joint_model->getVariableBounds();
         // Some joints do not have acceleration limits
         if (kinematic_bounds[0].acceleration_bounded_)
         {
@@ -912,16 +1024,16 @@ void ServoCalcs::updateJoints()
 
   // publish message
   {
-    auto msg = moveit::util::make_shared_from_pool<std_msgs::Float64>();
-    msg->data = worst_case_stop_time;
-    worst_case_stop_time_pub_.publish(msg);
+    std_msgs::Float64 msg;
+    msg.data = worst_case_stop_time;
+    publishMessage(msg, worst_case_stop_time_pub_, realtime_worst_case_stop_time_pub_);
   }
 }
 
 // Scale the incoming servo command
-Eigen::VectorXd ServoCalcs::scaleCartesianCommand(const geometry_msgs::TwistStamped& command) const
+Eigen::Matrix<double, 6, 1> ServoCalcs::scaleCartesianCommand(const geometry_msgs::TwistStamped& command) const
 {
-  Eigen::VectorXd result(6);
+  Eigen::Matrix<double, 6, 1> result;
 
   // Apply user-defined scaling if inputs are unitless [-1:1]
   if (parameters_.command_in_type == "unitless")
@@ -944,15 +1056,17 @@ Eigen::VectorXd ServoCalcs::scaleCartesianCommand(const geometry_msgs::TwistStam
     result[5] = command.twist.angular.z * parameters_.publish_period;
   }
   else
+  {
+    result.setZero();
     ROS_ERROR_STREAM_THROTTLE_NAMED(ROS_LOG_THROTTLE_PERIOD, LOGNAME, "Unexpected command_in_type");
+  }
 
   return result;
 }
 
-Eigen::VectorXd ServoCalcs::scaleJointCommand(const control_msgs::JointJog& command) const
+void ServoCalcs::scaleJointCommand(const control_msgs::JointJog& command, Eigen::ArrayXd& result) const
 {
-  Eigen::VectorXd result(num_joints_);
-  result.setZero();
+  result.setZero(num_joints_);
 
   std::size_t c;
   for (std::size_t m = 0; m < command.joint_names.size(); ++m)
@@ -975,8 +1089,6 @@ Eigen::VectorXd ServoCalcs::scaleJointCommand(const control_msgs::JointJog& comm
     else
       ROS_ERROR_STREAM_THROTTLE_NAMED(ROS_LOG_THROTTLE_PERIOD, LOGNAME, "Unexpected command_in_type, check yaml file.");
   }
-
-  return result;
 }
 
 // Add the deltas to each joint
@@ -1000,20 +1112,77 @@ bool ServoCalcs::addJointIncrements(sensor_msgs::JointState& output, const Eigen
   return true;
 }
 
-void ServoCalcs::removeDimension(Eigen::MatrixXd& jacobian, Eigen::VectorXd& delta_x, unsigned int row_to_remove)
+void ServoCalcs::selectControlledDimensions()
+{
+  // Remove the Jacobian rows corresponding to True in the vector drift_dimensions, but keep at least the first one
+  const auto num_drifting = std::count(drift_dimensions_.begin(), drift_dimensions_.end(), true);
+  const bool drift_all = num_drifting == static_cast<long>(drift_dimensions_.size());
+  const Eigen::Index num_rows = drift_all ? 1 : drift_dimensions_.size() - num_drifting;
+
+  // Resizing only allocates memory when the number of drift dimensions changed
+  controlled_jacobian_.resize(num_rows, jacobian_.cols());
+  controlled_delta_x_.resize(num_rows);
+  Eigen::Index row = 0;
+  for (std::size_t dimension = 0; dimension < drift_dimensions_.size() && row < num_rows; ++dimension)
+  {
+    if (!drift_dimensions_[dimension] || drift_all)
+    {
+      controlled_jacobian_.row(row) = jacobian_.row(dimension);
+      controlled_delta_x_(row) = delta_x_(dimension);
+      controlled_dimensions_[row] = dimension;
+      ++row;
+    }
+  }
+}
+
+void ServoCalcs::decomposeControlledJacobian()
 {
-  unsigned int num_rows = jacobian.rows() - 1;
-  unsigned int num_cols = jacobian.cols();
+  const Eigen::Index rows = controlled_jacobian_.rows();
+  const Eigen::Index cols = controlled_jacobian_.cols();
+  const bool same_dimensions = svd_u_.rows() == rows && svd_v_.rows() == cols;
+  if (!same_dimensions || svd_warm_starts_ >= SVD_WARM_STARTS_PER_COLD_START)
+  {
+    svd_.compute(controlled_jacobian_, Eigen::ComputeThinU | Eigen::ComputeThinV);
+    svd_u_ = svd_.matrixU();
+    svd_v_ = svd_.matrixV();
+    svd_warm_starts_ = 0;
+    return;
+  }
 
-  if (row_to_remove < num_rows)
+  // The Jacobian changes little between iterations. Expressed in the previous singular vectors (those that form a
+  // square basis), its rows or columns are nearly orthogonal. Eigen's QR preconditioner then leaves an almost diagonal
+  // matrix, so the Jacobi sweeps converge after about one pass instead of several.
+  const bool rotate_rows = rows <= cols;
+  const bool rotate_cols = cols <= rows;
+  rotated_jacobian_ = controlled_jacobian_;
+  if (rotate_rows)
+  {
+    rotated_jacobian_workspace_.noalias() = svd_u_.transpose() * rotated_jacobian_;
+    rotated_jacobian_.swap(rotated_jacobian_workspace_);
+  }
+  if (rotate_cols)
   {
-    jacobian.block(row_to_remove, 0, num_rows - row_to_remove, num_cols) =
-        jacobian.block(row_to_remove + 1, 0, num_rows - row_to_remove, num_cols);
-    delta_x.segment(row_to_remove, num_rows - row_to_remove) =
-        delta_x.segment(row_to_remove + 1, num_rows - row_to_remove);
+    rotated_jacobian_workspace_.noalias() = rotated_jacobian_ * svd_v_;
+    rotated_jacobian_.swap(rotated_jacobian_workspace_);
   }
-  jacobian.conservativeResize(num_rows, num_cols);
-  delta_x.conservativeResize(num_rows);
+  svd_.compute(rotated_jacobian_, Eigen::ComputeThinU | Eigen::ComputeThinV);
+
+  // Rotate the singular vectors back: J = (U_prev * U) * S * (V_prev * V)^T
+  if (rotate_rows)
+  {
+    svd_u_workspace_.noalias() = svd_u_ * svd_.matrixU();
+    svd_u_.swap(svd_u_workspace_);
+  }
+  else
+    svd_u_ = svd_.matrixU();
+  if (rotate_cols)
+  {
+    svd_v_workspace_.noalias() = svd_v_ * svd_.matrixV();
+    svd_v_.swap(svd_v_workspace_);
+  }
+  else
+    svd_v_ = svd_.matrixV();
+  ++svd_warm_starts_;
 }
 
 bool ServoCalcs::getCommandFrameTransform(Eigen::Isometry3d& transform)
@@ -1138,4 +1307,10 @@ void ServoCalcs::changeRobotLinkCommandFrame(const std::string& new_command_fram
   parameters_.robot_link_command_frame = new_command_frame;
 }
 
+void ServoCalcs::setCommandSink(const CommandSinkPtr& sink)
+{
+  const std::lock_guard<std::mutex> lock(input_mutex_);
+  command_sink_ = sink;
+}
+
 }  // namespace moveit_servo
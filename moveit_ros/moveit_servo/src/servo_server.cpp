@@ -37,6 +37,7 @@
  *      Author    : Andy Zelenak
  */
 
+#include <moveit_servo/multi_group_servo.h>
 #include <moveit_servo/servo.h>
 
 namespace
@@ -70,6 +71,16 @@ int main(int argc, char** argv)
       false /* skip octomap monitor */);
   planning_scene_monitor->startStateMonitor();
 
+  // Several groups are servoed by one server if they are listed in servo_groups
+  if (nh.hasParam("servo_groups"))
+  {
+    moveit_servo::MultiGroupServo multi_group_servo(nh, planning_scene_monitor);
+    multi_group_servo.start();
+    ros::waitForShutdown();
+    multi_group_servo.setPaused(true);
+    return 0;
+  }
+
   // Create the servo server
   moveit_servo::Servo servo(nh, planning_scene_monitor);
 
@@ -0,0 +1,96 @@
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2026, PickNik LLC.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of PickNik LLC nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *********************************************************************/
+
+#pragma once
+
+#include <octomap/octomap.h>
+
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace occupancy_map_monitor
+{
+typedef std::unordered_map<octomap::OcTreeKey, unsigned int, octomap::OcTreeKey::KeyHash> OcTreeKeyCountMap;
+
+/**
+ * Casts rays from a sensor origin and collects the free cells they pass through, exploiting that neighboring rays
+ * pass through mostly the same cells: cells the previous ray already passed through at about the same distance are
+ * not hashed into the free cell set again. Rays ordered by sortRayEndsByDirection() are neighbors. The collected
+ * cells (and counts) are exactly those of casting every ray on its own.
+ *
+ * Casting into a different free cell set or from a different origin requires reset(), or flush() for counted rays.
+ */
+class CoherentRayCaster
+{
+public:
+  /** \brief Add the cells between \e origin and the cell \e end (exclusive) to \e free_cells.
+   *  @return false if the ray leaves the tree */
+  bool castRay(const octomap::OcTree& tree, const octomap::point3d& origin, const octomap::OcTreeKey& end,
+               octomap::KeySet& free_cells);
+
+  /** \brief Add \e weight to the counts of the cells between \e origin and the cell \e end (exclusive) in
+   *  \e free_cells. Counts of cells the next ray may share are added later, at the latest by flush().
+   *  @return false if the ray leaves the tree */
+  bool castRay(const octomap::OcTree& tree, const octomap::point3d& origin, const octomap::OcTreeKey& end,
+               unsigned int weight, OcTreeKeyCountMap& free_cells);
+
+  /** \brief Add the outstanding counts of counted rays to \e free_cells and forget the previous ray */
+  void flush(OcTreeKeyCountMap& free_cells);
+
+  /** \brief Forget the previous ray */
+  void reset();
+
+private:
+  /** \brief Return the index of \e key in previous_ray_ near \e index, or previous_ray_.size() if it is not there */
+  std::size_t findInPreviousRay(const octomap::OcTreeKey& key, std::size_t index) const;
+
+  // Cached because it pre-allocates a lot of memory in its constructor
+  octomap::KeyRay key_ray_;
+  std::vector<octomap::OcTreeKey> previous_ray_;
+  // Counted rays: the outstanding counts of the cells of previous_ray_
+  std::vector<unsigned int> pending_counts_;
+  std::vector<unsigned int> next_pending_counts_;
+  std::vector<bool> carried_over_;
+};
+
+/** \brief Order ray end cells by their direction from \e origin, in rows of similar elevation like the scan lines
+ *  of a depth camera, so that consecutive rays are neighbors */
+void sortRayEndsByDirection(const octomap::OcTree& tree, const octomap::point3d& origin,
+                            std::vector<octomap::OcTreeKey>& ends);
+
+/** \brief Order weighted ray end cells by their direction from \e origin, see above */
+void sortRayEndsByDirection(const octomap::OcTree& tree, const octomap::point3d& origin,
+                            std::vector<std::pair<octomap::OcTreeKey, unsigned int>>& weighted_ends);
+}  // namespace occupancy_map_monitor
@@ -70,10 +70,12 @@ public:
   void stopMonitor();
 
   /** @brief Get a pointer to the underlying octree for this monitor. Lock the tree before reading or writing using this
-   *  pointer. The value of this pointer stays the same throughout the existance of the monitor instance. */
+   *  pointer. The value of this pointer stays the same throughout the existance of the monitor instance.
+   *  With double_buffered_octomap enabled this is the published tree, which only receives the changes of the updaters
+   *  when they trigger the update callback. */
   const collision_detection::OccMapTreePtr& getOcTreePtr()
   {
-    return tree_;
+    return published_tree_;
   }
 
   /** @brief Get a const pointer to the underlying octree for this monitor. Lock the
@@ -83,6 +85,20 @@ public:
     return tree_const_;
   }
 
+  /** @brief Get a pointer to the octree the updaters integrate sensor data into. This is the same tree as
+   *  getOcTreePtr() unless double_buffered_octomap is enabled. */
+  const collision_detection::OccMapTreePtr& getUpdaterOcTreePtr()
+  {
+    return tree_;
+  }
+
+  /** @brief Clear the octree, including the tree the updaters write to if it is double buffered */
+  void clearOcTree();
+
+  /** @brief Trigger the update callback after the content of the updaters' tree was replaced, which the change
+   *  detection of a double buffered octomap does not see */
+  void triggerFullUpdate();
+
   const std::string& getMapFrame() const
   {
     return map_frame_;
@@ -111,7 +127,10 @@ public:
   /** @brief Set the callback to trigger when updates to the maintained octomap are received */
   void setUpdateCallback(const boost::function<void()>& update_callback)
   {
-    tree_->setUpdateCallback(update_callback);
+    if (double_buffered_)
+      update_callback_ = update_callback;
+    else
+      tree_->setUpdateCallback(update_callback);
   }
 
   void setTransformCacheCallback(const TransformCacheProvider& transform_cache_callback);
@@ -132,6 +151,10 @@ private:
   /** @brief Load octree from a binary file (gets rid of current octree data) */
   bool loadMapCallback(moveit_msgs::LoadMap::Request& request, moveit_msgs::LoadMap::Response& response);
 
+  /** @brief Copy the changes the updaters made since the last call into the published tree and run the update callback.
+   *  If full is true, the published tree is replaced by a copy of the updated tree instead. */
+  void publishOcTree(bool full);
+
   bool getShapeTransformCache(std::size_t index, const std::string& target_frame, const ros::Time& target_time,
                               ShapeTransformCache& cache) const;
 
@@ -140,8 +163,11 @@ private:
   double map_resolution_;
   boost::mutex parameters_lock_;
 
-  collision_detection::OccMapTreePtr tree_;
+  collision_detection::OccMapTreePtr tree_;  /// written by the updaters
+  collision_detection::OccMapTreePtr published_tree_;  /// read by consumers, same as tree_ unless double buffered
   collision_detection::OccMapTreeConstPtr tree_const_;
+  bool double_buffered_;
+  boost::function<void()> update_callback_;  /// called after publishing when double buffered
 
   std::unique_ptr<pluginlib::ClassLoader<OccupancyMapUpdater> > updater_plugin_loader_;
   std::vector<OccupancyMapUpdaterPtr> map_updaters_;
@@ -0,0 +1,119 @@
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2026, PickNik LLC.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of PickNik LLC nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *********************************************************************/
+
+#pragma once
+
+#include <moveit/collision_detection/occupancy_map.h>
+#include <octomap_msgs/Octomap.h>
+#include <ros/ros.h>
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace occupancy_map_monitor
+{
+/** \brief The octomap_msgs::Octomap id of the messages of an octree delta stream */
+static const std::string OCTREE_DELTA_ID = "OcTreeDelta";
+
+/** \brief The content of one message of an octree delta stream.
+ *
+ *  A stream consists of keyframes, which contain the whole tree, and deltas, which contain the cells that changed
+ *  since the previous message. The messages are numbered consecutively, so a receiver that missed a message can wait
+ *  for the next keyframe. The payload is deflate compressed. */
+struct OcTreeDelta
+{
+  std::uint32_t sequence;
+
+  /** \brief True if this message contains the whole tree, which replaces the previous one */
+  bool keyframe;
+
+  /** \brief The whole tree, with the maximum likelihood occupancy of its cells. Only set for keyframes. */
+  std::shared_ptr<octomap::OcTree> tree;
+
+  /** \brief The changed cells and their log-odds, which are NaN for deleted cells. Only set for deltas. */
+  std::vector<std::pair<octomap::OcTreeKey, float>> cells;
+};
+
+/** \brief Fill \e msg with a keyframe containing \e tree. The tree needs to be locked for reading.
+ *  @return false if the tree could not be serialized or compressed */
+bool encodeOcTreeKeyframe(const octomap::OcTree& tree, std::uint32_t sequence, int compression_level,
+                          octomap_msgs::Octomap& msg);
+
+/** \brief Fill \e msg with a delta containing \e cells, the changed cells and their log-odds, or NaN for deleted
+ *  cells, of a tree with the given \e resolution.
+ *  @return false if the data could not be compressed */
+bool encodeOcTreeDelta(const std::vector<std::pair<octomap::OcTreeKey, float>>& cells, double resolution,
+                       std::uint32_t sequence, int compression_level, octomap_msgs::Octomap& msg);
+
+/** \brief Decode a message of an octree delta stream.
+ *  @return false if \e msg is not part of an octree delta stream or is corrupt */
+bool decodeOcTreeDelta(const octomap_msgs::Octomap& msg, OcTreeDelta& delta);
+
+/** \brief Apply \e delta to \e tree. The tree needs to be locked for writing and to have the resolution of the
+ *  stream. */
+void applyOcTreeDelta(const OcTreeDelta& delta, octomap::OcTree& tree);
+
+/** \brief Publishes the changes of an octree as an octree delta stream.
+ *
+ *  The changes are found by the change detection of the tree, which is enabled on construction. Only cells that
+ *  were created or changed their occupancy are recorded by it, so the receivers get the occupancy of all cells right
+ *  while their log-odds may lag behind. Changes that bypass the change detection, like clearing the tree, reach the
+ *  receivers with the next keyframe. */
+class OcTreeDeltaPublisher
+{
+public:
+  /** \brief Advertise the stream on \e topic of \e nh. A keyframe is sent every \e keyframe_period seconds and when
+   *  a subscriber connects. */
+  OcTreeDeltaPublisher(const collision_detection::OccMapTreePtr& tree, ros::NodeHandle& nh, const std::string& topic,
+                       double keyframe_period = 5.0, int compression_level = -1);
+
+  /** \brief Publish the changes since the last call, or a keyframe when one is due. Call this from the update
+   *  callback of the tree, while the tree is not locked. */
+  void publish(const std::string& frame_id, const ros::Time& stamp);
+
+private:
+  collision_detection::OccMapTreePtr tree_;
+  ros::Publisher publisher_;
+  double keyframe_period_;
+  int compression_level_;
+
+  std::uint32_t sequence_;
+  ros::WallTime last_keyframe_time_;
+  std::atomic<bool> keyframe_requested_;
+};
+}  // namespace occupancy_map_monitor
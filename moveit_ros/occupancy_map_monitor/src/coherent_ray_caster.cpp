@@ -0,0 +1,160 @@
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2026, PickNik LLC.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of PickNik LLC nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *********************************************************************/
+
+#include <moveit/occupancy_map_monitor/coherent_ray_caster.h>
+
+#include <algorithm>
+#include <cmath>
+
+namespace occupancy_map_monitor
+{
+namespace
+{
+// Elevation range of a row of rays [rad]. Rays within a row are ordered by azimuth.
+constexpr double ROW_ELEVATION_RANGE = 0.01;
+// How many cells earlier or later a cell may appear in the previous ray to be recognized
+constexpr std::size_t MATCH_WINDOW = 2;
+
+const octomap::OcTreeKey& endKey(const octomap::OcTreeKey& end)
+{
+  return end;
+}
+
+const octomap::OcTreeKey& endKey(const std::pair<octomap::OcTreeKey, unsigned int>& weighted_end)
+{
+  return weighted_end.first;
+}
+
+template <typename RayEnd>
+void sortByDirection(const octomap::OcTree& tree, const octomap::point3d& origin, std::vector<RayEnd>& ends)
+{
+  // (row, azimuth) of each end
+  std::vector<std::pair<std::pair<int, double>, RayEnd>> sorted_ends;
+  sorted_ends.reserve(ends.size());
+  for (const RayEnd& end : ends)
+  {
+    const octomap::point3d direction = tree.keyToCoord(endKey(end)) - origin;
+    const double elevation = std::atan2(direction.z(), std::hypot(direction.x(), direction.y()));
+    const double azimuth = std::atan2(direction.y(), direction.x());
+    sorted_ends.push_back({ { static_cast<int>(std::floor(elevation / ROW_ELEVATION_RANGE)), azimuth }, end });
+  }
+
+  std::sort(sorted_ends.begin(), sorted_ends.end(),
+            [](const auto& a, const auto& b) { return a.first < b.first; });
+  for (std::size_t i = 0; i < ends.size(); ++i)
+    ends[i] = sorted_ends[i].second;
+}
+}  // namespace
+
+std::size_t CoherentRayCaster::findInPreviousRay(const octomap::OcTreeKey& key, std::size_t index) const
+{
+  const std::size_t last = std::min(index + MATCH_WINDOW + 1, previous_ray_.size());
+  for (std::size_t j = index > MATCH_WINDOW ? index - MATCH_WINDOW : 0; j < last; ++j)
+    if (previous_ray_[j] == key)
+      return j;
+  return previous_ray_.size();
+}
+
+bool CoherentRayCaster::castRay(const octomap::OcTree& tree, const octomap::point3d& origin,
+                                const octomap::OcTreeKey& end, octomap::KeySet& free_cells)
+{
+  if (!tree.computeRayKeys(origin, tree.keyToCoord(end), key_ray_))
+    return false;
+
+  // the cells found in the previous ray were added with it
+  std::size_t index = 0;
+  for (const octomap::OcTreeKey& key : key_ray_)
+    if (findInPreviousRay(key, index++) == previous_ray_.size())
+      free_cells.insert(key);
+  previous_ray_.assign(key_ray_.begin(), key_ray_.end());
+  return true;
+}
+
+bool CoherentRayCaster::castRay(const octomap::OcTree& tree, const octomap::point3d& origin,
+                                const octomap::OcTreeKey& end, unsigned int weight, OcTreeKeyCountMap& free_cells)
+{
+  if (!tree.computeRayKeys(origin, tree.keyToCoord(end), key_ray_))
+    return false;
+
+  // The outstanding count of a cell found in the previous ray is carried over to this one. Since the cells of a ray
+  // are distinct, each count is carried over at most once.
+  next_pending_counts_.assign(key_ray_.size(), weight);
+  carried_over_.assign(previous_ray_.size(), false);
+  std::size_t index = 0;
+  for (const octomap::OcTreeKey& key : key_ray_)
+  {
+    const std::size_t previous_index = findInPreviousRay(key, index);
+    if (previous_index < previous_ray_.size())
+    {
+      next_pending_counts_[index] += pending_counts_[previous_index];
+      carried_over_[previous_index] = true;
+    }
+    ++index;
+  }
+
+  // the counts of the other cells of the previous ray are final
+  for (std::size_t i = 0; i < previous_ray_.size(); ++i)
+    if (!carried_over_[i])
+      free_cells[previous_ray_[i]] += pending_counts_[i];
+
+  previous_ray_.assign(key_ray_.begin(), key_ray_.end());
+  pending_counts_.swap(next_pending_counts_);
+  return true;
+}
+
+void CoherentRayCaster::flush(OcTreeKeyCountMap& free_cells)
+{
+  for (std::size_t i = 0; i < pending_counts_.size(); ++i)
+    free_cells[previous_ray_[i]] += pending_counts_[i];
+  reset();
+}
+
+void CoherentRayCaster::reset()
+{
+  previous_ray_.clear();
+  pending_counts_.clear();
+}
+
+void sortRayEndsByDirection(const octomap::OcTree& tree, const octomap::point3d& origin,
+                            std::vector<octomap::OcTreeKey>& ends)
+{
+  sortByDirection(tree, origin, ends);
+}
+
+void sortRayEndsByDirection(const octomap::OcTree& tree, const octomap::point3d& origin,
+                            std::vector<std::pair<octomap::OcTreeKey, unsigned int>>& weighted_ends)
+{
+  sortByDirection(tree, origin, weighted_ends);
+}
+}  // namespace occupancy_map_monitor
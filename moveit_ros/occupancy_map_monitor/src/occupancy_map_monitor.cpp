@@ -100,7 +100,21 @@ void OccupancyMapMonitor::initialize()
                                                         "No transforms will be applied to received data.");
 
   tree_ = std::make_shared<collision_detection::OccMapTree>(map_resolution_);
-  tree_const_ = tree_;
+
+  // with a double buffered octomap, the updaters integrate sensor data into tree_ while planners read
+  // published_tree_, which only gets locked for copying the keys that changed when an updater triggers the update
+  // callback
+  nh_.param("double_buffered_octomap", double_buffered_, false);
+  if (double_buffered_)
+  {
+    published_tree_ = std::make_shared<collision_detection::OccMapTree>(map_resolution_);
+    tree_->enableChangeDetection(true);
+    tree_->setUpdateCallback([this] { publishOcTree(false); });
+    ROS_INFO_NAMED(LOGNAME, "Using a double buffered octomap");
+  }
+  else
+    published_tree_ = tree_;
+  tree_const_ = published_tree_;
 
   XmlRpc::XmlRpcValue sensor_list;
   if (nh_.getParam("sensors", sensor_list))
@@ -311,6 +325,58 @@ bool OccupancyMapMonitor::getShapeTransformCache(std::size_t index, const std::s
     return false;
 }
 
+void OccupancyMapMonitor::publishOcTree(bool full)
+{
+  // resetting the change set modifies the updated tree as well
+  tree_->lockWrite();
+  published_tree_->lockWrite();
+  try
+  {
+    if (full)
+    {
+      octomap::OcTree copy(*tree_);
+      published_tree_->swapContent(copy);
+    }
+    else
+    {
+      // only nodes that were created or changed their occupancy are recorded, so the published log-odds of the
+      // remaining nodes lag behind until their classification flips
+      for (octomap::KeyBoolMap::const_iterator it = tree_->changedKeysBegin(); it != tree_->changedKeysEnd(); ++it)
+      {
+        const collision_detection::OccMapNode* node = tree_->search(it->first);
+        if (node)
+          published_tree_->setNodeValue(it->first, node->getLogOdds());
+        else
+          published_tree_->deleteNode(it->first);
+      }
+    }
+    tree_->resetChangeDetection();
+  }
+  catch (...)
+  {
+    ROS_ERROR_NAMED(LOGNAME, "Internal error while publishing octree");
+  }
+  published_tree_->unlockWrite();
+  tree_->unlockWrite();
+
+  if (update_callback_)
+    update_callback_();
+}
+
+void OccupancyMapMonitor::clearOcTree()
+{
+  tree_->lockWrite();
+  tree_->clear();
+  if (double_buffered_)
+  {
+    tree_->resetChangeDetection();
+    published_tree_->lockWrite();
+    published_tree_->clear();
+    published_tree_->unlockWrite();
+  }
+  tree_->unlockWrite();
+}
+
 bool OccupancyMapMonitor::saveMapCallback(moveit_msgs::SaveMap::Request& request,
                                           moveit_msgs::SaveMap::Response& response)
 {
@@ -347,11 +413,19 @@ bool OccupancyMapMonitor::loadMapCallback(moveit_msgs::LoadMap::Request& request
   tree_->unlockWrite();
 
   if (response.success)
-    tree_->triggerUpdateCallback();
+    triggerFullUpdate();
 
   return true;
 }
 
+void OccupancyMapMonitor::triggerFullUpdate()
+{
+  if (double_buffered_)
+    publishOcTree(true);
+  else
+    tree_->triggerUpdateCallback();
+}
+
 void OccupancyMapMonitor::startMonitor()
 {
   active_ = true;
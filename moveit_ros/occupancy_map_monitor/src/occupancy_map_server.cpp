@@ -38,6 +38,7 @@
 #include <ros/ros.h>
 #include <tf2_ros/transform_listener.h>
 #include <moveit/occupancy_map_monitor/occupancy_map_monitor.h>
+#include <moveit/occupancy_map_monitor/octree_delta.h>
 #include <octomap_msgs/conversions.h>
 
 static const std::string LOGNAME = "occupancy_map_server";
@@ -68,11 +69,35 @@ int main(int argc, char** argv)
 {
   ros::init(argc, argv, "occupancy_map_server");
   ros::NodeHandle nh;
-  ros::Publisher octree_binary_pub = nh.advertise<octomap_msgs::Octomap>("octomap_binary", 1);
+  ros::NodeHandle private_nh("~");
   std::shared_ptr<tf2_ros::Buffer> buffer = std::make_shared<tf2_ros::Buffer>(ros::Duration(5.0));
   std::shared_ptr<tf2_ros::TransformListener> listener = std::make_shared<tf2_ros::TransformListener>(*buffer, nh);
   occupancy_map_monitor::OccupancyMapMonitor server(buffer);
-  server.setUpdateCallback([&octree_binary_pub, &server] { return publishOctomap(octree_binary_pub, server); });
+
+  // the full octomap is published on every update, unless only the compressed delta stream is wanted
+  bool publish_octomap_binary;
+  std::string octree_delta_topic;
+  double keyframe_period;
+  int compression_level;
+  private_nh.param("publish_octomap_binary", publish_octomap_binary, true);
+  private_nh.param("octree_delta_topic", octree_delta_topic, std::string());
+  private_nh.param("octree_delta_keyframe_period", keyframe_period, 5.0);
+  private_nh.param("octree_delta_compression_level", compression_level, -1);
+
+  ros::Publisher octree_binary_pub;
+  if (publish_octomap_binary)
+    octree_binary_pub = nh.advertise<octomap_msgs::Octomap>("octomap_binary", 1);
+  std::unique_ptr<occupancy_map_monitor::OcTreeDeltaPublisher> delta_publisher;
+  if (!octree_delta_topic.empty())
+    delta_publisher = std::make_unique<occupancy_map_monitor::OcTreeDeltaPublisher>(
+        server.getOcTreePtr(), nh, octree_delta_topic, keyframe_period, compression_level);
+
+  server.setUpdateCallback([&] {
+    if (publish_octomap_binary)
+      publishOctomap(octree_binary_pub, server);
+    if (delta_publisher)
+      delta_publisher->publish(server.getMapFrame(), ros::Time::now());
+  });
   server.startMonitor();
 
   ros::spin();
@@ -50,7 +50,7 @@ OccupancyMapUpdater::~OccupancyMapUpdater() = default;
 void OccupancyMapUpdater::setMonitor(OccupancyMapMonitor* monitor)
 {
   monitor_ = monitor;
-  tree_ = monitor->getOcTreePtr();
+  tree_ = monitor->getUpdaterOcTreePtr();
 }
 
 void OccupancyMapUpdater::readXmlParam(XmlRpc::XmlRpcValue& params, const std::string& param_name, double* value)
@@ -0,0 +1,293 @@
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2026, PickNik LLC.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of PickNik LLC nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *********************************************************************/
+
+#include <moveit/occupancy_map_monitor/octree_delta.h>
+
+#include <zlib.h>
+
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <sstream>
+
+namespace occupancy_map_monitor
+{
+static const std::string LOGNAME = "octree_delta";
+
+namespace
+{
+// The payload starts with the format version, the message kind and the sequence number. Keyframes continue with the
+// binary octomap stream of the tree, deltas with the number of cells and one record of key and log-odds per cell.
+// The payload is deflate compressed and preceded by its uncompressed size. All numbers are little endian.
+const std::uint8_t FORMAT_VERSION = 1;
+const std::uint8_t KEYFRAME = 0;
+const std::uint8_t DELTA = 1;
+const std::size_t HEADER_SIZE = 6;
+const std::size_t CELL_SIZE = 10;
+
+void writeUInt16(std::uint16_t value, std::string& data)
+{
+  data.push_back(static_cast<char>(value & 0xff));
+  data.push_back(static_cast<char>(value >> 8));
+}
+
+void writeUInt32(std::uint32_t value, std::string& data)
+{
+  for (int i = 0; i < 4; ++i)
+    data.push_back(static_cast<char>((value >> (8 * i)) & 0xff));
+}
+
+std::uint16_t readUInt16(const std::uint8_t* data)
+{
+  return static_cast<std::uint16_t>(data[0] | (data[1] << 8));
+}
+
+std::uint32_t readUInt32(const std::uint8_t* data)
+{
+  return static_cast<std::uint32_t>(data[0]) | (static_cast<std::uint32_t>(data[1]) << 8) |
+         (static_cast<std::uint32_t>(data[2]) << 16) | (static_cast<std::uint32_t>(data[3]) << 24);
+}
+
+void writeHeader(std::uint8_t kind, std::uint32_t sequence, std::string& payload)
+{
+  payload.push_back(static_cast<char>(FORMAT_VERSION));
+  payload.push_back(static_cast<char>(kind));
+  writeUInt32(sequence, payload);
+}
+
+bool compressPayload(const std::string& payload, double resolution, int compression_level, octomap_msgs::Octomap& msg)
+{
+  uLongf compressed_size = compressBound(payload.size());
+  msg.data.resize(4 + compressed_size);
+  std::uint8_t* data = reinterpret_cast<std::uint8_t*>(msg.data.data());
+  const std::uint32_t size = payload.size();
+  for (int i = 0; i < 4; ++i)
+    data[i] = (size >> (8 * i)) & 0xff;
+  if (compress2(data + 4, &compressed_size, reinterpret_cast<const Bytef*>(payload.data()), payload.size(),
+                compression_level) != Z_OK)
+  {
+    ROS_ERROR_NAMED(LOGNAME, "Failed to compress octree data");
+    return false;
+  }
+  msg.data.resize(4 + compressed_size);
+  msg.id = OCTREE_DELTA_ID;
+  msg.binary = true;
+  msg.resolution = resolution;
+  return true;
+}
+}  // namespace
+
+bool encodeOcTreeKeyframe(const octomap::OcTree& tree, std::uint32_t sequence, int compression_level,
+                          octomap_msgs::Octomap& msg)
+{
+  std::stringstream stream;
+  if (!tree.writeBinaryData(stream))
+  {
+    ROS_ERROR_NAMED(LOGNAME, "Failed to serialize octree");
+    return false;
+  }
+
+  std::string payload;
+  writeHeader(KEYFRAME, sequence, payload);
+  payload += stream.str();
+  return compressPayload(payload, tree.getResolution(), compression_level, msg);
+}
+
+bool encodeOcTreeDelta(const std::vector<std::pair<octomap::OcTreeKey, float>>& cells, double resolution,
+                       std::uint32_t sequence, int compression_level, octomap_msgs::Octomap& msg)
+{
+  std::string payload;
+  payload.reserve(HEADER_SIZE + 4 + cells.size() * CELL_SIZE);
+  writeHeader(DELTA, sequence, payload);
+  writeUInt32(cells.size(), payload);
+  for (const std::pair<octomap::OcTreeKey, float>& cell : cells)
+  {
+    for (unsigned int i = 0; i < 3; ++i)
+      writeUInt16(cell.first[i], payload);
+    std::uint32_t value;
+    std::memcpy(&value, &cell.second, sizeof(value));
+    writeUInt32(value, payload);
+  }
+  return compressPayload(payload, resolution, compression_level, msg);
+}
+
+bool decodeOcTreeDelta(const octomap_msgs::Octomap& msg, OcTreeDelta& delta)
+{
+  if (msg.id != OCTREE_DELTA_ID || msg.data.size() < 4)
+  {
+    ROS_ERROR_NAMED(LOGNAME, "Received an octomap message that is not part of an octree delta stream");
+    return false;
+  }
+
+  const std::uint8_t* data = reinterpret_cast<const std::uint8_t*>(msg.data.data());
+  uLongf size = readUInt32(data);
+  std::vector<std::uint8_t> payload(size);
+  if (size < HEADER_SIZE || uncompress(payload.data(), &size, data + 4, msg.data.size() - 4) != Z_OK ||
+      size != payload.size() || payload[0] != FORMAT_VERSION)
+  {
+    ROS_ERROR_NAMED(LOGNAME, "Received a corrupt octree delta message");
+    return false;
+  }
+
+  delta.sequence = readUInt32(&payload[2]);
+  delta.keyframe = payload[1] == KEYFRAME;
+  delta.cells.clear();
+  delta.tree.reset();
+  if (delta.keyframe)
+  {
+    std::stringstream stream(std::string(payload.begin() + HEADER_SIZE, payload.end()));
+    delta.tree = std::make_shared<octomap::OcTree>(msg.resolution);
+    if (!delta.tree->readBinaryData(stream))
+    {
+      ROS_ERROR_NAMED(LOGNAME, "Received a corrupt octree keyframe");
+      return false;
+    }
+    return true;
+  }
+
+  const std::size_t num_cells = payload.size() >= HEADER_SIZE + 4 ? readUInt32(&payload[HEADER_SIZE]) : 0;
+  if (payload[1] != DELTA || payload.size() != HEADER_SIZE + 4 + num_cells * CELL_SIZE)
+  {
+    ROS_ERROR_NAMED(LOGNAME, "Received a corrupt octree delta message");
+    return false;
+  }
+
+  delta.cells.resize(num_cells);
+  const std::uint8_t* record = &payload[HEADER_SIZE + 4];
+  for (std::pair<octomap::OcTreeKey, float>& cell : delta.cells)
+  {
+    cell.first = octomap::OcTreeKey(readUInt16(record), readUInt16(record + 2), readUInt16(record + 4));
+    const std::uint32_t value = readUInt32(record + 6);
+    std::memcpy(&cell.second, &value, sizeof(value));
+    record += CELL_SIZE;
+  }
+  return true;
+}
+
+void applyOcTreeDelta(const OcTreeDelta& delta, octomap::OcTree& tree)
+{
+  if (delta.keyframe)
+  {
+    // swapping leaves the received tree empty, which does not matter as it is not used again
+    tree.swapContent(*delta.tree);
+    return;
+  }
+
+  for (const std::pair<octomap::OcTreeKey, float>& cell : delta.cells)
+    if (std::isnan(cell.second))
+      tree.deleteNode(cell.first);
+    else
+      tree.setNodeValue(cell.first, cell.second);
+}
+
+OcTreeDeltaPublisher::OcTreeDeltaPublisher(const collision_detection::OccMapTreePtr& tree, ros::NodeHandle& nh,
+                                           const std::string& topic, double keyframe_period, int compression_level)
+  : tree_(tree)
+  , keyframe_period_(keyframe_period)
+  , compression_level_(compression_level)
+  , sequence_(0)
+  , keyframe_requested_(true)
+{
+  tree_->lockWrite();
+  tree_->enableChangeDetection(true);
+  tree_->unlockWrite();
+  publisher_ = nh.advertise<octomap_msgs::Octomap>(topic, 10, [this](const ros::SingleSubscriberPublisher&) {
+    // the new subscriber needs the whole tree to apply deltas to
+    keyframe_requested_ = true;
+  });
+}
+
+void OcTreeDeltaPublisher::publish(const std::string& frame_id, const ros::Time& stamp)
+{
+  if (publisher_.getNumSubscribers() == 0)
+  {
+    // the next subscriber starts with a keyframe anyway, so the changes are not needed
+    tree_->lockWrite();
+    tree_->resetChangeDetection();
+    tree_->unlockWrite();
+    return;
+  }
+
+  octomap_msgs::Octomap msg;
+  msg.header.frame_id = frame_id;
+  msg.header.stamp = stamp;
+
+  const ros::WallTime now = ros::WallTime::now();
+  const bool keyframe = keyframe_requested_.exchange(false) || (now - last_keyframe_time_).toSec() >= keyframe_period_;
+  bool ok;
+  if (keyframe)
+  {
+    // changes made after resetting the change detection are both in the keyframe and in the next delta, which is
+    // harmless, so the tree only needs to be locked for writing briefly
+    tree_->lockWrite();
+    tree_->resetChangeDetection();
+    tree_->unlockWrite();
+
+    tree_->lockRead();
+    ok = encodeOcTreeKeyframe(*tree_, sequence_, compression_level_, msg);
+    tree_->unlockRead();
+    last_keyframe_time_ = now;
+  }
+  else
+  {
+    std::vector<std::pair<octomap::OcTreeKey, float>> cells;
+    tree_->lockWrite();
+    cells.reserve(tree_->numChangesDetected());
+    for (octomap::KeyBoolMap::const_iterator it = tree_->changedKeysBegin(); it != tree_->changedKeysEnd(); ++it)
+    {
+      const octomap::OcTreeNode* node = tree_->search(it->first);
+      cells.emplace_back(it->first, node ? node->getLogOdds() : std::numeric_limits<float>::quiet_NaN());
+    }
+    tree_->resetChangeDetection();
+    tree_->unlockWrite();
+
+    if (cells.empty())
+      return;
+    ok = encodeOcTreeDelta(cells, tree_->getResolution(), sequence_, compression_level_, msg);
+  }
+
+  if (ok)
+  {
+    publisher_.publish(msg);
+    ROS_DEBUG_NAMED(LOGNAME, "Published octree %s %u of %lu bytes", keyframe ? "keyframe" : "delta", sequence_,
+                    (long unsigned int)msg.data.size());
+    ++sequence_;
+  }
+  else
+  {
+    // the changes are lost, so the receivers need the whole tree again
+    keyframe_requested_ = true;
+  }
+}
+}  // namespace occupancy_map_monitor
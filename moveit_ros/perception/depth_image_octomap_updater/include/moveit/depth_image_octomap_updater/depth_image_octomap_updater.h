@@ -92,6 +92,9 @@ private:
   double max_update_rate_;
   unsigned int skip_vertical_pixels_;
   unsigned int skip_horizontal_pixels_;
+  unsigned int num_threads_;
+  LazyFreeSpaceUpdater::DecayModel free_space_decay_;
+  double free_space_decay_time_;
 
   unsigned int image_callback_count_;
   double average_callback_dt_;
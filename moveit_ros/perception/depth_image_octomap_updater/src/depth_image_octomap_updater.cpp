@@ -67,6 +67,9 @@ DepthImageOctomapUpdater::DepthImageOctomapUpdater()
   , max_update_rate_(0)
   , skip_vertical_pixels_(4)
   , skip_horizontal_pixels_(6)
+  , num_threads_(1)
+  , free_space_decay_(LazyFreeSpaceUpdater::NO_DECAY)
+  , free_space_decay_time_(0.0)
   , image_callback_count_(0)
   , average_callback_dt_(0.0)
   , good_tf_(5)
@@ -103,6 +106,30 @@ bool DepthImageOctomapUpdater::setParams(XmlRpc::XmlRpcValue& params)
       readXmlParam(params, "max_update_rate", &max_update_rate_);
     readXmlParam(params, "skip_vertical_pixels", &skip_vertical_pixels_);
     readXmlParam(params, "skip_horizontal_pixels", &skip_horizontal_pixels_);
+    if (params.hasMember("num_threads"))
+      readXmlParam(params, "num_threads", &num_threads_);
+    if (num_threads_ == 0)
+    {
+      ROS_ERROR_NAMED(LOGNAME, "num_threads must be at least 1");
+      return false;
+    }
+    if (params.hasMember("free_space_decay"))
+    {
+      const std::string decay = static_cast<const std::string&>(params["free_space_decay"]);
+      if (decay == "none")
+        free_space_decay_ = LazyFreeSpaceUpdater::NO_DECAY;
+      else if (decay == "linear")
+        free_space_decay_ = LazyFreeSpaceUpdater::LINEAR_DECAY;
+      else if (decay == "exponential")
+        free_space_decay_ = LazyFreeSpaceUpdater::EXPONENTIAL_DECAY;
+      else
+      {
+        ROS_ERROR_NAMED(LOGNAME, "Unknown free_space_decay '%s', expected 'none', 'linear' or 'exponential'",
+                        decay.c_str());
+        return false;
+      }
+      readXmlParam(params, "free_space_decay_time", &free_space_decay_time_);
+    }
     if (params.hasMember("filtered_cloud_topic"))
       filtered_cloud_topic_ = static_cast<const std::string&>(params["filtered_cloud_topic"]);
     if (params.hasMember("ns"))
@@ -120,7 +147,9 @@ bool DepthImageOctomapUpdater::setParams(XmlRpc::XmlRpcValue& params)
 bool DepthImageOctomapUpdater::initialize()
 {
   tf_buffer_ = monitor_->getTFClient();
-  free_space_updater_ = std::make_unique<LazyFreeSpaceUpdater>(tree_);
+  free_space_updater_ = std::make_unique<LazyFreeSpaceUpdater>(tree_, 10, num_threads_);
+  if (free_space_decay_ != LazyFreeSpaceUpdater::NO_DECAY)
+    free_space_updater_->setDecay(free_space_decay_, free_space_decay_time_);
 
   // create our mesh filter
   mesh_filter_ = std::make_unique<mesh_filter::MeshFilter<mesh_filter::StereoCameraModel>>(
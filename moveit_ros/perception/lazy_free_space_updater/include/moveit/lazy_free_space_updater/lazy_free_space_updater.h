@@ -37,33 +37,63 @@
 #pragma once
 
 #include <moveit/collision_detection/occupancy_map.h>
+#include <moveit/occupancy_map_monitor/coherent_ray_caster.h>
+#include <ros/time.h>
 #include <boost/thread.hpp>
 #include <deque>
 #include <unordered_map>
 
 namespace occupancy_map_monitor
 {
+/** \brief Marks the cells between a sensor and the cells it observed as free, in a background thread.
+ *
+ *  The cells of consecutive clouds taken from about the same sensor origin are merged into one batch while the
+ *  previous batch is still being processed, so the free space keeps up with the occupied cells. The rays of a batch
+ *  can be cast by several threads. */
 class LazyFreeSpaceUpdater
 {
 public:
-  LazyFreeSpaceUpdater(const collision_detection::OccMapTreePtr& tree, unsigned int max_batch_size = 10);
+  /** \brief How occupied cells that are not observed again lose their occupancy over time */
+  enum DecayModel
+  {
+    /** \brief Occupied cells only become free when rays pass through them */
+    NO_DECAY,
+    /** \brief The log-odds of occupied cells decrease at a constant rate */
+    LINEAR_DECAY,
+    /** \brief The log-odds of occupied cells decay exponentially towards the minimum clamping threshold */
+    EXPONENTIAL_DECAY
+  };
+
+  LazyFreeSpaceUpdater(const collision_detection::OccMapTreePtr& tree, unsigned int max_batch_size = 10,
+                       unsigned int num_threads = 1);
   ~LazyFreeSpaceUpdater();
 
   void pushLazyUpdate(octomap::KeySet* occupied_cells, octomap::KeySet* model_cells,
                       const octomap::point3d& sensor_origin);
 
+  /** \brief Let occupied cells that were not hit by the last batch decay over time. For LINEAR_DECAY, a cell at
+   *  the maximum clamping threshold is no longer occupied after \e decay_time seconds. For EXPONENTIAL_DECAY,
+   *  \e decay_time is the time constant. The decay is applied to the whole tree whenever a batch is processed, so it
+   *  should only be enabled for one of the sensors updating a tree. */
+  void setDecay(DecayModel model, double decay_time);
+
 private:
-#ifdef __APPLE__
-  typedef std::unordered_map<octomap::OcTreeKey, unsigned int, octomap::OcTreeKey::KeyHash> OcTreeKeyCountMap;
-#elif __cplusplus >= 201103L
-  typedef std::unordered_map<octomap::OcTreeKey, unsigned int, octomap::OcTreeKey::KeyHash> OcTreeKeyCountMap;
-#else
-  typedef std::tr1::unordered_map<octomap::OcTreeKey, unsigned int, octomap::OcTreeKey::KeyHash> OcTreeKeyCountMap;
-#endif
+  /** \brief The cells of one or more consecutive clouds taken from about the same sensor origin */
+  struct Batch
+  {
+    OcTreeKeyCountMap occupied_cells;
+    octomap::KeySet model_cells;
+    octomap::point3d sensor_origin;
+    std::size_t size;
+  };
 
-  void pushBatchToProcess(OcTreeKeyCountMap* occupied_cells, octomap::KeySet* model_cells,
+  /** \brief Merge the cells into the last waiting batch, or queue them as a new batch */
+  void pushBatchToProcess(octomap::KeySet* occupied_cells, octomap::KeySet* model_cells,
                           const octomap::point3d& sensor_origin);
 
+  /** \brief Lower the log-odds of the occupied cells that are not in \e batch. Requires the write lock */
+  void applyDecay(const Batch& batch, DecayModel model, double decay_time);
+
   void lazyUpdateThread();
   void processThread();
 
@@ -71,6 +101,7 @@ private:
   bool running_;
   std::size_t max_batch_size_;
   double max_sensor_delta_;
+  unsigned int num_threads_;
 
   std::deque<octomap::KeySet*> occupied_cells_sets_;
   std::deque<octomap::KeySet*> model_cells_sets_;
@@ -78,9 +109,11 @@ private:
   boost::condition_variable update_condition_;
   boost::mutex update_cell_sets_lock_;
 
-  OcTreeKeyCountMap* process_occupied_cells_set_;
-  octomap::KeySet* process_model_cells_set_;
-  octomap::point3d process_sensor_origin_;
+  /** \brief Batches waiting to be processed. Protected by cell_process_lock_, as are the decay settings */
+  std::deque<Batch> process_batches_;
+  DecayModel decay_model_;
+  double decay_time_;
+  ros::Time last_decay_time_;
   boost::condition_variable process_condition_;
   boost::mutex cell_process_lock_;
 
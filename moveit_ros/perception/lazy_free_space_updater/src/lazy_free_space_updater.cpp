@@ -37,17 +37,25 @@
 #include <moveit/lazy_free_space_updater/lazy_free_space_updater.h>
 #include <ros/console.h>
 
+#include <algorithm>
+#include <cmath>
+#include <omp.h>
+
 namespace occupancy_map_monitor
 {
 static const std::string LOGNAME = "lazy_free_space_updater";
+// Batches from different sensor origins cannot be merged. Beyond this many waiting batches, the oldest are dropped.
+static const std::size_t MAX_WAITING_BATCHES = 4;
 
-LazyFreeSpaceUpdater::LazyFreeSpaceUpdater(const collision_detection::OccMapTreePtr& tree, unsigned int max_batch_size)
+LazyFreeSpaceUpdater::LazyFreeSpaceUpdater(const collision_detection::OccMapTreePtr& tree, unsigned int max_batch_size,
+                                           unsigned int num_threads)
   : tree_(tree)
   , running_(true)
   , max_batch_size_(max_batch_size)
   , max_sensor_delta_(1e-3)  // 1mm
-  , process_occupied_cells_set_(nullptr)
-  , process_model_cells_set_(nullptr)
+  , num_threads_(std::max(num_threads, 1u))
+  , decay_model_(NO_DECAY)
+  , decay_time_(0.0)
   , update_thread_([this] { lazyUpdateThread(); })
   , process_thread_([this] { processThread(); })
 {
@@ -66,6 +74,27 @@ LazyFreeSpaceUpdater::~LazyFreeSpaceUpdater()
   }
   update_thread_.join();
   process_thread_.join();
+
+  while (!occupied_cells_sets_.empty())
+  {
+    delete occupied_cells_sets_.front();
+    occupied_cells_sets_.pop_front();
+    delete model_cells_sets_.front();
+    model_cells_sets_.pop_front();
+  }
+}
+
+void LazyFreeSpaceUpdater::setDecay(DecayModel model, double decay_time)
+{
+  boost::mutex::scoped_lock _(cell_process_lock_);
+  if (model != NO_DECAY && decay_time <= 0.0)
+  {
+    ROS_ERROR_NAMED(LOGNAME, "The free space decay time must be positive. Disabling decay.");
+    model = NO_DECAY;
+  }
+  decay_model_ = model;
+  decay_time_ = decay_time;
+  last_decay_time_ = ros::Time();
 }
 
 void LazyFreeSpaceUpdater::pushLazyUpdate(octomap::KeySet* occupied_cells, octomap::KeySet* model_cells,
@@ -80,26 +109,59 @@ void LazyFreeSpaceUpdater::pushLazyUpdate(octomap::KeySet* occupied_cells, octom
   update_condition_.notify_one();
 }
 
-void LazyFreeSpaceUpdater::pushBatchToProcess(OcTreeKeyCountMap* occupied_cells, octomap::KeySet* model_cells,
+void LazyFreeSpaceUpdater::pushBatchToProcess(octomap::KeySet* occupied_cells, octomap::KeySet* model_cells,
                                               const octomap::point3d& sensor_origin)
 {
-  // this is basically a queue of size 1. if this function is called repeatedly without any work being done by
-  // processThread(),
-  // data can be lost; this is intentional, to avoid spending too much time clearing the octomap
-  if (cell_process_lock_.try_lock())
-  {
-    process_occupied_cells_set_ = occupied_cells;
-    process_model_cells_set_ = model_cells;
-    process_sensor_origin_ = sensor_origin;
-    process_condition_.notify_one();
-    cell_process_lock_.unlock();
-  }
-  else
+  boost::mutex::scoped_lock _(cell_process_lock_);
+
+  // batches grow while processThread() is busy, so no cloud has to wait for a full batch to be freed
+  if (process_batches_.empty() || process_batches_.back().size >= max_batch_size_ ||
+      (process_batches_.back().sensor_origin - sensor_origin).norm() > max_sensor_delta_)
   {
-    ROS_WARN_NAMED(LOGNAME, "Previous batch update did not complete. Ignoring set of cells to be freed.");
-    delete occupied_cells;
-    delete model_cells;
+    if (process_batches_.size() >= MAX_WAITING_BATCHES)
+    {
+      ROS_WARN_NAMED(LOGNAME, "Free space updates are falling behind. Ignoring the oldest set of cells to be freed.");
+      process_batches_.pop_front();
+    }
+    process_batches_.emplace_back();
+    process_batches_.back().sensor_origin = sensor_origin;
+    process_batches_.back().size = 0;
   }
+
+  Batch& batch = process_batches_.back();
+  for (const octomap::OcTreeKey& it : *occupied_cells)
+    batch.occupied_cells[it]++;
+  batch.model_cells.insert(model_cells->begin(), model_cells->end());
+  batch.size++;
+  process_condition_.notify_one();
+
+  delete occupied_cells;
+  delete model_cells;
+}
+
+void LazyFreeSpaceUpdater::applyDecay(const Batch& batch, DecayModel model, double decay_time)
+{
+  const ros::Time now = ros::Time::now();
+  const double dt = last_decay_time_.isZero() ? 0.0 : (now - last_decay_time_).toSec();
+  last_decay_time_ = now;
+  if (dt <= 0.0)
+    return;
+
+  const float linear_delta =
+      -static_cast<float>((tree_->getClampingThresMaxLog() - tree_->getOccupancyThresLog()) * dt / decay_time);
+  const float min_log_odds = tree_->getClampingThresMinLog();
+  const float exponential_factor = static_cast<float>(std::exp(-dt / decay_time)) - 1.0f;
+
+  // collect the changes first, updating the nodes may expand and prune the tree under the iterator
+  std::vector<std::pair<octomap::OcTreeKey, float>> decays;
+  for (octomap::OcTree::leaf_iterator it = tree_->begin_leafs(), end = tree_->end_leafs(); it != end; ++it)
+    if (tree_->isNodeOccupied(*it) && batch.occupied_cells.find(it.getKey()) == batch.occupied_cells.end())
+      decays.emplace_back(it.getKey(), model == LINEAR_DECAY ? linear_delta :
+                                                               (it->getLogOdds() - min_log_odds) * exponential_factor);
+
+  for (const std::pair<octomap::OcTreeKey, float>& it : decays)
+    tree_->updateNode(it.first, it.second);
+  ROS_DEBUG_NAMED(LOGNAME, "Decayed %lu occupied cells", (long unsigned int)decays.size());
 }
 
 void LazyFreeSpaceUpdater::processThread()
@@ -107,79 +169,86 @@ void LazyFreeSpaceUpdater::processThread()
   const float lg_0 = tree_->getClampingThresMinLog() - tree_->getClampingThresMaxLog();
   const float lg_miss = tree_->getProbMissLog();
 
-  octomap::KeyRay key_ray1, key_ray2;
-  OcTreeKeyCountMap free_cells1, free_cells2;
+  std::vector<CoherentRayCaster> ray_casters(num_threads_);
+  std::vector<OcTreeKeyCountMap> free_cells(num_threads_);
+  std::vector<std::pair<octomap::OcTreeKey, unsigned int>> ray_ends;
 
   while (running_)
   {
-    free_cells1.clear();
-    free_cells2.clear();
+    Batch batch;
+    DecayModel decay_model;
+    double decay_time;
+    {
+      boost::unique_lock<boost::mutex> ulock(cell_process_lock_);
+      while (process_batches_.empty() && running_)
+        process_condition_.wait(ulock);
 
-    boost::unique_lock<boost::mutex> ulock(cell_process_lock_);
-    while (!process_occupied_cells_set_ && running_)
-      process_condition_.wait(ulock);
+      if (!running_)
+        break;
 
-    if (!running_)
-      break;
+      batch = std::move(process_batches_.front());
+      process_batches_.pop_front();
+      decay_model = decay_model_;
+      decay_time = decay_time_;
+    }
 
     ROS_DEBUG_NAMED(LOGNAME,
-                    "Begin processing batched update: marking free cells due to %lu occupied cells and %lu model cells",
-                    (long unsigned int)process_occupied_cells_set_->size(),
-                    (long unsigned int)process_model_cells_set_->size());
+                    "Begin processing batched update of %lu clouds: marking free cells due to %lu occupied cells and "
+                    "%lu model cells",
+                    (long unsigned int)batch.size, (long unsigned int)batch.occupied_cells.size(),
+                    (long unsigned int)batch.model_cells.size());
 
     ros::WallTime start = ros::WallTime::now();
+
+    /* the rays ending at occupied cells, weighted by how often the cells were hit, and the rays ending at model cells
+       are sorted together, so that each thread casts a contiguous range of neighboring rays */
+    ray_ends.assign(batch.occupied_cells.begin(), batch.occupied_cells.end());
+    for (const octomap::OcTreeKey& it : batch.model_cells)
+      ray_ends.emplace_back(it, 1);
+    for (OcTreeKeyCountMap& cells : free_cells)
+      cells.clear();
+    const int num_rays = ray_ends.size();
+
     tree_->lockRead();
 
-#pragma omp sections
+    sortRayEndsByDirection(*tree_, batch.sensor_origin, ray_ends);
+
+#pragma omp parallel num_threads(num_threads_)
     {
-#pragma omp section
-      {
-        /* compute the free cells along each ray that ends at an occupied cell */
-        for (std::pair<const octomap::OcTreeKey, unsigned int>& it : *process_occupied_cells_set_)
-          if (tree_->computeRayKeys(process_sensor_origin_, tree_->keyToCoord(it.first), key_ray1))
-            for (octomap::OcTreeKey& jt : key_ray1)
-              free_cells1[jt] += it.second;
-      }
-
-#pragma omp section
-      {
-        /* compute the free cells along each ray that ends at a model cell */
-        for (const octomap::OcTreeKey& it : *process_model_cells_set_)
-          if (tree_->computeRayKeys(process_sensor_origin_, tree_->keyToCoord(it), key_ray2))
-            for (octomap::OcTreeKey& jt : key_ray2)
-              free_cells2[jt]++;
-      }
+      const int thread = omp_get_thread_num();
+#pragma omp for schedule(static)
+      for (int i = 0; i < num_rays; ++i)
+        ray_casters[thread].castRay(*tree_, batch.sensor_origin, ray_ends[i].first, ray_ends[i].second,
+                                    free_cells[thread]);
+      ray_casters[thread].flush(free_cells[thread]);
     }
 
     tree_->unlockRead();
 
-    for (std::pair<const octomap::OcTreeKey, unsigned int>& it : *process_occupied_cells_set_)
-    {
-      free_cells1.erase(it.first);
-      free_cells2.erase(it.first);
-    }
+    for (std::size_t i = 1; i < free_cells.size(); ++i)
+      for (const std::pair<const octomap::OcTreeKey, unsigned int>& it : free_cells[i])
+        free_cells[0][it.first] += it.second;
 
-    for (const octomap::OcTreeKey& it : *process_model_cells_set_)
-    {
-      free_cells1.erase(it);
-      free_cells2.erase(it);
-    }
-    ROS_DEBUG_NAMED(LOGNAME, "Marking %lu cells as free...",
-                    (long unsigned int)(free_cells1.size() + free_cells2.size()));
+    for (const std::pair<const octomap::OcTreeKey, unsigned int>& it : batch.occupied_cells)
+      free_cells[0].erase(it.first);
+    for (const octomap::OcTreeKey& it : batch.model_cells)
+      free_cells[0].erase(it);
+    ROS_DEBUG_NAMED(LOGNAME, "Marking %lu cells as free...", (long unsigned int)free_cells[0].size());
 
     tree_->lockWrite();
 
     try
     {
       // set the logodds to the minimum for the cells that are part of the model
-      for (const octomap::OcTreeKey& it : *process_model_cells_set_)
+      for (const octomap::OcTreeKey& it : batch.model_cells)
         tree_->updateNode(it, lg_0);
 
       /* mark free cells only if not seen occupied in this cloud */
-      for (std::pair<const octomap::OcTreeKey, unsigned int>& it : free_cells1)
-        tree_->updateNode(it.first, it.second * lg_miss);
-      for (std::pair<const octomap::OcTreeKey, unsigned int>& it : free_cells2)
+      for (const std::pair<const octomap::OcTreeKey, unsigned int>& it : free_cells[0])
         tree_->updateNode(it.first, it.second * lg_miss);
+
+      if (decay_model != NO_DECAY)
+        applyDecay(batch, decay_model, decay_time);
     }
     catch (...)
     {
@@ -189,76 +258,38 @@ void LazyFreeSpaceUpdater::processThread()
     tree_->triggerUpdateCallback();
 
     ROS_DEBUG_NAMED(LOGNAME, "Marked free cells in %lf ms", (ros::WallTime::now() - start).toSec() * 1000.0);
-
-    delete process_occupied_cells_set_;
-    process_occupied_cells_set_ = nullptr;
-    delete process_model_cells_set_;
-    process_model_cells_set_ = nullptr;
   }
 }
 
 void LazyFreeSpaceUpdater::lazyUpdateThread()
 {
-  OcTreeKeyCountMap* occupied_cells_set = nullptr;
-  octomap::KeySet* model_cells_set = nullptr;
-  octomap::point3d sensor_origin;
-  unsigned int batch_size = 0;
+  std::deque<octomap::KeySet*> occupied_cells_sets;
+  std::deque<octomap::KeySet*> model_cells_sets;
+  std::deque<octomap::point3d> sensor_origins;
 
   while (running_)
   {
-    boost::unique_lock<boost::mutex> ulock(update_cell_sets_lock_);
-    while (occupied_cells_sets_.empty() && running_)
-      update_condition_.wait(ulock);
-
-    if (!running_)
-      break;
-
-    if (batch_size == 0)
     {
-      occupied_cells_set = new OcTreeKeyCountMap();
-      octomap::KeySet* s = occupied_cells_sets_.front();
-      occupied_cells_sets_.pop_front();
-      for (const octomap::OcTreeKey& it : *s)
-        (*occupied_cells_set)[it]++;
-      delete s;
-      model_cells_set = model_cells_sets_.front();
-      model_cells_sets_.pop_front();
-      sensor_origin = sensor_origins_.front();
-      sensor_origins_.pop_front();
-      batch_size++;
-    }
+      boost::unique_lock<boost::mutex> ulock(update_cell_sets_lock_);
+      while (occupied_cells_sets_.empty() && running_)
+        update_condition_.wait(ulock);
 
-    while (!occupied_cells_sets_.empty())
-    {
-      if ((sensor_origins_.front() - sensor_origin).norm() > max_sensor_delta_)
-      {
-        ROS_DEBUG_NAMED(LOGNAME, "Pushing %u sets of occupied/model cells to free cells update thread (origin changed)",
-                        batch_size);
-        pushBatchToProcess(occupied_cells_set, model_cells_set, sensor_origin);
-        batch_size = 0;
+      if (!running_)
         break;
-      }
-      sensor_origins_.pop_front();
-
-      octomap::KeySet* add_occ = occupied_cells_sets_.front();
-      for (const octomap::OcTreeKey& it : *add_occ)
-        (*occupied_cells_set)[it]++;
-      occupied_cells_sets_.pop_front();
-      delete add_occ;
-      octomap::KeySet* mod_occ = model_cells_sets_.front();
-      model_cells_set->insert(mod_occ->begin(), mod_occ->end());
-      model_cells_sets_.pop_front();
-      delete mod_occ;
-      batch_size++;
-    }
 
-    if (batch_size >= max_batch_size_)
-    {
-      ROS_DEBUG_NAMED(LOGNAME, "Pushing %u sets of occupied/model cells to free cells update thread", batch_size);
-      pushBatchToProcess(occupied_cells_set, model_cells_set, sensor_origin);
-      occupied_cells_set = nullptr;
-      batch_size = 0;
+      // take all pushed sets, so the sensor callbacks are not blocked while the sets are batched
+      occupied_cells_sets.swap(occupied_cells_sets_);
+      model_cells_sets.swap(model_cells_sets_);
+      sensor_origins.swap(sensor_origins_);
     }
+
+    ROS_DEBUG_NAMED(LOGNAME, "Batching %lu sets of occupied/model cells",
+                    (long unsigned int)occupied_cells_sets.size());
+    for (std::size_t i = 0; i < occupied_cells_sets.size(); ++i)
+      pushBatchToProcess(occupied_cells_sets[i], model_cells_sets[i], sensor_origins[i]);
+    occupied_cells_sets.clear();
+    model_cells_sets.clear();
+    sensor_origins.clear();
   }
 }
 }  // namespace occupancy_map_monitor
@@ -105,6 +105,14 @@ public:
    */
   void getDepthBuffer(float* buffer) const;
 
+  /**
+   * \brief starts an asynchronous transfer of the color and depth buffers into pixel buffer objects.
+   *
+   * The copy is queued on the GPU and returns immediately. A following getColorBuffer or getDepthBuffer call maps the
+   * pixel buffer instead of stalling on a synchronous texture read, as long as no new rendering started in between.
+   */
+  void readBuffersAsync() const;
+
   /**
    * \brief loads, compiles, links and adds GLSL shaders from files to the current OpenGL context.
    * \author Suat Gedikli (gedikli@willowgarage.com)
@@ -244,6 +252,13 @@ private:
    */
   void deleteFrameBuffers();
 
+  /**
+   * \brief copies the content of a pixel buffer object filled by readBuffersAsync into client memory
+   * \param[in] pbo handle of the pixel buffer object
+   * \param[out] buffer pointer to memory receiving width_ * height_ 32-bit values
+   */
+  void readPixelBuffer(GLuint pbo, void* buffer) const;
+
   /**
    * \brief create the OpenGL context if required. Only on context is created for each thread
    * \author Suat Gedikli (gedikli@willowgarage.com)
@@ -274,6 +289,15 @@ private:
   /** \brief handle to depth buffer*/
   GLuint depth_id_;
 
+  /** \brief handle to pixel buffer object receiving the asynchronous color buffer readback*/
+  GLuint color_pbo_id_;
+
+  /** \brief handle to pixel buffer object receiving the asynchronous depth buffer readback*/
+  GLuint depth_pbo_id_;
+
+  /** \brief whether the pixel buffer objects hold the contents of the last rendering*/
+  mutable bool pbo_valid_;
+
   /** \brief handle to program that is currently used*/
   GLuint program_;
 
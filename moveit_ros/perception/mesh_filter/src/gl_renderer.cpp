@@ -47,6 +47,7 @@
 #include <fstream>
 #include <stdexcept>
 #include <vector>
+#include <cstring>
 #include <ros/console.h>
 
 using namespace std;
@@ -58,6 +59,9 @@ mesh_filter::GLRenderer::GLRenderer(unsigned width, unsigned height, float near,
   , rbo_id_(0)
   , rgb_id_(0)
   , depth_id_(0)
+  , color_pbo_id_(0)
+  , depth_pbo_id_(0)
+  , pbo_valid_(false)
   , program_(0)
   , near_(near)
   , far_(far)
@@ -162,6 +166,16 @@ void mesh_filter::GLRenderer::initFrameBuffers()
     throw runtime_error("Couldn't create frame buffer");
 
   glBindFramebuffer(GL_FRAMEBUFFER, 0);  // Unbind our frame buffer
+
+  // both buffers are read back as 32 bits per pixel (RGBA8 labels and float depth)
+  glGenBuffers(1, &color_pbo_id_);
+  glBindBuffer(GL_PIXEL_PACK_BUFFER, color_pbo_id_);
+  glBufferData(GL_PIXEL_PACK_BUFFER, width_ * height_ * 4, nullptr, GL_STREAM_READ);
+  glGenBuffers(1, &depth_pbo_id_);
+  glBindBuffer(GL_PIXEL_PACK_BUFFER, depth_pbo_id_);
+  glBufferData(GL_PIXEL_PACK_BUFFER, width_ * height_ * 4, nullptr, GL_STREAM_READ);
+  glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+  pbo_valid_ = false;
 }
 
 void mesh_filter::GLRenderer::deleteFrameBuffers()
@@ -174,13 +188,19 @@ void mesh_filter::GLRenderer::deleteFrameBuffers()
     glDeleteTextures(1, &depth_id_);
   if (rgb_id_)
     glDeleteTextures(1, &rgb_id_);
+  if (color_pbo_id_)
+    glDeleteBuffers(1, &color_pbo_id_);
+  if (depth_pbo_id_)
+    glDeleteBuffers(1, &depth_pbo_id_);
 
-  rbo_id_ = fbo_id_ = depth_id_ = rgb_id_ = 0;
+  rbo_id_ = fbo_id_ = depth_id_ = rgb_id_ = color_pbo_id_ = depth_pbo_id_ = 0;
+  pbo_valid_ = false;
 }
 
 void mesh_filter::GLRenderer::begin() const
 {
   glPushAttrib(GL_VIEWPORT_BIT | GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT | GL_POLYGON_BIT | GL_PIXEL_MODE_BIT);
+  pbo_valid_ = false;
   glBindFramebuffer(GL_FRAMEBUFFER, fbo_id_);
   glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
   glViewport(0, 0, width_, height_);
@@ -204,6 +224,11 @@ void mesh_filter::GLRenderer::end() const
 
 void mesh_filter::GLRenderer::getColorBuffer(unsigned char* buffer) const
 {
+  if (pbo_valid_)
+  {
+    readPixelBuffer(color_pbo_id_, buffer);
+    return;
+  }
   glBindFramebuffer(GL_FRAMEBUFFER, fbo_id_);
   glBindTexture(GL_TEXTURE_2D, rgb_id_);
   glGetTexImage(GL_TEXTURE_2D, 0, GL_RGBA, GL_UNSIGNED_BYTE, buffer);
@@ -212,12 +237,46 @@ void mesh_filter::GLRenderer::getColorBuffer(unsigned char* buffer) const
 
 void mesh_filter::GLRenderer::getDepthBuffer(float* buffer) const
 {
+  if (pbo_valid_)
+  {
+    readPixelBuffer(depth_pbo_id_, buffer);
+    return;
+  }
   glBindFramebuffer(GL_FRAMEBUFFER, fbo_id_);
   glBindTexture(GL_TEXTURE_2D, depth_id_);
   glGetTexImage(GL_TEXTURE_2D, 0, GL_DEPTH_COMPONENT, GL_FLOAT, buffer);
   glBindFramebuffer(GL_FRAMEBUFFER, 0);
 }
 
+void mesh_filter::GLRenderer::readBuffersAsync() const
+{
+  // with a pixel pack buffer bound, glGetTexImage only queues the copy and the data pointer is an offset into the PBO
+  glBindFramebuffer(GL_FRAMEBUFFER, fbo_id_);
+  glBindBuffer(GL_PIXEL_PACK_BUFFER, color_pbo_id_);
+  glBindTexture(GL_TEXTURE_2D, rgb_id_);
+  glGetTexImage(GL_TEXTURE_2D, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+  glBindBuffer(GL_PIXEL_PACK_BUFFER, depth_pbo_id_);
+  glBindTexture(GL_TEXTURE_2D, depth_id_);
+  glGetTexImage(GL_TEXTURE_2D, 0, GL_DEPTH_COMPONENT, GL_FLOAT, nullptr);
+  glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+  glBindFramebuffer(GL_FRAMEBUFFER, 0);
+  pbo_valid_ = true;
+}
+
+void mesh_filter::GLRenderer::readPixelBuffer(GLuint pbo, void* buffer) const
+{
+  glBindBuffer(GL_PIXEL_PACK_BUFFER, pbo);
+  const void* data = glMapBuffer(GL_PIXEL_PACK_BUFFER, GL_READ_ONLY);
+  if (data)
+  {
+    memcpy(buffer, data, width_ * height_ * 4);
+    glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+  }
+  else
+    ROS_ERROR("Could not map pixel buffer object");
+  glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+}
+
 GLuint mesh_filter::GLRenderer::setShadersFromFile(const string& vertex_filename, const string& fragment_filename)
 {
   if (program_)
@@ -385,6 +385,10 @@ void mesh_filter::MeshFilterBase::doFilter(const void* sensor_data, const int en
   glBindTexture(GL_TEXTURE_2D, color_texture);
   glCallList(canvas_);
   depth_filter_->end();
+
+  // queue the readback of the filtered labels and depth right away, so the transfer overlaps with whatever the caller
+  // does before asking for getFilteredLabels / getFilteredDepth
+  depth_filter_->readBuffersAsync();
 }
 
 void mesh_filter::MeshFilterBase::setPaddingOffset(float offset)
@@ -0,0 +1,76 @@
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2026, PickNik LLC.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of PickNik LLC nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *********************************************************************/
+
+#pragma once
+
+#include <ros/ros.h>
+#include <octomap_msgs/Octomap.h>
+#include <moveit/occupancy_map_monitor/occupancy_map_updater.h>
+#include <moveit/occupancy_map_monitor/octree_delta.h>
+
+namespace occupancy_map_monitor
+{
+/** \brief Mirrors an octree that is published as an octree delta stream by another node, typically an
+ *  occupancy_map_server running the sensor updaters on a perception host. The robot is filtered out by that node,
+ *  so shapes are not excluded here. */
+class OcTreeDeltaUpdater : public OccupancyMapUpdater
+{
+public:
+  OcTreeDeltaUpdater();
+  ~OcTreeDeltaUpdater() override;
+
+  bool setParams(XmlRpc::XmlRpcValue& params) override;
+
+  bool initialize() override;
+  void start() override;
+  void stop() override;
+  ShapeHandle excludeShape(const shapes::ShapeConstPtr& shape) override;
+  void forgetShape(ShapeHandle handle) override;
+
+private:
+  void octreeDeltaCallback(const octomap_msgs::Octomap::ConstPtr& msg);
+
+  ros::NodeHandle root_nh_;
+  ros::Subscriber subscriber_;
+
+  /* params */
+  std::string octree_delta_topic_;
+
+  /* the last received message, kept to reuse its memory */
+  OcTreeDelta delta_;
+  /* whether all messages since the last keyframe were applied */
+  bool synchronized_;
+  std::uint32_t next_sequence_;
+};
+}  // namespace occupancy_map_monitor
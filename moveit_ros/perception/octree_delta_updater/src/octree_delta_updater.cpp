@@ -0,0 +1,148 @@
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2026, PickNik LLC.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of PickNik LLC nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *********************************************************************/
+
+#include <moveit/octree_delta_updater/octree_delta_updater.h>
+#include <moveit/occupancy_map_monitor/occupancy_map_monitor.h>
+#include <XmlRpcException.h>
+
+#include <cmath>
+
+namespace occupancy_map_monitor
+{
+static const std::string LOGNAME = "occupancy_map_monitor";
+
+OcTreeDeltaUpdater::OcTreeDeltaUpdater()
+  : OccupancyMapUpdater("OcTreeDeltaUpdater"), synchronized_(false), next_sequence_(0)
+{
+}
+
+OcTreeDeltaUpdater::~OcTreeDeltaUpdater()
+{
+  stop();
+}
+
+bool OcTreeDeltaUpdater::setParams(XmlRpc::XmlRpcValue& params)
+{
+  try
+  {
+    if (!params.hasMember("octree_delta_topic"))
+      return false;
+    octree_delta_topic_ = static_cast<const std::string&>(params["octree_delta_topic"]);
+  }
+  catch (XmlRpc::XmlRpcException& ex)
+  {
+    ROS_ERROR_STREAM_NAMED(LOGNAME, "XmlRpc Exception: " << ex.getMessage());
+    return false;
+  }
+
+  return true;
+}
+
+bool OcTreeDeltaUpdater::initialize()
+{
+  return true;
+}
+
+void OcTreeDeltaUpdater::start()
+{
+  if (subscriber_)
+    return;
+  synchronized_ = false;
+  subscriber_ = root_nh_.subscribe(octree_delta_topic_, 10, &OcTreeDeltaUpdater::octreeDeltaCallback, this);
+  ROS_INFO_NAMED(LOGNAME, "Listening to octree deltas on '%s'", octree_delta_topic_.c_str());
+}
+
+void OcTreeDeltaUpdater::stop()
+{
+  subscriber_.shutdown();
+}
+
+ShapeHandle OcTreeDeltaUpdater::excludeShape(const shapes::ShapeConstPtr& /*shape*/)
+{
+  return 0;
+}
+
+void OcTreeDeltaUpdater::forgetShape(ShapeHandle /*handle*/)
+{
+}
+
+void OcTreeDeltaUpdater::octreeDeltaCallback(const octomap_msgs::Octomap::ConstPtr& msg)
+{
+  if (std::fabs(msg->resolution - tree_->getResolution()) > 1e-9)
+  {
+    ROS_ERROR_THROTTLE_NAMED(1, LOGNAME, "Received an octree with resolution %g, but the octomap resolution is %g",
+                             msg->resolution, tree_->getResolution());
+    return;
+  }
+
+  if (monitor_->getMapFrame().empty())
+    monitor_->setMapFrame(msg->header.frame_id);
+  else if (monitor_->getMapFrame() != msg->header.frame_id)
+  {
+    ROS_ERROR_THROTTLE_NAMED(1, LOGNAME, "Received an octree in frame '%s', but the octomap frame is '%s'",
+                             msg->header.frame_id.c_str(), monitor_->getMapFrame().c_str());
+    return;
+  }
+
+  if (!decodeOcTreeDelta(*msg, delta_))
+    return;
+
+  // a delta only applies on top of all previous messages
+  if (!delta_.keyframe && (!synchronized_ || delta_.sequence != next_sequence_))
+  {
+    if (synchronized_)
+      ROS_WARN_NAMED(LOGNAME, "Missed octree delta %u. Waiting for the next keyframe.", next_sequence_);
+    synchronized_ = false;
+    return;
+  }
+
+  tree_->lockWrite();
+  try
+  {
+    applyOcTreeDelta(delta_, *tree_);
+  }
+  catch (...)
+  {
+    ROS_ERROR_NAMED(LOGNAME, "Internal error while applying octree delta");
+  }
+  tree_->unlockWrite();
+
+  synchronized_ = true;
+  next_sequence_ = delta_.sequence + 1;
+  if (delta_.keyframe)
+    monitor_->triggerFullUpdate();
+  else
+    tree_->triggerUpdateCallback();
+}
+}  // namespace occupancy_map_monitor
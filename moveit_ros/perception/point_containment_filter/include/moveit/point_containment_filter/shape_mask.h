@@ -74,6 +74,9 @@ public:
 
   void setTransformCallback(const TransformCallback& transform_callback);
 
+  /** \brief Set the number of threads maskContainment() splits the pointcloud over (default 1) */
+  void setNumThreads(unsigned int num_threads);
+
   /** \brief Compute the containment mask (INSIDE or OUTSIDE) for a given pointcloud. If a mask element is INSIDE, the
      point
       is inside the robot. The point is outside if the mask element is OUTSIDE.
@@ -116,7 +119,8 @@ protected:
 
   TransformCallback transform_callback_;
 
-  /** \brief Protects, bodies_ and bspheres_. All public methods acquire this mutex for their whole duration. */
+  /** \brief Protects bodies_, bspheres_ and the body grid. All public methods acquire this mutex for their whole
+      duration. */
   mutable boost::mutex shapes_lock_;
   std::set<SeeShape, SortBodies> bodies_;
   std::vector<bodies::BoundingSphere> bspheres_;
@@ -125,6 +129,24 @@ private:
   /** \brief Free memory. */
   void freeMemory();
 
+  /** \brief Sort the bodies into the cells of a coarse grid over the bounding sphere \e bound of all bodies */
+  void updateBodyGrid(const bodies::BoundingSphere& bound);
+
+  /** \brief Check whether a point inside the body grid is contained in one of the bodies of its cell */
+  int classifyPoint(const Eigen::Vector3d& pt) const;
+
+  unsigned int num_threads_;
+
+  /** \brief The bodies in the order of bodies_, matching bspheres_ */
+  std::vector<const bodies::Body*> body_list_;
+
+  /** \brief Coarse grid over the bounding sphere of all bodies. The bodies whose bounding spheres may overlap
+      cell i are grid_bodies_[grid_offsets_[i]] to grid_bodies_[grid_offsets_[i + 1] - 1], in the order of bodies_ */
+  Eigen::Vector3d grid_origin_;
+  double grid_inv_cell_size_;
+  std::vector<std::size_t> grid_offsets_;
+  std::vector<std::size_t> grid_bodies_;
+
   ShapeHandle next_handle_;
   ShapeHandle min_handle_;
   std::map<ShapeHandle, std::set<SeeShape, SortBodies>::iterator> used_handles_;
@@ -38,11 +38,39 @@
 #include <geometric_shapes/body_operations.h>
 #include <ros/console.h>
 #include <sensor_msgs/point_cloud2_iterator.h>
+#include <algorithm>
+#include <limits>
 
 static const std::string LOGNAME = "shape_mask";
 
+namespace
+{
+// Points are classified in blocks of this size. Their coordinates are copied into separate arrays first, so the
+// range and bounding sphere tests of a whole block vectorize.
+const int POINT_BLOCK_SIZE = 256;
+// Number of cells along each axis of the grid that looks up the bodies which may contain a point
+const int GRID_CELLS = 16;
+// Marks a point in a block that passed the range and bounding sphere tests
+const int CANDIDATE = -1;
+
+// Clamp a coordinate in cell units to the grid. NaN, which unbounded bodies produce, maps to the first cell.
+int gridCoordinate(double value)
+{
+  if (!(value > 0.0))
+    return 0;
+  if (value >= GRID_CELLS)
+    return GRID_CELLS - 1;
+  return static_cast<int>(value);
+}
+}  // namespace
+
 point_containment_filter::ShapeMask::ShapeMask(const TransformCallback& transform_callback)
-  : transform_callback_(transform_callback), next_handle_(1), min_handle_(1)
+  : transform_callback_(transform_callback)
+  , next_handle_(1)
+  , min_handle_(1)
+  , num_threads_(1)
+  , grid_origin_(Eigen::Vector3d::Zero())
+  , grid_inv_cell_size_(0.0)
 {
 }
 
@@ -64,6 +92,12 @@ void point_containment_filter::ShapeMask::setTransformCallback(const TransformCa
   transform_callback_ = transform_callback;
 }
 
+void point_containment_filter::ShapeMask::setNumThreads(unsigned int num_threads)
+{
+  boost::mutex::scoped_lock _(shapes_lock_);
+  num_threads_ = std::max(num_threads, 1u);
+}
+
 point_containment_filter::ShapeHandle point_containment_filter::ShapeMask::addShape(const shapes::ShapeConstPtr& shape,
                                                                                     double scale, double padding)
 {
@@ -114,6 +148,67 @@ void point_containment_filter::ShapeMask::removeShape(ShapeHandle handle)
     ROS_ERROR_NAMED(LOGNAME, "Unable to remove shape handle %u", handle);
 }
 
+void point_containment_filter::ShapeMask::updateBodyGrid(const bodies::BoundingSphere& bound)
+{
+  const double cell_size = std::max(2.0 * bound.radius / GRID_CELLS, std::numeric_limits<double>::epsilon());
+  grid_origin_ = bound.center - Eigen::Vector3d::Constant(bound.radius);
+  grid_inv_cell_size_ = 1.0 / cell_size;
+
+  // sort the bodies into the cells overlapped by the bounding boxes of their bounding spheres, in two passes:
+  // count the bodies per cell first, then fill the cells in body order
+  grid_offsets_.assign(GRID_CELLS * GRID_CELLS * GRID_CELLS + 1, 0);
+  for (int pass = 0; pass < 2; ++pass)
+  {
+    for (std::size_t k = 0; k < bspheres_.size(); ++k)
+    {
+      const Eigen::Vector3d lo = (bspheres_[k].center - grid_origin_).array() - bspheres_[k].radius;
+      const Eigen::Vector3d hi = (bspheres_[k].center - grid_origin_).array() + bspheres_[k].radius;
+      const int x_hi = gridCoordinate(hi.x() * grid_inv_cell_size_);
+      const int y_hi = gridCoordinate(hi.y() * grid_inv_cell_size_);
+      const int z_hi = gridCoordinate(hi.z() * grid_inv_cell_size_);
+      for (int x = gridCoordinate(lo.x() * grid_inv_cell_size_); x <= x_hi; ++x)
+        for (int y = gridCoordinate(lo.y() * grid_inv_cell_size_); y <= y_hi; ++y)
+          for (int z = gridCoordinate(lo.z() * grid_inv_cell_size_); z <= z_hi; ++z)
+          {
+            const std::size_t cell = (x * GRID_CELLS + y) * GRID_CELLS + z;
+            if (pass == 0)
+              ++grid_offsets_[cell + 1];
+            else
+              grid_bodies_[grid_offsets_[cell]++] = k;
+          }
+    }
+
+    if (pass == 0)
+    {
+      for (std::size_t i = 1; i < grid_offsets_.size(); ++i)
+        grid_offsets_[i] += grid_offsets_[i - 1];
+      grid_bodies_.resize(grid_offsets_.back());
+    }
+  }
+
+  // filling the cells advanced each offset to the start of the next cell
+  for (std::size_t i = grid_offsets_.size() - 1; i > 0; --i)
+    grid_offsets_[i] = grid_offsets_[i - 1];
+  grid_offsets_[0] = 0;
+}
+
+int point_containment_filter::ShapeMask::classifyPoint(const Eigen::Vector3d& pt) const
+{
+  const Eigen::Vector3d cell_pt = (pt - grid_origin_) * grid_inv_cell_size_;
+  const int x = gridCoordinate(cell_pt.x());
+  const int y = gridCoordinate(cell_pt.y());
+  const int z = gridCoordinate(cell_pt.z());
+  const std::size_t cell = (x * GRID_CELLS + y) * GRID_CELLS + z;
+  for (std::size_t i = grid_offsets_[cell]; i < grid_offsets_[cell + 1]; ++i)
+  {
+    const std::size_t k = grid_bodies_[i];
+    if ((bspheres_[k].center - pt).squaredNorm() <= bspheres_[k].radius * bspheres_[k].radius &&
+        body_list_[k]->containsPoint(pt))
+      return INSIDE;
+  }
+  return OUTSIDE;
+}
+
 void point_containment_filter::ShapeMask::maskContainment(const sensor_msgs::PointCloud2& data_in,
                                                           const Eigen::Vector3d& /*sensor_origin*/,
                                                           const double min_sensor_dist, const double max_sensor_dist,
@@ -129,8 +224,9 @@ void point_containment_filter::ShapeMask::maskContainment(const sensor_msgs::Poi
   {
     Eigen::Isometry3d tmp;
     bspheres_.resize(bodies_.size());
+    body_list_.resize(bodies_.size());
     std::size_t j = 0;
-    for (std::set<SeeShape>::const_iterator it = bodies_.begin(); it != bodies_.end(); ++it)
+    for (std::set<SeeShape>::const_iterator it = bodies_.begin(); it != bodies_.end(); ++it, ++j)
     {
       if (!transform_callback_(it->handle, tmp))
       {
@@ -141,37 +237,64 @@ void point_containment_filter::ShapeMask::maskContainment(const sensor_msgs::Poi
                                                                          << it->handle);
       }
       else
-      {
         it->body->setPose(tmp);
-        it->body->computeBoundingSphere(bspheres_[j++]);
-      }
+      // a body without a transform is still checked at its last pose
+      it->body->computeBoundingSphere(bspheres_[j]);
+      body_list_[j] = it->body;
     }
 
     // compute a sphere that bounds the entire robot
     bodies::BoundingSphere bound;
     bodies::mergeBoundingSpheres(bspheres_, bound);
     const double radius_squared = bound.radius * bound.radius;
+    updateBodyGrid(bound);
 
-    // we now decide which points we keep
-    sensor_msgs::PointCloud2ConstIterator<float> iter_x(data_in, "x");
-    sensor_msgs::PointCloud2ConstIterator<float> iter_y(data_in, "y");
-    sensor_msgs::PointCloud2ConstIterator<float> iter_z(data_in, "z");
+    // the range test compares squared distances
+    const double min_dist_squared = min_sensor_dist > 0.0 ? min_sensor_dist * min_sensor_dist : 0.0;
+    const double max_dist_squared = max_sensor_dist >= 0.0 ? max_sensor_dist * max_sensor_dist : -1.0;
+    const int num_blocks = (np + POINT_BLOCK_SIZE - 1) / POINT_BLOCK_SIZE;
 
-    // Cloud iterators are not incremented in the for loop, because of the pragma
-    // Comment out below parallelization as it can result in very high CPU consumption
-    //#pragma omp parallel for schedule(dynamic)
-    for (int i = 0; i < (int)np; ++i)
+    // The blocks are statically split into one contiguous range per thread, as the per-point work is too small to
+    // be worth balancing dynamically
+#pragma omp parallel num_threads(num_threads_)
     {
-      Eigen::Vector3d pt = Eigen::Vector3d(*(iter_x + i), *(iter_y + i), *(iter_z + i));
-      double d = pt.norm();
-      int out = OUTSIDE;
-      if (d < min_sensor_dist || d > max_sensor_dist)
-        out = CLIP;
-      else if ((bound.center - pt).squaredNorm() < radius_squared)
-        for (std::set<SeeShape>::const_iterator it = bodies_.begin(); it != bodies_.end() && out == OUTSIDE; ++it)
-          if (it->body->containsPoint(pt))
-            out = INSIDE;
-      mask[i] = out;
+      sensor_msgs::PointCloud2ConstIterator<float> iter_x(data_in, "x");
+      sensor_msgs::PointCloud2ConstIterator<float> iter_y(data_in, "y");
+      sensor_msgs::PointCloud2ConstIterator<float> iter_z(data_in, "z");
+      double x[POINT_BLOCK_SIZE], y[POINT_BLOCK_SIZE], z[POINT_BLOCK_SIZE];
+
+#pragma omp for schedule(static)
+      for (int block = 0; block < num_blocks; ++block)
+      {
+        const int begin = block * POINT_BLOCK_SIZE;
+        const int size = std::min<int>(POINT_BLOCK_SIZE, np - begin);
+        int* const block_mask = mask.data() + begin;
+
+        for (int i = 0; i < size; ++i)
+        {
+          x[i] = *(iter_x + (begin + i));
+          y[i] = *(iter_y + (begin + i));
+          z[i] = *(iter_z + (begin + i));
+        }
+
+        // points out of the sensor range are clipped, points outside the sphere bounding all bodies are outside
+        for (int i = 0; i < size; ++i)
+        {
+          const double d_squared = x[i] * x[i] + y[i] * y[i] + z[i] * z[i];
+          const double dx = x[i] - bound.center.x();
+          const double dy = y[i] - bound.center.y();
+          const double dz = z[i] - bound.center.z();
+          const bool near = dx * dx + dy * dy + dz * dz < radius_squared;
+          block_mask[i] = (d_squared < min_dist_squared || d_squared > max_dist_squared) ?
+                              (int)CLIP :
+                              (near ? CANDIDATE : (int)OUTSIDE);
+        }
+
+        // only the remaining points are checked against the bodies that may contain them
+        for (int i = 0; i < size; ++i)
+          if (block_mask[i] == CANDIDATE)
+            block_mask[i] = classifyPoint(Eigen::Vector3d(x[i], y[i], z[i]));
+      }
     }
   }
 }
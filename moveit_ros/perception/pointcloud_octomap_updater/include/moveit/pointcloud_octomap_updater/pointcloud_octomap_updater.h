@@ -41,6 +41,7 @@
 #include <tf2_ros/message_filter.h>
 #include <message_filters/subscriber.h>
 #include <sensor_msgs/PointCloud2.h>
+#include <moveit/occupancy_map_monitor/coherent_ray_caster.h>
 #include <moveit/occupancy_map_monitor/occupancy_map_updater.h>
 #include <moveit/point_containment_filter/shape_mask.h>
 
@@ -86,6 +87,7 @@ private:
   double max_range_;
   unsigned int point_subsample_;
   double max_update_rate_;
+  unsigned int num_threads_;
   std::string filtered_cloud_topic_;
   std::string ns_;
   ros::Publisher filtered_cloud_publisher_;
@@ -93,9 +95,11 @@ private:
   message_filters::Subscriber<sensor_msgs::PointCloud2>* point_cloud_subscriber_;
   tf2_ros::MessageFilter<sensor_msgs::PointCloud2>* point_cloud_filter_;
 
-  /* used to store all cells in the map which a given ray passes through during raycasting.
-     we cache this here because it dynamically pre-allocates a lot of memory in its contsructor */
-  octomap::KeyRay key_ray_;
+  /* ray casters, one per thread.
+     we cache these here because they dynamically pre-allocate a lot of memory in their constructor */
+  std::vector<CoherentRayCaster> ray_casters_;
+  /* the end points of the rays cast for the current cloud */
+  std::vector<octomap::OcTreeKey> ray_end_keys_;
 
   std::unique_ptr<point_containment_filter::ShapeMask> shape_mask_;
   std::vector<int> mask_;
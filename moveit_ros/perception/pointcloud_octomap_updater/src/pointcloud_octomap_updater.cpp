@@ -44,10 +44,24 @@
 #include <XmlRpcException.h>
 
 #include <memory>
+#include <omp.h>
 
 namespace occupancy_map_monitor
 {
 static const std::string LOGNAME = "occupancy_map_monitor";
+// Rays are handed out to the threads in chunks of this size, as their lengths vary a lot
+static const int RAY_CHUNK_SIZE = 1024;
+
+namespace
+{
+// Add the cells of all sets to the first one
+void mergeKeySets(std::vector<octomap::KeySet>& sets)
+{
+  for (std::size_t i = 1; i < sets.size(); ++i)
+    sets[0].insert(sets[i].begin(), sets[i].end());
+}
+}  // namespace
+
 PointCloudOctomapUpdater::PointCloudOctomapUpdater()
   : OccupancyMapUpdater("PointCloudUpdater")
   , private_nh_("~")
@@ -56,6 +70,7 @@ PointCloudOctomapUpdater::PointCloudOctomapUpdater()
   , max_range_(std::numeric_limits<double>::infinity())
   , point_subsample_(1)
   , max_update_rate_(0)
+  , num_threads_(1)
   , point_cloud_subscriber_(nullptr)
   , point_cloud_filter_(nullptr)
 {
@@ -80,6 +95,13 @@ bool PointCloudOctomapUpdater::setParams(XmlRpc::XmlRpcValue& params)
     readXmlParam(params, "point_subsample", &point_subsample_);
     if (params.hasMember("max_update_rate"))
       readXmlParam(params, "max_update_rate", &max_update_rate_);
+    if (params.hasMember("num_threads"))
+      readXmlParam(params, "num_threads", &num_threads_);
+    if (num_threads_ == 0)
+    {
+      ROS_ERROR_NAMED(LOGNAME, "num_threads must be at least 1");
+      return false;
+    }
     if (params.hasMember("filtered_cloud_topic"))
       filtered_cloud_topic_ = static_cast<const std::string&>(params["filtered_cloud_topic"]);
     if (params.hasMember("ns"))
@@ -99,6 +121,7 @@ bool PointCloudOctomapUpdater::initialize()
   tf_buffer_ = std::make_shared<tf2_ros::Buffer>();
   tf_listener_ = std::make_shared<tf2_ros::TransformListener>(*tf_buffer_, root_nh_);
   shape_mask_ = std::make_unique<point_containment_filter::ShapeMask>();
+  shape_mask_->setNumThreads(num_threads_);
   shape_mask_->setTransformCallback(
       [this](ShapeHandle shape, Eigen::Isometry3d& tf) { return getShapeTransform(shape, tf); });
 
@@ -230,101 +253,113 @@ void PointCloudOctomapUpdater::cloudMsgCallback(const sensor_msgs::PointCloud2::
   shape_mask_->maskContainment(*cloud_msg, sensor_origin_eigen, 0.0, max_range_, mask_);
   updateMask(*cloud_msg, sensor_origin_eigen, mask_);
 
-  octomap::KeySet free_cells, occupied_cells, model_cells, clip_cells;
-  std::unique_ptr<sensor_msgs::PointCloud2> filtered_cloud;
+  const int num_threads = num_threads_;
+  if (ray_casters_.size() < num_threads_)
+    ray_casters_.resize(num_threads_);
 
-  // We only use these iterators if we are creating a filtered_cloud for
-  // publishing. We cannot default construct these, so we use unique_ptr's
-  // to defer construction
-  std::unique_ptr<sensor_msgs::PointCloud2Iterator<float>> iter_filtered_x;
-  std::unique_ptr<sensor_msgs::PointCloud2Iterator<float>> iter_filtered_y;
-  std::unique_ptr<sensor_msgs::PointCloud2Iterator<float>> iter_filtered_z;
+  // The cells are collected per thread and merged afterwards
+  std::vector<octomap::KeySet> thread_occupied_cells(num_threads), thread_model_cells(num_threads),
+      thread_clip_cells(num_threads), thread_free_cells(num_threads);
+  std::unique_ptr<sensor_msgs::PointCloud2> filtered_cloud;
+  std::vector<std::vector<float>> thread_filtered_points;
 
   if (!filtered_cloud_topic_.empty())
   {
     filtered_cloud = std::make_unique<sensor_msgs::PointCloud2>();
     filtered_cloud->header = cloud_msg->header;
-    sensor_msgs::PointCloud2Modifier pcd_modifier(*filtered_cloud);
-    pcd_modifier.setPointCloud2FieldsByString(1, "xyz");
-    pcd_modifier.resize(cloud_msg->width * cloud_msg->height);
-
-    // we have created a filtered_out, so we can create the iterators now
-    iter_filtered_x = std::make_unique<sensor_msgs::PointCloud2Iterator<float>>(*filtered_cloud, "x");
-    iter_filtered_y = std::make_unique<sensor_msgs::PointCloud2Iterator<float>>(*filtered_cloud, "y");
-    iter_filtered_z = std::make_unique<sensor_msgs::PointCloud2Iterator<float>>(*filtered_cloud, "z");
+    thread_filtered_points.resize(num_threads);
   }
-  size_t filtered_cloud_size = 0;
+
+  const int num_rows = (cloud_msg->height + point_subsample_ - 1) / point_subsample_;
 
   tree_->lockRead();
 
   try
   {
-    /* do ray tracing to find which cells this point cloud indicates should be free, and which it indicates
-     * should be occupied */
-    for (unsigned int row = 0; row < cloud_msg->height; row += point_subsample_)
+    /* sort the points into cells that are occupied, on the robot model or clipped, in parallel over blocks of rows.
+       The blocks are assigned in thread order, which keeps the filtered cloud in the order of the input cloud */
+#pragma omp parallel num_threads(num_threads)
     {
-      unsigned int row_c = row * cloud_msg->width;
-      sensor_msgs::PointCloud2ConstIterator<float> pt_iter(*cloud_msg, "x");
-      // set iterator to point at start of the current row
-      pt_iter += row_c;
+      const int thread = omp_get_thread_num();
+      octomap::KeySet& occupied_cells = thread_occupied_cells[thread];
+      octomap::KeySet& model_cells = thread_model_cells[thread];
+      octomap::KeySet& clip_cells = thread_clip_cells[thread];
 
-      for (unsigned int col = 0; col < cloud_msg->width; col += point_subsample_, pt_iter += point_subsample_)
+#pragma omp for schedule(static)
+      for (int row_index = 0; row_index < num_rows; ++row_index)
       {
-        // if (mask_[row_c + col] == point_containment_filter::ShapeMask::CLIP)
-        //  continue;
+        unsigned int row_c = row_index * point_subsample_ * cloud_msg->width;
+        sensor_msgs::PointCloud2ConstIterator<float> pt_iter(*cloud_msg, "x");
+        // set iterator to point at start of the current row
+        pt_iter += row_c;
 
-        /* check for NaN */
-        if (!std::isnan(pt_iter[0]) && !std::isnan(pt_iter[1]) && !std::isnan(pt_iter[2]))
+        for (unsigned int col = 0; col < cloud_msg->width; col += point_subsample_, pt_iter += point_subsample_)
         {
-          /* occupied cell at ray endpoint if ray is shorter than max range and this point
-             isn't on a part of the robot*/
-          if (mask_[row_c + col] == point_containment_filter::ShapeMask::INSIDE)
-          {
-            // transform to map frame
-            tf2::Vector3 point_tf = map_h_sensor * tf2::Vector3(pt_iter[0], pt_iter[1], pt_iter[2]);
-            model_cells.insert(tree_->coordToKey(point_tf.getX(), point_tf.getY(), point_tf.getZ()));
-          }
-          else if (mask_[row_c + col] == point_containment_filter::ShapeMask::CLIP)
-          {
-            tf2::Vector3 clipped_point_tf =
-                map_h_sensor * (tf2::Vector3(pt_iter[0], pt_iter[1], pt_iter[2]).normalize() * max_range_);
-            clip_cells.insert(
-                tree_->coordToKey(clipped_point_tf.getX(), clipped_point_tf.getY(), clipped_point_tf.getZ()));
-          }
-          else
+          // if (mask_[row_c + col] == point_containment_filter::ShapeMask::CLIP)
+          //  continue;
+
+          /* check for NaN */
+          if (!std::isnan(pt_iter[0]) && !std::isnan(pt_iter[1]) && !std::isnan(pt_iter[2]))
           {
-            tf2::Vector3 point_tf = map_h_sensor * tf2::Vector3(pt_iter[0], pt_iter[1], pt_iter[2]);
-            occupied_cells.insert(tree_->coordToKey(point_tf.getX(), point_tf.getY(), point_tf.getZ()));
-            // build list of valid points if we want to publish them
-            if (filtered_cloud)
+            /* occupied cell at ray endpoint if ray is shorter than max range and this point
+               isn't on a part of the robot*/
+            if (mask_[row_c + col] == point_containment_filter::ShapeMask::INSIDE)
+            {
+              // transform to map frame
+              tf2::Vector3 point_tf = map_h_sensor * tf2::Vector3(pt_iter[0], pt_iter[1], pt_iter[2]);
+              model_cells.insert(tree_->coordToKey(point_tf.getX(), point_tf.getY(), point_tf.getZ()));
+            }
+            else if (mask_[row_c + col] == point_containment_filter::ShapeMask::CLIP)
             {
-              **iter_filtered_x = pt_iter[0];
-              **iter_filtered_y = pt_iter[1];
-              **iter_filtered_z = pt_iter[2];
-              ++filtered_cloud_size;
-              ++*iter_filtered_x;
-              ++*iter_filtered_y;
-              ++*iter_filtered_z;
+              tf2::Vector3 clipped_point_tf =
+                  map_h_sensor * (tf2::Vector3(pt_iter[0], pt_iter[1], pt_iter[2]).normalize() * max_range_);
+              clip_cells.insert(
+                  tree_->coordToKey(clipped_point_tf.getX(), clipped_point_tf.getY(), clipped_point_tf.getZ()));
+            }
+            else
+            {
+              tf2::Vector3 point_tf = map_h_sensor * tf2::Vector3(pt_iter[0], pt_iter[1], pt_iter[2]);
+              occupied_cells.insert(tree_->coordToKey(point_tf.getX(), point_tf.getY(), point_tf.getZ()));
+              // build list of valid points if we want to publish them
+              if (filtered_cloud)
+              {
+                std::vector<float>& filtered_points = thread_filtered_points[thread];
+                filtered_points.push_back(pt_iter[0]);
+                filtered_points.push_back(pt_iter[1]);
+                filtered_points.push_back(pt_iter[2]);
+              }
             }
           }
         }
       }
     }
 
-    /* compute the free cells along each ray that ends at an occupied cell */
-    for (const octomap::OcTreeKey& occupied_cell : occupied_cells)
-      if (tree_->computeRayKeys(sensor_origin, tree_->keyToCoord(occupied_cell), key_ray_))
-        free_cells.insert(key_ray_.begin(), key_ray_.end());
+    mergeKeySets(thread_occupied_cells);
+    mergeKeySets(thread_model_cells);
+    mergeKeySets(thread_clip_cells);
 
-    /* compute the free cells along each ray that ends at a model cell */
-    for (const octomap::OcTreeKey& model_cell : model_cells)
-      if (tree_->computeRayKeys(sensor_origin, tree_->keyToCoord(model_cell), key_ray_))
-        free_cells.insert(key_ray_.begin(), key_ray_.end());
+    /* compute the free cells along each ray that ends at an occupied, model or clipped cell, in parallel.
+       One ray is cast per cell, and neighboring rays are cast one after the other to share their work */
+    ray_end_keys_.clear();
+    ray_end_keys_.insert(ray_end_keys_.end(), thread_occupied_cells[0].begin(), thread_occupied_cells[0].end());
+    ray_end_keys_.insert(ray_end_keys_.end(), thread_model_cells[0].begin(), thread_model_cells[0].end());
+    ray_end_keys_.insert(ray_end_keys_.end(), thread_clip_cells[0].begin(), thread_clip_cells[0].end());
+    sortRayEndsByDirection(*tree_, sensor_origin, ray_end_keys_);
+    const int num_rays = ray_end_keys_.size();
 
-    /* compute the free cells along each ray that ends at a clipped cell */
-    for (const octomap::OcTreeKey& clip_cell : clip_cells)
-      if (tree_->computeRayKeys(sensor_origin, tree_->keyToCoord(clip_cell), key_ray_))
-        free_cells.insert(key_ray_.begin(), key_ray_.end());
+#pragma omp parallel num_threads(num_threads)
+    {
+      const int thread = omp_get_thread_num();
+      CoherentRayCaster& ray_caster = ray_casters_[thread];
+      octomap::KeySet& free_cells = thread_free_cells[thread];
+      ray_caster.reset();
+
+#pragma omp for schedule(dynamic, RAY_CHUNK_SIZE)
+      for (int i = 0; i < num_rays; ++i)
+        ray_caster.castRay(*tree_, sensor_origin, ray_end_keys_[i], free_cells);
+    }
+
+    mergeKeySets(thread_free_cells);
   }
   catch (...)
   {
@@ -334,6 +369,10 @@ void PointCloudOctomapUpdater::cloudMsgCallback(const sensor_msgs::PointCloud2::
 
   tree_->unlockRead();
 
+  octomap::KeySet& free_cells = thread_free_cells[0];
+  octomap::KeySet& occupied_cells = thread_occupied_cells[0];
+  const octomap::KeySet& model_cells = thread_model_cells[0];
+
   /* cells that overlap with the model are not occupied */
   for (const octomap::OcTreeKey& model_cell : model_cells)
     occupied_cells.erase(model_cell);
@@ -369,8 +408,21 @@ void PointCloudOctomapUpdater::cloudMsgCallback(const sensor_msgs::PointCloud2::
 
   if (filtered_cloud)
   {
+    std::size_t filtered_cloud_size = 0;
+    for (const std::vector<float>& points : thread_filtered_points)
+      filtered_cloud_size += points.size() / 3;
+
     sensor_msgs::PointCloud2Modifier pcd_modifier(*filtered_cloud);
+    pcd_modifier.setPointCloud2FieldsByString(1, "xyz");
     pcd_modifier.resize(filtered_cloud_size);
+    sensor_msgs::PointCloud2Iterator<float> iter_filtered(*filtered_cloud, "x");
+    for (const std::vector<float>& points : thread_filtered_points)
+      for (std::size_t i = 0; i < points.size(); i += 3, ++iter_filtered)
+      {
+        iter_filtered[0] = points[i];
+        iter_filtered[1] = points[i + 1];
+        iter_filtered[2] = points[i + 2];
+      }
     filtered_cloud_publisher_.publish(*filtered_cloud);
   }
 }
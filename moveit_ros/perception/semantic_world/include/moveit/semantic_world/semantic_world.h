@@ -117,6 +117,10 @@ public:
 
   void clear();
 
+  /**
+   * @brief Publish the current tables as collision objects in a single planning scene diff. Tables whose geometry
+   * did not change since the last call are left untouched, tables that disappeared are removed.
+   */
   bool addTablesToCollisionWorld();
 
   visualization_msgs::MarkerArray getPlaceLocationsMarker(const std::vector<geometry_msgs::PoseStamped>& poses) const;
@@ -133,6 +137,22 @@ public:
                             double min_distance_from_edge = 0.0, double min_vertical_offset = 0.0) const;
 
 private:
+  /** @brief Rasterized contour of a table in its own frame, used for containment queries */
+  struct TableContour;
+  using TableContourConstPtr = std::shared_ptr<const TableContour>;
+
+  TableContourConstPtr computeTableContour(const object_recognition_msgs::Table& table) const;
+
+  bool isInsideTableContour(const geometry_msgs::Pose& pose, const object_recognition_msgs::Table& table,
+                            const TableContour& contour, double min_distance_from_edge,
+                            double min_vertical_offset) const;
+
+  std::vector<geometry_msgs::PoseStamped> generatePlacePoses(const object_recognition_msgs::Table& table,
+                                                             const TableContour& contour, double resolution,
+                                                             double height_above_table, double delta_height,
+                                                             unsigned int num_heights,
+                                                             double min_distance_from_edge) const;
+
   shapes::Mesh* createSolidMeshFromPlanarPolygon(const shapes::Mesh& polygon, double thickness) const;
 
   shapes::Mesh* orientPlanarPolygon(const shapes::Mesh& polygon) const;
@@ -151,6 +171,9 @@ private:
 
   std::map<std::string, object_recognition_msgs::Table> current_tables_in_collision_world_;
 
+  /// contours of the tables in current_tables_in_collision_world_, computed once when a table is added
+  std::map<std::string, TableContourConstPtr> table_contours_;
+
   //  boost::mutex table_lock_;
 
   ros::Subscriber table_subscriber_;
@@ -50,11 +50,111 @@
 #include <tf2_eigen/tf2_eigen.h>
 #include <Eigen/Geometry>
 
+#include <set>
+
 namespace moveit
 {
 namespace semantic_world
 {
 static const std::string LOGNAME = "semantic_world";
+static const int SCALE_FACTOR = 100;  // pixels per meter of the rasterized table contours
+static const int CONTOUR_MARGIN = 5;  // pixels by which a rasterized contour may extend beyond the convex hull
+
+struct SemanticWorld::TableContour
+{
+  // bounds of the convex hull in the table frame
+  double x_min, x_max, y_min, y_max;
+  // outline in pixels, relative to (x_min, y_min)
+  std::vector<cv::Point> contour;
+};
+
+namespace
+{
+bool samePoint(const geometry_msgs::Point& a, const geometry_msgs::Point& b)
+{
+  return a.x == b.x && a.y == b.y && a.z == b.z;
+}
+
+bool sameTableGeometry(const object_recognition_msgs::Table& a, const object_recognition_msgs::Table& b)
+{
+  const geometry_msgs::Quaternion& qa = a.pose.orientation;
+  const geometry_msgs::Quaternion& qb = b.pose.orientation;
+  return a.header.frame_id == b.header.frame_id && samePoint(a.pose.position, b.pose.position) && qa.x == qb.x &&
+         qa.y == qb.y && qa.z == qb.z && qa.w == qb.w &&
+         std::equal(a.convex_hull.begin(), a.convex_hull.end(), b.convex_hull.begin(), b.convex_hull.end(), samePoint);
+}
+
+bool computePlacementClearance(const shapes::ShapeConstPtr& object_shape,
+                               const geometry_msgs::Quaternion& object_orientation, double& min_distance_from_edge,
+                               double& height_above_table)
+{
+  if (object_shape->type != shapes::MESH && object_shape->type != shapes::SPHERE && object_shape->type != shapes::BOX &&
+      object_shape->type != shapes::CONE)
+  {
+    return false;
+  }
+
+  double x_min(std::numeric_limits<double>::max()), x_max(-std::numeric_limits<double>::max());
+  double y_min(std::numeric_limits<double>::max()), y_max(-std::numeric_limits<double>::max());
+  double z_min(std::numeric_limits<double>::max()), z_max(-std::numeric_limits<double>::max());
+
+  Eigen::Quaterniond rotation(object_orientation.x, object_orientation.y, object_orientation.z, object_orientation.w);
+  Eigen::Isometry3d object_pose(rotation);
+  min_distance_from_edge = 0;
+  height_above_table = 0;
+
+  if (object_shape->type == shapes::MESH)
+  {
+    const shapes::Mesh* mesh = static_cast<const shapes::Mesh*>(object_shape.get());
+
+    for (std::size_t i = 0; i < mesh->vertex_count; ++i)
+    {
+      Eigen::Vector3d position(mesh->vertices[3 * i], mesh->vertices[3 * i + 1], mesh->vertices[3 * i + 2]);
+      position = object_pose * position;
+
+      if (x_min > position.x())
+        x_min = position.x();
+      if (x_max < position.x())
+        x_max = position.x();
+      if (y_min > position.y())
+        y_min = position.y();
+      if (y_max < position.y())
+        y_max = position.y();
+      if (z_min > position.z())
+        z_min = position.z();
+      if (z_max < position.z())
+        z_max = position.z();
+    }
+    min_distance_from_edge = 0.5 * std::max<double>(fabs(x_max - x_min), fabs(y_max - y_min));
+    height_above_table = -z_min;
+  }
+  else if (object_shape->type == shapes::BOX)  // assuming box is being kept down upright
+  {
+    const shapes::Box* box = static_cast<const shapes::Box*>(object_shape.get());
+    min_distance_from_edge = std::max<double>(fabs(box->size[0]), fabs(box->size[1])) / 2.0;
+    height_above_table = fabs(box->size[2]) / 2.0;
+  }
+  else if (object_shape->type == shapes::SPHERE)
+  {
+    const shapes::Sphere* sphere = static_cast<const shapes::Sphere*>(object_shape.get());
+    min_distance_from_edge = sphere->radius;
+    height_above_table = -sphere->radius;
+  }
+  else if (object_shape->type == shapes::CYLINDER)  // assuming cylinder is being kept down upright
+  {
+    const shapes::Cylinder* cylinder = static_cast<const shapes::Cylinder*>(object_shape.get());
+    min_distance_from_edge = cylinder->radius;
+    height_above_table = cylinder->length / 2.0;
+  }
+  else if (object_shape->type == shapes::CONE)  // assuming cone is being kept down upright
+  {
+    const shapes::Cone* cone = static_cast<const shapes::Cone*>(object_shape.get());
+    min_distance_from_edge = cone->radius;
+    height_above_table = cone->length / 2.0;
+  }
+  return true;
+}
+}  // namespace
 
 SemanticWorld::SemanticWorld(const planning_scene::PlanningSceneConstPtr& planning_scene)
   : planning_scene_(planning_scene)
@@ -98,39 +198,40 @@ bool SemanticWorld::addTablesToCollisionWorld()
   moveit_msgs::PlanningScene planning_scene;
   planning_scene.is_diff = true;
 
-  // Remove the existing tables
-  std::map<std::string, object_recognition_msgs::Table>::iterator it;
-  for (it = current_tables_in_collision_world_.begin(); it != current_tables_in_collision_world_.end(); ++it)
-  {
-    moveit_msgs::CollisionObject co;
-    co.id = it->first;
-    co.operation = moveit_msgs::CollisionObject::REMOVE;
-    planning_scene.world.collision_objects.push_back(co);
-    //    collision_object_publisher_.publish(co);
-  }
+  std::map<std::string, object_recognition_msgs::Table> tables;
+  std::map<std::string, TableContourConstPtr> contours;
+  std::set<std::string> in_world;
+  std::vector<moveit_msgs::CollisionObject> added;
 
-  planning_scene_diff_publisher_.publish(planning_scene);
-  planning_scene.world.collision_objects.clear();
-  current_tables_in_collision_world_.clear();
-  // Add the new tables
+  // Add the new tables; ADD replaces an existing object, and tables that did not move are kept as they are
   for (std::size_t i = 0; i < table_array_.tables.size(); ++i)
   {
-    moveit_msgs::CollisionObject co;
-    std::stringstream ss;
-    ss << "table_" << i;
-    co.id = ss.str();
-    current_tables_in_collision_world_[co.id] = table_array_.tables[i];
-    co.operation = moveit_msgs::CollisionObject::ADD;
+    const object_recognition_msgs::Table& table = table_array_.tables[i];
+    const std::string id = "table_" + std::to_string(i);
+    tables[id] = table;
 
-    const std::vector<geometry_msgs::Point>& convex_hull = table_array_.tables[i].convex_hull;
+    std::map<std::string, object_recognition_msgs::Table>::const_iterator previous =
+        current_tables_in_collision_world_.find(id);
+    if (previous != current_tables_in_collision_world_.end() && sameTableGeometry(previous->second, table))
+    {
+      contours[id] = table_contours_[id];
+      in_world.insert(id);
+      continue;
+    }
+    contours[id] = computeTableContour(table);
+
+    const std::vector<geometry_msgs::Point>& convex_hull = table.convex_hull;
+    if (convex_hull.size() < 3)
+      continue;
 
+    // triangulate the convex hull as a fan around its first vertex
     EigenSTL::vector_Vector3d vertices(convex_hull.size());
     std::vector<unsigned int> triangles((vertices.size() - 2) * 3);
     for (unsigned int j = 0; j < convex_hull.size(); ++j)
       vertices[j] = Eigen::Vector3d(convex_hull[j].x, convex_hull[j].y, convex_hull[j].z);
-    for (unsigned int j = 1; j < triangles.size() - 1; ++j)
+    for (unsigned int j = 1; j + 1 < vertices.size(); ++j)
     {
-      unsigned int i3 = j * 3;
+      unsigned int i3 = (j - 1) * 3;
       triangles[i3++] = 0;
       triangles[i3++] = j;
       triangles[i3] = j + 1;
@@ -158,15 +259,36 @@ bool SemanticWorld::addTablesToCollisionWorld()
 
     const shape_msgs::Mesh& table_shape_msg_mesh = boost::get<shape_msgs::Mesh>(table_shape_msg);
 
+    moveit_msgs::CollisionObject co;
+    co.id = id;
+    co.operation = moveit_msgs::CollisionObject::ADD;
     co.meshes.push_back(table_shape_msg_mesh);
-    co.mesh_poses.push_back(table_array_.tables[i].pose);
-    co.header = table_array_.tables[i].header;
-    planning_scene.world.collision_objects.push_back(co);
-    //    collision_object_publisher_.publish(co);
+    co.mesh_poses.push_back(table.pose);
+    co.header = table.header;
+    added.push_back(co);
+    in_world.insert(id);
     delete table_shape;
     delete table_mesh_solid;
   }
-  planning_scene_diff_publisher_.publish(planning_scene);
+
+  // Remove the existing tables that are gone, all in the same diff
+  std::map<std::string, object_recognition_msgs::Table>::iterator it;
+  for (it = current_tables_in_collision_world_.begin(); it != current_tables_in_collision_world_.end(); ++it)
+  {
+    if (in_world.count(it->first))
+      continue;
+    moveit_msgs::CollisionObject co;
+    co.id = it->first;
+    co.operation = moveit_msgs::CollisionObject::REMOVE;
+    planning_scene.world.collision_objects.push_back(co);
+  }
+  planning_scene.world.collision_objects.insert(planning_scene.world.collision_objects.end(), added.begin(),
+                                                added.end());
+
+  current_tables_in_collision_world_.swap(tables);
+  table_contours_.swap(contours);
+  if (!planning_scene.world.collision_objects.empty())
+    planning_scene_diff_publisher_.publish(planning_scene);
   return true;
 }
 
@@ -208,6 +330,7 @@ void SemanticWorld::clear()
 {
   table_array_.tables.clear();
   current_tables_in_collision_world_.clear();
+  table_contours_.clear();
 }
 
 std::vector<geometry_msgs::PoseStamped>
@@ -215,14 +338,18 @@ SemanticWorld::generatePlacePoses(const std::string& table_name, const shapes::S
                                   const geometry_msgs::Quaternion& object_orientation, double resolution,
                                   double delta_height, unsigned int num_heights) const
 {
-  object_recognition_msgs::Table chosen_table;
   std::map<std::string, object_recognition_msgs::Table>::const_iterator it =
       current_tables_in_collision_world_.find(table_name);
 
   if (it != current_tables_in_collision_world_.end())
   {
-    chosen_table = it->second;
-    return generatePlacePoses(chosen_table, object_shape, object_orientation, resolution, delta_height, num_heights);
+    double min_distance_from_edge, height_above_table;
+    const TableContourConstPtr& contour = table_contours_.at(table_name);
+    if (!contour ||
+        !computePlacementClearance(object_shape, object_orientation, min_distance_from_edge, height_above_table))
+      return std::vector<geometry_msgs::PoseStamped>();
+    return generatePlacePoses(it->second, *contour, resolution, height_above_table, delta_height, num_heights,
+                              min_distance_from_edge);
   }
 
   std::vector<geometry_msgs::PoseStamped> place_poses;
@@ -236,71 +363,9 @@ SemanticWorld::generatePlacePoses(const object_recognition_msgs::Table& chosen_t
                                   const geometry_msgs::Quaternion& object_orientation, double resolution,
                                   double delta_height, unsigned int num_heights) const
 {
-  std::vector<geometry_msgs::PoseStamped> place_poses;
-  if (object_shape->type != shapes::MESH && object_shape->type != shapes::SPHERE && object_shape->type != shapes::BOX &&
-      object_shape->type != shapes::CONE)
-  {
-    return place_poses;
-  }
-
-  double x_min(std::numeric_limits<double>::max()), x_max(-std::numeric_limits<double>::max());
-  double y_min(std::numeric_limits<double>::max()), y_max(-std::numeric_limits<double>::max());
-  double z_min(std::numeric_limits<double>::max()), z_max(-std::numeric_limits<double>::max());
-
-  Eigen::Quaterniond rotation(object_orientation.x, object_orientation.y, object_orientation.z, object_orientation.w);
-  Eigen::Isometry3d object_pose(rotation);
-  double min_distance_from_edge = 0;
-  double height_above_table = 0;
-
-  if (object_shape->type == shapes::MESH)
-  {
-    const shapes::Mesh* mesh = static_cast<const shapes::Mesh*>(object_shape.get());
-
-    for (std::size_t i = 0; i < mesh->vertex_count; ++i)
-    {
-      Eigen::Vector3d position(mesh->vertices[3 * i], mesh->vertices[3 * i + 1], mesh->vertices[3 * i + 2]);
-      position = object_pose * position;
-
-      if (x_min > position.x())
-        x_min = position.x();
-      if (x_max < position.x())
-        x_max = position.x();
-      if (y_min > position.y())
-        y_min = position.y();
-      if (y_max < position.y())
-        y_max = position.y();
-      if (z_min > position.z())
-        z_min = position.z();
-      if (z_max < position.z())
-        z_max = position.z();
-    }
-    min_distance_from_edge = 0.5 * std::max<double>(fabs(x_max - x_min), fabs(y_max - y_min));
-    height_above_table = -z_min;
-  }
-  else if (object_shape->type == shapes::BOX)  // assuming box is being kept down upright
-  {
-    const shapes::Box* box = static_cast<const shapes::Box*>(object_shape.get());
-    min_distance_from_edge = std::max<double>(fabs(box->size[0]), fabs(box->size[1])) / 2.0;
-    height_above_table = fabs(box->size[2]) / 2.0;
-  }
-  else if (object_shape->type == shapes::SPHERE)
-  {
-    const shapes::Sphere* sphere = static_cast<const shapes::Sphere*>(object_shape.get());
-    min_distance_from_edge = sphere->radius;
-    height_above_table = -sphere->radius;
-  }
-  else if (object_shape->type == shapes::CYLINDER)  // assuming cylinder is being kept down upright
-  {
-    const shapes::Cylinder* cylinder = static_cast<const shapes::Cylinder*>(object_shape.get());
-    min_distance_from_edge = cylinder->radius;
-    height_above_table = cylinder->length / 2.0;
-  }
-  else if (object_shape->type == shapes::CONE)  // assuming cone is being kept down upright
-  {
-    const shapes::Cone* cone = static_cast<const shapes::Cone*>(object_shape.get());
-    min_distance_from_edge = cone->radius;
-    height_above_table = cone->length / 2.0;
-  }
+  double min_distance_from_edge, height_above_table;
+  if (!computePlacementClearance(object_shape, object_orientation, min_distance_from_edge, height_above_table))
+    return std::vector<geometry_msgs::PoseStamped>();
 
   return generatePlacePoses(chosen_table, resolution, height_above_table, delta_height, num_heights,
                             min_distance_from_edge);
@@ -311,87 +376,106 @@ std::vector<geometry_msgs::PoseStamped> SemanticWorld::generatePlacePoses(const
                                                                           double delta_height, unsigned int num_heights,
                                                                           double min_distance_from_edge) const
 {
-  std::vector<geometry_msgs::PoseStamped> place_poses;
-  // Assumption that the table's normal is along the Z axis
-  if (table.convex_hull.empty())
-    return place_poses;
-  const int scale_factor = 100;
-  std::vector<cv::Point2f> table_contour;
-  float x_min = table.convex_hull[0].x, x_max = x_min, y_min = table.convex_hull[0].y, y_max = y_min;
-  for (std::size_t j = 1; j < table.convex_hull.size(); ++j)
-  {
-    if (table.convex_hull[j].x < x_min)
-      x_min = table.convex_hull[j].x;
-    else if (table.convex_hull[j].x > x_max)
-      x_max = table.convex_hull[j].x;
-    if (table.convex_hull[j].y < y_min)
-      y_min = table.convex_hull[j].y;
-    else if (table.convex_hull[j].y > y_max)
-      y_max = table.convex_hull[j].y;
-  }
-  for (const geometry_msgs::Point& vertex : table.convex_hull)
-    table_contour.push_back(cv::Point((vertex.x - x_min) * scale_factor, (vertex.y - y_min) * scale_factor));
-
-  double x_range = fabs(x_max - x_min);
-  double y_range = fabs(y_max - y_min);
-  int max_range = (int)x_range + 1;
-  if (max_range < (int)y_range + 1)
-    max_range = (int)y_range + 1;
-
-  int image_scale = std::max<int>(max_range, 4);
-  cv::Mat src = cv::Mat::zeros(image_scale * scale_factor, image_scale * scale_factor, CV_8UC1);
-
-  for (std::size_t j = 0; j < table.convex_hull.size(); ++j)
-  {
-    cv::line(src, table_contour[j], table_contour[(j + 1) % table.convex_hull.size()], cv::Scalar(255), 3, 8);
-  }
+  TableContourConstPtr contour = computeTableContour(table);
+  if (!contour)
+    return std::vector<geometry_msgs::PoseStamped>();
+  return generatePlacePoses(table, *contour, resolution, height_above_table, delta_height, num_heights,
+                            min_distance_from_edge);
+}
 
-  unsigned int num_x = fabs(x_max - x_min) / resolution + 1;
-  unsigned int num_y = fabs(y_max - y_min) / resolution + 1;
+std::vector<geometry_msgs::PoseStamped>
+SemanticWorld::generatePlacePoses(const object_recognition_msgs::Table& table, const TableContour& contour,
+                                  double resolution, double height_above_table, double delta_height,
+                                  unsigned int num_heights, double min_distance_from_edge) const
+{
+  unsigned int num_x = fabs(contour.x_max - contour.x_min) / resolution + 1;
+  unsigned int num_y = fabs(contour.y_max - contour.y_min) / resolution + 1;
 
   ROS_DEBUG_NAMED(LOGNAME, "Num points for possible place operations: %d %d", num_x, num_y);
 
-  std::vector<std::vector<cv::Point> > contours;
-  std::vector<cv::Vec4i> hierarchy;
-  cv::findContours(src, contours, hierarchy, cv::RETR_TREE, cv::CHAIN_APPROX_SIMPLE);
+  Eigen::Isometry3d pose;
+  tf2::fromMsg(table.pose, pose);
 
-  for (std::size_t j = 0; j < num_x; ++j)
+  // the grid columns are tested in parallel and concatenated in order afterwards
+  std::vector<std::vector<geometry_msgs::PoseStamped> > columns(num_x);
+#pragma omp parallel for schedule(dynamic)
+  for (int j = 0; j < (int)num_x; ++j)
   {
-    int point_x = j * resolution * scale_factor;
+    int point_x = j * resolution * SCALE_FACTOR;
     for (std::size_t k = 0; k < num_y; ++k)
     {
+      int point_y = k * resolution * SCALE_FACTOR;
+      cv::Point2f point2f(point_x, point_y);
+      double result = cv::pointPolygonTest(contour.contour, point2f, true);
+      if ((int)result < (int)(min_distance_from_edge * SCALE_FACTOR))
+        continue;
       for (std::size_t mm = 0; mm < num_heights; ++mm)
       {
-        int point_y = k * resolution * scale_factor;
-        cv::Point2f point2f(point_x, point_y);
-        double result = cv::pointPolygonTest(contours[0], point2f, true);
-        if ((int)result >= (int)(min_distance_from_edge * scale_factor))
-        {
-          Eigen::Vector3d point((double)(point_x) / scale_factor + x_min, (double)(point_y) / scale_factor + y_min,
-                                height_above_table + mm * delta_height);
-          Eigen::Isometry3d pose;
-          tf2::fromMsg(table.pose, pose);
-          point = pose * point;
-          geometry_msgs::PoseStamped place_pose;
-          place_pose.pose.orientation.w = 1.0;
-          place_pose.pose.position.x = point.x();
-          place_pose.pose.position.y = point.y();
-          place_pose.pose.position.z = point.z();
-          place_pose.header = table.header;
-          place_poses.push_back(place_pose);
-        }
+        Eigen::Vector3d point((double)(point_x) / SCALE_FACTOR + contour.x_min,
+                              (double)(point_y) / SCALE_FACTOR + contour.y_min, height_above_table + mm * delta_height);
+        point = pose * point;
+        geometry_msgs::PoseStamped place_pose;
+        place_pose.pose.orientation.w = 1.0;
+        place_pose.pose.position.x = point.x();
+        place_pose.pose.position.y = point.y();
+        place_pose.pose.position.z = point.z();
+        place_pose.header = table.header;
+        columns[j].push_back(place_pose);
       }
     }
   }
+
+  std::vector<geometry_msgs::PoseStamped> place_poses;
+  for (const std::vector<geometry_msgs::PoseStamped>& column : columns)
+    place_poses.insert(place_poses.end(), column.begin(), column.end());
   return place_poses;
 }
 
 bool SemanticWorld::isInsideTableContour(const geometry_msgs::Pose& pose, const object_recognition_msgs::Table& table,
                                          double min_distance_from_edge, double min_vertical_offset) const
+{
+  TableContourConstPtr contour = computeTableContour(table);
+  return contour && isInsideTableContour(pose, table, *contour, min_distance_from_edge, min_vertical_offset);
+}
+
+bool SemanticWorld::isInsideTableContour(const geometry_msgs::Pose& pose, const object_recognition_msgs::Table& table,
+                                         const TableContour& contour, double min_distance_from_edge,
+                                         double min_vertical_offset) const
+{
+  Eigen::Vector3d point(pose.position.x, pose.position.y, pose.position.z);
+  Eigen::Isometry3d pose_table;
+  tf2::fromMsg(table.pose, pose_table);
+
+  // Point in table frame
+  point = pose_table.inverse() * point;
+  // Assuming Z axis points upwards for the table
+  if (point.z() < -fabs(min_vertical_offset))
+  {
+    ROS_ERROR_NAMED(LOGNAME, "Object is not above table");
+    return false;
+  }
+
+  // reject points outside the bounds of the table before the more expensive contour test
+  double margin = (double)CONTOUR_MARGIN / SCALE_FACTOR - std::max(min_distance_from_edge, 0.0);
+  if (point.x() < contour.x_min - margin || point.x() > contour.x_max + margin || point.y() < contour.y_min - margin ||
+      point.y() > contour.y_max + margin)
+    return false;
+
+  int point_x = (point.x() - contour.x_min) * SCALE_FACTOR;
+  int point_y = (point.y() - contour.y_min) * SCALE_FACTOR;
+  cv::Point2f point2f(point_x, point_y);
+  double result = cv::pointPolygonTest(contour.contour, point2f, true);
+  ROS_DEBUG_NAMED(LOGNAME, "table distance: %f", result);
+
+  return (int)result >= (int)(min_distance_from_edge * SCALE_FACTOR);
+}
+
+SemanticWorld::TableContourConstPtr
+SemanticWorld::computeTableContour(const object_recognition_msgs::Table& table) const
 {
   // Assumption that the table's normal is along the Z axis
   if (table.convex_hull.empty())
-    return false;
+    return TableContourConstPtr();
   float x_min = table.convex_hull[0].x, x_max = x_min, y_min = table.convex_hull[0].y, y_max = y_min;
   for (std::size_t j = 1; j < table.convex_hull.size(); ++j)
   {
@@ -404,10 +488,9 @@ bool SemanticWorld::isInsideTableContour(const geometry_msgs::Pose& pose, const
     else if (table.convex_hull[j].y > y_max)
       y_max = table.convex_hull[j].y;
   }
-  const int scale_factor = 100;
   std::vector<cv::Point2f> table_contour;
   for (const geometry_msgs::Point& vertex : table.convex_hull)
-    table_contour.push_back(cv::Point((vertex.x - x_min) * scale_factor, (vertex.y - y_min) * scale_factor));
+    table_contour.push_back(cv::Point((vertex.x - x_min) * SCALE_FACTOR, (vertex.y - y_min) * SCALE_FACTOR));
 
   double x_range = fabs(x_max - x_min);
   double y_range = fabs(y_max - y_min);
@@ -416,7 +499,7 @@ bool SemanticWorld::isInsideTableContour(const geometry_msgs::Pose& pose, const
     max_range = (int)y_range + 1;
 
   int image_scale = std::max<int>(max_range, 4);
-  cv::Mat src = cv::Mat::zeros(image_scale * scale_factor, image_scale * scale_factor, CV_8UC1);
+  cv::Mat src = cv::Mat::zeros(image_scale * SCALE_FACTOR, image_scale * SCALE_FACTOR, CV_8UC1);
 
   for (std::size_t j = 0; j < table.convex_hull.size(); ++j)
   {
@@ -426,27 +509,16 @@ bool SemanticWorld::isInsideTableContour(const geometry_msgs::Pose& pose, const
   std::vector<std::vector<cv::Point> > contours;
   std::vector<cv::Vec4i> hierarchy;
   cv::findContours(src, contours, hierarchy, cv::RETR_TREE, cv::CHAIN_APPROX_SIMPLE);
-
-  Eigen::Vector3d point(pose.position.x, pose.position.y, pose.position.z);
-  Eigen::Isometry3d pose_table;
-  tf2::fromMsg(table.pose, pose_table);
-
-  // Point in table frame
-  point = pose_table.inverse() * point;
-  // Assuming Z axis points upwards for the table
-  if (point.z() < -fabs(min_vertical_offset))
-  {
-    ROS_ERROR_NAMED(LOGNAME, "Object is not above table");
-    return false;
-  }
-
-  int point_x = (point.x() - x_min) * scale_factor;
-  int point_y = (point.y() - y_min) * scale_factor;
-  cv::Point2f point2f(point_x, point_y);
-  double result = cv::pointPolygonTest(contours[0], point2f, true);
-  ROS_DEBUG_NAMED(LOGNAME, "table distance: %f", result);
-
-  return (int)result >= (int)(min_distance_from_edge * scale_factor);
+  if (contours.empty())
+    return TableContourConstPtr();
+
+  auto result = std::make_shared<TableContour>();
+  result->x_min = x_min;
+  result->x_max = x_max;
+  result->y_min = y_min;
+  result->y_max = y_max;
+  result->contour = std::move(contours[0]);
+  return result;
 }
 
 std::string SemanticWorld::findObjectTable(const geometry_msgs::Pose& pose, double min_distance_from_edge,
@@ -456,7 +528,8 @@ std::string SemanticWorld::findObjectTable(const geometry_msgs::Pose& pose, doub
   for (it = current_tables_in_collision_world_.begin(); it != current_tables_in_collision_world_.end(); ++it)
   {
     ROS_DEBUG_STREAM_NAMED(LOGNAME, "Testing table: " << it->first);
-    if (isInsideTableContour(pose, it->second, min_distance_from_edge, min_vertical_offset))
+    const TableContourConstPtr& contour = table_contours_.at(it->first);
+    if (contour && isInsideTableContour(pose, it->second, *contour, min_distance_from_edge, min_vertical_offset))
       return it->first;
   }
   return std::string();
@@ -159,13 +159,16 @@ public:
                                   links.front()->getParentJointModel()->getParentLinkModel()->getName() :
                                   jmg->getParentModel().getModelFrame();
 
-    // just to be sure, do not call the same pluginlib instance allocation function in parallel
-    boost::mutex::scoped_lock slock(lock_);
     for (std::size_t i = 0; !result && i < it->second.size(); ++i)
     {
       try
       {
-        result = kinematics_loader_->createUniqueInstance(it->second[i]);
+        {
+          // just to be sure, do not call the same pluginlib instance allocation function in parallel;
+          // the solvers themselves are initialized concurrently
+          boost::mutex::scoped_lock slock(lock_);
+          result = kinematics_loader_->createUniqueInstance(it->second[i]);
+        }
         if (result)
         {
           // choose the tip of the IK solver
@@ -213,14 +216,19 @@ public:
   // second call in JointModelGroup::setSolverAllocators() is to actually retrieve the instance for use
   kinematics::KinematicsBasePtr allocKinematicsSolverWithCache(const moveit::core::JointModelGroup* jmg)
   {
-    boost::mutex::scoped_lock slock(cache_lock_);
-    kinematics::KinematicsBasePtr& cached = instances_[jmg];
-    if (cached.unique())
-      return std::move(cached);  // pass on unique instance
+    {
+      boost::mutex::scoped_lock slock(cache_lock_);
+      kinematics::KinematicsBasePtr& cached = instances_[jmg];
+      if (cached.unique())
+        return std::move(cached);  // pass on unique instance
+    }
 
-    // create a new instance and store in instances_
-    cached = allocKinematicsSolver(jmg);
-    return cached;
+    // create a new instance without holding the cache lock, so solvers of different groups can be created in parallel,
+    // and store it in instances_
+    kinematics::KinematicsBasePtr result = allocKinematicsSolver(jmg);
+    boost::mutex::scoped_lock slock(cache_lock_);
+    instances_[jmg] = result;
+    return result;
   }
 
   void status() const
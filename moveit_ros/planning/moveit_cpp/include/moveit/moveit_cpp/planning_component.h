@@ -41,6 +41,7 @@
 #include <moveit/moveit_cpp/moveit_cpp.h>
 #include <moveit_msgs/MoveItErrorCodes.h>
 #include <moveit/utils/moveit_error_code.h>
+#include <moveit/planning_interface/planning_request.h>
 #include <moveit/planning_interface/planning_response.h>
 #include <mutex>
 
@@ -218,6 +219,16 @@ public:
        const SolutionCallbackFunction& solution_selection_callback = &getShortestSolution,
        const StoppingCriterionFunction& stopping_criterion_callback = StoppingCriterionFunction());
 
+  /** \brief Plan from the start or current state to each of \e goals, which are alternatives like grasp candidates,
+   * and return one response per goal. All goals are planned in the same copy of the planning scene, on up to
+   * \e num_threads threads (0 uses all hardware threads). Running several threads requires a planning pipeline that
+   * can plan concurrently, like OMPL. If \e max_successes is not 0, planning stops after that many goals succeeded;
+   * goals still being planned for then fail and goals not started yet are returned as PREEMPTED. The path and
+   * trajectory constraints set before apply to all goals. Unlike plan(), the last solution is not updated. */
+  std::vector<planning_interface::MotionPlanResponse>
+  planBatch(const std::vector<std::vector<moveit_msgs::Constraints>>& goals, const PlanRequestParameters& parameters,
+            std::size_t max_successes = 0, unsigned int num_threads = 1);
+
   /** \brief Execute the latest computed solution trajectory computed by plan(). By default this function terminates
    * after the execution is complete. The execution can be run in background by setting blocking to false. */
   bool execute(bool blocking = true);
@@ -253,9 +264,33 @@ private:
   // std::unique_ptr<moveit_msgs::Constraints> path_constraints_;
   // std::unique_ptr<moveit_msgs::TrajectoryConstraints> trajectory_constraints_;
 
+  /** \brief Fill the fields of \e req that do not depend on the goal */
+  void initPlanRequest(const PlanRequestParameters& parameters, ::planning_interface::MotionPlanRequest& req) const;
+
+  /** \brief Clone the current planning scene with the considered start state, which is also set in \e req */
+  planning_scene::PlanningScenePtr cloneStartScene(::planning_interface::MotionPlanRequest& req);
+
+  /** \brief Plan for \e req, which must contain the start state of \e planning_scene, to the goal set with setGoal()
+   * using \e parameters */
+  planning_interface::MotionPlanResponse planInScene(const PlanRequestParameters& parameters,
+                                                     const planning_scene::PlanningScenePtr& planning_scene,
+                                                     ::planning_interface::MotionPlanRequest& req);
+
   /** \brief Reset all member variables */
   void clearContents();
 };
+
+/// \brief A function to choose the solution with the shortest planning time from a vector of solutions
+planning_interface::MotionPlanResponse
+getFastestSolution(std::vector<planning_interface::MotionPlanResponse> const& solutions);
+
+/// \brief A function to choose the solution that was found first from a vector of solutions
+planning_interface::MotionPlanResponse
+getFirstSolution(std::vector<planning_interface::MotionPlanResponse> const& solutions);
+
+/// \brief A stopping criterion that terminates the remaining planning pipelines once one of them found a solution
+bool stopAtFirstSolution(PlanningComponent::PlanSolutions const& solutions,
+                         PlanningComponent::MultiPipelinePlanRequestParameters const& plan_request_parameters);
 }  // namespace moveit_cpp
 
 namespace moveit
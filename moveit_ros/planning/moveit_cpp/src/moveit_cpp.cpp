@@ -236,13 +236,11 @@ bool MoveItCpp::execute(const std::string& group_name, const robot_trajectory::R
   }
 
   // Execute trajectory
-  moveit_msgs::RobotTrajectory robot_trajectory_msg;
-  robot_trajectory->getRobotTrajectoryMsg(robot_trajectory_msg);
   // TODO: cambel
   // blocking is the only valid option right now. Add non-bloking use case
   if (blocking)
   {
-    trajectory_execution_manager_->push(robot_trajectory_msg);
+    trajectory_execution_manager_->push(*robot_trajectory);
     trajectory_execution_manager_->execute();
     return trajectory_execution_manager_->waitForExecution();
   }
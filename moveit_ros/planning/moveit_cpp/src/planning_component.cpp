@@ -41,6 +41,7 @@
 #include <moveit/planning_pipeline/planning_pipeline.h>
 #include <moveit/planning_scene_monitor/planning_scene_monitor.h>
 #include <moveit/robot_state/conversions.h>
+#include <atomic>
 #include <thread>
 
 namespace moveit_cpp
@@ -111,21 +112,23 @@ bool PlanningComponent::setTrajectoryConstraints(const moveit_msgs::TrajectoryCo
   return true;
 }
 
-planning_interface::MotionPlanResponse PlanningComponent::plan(const PlanRequestParameters& parameters,
-                                                               const bool store_solution)
+void PlanningComponent::initPlanRequest(const PlanRequestParameters& parameters,
+                                        ::planning_interface::MotionPlanRequest& req) const
 {
-  auto plan_solution = planning_interface::MotionPlanResponse();
-  if (!joint_model_group_)
-  {
-    ROS_ERROR_NAMED(LOGNAME, "Failed to retrieve joint model group for name '%s'.", group_name_.c_str());
-    plan_solution.error_code_ = moveit::core::MoveItErrorCode::INVALID_GROUP_NAME;
-    if (store_solution)
-    {
-      last_plan_solution_ = plan_solution;
-    }
-    return plan_solution;
-  }
+  req.group_name = group_name_;
+  req.planner_id = parameters.planner_id;
+  req.num_planning_attempts = std::max(1, parameters.planning_attempts);
+  req.allowed_planning_time = parameters.planning_time;
+  req.max_velocity_scaling_factor = parameters.max_velocity_scaling_factor;
+  req.max_acceleration_scaling_factor = parameters.max_acceleration_scaling_factor;
+  if (workspace_parameters_set_)
+    req.workspace_parameters = workspace_parameters_;
+  req.path_constraints = current_path_constraints_;
+  req.trajectory_constraints = current_trajectory_constraints_;
+}
 
+planning_scene::PlanningScenePtr PlanningComponent::cloneStartScene(::planning_interface::MotionPlanRequest& req)
+{
   // Clone current planning scene
   planning_scene_monitor::PlanningSceneMonitorPtr planning_scene_monitor =
       moveit_cpp_->getPlanningSceneMonitorNonConst();
@@ -136,17 +139,6 @@ planning_interface::MotionPlanResponse PlanningComponent::plan(const PlanRequest
   planning_scene_monitor->unlockSceneRead();  // UNLOCK planning scene
   planning_scene_monitor.reset();             // release this pointer
 
-  // Init MotionPlanRequest
-  ::planning_interface::MotionPlanRequest req;
-  req.group_name = group_name_;
-  req.planner_id = parameters.planner_id;
-  req.num_planning_attempts = std::max(1, parameters.planning_attempts);
-  req.allowed_planning_time = parameters.planning_time;
-  req.max_velocity_scaling_factor = parameters.max_velocity_scaling_factor;
-  req.max_acceleration_scaling_factor = parameters.max_acceleration_scaling_factor;
-  if (workspace_parameters_set_)
-    req.workspace_parameters = workspace_parameters_;
-
   // Set start state
   moveit::core::RobotStatePtr start_state = considered_start_state_;
   if (!start_state)
@@ -154,26 +146,46 @@ planning_interface::MotionPlanResponse PlanningComponent::plan(const PlanRequest
   start_state->update();
   moveit::core::robotStateToRobotStateMsg(*start_state, req.start_state);
   planning_scene->setCurrentState(*start_state);
+  return planning_scene;
+}
+
+planning_interface::MotionPlanResponse PlanningComponent::plan(const PlanRequestParameters& parameters,
+                                                               const bool store_solution)
+{
+  ::planning_interface::MotionPlanRequest req;
+  initPlanRequest(parameters, req);
+  planning_scene::PlanningScenePtr planning_scene = cloneStartScene(req);
+
+  planning_interface::MotionPlanResponse plan_solution = planInScene(parameters, planning_scene, req);
+  if (store_solution)
+  {
+    last_plan_solution_ = plan_solution;
+  }
+  return plan_solution;
+}
+
+planning_interface::MotionPlanResponse
+PlanningComponent::planInScene(const PlanRequestParameters& parameters,
+                               const planning_scene::PlanningScenePtr& planning_scene,
+                               ::planning_interface::MotionPlanRequest& req)
+{
+  auto plan_solution = planning_interface::MotionPlanResponse();
+  if (!joint_model_group_)
+  {
+    ROS_ERROR_NAMED(LOGNAME, "Failed to retrieve joint model group for name '%s'.", group_name_.c_str());
+    plan_solution.error_code_ = moveit::core::MoveItErrorCode::INVALID_GROUP_NAME;
+    return plan_solution;
+  }
 
   // Set goal constraints
   if (current_goal_constraints_.empty())
   {
     ROS_ERROR_NAMED(LOGNAME, "No goal constraints set for planning request");
     plan_solution.error_code_ = moveit::core::MoveItErrorCode::INVALID_GOAL_CONSTRAINTS;
-    if (store_solution)
-    {
-      last_plan_solution_ = plan_solution;
-    }
     return plan_solution;
   }
   req.goal_constraints = current_goal_constraints_;
 
-  // Set path constraints
-  req.path_constraints = current_path_constraints_;
-
-  // Set trajectory constraints
-  req.trajectory_constraints = current_trajectory_constraints_;
-
   // Run planning attempt
   ::planning_interface::MotionPlanResponse res;
   const auto& pipelines = moveit_cpp_->getPlanningPipelines();
@@ -182,10 +194,6 @@ planning_interface::MotionPlanResponse PlanningComponent::plan(const PlanRequest
   {
     ROS_ERROR_NAMED(LOGNAME, "No planning pipeline available for name '%s'", parameters.planning_pipeline.c_str());
     plan_solution.error_code_ = moveit::core::MoveItErrorCode::FAILURE;
-    if (store_solution)
-    {
-      last_plan_solution_ = plan_solution;
-    }
     return plan_solution;
   }
   const planning_pipeline::PlanningPipelinePtr pipeline = it->second;
@@ -194,10 +202,6 @@ planning_interface::MotionPlanResponse PlanningComponent::plan(const PlanRequest
   if (res.error_code_.val != res.error_code_.SUCCESS)
   {
     ROS_ERROR("Could not compute plan successfully");
-    if (store_solution)
-    {
-      last_plan_solution_ = plan_solution;
-    }
     return plan_solution;
   }
   plan_solution.trajectory_ = res.trajectory_;
@@ -216,11 +220,6 @@ planning_interface::MotionPlanResponse PlanningComponent::plan(const PlanRequest
   //    visual_tools_->publishRobotState(last_solution_trajectory_->getLastWayPoint(), rviz_visual_tools::TRANSLUCENT);
   //  }
   //}
-
-  if (store_solution)
-  {
-    last_plan_solution_ = plan_solution;
-  }
   return plan_solution;
 }
 
@@ -245,6 +244,13 @@ PlanningComponent::plan(const MultiPipelinePlanRequestParameters& parameters,
         parameters.multi_plan_request_parameters.size(), hardware_concurrency);
   }
 
+  // All pipelines plan in the same copy of the scene, from the same start state
+  ::planning_interface::MotionPlanRequest start_req;
+  const planning_scene::PlanningScenePtr planning_scene = cloneStartScene(start_req);
+
+  // Serializes adding solutions and evaluating the stopping criterion, so that it sees a consistent set of solutions
+  std::mutex solutions_mutex;
+
   // Launch planning threads
   for (auto const& plan_request_parameter : parameters.multi_plan_request_parameters)
   {
@@ -252,7 +258,10 @@ PlanningComponent::plan(const MultiPipelinePlanRequestParameters& parameters,
       auto plan_solution = planning_interface::MotionPlanResponse();
       try
       {
-        plan_solution = plan(plan_request_parameter, false);
+        ::planning_interface::MotionPlanRequest req;
+        initPlanRequest(plan_request_parameter, req);
+        req.start_state = start_req.start_state;
+        plan_solution = planInScene(plan_request_parameter, planning_scene, req);
       }
       catch (const std::exception& e)
       {
@@ -261,8 +270,9 @@ PlanningComponent::plan(const MultiPipelinePlanRequestParameters& parameters,
         plan_solution.error_code_ = moveit::core::MoveItErrorCode::FAILURE;
       }
       plan_solution.planner_id_ = plan_request_parameter.planner_id;
-      planning_solutions.pushBack(plan_solution);
 
+      std::lock_guard<std::mutex> solutions_lock(solutions_mutex);
+      planning_solutions.pushBack(plan_solution);
       if (stopping_criterion_callback != nullptr)
       {
         if (stopping_criterion_callback(planning_solutions, parameters))
@@ -294,6 +304,84 @@ PlanningComponent::plan(const MultiPipelinePlanRequestParameters& parameters,
   return last_plan_solution_;
 }
 
+std::vector<planning_interface::MotionPlanResponse>
+PlanningComponent::planBatch(const std::vector<std::vector<moveit_msgs::Constraints>>& goals,
+                             const PlanRequestParameters& parameters, std::size_t max_successes,
+                             unsigned int num_threads)
+{
+  // goals that are not planned for because enough others succeeded already are reported as preempted
+  std::vector<planning_interface::MotionPlanResponse> solutions(goals.size());
+  for (planning_interface::MotionPlanResponse& solution : solutions)
+    solution.error_code_ = moveit::core::MoveItErrorCode::PREEMPTED;
+  if (goals.empty())
+    return solutions;
+
+  const auto& pipelines = moveit_cpp_->getPlanningPipelines();
+  auto it = pipelines.find(parameters.planning_pipeline);
+  if (it == pipelines.end())
+  {
+    ROS_ERROR_NAMED(LOGNAME, "No planning pipeline available for name '%s'", parameters.planning_pipeline.c_str());
+    for (planning_interface::MotionPlanResponse& solution : solutions)
+      solution.error_code_ = moveit::core::MoveItErrorCode::FAILURE;
+    return solutions;
+  }
+  const planning_pipeline::PlanningPipelinePtr pipeline = it->second;
+
+  // All goals are planned in the same copy of the scene, which the planners only read
+  ::planning_interface::MotionPlanRequest batch_req;
+  initPlanRequest(parameters, batch_req);
+  const planning_scene::PlanningScenePtr planning_scene = cloneStartScene(batch_req);
+
+  std::atomic<std::size_t> next_goal{ 0 };
+  std::atomic<std::size_t> successes{ 0 };
+  auto plan_goals = [&]() {
+    std::size_t goal_index;
+    while ((max_successes == 0 || successes < max_successes) && (goal_index = next_goal++) < goals.size())
+    {
+      ::planning_interface::MotionPlanRequest req = batch_req;
+      req.goal_constraints = goals[goal_index];
+      ::planning_interface::MotionPlanResponse res;
+      try
+      {
+        pipeline->generatePlan(planning_scene, req, res);
+      }
+      catch (const std::exception& e)
+      {
+        ROS_ERROR_STREAM_NAMED(LOGNAME, "Planning for goal " << goal_index << " threw exception '" << e.what() << "'");
+        res.error_code_.val = moveit_msgs::MoveItErrorCodes::FAILURE;
+      }
+
+      planning_interface::MotionPlanResponse& solution = solutions[goal_index];
+      solution.error_code_ = res.error_code_;
+      solution.planner_id_ = parameters.planner_id;
+      if (res.error_code_.val == res.error_code_.SUCCESS)
+      {
+        solution.trajectory_ = res.trajectory_;
+        solution.planning_time_ = res.planning_time_;
+        solution.start_state_ = req.start_state;
+        if (++successes == max_successes)
+        {
+          ROS_INFO_NAMED(LOGNAME, "Found %zu solutions: Terminating the goals that are still planned for",
+                         max_successes);
+          pipeline->terminate();
+        }
+      }
+    }
+  };
+
+  // The calling thread plans as well
+  if (num_threads == 0)
+    num_threads = std::max(std::thread::hardware_concurrency(), 1u);
+  std::vector<std::thread> planning_threads;
+  for (std::size_t i = 1; i < std::min<std::size_t>(num_threads, goals.size()); ++i)
+    planning_threads.emplace_back(plan_goals);
+  plan_goals();
+  for (std::thread& planning_thread : planning_threads)
+    planning_thread.join();
+
+  return solutions;
+}
+
 planning_interface::MotionPlanResponse PlanningComponent::plan()
 {
   return plan(plan_request_parameters_);
@@ -449,6 +537,41 @@ getShortestSolution(std::vector<planning_interface::MotionPlanResponse> const& s
   return *shortest_trajectory;
 }
 
+planning_interface::MotionPlanResponse
+getFastestSolution(std::vector<planning_interface::MotionPlanResponse> const& solutions)
+{
+  planning_interface::MotionPlanResponse const* fastest = nullptr;
+  for (planning_interface::MotionPlanResponse const& solution : solutions)
+    if (solution && (!fastest || solution.planning_time_ < fastest->planning_time_))
+      fastest = &solution;
+  if (fastest)
+  {
+    ROS_INFO_NAMED(LOGNAME, "Chosen solution with shortest planning time: '%f'", fastest->planning_time_);
+    return *fastest;
+  }
+  ROS_INFO_STREAM_NAMED(LOGNAME, "Could not determine fastest solution");
+  return solutions.empty() ? planning_interface::MotionPlanResponse() : solutions.front();
+}
+
+planning_interface::MotionPlanResponse
+getFirstSolution(std::vector<planning_interface::MotionPlanResponse> const& solutions)
+{
+  for (planning_interface::MotionPlanResponse const& solution : solutions)
+    if (solution)
+      return solution;
+  ROS_INFO_STREAM_NAMED(LOGNAME, "Could not determine first solution");
+  return solutions.empty() ? planning_interface::MotionPlanResponse() : solutions.front();
+}
+
+bool stopAtFirstSolution(PlanningComponent::PlanSolutions const& solutions,
+                         PlanningComponent::MultiPipelinePlanRequestParameters const& /*plan_request_parameters*/)
+{
+  for (planning_interface::MotionPlanResponse const& solution : solutions.getSolutions())
+    if (solution)
+      return true;
+  return false;
+}
+
 void PlanningComponent::clearContents()
 {
   considered_start_state_.reset();
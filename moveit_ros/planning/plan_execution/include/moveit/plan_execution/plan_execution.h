@@ -43,6 +43,7 @@
 #include <moveit/planning_scene_monitor/trajectory_monitor.h>
 #include <moveit/sensor_manager/sensor_manager.h>
 #include <pluginlib/class_loader.hpp>
+#include <Eigen/Geometry>
 
 #include <atomic>
 
@@ -128,6 +129,19 @@ public:
     return default_max_replan_attempts_;
   }
 
+  /** \brief Limit the checks of the executed trajectory on scene updates to the waypoints within \e horizon seconds
+      ahead of the current execution point. Waypoints further ahead are checked once they come within the horizon.
+      A horizon of 0 (the default) checks the whole remaining trajectory right away. */
+  void setMonitoringHorizon(double horizon)
+  {
+    monitoring_horizon_ = horizon;
+  }
+
+  double getMonitoringHorizon() const
+  {
+    return monitoring_horizon_;
+  }
+
   void planAndExecute(ExecutableMotionPlan& plan, const Options& opt);
   void planAndExecute(ExecutableMotionPlan& plan, const moveit_msgs::PlanningScene& scene_diff, const Options& opt);
 
@@ -142,6 +156,13 @@ public:
 private:
   void planAndExecuteHelper(ExecutableMotionPlan& plan, const Options& opt);
   bool isRemainingPathValid(const ExecutableMotionPlan& plan, const std::pair<int, int>& path_segment);
+  /** \brief Check the remaining waypoints within the monitoring horizon that overlap regions of the scene changed since
+      the previous call. Only called by the thread monitoring the execution */
+  bool isRemainingPathStillValid(const ExecutableMotionPlan& plan, const std::pair<int, int>& path_segment);
+  /** \brief Check \e waypoints of trajectory \e component in parallel. The scene needs to be locked */
+  bool areWaypointsValid(const ExecutableMotionPlan& plan, int component,
+                         const std::vector<std::size_t>& waypoints) const;
+  const Eigen::AlignedBox3d& getWaypointBox(const robot_trajectory::RobotTrajectory& t, std::size_t index);
 
   void planningSceneUpdatedCallback(const planning_scene_monitor::PlanningSceneMonitor::SceneUpdateType update_type);
   void doneWithTrajectoryExecution(const moveit_controller_manager::ExecutionStatus& status);
@@ -153,6 +174,7 @@ private:
   planning_scene_monitor::TrajectoryMonitorPtr trajectory_monitor_;
 
   unsigned int default_max_replan_attempts_;
+  double monitoring_horizon_;
 
   class
   {
@@ -178,6 +200,19 @@ private:
   bool execution_complete_;
   bool path_became_invalid_;
 
+  /** \brief A region of the scene that changed, and the waypoint up to which it was checked */
+  struct ChangedRegion
+  {
+    Eigen::AlignedBox3d box;
+    std::size_t checked_until;
+  };
+
+  // incremental validation of the executed trajectory component
+  int monitored_component_;
+  std::uint64_t monitored_scene_version_;
+  std::vector<ChangedRegion> changed_regions_;
+  std::vector<Eigen::AlignedBox3d> waypoint_boxes_;  // bounding boxes of the robot at the waypoints, computed lazily
+
   class DynamicReconfigureImpl;
   DynamicReconfigureImpl* reconfigure_impl_;
 };
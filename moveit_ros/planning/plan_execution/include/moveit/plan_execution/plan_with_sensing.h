@@ -104,6 +104,18 @@ public:
     discard_overlapping_cost_sources_ = value;
   }
 
+  double getMaxMapUpdateWait() const
+  {
+    return max_map_update_wait_;
+  }
+
+  /** \brief Set the maximum time (in seconds) to wait after looking around for the octomap to refresh the regions of
+   *  the cost sources before planning again. Planning starts as soon as the map updates stop refreshing new regions. */
+  void setMaxMapUpdateWait(double value)
+  {
+    max_map_update_wait_ = value;
+  }
+
   void setBeforeLookCallback(const boost::function<void()>& callback)
   {
     before_look_callback_ = callback;
@@ -114,6 +126,16 @@ public:
 private:
   bool lookAt(const std::set<collision_detection::CostSource>& cost_sources, const std::string& frame_id);
 
+  /** \brief Fingerprint the octomap leaves within each of the cost sources. Empty if the scene has no octomap. */
+  std::vector<std::size_t> getRegionSignatures(const planning_scene_monitor::PlanningSceneMonitorPtr& psm,
+                                               const std::set<collision_detection::CostSource>& cost_sources) const;
+
+  /** \brief Wait until the octomap refreshed the regions of the cost sources, given their \e signatures from before
+   *  looking around, or at most max_map_update_wait_ seconds */
+  void waitForRegionUpdates(const planning_scene_monitor::PlanningSceneMonitorPtr& psm,
+                            const std::set<collision_detection::CostSource>& cost_sources,
+                            const std::vector<std::size_t>& signatures) const;
+
   ros::NodeHandle node_handle_;
   trajectory_execution_manager::TrajectoryExecutionManagerPtr trajectory_execution_manager_;
 
@@ -124,6 +146,7 @@ private:
 
   double discard_overlapping_cost_sources_;
   unsigned int max_cost_sources_;
+  double max_map_update_wait_;
 
   bool display_cost_sources_;
   ros::Publisher cost_sources_publisher_;
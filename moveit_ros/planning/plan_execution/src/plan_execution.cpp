@@ -42,6 +42,10 @@
 #include <moveit/utils/moveit_error_code.h>
 #include <boost/algorithm/string/join.hpp>
 
+#include <atomic>
+#include <limits>
+#include <thread>
+
 #include <dynamic_reconfigure/server.h>
 #include <moveit_ros_planning/PlanExecutionDynamicReconfigureConfig.h>
 
@@ -49,6 +53,9 @@ namespace plan_execution
 {
 using namespace moveit_ros_planning;
 
+// the waypoints to validate are only distributed over threads if each gets at least this many of them
+static const std::size_t PARALLEL_VALIDATION_MIN_WAYPOINTS = 16;
+
 class PlanExecution::DynamicReconfigureImpl
 {
 public:
@@ -64,6 +71,7 @@ private:
   {
     owner_->setMaxReplanAttempts(config.max_replan_attempts);
     owner_->setTrajectoryStateRecordingFrequency(config.record_trajectory_state_frequency);
+    owner_->setMonitoringHorizon(config.monitoring_horizon);
   }
 
   PlanExecution* owner_;
@@ -83,6 +91,9 @@ plan_execution::PlanExecution::PlanExecution(
         planning_scene_monitor_->getRobotModel(), planning_scene_monitor_->getStateMonitor());
 
   default_max_replan_attempts_ = 5;
+  monitoring_horizon_ = 0.0;
+  monitored_component_ = -1;
+  monitored_scene_version_ = 0;
 
   new_scene_update_ = false;
 
@@ -254,32 +265,145 @@ bool plan_execution::PlanExecution::isRemainingPathValid(const ExecutableMotionP
                                                                                          // representation while
                                                                                          // isStateValid() is called
     const robot_trajectory::RobotTrajectory& t = *plan.plan_components_[path_segment.first].trajectory_;
-    const collision_detection::AllowedCollisionMatrix* acm =
-        plan.plan_components_[path_segment.first].allowed_collision_matrix_.get();
-    std::size_t wpc = t.getWayPointCount();
-    collision_detection::CollisionRequest req;
-    req.group_name = t.getGroupName();
-    for (std::size_t i = std::max(path_segment.second - 1, 0); i < wpc; ++i)
+    std::vector<std::size_t> waypoints;
+    for (std::size_t i = std::max(path_segment.second - 1, 0); i < t.getWayPointCount(); ++i)
+      waypoints.push_back(i);
+    return areWaypointsValid(plan, path_segment.first, waypoints);
+  }
+  return true;
+}
+
+bool plan_execution::PlanExecution::isRemainingPathStillValid(const ExecutableMotionPlan& plan,
+                                                              const std::pair<int, int>& path_segment)
+{
+  if (path_segment.first < 0 || !plan.plan_components_[path_segment.first].trajectory_monitoring_)
+    return true;
+
+  planning_scene_monitor::LockedPlanningSceneRO lscene(plan.planning_scene_monitor_);
+  const robot_trajectory::RobotTrajectory& t = *plan.plan_components_[path_segment.first].trajectory_;
+  const std::size_t wpc = t.getWayPointCount();
+  const std::size_t first = std::max(path_segment.second - 1, 0);
+
+  // the next trajectory component was checked as a whole before its execution started
+  if (path_segment.first != monitored_component_)
+  {
+    monitored_component_ = path_segment.first;
+    waypoint_boxes_.assign(wpc, Eigen::AlignedBox3d());
+    for (ChangedRegion& region : changed_regions_)
+      region.checked_until = 0;
+  }
+
+  // collect the regions of the scene changed since the previous check
+  const Eigen::AlignedBox3d everywhere(Eigen::Vector3d::Constant(-std::numeric_limits<double>::infinity()),
+                                       Eigen::Vector3d::Constant(std::numeric_limits<double>::infinity()));
+  std::vector<planning_scene::PlanningScene::SceneChange> changes;
+  if (!plan.planning_scene_->getChangesSince(monitored_scene_version_, changes))
+    changed_regions_.push_back({ everywhere, first });
+  for (const planning_scene::PlanningScene::SceneChange& change : changes)
+  {
+    // attached bodies and the allowed collision matrix affect the validity of every waypoint
+    if (change.type != planning_scene::PlanningScene::SceneChange::WORLD_OBJECT)
     {
-      collision_detection::CollisionResult res;
-      if (acm)
-        plan.planning_scene_->checkCollisionUnpadded(req, res, t.getWayPoint(i), *acm);
-      else
-        plan.planning_scene_->checkCollisionUnpadded(req, res, t.getWayPoint(i));
+      changed_regions_.push_back({ everywhere, first });
+      continue;
+    }
+    // removed shapes cannot cause collisions, so only the current extent of a changed object matters
+    const Eigen::AlignedBox3d box = plan.planning_scene_->getWorld()->getObjectAABB(change.id);
+    if (!box.isEmpty())
+      changed_regions_.push_back({ box, first });
+  }
+  monitored_scene_version_ = plan.planning_scene_->getChangeVersion();
+  if (changed_regions_.empty())
+    return true;
+
+  // only the waypoints within the monitoring horizon are checked now, the others once they come within it
+  std::size_t last = wpc;
+  if (monitoring_horizon_ > 0.0 && first < wpc)
+  {
+    int before, after;
+    double blend;
+    t.findWayPointIndicesForDurationAfterStart(t.getWayPointDurationFromStart(first) + monitoring_horizon_, before,
+                                               after, blend);
+    last = std::min<std::size_t>(after + 1, wpc);
+  }
 
-      if (res.collision || !plan.planning_scene_->isStateFeasible(t.getWayPoint(i), false))
+  std::vector<std::size_t> waypoints;
+  for (std::size_t i = first; i < last; ++i)
+    for (const ChangedRegion& region : changed_regions_)
+      if (i >= region.checked_until && getWaypointBox(t, i).intersects(region.box))
       {
-        // call the same functions again, in verbose mode, to show what issues have been detected
-        plan.planning_scene_->isStateFeasible(t.getWayPoint(i), true);
-        req.verbose = true;
-        res.clear();
-        if (acm)
-          plan.planning_scene_->checkCollisionUnpadded(req, res, t.getWayPoint(i), *acm);
-        else
-          plan.planning_scene_->checkCollisionUnpadded(req, res, t.getWayPoint(i));
-        return false;
+        waypoints.push_back(i);
+        break;
       }
-    }
+  for (ChangedRegion& region : changed_regions_)
+    region.checked_until = std::max(region.checked_until, last);
+  changed_regions_.erase(std::remove_if(changed_regions_.begin(), changed_regions_.end(),
+                                        [wpc](const ChangedRegion& region) { return region.checked_until >= wpc; }),
+                         changed_regions_.end());
+
+  return areWaypointsValid(plan, path_segment.first, waypoints);
+}
+
+const Eigen::AlignedBox3d& plan_execution::PlanExecution::getWaypointBox(const robot_trajectory::RobotTrajectory& t,
+                                                                         std::size_t index)
+{
+  Eigen::AlignedBox3d& box = waypoint_boxes_[index];
+  if (box.isEmpty())
+  {
+    moveit::core::RobotState state(t.getWayPoint(index));
+    std::vector<double> aabb;
+    state.computeAABB(aabb);
+    box.extend(Eigen::Vector3d(aabb[0], aabb[2], aabb[4]));
+    box.extend(Eigen::Vector3d(aabb[1], aabb[3], aabb[5]));
+  }
+  return box;
+}
+
+bool plan_execution::PlanExecution::areWaypointsValid(const ExecutableMotionPlan& plan, int component,
+                                                      const std::vector<std::size_t>& waypoints) const
+{
+  const robot_trajectory::RobotTrajectory& t = *plan.plan_components_[component].trajectory_;
+  const collision_detection::AllowedCollisionMatrix* acm =
+      plan.plan_components_[component].allowed_collision_matrix_.get();
+
+  auto is_valid = [&](std::size_t i, bool verbose) {
+    collision_detection::CollisionRequest req;
+    req.group_name = t.getGroupName();
+    req.verbose = verbose;
+    collision_detection::CollisionResult res;
+    if (acm)
+      plan.planning_scene_->checkCollisionUnpadded(req, res, t.getWayPoint(i), *acm);
+    else
+      plan.planning_scene_->checkCollisionUnpadded(req, res, t.getWayPoint(i));
+    return !res.collision && plan.planning_scene_->isStateFeasible(t.getWayPoint(i), verbose);
+  };
+
+  // check the waypoints in parallel, stopping all workers at the first invalid one
+  const std::size_t count = waypoints.size();
+  std::atomic<std::size_t> next(0);
+  std::atomic<std::size_t> invalid(count);
+  auto worker = [&]() {
+    for (std::size_t k = next++; k < count && invalid.load(std::memory_order_relaxed) == count; k = next++)
+      if (!is_valid(waypoints[k], false))
+      {
+        std::size_t expected = count;
+        invalid.compare_exchange_strong(expected, k);
+      }
+  };
+  const unsigned int threads =
+      std::min<std::size_t>(std::thread::hardware_concurrency(), count / PARALLEL_VALIDATION_MIN_WAYPOINTS);
+  std::vector<std::thread> workers;
+  for (unsigned int k = 1; k < threads; ++k)
+    workers.emplace_back(worker);
+  worker();
+  for (std::thread& thread : workers)
+    thread.join();
+
+  if (invalid != count)
+  {
+    // call the same functions again, in verbose mode, to show what issues have been detected
+    is_valid(waypoints[invalid], true);
+    return false;
   }
   return true;
 }
@@ -384,17 +508,24 @@ moveit_msgs::MoveItErrorCodes plan_execution::PlanExecution::executeAndMonitor(E
   // wait for path to be done, while checking that the path does not become invalid
   ros::Rate r(100);
   path_became_invalid_ = false;
+  monitored_component_ = -1;
+  changed_regions_.clear();
+  {
+    planning_scene_monitor::LockedPlanningSceneRO lscene(plan.planning_scene_monitor_);
+    monitored_scene_version_ = plan.planning_scene_->getChangeVersion();
+  }
   bool preempt_requested = false;
 
   while (node_handle_.ok() && !execution_complete_ && !path_became_invalid_)
   {
     r.sleep();
-    // check the path if there was an environment update in the meantime
-    if (new_scene_update_)
+    // check the path if there was an environment update in the meantime, or changes remain to be checked for the
+    // waypoints entering the monitoring horizon
+    if (new_scene_update_ || !changed_regions_.empty())
     {
       new_scene_update_ = false;
       std::pair<int, int> current_index = trajectory_execution_manager_->getCurrentExpectedTrajectoryIndex();
-      if (!isRemainingPathValid(plan, current_index))
+      if (!isRemainingPathStillValid(plan, current_index))
       {
         ROS_INFO_NAMED("plan_execution", "Trajectory component '%s' is invalid after scene update",
                        plan.plan_components_[current_index.first].description_.c_str());
@@ -38,6 +38,9 @@
 #include <moveit/trajectory_processing/trajectory_tools.h>
 #include <moveit/collision_detection/collision_tools.h>
 #include <boost/algorithm/string/join.hpp>
+#include <boost/functional/hash.hpp>
+#include <geometric_shapes/shapes.h>
+#include <octomap/OcTree.h>
 
 #include <dynamic_reconfigure/server.h>
 #include <moveit_ros_planning/SenseForPlanDynamicReconfigureConfig.h>
@@ -63,6 +66,7 @@ private:
     owner_->setMaxCostSources(config.max_cost_sources);
     owner_->setMaxLookAttempts(config.max_look_attempts);
     owner_->setDiscardOverlappingCostSources(config.discard_overlapping_cost_sources);
+    owner_->setMaxMapUpdateWait(config.max_map_update_wait);
   }
 
   PlanWithSensing* owner_;
@@ -79,6 +83,7 @@ plan_execution::PlanWithSensing::PlanWithSensing(
 
   discard_overlapping_cost_sources_ = 0.8;
   max_cost_sources_ = 100;
+  max_map_update_wait_ = 1.0;
 
   // by default we do not display path cost sources
   display_cost_sources_ = false;
@@ -210,9 +215,13 @@ bool plan_execution::PlanWithSensing::computePlan(ExecutableMotionPlan& plan,
                "%u) at looking around.",
                cost, max_safe_path_cost, look_attempts, max_look_attempts);
 
+      const std::vector<std::size_t> signatures = getRegionSignatures(plan.planning_scene_monitor_, cost_sources);
       bool looked_at_result = lookAt(cost_sources, plan.planning_scene_->getPlanningFrame());
       if (looked_at_result)
+      {
+        waitForRegionUpdates(plan.planning_scene_monitor_, cost_sources, signatures);
         ROS_INFO("Sensor was successfully actuated. Attempting to recompute a motion plan.");
+      }
       else
       {
         if (look_around_failed)
@@ -277,3 +286,99 @@ bool plan_execution::PlanWithSensing::lookAt(const std::set<collision_detection:
     }
   return false;
 }
+
+std::vector<std::size_t> plan_execution::PlanWithSensing::getRegionSignatures(
+    const planning_scene_monitor::PlanningSceneMonitorPtr& psm,
+    const std::set<collision_detection::CostSource>& cost_sources) const
+{
+  std::vector<std::size_t> signatures;
+  if (!psm)
+    return signatures;
+
+  planning_scene_monitor::LockedPlanningSceneRO lscene(psm);
+  collision_detection::World::ObjectConstPtr map =
+      lscene->getWorld()->getObject(planning_scene::PlanningScene::OCTOMAP_NS);
+  if (!map || map->shapes_.size() != 1)
+    return signatures;
+  const std::shared_ptr<const octomap::OcTree>& octree =
+      static_cast<const shapes::OcTree*>(map->shapes_[0].get())->octree;
+  if (!octree)
+    return signatures;
+
+  // the cost sources are in the planning frame, the octree in the frame of the octomap object
+  const Eigen::Isometry3d to_map = map->global_shape_poses_[0].inverse();
+  signatures.reserve(cost_sources.size());
+  for (const collision_detection::CostSource& source : cost_sources)
+  {
+    const Eigen::AlignedBox3d source_box(Eigen::Vector3d(source.aabb_min[0], source.aabb_min[1], source.aabb_min[2]),
+                                         Eigen::Vector3d(source.aabb_max[0], source.aabb_max[1], source.aabb_max[2]));
+    Eigen::AlignedBox3d box;
+    for (int corner = 0; corner < 8; ++corner)
+      box.extend(to_map * source_box.corner(static_cast<Eigen::AlignedBox3d::CornerType>(corner)));
+
+    // every integrated measurement changes the log-odds of the leaves it hits, unless they are clamped already
+    std::size_t signature = 0;
+    const octomap::point3d min(box.min().x(), box.min().y(), box.min().z());
+    const octomap::point3d max(box.max().x(), box.max().y(), box.max().z());
+    for (auto it = octree->begin_leafs_bbx(min, max), end = octree->end_leafs_bbx(); it != end; ++it)
+    {
+      const octomap::OcTreeKey key = it.getKey();
+      boost::hash_combine(signature, key[0]);
+      boost::hash_combine(signature, key[1]);
+      boost::hash_combine(signature, key[2]);
+      boost::hash_combine(signature, it.getDepth());
+      boost::hash_combine(signature, it->getLogOdds());
+    }
+    signatures.push_back(signature);
+  }
+  return signatures;
+}
+
+void plan_execution::PlanWithSensing::waitForRegionUpdates(
+    const planning_scene_monitor::PlanningSceneMonitorPtr& psm,
+    const std::set<collision_detection::CostSource>& cost_sources, const std::vector<std::size_t>& signatures) const
+{
+  if (signatures.empty() || max_map_update_wait_ <= 0.0)
+    return;
+
+  // the map may have been updated while the sensor moved
+  std::vector<bool> pending(signatures.size(), true);
+  std::size_t pending_count = signatures.size();
+  std::uint64_t version = psm->getOctomapVersion();
+  bool first_check = true;
+  const ros::WallTime deadline = ros::WallTime::now() + ros::WallDuration(max_map_update_wait_);
+  do
+  {
+    if (!first_check)
+    {
+      ros::WallDuration(0.01).sleep();
+      if (psm->getOctomapVersion() == version)
+        continue;
+      version = psm->getOctomapVersion();
+    }
+
+    const std::vector<std::size_t> current = getRegionSignatures(psm, cost_sources);
+    if (current.size() != signatures.size())
+      return;  // the octomap was removed
+    std::size_t refreshed = 0;
+    for (std::size_t i = 0; i < signatures.size(); ++i)
+      if (pending[i] && current[i] != signatures[i])
+      {
+        pending[i] = false;
+        ++refreshed;
+      }
+    pending_count -= refreshed;
+
+    // once an update refreshes no further region, the remaining ones are out of view of the sensor
+    if (pending_count == 0 || (refreshed == 0 && pending_count < signatures.size()))
+    {
+      ROS_DEBUG("The octomap refreshed %zu of %zu cost source regions after looking around.",
+                signatures.size() - pending_count, signatures.size());
+      return;
+    }
+    first_check = false;
+  } while (ros::WallTime::now() < deadline);
+
+  ROS_DEBUG("The octomap refreshed %zu of %zu cost source regions within %lf seconds after looking around.",
+            signatures.size() - pending_count, signatures.size(), max_map_update_wait_);
+}
@@ -0,0 +1,97 @@
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2026, PickNik LLC.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of PickNik LLC nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *********************************************************************/
+
+/* Computes a reachability map for the IK solver of a group and writes it to a file that
+   pick_place loads through its ~reachability_maps parameter */
+
+#include <moveit/robot_model_loader/robot_model_loader.h>
+#include <moveit/kinematics_metrics/reachability_map.h>
+#include <ros/ros.h>
+#include <boost/lexical_cast.hpp>
+
+static const std::string ROBOT_DESCRIPTION = "robot_description";
+
+int main(int argc, char** argv)
+{
+  ros::init(argc, argv, "compute_reachability_map");
+
+  ros::AsyncSpinner spinner(1);
+  spinner.start();
+
+  if (argc <= 2)
+    ROS_ERROR("Usage: moveit_compute_reachability_map <group> <file> [radius] [resolution] [threads]");
+  else
+  {
+    robot_model_loader::RobotModelLoader rml(ROBOT_DESCRIPTION);
+    std::string group = argv[1];
+    std::string filename = argv[2];
+
+    kinematics_metrics::ReachabilityMap::Options options;
+    try
+    {
+      if (argc > 3)
+        options.radius = boost::lexical_cast<double>(argv[3]);
+      if (argc > 4)
+        options.resolution = boost::lexical_cast<double>(argv[4]);
+      if (argc > 5)
+        options.threads = boost::lexical_cast<unsigned int>(argv[5]);
+    }
+    catch (boost::bad_lexical_cast& e)
+    {
+      ROS_ERROR("Invalid argument: %s", e.what());
+      ros::shutdown();
+      return 1;
+    }
+
+    const moveit::core::JointModelGroup* jmg = rml.getModel()->getJointModelGroup(group);
+    if (jmg)
+    {
+      ROS_INFO_STREAM("Computing reachability map for " << group << " (radius " << options.radius << ", resolution "
+                                                        << options.resolution << ")");
+      kinematics_metrics::ReachabilityMap map;
+      ros::WallTime start = ros::WallTime::now();
+      if (map.compute(jmg, options))
+      {
+        ROS_INFO("Computed reachability map in %lf seconds", (ros::WallTime::now() - start).toSec());
+        if (map.saveToFile(filename))
+          ROS_INFO_STREAM("Wrote reachability map to " << filename);
+        else
+          ROS_ERROR_STREAM("Unable to write reachability map to " << filename);
+      }
+    }
+  }
+
+  ros::shutdown();
+  return 0;
+}
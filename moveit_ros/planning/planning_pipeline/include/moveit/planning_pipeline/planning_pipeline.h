@@ -42,7 +42,9 @@
 #include <ros/ros.h>
 
 #include <atomic>
+#include <map>
 #include <memory>
+#include <mutex>
 
 /** \brief Planning pipeline */
 namespace planning_pipeline
@@ -68,6 +70,10 @@ public:
    * this topic (visualization_msgs::MarkerArray) */
   static const std::string MOTION_CONTACTS_TOPIC;
 
+  /** \brief Aggregated wall times of the pipeline stages (see MotionPlanResponse::stage_description_) are periodically
+   * published on this topic as histograms (diagnostic_msgs::DiagnosticArray) */
+  static const std::string PLANNING_METRICS_TOPIC;
+
   /** \brief Given a robot model (\e model), a node handle (\e pipeline_nh), initialize the planning pipeline.
       \param model The robot model for which this pipeline is initialized.
       \param pipeline_nh The ROS node handle that should be used for reading parameters needed for configuration
@@ -102,6 +108,19 @@ public:
    * This is true by default.  */
   void checkSolutionPaths(bool flag);
 
+  /** \brief Pass a flag telling the pipeline whether or not to memoize collision checks and constraint evaluations
+   * for the duration of each planning query, so the planning request adapters, the planner and the recheck of the
+   * solution path do not repeat them for the same states. Default is false. */
+  void cacheStateValidity(bool flag)
+  {
+    cache_state_validity_ = flag;
+  }
+
+  /** \brief Publish the wall times of the pipeline stages, aggregated over all queries answered in the last \e period
+   * seconds, on PLANNING_METRICS_TOPIC. A period of 0 disables publishing. Read from the ~planning_metrics_period
+   * parameter, default is 10 seconds. */
+  void publishPlanningMetrics(double period);
+
   /** \brief Get the flag set by displayComputedMotionPlans() */
   bool getDisplayComputedMotionPlans() const
   {
@@ -120,6 +139,12 @@ public:
     return check_solution_paths_;
   }
 
+  /** \brief Get the flag set by cacheStateValidity() */
+  bool getCacheStateValidity() const
+  {
+    return cache_state_validity_;
+  }
+
   /** \brief Call the motion planner plugin and the sequence of planning request adapters (if any).
       \param planning_scene The planning scene where motion planning is to be done
       \param req The request for motion planning
@@ -176,6 +201,18 @@ public:
 private:
   void configure();
 
+  /// Add the stage timings of a finished query to the aggregated metrics, publishing them if the period elapsed
+  void recordPlanningMetrics(const planning_interface::MotionPlanResponse& res, double total_time) const;
+
+  /// Aggregated wall times of one stage of the pipeline
+  struct StageMetrics
+  {
+    std::size_t count = 0;
+    double total_time = 0.0;
+    double max_time = 0.0;
+    std::vector<std::size_t> histogram;
+  };
+
   // Flag that indicates whether or not the planning pipeline is currently solving a planning problem
   mutable std::atomic<bool> active_;
 
@@ -207,6 +244,16 @@ private:
   /// Flag indicating whether the reported plans should be checked once again, by the planning pipeline itself
   bool check_solution_paths_;
   ros::Publisher contacts_publisher_;
+
+  /// Flag indicating whether validity checks are memoized within each planning query
+  bool cache_state_validity_;
+
+  /// Period [s] at which aggregated stage timings are published, 0 if disabled
+  double metrics_period_;
+  ros::Publisher metrics_publisher_;
+  mutable std::mutex metrics_lock_;
+  mutable std::map<std::string, StageMetrics> stage_metrics_;
+  mutable ros::WallTime metrics_window_start_;
 };
 
 MOVEIT_CLASS_FORWARD(PlanningPipeline);  // Defines PlanningPipelinePtr, ConstPtr, WeakPtr... etc
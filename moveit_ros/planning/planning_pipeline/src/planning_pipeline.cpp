@@ -38,15 +38,26 @@
 #include <moveit/robot_state/conversions.h>
 #include <moveit/collision_detection/collision_tools.h>
 #include <moveit/trajectory_processing/trajectory_tools.h>
+#include <moveit/profiler/trace.h>
 #include <moveit_msgs/DisplayTrajectory.h>
+#include <diagnostic_msgs/DiagnosticArray.h>
 #include <visualization_msgs/MarkerArray.h>
 #include <boost/tokenizer.hpp>
 #include <boost/algorithm/string/join.hpp>
+#include <algorithm>
 #include <sstream>
 
 const std::string planning_pipeline::PlanningPipeline::DISPLAY_PATH_TOPIC = "display_planned_path";
 const std::string planning_pipeline::PlanningPipeline::MOTION_PLAN_REQUEST_TOPIC = "motion_plan_request";
 const std::string planning_pipeline::PlanningPipeline::MOTION_CONTACTS_TOPIC = "display_contacts";
+const std::string planning_pipeline::PlanningPipeline::PLANNING_METRICS_TOPIC = "planning_pipeline_metrics";
+
+namespace
+{
+// Upper bounds [s] of the buckets of the stage time histograms; the last bucket collects everything above
+const std::vector<double> HISTOGRAM_BOUNDS = { 0.001, 0.002, 0.005, 0.01, 0.02, 0.05, 0.1,
+                                               0.2,   0.5,   1.0,   2.0,  5.0,  10.0 };
+}  // namespace
 
 planning_pipeline::PlanningPipeline::PlanningPipeline(const moveit::core::RobotModelConstPtr& model,
                                                       const ros::NodeHandle& pipeline_nh,
@@ -89,6 +100,8 @@ void planning_pipeline::PlanningPipeline::configure()
   check_solution_paths_ = false;  // this is set to true below
   publish_received_requests_ = false;
   display_computed_motion_plans_ = false;  // this is set to true below
+  cache_state_validity_ = false;
+  metrics_period_ = 0.0;
 
   // load the planning plugin
   try
@@ -177,6 +190,10 @@ void planning_pipeline::PlanningPipeline::configure()
   }
   displayComputedMotionPlans(true);
   checkSolutionPaths(true);
+
+  double metrics_period;
+  pipeline_nh_.param("planning_metrics_period", metrics_period, 10.0);
+  publishPlanningMetrics(metrics_period);
 }
 
 void planning_pipeline::PlanningPipeline::displayComputedMotionPlans(bool flag)
@@ -207,6 +224,79 @@ void planning_pipeline::PlanningPipeline::checkSolutionPaths(bool flag)
   check_solution_paths_ = flag;
 }
 
+void planning_pipeline::PlanningPipeline::publishPlanningMetrics(double period)
+{
+  std::lock_guard<std::mutex> lock(metrics_lock_);
+  if (metrics_period_ > 0.0 && period <= 0.0)
+    metrics_publisher_.shutdown();
+  else if (metrics_period_ <= 0.0 && period > 0.0)
+    metrics_publisher_ = private_nh_.advertise<diagnostic_msgs::DiagnosticArray>(PLANNING_METRICS_TOPIC, 10);
+  metrics_period_ = std::max(0.0, period);
+  stage_metrics_.clear();
+  metrics_window_start_ = ros::WallTime::now();
+}
+
+void planning_pipeline::PlanningPipeline::recordPlanningMetrics(const planning_interface::MotionPlanResponse& res,
+                                                                double total_time) const
+{
+  std::lock_guard<std::mutex> lock(metrics_lock_);
+  if (metrics_period_ <= 0.0)
+    return;
+
+  auto record = [this](const std::string& stage, double time) {
+    StageMetrics& metrics = stage_metrics_[stage];
+    if (metrics.histogram.empty())
+      metrics.histogram.resize(HISTOGRAM_BOUNDS.size() + 1, 0);
+    ++metrics.count;
+    metrics.total_time += time;
+    metrics.max_time = std::max(metrics.max_time, time);
+    ++metrics.histogram[std::lower_bound(HISTOGRAM_BOUNDS.begin(), HISTOGRAM_BOUNDS.end(), time) -
+                        HISTOGRAM_BOUNDS.begin()];
+  };
+  for (std::size_t i = 0; i < res.stage_description_.size() && i < res.stage_time_.size(); ++i)
+    record(res.stage_description_[i], res.stage_time_[i]);
+  record("total", total_time);
+
+  ros::WallTime now = ros::WallTime::now();
+  if ((now - metrics_window_start_).toSec() < metrics_period_)
+    return;
+
+  diagnostic_msgs::DiagnosticArray msg;
+  msg.header.stamp = ros::Time::now();
+  for (const std::pair<const std::string, StageMetrics>& stage : stage_metrics_)
+  {
+    diagnostic_msgs::DiagnosticStatus status;
+    status.level = diagnostic_msgs::DiagnosticStatus::OK;
+    status.name = pipeline_nh_.getNamespace() + ": " + stage.first;
+    status.hardware_id = planner_plugin_name_;
+    auto add_value = [&status](const std::string& key, const std::string& value) {
+      diagnostic_msgs::KeyValue kv;
+      kv.key = key;
+      kv.value = value;
+      status.values.push_back(kv);
+    };
+    const StageMetrics& metrics = stage.second;
+    add_value("count", std::to_string(metrics.count));
+    add_value("mean", std::to_string(metrics.total_time / metrics.count));
+    add_value("max", std::to_string(metrics.max_time));
+    for (std::size_t i = 0; i < metrics.histogram.size(); ++i)
+    {
+      std::stringstream bucket;
+      if (i < HISTOGRAM_BOUNDS.size())
+        bucket << "<= " << HISTOGRAM_BOUNDS[i];
+      else
+        bucket << "> " << HISTOGRAM_BOUNDS.back();
+      add_value(bucket.str(), std::to_string(metrics.histogram[i]));
+    }
+    status.message = std::to_string(metrics.count) + " samples in the last " +
+                     std::to_string((now - metrics_window_start_).toSec()) + " s";
+    msg.status.push_back(status);
+  }
+  metrics_publisher_.publish(msg);
+  stage_metrics_.clear();
+  metrics_window_start_ = now;
+}
+
 bool planning_pipeline::PlanningPipeline::generatePlan(const planning_scene::PlanningSceneConstPtr& planning_scene,
                                                        const planning_interface::MotionPlanRequest& req,
                                                        planning_interface::MotionPlanResponse& res) const
@@ -220,6 +310,8 @@ bool planning_pipeline::PlanningPipeline::generatePlan(const planning_scene::Pla
                                                        planning_interface::MotionPlanResponse& res,
                                                        std::vector<std::size_t>& adapter_added_state_index) const
 {
+  MOVEIT_TRACE_ZONE("PlanningPipeline::generatePlan");
+  ros::WallTime start = ros::WallTime::now();
   // Set planning pipeline active
   active_ = true;
 
@@ -236,12 +328,25 @@ bool planning_pipeline::PlanningPipeline::generatePlan(const planning_scene::Pla
     return false;
   }
 
+  // run the query on a diff of the scene that memoizes validity checks, if requested; the cache lives as long as
+  // the query, so results never outlive the scene they were computed for
+  planning_scene::PlanningSceneConstPtr scene = planning_scene;
+  if (cache_state_validity_)
+  {
+    ros::WallTime diff_start = ros::WallTime::now();
+    planning_scene::PlanningScenePtr cached_scene = planning_scene->diff();
+    cached_scene->setStateValidityCache(std::make_shared<planning_scene::StateValidityCache>());
+    scene = cached_scene;
+    res.addStageTime("scene diff", (ros::WallTime::now() - diff_start).toSec());
+  }
+
   bool solved = false;
   try
   {
+    MOVEIT_TRACE_ZONE("PlanningPipeline::plan");
     if (adapter_chain_)
     {
-      solved = adapter_chain_->adaptAndPlan(planner_instance_, planning_scene, req, res, adapter_added_state_index);
+      solved = adapter_chain_->adaptAndPlan(planner_instance_, scene, req, res, adapter_added_state_index);
       if (!adapter_added_state_index.empty())
       {
         std::stringstream ss;
@@ -252,9 +357,13 @@ bool planning_pipeline::PlanningPipeline::generatePlan(const planning_scene::Pla
     }
     else
     {
+      ros::WallTime setup_start = ros::WallTime::now();
       planning_interface::PlanningContextPtr context =
-          planner_instance_->getPlanningContext(planning_scene, req, res.error_code_);
+          planner_instance_->getPlanningContext(scene, req, res.error_code_);
+      ros::WallTime solve_start = ros::WallTime::now();
+      res.addStageTime("planning context setup", (solve_start - setup_start).toSec());
       solved = context ? context->solve(res) : false;
+      res.addStageTime("solve", (ros::WallTime::now() - solve_start).toSec());
     }
   }
   catch (std::exception& ex)
@@ -272,13 +381,14 @@ bool planning_pipeline::PlanningPipeline::generatePlan(const planning_scene::Pla
     ROS_DEBUG_STREAM("Motion planner reported a solution path with " << state_count << " states");
     if (check_solution_paths_)
     {
+      ros::WallTime check_start = ros::WallTime::now();
       visualization_msgs::MarkerArray arr;
       visualization_msgs::Marker m;
       m.action = visualization_msgs::Marker::DELETEALL;
       arr.markers.push_back(m);
 
       std::vector<std::size_t> index;
-      if (!planning_scene->isPathValid(*res.trajectory_, req.path_constraints, req.group_name, false, &index))
+      if (!scene->isPathValid(*res.trajectory_, req.path_constraints, req.group_name, false, &index))
       {
         // check to see if there is any problem with the states that are found to be invalid
         // they are considered ok if they were added by a planning request adapter
@@ -318,7 +428,7 @@ bool planning_pipeline::PlanningPipeline::generatePlan(const planning_scene::Pla
             {
               // check validity with verbose on
               const moveit::core::RobotState& robot_state = res.trajectory_->getWayPoint(it);
-              planning_scene->isStateValid(robot_state, req.path_constraints, req.group_name, true);
+              scene->isStateValid(robot_state, req.path_constraints, req.group_name, true);
 
               // compute the contacts if any
               collision_detection::CollisionRequest c_req;
@@ -327,12 +437,11 @@ bool planning_pipeline::PlanningPipeline::generatePlan(const planning_scene::Pla
               c_req.max_contacts = 10;
               c_req.max_contacts_per_pair = 3;
               c_req.verbose = false;
-              planning_scene->checkCollision(c_req, c_res, robot_state);
+              scene->checkCollision(c_req, c_res, robot_state);
               if (c_res.contact_count > 0)
               {
                 visualization_msgs::MarkerArray arr_i;
-                collision_detection::getCollisionMarkersFromContacts(arr_i, planning_scene->getPlanningFrame(),
-                                                                     c_res.contacts);
+                collision_detection::getCollisionMarkersFromContacts(arr_i, scene->getPlanningFrame(), c_res.contacts);
                 arr.markers.insert(arr.markers.end(), arr_i.markers.begin(), arr_i.markers.end());
               }
             }
@@ -346,6 +455,7 @@ bool planning_pipeline::PlanningPipeline::generatePlan(const planning_scene::Pla
       else
         ROS_DEBUG("Planned path was found to be valid when rechecked");
       contacts_publisher_.publish(arr);
+      res.addStageTime("path check", (ros::WallTime::now() - check_start).toSec());
     }
   }
 
@@ -377,6 +487,7 @@ bool planning_pipeline::PlanningPipeline::generatePlan(const planning_scene::Pla
                "unusual. Are you using a move_group_interface and forgetting to call clearPoseTargets() or "
                "equivalent?");
   }
+  recordPlanningMetrics(res, (ros::WallTime::now() - start).toSec());
   // Set planning pipeline to inactive
   active_ = false;
   return solved && valid;
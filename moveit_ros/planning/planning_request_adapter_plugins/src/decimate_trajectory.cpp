@@ -0,0 +1,125 @@
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2026, PickNik LLC.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of PickNik LLC nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *********************************************************************/
+
+#include <moveit/planning_request_adapter/planning_request_adapter.h>
+#include <moveit/trajectory_processing/decimate_trajectory.h>
+#include <class_loader/class_loader.hpp>
+#include <ros/ros.h>
+#include <algorithm>
+
+namespace default_planner_request_adapters
+{
+class DecimateTrajectory : public planning_request_adapter::PlanningRequestAdapter
+{
+public:
+  static const std::string JOINT_TOLERANCE_PARAM_NAME;
+  static const std::string CARTESIAN_TOLERANCE_PARAM_NAME;
+  static const std::string LINK_PARAM_NAME;
+
+  DecimateTrajectory() : planning_request_adapter::PlanningRequestAdapter()
+  {
+  }
+
+  void initialize(const ros::NodeHandle& nh) override
+  {
+    if (!nh.getParam(JOINT_TOLERANCE_PARAM_NAME, joint_tolerance_))
+    {
+      joint_tolerance_ = 0.001;
+      ROS_INFO_STREAM("Param '" << JOINT_TOLERANCE_PARAM_NAME
+                                << "' was not set. Using default value: " << joint_tolerance_);
+    }
+    else
+      ROS_INFO_STREAM("Param '" << JOINT_TOLERANCE_PARAM_NAME << "' was set to " << joint_tolerance_);
+
+    if (!nh.getParam(CARTESIAN_TOLERANCE_PARAM_NAME, cartesian_tolerance_))
+    {
+      cartesian_tolerance_ = 0.0;
+      ROS_INFO_STREAM("Param '" << CARTESIAN_TOLERANCE_PARAM_NAME
+                                << "' was not set. Using default value: " << cartesian_tolerance_);
+    }
+    else
+      ROS_INFO_STREAM("Param '" << CARTESIAN_TOLERANCE_PARAM_NAME << "' was set to " << cartesian_tolerance_);
+
+    nh.getParam(LINK_PARAM_NAME, link_name_);
+  }
+
+  std::string getDescription() const override
+  {
+    return "Decimate Trajectory";
+  }
+
+  bool adaptAndPlan(const PlannerFn& planner, const planning_scene::PlanningSceneConstPtr& planning_scene,
+                    const planning_interface::MotionPlanRequest& req, planning_interface::MotionPlanResponse& res,
+                    std::vector<std::size_t>& added_path_index) const override
+  {
+    bool result = planner(planning_scene, req, res);
+    if (result && res.trajectory_)
+    {
+      ROS_DEBUG("Running '%s'", getDescription().c_str());
+      std::vector<std::size_t> retained;
+      if (!trajectory_processing::decimateTrajectory(*res.trajectory_, joint_tolerance_, cartesian_tolerance_,
+                                                     link_name_, retained))
+      {
+        ROS_ERROR("Decimating the solution path failed.");
+        result = false;
+      }
+      else
+      {
+        // Map the indices of waypoints added by other adapters to the decimated trajectory, dropping removed ones
+        std::vector<std::size_t> retained_added_path_index;
+        for (std::size_t index : added_path_index)
+        {
+          auto it = std::lower_bound(retained.begin(), retained.end(), index);
+          if (it != retained.end() && *it == index)
+            retained_added_path_index.push_back(it - retained.begin());
+        }
+        added_path_index.swap(retained_added_path_index);
+      }
+    }
+    return result;
+  }
+
+private:
+  double joint_tolerance_;
+  double cartesian_tolerance_;
+  std::string link_name_;
+};
+
+const std::string DecimateTrajectory::JOINT_TOLERANCE_PARAM_NAME = "decimation_joint_tolerance";
+const std::string DecimateTrajectory::CARTESIAN_TOLERANCE_PARAM_NAME = "decimation_cartesian_tolerance";
+const std::string DecimateTrajectory::LINK_PARAM_NAME = "decimation_link";
+}  // namespace default_planner_request_adapters
+
+CLASS_LOADER_REGISTER_CLASS(default_planner_request_adapters::DecimateTrajectory,
+                            planning_request_adapter::PlanningRequestAdapter);
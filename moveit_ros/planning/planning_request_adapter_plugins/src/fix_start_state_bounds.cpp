@@ -77,6 +77,11 @@ public:
     return "Fix Start State Bounds";
   }
 
+  bool onlyFixesInvalidStartState() const override
+  {
+    return true;
+  }
+
   bool adaptAndPlan(const PlannerFn& planner, const planning_scene::PlanningSceneConstPtr& planning_scene,
                     const planning_interface::MotionPlanRequest& req, planning_interface::MotionPlanResponse& res,
                     std::vector<std::size_t>& added_path_index) const override
@@ -36,8 +36,12 @@
 
 #include <moveit/planning_request_adapter/planning_request_adapter.h>
 #include <moveit/robot_state/conversions.h>
+#include <moveit/robot_model/prismatic_joint_model.h>
+#include <moveit/robot_model/revolute_joint_model.h>
 #include <moveit/trajectory_processing/trajectory_tools.h>
 #include <class_loader/class_loader.hpp>
+#include <algorithm>
+#include <limits>
 #include <ros/ros.h>
 
 namespace default_planner_request_adapters
@@ -48,6 +52,7 @@ public:
   static const std::string DT_PARAM_NAME;
   static const std::string JIGGLE_PARAM_NAME;
   static const std::string ATTEMPTS_PARAM_NAME;
+  static const std::string REPAIR_STEPS_PARAM_NAME;
 
   FixStartStateCollision() : planning_request_adapter::PlanningRequestAdapter()
   {
@@ -85,6 +90,21 @@ public:
       }
       ROS_INFO_STREAM("Param '" << ATTEMPTS_PARAM_NAME << "' was set to " << sampling_attempts_);
     }
+
+    if (!nh.getParam(REPAIR_STEPS_PARAM_NAME, repair_steps_))
+    {
+      repair_steps_ = 10;
+      ROS_INFO_STREAM("Param '" << REPAIR_STEPS_PARAM_NAME << "' was not set. Using default value: " << repair_steps_);
+    }
+    else
+    {
+      if (repair_steps_ < 0)
+      {
+        repair_steps_ = 0;
+        ROS_WARN_STREAM("Param '" << REPAIR_STEPS_PARAM_NAME << "' needs to be at least 0.");
+      }
+      ROS_INFO_STREAM("Param '" << REPAIR_STEPS_PARAM_NAME << "' was set to " << repair_steps_);
+    }
   }
 
   std::string getDescription() const override
@@ -92,6 +112,11 @@ public:
     return "Fix Start State In Collision";
   }
 
+  bool onlyFixesInvalidStartState() const override
+  {
+    return true;
+  }
+
   bool adaptAndPlan(const PlannerFn& planner, const planning_scene::PlanningSceneConstPtr& planning_scene,
                     const planning_interface::MotionPlanRequest& req, planning_interface::MotionPlanResponse& res,
                     std::vector<std::size_t>& added_path_index) const override
@@ -127,7 +152,13 @@ public:
               planning_scene->getRobotModel()->getJointModelGroup(req.group_name)->getJointModels() :
               planning_scene->getRobotModel()->getJointModels();
 
-      bool found = false;
+      // first push the state out of collision along the contact normals, then fall back to random sampling
+      bool found = repairState(*planning_scene, creq, jmodels, start_state);
+      if (found)
+        ROS_INFO("Pushed the start state out of collision, to a distance of %lf", prefix_state->distance(start_state));
+      else
+        start_state = *prefix_state;
+
       for (int c = 0; !found && c < sampling_attempts_; ++c)
       {
         for (std::size_t i = 0; !found && i < jmodels.size(); ++i)
@@ -187,14 +218,145 @@ public:
   }
 
 private:
+  /** \brief Move \e state out of collision in at most repair_steps_ steps. Each step moves the links in contact
+      along the contact normals by the penetration depth, using the Jacobian transpose of the contact points
+      with respect to the single-axis joints among \e jmodels. Returns true if \e state ends up collision free. */
+  bool repairState(const planning_scene::PlanningScene& planning_scene,
+                   const collision_detection::CollisionRequest& creq,
+                   const std::vector<const moveit::core::JointModel*>& jmodels, moveit::core::RobotState& state) const
+  {
+    std::vector<const moveit::core::JointModel*> joints;
+    for (const moveit::core::JointModel* jmodel : jmodels)
+      if ((jmodel->getType() == moveit::core::JointModel::REVOLUTE ||
+           jmodel->getType() == moveit::core::JointModel::PRISMATIC) &&
+          !jmodel->getMimic())
+        joints.push_back(jmodel);
+    if (joints.empty() || repair_steps_ == 0)
+      return false;
+
+    collision_detection::CollisionRequest contact_req = creq;
+    contact_req.contacts = true;
+    contact_req.max_contacts = MAX_REPAIR_CONTACTS;
+    contact_req.max_contacts_per_pair = 1;
+
+    std::vector<Eigen::Matrix3Xd> jacobians;
+    std::vector<Eigen::Vector3d> pushes;
+    Eigen::VectorXd step(joints.size());
+    for (int s = 0; s < repair_steps_; ++s)
+    {
+      collision_detection::CollisionResult cres;
+      planning_scene.checkCollision(contact_req, cres, state);
+      if (!cres.collision)
+        return true;
+
+      jacobians.clear();
+      pushes.clear();
+      for (const auto& contact_pair : cres.contacts)
+        for (const collision_detection::Contact& contact : contact_pair.second)
+        {
+          // the normal points from body 1 to body 2, so the bodies are pushed apart in opposite directions
+          const Eigen::Vector3d push = contact.normal * (contact.depth + REPAIR_MARGIN);
+          addContactJacobian(state, joints, contact.body_name_1, contact.body_type_1, contact.pos, -push, jacobians,
+                             pushes);
+          addContactJacobian(state, joints, contact.body_name_2, contact.body_type_2, contact.pos, push, jacobians,
+                             pushes);
+        }
+
+      step.setZero();
+      for (std::size_t k = 0; k < jacobians.size(); ++k)
+        step += jacobians[k].transpose() * pushes[k];
+      // scale the step so the linearized motion of the contact points matches the pushes best
+      double num = 0.0, den = 0.0;
+      for (std::size_t k = 0; k < jacobians.size(); ++k)
+      {
+        const Eigen::Vector3d motion = jacobians[k] * step;
+        num += pushes[k].dot(motion);
+        den += motion.squaredNorm();
+      }
+      if (den < std::numeric_limits<double>::epsilon())
+        return false;
+      step *= num / den;
+
+      for (std::size_t i = 0; i < joints.size(); ++i)
+      {
+        // stay within the neighborhood random sampling would explore
+        const double max_step = joints[i]->getMaximumExtent() * jiggle_fraction_;
+        double value = state.getJointPositions(joints[i])[0] + std::max(-max_step, std::min(max_step, step[i]));
+        state.setJointPositions(joints[i], &value);
+        state.enforceBounds(joints[i]);
+      }
+      state.update();
+    }
+
+    collision_detection::CollisionResult cres;
+    planning_scene.checkCollision(creq, cres, state);
+    return !cres.collision;
+  }
+
+  /** \brief Append the Jacobian of \e point on the robot link (or the link \e body is attached to) with respect to
+      \e joints, together with the desired displacement \e push of the point. Bodies not moved by \e joints are
+      skipped. */
+  static void addContactJacobian(const moveit::core::RobotState& state,
+                                 const std::vector<const moveit::core::JointModel*>& joints, const std::string& body,
+                                 collision_detection::BodyType type, const Eigen::Vector3d& point,
+                                 const Eigen::Vector3d& push, std::vector<Eigen::Matrix3Xd>& jacobians,
+                                 std::vector<Eigen::Vector3d>& pushes)
+  {
+    const moveit::core::LinkModel* link = nullptr;
+    if (type == collision_detection::BodyTypes::ROBOT_LINK)
+      link = state.getRobotModel()->getLinkModel(body);
+    else if (type == collision_detection::BodyTypes::ROBOT_ATTACHED)
+    {
+      const moveit::core::AttachedBody* attached_body = state.getAttachedBody(body);
+      if (attached_body)
+        link = attached_body->getAttachedLink();
+    }
+    if (!link)
+      return;
+
+    Eigen::Matrix3Xd jacobian = Eigen::Matrix3Xd::Zero(3, joints.size());
+    bool moved = false;
+    for (; link; link = link->getParentLinkModel())
+    {
+      const moveit::core::JointModel* jmodel = link->getParentJointModel();
+      auto it = std::find(joints.begin(), joints.end(), jmodel);
+      if (it == joints.end())
+        continue;
+      // the joint axis is expressed in the frame of the joint's child link
+      const Eigen::Isometry3d& frame = state.getGlobalLinkTransform(link);
+      if (jmodel->getType() == moveit::core::JointModel::REVOLUTE)
+      {
+        const Eigen::Vector3d axis =
+            frame.linear() * static_cast<const moveit::core::RevoluteJointModel*>(jmodel)->getAxis();
+        jacobian.col(it - joints.begin()) = axis.cross(point - frame.translation());
+      }
+      else
+        jacobian.col(it - joints.begin()) =
+            frame.linear() * static_cast<const moveit::core::PrismaticJointModel*>(jmodel)->getAxis();
+      moved = true;
+    }
+    if (moved)
+    {
+      jacobians.push_back(jacobian);
+      pushes.push_back(push);
+    }
+  }
+
+  /** \brief Number of contacts used per repair step */
+  static constexpr std::size_t MAX_REPAIR_CONTACTS = 32;
+  /** \brief Distance [m] the contact points are pushed beyond the penetration depth */
+  static constexpr double REPAIR_MARGIN = 1e-3;
+
   double max_dt_offset_;
   double jiggle_fraction_;
   int sampling_attempts_;
+  int repair_steps_;
 };
 
 const std::string FixStartStateCollision::DT_PARAM_NAME = "start_state_max_dt";
 const std::string FixStartStateCollision::JIGGLE_PARAM_NAME = "jiggle_fraction";
 const std::string FixStartStateCollision::ATTEMPTS_PARAM_NAME = "max_sampling_attempts";
+const std::string FixStartStateCollision::REPAIR_STEPS_PARAM_NAME = "max_repair_steps";
 }  // namespace default_planner_request_adapters
 
 CLASS_LOADER_REGISTER_CLASS(default_planner_request_adapters::FixStartStateCollision,
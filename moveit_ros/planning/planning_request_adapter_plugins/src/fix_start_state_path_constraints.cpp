@@ -59,6 +59,11 @@ public:
     return "Fix Start State Path Constraints";
   }
 
+  bool onlyFixesInvalidStartState() const override
+  {
+    return true;
+  }
+
   bool adaptAndPlan(const PlannerFn& planner, const planning_scene::PlanningSceneConstPtr& planning_scene,
                     const planning_interface::MotionPlanRequest& req, planning_interface::MotionPlanResponse& res,
                     std::vector<std::size_t>& added_path_index) const override
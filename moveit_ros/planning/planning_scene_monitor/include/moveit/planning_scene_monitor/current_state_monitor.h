@@ -43,6 +43,9 @@
 #include <boost/function.hpp>
 #include <boost/thread/mutex.hpp>
 #include <boost/thread/condition_variable.hpp>
+#include <atomic>
+#include <deque>
+#include <memory>
 
 namespace planning_scene_monitor
 {
@@ -151,6 +154,9 @@ public:
   }
 
   /** @brief Get the current state
+   *
+   *  This and the other functions reading the current state do not lock, so they neither block nor are blocked by
+   *  the ingestion of joint states; they always return a consistent state of a single update.
    *  @return Returns the current state */
   moveit::core::RobotStatePtr getCurrentState() const;
 
@@ -168,6 +174,18 @@ public:
    *  @return Returns the map from joint names to joint state values*/
   std::map<std::string, double> getCurrentStateValues() const;
 
+  /** @brief Keep the states received within \e duration before the most recent one, so getStateAtTime() can look up
+   *  past states. A zero duration (the default) disables the history. */
+  void setStateHistoryDuration(const ros::Duration& duration);
+
+  /** @brief Get the duration of the state history (zero if disabled) */
+  ros::Duration getStateHistoryDuration() const;
+
+  /** @brief Set the positions of \e state to the robot state at time \e t, interpolated between the two closest
+   *  states of the history
+   *  @return False if \e t is not covered by the history (e.g. no state with a newer stamp was received yet) */
+  bool getStateAtTime(const ros::Time& t, moveit::core::RobotState& state) const;
+
   /** @brief Wait for at most \e wait_time seconds (default 1s) for a robot state more recent than t
    *  @return true on success, false if up-to-date robot state wasn't received within \e wait_time
    */
@@ -226,11 +244,25 @@ private:
   void jointStateCallback(const sensor_msgs::JointStateConstPtr& joint_state);
   void tfCallback();
 
+  /** @brief Publish robot_state_ and current_state_time_ to the lock-free readers. Requires state_update_lock_ */
+  void publishState();
+
+  /** @brief Read the state published last. \e values receives the positions, velocities and efforts of all
+   *  variables, one after another */
+  ros::Time readState(std::vector<double>& values, bool& has_velocities, bool& has_efforts) const;
+
+  /** @brief Append robot_state_ to the state history, if enabled. Requires state_update_lock_ */
+  void recordState();
+
   ros::NodeHandle nh_;
   std::shared_ptr<tf2_ros::Buffer> tf_buffer_;
   moveit::core::RobotModelConstPtr robot_model_;
   moveit::core::RobotState robot_state_;
-  std::map<const moveit::core::JointModel*, ros::Time> joint_time_;
+  // time of the last update of each joint, indexed by joint index; ros::Time(0) also marks static transforms
+  std::vector<ros::Time> joint_time_;
+  std::vector<bool> joint_received_;  // whether joint_time_ was set
+  // joint models for the name order of the last joint state message, protected by state_update_lock_
+  moveit::core::JointNameMapping joint_state_mapping_;
   bool state_monitor_started_;
   bool copy_dynamics_;  // Copy velocity and effort from joint_state
   ros::Time monitor_start_time_;
@@ -240,6 +272,19 @@ private:
 
   mutable boost::mutex state_update_lock_;
   mutable boost::condition_variable state_update_condition_;
+
+  // seqlock-protected copy of robot_state_ for lock-free readers, written by publishState(): the sequence is odd
+  // while the copy is being written, readers retry until they read the same even sequence before and after copying
+  std::atomic<std::uint64_t> published_sequence_;
+  std::unique_ptr<std::atomic<double>[]> published_values_;  // positions, velocities, efforts
+  std::atomic<std::uint64_t> published_time_;                 // current_state_time_ in nanoseconds
+  std::atomic<bool> published_velocities_;
+  std::atomic<bool> published_efforts_;
+
+  // variable positions of past states, sorted by stamp
+  std::deque<std::pair<ros::Time, std::vector<double>>> state_history_;
+  ros::Duration state_history_duration_;
+  mutable boost::mutex state_history_lock_;
   std::vector<JointStateUpdateCallback> update_callbacks_;
 
   std::shared_ptr<TFConnection> tf_connection_;
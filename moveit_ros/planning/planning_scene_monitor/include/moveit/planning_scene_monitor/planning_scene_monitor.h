@@ -49,6 +49,8 @@
 #include <boost/noncopyable.hpp>
 #include <boost/thread/shared_mutex.hpp>
 #include <boost/thread/recursive_mutex.hpp>
+#include <atomic>
+#include <deque>
 #include <memory>
 
 namespace planning_scene_monitor
@@ -202,6 +204,16 @@ public:
     return scene_const_;
   }
 
+  /** @brief Get an immutable snapshot of the current planning scene.
+   *
+   * The returned scene is a parent-free copy of the monitored scene that is never modified afterwards, so it can be
+   * used without holding a lock for as long as needed, e.g. for the whole duration of a planning request, while the
+   * monitor keeps applying state, octomap and geometry updates to the live scene.
+   * A new snapshot is built only if the monitored scene changed since the last one was published; otherwise all
+   * callers share the same instance. Building a snapshot holds the read lock just for the time of the copy.
+   * @return The snapshot, or a null pointer if the monitor has no scene */
+  planning_scene::PlanningSceneConstPtr getPlanningSceneSnapshot();
+
   /** @brief Return true if the scene \e scene can be updated directly
       or indirectly by this monitor. This function will return true if
       the pointer of the scene is the same as the one maintained,
@@ -276,6 +288,21 @@ public:
     return publish_planning_scene_frequency_;
   }
 
+  /** \brief Start batching the updates received on the monitored topics and from the octomap monitor.
+      Instead of applying each message under its own write lock, the updates received within a time window are
+      applied in order under a single write lock, followed by a single update event. Consecutive octomap updates
+      within a window are collapsed into one. The window starts at \e min_window seconds; it grows towards
+      \e max_window as long as batches keep collecting more than one update and shrinks back when the load drops, so
+      isolated updates are applied with little latency. */
+  void startCoalescingSceneUpdates(double min_window = 0.005, double max_window = 0.1);
+
+  /** \brief Stop batching scene updates; pending updates are applied before this function returns */
+  void stopCoalescingSceneUpdates();
+
+  /** \brief Get the current length of the window in which scene updates are batched (seconds).
+      This is 0 if updates are not batched. */
+  double getSceneUpdateCoalescingWindow() const;
+
   /** @brief Get the stored instance of the stored current state monitor
    *  @return An instance of the stored current state monitor*/
   const CurrentStateMonitorPtr& getStateMonitor() const
@@ -381,6 +408,13 @@ public:
     return last_update_time_;
   }
 
+  /** \brief Return a counter that changes whenever the octomap of the monitored scene may have changed, so callers
+   *  waiting for new sensor data can poll it instead of inspecting the octree */
+  std::uint64_t getOctomapVersion() const
+  {
+    return octomap_version_;
+  }
+
   void publishDebugInformation(bool flag);
 
   /** @brief This function is called every time there is a change to the planning scene */
@@ -424,6 +458,20 @@ protected:
   /** @brief Configure the default padding*/
   void configureDefaultPadding();
 
+  /** @brief Apply a planning scene message to the monitored scene. The scene must be locked for writing.
+   *  @param scene The message to apply
+   *  @param update_type Set to the type of update the message caused
+   *  @return The result of PlanningScene::usePlanningSceneMsg() */
+  bool applyPlanningSceneMessage(const moveit_msgs::PlanningScene& scene, SceneUpdateType& update_type);
+
+  /** @brief Apply the current octomap of the octomap monitor to the monitored scene.
+   *  The scene must be locked for writing. */
+  void applyOctomapUpdate();
+
+  /** @brief Apply the update \e fn to the monitored scene, or queue it if updates are coalesced.
+   *  \e fn is called with the scene locked for writing and returns the type of update it caused */
+  void applySceneUpdate(const boost::function<SceneUpdateType()>& fn);
+
   /** @brief Callback for a new collision object msg*/
   void collisionObjectCallback(const moveit_msgs::CollisionObjectConstPtr& obj);
 
@@ -458,6 +506,9 @@ protected:
 
   bool getShapeTransformCache(const std::string& target_frame, const ros::Time& target_time,
                               occupancy_map_monitor::ShapeTransformCache& cache) const;
+  /// Compute the shape transforms for the robot in \e state, which is the robot state at \e target_time
+  bool getShapeTransformCache(const std::string& target_frame, const ros::Time& target_time,
+                              moveit::core::RobotState& state, occupancy_map_monitor::ShapeTransformCache& cache) const;
 
   /// The name of this scene monitor
   std::string monitor_name_;
@@ -469,6 +520,15 @@ protected:
   ros::Time last_update_time_;                     /// Last time the state was updated
   ros::Time last_robot_motion_time_;               /// Last time the robot has moved
 
+  /// last published snapshot of scene_, only accessed through std::atomic_load() / std::atomic_store()
+  planning_scene::PlanningSceneConstPtr scene_snapshot_;
+  std::atomic<std::uint64_t> scene_snapshot_version_;       /// value of scene_version_ scene_snapshot_ was built from
+  std::atomic<std::uint64_t> scene_version_;                /// incremented on every update of scene_
+  boost::mutex scene_snapshot_mutex_;                       /// serializes building new snapshots
+  std::shared_ptr<const octomap::OcTree> snapshot_octree_;  /// copy of the monitored octree shared by snapshots
+  std::uint64_t snapshot_octree_version_;                   /// value of octomap_version_ snapshot_octree_ copies
+  std::atomic<std::uint64_t> octomap_version_;              /// incremented on every octomap update
+
   ros::NodeHandle nh_;
   ros::NodeHandle root_nh_;
   ros::CallbackQueue queue_;
@@ -499,6 +559,16 @@ protected:
   SceneUpdateType new_scene_update_;
   boost::condition_variable_any new_scene_update_condition_;
 
+  // variables for coalescing scene updates, protected by coalesce_updates_mutex_
+  std::unique_ptr<boost::thread> coalesce_updates_;
+  mutable boost::mutex coalesce_updates_mutex_;
+  boost::condition_variable coalesce_updates_condition_;
+  std::deque<boost::function<SceneUpdateType()> > pending_scene_updates_;
+  bool pending_octomap_update_;
+  double coalesce_window_;
+  double coalesce_min_window_;
+  double coalesce_max_window_;
+
   // subscribe to various sources of data
   ros::Subscriber planning_scene_subscriber_;
   ros::Subscriber planning_scene_world_subscriber_;
@@ -535,11 +605,16 @@ protected:
                                                                            /// are received
 
 private:
-  void getUpdatedFrameTransforms(std::vector<geometry_msgs::TransformStamped>& transforms);
+  /** @brief Look up the transforms of the TF frames that are not robot links. Unless \e all_frames is set, only the
+   *  frames for which TF received new data since the last call are included. Requires frame_transforms_mutex_ */
+  void getUpdatedFrameTransforms(std::vector<geometry_msgs::TransformStamped>& transforms, bool all_frames);
 
   // publish planning scene update diffs (runs in its own thread)
   void scenePublishingThread();
 
+  // apply batches of queued scene updates (runs in its own thread)
+  void sceneUpdateCoalescingThread();
+
   // called by current_state_monitor_ when robot state (as monitored on joint state topic) changes
   void onStateUpdate(const sensor_msgs::JointStateConstPtr& joint_state);
 
@@ -569,6 +644,14 @@ private:
   // arriving so fast that it is preceding the transform state.
   ros::Duration shape_transform_cache_lookup_wait_time_;
 
+  /// state of the incremental updates of the scene's fixed frames in updateFrameTransforms()
+  // These fields are protected by frame_transforms_mutex_
+  boost::mutex frame_transforms_mutex_;
+  std::map<std::string, ros::Time> frame_stamps_;  // stamp of the last lookup of each TF frame
+  std::size_t tf_frame_count_;
+  const moveit::core::Transforms* frame_transforms_;  // the scene transforms updated last, and their version
+  std::uint64_t frame_transforms_version_;
+
   /// timer for state updates.
   // Check if last_state_update_ is true and if so call updateSceneWithCurrentState()
   // Not safe to access from callback functions.
@@ -605,7 +688,9 @@ private:
  * Any number of these "ReadOnly" locks can exist at a given time.
  * The intention is that users which only need to read from the
  * PlanningScene will use these and will thus not interfere with each
- * other.
+ * other. They do block updates of the monitored scene though, so
+ * long-running readers should prefer
+ * PlanningSceneMonitor::getPlanningSceneSnapshot().
  *
  * @see LockedPlanningSceneRW */
 class LockedPlanningSceneRO
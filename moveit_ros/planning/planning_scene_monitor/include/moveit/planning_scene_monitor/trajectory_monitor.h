@@ -40,6 +40,7 @@
 #include <moveit/planning_scene_monitor/current_state_monitor.h>
 #include <moveit/robot_trajectory/robot_trajectory.h>
 #include <boost/thread.hpp>
+#include <atomic>
 #include <memory>
 
 namespace planning_scene_monitor
@@ -49,7 +50,14 @@ using TrajectoryStateAddedCallback = boost::function<void(const moveit::core::Ro
 MOVEIT_CLASS_FORWARD(TrajectoryMonitor);  // Defines TrajectoryMonitorPtr, ConstPtr, WeakPtr... etc
 
 /** @class TrajectoryMonitor
-    @brief Monitors the joint_states topic and tf to record the trajectory of the robot. */
+    @brief Monitors the joint_states topic and tf to record the trajectory of the robot.
+
+    If the state monitor keeps a state history (CurrentStateMonitor::setStateHistoryDuration()), the recorded
+    positions are interpolated at exact multiples of the sampling period, independent of the timing of the recording
+    thread.
+
+    Only the joint positions and the time of each sample are recorded, into a preallocated buffer the recording thread
+    fills without locking. getTrajectory() converts them into a RobotTrajectory on demand, also while recording. */
 class TrajectoryMonitor
 {
 public:
@@ -74,16 +82,22 @@ public:
 
   void setSamplingFrequency(double sampling_frequency);
 
-  /// Return the current maintained trajectory. This function is not thread safe (hence NOT const), because the
-  /// trajectory could be modified.
-  const robot_trajectory::RobotTrajectory& getTrajectory()
-  {
-    return trajectory_;
-  }
+  /// Return the trajectory recorded so far. Safe to call while recording.
+  robot_trajectory::RobotTrajectory getTrajectory() const;
+
+  /// Move the recorded trajectory into \e other and start a new recording
+  void swapTrajectory(robot_trajectory::RobotTrajectory& other);
 
-  void swapTrajectory(robot_trajectory::RobotTrajectory& other)
+  /// Return the number of states recorded so far
+  std::size_t getRecordedStateCount() const;
+
+  /** @brief Keep at most \e max_states states, overwriting the oldest ones once the buffer is full. Zero (the default)
+   *  keeps all states, growing the buffer as needed. Clears the recorded trajectory. */
+  void setMaxRecordedStates(std::size_t max_states);
+
+  std::size_t getMaxRecordedStates() const
   {
-    trajectory_.swap(other);
+    return max_recorded_states_;
   }
 
   void setOnStateAddCallback(const TrajectoryStateAddedCallback& callback)
@@ -94,10 +108,30 @@ public:
 private:
   void recordStates();
 
+  /** @brief Append the positions of scratch_state_ at time \e t to the buffer. Only called by the recording thread. */
+  void recordState(const ros::Time& t);
+
+  /** @brief Record the states of the state monitor's history since the last recorded one
+   *  @return False if the history does not cover the next sample */
+  bool recordStatesFromHistory();
+
   CurrentStateMonitorConstPtr current_state_monitor_;
   double sampling_frequency_;
 
-  robot_trajectory::RobotTrajectory trajectory_;
+  // Samples are stored one after the other in a ring of buffer_capacity_ slots: positions_ holds the variable
+  // positions of all slots, times_ the time of each slot (in nanoseconds). recorded_ counts all samples since the last
+  // clear; it is only written by the recording thread, after the slot is complete. Once the ring wraps around, readers
+  // drop the slots that were overwritten while they copied them. Growing the buffer (without a limit on the number of
+  // states) and reading it for getTrajectory() are serialized by buffer_lock_.
+  std::size_t variable_count_;
+  std::size_t max_recorded_states_;
+  std::size_t buffer_capacity_;
+  std::unique_ptr<std::atomic<double>[]> positions_;
+  std::unique_ptr<std::atomic<std::uint64_t>[]> times_;
+  std::atomic<std::size_t> recorded_;
+  mutable boost::mutex buffer_lock_;
+  moveit::core::RobotState scratch_state_;
+
   ros::Time trajectory_start_time_;
   ros::Time last_recorded_state_time_;
 
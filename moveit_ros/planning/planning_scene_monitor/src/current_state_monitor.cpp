@@ -39,6 +39,8 @@
 #include <tf2_eigen/tf2_eigen.h>
 #include <tf2_geometry_msgs/tf2_geometry_msgs.h>
 
+#include <algorithm>
+#include <iterator>
 #include <limits>
 
 constexpr char LOGNAME[] = "current_state_monitor";
@@ -60,8 +62,16 @@ CurrentStateMonitor::CurrentStateMonitor(const moveit::core::RobotModelConstPtr&
   , state_monitor_started_(false)
   , copy_dynamics_(false)
   , error_(std::numeric_limits<double>::epsilon())
+  , published_sequence_(0)
+  , published_values_(new std::atomic<double>[3 * robot_model->getVariableCount()])
+  , published_time_(0)
+  , published_velocities_(false)
+  , published_efforts_(false)
 {
   robot_state_.setToDefaultValues();
+  joint_time_.resize(robot_model_->getJointModelCount());
+  joint_received_.resize(robot_model_->getJointModelCount(), false);
+  publishState();
 }
 
 CurrentStateMonitor::~CurrentStateMonitor()
@@ -69,59 +79,191 @@ CurrentStateMonitor::~CurrentStateMonitor()
   stopStateMonitor();
 }
 
+void CurrentStateMonitor::publishState()
+{
+  // writers are serialized by state_update_lock_, so only the readers need to detect the update
+  const std::size_t n = robot_model_->getVariableCount();
+  const bool has_velocities = robot_state_.hasVelocities();
+  const bool has_efforts = robot_state_.hasEffort();
+  published_sequence_.fetch_add(1, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_release);
+
+  const double* pos = robot_state_.getVariablePositions();
+  for (std::size_t i = 0; i < n; ++i)
+    published_values_[i].store(pos[i], std::memory_order_relaxed);
+  if (has_velocities)
+  {
+    const double* vel = robot_state_.getVariableVelocities();
+    for (std::size_t i = 0; i < n; ++i)
+      published_values_[n + i].store(vel[i], std::memory_order_relaxed);
+  }
+  if (has_efforts)
+  {
+    const double* eff = robot_state_.getVariableEffort();
+    for (std::size_t i = 0; i < n; ++i)
+      published_values_[2 * n + i].store(eff[i], std::memory_order_relaxed);
+  }
+  published_velocities_.store(has_velocities, std::memory_order_relaxed);
+  published_efforts_.store(has_efforts, std::memory_order_relaxed);
+  published_time_.store(current_state_time_.toNSec(), std::memory_order_relaxed);
+
+  published_sequence_.fetch_add(1, std::memory_order_release);
+
+  recordState();
+}
+
+void CurrentStateMonitor::recordState()
+{
+  boost::mutex::scoped_lock slock(state_history_lock_);
+  if (state_history_duration_.isZero())
+    return;
+
+  const double* pos = robot_state_.getVariablePositions();
+  const std::size_t n = robot_model_->getVariableCount();
+  if (!state_history_.empty() && state_history_.back().first == current_state_time_)
+  {
+    // a further update for the same stamp (e.g. from TF or a second joint state publisher)
+    std::copy(pos, pos + n, state_history_.back().second.begin());
+    return;
+  }
+
+  // reuse the buffer of the oldest state, if it expired
+  std::vector<double> positions;
+  if (!state_history_.empty() && state_history_.front().first + state_history_duration_ < current_state_time_)
+  {
+    positions.swap(state_history_.front().second);
+    state_history_.pop_front();
+  }
+  positions.assign(pos, pos + n);
+
+  // stamps of different publishers are not necessarily ordered
+  auto it = std::upper_bound(
+      state_history_.begin(), state_history_.end(), current_state_time_,
+      [](const ros::Time& t, const std::pair<ros::Time, std::vector<double>>& entry) { return t < entry.first; });
+  state_history_.emplace(it, current_state_time_, std::move(positions));
+
+  while (state_history_.front().first + state_history_duration_ < state_history_.back().first)
+    state_history_.pop_front();
+}
+
+void CurrentStateMonitor::setStateHistoryDuration(const ros::Duration& duration)
+{
+  boost::mutex::scoped_lock slock(state_history_lock_);
+  state_history_duration_ = duration;
+  if (duration.isZero())
+    state_history_.clear();
+}
+
+ros::Duration CurrentStateMonitor::getStateHistoryDuration() const
+{
+  boost::mutex::scoped_lock slock(state_history_lock_);
+  return state_history_duration_;
+}
+
+bool CurrentStateMonitor::getStateAtTime(const ros::Time& t, moveit::core::RobotState& state) const
+{
+  boost::mutex::scoped_lock slock(state_history_lock_);
+  if (state_history_.empty() || t < state_history_.front().first || t > state_history_.back().first)
+    return false;
+
+  // first state not older than t, which exists because t is within the history
+  auto after = std::lower_bound(
+      state_history_.begin(), state_history_.end(), t,
+      [](const std::pair<ros::Time, std::vector<double>>& entry, const ros::Time& t) { return entry.first < t; });
+  if (after->first == t)
+  {
+    state.setVariablePositions(after->second);
+    return true;
+  }
+
+  auto before = std::prev(after);
+  const double fraction = (t - before->first).toSec() / (after->first - before->first).toSec();
+  std::vector<double> positions(robot_model_->getVariableCount());
+  robot_model_->interpolate(before->second.data(), after->second.data(), fraction, positions.data());
+  state.setVariablePositions(positions);
+  return true;
+}
+
+ros::Time CurrentStateMonitor::readState(std::vector<double>& values, bool& has_velocities, bool& has_efforts) const
+{
+  const std::size_t n = 3 * robot_model_->getVariableCount();
+  values.resize(n);
+  std::uint64_t time = 0;
+  std::uint64_t sequence;
+  do
+  {
+    sequence = published_sequence_.load(std::memory_order_acquire);
+    if (sequence & 1)
+      continue;  // an update is being written
+    for (std::size_t i = 0; i < n; ++i)
+      values[i] = published_values_[i].load(std::memory_order_relaxed);
+    has_velocities = published_velocities_.load(std::memory_order_relaxed);
+    has_efforts = published_efforts_.load(std::memory_order_relaxed);
+    time = published_time_.load(std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_acquire);
+  } while ((sequence & 1) || sequence != published_sequence_.load(std::memory_order_relaxed));
+
+  ros::Time stamp;
+  stamp.fromNSec(time);
+  return stamp;
+}
+
 moveit::core::RobotStatePtr CurrentStateMonitor::getCurrentState() const
 {
-  boost::mutex::scoped_lock slock(state_update_lock_);
-  moveit::core::RobotState* result = new moveit::core::RobotState(robot_state_);
-  return moveit::core::RobotStatePtr(result);
+  return getCurrentStateAndTime().first;
 }
 
 ros::Time CurrentStateMonitor::getCurrentStateTime() const
 {
-  boost::mutex::scoped_lock slock(state_update_lock_);
-  return current_state_time_;
+  ros::Time stamp;
+  stamp.fromNSec(published_time_.load(std::memory_order_acquire));
+  return stamp;
 }
 
 std::pair<moveit::core::RobotStatePtr, ros::Time> CurrentStateMonitor::getCurrentStateAndTime() const
 {
-  boost::mutex::scoped_lock slock(state_update_lock_);
-  moveit::core::RobotState* result = new moveit::core::RobotState(robot_state_);
-  return std::make_pair(moveit::core::RobotStatePtr(result), current_state_time_);
+  std::vector<double> values;
+  bool has_velocities, has_efforts;
+  ros::Time stamp = readState(values, has_velocities, has_efforts);
+
+  const std::size_t n = robot_model_->getVariableCount();
+  moveit::core::RobotStatePtr result = std::make_shared<moveit::core::RobotState>(robot_model_);
+  result->setVariablePositions(values.data());
+  if (has_velocities)
+    result->setVariableVelocities(values.data() + n);
+  if (has_efforts)
+    result->setVariableEffort(values.data() + 2 * n);
+  return std::make_pair(result, stamp);
 }
 
 std::map<std::string, double> CurrentStateMonitor::getCurrentStateValues() const
 {
+  std::vector<double> values;
+  bool has_velocities, has_efforts;
+  readState(values, has_velocities, has_efforts);
+
   std::map<std::string, double> m;
-  boost::mutex::scoped_lock slock(state_update_lock_);
-  const double* pos = robot_state_.getVariablePositions();
-  const std::vector<std::string>& names = robot_state_.getVariableNames();
+  const std::vector<std::string>& names = robot_model_->getVariableNames();
   for (std::size_t i = 0; i < names.size(); ++i)
-    m[names[i]] = pos[i];
+    m[names[i]] = values[i];
   return m;
 }
 
 void CurrentStateMonitor::setToCurrentState(moveit::core::RobotState& upd) const
 {
-  boost::mutex::scoped_lock slock(state_update_lock_);
-  const double* pos = robot_state_.getVariablePositions();
-  upd.setVariablePositions(pos);
+  std::vector<double> values;
+  bool has_velocities, has_efforts;
+  readState(values, has_velocities, has_efforts);
+
+  const std::size_t n = robot_model_->getVariableCount();
+  upd.setVariablePositions(values.data());
   if (copy_dynamics_)
   {
-    if (robot_state_.hasVelocities())
-    {
-      const double* vel = robot_state_.getVariableVelocities();
-      upd.setVariableVelocities(vel);
-    }
-    if (robot_state_.hasAccelerations())
-    {
-      const double* acc = robot_state_.getVariableAccelerations();
-      upd.setVariableAccelerations(acc);
-    }
-    if (robot_state_.hasEffort())
-    {
-      const double* eff = robot_state_.getVariableEffort();
-      upd.setVariableEffort(eff);
-    }
+    // accelerations are never received, so there are none to copy
+    if (has_velocities)
+      upd.setVariableVelocities(values.data() + n);
+    if (has_efforts)
+      upd.setVariableEffort(values.data() + 2 * n);
   }
 }
 
@@ -140,7 +282,11 @@ void CurrentStateMonitor::startStateMonitor(const std::string& joint_states_topi
 {
   if (!state_monitor_started_ && robot_model_)
   {
-    joint_time_.clear();
+    {
+      boost::mutex::scoped_lock slock(state_update_lock_);
+      std::fill(joint_received_.begin(), joint_received_.end(), false);
+      std::fill(joint_time_.begin(), joint_time_.end(), ros::Time());
+    }
     if (joint_states_topic.empty())
       ROS_ERROR_NAMED(LOGNAME, "The joint states topic cannot be an empty string");
     else
@@ -191,15 +337,15 @@ bool CurrentStateMonitor::haveCompleteStateHelper(const ros::Time& oldest_allowe
   boost::mutex::scoped_lock slock(state_update_lock_);
   for (const moveit::core::JointModel* joint : active_joints)
   {
-    std::map<const moveit::core::JointModel*, ros::Time>::const_iterator it = joint_time_.find(joint);
-    if (it == joint_time_.end())
+    const int index = joint->getJointIndex();
+    if (!joint_received_[index])
     {
       ROS_DEBUG_NAMED(LOGNAME, "Joint '%s' has never been updated", joint->getName().c_str());
     }
-    else if (it->second < oldest_allowed_update_time)
+    else if (joint_time_[index] < oldest_allowed_update_time)
     {
       ROS_DEBUG_NAMED(LOGNAME, "Joint '%s' was last updated %0.3lf seconds before requested time",
-                      joint->getName().c_str(), (oldest_allowed_update_time - it->second).toSec());
+                      joint->getName().c_str(), (oldest_allowed_update_time - joint_time_[index]).toSec());
     }
     else
       continue;
@@ -292,16 +438,20 @@ void CurrentStateMonitor::jointStateCallback(const sensor_msgs::JointStateConstP
     // read the received values, and update their time stamps
     std::size_t n = joint_state->name.size();
     current_state_time_ = joint_state->header.stamp;
+    // publishers keep the order of joint names, so the name lookups are only repeated if it changes
+    joint_state_mapping_.update(*robot_model_, joint_state->name);
+    const std::vector<const moveit::core::JointModel*>& joint_models = joint_state_mapping_.getJointModels();
     for (std::size_t i = 0; i < n; ++i)
     {
-      const moveit::core::JointModel* jm = robot_model_->getJointModel(joint_state->name[i]);
+      const moveit::core::JointModel* jm = joint_models[i];
       if (!jm)
         continue;
       // ignore fixed joints, multi-dof joints (they should not even be in the message)
       if (jm->getVariableCount() != 1)
         continue;
 
-      joint_time_[jm] = joint_state->header.stamp;
+      joint_time_[jm->getJointIndex()] = joint_state->header.stamp;
+      joint_received_[jm->getJointIndex()] = true;
 
       if (robot_state_.getJointPositions(jm)[0] != joint_state->position[i])
       {
@@ -344,6 +494,7 @@ void CurrentStateMonitor::jointStateCallback(const sensor_msgs::JointStateConstP
         }
       }
     }
+    publishState();
   }
 
   // callbacks, if needed
@@ -388,9 +539,11 @@ void CurrentStateMonitor::tfCallback()
       }
 
       // allow update if time is more recent or if it is a static transform (time = 0)
-      if (latest_common_time <= joint_time_[joint] && latest_common_time > ros::Time(0))
+      const int index = joint->getJointIndex();
+      if (latest_common_time <= joint_time_[index] && latest_common_time > ros::Time(0))
         continue;
-      joint_time_[joint] = latest_common_time;
+      joint_time_[index] = latest_common_time;
+      joint_received_[index] = true;
 
       std::vector<double> new_values(joint->getStateSpaceDimension());
       const moveit::core::LinkModel* link = joint->getChildLinkModel();
@@ -408,6 +561,8 @@ void CurrentStateMonitor::tfCallback()
       robot_state_.setJointPositions(joint, new_values.data());
       update = true;
     }
+    if (update)
+      publishState();
   }
 
   // callbacks, if needed
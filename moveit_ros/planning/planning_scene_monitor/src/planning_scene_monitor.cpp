@@ -44,6 +44,7 @@
 #include <moveit_ros_planning/PlanningSceneMonitorDynamicReconfigureConfig.h>
 #include <tf2/exceptions.h>
 #include <tf2/LinearMath/Transform.h>
+#include <tf2_msgs/TF2Error.h>
 #include <tf2_eigen/tf2_eigen.h>
 #include <tf2_geometry_msgs/tf2_geometry_msgs.h>
 #include <moveit/profiler/profiler.h>
@@ -57,6 +58,8 @@ namespace planning_scene_monitor
 using namespace moveit_ros_planning;
 
 static const std::string LOGNAME = "planning_scene_monitor";
+// how long the state history used for the self filter of the octomap reaches back (seconds)
+static const double SELF_FILTER_STATE_HISTORY_DURATION = 2.0;
 
 class PlanningSceneMonitor::DynamicReconfigureImpl
 {
@@ -102,6 +105,11 @@ private:
     }
     else
       owner_->stopPublishingPlanningScene();
+    if (config.coalesce_scene_updates)
+      owner_->startCoalescingSceneUpdates(std::min(0.005, config.coalesce_scene_updates_max_window),
+                                          config.coalesce_scene_updates_max_window);
+    else
+      owner_->stopCoalescingSceneUpdates();
   }
 
   PlanningSceneMonitor* owner_;
@@ -139,7 +147,17 @@ PlanningSceneMonitor::PlanningSceneMonitor(const robot_model_loader::RobotModelL
 PlanningSceneMonitor::PlanningSceneMonitor(const planning_scene::PlanningScenePtr& scene,
                                            const robot_model_loader::RobotModelLoaderPtr& rm_loader,
                                            const std::shared_ptr<tf2_ros::Buffer>& tf_buffer, const std::string& name)
-  : monitor_name_(name), nh_("~"), tf_buffer_(tf_buffer), rm_loader_(rm_loader)
+  : monitor_name_(name)
+  , scene_snapshot_version_(0)
+  , scene_version_(0)
+  , snapshot_octree_version_(0)
+  , octomap_version_(0)
+  , nh_("~")
+  , tf_buffer_(tf_buffer)
+  , tf_frame_count_(0)
+  , frame_transforms_(nullptr)
+  , frame_transforms_version_(0)
+  , rm_loader_(rm_loader)
 {
   root_nh_.setCallbackQueue(&queue_);
   nh_.setCallbackQueue(&queue_);
@@ -152,7 +170,18 @@ PlanningSceneMonitor::PlanningSceneMonitor(const planning_scene::PlanningScenePt
                                            const robot_model_loader::RobotModelLoaderPtr& rm_loader,
                                            const ros::NodeHandle& nh, const std::shared_ptr<tf2_ros::Buffer>& tf_buffer,
                                            const std::string& name)
-  : monitor_name_(name), nh_("~"), root_nh_(nh), tf_buffer_(tf_buffer), rm_loader_(rm_loader)
+  : monitor_name_(name)
+  , scene_snapshot_version_(0)
+  , scene_version_(0)
+  , snapshot_octree_version_(0)
+  , octomap_version_(0)
+  , nh_("~")
+  , root_nh_(nh)
+  , tf_buffer_(tf_buffer)
+  , tf_frame_count_(0)
+  , frame_transforms_(nullptr)
+  , frame_transforms_version_(0)
+  , rm_loader_(rm_loader)
 {
   // use same callback queue as root_nh_
   nh_.setCallbackQueue(root_nh_.getCallbackQueue());
@@ -170,10 +199,13 @@ PlanningSceneMonitor::~PlanningSceneMonitor()
   stopStateMonitor();
   stopWorldGeometryMonitor();
   stopSceneMonitor();
+  stopCoalescingSceneUpdates();
 
   spinner_.reset();
   delete reconfigure_impl_;
   current_state_monitor_.reset();
+  std::atomic_store(&scene_snapshot_, planning_scene::PlanningSceneConstPtr());
+  snapshot_octree_.reset();
   scene_const_.reset();
   scene_.reset();
   parent_scene_.reset();
@@ -241,6 +273,8 @@ void PlanningSceneMonitor::initialize(const planning_scene::PlanningScenePtr& sc
 
   publish_planning_scene_frequency_ = 2.0;
   new_scene_update_ = UPDATE_NONE;
+  pending_octomap_update_ = false;
+  coalesce_window_ = coalesce_min_window_ = coalesce_max_window_ = 0.0;
 
   last_update_time_ = last_robot_motion_time_ = ros::Time::now();
   last_robot_state_update_wall_time_ = ros::WallTime::now();
@@ -337,6 +371,127 @@ void PlanningSceneMonitor::startPublishingPlanningScene(SceneUpdateType update_t
   }
 }
 
+void PlanningSceneMonitor::startCoalescingSceneUpdates(double min_window, double max_window)
+{
+  if (min_window <= 0.0 || max_window < min_window)
+  {
+    ROS_ERROR_NAMED(LOGNAME, "Invalid scene update coalescing window [%f, %f]", min_window, max_window);
+    return;
+  }
+  boost::mutex::scoped_lock lock(coalesce_updates_mutex_);
+  coalesce_min_window_ = min_window;
+  coalesce_max_window_ = max_window;
+  coalesce_window_ = min_window;
+  if (!coalesce_updates_)
+  {
+    ROS_INFO_NAMED(LOGNAME, "Coalescing scene updates within %.1f - %.1f ms", min_window * 1000.0,
+                   max_window * 1000.0);
+    coalesce_updates_ = std::make_unique<boost::thread>([this] { sceneUpdateCoalescingThread(); });
+  }
+}
+
+void PlanningSceneMonitor::stopCoalescingSceneUpdates()
+{
+  std::unique_ptr<boost::thread> copy;
+  {
+    boost::mutex::scoped_lock lock(coalesce_updates_mutex_);
+    copy.swap(coalesce_updates_);
+    coalesce_window_ = 0.0;
+  }
+  if (copy)
+  {
+    coalesce_updates_condition_.notify_all();
+    copy->join();
+    ROS_INFO_NAMED(LOGNAME, "Stopped coalescing scene updates.");
+  }
+}
+
+double PlanningSceneMonitor::getSceneUpdateCoalescingWindow() const
+{
+  boost::mutex::scoped_lock lock(coalesce_updates_mutex_);
+  return coalesce_window_;
+}
+
+void PlanningSceneMonitor::sceneUpdateCoalescingThread()
+{
+  ROS_DEBUG_NAMED(LOGNAME, "Started scene update coalescing thread ...");
+  std::deque<boost::function<SceneUpdateType()> > batch;
+  bool octomap_update = false;
+  bool running = true;
+  while (running)
+  {
+    {
+      boost::mutex::scoped_lock lock(coalesce_updates_mutex_);
+      while (coalesce_window_ > 0.0 && pending_scene_updates_.empty() && !pending_octomap_update_)
+        coalesce_updates_condition_.wait(lock);
+
+      // collect the updates arriving within the window, unless we are asked to stop
+      if (coalesce_window_ > 0.0)
+      {
+        const boost::chrono::nanoseconds window(ros::WallDuration(coalesce_window_).toNSec());
+        const boost::chrono::steady_clock::time_point deadline = boost::chrono::steady_clock::now() + window;
+        coalesce_updates_condition_.wait_until(lock, deadline, [this] { return coalesce_window_ <= 0.0; });
+      }
+      running = coalesce_window_ > 0.0;
+      batch.swap(pending_scene_updates_);
+      octomap_update = pending_octomap_update_;
+      pending_octomap_update_ = false;
+
+      // adapt the window to the load: grow it while batches collect several updates, shrink it otherwise
+      const std::size_t batch_size = batch.size() + (octomap_update ? 1 : 0);
+      if (running)
+        coalesce_window_ = batch_size > 1 ? std::min(coalesce_window_ * 1.5, coalesce_max_window_) :
+                                            std::max(coalesce_window_ * 0.5, coalesce_min_window_);
+    }
+
+    if (batch.empty() && !octomap_update)
+      continue;
+
+    updateFrameTransforms();
+    SceneUpdateType upd = UPDATE_NONE;
+    {
+      boost::unique_lock<boost::shared_mutex> ulock(scene_update_mutex_);
+      // we don't want the transform cache to update while we are potentially changing attached bodies
+      boost::recursive_mutex::scoped_lock prevent_shape_cache_updates(shape_handles_lock_);
+      last_update_time_ = ros::Time::now();
+      for (const boost::function<SceneUpdateType()>& fn : batch)
+        upd = (SceneUpdateType)((int)upd | (int)fn());
+      if (octomap_update)
+      {
+        applyOctomapUpdate();
+        upd = (SceneUpdateType)((int)upd | (int)UPDATE_GEOMETRY);
+      }
+    }
+    ROS_DEBUG_NAMED(LOGNAME, "Applied a batch of %zu scene updates", batch.size() + (octomap_update ? 1 : 0));
+    batch.clear();
+    triggerSceneUpdateEvent(upd);
+  }
+  ROS_DEBUG_NAMED(LOGNAME, "Stopped scene update coalescing thread");
+}
+
+void PlanningSceneMonitor::applySceneUpdate(const boost::function<SceneUpdateType()>& fn)
+{
+  {
+    boost::mutex::scoped_lock lock(coalesce_updates_mutex_);
+    if (coalesce_window_ > 0.0)
+    {
+      pending_scene_updates_.push_back(fn);
+      coalesce_updates_condition_.notify_all();
+      return;
+    }
+  }
+
+  updateFrameTransforms();
+  SceneUpdateType upd;
+  {
+    boost::unique_lock<boost::shared_mutex> ulock(scene_update_mutex_);
+    last_update_time_ = ros::Time::now();
+    upd = fn();
+  }
+  if (upd != UPDATE_NONE)
+    triggerSceneUpdateEvent(upd);
+}
+
 void PlanningSceneMonitor::scenePublishingThread()
 {
   ROS_DEBUG_NAMED(LOGNAME, "Started scene publishing thread ...");
@@ -466,8 +621,61 @@ bool PlanningSceneMonitor::updatesScene(const planning_scene::PlanningSceneConst
   return sceneIsParentOf(scene_const_, scene.get());
 }
 
+planning_scene::PlanningSceneConstPtr PlanningSceneMonitor::getPlanningSceneSnapshot()
+{
+  planning_scene::PlanningSceneConstPtr snapshot = std::atomic_load(&scene_snapshot_);
+  if (snapshot && scene_snapshot_version_ == scene_version_)
+    return snapshot;
+
+  // only one thread builds the next snapshot, the others reuse it
+  boost::mutex::scoped_lock build_lock(scene_snapshot_mutex_);
+  snapshot = std::atomic_load(&scene_snapshot_);
+  if (snapshot && scene_snapshot_version_ == scene_version_)
+    return snapshot;
+
+  planning_scene::PlanningScenePtr next;
+  std::uint64_t version;
+  {
+    // writers only increment scene_version_ after releasing the write lock, so the copy is at least as recent
+    // as the version read here
+    boost::shared_lock<boost::shared_mutex> lock(scene_update_mutex_);
+    if (!scene_)
+      return planning_scene::PlanningSceneConstPtr();
+    version = scene_version_;
+    next = planning_scene::PlanningScene::clone(scene_);
+
+    // the copied world shares the octree with the monitor, which keeps modifying it in place
+    collision_detection::World::ObjectConstPtr map =
+        next->getWorld()->getObject(planning_scene::PlanningScene::OCTOMAP_NS);
+    if (octomap_monitor_ && map && map->shapes_.size() == 1)
+    {
+      const occupancy_map_monitor::OccMapTreePtr& tree = octomap_monitor_->getOcTreePtr();
+      if (static_cast<const shapes::OcTree*>(map->shapes_[0].get())->octree == tree)
+      {
+        if (!snapshot_octree_ || snapshot_octree_version_ != octomap_version_)
+        {
+          tree->lockRead();
+          snapshot_octree_version_ = octomap_version_;
+          snapshot_octree_ = std::make_shared<const octomap::OcTree>(static_cast<const octomap::OcTree&>(*tree));
+          tree->unlockRead();
+        }
+        next->processOctomapPtr(snapshot_octree_, map->shape_poses_[0]);
+      }
+    }
+  }
+
+  // the snapshot is never modified again, readers hold on to it as long as they need it
+  snapshot = next;
+  std::atomic_store(&scene_snapshot_, snapshot);
+  scene_snapshot_version_ = version;
+  return snapshot;
+}
+
 void PlanningSceneMonitor::triggerSceneUpdateEvent(SceneUpdateType update_type)
 {
+  // invalidate the published snapshot before anyone is notified about the change
+  ++scene_version_;
+
   // do not modify update functions while we are calling them
   boost::recursive_mutex::scoped_lock lock(update_lock_);
 
@@ -534,6 +742,19 @@ bool PlanningSceneMonitor::getPlanningSceneServiceCallback(moveit_msgs::GetPlann
 
 void PlanningSceneMonitor::newPlanningSceneCallback(const moveit_msgs::PlanningSceneConstPtr& scene)
 {
+  {
+    boost::mutex::scoped_lock lock(coalesce_updates_mutex_);
+    if (coalesce_window_ > 0.0)
+    {
+      pending_scene_updates_.push_back([this, scene] {
+        SceneUpdateType upd;
+        applyPlanningSceneMessage(*scene, upd);
+        return upd;
+      });
+      coalesce_updates_condition_.notify_all();
+      return;
+    }
+  }
   newPlanningSceneMessage(*scene);
 }
 
@@ -546,9 +767,7 @@ void PlanningSceneMonitor::clearOctomap()
 
     if (octomap_monitor_)
     {
-      octomap_monitor_->getOcTreePtr()->lockWrite();
-      octomap_monitor_->getOcTreePtr()->clear();
-      octomap_monitor_->getOcTreePtr()->unlockWrite();
+      octomap_monitor_->clearOcTree();
     }
     else
     {
@@ -566,56 +785,60 @@ bool PlanningSceneMonitor::newPlanningSceneMessage(const moveit_msgs::PlanningSc
     return false;
 
   bool result;
-
-  SceneUpdateType upd = UPDATE_SCENE;
-  std::string old_scene_name;
+  SceneUpdateType upd;
   {
     boost::unique_lock<boost::shared_mutex> ulock(scene_update_mutex_);
     // we don't want the transform cache to update while we are potentially changing attached bodies
     boost::recursive_mutex::scoped_lock prevent_shape_cache_updates(shape_handles_lock_);
+    result = applyPlanningSceneMessage(scene, upd);
+  }
+  triggerSceneUpdateEvent(upd);
+  return result;
+}
 
-    last_update_time_ = ros::Time::now();
-    last_robot_motion_time_ = scene.robot_state.joint_state.header.stamp;
-    ROS_DEBUG_STREAM_NAMED("planning_scene_monitor",
-                           "scene update " << fmod(last_update_time_.toSec(), 10.)
-                                           << " robot stamp: " << fmod(last_robot_motion_time_.toSec(), 10.));
-    old_scene_name = scene_->getName();
-    result = scene_->usePlanningSceneMsg(scene);
-    if (octomap_monitor_)
+bool PlanningSceneMonitor::applyPlanningSceneMessage(const moveit_msgs::PlanningScene& scene,
+                                                     SceneUpdateType& update_type)
+{
+  last_update_time_ = ros::Time::now();
+  last_robot_motion_time_ = scene.robot_state.joint_state.header.stamp;
+  ROS_DEBUG_STREAM_NAMED("planning_scene_monitor",
+                         "scene update " << fmod(last_update_time_.toSec(), 10.)
+                                         << " robot stamp: " << fmod(last_robot_motion_time_.toSec(), 10.));
+  const std::string old_scene_name = scene_->getName();
+  const bool result = scene_->usePlanningSceneMsg(scene);
+  if (octomap_monitor_)
+  {
+    if (!scene.is_diff && scene.world.octomap.octomap.data.empty())
     {
-      if (!scene.is_diff && scene.world.octomap.octomap.data.empty())
-      {
-        octomap_monitor_->getOcTreePtr()->lockWrite();
-        octomap_monitor_->getOcTreePtr()->clear();
-        octomap_monitor_->getOcTreePtr()->unlockWrite();
-      }
+      octomap_monitor_->clearOcTree();
     }
-    robot_model_ = scene_->getRobotModel();
+  }
+  robot_model_ = scene_->getRobotModel();
 
-    // if we just reset the scene completely but we were maintaining diffs, we need to fix that
-    if (!scene.is_diff && parent_scene_)
-    {
-      // the scene is now decoupled from the parent, since we just reset it
-      scene_->setAttachedBodyUpdateCallback(moveit::core::AttachedBodyCallback());
-      scene_->setCollisionObjectUpdateCallback(collision_detection::World::ObserverCallbackFn());
-      parent_scene_ = scene_;
-      scene_ = parent_scene_->diff();
-      scene_const_ = scene_;
-      scene_->setAttachedBodyUpdateCallback([this](moveit::core::AttachedBody* body, bool attached) {
-        currentStateAttachedBodyUpdateCallback(body, attached);
-      });
-      scene_->setCollisionObjectUpdateCallback(
-          [this](const collision_detection::World::ObjectConstPtr& object, collision_detection::World::Action action) {
-            currentWorldObjectUpdateCallback(object, action);
-          });
-    }
-    if (octomap_monitor_)
-    {
-      excludeAttachedBodiesFromOctree();  // in case updates have happened to the attached bodies, put them in
-      excludeWorldObjectsFromOctree();    // in case updates have happened to the attached bodies, put them in
-    }
+  // if we just reset the scene completely but we were maintaining diffs, we need to fix that
+  if (!scene.is_diff && parent_scene_)
+  {
+    // the scene is now decoupled from the parent, since we just reset it
+    scene_->setAttachedBodyUpdateCallback(moveit::core::AttachedBodyCallback());
+    scene_->setCollisionObjectUpdateCallback(collision_detection::World::ObserverCallbackFn());
+    parent_scene_ = scene_;
+    scene_ = parent_scene_->diff();
+    scene_const_ = scene_;
+    scene_->setAttachedBodyUpdateCallback([this](moveit::core::AttachedBody* body, bool attached) {
+      currentStateAttachedBodyUpdateCallback(body, attached);
+    });
+    scene_->setCollisionObjectUpdateCallback(
+        [this](const collision_detection::World::ObjectConstPtr& object, collision_detection::World::Action action) {
+          currentWorldObjectUpdateCallback(object, action);
+        });
+  }
+  if (octomap_monitor_)
+  {
+    excludeAttachedBodiesFromOctree();  // in case updates have happened to the attached bodies, put them in
+    excludeWorldObjectsFromOctree();    // in case updates have happened to the attached bodies, put them in
   }
 
+  update_type = UPDATE_SCENE;
   // if we have a diff, try to more accurately determine the update type
   if (scene.is_diff)
   {
@@ -624,22 +847,21 @@ bool PlanningSceneMonitor::newPlanningSceneMessage(const moveit_msgs::PlanningSc
                               scene.link_scale.empty();
     if (no_other_scene_upd)
     {
-      upd = UPDATE_NONE;
+      update_type = UPDATE_NONE;
       if (!moveit::core::isEmpty(scene.world))
-        upd = (SceneUpdateType)((int)upd | (int)UPDATE_GEOMETRY);
+        update_type = (SceneUpdateType)((int)update_type | (int)UPDATE_GEOMETRY);
 
       if (!scene.fixed_frame_transforms.empty())
-        upd = (SceneUpdateType)((int)upd | (int)UPDATE_TRANSFORMS);
+        update_type = (SceneUpdateType)((int)update_type | (int)UPDATE_TRANSFORMS);
 
       if (!moveit::core::isEmpty(scene.robot_state))
       {
-        upd = (SceneUpdateType)((int)upd | (int)UPDATE_STATE);
+        update_type = (SceneUpdateType)((int)update_type | (int)UPDATE_STATE);
         if (!scene.robot_state.attached_collision_objects.empty() || !static_cast<bool>(scene.robot_state.is_diff))
-          upd = (SceneUpdateType)((int)upd | (int)UPDATE_GEOMETRY);
+          update_type = (SceneUpdateType)((int)update_type | (int)UPDATE_GEOMETRY);
       }
     }
   }
-  triggerSceneUpdateEvent(upd);
   return result;
 }
 
@@ -647,23 +869,18 @@ void PlanningSceneMonitor::newPlanningSceneWorldCallback(const moveit_msgs::Plan
 {
   if (scene_)
   {
-    updateFrameTransforms();
-    {
-      boost::unique_lock<boost::shared_mutex> ulock(scene_update_mutex_);
-      last_update_time_ = ros::Time::now();
+    applySceneUpdate([this, world] {
       scene_->getWorldNonConst()->clearObjects();
       scene_->processPlanningSceneWorldMsg(*world);
       if (octomap_monitor_)
       {
         if (world->octomap.octomap.data.empty())
         {
-          octomap_monitor_->getOcTreePtr()->lockWrite();
-          octomap_monitor_->getOcTreePtr()->clear();
-          octomap_monitor_->getOcTreePtr()->unlockWrite();
+          octomap_monitor_->clearOcTree();
         }
       }
-    }
-    triggerSceneUpdateEvent(UPDATE_SCENE);
+      return UPDATE_SCENE;
+    });
   }
 }
 
@@ -672,27 +889,17 @@ void PlanningSceneMonitor::collisionObjectCallback(const moveit_msgs::CollisionO
   if (!scene_)
     return;
 
-  updateFrameTransforms();
-  {
-    boost::unique_lock<boost::shared_mutex> ulock(scene_update_mutex_);
-    last_update_time_ = ros::Time::now();
-    if (!scene_->processCollisionObjectMsg(*obj))
-      return;
-  }
-  triggerSceneUpdateEvent(UPDATE_GEOMETRY);
+  applySceneUpdate([this, obj] { return scene_->processCollisionObjectMsg(*obj) ? UPDATE_GEOMETRY : UPDATE_NONE; });
 }
 
 void PlanningSceneMonitor::attachObjectCallback(const moveit_msgs::AttachedCollisionObjectConstPtr& obj)
 {
   if (scene_)
   {
-    updateFrameTransforms();
-    {
-      boost::unique_lock<boost::shared_mutex> ulock(scene_update_mutex_);
-      last_update_time_ = ros::Time::now();
+    applySceneUpdate([this, obj] {
       scene_->processAttachedCollisionObjectMsg(*obj);
-    }
-    triggerSceneUpdateEvent(UPDATE_GEOMETRY);
+      return UPDATE_GEOMETRY;
+    });
   }
 }
 
@@ -991,7 +1198,12 @@ void PlanningSceneMonitor::lockSceneWrite()
 void PlanningSceneMonitor::unlockSceneWrite()
 {
   if (octomap_monitor_)
+  {
+    ++octomap_version_;
     octomap_monitor_->getOcTreePtr()->unlockWrite();
+  }
+  // the scene may have been modified through LockedPlanningSceneRW without triggering an update event
+  ++scene_version_;
   scene_update_mutex_.unlock();
 }
 
@@ -1023,6 +1235,12 @@ bool PlanningSceneMonitor::getShapeTransformCache(const std::string& target_fram
 {
   if (!tf_buffer_)
     return false;
+
+  // the robot state at the sensor's stamp avoids a TF lookup per link
+  moveit::core::RobotState state(getRobotModel());
+  if (current_state_monitor_ && current_state_monitor_->getStateAtTime(target_time, state))
+    return getShapeTransformCache(target_frame, target_time, state, cache);
+
   try
   {
     boost::recursive_mutex::scoped_lock _(shape_handles_lock_);
@@ -1073,6 +1291,61 @@ bool PlanningSceneMonitor::getShapeTransformCache(const std::string& target_fram
   return true;
 }
 
+bool PlanningSceneMonitor::getShapeTransformCache(const std::string& target_frame, const ros::Time& target_time,
+                                                  moveit::core::RobotState& state,
+                                                  occupancy_map_monitor::ShapeTransformCache& cache) const
+{
+  try
+  {
+    boost::recursive_mutex::scoped_lock _(shape_handles_lock_);
+
+    state.updateLinkTransforms();
+    tf_buffer_->canTransform(target_frame, getRobotModel()->getModelFrame(), target_time,
+                             shape_transform_cache_lookup_wait_time_);
+    const Eigen::Isometry3d robot_transform = tf2::transformToEigen(
+        tf_buffer_->lookupTransform(target_frame, getRobotModel()->getModelFrame(), target_time));
+
+    for (const std::pair<const moveit::core::LinkModel* const,
+                         std::vector<std::pair<occupancy_map_monitor::ShapeHandle, std::size_t>>>& link_shape_handle :
+         link_shape_handles_)
+    {
+      const Eigen::Isometry3d ttr = robot_transform * state.getGlobalLinkTransform(link_shape_handle.first);
+      for (std::size_t j = 0; j < link_shape_handle.second.size(); ++j)
+        cache[link_shape_handle.second[j].first] =
+            ttr * link_shape_handle.first->getCollisionOriginTransforms()[link_shape_handle.second[j].second];
+    }
+    for (const std::pair<const moveit::core::AttachedBody* const,
+                         std::vector<std::pair<occupancy_map_monitor::ShapeHandle, std::size_t>>>&
+             attached_body_shape_handle : attached_body_shape_handles_)
+    {
+      const Eigen::Isometry3d transform =
+          robot_transform * state.getGlobalLinkTransform(attached_body_shape_handle.first->getAttachedLink());
+      for (std::size_t k = 0; k < attached_body_shape_handle.second.size(); ++k)
+        cache[attached_body_shape_handle.second[k].first] =
+            transform *
+            attached_body_shape_handle.first->getShapePosesInLinkFrame()[attached_body_shape_handle.second[k].second];
+    }
+    {
+      Eigen::Isometry3d transform = robot_transform;
+      if (scene_->getPlanningFrame() != getRobotModel()->getModelFrame())
+        transform =
+            tf2::transformToEigen(tf_buffer_->lookupTransform(target_frame, scene_->getPlanningFrame(), target_time));
+      for (const std::pair<const std::string,
+                           std::vector<std::pair<occupancy_map_monitor::ShapeHandle, const Eigen::Isometry3d*>>>&
+               collision_body_shape_handle : collision_body_shape_handles_)
+        for (const std::pair<occupancy_map_monitor::ShapeHandle, const Eigen::Isometry3d*>& it :
+             collision_body_shape_handle.second)
+          cache[it.first] = transform * (*it.second);
+    }
+  }
+  catch (tf2::TransformException& ex)
+  {
+    ROS_ERROR_THROTTLE_NAMED(1, LOGNAME, "Transform error: %s", ex.what());
+    return false;
+  }
+  return true;
+}
+
 void PlanningSceneMonitor::startWorldGeometryMonitor(const std::string& collision_objects_topic,
                                                      const std::string& planning_scene_world_topic,
                                                      const bool load_octomap_monitor)
@@ -1114,6 +1387,8 @@ void PlanningSceneMonitor::startWorldGeometryMonitor(const std::string& collisio
           });
       octomap_monitor_->setUpdateCallback([this] { octomapUpdateCallback(); });
     }
+    if (current_state_monitor_)
+      current_state_monitor_->setStateHistoryDuration(ros::Duration(SELF_FILTER_STATE_HISTORY_DURATION));
     octomap_monitor_->startMonitor();
   }
 }
@@ -1144,6 +1419,8 @@ void PlanningSceneMonitor::startStateMonitor(const std::string& joint_states_top
       current_state_monitor_ = std::make_shared<CurrentStateMonitor>(getRobotModel(), tf_buffer_, root_nh_);
     current_state_monitor_->addUpdateCallback(
         [this](const sensor_msgs::JointStateConstPtr& state) { onStateUpdate(state); });
+    if (octomap_monitor_)
+      current_state_monitor_->setStateHistoryDuration(ros::Duration(SELF_FILTER_STATE_HISTORY_DURATION));
     current_state_monitor_->startStateMonitor(joint_states_topic);
 
     {
@@ -1241,25 +1518,42 @@ void PlanningSceneMonitor::octomapUpdateCallback()
   if (!octomap_monitor_)
     return;
 
+  {
+    // consecutive octomap updates within a window are applied only once
+    boost::mutex::scoped_lock lock(coalesce_updates_mutex_);
+    if (coalesce_window_ > 0.0)
+    {
+      pending_octomap_update_ = true;
+      coalesce_updates_condition_.notify_all();
+      return;
+    }
+  }
+
   updateFrameTransforms();
   {
     boost::unique_lock<boost::shared_mutex> ulock(scene_update_mutex_);
     last_update_time_ = ros::Time::now();
-    octomap_monitor_->getOcTreePtr()->lockRead();
-    try
-    {
-      scene_->processOctomapPtr(octomap_monitor_->getOcTreePtr(), Eigen::Isometry3d::Identity());
-      octomap_monitor_->getOcTreePtr()->unlockRead();
-    }
-    catch (...)
-    {
-      octomap_monitor_->getOcTreePtr()->unlockRead();  // unlock and rethrow
-      throw;
-    }
+    applyOctomapUpdate();
   }
   triggerSceneUpdateEvent(UPDATE_GEOMETRY);
 }
 
+void PlanningSceneMonitor::applyOctomapUpdate()
+{
+  ++octomap_version_;
+  octomap_monitor_->getOcTreePtr()->lockRead();
+  try
+  {
+    scene_->processOctomapPtr(octomap_monitor_->getOcTreePtr(), Eigen::Isometry3d::Identity());
+    octomap_monitor_->getOcTreePtr()->unlockRead();
+  }
+  catch (...)
+  {
+    octomap_monitor_->getOcTreePtr()->unlockRead();  // unlock and rethrow
+    throw;
+  }
+}
+
 void PlanningSceneMonitor::setStateUpdateFrequency(double hz)
 {
   bool update = false;
@@ -1331,17 +1625,35 @@ void PlanningSceneMonitor::setPlanningScenePublishingFrequency(double hz)
                   publish_planning_scene_frequency_);
 }
 
-void PlanningSceneMonitor::getUpdatedFrameTransforms(std::vector<geometry_msgs::TransformStamped>& transforms)
+void PlanningSceneMonitor::getUpdatedFrameTransforms(std::vector<geometry_msgs::TransformStamped>& transforms,
+                                                     bool all_frames)
 {
   const std::string& target = getRobotModel()->getModelFrame();
 
   std::vector<std::string> all_frame_names;
   tf_buffer_->_getFrameStrings(all_frame_names);
+  // static frames (latest common time 0) are only looked up again when new frames appear
+  if (all_frame_names.size() != tf_frame_count_)
+    all_frames = true;
+  tf_frame_count_ = all_frame_names.size();
+  const tf2::CompactFrameID target_id = tf_buffer_->_lookupFrameNumber(target);
+
   for (const std::string& all_frame_name : all_frame_names)
   {
     if (all_frame_name == target || getRobotModel()->hasLinkModel(all_frame_name))
       continue;
 
+    std::map<std::string, ros::Time>::iterator stamp = frame_stamps_.find(all_frame_name);
+    if (!all_frames && stamp != frame_stamps_.end())
+    {
+      // skip the lookup if TF did not receive new data for the frame's chain
+      ros::Time latest_common_time;
+      if (tf_buffer_->_getLatestCommonTime(target_id, tf_buffer_->_lookupFrameNumber(all_frame_name),
+                                           latest_common_time, nullptr) == tf2_msgs::TF2Error::NO_ERROR &&
+          latest_common_time == stamp->second)
+        continue;
+    }
+
     geometry_msgs::TransformStamped f;
     try
     {
@@ -1354,6 +1666,7 @@ void PlanningSceneMonitor::getUpdatedFrameTransforms(std::vector<geometry_msgs::
                                          << ")");
       continue;
     }
+    frame_stamps_[all_frame_name] = f.header.stamp;
     f.header.frame_id = all_frame_name;
     f.child_frame_id = target;
     transforms.push_back(f);
@@ -1367,14 +1680,30 @@ void PlanningSceneMonitor::updateFrameTransforms()
 
   if (scene_)
   {
+    boost::mutex::scoped_lock frame_lock(frame_transforms_mutex_);
+    bool all_frames;
+    {
+      boost::shared_lock<boost::shared_mutex> slock(scene_update_mutex_);
+      // look up all frames again if the scene's transforms were replaced or modified elsewhere
+      const moveit::core::Transforms& scene_transforms = scene_->getTransforms();
+      all_frames = &scene_transforms != frame_transforms_ || scene_transforms.getVersion() != frame_transforms_version_;
+    }
+
     std::vector<geometry_msgs::TransformStamped> transforms;
-    getUpdatedFrameTransforms(transforms);
+    getUpdatedFrameTransforms(transforms, all_frames);
+    bool changed;
     {
       boost::unique_lock<boost::shared_mutex> ulock(scene_update_mutex_);
-      scene_->getTransformsNonConst().setTransforms(transforms);
+      moveit::core::Transforms& scene_transforms = scene_->getTransformsNonConst();
+      const std::uint64_t version = scene_transforms.getVersion();
+      scene_transforms.setTransforms(transforms);
+      changed = scene_transforms.getVersion() != version;
+      frame_transforms_ = &scene_transforms;
+      frame_transforms_version_ = scene_transforms.getVersion();
       last_update_time_ = ros::Time::now();
     }
-    triggerSceneUpdateEvent(UPDATE_TRANSFORMS);
+    if (changed)
+      triggerSceneUpdateEvent(UPDATE_TRANSFORMS);
   }
 }
 
@@ -37,16 +37,30 @@
 #include <moveit/planning_scene_monitor/trajectory_monitor.h>
 #include <moveit/trajectory_processing/trajectory_tools.h>
 #include <ros/rate.h>
+#include <algorithm>
+#include <cmath>
 #include <limits>
 #include <memory>
 
 static const std::string LOGNAME = "TrajectoryMonitor";
 
+namespace
+{
+// buffer slots preallocated when recording starts (without a limit on the number of states): this many seconds of
+// samples, but at least MIN_BUFFER_CAPACITY
+const double INITIAL_BUFFER_DURATION = 60.0;
+const std::size_t MIN_BUFFER_CAPACITY = 64;
+}  // namespace
+
 planning_scene_monitor::TrajectoryMonitor::TrajectoryMonitor(const CurrentStateMonitorConstPtr& state_monitor,
                                                              double sampling_frequency)
   : current_state_monitor_(state_monitor)
   , sampling_frequency_(sampling_frequency)
-  , trajectory_(current_state_monitor_->getRobotModel(), "")
+  , variable_count_(current_state_monitor_->getRobotModel()->getVariableCount())
+  , max_recorded_states_(0)
+  , buffer_capacity_(0)
+  , recorded_(0)
+  , scratch_state_(current_state_monitor_->getRobotModel())
 {
   setSamplingFrequency(sampling_frequency);
 }
@@ -98,11 +112,128 @@ void planning_scene_monitor::TrajectoryMonitor::clearTrajectory()
   bool restart = isActive();
   if (restart)
     stopTrajectoryMonitor();
-  trajectory_.clear();
+  recorded_ = 0;
+  if (restart)
+    startTrajectoryMonitor();
+}
+
+void planning_scene_monitor::TrajectoryMonitor::setMaxRecordedStates(std::size_t max_states)
+{
+  bool restart = isActive();
+  if (restart)
+    stopTrajectoryMonitor();
+  {
+    boost::mutex::scoped_lock lock(buffer_lock_);
+    max_recorded_states_ = max_states;
+    buffer_capacity_ = 0;
+    positions_.reset();
+    times_.reset();
+    recorded_ = 0;
+  }
   if (restart)
     startTrajectoryMonitor();
 }
 
+std::size_t planning_scene_monitor::TrajectoryMonitor::getRecordedStateCount() const
+{
+  const std::size_t recorded = recorded_.load(std::memory_order_acquire);
+  return max_recorded_states_ > 0 ? std::min(recorded, max_recorded_states_) : recorded;
+}
+
+robot_trajectory::RobotTrajectory planning_scene_monitor::TrajectoryMonitor::getTrajectory() const
+{
+  robot_trajectory::RobotTrajectory trajectory(current_state_monitor_->getRobotModel(), "");
+
+  std::vector<double> positions;
+  std::vector<std::uint64_t> times;
+  std::size_t first, last;
+  {
+    boost::mutex::scoped_lock lock(buffer_lock_);
+    last = recorded_.load(std::memory_order_acquire);
+    first = last > buffer_capacity_ ? last - buffer_capacity_ : 0;
+    positions.resize((last - first) * variable_count_);
+    times.resize(last - first);
+    for (std::size_t i = first; i < last; ++i)
+    {
+      const std::size_t slot = i % buffer_capacity_;
+      double* values = &positions[(i - first) * variable_count_];
+      for (std::size_t j = 0; j < variable_count_; ++j)
+        values[j] = positions_[slot * variable_count_ + j].load(std::memory_order_relaxed);
+      times[i - first] = times_[slot].load(std::memory_order_relaxed);
+    }
+    // once the ring wraps around, the slot being written while copying overwrote the sample one ring length before
+    std::atomic_thread_fence(std::memory_order_acquire);
+    const std::size_t recorded = recorded_.load(std::memory_order_relaxed);
+    if (max_recorded_states_ > 0 && recorded + 1 > first + buffer_capacity_)
+    {
+      const std::size_t skip = std::min(recorded + 1 - buffer_capacity_, last) - first;
+      positions.erase(positions.begin(), positions.begin() + skip * variable_count_);
+      times.erase(times.begin(), times.begin() + skip);
+    }
+  }
+
+  ros::Time previous;
+  for (std::size_t i = 0; i < times.size(); ++i)
+  {
+    ros::Time t;
+    t.fromNSec(times[i]);
+    auto state = std::make_shared<moveit::core::RobotState>(current_state_monitor_->getRobotModel());
+    state->setVariablePositions(&positions[i * variable_count_]);
+    trajectory.addSuffixWayPoint(state, i == 0 ? 0.0 : (t - previous).toSec());
+    previous = t;
+  }
+  return trajectory;
+}
+
+void planning_scene_monitor::TrajectoryMonitor::swapTrajectory(robot_trajectory::RobotTrajectory& other)
+{
+  bool restart = isActive();
+  if (restart)
+    stopTrajectoryMonitor();
+  other = getTrajectory();
+  recorded_ = 0;
+  if (restart)
+    startTrajectoryMonitor();
+}
+
+void planning_scene_monitor::TrajectoryMonitor::recordState(const ros::Time& t)
+{
+  const std::size_t index = recorded_.load(std::memory_order_relaxed);
+  if (index >= buffer_capacity_ && (max_recorded_states_ == 0 || buffer_capacity_ == 0))
+  {
+    // allocate the ring, or double it while there is no limit
+    boost::mutex::scoped_lock lock(buffer_lock_);
+    std::size_t capacity = max_recorded_states_;
+    if (capacity == 0)
+      capacity = std::max({ 2 * buffer_capacity_, MIN_BUFFER_CAPACITY,
+                            static_cast<std::size_t>(std::ceil(INITIAL_BUFFER_DURATION * sampling_frequency_)) });
+    std::unique_ptr<std::atomic<double>[]> positions(new std::atomic<double>[capacity * variable_count_]);
+    std::unique_ptr<std::atomic<std::uint64_t>[]> times(new std::atomic<std::uint64_t>[capacity]);
+    for (std::size_t i = 0; i < std::min(index, buffer_capacity_); ++i)
+    {
+      for (std::size_t j = 0; j < variable_count_; ++j)
+        positions[i * variable_count_ + j].store(positions_[i * variable_count_ + j].load(std::memory_order_relaxed),
+                                                 std::memory_order_relaxed);
+      times[i].store(times_[i].load(std::memory_order_relaxed), std::memory_order_relaxed);
+    }
+    positions_.swap(positions);
+    times_.swap(times);
+    buffer_capacity_ = capacity;
+  }
+
+  // readers that see any of the following writes also see the samples published before
+  std::atomic_thread_fence(std::memory_order_release);
+  const std::size_t slot = index % buffer_capacity_;
+  const double* values = scratch_state_.getVariablePositions();
+  for (std::size_t j = 0; j < variable_count_; ++j)
+    positions_[slot * variable_count_ + j].store(values[j], std::memory_order_relaxed);
+  times_[slot].store(t.toNSec(), std::memory_order_relaxed);
+  recorded_.store(index + 1, std::memory_order_release);
+
+  if (state_add_callback_)
+    state_add_callback_(std::make_shared<moveit::core::RobotState>(scratch_state_), t);
+}
+
 void planning_scene_monitor::TrajectoryMonitor::recordStates()
 {
   if (!current_state_monitor_)
@@ -113,19 +244,34 @@ void planning_scene_monitor::TrajectoryMonitor::recordStates()
   while (record_states_thread_)
   {
     rate.sleep();
-    std::pair<moveit::core::RobotStatePtr, ros::Time> state = current_state_monitor_->getCurrentStateAndTime();
-    if (trajectory_.empty())
-    {
-      trajectory_.addSuffixWayPoint(state.first, 0.0);
-      trajectory_start_time_ = state.second;
-      last_recorded_state_time_ = state.second;
-    }
-    else
-    {
-      trajectory_.addSuffixWayPoint(state.first, (state.second - last_recorded_state_time_).toSec());
-      last_recorded_state_time_ = state.second;
-    }
-    if (state_add_callback_)
-      state_add_callback_(state.first, state.second);
+    const bool empty = recorded_.load(std::memory_order_relaxed) == 0;
+    if (!empty && recordStatesFromHistory())
+      continue;
+    const ros::Time t = current_state_monitor_->getCurrentStateTime();
+    current_state_monitor_->setToCurrentState(scratch_state_);
+    if (empty)
+      trajectory_start_time_ = t;
+    last_recorded_state_time_ = t;
+    recordState(t);
+  }
+}
+
+bool planning_scene_monitor::TrajectoryMonitor::recordStatesFromHistory()
+{
+  if (current_state_monitor_->getStateHistoryDuration().isZero())
+    return false;
+
+  const ros::Duration period(1.0 / sampling_frequency_);
+  const ros::Time latest = current_state_monitor_->getCurrentStateTime();
+  bool recorded = false;
+  for (ros::Time t = last_recorded_state_time_ + period; t <= latest; t += period)
+  {
+    if (!current_state_monitor_->getStateAtTime(t, scratch_state_))
+      return recorded;  // the next sample already left the history
+    last_recorded_state_time_ = t;
+    recordState(t);
+    recorded = true;
   }
+  // all samples due so far are recorded
+  return true;
 }
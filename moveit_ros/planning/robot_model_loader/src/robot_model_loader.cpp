@@ -38,6 +38,7 @@
 #include <moveit/profiler/profiler.h>
 #include <ros/ros.h>
 
+#include <future>
 #include <memory>
 #include <typeinfo>
 
@@ -188,16 +189,31 @@ void RobotModelLoader::loadKinematicsSolvers(const kinematics_plugin_loader::Kin
     if (groups.empty() && !model_->getJointModelGroups().empty())
       ROS_WARN("No kinematics plugins defined. Fill and load kinematics.yaml!");
 
-    std::map<std::string, moveit::core::SolverAllocatorFn> imap;
+    // Initializing a solver can take long (e.g. loading IK databases), so the solvers of all groups are allocated in
+    // parallel unless disabled
+    ros::NodeHandle nh("~");
+    bool parallel_loading;
+    nh.param("kinematics_solver_parallel_loading", parallel_loading, true);
+
+    std::vector<const moveit::core::JointModelGroup*> jmgs;
     for (const std::string& group : groups)
     {
       // Check if a group in kinematics.yaml exists in the srdf
-      if (!model_->hasJointModelGroup(group))
-        continue;
+      if (model_->hasJointModelGroup(group))
+        jmgs.push_back(model_->getJointModelGroup(group));
+    }
+    std::vector<std::future<kinematics::KinematicsBasePtr>> solvers;
+    for (const moveit::core::JointModelGroup* jmg : jmgs)
+      solvers.push_back(std::async(parallel_loading ? std::launch::async : std::launch::deferred, kinematics_allocator,
+                                   jmg));
 
-      const moveit::core::JointModelGroup* jmg = model_->getJointModelGroup(group);
+    std::map<std::string, moveit::core::SolverAllocatorFn> imap;
+    for (std::size_t i = 0; i < jmgs.size(); ++i)
+    {
+      const moveit::core::JointModelGroup* jmg = jmgs[i];
+      const std::string& group = jmg->getName();
 
-      kinematics::KinematicsBasePtr solver = kinematics_allocator(jmg);
+      kinematics::KinematicsBasePtr solver = solvers[i].get();
       if (solver)
       {
         std::string error_msg;
@@ -38,6 +38,7 @@
 
 #include <moveit/macros/class_forward.h>
 #include <moveit/robot_model/robot_model.h>
+#include <moveit/robot_trajectory/robot_trajectory.h>
 #include <moveit/planning_scene_monitor/current_state_monitor.h>
 #include <moveit_msgs/RobotTrajectory.h>
 #include <sensor_msgs/JointState.h>
@@ -47,7 +48,10 @@
 #include <boost/thread.hpp>
 #include <pluginlib/class_loader.hpp>
 
+#include <atomic>
+#include <functional>
 #include <memory>
+#include <tuple>
 
 namespace trajectory_execution_manager
 {
@@ -69,6 +73,11 @@ public:
   /// successfully.
   using PathSegmentCompleteCallback = boost::function<void(std::size_t)>;
 
+  /// Definition of the function signature that is called when a controller reports progress on the pushed trajectory
+  /// with the given index. It is called from the thread receiving the controller feedback.
+  using ExecutionProgressCallback =
+      boost::function<void(std::size_t, const std::string&, const moveit_controller_manager::ExecutionProgress&)>;
+
   /// Data structure that represents information necessary to execute a trajectory
   struct TrajectoryExecutionContext
   {
@@ -150,6 +159,16 @@ public:
   /// If no controller is specified, a default is used.
   bool push(const moveit_msgs::RobotTrajectory& trajectory, const std::vector<std::string>& controllers);
 
+  /// Add a trajectory for future execution. Optionally specify a controller to use for the trajectory. If no controller
+  /// is specified, a default is used. The parts sent to the controllers are generated directly from \e trajectory,
+  /// without first converting all of it to a message.
+  bool push(const robot_trajectory::RobotTrajectory& trajectory, const std::string& controller = "");
+
+  /// Add a trajectory for future execution. Optionally specify a set of controllers to consider using for the
+  /// trajectory. Multiple controllers can be used simultaneously to execute the different parts of the trajectory.
+  /// The parts sent to the controllers are generated directly from \e trajectory.
+  bool push(const robot_trajectory::RobotTrajectory& trajectory, const std::vector<std::string>& controllers);
+
   /// Get the trajectories to be executed
   const std::vector<TrajectoryExecutionContext*>& getTrajectories() const;
 
@@ -177,6 +196,31 @@ public:
   /// pushAndExecute().
   std::pair<int, int> getCurrentExpectedTrajectoryIndex() const;
 
+  /// Set the joints of \e state moved by the currently executing trajectory to the positions and velocities they are
+  /// expected to have at \e time, e.g. to plan a trajectory to splice in at that time. Returns false if no trajectory
+  /// is being executed.
+  bool getExpectedState(const ros::Time& time, moveit::core::RobotState& state) const;
+
+  /// Replace the remainder of the currently executing trajectory from \e splice_time on by \e trajectory, without
+  /// stopping. Only the last pushed trajectory can be spliced, and \e trajectory must use the same controllers and
+  /// start at the state getExpectedState() reports for \e splice_time. It is sent with \e splice_time as start time,
+  /// so the controllers need to replace their active trajectory from the start time of a new one, as
+  /// FollowJointTrajectory controllers do.
+  bool spliceTrajectory(const moveit_msgs::RobotTrajectory& trajectory, const ros::Time& splice_time);
+
+  /// Set the speed at which trajectories execute, relative to their planned timing, e.g. 0.5 for half speed. A
+  /// trajectory that is being executed is time-warped: its remainder is re-sent to the controllers with the new timing,
+  /// the speed changing at the rate set by setMaxSpeedOverrideRate(). Later trajectories start at this speed. Returns
+  /// false if the executing trajectory cannot be time-warped.
+  bool setExecutionSpeedOverride(double speed);
+
+  /// Get the speed override set by setExecutionSpeedOverride()
+  double getExecutionSpeedOverride() const;
+
+  /// Limit how fast the speed override of an executing trajectory changes, in speed factor per second. 0 applies a new
+  /// speed override instantly.
+  void setMaxSpeedOverrideRate(double rate);
+
   /// Return the controller status for the last attempted execution
   moveit_controller_manager::ExecutionStatus getLastExecutionStatus() const;
 
@@ -208,6 +252,18 @@ public:
   /// Enable or disable waiting for trajectory completion
   void setWaitForTrajectoryCompletion(bool flag);
 
+  /// Send the next pushed trajectory this many seconds before the current one is expected to finish, scheduled to
+  /// start right when it finishes, so consecutive trajectories execute without stopping in between. This only applies
+  /// to trajectories using the same controllers whose start continues the end of their predecessor. 0 disables it.
+  void setPipelineExecutionLookahead(double lookahead);
+
+  /// Set a callback receiving the progress reported by the controllers during execution
+  void setExecutionProgressCallback(const ExecutionProgressCallback& callback);
+
+  /// Abort execution as soon as a controller reports a position tracking error larger than this value, instead of
+  /// waiting for the controller or the execution duration monitoring to give up. 0 disables it.
+  void setMaxTrackingError(double error);
+
 private:
   struct ControllerInformation
   {
@@ -225,6 +281,26 @@ private:
     }
   };
 
+  /// Time warp of an executing trajectory: starting at wall time \e start, at planned time \e planned_start, the
+  /// trajectory advances at a speed that ramps from \e from to \e to at \e rate per second (instantly if \e rate is 0)
+  struct SpeedWarp
+  {
+    ros::Time start;
+    double planned_start = 0.0;
+    double from = 1.0;
+    double to = 1.0;
+    double rate = 0.0;
+
+    double rampDuration() const;
+    /// Speed and its rate of change \e t seconds after \e start
+    double speed(double t) const;
+    double acceleration(double t) const;
+    /// Planned time reached \e t seconds after \e start
+    double planned(double t) const;
+    /// Seconds after \e start at which \e planned_time is reached
+    double wall(double planned_time) const;
+  };
+
   void initialize();
 
   void reloadControllerInformation();
@@ -233,6 +309,14 @@ private:
   bool validate(const TrajectoryExecutionContext& context) const;
   bool configure(TrajectoryExecutionContext& context, const moveit_msgs::RobotTrajectory& trajectory,
                  const std::vector<std::string>& controllers);
+  bool configure(TrajectoryExecutionContext& context, const robot_trajectory::RobotTrajectory& trajectory,
+                 const std::vector<std::string>& controllers);
+  /// Select the controllers for \e actuated_joints among \e controllers (all known ones if empty) and call
+  /// \e distribute to split the trajectory among the selected context.controllers_
+  bool configureControllers(TrajectoryExecutionContext& context, const std::set<std::string>& actuated_joints,
+                            const std::vector<std::string>& controllers, const std::function<bool()>& distribute);
+  /// Add a configured \e context to the trajectories to execute, taking ownership of it
+  bool pushContext(TrajectoryExecutionContext* context);
 
   void updateControllersState(const ros::Duration& age);
   void updateControllerState(const std::string& controller, const ros::Duration& age);
@@ -240,6 +324,9 @@ private:
 
   bool distributeTrajectory(const moveit_msgs::RobotTrajectory& trajectory, const std::vector<std::string>& controllers,
                             std::vector<moveit_msgs::RobotTrajectory>& parts);
+  bool distributeTrajectory(const robot_trajectory::RobotTrajectory& trajectory,
+                            const std::set<std::string>& actuated_joints, const std::vector<std::string>& controllers,
+                            std::vector<moveit_msgs::RobotTrajectory>& parts);
 
   bool findControllers(const std::set<std::string>& actuated_joints, std::size_t controller_count,
                        const std::vector<std::string>& available_controllers,
@@ -256,11 +343,31 @@ private:
 
   void executeThread(const ExecutionCompleteCallback& callback, const PathSegmentCompleteCallback& part_callback,
                      bool auto_clear);
-  bool executePart(std::size_t part_index);
+  /// Execute trajectory \e part_index, starting it at \e start_time if that is set. If the next trajectory is
+  /// pipelined, returns as soon as it should be sent and sets \e start_time to when it should start.
+  bool executePart(std::size_t part_index, ros::Time& start_time);
+  /// Check whether \e next can be sent before \e current finishes, i.e. it uses the same controllers and its first
+  /// point continues the last point of \e current in position and velocity
+  bool canPipeline(const TrajectoryExecutionContext& current, const TrajectoryExecutionContext& next) const;
   bool waitForRobotToStop(const TrajectoryExecutionContext& context, double wait_time = 1.0);
 
+  /// Check that the last pushed trajectory is executing, so it can be spliced. Requires execution_state_mutex_ and
+  /// time_index_mutex_ to be locked.
+  bool canSplice() const;
+  /// Replace the executing trajectory parts from \e splice_time on by \e parts, checking that they start where the
+  /// executing ones are at that time if \e check_start is set. Requires execution_state_mutex_ and time_index_mutex_
+  /// to be locked.
+  bool spliceParts(std::vector<moveit_msgs::RobotTrajectory>& parts, const ros::Time& splice_time, bool check_start);
+  /// Time the remainder of \e planned from \e splice_time on according to \e warp
+  static trajectory_msgs::JointTrajectory warpJointTrajectory(const trajectory_msgs::JointTrajectory& planned,
+                                                              const SpeedWarp& warp, const ros::Time& splice_time);
+
   void stopExecutionInternal();
 
+  /// Handle the progress reported by \e controller for trajectory \e part_index
+  void receiveProgress(std::size_t part_index, const std::string& controller,
+                       const moveit_controller_manager::ExecutionProgress& progress);
+
   void receiveEvent(const std_msgs::StringConstPtr& event);
 
   void loadControllerParams();
@@ -272,6 +379,11 @@ private:
   ros::Subscriber event_topic_subscriber_;
 
   std::map<std::string, ControllerInformation> known_controllers_;
+  std::map<std::string, std::vector<std::string> > joint_controllers_;  // known controllers actuating each joint
+  // combinations of disjoint controllers found to cover a set of joints, by controller count, joints and candidates
+  std::map<std::tuple<std::size_t, std::set<std::string>, std::vector<std::string> >,
+           std::vector<std::vector<std::string> > >
+      controller_combinations_;
   bool manage_controllers_;
 
   // thread used to execute trajectories using the execute() command
@@ -287,6 +399,12 @@ private:
   std::vector<moveit_controller_manager::MoveItControllerHandlePtr> active_handles_;
   int current_context_;
   std::vector<ros::Time> time_index_;  // used to find current expected trajectory location
+  ros::Time part_start_time_;          // time the current trajectory was sent at, guarded by time_index_mutex_
+  ros::Time splice_deadline_;          // execution deadline after splicing, guarded by execution_state_mutex_
+  // the executing trajectory parts with their planned timing, and how their execution is time-warped by the speed
+  // override; guarded by time_index_mutex_
+  std::vector<moveit_msgs::RobotTrajectory> unwarped_parts_;
+  SpeedWarp speed_warp_;
   mutable boost::mutex time_index_mutex_;
   bool execution_complete_;
 
@@ -312,5 +430,15 @@ private:
   double allowed_start_tolerance_;  // joint tolerance for validate(): radians for revolute joints
   double execution_velocity_scaling_;
   bool wait_for_trajectory_completion_;
+  double pipeline_execution_lookahead_;
+  double speed_override_;  // guarded by time_index_mutex_
+  double max_speed_override_rate_;
+
+  // progress monitoring, guarded by progress_mutex_ as it is accessed from the threads receiving controller feedback
+  boost::mutex progress_mutex_;
+  std::vector<moveit_controller_manager::MoveItControllerHandlePtr> monitored_handles_;
+  ExecutionProgressCallback execution_progress_callback_;
+  double max_tracking_error_;
+  std::atomic<bool> tracking_error_exceeded_;
 };
 }  // namespace trajectory_execution_manager
@@ -36,6 +36,7 @@
 
 #include <moveit/trajectory_execution_manager/trajectory_execution_manager.h>
 #include <moveit/robot_state/robot_state.h>
+#include <moveit/profiler/trace.h>
 #include <moveit_ros_planning/TrajectoryExecutionDynamicReconfigureConfig.h>
 #include <geometric_shapes/check_isometry.h>
 #include <dynamic_reconfigure/server.h>
@@ -48,12 +49,89 @@ namespace trajectory_execution_manager
 {
 const std::string TrajectoryExecutionManager::EXECUTION_EVENT_TOPIC = "trajectory_execution_event";
 
+namespace
+{
+// Interpolate the point of trajectory at time_from_start linearly between its waypoints
+trajectory_msgs::JointTrajectoryPoint interpolatePoint(const trajectory_msgs::JointTrajectory& trajectory,
+                                                       const ros::Duration& time_from_start)
+{
+  const std::vector<trajectory_msgs::JointTrajectoryPoint>& points = trajectory.points;
+  auto next = std::upper_bound(points.begin(), points.end(), time_from_start,
+                               [](const ros::Duration& t, const trajectory_msgs::JointTrajectoryPoint& point) {
+                                 return t < point.time_from_start;
+                               });
+  if (next == points.begin())
+    return points.front();
+  if (next == points.end())
+    return points.back();
+
+  const trajectory_msgs::JointTrajectoryPoint& previous = *(next - 1);
+  const double span = (next->time_from_start - previous.time_from_start).toSec();
+  const double t = span > 0.0 ? (time_from_start - previous.time_from_start).toSec() / span : 1.0;
+  trajectory_msgs::JointTrajectoryPoint point;
+  point.time_from_start = time_from_start;
+  point.positions.resize(previous.positions.size());
+  for (std::size_t i = 0; i < point.positions.size(); ++i)
+    point.positions[i] = previous.positions[i] + t * (next->positions[i] - previous.positions[i]);
+  if (previous.velocities.size() == point.positions.size() && next->velocities.size() == point.positions.size())
+  {
+    point.velocities.resize(point.positions.size());
+    for (std::size_t i = 0; i < point.velocities.size(); ++i)
+      point.velocities[i] = previous.velocities[i] + t * (next->velocities[i] - previous.velocities[i]);
+  }
+  if (previous.accelerations.size() == point.positions.size() && next->accelerations.size() == point.positions.size())
+  {
+    point.accelerations.resize(point.positions.size());
+    for (std::size_t i = 0; i < point.accelerations.size(); ++i)
+      point.accelerations[i] = previous.accelerations[i] + t * (next->accelerations[i] - previous.accelerations[i]);
+  }
+  return point;
+}
+
+// Execute trajectory at a constant speed relative to its timing
+void scaleTrajectoryTiming(moveit_msgs::RobotTrajectory& trajectory, double speed)
+{
+  for (trajectory_msgs::JointTrajectoryPoint& point : trajectory.joint_trajectory.points)
+  {
+    point.time_from_start *= 1.0 / speed;
+    for (double& velocity : point.velocities)
+      velocity *= speed;
+    for (double& acceleration : point.accelerations)
+      acceleration *= speed * speed;
+  }
+  for (trajectory_msgs::MultiDOFJointTrajectoryPoint& point : trajectory.multi_dof_joint_trajectory.points)
+  {
+    point.time_from_start *= 1.0 / speed;
+    for (geometry_msgs::Twist& velocity : point.velocities)
+    {
+      velocity.linear.x *= speed;
+      velocity.linear.y *= speed;
+      velocity.linear.z *= speed;
+      velocity.angular.x *= speed;
+      velocity.angular.y *= speed;
+      velocity.angular.z *= speed;
+    }
+    for (geometry_msgs::Twist& acceleration : point.accelerations)
+    {
+      acceleration.linear.x *= speed * speed;
+      acceleration.linear.y *= speed * speed;
+      acceleration.linear.z *= speed * speed;
+      acceleration.angular.x *= speed * speed;
+      acceleration.angular.y *= speed * speed;
+      acceleration.angular.z *= speed * speed;
+    }
+  }
+}
+}  // namespace
+
 static const ros::Duration DEFAULT_CONTROLLER_INFORMATION_VALIDITY_AGE(1.0);
 static const double DEFAULT_CONTROLLER_GOAL_DURATION_MARGIN = 0.5;  // allow 0.5s more than the expected execution time
                                                                     // before triggering a trajectory cancel (applied
                                                                     // after scaling)
 static const double DEFAULT_CONTROLLER_GOAL_DURATION_SCALING =
     1.1;  // allow the execution of a trajectory to take more time than expected (scaled by a value > 1)
+static const double MIN_SPEED_OVERRIDE = 0.01;
+static const ros::Duration SPEED_OVERRIDE_LEAD_TIME(0.1);  // time for a time-warped trajectory to reach the controllers
 
 using namespace moveit_ros_planning;
 
@@ -76,6 +154,10 @@ private:
     owner_->setExecutionVelocityScaling(config.execution_velocity_scaling);
     owner_->setAllowedStartTolerance(config.allowed_start_tolerance);
     owner_->setWaitForTrajectoryCompletion(config.wait_for_trajectory_completion);
+    owner_->setPipelineExecutionLookahead(config.pipeline_execution_lookahead);
+    owner_->setMaxTrackingError(config.max_tracking_error);
+    owner_->setMaxSpeedOverrideRate(config.max_speed_override_rate);
+    owner_->setExecutionSpeedOverride(config.execution_speed_override);
   }
 
   TrajectoryExecutionManager* owner_;
@@ -116,6 +198,11 @@ void TrajectoryExecutionManager::initialize()
   execution_duration_monitoring_ = true;
   execution_velocity_scaling_ = 1.0;
   allowed_start_tolerance_ = 0.01;
+  pipeline_execution_lookahead_ = 0.0;
+  max_tracking_error_ = 0.0;
+  tracking_error_exceeded_ = false;
+  speed_override_ = 1.0;
+  max_speed_override_rate_ = 1.0;
 
   allowed_execution_duration_scaling_ = DEFAULT_CONTROLLER_GOAL_DURATION_SCALING;
   allowed_goal_duration_margin_ = DEFAULT_CONTROLLER_GOAL_DURATION_MARGIN;
@@ -212,6 +299,33 @@ void TrajectoryExecutionManager::setWaitForTrajectoryCompletion(bool flag)
   wait_for_trajectory_completion_ = flag;
 }
 
+void TrajectoryExecutionManager::setPipelineExecutionLookahead(double lookahead)
+{
+  pipeline_execution_lookahead_ = lookahead;
+}
+
+void TrajectoryExecutionManager::setExecutionProgressCallback(const ExecutionProgressCallback& callback)
+{
+  boost::mutex::scoped_lock slock(progress_mutex_);
+  execution_progress_callback_ = callback;
+}
+
+void TrajectoryExecutionManager::setMaxTrackingError(double error)
+{
+  max_tracking_error_ = error;
+}
+
+double TrajectoryExecutionManager::getExecutionSpeedOverride() const
+{
+  boost::mutex::scoped_lock slock(time_index_mutex_);
+  return speed_override_;
+}
+
+void TrajectoryExecutionManager::setMaxSpeedOverrideRate(double rate)
+{
+  max_speed_override_rate_ = std::max(rate, 0.0);
+}
+
 bool TrajectoryExecutionManager::isManagingControllers() const
 {
   return manage_controllers_;
@@ -271,33 +385,60 @@ bool TrajectoryExecutionManager::push(const moveit_msgs::RobotTrajectory& trajec
 
   TrajectoryExecutionContext* context = new TrajectoryExecutionContext();
   if (configure(*context, trajectory, controllers))
-  {
-    if (verbose_)
-    {
-      std::stringstream ss;
-      ss << "Pushed trajectory for execution using controllers [ ";
-      for (const std::string& controller : context->controllers_)
-        ss << controller << " ";
-      ss << "]:" << std::endl;
-      for (const moveit_msgs::RobotTrajectory& trajectory_part : context->trajectory_parts_)
-        ss << trajectory_part << std::endl;
-      ROS_INFO_NAMED(LOGNAME, "%s", ss.str().c_str());
-    }
-    trajectories_.push_back(context);
-    return true;
-  }
+    return pushContext(context);
+  delete context;
+  last_execution_status_ = moveit_controller_manager::ExecutionStatus::ABORTED;
+  return false;
+}
+
+bool TrajectoryExecutionManager::push(const robot_trajectory::RobotTrajectory& trajectory,
+                                      const std::string& controller)
+{
+  if (controller.empty())
+    return push(trajectory, std::vector<std::string>());
   else
+    return push(trajectory, std::vector<std::string>(1, controller));
+}
+
+bool TrajectoryExecutionManager::push(const robot_trajectory::RobotTrajectory& trajectory,
+                                      const std::vector<std::string>& controllers)
+{
+  if (!execution_complete_)
   {
-    delete context;
-    last_execution_status_ = moveit_controller_manager::ExecutionStatus::ABORTED;
+    ROS_ERROR_NAMED(LOGNAME, "Cannot push a new trajectory while another is being executed");
+    return false;
   }
 
+  TrajectoryExecutionContext* context = new TrajectoryExecutionContext();
+  if (configure(*context, trajectory, controllers))
+    return pushContext(context);
+  delete context;
+  last_execution_status_ = moveit_controller_manager::ExecutionStatus::ABORTED;
   return false;
 }
 
+bool TrajectoryExecutionManager::pushContext(TrajectoryExecutionContext* context)
+{
+  if (verbose_)
+  {
+    std::stringstream ss;
+    ss << "Pushed trajectory for execution using controllers [ ";
+    for (const std::string& controller : context->controllers_)
+      ss << controller << " ";
+    ss << "]:" << std::endl;
+    for (const moveit_msgs::RobotTrajectory& trajectory_part : context->trajectory_parts_)
+      ss << trajectory_part << std::endl;
+    ROS_INFO_NAMED(LOGNAME, "%s", ss.str().c_str());
+  }
+  trajectories_.push_back(context);
+  return true;
+}
+
 void TrajectoryExecutionManager::reloadControllerInformation()
 {
   known_controllers_.clear();
+  joint_controllers_.clear();
+  controller_combinations_.clear();
   if (controller_manager_)
   {
     std::vector<std::string> names;
@@ -309,24 +450,17 @@ void TrajectoryExecutionManager::reloadControllerInformation()
       ControllerInformation ci;
       ci.name_ = name;
       ci.joints_.insert(joints.begin(), joints.end());
+      for (const std::string& joint : ci.joints_)
+        joint_controllers_[joint].push_back(name);
       known_controllers_[ci.name_] = ci;
     }
 
-    for (std::map<std::string, ControllerInformation>::iterator it = known_controllers_.begin();
-         it != known_controllers_.end(); ++it)
-      for (std::map<std::string, ControllerInformation>::iterator jt = known_controllers_.begin();
-           jt != known_controllers_.end(); ++jt)
-        if (it != jt)
-        {
-          std::vector<std::string> intersect;
-          std::set_intersection(it->second.joints_.begin(), it->second.joints_.end(), jt->second.joints_.begin(),
-                                jt->second.joints_.end(), std::back_inserter(intersect));
-          if (!intersect.empty())
-          {
-            it->second.overlapping_controllers_.insert(jt->first);
-            jt->second.overlapping_controllers_.insert(it->first);
-          }
-        }
+    // controllers overlap if they share a joint
+    for (const std::pair<const std::string, std::vector<std::string> >& joint_controllers : joint_controllers_)
+      for (const std::string& controller : joint_controllers.second)
+        for (const std::string& other_controller : joint_controllers.second)
+          if (controller != other_controller)
+            known_controllers_[controller].overlapping_controllers_.insert(other_controller);
   }
 }
 
@@ -457,12 +591,20 @@ bool TrajectoryExecutionManager::findControllers(const std::set<std::string>& ac
                                                  const std::vector<std::string>& available_controllers,
                                                  std::vector<std::string>& selected_controllers)
 {
-  // generate all combinations of controller_count controllers that operate on disjoint sets of joints
-  std::vector<std::string> work_area;
+  // generate all combinations of controller_count controllers that operate on disjoint sets of joints;
+  // these only depend on the joints of the controllers, so they are cached until the controllers are reloaded
   OrderPotentialControllerCombination order;
   std::vector<std::vector<std::string>>& selected_options = order.selected_options;
-  generateControllerCombination(0, controller_count, available_controllers, work_area, selected_options,
-                                actuated_joints);
+  auto key = std::make_tuple(controller_count, actuated_joints, available_controllers);
+  auto combinations = controller_combinations_.find(key);
+  if (combinations == controller_combinations_.end())
+  {
+    std::vector<std::string> work_area;
+    std::vector<std::vector<std::string>> options;
+    generateControllerCombination(0, controller_count, available_controllers, work_area, options, actuated_joints);
+    combinations = controller_combinations_.emplace(std::move(key), std::move(options)).first;
+  }
+  selected_options = combinations->second;
 
   if (verbose_)
   {
@@ -557,15 +699,28 @@ bool TrajectoryExecutionManager::selectControllers(const std::set<std::string>&
                                                    const std::vector<std::string>& available_controllers,
                                                    std::vector<std::string>& selected_controllers)
 {
-  for (std::size_t i = 1; i <= available_controllers.size(); ++i)
-    if (findControllers(actuated_joints, i, available_controllers, selected_controllers))
+  // only controllers that actuate any of the joints are worth combining
+  std::set<std::string> actuating_controllers;
+  for (const std::string& joint : actuated_joints)
+  {
+    std::map<std::string, std::vector<std::string>>::const_iterator it = joint_controllers_.find(joint);
+    if (it != joint_controllers_.end())
+      actuating_controllers.insert(it->second.begin(), it->second.end());
+  }
+  std::vector<std::string> candidates;
+  for (const std::string& controller : available_controllers)
+    if (actuating_controllers.find(controller) != actuating_controllers.end())
+      candidates.push_back(controller);
+
+  for (std::size_t i = 1; i <= candidates.size(); ++i)
+    if (findControllers(actuated_joints, i, candidates, selected_controllers))
     {
       // if we are not managing controllers, prefer to use active controllers even if there are more of them
       if (!manage_controllers_ && !areControllersActive(selected_controllers))
       {
         std::vector<std::string> other_option;
-        for (std::size_t j = i + 1; j <= available_controllers.size(); ++j)
-          if (findControllers(actuated_joints, j, available_controllers, other_option))
+        for (std::size_t j = i + 1; j <= candidates.size(); ++j)
+          if (findControllers(actuated_joints, j, candidates, other_option))
           {
             if (areControllersActive(other_option))
             {
@@ -715,8 +870,56 @@ bool TrajectoryExecutionManager::distributeTrajectory(const moveit_msgs::RobotTr
   return true;
 }
 
+bool TrajectoryExecutionManager::distributeTrajectory(const robot_trajectory::RobotTrajectory& trajectory,
+                                                      const std::set<std::string>& actuated_joints,
+                                                      const std::vector<std::string>& controllers,
+                                                      std::vector<moveit_msgs::RobotTrajectory>& parts)
+{
+  parts.clear();
+  parts.resize(controllers.size());
+
+  for (std::size_t i = 0; i < controllers.size(); ++i)
+  {
+    std::map<std::string, ControllerInformation>::iterator it = known_controllers_.find(controllers[i]);
+    if (it == known_controllers_.end())
+    {
+      ROS_ERROR_STREAM_NAMED(LOGNAME, "Controller " << controllers[i] << " not found.");
+      return false;
+    }
+    std::vector<std::string> intersect;
+    std::set_intersection(it->second.joints_.begin(), it->second.joints_.end(), actuated_joints.begin(),
+                          actuated_joints.end(), std::back_inserter(intersect));
+    if (intersect.empty())
+    {
+      ROS_WARN_STREAM_NAMED(LOGNAME, "No joints to be distributed for controller " << controllers[i]);
+      continue;
+    }
+
+    // convert only the joints of this controller, straight from the waypoints
+    trajectory.getRobotTrajectoryMsg(parts[i], intersect);
+    if (execution_velocity_scaling_ != 1.0)
+    {
+      for (trajectory_msgs::JointTrajectoryPoint& point : parts[i].joint_trajectory.points)
+        for (double& velocity : point.velocities)
+          velocity *= execution_velocity_scaling_;
+      for (trajectory_msgs::MultiDOFJointTrajectoryPoint& point : parts[i].multi_dof_joint_trajectory.points)
+        for (geometry_msgs::Twist& velocity : point.velocities)
+        {
+          velocity.linear.x *= execution_velocity_scaling_;
+          velocity.linear.y *= execution_velocity_scaling_;
+          velocity.linear.z *= execution_velocity_scaling_;
+          velocity.angular.x *= execution_velocity_scaling_;
+          velocity.angular.y *= execution_velocity_scaling_;
+          velocity.angular.z *= execution_velocity_scaling_;
+        }
+    }
+  }
+  return true;
+}
+
 bool TrajectoryExecutionManager::validate(const TrajectoryExecutionContext& context) const
 {
+  MOVEIT_TRACE_ZONE("TrajectoryExecutionManager::validate");
   if (allowed_start_tolerance_ == 0)  // skip validation on this magic number
     return true;
 
@@ -841,6 +1044,43 @@ bool TrajectoryExecutionManager::configure(TrajectoryExecutionContext& context,
     return false;
   }
 
+  return configureControllers(context, actuated_joints, controllers, [&]() {
+    return distributeTrajectory(trajectory, context.controllers_, context.trajectory_parts_);
+  });
+}
+
+bool TrajectoryExecutionManager::configure(TrajectoryExecutionContext& context,
+                                           const robot_trajectory::RobotTrajectory& trajectory,
+                                           const std::vector<std::string>& controllers)
+{
+  if (trajectory.empty())
+  {
+    // empty trajectories don't need to configure anything
+    return true;
+  }
+  std::set<std::string> actuated_joints;
+  const moveit::core::JointModelGroup* group = trajectory.getGroup();
+  for (const moveit::core::JointModel* jm :
+       group ? group->getActiveJointModels() : robot_model_->getActiveJointModels())
+    if (!jm->isPassive() && !jm->getMimic() && jm->getType() != moveit::core::JointModel::FIXED)
+      actuated_joints.insert(jm->getName());
+
+  if (actuated_joints.empty())
+  {
+    ROS_WARN_NAMED(LOGNAME, "The trajectory to execute specifies no joints");
+    return false;
+  }
+
+  return configureControllers(context, actuated_joints, controllers, [&]() {
+    return distributeTrajectory(trajectory, actuated_joints, context.controllers_, context.trajectory_parts_);
+  });
+}
+
+bool TrajectoryExecutionManager::configureControllers(TrajectoryExecutionContext& context,
+                                                      const std::set<std::string>& actuated_joints,
+                                                      const std::vector<std::string>& controllers,
+                                                      const std::function<bool()>& distribute)
+{
   if (controllers.empty())
   {
     bool retry = true;
@@ -854,7 +1094,7 @@ bool TrajectoryExecutionManager::configure(TrajectoryExecutionContext& context,
         all_controller_names.push_back(it->first);
       if (selectControllers(actuated_joints, all_controller_names, context.controllers_))
       {
-        if (distributeTrajectory(trajectory, context.controllers_, context.trajectory_parts_))
+        if (distribute())
           return true;
       }
       else
@@ -890,7 +1130,7 @@ bool TrajectoryExecutionManager::configure(TrajectoryExecutionContext& context,
         }
     if (selectControllers(actuated_joints, controllers, context.controllers_))
     {
-      if (distributeTrajectory(trajectory, context.controllers_, context.trajectory_parts_))
+      if (distribute())
         return true;
     }
   }
@@ -936,6 +1176,50 @@ void TrajectoryExecutionManager::stopExecutionInternal()
     }
 }
 
+void TrajectoryExecutionManager::receiveProgress(std::size_t part_index, const std::string& controller,
+                                                 const moveit_controller_manager::ExecutionProgress& progress)
+{
+  // This runs in the thread delivering controller feedback, which may hold locks of the controller's action client.
+  // execution_state_mutex_ is held while canceling controllers, so only progress_mutex_ is used here, and controllers
+  // are canceled without holding it.
+  ExecutionProgressCallback callback;
+  std::vector<moveit_controller_manager::MoveItControllerHandlePtr> handles_to_cancel;
+  {
+    boost::mutex::scoped_lock slock(progress_mutex_);
+    // ignore late feedback of trajectories that are not executed anymore
+    if (monitored_handles_.empty())
+      return;
+    callback = execution_progress_callback_;
+
+    if (max_tracking_error_ > 0.0 && !tracking_error_exceeded_)
+      for (std::size_t i = 0; i < progress.position_errors.size(); ++i)
+        if (std::fabs(progress.position_errors[i]) > max_tracking_error_)
+        {
+          ROS_ERROR_NAMED(LOGNAME, "Controller '%s' reports a tracking error of %g for joint '%s' (allowed: %g). "
+                                   "Stopping trajectory.",
+                          controller.c_str(), progress.position_errors[i],
+                          i < progress.joint_names.size() ? progress.joint_names[i].c_str() : "", max_tracking_error_);
+          tracking_error_exceeded_ = true;
+          handles_to_cancel = monitored_handles_;
+          break;
+        }
+  }
+
+  // like the duration monitoring, only cancel the controllers and let executePart() report the failure
+  for (moveit_controller_manager::MoveItControllerHandlePtr& handle : handles_to_cancel)
+    try
+    {
+      handle->cancelExecution();
+    }
+    catch (std::exception& ex)
+    {
+      ROS_ERROR_NAMED(LOGNAME, "Caught %s when canceling execution.", ex.what());
+    }
+
+  if (callback)
+    callback(part_index, controller, progress);
+}
+
 void TrajectoryExecutionManager::stopExecution(bool auto_clear)
 {
   if (!execution_complete_)
@@ -1057,10 +1341,13 @@ void TrajectoryExecutionManager::executeThread(const ExecutionCompleteCallback&
 
   // execute each trajectory, one after the other (executePart() is blocking) or until one fails.
   // on failure, the status is set by executePart(). Otherwise, it will remain as set above (success)
+  // a pipelined trajectory is handed over to its successor shortly before it finishes and reported complete then
+  // when a trajectory is pipelined, start_time is set to when its predecessor finishes
   std::size_t i = 0;
+  ros::Time start_time;
   for (; i < trajectories_.size(); ++i)
   {
-    bool epart = executePart(i);
+    bool epart = executePart(i, start_time);
     if (epart && part_callback)
       part_callback(i);
     if (!epart || execution_complete_)
@@ -1092,10 +1379,69 @@ void TrajectoryExecutionManager::executeThread(const ExecutionCompleteCallback&
     callback(last_execution_status_);
 }
 
-bool TrajectoryExecutionManager::executePart(std::size_t part_index)
+bool TrajectoryExecutionManager::canPipeline(const TrajectoryExecutionContext& current,
+                                             const TrajectoryExecutionContext& next) const
+{
+  if (current.controllers_ != next.controllers_)
+    return false;
+
+  for (std::size_t i = 0; i < current.trajectory_parts_.size(); ++i)
+  {
+    const moveit_msgs::RobotTrajectory& current_part = current.trajectory_parts_[i];
+    const moveit_msgs::RobotTrajectory& next_part = next.trajectory_parts_[i];
+    // multi-dof trajectories are never spliced
+    if (!current_part.multi_dof_joint_trajectory.points.empty() || !next_part.multi_dof_joint_trajectory.points.empty())
+      return false;
+    if (current_part.joint_trajectory.points.empty() || next_part.joint_trajectory.points.empty() ||
+        current_part.joint_trajectory.joint_names != next_part.joint_trajectory.joint_names)
+      return false;
+
+    const trajectory_msgs::JointTrajectoryPoint& last = current_part.joint_trajectory.points.back();
+    const trajectory_msgs::JointTrajectoryPoint& first = next_part.joint_trajectory.points.front();
+    if (last.positions.size() != first.positions.size())
+      return false;
+    for (std::size_t j = 0; j < first.positions.size(); ++j)
+      if (std::fabs(last.positions[j] - first.positions[j]) > allowed_start_tolerance_)
+        return false;
+    // a missing velocity counts as zero
+    for (std::size_t j = 0; j < first.positions.size(); ++j)
+    {
+      const double last_velocity = j < last.velocities.size() ? last.velocities[j] : 0.0;
+      const double first_velocity = j < first.velocities.size() ? first.velocities[j] : 0.0;
+      if (std::fabs(last_velocity - first_velocity) > allowed_start_tolerance_)
+        return false;
+    }
+  }
+  return true;
+}
+
+bool TrajectoryExecutionManager::executePart(std::size_t part_index, ros::Time& start_time)
 {
+  MOVEIT_TRACE_ZONE("TrajectoryExecutionManager::executePart");
   TrajectoryExecutionContext& context = *trajectories_[part_index];
 
+  // a pipelined predecessor is still executing until start_time; it is canceled if this part cannot be sent
+  std::vector<moveit_controller_manager::MoveItControllerHandlePtr> previous_handles;
+  if (!start_time.isZero())
+  {
+    boost::mutex::scoped_lock slock(execution_state_mutex_);
+    previous_handles = active_handles_;
+    for (moveit_msgs::RobotTrajectory& part : context.trajectory_parts_)
+      part.joint_trajectory.header.stamp = std::max(part.joint_trajectory.header.stamp, start_time);
+    start_time = ros::Time();
+  }
+  const auto cancel_previous = [&previous_handles] {
+    for (moveit_controller_manager::MoveItControllerHandlePtr& handle : previous_handles)
+      try
+      {
+        handle->cancelExecution();
+      }
+      catch (std::exception& ex)
+      {
+        ROS_ERROR_NAMED(LOGNAME, "Caught %s when canceling execution", ex.what());
+      }
+  };
+
   // first make sure desired controllers are active
   if (ensureActiveControllers(context.controllers_))
   {
@@ -1104,6 +1450,7 @@ bool TrajectoryExecutionManager::executePart(std::size_t part_index)
       return false;
 
     std::vector<moveit_controller_manager::MoveItControllerHandlePtr> handles;
+    double speed = 1.0;
     {
       boost::mutex::scoped_lock slock(execution_state_mutex_);
       if (!execution_complete_)
@@ -1111,6 +1458,12 @@ bool TrajectoryExecutionManager::executePart(std::size_t part_index)
         // time indexing uses this member too, so we lock this mutex as well
         time_index_mutex_.lock();
         current_context_ = part_index;
+        // keep the planned timing for time warping, and execute at the current speed override
+        unwarped_parts_ = context.trajectory_parts_;
+        speed = speed_override_;
+        if (speed != 1.0)
+          for (moveit_msgs::RobotTrajectory& part : context.trajectory_parts_)
+            scaleTrajectoryTiming(part, speed);
         time_index_mutex_.unlock();
         active_handles_.resize(context.controllers_.size());
         for (std::size_t i = 0; i < context.controllers_.size(); ++i)
@@ -1126,6 +1479,7 @@ bool TrajectoryExecutionManager::executePart(std::size_t part_index)
           }
           if (!h)
           {
+            cancel_previous();
             active_handles_.clear();
             current_context_ = -1;
             last_execution_status_ = moveit_controller_manager::ExecutionStatus::ABORTED;
@@ -1133,9 +1487,20 @@ bool TrajectoryExecutionManager::executePart(std::size_t part_index)
                             context.controllers_[i].c_str());
             return false;
           }
+          const std::string& controller = context.controllers_[i];
+          h->setProgressCallback([this, part_index, controller](const auto& progress) {
+            receiveProgress(part_index, controller, progress);
+          });
           active_handles_[i] = h;
         }
         handles = active_handles_;  // keep a copy for later, to avoid thread safety issues
+        splice_deadline_ = ros::Time();
+        {
+          // monitor the progress of the new handles before anything is sent to them
+          boost::mutex::scoped_lock plock(progress_mutex_);
+          monitored_handles_ = handles;
+          tracking_error_exceeded_ = false;
+        }
         for (std::size_t i = 0; i < context.trajectory_parts_.size(); ++i)
         {
           bool ok = false;
@@ -1162,9 +1527,12 @@ bool TrajectoryExecutionManager::executePart(std::size_t part_index)
                             context.trajectory_parts_.size(), active_handles_[i]->getName().c_str());
             if (i > 0)
               ROS_ERROR_NAMED(LOGNAME, "Cancelling previously sent trajectory parts");
+            cancel_previous();
             active_handles_.clear();
             current_context_ = -1;
             last_execution_status_ = moveit_controller_manager::ExecutionStatus::ABORTED;
+            boost::mutex::scoped_lock plock(progress_mutex_);
+            monitored_handles_.clear();
             return false;
           }
         }
@@ -1224,6 +1592,13 @@ bool TrajectoryExecutionManager::executePart(std::size_t part_index)
     if (longest_part >= 0)
     {
       boost::mutex::scoped_lock slock(time_index_mutex_);
+      part_start_time_ = current_time;
+      speed_warp_ = SpeedWarp();
+      speed_warp_.start = current_time;
+      for (const moveit_msgs::RobotTrajectory& part : context.trajectory_parts_)
+        speed_warp_.start = std::max(speed_warp_.start, part.joint_trajectory.header.stamp);
+      speed_warp_.from = speed_warp_.to = speed;
+      speed_warp_.rate = max_speed_override_rate_;
 
       if (context.trajectory_parts_[longest_part].joint_trajectory.points.size() >=
           context.trajectory_parts_[longest_part].multi_dof_joint_trajectory.points.size())
@@ -1246,12 +1621,60 @@ bool TrajectoryExecutionManager::executePart(std::size_t part_index)
       }
     }
 
+    // if the next trajectory continues this one, wait only until it needs to be sent and hand over to it, keeping the
+    // active handles so that a stop request still cancels this trajectory
+    if (pipeline_execution_lookahead_ > 0.0 && part_index + 1 < trajectories_.size() &&
+        canPipeline(context, *trajectories_[part_index + 1]))
+    {
+      ros::Time end_time = current_time;
+      for (const moveit_msgs::RobotTrajectory& part : context.trajectory_parts_)
+        end_time = std::max(end_time, std::max(part.joint_trajectory.header.stamp, current_time) +
+                                          part.joint_trajectory.points.back().time_from_start);
+      const ros::Time handover_time = end_time - ros::Duration(pipeline_execution_lookahead_);
+
+      bool running = false;
+      for (moveit_controller_manager::MoveItControllerHandlePtr& handle : handles)
+      {
+        // a zero timeout would wait for completion, so a handover that is already due does not wait at all
+        const ros::Duration remaining = handover_time - ros::Time::now();
+        if (remaining <= ros::Duration(0.0) || !handle->waitForExecution(remaining))
+          running = true;
+        else if (handle->getLastExecutionStatus() != moveit_controller_manager::ExecutionStatus::SUCCEEDED)
+        {
+          // let the regular checks below report the failure
+          running = false;
+          break;
+        }
+      }
+      if (running && !execution_complete_)
+      {
+        boost::mutex::scoped_lock slock(time_index_mutex_);
+        time_index_.clear();
+        current_context_ = -1;
+        start_time = end_time;
+        return true;
+      }
+    }
+
     bool result = true;
     for (moveit_controller_manager::MoveItControllerHandlePtr& handle : handles)
     {
       if (execution_duration_monitoring_)
       {
-        if (!handle->waitForExecution(expected_trajectory_duration))
+        bool finished = handle->waitForExecution(expected_trajectory_duration);
+        // a spliced trajectory may run longer than the one sent originally
+        while (!finished && !execution_complete_)
+        {
+          ros::Duration remaining;
+          {
+            boost::mutex::scoped_lock slock(execution_state_mutex_);
+            remaining = splice_deadline_ - ros::Time::now();
+          }
+          if (remaining <= ros::Duration(0.0))
+            break;
+          finished = handle->waitForExecution(remaining);
+        }
+        if (!finished)
           if (!execution_complete_ && ros::Time::now() - current_time > expected_trajectory_duration)
           {
             ROS_ERROR_NAMED(LOGNAME,
@@ -1286,6 +1709,20 @@ bool TrajectoryExecutionManager::executePart(std::size_t part_index)
       }
     }
 
+    if (tracking_error_exceeded_)
+    {
+      last_execution_status_ = moveit_controller_manager::ExecutionStatus::ABORTED;
+      result = false;
+    }
+
+    // stop monitoring the progress
+    {
+      boost::mutex::scoped_lock plock(progress_mutex_);
+      monitored_handles_.clear();
+    }
+    for (moveit_controller_manager::MoveItControllerHandlePtr& handle : handles)
+      handle->setProgressCallback(moveit_controller_manager::ExecutionProgressCallback());
+
     // clear the active handles
     execution_state_mutex_.lock();
     active_handles_.clear();
@@ -1301,6 +1738,7 @@ bool TrajectoryExecutionManager::executePart(std::size_t part_index)
   }
   else
   {
+    cancel_previous();
     last_execution_status_ = moveit_controller_manager::ExecutionStatus::ABORTED;
     return false;
   }
@@ -1365,6 +1803,300 @@ bool TrajectoryExecutionManager::waitForRobotToStop(const TrajectoryExecutionCon
   return time_remaining > 0;
 }
 
+bool TrajectoryExecutionManager::getExpectedState(const ros::Time& time, moveit::core::RobotState& state) const
+{
+  boost::mutex::scoped_lock slock(time_index_mutex_);
+  if (current_context_ < 0 || time_index_.empty())
+    return false;
+
+  for (const moveit_msgs::RobotTrajectory& part : trajectories_[current_context_]->trajectory_parts_)
+  {
+    if (part.joint_trajectory.points.empty())
+      continue;
+    const ros::Time start = std::max(part.joint_trajectory.header.stamp, part_start_time_);
+    const trajectory_msgs::JointTrajectoryPoint point = interpolatePoint(part.joint_trajectory, time - start);
+    state.setVariablePositions(part.joint_trajectory.joint_names, point.positions);
+    if (!point.velocities.empty())
+      state.setVariableVelocities(part.joint_trajectory.joint_names, point.velocities);
+  }
+  return true;
+}
+
+bool TrajectoryExecutionManager::canSplice() const
+{
+  // the time index is built once the execution of a trajectory is monitored
+  if (execution_complete_ || current_context_ < 0 || time_index_.empty() || active_handles_.empty())
+  {
+    ROS_ERROR_NAMED(LOGNAME, "Cannot splice a trajectory: no trajectory is being executed");
+    return false;
+  }
+  if (static_cast<std::size_t>(current_context_) + 1 != trajectories_.size())
+  {
+    ROS_ERROR_NAMED(LOGNAME, "Cannot splice a trajectory: only the last pushed trajectory can be spliced");
+    return false;
+  }
+  return true;
+}
+
+bool TrajectoryExecutionManager::spliceTrajectory(const moveit_msgs::RobotTrajectory& trajectory,
+                                                  const ros::Time& splice_time)
+{
+  boost::mutex::scoped_lock slock(execution_state_mutex_);
+  boost::mutex::scoped_lock tlock(time_index_mutex_);
+  if (!canSplice())
+    return false;
+  if (splice_time < ros::Time::now())
+  {
+    ROS_ERROR_NAMED(LOGNAME, "Cannot splice a trajectory at a time in the past");
+    return false;
+  }
+
+  std::vector<moveit_msgs::RobotTrajectory> parts;
+  if (!distributeTrajectory(trajectory, trajectories_[current_context_]->controllers_, parts))
+  {
+    ROS_ERROR_NAMED(LOGNAME, "Cannot splice a trajectory that does not fit the controllers currently executing");
+    return false;
+  }
+
+  // the new trajectory continues at the speed the executing one has at the splice time
+  const double t = (splice_time - speed_warp_.start).toSec();
+  SpeedWarp warp;
+  warp.start = splice_time;
+  warp.from = speed_warp_.speed(t);
+  warp.to = speed_override_;
+  warp.rate = max_speed_override_rate_;
+  std::vector<moveit_msgs::RobotTrajectory> warped_parts = parts;
+  if (warp.from != 1.0 || warp.to != 1.0)
+    for (moveit_msgs::RobotTrajectory& part : warped_parts)
+      if (!part.joint_trajectory.points.empty())
+        part.joint_trajectory = warpJointTrajectory(part.joint_trajectory, warp, splice_time);
+
+  if (!spliceParts(warped_parts, splice_time, true))
+    return false;
+  unwarped_parts_ = parts;
+  speed_warp_ = warp;
+  return true;
+}
+
+bool TrajectoryExecutionManager::spliceParts(std::vector<moveit_msgs::RobotTrajectory>& parts,
+                                             const ros::Time& splice_time, bool check_start)
+{
+  TrajectoryExecutionContext& context = *trajectories_[current_context_];
+
+  // validate all parts before sending any, and compute the spliced trajectories
+  std::vector<trajectory_msgs::JointTrajectory::_points_type> spliced_points(parts.size());
+  ros::Time end_time = splice_time;
+  for (std::size_t i = 0; i < parts.size(); ++i)
+  {
+    const trajectory_msgs::JointTrajectory& current = context.trajectory_parts_[i].joint_trajectory;
+    trajectory_msgs::JointTrajectory& next = parts[i].joint_trajectory;
+    if (!parts[i].multi_dof_joint_trajectory.points.empty() ||
+        !context.trajectory_parts_[i].multi_dof_joint_trajectory.points.empty() || current.points.empty() ||
+        next.points.empty() || current.joint_names != next.joint_names)
+    {
+      ROS_ERROR_NAMED(LOGNAME, "Cannot splice trajectory part %zu for controller '%s': only single-dof trajectories "
+                               "on the same joints can be spliced",
+                      i, context.controllers_[i].c_str());
+      return false;
+    }
+
+    const ros::Time start = std::max(current.header.stamp, part_start_time_);
+    const ros::Duration offset = splice_time - start;
+    if (offset >= current.points.back().time_from_start)
+    {
+      ROS_ERROR_NAMED(LOGNAME,
+                      "Cannot splice trajectory part %zu: the executing trajectory ends before the splice time", i);
+      return false;
+    }
+
+    const trajectory_msgs::JointTrajectoryPoint expected = interpolatePoint(current, offset);
+    for (std::size_t j = 0; check_start && allowed_start_tolerance_ > 0.0 && j < expected.positions.size(); ++j)
+      if (std::fabs(expected.positions[j] - next.points.front().positions[j]) > allowed_start_tolerance_)
+      {
+        ROS_ERROR_NAMED(LOGNAME,
+                        "Cannot splice trajectory: joint '%s' starts at %g, but is expected at %g at the splice time",
+                        next.joint_names[j].c_str(), next.points.front().positions[j], expected.positions[j]);
+        return false;
+      }
+
+    // the executed trajectory is the current one up to the splice time, followed by the new one
+    for (const trajectory_msgs::JointTrajectoryPoint& point : current.points)
+      if (point.time_from_start < offset)
+        spliced_points[i].push_back(point);
+    for (trajectory_msgs::JointTrajectoryPoint point : next.points)
+    {
+      point.time_from_start += offset;
+      spliced_points[i].push_back(point);
+    }
+    next.header.stamp = splice_time;
+    end_time = std::max(end_time, start + spliced_points[i].back().time_from_start);
+  }
+
+  for (std::size_t i = 0; i < parts.size(); ++i)
+  {
+    bool ok = false;
+    try
+    {
+      ok = active_handles_[i]->sendTrajectory(parts[i]);
+    }
+    catch (std::exception& ex)
+    {
+      ROS_ERROR_NAMED(LOGNAME, "Caught %s when sending trajectory to controller", ex.what());
+    }
+    if (!ok)
+    {
+      // the controllers may now execute inconsistent motions, so they are all stopped
+      ROS_ERROR_NAMED(LOGNAME, "Failed to splice trajectory part %zu into controller %s. Stopping trajectory.", i,
+                      active_handles_[i]->getName().c_str());
+      stopExecutionInternal();
+      return false;
+    }
+  }
+
+  // keep the context and the time index in line with what is executed now
+  std::size_t longest_part = 0;
+  for (std::size_t i = 0; i < parts.size(); ++i)
+  {
+    context.trajectory_parts_[i].joint_trajectory.points.swap(spliced_points[i]);
+    if (context.trajectory_parts_[i].joint_trajectory.points.size() >
+        context.trajectory_parts_[longest_part].joint_trajectory.points.size())
+      longest_part = i;
+  }
+  const trajectory_msgs::JointTrajectory& longest = context.trajectory_parts_[longest_part].joint_trajectory;
+  const ros::Time longest_start = std::max(longest.header.stamp, part_start_time_);
+  time_index_.clear();
+  for (const trajectory_msgs::JointTrajectoryPoint& point : longest.points)
+    time_index_.push_back(longest_start + point.time_from_start);
+
+  splice_deadline_ = part_start_time_ + (end_time - part_start_time_) * allowed_execution_duration_scaling_ +
+                     ros::Duration(allowed_goal_duration_margin_);
+  ROS_INFO_NAMED(LOGNAME, "Spliced a new trajectory into the executing one, %.3f s from now",
+                 (splice_time - ros::Time::now()).toSec());
+  return true;
+}
+
+double TrajectoryExecutionManager::SpeedWarp::rampDuration() const
+{
+  return rate > 0.0 ? std::fabs(to - from) / rate : 0.0;
+}
+
+double TrajectoryExecutionManager::SpeedWarp::speed(double t) const
+{
+  if (t <= 0.0)
+    return from;
+  if (t >= rampDuration())
+    return to;
+  return from + acceleration(t) * t;
+}
+
+double TrajectoryExecutionManager::SpeedWarp::acceleration(double t) const
+{
+  if (t < 0.0 || t >= rampDuration())
+    return 0.0;
+  return to > from ? rate : -rate;
+}
+
+double TrajectoryExecutionManager::SpeedWarp::planned(double t) const
+{
+  if (t <= 0.0)
+    return planned_start + from * t;
+  const double ramp = std::min(t, rampDuration());
+  return planned_start + from * ramp + 0.5 * acceleration(0.0) * ramp * ramp + to * (t - ramp);
+}
+
+double TrajectoryExecutionManager::SpeedWarp::wall(double planned_time) const
+{
+  if (planned_time <= planned_start)
+    return (planned_time - planned_start) / from;
+  const double ramp = rampDuration();
+  const double ramp_end = planned(ramp);
+  if (planned_time >= ramp_end)
+    return ramp + (planned_time - ramp_end) / to;
+  // solve from * t + acceleration / 2 * t^2 = planned_time - planned_start in a numerically stable way
+  const double d = planned_time - planned_start;
+  return 2.0 * d / (from + std::sqrt(std::max(0.0, from * from + 2.0 * acceleration(0.0) * d)));
+}
+
+trajectory_msgs::JointTrajectory TrajectoryExecutionManager::warpJointTrajectory(
+    const trajectory_msgs::JointTrajectory& planned, const SpeedWarp& warp, const ros::Time& splice_time)
+{
+  const double splice_wall = (splice_time - warp.start).toSec();
+  const double splice_planned = warp.planned(splice_wall);
+
+  trajectory_msgs::JointTrajectory warped;
+  warped.header = planned.header;
+  warped.header.stamp = splice_time;
+  warped.joint_names = planned.joint_names;
+  const auto add_point = [&](trajectory_msgs::JointTrajectoryPoint point, double t) {
+    // the planned derivatives are scaled by the speed, and its rate of change adds to the accelerations
+    const double speed = warp.speed(t);
+    point.time_from_start = ros::Duration(t - splice_wall);
+    if (point.accelerations.size() == point.velocities.size())
+      for (std::size_t i = 0; i < point.accelerations.size(); ++i)
+        point.accelerations[i] = point.accelerations[i] * speed * speed + point.velocities[i] * warp.acceleration(t);
+    else
+      point.accelerations.clear();
+    for (double& velocity : point.velocities)
+      velocity *= speed;
+    warped.points.push_back(point);
+  };
+
+  add_point(interpolatePoint(planned, ros::Duration(splice_planned)), splice_wall);
+  for (const trajectory_msgs::JointTrajectoryPoint& point : planned.points)
+    if (point.time_from_start.toSec() > splice_planned)
+      add_point(point, warp.wall(point.time_from_start.toSec()));
+  return warped;
+}
+
+bool TrajectoryExecutionManager::setExecutionSpeedOverride(double speed)
+{
+  speed = std::max(speed, MIN_SPEED_OVERRIDE);
+  boost::mutex::scoped_lock slock(execution_state_mutex_);
+  boost::mutex::scoped_lock tlock(time_index_mutex_);
+  if (speed == speed_override_)
+    return true;
+  speed_override_ = speed;
+
+  // without an executing trajectory, the speed override applies to the next one
+  if (execution_complete_ || current_context_ < 0 || time_index_.empty() || active_handles_.empty() ||
+      unwarped_parts_.empty())
+    return true;
+  if (!canSplice())
+    return false;
+
+  // ramp the speed from the one of the executing trajectory at the time the re-sent one reaches the controllers
+  const ros::Time splice_time = std::max(ros::Time::now() + SPEED_OVERRIDE_LEAD_TIME, speed_warp_.start);
+  const double t = (splice_time - speed_warp_.start).toSec();
+  SpeedWarp warp;
+  warp.start = splice_time;
+  warp.planned_start = speed_warp_.planned(t);
+  warp.from = speed_warp_.speed(t);
+  warp.to = speed;
+  warp.rate = max_speed_override_rate_;
+
+  std::vector<moveit_msgs::RobotTrajectory> parts(unwarped_parts_.size());
+  for (std::size_t i = 0; i < unwarped_parts_.size(); ++i)
+  {
+    const trajectory_msgs::JointTrajectory& planned = unwarped_parts_[i].joint_trajectory;
+    if (!unwarped_parts_[i].multi_dof_joint_trajectory.points.empty() || planned.points.empty())
+    {
+      ROS_WARN_NAMED(LOGNAME, "Cannot change the speed of the executing trajectory: only single-dof trajectories can "
+                              "be time-warped");
+      return false;
+    }
+    // a trajectory about to finish completes at its current speed
+    if (warp.planned_start >= planned.points.back().time_from_start.toSec())
+      return true;
+    parts[i].joint_trajectory = warpJointTrajectory(planned, warp, splice_time);
+  }
+
+  if (!spliceParts(parts, splice_time, false))
+    return false;
+  speed_warp_ = warp;
+  ROS_INFO_NAMED(LOGNAME, "Changing the execution speed from %g to %g", warp.from, warp.to);
+  return true;
+}
+
 std::pair<int, int> TrajectoryExecutionManager::getCurrentExpectedTrajectoryIndex() const
 {
   boost::mutex::scoped_lock slock(time_index_mutex_);
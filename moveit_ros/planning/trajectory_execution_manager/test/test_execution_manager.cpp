@@ -108,6 +108,21 @@ TEST_F(MoveItCppTest, PushExecuteAndWaitTest)
   ASSERT_EQ(last_execution_status, moveit_controller_manager::ExecutionStatus::SUCCEEDED);
 }
 
+TEST_F(MoveItCppTest, PushRobotTrajectoryExecuteAndWaitTest)
+{
+  moveit::core::RobotStatePtr state = moveit_cpp_ptr->getCurrentState();
+  robot_trajectory::RobotTrajectory trajectory(moveit_cpp_ptr->getRobotModel(), "panda_arm");
+  trajectory.addSuffixWayPoint(*state, 0.0);
+  trajectory.addSuffixWayPoint(*state, 0.1);
+  ASSERT_TRUE(trajectory_execution_manager_ptr->push(trajectory));
+  ASSERT_EQ(trajectory_execution_manager_ptr->getTrajectories().size(), 1u);
+  const auto& parts = trajectory_execution_manager_ptr->getTrajectories()[0]->trajectory_parts_;
+  ASSERT_FALSE(parts.empty());
+  EXPECT_EQ(parts[0].joint_trajectory.points.size(), 2u);
+  auto last_execution_status = trajectory_execution_manager_ptr->executeAndWait();
+  ASSERT_EQ(last_execution_status, moveit_controller_manager::ExecutionStatus::SUCCEEDED);
+}
+
 }  // namespace moveit_cpp
 
 int main(int argc, char** argv)
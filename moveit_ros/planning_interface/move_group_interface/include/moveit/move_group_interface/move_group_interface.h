@@ -52,6 +52,8 @@
 #include <moveit_msgs/MoveGroupAction.h>
 #include <geometry_msgs/PoseStamped.h>
 #include <actionlib/client/simple_action_client.h>
+#include <functional>
+#include <future>
 #include <memory>
 #include <utility>
 #include <tf2_ros/buffer.h>
@@ -112,6 +114,44 @@ public:
     double planning_time_;
   };
 
+  /** \brief The result of an asynchronous planning request, see planAsync() */
+  struct PlanResult
+  {
+    /// The computed plan, valid if error_code_ is SUCCESS
+    Plan plan_;
+
+    moveit::core::MoveItErrorCode error_code_;
+  };
+
+  /** \brief The result of an asynchronous Cartesian path request, see computeCartesianPathAsync() */
+  struct CartesianPathResult
+  {
+    /// The computed trajectory, valid if error_code_ is SUCCESS
+    moveit_msgs::RobotTrajectory trajectory_;
+
+    /// The fraction of the path achieved as described by the waypoints, -1.0 in case of error
+    double fraction_ = -1.0;
+
+    moveit::core::MoveItErrorCode error_code_;
+  };
+
+  /** \brief Handle of an in-flight asynchronous request.
+      \e future_ becomes ready once the request finished, failed or was canceled. Canceled requests report
+      PREEMPTED unless the server finished them first. */
+  template <typename ResultT>
+  struct AsyncRequest
+  {
+    std::shared_future<ResultT> future_;
+
+    /// Cancel the request if it is still in flight; does nothing otherwise
+    std::function<void()> cancel_;
+  };
+
+  /// Called with the result of an asynchronous request once it completed, right before its future becomes ready
+  template <typename ResultT>
+  using AsyncCallback = std::function<void(const ResultT&)>;
+  using AsyncErrorCodeCallback = AsyncCallback<moveit::core::MoveItErrorCode>;
+
   /**
       \brief Construct a MoveGroupInterface instance call using a specified set of options \e opt.
 
@@ -762,6 +802,36 @@ public:
                               const moveit_msgs::Constraints& path_constraints, bool avoid_collisions = true,
                               moveit_msgs::MoveItErrorCodes* error_code = nullptr);
 
+  /** \brief Compute a motion plan like plan(), without blocking the caller.
+      Several planning requests can be in flight at the same time, also while a trajectory is executed. The goal and
+      all other settings are captured when this is called. \e callback, if set, is called from a ROS callback thread,
+      so an asynchronous spinner is required. */
+  AsyncRequest<PlanResult> planAsync(const AsyncCallback<PlanResult>& callback = AsyncCallback<PlanResult>());
+
+  /** \brief Plan and execute a trajectory to the current target like move(), without blocking the caller.
+      \e callback, if set, is called from a ROS callback thread. Canceling the request stops planning or execution. */
+  AsyncRequest<moveit::core::MoveItErrorCode>
+  moveAsync(const AsyncErrorCodeCallback& callback = AsyncErrorCodeCallback());
+
+  /** \brief Execute \e plan like execute(), without blocking the caller.
+      \e callback, if set, is called from a ROS callback thread. Canceling the request stops the execution. */
+  AsyncRequest<moveit::core::MoveItErrorCode>
+  executeAsync(const Plan& plan, const AsyncErrorCodeCallback& callback = AsyncErrorCodeCallback());
+
+  /** \brief Execute \e trajectory like execute(), without blocking the caller. */
+  AsyncRequest<moveit::core::MoveItErrorCode>
+  executeAsync(const moveit_msgs::RobotTrajectory& trajectory,
+               const AsyncErrorCodeCallback& callback = AsyncErrorCodeCallback());
+
+  /** \brief Compute a Cartesian path like computeCartesianPath(), without blocking the caller.
+      The service call cannot be aborted on the server side: canceling the request makes it report PREEMPTED right away
+      and discards the result when it arrives. \e callback, if set, is called from an internal thread. */
+  AsyncRequest<CartesianPathResult>
+  computeCartesianPathAsync(const std::vector<geometry_msgs::Pose>& waypoints, double eef_step, double jump_threshold,
+                            const moveit_msgs::Constraints& path_constraints = moveit_msgs::Constraints(),
+                            bool avoid_collisions = true,
+                            const AsyncCallback<CartesianPathResult>& callback = AsyncCallback<CartesianPathResult>());
+
   /** \brief Stop any trajectory execution, if one is active */
   void stop();
 
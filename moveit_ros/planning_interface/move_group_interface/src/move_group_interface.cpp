@@ -38,7 +38,10 @@
 
 #include <stdexcept>
 #include <sstream>
+#include <atomic>
 #include <memory>
+#include <mutex>
+#include <thread>
 #include <moveit/warehouse/constraints_storage.h>
 #include <moveit/kinematic_constraints/utils.h>
 #include <moveit/move_group/capability_names.h>
@@ -59,6 +62,7 @@
 #include <moveit_msgs/GraspPlanning.h>
 #include <moveit_msgs/GetPlannerParams.h>
 #include <moveit_msgs/SetPlannerParams.h>
+#include <actionlib/client/action_client.h>
 
 #include <std_msgs/String.h>
 #include <geometry_msgs/TransformStamped.h>
@@ -79,6 +83,9 @@ const std::string GRASP_PLANNING_SERVICE_NAME = "plan_grasps";  // name of the s
 
 const std::string LOGNAME = "move_group_interface";
 
+// seconds to wait for the action servers when the first asynchronous request is sent
+constexpr double ASYNC_SERVER_TIMEOUT = 5.0;
+
 namespace
 {
 enum ActiveTargetType
@@ -817,12 +824,7 @@ public:
     }
 
     moveit_msgs::MoveGroupGoal goal;
-    constructGoal(goal);
-    goal.planning_options.plan_only = true;
-    goal.planning_options.look_around = false;
-    goal.planning_options.replan = false;
-    goal.planning_options.planning_scene_diff.is_diff = true;
-    goal.planning_options.planning_scene_diff.robot_state.is_diff = true;
+    constructPlanGoal(goal);
 
     move_action_client_->sendGoal(goal);
     if (!move_action_client_->waitForResult())
@@ -858,13 +860,7 @@ public:
     }
 
     moveit_msgs::MoveGroupGoal goal;
-    constructGoal(goal);
-    goal.planning_options.plan_only = false;
-    goal.planning_options.look_around = can_look_;
-    goal.planning_options.replan = can_replan_;
-    goal.planning_options.replan_delay = replan_delay_;
-    goal.planning_options.planning_scene_diff.is_diff = true;
-    goal.planning_options.planning_scene_diff.robot_state.is_diff = true;
+    constructMoveGoal(goal);
 
     move_action_client_->sendGoal(goal);
     if (!wait)
@@ -934,7 +930,30 @@ public:
   {
     moveit_msgs::GetCartesianPath::Request req;
     moveit_msgs::GetCartesianPath::Response res;
+    constructCartesianPathRequest(waypoints, step, jump_threshold, path_constraints, avoid_collisions, req);
 
+    if (cartesian_path_service_.call(req, res))
+    {
+      error_code = res.error_code;
+      if (res.error_code.val == moveit_msgs::MoveItErrorCodes::SUCCESS)
+      {
+        msg = res.solution;
+        return res.fraction;
+      }
+      else
+        return -1.0;
+    }
+    else
+    {
+      error_code.val = error_code.FAILURE;
+      return -1.0;
+    }
+  }
+
+  void constructCartesianPathRequest(const std::vector<geometry_msgs::Pose>& waypoints, double step,
+                                     double jump_threshold, const moveit_msgs::Constraints& path_constraints,
+                                     bool avoid_collisions, moveit_msgs::GetCartesianPath::Request& req) const
+  {
     if (considered_start_state_)
       moveit::core::robotStateToRobotStateMsg(*considered_start_state_, req.start_state);
     else
@@ -951,23 +970,213 @@ public:
     req.link_name = getEndEffectorLink();
     req.cartesian_speed_limited_link = cartesian_speed_limited_link_;
     req.max_cartesian_speed = max_cartesian_speed_;
+  }
 
-    if (cartesian_path_service_.call(req, res))
+  /// State shared between an asynchronous action request and the callbacks of its goal handle
+  template <typename ActionSpec, typename ResultT>
+  struct AsyncGoal
+  {
+    actionlib::ClientGoalHandle<ActionSpec> handle;
+    std::promise<ResultT> promise;
+    std::atomic<bool> done{ false };
+    // keeps the state alive until the goal is done, even if the caller drops its AsyncRequest
+    std::shared_ptr<AsyncGoal> self;
+  };
+
+  /// Create the action client for asynchronous requests on first use. Returns nullptr if the server is unreachable.
+  template <typename ActionSpec>
+  actionlib::ActionClient<ActionSpec>* getAsyncClient(std::unique_ptr<actionlib::ActionClient<ActionSpec>>& client,
+                                                      const std::string& name)
+  {
+    std::lock_guard<std::mutex> lock(async_clients_mutex_);
+    if (!client)
+      client = std::make_unique<actionlib::ActionClient<ActionSpec>>(node_handle_, name);
+    if (!client->isServerConnected())
     {
-      error_code = res.error_code;
-      if (res.error_code.val == moveit_msgs::MoveItErrorCodes::SUCCESS)
+      try
       {
-        msg = res.solution;
-        return res.fraction;
+        waitForAction(client, name, ros::WallTime::now() + ros::WallDuration(ASYNC_SERVER_TIMEOUT),
+                      ASYNC_SERVER_TIMEOUT);
+      }
+      catch (std::runtime_error& ex)
+      {
+        ROS_WARN_STREAM_NAMED(LOGNAME, ex.what());
+        return nullptr;
       }
-      else
-        return -1.0;
     }
-    else
-    {
-      error_code.val = error_code.FAILURE;
-      return -1.0;
+    return client.get();
+  }
+
+  /// A request that already finished with \e result
+  template <typename ResultT>
+  static MoveGroupInterface::AsyncRequest<ResultT> finishedAsyncRequest(const ResultT& result)
+  {
+    std::promise<ResultT> promise;
+    promise.set_value(result);
+    return { promise.get_future().share(), []() {} };
+  }
+
+  /// Send \e goal with \e client and fulfill the request with the result of \e make_result once the goal is done
+  template <typename ActionSpec, typename ResultT>
+  static MoveGroupInterface::AsyncRequest<ResultT>
+  sendAsyncGoal(actionlib::ActionClient<ActionSpec>& client,
+                const typename actionlib::ActionClient<ActionSpec>::Goal& goal,
+                const std::function<ResultT(const actionlib::ClientGoalHandle<ActionSpec>&)>& make_result,
+                const MoveGroupInterface::AsyncCallback<ResultT>& callback)
+  {
+    auto state = std::make_shared<AsyncGoal<ActionSpec, ResultT>>();
+    state->self = state;
+    MoveGroupInterface::AsyncRequest<ResultT> request;
+    request.future_ = state->promise.get_future().share();
+
+    // The transition callback holds a weak reference only, as the goal handle stored in the state owns the callback.
+    // It may run synchronously from within cancel(), so no locks are held around the goal handle.
+    std::weak_ptr<AsyncGoal<ActionSpec, ResultT>> weak_state = state;
+    state->handle = client.sendGoal(goal, [weak_state, make_result,
+                                           callback](actionlib::ClientGoalHandle<ActionSpec> handle) {
+      if (handle.getCommState() != actionlib::CommState::DONE)
+        return;
+      std::shared_ptr<AsyncGoal<ActionSpec, ResultT>> goal_state = weak_state.lock();
+      if (!goal_state || goal_state->done.exchange(true))
+        return;
+      ResultT result = make_result(handle);
+      if (callback)
+        callback(result);
+      goal_state->promise.set_value(result);
+      goal_state->self.reset();
+    });
+    request.cancel_ = [state]() {
+      if (!state->done)
+        state->handle.cancel();
+    };
+    return request;
+  }
+
+  /// Error code of a finished action goal, PREEMPTED if it was canceled before the server sent a result
+  template <typename ActionSpec>
+  static moveit::core::MoveItErrorCode asyncErrorCode(const actionlib::ClientGoalHandle<ActionSpec>& handle)
+  {
+    const auto result = handle.getResult();
+    if (result)
+      return result->error_code;
+    const actionlib::TerminalState state = handle.getTerminalState();
+    if (state == actionlib::TerminalState::PREEMPTED || state == actionlib::TerminalState::RECALLED)
+      return moveit::core::MoveItErrorCode::PREEMPTED;
+    ROS_WARN_STREAM_NAMED(LOGNAME, "Asynchronous request finished without result: " << state.toString());
+    return moveit::core::MoveItErrorCode::FAILURE;
+  }
+
+  MoveGroupInterface::AsyncRequest<MoveGroupInterface::PlanResult>
+  planAsync(const MoveGroupInterface::AsyncCallback<MoveGroupInterface::PlanResult>& callback)
+  {
+    using GoalHandle = actionlib::ClientGoalHandle<moveit_msgs::MoveGroupAction>;
+    actionlib::ActionClient<moveit_msgs::MoveGroupAction>* client =
+        getAsyncClient(async_move_action_client_, move_group::MOVE_ACTION);
+    if (!client)
+    {
+      MoveGroupInterface::PlanResult result;
+      result.error_code_ = moveit::core::MoveItErrorCode::COMMUNICATION_FAILURE;
+      return finishedAsyncRequest(result);
     }
+
+    moveit_msgs::MoveGroupGoal goal;
+    constructPlanGoal(goal);
+    return sendAsyncGoal<moveit_msgs::MoveGroupAction, MoveGroupInterface::PlanResult>(
+        *client, goal,
+        [](const GoalHandle& handle) {
+          MoveGroupInterface::PlanResult result;
+          result.error_code_ = asyncErrorCode(handle);
+          if (result.error_code_)
+          {
+            const auto action_result = handle.getResult();
+            result.plan_.trajectory_ = action_result->planned_trajectory;
+            result.plan_.start_state_ = action_result->trajectory_start;
+            result.plan_.planning_time_ = action_result->planning_time;
+          }
+          return result;
+        },
+        callback);
+  }
+
+  MoveGroupInterface::AsyncRequest<moveit::core::MoveItErrorCode>
+  moveAsync(const MoveGroupInterface::AsyncErrorCodeCallback& callback)
+  {
+    actionlib::ActionClient<moveit_msgs::MoveGroupAction>* client =
+        getAsyncClient(async_move_action_client_, move_group::MOVE_ACTION);
+    if (!client)
+      return finishedAsyncRequest(moveit::core::MoveItErrorCode(moveit::core::MoveItErrorCode::COMMUNICATION_FAILURE));
+
+    moveit_msgs::MoveGroupGoal goal;
+    constructMoveGoal(goal);
+    return sendAsyncGoal<moveit_msgs::MoveGroupAction, moveit::core::MoveItErrorCode>(
+        *client, goal, &asyncErrorCode<moveit_msgs::MoveGroupAction>, callback);
+  }
+
+  MoveGroupInterface::AsyncRequest<moveit::core::MoveItErrorCode>
+  executeAsync(const moveit_msgs::RobotTrajectory& trajectory,
+               const MoveGroupInterface::AsyncErrorCodeCallback& callback)
+  {
+    actionlib::ActionClient<moveit_msgs::ExecuteTrajectoryAction>* client =
+        getAsyncClient(async_execute_action_client_, move_group::EXECUTE_ACTION_NAME);
+    if (!client)
+      return finishedAsyncRequest(moveit::core::MoveItErrorCode(moveit::core::MoveItErrorCode::COMMUNICATION_FAILURE));
+
+    moveit_msgs::ExecuteTrajectoryGoal goal;
+    goal.trajectory = trajectory;
+    return sendAsyncGoal<moveit_msgs::ExecuteTrajectoryAction, moveit::core::MoveItErrorCode>(
+        *client, goal, &asyncErrorCode<moveit_msgs::ExecuteTrajectoryAction>, callback);
+  }
+
+  MoveGroupInterface::AsyncRequest<MoveGroupInterface::CartesianPathResult>
+  computeCartesianPathAsync(const std::vector<geometry_msgs::Pose>& waypoints, double step, double jump_threshold,
+                            const moveit_msgs::Constraints& path_constraints, bool avoid_collisions,
+                            const MoveGroupInterface::AsyncCallback<MoveGroupInterface::CartesianPathResult>& callback)
+  {
+    using Result = MoveGroupInterface::CartesianPathResult;
+    struct State
+    {
+      std::promise<Result> promise;
+      std::atomic<bool> done{ false };
+
+      void finish(const Result& result, const MoveGroupInterface::AsyncCallback<Result>& callback)
+      {
+        if (done.exchange(true))
+          return;
+        if (callback)
+          callback(result);
+        promise.set_value(result);
+      }
+    };
+    auto state = std::make_shared<State>();
+    MoveGroupInterface::AsyncRequest<Result> request;
+    request.future_ = state->promise.get_future().share();
+    request.cancel_ = [state, callback]() {
+      Result result;
+      result.error_code_ = moveit::core::MoveItErrorCode::PREEMPTED;
+      state->finish(result, callback);
+    };
+
+    // the service call runs on copies only, so it may outlive this object
+    auto req = std::make_shared<moveit_msgs::GetCartesianPath::Request>();
+    constructCartesianPathRequest(waypoints, step, jump_threshold, path_constraints, avoid_collisions, *req);
+    ros::ServiceClient service = cartesian_path_service_;
+    std::thread([state, req, service, callback]() mutable {
+      moveit_msgs::GetCartesianPath::Response res;
+      Result result;
+      if (service.call(*req, res))
+      {
+        result.error_code_ = res.error_code;
+        if (res.error_code.val == moveit_msgs::MoveItErrorCodes::SUCCESS)
+        {
+          result.trajectory_ = std::move(res.solution);
+          result.fraction_ = res.fraction;
+        }
+      }
+      else
+        result.error_code_ = moveit::core::MoveItErrorCode::FAILURE;
+      state->finish(result, callback);
+    }).detach();
+    return request;
   }
 
   void stop()
@@ -1136,6 +1345,27 @@ public:
     constructMotionPlanRequest(goal.request);
   }
 
+  void constructPlanGoal(moveit_msgs::MoveGroupGoal& goal) const
+  {
+    constructGoal(goal);
+    goal.planning_options.plan_only = true;
+    goal.planning_options.look_around = false;
+    goal.planning_options.replan = false;
+    goal.planning_options.planning_scene_diff.is_diff = true;
+    goal.planning_options.planning_scene_diff.robot_state.is_diff = true;
+  }
+
+  void constructMoveGoal(moveit_msgs::MoveGroupGoal& goal) const
+  {
+    constructGoal(goal);
+    goal.planning_options.plan_only = false;
+    goal.planning_options.look_around = can_look_;
+    goal.planning_options.replan = can_replan_;
+    goal.planning_options.replan_delay = replan_delay_;
+    goal.planning_options.planning_scene_diff.is_diff = true;
+    goal.planning_options.planning_scene_diff.robot_state.is_diff = true;
+  }
+
   moveit_msgs::PickupGoal constructPickupGoal(const std::string& object, std::vector<moveit_msgs::Grasp>&& grasps,
                                               bool plan_only = false) const
   {
@@ -1308,6 +1538,10 @@ private:
   std::unique_ptr<actionlib::SimpleActionClient<moveit_msgs::ExecuteTrajectoryAction>> execute_action_client_;
   std::unique_ptr<actionlib::SimpleActionClient<moveit_msgs::PickupAction>> pick_action_client_;
   std::unique_ptr<actionlib::SimpleActionClient<moveit_msgs::PlaceAction>> place_action_client_;
+  // clients for asynchronous requests, which support several goals in flight; created on first use
+  std::unique_ptr<actionlib::ActionClient<moveit_msgs::MoveGroupAction>> async_move_action_client_;
+  std::unique_ptr<actionlib::ActionClient<moveit_msgs::ExecuteTrajectoryAction>> async_execute_action_client_;
+  std::mutex async_clients_mutex_;
 
   // general planning params
   moveit::core::RobotStatePtr considered_start_state_;
@@ -1608,6 +1842,39 @@ double MoveGroupInterface::computeCartesianPath(const std::vector<geometry_msgs:
                                      avoid_collisions, err);
 }
 
+MoveGroupInterface::AsyncRequest<MoveGroupInterface::PlanResult>
+MoveGroupInterface::planAsync(const AsyncCallback<PlanResult>& callback)
+{
+  return impl_->planAsync(callback);
+}
+
+MoveGroupInterface::AsyncRequest<moveit::core::MoveItErrorCode>
+MoveGroupInterface::moveAsync(const AsyncErrorCodeCallback& callback)
+{
+  return impl_->moveAsync(callback);
+}
+
+MoveGroupInterface::AsyncRequest<moveit::core::MoveItErrorCode>
+MoveGroupInterface::executeAsync(const Plan& plan, const AsyncErrorCodeCallback& callback)
+{
+  return impl_->executeAsync(plan.trajectory_, callback);
+}
+
+MoveGroupInterface::AsyncRequest<moveit::core::MoveItErrorCode>
+MoveGroupInterface::executeAsync(const moveit_msgs::RobotTrajectory& trajectory, const AsyncErrorCodeCallback& callback)
+{
+  return impl_->executeAsync(trajectory, callback);
+}
+
+MoveGroupInterface::AsyncRequest<MoveGroupInterface::CartesianPathResult>
+MoveGroupInterface::computeCartesianPathAsync(const std::vector<geometry_msgs::Pose>& waypoints, double eef_step,
+                                              double jump_threshold, const moveit_msgs::Constraints& path_constraints,
+                                              bool avoid_collisions, const AsyncCallback<CartesianPathResult>& callback)
+{
+  return impl_->computeCartesianPathAsync(waypoints, eef_step, jump_threshold, path_constraints, avoid_collisions,
+                                          callback);
+}
+
 void MoveGroupInterface::stop()
 {
   impl_->stop();
@@ -481,6 +481,123 @@ public:
                           plan.planning_time_);
   }
 
+  /** Split \e trajectory into (joint names, times from start, positions, velocities, accelerations), with one row per
+      waypoint. eigenpy hands the matrices to Python as numpy arrays, so no Python object is created per value.
+      Velocities and accelerations are empty if not all waypoints specify them. */
+  template <typename Scalar>
+  static bp::tuple trajectoryToArrays(const trajectory_msgs::JointTrajectory& trajectory)
+  {
+    using Matrix = Eigen::Matrix<Scalar, Eigen::Dynamic, Eigen::Dynamic>;
+    const std::size_t points = trajectory.points.size();
+    const std::size_t joints = trajectory.joint_names.size();
+    bool has_velocities = points > 0;
+    bool has_accelerations = points > 0;
+    for (const trajectory_msgs::JointTrajectoryPoint& point : trajectory.points)
+    {
+      has_velocities &= point.velocities.size() == joints;
+      has_accelerations &= point.accelerations.size() == joints;
+    }
+
+    Eigen::Matrix<Scalar, Eigen::Dynamic, 1> times(points);
+    Matrix positions(points, joints);
+    Matrix velocities(has_velocities ? points : 0, joints);
+    Matrix accelerations(has_accelerations ? points : 0, joints);
+    for (std::size_t i = 0; i < points; ++i)
+    {
+      const trajectory_msgs::JointTrajectoryPoint& point = trajectory.points[i];
+      times[i] = point.time_from_start.toSec();
+      for (std::size_t j = 0; j < joints; ++j)
+      {
+        positions(i, j) = point.positions[j];
+        if (has_velocities)
+          velocities(i, j) = point.velocities[j];
+        if (has_accelerations)
+          accelerations(i, j) = point.accelerations[j];
+      }
+    }
+    return bp::make_tuple(py_bindings_tools::listFromString(trajectory.joint_names), times, positions, velocities,
+                          accelerations);
+  }
+
+  static bp::tuple trajectoryToArrays(const trajectory_msgs::JointTrajectory& trajectory, bool single_precision)
+  {
+    return single_precision ? trajectoryToArrays<float>(trajectory) : trajectoryToArrays<double>(trajectory);
+  }
+
+  bp::tuple planArraysPython(bool single_precision)
+  {
+    MoveGroupInterface::Plan plan;
+    moveit_msgs::MoveItErrorCodes res;
+    {
+      GILReleaser gr;
+      res = MoveGroupInterface::plan(plan);
+    }
+    return bp::make_tuple(py_bindings_tools::serializeMsg(res),
+                          trajectoryToArrays(plan.trajectory_.joint_trajectory, single_precision), plan.planning_time_);
+  }
+
+  bp::tuple computeCartesianPathArraysPython(const bp::list& waypoints, double eef_step, double jump_threshold,
+                                             bool avoid_collisions, bool single_precision)
+  {
+    std::vector<geometry_msgs::Pose> poses;
+    convertListToArrayOfPoses(waypoints, poses);
+    moveit_msgs::RobotTrajectory trajectory;
+    double fraction;
+    {
+      GILReleaser gr;
+      fraction = computeCartesianPath(poses, eef_step, jump_threshold, trajectory, moveit_msgs::Constraints(),
+                                      avoid_collisions);
+    }
+    return bp::make_tuple(trajectoryToArrays(trajectory.joint_trajectory, single_precision), fraction);
+  }
+
+  /** Execute the trajectory given as arrays like returned by planArraysPython(), without going through a serialized
+      message. \e velocities and \e accelerations may be empty. */
+  bool executeArraysPython(const bp::list& joint_names, const Eigen::VectorXd& times, const Eigen::MatrixXd& positions,
+                           const Eigen::MatrixXd& velocities, const Eigen::MatrixXd& accelerations, bool wait)
+  {
+    moveit_msgs::RobotTrajectory trajectory;
+    trajectory_msgs::JointTrajectory& joint_trajectory = trajectory.joint_trajectory;
+    joint_trajectory.joint_names = py_bindings_tools::stringFromList(joint_names);
+    const std::size_t joints = joint_trajectory.joint_names.size();
+    const std::size_t points = times.size();
+    if (static_cast<std::size_t>(positions.rows()) != points || static_cast<std::size_t>(positions.cols()) != joints ||
+        (velocities.size() > 0 && (velocities.rows() != positions.rows() || velocities.cols() != positions.cols())) ||
+        (accelerations.size() > 0 &&
+         (accelerations.rows() != positions.rows() || accelerations.cols() != positions.cols())))
+    {
+      ROS_ERROR_NAMED("move_group_py", "Trajectory arrays do not match %zu waypoints of %zu joints", points, joints);
+      return false;
+    }
+
+    joint_trajectory.points.resize(points);
+    for (std::size_t i = 0; i < points; ++i)
+    {
+      trajectory_msgs::JointTrajectoryPoint& point = joint_trajectory.points[i];
+      point.time_from_start = ros::Duration(times[i]);
+      point.positions.resize(joints);
+      for (std::size_t j = 0; j < joints; ++j)
+        point.positions[j] = positions(i, j);
+      if (velocities.size() > 0)
+      {
+        point.velocities.resize(joints);
+        for (std::size_t j = 0; j < joints; ++j)
+          point.velocities[j] = velocities(i, j);
+      }
+      if (accelerations.size() > 0)
+      {
+        point.accelerations.resize(joints);
+        for (std::size_t j = 0; j < joints; ++j)
+          point.accelerations[j] = accelerations(i, j);
+      }
+    }
+
+    if (!wait)
+      return asyncExecute(trajectory) == moveit::core::MoveItErrorCode::SUCCESS;
+    GILReleaser gr;
+    return execute(trajectory) == moveit::core::MoveItErrorCode::SUCCESS;
+  }
+
   py_bindings_tools::ByteString constructMotionPlanRequestPython()
   {
     moveit_msgs::MotionPlanRequest request;
@@ -795,11 +912,15 @@ static void wrap_move_group_interface()
   move_group_interface_class.def("get_planning_pipeline_id", &MoveGroupInterfaceWrapper::getPlanningPipelineIdCStr);
   move_group_interface_class.def("set_num_planning_attempts", &MoveGroupInterfaceWrapper::setNumPlanningAttempts);
   move_group_interface_class.def("plan", &MoveGroupInterfaceWrapper::planPython);
+  move_group_interface_class.def("plan_arrays", &MoveGroupInterfaceWrapper::planArraysPython);
   move_group_interface_class.def("construct_motion_plan_request",
                                  &MoveGroupInterfaceWrapper::constructMotionPlanRequestPython);
   move_group_interface_class.def("compute_cartesian_path", &MoveGroupInterfaceWrapper::computeCartesianPathPython);
   move_group_interface_class.def("compute_cartesian_path",
                                  &MoveGroupInterfaceWrapper::computeCartesianPathConstrainedPython);
+  move_group_interface_class.def("compute_cartesian_path_arrays",
+                                 &MoveGroupInterfaceWrapper::computeCartesianPathArraysPython);
+  move_group_interface_class.def("execute_arrays", &MoveGroupInterfaceWrapper::executeArraysPython);
   move_group_interface_class.def("set_support_surface_name", &MoveGroupInterfaceWrapper::setSupportSurfaceName);
   move_group_interface_class.def("attach_object", &MoveGroupInterfaceWrapper::attachObjectPython);
   move_group_interface_class.def("detach_object", &MoveGroupInterfaceWrapper::detachObject);
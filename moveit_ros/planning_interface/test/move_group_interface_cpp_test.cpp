@@ -40,6 +40,7 @@
  */
 
 // C++
+#include <atomic>
 #include <string>
 #include <vector>
 #include <map>
@@ -345,6 +346,35 @@ TEST_F(MoveGroupTestFixture, JointSpaceGoalTest)
   testJointPositions(plan_joint_positions);
 }
 
+TEST_F(MoveGroupTestFixture, AsyncPlanAndExecuteTest)
+{
+  SCOPED_TRACE("AsyncPlanAndExecuteTest");
+
+  std::vector<double> plan_joint_positions = { 0.2, -0.5, 0.1, -2.0, 0.0, 1.5, 0.8 };
+  move_group_->setJointValueTarget(plan_joint_positions);
+
+  // plan without blocking, the callback runs before the future becomes ready
+  std::atomic<bool> callback_called{ false };
+  auto plan_request = move_group_->planAsync(
+      [&callback_called](const moveit::planning_interface::MoveGroupInterface::PlanResult& /*result*/) {
+        callback_called = true;
+      });
+  ASSERT_EQ(plan_request.future_.wait_for(std::chrono::seconds(10)), std::future_status::ready);
+  const auto& plan_result = plan_request.future_.get();
+  ASSERT_EQ(plan_result.error_code_, moveit::core::MoveItErrorCode::SUCCESS);
+  EXPECT_TRUE(callback_called);
+
+  // canceling a finished request has no effect
+  plan_request.cancel_();
+  EXPECT_EQ(plan_request.future_.get().error_code_, moveit::core::MoveItErrorCode::SUCCESS);
+
+  auto execute_request = move_group_->executeAsync(plan_result.plan_);
+  ASSERT_EQ(execute_request.future_.wait_for(std::chrono::seconds(30)), std::future_status::ready);
+  ASSERT_EQ(execute_request.future_.get(), moveit::core::MoveItErrorCode::SUCCESS);
+
+  testJointPositions(plan_joint_positions);
+}
+
 int main(int argc, char** argv)
 {
   ros::init(argc, argv, "move_group_interface_cpp_test");
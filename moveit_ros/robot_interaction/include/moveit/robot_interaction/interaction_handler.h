@@ -235,10 +235,11 @@ private:
                           const visualization_msgs::InteractiveMarkerFeedbackConstPtr& feedback,
                           StateChangeCallbackFn& callback);
 
-  // Update RobotState for a new pose of an eef.
+  // Update RobotState with the IK \e solution computed for a new pose of an eef.
+  // \e ok tells whether IK succeeded.
   // YOU MUST LOCK state_lock_ BEFORE CALLING THIS.
   void updateStateEndEffector(moveit::core::RobotState& state, const EndEffectorInteraction& eef,
-                              const geometry_msgs::Pose& pose, StateChangeCallbackFn& callback);
+                              const moveit::core::RobotState& solution, bool ok, StateChangeCallbackFn& callback);
 
   // Update RobotState for a new joint position.
   // YOU MUST LOCK state_lock_ BEFORE CALLING THIS.
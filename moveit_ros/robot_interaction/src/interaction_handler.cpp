@@ -235,12 +235,19 @@ void InteractionHandler::handleEndEffector(const EndEffectorInteraction& eef,
   else
     return;
 
+  // Solve IK on a copy of the current state without holding state_lock_, so readers of the state (e.g. rendering)
+  // are not blocked by the solver. The copy seeds the solver with the previous solution.
+  // The kinematic options map does its own locking.
+  moveit::core::RobotState solution(*getState());
+  KinematicOptions kinematic_options = kinematic_options_map_->getOptions(eef.parent_group);
+  bool ok = kinematic_options.setStateFromIK(solution, eef.parent_group, eef.parent_link, tpose.pose);
+
   StateChangeCallbackFn callback;
 
-  // modify the RobotState in-place with state_lock_ held.
+  // copy the solution into the RobotState with state_lock_ held.
   // This locks state_lock_ before calling updateState()
-  LockedRobotState::modifyState([this, &eef, &pose = tpose.pose, &callback](moveit::core::RobotState* state) {
-    updateStateEndEffector(*state, eef, pose, callback);
+  LockedRobotState::modifyState([this, &eef, &solution, ok, &callback](moveit::core::RobotState* state) {
+    updateStateEndEffector(*state, eef, solution, ok, callback);
   });
 
   // This calls update_callback_ to notify client that state changed.
@@ -295,13 +302,19 @@ void InteractionHandler::updateStateGeneric(moveit::core::RobotState& state, con
 
 // MUST hold state_lock_ when calling this!
 void InteractionHandler::updateStateEndEffector(moveit::core::RobotState& state, const EndEffectorInteraction& eef,
-                                                const geometry_msgs::Pose& pose, StateChangeCallbackFn& callback)
+                                                const moveit::core::RobotState& solution, bool ok,
+                                                StateChangeCallbackFn& callback)
 {
-  // This is called with state_lock_ held, so no additional locking needed to
-  // access kinematic_options_map_.
-  KinematicOptions kinematic_options = kinematic_options_map_->getOptions(eef.parent_group);
+  // Only take over the joints of the IK group, so changes made to the other
+  // joints while the solver was running are kept.
+  if (const moveit::core::JointModelGroup* jmg = solution.getJointModelGroup(eef.parent_group))
+  {
+    std::vector<double> values;
+    solution.copyJointGroupPositions(jmg, values);
+    state.setJointGroupPositions(jmg, values);
+    state.update();
+  }
 
-  bool ok = kinematic_options.setStateFromIK(state, eef.parent_group, eef.parent_link, pose);
   bool error_state_changed = setErrorState(eef.parent_group, !ok);
   if (update_callback_)
     callback = [cb = this->update_callback_, error_state_changed](robot_interaction::InteractionHandler* handler) {
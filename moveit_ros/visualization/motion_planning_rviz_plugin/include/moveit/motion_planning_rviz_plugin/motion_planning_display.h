@@ -196,6 +196,13 @@ protected:
     OUTSIDE_BOUNDS_LINK
   };
 
+  /// Links to highlight in a query state, with the status text describing them
+  struct QueryStateStatus
+  {
+    std::map<std::string, LinkDisplayStatus> links;
+    std::vector<std::string> text;
+  };
+
   void clearRobotModel() override;
   void onRobotModelLoaded() override;
   void onNewPlanningSceneState() override;
@@ -216,6 +223,10 @@ protected:
   void recomputeQueryGoalStateMetrics();
   void drawQueryStartState();
   void drawQueryGoalState();
+  /** \brief Check \e state for collisions and for joints of \e group outside bounds (run in the background) */
+  void computeQueryStateStatus(bool start, const moveit::core::RobotStateConstPtr& state, const std::string& group);
+  /** \brief Color the links and show the status text found by computeQueryStateStatus() (run in the main loop) */
+  void applyQueryStateStatus(bool start, const QueryStateStatus& status);
   void scheduleDrawQueryStartState(robot_interaction::InteractionHandler* handler, bool error_state_changed);
   void scheduleDrawQueryGoalState(robot_interaction::InteractionHandler* handler, bool error_state_changed);
 
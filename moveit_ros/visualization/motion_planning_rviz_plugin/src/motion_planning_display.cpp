@@ -624,45 +624,11 @@ void MotionPlanningDisplay::drawQueryStartState()
       query_robot_start_->update(state);
       query_robot_start_->setVisible(true);
 
-      // update link colors
-      std::vector<std::string> collision_links;
-      getPlanningSceneRO()->getCollidingLinks(collision_links, *state);
-      status_links_start_.clear();
-      for (const std::string& collision_link : collision_links)
-        status_links_start_[collision_link] = COLLISION_LINK;
-      if (!collision_links.empty())
-      {
-        collision_detection::CollisionResult::ContactMap pairs;
-        getPlanningSceneRO()->getCollidingPairs(pairs, *state);
-        setStatusTextColor(query_start_color_property_->getColor());
-        addStatusText("Start state colliding links:");
-        for (collision_detection::CollisionResult::ContactMap::const_iterator it = pairs.begin(); it != pairs.end();
-             ++it)
-          addStatusText(it->first.first + " - " + it->first.second);
-        addStatusText(".");
-      }
-      if (!getCurrentPlanningGroup().empty())
-      {
-        const moveit::core::JointModelGroup* jmg = state->getJointModelGroup(getCurrentPlanningGroup());
-        if (jmg)
-        {
-          std::vector<std::string> outside_bounds;
-          const std::vector<const moveit::core::JointModel*>& jmodels = jmg->getActiveJointModels();
-          for (const moveit::core::JointModel* jmodel : jmodels)
-            if (!state->satisfiesBounds(jmodel, jmodel->getMaximumExtent() * 1e-2))
-            {
-              outside_bounds.push_back(jmodel->getChildLinkModel()->getName());
-              status_links_start_[outside_bounds.back()] = OUTSIDE_BOUNDS_LINK;
-            }
-          if (!outside_bounds.empty())
-          {
-            setStatusTextColor(query_start_color_property_->getColor());
-            addStatusText("Links descending from joints that are outside bounds in start state:");
-            addStatusText(outside_bounds);
-          }
-        }
-      }
-      updateLinkColors();
+      // check collisions and bounds in the background; a newer state replaces a pending check
+      addBackgroundJob(
+          [this, state, group = getCurrentPlanningGroup()] { computeQueryStateStatus(true, state, group); },
+          "checkQueryStartState", 0, "checkQueryStartState");
+
       // update metrics text
       displayMetrics(true);
     }
@@ -743,47 +709,10 @@ void MotionPlanningDisplay::drawQueryGoalState()
       query_robot_goal_->update(state);
       query_robot_goal_->setVisible(true);
 
-      // update link colors
-      std::vector<std::string> collision_links;
-      getPlanningSceneRO()->getCollidingLinks(collision_links, *state);
-      status_links_goal_.clear();
-      for (const std::string& collision_link : collision_links)
-        status_links_goal_[collision_link] = COLLISION_LINK;
-      if (!collision_links.empty())
-      {
-        collision_detection::CollisionResult::ContactMap pairs;
-        getPlanningSceneRO()->getCollidingPairs(pairs, *state);
-        setStatusTextColor(query_goal_color_property_->getColor());
-        addStatusText("Goal state colliding links:");
-        for (collision_detection::CollisionResult::ContactMap::const_iterator it = pairs.begin(); it != pairs.end();
-             ++it)
-          addStatusText(it->first.first + " - " + it->first.second);
-        addStatusText(".");
-      }
-
-      if (!getCurrentPlanningGroup().empty())
-      {
-        const moveit::core::JointModelGroup* jmg = state->getJointModelGroup(getCurrentPlanningGroup());
-        if (jmg)
-        {
-          const std::vector<const moveit::core::JointModel*>& jmodels = jmg->getActiveJointModels();
-          std::vector<std::string> outside_bounds;
-          for (const moveit::core::JointModel* jmodel : jmodels)
-            if (!state->satisfiesBounds(jmodel, jmodel->getMaximumExtent() * 1e-2))
-            {
-              outside_bounds.push_back(jmodel->getChildLinkModel()->getName());
-              status_links_goal_[outside_bounds.back()] = OUTSIDE_BOUNDS_LINK;
-            }
-
-          if (!outside_bounds.empty())
-          {
-            setStatusTextColor(query_goal_color_property_->getColor());
-            addStatusText("Links descending from joints that are outside bounds in goal state:");
-            addStatusText(outside_bounds);
-          }
-        }
-      }
-      updateLinkColors();
+      // check collisions and bounds in the background; a newer state replaces a pending check
+      addBackgroundJob(
+          [this, state, group = getCurrentPlanningGroup()] { computeQueryStateStatus(false, state, group); },
+          "checkQueryGoalState", 0, "checkQueryGoalState");
 
       // update metrics text
       displayMetrics(false);
@@ -794,6 +723,67 @@ void MotionPlanningDisplay::drawQueryGoalState()
   context_->queueRender();
 }
 
+void MotionPlanningDisplay::computeQueryStateStatus(bool start, const moveit::core::RobotStateConstPtr& state,
+                                                    const std::string& group)
+{
+  if (!planning_scene_monitor_)
+    return;
+
+  QueryStateStatus status;
+
+  std::vector<std::string> collision_links;
+  collision_detection::CollisionResult::ContactMap pairs;
+  {
+    planning_scene_monitor::LockedPlanningSceneRO ps = getPlanningSceneRO();
+    ps->getCollidingLinks(collision_links, *state);
+    if (!collision_links.empty())
+      ps->getCollidingPairs(pairs, *state);
+  }
+  for (const std::string& collision_link : collision_links)
+    status.links[collision_link] = COLLISION_LINK;
+  if (!collision_links.empty())
+  {
+    status.text.push_back(start ? "Start state colliding links:" : "Goal state colliding links:");
+    for (const auto& pair : pairs)
+      status.text.push_back(pair.first.first + " - " + pair.first.second);
+    status.text.push_back(".");
+  }
+
+  if (const moveit::core::JointModelGroup* jmg = group.empty() ? nullptr : state->getJointModelGroup(group))
+  {
+    std::vector<std::string> outside_bounds;
+    for (const moveit::core::JointModel* jmodel : jmg->getActiveJointModels())
+      if (!state->satisfiesBounds(jmodel, jmodel->getMaximumExtent() * 1e-2))
+      {
+        outside_bounds.push_back(jmodel->getChildLinkModel()->getName());
+        status.links[outside_bounds.back()] = OUTSIDE_BOUNDS_LINK;
+      }
+    if (!outside_bounds.empty())
+    {
+      status.text.push_back(std::string("Links descending from joints that are outside bounds in ") +
+                            (start ? "start" : "goal") + " state:");
+      status.text.insert(status.text.end(), outside_bounds.begin(), outside_bounds.end());
+    }
+  }
+
+  // a check for a newer state was queued meanwhile, which will show its own result
+  if (moveit::tools::BackgroundProcessing::isCancelled())
+    return;
+  addMainLoopJob([this, start, status] { applyQueryStateStatus(start, status); });
+}
+
+void MotionPlanningDisplay::applyQueryStateStatus(bool start, const QueryStateStatus& status)
+{
+  (start ? status_links_start_ : status_links_goal_) = status.links;
+  if (!status.text.empty())
+  {
+    setStatusTextColor(start ? query_start_color_property_->getColor() : query_goal_color_property_->getColor());
+    addStatusText(status.text);
+  }
+  updateLinkColors();
+  context_->queueRender();
+}
+
 void MotionPlanningDisplay::resetInteractiveMarkers()
 {
   query_start_state_->clearError();
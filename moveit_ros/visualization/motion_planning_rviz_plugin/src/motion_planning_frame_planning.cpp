@@ -75,7 +75,8 @@ void MotionPlanningFrame::planAndExecuteButtonClicked()
 void MotionPlanningFrame::stopButtonClicked()
 {
   ui_->stop_button->setEnabled(false);  // avoid clicking again
-  planning_display_->addBackgroundJob([this] { computeStopButtonClicked(); }, "stop");
+  // stopping must not wait for a plan that is being computed
+  planning_display_->addBackgroundJob([this] { computeStopButtonClicked(); }, "stop", 1, "stop");
 }
 
 void MotionPlanningFrame::allowReplanningToggled(bool checked)
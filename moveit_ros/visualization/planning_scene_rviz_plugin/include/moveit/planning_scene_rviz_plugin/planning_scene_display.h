@@ -43,6 +43,7 @@
 #include <moveit/planning_scene_monitor/planning_scene_monitor.h>
 #include <moveit/background_processing/background_processing.h>
 #include <ros/ros.h>
+#include <atomic>
 #endif
 
 namespace Ogre
@@ -87,6 +88,12 @@ public:
       All jobs are queued and processed in order by a single background thread. */
   void addBackgroundJob(const boost::function<void()>& job, const std::string& name);
 
+  /** Queue this function call for execution by the background threads, with a \e priority (higher runs first)
+      and a \e key. Jobs with the same key run one at a time, and a new job replaces the queued jobs of its key.
+      Keyed jobs may run next to the jobs added without key, so they must not rely on being serialized with them. */
+  void addBackgroundJob(const boost::function<void()>& job, const std::string& name, int priority,
+                        const std::string& key);
+
   /** Directly spawn a (detached) background thread for execution of this function call
       Should be used, when order of processing is not relevant / job can run in parallel.
       Must be used, when job will be blocking. Using addBackgroundJob() in this case will block other queued jobs as
@@ -161,6 +168,10 @@ protected:
   void executeMainLoopJobs();
   void sceneMonitorReceivedUpdate(planning_scene_monitor::PlanningSceneMonitor::SceneUpdateType update_type);
   void renderPlanningScene();
+  /// render a scene captured by PlanningSceneRender::captureSnapshot() with the current display settings
+  void renderSceneSnapshot(const PlanningSceneRender::SceneSnapshot& snapshot);
+  /// capture the scene of \e monitor for rendering; runs as a background job
+  void captureSceneSnapshot(const planning_scene_monitor::PlanningSceneMonitorPtr& monitor);
   void setLinkColor(rviz::Robot* robot, const std::string& link_name, const QColor& color);
   void unsetLinkColor(rviz::Robot* robot, const std::string& link_name);
   void setGroupColor(rviz::Robot* robot, const std::string& group_name, const QColor& color);
@@ -197,6 +208,14 @@ protected:
   bool robot_state_needs_render_;
   float current_scene_time_;
 
+  // Updates from the scene monitor are captured in the background, at most once per scene display time, so the
+  // render thread neither locks nor iterates the scene for them
+  std::atomic<bool> scene_update_pending_;
+  std::atomic<bool> scene_capture_queued_;
+  // latest capture that was not rendered yet
+  PlanningSceneRender::SceneSnapshotConstPtr pending_snapshot_;
+  boost::mutex pending_snapshot_lock_;
+
   rviz::Property* scene_category_;
   rviz::Property* robot_category_;
 
@@ -66,7 +66,14 @@ namespace moveit_rviz_plugin
 // Base class contructor
 // ******************************************************************************************
 PlanningSceneDisplay::PlanningSceneDisplay(bool listen_to_planning_scene, bool show_scene_robot)
-  : Display(), planning_scene_needs_render_(true), current_scene_time_(0.0f)
+  : Display()
+  // a second thread runs keyed jobs while a slow job holds the first one
+  , background_process_(2)
+  , planning_scene_needs_render_(true)
+  , robot_state_needs_render_(false)
+  , current_scene_time_(0.0f)
+  , scene_update_pending_(false)
+  , scene_capture_queued_(false)
 {
   move_group_ns_property_ = new rviz::StringProperty("Move Group Namespace", "",
                                                      "The name of the ROS namespace in "
@@ -177,6 +184,8 @@ PlanningSceneDisplay::~PlanningSceneDisplay()
 void PlanningSceneDisplay::clearJobs()
 {
   background_process_.clear();
+  // a removed capture would otherwise keep new ones from being queued
+  scene_capture_queued_ = false;
   {
     boost::unique_lock<boost::mutex> ulock(main_loop_jobs_lock_);
     main_loop_jobs_.clear();
@@ -224,6 +233,12 @@ void PlanningSceneDisplay::addBackgroundJob(const boost::function<void()>& job,
   background_process_.addJob(job, name);
 }
 
+void PlanningSceneDisplay::addBackgroundJob(const boost::function<void()>& job, const std::string& name,
+                                            int priority, const std::string& key)
+{
+  background_process_.addJob(job, name, priority, key);
+}
+
 void PlanningSceneDisplay::spawnBackgroundJob(const boost::function<void()>& job)
 {
   boost::thread t(job);
@@ -332,6 +347,29 @@ void PlanningSceneDisplay::changedSceneName()
 }
 
 void PlanningSceneDisplay::renderPlanningScene()
+{
+  try
+  {
+    if (planning_scene_needs_render_)
+    {
+      PlanningSceneRender::SceneSnapshotPtr snapshot;
+      {
+        const planning_scene_monitor::LockedPlanningSceneRO& ps = getPlanningSceneRO();
+        snapshot = PlanningSceneRender::captureSnapshot(ps);
+      }
+      renderSceneSnapshot(*snapshot);
+      return;
+    }
+    planning_scene_render_->updateRobotPosition(getPlanningSceneRO());
+  }
+  catch (std::exception& ex)
+  {
+    ROS_ERROR("Caught %s while rendering planning scene", ex.what());
+  }
+  planning_scene_render_->getGeometryNode()->setVisible(scene_enabled_property_->getBool());
+}
+
+void PlanningSceneDisplay::renderSceneSnapshot(const PlanningSceneRender::SceneSnapshot& snapshot)
 {
   QColor color = scene_color_property_->getColor();
   rviz::Color env_color(color.redF(), color.greenF(), color.blueF());
@@ -341,18 +379,10 @@ void PlanningSceneDisplay::renderPlanningScene()
 
   try
   {
-    const planning_scene_monitor::LockedPlanningSceneRO& ps = getPlanningSceneRO();
-    if (planning_scene_needs_render_)
-    {
-      planning_scene_render_->renderPlanningScene(
-          ps, env_color, attached_color, static_cast<OctreeVoxelRenderMode>(octree_render_property_->getOptionInt()),
-          static_cast<OctreeVoxelColorMode>(octree_coloring_property_->getOptionInt()),
-          scene_alpha_property_->getFloat());
-    }
-    else
-    {
-      planning_scene_render_->updateRobotPosition(ps);
-    }
+    planning_scene_render_->renderSnapshot(snapshot, env_color, attached_color,
+                                           static_cast<OctreeVoxelRenderMode>(octree_render_property_->getOptionInt()),
+                                           static_cast<OctreeVoxelColorMode>(octree_coloring_property_->getOptionInt()),
+                                           scene_alpha_property_->getFloat());
   }
   catch (std::exception& ex)
   {
@@ -361,6 +391,27 @@ void PlanningSceneDisplay::renderPlanningScene()
   planning_scene_render_->getGeometryNode()->setVisible(scene_enabled_property_->getBool());
 }
 
+void PlanningSceneDisplay::captureSceneSnapshot(const planning_scene_monitor::PlanningSceneMonitorPtr& monitor)
+{
+  PlanningSceneRender::SceneSnapshotPtr snapshot;
+  try
+  {
+    planning_scene_monitor::LockedPlanningSceneRO ps(monitor);
+    snapshot = PlanningSceneRender::captureSnapshot(ps);
+  }
+  catch (std::exception& ex)
+  {
+    ROS_ERROR("Caught %s while capturing planning scene", ex.what());
+  }
+  if (snapshot)
+  {
+    // a newer capture replaces one the render thread did not get to yet
+    boost::mutex::scoped_lock lock(pending_snapshot_lock_);
+    pending_snapshot_ = snapshot;
+  }
+  scene_capture_queued_ = false;
+}
+
 void PlanningSceneDisplay::changedSceneAlpha()
 {
   queueRenderSceneGeometry();
@@ -588,7 +639,7 @@ void PlanningSceneDisplay::onSceneMonitorReceivedUpdate(
   getPlanningSceneRW()->getCurrentStateNonConst().update();
   QMetaObject::invokeMethod(this, "setSceneName", Qt::QueuedConnection,
                             Q_ARG(QString, QString::fromStdString(getPlanningSceneRO()->getName())));
-  planning_scene_needs_render_ = true;
+  scene_update_pending_ = true;
 }
 
 void PlanningSceneDisplay::setSceneName(const QString& name)
@@ -651,15 +702,45 @@ void PlanningSceneDisplay::update(float wall_dt, float ros_dt)
 void PlanningSceneDisplay::updateInternal(float wall_dt, float /*ros_dt*/)
 {
   current_scene_time_ += wall_dt;
-  if (planning_scene_render_ &&
-      ((current_scene_time_ > scene_display_time_property_->getFloat() && robot_state_needs_render_) ||
-       planning_scene_needs_render_))
+  if (!planning_scene_render_)
+    return;
+
+  if ((current_scene_time_ > scene_display_time_property_->getFloat() && robot_state_needs_render_) ||
+      planning_scene_needs_render_)
   {
+    if (planning_scene_needs_render_)
+    {
+      // the scene is rendered as it is now, an older capture must not replace it
+      boost::mutex::scoped_lock lock(pending_snapshot_lock_);
+      pending_snapshot_.reset();
+    }
     renderPlanningScene();
     current_scene_time_ = 0.0f;
     robot_state_needs_render_ = false;
     planning_scene_needs_render_ = false;
+    return;
+  }
+
+  if (scene_update_pending_ && !scene_capture_queued_ &&
+      current_scene_time_ > scene_display_time_property_->getFloat())
+  {
+    scene_update_pending_ = false;
+    scene_capture_queued_ = true;
+    current_scene_time_ = 0.0f;
+    planning_scene_monitor::PlanningSceneMonitorPtr monitor = planning_scene_monitor_;
+    // only reads the scene under its lock, so it need not wait for slow jobs
+    addBackgroundJob([this, monitor] { captureSceneSnapshot(monitor); }, "captureSceneSnapshot", 0,
+                     "captureSceneSnapshot");
+  }
+
+  PlanningSceneRender::SceneSnapshotConstPtr snapshot;
+  {
+    boost::mutex::scoped_lock lock(pending_snapshot_lock_);
+    snapshot.swap(pending_snapshot_);
   }
+  // captures of a scene monitor that was replaced in between do not fit the robot that is rendered now
+  if (snapshot && snapshot->robot_state->getRobotModel() == getRobotModel())
+    renderSceneSnapshot(*snapshot);
 }
 
 void PlanningSceneDisplay::load(const rviz::Config& config)
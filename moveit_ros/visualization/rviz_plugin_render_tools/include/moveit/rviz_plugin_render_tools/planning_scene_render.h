@@ -61,6 +61,28 @@ MOVEIT_CLASS_FORWARD(PlanningSceneRender);      // Defines PlanningSceneRenderPt
 class PlanningSceneRender
 {
 public:
+  /** \brief What is needed to render a planning scene. It can be captured in a background thread, so that the render
+      thread neither locks the scene nor iterates it. */
+  struct SceneSnapshot
+  {
+    struct Object
+    {
+      std::string id;
+      std::vector<shapes::ShapeConstPtr> shapes;
+      EigenSTL::vector_Isometry3d shape_poses;
+      Eigen::Isometry3d pose;
+    };
+
+    std::vector<Object, Eigen::aligned_allocator<Object> > objects;
+    moveit::core::RobotStatePtr robot_state;
+    planning_scene::ObjectColorMap object_colors;
+  };
+  using SceneSnapshotPtr = std::shared_ptr<SceneSnapshot>;
+  using SceneSnapshotConstPtr = std::shared_ptr<const SceneSnapshot>;
+
+  /** \brief Capture the world objects, current state and object colors of \e scene */
+  static SceneSnapshotPtr captureSnapshot(const planning_scene::PlanningSceneConstPtr& scene);
+
   PlanningSceneRender(Ogre::SceneNode* root_node, rviz::DisplayContext* context,
                       const RobotStateVisualizationPtr& robot);
   ~PlanningSceneRender();
@@ -77,15 +99,37 @@ public:
 
   void updateRobotPosition(const planning_scene::PlanningSceneConstPtr& scene);
 
+  /** \brief Render the world of \e scene. Only objects whose shapes or color changed since the last call are
+      rebuilt, objects that only moved are repositioned. */
   void renderPlanningScene(const planning_scene::PlanningSceneConstPtr& scene, const rviz::Color& default_scene_color,
                            const rviz::Color& default_attached_color, OctreeVoxelRenderMode voxel_render_mode,
                            OctreeVoxelColorMode voxel_color_mode, float default_scene_alpha);
+  /** \brief Render a scene captured by captureSnapshot(), like renderPlanningScene() */
+  void renderSnapshot(const SceneSnapshot& snapshot, const rviz::Color& default_scene_color,
+                      const rviz::Color& default_attached_color, OctreeVoxelRenderMode voxel_render_mode,
+                      OctreeVoxelColorMode voxel_color_mode, float default_scene_alpha);
   void clear();
 
 private:
+  /** \brief The rendering of a world object and what it was rendered from */
+  struct ObjectRender
+  {
+    Ogre::SceneNode* node;
+    RenderShapesPtr render_shapes;
+    std::vector<shapes::ShapeConstPtr> shapes;
+    EigenSTL::vector_Isometry3d shape_poses;
+    rviz::Color color;
+    float alpha;
+  };
+
+  void destroyObjectRender(ObjectRender& object_render);
+
   Ogre::SceneNode* planning_scene_geometry_node_;
   rviz::DisplayContext* context_;
-  RenderShapesPtr render_shapes_;
   RobotStateVisualizationPtr scene_robot_;
+
+  std::map<std::string, ObjectRender> object_renders_;
+  OctreeVoxelRenderMode octree_voxel_rendering_;
+  OctreeVoxelColorMode octree_color_mode_;
 };
 }  // namespace moveit_rviz_plugin
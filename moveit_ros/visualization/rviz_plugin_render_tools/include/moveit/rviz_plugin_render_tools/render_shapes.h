@@ -72,9 +72,15 @@ public:
   void clear();
 
 private:
+  /** \brief An entity of a mesh whose vertex data is shared by all renderings of meshes with the same content */
+  struct MeshInstance;
+
+  MeshInstance* renderMesh(Ogre::SceneNode* node, const shapes::Mesh* mesh);
+
   rviz::DisplayContext* context_;
 
   std::vector<std::unique_ptr<rviz::Shape> > scene_shapes_;
+  std::vector<std::unique_ptr<MeshInstance> > mesh_instances_;
   std::vector<OcTreeRenderPtr> octree_voxel_grids_;
 };
 }  // namespace moveit_rviz_plugin
@@ -42,17 +42,24 @@
 #include <OgreSceneNode.h>
 #include <OgreSceneManager.h>
 
+#include <algorithm>
+#include <set>
+
 namespace moveit_rviz_plugin
 {
 PlanningSceneRender::PlanningSceneRender(Ogre::SceneNode* node, rviz::DisplayContext* context,
                                          const RobotStateVisualizationPtr& robot)
-  : planning_scene_geometry_node_(node->createChildSceneNode()), context_(context), scene_robot_(robot)
+  : planning_scene_geometry_node_(node->createChildSceneNode())
+  , context_(context)
+  , scene_robot_(robot)
+  , octree_voxel_rendering_(OCTOMAP_OCCUPIED_VOXELS)
+  , octree_color_mode_(OCTOMAP_Z_AXIS_COLOR)
 {
-  render_shapes_ = std::make_shared<RenderShapes>(context);
 }
 
 PlanningSceneRender::~PlanningSceneRender()
 {
+  clear();
   context_->getSceneManager()->destroySceneNode(planning_scene_geometry_node_);
 }
 
@@ -68,7 +75,37 @@ void PlanningSceneRender::updateRobotPosition(const planning_scene::PlanningScen
 
 void PlanningSceneRender::clear()
 {
-  render_shapes_->clear();
+  for (std::pair<const std::string, ObjectRender>& object_render : object_renders_)
+    destroyObjectRender(object_render.second);
+  object_renders_.clear();
+}
+
+void PlanningSceneRender::destroyObjectRender(ObjectRender& object_render)
+{
+  object_render.render_shapes->clear();
+  context_->getSceneManager()->destroySceneNode(object_render.node);
+}
+
+PlanningSceneRender::SceneSnapshotPtr
+PlanningSceneRender::captureSnapshot(const planning_scene::PlanningSceneConstPtr& scene)
+{
+  auto snapshot = std::make_shared<SceneSnapshot>();
+  snapshot->robot_state = std::make_shared<moveit::core::RobotState>(scene->getCurrentState());
+  snapshot->robot_state->update();
+  scene->getKnownObjectColors(snapshot->object_colors);
+
+  const collision_detection::WorldConstPtr& world = scene->getWorld();
+  snapshot->objects.reserve(world->size());
+  for (const auto& id_object : *world)
+  {
+    SceneSnapshot::Object object;
+    object.id = id_object.first;
+    object.shapes = id_object.second->shapes_;
+    object.shape_poses = id_object.second->shape_poses_;
+    object.pose = id_object.second->pose_;
+    snapshot->objects.push_back(std::move(object));
+  }
+  return snapshot;
 }
 
 void PlanningSceneRender::renderPlanningScene(const planning_scene::PlanningSceneConstPtr& scene,
@@ -79,43 +116,97 @@ void PlanningSceneRender::renderPlanningScene(const planning_scene::PlanningScen
 {
   if (!scene)
     return;
+  renderSnapshot(*captureSnapshot(scene), default_env_color, default_attached_color, octree_voxel_rendering,
+                 octree_color_mode, default_scene_alpha);
+}
 
-  clear();
+void PlanningSceneRender::renderSnapshot(const SceneSnapshot& snapshot, const rviz::Color& default_env_color,
+                                         const rviz::Color& default_attached_color,
+                                         OctreeVoxelRenderMode octree_voxel_rendering,
+                                         OctreeVoxelColorMode octree_color_mode, float default_scene_alpha)
+{
+  // octrees are rendered according to these modes, so all of them need to be rebuilt when the modes change
+  if (octree_voxel_rendering != octree_voxel_rendering_ || octree_color_mode != octree_color_mode_)
+  {
+    clear();
+    octree_voxel_rendering_ = octree_voxel_rendering;
+    octree_color_mode_ = octree_color_mode;
+  }
 
   if (scene_robot_)
   {
-    moveit::core::RobotState* rs = new moveit::core::RobotState(scene->getCurrentState());
-    rs->update();
-
     std_msgs::ColorRGBA color;
     color.r = default_attached_color.r_;
     color.g = default_attached_color.g_;
     color.b = default_attached_color.b_;
     color.a = 1.0f;
-    planning_scene::ObjectColorMap color_map;
-    scene->getKnownObjectColors(color_map);
-    scene_robot_->update(moveit::core::RobotStateConstPtr(rs), color, color_map);
+    scene_robot_->update(snapshot.robot_state, color, snapshot.object_colors);
+  }
+
+  // drop objects that were removed from the scene
+  std::set<std::string> ids;
+  for (const SceneSnapshot::Object& object : snapshot.objects)
+    ids.insert(object.id);
+  for (auto it = object_renders_.begin(); it != object_renders_.end();)
+  {
+    if (ids.count(it->first))
+      ++it;
+    else
+    {
+      destroyObjectRender(it->second);
+      it = object_renders_.erase(it);
+    }
   }
 
-  const std::vector<std::string>& ids = scene->getWorld()->getObjectIds();
-  for (const std::string& id : ids)
+  for (const SceneSnapshot::Object& object : snapshot.objects)
   {
-    collision_detection::CollisionEnv::ObjectConstPtr object = scene->getWorld()->getObject(id);
     rviz::Color color = default_env_color;
     float alpha = default_scene_alpha;
-    if (scene->hasObjectColor(id))
+    auto color_it = snapshot.object_colors.find(object.id);
+    if (color_it != snapshot.object_colors.end())
     {
-      const std_msgs::ColorRGBA& c = scene->getObjectColor(id);
+      const std_msgs::ColorRGBA& c = color_it->second;
       color.r_ = c.r;
       color.g_ = c.g;
       color.b_ = c.b;
       alpha = c.a;
     }
-    for (std::size_t j = 0; j < object->shapes_.size(); ++j)
+
+    const Eigen::Vector3d& t = object.pose.translation();
+    const Eigen::Quaterniond q(object.pose.linear());
+    auto it = object_renders_.find(object.id);
+    if (it != object_renders_.end())
+    {
+      const ObjectRender& existing = it->second;
+      if (existing.shapes == object.shapes && existing.shape_poses.size() == object.shape_poses.size() &&
+          std::equal(existing.shape_poses.begin(), existing.shape_poses.end(), object.shape_poses.begin(),
+                     [](const Eigen::Isometry3d& a, const Eigen::Isometry3d& b) { return a.matrix() == b.matrix(); }) &&
+          existing.color.r_ == color.r_ && existing.color.g_ == color.g_ && existing.color.b_ == color.b_ &&
+          existing.alpha == alpha)
+      {
+        // unchanged apart from maybe the object pose, which only moves its scene node
+        existing.node->setPosition(Ogre::Vector3(t.x(), t.y(), t.z()));
+        existing.node->setOrientation(Ogre::Quaternion(q.w(), q.x(), q.y(), q.z()));
+        continue;
+      }
+      destroyObjectRender(it->second);
+      object_renders_.erase(it);
+    }
+
+    ObjectRender& object_render = object_renders_[object.id];
+    object_render.node = planning_scene_geometry_node_->createChildSceneNode();
+    object_render.render_shapes = std::make_shared<RenderShapes>(context_);
+    object_render.shapes = object.shapes;
+    object_render.shape_poses = object.shape_poses;
+    object_render.color = color;
+    object_render.alpha = alpha;
+
+    object_render.node->setPosition(Ogre::Vector3(t.x(), t.y(), t.z()));
+    object_render.node->setOrientation(Ogre::Quaternion(q.w(), q.x(), q.y(), q.z()));
+    for (std::size_t j = 0; j < object.shapes.size(); ++j)
     {
-      render_shapes_->renderShape(planning_scene_geometry_node_, object->shapes_[j].get(),
-                                  object->global_shape_poses_[j], octree_voxel_rendering, octree_color_mode, color,
-                                  alpha);
+      object_render.render_shapes->renderShape(object_render.node, object.shapes[j].get(), object.shape_poses[j],
+                                               octree_voxel_rendering, octree_color_mode, color, alpha);
     }
   }
 }
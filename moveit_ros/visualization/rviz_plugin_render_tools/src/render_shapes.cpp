@@ -36,6 +36,7 @@
 
 #include <moveit/rviz_plugin_render_tools/render_shapes.h>
 #include <moveit/rviz_plugin_render_tools/octomap_render.h>
+#include <moveit/collision_detection/geometry_cache.h>
 #include <geometric_shapes/check_isometry.h>
 #include <geometric_shapes/mesh_operations.h>
 
@@ -43,9 +44,11 @@
 #include <OgreSceneManager.h>
 #include <OgreManualObject.h>
 #include <OgreMaterialManager.h>
+#include <OgreMeshManager.h>
+#include <OgreEntity.h>
+#include <OgreTechnique.h>
 
 #include <rviz/ogre_helpers/shape.h>
-#include <rviz/ogre_helpers/mesh_shape.h>
 
 #include <rviz/display_context.h>
 #include <rviz/robot/robot.h>
@@ -53,10 +56,132 @@
 #include <boost/lexical_cast.hpp>
 #include <boost/math/constants/constants.hpp>
 
+#include <map>
 #include <memory>
 
 namespace moveit_rviz_plugin
 {
+namespace
+{
+/** \brief Ogre meshes built from shapes::Mesh content, shared by all RenderShapes instances */
+struct SharedMesh
+{
+  Ogre::MeshPtr mesh;
+  std::size_t use_count = 0;
+};
+
+std::map<std::uint64_t, SharedMesh>& sharedMeshes()
+{
+  static std::map<std::uint64_t, SharedMesh> meshes;
+  return meshes;
+}
+
+std::string uniqueName(const std::string& prefix)
+{
+  static std::size_t count = 0;
+  return prefix + boost::lexical_cast<std::string>(count++);
+}
+
+/** \brief Get the Ogre mesh for the content of \e mesh, building it if no rendered mesh has the same content */
+Ogre::MeshPtr acquireSharedMesh(Ogre::SceneManager* scene_manager, const shapes::Mesh& mesh, std::uint64_t key)
+{
+  SharedMesh& shared = sharedMeshes()[key];
+  ++shared.use_count;
+  if (!shared.mesh.isNull())
+    return shared.mesh;
+
+  Ogre::ManualObject* manual = scene_manager->createManualObject();
+  manual->begin("BaseWhiteNoLighting", Ogre::RenderOperation::OT_TRIANGLE_LIST);
+  for (unsigned int i = 0; i < mesh.triangle_count; ++i)
+  {
+    const unsigned int i3 = i * 3;
+    Ogre::Vector3 v[3];
+    for (int k = 0; k < 3; ++k)
+    {
+      const unsigned int vi = 3 * mesh.triangles[i3 + k];
+      v[k] = Ogre::Vector3(mesh.vertices[vi], mesh.vertices[vi + 1], mesh.vertices[vi + 2]);
+    }
+    Ogre::Vector3 normal;
+    if (mesh.triangle_normals)
+      normal = Ogre::Vector3(mesh.triangle_normals[i3], mesh.triangle_normals[i3 + 1], mesh.triangle_normals[i3 + 2]);
+    else
+      normal = (v[1] - v[0]).crossProduct(v[2] - v[0]).normalisedCopy();
+    for (int k = 0; k < 3; ++k)
+    {
+      manual->position(v[k]);
+      if (mesh.vertex_normals)
+      {
+        const unsigned int vi = 3 * mesh.triangles[i3 + k];
+        manual->normal(mesh.vertex_normals[vi], mesh.vertex_normals[vi + 1], mesh.vertex_normals[vi + 2]);
+      }
+      else
+        manual->normal(normal);
+    }
+  }
+  manual->end();
+  shared.mesh = manual->convertToMesh(uniqueName("moveit_render_shapes_mesh_"));
+  scene_manager->destroyManualObject(manual);
+  return shared.mesh;
+}
+
+void releaseSharedMesh(std::uint64_t key)
+{
+  auto it = sharedMeshes().find(key);
+  if (it == sharedMeshes().end() || --it->second.use_count > 0)
+    return;
+  Ogre::MeshManager::getSingleton().remove(it->second.mesh->getName());
+  sharedMeshes().erase(it);
+}
+}  // namespace
+
+struct RenderShapes::MeshInstance
+{
+  MeshInstance(Ogre::SceneManager* scene_manager, Ogre::SceneNode* parent, const shapes::Mesh& mesh)
+    : scene_manager_(scene_manager), key_(collision_detection::GeometryCache::computeMeshHash(mesh))
+  {
+    Ogre::MeshPtr shared_mesh = acquireSharedMesh(scene_manager, mesh, key_);
+    node_ = parent->createChildSceneNode();
+    entity_ = scene_manager->createEntity(uniqueName("moveit_render_shapes_entity_"), shared_mesh->getName());
+    material_ = Ogre::MaterialManager::getSingleton().create(uniqueName("moveit_render_shapes_material_"),
+                                                             Ogre::ResourceGroupManager::DEFAULT_RESOURCE_GROUP_NAME);
+    material_->setReceiveShadows(false);
+    material_->getTechnique(0)->setLightingEnabled(true);
+    entity_->setMaterial(material_);
+    node_->attachObject(entity_);
+  }
+
+  ~MeshInstance()
+  {
+    scene_manager_->destroyEntity(entity_);
+    scene_manager_->destroySceneNode(node_);
+    Ogre::MaterialManager::getSingleton().remove(material_->getName());
+    releaseSharedMesh(key_);
+  }
+
+  void setColor(float r, float g, float b, float a)
+  {
+    Ogre::Technique* technique = material_->getTechnique(0);
+    technique->setAmbient(r * 0.5, g * 0.5, b * 0.5);
+    technique->setDiffuse(r, g, b, a);
+    if (a < 0.9998)
+    {
+      technique->setSceneBlending(Ogre::SBT_TRANSPARENT_ALPHA);
+      technique->setDepthWriteEnabled(false);
+    }
+    else
+    {
+      technique->setSceneBlending(Ogre::SBT_REPLACE);
+      technique->setDepthWriteEnabled(true);
+    }
+  }
+
+  Ogre::SceneManager* scene_manager_;
+  std::uint64_t key_;
+  Ogre::SceneNode* node_;
+  Ogre::Entity* entity_;
+  Ogre::MaterialPtr material_;
+};
+
 RenderShapes::RenderShapes(rviz::DisplayContext* context) : context_(context)
 {
 }
@@ -69,9 +194,16 @@ RenderShapes::~RenderShapes()
 void RenderShapes::clear()
 {
   scene_shapes_.clear();
+  mesh_instances_.clear();
   octree_voxel_grids_.clear();
 }
 
+RenderShapes::MeshInstance* RenderShapes::renderMesh(Ogre::SceneNode* node, const shapes::Mesh* mesh)
+{
+  mesh_instances_.push_back(std::make_unique<MeshInstance>(context_->getSceneManager(), node, *mesh));
+  return mesh_instances_.back().get();
+}
+
 void RenderShapes::renderShape(Ogre::SceneNode* node, const shapes::Shape* s, const Eigen::Isometry3d& p,
                                OctreeVoxelRenderMode octree_voxel_rendering, OctreeVoxelColorMode octree_color_mode,
                                const rviz::Color& color, float alpha)
@@ -133,39 +265,14 @@ void RenderShapes::renderShape(Ogre::SceneNode* node, const shapes::Shape* s, co
     break;
     case shapes::MESH:
     {
+      // meshes with the same content, like the many parts of a bin, share their vertex buffers
       const shapes::Mesh* mesh = static_cast<const shapes::Mesh*>(s);
       if (mesh->triangle_count > 0)
       {
-        rviz::MeshShape* m = new rviz::MeshShape(context_->getSceneManager(), node);
-        ogre_shape = m;
-
-        Ogre::Vector3 normal(0.0, 0.0, 0.0);
-        for (unsigned int i = 0; i < mesh->triangle_count; ++i)
-        {
-          unsigned int i3 = i * 3;
-          if (mesh->triangle_normals && !mesh->vertex_normals)
-          {
-            normal.x = mesh->triangle_normals[i3];
-            normal.y = mesh->triangle_normals[i3 + 1];
-            normal.z = mesh->triangle_normals[i3 + 2];
-          }
-
-          for (int k = 0; k < 3; ++k)
-          {
-            unsigned int vi = 3 * mesh->triangles[i3 + k];
-            Ogre::Vector3 v(mesh->vertices[vi], mesh->vertices[vi + 1], mesh->vertices[vi + 2]);
-            if (mesh->vertex_normals)
-            {
-              Ogre::Vector3 n(mesh->vertex_normals[vi], mesh->vertex_normals[vi + 1], mesh->vertex_normals[vi + 2]);
-              m->addVertex(v, n);
-            }
-            else if (mesh->triangle_normals)
-              m->addVertex(v, normal);
-            else
-              m->addVertex(v);
-          }
-        }
-        m->endTriangles();
+        MeshInstance* instance = renderMesh(node, mesh);
+        instance->setColor(color.r_, color.g_, color.b_, alpha);
+        instance->node_->setPosition(position);
+        instance->node_->setOrientation(orientation);
       }
     }
     break;
@@ -207,6 +314,8 @@ void RenderShapes::updateShapeColors(float r, float g, float b, float a)
 {
   for (const std::unique_ptr<rviz::Shape>& shape : scene_shapes_)
     shape->setColor(r, g, b, a);
+  for (const std::unique_ptr<MeshInstance>& instance : mesh_instances_)
+    instance->setColor(r, g, b, a);
 }
 
 }  // namespace moveit_rviz_plugin
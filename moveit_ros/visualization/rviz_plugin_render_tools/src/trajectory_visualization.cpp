@@ -180,6 +180,7 @@ void TrajectoryVisualization::setName(const QString& name)
 void TrajectoryVisualization::onRobotModelLoaded(const moveit::core::RobotModelConstPtr& robot_model)
 {
   robot_model_ = robot_model;
+  clearTrajectoryTrail();  // trail robots show the previous model
 
   // Error check
   if (!robot_model_)
@@ -226,25 +227,35 @@ void TrajectoryVisualization::changedLoopDisplay()
 
 void TrajectoryVisualization::changedShowTrail()
 {
-  clearTrajectoryTrail();
-
   if (!trail_display_property_->getBool())
+  {
+    clearTrajectoryTrail();
     return;
+  }
   robot_trajectory::RobotTrajectoryPtr t = trajectory_message_to_display_;
   if (!t)
     t = displaying_trajectory_message_;
   if (!t)
+  {
+    clearTrajectoryTrail();
     return;
+  }
 
   int stepsize = trail_step_size_property_->getInt();
   // always include last trajectory point
+  // Trail robots of a previous trajectory are reused, as loading the robot model into rviz dominates the cost of
+  // showing a trail.
   trajectory_trail_.resize((int)std::ceil((t->getWayPointCount() + stepsize - 1) / (float)stepsize));
   for (std::size_t i = 0; i < trajectory_trail_.size(); i++)
   {
     int waypoint_i = std::min(i * stepsize, t->getWayPointCount() - 1);  // limit to last trajectory point
-    auto r = std::make_unique<RobotStateVisualization>(scene_node_, context_,
-                                                       "Trail Robot " + boost::lexical_cast<std::string>(i), nullptr);
-    r->load(*robot_model_->getURDF());
+    RobotStateVisualizationUniquePtr& r = trajectory_trail_[i];
+    if (!r)
+    {
+      r = std::make_unique<RobotStateVisualization>(scene_node_, context_,
+                                                    "Trail Robot " + boost::lexical_cast<std::string>(i), nullptr);
+      r->load(*robot_model_->getURDF());
+    }
     r->setVisualVisible(display_path_visual_enabled_property_->getBool());
     r->setCollisionVisible(display_path_collision_enabled_property_->getBool());
     r->setAlpha(robot_path_alpha_property_->getFloat());
@@ -252,7 +263,6 @@ void TrajectoryVisualization::changedShowTrail()
     if (enable_robot_color_property_->getBool())
       setRobotColor(&(r->getRobot()), robot_color_property_->getColor());
     r->setVisible(display_->isEnabled() && (!animating_path_ || waypoint_i <= current_state_));
-    trajectory_trail_[i] = std::move(r);
   }
 }
 
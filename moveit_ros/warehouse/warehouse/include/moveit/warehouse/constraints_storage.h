@@ -39,6 +39,8 @@
 #include "moveit/warehouse/moveit_message_storage.h"
 #include <moveit/macros/class_forward.h>
 #include <moveit_msgs/Constraints.h>
+#include <map>
+#include <tuple>
 
 namespace moveit_warehouse
 {
@@ -59,6 +61,10 @@ public:
   ConstraintsStorage(warehouse_ros::DatabaseConnection::Ptr conn);
 
   void addConstraints(const moveit_msgs::Constraints& msg, const std::string& robot = "", const std::string& group = "");
+
+  /** \brief Add (or replace) all of \e msgs, looking up the existing names only once */
+  void addConstraints(const std::vector<moveit_msgs::Constraints>& msgs, const std::string& robot = "",
+                      const std::string& group = "");
   bool hasConstraints(const std::string& name, const std::string& robot = "", const std::string& group = "") const;
   void getKnownConstraints(std::vector<std::string>& names, const std::string& robot = "",
                            const std::string& group = "") const;
@@ -69,6 +75,12 @@ public:
   bool getConstraints(ConstraintsWithMetadata& msg_m, const std::string& name, const std::string& robot = "",
                       const std::string& group = "") const;
 
+  /** \brief Get the constraints whose names match \e regex (all if it is empty) with a single database query,
+   *  which is much faster than getting them one by one */
+  void getConstraints(const std::string& regex, std::vector<ConstraintsWithMetadata>& msgs,
+                      std::vector<std::string>& names, const std::string& robot = "",
+                      const std::string& group = "") const;
+
   void renameConstraints(const std::string& old_name, const std::string& new_name, const std::string& robot = "",
                          const std::string& group = "");
 
@@ -76,9 +88,14 @@ public:
 
   void reset();
 
+  void clearCache() override;
+
 private:
   void createCollections();
 
   ConstraintsCollection constraints_collection_;
+
+  /// Constraints read while the cache is enabled, by robot, group and name
+  mutable std::map<std::tuple<std::string, std::string, std::string>, ConstraintsWithMetadata> cache_;
 };
 }  // namespace moveit_warehouse
@@ -55,11 +55,29 @@ public:
   {
   }
 
+  /// \brief Keep the messages read by name in memory and serve repeated reads from there. Writes through this object
+  /// keep the cache up to date, but changes other clients make to the database are not seen while it is enabled.
+  void setCacheEnabled(bool enabled);
+
+  bool isCacheEnabled() const
+  {
+    return cache_enabled_;
+  }
+
+  /// \brief Forget all cached messages
+  virtual void clearCache()
+  {
+  }
+
 protected:
   /// Keep only the \e names that match \e regex
   void filterNames(const std::string& regex, std::vector<std::string>& names) const;
 
+  /// Return the indices of the \e names that match \e regex, in order
+  std::vector<std::size_t> matchNames(const std::string& regex, const std::vector<std::string>& names) const;
+
   warehouse_ros::DatabaseConnection::Ptr conn_;
+  bool cache_enabled_;
 };
 
 /// \brief Load a database connection
@@ -41,6 +41,7 @@
 #include <moveit_msgs/PlanningScene.h>
 #include <moveit_msgs/MotionPlanRequest.h>
 #include <moveit_msgs/RobotTrajectory.h>
+#include <map>
 
 namespace moveit_warehouse
 {
@@ -65,6 +66,9 @@ public:
   PlanningSceneStorage(warehouse_ros::DatabaseConnection::Ptr conn);
 
   void addPlanningScene(const moveit_msgs::PlanningScene& scene);
+
+  /** \brief Add (or replace) all of \e scenes, looking up the existing names only once */
+  void addPlanningScenes(const std::vector<moveit_msgs::PlanningScene>& scenes);
   void addPlanningQuery(const moveit_msgs::MotionPlanRequest& planning_query, const std::string& scene_name,
                         const std::string& query_name = "");
   void addPlanningResult(const moveit_msgs::MotionPlanRequest& planning_query,
@@ -89,6 +93,11 @@ public:
   void getPlanningQueries(std::vector<MotionPlanRequestWithMetadata>& planning_queries,
                           std::vector<std::string>& query_names, const std::string& scene_name) const;
 
+  /** \brief Get the queries of \e scene_name whose names match \e regex (all if it is empty) with a single database
+   *  query, which is much faster than getting them one by one */
+  void getPlanningQueries(const std::string& regex, std::vector<MotionPlanRequestWithMetadata>& planning_queries,
+                          std::vector<std::string>& query_names, const std::string& scene_name) const;
+
   void getPlanningResults(std::vector<RobotTrajectoryWithMetadata>& planning_results, const std::string& scene_name,
                           const moveit_msgs::MotionPlanRequest& planning_query) const;
   void getPlanningResults(std::vector<RobotTrajectoryWithMetadata>& planning_results, const std::string& scene_name,
@@ -106,6 +115,8 @@ public:
 
   void reset();
 
+  void clearCache() override;
+
 private:
   void createCollections();
 
@@ -117,5 +128,9 @@ private:
   PlanningSceneCollection planning_scene_collection_;
   MotionPlanRequestCollection motion_plan_request_collection_;
   RobotTrajectoryCollection robot_trajectory_collection_;
+
+  /// Scenes and queries read while the cache is enabled, by scene name and by scene and query name
+  mutable std::map<std::string, PlanningSceneWithMetadata> scene_cache_;
+  mutable std::map<std::pair<std::string, std::string>, MotionPlanRequestWithMetadata> query_cache_;
 };
 }  // namespace moveit_warehouse
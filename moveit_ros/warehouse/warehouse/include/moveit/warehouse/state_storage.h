@@ -39,6 +39,7 @@
 #include <moveit/warehouse/moveit_message_storage.h>
 #include <moveit/macros/class_forward.h>
 #include <moveit_msgs/RobotState.h>
+#include <map>
 
 namespace moveit_warehouse
 {
@@ -58,6 +59,10 @@ public:
   RobotStateStorage(warehouse_ros::DatabaseConnection::Ptr conn);
 
   void addRobotState(const moveit_msgs::RobotState& msg, const std::string& name, const std::string& robot = "");
+
+  /** \brief Add (or replace) the states \e msgs named \e names, looking up the existing names only once */
+  void addRobotStates(const std::vector<moveit_msgs::RobotState>& msgs, const std::vector<std::string>& names,
+                      const std::string& robot = "");
   bool hasRobotState(const std::string& name, const std::string& robot = "") const;
   void getKnownRobotStates(std::vector<std::string>& names, const std::string& robot = "") const;
   void getKnownRobotStates(const std::string& regex, std::vector<std::string>& names,
@@ -66,15 +71,25 @@ public:
   /** \brief Get the constraints named \e name. Return false on failure. */
   bool getRobotState(RobotStateWithMetadata& msg_m, const std::string& name, const std::string& robot = "") const;
 
+  /** \brief Get the states whose names match \e regex (all if it is empty) with a single database query, which is
+   *  much faster than getting them one by one */
+  void getRobotStates(const std::string& regex, std::vector<RobotStateWithMetadata>& msgs,
+                      std::vector<std::string>& names, const std::string& robot = "") const;
+
   void renameRobotState(const std::string& old_name, const std::string& new_name, const std::string& robot = "");
 
   void removeRobotState(const std::string& name, const std::string& robot = "");
 
   void reset();
 
+  void clearCache() override;
+
 private:
   void createCollections();
 
   RobotStateCollection state_collection_;
+
+  /// States read while the cache is enabled, by robot and name
+  mutable std::map<std::pair<std::string, std::string>, RobotStateWithMetadata> cache_;
 };
 }  // namespace moveit_warehouse
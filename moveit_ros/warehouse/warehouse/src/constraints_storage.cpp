@@ -36,6 +36,7 @@
 
 #include <moveit/warehouse/constraints_storage.h>
 
+#include <set>
 #include <utility>
 
 const std::string moveit_warehouse::ConstraintsStorage::DATABASE_NAME = "moveit_constraints";
@@ -60,6 +61,7 @@ void moveit_warehouse::ConstraintsStorage::createCollections()
 
 void moveit_warehouse::ConstraintsStorage::reset()
 {
+  clearCache();
   constraints_collection_.reset();
   conn_->dropDatabase(DATABASE_NAME);
   createCollections();
@@ -79,9 +81,30 @@ void moveit_warehouse::ConstraintsStorage::addConstraints(const moveit_msgs::Con
   metadata->append(ROBOT_NAME, robot);
   metadata->append(CONSTRAINTS_GROUP_NAME, group);
   constraints_collection_->insert(msg, metadata);
+  clearCache();
   ROS_DEBUG("%s constraints '%s'", replace ? "Replaced" : "Added", msg.name.c_str());
 }
 
+void moveit_warehouse::ConstraintsStorage::addConstraints(const std::vector<moveit_msgs::Constraints>& msgs,
+                                                          const std::string& robot, const std::string& group)
+{
+  std::vector<std::string> known_names;
+  getKnownConstraints(known_names, robot, group);
+  const std::set<std::string> known(known_names.begin(), known_names.end());
+  for (const moveit_msgs::Constraints& msg : msgs)
+  {
+    if (known.find(msg.name) != known.end())
+      removeConstraints(msg.name, robot, group);
+    Metadata::Ptr metadata = constraints_collection_->createMetadata();
+    metadata->append(CONSTRAINTS_ID_NAME, msg.name);
+    metadata->append(ROBOT_NAME, robot);
+    metadata->append(CONSTRAINTS_GROUP_NAME, group);
+    constraints_collection_->insert(msg, metadata);
+  }
+  clearCache();
+  ROS_DEBUG("Added %zu constraints", msgs.size());
+}
+
 bool moveit_warehouse::ConstraintsStorage::hasConstraints(const std::string& name, const std::string& robot,
                                                           const std::string& group) const
 {
@@ -121,6 +144,16 @@ void moveit_warehouse::ConstraintsStorage::getKnownConstraints(std::vector<std::
 bool moveit_warehouse::ConstraintsStorage::getConstraints(ConstraintsWithMetadata& msg_m, const std::string& name,
                                                           const std::string& robot, const std::string& group) const
 {
+  if (cache_enabled_)
+  {
+    auto it = cache_.find(std::make_tuple(robot, group, name));
+    if (it != cache_.end())
+    {
+      msg_m = it->second;
+      return true;
+    }
+  }
+
   Query::Ptr q = constraints_collection_->createQuery();
   q->append(CONSTRAINTS_ID_NAME, name);
   if (!robot.empty())
@@ -135,10 +168,47 @@ bool moveit_warehouse::ConstraintsStorage::getConstraints(ConstraintsWithMetadat
     msg_m = constr.back();
     // in case the constraints were renamed, the name in the message may be out of date
     const_cast<moveit_msgs::Constraints*>(static_cast<const moveit_msgs::Constraints*>(msg_m.get()))->name = name;
+    if (cache_enabled_)
+      cache_[std::make_tuple(robot, group, name)] = msg_m;
     return true;
   }
 }
 
+void moveit_warehouse::ConstraintsStorage::getConstraints(const std::string& regex,
+                                                          std::vector<ConstraintsWithMetadata>& msgs,
+                                                          std::vector<std::string>& names, const std::string& robot,
+                                                          const std::string& group) const
+{
+  msgs.clear();
+  names.clear();
+  Query::Ptr q = constraints_collection_->createQuery();
+  if (!robot.empty())
+    q->append(ROBOT_NAME, robot);
+  if (!group.empty())
+    q->append(CONSTRAINTS_GROUP_NAME, group);
+  std::vector<ConstraintsWithMetadata> constr = constraints_collection_->queryList(q, false);
+
+  // like getConstraints(), keep the last constraints of every name
+  std::map<std::string, ConstraintsWithMetadata> latest;
+  for (ConstraintsWithMetadata& c : constr)
+    if (c->lookupField(CONSTRAINTS_ID_NAME))
+      latest[c->lookupString(CONSTRAINTS_ID_NAME)] = c;
+  std::vector<std::string> constr_names;
+  for (const std::pair<const std::string, ConstraintsWithMetadata>& c : latest)
+    constr_names.push_back(c.first);
+
+  for (std::size_t i : matchNames(regex, constr_names))
+  {
+    ConstraintsWithMetadata& msg_m = latest[constr_names[i]];
+    const_cast<moveit_msgs::Constraints*>(static_cast<const moveit_msgs::Constraints*>(msg_m.get()))->name =
+        constr_names[i];
+    names.push_back(constr_names[i]);
+    msgs.push_back(msg_m);
+    if (cache_enabled_)
+      cache_[std::make_tuple(robot, group, constr_names[i])] = msg_m;
+  }
+}
+
 void moveit_warehouse::ConstraintsStorage::renameConstraints(const std::string& old_name, const std::string& new_name,
                                                              const std::string& robot, const std::string& group)
 {
@@ -151,6 +221,7 @@ void moveit_warehouse::ConstraintsStorage::renameConstraints(const std::string&
   Metadata::Ptr m = constraints_collection_->createMetadata();
   m->append(CONSTRAINTS_ID_NAME, new_name);
   constraints_collection_->modifyMetadata(q, m);
+  clearCache();
   ROS_DEBUG("Renamed constraints from '%s' to '%s'", old_name.c_str(), new_name.c_str());
 }
 
@@ -164,5 +235,11 @@ void moveit_warehouse::ConstraintsStorage::removeConstraints(const std::string&
   if (!group.empty())
     q->append(CONSTRAINTS_GROUP_NAME, group);
   unsigned int rem = constraints_collection_->removeMessages(q);
+  clearCache();
   ROS_DEBUG("Removed %u Constraints messages (named '%s')", rem, name.c_str());
 }
+
+void moveit_warehouse::ConstraintsStorage::clearCache()
+{
+  cache_.clear();
+}
@@ -41,10 +41,17 @@
 #include <utility>
 
 moveit_warehouse::MoveItMessageStorage::MoveItMessageStorage(warehouse_ros::DatabaseConnection::Ptr conn)
-  : conn_(std::move(conn))
+  : conn_(std::move(conn)), cache_enabled_(false)
 {
 }
 
+void moveit_warehouse::MoveItMessageStorage::setCacheEnabled(bool enabled)
+{
+  cache_enabled_ = enabled;
+  if (!enabled)
+    clearCache();
+}
+
 void moveit_warehouse::MoveItMessageStorage::filterNames(const std::string& regex, std::vector<std::string>& names) const
 {
   if (!regex.empty())
@@ -61,6 +68,28 @@ void moveit_warehouse::MoveItMessageStorage::filterNames(const std::string& rege
   }
 }
 
+std::vector<std::size_t>
+moveit_warehouse::MoveItMessageStorage::matchNames(const std::string& regex,
+                                                   const std::vector<std::string>& names) const
+{
+  std::vector<std::size_t> indices;
+  indices.reserve(names.size());
+  if (regex.empty())
+  {
+    for (std::size_t i = 0; i < names.size(); ++i)
+      indices.push_back(i);
+    return indices;
+  }
+  boost::regex r(regex);
+  for (std::size_t i = 0; i < names.size(); ++i)
+  {
+    boost::cmatch match;
+    if (boost::regex_match(names[i].c_str(), match, r))
+      indices.push_back(i);
+  }
+  return indices;
+}
+
 static std::unique_ptr<warehouse_ros::DatabaseLoader> DBLOADER;
 
 typename warehouse_ros::DatabaseConnection::Ptr moveit_warehouse::loadDatabase()
@@ -36,6 +36,7 @@
 
 #include <moveit/warehouse/planning_scene_storage.h>
 #include <boost/regex.hpp>
+#include <set>
 #include <utility>
 
 const std::string moveit_warehouse::PlanningSceneStorage::DATABASE_NAME = "moveit_planning_scenes";
@@ -63,6 +64,7 @@ void moveit_warehouse::PlanningSceneStorage::createCollections()
 
 void moveit_warehouse::PlanningSceneStorage::reset()
 {
+  clearCache();
   planning_scene_collection_.reset();
   motion_plan_request_collection_.reset();
   robot_trajectory_collection_.reset();
@@ -81,9 +83,27 @@ void moveit_warehouse::PlanningSceneStorage::addPlanningScene(const moveit_msgs:
   Metadata::Ptr metadata = planning_scene_collection_->createMetadata();
   metadata->append(PLANNING_SCENE_ID_NAME, scene.name);
   planning_scene_collection_->insert(scene, metadata);
+  clearCache();
   ROS_DEBUG("%s scene '%s'", replace ? "Replaced" : "Added", scene.name.c_str());
 }
 
+void moveit_warehouse::PlanningSceneStorage::addPlanningScenes(const std::vector<moveit_msgs::PlanningScene>& scenes)
+{
+  std::vector<std::string> known_names;
+  getPlanningSceneNames(known_names);
+  const std::set<std::string> known(known_names.begin(), known_names.end());
+  for (const moveit_msgs::PlanningScene& scene : scenes)
+  {
+    if (known.find(scene.name) != known.end())
+      removePlanningScene(scene.name);
+    Metadata::Ptr metadata = planning_scene_collection_->createMetadata();
+    metadata->append(PLANNING_SCENE_ID_NAME, scene.name);
+    planning_scene_collection_->insert(scene, metadata);
+  }
+  clearCache();
+  ROS_DEBUG("Added %zu scenes", scenes.size());
+}
+
 bool moveit_warehouse::PlanningSceneStorage::hasPlanningScene(const std::string& name) const
 {
   Query::Ptr q = planning_scene_collection_->createQuery();
@@ -166,6 +186,7 @@ std::string moveit_warehouse::PlanningSceneStorage::addNewPlanningRequest(
   metadata->append(PLANNING_SCENE_ID_NAME, scene_name);
   metadata->append(MOTION_PLAN_REQUEST_ID_NAME, id);
   motion_plan_request_collection_->insert(planning_query, metadata);
+  clearCache();
   ROS_DEBUG("Saved planning query '%s' for scene '%s'", id.c_str(), scene_name.c_str());
   return id;
 }
@@ -217,6 +238,16 @@ bool moveit_warehouse::PlanningSceneStorage::getPlanningSceneWorld(moveit_msgs::
 bool moveit_warehouse::PlanningSceneStorage::getPlanningScene(PlanningSceneWithMetadata& scene_m,
                                                               const std::string& scene_name) const
 {
+  if (cache_enabled_)
+  {
+    auto it = scene_cache_.find(scene_name);
+    if (it != scene_cache_.end())
+    {
+      scene_m = it->second;
+      return true;
+    }
+  }
+
   Query::Ptr q = planning_scene_collection_->createQuery();
   q->append(PLANNING_SCENE_ID_NAME, scene_name);
   std::vector<PlanningSceneWithMetadata> planning_scenes = planning_scene_collection_->queryList(q, false);
@@ -229,6 +260,8 @@ bool moveit_warehouse::PlanningSceneStorage::getPlanningScene(PlanningSceneWithM
   // in case the scene was renamed, the name in the message may be out of date
   const_cast<moveit_msgs::PlanningScene*>(static_cast<const moveit_msgs::PlanningScene*>(scene_m.get()))->name =
       scene_name;
+  if (cache_enabled_)
+    scene_cache_[scene_name] = scene_m;
   return true;
 }
 
@@ -236,6 +269,16 @@ bool moveit_warehouse::PlanningSceneStorage::getPlanningQuery(MotionPlanRequestW
                                                               const std::string& scene_name,
                                                               const std::string& query_name)
 {
+  if (cache_enabled_)
+  {
+    auto it = query_cache_.find(std::make_pair(scene_name, query_name));
+    if (it != query_cache_.end())
+    {
+      query_m = it->second;
+      return true;
+    }
+  }
+
   Query::Ptr q = motion_plan_request_collection_->createQuery();
   q->append(PLANNING_SCENE_ID_NAME, scene_name);
   q->append(MOTION_PLAN_REQUEST_ID_NAME, query_name);
@@ -248,6 +291,8 @@ bool moveit_warehouse::PlanningSceneStorage::getPlanningQuery(MotionPlanRequestW
   else
   {
     query_m = planning_queries.front();
+    if (cache_enabled_)
+      query_cache_[std::make_pair(scene_name, query_name)] = query_m;
     return true;
   }
 }
@@ -309,6 +354,28 @@ void moveit_warehouse::PlanningSceneStorage::getPlanningQueries(
       query_names[i].clear();
 }
 
+void moveit_warehouse::PlanningSceneStorage::getPlanningQueries(
+    const std::string& regex, std::vector<MotionPlanRequestWithMetadata>& planning_queries,
+    std::vector<std::string>& query_names, const std::string& scene_name) const
+{
+  std::vector<MotionPlanRequestWithMetadata> all_queries;
+  std::vector<std::string> all_names;
+  getPlanningQueries(all_queries, all_names, scene_name);
+
+  // like getPlanningQuery(), keep the first query of every name
+  std::set<std::string> seen;
+  planning_queries.clear();
+  query_names.clear();
+  for (std::size_t i : matchNames(regex, all_names))
+    if (!all_names[i].empty() && seen.insert(all_names[i]).second)
+    {
+      planning_queries.push_back(all_queries[i]);
+      query_names.push_back(all_names[i]);
+      if (cache_enabled_)
+        query_cache_[std::make_pair(scene_name, all_names[i])] = all_queries[i];
+    }
+}
+
 void moveit_warehouse::PlanningSceneStorage::getPlanningResults(
     std::vector<RobotTrajectoryWithMetadata>& planning_results, const std::string& scene_name,
     const moveit_msgs::MotionPlanRequest& planning_query) const
@@ -348,6 +415,7 @@ void moveit_warehouse::PlanningSceneStorage::renamePlanningScene(const std::stri
   Metadata::Ptr m = planning_scene_collection_->createMetadata();
   m->append(PLANNING_SCENE_ID_NAME, new_scene_name);
   planning_scene_collection_->modifyMetadata(q, m);
+  clearCache();
   ROS_DEBUG("Renamed planning scene from '%s' to '%s'", old_scene_name.c_str(), new_scene_name.c_str());
 }
 
@@ -361,6 +429,7 @@ void moveit_warehouse::PlanningSceneStorage::renamePlanningQuery(const std::stri
   Metadata::Ptr m = motion_plan_request_collection_->createMetadata();
   m->append(MOTION_PLAN_REQUEST_ID_NAME, new_query_name);
   motion_plan_request_collection_->modifyMetadata(q, m);
+  clearCache();
   ROS_DEBUG("Renamed planning query for scene '%s' from '%s' to '%s'", scene_name.c_str(), old_query_name.c_str(),
             new_query_name.c_str());
 }
@@ -371,6 +440,7 @@ void moveit_warehouse::PlanningSceneStorage::removePlanningScene(const std::stri
   Query::Ptr q = planning_scene_collection_->createQuery();
   q->append(PLANNING_SCENE_ID_NAME, scene_name);
   unsigned int rem = planning_scene_collection_->removeMessages(q);
+  clearCache();
   ROS_DEBUG("Removed %u PlanningScene messages (named '%s')", rem, scene_name.c_str());
 }
 
@@ -380,6 +450,7 @@ void moveit_warehouse::PlanningSceneStorage::removePlanningQueries(const std::st
   Query::Ptr q = motion_plan_request_collection_->createQuery();
   q->append(PLANNING_SCENE_ID_NAME, scene_name);
   unsigned int rem = motion_plan_request_collection_->removeMessages(q);
+  clearCache();
   ROS_DEBUG("Removed %u MotionPlanRequest messages for scene '%s'", rem, scene_name.c_str());
 }
 
@@ -391,6 +462,7 @@ void moveit_warehouse::PlanningSceneStorage::removePlanningQuery(const std::stri
   q->append(PLANNING_SCENE_ID_NAME, scene_name);
   q->append(MOTION_PLAN_REQUEST_ID_NAME, query_name);
   unsigned int rem = motion_plan_request_collection_->removeMessages(q);
+  clearCache();
   ROS_DEBUG("Removed %u MotionPlanRequest messages for scene '%s', query '%s'", rem, scene_name.c_str(),
             query_name.c_str());
 }
@@ -413,3 +485,9 @@ void moveit_warehouse::PlanningSceneStorage::removePlanningResults(const std::st
   ROS_DEBUG("Removed %u RobotTrajectory messages for scene '%s', query '%s'", rem, scene_name.c_str(),
             query_name.c_str());
 }
+
+void moveit_warehouse::PlanningSceneStorage::clearCache()
+{
+  scene_cache_.clear();
+  query_cache_.clear();
+}
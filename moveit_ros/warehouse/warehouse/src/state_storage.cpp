@@ -36,6 +36,7 @@
 
 #include <moveit/warehouse/state_storage.h>
 
+#include <set>
 #include <utility>
 
 const std::string moveit_warehouse::RobotStateStorage::DATABASE_NAME = "moveit_robot_states";
@@ -59,6 +60,7 @@ void moveit_warehouse::RobotStateStorage::createCollections()
 
 void moveit_warehouse::RobotStateStorage::reset()
 {
+  clearCache();
   state_collection_.reset();
   conn_->dropDatabase(DATABASE_NAME);
   createCollections();
@@ -77,9 +79,36 @@ void moveit_warehouse::RobotStateStorage::addRobotState(const moveit_msgs::Robot
   metadata->append(STATE_NAME, name);
   metadata->append(ROBOT_NAME, robot);
   state_collection_->insert(msg, metadata);
+  clearCache();
   ROS_DEBUG("%s robot state '%s'", replace ? "Replaced" : "Added", name.c_str());
 }
 
+void moveit_warehouse::RobotStateStorage::addRobotStates(const std::vector<moveit_msgs::RobotState>& msgs,
+                                                         const std::vector<std::string>& names,
+                                                         const std::string& robot)
+{
+  if (msgs.size() != names.size())
+  {
+    ROS_ERROR("Got %zu robot states but %zu names", msgs.size(), names.size());
+    return;
+  }
+
+  std::vector<std::string> known_names;
+  getKnownRobotStates(known_names, robot);
+  const std::set<std::string> known(known_names.begin(), known_names.end());
+  for (std::size_t i = 0; i < msgs.size(); ++i)
+  {
+    if (known.find(names[i]) != known.end())
+      removeRobotState(names[i], robot);
+    Metadata::Ptr metadata = state_collection_->createMetadata();
+    metadata->append(STATE_NAME, names[i]);
+    metadata->append(ROBOT_NAME, robot);
+    state_collection_->insert(msgs[i], metadata);
+  }
+  clearCache();
+  ROS_DEBUG("Added %zu robot states", msgs.size());
+}
+
 bool moveit_warehouse::RobotStateStorage::hasRobotState(const std::string& name, const std::string& robot) const
 {
   Query::Ptr q = state_collection_->createQuery();
@@ -113,6 +142,16 @@ void moveit_warehouse::RobotStateStorage::getKnownRobotStates(std::vector<std::s
 bool moveit_warehouse::RobotStateStorage::getRobotState(RobotStateWithMetadata& msg_m, const std::string& name,
                                                         const std::string& robot) const
 {
+  if (cache_enabled_)
+  {
+    auto it = cache_.find(std::make_pair(robot, name));
+    if (it != cache_.end())
+    {
+      msg_m = it->second;
+      return true;
+    }
+  }
+
   Query::Ptr q = state_collection_->createQuery();
   q->append(STATE_NAME, name);
   if (!robot.empty())
@@ -123,10 +162,44 @@ bool moveit_warehouse::RobotStateStorage::getRobotState(RobotStateWithMetadata&
   else
   {
     msg_m = constr.front();
+    if (cache_enabled_)
+      cache_[std::make_pair(robot, name)] = msg_m;
     return true;
   }
 }
 
+void moveit_warehouse::RobotStateStorage::getRobotStates(const std::string& regex,
+                                                         std::vector<RobotStateWithMetadata>& msgs,
+                                                         std::vector<std::string>& names,
+                                                         const std::string& robot) const
+{
+  msgs.clear();
+  names.clear();
+  Query::Ptr q = state_collection_->createQuery();
+  if (!robot.empty())
+    q->append(ROBOT_NAME, robot);
+  std::vector<RobotStateWithMetadata> states = state_collection_->queryList(q, false, STATE_NAME, true);
+
+  // like getRobotState(), keep the first state of every name
+  std::vector<std::string> state_names;
+  std::vector<RobotStateWithMetadata> unique_states;
+  std::set<std::string> seen;
+  for (RobotStateWithMetadata& state : states)
+    if (state->lookupField(STATE_NAME) && seen.insert(state->lookupString(STATE_NAME)).second)
+    {
+      state_names.push_back(state->lookupString(STATE_NAME));
+      unique_states.push_back(state);
+    }
+
+  for (std::size_t i : matchNames(regex, state_names))
+  {
+    names.push_back(state_names[i]);
+    msgs.push_back(unique_states[i]);
+    if (cache_enabled_)
+      cache_[std::make_pair(robot, state_names[i])] = unique_states[i];
+  }
+}
+
 void moveit_warehouse::RobotStateStorage::renameRobotState(const std::string& old_name, const std::string& new_name,
                                                            const std::string& robot)
 {
@@ -137,6 +210,7 @@ void moveit_warehouse::RobotStateStorage::renameRobotState(const std::string& ol
   Metadata::Ptr m = state_collection_->createMetadata();
   m->append(STATE_NAME, new_name);
   state_collection_->modifyMetadata(q, m);
+  clearCache();
   ROS_DEBUG("Renamed robot state from '%s' to '%s'", old_name.c_str(), new_name.c_str());
 }
 
@@ -147,5 +221,11 @@ void moveit_warehouse::RobotStateStorage::removeRobotState(const std::string& na
   if (!robot.empty())
     q->append(ROBOT_NAME, robot);
   unsigned int rem = state_collection_->removeMessages(q);
+  clearCache();
   ROS_DEBUG("Removed %u RobotState messages (named '%s')", rem, name.c_str());
 }
+
+void moveit_warehouse::RobotStateStorage::clearCache()
+{
+  cache_.clear();
+}
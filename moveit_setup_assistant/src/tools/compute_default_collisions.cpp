@@ -41,6 +41,7 @@
 #include <boost/unordered_map.hpp>
 #include <boost/assign.hpp>
 #include <ros/console.h>
+#include <algorithm>
 
 namespace moveit_setup_assistant
 {
@@ -59,27 +60,34 @@ const boost::unordered_map<std::string, DisabledReason> REASONS_FROM_STRING =
 // Unique set of pairs of links in string-based form
 typedef std::set<std::pair<std::string, std::string> > StringPairSet;
 
+// Number of trials a thread runs between merging the link pairs it found with those of the other threads
+static const unsigned int SYNC_INTERVAL = 100;
+
+// Results shared by the threads searching for never colliding links. Threads collect pairs locally and merge them
+// here every SYNC_INTERVAL trials, which is the only time they take the lock.
+struct NeverInCollisionSearch
+{
+  boost::mutex lock_;
+  StringPairSet links_seen_colliding_;
+  unsigned int trials_done_ = 0;
+  unsigned int last_new_pair_trial_ = 0;
+  unsigned int convergence_trials_ = 0;  // 0 runs all trials
+  bool converged_ = false;
+};
+
 // Struct for passing parameters to threads, for cleaner code
 struct ThreadComputation
 {
-  ThreadComputation(planning_scene::PlanningScene& scene, const collision_detection::CollisionRequest& req,
-                    int thread_id, int num_trials, StringPairSet* links_seen_colliding, boost::mutex* lock,
-                    unsigned int* progress)
-    : scene_(scene)
-    , req_(req)
-    , thread_id_(thread_id)
-    , num_trials_(num_trials)
-    , links_seen_colliding_(links_seen_colliding)
-    , lock_(lock)
-    , progress_(progress)
+  ThreadComputation(const planning_scene::PlanningScene& scene, const collision_detection::CollisionRequest& req,
+                    int thread_id, int num_trials, NeverInCollisionSearch* search, unsigned int* progress)
+    : scene_(scene), req_(req), thread_id_(thread_id), num_trials_(num_trials), search_(search), progress_(progress)
   {
   }
-  planning_scene::PlanningScene& scene_;
+  const planning_scene::PlanningScene& scene_;
   const collision_detection::CollisionRequest& req_;
   int thread_id_;
   unsigned int num_trials_;
-  StringPairSet* links_seen_colliding_;
-  boost::mutex* lock_;
+  NeverInCollisionSearch* search_;
   unsigned int* progress_;  // only to be updated by thread 0
 };
 
@@ -155,11 +163,26 @@ static unsigned int disableAlwaysInCollision(planning_scene::PlanningScene& scen
  * \param link_pairs List of all unique link pairs and each pair's properties
  * \param req A reference to a collision request that is already initialized
  * \param links_seen_colliding Set of links that have at some point been seen in collision
+ * \param convergence_trials Stop once this many trials found no new colliding pair, 0 to run all trials
  * \return number of never in collision links found and disabled
  */
-static unsigned int disableNeverInCollision(const unsigned int num_trials, planning_scene::PlanningScene& scene,
+static unsigned int disableNeverInCollision(const unsigned int num_trials, const planning_scene::PlanningScene& scene,
                                             LinkPairMap& link_pairs, const collision_detection::CollisionRequest& req,
-                                            StringPairSet& links_seen_colliding, unsigned int* progress);
+                                            StringPairSet& links_seen_colliding, unsigned int* progress,
+                                            unsigned int convergence_trials);
+
+/**
+ * \brief Merge the link pairs a thread found since its last call into the shared search results
+ * \param search The shared search results
+ * \param new_pairs Pairs newly seen colliding by the thread, cleared on return
+ * \param trials Number of trials the thread ran since its last call
+ * \param num_known Number of shared pairs already allowed in \e acm, updated on return
+ * \param acm The thread's collision matrix, in which pairs found by other threads are allowed
+ * \return false if the search converged and the thread should stop
+ */
+static bool synchronizeNeverInCollisionSearch(NeverInCollisionSearch& search, StringPairSet& new_pairs,
+                                              unsigned int trials, std::size_t& num_known,
+                                              collision_detection::AllowedCollisionMatrix& acm);
 
 /**
  * \brief Thread for getting the pairs of links that are never in collision
@@ -172,7 +195,8 @@ static void disableNeverInCollisionThread(ThreadComputation tc);
 // ******************************************************************************************
 LinkPairMap computeDefaultCollisions(const planning_scene::PlanningSceneConstPtr& parent_scene, unsigned int* progress,
                                      const bool include_never_colliding, const unsigned int num_trials,
-                                     const double min_collision_fraction, const bool verbose)
+                                     const double min_collision_fraction, const bool verbose,
+                                     const unsigned int convergence_trials)
 {
   // Create new instance of planning scene using pointer
   planning_scene::PlanningScenePtr scene = parent_scene->diff();
@@ -237,7 +261,8 @@ LinkPairMap computeDefaultCollisions(const planning_scene::PlanningSceneConstPtr
   unsigned int num_never = 0;
   if (include_never_colliding)  // option of function
   {
-    num_never = disableNeverInCollision(num_trials, *scene, link_pairs, req, links_seen_colliding, progress);
+    num_never = disableNeverInCollision(num_trials, *scene, link_pairs, req, links_seen_colliding, progress,
+                                        convergence_trials);
   }
 
   // ROS_INFO("Link pairs seen colliding ever: %d", int(links_seen_colliding.size()));
@@ -548,14 +573,17 @@ unsigned int disableAlwaysInCollision(planning_scene::PlanningScene& scene, Link
 // ******************************************************************************************
 // Get the pairs of links that are never in collision
 // ******************************************************************************************
-unsigned int disableNeverInCollision(const unsigned int num_trials, planning_scene::PlanningScene& scene,
+unsigned int disableNeverInCollision(const unsigned int num_trials, const planning_scene::PlanningScene& scene,
                                      LinkPairMap& link_pairs, const collision_detection::CollisionRequest& req,
-                                     StringPairSet& links_seen_colliding, unsigned int* progress)
+                                     StringPairSet& links_seen_colliding, unsigned int* progress,
+                                     unsigned int convergence_trials)
 {
   unsigned int num_disabled = 0;
 
   boost::thread_group bgroup;  // create a group of threads
-  boost::mutex lock;           // used for sharing the same data structures
+  NeverInCollisionSearch search;
+  search.links_seen_colliding_ = links_seen_colliding;
+  search.convergence_trials_ = convergence_trials;
 
   int num_threads = boost::thread::hardware_concurrency();  // how many cores does this computer have?
   // ROS_INFO_STREAM("Performing " << num_trials << " trials for 'always in collision' checking on " <<
@@ -563,7 +591,7 @@ unsigned int disableNeverInCollision(const unsigned int num_trials, planning_sce
 
   for (int i = 0; i < num_threads; ++i)
   {
-    ThreadComputation tc(scene, req, i, num_trials / num_threads, &links_seen_colliding, &lock, progress);
+    ThreadComputation tc(scene, req, i, num_trials / num_threads, &search, progress);
     bgroup.create_thread([tc] { return disableNeverInCollisionThread(tc); });
   }
 
@@ -579,6 +607,11 @@ unsigned int disableNeverInCollision(const unsigned int num_trials, planning_sce
     throw;
   }
 
+  if (search.converged_)
+    ROS_INFO("No new colliding link pairs in the last %u trials, stopped after %u of %u trials",
+             search.convergence_trials_, search.trials_done_, num_trials);
+  links_seen_colliding.swap(search.links_seen_colliding_);
+
   // Loop through every possible link pair and check if it has ever been seen in collision
   for (std::pair<const std::pair<std::string, std::string>, LinkPairData>& link_pair : link_pairs)
   {
@@ -602,6 +635,33 @@ unsigned int disableNeverInCollision(const unsigned int num_trials, planning_sce
   return num_disabled;
 }
 
+// ******************************************************************************************
+// Merge the link pairs found by one thread with those found by the others
+// ******************************************************************************************
+bool synchronizeNeverInCollisionSearch(NeverInCollisionSearch& search, StringPairSet& new_pairs, unsigned int trials,
+                                       std::size_t& num_known, collision_detection::AllowedCollisionMatrix& acm)
+{
+  boost::mutex::scoped_lock slock(search.lock_);
+  search.trials_done_ += trials;
+  for (const std::pair<std::string, std::string>& pair : new_pairs)
+    if (search.links_seen_colliding_.insert(pair).second)
+      search.last_new_pair_trial_ = search.trials_done_;
+  new_pairs.clear();
+
+  // pairs found by other threads need not be checked by this one anymore
+  if (search.links_seen_colliding_.size() != num_known)
+  {
+    for (const std::pair<std::string, std::string>& pair : search.links_seen_colliding_)
+      acm.setEntry(pair.first, pair.second, true);
+    num_known = search.links_seen_colliding_.size();
+  }
+
+  if (search.convergence_trials_ > 0 &&
+      search.trials_done_ - search.last_new_pair_trial_ >= search.convergence_trials_)
+    search.converged_ = true;
+  return !search.converged_;
+}
+
 // ******************************************************************************************
 // Thread for getting the pairs of links that are never in collision
 // ******************************************************************************************
@@ -610,10 +670,24 @@ void disableNeverInCollisionThread(ThreadComputation tc)
   // ROS_INFO_STREAM("Thread " << tc.thread_id_ << " running " << tc.num_trials_ << " trials");
 
   // User feedback vars
-  const unsigned int progress_interval = tc.num_trials_ / 20;  // show progress update every 5%
+  const unsigned int progress_interval = std::max(tc.num_trials_ / 20, 1u);  // show progress update every 5%
 
-  // Create a new kinematic state for this thread to work on
-  moveit::core::RobotState robot_state(tc.scene_.getRobotModel());
+  // Each thread checks in its own child scene, so it can allow the pairs it found in its collision matrix without
+  // locking and without racing with the checks of other threads
+  planning_scene::PlanningScenePtr scene = tc.scene_.diff();
+  collision_detection::AllowedCollisionMatrix& acm = scene->getAllowedCollisionMatrixNonConst();
+  moveit::core::RobotState robot_state(scene->getRobotModel());
+
+  // Once the pairs that collide often are allowed, most states are collision free. A binary check answers those
+  // without computing contacts, which are only enumerated for states that do collide.
+  collision_detection::CollisionRequest binary_req = tc.req_;
+  binary_req.contacts = false;
+  binary_req.max_contacts = 1;
+
+  StringPairSet new_pairs;
+  std::size_t num_known = 0;
+  unsigned int trials_since_sync = 0;
+  synchronizeNeverInCollisionSearch(*tc.search_, new_pairs, 0, num_known, acm);  // start from the pairs known so far
 
   // Do a large number of tests
   for (unsigned int i = 0; i < tc.num_trials_; ++i)
@@ -626,25 +700,24 @@ void disableNeverInCollisionThread(ThreadComputation tc)
       (*tc.progress_) = i * 92 / tc.num_trials_ + 8;  // 8 is the amount of progress already completed in prev steps
     }
 
-    collision_detection::CollisionResult res;
     robot_state.setToRandomPositions();
-    tc.scene_.checkSelfCollision(tc.req_, res, robot_state);
-
-    // Check all contacts
-    for (collision_detection::CollisionResult::ContactMap::const_iterator it = res.contacts.begin();
-         it != res.contacts.end(); ++it)
+    collision_detection::CollisionResult res;
+    scene->checkSelfCollision(binary_req, res, robot_state);
+    if (res.collision)
     {
-      // Check if this collision pair is unique before doing a thread lock
-      if (tc.links_seen_colliding_->find(it->first) == tc.links_seen_colliding_->end())
-      {
-        // Collision Matrix and links_seen_colliding is modified only if needed, based on above if statement
+      res.clear();
+      scene->checkSelfCollision(tc.req_, res, robot_state);
 
-        boost::mutex::scoped_lock slock(*tc.lock_);
-        tc.links_seen_colliding_->insert(it->first);
+      for (const auto& contact : res.contacts)
+        if (new_pairs.insert(contact.first).second)
+          acm.setEntry(contact.first.first, contact.first.second, true);  // disable link checking in this thread
+    }
 
-        tc.scene_.getAllowedCollisionMatrixNonConst().setEntry(it->first.first, it->first.second,
-                                                               true);  // disable link checking in the collision matrix
-      }
+    if (++trials_since_sync == SYNC_INTERVAL || i + 1 == tc.num_trials_)
+    {
+      if (!synchronizeNeverInCollisionSearch(*tc.search_, new_pairs, trials_since_sync, num_known, acm))
+        break;
+      trials_since_sync = 0;
     }
   }
 }